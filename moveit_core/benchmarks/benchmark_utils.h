@@ -0,0 +1,101 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <rclcpp/node.hpp>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace moveit_benchmarks
+{
+/** \brief Load the robot model of a robot from moveit_resources only once for all benchmarks */
+inline const moveit::core::RobotModelPtr& getRobotModel(const std::string& robot_name)
+{
+  static std::map<std::string, moveit::core::RobotModelPtr> robot_models;
+  moveit::core::RobotModelPtr& robot_model = robot_models[robot_name];
+  if (!robot_model)
+    robot_model = moveit::core::loadTestingRobotModel(robot_name);
+  return robot_model;
+}
+
+/** \brief Node that is shared by all benchmarks which need one, e.g. to initialize kinematics solvers */
+inline const rclcpp::Node::SharedPtr& getNode()
+{
+  static const rclcpp::Node::SharedPtr node = rclcpp::Node::make_shared("moveit_core_benchmarks");
+  return node;
+}
+
+/** \brief Generate random states of \e group with a fixed seed, so that every run measures the same states.
+ *  Variables that are not part of \e group keep their default values. */
+inline std::vector<moveit::core::RobotState> makeRandomStates(const moveit::core::RobotModelConstPtr& robot_model,
+                                                              const moveit::core::JointModelGroup* group,
+                                                              std::size_t count)
+{
+  random_numbers::RandomNumberGenerator rng(42);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  std::vector<moveit::core::RobotState> states(count, state);
+  for (moveit::core::RobotState& random_state : states)
+  {
+    random_state.setToRandomPositions(group, rng);
+    random_state.update();
+  }
+  return states;
+}
+
+/** \brief Add acceleration limits to all joints, which are missing in the URDFs of moveit_resources */
+inline void setAccelerationLimits(const moveit::core::RobotModelPtr& robot_model)
+{
+  for (moveit::core::JointModel* joint_model : robot_model->getActiveJointModels())
+  {
+    std::vector<moveit_msgs::msg::JointLimits> joint_bounds_msg(joint_model->getVariableBoundsMsg());
+    for (moveit_msgs::msg::JointLimits& joint_bound : joint_bounds_msg)
+    {
+      if (!joint_bound.has_acceleration_limits)
+      {
+        joint_bound.has_acceleration_limits = true;
+        joint_bound.max_acceleration = 1.0;
+      }
+    }
+    joint_model->setVariableBounds(joint_bounds_msg);
+  }
+}
+}  // namespace moveit_benchmarks
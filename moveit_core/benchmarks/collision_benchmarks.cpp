@@ -0,0 +1,206 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks of collision checking and of the allowed collision matrix */
+
+#include "benchmark_utils.h"
+
+#include <moveit/collision_detection/collision_matrix.h>
+#include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
+#include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
+#include <moveit/collision_distance_field/collision_env_hybrid.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <geometric_shapes/shapes.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+constexpr std::size_t NUM_STATES = 1000;
+constexpr std::size_t NUM_OBJECTS = 50;
+
+// Boxes scattered around the base of the robot, so that part of the random states are in collision
+void addRandomBoxes(collision_detection::World& world)
+{
+  random_numbers::RandomNumberGenerator rng(7);
+  for (std::size_t i = 0; i < NUM_OBJECTS; ++i)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = Eigen::Vector3d(rng.uniformReal(-1.0, 1.0), rng.uniformReal(-1.0, 1.0),
+                                         rng.uniformReal(0.0, 1.5));
+    world.addToObject("box_" + std::to_string(i), std::make_shared<shapes::Box>(0.1, 0.1, 0.1), pose);
+  }
+}
+}  // namespace
+
+template <class CollisionAllocatorType>
+static void checkSelfCollision(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  const collision_detection::CollisionEnvPtr env = CollisionAllocatorType().allocateEnv(robot_model);
+  const collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  const std::vector<moveit::core::RobotState> states =
+      moveit_benchmarks::makeRandomStates(robot_model, robot_model->getJointModelGroup("whole_body"), NUM_STATES);
+
+  const collision_detection::CollisionRequest req;
+  std::size_t collisions = 0;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    collision_detection::CollisionResult res;
+    env->checkSelfCollision(req, res, states[i], acm);
+    collisions += res.collision;
+    i = (i + 1) % states.size();
+  }
+  st.counters["collision_rate"] =
+      benchmark::Counter(static_cast<double>(collisions), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(checkSelfCollision, collision_detection::CollisionDetectorAllocatorFCL);
+BENCHMARK_TEMPLATE(checkSelfCollision, collision_detection::CollisionDetectorAllocatorBullet);
+
+template <class CollisionAllocatorType>
+static void checkRobotCollision(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  auto world = std::make_shared<collision_detection::World>();
+  addRandomBoxes(*world);
+  const collision_detection::CollisionEnvPtr env = CollisionAllocatorType().allocateEnv(world, robot_model);
+  const collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  const std::vector<moveit::core::RobotState> states =
+      moveit_benchmarks::makeRandomStates(robot_model, robot_model->getJointModelGroup("panda_arm"), NUM_STATES);
+
+  const collision_detection::CollisionRequest req;
+  std::size_t collisions = 0;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    collision_detection::CollisionResult res;
+    env->checkRobotCollision(req, res, states[i], acm);
+    collisions += res.collision;
+    i = (i + 1) % states.size();
+  }
+  st.counters["collision_rate"] =
+      benchmark::Counter(static_cast<double>(collisions), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(checkRobotCollision, collision_detection::CollisionDetectorAllocatorFCL);
+BENCHMARK_TEMPLATE(checkRobotCollision, collision_detection::CollisionDetectorAllocatorBullet);
+
+// The hybrid environment used by CHOMP, with the different ways to combine FCL and the distance field
+static void checkRobotCollisionHybrid(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  auto world = std::make_shared<collision_detection::World>();
+  addRandomBoxes(*world);
+  collision_detection::CollisionEnvHybrid env(robot_model, world);
+  env.setRobotCollisionCheckMode(static_cast<collision_detection::HybridCollisionCheckMode>(st.range(0)));
+  const collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  const std::vector<moveit::core::RobotState> states =
+      moveit_benchmarks::makeRandomStates(robot_model, robot_model->getJointModelGroup("panda_arm"), NUM_STATES);
+
+  collision_detection::CollisionRequest req;
+  req.group_name = "panda_arm";
+  std::size_t collisions = 0;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    collision_detection::CollisionResult res;
+    env.checkRobotCollision(req, res, states[i], acm);
+    collisions += res.collision;
+    i = (i + 1) % states.size();
+  }
+  st.counters["collision_rate"] =
+      benchmark::Counter(static_cast<double>(collisions), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(checkRobotCollisionHybrid)
+    ->ArgName("mode")
+    ->Arg(static_cast<int>(collision_detection::HybridCollisionCheckMode::FCL))
+    ->Arg(static_cast<int>(collision_detection::HybridCollisionCheckMode::PARALLEL))
+    ->Arg(static_cast<int>(collision_detection::HybridCollisionCheckMode::DISTANCE_FIELD_FIRST));
+
+static void isStateValid(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  planning_scene::PlanningScene scene(robot_model);
+  addRandomBoxes(*scene.getWorldNonConst());
+  const std::vector<moveit::core::RobotState> states =
+      moveit_benchmarks::makeRandomStates(robot_model, robot_model->getJointModelGroup("panda_arm"), NUM_STATES);
+
+  std::size_t valid = 0;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    valid += scene.isStateValid(states[i], "panda_arm");
+    i = (i + 1) % states.size();
+  }
+  st.counters["valid_rate"] = benchmark::Counter(static_cast<double>(valid), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(isStateValid);
+
+static void allowedCollisionMatrixLookup(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  const collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  const std::vector<std::string>& names = robot_model->getLinkModelNames();
+
+  collision_detection::AllowedCollision::Type type;
+  for (auto _ : st)
+  {
+    for (const std::string& name1 : names)
+    {
+      for (const std::string& name2 : names)
+        benchmark::DoNotOptimize(acm.getAllowedCollision(name1, name2, type));
+    }
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * names.size() * names.size()));
+}
+BENCHMARK(allowedCollisionMatrixLookup);
+
+static void compiledAllowedCollisionMatrixLookup(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  const collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  const collision_detection::CompiledAllowedCollisionMatrix compiled(acm, robot_model->getLinkModelNames());
+  const std::size_t size = compiled.getNames().size();
+
+  collision_detection::AllowedCollision::Type type;
+  for (auto _ : st)
+  {
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      for (std::size_t j = 0; j < size; ++j)
+        benchmark::DoNotOptimize(compiled.getAllowedCollision(i, j, type));
+    }
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * size * size));
+}
+BENCHMARK(compiledAllowedCollisionMatrixLookup);
@@ -0,0 +1,86 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks of the joint constraint sampler with pseudo-random and quasi-random (Halton) sampling */
+
+#include "benchmark_utils.h"
+
+#include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <benchmark/benchmark.h>
+
+static void sampleJointConstraints(benchmark::State& st, bool quasi_random)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  const auto planning_scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+
+  // constrain the first joint to a narrow interval, the other joints are sampled within their limits
+  kinematic_constraints::JointConstraint constraint(robot_model);
+  moveit_msgs::msg::JointConstraint constraint_msg;
+  constraint_msg.joint_name = "panda_joint1";
+  constraint_msg.position = 0.5;
+  constraint_msg.tolerance_above = 0.05;
+  constraint_msg.tolerance_below = 0.05;
+  constraint_msg.weight = 1.0;
+  constraint.configure(constraint_msg);
+
+  constraint_samplers::JointConstraintSampler sampler(planning_scene, "panda_arm", 42);
+  sampler.setQuasiRandomSampling(quasi_random);
+  if (!sampler.configure({ constraint }))
+  {
+    st.SkipWithError("Failed to configure the joint constraint sampler");
+    return;
+  }
+
+  // a small region of two unconstrained joints (1% of their joint space) that a planner would need to hit
+  const moveit::core::VariableBounds& bounds2 = robot_model->getVariableBounds("panda_joint2");
+  const moveit::core::VariableBounds& bounds4 = robot_model->getVariableBounds("panda_joint4");
+  const auto in_region = [](double value, const moveit::core::VariableBounds& bounds) {
+    return value - bounds.min_position_ < 0.1 * (bounds.max_position_ - bounds.min_position_);
+  };
+
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  std::size_t hits = 0;
+  for (auto _ : st)
+  {
+    sampler.sample(state, state, 1);
+    hits += in_region(state.getVariablePosition("panda_joint2"), bounds2) &&
+            in_region(state.getVariablePosition("panda_joint4"), bounds4);
+  }
+  benchmark::DoNotOptimize(state.getVariablePositions());
+  st.counters["region_hit_rate"] = benchmark::Counter(static_cast<double>(hits), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(sampleJointConstraints, uniform, false);
+BENCHMARK_CAPTURE(sampleJointConstraints, quasi_random, true);
@@ -0,0 +1,150 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks of the kinematics of RobotState */
+
+#include "benchmark_utils.h"
+#include "../constraint_samplers/test/pr2_arm_kinematics_plugin.h"
+
+#include <moveit/robot_state/cartesian_interpolator.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+constexpr std::size_t NUM_STATES = 1000;
+
+// The kinematics plugins of moveit_kinematics are not available in moveit_core, so use the analytic PR2 arm solver
+// of the constraint sampler tests
+const moveit::core::JointModelGroup* getPR2RightArmWithIK()
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  static const bool initialized = [&robot_model] {
+    auto solver = std::make_shared<pr2_arm_kinematics::PR2ArmKinematicsPlugin>();
+    solver->initialize(moveit_benchmarks::getNode(), *robot_model, "right_arm", "torso_lift_link",
+                       { "r_wrist_roll_link" }, .01);
+    robot_model->setKinematicsAllocators({ { "right_arm", [solver](const moveit::core::JointModelGroup* /*group*/) {
+                                              return kinematics::KinematicsBasePtr(solver);
+                                            } } });
+    return true;
+  }();
+  static_cast<void>(initialized);
+  return robot_model->getJointModelGroup("right_arm");
+}
+}  // namespace
+
+static void updateLinkTransforms(benchmark::State& st, const std::string& robot_name, const std::string& group_name)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel(robot_name);
+  std::vector<moveit::core::RobotState> states =
+      moveit_benchmarks::makeRandomStates(robot_model, robot_model->getJointModelGroup(group_name), NUM_STATES);
+  moveit::core::RobotState state(robot_model);
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    state.setVariablePositions(states[i].getVariablePositions());
+    state.updateLinkTransforms();
+    benchmark::DoNotOptimize(state.getGlobalLinkTransform(robot_model->getLinkModels().back()));
+    i = (i + 1) % states.size();
+  }
+}
+BENCHMARK_CAPTURE(updateLinkTransforms, panda, std::string("panda"), std::string("panda_arm"));
+BENCHMARK_CAPTURE(updateLinkTransforms, pr2, std::string("pr2"), std::string("whole_body"));
+
+static void getJacobian(benchmark::State& st)
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* link = robot_model->getLinkModel("panda_link8");
+  std::vector<moveit::core::RobotState> states = moveit_benchmarks::makeRandomStates(robot_model, group, NUM_STATES);
+  Eigen::MatrixXd jacobian;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    states[i].getJacobian(group, link, Eigen::Vector3d::Zero(), jacobian);
+    benchmark::DoNotOptimize(jacobian.data());
+    i = (i + 1) % states.size();
+  }
+}
+BENCHMARK(getJacobian);
+
+static void setFromIK(benchmark::State& st)
+{
+  const moveit::core::JointModelGroup* group = getPR2RightArmWithIK();
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  const moveit::core::LinkModel* tip = robot_model->getLinkModel("r_wrist_roll_link");
+
+  // targets that are known to be reachable
+  std::vector<Eigen::Isometry3d> targets;
+  for (const moveit::core::RobotState& state : moveit_benchmarks::makeRandomStates(robot_model, group, NUM_STATES))
+    targets.push_back(state.getGlobalLinkTransform(tip));
+
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  std::size_t i = 0;
+  std::size_t solved = 0;
+  for (auto _ : st)
+  {
+    solved += state.setFromIK(group, targets[i], 0.1);
+    i = (i + 1) % targets.size();
+  }
+  st.counters["success_rate"] = benchmark::Counter(static_cast<double>(solved), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(setFromIK);
+
+static void computeCartesianPath(benchmark::State& st)
+{
+  const moveit::core::JointModelGroup* group = getPR2RightArmWithIK();
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("pr2");
+  const moveit::core::LinkModel* tip = robot_model->getLinkModel("r_wrist_roll_link");
+
+  moveit::core::RobotState start_state(robot_model);
+  start_state.setToDefaultValues();
+  const std::vector<double> arm_positions = { -0.5, 0.3, -1.0, -1.2, 0.0, -0.5, 0.0 };
+  start_state.setJointGroupPositions(group, arm_positions);
+  start_state.update();
+
+  std::vector<moveit::core::RobotStatePtr> path;
+  double distance = 0.0;
+  for (auto _ : st)
+  {
+    moveit::core::RobotState state(start_state);
+    distance = moveit::core::CartesianInterpolator::computeCartesianPath(
+                   &state, group, path, tip, Eigen::Vector3d(0.0, 0.0, -0.1), true, moveit::core::MaxEEFStep(0.01),
+                   moveit::core::JumpThreshold())
+                   .meters;
+    benchmark::DoNotOptimize(path.data());
+  }
+  st.counters["distance"] = distance;
+}
+BENCHMARK(computeCartesianPath)->Unit(benchmark::kMicrosecond);
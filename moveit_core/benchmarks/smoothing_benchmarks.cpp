@@ -0,0 +1,105 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks of the online signal smoothing filters of servoing and the local planner */
+
+#include <moveit/online_signal_smoothing/butterworth_filter.h>
+#include <moveit/online_signal_smoothing/critically_damped_filter.h>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+constexpr double FILTER_COEFF = 4.0;
+
+// A different command of every joint
+std::vector<double> makeCommand(std::size_t num_joints)
+{
+  std::vector<double> command(num_joints);
+  for (std::size_t i = 0; i < num_joints; ++i)
+    command[i] = std::sin(static_cast<double>(i));
+  return command;
+}
+}  // namespace
+
+// One ButterworthFilter per joint, as used by the smoothing plugin before the multi-channel filter
+static void butterworthFilterPerJoint(benchmark::State& st)
+{
+  const auto num_joints = static_cast<std::size_t>(st.range(0));
+  const online_signal_smoothing::ButterworthFilter filter(FILTER_COEFF);
+  std::vector<online_signal_smoothing::ButterworthFilter> filters(num_joints, filter);
+  std::vector<double> command = makeCommand(num_joints);
+  for (auto _ : st)
+  {
+    for (std::size_t i = 0; i < num_joints; ++i)
+      command[i] = filters[i].filter(command[i]);
+    benchmark::DoNotOptimize(command.data());
+    benchmark::ClobberMemory();
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(butterworthFilterPerJoint)->RangeMultiplier(4)->Range(4, 256);
+
+static void multiChannelButterworthFilter(benchmark::State& st)
+{
+  const auto num_joints = static_cast<std::size_t>(st.range(0));
+  online_signal_smoothing::MultiChannelButterworthFilter filter(FILTER_COEFF, num_joints);
+  std::vector<double> command = makeCommand(num_joints);
+  for (auto _ : st)
+  {
+    filter.filter(Eigen::Map<Eigen::ArrayXd>(command.data(), command.size()));
+    benchmark::DoNotOptimize(command.data());
+    benchmark::ClobberMemory();
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(multiChannelButterworthFilter)->RangeMultiplier(4)->Range(4, 256);
+
+static void criticallyDampedFilter(benchmark::State& st)
+{
+  const auto num_joints = static_cast<std::size_t>(st.range(0));
+  online_signal_smoothing::CriticallyDampedFilter filter(FILTER_COEFF, static_cast<std::size_t>(st.range(1)),
+                                                         num_joints);
+  std::vector<double> command = makeCommand(num_joints);
+  for (auto _ : st)
+  {
+    filter.filter(Eigen::Map<Eigen::ArrayXd>(command.data(), command.size()));
+    benchmark::DoNotOptimize(command.data());
+    benchmark::ClobberMemory();
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(criticallyDampedFilter)->ArgsProduct({ { 7, 64 }, { 2, 4 } });
@@ -0,0 +1,105 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks of time parameterization and trajectory smoothing */
+
+#include "benchmark_utils.h"
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+constexpr std::size_t NUM_WAYPOINTS = 100;
+
+// A random walk of the panda arm with a slight drift, so that consecutive waypoints are never identical
+robot_trajectory::RobotTrajectory makeRandomWalk()
+{
+  const moveit::core::RobotModelPtr& robot_model = moveit_benchmarks::getRobotModel("panda");
+  static const bool limits_set = [&robot_model] {
+    moveit_benchmarks::setAccelerationLimits(robot_model);
+    return true;
+  }();
+  static_cast<void>(limits_set);
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup("panda_arm");
+
+  random_numbers::RandomNumberGenerator rng(42);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues(group, "ready");
+  std::vector<double> positions;
+  state.copyJointGroupPositions(group, positions);
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+  for (std::size_t i = 0; i < NUM_WAYPOINTS; ++i)
+  {
+    for (double& position : positions)
+      position += rng.uniformReal(-0.02, 0.02) + 0.005;
+    state.setJointGroupPositions(group, positions);
+    state.enforceBounds(group);
+    trajectory.addSuffixWayPoint(state, 0.0);
+  }
+  return trajectory;
+}
+}  // namespace
+
+static void timeOptimalTrajectoryGeneration(benchmark::State& st)
+{
+  const robot_trajectory::RobotTrajectory input = makeRandomWalk();
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  for (auto _ : st)
+  {
+    st.PauseTiming();
+    robot_trajectory::RobotTrajectory trajectory(input, true);
+    st.ResumeTiming();
+    benchmark::DoNotOptimize(totg.computeTimeStamps(trajectory));
+  }
+}
+BENCHMARK(timeOptimalTrajectoryGeneration)->Unit(benchmark::kMillisecond);
+
+static void ruckigSmoothing(benchmark::State& st)
+{
+  robot_trajectory::RobotTrajectory input = makeRandomWalk();
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  totg.computeTimeStamps(input);
+  for (auto _ : st)
+  {
+    st.PauseTiming();
+    robot_trajectory::RobotTrajectory trajectory(input, true);
+    st.ResumeTiming();
+    benchmark::DoNotOptimize(trajectory_processing::RuckigSmoothing::applySmoothing(trajectory));
+  }
+}
+BENCHMARK(ruckigSmoothing)->Unit(benchmark::kMillisecond);
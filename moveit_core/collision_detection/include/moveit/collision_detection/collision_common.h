@@ -105,6 +105,42 @@ struct Contact
   Eigen::Vector3d nearest_points[2];
 };
 
+/** \brief A pair of bodies in contact, referred to by the contacts in CollisionResult::flat_contacts. The names point
+ * to the ids kept by the link, attached body or world object, so they are only valid as long as these bodies exist. */
+struct ContactPair
+{
+  /** \brief The id of the first body, which is the smaller id of the two */
+  const std::string* body_name_1;
+
+  /** \brief The type of the first body */
+  BodyType body_type_1;
+
+  /** \brief The id of the second body */
+  const std::string* body_name_2;
+
+  /** \brief The type of the second body */
+  BodyType body_type_2;
+
+  /** \brief Number of contacts of this pair in CollisionResult::flat_contacts */
+  std::size_t contact_count;
+};
+
+/** \brief A contact stored without the names of its bodies, see CollisionRequest::flat_contacts */
+struct FlatContact
+{
+  /** \brief contact position */
+  Eigen::Vector3d pos;
+
+  /** \brief normal unit vector at contact */
+  Eigen::Vector3d normal;
+
+  /** \brief depth (penetration between bodies) */
+  double depth;
+
+  /** \brief Index of the pair of bodies in contact in CollisionResult::contact_pairs */
+  std::size_t pair_index;
+};
+
 /** \brief When collision costs are computed, this structure contains information about the partial cost incurred in a
  * particular volume */
 struct CostSource
@@ -144,7 +180,12 @@ struct CostSource
 /** \brief Representation of a collision checking result */
 struct CollisionResult
 {
-  CollisionResult() : collision(false), distance(std::numeric_limits<double>::max()), contact_count(0)
+  CollisionResult()
+    : collision(false)
+    , distance(std::numeric_limits<double>::max())
+    , contact_count(0)
+    , broadphase_pairs(0)
+    , narrowphase_tests(0)
   {
   }
   using ContactMap = std::map<std::pair<std::string, std::string>, std::vector<Contact> >;
@@ -158,9 +199,36 @@ struct CollisionResult
     distance = std::numeric_limits<double>::max();
     contact_count = 0;
     contacts.clear();
+    contact_pairs.clear();
+    flat_contacts.clear();
     cost_sources.clear();
+    broadphase_pairs = 0;
+    narrowphase_tests = 0;
   }
 
+  /** \brief Reserve storage for \e max_contacts flat contacts and their pairs, so that checks adding up to that many
+   * contacts to this result do not allocate */
+  void reserveFlatContacts(std::size_t max_contacts)
+  {
+    contact_pairs.reserve(max_contacts);
+    flat_contacts.reserve(max_contacts);
+  }
+
+  /** \brief Get the index of the pair of bodies \e id1 and \e id2 in \e contact_pairs, or the size of \e
+   * contact_pairs if the pair has no flat contacts. The ids are compared by address, so they need to be the ids kept
+   * by the bodies, and are expected in order, i.e. *\e id1 < *\e id2. */
+  std::size_t findContactPair(const std::string* id1, const std::string* id2) const
+  {
+    std::size_t i = 0;
+    while (i < contact_pairs.size() && (contact_pairs[i].body_name_1 != id1 || contact_pairs[i].body_name_2 != id2))
+      ++i;
+    return i;
+  }
+
+  /** \brief Convert the flat contacts to \e contact_map, e.g. to use a result of a check with flat contacts where
+   * the contact map is expected */
+  void getFlatContacts(ContactMap& contact_map) const;
+
   /** \brief Throttled warning printing the first collision pair, if any. All collisions are logged at DEBUG level */
   void print() const;
 
@@ -176,8 +244,21 @@ struct CollisionResult
   /** \brief A map returning the pairs of body ids in contact, plus their contact details */
   ContactMap contacts;
 
+  /** \brief The pairs of bodies in contact, if contacts were requested as flat contacts */
+  std::vector<ContactPair> contact_pairs;
+
+  /** \brief The contacts, if they were requested as flat contacts. The storage is kept by clear(), so a result that
+   * is reused for many checks stops allocating once it held the maximum number of contacts. */
+  std::vector<FlatContact> flat_contacts;
+
   /** \brief These are the individual cost sources when costs are computed */
   std::set<CostSource> cost_sources;
+
+  /** \brief Number of object pairs the broadphase reported as potentially colliding */
+  std::size_t broadphase_pairs;
+
+  /** \brief Number of object pairs that were checked by the narrowphase */
+  std::size_t narrowphase_tests;
 };
 
 /** \brief Representation of a collision checking request */
@@ -185,6 +266,8 @@ struct CollisionRequest
 {
   CollisionRequest()
     : distance(false)
+    , distance_threshold(std::numeric_limits<double>::max())
+    , distance_stop_threshold(std::numeric_limits<double>::lowest())
     , cost(false)
     , contacts(false)
     , max_contacts(1)
@@ -200,15 +283,49 @@ struct CollisionRequest
   /** \brief The group name to check collisions for (optional; if empty, assume the complete robot). Descendent links are included. */
   std::string group_name;
 
+  /** \brief The group to check collisions for. If set, it is used instead of \e group_name, which saves looking up the
+   * group by its name in every check. */
+  const moveit::core::JointModelGroup* group = nullptr;
+
+  /** \brief Get the group to check collisions for: \e group if set, otherwise the group named \e group_name.
+   * Returns nullptr for the complete robot, i.e. if \e group_name is empty or not a group of \e robot_model. */
+  const moveit::core::JointModelGroup* getGroup(const moveit::core::RobotModel& robot_model) const
+  {
+    if (group || group_name.empty())
+      return group;
+    bool has_group;
+    return robot_model.getJointModelGroup(group_name, &has_group);
+  }
+
+  /** \brief Get the name of the group to check collisions for (empty for the complete robot) */
+  const std::string& getGroupName() const
+  {
+    return group ? group->getName() : group_name;
+  }
+
   /** \brief If true, compute proximity distance */
   bool distance;
 
+  /** \brief When computing the proximity distance, ignore objects that are farther apart than this. If no objects are
+   * closer, the reported distance stays at std::numeric_limits<double>::max(). */
+  double distance_threshold;
+
+  /** \brief When computing the proximity distance, stop at the first pair of objects closer than this. The reported
+   * distance is then below the threshold, but not necessarily the minimum distance. */
+  double distance_stop_threshold;
+
   /** \brief If true, a collision cost is computed */
   bool cost;
 
   /** \brief If true, compute contacts. Otherwise only a binary collision yes/no is reported. */
   bool contacts;
 
+  /** \brief If true, computed contacts are stored in CollisionResult::flat_contacts and CollisionResult::contact_pairs
+   * instead of CollisionResult::contacts. This saves allocating map nodes keyed by the body names for every contact,
+   * in particular when the result is reused. Only the FCL collision checker supports flat contacts; the others
+   * ignore this flag. */
+  bool flat_contacts = false;
+
   /** \brief Overall maximum number of contacts to compute */
   std::size_t max_contacts;
 
@@ -249,6 +366,7 @@ struct DistanceRequest
     , active_components_only(nullptr)
     , acm(nullptr)
     , distance_threshold(std::numeric_limits<double>::max())
+    , stop_threshold(std::numeric_limits<double>::lowest())
     , verbose(false)
     , compute_gradient(false)
   {
@@ -259,9 +377,11 @@ struct DistanceRequest
       joints in this group that have their values updated. */
   void enableGroup(const moveit::core::RobotModelConstPtr& robot_model)
   {
-    if (robot_model->hasJointModelGroup(group_name))
+    bool has_group;
+    const moveit::core::JointModelGroup* jmg = group ? group : robot_model->getJointModelGroup(group_name, &has_group);
+    if (jmg)
     {
-      active_components_only = &robot_model->getJointModelGroup(group_name)->getUpdatedLinkModelsSet();
+      active_components_only = &jmg->getUpdatedLinkModelsSet();
     }
     else
     {
@@ -286,6 +406,9 @@ struct DistanceRequest
   /// The group name
   std::string group_name;
 
+  /// The group, used instead of the group name if set
+  const moveit::core::JointModelGroup* group = nullptr;
+
   /// The set of active components to check
   const std::set<const moveit::core::LinkModel*>* active_components_only;
 
@@ -296,6 +419,10 @@ struct DistanceRequest
   /// If set, this can significantly reduce the number of queries.
   double distance_threshold;
 
+  /// Stop the query as soon as the distance of a pair is below this threshold.
+  /// The reported minimum distance is then below the threshold, but not necessarily the global minimum.
+  double stop_threshold;
+
   /// Log debug information
   bool verbose;
 
@@ -366,7 +493,7 @@ using DistanceMap = std::map<const std::pair<std::string, std::string>, std::vec
 /** \brief Result of a distance request. */
 struct DistanceResult
 {
-  DistanceResult() : collision(false)
+  DistanceResult() : collision(false), broadphase_pairs(0), narrowphase_tests(0)
   {
   }
 
@@ -379,12 +506,45 @@ struct DistanceResult
   /// A map of distance data for each link in the req.active_components_only
   DistanceMap distances;
 
+  /// Number of object pairs the broadphase reported to the distance query
+  std::size_t broadphase_pairs;
+
+  /// Number of object pairs whose distance was computed by the narrowphase
+  std::size_t narrowphase_tests;
+
   /// Clear structure data
   void clear()
   {
     collision = false;
     minimum_distance.clear();
     distances.clear();
+    broadphase_pairs = 0;
+    narrowphase_tests = 0;
   }
 };
+
+/** \brief Counters of the queries a collision environment answered, see CollisionEnv::setStatisticsEnabled().
+ *
+ *  A collision query that also computes the distance counts as one collision and one distance query. Environments
+ *  without a broadphase, such as the distance field, leave the pair counters at zero. */
+struct CollisionStatistics
+{
+  /// Number of collision queries
+  std::size_t collision_queries = 0;
+
+  /// Number of distance queries
+  std::size_t distance_queries = 0;
+
+  /// Number of object pairs reported by the broadphase, summed over all queries
+  std::size_t broadphase_pairs = 0;
+
+  /// Number of object pairs checked by the narrowphase, summed over all queries
+  std::size_t narrowphase_tests = 0;
+
+  /// Wall time spent in collision queries (seconds)
+  double collision_time = 0.0;
+
+  /// Wall time spent in distance queries (seconds)
+  double distance_time = 0.0;
+};
 }  // namespace collision_detection
@@ -63,6 +63,15 @@ public:
    */
   virtual CollisionEnvPtr allocateEnv(const CollisionEnvConstPtr& orig, const WorldPtr& world) const = 0;
 
+  /** create a new CollisionEnv for \e world, an unmodified copy of the world of \e parent, that reuses the collision
+   * objects of \e parent instead of copying them. \e parent must not be modified while the new env exists.
+   * Collision detectors without support for this copy \e parent.
+   */
+  virtual CollisionEnvPtr allocateOverlayEnv(const CollisionEnvConstPtr& parent, const WorldPtr& world) const
+  {
+    return allocateEnv(parent, world);
+  }
+
   /** create a new CollisionEnv given a robot_model with a new empty world */
   virtual CollisionEnvPtr allocateEnv(const moveit::core::RobotModelConstPtr& robot_model) const = 0;
 };
@@ -42,6 +42,10 @@
 #include <moveit_msgs/msg/link_padding.hpp>
 #include <moveit_msgs/msg/link_scale.hpp>
 #include <moveit/collision_detection/world.h>
+#include <moveit/collision_detection/memory_usage.h>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
 
 namespace collision_detection
 {
@@ -236,6 +240,12 @@ public:
    * Passing nullptr will result in a new empty world being created. */
   virtual void setWorld(const WorldPtr& world);
 
+  /** \brief Add an estimate of the memory held by the geometry this collision checker built for the robot links,
+   *  attached bodies and world objects to \e usage, in bytes per link or object name.
+   *
+   *  The default implementation adds nothing, as it does not build any geometry. */
+  virtual void getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& usage) const;
+
   /** access the world geometry */
   const WorldPtr& getWorld()
   {
@@ -302,7 +312,66 @@ public:
   /** @brief Get the link scaling as a vector of messages*/
   void getScale(std::vector<moveit_msgs::msg::LinkScale>& scale) const;
 
+  /** @brief Enable or disable collecting statistics of the collision and distance queries (disabled by default).
+   *
+   *  Each query counts in its own result and adds to the totals of the environment once it is done, so concurrent
+   *  queries only share a few atomic additions per query. */
+  void setStatisticsEnabled(bool enabled)
+  {
+    statistics_enabled_ = enabled;
+  }
+
+  /** @brief Check if query statistics are collected */
+  bool getStatisticsEnabled() const
+  {
+    return statistics_enabled_;
+  }
+
+  /** @brief Get the statistics of the queries since construction or the last call to resetStatistics() */
+  CollisionStatistics getStatistics() const;
+
+  /** @brief Reset the query statistics to zero */
+  void resetStatistics();
+
 protected:
+  /** @brief Adds one query to the statistics of an environment when it goes out of scope.
+   *
+   *  Collision environments create one at the start of each collision or distance query, for the result the query
+   *  writes to. Nothing is measured while statistics are disabled. */
+  template <typename ResultT>
+  class QueryRecorder
+  {
+  public:
+    QueryRecorder(const CollisionEnv& env, const ResultT& res)
+      : env_(env.statistics_enabled_ ? &env : nullptr), res_(res)
+    {
+      if (env_)
+      {
+        broadphase_pairs_ = res.broadphase_pairs;
+        narrowphase_tests_ = res.narrowphase_tests;
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~QueryRecorder()
+    {
+      if (env_)
+        env_->addQueryStatistics(std::is_same<ResultT, DistanceResult>::value,
+                                 res_.broadphase_pairs - broadphase_pairs_, res_.narrowphase_tests - narrowphase_tests_,
+                                 std::chrono::steady_clock::now() - start_);
+    }
+
+    QueryRecorder(const QueryRecorder&) = delete;
+    QueryRecorder& operator=(const QueryRecorder&) = delete;
+
+  private:
+    const CollisionEnv* env_;
+    const ResultT& res_;
+    std::size_t broadphase_pairs_ = 0;
+    std::size_t narrowphase_tests_ = 0;
+    std::chrono::steady_clock::time_point start_;
+  };
+
   /** @brief When the scale or padding is changed for a set of links by any of the functions in this class,
      updatedPaddingOrScaling() function is called.
       This function has an empty default implementation. The intention is to override this function in a derived class
@@ -321,7 +390,19 @@ protected:
   std::map<std::string, double> link_scale_;
 
 private:
+  /** @brief Add the counters of one finished query to the statistics */
+  void addQueryStatistics(bool distance_query, std::size_t broadphase_pairs, std::size_t narrowphase_tests,
+                          std::chrono::steady_clock::duration time) const;
+
   WorldPtr world_;             // The world always valid, never nullptr.
   WorldConstPtr world_const_;  // always same as world_
+
+  std::atomic<bool> statistics_enabled_{ false };
+  mutable std::atomic<std::size_t> collision_queries_{ 0 };
+  mutable std::atomic<std::size_t> distance_queries_{ 0 };
+  mutable std::atomic<std::size_t> broadphase_pairs_{ 0 };
+  mutable std::atomic<std::size_t> narrowphase_tests_{ 0 };
+  mutable std::atomic<std::chrono::steady_clock::rep> collision_time_{ 0 };
+  mutable std::atomic<std::chrono::steady_clock::rep> distance_time_{ 0 };
 };
 }  // namespace collision_detection
@@ -37,12 +37,15 @@
 #pragma once
 
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/collision_detection/persistent_map.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/msg/allowed_collision_matrix.hpp>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <map>
+#include <cstdint>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -246,14 +249,92 @@ public:
   /** @brief Print the allowed collision matrix */
   void print(std::ostream& out) const;
 
+  /** @brief Get a value that changes whenever the allowed collision matrix is modified.
+   *  Copies share the version of the matrix they were copied from until either of them is modified. */
+  std::size_t getVersion() const
+  {
+    return version_;
+  }
+
 private:
+  friend class CompiledAllowedCollisionMatrix;
+
   bool getDefaultEntry(const std::string& name1, const std::string& name2,
                        AllowedCollision::Type& allowed_collision) const;
 
-  std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
-  std::map<std::string, std::map<std::string, DecideContactFn> > allowed_contacts_;
+  /** @brief Assign a new, globally unique value to \e version_ */
+  void updateVersion();
+
+  /** @brief Remove the predicate of the entry of \e name2 in the row of \e name1, if any */
+  void removeAllowedContact(const std::string& name1, const std::string& name2);
+
+  // Copies of the matrix share the structure of the entries, so copying is O(1) and setting an entry
+  // is O(log n) in the matrix and the copy
+  PersistentMap<std::string, PersistentMap<std::string, AllowedCollision::Type> > entries_;
+  PersistentMap<std::string, PersistentMap<std::string, DecideContactFn> > allowed_contacts_;
 
   std::map<std::string, AllowedCollision::Type> default_entries_;
   std::map<std::string, DecideContactFn> default_allowed_contacts_;
+
+  std::size_t version_;
+};
+
+MOVEIT_CLASS_FORWARD(CompiledAllowedCollisionMatrix);  // Defines CompiledAllowedCollisionMatrixPtr, ConstPtr, ...
+
+/** @class CompiledAllowedCollisionMatrix
+ *  @brief Snapshot of an AllowedCollisionMatrix for a fixed set of names, which are referred to by their index.
+ *
+ *  The allowed collision type of every pair of names, including the defaults, is resolved when the snapshot is
+ *  created and stored in a dense matrix, so that collision checkers can look it up without any string comparisons.
+ *  The predicates of conditional entries are kept in a side table. */
+class CompiledAllowedCollisionMatrix
+{
+public:
+  /** @brief Resolve the entries of \e acm between all pairs of \e names */
+  CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm, const std::vector<std::string>& names);
+
+  /** @brief Get the version of the allowed collision matrix this snapshot was created from */
+  std::size_t getSourceVersion() const
+  {
+    return source_version_;
+  }
+
+  /** @brief Get the names the indices refer to */
+  const std::vector<std::string>& getNames() const
+  {
+    return names_;
+  }
+
+  /** @brief Get the type of the allowed collision between the elements with index \e i and \e j.
+   *  Return false if neither an entry nor defaults were found, like AllowedCollisionMatrix::getAllowedCollision() */
+  bool getAllowedCollision(std::size_t i, std::size_t j, AllowedCollision::Type& allowed_collision) const
+  {
+    const std::uint8_t entry = entries_[i * names_.size() + j];
+    if (entry == NOT_FOUND)
+      return false;
+    allowed_collision = static_cast<AllowedCollision::Type>(entry);
+    return true;
+  }
+
+  /** @brief Get the predicate of a conditional entry between the elements with index \e i and \e j.
+   *  Return nullptr if the entry is not conditional. */
+  const DecideContactFn* getAllowedContactFn(std::size_t i, std::size_t j) const
+  {
+    const auto it = allowed_contacts_.find(i * names_.size() + j);
+    return it == allowed_contacts_.end() ? nullptr : &it->second;
+  }
+
+private:
+  static constexpr std::uint8_t NOT_FOUND = 0xFF;
+
+  std::vector<std::string> names_;
+
+  /** @brief Row-major matrix of AllowedCollision::Type values, or NOT_FOUND */
+  std::vector<std::uint8_t> entries_;
+
+  /** @brief Predicates of the conditional entries, indexed like \e entries_ */
+  std::unordered_map<std::size_t, DecideContactFn> allowed_contacts_;
+
+  std::size_t source_version_;
 };
 }  // namespace collision_detection
@@ -0,0 +1,68 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/collision_detection/world.h>
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace collision_detection
+{
+/** \brief Estimated memory, in bytes, held by the geometry of a world or planning scene.
+ *
+ *  The estimates count the data of the geometry (vertices, triangles, octree nodes, bounding volumes), not the
+ *  bookkeeping around it, so they are meant to spot growth rather than to add up to the memory of the process. */
+struct MemoryUsage
+{
+  /// Shapes of each world object, except octrees
+  std::map<std::string, std::size_t> world_objects;
+
+  /// Octrees of each world object
+  std::map<std::string, std::size_t> octrees;
+
+  /// Geometry built by the collision checker for each world object, robot link and attached body
+  std::map<std::string, std::size_t> collision_geometry;
+
+  /** \brief Get the sum of all entries */
+  std::size_t getTotal() const;
+};
+
+/** \brief Estimate the memory of the data of \e shape */
+std::size_t estimateShapeMemoryUsage(const shapes::Shape& shape);
+
+/** \brief Add the shapes of \e object to \e usage */
+void addObjectMemoryUsage(const World::Object& object, MemoryUsage& usage);
+}  // namespace collision_detection
@@ -0,0 +1,115 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <geometric_shapes/shapes.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace collision_detection
+{
+/** \brief Compute a hash of the vertices and triangles of \e mesh */
+std::size_t computeMeshHash(const shapes::Mesh& mesh);
+
+/** \brief Check if two meshes have identical vertices and triangles */
+bool meshesEqual(const shapes::Mesh& mesh1, const shapes::Mesh& mesh2);
+
+/** \brief Thread-safe cache of geometry built from meshes, keyed by the content of the meshes.
+ *
+ *  Collision backends use this to build expensive geometry, e.g. bounding volume hierarchies, only once for all
+ *  objects that use identical meshes, even if every object holds its own copy of the mesh. The cache only keeps
+ *  weak references to the geometry, which is freed as soon as no collision object uses it anymore. */
+template <typename T>
+class MeshGeometryCache
+{
+public:
+  /** \brief Function that builds the geometry for a mesh */
+  using CreateFn = std::function<std::shared_ptr<T>(const shapes::Mesh&)>;
+
+  /** \brief Return the geometry cached for a mesh with the same content as \e mesh, or build it with \e create */
+  std::shared_ptr<T> getOrCreate(const std::shared_ptr<const shapes::Mesh>& mesh, const CreateFn& create)
+  {
+    const std::size_t hash = computeMeshHash(*mesh);
+    {
+      std::scoped_lock lock(lock_);
+      const auto range = entries_.equal_range(hash);
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        std::shared_ptr<T> geometry = it->second.geometry.lock();
+        if (geometry && (it->second.mesh == mesh || meshesEqual(*it->second.mesh, *mesh)))
+          return geometry;
+      }
+    }
+
+    // build without holding the lock, as this may take a while for large meshes
+    std::shared_ptr<T> geometry = create(*mesh);
+    if (geometry)
+    {
+      std::scoped_lock lock(lock_);
+      if (++insert_count_ >= MAX_CLEAN_COUNT)
+      {
+        // remove entries for geometry that is no longer used
+        for (auto it = entries_.begin(); it != entries_.end();)
+          it = it->second.geometry.expired() ? entries_.erase(it) : std::next(it);
+        insert_count_ = 0;
+      }
+      entries_.emplace(hash, Entry{ mesh, geometry });
+    }
+    return geometry;
+  }
+
+  /** \brief Remove all entries from the cache. Geometry still in use stays valid. */
+  void clear()
+  {
+    std::scoped_lock lock(lock_);
+    entries_.clear();
+  }
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<const shapes::Mesh> mesh;  // the mesh the geometry was built from, to resolve hash collisions
+    std::weak_ptr<T> geometry;
+  };
+
+  static const unsigned int MAX_CLEAN_COUNT = 100;  // every this many insertions, unused entries are removed
+
+  std::mutex lock_;
+  std::unordered_multimap<std::size_t, Entry> entries_;
+  unsigned int insert_count_ = 0;
+};
+}  // namespace collision_detection
@@ -38,6 +38,7 @@
 
 #include <octomap/octomap.h>
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <shared_mutex>
@@ -59,6 +60,11 @@ public:
   {
   }
 
+  /** @brief Deep copy of the cells of @e tree */
+  OccMapTree(const octomap::OcTree& tree) : octomap::OcTree(tree)
+  {
+  }
+
   /** @brief lock the underlying octree. it will not be read or written by the
    *  monitor until unlockTree() is called */
   void lockRead()
@@ -110,11 +116,89 @@ public:
     update_callback_ = update_callback;
   }
 
+  /** @brief Delete all cells that do not intersect the axis aligned box [min, max]. Cells crossing the boundary of
+   *  the box are kept as a whole. If change detection is enabled, the deleted occupied cells are reported as
+   *  changed. The tree must be locked for writing. */
+  void clearOutsideBBX(const octomap::point3d& min, const octomap::point3d& max);
+
+  /** @brief Delete all cells. The tree must be locked for writing. */
+  void clear()
+  {
+    octomap::OcTree::clear();
+    markStructureChanged();
+  }
+
+  /** @brief Record that the cells changed in a way change detection does not report, e.g. when the tree was read
+   *  from a file or cells were deleted */
+  void markStructureChanged()
+  {
+    ++structure_version_;
+  }
+
+  /** @brief Get a counter of the changes not reported by change detection. As long as it is the same, the cells
+   *  reported as changed are all cells whose occupancy changed */
+  std::size_t getStructureVersion() const
+  {
+    return structure_version_;
+  }
+
 private:
+  enum class BBXOverlap
+  {
+    OUTSIDE,
+    CROSSING,
+    INSIDE
+  };
+
+  BBXOverlap computeBBXOverlap(const octomap::OcTreeKey& key, unsigned int depth, const octomap::OcTreeKey& min_key,
+                               const octomap::OcTreeKey& max_key) const;
+  bool hasCellsInBBX(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                     const octomap::OcTreeKey& min_key, const octomap::OcTreeKey& max_key) const;
+  void copyCellsInBBX(const OccMapNode* node, OccMapNode* copy, const octomap::OcTreeKey& key, unsigned int depth,
+                      const octomap::OcTreeKey& min_key, const octomap::OcTreeKey& max_key, bool inside,
+                      OccMapTree& window);
+  void reportEvictedCells(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth);
+
   std::shared_mutex tree_mutex_;
   std::function<void()> update_callback_;
+  std::size_t structure_version_ = 0;
 };
 
 using OccMapTreePtr = std::shared_ptr<OccMapTree>;
 using OccMapTreeConstPtr = std::shared_ptr<const OccMapTree>;
+
+/** @brief Immutable copies of an OccMapTree, so that readers (e.g. collision checks) never wait for the writers of
+ *  the tree
+ *
+ *  Each update creates a new snapshot of the tree. The trees of the snapshots are double buffered: the tree of the
+ *  snapshot before the current one is reused once no reader holds it anymore, and only the cells reported as changed
+ *  since then are copied into it. Otherwise, and after changes that change detection does not report, the tree is
+ *  copied completely. The cells of a snapshot have the occupancy of the cells of the tree, their log-odds may differ
+ *  as long as that does not change their occupancy.
+ *
+ *  Updates must not run concurrently. */
+class OccMapTreeSnapshots
+{
+public:
+  /** @brief Create a snapshot of @e tree, which must be locked for reading and have change detection enabled. The
+   *  caller resets the change detection of the tree after the update. */
+  std::shared_ptr<const octomap::OcTree> update(const OccMapTree& tree);
+
+  /** @brief Get the last snapshot, nullptr before the first update */
+  const std::shared_ptr<const octomap::OcTree>& get() const
+  {
+    return current_snapshot_;
+  }
+
+  /** @brief Forget all snapshots, the next update copies the tree completely */
+  void reset();
+
+private:
+  std::shared_ptr<OccMapTree> current_;
+  std::shared_ptr<const octomap::OcTree> current_snapshot_;
+  std::shared_ptr<OccMapTree> previous_;
+  // the cells changed between previous_ and current_
+  octomap::KeySet previous_changes_;
+  std::size_t structure_version_ = 0;
+};
 }  // namespace collision_detection
@@ -0,0 +1,400 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: A sorted map with structural sharing between copies */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief A sorted map whose copies share their structure.
+ *
+ * The map is a balanced (AVL) binary tree of reference-counted nodes. Copying a map only copies the pointer to the
+ * root, so it is O(1). Modifying a map copies the O(log n) nodes on the path to the modified entry if they are shared
+ * with other copies, and modifies them in place otherwise. Other copies never see the change.
+ * Iteration visits the entries in the order of their keys, like std::map.
+ *
+ * A map can be copied while other threads read it, but not while it is modified. */
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class PersistentMap
+{
+  struct Node;
+  using NodePtr = std::shared_ptr<Node>;
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+
+  /** \brief Iterator over the entries in the order of their keys */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename PersistentMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const
+    {
+      return stack_.back()->value;
+    }
+    pointer operator->() const
+    {
+      return &stack_.back()->value;
+    }
+    const_iterator& operator++()
+    {
+      const Node* node = stack_.back();
+      stack_.pop_back();
+      pushLeftSpine(node->right.get());
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return stack_.empty() ? other.stack_.empty() : !other.stack_.empty() && stack_.back() == other.stack_.back();
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend class PersistentMap;
+
+    void pushLeftSpine(const Node* node)
+    {
+      for (; node; node = node->left.get())
+        stack_.push_back(node);
+    }
+
+    // The current node is at the back, preceded by the ancestors whose entries come after it
+    std::vector<const Node*> stack_;
+  };
+
+  PersistentMap() = default;
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  const_iterator begin() const
+  {
+    const_iterator it;
+    it.pushLeftSpine(root_.get());
+    return it;
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator();
+  }
+
+  /** \brief Find the entry of a key. Returns end() if there is none. */
+  const_iterator find(const Key& key) const
+  {
+    const_iterator it;
+    for (const Node* node = root_.get(); node;)
+    {
+      if (compare_(key, node->value.first))
+      {
+        it.stack_.push_back(node);
+        node = node->left.get();
+      }
+      else if (compare_(node->value.first, key))
+        node = node->right.get();
+      else
+      {
+        it.stack_.push_back(node);
+        return it;
+      }
+    }
+    return end();
+  }
+
+  /** \brief Get the value of a key, or nullptr if there is none */
+  const T* get(const Key& key) const
+  {
+    const Node* node = findNode(key);
+    return node ? &node->value.second : nullptr;
+  }
+
+  bool contains(const Key& key) const
+  {
+    return findNode(key) != nullptr;
+  }
+
+  /** \brief Get the value of a key for modification, or nullptr if there is none.
+   * The nodes on the path to the entry are unshared first, so the modification is not seen by other copies.
+   * The pointer is valid until the map is modified again. */
+  T* getMutable(const Key& key)
+  {
+    if (!findNode(key))
+      return nullptr;
+    NodePtr* link = &root_;
+    while (true)
+    {
+      Node* node = unshare(*link);
+      if (compare_(key, node->value.first))
+        link = &node->left;
+      else if (compare_(node->value.first, key))
+        link = &node->right;
+      else
+        return &node->value.second;
+    }
+  }
+
+  /** \brief Get the value of a key for modification, inserting a default constructed value if there is none.
+   * See getMutable(). */
+  T& operator[](const Key& key)
+  {
+    if (T* value = getMutable(key))
+      return *value;
+    T* value = nullptr;
+    insert(root_, key, value);
+    ++size_;
+    return *value;
+  }
+
+  /** \brief Call fn(key, value) for every entry in the order of the keys, with the value open for modification.
+   * All nodes are unshared first, so this is O(n) even if fn does not modify anything. fn must not modify the map. */
+  template <typename Fn>
+  void forEachMutable(const Fn& fn)
+  {
+    forEachMutable(root_, fn);
+  }
+
+  /** \brief Remove the entry of a key. Returns false if there is none. */
+  bool erase(const Key& key)
+  {
+    if (!findNode(key))
+      return false;
+    erase(root_, key);
+    --size_;
+    return true;
+  }
+
+  void clear()
+  {
+    root_.reset();
+    size_ = 0;
+  }
+
+  /** \brief True if this map and \e other share their whole structure, i.e. neither was modified since one was copied
+   * from the other. Maps that do not share their structure may still be equal. */
+  bool sharesStructureWith(const PersistentMap& other) const
+  {
+    return root_ == other.root_;
+  }
+
+private:
+  struct Node
+  {
+    Node(const Key& key) : value(key, T())
+    {
+    }
+
+    value_type value;
+    NodePtr left, right;
+    int height = 1;
+  };
+
+  const Node* findNode(const Key& key) const
+  {
+    const Node* node = root_.get();
+    while (node)
+    {
+      if (compare_(key, node->value.first))
+        node = node->left.get();
+      else if (compare_(node->value.first, key))
+        node = node->right.get();
+      else
+        break;
+    }
+    return node;
+  }
+
+  // Make sure that *node is referenced only by this map, copying it if it is shared with another map
+  static Node* unshare(NodePtr& node)
+  {
+    if (node.use_count() > 1)
+      node = std::make_shared<Node>(*node);
+    return node.get();
+  }
+
+  static int height(const NodePtr& node)
+  {
+    return node ? node->height : 0;
+  }
+
+  static void updateHeight(Node* node)
+  {
+    node->height = 1 + std::max(height(node->left), height(node->right));
+  }
+
+  static void rotateLeft(NodePtr& node)
+  {
+    unshare(node);
+    unshare(node->right);
+    NodePtr pivot = node->right;
+    node->right = pivot->left;
+    updateHeight(node.get());
+    pivot->left = node;
+    updateHeight(pivot.get());
+    node = std::move(pivot);
+  }
+
+  static void rotateRight(NodePtr& node)
+  {
+    unshare(node);
+    unshare(node->left);
+    NodePtr pivot = node->left;
+    node->left = pivot->right;
+    updateHeight(node.get());
+    pivot->right = node;
+    updateHeight(pivot.get());
+    node = std::move(pivot);
+  }
+
+  // Restore the AVL balance of an unshared node whose subtrees differ in height by at most 2
+  static void rebalance(NodePtr& node)
+  {
+    updateHeight(node.get());
+    const int balance = height(node->left) - height(node->right);
+    if (balance > 1)
+    {
+      if (height(node->left->left) < height(node->left->right))
+        rotateLeft(node->left);
+      rotateRight(node);
+    }
+    else if (balance < -1)
+    {
+      if (height(node->right->right) < height(node->right->left))
+        rotateRight(node->right);
+      rotateLeft(node);
+    }
+  }
+
+  // Insert a key that is not in the map yet and point value to its default constructed value
+  void insert(NodePtr& node, const Key& key, T*& value)
+  {
+    if (!node)
+    {
+      node = std::make_shared<Node>(key);
+      value = &node->value.second;
+      return;
+    }
+    unshare(node);
+    insert(compare_(key, node->value.first) ? node->left : node->right, key, value);
+    rebalance(node);
+  }
+
+  // Remove a key that is in the map
+  void erase(NodePtr& node, const Key& key)
+  {
+    unshare(node);
+    if (compare_(key, node->value.first))
+      erase(node->left, key);
+    else if (compare_(node->value.first, key))
+      erase(node->right, key);
+    else if (!node->left)
+      node = node->right;
+    else if (!node->right)
+      node = node->left;
+    else
+    {
+      // Keys are const, so the successor takes the place of the removed node
+      NodePtr successor;
+      removeMin(node->right, successor);
+      unshare(successor);
+      successor->left = node->left;
+      successor->right = node->right;
+      node = std::move(successor);
+    }
+    if (node)
+      rebalance(node);
+  }
+
+  template <typename Fn>
+  static void forEachMutable(NodePtr& node, const Fn& fn)
+  {
+    if (!node)
+      return;
+    Node* unshared = unshare(node);
+    forEachMutable(unshared->left, fn);
+    fn(unshared->value.first, unshared->value.second);
+    forEachMutable(unshared->right, fn);
+  }
+
+  // Detach the node with the smallest key of a subtree
+  static void removeMin(NodePtr& node, NodePtr& min)
+  {
+    if (!node->left)
+    {
+      min = node;
+      node = node->right;
+      return;
+    }
+    unshare(node);
+    removeMin(node->left, min);
+    rebalance(node);
+  }
+
+  NodePtr root_;
+  std::size_t size_ = 0;
+  Compare compare_;
+};
+}  // namespace collision_detection
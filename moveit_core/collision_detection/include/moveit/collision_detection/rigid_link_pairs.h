@@ -0,0 +1,65 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Link pairs whose relative transform is fixed while only the joints of a group move */
+
+#pragma once
+
+#include <moveit/robot_model/joint_model_group.h>
+#include <utility>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief The link pairs of a group that move rigidly with respect to each other, see getRigidLinkPairs() */
+struct RigidLinkPairs
+{
+  /** \brief Pairs of links with collision geometry that are moved by the group, but whose relative transform only
+   *   depends on the \e frozen_variables */
+  std::vector<std::pair<const moveit::core::LinkModel*, const moveit::core::LinkModel*>> pairs;
+
+  /** \brief Indices of the variables that the joints of the group don't move */
+  std::vector<std::size_t> frozen_variables;
+};
+
+/** \brief Find the link pairs that can't change their collision state while only the joints of \e group move.
+ *
+ *  Two links moved by the group are rigidly connected if the closest group joint above each of them in the kinematic
+ *  tree is the same one, e.g. the last link of an arm and the fingers of a hand that is not part of the group. Their
+ *  collision state only depends on the frozen variables, so a self-collision check for the group can skip them once
+ *  they are known to be apart for the current values of the frozen variables. Links that the group doesn't move are
+ *  not included, since self-collision checks for the group already skip pairs of them. Mimic joints of group joints
+ *  count as group joints. */
+RigidLinkPairs getRigidLinkPairs(const moveit::core::JointModelGroup& group);
+}  // namespace collision_detection
@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/macros/class_forward.h>
+#include <moveit/collision_detection/persistent_map.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -63,7 +64,8 @@ public:
 
   /** \brief A copy constructor.
    * \e other should not be changed while the copy constructor is running
-   * This does copy on write and should be quick. */
+   * This does copy on write and is O(1): the copy shares the objects and the structure of the object map with
+   * \e other, and modifying an object in either world only copies that object and O(log n) map nodes. */
   World(const World& other);
 
   virtual ~World();
@@ -123,7 +125,7 @@ public:
   ObjectConstPtr getObject(const std::string& object_id) const;
 
   /** iterator over the objects in the world. */
-  using const_iterator = std::map<std::string, ObjectPtr>::const_iterator;
+  using const_iterator = PersistentMap<std::string, ObjectPtr>::const_iterator;
   /** iterator pointing to first change */
   const_iterator begin() const
   {
@@ -313,6 +315,15 @@ public:
    * Used which switching from one world to another. */
   void notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const;
 
+  /** \brief Get a counter that increases with every change to the objects of this world, including their subframes.
+   *
+   * Information derived from the objects can be cached as long as the counter does not change. Copies of a world
+   * start counting from zero. */
+  std::size_t getChangeCount() const
+  {
+    return change_count_;
+  }
+
 private:
   /** notify all observers of a change */
   void notify(const ObjectConstPtr& /*obj*/, Action /*action*/);
@@ -332,8 +343,11 @@ private:
   /** \brief Updates the global shape and subframe poses. */
   void updateGlobalPosesInternal(ObjectPtr& obj, bool update_shape_poses = true, bool update_subframe_poses = true);
 
-  /** The objects maintained in the world */
-  std::map<std::string, ObjectPtr> objects_;
+  /** The objects maintained in the world, shared with copies of this world */
+  PersistentMap<std::string, ObjectPtr> objects_;
+
+  /** The number of changes to objects_, see getChangeCount() */
+  std::size_t change_count_ = 0;
 
   /** Wrapper for a callback function to call when something changes in the world */
   class Observer
@@ -0,0 +1,124 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Uniform grid over the bounding boxes of world objects for region and nearest-object queries */
+
+#pragma once
+
+#include <moveit/collision_detection/world.h>
+#include <moveit/macros/class_forward.h>
+#include <array>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace collision_detection
+{
+MOVEIT_CLASS_FORWARD(WorldSpatialIndex);  // Defines WorldSpatialIndexPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Spatial index over the axis-aligned bounding boxes (AABBs) of the objects of a World.
+ *
+ * The AABBs are binned into a uniform grid, which is kept up to date through the world's observer callbacks. Region
+ * and nearest-object queries only visit the cells around the query instead of iterating over all objects. Objects
+ * that would cover too many cells, and unbounded ones such as planes, are kept in a separate list that every query
+ * checks. Queries are conservative: they are answered for the AABBs, not for the exact object geometry. */
+class WorldSpatialIndex
+{
+public:
+  /** \brief Index the objects of \e world, binned into cubic cells with edge length \e cell_size (meters) */
+  WorldSpatialIndex(const WorldPtr& world, double cell_size = 0.5);
+  ~WorldSpatialIndex();
+
+  WorldSpatialIndex(const WorldSpatialIndex&) = delete;
+  WorldSpatialIndex& operator=(const WorldSpatialIndex&) = delete;
+
+  double getCellSize() const
+  {
+    return cell_size_;
+  }
+
+  /** \brief Get the AABB of object \e object_id in the world frame. Returns false for unknown and unbounded objects. */
+  bool getObjectAABB(const std::string& object_id, Eigen::AlignedBox3d& aabb) const;
+
+  /** \brief Compute the AABB of \e object in the world frame. Returns false if the object has no finite bounds; an
+   * object without shapes has an empty AABB. */
+  static bool computeObjectAABB(const World::Object& object, Eigen::AlignedBox3d& aabb);
+
+  /** \brief Get the ids of the objects whose AABB intersects \e region, sorted.
+   * Unbounded objects are always included. */
+  std::vector<std::string> getObjectsInRegion(const Eigen::AlignedBox3d& region) const;
+
+  /** \brief Get the ids of the objects whose AABB is at most \e distance away from \e point, sorted.
+   * Unbounded objects are always included. */
+  std::vector<std::string> getObjectsNear(const Eigen::Vector3d& point, double distance) const;
+
+  /** \brief Find the object whose AABB is closest to \e point. The distance is 0 if \e point is inside the AABB.
+   * Unbounded objects are ignored. Returns false if there is no bounded object. */
+  bool getNearestObject(const Eigen::Vector3d& point, std::string& object_id, double& distance) const;
+
+private:
+  using CellIndex = std::array<int, 3>;
+  struct CellIndexHash
+  {
+    std::size_t operator()(const CellIndex& index) const;
+  };
+
+  /** \brief Callback for changes of the world */
+  void notify(const World::ObjectConstPtr& object, World::Action action);
+
+  void insertObject(const World::Object& object);
+  void removeObject(const std::string& object_id);
+
+  CellIndex getCellIndex(const Eigen::Vector3d& point) const;
+
+  /** \brief Distance from \e point to \e aabb, 0 if \e point is inside */
+  static double distance(const Eigen::Vector3d& point, const Eigen::AlignedBox3d& aabb);
+
+  WorldWeakPtr world_;
+  World::ObserverHandle observer_handle_;
+  const double cell_size_;
+
+  /// AABBs of the bounded objects, in the grid or in large_objects_
+  std::map<std::string, Eigen::AlignedBox3d> aabbs_;
+  /// ids of the objects overlapping each non-empty cell
+  std::unordered_map<CellIndex, std::vector<std::string>, CellIndexHash> cells_;
+  /// bounded objects that cover too many cells to be binned
+  std::set<std::string> large_objects_;
+  /// objects without finite bounds, e.g. planes
+  std::set<std::string> unbounded_objects_;
+  /// range of cells that were ever occupied, bounds the nearest-object search
+  CellIndex min_cell_;
+  CellIndex max_cell_;
+};
+}  // namespace collision_detection
@@ -42,9 +42,38 @@ constexpr size_t LOG_THROTTLE_PERIOD{ 5 };
 
 namespace collision_detection
 {
+void CollisionResult::getFlatContacts(ContactMap& contact_map) const
+{
+  contact_map.clear();
+  Contact contact;
+  for (const FlatContact& flat_contact : flat_contacts)
+  {
+    const ContactPair& pair = contact_pairs[flat_contact.pair_index];
+    contact.pos = flat_contact.pos;
+    contact.normal = flat_contact.normal;
+    contact.depth = flat_contact.depth;
+    contact.body_name_1 = *pair.body_name_1;
+    contact.body_type_1 = pair.body_type_1;
+    contact.body_name_2 = *pair.body_name_2;
+    contact.body_type_2 = pair.body_type_2;
+    contact_map[std::make_pair(*pair.body_name_1, *pair.body_name_2)].push_back(contact);
+  }
+}
+
 void CollisionResult::print() const
 {
   rclcpp::Clock clock;
+  if (contacts.empty() && !contact_pairs.empty())
+  {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, clock, LOG_THROTTLE_PERIOD,
+                                "Objects in collision (printing 1st of "
+                                    << contact_pairs.size() << " pairs): " << *contact_pairs.front().body_name_1 << ", "
+                                    << *contact_pairs.front().body_name_2);
+#pragma GCC diagnostic pop
+    return;
+  }
   if (!contacts.empty())
   {
 #pragma GCC diagnostic push
@@ -112,6 +112,7 @@ CollisionEnv::CollisionEnv(const CollisionEnv& other, const WorldPtr& world)
 {
   link_padding_ = other.link_padding_;
   link_scale_ = other.link_scale_;
+  statistics_enabled_ = other.statistics_enabled_.load();
 }
 void CollisionEnv::setPadding(const double padding)
 {
@@ -288,6 +289,48 @@ void CollisionEnv::getScale(std::vector<moveit_msgs::msg::LinkScale>& scale) con
   }
 }
 
+CollisionStatistics CollisionEnv::getStatistics() const
+{
+  CollisionStatistics stats;
+  stats.collision_queries = collision_queries_.load(std::memory_order_relaxed);
+  stats.distance_queries = distance_queries_.load(std::memory_order_relaxed);
+  stats.broadphase_pairs = broadphase_pairs_.load(std::memory_order_relaxed);
+  stats.narrowphase_tests = narrowphase_tests_.load(std::memory_order_relaxed);
+  using Seconds = std::chrono::duration<double>;
+  stats.collision_time =
+      std::chrono::duration_cast<Seconds>(std::chrono::steady_clock::duration(collision_time_.load())).count();
+  stats.distance_time =
+      std::chrono::duration_cast<Seconds>(std::chrono::steady_clock::duration(distance_time_.load())).count();
+  return stats;
+}
+
+void CollisionEnv::resetStatistics()
+{
+  collision_queries_ = 0;
+  distance_queries_ = 0;
+  broadphase_pairs_ = 0;
+  narrowphase_tests_ = 0;
+  collision_time_ = 0;
+  distance_time_ = 0;
+}
+
+void CollisionEnv::addQueryStatistics(bool distance_query, std::size_t broadphase_pairs, std::size_t narrowphase_tests,
+                                      std::chrono::steady_clock::duration time) const
+{
+  if (distance_query)
+  {
+    distance_queries_.fetch_add(1, std::memory_order_relaxed);
+    distance_time_.fetch_add(time.count(), std::memory_order_relaxed);
+  }
+  else
+  {
+    collision_queries_.fetch_add(1, std::memory_order_relaxed);
+    collision_time_.fetch_add(time.count(), std::memory_order_relaxed);
+  }
+  broadphase_pairs_.fetch_add(broadphase_pairs, std::memory_order_relaxed);
+  narrowphase_tests_.fetch_add(narrowphase_tests, std::memory_order_relaxed);
+}
+
 void CollisionEnv::updatedPaddingOrScaling(const std::vector<std::string>& /*links*/)
 {
 }
@@ -301,6 +344,10 @@ void CollisionEnv::setWorld(const WorldPtr& world)
   world_const_ = world;
 }
 
+void CollisionEnv::getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& /*usage*/) const
+{
+}
+
 void CollisionEnv::checkCollision(const CollisionRequest& req, CollisionResult& res,
                                   const moveit::core::RobotState& state) const
 {
@@ -37,6 +37,7 @@
 #include <moveit/collision_detection/collision_matrix.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <atomic>
 #include <functional>
 #include <iomanip>
 
@@ -45,12 +46,22 @@ namespace collision_detection
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_collision_detection.collision_matrix");
 
+// Source of the versions of all allowed collision matrices
+static std::atomic<std::size_t> ACM_VERSION_COUNTER{ 0 };
+
+void AllowedCollisionMatrix::updateVersion()
+{
+  version_ = ++ACM_VERSION_COUNTER;
+}
+
 AllowedCollisionMatrix::AllowedCollisionMatrix()
 {
+  updateVersion();
 }
 
 AllowedCollisionMatrix::AllowedCollisionMatrix(const std::vector<std::string>& names, const bool allowed)
 {
+  updateVersion();
   for (std::size_t i = 0; i < names.size(); ++i)
   {
     for (std::size_t j = i; j < names.size(); ++j)
@@ -60,6 +71,7 @@ AllowedCollisionMatrix::AllowedCollisionMatrix(const std::vector<std::string>& n
 
 AllowedCollisionMatrix::AllowedCollisionMatrix(const srdf::Model& srdf)
 {
+  updateVersion();
   // load collision defaults
   for (const std::string& name : srdf.getNoDefaultCollisionLinks())
     setDefaultEntry(name, collision_detection::AllowedCollision::ALWAYS);
@@ -73,6 +85,7 @@ AllowedCollisionMatrix::AllowedCollisionMatrix(const srdf::Model& srdf)
 
 AllowedCollisionMatrix::AllowedCollisionMatrix(const moveit_msgs::msg::AllowedCollisionMatrix& msg)
 {
+  updateVersion();
   if (msg.entry_names.size() != msg.entry_values.size() ||
       msg.default_entry_names.size() != msg.default_entry_values.size())
   {
@@ -146,73 +159,71 @@ bool AllowedCollisionMatrix::hasEntry(const std::string& name1, const std::strin
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, const bool allowed)
 {
+  updateVersion();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
-  entries_[name1][name2] = entries_[name2][name1] = v;
+  entries_[name1][name2] = v;
+  entries_[name2][name1] = v;
 
   // remove function pointers, if any
-  auto it = allowed_contacts_.find(name1);
-  if (it != allowed_contacts_.end())
-  {
-    auto jt = it->second.find(name2);
-    if (jt != it->second.end())
-      it->second.erase(jt);
-  }
-  it = allowed_contacts_.find(name2);
-  if (it != allowed_contacts_.end())
-  {
-    auto jt = it->second.find(name1);
-    if (jt != it->second.end())
-      it->second.erase(jt);
-  }
+  removeAllowedContact(name1, name2);
+  removeAllowedContact(name2, name1);
+}
+
+void AllowedCollisionMatrix::removeAllowedContact(const std::string& name1, const std::string& name2)
+{
+  // Check first, so that rows shared with copies of the matrix are not copied needlessly
+  const auto it = allowed_contacts_.find(name1);
+  if (it != allowed_contacts_.end() && it->second.contains(name2))
+    allowed_contacts_.getMutable(name1)->erase(name2);
 }
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, DecideContactFn& fn)
 {
-  entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
-  allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
+  updateVersion();
+  entries_[name1][name2] = AllowedCollision::CONDITIONAL;
+  entries_[name2][name1] = AllowedCollision::CONDITIONAL;
+  allowed_contacts_[name1][name2] = fn;
+  allowed_contacts_[name2][name1] = fn;
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name)
 {
+  updateVersion();
   entries_.erase(name);
   allowed_contacts_.erase(name);
-  for (auto& entry : entries_)
-    entry.second.erase(name);
-  for (auto& allowed_contact : allowed_contacts_)
-    allowed_contact.second.erase(name);
+
+  // Only the rows that contain the name are modified (and copied if they are shared with a copy of the matrix)
+  std::vector<std::string> rows;
+  for (const auto& entry : entries_)
+  {
+    if (entry.second.contains(name))
+      rows.push_back(entry.first);
+  }
+  for (const std::string& row : rows)
+    entries_.getMutable(row)->erase(name);
+
+  rows.clear();
+  for (const auto& allowed_contact : allowed_contacts_)
+  {
+    if (allowed_contact.second.contains(name))
+      rows.push_back(allowed_contact.first);
+  }
+  for (const std::string& row : rows)
+    allowed_contacts_.getMutable(row)->erase(name);
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string& name2)
 {
+  updateVersion();
   auto jt = entries_.find(name1);
-  if (jt != entries_.end())
-  {
-    auto it = jt->second.find(name2);
-    if (it != jt->second.end())
-      jt->second.erase(it);
-  }
+  if (jt != entries_.end() && jt->second.contains(name2))
+    entries_.getMutable(name1)->erase(name2);
   jt = entries_.find(name2);
-  if (jt != entries_.end())
-  {
-    auto it = jt->second.find(name1);
-    if (it != jt->second.end())
-      jt->second.erase(it);
-  }
+  if (jt != entries_.end() && jt->second.contains(name1))
+    entries_.getMutable(name2)->erase(name1);
 
-  auto it = allowed_contacts_.find(name1);
-  if (it != allowed_contacts_.end())
-  {
-    auto jt = it->second.find(name2);
-    if (jt != it->second.end())
-      it->second.erase(jt);
-  }
-  it = allowed_contacts_.find(name2);
-  if (it != allowed_contacts_.end())
-  {
-    auto jt = it->second.find(name1);
-    if (jt != it->second.end())
-      it->second.erase(jt);
-  }
+  removeAllowedContact(name1, name2);
+  removeAllowedContact(name2, name1);
 }
 
 void AllowedCollisionMatrix::setEntry(const std::string& name, const std::vector<std::string>& other_names,
@@ -234,29 +245,29 @@ void AllowedCollisionMatrix::setEntry(const std::vector<std::string>& names1, co
 
 void AllowedCollisionMatrix::setEntry(const std::string& name, const bool allowed)
 {
-  std::string last = name;
-  for (auto& entry : entries_)
+  // setEntry() modifies entries_, so the names are collected before
+  std::vector<std::string> names;
+  for (const auto& entry : entries_)
   {
-    if (name != entry.first && last != entry.first)
-    {
-      last = entry.first;
-      setEntry(name, entry.first, allowed);
-    }
+    if (name != entry.first)
+      names.push_back(entry.first);
   }
+  for (const std::string& other_name : names)
+    setEntry(name, other_name, allowed);
 }
 
 void AllowedCollisionMatrix::setEntry(const bool allowed)
 {
+  updateVersion();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
-  for (auto& entry : entries_)
-  {
-    for (auto& it2 : entry.second)
-      it2.second = v;
-  }
+  entries_.forEachMutable([v](const std::string& /*name*/, PersistentMap<std::string, AllowedCollision::Type>& row) {
+    row.forEachMutable([v](const std::string& /*name*/, AllowedCollision::Type& type) { type = v; });
+  });
 }
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const bool allowed)
 {
+  updateVersion();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
@@ -264,6 +275,7 @@ void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const bool
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, DecideContactFn& fn)
 {
+  updateVersion();
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
 }
@@ -362,8 +374,106 @@ bool AllowedCollisionMatrix::getAllowedCollision(const std::string& name1, const
   return getEntry(name1, name2, allowed_collision) || getDefaultEntry(name1, name2, allowed_collision);
 }
 
+CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm,
+                                                               const std::vector<std::string>& names)
+  : names_(names), entries_(names.size() * names.size(), NOT_FOUND), source_version_(acm.getVersion())
+{
+  const std::size_t n = names_.size();
+
+  // resolve the defaults of each name only once
+  std::unordered_map<std::string, std::vector<std::size_t>> indices;
+  std::vector<std::uint8_t> default_types(n, NOT_FOUND);
+  std::vector<const DecideContactFn*> default_fns(n, nullptr);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    indices[names_[i]].push_back(i);
+    const auto type_it = acm.default_entries_.find(names_[i]);
+    if (type_it != acm.default_entries_.end())
+      default_types[i] = type_it->second;
+    const auto fn_it = acm.default_allowed_contacts_.find(names_[i]);
+    if (fn_it != acm.default_allowed_contacts_.end())
+      default_fns[i] = &fn_it->second;
+  }
+
+  // combine the defaults of all pairs the same way getDefaultEntry() and getAllowedCollision() do
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      const std::uint8_t t1 = default_types[i];
+      const std::uint8_t t2 = default_types[j];
+      std::uint8_t& type = entries_[i * n + j];
+      if (t1 == NOT_FOUND || t2 == NOT_FOUND)
+        type = t1 == NOT_FOUND ? t2 : t1;
+      else if (t1 == AllowedCollision::NEVER || t2 == AllowedCollision::NEVER)
+        type = AllowedCollision::NEVER;
+      else if (t1 == AllowedCollision::CONDITIONAL || t2 == AllowedCollision::CONDITIONAL)
+        type = AllowedCollision::CONDITIONAL;
+      else
+        type = AllowedCollision::ALWAYS;
+
+      if (type != AllowedCollision::CONDITIONAL)
+        continue;
+      const DecideContactFn* fn1 = default_fns[i];
+      const DecideContactFn* fn2 = default_fns[j];
+      if (fn1 && fn2)
+      {
+        allowed_contacts_[i * n + j] = [f1 = *fn1, f2 = *fn2](Contact& contact) {
+          return andDecideContact(f1, f2, contact);
+        };
+      }
+      else if (fn1 || fn2)
+        allowed_contacts_[i * n + j] = fn1 ? *fn1 : *fn2;
+    }
+  }
+
+  // explicit entries take precedence over the defaults
+  for (const auto& row : acm.entries_)
+  {
+    const auto it1 = indices.find(row.first);
+    if (it1 == indices.end())
+      continue;
+    for (const auto& entry : row.second)
+    {
+      const auto it2 = indices.find(entry.first);
+      if (it2 == indices.end())
+        continue;
+      for (std::size_t i : it1->second)
+      {
+        for (std::size_t j : it2->second)
+        {
+          entries_[i * n + j] = entry.second;
+          if (entry.second != AllowedCollision::CONDITIONAL)
+            allowed_contacts_.erase(i * n + j);
+        }
+      }
+    }
+  }
+  for (const auto& row : acm.allowed_contacts_)
+  {
+    const auto it1 = indices.find(row.first);
+    if (it1 == indices.end())
+      continue;
+    for (const auto& entry : row.second)
+    {
+      const auto it2 = indices.find(entry.first);
+      if (it2 == indices.end())
+        continue;
+      for (std::size_t i : it1->second)
+      {
+        for (std::size_t j : it2->second)
+        {
+          if (entries_[i * n + j] == AllowedCollision::CONDITIONAL)
+            allowed_contacts_[i * n + j] = entry.second;
+        }
+      }
+    }
+  }
+}
+
 void AllowedCollisionMatrix::clear()
 {
+  updateVersion();
   entries_.clear();
   allowed_contacts_.clear();
   default_entries_.clear();
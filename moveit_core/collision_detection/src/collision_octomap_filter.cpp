@@ -42,7 +42,13 @@
 #include <geometric_shapes/shapes.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_collision_detection.collision_octomap_filter");
@@ -59,6 +65,89 @@ bool findSurface(const octomap::point3d_list& cloud, const double& spacing, cons
 bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, const double& r_multiple,
                  const octomath::Vector3& position, double& intensity, octomath::Vector3& gradient);
 
+namespace
+{
+// Occupied leaves of an octree, bucketed on a coarse grid in key space. Each bucket is read from the octree at most
+// once, so contacts that are close to each other share the octree queries for their neighborhood.
+class OccupiedLeafHash
+{
+public:
+  OccupiedLeafHash(const octomap::OcTree& octree, unsigned int bucket_size)
+    : octree_(octree), bucket_size_(std::max(1u, bucket_size))
+  {
+  }
+
+  // Append the centers of the occupied leaves overlapping the box [min, max] to cloud.
+  // This yields the same leaves as iterating octree.begin_leafs_bbx(min, max).
+  void getOccupiedLeafs(const octomap::point3d& min, const octomap::point3d& max, octomap::point3d_list& cloud)
+  {
+    octomap::OcTreeKey min_key, max_key;
+    if (!octree_.coordToKeyChecked(min, min_key) || !octree_.coordToKeyChecked(max, max_key))
+      return;
+
+    seen_.clear();
+    for (unsigned int x = min_key[0] / bucket_size_; x <= max_key[0] / bucket_size_; ++x)
+      for (unsigned int y = min_key[1] / bucket_size_; y <= max_key[1] / bucket_size_; ++y)
+        for (unsigned int z = min_key[2] / bucket_size_; z <= max_key[2] / bucket_size_; ++z)
+          for (const Leaf& leaf : getBucket(x, y, z))
+          {
+            // a coarse leaf may be stored in more than one bucket
+            if (overlaps(leaf, min_key, max_key) && seen_.insert(leaf.id).second)
+              cloud.push_back(leaf.center);
+          }
+  }
+
+private:
+  struct Leaf
+  {
+    octomap::OcTreeKey key;
+    unsigned int half_size;  // half edge length of the leaf, in keys
+    uint64_t id;
+    octomap::point3d center;
+  };
+
+  static bool overlaps(const Leaf& leaf, const octomap::OcTreeKey& min_key, const octomap::OcTreeKey& max_key)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+      if (min_key[i] > leaf.key[i] + leaf.half_size || max_key[i] + leaf.half_size < leaf.key[i])
+        return false;
+    return true;
+  }
+
+  const std::vector<Leaf>& getBucket(unsigned int x, unsigned int y, unsigned int z)
+  {
+    const uint64_t bucket_id = (static_cast<uint64_t>(x) << 32) | (static_cast<uint64_t>(y) << 16) | z;
+    auto inserted = buckets_.emplace(bucket_id, std::vector<Leaf>());
+    std::vector<Leaf>& bucket = inserted.first->second;
+    if (!inserted.second)
+      return bucket;
+
+    const unsigned int max_key = std::numeric_limits<octomap::key_type>::max();
+    const octomap::OcTreeKey min_key(x * bucket_size_, y * bucket_size_, z * bucket_size_);
+    const octomap::OcTreeKey max_bucket_key(std::min(max_key, (x + 1) * bucket_size_ - 1),
+                                            std::min(max_key, (y + 1) * bucket_size_ - 1),
+                                            std::min(max_key, (z + 1) * bucket_size_ - 1));
+    const unsigned int tree_depth = octree_.getTreeDepth();
+    for (auto it = octree_.begin_leafs_bbx(min_key, max_bucket_key), end = octree_.end_leafs_bbx(); it != end; ++it)
+    {
+      if (!octree_.isNodeOccupied(*it))
+        continue;
+      const octomap::OcTreeKey& key = it.getKey();
+      const unsigned int depth = it.getDepth();
+      const uint64_t id = (static_cast<uint64_t>(depth) << 48) | (static_cast<uint64_t>(key[0]) << 32) |
+                          (static_cast<uint64_t>(key[1]) << 16) | key[2];
+      bucket.push_back({ key, (1u << (tree_depth - depth)) >> 1, id, it.getCoordinate() });
+    }
+    return bucket;
+  }
+
+  const octomap::OcTree& octree_;
+  const unsigned int bucket_size_;
+  std::unordered_map<uint64_t, std::vector<Leaf>> buckets_;
+  std::unordered_set<uint64_t> seen_;
+};
+}  // namespace
+
 int collision_detection::refineContactNormals(const World::ObjectConstPtr& object, CollisionResult& res,
                                               const double cell_bbx_search_distance,
                                               const double allowed_angle_divergence, const bool estimate_depth,
@@ -74,96 +163,56 @@ int collision_detection::refineContactNormals(const World::ObjectConstPtr& objec
     RCLCPP_WARN(LOGGER, "There do not appear to be any contacts, so there is nothing to refine!");
     return 0;
   }
+  if (object->shapes_.empty())
+    return 0;
+  const std::shared_ptr<const shapes::OcTree> shape_octree =
+      std::dynamic_pointer_cast<const shapes::OcTree>(object->shapes_[0]);
+  if (!shape_octree)
+    return 0;
+
+  const std::shared_ptr<const octomap::OcTree> octree = shape_octree->octree;
+  const double cell_size = octree->getResolution();
+  // buckets span the whole search box, so each contact touches at most two buckets per axis
+  OccupiedLeafHash occupied_leafs(*octree, static_cast<unsigned int>(std::ceil(2.0 * cell_bbx_search_distance)) + 1);
 
   int modified = 0;
 
   // iterate through contacts
   for (auto& contact : res.contacts)
   {
-    const std::string contact1 = contact.first.first;
-    const std::string contact2 = contact.first.second;
-    std::string octomap_name = "";
-    std::vector<collision_detection::Contact>& contact_vector = contact.second;
-
-    if (contact1.find("octomap") != std::string::npos)
-    {
-      octomap_name = contact1;
-    }
-    else if (contact2.find("octomap") != std::string::npos)
-    {
-      octomap_name = contact2;
-    }
-    else
-    {
+    const std::string& contact1 = contact.first.first;
+    const std::string& contact2 = contact.first.second;
+    if (contact1.find("octomap") == std::string::npos && contact2.find("octomap") == std::string::npos)
       continue;
-    }
 
-    double cell_size = 0;
-    if (!object->shapes_.empty())
+    for (auto& contact_info : contact.second)
     {
-      const shapes::ShapeConstPtr& shape = object->shapes_[0];
-      const std::shared_ptr<const shapes::OcTree> shape_octree = std::dynamic_pointer_cast<const shapes::OcTree>(shape);
-      if (shape_octree)
+      const Eigen::Vector3d& point = contact_info.pos;
+      const Eigen::Vector3d& normal = contact_info.normal;
+
+      const octomath::Vector3 contact_point(point[0], point[1], point[2]);
+      const octomath::Vector3 contact_normal(normal[0], normal[1], normal[2]);
+      const octomath::Vector3 diagonal = octomath::Vector3(1, 1, 1);
+      const octomath::Vector3 bbx_min = contact_point - diagonal * cell_size * cell_bbx_search_distance;
+      const octomath::Vector3 bbx_max = contact_point + diagonal * cell_size * cell_bbx_search_distance;
+      octomap::point3d_list node_centers;
+      occupied_leafs.getOccupiedLeafs(bbx_min, bbx_max, node_centers);
+
+      octomath::Vector3 n;
+      double depth;
+      if (getMetaballSurfaceProperties(node_centers, cell_size, iso_value, metaball_radius_multiple, contact_point, n,
+                                       depth, estimate_depth))
       {
-        std::shared_ptr<const octomap::OcTree> octree = shape_octree->octree;
-        cell_size = octree->getResolution();
-        for (auto& contact_info : contact_vector)
+        // only modify normal if the refinement predicts a "very different" result.
+        const double divergence = contact_normal.angleTo(n);
+        if (divergence > allowed_angle_divergence)
         {
-          const Eigen::Vector3d& point = contact_info.pos;
-          const Eigen::Vector3d& normal = contact_info.normal;
-
-          const octomath::Vector3 contact_point(point[0], point[1], point[2]);
-          const octomath::Vector3 contact_normal(normal[0], normal[1], normal[2]);
-          const octomath::Vector3 diagonal = octomath::Vector3(1, 1, 1);
-          const octomath::Vector3 bbx_min = contact_point - diagonal * cell_size * cell_bbx_search_distance;
-          const octomath::Vector3 bbx_max = contact_point + diagonal * cell_size * cell_bbx_search_distance;
-          octomap::point3d_list node_centers;
-          octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator it =
-              octree->begin_leafs_bbx(bbx_min, bbx_max);
-          octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator leafs_end =
-              octree->end_leafs_bbx();
-          int count = 0;
-          for (; it != leafs_end; ++it)
-          {
-            const octomap::point3d pt = it.getCoordinate();
-            // double prob = it->getOccupancy();
-            if (octree->isNodeOccupied(*it))  // magic number!
-            {
-              count++;
-              node_centers.push_back(pt);
-              // RCLCPP_INFO(LOGGER, "Adding point %d with prob %.3f at [%.3f, %.3f, %.3f]",
-              //                          count, prob, pt.x(), pt.y(), pt.z());
-            }
-          }
-          // RCLCPP_INFO(LOGGER, "Contact point at [%.3f, %.3f, %.3f], cell size %.3f, occupied cells
-          // %d",
-          //                          contact_point.x(), contact_point.y(), contact_point.z(), cell_size, count);
-
-          // octree->getOccupiedLeafsBBX(node_centers, bbx_min, bbx_max);
-          // RCLCPP_ERROR(LOGGER, "bad stuff in collision_octomap_filter.cpp; need to port octomap
-          // call for groovy");
-
-          octomath::Vector3 n;
-          double depth;
-          if (getMetaballSurfaceProperties(node_centers, cell_size, iso_value, metaball_radius_multiple, contact_point,
-                                           n, depth, estimate_depth))
-          {
-            // only modify normal if the refinement predicts a "very different" result.
-            const double divergence = contact_normal.angleTo(n);
-            if (divergence > allowed_angle_divergence)
-            {
-              modified++;
-              // RCLCPP_INFO(LOGGER, "Normals differ by %.3f, changing: [%.3f, %.3f, %.3f] -> [%.3f,
-              // %.3f, %.3f]",
-              //                          divergence, contact_normal.x(), contact_normal.y(), contact_normal.z(),
-              //                          n.x(), n.y(), n.z());
-              contact_info.normal = Eigen::Vector3d(n.x(), n.y(), n.z());
-            }
-
-            if (estimate_depth)
-              contact_info.depth = depth;
-          }
+          modified++;
+          contact_info.normal = Eigen::Vector3d(n.x(), n.y(), n.z());
         }
+
+        if (estimate_depth)
+          contact_info.depth = depth;
       }
     }
   }
@@ -240,7 +289,7 @@ bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, cons
   intensity = 0.f;
   gradient = octomath::Vector3(0, 0, 0);
 
-  const double r = r_multiple * spacing;  // TODO magic number!
+  const double radius = r_multiple * spacing;  // TODO magic number!
   // double T = 0.5; // TODO magic number!
 
   const int nn = cloud.size();
@@ -249,42 +298,35 @@ bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, cons
     return false;
   }
 
-  // variables for Wyvill
-  double a = 0, b = 0, c = 0, r2 = 0, r4 = 0, r6 = 0, a1 = 0, b1 = 0, c1 = 0, a2 = 0, b2 = 0, c2 = 0;
+  // variables for Wyvill, they only depend on the radius
   const bool wyvill = true;
+  const double radius2 = radius * radius;
+  const double radius4 = radius2 * radius2;
+  const double radius6 = radius4 * radius2;
+  const double a = -4.0 / 9.0;
+  const double b = 17.0 / 9.0;
+  const double c = -22.0 / 9.0;
+  const double a1 = a / radius6;
+  const double b1 = b / radius4;
+  const double c1 = c / radius2;
+  const double a2 = 6 * a1;
+  const double b2 = 4 * b1;
+  const double c2 = 2 * c1;
 
+  bool sampled = false;
   for (const octomath::Vector3& v : cloud)
   {
-    if (wyvill)
-    {
-      r2 = r * r;
-      r4 = r2 * r2;
-      r6 = r4 * r2;
-      a = -4.0 / 9.0;
-      b = 17.0 / 9.0;
-      c = -22.0 / 9.0;
-      a1 = a / r6;
-      b1 = b / r4;
-      c1 = c / r2;
-      a2 = 6 * a1;
-      b2 = 4 * b1;
-      c2 = 2 * c1;
-    }
-    else
-    {
-      RCLCPP_ERROR(LOGGER, "This should not be called!");
-    }
-
     double f_val = 0;
     octomath::Vector3 f_grad(0, 0, 0);
 
     octomath::Vector3 pos = position - v;
     const double r = pos.norm();
-    pos = pos * (1.0 / r);
-    if (r > r)  // must skip points outside valid bounds.
+    if (r > radius)  // must skip points outside valid bounds.
     {
       continue;
     }
+    pos = pos * (1.0 / r);
+    sampled = true;
     const double r2 = r * r;
     const double r3 = r * r2;
     const double r4 = r2 * r2;
@@ -299,10 +341,11 @@ bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, cons
     else
     {
       RCLCPP_ERROR(LOGGER, "This should not be called!");
-      const double r_scaled = r / r;
+      const double r_scaled = r / radius;
       // TODO still need to address the scaling...
       f_val = pow((1 - r_scaled), 4) * (4 * r_scaled + 1);
-      f_grad = pos * (-4.0 / r * pow(1.0 - r_scaled, 3) * (4.0 * r_scaled + 1.0) + 4.0 / r * pow(1 - r_scaled, 4));
+      f_grad = pos * (-4.0 / radius * pow(1.0 - r_scaled, 3) * (4.0 * r_scaled + 1.0) +
+                      4.0 / radius * pow(1 - r_scaled, 4));
     }
 
     // TODO:  The whole library should be overhauled to follow the "gradient points out"
@@ -312,5 +355,5 @@ bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, cons
   }
   // implicit surface gradient convention points out, so we flip it.
   gradient *= -1.0;
-  return true;  // it worked
+  return sampled;  // it worked if any point is close enough
 }
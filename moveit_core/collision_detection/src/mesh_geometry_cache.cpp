@@ -0,0 +1,63 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/mesh_geometry_cache.h>
+#include <algorithm>
+#include <string_view>
+
+namespace collision_detection
+{
+namespace
+{
+template <typename T>
+std::size_t hashArray(const T* data, std::size_t size)
+{
+  return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(data), size * sizeof(T)));
+}
+}  // namespace
+
+std::size_t computeMeshHash(const shapes::Mesh& mesh)
+{
+  std::size_t seed = hashArray(mesh.vertices, 3 * mesh.vertex_count);
+  seed ^= hashArray(mesh.triangles, 3 * mesh.triangle_count) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+bool meshesEqual(const shapes::Mesh& mesh1, const shapes::Mesh& mesh2)
+{
+  return mesh1.vertex_count == mesh2.vertex_count && mesh1.triangle_count == mesh2.triangle_count &&
+         std::equal(mesh1.vertices, mesh1.vertices + 3 * mesh1.vertex_count, mesh2.vertices) &&
+         std::equal(mesh1.triangles, mesh1.triangles + 3 * mesh1.triangle_count, mesh2.triangles);
+}
+}  // namespace collision_detection
@@ -0,0 +1,238 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/occupancy_map.h>
+
+#include <atomic>
+
+namespace collision_detection
+{
+void OccMapTree::clearOutsideBBX(const octomap::point3d& min, const octomap::point3d& max)
+{
+  if (!root)
+    return;
+
+  // coordinates beyond the range of the tree are clamped to the first or last key
+  octomap::OcTreeKey min_key, max_key;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (!coordToKeyChecked(min(i), min_key[i]))
+      min_key[i] = min(i) < 0.0f ? 0 : 2 * tree_max_val - 1;
+    if (!coordToKeyChecked(max(i), max_key[i]))
+      max_key[i] = max(i) < 0.0f ? 0 : 2 * tree_max_val - 1;
+  }
+
+  // The retained cells are copied into a new tree rather than deleting the evicted subtrees in place, which
+  // octomap does not support for inner nodes. The cost is bounded by the size of the box.
+  const octomap::OcTreeKey root_key(tree_max_val, tree_max_val, tree_max_val);
+  OccMapTree window(resolution);
+  const BBXOverlap overlap = computeBBXOverlap(root_key, 0, min_key, max_key);
+  if (overlap == BBXOverlap::OUTSIDE || !hasCellsInBBX(root, root_key, 0, min_key, max_key))
+    reportEvictedCells(root, root_key, 0);
+  else
+  {
+    window.root = new OccMapNode();
+    window.tree_size = 1;
+    copyCellsInBBX(root, window.root, root_key, 0, min_key, max_key, overlap == BBXOverlap::INSIDE, window);
+  }
+  swapContent(window);
+  size_changed = true;
+  // the deleted free cells are not reported as changed
+  markStructureChanged();
+}
+
+OccMapTree::BBXOverlap OccMapTree::computeBBXOverlap(const octomap::OcTreeKey& key, unsigned int depth,
+                                                     const octomap::OcTreeKey& min_key,
+                                                     const octomap::OcTreeKey& max_key) const
+{
+  // a node at depth spans this many keys per axis, centered at its key
+  const unsigned int size = 1u << (tree_depth - depth);
+  bool inside = true;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const unsigned int lower = key[i] - (size >> 1);
+    const unsigned int upper = lower + size - 1;
+    if (upper < min_key[i] || lower > max_key[i])
+      return BBXOverlap::OUTSIDE;
+    inside = inside && lower >= min_key[i] && upper <= max_key[i];
+  }
+  return inside ? BBXOverlap::INSIDE : BBXOverlap::CROSSING;
+}
+
+bool OccMapTree::hasCellsInBBX(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                               const octomap::OcTreeKey& min_key, const octomap::OcTreeKey& max_key) const
+{
+  const BBXOverlap overlap = computeBBXOverlap(key, depth, min_key, max_key);
+  if (overlap == BBXOverlap::OUTSIDE)
+    return false;
+  if (overlap == BBXOverlap::INSIDE || !nodeHasChildren(node))
+    return true;
+
+  const octomap::key_type center_offset_key = tree_max_val >> (depth + 1);
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!nodeChildExists(node, i))
+      continue;
+    octomap::OcTreeKey child_key;
+    octomap::computeChildKey(i, center_offset_key, key, child_key);
+    if (hasCellsInBBX(getNodeChild(node, i), child_key, depth + 1, min_key, max_key))
+      return true;
+  }
+  return false;
+}
+
+void OccMapTree::copyCellsInBBX(const OccMapNode* node, OccMapNode* copy, const octomap::OcTreeKey& key,
+                                unsigned int depth, const octomap::OcTreeKey& min_key,
+                                const octomap::OcTreeKey& max_key, bool inside, OccMapTree& window)
+{
+  copy->copyData(*node);
+  if (!nodeHasChildren(node))
+    return;
+
+  const octomap::key_type center_offset_key = tree_max_val >> (depth + 1);
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!nodeChildExists(node, i))
+      continue;
+    const OccMapNode* child = getNodeChild(node, i);
+    octomap::OcTreeKey child_key;
+    octomap::computeChildKey(i, center_offset_key, key, child_key);
+
+    bool child_inside = inside;
+    if (!inside)
+    {
+      const BBXOverlap overlap = computeBBXOverlap(child_key, depth + 1, min_key, max_key);
+      if (overlap == BBXOverlap::OUTSIDE ||
+          (overlap == BBXOverlap::CROSSING && !hasCellsInBBX(child, child_key, depth + 1, min_key, max_key)))
+      {
+        reportEvictedCells(child, child_key, depth + 1);
+        continue;
+      }
+      child_inside = overlap == BBXOverlap::INSIDE;
+    }
+    copyCellsInBBX(child, window.createNodeChild(copy, i), child_key, depth + 1, min_key, max_key, child_inside,
+                   window);
+  }
+
+  // the occupancy of inner nodes is the maximum of the children that were kept
+  if (!inside)
+    copy->updateOccupancyChildren();
+}
+
+void OccMapTree::reportEvictedCells(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth)
+{
+  if (!use_change_detection)
+    return;
+
+  if (nodeHasChildren(node))
+  {
+    const octomap::key_type center_offset_key = tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+      if (!nodeChildExists(node, i))
+        continue;
+      octomap::OcTreeKey child_key;
+      octomap::computeChildKey(i, center_offset_key, key, child_key);
+      reportEvictedCells(getNodeChild(node, i), child_key, depth + 1);
+    }
+  }
+  else if (isNodeOccupied(node))
+  {
+    // changes are tracked at the finest resolution, so pruned leaves are reported cell by cell
+    const unsigned int size = 1u << (tree_depth - depth);
+    const octomap::OcTreeKey lower(key[0] - (size >> 1), key[1] - (size >> 1), key[2] - (size >> 1));
+    for (unsigned int x = 0; x < size; ++x)
+      for (unsigned int y = 0; y < size; ++y)
+        for (unsigned int z = 0; z < size; ++z)
+          changed_keys.emplace(octomap::OcTreeKey(lower[0] + x, lower[1] + y, lower[2] + z), false);
+  }
+}
+
+std::shared_ptr<const octomap::OcTree> OccMapTreeSnapshots::update(const OccMapTree& tree)
+{
+  octomap::KeySet changes;
+  for (auto it = tree.changedKeysBegin(); it != tree.changedKeysEnd(); ++it)
+    changes.insert(it->first);
+
+  const bool incremental = current_ && tree.isChangeDetectionEnabled() &&
+                           tree.getStructureVersion() == structure_version_ &&
+                           tree.getResolution() == current_->getResolution();
+  std::shared_ptr<OccMapTree> next;
+  // nobody can obtain a new reference to the previous tree, so a single owner stays the single owner
+  if (incremental && previous_ && previous_.use_count() == 1)
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    next = std::move(previous_);
+    previous_changes_.insert(changes.begin(), changes.end());
+    for (const octomap::OcTreeKey& key : previous_changes_)
+    {
+      // pruned cells of the tree are found as their parent
+      const OccMapNode* node = tree.search(key);
+      if (node)
+        next->setNodeValue(key, node->getLogOdds());
+      else
+        next->deleteNode(key);
+    }
+  }
+  else
+  {
+    next = std::make_shared<OccMapTree>(static_cast<const octomap::OcTree&>(tree));
+    next->enableChangeDetection(false);
+    next->resetChangeDetection();
+  }
+
+  if (incremental)
+  {
+    previous_ = std::move(current_);
+    previous_changes_ = std::move(changes);
+  }
+  else
+  {
+    previous_.reset();
+    previous_changes_.clear();
+  }
+  current_ = std::move(next);
+  current_snapshot_ = current_;
+  structure_version_ = tree.getStructureVersion();
+  return current_snapshot_;
+}
+
+void OccMapTreeSnapshots::reset()
+{
+  current_.reset();
+  current_snapshot_.reset();
+  previous_.reset();
+  previous_changes_.clear();
+}
+}  // namespace collision_detection
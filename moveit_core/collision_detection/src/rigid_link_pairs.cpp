@@ -0,0 +1,97 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Link pairs whose relative transform is fixed while only the joints of a group move */
+
+#include <moveit/collision_detection/rigid_link_pairs.h>
+#include <moveit/robot_model/robot_model.h>
+
+#include <map>
+#include <set>
+
+namespace collision_detection
+{
+RigidLinkPairs getRigidLinkPairs(const moveit::core::JointModelGroup& group)
+{
+  const moveit::core::RobotModel& robot_model = group.getParentModel();
+
+  // joints that move with the group, including the mimic joints following them
+  std::set<const moveit::core::JointModel*> moving_joints;
+  for (const moveit::core::JointModel* joint : group.getJointModels())
+  {
+    if (joint->getType() != moveit::core::JointModel::FIXED)
+      moving_joints.insert(joint);
+  }
+  bool added = true;
+  while (added)
+  {
+    added = false;
+    for (const moveit::core::JointModel* joint : robot_model.getMimicJointModels())
+    {
+      if (moving_joints.count(joint->getMimic()) && moving_joints.insert(joint).second)
+        added = true;
+    }
+  }
+
+  RigidLinkPairs result;
+  for (const moveit::core::JointModel* joint : robot_model.getJointModels())
+  {
+    if (moving_joints.count(joint))
+      continue;
+    for (std::size_t i = 0; i < joint->getVariableCount(); ++i)
+      result.frozen_variables.push_back(joint->getFirstVariableIndex() + i);
+  }
+
+  // group the links by the closest moving joint above them
+  std::map<const moveit::core::JointModel*, std::vector<const moveit::core::LinkModel*>> rigid_bodies;
+  for (const moveit::core::LinkModel* link : robot_model.getLinkModelsWithCollisionGeometry())
+  {
+    const moveit::core::JointModel* joint = link->getParentJointModel();
+    while (joint && !moving_joints.count(joint))
+      joint = joint->getParentLinkModel() ? joint->getParentLinkModel()->getParentJointModel() : nullptr;
+    if (joint)
+      rigid_bodies[joint].push_back(link);
+  }
+
+  for (const auto& [joint, links] : rigid_bodies)
+  {
+    for (std::size_t i = 0; i < links.size(); ++i)
+    {
+      for (std::size_t j = i + 1; j < links.size(); ++j)
+        result.pairs.emplace_back(links[i], links[j]);
+    }
+  }
+  return result;
+}
+}  // namespace collision_detection
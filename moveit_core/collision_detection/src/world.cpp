@@ -48,9 +48,8 @@ World::World()
 {
 }
 
-World::World(const World& other)
+World::World(const World& other) : objects_(other.objects_)
 {
-  objects_ = other.objects_;
 }
 
 World::~World()
@@ -129,13 +128,13 @@ void World::ensureUnique(ObjectPtr& obj)
 
 bool World::hasObject(const std::string& object_id) const
 {
-  return objects_.find(object_id) != objects_.end();
+  return objects_.contains(object_id);
 }
 
 bool World::knowsTransform(const std::string& name) const
 {
   // Check object names first
-  const std::map<std::string, ObjectPtr>::const_iterator it = objects_.find(name);
+  const auto it = objects_.find(name);
   if (it != objects_.end())
   {
     return true;
@@ -170,7 +169,7 @@ const Eigen::Isometry3d& World::getTransform(const std::string& name, bool& fram
   // assume found
   frame_found = true;
 
-  const std::map<std::string, ObjectPtr>::const_iterator it = objects_.find(name);
+  const auto it = objects_.find(name);
   if (it != objects_.end())
   {
     return it->second->pose_;
@@ -239,12 +238,13 @@ bool World::moveShapeInObject(const std::string& object_id, const shapes::ShapeC
     {
       if (it->second->shapes_[i] == shape)
       {
-        ensureUnique(it->second);
+        ObjectPtr& obj = *objects_.getMutable(object_id);
+        ensureUnique(obj);
         ASSERT_ISOMETRY(shape_pose)  // unsanitized input, could contain a non-isometry
-        it->second->shape_poses_[i] = shape_pose;
-        it->second->global_shape_poses_[i] = it->second->pose_ * shape_pose;
+        obj->shape_poses_[i] = shape_pose;
+        obj->global_shape_poses_[i] = obj->pose_ * shape_pose;
 
-        notify(it->second, MOVE_SHAPE);
+        notify(obj, MOVE_SHAPE);
         return true;
       }
     }
@@ -296,19 +296,20 @@ bool World::removeShapeFromObject(const std::string& object_id, const shapes::Sh
     {
       if (it->second->shapes_[i] == shape)
       {
-        ensureUnique(it->second);
-        it->second->shapes_.erase(it->second->shapes_.begin() + i);
-        it->second->shape_poses_.erase(it->second->shape_poses_.begin() + i);
-        it->second->global_shape_poses_.erase(it->second->global_shape_poses_.begin() + i);
+        ObjectPtr& obj = *objects_.getMutable(object_id);
+        ensureUnique(obj);
+        obj->shapes_.erase(obj->shapes_.begin() + i);
+        obj->shape_poses_.erase(obj->shape_poses_.begin() + i);
+        obj->global_shape_poses_.erase(obj->global_shape_poses_.begin() + i);
 
-        if (it->second->shapes_.empty())
+        if (obj->shapes_.empty())
         {
-          notify(it->second, DESTROY);
-          objects_.erase(it);
+          notify(obj, DESTROY);
+          objects_.erase(object_id);
         }
         else
         {
-          notify(it->second, REMOVE_SHAPE);
+          notify(obj, REMOVE_SHAPE);
         }
         return true;
       }
@@ -323,7 +324,7 @@ bool World::removeObject(const std::string& object_id)
   if (it != objects_.end())
   {
     notify(it->second, DESTROY);
-    objects_.erase(it);
+    objects_.erase(object_id);
     return true;
   }
   return false;
@@ -337,8 +338,8 @@ void World::clearObjects()
 
 bool World::setSubframesOfObject(const std::string& object_id, const moveit::core::FixedTransformsMap& subframe_poses)
 {
-  const auto obj_pair = objects_.find(object_id);
-  if (obj_pair == objects_.end())
+  ObjectPtr* obj = objects_.getMutable(object_id);
+  if (!obj)
   {
     return false;
   }
@@ -346,9 +347,12 @@ bool World::setSubframesOfObject(const std::string& object_id, const moveit::cor
   {
     ASSERT_ISOMETRY(t.second)  // unsanitized input, could contain a non-isometry
   }
-  obj_pair->second->subframe_poses_ = subframe_poses;
-  obj_pair->second->global_subframe_poses_ = subframe_poses;
-  updateGlobalPosesInternal(obj_pair->second, false, true);
+  ensureUnique(*obj);
+  (*obj)->subframe_poses_ = subframe_poses;
+  (*obj)->global_subframe_poses_ = subframe_poses;
+  updateGlobalPosesInternal(*obj, false, true);
+  // observers are not notified about subframes, but cached frames are outdated
+  ++change_count_;
   return true;
 }
 
@@ -395,12 +399,13 @@ void World::removeObserver(ObserverHandle observer_handle)
 
 void World::notifyAll(Action action)
 {
-  for (std::map<std::string, ObjectPtr>::const_iterator it = objects_.begin(); it != objects_.end(); ++it)
-    notify(it->second, action);
+  for (const auto& object : objects_)
+    notify(object.second, action);
 }
 
 void World::notify(const ObjectConstPtr& obj, Action action)
 {
+  ++change_count_;
   for (Observer* observer : observers_)
     observer->callback_(obj, action);
 }
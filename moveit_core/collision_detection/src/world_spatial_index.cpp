@@ -0,0 +1,389 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Uniform grid over the bounding boxes of world objects for region and nearest-object queries */
+
+#include <moveit/collision_detection/world_spatial_index.h>
+#include <geometric_shapes/shape_operations.h>
+#include <geometric_shapes/shapes.h>
+#include <octomap/octomap.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace collision_detection
+{
+namespace
+{
+// Objects covering more cells are checked linearly by every query instead of being binned
+constexpr double MAX_CELLS_PER_OBJECT = 4096;
+
+// Extend aabb by the box [min, max] transformed by pose
+void extendByBox(const Eigen::Vector3d& min, const Eigen::Vector3d& max, const Eigen::Isometry3d& pose,
+                 Eigen::AlignedBox3d& aabb)
+{
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    const Eigen::Vector3d point((corner & 1) ? max.x() : min.x(), (corner & 2) ? max.y() : min.y(),
+                                (corner & 4) ? max.z() : min.z());
+    aabb.extend(pose * point);
+  }
+}
+
+// Extend aabb by the world frame AABB of shape at pose. Returns false if the shape has no finite bounds.
+bool extendByShape(const shapes::Shape& shape, const Eigen::Isometry3d& pose, Eigen::AlignedBox3d& aabb)
+{
+  switch (shape.type)
+  {
+    case shapes::PLANE:
+      return false;
+    case shapes::SPHERE:
+    {
+      const double radius = static_cast<const shapes::Sphere&>(shape).radius;
+      aabb.extend(pose.translation() - Eigen::Vector3d::Constant(radius));
+      aabb.extend(pose.translation() + Eigen::Vector3d::Constant(radius));
+      return true;
+    }
+    case shapes::MESH:
+    {
+      // transforming the vertices is tighter than transforming the box around them
+      const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+      for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+      {
+        aabb.extend(pose * Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+      }
+      return true;
+    }
+    case shapes::OCTREE:
+    {
+      const std::shared_ptr<const octomap::OcTree>& octree = static_cast<const shapes::OcTree&>(shape).octree;
+      if (octree && octree->size() > 0)
+      {
+        Eigen::Vector3d min, max;
+        octree->getMetricMin(min.x(), min.y(), min.z());
+        octree->getMetricMax(max.x(), max.y(), max.z());
+        extendByBox(min, max, pose, aabb);
+      }
+      return true;
+    }
+    default:
+    {
+      // the remaining primitives are centered at their origin
+      const Eigen::Vector3d half_extents = 0.5 * shapes::computeShapeExtents(&shape);
+      extendByBox(-half_extents, half_extents, pose, aabb);
+      return true;
+    }
+  }
+}
+}  // namespace
+
+std::size_t WorldSpatialIndex::CellIndexHash::operator()(const CellIndex& index) const
+{
+  // large primes spread neighboring cells over the buckets
+  return static_cast<std::size_t>(index[0]) * 73856093u ^ static_cast<std::size_t>(index[1]) * 19349663u ^
+         static_cast<std::size_t>(index[2]) * 83492791u;
+}
+
+WorldSpatialIndex::WorldSpatialIndex(const WorldPtr& world, double cell_size)
+  : world_(world)
+  , cell_size_(cell_size > 0.0 ? cell_size : 0.5)
+  , min_cell_({ std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max() })
+  , max_cell_({ std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min() })
+{
+  observer_handle_ =
+      world->addObserver([this](const World::ObjectConstPtr& object, World::Action action) { notify(object, action); });
+  world->notifyObserverAllObjects(observer_handle_, World::CREATE | World::ADD_SHAPE);
+}
+
+WorldSpatialIndex::~WorldSpatialIndex()
+{
+  WorldPtr world = world_.lock();
+  if (world)
+    world->removeObserver(observer_handle_);
+}
+
+bool WorldSpatialIndex::getObjectAABB(const std::string& object_id, Eigen::AlignedBox3d& aabb) const
+{
+  const auto it = aabbs_.find(object_id);
+  if (it == aabbs_.end())
+    return false;
+  aabb = it->second;
+  return true;
+}
+
+std::vector<std::string> WorldSpatialIndex::getObjectsInRegion(const Eigen::AlignedBox3d& region) const
+{
+  std::set<std::string> object_ids(unbounded_objects_);
+  if (region.isEmpty())
+    return std::vector<std::string>(object_ids.begin(), object_ids.end());
+
+  for (const std::string& object_id : large_objects_)
+  {
+    if (aabbs_.at(object_id).intersects(region))
+      object_ids.insert(object_id);
+  }
+
+  if (!cells_.empty())
+  {
+    // only the part of the region overlapping occupied cells needs to be visited
+    const CellIndex region_min = getCellIndex(region.min());
+    const CellIndex region_max = getCellIndex(region.max());
+    CellIndex lower, upper;
+    double cell_count = 1.0;
+    for (std::size_t axis = 0; axis < 3; ++axis)
+    {
+      lower[axis] = std::max(region_min[axis], min_cell_[axis]);
+      upper[axis] = std::min(region_max[axis], max_cell_[axis]);
+      cell_count *= std::max(0, upper[axis] - lower[axis] + 1);
+    }
+
+    auto add_cell = [&](const std::vector<std::string>& cell_objects) {
+      for (const std::string& object_id : cell_objects)
+      {
+        if (aabbs_.at(object_id).intersects(region))
+          object_ids.insert(object_id);
+      }
+    };
+    if (cell_count > static_cast<double>(cells_.size()))
+    {
+      // the region covers more cells than are occupied
+      for (const auto& [index, cell_objects] : cells_)
+      {
+        if (index[0] >= lower[0] && index[0] <= upper[0] && index[1] >= lower[1] && index[1] <= upper[1] &&
+            index[2] >= lower[2] && index[2] <= upper[2])
+          add_cell(cell_objects);
+      }
+    }
+    else
+    {
+      for (int x = lower[0]; x <= upper[0]; ++x)
+      {
+        for (int y = lower[1]; y <= upper[1]; ++y)
+        {
+          for (int z = lower[2]; z <= upper[2]; ++z)
+          {
+            const auto it = cells_.find({ x, y, z });
+            if (it != cells_.end())
+              add_cell(it->second);
+          }
+        }
+      }
+    }
+  }
+  return std::vector<std::string>(object_ids.begin(), object_ids.end());
+}
+
+std::vector<std::string> WorldSpatialIndex::getObjectsNear(const Eigen::Vector3d& point, double distance) const
+{
+  const Eigen::Vector3d offset = Eigen::Vector3d::Constant(std::max(distance, 0.0));
+  std::vector<std::string> object_ids = getObjectsInRegion(Eigen::AlignedBox3d(point - offset, point + offset));
+  object_ids.erase(std::remove_if(object_ids.begin(), object_ids.end(),
+                                  [&](const std::string& object_id) {
+                                    const auto it = aabbs_.find(object_id);
+                                    return it != aabbs_.end() &&
+                                           WorldSpatialIndex::distance(point, it->second) > distance;
+                                  }),
+                   object_ids.end());
+  return object_ids;
+}
+
+bool WorldSpatialIndex::getNearestObject(const Eigen::Vector3d& point, std::string& object_id, double& distance) const
+{
+  double best_distance = std::numeric_limits<double>::infinity();
+  auto check = [&](const std::string& id) {
+    const double d = WorldSpatialIndex::distance(point, aabbs_.at(id));
+    if (d < best_distance)
+    {
+      best_distance = d;
+      object_id = id;
+    }
+  };
+  for (const std::string& id : large_objects_)
+    check(id);
+
+  if (!cells_.empty())
+  {
+    // Visit the shells of cells around the point's cell with increasing Chebyshev radius r. All cells of shell r are
+    // at least (r - 1) * cell_size away from the point, so the search stops once no closer object can be found.
+    const CellIndex center = getCellIndex(point);
+    int first_ring = 0;
+    int last_ring = 0;
+    for (std::size_t axis = 0; axis < 3; ++axis)
+    {
+      first_ring = std::max({ first_ring, min_cell_[axis] - center[axis], center[axis] - max_cell_[axis] });
+      last_ring = std::max({ last_ring, center[axis] - min_cell_[axis], max_cell_[axis] - center[axis] });
+    }
+    for (int r = first_ring; r <= last_ring && best_distance > (r - 1) * cell_size_; ++r)
+    {
+      // clamp the shell to the occupied cells
+      const int x_begin = std::max(-r, min_cell_[0] - center[0]), x_end = std::min(r, max_cell_[0] - center[0]);
+      const int y_begin = std::max(-r, min_cell_[1] - center[1]), y_end = std::min(r, max_cell_[1] - center[1]);
+      const int z_begin = std::max(-r, min_cell_[2] - center[2]), z_end = std::min(r, max_cell_[2] - center[2]);
+      for (int dx = x_begin; dx <= x_end; ++dx)
+      {
+        for (int dy = y_begin; dy <= y_end; ++dy)
+        {
+          // inside the shell only the two cells at dz = -r and dz = r belong to it
+          const bool on_shell = std::abs(dx) == r || std::abs(dy) == r;
+          for (int dz = z_begin; dz <= z_end; ++dz)
+          {
+            if (!on_shell && std::abs(dz) != r)
+            {
+              if (dz < r - 1)
+                dz = r - 1;
+              continue;
+            }
+            const auto it = cells_.find({ center[0] + dx, center[1] + dy, center[2] + dz });
+            if (it != cells_.end())
+            {
+              for (const std::string& id : it->second)
+                check(id);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (std::isinf(best_distance))
+    return false;
+  distance = best_distance;
+  return true;
+}
+
+void WorldSpatialIndex::notify(const World::ObjectConstPtr& object, World::Action action)
+{
+  if (action == World::DESTROY)
+    removeObject(object->id_);
+  else
+    insertObject(*object);
+}
+
+bool WorldSpatialIndex::computeObjectAABB(const World::Object& object, Eigen::AlignedBox3d& aabb)
+{
+  aabb.setEmpty();
+  for (std::size_t i = 0; i < object.shapes_.size(); ++i)
+  {
+    if (!extendByShape(*object.shapes_[i], object.global_shape_poses_[i], aabb))
+      return false;
+  }
+  return true;
+}
+
+void WorldSpatialIndex::insertObject(const World::Object& object)
+{
+  removeObject(object.id_);
+
+  Eigen::AlignedBox3d aabb;
+  if (!computeObjectAABB(object, aabb))
+  {
+    unbounded_objects_.insert(object.id_);
+    return;
+  }
+  if (aabb.isEmpty())
+    return;
+  aabbs_[object.id_] = aabb;
+
+  const CellIndex lower = getCellIndex(aabb.min());
+  const CellIndex upper = getCellIndex(aabb.max());
+  double cell_count = 1.0;
+  for (std::size_t axis = 0; axis < 3; ++axis)
+    cell_count *= static_cast<double>(upper[axis]) - lower[axis] + 1;
+  if (cell_count > MAX_CELLS_PER_OBJECT)
+  {
+    large_objects_.insert(object.id_);
+    return;
+  }
+
+  for (std::size_t axis = 0; axis < 3; ++axis)
+  {
+    min_cell_[axis] = std::min(min_cell_[axis], lower[axis]);
+    max_cell_[axis] = std::max(max_cell_[axis], upper[axis]);
+  }
+  for (int x = lower[0]; x <= upper[0]; ++x)
+  {
+    for (int y = lower[1]; y <= upper[1]; ++y)
+    {
+      for (int z = lower[2]; z <= upper[2]; ++z)
+        cells_[{ x, y, z }].push_back(object.id_);
+    }
+  }
+}
+
+void WorldSpatialIndex::removeObject(const std::string& object_id)
+{
+  unbounded_objects_.erase(object_id);
+  const auto it = aabbs_.find(object_id);
+  if (it == aabbs_.end())
+    return;
+
+  if (large_objects_.erase(object_id) == 0)
+  {
+    const CellIndex lower = getCellIndex(it->second.min());
+    const CellIndex upper = getCellIndex(it->second.max());
+    for (int x = lower[0]; x <= upper[0]; ++x)
+    {
+      for (int y = lower[1]; y <= upper[1]; ++y)
+      {
+        for (int z = lower[2]; z <= upper[2]; ++z)
+        {
+          const auto cell = cells_.find({ x, y, z });
+          if (cell == cells_.end())
+            continue;
+          cell->second.erase(std::remove(cell->second.begin(), cell->second.end(), object_id), cell->second.end());
+          if (cell->second.empty())
+            cells_.erase(cell);
+        }
+      }
+    }
+  }
+  aabbs_.erase(it);
+}
+
+WorldSpatialIndex::CellIndex WorldSpatialIndex::getCellIndex(const Eigen::Vector3d& point) const
+{
+  // clamp, so that far away or infinite coordinates can't overflow the cell index
+  constexpr double MAX_INDEX = 1e8;
+  CellIndex index;
+  for (std::size_t axis = 0; axis < 3; ++axis)
+    index[axis] = static_cast<int>(std::clamp(std::floor(point[axis] / cell_size_), -MAX_INDEX, MAX_INDEX));
+  return index;
+}
+
+double WorldSpatialIndex::distance(const Eigen::Vector3d& point, const Eigen::AlignedBox3d& aabb)
+{
+  return aabb.exteriorDistance(point);
+}
+}  // namespace collision_detection
@@ -0,0 +1,146 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/collision_matrix.h>
+
+using namespace collision_detection;
+
+TEST(CompiledAllowedCollisionMatrix, MatchesAllowedCollisionMatrix)
+{
+  AllowedCollisionMatrix acm;
+  DecideContactFn allow_all = [](Contact& /*contact*/) { return true; };
+  acm.setEntry("a", "b", true);
+  acm.setEntry("a", "c", false);
+  acm.setEntry("b", "c", allow_all);
+  acm.setDefaultEntry("d", true);
+  acm.setDefaultEntry("e", allow_all);
+  acm.setEntry("d", "a", false);
+
+  const std::vector<std::string> names = { "a", "b", "c", "d", "e", "unknown" };
+  const CompiledAllowedCollisionMatrix compiled(acm, names);
+  EXPECT_EQ(compiled.getSourceVersion(), acm.getVersion());
+
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    for (std::size_t j = 0; j < names.size(); ++j)
+    {
+      AllowedCollision::Type expected_type, type;
+      const bool expected_found = acm.getAllowedCollision(names[i], names[j], expected_type);
+      ASSERT_EQ(compiled.getAllowedCollision(i, j, type), expected_found) << names[i] << ", " << names[j];
+      if (!expected_found)
+        continue;
+      EXPECT_EQ(type, expected_type) << names[i] << ", " << names[j];
+      EXPECT_EQ(compiled.getAllowedContactFn(i, j) != nullptr, type == AllowedCollision::CONDITIONAL);
+    }
+  }
+}
+
+TEST(CompiledAllowedCollisionMatrix, ConditionalDefaults)
+{
+  AllowedCollisionMatrix acm;
+  int calls = 0;
+  DecideContactFn allow = [&calls](Contact& /*contact*/) { return ++calls > 0; };
+  DecideContactFn deny = [](Contact& /*contact*/) { return false; };
+  acm.setDefaultEntry("a", allow);
+  acm.setDefaultEntry("b", deny);
+  acm.setDefaultEntry("c", allow);
+  acm.setEntry("a", "c", true);
+
+  const CompiledAllowedCollisionMatrix compiled(acm, { "a", "b", "c" });
+  Contact contact;
+  // both defaults are conditional, so both predicates need to allow the contact
+  ASSERT_NE(compiled.getAllowedContactFn(0, 1), nullptr);
+  EXPECT_FALSE((*compiled.getAllowedContactFn(0, 1))(contact));
+  EXPECT_EQ(calls, 1);
+  // explicit entries override the default predicates
+  AllowedCollision::Type type;
+  ASSERT_TRUE(compiled.getAllowedCollision(0, 2, type));
+  EXPECT_EQ(type, AllowedCollision::ALWAYS);
+  EXPECT_EQ(compiled.getAllowedContactFn(0, 2), nullptr);
+}
+
+TEST(AllowedCollisionMatrix, CopiesAreIndependent)
+{
+  AllowedCollisionMatrix acm;
+  DecideContactFn allow_all = [](Contact& /*contact*/) { return true; };
+  acm.setEntry("a", "b", true);
+  acm.setEntry("a", "c", allow_all);
+
+  AllowedCollisionMatrix copy(acm);
+  copy.setEntry("a", "b", false);
+  copy.removeEntry("c");
+  copy.setEntry("d", "a", true);
+
+  AllowedCollision::Type type;
+  ASSERT_TRUE(acm.getEntry("a", "b", type));
+  EXPECT_EQ(type, AllowedCollision::ALWAYS);
+  ASSERT_TRUE(acm.getEntry("c", "a", type));
+  EXPECT_EQ(type, AllowedCollision::CONDITIONAL);
+  DecideContactFn fn;
+  EXPECT_TRUE(acm.getEntry("a", "c", fn));
+  EXPECT_FALSE(acm.hasEntry("d"));
+
+  ASSERT_TRUE(copy.getEntry("b", "a", type));
+  EXPECT_EQ(type, AllowedCollision::NEVER);
+  EXPECT_FALSE(copy.hasEntry("c"));
+  EXPECT_FALSE(copy.getEntry("a", "c", fn));
+  EXPECT_TRUE(copy.hasEntry("d"));
+
+  copy.setEntry(true);
+  ASSERT_TRUE(copy.getEntry("a", "b", type));
+  EXPECT_EQ(type, AllowedCollision::ALWAYS);
+  ASSERT_TRUE(copy.getEntry("a", "d", type));
+  EXPECT_EQ(type, AllowedCollision::ALWAYS);
+}
+
+TEST(AllowedCollisionMatrix, Version)
+{
+  AllowedCollisionMatrix acm;
+  const AllowedCollisionMatrix copy(acm);
+  EXPECT_EQ(copy.getVersion(), acm.getVersion());
+
+  acm.setEntry("a", "b", true);
+  EXPECT_NE(copy.getVersion(), acm.getVersion());
+  const std::size_t version = acm.getVersion();
+  acm.setDefaultEntry("a", false);
+  EXPECT_NE(version, acm.getVersion());
+  EXPECT_NE(AllowedCollisionMatrix().getVersion(), AllowedCollisionMatrix().getVersion());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/mesh_geometry_cache.h>
+#include <geometric_shapes/shapes.h>
+
+namespace
+{
+std::shared_ptr<shapes::Mesh> createTriangle(double z)
+{
+  auto mesh = std::make_shared<shapes::Mesh>(3, 1);
+  const double vertices[9] = { 0.0, 0.0, z, 1.0, 0.0, z, 0.0, 1.0, z };
+  std::copy(vertices, vertices + 9, mesh->vertices);
+  mesh->triangles[0] = 0;
+  mesh->triangles[1] = 1;
+  mesh->triangles[2] = 2;
+  return mesh;
+}
+}  // namespace
+
+TEST(MeshGeometryCache, HashAndEquality)
+{
+  auto mesh1 = createTriangle(0.0);
+  auto mesh2 = createTriangle(0.0);
+  auto mesh3 = createTriangle(1.0);
+
+  EXPECT_EQ(collision_detection::computeMeshHash(*mesh1), collision_detection::computeMeshHash(*mesh2));
+  EXPECT_NE(collision_detection::computeMeshHash(*mesh1), collision_detection::computeMeshHash(*mesh3));
+  EXPECT_TRUE(collision_detection::meshesEqual(*mesh1, *mesh2));
+  EXPECT_FALSE(collision_detection::meshesEqual(*mesh1, *mesh3));
+}
+
+TEST(MeshGeometryCache, ShareIdenticalMeshes)
+{
+  collision_detection::MeshGeometryCache<int> cache;
+  int created = 0;
+  auto create = [&created](const shapes::Mesh& /*mesh*/) { return std::make_shared<int>(++created); };
+
+  auto mesh1 = createTriangle(0.0);
+  auto mesh2 = createTriangle(0.0);
+  auto mesh3 = createTriangle(1.0);
+
+  std::shared_ptr<int> geometry1 = cache.getOrCreate(mesh1, create);
+  std::shared_ptr<int> geometry2 = cache.getOrCreate(mesh2, create);
+  std::shared_ptr<int> geometry3 = cache.getOrCreate(mesh3, create);
+  EXPECT_EQ(created, 2);
+  EXPECT_EQ(geometry1, geometry2);
+  EXPECT_NE(geometry1, geometry3);
+
+  // geometry is rebuilt once nobody uses it anymore
+  geometry1.reset();
+  geometry2.reset();
+  geometry1 = cache.getOrCreate(mesh2, create);
+  EXPECT_EQ(created, 3);
+  EXPECT_EQ(*geometry1, 3);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/occupancy_map.h>
+#include <random>
+#include <vector>
+
+using namespace collision_detection;
+
+namespace
+{
+void expectSameOccupancy(const octomap::OcTree& snapshot, const OccMapTree& tree, double extent)
+{
+  const double resolution = tree.getResolution();
+  for (double x = -extent; x < extent; x += resolution)
+    for (double y = -extent; y < extent; y += resolution)
+      for (double z = -extent; z < extent; z += resolution)
+      {
+        const octomap::OcTreeNode* expected = tree.search(x, y, z);
+        const octomap::OcTreeNode* actual = snapshot.search(x, y, z);
+        const bool expected_occupied = expected && tree.isNodeOccupied(expected);
+        const bool actual_occupied = actual && snapshot.isNodeOccupied(actual);
+        ASSERT_EQ(expected_occupied, actual_occupied) << x << " " << y << " " << z;
+      }
+}
+}  // namespace
+
+TEST(OccMapTreeSnapshots, FollowTree)
+{
+  const double extent = 0.5;
+  OccMapTree tree(0.1);
+  tree.enableChangeDetection(true);
+  OccMapTreeSnapshots snapshots;
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(-extent, extent);
+  std::bernoulli_distribution occupied(0.7);
+  std::vector<std::shared_ptr<const octomap::OcTree>> held;
+  for (int i = 0; i < 20; ++i)
+  {
+    for (int j = 0; j < 30; ++j)
+      tree.updateNode(coordinate(rng), coordinate(rng), coordinate(rng), occupied(rng));
+    if (i == 10)
+      tree.clear();
+
+    std::shared_ptr<const octomap::OcTree> snapshot = snapshots.update(tree);
+    tree.resetChangeDetection();
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(snapshot, snapshots.get());
+    expectSameOccupancy(*snapshot, tree, extent);
+
+    // holding a snapshot forces the next but one update to copy the tree
+    if (i % 3 == 0)
+      held.push_back(snapshot);
+  }
+
+  // held snapshots are not modified by later updates
+  const std::size_t held_size = held.back()->size();
+  tree.updateNode(0.0, 0.0, 0.0, true);
+  snapshots.update(tree);
+  tree.resetChangeDetection();
+  snapshots.update(tree);
+  EXPECT_EQ(held.back()->size(), held_size);
+
+  snapshots.reset();
+  EXPECT_FALSE(snapshots.get());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/persistent_map.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace collision_detection;
+
+using IntMap = PersistentMap<std::string, int>;
+
+namespace
+{
+void expectEqual(const IntMap& map, const std::map<std::string, int>& reference)
+{
+  ASSERT_EQ(map.size(), reference.size());
+  auto it = reference.begin();
+  for (const auto& entry : map)
+  {
+    EXPECT_EQ(entry.first, it->first);
+    EXPECT_EQ(entry.second, it->second);
+    ++it;
+  }
+}
+}  // namespace
+
+TEST(PersistentMap, InsertFindErase)
+{
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  map["b"] = 2;
+  map["a"] = 1;
+  map["c"] = 3;
+  EXPECT_EQ(map.size(), 3u);
+  ASSERT_NE(map.get("a"), nullptr);
+  EXPECT_EQ(*map.get("a"), 1);
+  EXPECT_EQ(map.get("d"), nullptr);
+  EXPECT_EQ(map.find("d"), map.end());
+  EXPECT_EQ(map.find("b")->second, 2);
+  EXPECT_EQ(map.begin()->first, "a");
+
+  EXPECT_TRUE(map.erase("b"));
+  EXPECT_FALSE(map.erase("b"));
+  EXPECT_FALSE(map.contains("b"));
+  expectEqual(map, { { "a", 1 }, { "c", 3 } });
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(PersistentMap, CopiesAreIndependent)
+{
+  IntMap map;
+  for (int i = 0; i < 100; ++i)
+    map[std::to_string(i)] = i;
+
+  IntMap copy(map);
+  EXPECT_TRUE(copy.sharesStructureWith(map));
+
+  *copy.getMutable("5") = -5;
+  copy.erase("6");
+  copy["100"] = 100;
+  EXPECT_FALSE(copy.sharesStructureWith(map));
+
+  EXPECT_EQ(*map.get("5"), 5);
+  EXPECT_TRUE(map.contains("6"));
+  EXPECT_FALSE(map.contains("100"));
+  EXPECT_EQ(map.size(), 100u);
+  EXPECT_EQ(*copy.get("5"), -5);
+  EXPECT_FALSE(copy.contains("6"));
+  EXPECT_EQ(copy.size(), 100u);
+
+  copy.forEachMutable([](const std::string& /*key*/, int& value) { value = 0; });
+  EXPECT_EQ(*map.get("99"), 99);
+  EXPECT_EQ(*copy.get("99"), 0);
+}
+
+TEST(PersistentMap, MatchesStdMapAcrossVersions)
+{
+  std::mt19937 rng(42);
+  std::vector<std::pair<IntMap, std::map<std::string, int>>> versions(1);
+  for (int step = 0; step < 5000; ++step)
+  {
+    const std::size_t index = rng() % versions.size();
+    if (rng() % 20 == 0 && versions.size() < 20)
+    {
+      versions.push_back(versions[index]);
+      continue;
+    }
+
+    IntMap& map = versions[index].first;
+    std::map<std::string, int>& reference = versions[index].second;
+    const std::string key = std::to_string(rng() % 200);
+    switch (rng() % 3)
+    {
+      case 0:
+      {
+        const int value = static_cast<int>(rng() % 1000);
+        map[key] = value;
+        reference[key] = value;
+        break;
+      }
+      case 1:
+        EXPECT_EQ(map.erase(key), reference.erase(key) > 0);
+        break;
+      default:
+      {
+        int* value = map.getMutable(key);
+        const auto it = reference.find(key);
+        ASSERT_EQ(value == nullptr, it == reference.end());
+        if (value)
+          it->second = ++*value;
+      }
+    }
+  }
+
+  for (const auto& version : versions)
+    expectEqual(version.first, version.second);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -458,6 +458,68 @@ TEST(World, ObjectPoseAndSubframes)
   EXPECT_EQ(1.0, pose(2, 3));  // z
 }
 
+TEST(World, CopiesAreIndependent)
+{
+  World world;
+  shapes::ShapePtr ball = std::make_shared<shapes::Sphere>(1.0);
+  shapes::ShapePtr box = std::make_shared<shapes::Box>(1, 2, 3);
+  for (int i = 0; i < 20; ++i)
+    world.addToObject("ball" + std::to_string(i), ball, Eigen::Isometry3d::Identity());
+
+  World copy(world);
+  EXPECT_EQ(copy.getObject("ball3"), world.getObject("ball3"));
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 1.0;
+  EXPECT_TRUE(copy.moveObject("ball3", pose));
+  EXPECT_TRUE(copy.removeObject("ball4"));
+  copy.addToObject("box", box, Eigen::Isometry3d::Identity());
+
+  EXPECT_EQ(world.size(), 20u);
+  EXPECT_EQ(copy.size(), 20u);
+  EXPECT_TRUE(world.hasObject("ball4"));
+  EXPECT_FALSE(world.hasObject("box"));
+  EXPECT_FALSE(copy.hasObject("ball4"));
+  EXPECT_TRUE(copy.hasObject("box"));
+  EXPECT_NE(copy.getObject("ball3"), world.getObject("ball3"));
+  EXPECT_DOUBLE_EQ(world.getObject("ball3")->pose_.translation().x(), 0.0);
+  EXPECT_DOUBLE_EQ(copy.getObject("ball3")->pose_.translation().x(), 1.0);
+
+  // Untouched objects are still shared
+  EXPECT_EQ(copy.getObject("ball5"), world.getObject("ball5"));
+}
+
+TEST(World, ChangeCount)
+{
+  World world;
+  shapes::ShapePtr ball = std::make_shared<shapes::Sphere>(1.0);
+  std::size_t count = world.getChangeCount();
+
+  world.addToObject("ball", ball, Eigen::Isometry3d::Identity());
+  EXPECT_GT(world.getChangeCount(), count);
+  count = world.getChangeCount();
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 1.0;
+  EXPECT_TRUE(world.moveObject("ball", pose));
+  EXPECT_GT(world.getChangeCount(), count);
+  count = world.getChangeCount();
+
+  // subframes are not reported to observers, but still count as a change
+  moveit::core::FixedTransformsMap subframes;
+  subframes["tip"] = Eigen::Isometry3d::Identity();
+  EXPECT_TRUE(world.setSubframesOfObject("ball", subframes));
+  EXPECT_GT(world.getChangeCount(), count);
+  count = world.getChangeCount();
+
+  // failed operations do not change anything
+  EXPECT_FALSE(world.removeObject("box"));
+  EXPECT_EQ(world.getChangeCount(), count);
+
+  EXPECT_TRUE(world.removeObject("ball"));
+  EXPECT_GT(world.getChangeCount(), count);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,178 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/world_spatial_index.h>
+#include <geometric_shapes/shapes.h>
+
+using collision_detection::World;
+using collision_detection::WorldPtr;
+using collision_detection::WorldSpatialIndex;
+
+namespace
+{
+Eigen::Isometry3d translation(double x, double y, double z)
+{
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(x, y, z);
+  return pose;
+}
+
+Eigen::AlignedBox3d box(const Eigen::Vector3d& min, const Eigen::Vector3d& max)
+{
+  return Eigen::AlignedBox3d(min, max);
+}
+}  // namespace
+
+TEST(WorldSpatialIndex, TracksWorldChanges)
+{
+  WorldPtr world = std::make_shared<World>();
+  world->addToObject("existing", std::make_shared<shapes::Sphere>(0.1), translation(5, 0, 0));
+
+  WorldSpatialIndex index(world, 0.5);
+
+  // objects added before the index was created are indexed
+  Eigen::AlignedBox3d aabb;
+  ASSERT_TRUE(index.getObjectAABB("existing", aabb));
+  EXPECT_TRUE(aabb.min().isApprox(Eigen::Vector3d(4.9, -0.1, -0.1)));
+  EXPECT_TRUE(aabb.max().isApprox(Eigen::Vector3d(5.1, 0.1, 0.1)));
+
+  world->addToObject("box", std::make_shared<shapes::Box>(1.0, 1.0, 1.0), translation(0, 0, 0));
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(-1, -1, -1), Eigen::Vector3d(1, 1, 1))),
+            std::vector<std::string>({ "box" }));
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(-1, -1, -1), Eigen::Vector3d(6, 1, 1))),
+            std::vector<std::string>({ "box", "existing" }));
+  EXPECT_TRUE(index.getObjectsInRegion(box(Eigen::Vector3d(1, 1, 1), Eigen::Vector3d(2, 2, 2))).empty());
+
+  // moving an object moves its AABB
+  world->moveObject("box", translation(1.5, 1.5, 1.5));
+  EXPECT_TRUE(index.getObjectsInRegion(box(Eigen::Vector3d(-0.4, -0.4, -0.4), Eigen::Vector3d(0.4, 0.4, 0.4))).empty());
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(1, 1, 1), Eigen::Vector3d(2, 2, 2))),
+            std::vector<std::string>({ "box" }));
+
+  // adding a shape grows the AABB
+  world->addToObject("box", std::make_shared<shapes::Sphere>(0.5), translation(-3, 0, 0));  // relative to the object
+  ASSERT_TRUE(index.getObjectAABB("box", aabb));
+  EXPECT_TRUE(aabb.min().isApprox(Eigen::Vector3d(-2.0, 1.0, 1.0)));
+  EXPECT_TRUE(aabb.max().isApprox(Eigen::Vector3d(2.0, 2.0, 2.0)));
+
+  world->removeObject("box");
+  EXPECT_FALSE(index.getObjectAABB("box", aabb));
+  EXPECT_TRUE(index.getObjectsInRegion(box(Eigen::Vector3d(-5, -5, -5), Eigen::Vector3d(4, 4, 4))).empty());
+
+  world->clearObjects();
+  EXPECT_FALSE(index.getObjectAABB("existing", aabb));
+}
+
+TEST(WorldSpatialIndex, NearestObject)
+{
+  WorldPtr world = std::make_shared<World>();
+  WorldSpatialIndex index(world, 0.25);
+
+  std::string object_id;
+  double distance;
+  EXPECT_FALSE(index.getNearestObject(Eigen::Vector3d::Zero(), object_id, distance));
+
+  world->addToObject("near", std::make_shared<shapes::Sphere>(0.5), translation(2, 0, 0));
+  world->addToObject("far", std::make_shared<shapes::Sphere>(0.5), translation(-10, 0, 0));
+
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d::Zero(), object_id, distance));
+  EXPECT_EQ(object_id, "near");
+  EXPECT_NEAR(distance, 1.5, 1e-9);
+
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d(-9, 0, 0), object_id, distance));
+  EXPECT_EQ(object_id, "far");
+  EXPECT_NEAR(distance, 0.5, 1e-9);
+
+  // query points far outside the occupied cells
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d(100, 0, 0), object_id, distance));
+  EXPECT_EQ(object_id, "near");
+  EXPECT_NEAR(distance, 97.5, 1e-9);
+
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d(2, 0.2, 0), object_id, distance));
+  EXPECT_EQ(object_id, "near");
+  EXPECT_DOUBLE_EQ(distance, 0.0);
+
+  EXPECT_EQ(index.getObjectsNear(Eigen::Vector3d::Zero(), 1.0), std::vector<std::string>());
+  EXPECT_EQ(index.getObjectsNear(Eigen::Vector3d::Zero(), 1.6), std::vector<std::string>({ "near" }));
+  EXPECT_EQ(index.getObjectsNear(Eigen::Vector3d::Zero(), 10.0), std::vector<std::string>({ "far", "near" }));
+}
+
+TEST(WorldSpatialIndex, LargeAndUnboundedObjects)
+{
+  WorldPtr world = std::make_shared<World>();
+  WorldSpatialIndex index(world, 0.1);
+
+  // a plane has no finite AABB and is part of every region query, but never the nearest object
+  world->addToObject("ground", std::make_shared<shapes::Plane>(0, 0, 1, 0), translation(0, 0, 0));
+  // a table top covering far more cells than are binned per object
+  world->addToObject("table", std::make_shared<shapes::Box>(20.0, 20.0, 0.1), translation(0, 0, 1));
+  world->addToObject("cup", std::make_shared<shapes::Sphere>(0.05), translation(0.3, 0, 1.1));
+
+  Eigen::AlignedBox3d aabb;
+  EXPECT_FALSE(index.getObjectAABB("ground", aabb));
+  EXPECT_TRUE(index.getObjectAABB("table", aabb));
+
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(5, 5, 5), Eigen::Vector3d(6, 6, 6))),
+            std::vector<std::string>({ "ground" }));
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(5, 5, 0.5), Eigen::Vector3d(6, 6, 1.0))),
+            std::vector<std::string>({ "ground", "table" }));
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(0.2, -0.1, 1.0), Eigen::Vector3d(0.4, 0.1, 1.2))),
+            std::vector<std::string>({ "cup", "ground", "table" }));
+
+  std::string object_id;
+  double distance;
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d(0.3, 0, 1.5), object_id, distance));
+  EXPECT_EQ(object_id, "cup");
+  EXPECT_NEAR(distance, 0.35, 1e-9);
+  ASSERT_TRUE(index.getNearestObject(Eigen::Vector3d(5, 5, 1.5), object_id, distance));
+  EXPECT_EQ(object_id, "table");
+  EXPECT_NEAR(distance, 0.45, 1e-9);
+
+  world->removeObject("table");
+  EXPECT_EQ(index.getObjectsInRegion(box(Eigen::Vector3d(5, 5, 0.5), Eigen::Vector3d(6, 6, 1.0))),
+            std::vector<std::string>({ "ground" }));
+
+  // the AABBs are also available for objects that are not indexed
+  ASSERT_TRUE(WorldSpatialIndex::computeObjectAABB(*world->getObject("cup"), aabb));
+  EXPECT_TRUE(aabb.min().isApprox(Eigen::Vector3d(0.25, -0.05, 1.05)));
+  EXPECT_TRUE(aabb.max().isApprox(Eigen::Vector3d(0.35, 0.05, 1.15)));
+  EXPECT_FALSE(WorldSpatialIndex::computeObjectAABB(*world->getObject("ground"), aabb));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
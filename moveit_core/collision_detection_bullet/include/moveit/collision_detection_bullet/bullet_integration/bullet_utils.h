@@ -654,7 +654,9 @@ public:
   bool processOverlap(btBroadphasePair& pair) override;
 };
 
-/** \brief Casts a geometric shape into a btCollisionShape */
+/** \brief Casts a geometric shape into a btCollisionShape
+ *
+ *  The returned shape is owned by \e cow. Shapes of identical meshes are shared between all collision objects. */
 btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
                                        const CollisionObjectType& collision_object_type, CollisionObjectWrapper* cow);
 
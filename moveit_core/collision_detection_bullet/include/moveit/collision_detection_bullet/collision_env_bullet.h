@@ -39,7 +39,10 @@
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_discrete_bvh_manager.h>
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_cast_bvh_manager.h>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 
 namespace collision_detection
 {
@@ -86,6 +89,8 @@ public:
 
   void setWorld(const WorldPtr& world) override;
 
+  void getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& usage) const override;
+
 protected:
   /** \brief Updates the poses of the objects in the manager according to given robot state */
   void updateTransformsFromState(const moveit::core::RobotState& state,
@@ -99,6 +104,35 @@ protected:
   void addAttachedOjects(const moveit::core::RobotState& state,
                          std::vector<collision_detection_bullet::CollisionObjectWrapperPtr>& cows) const;
 
+  /** \brief Wrap an attached body into a bullet collision object, or return nullptr if it has invalid geometry */
+  collision_detection_bullet::CollisionObjectWrapperPtr
+  createAttachedObject(const moveit::core::AttachedBody& body) const;
+
+  struct DiscreteContext;
+
+  /** \brief Register the attached bodies of \e state to the manager of \e context, at their poses in \e state.
+   *
+   *  The collision objects of the attached bodies stay registered between checks, so that the broadphase keeps their
+   *  overlapping pairs. They are only rebuilt when the geometry or the touch links of an attached body change, and
+   *  removed once a checked state does not have the attached body anymore. */
+  void updateAttachedObjects(DiscreteContext& context, const moveit::core::RobotState& state) const;
+
+  /** \brief Remove the collision object of an attached body from the manager of \e context, if it is registered */
+  void removeAttachedObject(DiscreteContext& context, const std::string& name) const;
+
+  /** \brief Take an idle discrete context, or clone \m manager_ into a new one if all of them are in use */
+  std::unique_ptr<DiscreteContext> acquireDiscreteContext() const;
+
+  /** \brief Give back a context after a check. Contexts cloned before the last geometry change are dropped. */
+  void releaseDiscreteContext(std::unique_ptr<DiscreteContext> context) const;
+
+  /** \brief Drop all idle discrete contexts after a change to \m manager_, must be called with the mutex locked */
+  void invalidateDiscreteContexts();
+
+  /** \brief Runs a discrete self or robot collision check on a context of the calling thread */
+  void contactTestDiscrete(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
+                           const AllowedCollisionMatrix* acm, bool self) const;
+
   /** \brief Bundles the different checkSelfCollision functions into a single function */
   void checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
@@ -113,7 +147,10 @@ protected:
   /** \brief Construts a bullet collision object out of a robot link */
   void addLinkAsCollisionObject(const urdf::LinkSharedPtr& link);
 
-  /** \brief Handles self collision checks */
+  /** \brief Holds the geometry of the robot links and world objects for discrete checks.
+   *
+   *  The checks do not run on this manager, but on clones of it that share its (immutable) collision shapes, one per
+   *  concurrently checking thread. */
   collision_detection_bullet::BulletDiscreteBVHManagerPtr manager_{
     new collision_detection_bullet::BulletDiscreteBVHManager()
   };
@@ -123,9 +160,36 @@ protected:
     new collision_detection_bullet::BulletCastBVHManager()
   };
 
-  // Lock manager_ and manager_CCD_, for thread-safe collision tests
+  // Lock manager_, manager_CCD_ and the idle discrete contexts, for thread-safe collision tests
   mutable std::mutex collision_env_mutex_;
 
+  /** \brief Collision object of an attached body in a discrete manager, with the properties it was built from */
+  struct AttachedObject
+  {
+    std::vector<shapes::ShapeConstPtr> shapes_;
+    EigenSTL::vector_Isometry3d shape_poses_;
+    std::set<std::string> touch_links_;
+    collision_detection_bullet::CollisionObjectWrapperPtr cow_;
+  };
+
+  /** \brief Clone of \m manager_ that one thread at a time runs discrete checks on */
+  struct DiscreteContext
+  {
+    collision_detection_bullet::BulletDiscreteBVHManagerPtr manager_;
+
+    /** \brief Attached bodies registered to \m manager_ by updateAttachedObjects() */
+    std::map<std::string, AttachedObject> attached_objects_;
+
+    /** \brief Value of \m geometry_version_ when \m manager_ was cloned */
+    std::size_t version_;
+  };
+
+  /** \brief Discrete contexts that are not in use by a check, guarded by \m collision_env_mutex_ */
+  mutable std::vector<std::unique_ptr<DiscreteContext>> idle_contexts_;
+
+  /** \brief Counts the changes to \m manager_, guarded by \m collision_env_mutex_ */
+  std::size_t geometry_version_ = 0;
+
   /** \brief Adds a world object to the collision managers */
   void addToManager(const World::Object* obj);
 
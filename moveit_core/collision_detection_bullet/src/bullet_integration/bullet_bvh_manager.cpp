@@ -113,6 +113,9 @@ void BulletBVHManager::setCollisionObjectsTransform(const std::string& name, con
   {
     CollisionObjectWrapperPtr& cow = it->second;
     btTransform tf = convertEigenToBt(pose);
+    // objects that did not move since the last query keep their AABB
+    if (cow->getWorldTransform() == tf)
+      return;
     cow->setWorldTransform(tf);
 
     // Now update Broadphase AABB (See BulletWorld updateSingleAabb function)
@@ -38,6 +38,8 @@
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
 #include <BulletCollision/Gimpact/btGImpactShape.h>
 #include <geometric_shapes/shapes.h>
+#include <moveit/collision_detection/mesh_geometry_cache.h>
+#include <array>
 #include <memory>
 #include <octomap/octomap.h>
 #include <rclcpp/logger.hpp>
@@ -120,8 +122,8 @@ btCollisionShape* createShapePrimitive(const shapes::Cone* geom, const Collision
   return (new btConeShapeZ(r, l));
 }
 
-btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const CollisionObjectType& collision_object_type,
-                                       CollisionObjectWrapper* cow)
+std::shared_ptr<btCollisionShape> createShapePrimitive(const shapes::Mesh* geom,
+                                                       const CollisionObjectType& collision_object_type)
 {
   assert(collision_object_type == CollisionObjectType::USE_SHAPE_TYPE ||
          collision_object_type == CollisionObjectType::CONVEX_HULL ||
@@ -153,7 +155,7 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
               btVector3(static_cast<btScalar>(v[0]), static_cast<btScalar>(v[1]), static_cast<btScalar>(v[2])));
         }
 
-        return subshape;
+        return std::shared_ptr<btCollisionShape>(subshape);
       }
       case CollisionObjectType::USE_SHAPE_TYPE:
       {
@@ -162,6 +164,10 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
         compound->setMargin(
             BULLET_MARGIN);  // margin: compound seems to have no effect when positive but has an effect when negative
 
+        // the triangles are owned by the compound, as it may be shared by several collision objects
+        auto triangles = std::make_shared<std::vector<std::unique_ptr<btCollisionShape>>>();
+        triangles->reserve(geom->triangle_count);
+
         for (unsigned i = 0; i < geom->triangle_count; ++i)
         {
           btVector3 v[3];
@@ -177,7 +183,7 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
           btCollisionShape* subshape = new btTriangleShapeEx(v[0], v[1], v[2]);
           if (subshape != nullptr)
           {
-            cow->manage(subshape);
+            triangles->emplace_back(subshape);
             subshape->setMargin(BULLET_MARGIN);
             btTransform geom_trans;
             geom_trans.setIdentity();
@@ -185,7 +191,7 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
           }
         }
 
-        return compound;
+        return std::shared_ptr<btCollisionShape>(compound, [triangles](btCollisionShape* shape) { delete shape; });
       }
       default:
       {
@@ -199,6 +205,57 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
   return nullptr;
 }
 
+namespace
+{
+/** \brief Cache of the collision shapes built from meshes, separately for each collision object type */
+collision_detection::MeshGeometryCache<btCollisionShape>&
+getMeshShapeCache(const CollisionObjectType& collision_object_type)
+{
+  static collision_detection::MeshGeometryCache<btCollisionShape> convex_hull_cache;
+  static collision_detection::MeshGeometryCache<btCollisionShape> triangle_cache;
+  return collision_object_type == CollisionObjectType::CONVEX_HULL ? convex_hull_cache : triangle_cache;
+}
+
+/** \brief Recursively collect the occupied regions of an octree as (key, depth) pairs.
+ *
+ *  Subtrees whose cells are all occupied are not split up but reported once by their common ancestor, so that large
+ *  solid regions of a fine map become a few big cells instead of many small ones.
+ *  \return true if the whole subtree of \e node is occupied; it is then left to the caller to report it */
+bool collectOccupiedRegions(const octomap::OcTree& octree, const octomap::OcTreeNode* node,
+                            const octomap::OcTreeKey& key, unsigned int depth,
+                            std::vector<std::pair<octomap::OcTreeKey, unsigned int>>& regions)
+{
+  if (!octree.nodeHasChildren(node))
+    return octree.isNodeOccupied(node);
+
+  const octomap::key_type center_offset_key = (1u << (octree.getTreeDepth() - 1)) >> (depth + 1);
+  std::array<octomap::OcTreeKey, 8> child_keys;
+  std::array<bool, 8> child_occupied{};
+  bool all_occupied = true;
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!octree.nodeChildExists(node, i))
+    {
+      all_occupied = false;
+      continue;
+    }
+    octomap::computeChildKey(i, center_offset_key, key, child_keys[i]);
+    child_occupied[i] = collectOccupiedRegions(octree, octree.getNodeChild(node, i), child_keys[i], depth + 1, regions);
+    all_occupied = all_occupied && child_occupied[i];
+  }
+
+  if (all_occupied)
+    return true;
+
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (child_occupied[i])
+      regions.emplace_back(child_keys[i], depth + 1);
+  }
+  return false;
+}
+}  // namespace
+
 btCollisionShape* createShapePrimitive(const shapes::OcTree* geom, const CollisionObjectType& collision_object_type,
                                        CollisionObjectWrapper* cow)
 {
@@ -207,66 +264,58 @@ btCollisionShape* createShapePrimitive(const shapes::OcTree* geom, const Collisi
          collision_object_type == CollisionObjectType::SDF ||
          collision_object_type == CollisionObjectType::MULTI_SPHERE);
 
-  btCompoundShape* subshape =
-      new btCompoundShape(BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(geom->octree->size()));
-  double occupancy_threshold = geom->octree->getOccupancyThres();
+  if (collision_object_type != CollisionObjectType::USE_SHAPE_TYPE &&
+      collision_object_type != CollisionObjectType::MULTI_SPHERE)
+  {
+    RCLCPP_ERROR(BULLET_LOGGER, "This bullet shape type (%d) is not supported for geometry octree",
+                 static_cast<int>(collision_object_type));
+    return nullptr;
+  }
 
-  // convert the mesh to the assigned collision object type
-  switch (collision_object_type)
+  const octomap::OcTree& octree = *geom->octree;
+  std::vector<std::pair<octomap::OcTreeKey, unsigned int>> regions;
+  if (octree.getRoot())
   {
-    case CollisionObjectType::USE_SHAPE_TYPE:
+    const octomap::key_type root_key_value = 1u << (octree.getTreeDepth() - 1);
+    const octomap::OcTreeKey root_key(root_key_value, root_key_value, root_key_value);
+    if (collectOccupiedRegions(octree, octree.getRoot(), root_key, 0, regions))
+      regions.emplace_back(root_key, 0);
+  }
+
+  // the compound's dynamic AABB tree keeps narrow phase queries local to the contacted cells
+  btCompoundShape* subshape = new btCompoundShape(BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(regions.size()));
+
+  // all cells of the same depth have the same size and share one child shape
+  std::vector<btCollisionShape*> cell_shapes(octree.getTreeDepth() + 1, nullptr);
+  for (const std::pair<octomap::OcTreeKey, unsigned int>& region : regions)
+  {
+    const unsigned int depth = region.second;
+    if (!cell_shapes[depth])
     {
-      for (auto it = geom->octree->begin(static_cast<unsigned char>(geom->octree->getTreeDepth())),
-                end = geom->octree->end();
-           it != end; ++it)
+      const double size = octree.getNodeSize(depth);
+      btCollisionShape* childshape;
+      if (collision_object_type == CollisionObjectType::USE_SHAPE_TYPE)
       {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geom_trans;
-          geom_trans.setIdentity();
-          geom_trans.setOrigin(btVector3(static_cast<btScalar>(it.getX()), static_cast<btScalar>(it.getY()),
-                                         static_cast<btScalar>(it.getZ())));
-          btScalar l = static_cast<btScalar>(size / 2);
-          btBoxShape* childshape = new btBoxShape(btVector3(l, l, l));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geom_trans, childshape);
-        }
+        btScalar l = static_cast<btScalar>(size / 2);
+        childshape = new btBoxShape(btVector3(l, l, l));
       }
-      return subshape;
-    }
-    case CollisionObjectType::MULTI_SPHERE:
-    {
-      for (auto it = geom->octree->begin(static_cast<unsigned char>(geom->octree->getTreeDepth())),
-                end = geom->octree->end();
-           it != end; ++it)
+      else
       {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geom_trans;
-          geom_trans.setIdentity();
-          geom_trans.setOrigin(btVector3(static_cast<btScalar>(it.getX()), static_cast<btScalar>(it.getY()),
-                                         static_cast<btScalar>(it.getZ())));
-          btSphereShape* childshape =
-              new btSphereShape(static_cast<btScalar>(std::sqrt(2 * ((size / 2) * (size / 2)))));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geom_trans, childshape);
-        }
+        childshape = new btSphereShape(static_cast<btScalar>(std::sqrt(2 * ((size / 2) * (size / 2)))));
       }
-      return subshape;
-    }
-    default:
-    {
-      RCLCPP_ERROR(BULLET_LOGGER, "This bullet shape type (%d) is not supported for geometry octree",
-                   static_cast<int>(collision_object_type));
-      return nullptr;
+      childshape->setMargin(BULLET_MARGIN);
+      cow->manage(childshape);
+      cell_shapes[depth] = childshape;
     }
+
+    const octomap::point3d center = octree.keyToCoord(region.first, depth);
+    btTransform geom_trans;
+    geom_trans.setIdentity();
+    geom_trans.setOrigin(btVector3(static_cast<btScalar>(center.x()), static_cast<btScalar>(center.y()),
+                                   static_cast<btScalar>(center.z())));
+    subshape->addChildShape(geom_trans, cell_shapes[depth]);
   }
+  return subshape;
 }
 
 void updateCollisionObjectFilters(const std::vector<std::string>& active, CollisionObjectWrapper& cow)
@@ -402,31 +451,45 @@ void addCollisionObjectToBroadphase(const CollisionObjectWrapperPtr& cow,
 btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
                                        const CollisionObjectType& collision_object_type, CollisionObjectWrapper* cow)
 {
+  btCollisionShape* shape = nullptr;
   switch (geom->type)
   {
     case shapes::BOX:
     {
-      return createShapePrimitive(static_cast<const shapes::Box*>(geom.get()), collision_object_type);
+      shape = createShapePrimitive(static_cast<const shapes::Box*>(geom.get()), collision_object_type);
+      break;
     }
     case shapes::SPHERE:
     {
-      return createShapePrimitive(static_cast<const shapes::Sphere*>(geom.get()), collision_object_type);
+      shape = createShapePrimitive(static_cast<const shapes::Sphere*>(geom.get()), collision_object_type);
+      break;
     }
     case shapes::CYLINDER:
     {
-      return createShapePrimitive(static_cast<const shapes::Cylinder*>(geom.get()), collision_object_type);
+      shape = createShapePrimitive(static_cast<const shapes::Cylinder*>(geom.get()), collision_object_type);
+      break;
     }
     case shapes::CONE:
     {
-      return createShapePrimitive(static_cast<const shapes::Cone*>(geom.get()), collision_object_type);
+      shape = createShapePrimitive(static_cast<const shapes::Cone*>(geom.get()), collision_object_type);
+      break;
     }
     case shapes::MESH:
     {
-      return createShapePrimitive(static_cast<const shapes::Mesh*>(geom.get()), collision_object_type, cow);
+      // objects with identical meshes share a single collision shape
+      auto create = [&collision_object_type](const shapes::Mesh& mesh) {
+        return createShapePrimitive(&mesh, collision_object_type);
+      };
+      const auto mesh = std::static_pointer_cast<const shapes::Mesh>(geom);
+      std::shared_ptr<btCollisionShape> mesh_shape = getMeshShapeCache(collision_object_type).getOrCreate(mesh, create);
+      if (mesh_shape)
+        cow->manage(mesh_shape);
+      return mesh_shape.get();
     }
     case shapes::OCTREE:
     {
-      return createShapePrimitive(static_cast<const shapes::OcTree*>(geom.get()), collision_object_type, cow);
+      shape = createShapePrimitive(static_cast<const shapes::OcTree*>(geom.get()), collision_object_type, cow);
+      break;
     }
     default:
     {
@@ -435,6 +498,9 @@ btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
       return nullptr;
     }
   }
+  if (shape)
+    cow->manage(shape);
+  return shape;
 }
 
 bool BroadphaseFilterCallback::needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const
@@ -508,6 +574,7 @@ bool TesseractCollisionPairCallback::processOverlap(btBroadphasePair& pair)
   {
     return false;
   }
+  results_callback_.collisions_.res.broadphase_pairs++;
 
   const CollisionObjectWrapper* cow0 = static_cast<const CollisionObjectWrapper*>(pair.m_pProxy0->m_clientObject);
   const CollisionObjectWrapper* cow1 = static_cast<const CollisionObjectWrapper*>(pair.m_pProxy1->m_clientObject);
@@ -515,6 +582,7 @@ bool TesseractCollisionPairCallback::processOverlap(btBroadphasePair& pair)
   std::pair<std::string, std::string> pair_names{ cow0->getName(), cow1->getName() };
   if (results_callback_.needsCollision(cow0, cow1))
   {
+    results_callback_.collisions_.res.narrowphase_tests++;
     RCLCPP_DEBUG_STREAM(BULLET_LOGGER, "Processing " << cow0->getName() << " vs " << cow1->getName());
     btCollisionObjectWrapper obj0_wrap(nullptr, cow0->getCollisionShape(), cow0, cow0->getWorldTransform(), -1, -1);
     btCollisionObjectWrapper obj1_wrap(nullptr, cow1->getCollisionShape(), cow1, cow1->getWorldTransform(), -1, -1);
@@ -577,7 +645,6 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name, const co
   {
     btCollisionShape* shape = createShapePrimitive(shapes_[0], collision_object_types[0], this);
     shape->setMargin(BULLET_MARGIN);
-    manage(shape);
     setCollisionShape(shape);
     setWorldTransform(convertEigenToBt(shape_poses_[0]));
   }
@@ -597,7 +664,6 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name, const co
       btCollisionShape* subshape = createShapePrimitive(shapes_[j], collision_object_types[j], this);
       if (subshape != nullptr)
       {
-        manage(subshape);
         subshape->setMargin(BULLET_MARGIN);
         btTransform geom_trans = convertEigenToBt(inv_world * shape_poses_[j]);
         compound->addChildShape(geom_trans, subshape);
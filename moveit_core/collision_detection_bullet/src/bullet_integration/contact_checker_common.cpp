@@ -52,6 +52,10 @@ collision_detection::Contact* processResult(ContactTestData& cdata, collision_de
     {
       cdata.res.distance = contact.depth;
     }
+    if (contact.depth < cdata.req.distance_stop_threshold)
+    {
+      cdata.done = true;
+    }
   }
 
   RCLCPP_DEBUG_STREAM(BULLET_LOGGER, "Contact btw " << key.first << " and " << key.second << " dist: " << contact.depth);
@@ -38,7 +38,9 @@
 #include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
 #include <moveit/collision_detection_bullet/bullet_integration/ros_bullet_utils.h>
 #include <moveit/collision_detection_bullet/bullet_integration/contact_checker_common.h>
+#include <algorithm>
 #include <functional>
+#include <utility>
 #include <bullet/btBulletCollisionCommon.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
@@ -49,6 +51,41 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.core.collision_d
 const std::string CollisionDetectorAllocatorBullet::NAME("Bullet");
 const double MAX_DISTANCE_MARGIN = 99;
 
+namespace
+{
+bool equalPoses(const EigenSTL::vector_Isometry3d& poses1, const EigenSTL::vector_Isometry3d& poses2)
+{
+  if (poses1.size() != poses2.size())
+    return false;
+  for (std::size_t i = 0; i < poses1.size(); ++i)
+  {
+    if (poses1[i].matrix() != poses2[i].matrix())
+      return false;
+  }
+  return true;
+}
+
+/** \brief Estimate the memory of \e shape and the shapes it is composed of */
+std::size_t estimateShapeMemoryUsage(const btCollisionShape& shape)
+{
+  if (shape.isCompound())
+  {
+    const auto& compound = static_cast<const btCompoundShape&>(shape);
+    std::size_t bytes =
+        sizeof(btCompoundShape) + static_cast<std::size_t>(compound.getNumChildShapes()) * sizeof(btCompoundShapeChild);
+    for (int i = 0; i < compound.getNumChildShapes(); ++i)
+      bytes += estimateShapeMemoryUsage(*compound.getChildShape(i));
+    return bytes;
+  }
+  if (shape.getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+  {
+    return sizeof(btConvexHullShape) +
+           static_cast<std::size_t>(static_cast<const btConvexHullShape&>(shape).getNumPoints()) * sizeof(btVector3);
+  }
+  return sizeof(btConvexInternalShape);
+}
+}  // namespace
+
 CollisionEnvBullet::CollisionEnvBullet(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
   : CollisionEnv(model, padding, scale)
 {
@@ -116,35 +153,7 @@ void CollisionEnvBullet::checkSelfCollisionHelper(const CollisionRequest& req, C
                                                   const moveit::core::RobotState& state,
                                                   const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
-
-  std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> cows;
-  addAttachedOjects(state, cows);
-
-  if (req.distance)
-  {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
-  }
-
-  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
-  {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
-        cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
-  }
-
-  // updating link positions with the current robot state
-  for (const std::string& link : active_)
-  {
-    manager_->setCollisionObjectsTransform(link, state.getCollisionBodyTransform(link, 0));
-  }
-
-  manager_->contactTest(res, req, acm, true);
-
-  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
-  {
-    manager_->removeCollisionObject(cow->getName());
-  }
+  contactTestDiscrete(req, res, state, acm, true);
 }
 
 void CollisionEnvBullet::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
@@ -179,30 +188,58 @@ void CollisionEnvBullet::checkRobotCollisionHelper(const CollisionRequest& req,
                                                    const moveit::core::RobotState& state,
                                                    const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  contactTestDiscrete(req, res, state, acm, false);
+}
+
+void CollisionEnvBullet::contactTestDiscrete(const CollisionRequest& req, CollisionResult& res,
+                                             const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                             bool self) const
+{
+  QueryRecorder<CollisionResult> recorder(*this, res);
+  std::unique_ptr<DiscreteContext> context = acquireDiscreteContext();
+  const collision_detection_bullet::BulletDiscreteBVHManagerPtr& manager = context->manager_;
 
   if (req.distance)
   {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
+    // objects farther apart than the threshold are pruned by the broadphase
+    const double contact_distance = std::min(MAX_DISTANCE_MARGIN, req.distance_threshold);
+    if (manager->getContactDistanceThreshold() != contact_distance)
+      manager->setContactDistanceThreshold(contact_distance);
   }
 
-  std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
-  addAttachedOjects(state, attached_cows);
-  updateTransformsFromState(state, manager_);
+  updateAttachedObjects(*context, state);
+  updateTransformsFromState(state, manager);
 
-  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
+  manager->contactTest(res, req, acm, self);
+  releaseDiscreteContext(std::move(context));
+}
+
+std::unique_ptr<CollisionEnvBullet::DiscreteContext> CollisionEnvBullet::acquireDiscreteContext() const
+{
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  if (!idle_contexts_.empty())
   {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
-        cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
+    std::unique_ptr<DiscreteContext> context = std::move(idle_contexts_.back());
+    idle_contexts_.pop_back();
+    return context;
   }
+  auto context = std::make_unique<DiscreteContext>();
+  context->manager_ = manager_->clone();
+  context->version_ = geometry_version_;
+  return context;
+}
 
-  manager_->contactTest(res, req, acm, false);
+void CollisionEnvBullet::releaseDiscreteContext(std::unique_ptr<DiscreteContext> context) const
+{
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  if (context->version_ == geometry_version_)
+    idle_contexts_.push_back(std::move(context));
+}
 
-  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
-  {
-    manager_->removeCollisionObject(cow->getName());
-  }
+void CollisionEnvBullet::invalidateDiscreteContexts()
+{
+  ++geometry_version_;
+  idle_contexts_.clear();
 }
 
 void CollisionEnvBullet::checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
@@ -211,6 +248,7 @@ void CollisionEnvBullet::checkRobotCollisionHelperCCD(const CollisionRequest& re
                                                       const AllowedCollisionMatrix* acm) const
 {
   std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  QueryRecorder<CollisionResult> recorder(*this, res);
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
   addAttachedOjects(state1, attached_cows);
@@ -317,9 +355,22 @@ void CollisionEnvBullet::setWorld(const WorldPtr& world)
   getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
 }
 
+void CollisionEnvBullet::getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& usage) const
+{
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  // the continuous manager and the per-thread clones share the shapes of the discrete manager
+  for (const auto& [name, cow] : manager_->getCollisionObjects())
+  {
+    if (cow->getCollisionShape())
+      usage[name] += estimateShapeMemoryUsage(*cow->getCollisionShape());
+  }
+}
+
 void CollisionEnvBullet::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
   std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  invalidateDiscreteContexts();
+
   if (action == World::DESTROY)
   {
     manager_->removeCollisionObject(obj->id_);
@@ -339,28 +390,83 @@ void CollisionEnvBullet::addAttachedOjects(const moveit::core::RobotState& state
 
   for (const moveit::core::AttachedBody*& body : attached_bodies)
   {
-    const EigenSTL::vector_Isometry3d& attached_body_transform = body->getGlobalCollisionBodyTransforms();
+    if (collision_detection_bullet::CollisionObjectWrapperPtr cow = createAttachedObject(*body))
+      cows.push_back(cow);
+  }
+}
 
-    std::vector<collision_detection_bullet::CollisionObjectType> collision_object_types(
-        attached_body_transform.size(), collision_detection_bullet::CollisionObjectType::USE_SHAPE_TYPE);
+collision_detection_bullet::CollisionObjectWrapperPtr
+CollisionEnvBullet::createAttachedObject(const moveit::core::AttachedBody& body) const
+{
+  const EigenSTL::vector_Isometry3d& attached_body_transform = body.getGlobalCollisionBodyTransforms();
 
-    try
+  std::vector<collision_detection_bullet::CollisionObjectType> collision_object_types(
+      attached_body_transform.size(), collision_detection_bullet::CollisionObjectType::USE_SHAPE_TYPE);
+
+  try
+  {
+    return std::make_shared<collision_detection_bullet::CollisionObjectWrapper>(
+        body.getName(), collision_detection::BodyType::ROBOT_ATTACHED, body.getShapes(), attached_body_transform,
+        collision_object_types, body.getTouchLinks());
+  }
+  catch (std::exception&)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Not adding " << body.getName() << " due to bad arguments.");
+    return nullptr;
+  }
+}
+
+void CollisionEnvBullet::updateAttachedObjects(DiscreteContext& context, const moveit::core::RobotState& state) const
+{
+  std::map<std::string, AttachedObject>& attached_objects = context.attached_objects_;
+  for (auto it = attached_objects.begin(); it != attached_objects.end();)
+  {
+    if (state.hasAttachedBody(it->first))
     {
-      collision_detection_bullet::CollisionObjectWrapperPtr cow =
-          std::make_shared<collision_detection_bullet::CollisionObjectWrapper>(
-              body->getName(), collision_detection::BodyType::ROBOT_ATTACHED, body->getShapes(),
-              attached_body_transform, collision_object_types, body->getTouchLinks());
-      cows.push_back(cow);
+      ++it;
+      continue;
     }
-    catch (std::exception&)
+    context.manager_->removeCollisionObject(it->first);
+    it = attached_objects.erase(it);
+  }
+
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  state.getAttachedBodies(attached_bodies);
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    auto it = attached_objects.find(body->getName());
+    if (it == attached_objects.end() || it->second.shapes_ != body->getShapes() ||
+        !equalPoses(it->second.shape_poses_, body->getShapePoses()) || it->second.touch_links_ != body->getTouchLinks())
     {
-      RCLCPP_ERROR_STREAM(LOGGER, "Not adding " << body->getName() << " due to bad arguments.");
+      // (re-)build the collision object. The shapes are kept, so that their addresses identify them.
+      removeAttachedObject(context, body->getName());
+      collision_detection_bullet::CollisionObjectWrapperPtr cow = createAttachedObject(*body);
+      if (!cow)
+        continue;
+      context.manager_->addCollisionObject(cow);
+      it = attached_objects
+               .emplace(body->getName(),
+                        AttachedObject{ body->getShapes(), body->getShapePoses(), body->getTouchLinks(), cow })
+               .first;
     }
+    context.manager_->setCollisionObjectsTransform(body->getName(), body->getGlobalCollisionBodyTransforms()[0]);
+  }
+}
+
+void CollisionEnvBullet::removeAttachedObject(DiscreteContext& context, const std::string& name) const
+{
+  const auto it = context.attached_objects_.find(name);
+  if (it != context.attached_objects_.end())
+  {
+    context.manager_->removeCollisionObject(name);
+    context.attached_objects_.erase(it);
   }
 }
 
 void CollisionEnvBullet::updatedPaddingOrScaling(const std::vector<std::string>& links)
 {
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  invalidateDiscreteContexts();
   for (const std::string& link : links)
   {
     if (robot_model_->getURDF()->links_.find(link) != robot_model_->getURDF()->links_.end())
@@ -50,6 +50,10 @@
 
 #include <urdf_parser/urdf_parser.h>
 #include <geometric_shapes/shape_operations.h>
+#include <octomap/octomap.h>
+
+#include <atomic>
+#include <thread>
 
 namespace cb = collision_detection_bullet;
 
@@ -323,6 +327,63 @@ TEST_F(BulletCollisionDetectionTester, ContinuousCollisionWorld)
   res.clear();
 }
 
+TEST_F(BulletCollisionDetectionTester, ConcurrentDiscreteChecks)
+{
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+
+  moveit::core::RobotState state1(robot_model_);
+  setToHome(state1);
+
+  moveit::core::RobotState state2(robot_model_);
+  setToHome(state2);
+  double joint_2{ 0.05 };
+  state2.setJointPositions("panda_joint2", &joint_2);
+  state2.update();
+
+  // a box at the hand of the home state that the second state moves away from
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  cenv_->getWorld()->addToObject("box", shape_ptr, state1.getGlobalLinkTransform("panda_hand"));
+
+  const std::vector<const moveit::core::RobotState*> states{ &state1, &state2 };
+  std::vector<bool> expected;
+  for (const moveit::core::RobotState* state : states)
+  {
+    collision_detection::CollisionResult res;
+    cenv_->checkRobotCollision(req, res, *state, *acm_);
+    expected.push_back(res.collision);
+  }
+  ASSERT_TRUE(expected[0]);
+  ASSERT_FALSE(expected[1]);
+
+  // threads checking concurrently see the same results as sequential checks
+  std::atomic<unsigned int> mismatches{ 0 };
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      for (std::size_t i = 0; i < 50; ++i)
+      {
+        const std::size_t index = (i + t) % states.size();
+        collision_detection::CollisionResult res;
+        cenv_->checkRobotCollision(req, res, *states[index], *acm_);
+        if (res.collision != expected[index])
+          ++mismatches;
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(mismatches, 0u);
+
+  // checks after a world change use the changed geometry
+  cenv_->getWorld()->removeObject("box");
+  collision_detection::CollisionResult res;
+  cenv_->checkRobotCollision(req, res, state1, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
 TEST(ContinuousCollisionUnit, BulletCastBVHCollisionBoxBoxUnit)
 {
   collision_detection::CollisionResult result;
@@ -362,6 +423,35 @@ TEST(ContinuousCollisionUnit, BulletCastMeshVsBox)
   ASSERT_TRUE(result.collision);
 }
 
+TEST(BulletOctreeUnit, MergeOccupiedSubtrees)
+{
+  auto octree = std::make_shared<octomap::OcTree>(0.1);
+  for (double x : { 0.05, 0.15 })
+  {
+    for (double y : { 0.05, 0.15 })
+    {
+      for (double z : { 0.05, 0.15 })
+        octree->updateNode(octomap::point3d(x, y, z), true);
+    }
+  }
+  // different occupancy values keep octomap from pruning the eight cells itself
+  octree->updateNode(octomap::point3d(0.05, 0.05, 0.05), true);
+  octree->updateNode(octomap::point3d(1.05, 1.05, 1.05), true);
+  octree->updateNode(octomap::point3d(1.15, 1.05, 1.05), false);
+
+  std::vector<shapes::ShapeConstPtr> shapes{ std::make_shared<const shapes::OcTree>(octree) };
+  cb::AlignedVector<Eigen::Isometry3d> poses{ Eigen::Isometry3d::Identity() };
+  std::vector<cb::CollisionObjectType> types{ cb::CollisionObjectType::USE_SHAPE_TYPE };
+  cb::CollisionObjectWrapper cow("octomap", collision_detection::BodyType::WORLD_OBJECT, shapes, poses, types, false);
+
+  const btCompoundShape* compound = static_cast<const btCompoundShape*>(cow.getCollisionShape());
+  ASSERT_EQ(compound->getNumChildShapes(), 2);
+  // the eight cells are represented by their parent, the free cell is skipped
+  const btBoxShape* box = static_cast<const btBoxShape*>(compound->getChildShape(0));
+  EXPECT_NEAR(box->getHalfExtentsWithoutMargin().x(), 0.1, 1e-5);
+  EXPECT_NEAR(compound->getChildTransform(0).getOrigin().x(), 0.1, 1e-5);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
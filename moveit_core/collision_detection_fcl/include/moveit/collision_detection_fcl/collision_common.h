@@ -52,8 +52,11 @@
 #include <fcl/distance.h>
 #endif
 
+#include <limits>
 #include <memory>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace collision_detection
 {
@@ -137,15 +140,71 @@ struct CollisionGeometryData
   } ptr;
 };
 
+MOVEIT_STRUCT_FORWARD(FCLAllowedCollisionMatrix);
+
+/** \brief An allowed collision matrix compiled for the links of a robot model and the objects of a world.
+ *
+ *  The links are indexed by their link index, followed by the world objects. Attached bodies have no index, so pairs
+ *  involving them are looked up in the original allowed collision matrix. */
+struct FCLAllowedCollisionMatrix
+{
+  FCLAllowedCollisionMatrix(const AllowedCollisionMatrix& acm, const moveit::core::RobotModel& robot_model,
+                            const World& world);
+
+  /** \brief Return the index of the body with the geometry \e cd, or NO_INDEX if it has none */
+  std::size_t getIndex(const CollisionGeometryData& cd) const
+  {
+    if (cd.type == BodyTypes::ROBOT_LINK)
+      return cd.ptr.link->getLinkIndex();
+    if (cd.type == BodyTypes::WORLD_OBJECT)
+    {
+      const auto it = object_indices_.find(cd.ptr.obj);
+      if (it != object_indices_.end())
+        return it->second;
+    }
+    return NO_INDEX;
+  }
+
+  static constexpr std::size_t NO_INDEX = std::numeric_limits<std::size_t>::max();
+
+  /** \brief The allowed collision matrix compiled for all links and objects */
+  CompiledAllowedCollisionMatrix matrix_;
+
+  /** \brief Index of each world object in \e matrix_ */
+  std::unordered_map<const World::Object*, std::size_t> object_indices_;
+};
+
+/** \brief Look up the allowed collision type of two geometries in \e acm, or in \e compiled if it is given and
+ *  indexes both of them.
+ *
+ *  \param fn If not nullptr, the predicate of a conditional entry is copied here */
+bool getAllowedCollision(const AllowedCollisionMatrix& acm, const FCLAllowedCollisionMatrix* compiled,
+                         const CollisionGeometryData& cd1, const CollisionGeometryData& cd2,
+                         AllowedCollision::Type& allowed_collision, DecideContactFn* fn);
+
 /** \brief Data structure which is passed to the collision callback function of the collision manager. */
 struct CollisionData
 {
-  CollisionData() : req_(nullptr), active_components_only_(nullptr), res_(nullptr), acm_(nullptr), done_(false)
+  CollisionData()
+    : req_(nullptr)
+    , active_components_only_(nullptr)
+    , res_(nullptr)
+    , acm_(nullptr)
+    , compiled_acm_(nullptr)
+    , skipped_link_pairs_(nullptr)
+    , done_(false)
   {
   }
 
-  CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm)
-    : req_(req), active_components_only_(nullptr), res_(res), acm_(acm), done_(false)
+  CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm,
+                const FCLAllowedCollisionMatrix* compiled_acm = nullptr)
+    : req_(req)
+    , active_components_only_(nullptr)
+    , res_(res)
+    , acm_(acm)
+    , compiled_acm_(compiled_acm)
+    , skipped_link_pairs_(nullptr)
+    , done_(false)
   {
   }
 
@@ -171,6 +230,14 @@ struct CollisionData
   /** \brief The user-specified collision matrix (may be nullptr). */
   const AllowedCollisionMatrix* acm_;
 
+  /** \brief \e acm_ compiled for the checked robot and world (may be nullptr). */
+  const FCLAllowedCollisionMatrix* compiled_acm_;
+
+  /** \brief Symmetric matrix over the link indices of the link pairs that don't need to be checked (may be nullptr).
+   *
+   *  Self-collision checks for a group set it to the rigidly connected link pairs that are known to be apart. */
+  const std::vector<std::vector<bool>>* skipped_link_pairs_;
+
   /** \brief Flag indicating whether collision checking is complete. */
   bool done_;
 };
@@ -178,7 +245,8 @@ struct CollisionData
 /** \brief Data structure which is passed to the distance callback function of the collision manager. */
 struct DistanceData
 {
-  DistanceData(const DistanceRequest* req, DistanceResult* res) : req(req), res(res), done(false)
+  DistanceData(const DistanceRequest* req, DistanceResult* res, const FCLAllowedCollisionMatrix* compiled_acm = nullptr)
+    : req(req), res(res), compiled_acm(compiled_acm), done(false)
   {
   }
   ~DistanceData()
@@ -191,6 +259,9 @@ struct DistanceData
   /** \brief Distance query results information. */
   DistanceResult* res;
 
+  /** \brief The collision matrix of \e req compiled for the checked robot and world (may be nullptr). */
+  const FCLAllowedCollisionMatrix* compiled_acm;
+
   /** \brief Indicates if distance query is finished. */
   bool done;
 };
@@ -247,6 +318,10 @@ struct FCLGeometry
 
   /** \brief Pointer to the user-defined geometry data. */
   CollisionGeometryDataPtr collision_geometry_data_;
+
+  /** \brief Geometry that \e collision_geometry_ was copied from, if any. Keeping it alive lets geometry for identical
+   *  meshes be copied instead of built again. */
+  std::shared_ptr<const fcl::CollisionGeometryd> source_geometry_;
 };
 
 typedef std::shared_ptr<fcl::CollisionObjectd> FCLCollisionObjectPtr;
@@ -319,6 +394,10 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
 /** \brief Increases the counter of the caches which can trigger the cleaning of expired entries from them. */
 void cleanCollisionGeometryCache();
 
+/** \brief Estimate the memory, in bytes, of the bounding volume hierarchy or shape held by \e geometry. Octrees are
+ *  counted without the octomap they reference. */
+std::size_t estimateCollisionGeometryMemoryUsage(const FCLGeometry& geometry);
+
 /** \brief Transforms an Eigen Isometry3d to FCL coordinate transformation */
 inline void transform2fcl(const Eigen::Isometry3d& b, fcl::Transform3d& f)
 {
@@ -49,5 +49,10 @@ class MOVEIT_COLLISION_DETECTION_FCL_EXPORT CollisionDetectorAllocatorFCL
 {
 public:
   static const std::string NAME;  // defined in collision_env_fcl.cpp
+
+  CollisionEnvPtr allocateOverlayEnv(const CollisionEnvConstPtr& parent, const WorldPtr& world) const override
+  {
+    return std::make_shared<CollisionEnvFCL>(std::dynamic_pointer_cast<const CollisionEnvFCL>(parent), world);
+  }
 };
 }  // namespace collision_detection
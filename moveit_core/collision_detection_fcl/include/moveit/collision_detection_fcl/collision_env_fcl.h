@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/collision_detection/collision_env.h>
+#include <moveit/collision_detection/rigid_link_pairs.h>
 #include <moveit/collision_detection_fcl/collision_common.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
@@ -45,7 +46,12 @@
 #include <fcl/broadphase/broadphase.h>
 #endif
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 
 namespace collision_detection
 {
@@ -62,6 +68,14 @@ public:
 
   CollisionEnvFCL(const CollisionEnvFCL& other, const WorldPtr& world);
 
+  /** \brief Construct an overlay of \e parent for \e world, which must be an unmodified copy of the world of \e parent.
+   *
+   *  Unlike the copy constructor, the overlay does not register the objects of \e parent to a broadphase of its own.
+   *  World queries check the objects of \e parent in its broadphase, except those that were changed or removed in
+   *  \e world, which are checked in the broadphase of the overlay along with the added objects. Construction is thus
+   *  independent of the number of world objects, but \e parent must not be modified while the overlay exists. */
+  CollisionEnvFCL(const std::shared_ptr<const CollisionEnvFCL>& parent, const WorldPtr& world);
+
   ~CollisionEnvFCL() override;
 
   void checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
@@ -90,6 +104,26 @@ public:
 
   void setWorld(const WorldPtr& world) override;
 
+  void getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& usage) const override;
+
+  /** \brief Cache the results of up to \e size recent robot-world collision checks. A size of 0 disables the cache,
+   *   which is the default.
+   *
+   *   Only checks that ask for nothing but the collision flag are cached, i.e. without contacts, cost sources,
+   *   distance, \e is_done or verbose output. States match if their variable positions are equal after rounding to
+   *   multiples of \e resolution. Cached results are dropped when a world object they depend on changes: a result in
+   *   collision depends on the object in collision, a collision-free result on the objects overlapping the AABB of the
+   *   robot in the checked state. */
+  void setRobotCollisionCacheSize(std::size_t size, double resolution = 1e-6);
+
+  std::size_t getRobotCollisionCacheSize() const
+  {
+    return robot_collision_cache_size_;
+  }
+
+  /** \brief Drop all cached robot-world collision results */
+  void clearRobotCollisionCache();
+
 protected:
   /** \brief Updates the FCL collision geometry and objects saved in the CollisionRobotFCL members to reflect a new
    *   padding or scaling of the robot links.
@@ -108,6 +142,15 @@ protected:
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                  const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
 
+  /** \brief Bundles the continuous checkRobotCollision functions into a single function
+   *
+   *   Every robot object is swept from its pose in \e state1 to its pose in \e state2. The world objects overlapping
+   *   the AABB of the swept volume are checked with FCL's continuous collision, and contacts are reported at the first
+   *   time of contact, with Contact::percent_interpolation set accordingly. */
+  void checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                    const moveit::core::RobotState& state1, const moveit::core::RobotState& state2,
+                                    const AllowedCollisionMatrix* acm) const;
+
   /** \brief Construct an FCL collision object from MoveIt's World::Object. */
   void constructFCLObjectWorld(const World::Object* obj, FCLObject& fcl_obj) const;
 
@@ -130,6 +173,33 @@ protected:
    *   state and specifying a broadphase collision manager of FCL where the constructed object is registered to. */
   void allocSelfCollisionBroadPhase(const moveit::core::RobotState& state, FCLManager& manager) const;
 
+  /** \brief Broadphase manager for self collision checks, which persists between checks.
+   *
+   *  The robot's link objects stay registered to the manager and are only moved to the new link transforms of each
+   *  checked state, followed by an in-place update of the manager. Attached bodies are registered for the duration
+   *  of a single check only. */
+  struct SelfCollisionBroadPhase
+  {
+    std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
+
+    /** \brief Copies of \m robot_fcl_objs_ owned by this broadphase, registered to \m manager_ */
+    std::vector<FCLCollisionObjectPtr> robot_objects_;
+
+    /** \brief Objects of the attached bodies of the currently checked state */
+    FCLObject attached_objects_;
+
+    /** \brief Value of \m robot_geometry_version_ that \m robot_objects_ were created from */
+    std::size_t robot_geometry_version_ = 0;
+  };
+
+  /** \brief Take an idle self collision broadphase, or create one, updated to the transforms of \e state.
+   *   releaseSelfCollisionBroadPhase() needs to be called once the check is done. */
+  std::unique_ptr<SelfCollisionBroadPhase> acquireSelfCollisionBroadPhase(const moveit::core::RobotState& state) const;
+
+  /** \brief Remove the attached bodies registered by acquireSelfCollisionBroadPhase() and return \e broadphase to
+   *   the idle ones */
+  void releaseSelfCollisionBroadPhase(std::unique_ptr<SelfCollisionBroadPhase> broadphase) const;
+
   /** \brief Converts all shapes which make up an attached body into a vector of FCLGeometryConstPtr.
    *
    *   When they are converted, they can be added to the FCL representation of the robot for collision checking.
@@ -150,7 +220,121 @@ protected:
 
   std::map<std::string, FCLObject> fcl_objs_;
 
+  /** \brief The environment whose world objects this one overlays, or nullptr if \m manager_ holds all objects */
+  std::shared_ptr<const CollisionEnvFCL> overlay_parent_;
+
+  /** \brief Objects of \m overlay_parent_ that were changed or removed in this world, and are skipped in its manager */
+  std::set<std::string> hidden_parent_objects_;
+
+  /** \brief Incremented whenever \m robot_fcl_objs_ change, so that persistent broadphases get rebuilt */
+  std::size_t robot_geometry_version_ = 0;
+
+  /** \brief Idle self collision broadphases, one is taken by every running self collision check. At most one per
+   *   hardware thread is kept, so this does not grow with the number of threads that ever performed a check. */
+  mutable std::vector<std::unique_ptr<SelfCollisionBroadPhase>> self_collision_broadphases_;
+  mutable std::mutex self_collision_broadphases_mutex_;
+
+  /** \brief Get \e acm compiled for the robot model and the current world, or nullptr if \e acm is nullptr.
+   *
+   *  The most recently compiled matrix is reused as long as neither \e acm nor the world changed. */
+  FCLAllowedCollisionMatrixConstPtr getCompiledACM(const AllowedCollisionMatrix* acm) const;
+
+  /** \brief Drop the compiled collision matrix, e.g. because the objects it refers to changed */
+  void resetCompiledACM();
+
+  /** \brief Get the link pairs that a self-collision check of \e state for \e group can skip, or nullptr if there are
+   *   none. These are the pairs of getRigidLinkPairs() that are apart in \e state.
+   *
+   *  The result only depends on the frozen variables of the group, so it is reused for the few most recent values. */
+  std::shared_ptr<const std::vector<std::vector<bool>>>
+  getSkippedLinkPairs(const moveit::core::JointModelGroup* group, const moveit::core::RobotState& state) const;
+
+  struct SkippedLinkPairs
+  {
+    const moveit::core::JointModelGroup* group;
+    std::vector<double> frozen_values;
+    /** \brief Value of \m robot_geometry_version_ the pairs were checked with */
+    std::size_t robot_geometry_version;
+    std::shared_ptr<const std::vector<std::vector<bool>>> skipped;
+  };
+
+  /** \brief Rigid link pairs of each group that was checked, computed on first use */
+  mutable std::map<const moveit::core::JointModelGroup*, RigidLinkPairs> rigid_link_pairs_;
+  /** \brief The most recently used skipped link pairs first */
+  mutable std::vector<SkippedLinkPairs> skipped_link_pairs_;
+  mutable std::mutex skipped_link_pairs_mutex_;
+
+  mutable FCLAllowedCollisionMatrixConstPtr compiled_acm_;
+  mutable std::mutex compiled_acm_mutex_;
+
+  /** \brief Get the AABB of all world objects, including the objects of \m overlay_parent_ */
+  Eigen::AlignedBox3d getWorldAABB() const;
+
+  /** \brief Drop the cached AABB of the world objects */
+  void resetWorldAABB();
+
+  /** \brief Check if the robot in \e state may collide with any world object.
+   *
+   *  The AABBs of the bounding spheres of the robot bodies are tested against the AABB of all world objects, first
+   *  all of them together, then one by one. If this returns false, the robot can't collide with the world.
+   *  \param robot_aabb Set to the AABB of all bodies of the robot, which contains its collision geometry */
+  bool mayCollideWithWorld(const moveit::core::RobotState& state, Eigen::AlignedBox3d& robot_aabb) const;
+
+  mutable std::optional<Eigen::AlignedBox3d> world_aabb_;
+  mutable std::mutex world_aabb_mutex_;
+
+  /** \brief Everything a cached robot-world collision result was computed from, besides the world objects */
+  struct RobotCollisionCacheKey
+  {
+    /** \brief Rounded variable positions, followed by the rounded shape poses of the attached bodies */
+    std::vector<std::int64_t> values;
+    /** \brief Names and links of the attached bodies */
+    std::vector<std::string> attached_bodies;
+    /** \brief Shapes of the attached bodies */
+    std::vector<const shapes::Shape*> attached_shapes;
+    /** \brief The checked group, or nullptr for the complete robot */
+    const moveit::core::JointModelGroup* group = nullptr;
+    /** \brief Version of the allowed collision matrix, or 0 if there was none */
+    std::size_t acm_version = 0;
+    std::size_t hash = 0;
+
+    bool operator==(const RobotCollisionCacheKey& other) const;
+  };
+
+  struct RobotCollisionCacheEntry
+  {
+    RobotCollisionCacheKey key;
+    bool collision = false;
+    /** \brief For results in collision, the world object in collision */
+    std::string object_id;
+    /** \brief For collision-free results, the AABB of the robot in the checked state */
+    Eigen::AlignedBox3d robot_aabb;
+  };
+
+  /** \brief Build the cache key for checking \e state. Returns false if the query can't be cached. */
+  bool getRobotCollisionCacheKey(const CollisionRequest& req, const moveit::core::RobotState& state,
+                                 const AllowedCollisionMatrix* acm, RobotCollisionCacheKey& key) const;
+
+  /** \brief Look up the cached result for \e key. Returns false if there is none. */
+  bool lookupRobotCollisionCache(const RobotCollisionCacheKey& key, bool& collision) const;
+
+  /** \brief Store a result, replacing the oldest one if the cache is full */
+  void insertRobotCollisionCache(RobotCollisionCacheEntry&& entry) const;
+
+  /** \brief Drop the cached results that depend on the world object \e id, given its current FCL objects */
+  void invalidateRobotCollisionCache(const std::string& id);
+
+  std::size_t robot_collision_cache_size_ = 0;
+  double robot_collision_cache_resolution_ = 1e-6;
+  /** \brief Ring buffer of cached results, \m robot_collision_cache_next_ is the slot to be replaced next */
+  mutable std::vector<RobotCollisionCacheEntry> robot_collision_cache_;
+  mutable std::size_t robot_collision_cache_next_ = 0;
+  mutable std::mutex robot_collision_cache_mutex_;
+
 private:
+  /** \brief Construct \m robot_geoms_ and \m robot_fcl_objs_ for the collision geometry of all robot links */
+  void constructRobotGeometry();
+
   /** \brief Callback function executed for each change to the world environment */
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
 
@@ -37,6 +37,7 @@
 #include <moveit/collision_detection_fcl/collision_common.h>
 #include <geometric_shapes/shapes.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <moveit/collision_detection/mesh_geometry_cache.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 
@@ -49,20 +50,96 @@
 #include <fcl/octree.h>
 #endif
 
+#include <map>
 #include <memory>
 #include <type_traits>
 #include <mutex>
+#include <tuple>
 
 namespace collision_detection
 {
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_collision_detection_fcl.collision_common");
 
+static std::vector<std::string> getCompiledNames(const moveit::core::RobotModel& robot_model, const World& world)
+{
+  std::vector<std::string> names;
+  names.reserve(robot_model.getLinkModels().size() + world.size());
+  for (const moveit::core::LinkModel* link : robot_model.getLinkModels())
+    names.push_back(link->getName());
+  for (const auto& object : world)
+    names.push_back(object.first);
+  return names;
+}
+
+FCLAllowedCollisionMatrix::FCLAllowedCollisionMatrix(const AllowedCollisionMatrix& acm,
+                                                     const moveit::core::RobotModel& robot_model, const World& world)
+  : matrix_(acm, getCompiledNames(robot_model, world))
+{
+  std::size_t index = robot_model.getLinkModels().size();
+  for (const auto& object : world)
+    object_indices_[object.second.get()] = index++;
+}
+
+bool getAllowedCollision(const AllowedCollisionMatrix& acm, const FCLAllowedCollisionMatrix* compiled,
+                         const CollisionGeometryData& cd1, const CollisionGeometryData& cd2,
+                         AllowedCollision::Type& allowed_collision, DecideContactFn* fn)
+{
+  if (compiled)
+  {
+    const std::size_t i = compiled->getIndex(cd1);
+    const std::size_t j = compiled->getIndex(cd2);
+    if (i != FCLAllowedCollisionMatrix::NO_INDEX && j != FCLAllowedCollisionMatrix::NO_INDEX)
+    {
+      if (!compiled->matrix_.getAllowedCollision(i, j, allowed_collision))
+        return false;
+      if (fn && allowed_collision == AllowedCollision::CONDITIONAL)
+      {
+        if (const DecideContactFn* decide = compiled->matrix_.getAllowedContactFn(i, j))
+          *fn = *decide;
+      }
+      return true;
+    }
+  }
+
+  // attached bodies and objects that are not part of the compiled matrix
+  if (!acm.getAllowedCollision(cd1.getID(), cd2.getID(), allowed_collision))
+    return false;
+  if (fn && allowed_collision == AllowedCollision::CONDITIONAL)
+    acm.getAllowedCollision(cd1.getID(), cd2.getID(), *fn);
+  return true;
+}
+
+// Store a contact as flat contact, with the bodies of its pair in order and the normal pointing from the first body.
+// The ids need to be the ones kept by the bodies, as the pair refers to them.
+static void addFlatContact(CollisionResult& res, const std::string& id1, BodyType type1, const std::string& id2,
+                           BodyType type2, const Eigen::Vector3d& pos, const Eigen::Vector3d& normal, double depth)
+{
+  const bool swapped = id2 < id1;
+  const std::string* first = swapped ? &id2 : &id1;
+  const std::string* second = swapped ? &id1 : &id2;
+  const std::size_t pair_index = res.findContactPair(first, second);
+  if (pair_index == res.contact_pairs.size())
+    res.contact_pairs.push_back(ContactPair{ first, swapped ? type2 : type1, second, swapped ? type1 : type2, 0 });
+  ++res.contact_pairs[pair_index].contact_count;
+  res.flat_contacts.push_back(FlatContact{ pos, swapped ? Eigen::Vector3d(-normal) : normal, depth, pair_index });
+}
+
+static void addFlatContact(CollisionResult& res, const fcl::Contactd& fc)
+{
+  const CollisionGeometryData* cgd1 = static_cast<const CollisionGeometryData*>(fc.o1->getUserData());
+  const CollisionGeometryData* cgd2 = static_cast<const CollisionGeometryData*>(fc.o2->getUserData());
+  addFlatContact(res, cgd1->getID(), cgd1->type, cgd2->getID(), cgd2->type,
+                 Eigen::Vector3d(fc.pos[0], fc.pos[1], fc.pos[2]),
+                 Eigen::Vector3d(fc.normal[0], fc.normal[1], fc.normal[2]), fc.penetration_depth);
+}
+
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
 {
   CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
   if (cdata->done_)
     return true;
+  cdata->res_->broadphase_pairs++;
   const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
   const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
 
@@ -88,13 +165,18 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       return false;
   }
 
+  // links that move rigidly with respect to each other and are known to be apart
+  if (cdata->skipped_link_pairs_ && cd1->type == BodyTypes::ROBOT_LINK && cd2->type == BodyTypes::ROBOT_LINK &&
+      (*cdata->skipped_link_pairs_)[cd1->ptr.link->getLinkIndex()][cd2->ptr.link->getLinkIndex()])
+    return false;
+
   // use the collision matrix (if any) to avoid certain collision checks
   DecideContactFn dcf;
   bool always_allow_collision = false;
   if (cdata->acm_)
   {
     AllowedCollision::Type type;
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = getAllowedCollision(*cdata->acm_, cdata->compiled_acm_, *cd1, *cd2, type, &dcf);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -112,7 +194,6 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       }
       else if (type == AllowedCollision::CONDITIONAL)
       {
-        cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), dcf);
         if (cdata->req_->verbose)
         {
           RCLCPP_DEBUG(LOGGER, "Collision between '%s' and '%s' is conditionally allowed", cd1->getID().c_str(),
@@ -160,6 +241,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   if (always_allow_collision)
     return false;
 
+  cdata->res_->narrowphase_tests++;
   if (cdata->req_->verbose)
     RCLCPP_DEBUG(LOGGER, "Actually checking collisions between %s and %s", cd1->getID().c_str(), cd2->getID().c_str());
 
@@ -170,7 +252,15 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
     if (cdata->res_->contact_count < cdata->req_->max_contacts)
     {
       std::size_t have;
-      if (cd1->getID() < cd2->getID())
+      if (cdata->req_->flat_contacts)
+      {
+        const bool ordered = cd1->getID() < cd2->getID();
+        const std::size_t pair_index = cdata->res_->findContactPair(ordered ? &cd1->getID() : &cd2->getID(),
+                                                                    ordered ? &cd2->getID() : &cd1->getID());
+        const std::vector<ContactPair>& pairs = cdata->res_->contact_pairs;
+        have = pair_index < pairs.size() ? pairs[pair_index].contact_count : 0;
+      }
+      else if (cd1->getID() < cd2->getID())
       {
         std::pair<std::string, std::string> cp(cd1->getID(), cd2->getID());
         have = cdata->res_->contacts.find(cp) != cdata->res_->contacts.end() ? cdata->res_->contacts[cp].size() : 0;
@@ -222,7 +312,10 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
           if (want_contact_count > 0)
           {
             --want_contact_count;
-            cdata->res_->contacts[pc].push_back(c);
+            if (cdata->req_->flat_contacts)
+              addFlatContact(*cdata->res_, col_result.getContact(i));
+            else
+              cdata->res_->contacts[pc].push_back(c);
             cdata->res_->contact_count++;
             if (cdata->req_->verbose)
             {
@@ -298,17 +391,25 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
                       cd2->getTypeString().c_str(), num_contacts);
         }
 
-        const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
-                                                            std::make_pair(cd1->getID(), cd2->getID()) :
-                                                            std::make_pair(cd2->getID(), cd1->getID());
         cdata->res_->collision = true;
-        for (int i = 0; i < num_contacts; ++i)
+        if (cdata->req_->flat_contacts)
         {
-          Contact c;
-          fcl2contact(col_result.getContact(i), c);
-          cdata->res_->contacts[pc].push_back(c);
-          cdata->res_->contact_count++;
+          for (int i = 0; i < num_contacts; ++i)
+            addFlatContact(*cdata->res_, col_result.getContact(i));
         }
+        else
+        {
+          const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
+                                                              std::make_pair(cd1->getID(), cd2->getID()) :
+                                                              std::make_pair(cd2->getID(), cd1->getID());
+          for (int i = 0; i < num_contacts; ++i)
+          {
+            Contact c;
+            fcl2contact(col_result.getContact(i), c);
+            cdata->res_->contacts[pc].push_back(c);
+          }
+        }
+        cdata->res_->contact_count += num_contacts;
       }
 
       if (enable_cost)
@@ -440,9 +541,19 @@ struct FCLShapeCache
   unsigned int clean_count_;
 };
 
-bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& /*min_dist*/)
+bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist)
 {
   DistanceData* cdata = reinterpret_cast<DistanceData*>(data);
+  cdata->res->broadphase_pairs++;
+
+  // The broadphase skips all pairs whose bounding boxes are farther apart than min_dist. Only distances below the
+  // threshold are of interest, and a global search needs nothing farther than the closest pair found so far.
+  // Overlapping bounding boxes have a distance of zero, so the bound must stay positive to keep them.
+  double bound = cdata->req->distance_threshold;
+  if (cdata->req->type == DistanceRequestType::GLOBAL)
+    bound = std::min(bound, cdata->res->minimum_distance.distance);
+  if (bound > 0.0 && bound < min_dist)
+    min_dist = bound;
 
   const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
   const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
@@ -476,7 +587,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   if (cdata->req->acm)
   {
     AllowedCollision::Type type;
-    bool found = cdata->req->acm->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = getAllowedCollision(*cdata->req->acm, cdata->compiled_acm, *cd1, *cd2, type, nullptr);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -538,7 +649,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   // GLOBAL search: for efficiency, distance_threshold starts at the smallest distance between any pairs found so far
   if (cdata->req->type == DistanceRequestType::GLOBAL)
   {
-    dist_threshold = cdata->res->minimum_distance.distance;
+    dist_threshold = std::min(dist_threshold, cdata->res->minimum_distance.distance);
   }
   // Check if a distance between this pair has been found yet. Decrease threshold_distance if so, to narrow the search
   else if (it != cdata->res->distances.end())
@@ -567,6 +678,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   {
     return false;
   }
+  cdata->res->narrowphase_tests++;
   double distance = fcl::distance(o1, o2, fcl::DistanceRequestd(cdata->req->enable_nearest_points), fcl_result);
 
   // Check if either object is already in the map. If not add it or if present
@@ -696,7 +808,8 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
       }
     }
 
-    if (!cdata->req->enable_signed_distance && cdata->res->collision)
+    if ((!cdata->req->enable_signed_distance && cdata->res->collision) ||
+        dist_result.distance < cdata->req->stop_threshold)
     {
       cdata->done = true;
     }
@@ -705,6 +818,39 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   return cdata->done;
 }
 
+/* Templated function to get the cache of BVHs built from meshes for each bounding volume type.
+ *
+ * In contrast to the per-thread shape caches, it is shared by all threads and all collision environments, as it is
+ * keyed by the content of the meshes. */
+template <typename BV>
+collision_detection::MeshGeometryCache<const fcl::BVHModel<BV>>& GetBVHCache()
+{
+  static collision_detection::MeshGeometryCache<const fcl::BVHModel<BV>> cache;
+  return cache;
+}
+
+/** \brief Build the bounding volume hierarchy of a mesh */
+template <typename BV>
+std::shared_ptr<const fcl::BVHModel<BV>> createBVH(const shapes::Mesh& mesh)
+{
+  auto g = std::make_shared<fcl::BVHModel<BV>>();
+  if (mesh.vertex_count > 0 && mesh.triangle_count > 0)
+  {
+    std::vector<fcl::Triangle> tri_indices(mesh.triangle_count);
+    for (unsigned int i = 0; i < mesh.triangle_count; ++i)
+      tri_indices[i] = fcl::Triangle(mesh.triangles[3 * i], mesh.triangles[3 * i + 1], mesh.triangles[3 * i + 2]);
+
+    std::vector<fcl::Vector3d> points(mesh.vertex_count);
+    for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+      points[i] = fcl::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]);
+
+    g->beginModel();
+    g->addSubModel(points, tri_indices);
+    g->endModel();
+  }
+  return g;
+}
+
 /* Templated function to get a different cache for each of the template arguments combinations.
  *
  * The returned cache is a quasi-singleton for each thread as it is created \e thread_local. */
@@ -830,6 +976,7 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
     }
 
   fcl::CollisionGeometryd* cg_g = nullptr;
+  std::shared_ptr<const fcl::BVHModel<BV>> source_bvh;
   // handle cases individually
   switch (shape->type)
   {
@@ -866,26 +1013,11 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
     break;
     case shapes::MESH:
     {
-      auto g = new fcl::BVHModel<BV>();
-      const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape.get());
-      if (mesh->vertex_count > 0 && mesh->triangle_count > 0)
-      {
-        std::vector<fcl::Triangle> tri_indices(mesh->triangle_count);
-        for (unsigned int i = 0; i < mesh->triangle_count; ++i)
-        {
-          tri_indices[i] =
-              fcl::Triangle(mesh->triangles[3 * i], mesh->triangles[3 * i + 1], mesh->triangles[3 * i + 2]);
-        }
-
-        std::vector<fcl::Vector3d> points(mesh->vertex_count);
-        for (unsigned int i = 0; i < mesh->vertex_count; ++i)
-          points[i] = fcl::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
-
-        g->beginModel();
-        g->addSubModel(points, tri_indices);
-        g->endModel();
-      }
-      cg_g = g;
+      // FCL stores the CollisionGeometryData in the geometry itself, so every object needs its own BVH. Copying the
+      // BVH built for a mesh with identical content is much cheaper than building it again, though.
+      source_bvh = GetBVHCache<BV>().getOrCreate(std::static_pointer_cast<const shapes::Mesh>(shape),
+                                                 [](const shapes::Mesh& mesh) { return createBVH<BV>(mesh); });
+      cg_g = new fcl::BVHModel<BV>(*source_bvh);
     }
     break;
     case shapes::OCTREE:
@@ -902,7 +1034,8 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   if (cg_g)
   {
     cg_g->computeLocalAABB();
-    FCLGeometryConstPtr res = std::make_shared<const FCLGeometry>(cg_g, data, shape_index);
+    auto res = std::make_shared<FCLGeometry>(cg_g, data, shape_index);
+    res->source_geometry_ = source_bvh;
     cache.map_[wptr] = res;
     cache.bumpUseCount();
     return res;
@@ -927,6 +1060,84 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   return createCollisionGeometry<fcl::OBBRSSd, World::Object>(shape, obj, 0);
 }
 
+/** \brief Scaled and padded collision geometry, shared by all threads and collision environments.
+ *
+ *  The geometry is keyed by the source shape, the body it belongs to, and the scale and padding. The store only keeps
+ *  weak references, so a geometry lives as long as any environment uses it. Environments that switch to a scale and
+ *  padding that another environment (e.g. another planning scene) already uses get the same geometry. */
+template <typename BV>
+class PaddedGeometryStore
+{
+public:
+  template <typename CreateFn>
+  FCLGeometryConstPtr getOrCreate(const shapes::ShapeConstPtr& shape, const void* data, int shape_index, double scale,
+                                  double padding, const CreateFn& create)
+  {
+    const Key key{ shape, data, shape_index, scale, padding };
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      const auto it = geometries_.find(key);
+      if (it != geometries_.end())
+      {
+        if (FCLGeometryConstPtr geometry = it->second.lock())
+          return geometry;
+      }
+    }
+
+    // building the geometry can take long for meshes, so it is done without holding the lock
+    FCLGeometryConstPtr geometry = create();
+    if (!geometry)
+      return geometry;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    std::weak_ptr<const FCLGeometry>& entry = geometries_[key];
+    if (FCLGeometryConstPtr existing = entry.lock())
+      return existing;  // built by another thread in the meantime
+    entry = geometry;
+
+    // drop the entries of released geometry once in a while
+    if (++insert_count_ % CLEAN_INTERVAL == 0)
+    {
+      for (auto it = geometries_.begin(); it != geometries_.end();)
+        it = it->second.expired() ? geometries_.erase(it) : std::next(it);
+    }
+    return geometry;
+  }
+
+private:
+  struct Key
+  {
+    shapes::ShapeConstWeakPtr shape;
+    const void* data;
+    int shape_index;
+    double scale;
+    double padding;
+
+    bool operator<(const Key& other) const
+    {
+      if (std::owner_less<shapes::ShapeConstWeakPtr>()(shape, other.shape))
+        return true;
+      if (std::owner_less<shapes::ShapeConstWeakPtr>()(other.shape, shape))
+        return false;
+      return std::tie(data, shape_index, scale, padding) <
+             std::tie(other.data, other.shape_index, other.scale, other.padding);
+    }
+  };
+
+  static constexpr std::size_t CLEAN_INTERVAL = 100;
+
+  std::map<Key, std::weak_ptr<const FCLGeometry>> geometries_;
+  std::size_t insert_count_ = 0;
+  std::mutex lock_;
+};
+
+template <typename BV>
+PaddedGeometryStore<BV>& GetPaddedGeometryStore()
+{
+  static PaddedGeometryStore<BV> store;
+  return store;
+}
+
 /** \brief Templated helper function creating new collision geometry out of general object using an arbitrary bounding
  *  volume (BV). This can include padding and scaling. */
 template <typename BV, typename T>
@@ -940,9 +1151,11 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   }
   else
   {
-    shapes::ShapePtr scaled_shape(shape->clone());
-    scaled_shape->scaleAndPadd(scale, padding);
-    return createCollisionGeometry<BV, T>(scaled_shape, data, shape_index);
+    return GetPaddedGeometryStore<BV>().getOrCreate(shape, data, shape_index, scale, padding, [&]() {
+      shapes::ShapePtr scaled_shape(shape->clone());
+      scaled_shape->scaleAndPadd(scale, padding);
+      return createCollisionGeometry<BV, T>(scaled_shape, data, shape_index);
+    });
   }
 }
 
@@ -976,11 +1189,23 @@ void cleanCollisionGeometryCache()
   }
 }
 
+std::size_t estimateCollisionGeometryMemoryUsage(const FCLGeometry& geometry)
+{
+  const fcl::CollisionGeometryd* collision_geometry = geometry.collision_geometry_.get();
+  if (const auto* bvh = dynamic_cast<const fcl::BVHModel<fcl::OBBRSSd>*>(collision_geometry))
+  {
+    return sizeof(*bvh) + static_cast<std::size_t>(bvh->num_vertices) * sizeof(fcl::Vector3d) +
+           static_cast<std::size_t>(bvh->num_tris) * sizeof(fcl::Triangle) +
+           static_cast<std::size_t>(bvh->getNumBVs()) * sizeof(fcl::BVNode<fcl::OBBRSSd>);
+  }
+  return sizeof(fcl::CollisionGeometryd);
+}
+
 void CollisionData::enableGroup(const moveit::core::RobotModelConstPtr& robot_model)
 {
-  if (robot_model->hasJointModelGroup(req_->group_name))
+  if (const moveit::core::JointModelGroup* group = req_->getGroup(*robot_model))
   {
-    active_components_only_ = &robot_model->getJointModelGroup(req_->group_name)->getUpdatedLinkModelsSet();
+    active_components_only_ = &group->getUpdatedLinkModelsSet();
   }
   else
   {
@@ -44,8 +44,17 @@
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+#include <fcl/geometry/shape/box.h>
+#include <fcl/narrowphase/continuous_collision.h>
 #endif
 
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
 namespace collision_detection
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_collision_detection_fcl.collision_env_fcl");
@@ -74,38 +83,120 @@ void checkFCLCapabilities(const DistanceRequest& req)
   static_cast<void>(req);  // silent -Wunused-parameter
 #endif
 }
-}  // namespace
 
-CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
-  : CollisionEnv(model, padding, scale)
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+// Maximum distance [m] a point of a robot object may travel between two samples of the continuous check
+constexpr double CONTINUOUS_COLLISION_RESOLUTION = 0.01;
+
+/** \brief Data passed to continuousCollisionCallback() for the motion of a single robot object */
+struct ContinuousCollisionData
 {
-  const std::vector<const moveit::core::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
-  std::size_t index;
-  robot_geoms_.resize(robot_model_->getLinkGeometryCount());
-  robot_fcl_objs_.resize(robot_model_->getLinkGeometryCount());
-  // we keep the same order of objects as what RobotState *::getLinkState() returns
-  for (auto link : links)
+  /** \brief Box enclosing the swept volume, used as broadphase query */
+  const fcl::CollisionObjectd* query_;
+
+  /** \brief The robot object at the start and at the end of the motion */
+  const fcl::CollisionObjectd* begin_;
+  const fcl::CollisionObjectd* end_;
+
+  fcl::ContinuousCollisionRequestd request_;
+
+  CollisionData* cdata_;
+};
+
+bool continuousCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  ContinuousCollisionData* ccdata = reinterpret_cast<ContinuousCollisionData*>(data);
+  CollisionData* cdata = ccdata->cdata_;
+  if (cdata->done_)
+    return true;
+  cdata->res_->broadphase_pairs++;
+  cdata->res_->narrowphase_tests++;
+
+  fcl::CollisionObjectd* world_obj = o1 == ccdata->query_ ? o2 : o1;
+  fcl::ContinuousCollisionResultd ccresult;
+  fcl::continuousCollide(ccdata->begin_->collisionGeometry().get(), ccdata->begin_->getTransform(),
+                         ccdata->end_->getTransform(), world_obj->collisionGeometry().get(),
+                         world_obj->getTransform(), world_obj->getTransform(), ccdata->request_, ccresult);
+  if (!ccresult.is_collide)
+    return false;
+
+  // Filtering by the ACM and the computation of contacts is left to the discrete callback, which is evaluated for the
+  // robot object at the time of contact (the sample at which the naive solver found the collision).
+  fcl::CollisionObjectd robot_obj(ccdata->begin_->collisionGeometry(), ccresult.contact_tf1);
+  const CollisionGeometryData* cd1 =
+      static_cast<const CollisionGeometryData*>(robot_obj.collisionGeometry()->getUserData());
+  const CollisionGeometryData* cd2 =
+      static_cast<const CollisionGeometryData*>(world_obj->collisionGeometry()->getUserData());
+  const std::pair<std::string, std::string> pc = cd1->getID() < cd2->getID() ?
+                                                     std::make_pair(cd1->getID(), cd2->getID()) :
+                                                     std::make_pair(cd2->getID(), cd1->getID());
+  auto it = cdata->res_->contacts.find(pc);
+  const std::size_t known_contacts = it != cdata->res_->contacts.end() ? it->second.size() : 0;
+
+  collisionCallback(&robot_obj, world_obj, cdata);
+
+  it = cdata->res_->contacts.find(pc);
+  if (it != cdata->res_->contacts.end())
   {
-    for (std::size_t j{ 0 }; j < link->getShapes().size(); ++j)
-    {
-      FCLGeometryConstPtr link_geometry = createCollisionGeometry(link->getShapes()[j], getLinkScale(link->getName()),
-                                                                  getLinkPadding(link->getName()), link, j);
-      if (link_geometry)
-      {
-        index = link->getFirstCollisionBodyTransformIndex() + j;
-        robot_geoms_[index] = link_geometry;
+    for (std::size_t i = known_contacts; i < it->second.size(); ++i)
+      it->second[i].percent_interpolation = ccresult.time_of_contact;
+  }
+  return cdata->done_;
+}
+#endif
 
-        // Need to store the FCL object so the AABB does not get recreated every time.
-        // Every time this object is created, g->computeLocalAABB() is called  which is
-        // very expensive and should only be calculated once. To update the AABB, use the
-        // collObj->setTransform and then call collObj->computeAABB() to transform the AABB.
-        robot_fcl_objs_[index] = FCLCollisionObjectConstPtr(
-            std::make_shared<const fcl::CollisionObjectd>(link_geometry->collision_geometry_));
-      }
-      else
-        RCLCPP_ERROR(LOGGER, "Unable to construct collision geometry for link '%s'", link->getName().c_str());
-    }
+/** \brief Data passed to the callbacks for the objects of an overlay parent */
+struct OverlayData
+{
+  /** \brief Objects of the parent that are hidden by the overlay */
+  const std::set<std::string>* hidden_objects_;
+
+  /** \brief Data of the wrapped callback */
+  void* data_;
+};
+
+bool isHidden(const std::set<std::string>& hidden_objects, const fcl::CollisionObjectd* o)
+{
+  const CollisionGeometryData* cd = static_cast<const CollisionGeometryData*>(o->collisionGeometry()->getUserData());
+  // the query objects of continuous checks have no user data
+  return cd && cd->type == BodyTypes::WORLD_OBJECT && hidden_objects.count(cd->getID()) > 0;
+}
+
+template <bool (*Callback)(fcl::CollisionObjectd*, fcl::CollisionObjectd*, void*)>
+bool overlayCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  const OverlayData* odata = reinterpret_cast<const OverlayData*>(data);
+  if (isHidden(*odata->hidden_objects_, o1) || isHidden(*odata->hidden_objects_, o2))
+    return false;
+  return Callback(o1, o2, odata->data_);
+}
+
+bool overlayDistanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist)
+{
+  const OverlayData* odata = reinterpret_cast<const OverlayData*>(data);
+  if (isHidden(*odata->hidden_objects_, o1) || isHidden(*odata->hidden_objects_, o2))
+    return false;
+  return distanceCallback(o1, o2, odata->data_, min_dist);
+}
+
+// Union of the AABBs of the collision objects of fcl_obj
+Eigen::AlignedBox3d getAABB(const FCLObject& fcl_obj)
+{
+  Eigen::AlignedBox3d aabb;
+  for (const FCLCollisionObjectPtr& object : fcl_obj.collision_objects_)
+  {
+    const auto& bv = object->getAABB();
+    aabb.extend(Eigen::Vector3d(bv.min_[0], bv.min_[1], bv.min_[2]));
+    aabb.extend(Eigen::Vector3d(bv.max_[0], bv.max_[1], bv.max_[2]));
   }
+  return aabb;
+}
+}  // namespace
+
+CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
+  : CollisionEnv(model, padding, scale)
+{
+  constructRobotGeometry();
 
   manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
 
@@ -118,20 +209,46 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
                                  double scale)
   : CollisionEnv(model, world, padding, scale)
 {
-  const std::vector<const moveit::core::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
-  std::size_t index;
-  robot_geoms_.resize(robot_model_->getLinkGeometryCount());
-  robot_fcl_objs_.resize(robot_model_->getLinkGeometryCount());
+  constructRobotGeometry();
+
+  manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+
+  // request notifications about changes to new world
+  observer_handle_ = getWorld()->addObserver(
+      [this](const World::ObjectConstPtr& object, World::Action action) { notifyObjectChange(object, action); });
+  getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
+}
+
+void CollisionEnvFCL::constructRobotGeometry()
+{
   // we keep the same order of objects as what RobotState *::getLinkState() returns
-  for (auto link : links)
+  std::vector<std::pair<const moveit::core::LinkModel*, std::size_t>> link_shapes;
+  std::size_t mesh_count = 0;
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModelsWithCollisionGeometry())
   {
     for (std::size_t j{ 0 }; j < link->getShapes().size(); ++j)
     {
+      link_shapes.emplace_back(link, j);
+      if (link->getShapes()[j]->type == shapes::MESH)
+        ++mesh_count;
+    }
+  }
+
+  robot_geoms_.assign(robot_model_->getLinkGeometryCount(), FCLGeometryConstPtr());
+  robot_fcl_objs_.assign(robot_model_->getLinkGeometryCount(), FCLCollisionObjectConstPtr());
+
+  // Building the BVHs of the link meshes dominates the construction time, so the geometry is built concurrently.
+  // Every shape is written to its own index, so the result does not depend on the number of threads.
+  std::atomic<std::size_t> next_shape{ 0 };
+  const auto construct_shapes = [&]() {
+    for (std::size_t i = next_shape++; i < link_shapes.size(); i = next_shape++)
+    {
+      const auto& [link, j] = link_shapes[i];
       FCLGeometryConstPtr g = createCollisionGeometry(link->getShapes()[j], getLinkScale(link->getName()),
                                                       getLinkPadding(link->getName()), link, j);
       if (g)
       {
-        index = link->getFirstCollisionBodyTransformIndex() + j;
+        const std::size_t index = link->getFirstCollisionBodyTransformIndex() + j;
         robot_geoms_[index] = g;
 
         // Need to store the FCL object so the AABB does not get recreated every time.
@@ -140,17 +257,22 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
         // collObj->setTransform and then call collObj->computeAABB() to transform the AABB.
         robot_fcl_objs_[index] = std::make_shared<const fcl::CollisionObjectd>(g->collision_geometry_);
       }
-      else
-        RCLCPP_ERROR(LOGGER, "Unable to construct collision geometry for link '%s'", link->getName().c_str());
     }
-  }
+  };
 
-  manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+  const std::size_t thread_count = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), mesh_count);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(construct_shapes);
+  construct_shapes();
+  for (std::thread& thread : threads)
+    thread.join();
 
-  // request notifications about changes to new world
-  observer_handle_ = getWorld()->addObserver(
-      [this](const World::ObjectConstPtr& object, World::Action action) { notifyObjectChange(object, action); });
-  getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
+  for (const auto& [link, j] : link_shapes)
+  {
+    if (!robot_geoms_[link->getFirstCollisionBodyTransformIndex() + j])
+      RCLCPP_ERROR(LOGGER, "Unable to construct collision geometry for link '%s'", link->getName().c_str());
+  }
 }
 
 CollisionEnvFCL::~CollisionEnvFCL()
@@ -166,10 +288,52 @@ CollisionEnvFCL::CollisionEnvFCL(const CollisionEnvFCL& other, const WorldPtr& w
   manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
 
   fcl_objs_ = other.fcl_objs_;
+  // a copy does not depend on the environment other overlays: take over the objects other still shares with it
+  if (other.overlay_parent_)
+  {
+    for (const auto& fcl_obj : other.overlay_parent_->fcl_objs_)
+    {
+      // objects other changed or removed are hidden, insert() keeps the changed ones of other
+      if (other.hidden_parent_objects_.count(fcl_obj.first) == 0)
+        fcl_objs_.insert(fcl_obj);
+    }
+  }
   for (auto& fcl_obj : fcl_objs_)
     fcl_obj.second.registerTo(manager_.get());
   // manager_->update();
 
+  // the cached results refer to the world of other, only the settings carry over
+  robot_collision_cache_size_ = other.robot_collision_cache_size_;
+  robot_collision_cache_resolution_ = other.robot_collision_cache_resolution_;
+
+  // request notifications about changes to new world
+  observer_handle_ = getWorld()->addObserver(
+      [this](const World::ObjectConstPtr& object, World::Action action) { notifyObjectChange(object, action); });
+}
+
+CollisionEnvFCL::CollisionEnvFCL(const std::shared_ptr<const CollisionEnvFCL>& parent, const WorldPtr& world)
+  : CollisionEnv(*parent, world)
+{
+  robot_geoms_ = parent->robot_geoms_;
+  robot_fcl_objs_ = parent->robot_fcl_objs_;
+
+  manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+
+  if (parent->overlay_parent_)
+  {
+    // overlay the same environment as the parent, which only has the few objects that differ in its own manager
+    overlay_parent_ = parent->overlay_parent_;
+    hidden_parent_objects_ = parent->hidden_parent_objects_;
+    fcl_objs_ = parent->fcl_objs_;
+    for (auto& fcl_obj : fcl_objs_)
+      fcl_obj.second.registerTo(manager_.get());
+  }
+  else
+    overlay_parent_ = parent;
+
+  robot_collision_cache_size_ = parent->robot_collision_cache_size_;
+  robot_collision_cache_resolution_ = parent->robot_collision_cache_resolution_;
+
   // request notifications about changes to new world
   observer_handle_ = getWorld()->addObserver(
       [this](const World::ObjectConstPtr& object, World::Action action) { notifyObjectChange(object, action); });
@@ -254,6 +418,98 @@ void CollisionEnvFCL::allocSelfCollisionBroadPhase(const moveit::core::RobotStat
   manager.object_.registerTo(manager.manager_.get());
 }
 
+std::unique_ptr<CollisionEnvFCL::SelfCollisionBroadPhase>
+CollisionEnvFCL::acquireSelfCollisionBroadPhase(const moveit::core::RobotState& state) const
+{
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase;
+  {
+    std::scoped_lock slock(self_collision_broadphases_mutex_);
+    if (!self_collision_broadphases_.empty())
+    {
+      broadphase = std::move(self_collision_broadphases_.back());
+      self_collision_broadphases_.pop_back();
+    }
+  }
+  if (!broadphase)
+    broadphase = std::make_unique<SelfCollisionBroadPhase>();
+
+  fcl::Transform3d fcl_tf;
+  if (!broadphase->manager_ || broadphase->robot_geometry_version_ != robot_geometry_version_)
+  {
+    // (re-)create the robot objects and register them
+    broadphase->manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+    broadphase->robot_objects_.assign(robot_geoms_.size(), nullptr);
+    std::vector<fcl::CollisionObjectd*> objects;
+    objects.reserve(robot_geoms_.size());
+    for (std::size_t i = 0; i < robot_geoms_.size(); ++i)
+    {
+      if (robot_geoms_[i] && robot_geoms_[i]->collision_geometry_)
+      {
+        transform2fcl(state.getCollisionBodyTransform(robot_geoms_[i]->collision_geometry_data_->ptr.link,
+                                                      robot_geoms_[i]->collision_geometry_data_->shape_index),
+                      fcl_tf);
+        broadphase->robot_objects_[i] = std::make_shared<fcl::CollisionObjectd>(*robot_fcl_objs_[i]);
+        broadphase->robot_objects_[i]->setTransform(fcl_tf);
+        broadphase->robot_objects_[i]->computeAABB();
+        objects.push_back(broadphase->robot_objects_[i].get());
+      }
+    }
+    broadphase->manager_->registerObjects(objects);
+    broadphase->robot_geometry_version_ = robot_geometry_version_;
+  }
+  else
+  {
+    // move the existing objects to the new link transforms
+    for (std::size_t i = 0; i < broadphase->robot_objects_.size(); ++i)
+    {
+      const FCLCollisionObjectPtr& object = broadphase->robot_objects_[i];
+      if (object)
+      {
+        transform2fcl(state.getCollisionBodyTransform(robot_geoms_[i]->collision_geometry_data_->ptr.link,
+                                                      robot_geoms_[i]->collision_geometry_data_->shape_index),
+                      fcl_tf);
+        object->setTransform(fcl_tf);
+        object->computeAABB();
+      }
+    }
+  }
+
+  // attached bodies change between states, so they are only registered temporarily
+  std::vector<const moveit::core::AttachedBody*> ab;
+  state.getAttachedBodies(ab);
+  for (auto& body : ab)
+  {
+    std::vector<FCLGeometryConstPtr> objs;
+    getAttachedBodyObjects(body, objs);
+    const EigenSTL::vector_Isometry3d& ab_t = body->getGlobalCollisionBodyTransforms();
+    for (std::size_t k = 0; k < objs.size(); ++k)
+    {
+      if (objs[k]->collision_geometry_)
+      {
+        transform2fcl(ab_t[k], fcl_tf);
+        broadphase->attached_objects_.collision_objects_.push_back(
+            std::make_shared<fcl::CollisionObjectd>(objs[k]->collision_geometry_, fcl_tf));
+        broadphase->attached_objects_.collision_geometry_.push_back(objs[k]);
+      }
+    }
+  }
+  broadphase->attached_objects_.registerTo(broadphase->manager_.get());
+  broadphase->manager_->update();
+  return broadphase;
+}
+
+void CollisionEnvFCL::releaseSelfCollisionBroadPhase(std::unique_ptr<SelfCollisionBroadPhase> broadphase) const
+{
+  broadphase->attached_objects_.unregisterFrom(broadphase->manager_.get());
+  broadphase->attached_objects_.clear();
+
+  // broadphases beyond the number of hardware threads are only needed for a burst of concurrent checks
+  static const std::size_t MAX_IDLE_BROADPHASES = std::max(1u, std::thread::hardware_concurrency());
+  std::scoped_lock slock(self_collision_broadphases_mutex_);
+  if (self_collision_broadphases_.size() < MAX_IDLE_BROADPHASES)
+    self_collision_broadphases_.push_back(std::move(broadphase));
+}
+
 void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                          const moveit::core::RobotState& state) const
 {
@@ -270,18 +526,27 @@ void CollisionEnvFCL::checkSelfCollisionHelper(const CollisionRequest& req, Coll
                                                const moveit::core::RobotState& state,
                                                const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
-  CollisionData cd(&req, &res, acm);
+  QueryRecorder<CollisionResult> recorder(*this, res);
+  const FCLAllowedCollisionMatrixConstPtr compiled_acm = getCompiledACM(acm);
+  const moveit::core::JointModelGroup* group = req.getGroup(*getRobotModel());
+  const std::shared_ptr<const std::vector<std::vector<bool>>> skipped_link_pairs =
+      group ? getSkippedLinkPairs(group, state) : nullptr;
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase = acquireSelfCollisionBroadPhase(state);
+  CollisionData cd(&req, &res, acm, compiled_acm.get());
   cd.enableGroup(getRobotModel());
-  manager.manager_->collide(&cd, &collisionCallback);
+  cd.skipped_link_pairs_ = skipped_link_pairs.get();
+  broadphase->manager_->collide(&cd, &collisionCallback);
+  releaseSelfCollisionBroadPhase(std::move(broadphase));
   if (req.distance)
   {
     DistanceRequest dreq;
     DistanceResult dres;
 
     dreq.group_name = req.group_name;
+    dreq.group = req.group;
     dreq.acm = acm;
+    dreq.distance_threshold = req.distance_threshold;
+    dreq.stop_threshold = req.distance_stop_threshold;
     dreq.enableGroup(getRobotModel());
     distanceSelf(dreq, dres, state);
     res.distance = dres.minimum_distance.distance;
@@ -301,32 +566,90 @@ void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, Collision
   checkRobotCollisionHelper(req, res, state, &acm);
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2) const
 {
-  RCLCPP_ERROR(LOGGER, "Continuous collision not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, nullptr);
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/,
-                                          const AllowedCollisionMatrix& /*acm*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2,
+                                          const AllowedCollisionMatrix& acm) const
 {
-  RCLCPP_ERROR(LOGGER, "Not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, &acm);
 }
 
 void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                                 const moveit::core::RobotState& state,
                                                 const AllowedCollisionMatrix* acm) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
+
+  RobotCollisionCacheEntry cache_entry;
+  const bool use_cache = getRobotCollisionCacheKey(req, state, acm, cache_entry.key);
+  if (use_cache)
+  {
+    bool collision;
+    if (lookupRobotCollisionCache(cache_entry.key, collision))
+    {
+      res.collision |= collision;
+      return;
+    }
+  }
+
+  // states whose bounding volumes are apart from all world objects don't need the broadphase
+  Eigen::AlignedBox3d robot_aabb;
+  const bool may_collide = mayCollideWithWorld(state, robot_aabb);
   FCLObject fcl_obj;
-  constructFCLObjectRobot(state, fcl_obj);
+  if (may_collide)
+    constructFCLObjectRobot(state, fcl_obj);
 
-  CollisionData cd(&req, &res, acm);
+  // A cached result in collision needs to know the object in collision, so a single contact is requested
+  CollisionRequest cache_req;
+  CollisionResult cache_res;
+  if (use_cache)
+  {
+    cache_req = req;
+    cache_req.contacts = true;
+    cache_req.flat_contacts = true;
+    cache_req.max_contacts = 1;
+    cache_req.max_contacts_per_pair = 1;
+  }
+
+  const FCLAllowedCollisionMatrixConstPtr compiled_acm = getCompiledACM(acm);
+  CollisionData cd(use_cache ? &cache_req : &req, use_cache ? &cache_res : &res, acm, compiled_acm.get());
   cd.enableGroup(getRobotModel());
   for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
     manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+  if (overlay_parent_)
+  {
+    OverlayData od{ &hidden_parent_objects_, &cd };
+    for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+      overlay_parent_->manager_->collide(fcl_obj.collision_objects_[i].get(), &od,
+                                         &overlayCollisionCallback<collisionCallback>);
+  }
+
+  if (use_cache)
+  {
+    res.collision |= cache_res.collision;
+    res.broadphase_pairs += cache_res.broadphase_pairs;
+    res.narrowphase_tests += cache_res.narrowphase_tests;
+
+    cache_entry.collision = cache_res.collision;
+    if (cache_res.collision)
+    {
+      // only robot-world pairs are checked, so one body of the contact is the world object
+      if (cache_res.contact_pairs.empty())
+        return;
+      const ContactPair& pair = cache_res.contact_pairs.front();
+      cache_entry.object_id = pair.body_type_1 == BodyTypes::WORLD_OBJECT ? *pair.body_name_1 : *pair.body_name_2;
+    }
+    else
+      cache_entry.robot_aabb = robot_aabb;
+    insertRobotCollisionCache(std::move(cache_entry));
+  }
 
   if (req.distance)
   {
@@ -334,36 +657,388 @@ void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, Col
     DistanceResult dres;
 
     dreq.group_name = req.group_name;
+    dreq.group = req.group;
     dreq.acm = acm;
+    dreq.distance_threshold = req.distance_threshold;
+    dreq.stop_threshold = req.distance_stop_threshold;
     dreq.enableGroup(getRobotModel());
     distanceRobot(dreq, dres, state);
     res.distance = dres.minimum_distance.distance;
   }
 }
 
+void CollisionEnvFCL::checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state1,
+                                                   const moveit::core::RobotState& state2,
+                                                   const AllowedCollisionMatrix* acm) const
+{
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  QueryRecorder<CollisionResult> recorder(*this, res);
+  FCLObject fcl_obj1, fcl_obj2;
+  constructFCLObjectRobot(state1, fcl_obj1);
+  constructFCLObjectRobot(state2, fcl_obj2);
+  if (fcl_obj1.collision_objects_.size() != fcl_obj2.collision_objects_.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Continuous collision checking requires the same attached bodies in both states");
+    return;
+  }
+
+  const FCLAllowedCollisionMatrixConstPtr compiled_acm = getCompiledACM(acm);
+  CollisionData cd(&req, &res, acm, compiled_acm.get());
+  cd.enableGroup(getRobotModel());
+
+  ContinuousCollisionData ccd;
+  ccd.cdata_ = &cd;
+  // The naive solver checks discrete samples along the motion, which works for all geometry types supported by the
+  // discrete check. Conservative advancement only supports a subset of them.
+  ccd.request_.ccd_motion_type = fcl::CCDM_LINEAR;
+  ccd.request_.ccd_solver_type = fcl::CCDC_NAIVE;
+
+  for (std::size_t i = 0; !cd.done_ && i < fcl_obj1.collision_objects_.size(); ++i)
+  {
+    const fcl::CollisionObjectd* begin = fcl_obj1.collision_objects_[i].get();
+    const fcl::CollisionObjectd* end = fcl_obj2.collision_objects_[i].get();
+
+    // Choose the number of samples such that no point of the object moves more than the resolution between samples
+    const fcl::Transform3d& tf_begin = begin->getTransform();
+    const fcl::Transform3d& tf_end = end->getTransform();
+    const Eigen::AngleAxisd rotation(tf_begin.linear().transpose() * tf_end.linear());
+    const double motion = (tf_end.translation() - tf_begin.translation()).norm() +
+                          std::abs(rotation.angle()) * begin->collisionGeometry()->aabb_radius;
+    const std::size_t samples =
+        std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(motion / CONTINUOUS_COLLISION_RESOLUTION)) + 1);
+    ccd.request_.num_max_iterations = samples;
+    ccd.request_.toc_err = 1.0 / static_cast<double>(samples);
+
+    // Query the broadphase with a box enclosing both poses of the object
+    fcl::AABBd swept = begin->getAABB();
+    swept += end->getAABB();
+    fcl::Transform3d box_pose = fcl::Transform3d::Identity();
+    box_pose.translation() = swept.center();
+    fcl::CollisionObjectd query(std::make_shared<fcl::Boxd>(swept.width(), swept.height(), swept.depth()), box_pose);
+
+    ccd.query_ = &query;
+    ccd.begin_ = begin;
+    ccd.end_ = end;
+    manager_->collide(&query, &ccd, &continuousCollisionCallback);
+    if (overlay_parent_)
+    {
+      OverlayData od{ &hidden_parent_objects_, &ccd };
+      overlay_parent_->manager_->collide(&query, &od, &overlayCollisionCallback<continuousCollisionCallback>);
+    }
+  }
+#else
+  static_cast<void>(req);
+  static_cast<void>(res);
+  static_cast<void>(state1);
+  static_cast<void>(state2);
+  static_cast<void>(acm);
+  RCLCPP_ERROR(LOGGER, "Continuous collision checking requires FCL 0.6.0 or newer");
+#endif
+}
+
 void CollisionEnvFCL::distanceSelf(const DistanceRequest& req, DistanceResult& res,
                                    const moveit::core::RobotState& state) const
 {
+  QueryRecorder<DistanceResult> recorder(*this, res);
   checkFCLCapabilities(req);
 
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
-  DistanceData drd(&req, &res);
+  const FCLAllowedCollisionMatrixConstPtr compiled_acm = getCompiledACM(req.acm);
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase = acquireSelfCollisionBroadPhase(state);
+  DistanceData drd(&req, &res, compiled_acm.get());
 
-  manager.manager_->distance(&drd, &distanceCallback);
+  broadphase->manager_->distance(&drd, &distanceCallback);
+  releaseSelfCollisionBroadPhase(std::move(broadphase));
 }
 
 void CollisionEnvFCL::distanceRobot(const DistanceRequest& req, DistanceResult& res,
                                     const moveit::core::RobotState& state) const
 {
+  QueryRecorder<DistanceResult> recorder(*this, res);
   checkFCLCapabilities(req);
 
   FCLObject fcl_obj;
   constructFCLObjectRobot(state, fcl_obj);
 
-  DistanceData drd(&req, &res);
+  const FCLAllowedCollisionMatrixConstPtr compiled_acm = getCompiledACM(req.acm);
+  DistanceData drd(&req, &res, compiled_acm.get());
   for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
     manager_->distance(fcl_obj.collision_objects_[i].get(), &drd, &distanceCallback);
+  if (overlay_parent_)
+  {
+    OverlayData od{ &hidden_parent_objects_, &drd };
+    for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
+      overlay_parent_->manager_->distance(fcl_obj.collision_objects_[i].get(), &od, &overlayDistanceCallback);
+  }
+}
+
+FCLAllowedCollisionMatrixConstPtr CollisionEnvFCL::getCompiledACM(const AllowedCollisionMatrix* acm) const
+{
+  if (!acm)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(compiled_acm_mutex_);
+  if (!compiled_acm_ || compiled_acm_->matrix_.getSourceVersion() != acm->getVersion())
+    compiled_acm_ = std::make_shared<const FCLAllowedCollisionMatrix>(*acm, *getRobotModel(), *getWorld());
+  return compiled_acm_;
+}
+
+void CollisionEnvFCL::resetCompiledACM()
+{
+  std::lock_guard<std::mutex> lock(compiled_acm_mutex_);
+  compiled_acm_.reset();
+}
+
+Eigen::AlignedBox3d CollisionEnvFCL::getWorldAABB() const
+{
+  std::lock_guard<std::mutex> lock(world_aabb_mutex_);
+  if (!world_aabb_)
+  {
+    Eigen::AlignedBox3d aabb;
+    for (const auto& [id, fcl_obj] : fcl_objs_)
+      aabb.extend(getAABB(fcl_obj));
+    // the hidden objects of the parent are included as well, which is conservative
+    if (overlay_parent_)
+      aabb.extend(overlay_parent_->getWorldAABB());
+    world_aabb_ = aabb;
+  }
+  return *world_aabb_;
+}
+
+bool CollisionEnvFCL::mayCollideWithWorld(const moveit::core::RobotState& state, Eigen::AlignedBox3d& robot_aabb) const
+{
+  // bounding boxes of the bounding spheres of all robot bodies, which only cost a transform each
+  std::vector<Eigen::AlignedBox3d> body_aabbs;
+  body_aabbs.reserve(robot_geoms_.size());
+  const auto add_body = [&](const fcl::CollisionGeometryd& geometry, const Eigen::Isometry3d& pose) {
+    const Eigen::Vector3d center =
+        pose * Eigen::Vector3d(geometry.aabb_center[0], geometry.aabb_center[1], geometry.aabb_center[2]);
+    const Eigen::Vector3d radius = Eigen::Vector3d::Constant(geometry.aabb_radius);
+    body_aabbs.emplace_back(center - radius, center + radius);
+  };
+  for (std::size_t i = 0; i < robot_geoms_.size(); ++i)
+  {
+    if (robot_geoms_[i] && robot_geoms_[i]->collision_geometry_)
+    {
+      add_body(*robot_geoms_[i]->collision_geometry_,
+               state.getCollisionBodyTransform(robot_geoms_[i]->collision_geometry_data_->ptr.link,
+                                               robot_geoms_[i]->collision_geometry_data_->shape_index));
+    }
+  }
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  state.getAttachedBodies(attached_bodies);
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    std::vector<FCLGeometryConstPtr> geoms;
+    getAttachedBodyObjects(body, geoms);
+    const EigenSTL::vector_Isometry3d& poses = body->getGlobalCollisionBodyTransforms();
+    for (std::size_t k = 0; k < geoms.size(); ++k)
+    {
+      if (geoms[k]->collision_geometry_)
+        add_body(*geoms[k]->collision_geometry_, poses[k]);
+    }
+  }
+
+  robot_aabb.setEmpty();
+  for (const Eigen::AlignedBox3d& body_aabb : body_aabbs)
+    robot_aabb.extend(body_aabb);
+
+  // test the whole robot first, then every body
+  const Eigen::AlignedBox3d world_aabb = getWorldAABB();
+  if (!robot_aabb.intersects(world_aabb))
+    return false;
+  return std::any_of(body_aabbs.begin(), body_aabbs.end(),
+                     [&world_aabb](const Eigen::AlignedBox3d& body_aabb) { return body_aabb.intersects(world_aabb); });
+}
+
+std::shared_ptr<const std::vector<std::vector<bool>>>
+CollisionEnvFCL::getSkippedLinkPairs(const moveit::core::JointModelGroup* group,
+                                     const moveit::core::RobotState& state) const
+{
+  // only a few frozen configurations are kept, planning usually checks a single one over and over
+  static const std::size_t MAX_FROZEN_CONFIGURATIONS = 4;
+
+  std::unique_lock<std::mutex> lock(skipped_link_pairs_mutex_);
+  auto pairs_it = rigid_link_pairs_.find(group);
+  if (pairs_it == rigid_link_pairs_.end())
+    pairs_it = rigid_link_pairs_.emplace(group, getRigidLinkPairs(*group)).first;
+  const RigidLinkPairs& rigid_link_pairs = pairs_it->second;
+  if (rigid_link_pairs.pairs.empty())
+    return nullptr;
+
+  std::vector<double> frozen_values;
+  frozen_values.reserve(rigid_link_pairs.frozen_variables.size());
+  for (std::size_t index : rigid_link_pairs.frozen_variables)
+    frozen_values.push_back(state.getVariablePosition(index));
+
+  for (auto it = skipped_link_pairs_.begin(); it != skipped_link_pairs_.end(); ++it)
+  {
+    if (it->group == group && it->robot_geometry_version == robot_geometry_version_ &&
+        it->frozen_values == frozen_values)
+    {
+      std::rotate(skipped_link_pairs_.begin(), it, it + 1);
+      return skipped_link_pairs_.front().skipped;
+    }
+  }
+  const std::size_t robot_geometry_version = robot_geometry_version_;
+  lock.unlock();
+
+  // check the rigid link pairs in the current state, their collision state doesn't change while only the group moves
+  FCLObject fcl_obj;
+  constructFCLObjectRobot(state, fcl_obj);
+  std::vector<std::vector<const fcl::CollisionObjectd*>> link_objects(getRobotModel()->getLinkModelCount());
+  for (const FCLCollisionObjectPtr& object : fcl_obj.collision_objects_)
+  {
+    const CollisionGeometryData* data =
+        static_cast<const CollisionGeometryData*>(object->collisionGeometry()->getUserData());
+    if (data->type == BodyTypes::ROBOT_LINK)
+      link_objects[data->ptr.link->getLinkIndex()].push_back(object.get());
+  }
+
+  auto skipped = std::make_shared<std::vector<std::vector<bool>>>(
+      link_objects.size(), std::vector<bool>(link_objects.size(), false));
+  for (const auto& [link1, link2] : rigid_link_pairs.pairs)
+  {
+    bool apart = true;
+    for (const fcl::CollisionObjectd* object1 : link_objects[link1->getLinkIndex()])
+    {
+      for (const fcl::CollisionObjectd* object2 : link_objects[link2->getLinkIndex()])
+      {
+        fcl::CollisionResultd result;
+        if (apart && fcl::collide(object1, object2, fcl::CollisionRequestd(), result) > 0)
+          apart = false;
+      }
+    }
+    (*skipped)[link1->getLinkIndex()][link2->getLinkIndex()] = apart;
+    (*skipped)[link2->getLinkIndex()][link1->getLinkIndex()] = apart;
+  }
+
+  lock.lock();
+  skipped_link_pairs_.insert(skipped_link_pairs_.begin(),
+                             SkippedLinkPairs{ group, std::move(frozen_values), robot_geometry_version, skipped });
+  if (skipped_link_pairs_.size() > MAX_FROZEN_CONFIGURATIONS)
+    skipped_link_pairs_.pop_back();
+  return skipped;
+}
+
+void CollisionEnvFCL::setRobotCollisionCacheSize(std::size_t size, double resolution)
+{
+  std::lock_guard<std::mutex> lock(robot_collision_cache_mutex_);
+  robot_collision_cache_size_ = size;
+  robot_collision_cache_resolution_ = resolution > 0.0 ? resolution : 1e-6;
+  robot_collision_cache_.clear();
+  robot_collision_cache_next_ = 0;
+}
+
+void CollisionEnvFCL::clearRobotCollisionCache()
+{
+  std::lock_guard<std::mutex> lock(robot_collision_cache_mutex_);
+  robot_collision_cache_.clear();
+  robot_collision_cache_next_ = 0;
+}
+
+bool CollisionEnvFCL::RobotCollisionCacheKey::operator==(const RobotCollisionCacheKey& other) const
+{
+  return hash == other.hash && acm_version == other.acm_version && values == other.values &&
+         group == other.group && attached_shapes == other.attached_shapes &&
+         attached_bodies == other.attached_bodies;
+}
+
+bool CollisionEnvFCL::getRobotCollisionCacheKey(const CollisionRequest& req, const moveit::core::RobotState& state,
+                                                const AllowedCollisionMatrix* acm, RobotCollisionCacheKey& key) const
+{
+  if (robot_collision_cache_size_ == 0 || req.contacts || req.cost || req.distance || req.is_done || req.verbose)
+    return false;
+
+  const double resolution = robot_collision_cache_resolution_;
+  const auto round = [resolution](double value) { return static_cast<std::int64_t>(std::llround(value / resolution)); };
+
+  const std::size_t variable_count = state.getVariableCount();
+  key.values.reserve(variable_count);
+  for (std::size_t i = 0; i < variable_count; ++i)
+    key.values.push_back(round(state.getVariablePosition(i)));
+
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  state.getAttachedBodies(attached_bodies);
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    key.attached_bodies.push_back(body->getName());
+    key.attached_bodies.push_back(body->getAttachedLinkName());
+    for (const shapes::ShapeConstPtr& shape : body->getShapes())
+      key.attached_shapes.push_back(shape.get());
+    for (const Eigen::Isometry3d& pose : body->getShapePosesInLinkFrame())
+    {
+      for (int row = 0; row < 3; ++row)
+      {
+        for (int col = 0; col < 4; ++col)
+          key.values.push_back(round(pose(row, col)));
+      }
+    }
+  }
+
+  key.group = req.getGroup(*getRobotModel());
+  key.acm_version = acm ? acm->getVersion() : 0;
+
+  key.hash = boost::hash_range(key.values.begin(), key.values.end());
+  boost::hash_combine(key.hash, key.attached_bodies);
+  boost::hash_combine(key.hash, key.group);
+  boost::hash_combine(key.hash, key.acm_version);
+  return true;
+}
+
+bool CollisionEnvFCL::lookupRobotCollisionCache(const RobotCollisionCacheKey& key, bool& collision) const
+{
+  std::lock_guard<std::mutex> lock(robot_collision_cache_mutex_);
+  for (const RobotCollisionCacheEntry& entry : robot_collision_cache_)
+  {
+    if (entry.key == key)
+    {
+      collision = entry.collision;
+      return true;
+    }
+  }
+  return false;
+}
+
+void CollisionEnvFCL::insertRobotCollisionCache(RobotCollisionCacheEntry&& entry) const
+{
+  std::lock_guard<std::mutex> lock(robot_collision_cache_mutex_);
+  if (robot_collision_cache_size_ == 0)
+    return;
+  if (robot_collision_cache_.size() < robot_collision_cache_size_)
+    robot_collision_cache_.push_back(std::move(entry));
+  else
+  {
+    robot_collision_cache_[robot_collision_cache_next_] = std::move(entry);
+    robot_collision_cache_next_ = (robot_collision_cache_next_ + 1) % robot_collision_cache_size_;
+  }
+}
+
+void CollisionEnvFCL::invalidateRobotCollisionCache(const std::string& id)
+{
+  std::lock_guard<std::mutex> lock(robot_collision_cache_mutex_);
+  if (robot_collision_cache_.empty())
+    return;
+
+  // removing or changing an object can only end the collisions with it, and the new geometry can only collide with
+  // robot states whose AABB it overlaps
+  Eigen::AlignedBox3d object_aabb;
+  const auto it = fcl_objs_.find(id);
+  if (it != fcl_objs_.end())
+    object_aabb = getAABB(it->second);
+
+  const auto outdated = [&](const RobotCollisionCacheEntry& entry) {
+    return entry.collision ? entry.object_id == id : entry.robot_aabb.intersects(object_aabb);
+  };
+  robot_collision_cache_.erase(std::remove_if(robot_collision_cache_.begin(), robot_collision_cache_.end(), outdated),
+                               robot_collision_cache_.end());
+  robot_collision_cache_next_ = 0;
+}
+
+void CollisionEnvFCL::resetWorldAABB()
+{
+  std::lock_guard<std::mutex> lock(world_aabb_mutex_);
+  world_aabb_.reset();
 }
 
 void CollisionEnvFCL::updateFCLObject(const std::string& id)
@@ -412,7 +1087,12 @@ void CollisionEnvFCL::setWorld(const WorldPtr& world)
   // clear out objects from old world
   manager_->clear();
   fcl_objs_.clear();
+  overlay_parent_.reset();
+  hidden_parent_objects_.clear();
   cleanCollisionGeometryCache();
+  resetCompiledACM();
+  resetWorldAABB();
+  clearRobotCollisionCache();
 
   CollisionEnv::setWorld(world);
 
@@ -424,8 +1104,31 @@ void CollisionEnvFCL::setWorld(const WorldPtr& world)
   getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
 }
 
+void CollisionEnvFCL::getCollisionGeometryMemoryUsage(std::map<std::string, std::size_t>& usage) const
+{
+  for (const FCLGeometryConstPtr& geometry : robot_geoms_)
+  {
+    if (geometry && geometry->collision_geometry_)
+      usage[geometry->collision_geometry_data_->getID()] += estimateCollisionGeometryMemoryUsage(*geometry);
+  }
+  // objects of an overlaid parent are reported by the parent
+  for (const auto& [id, fcl_obj] : fcl_objs_)
+  {
+    for (const FCLGeometryConstPtr& geometry : fcl_obj.collision_geometry_)
+      usage[id] += estimateCollisionGeometryMemoryUsage(*geometry);
+  }
+}
+
 void CollisionEnvFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
+  // the compiled collision matrix refers to the objects of the world
+  resetCompiledACM();
+  resetWorldAABB();
+
+  // the object of the overlaid environment is outdated, the object of this world is handled in manager_
+  if (overlay_parent_ && overlay_parent_->fcl_objs_.count(obj->id_))
+    hidden_parent_objects_.insert(obj->id_);
+
   if (action == World::DESTROY)
   {
     auto it = fcl_objs_.find(obj->id_);
@@ -443,6 +1146,8 @@ void CollisionEnvFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Actio
     if (action & (World::DESTROY | World::REMOVE_SHAPE))
       cleanCollisionGeometryCache();
   }
+
+  invalidateRobotCollisionCache(obj->id_);
 }
 
 void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& links)
@@ -468,6 +1173,9 @@ void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& li
     else
       RCLCPP_ERROR(LOGGER, "Updating padding or scaling for unknown link: '%s'", link.c_str());
   }
+  // persistent self collision broadphases need to pick up the new geometry
+  ++robot_geometry_version_;
+  clearRobotCollisionCache();
 }
 
 }  // end of namespace collision_detection
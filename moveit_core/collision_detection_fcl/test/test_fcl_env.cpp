@@ -44,6 +44,7 @@
 
 #include <moveit/collision_detection_fcl/collision_common.h>
 #include <moveit/collision_detection_fcl/collision_env_fcl.h>
+#include <moveit/collision_detection/rigid_link_pairs.h>
 
 #include <urdf_parser/urdf_parser.h>
 #include <geometric_shapes/shape_operations.h>
@@ -191,6 +192,51 @@ TEST_F(CollisionDetectionEnvTest, RobotWorldCollision_2)
   res.clear();
 }
 
+/** \brief Flat contacts hold the same contacts as the contact map, also when the result is reused. */
+TEST_F(CollisionDetectionEnvTest, FlatContacts)
+{
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  req.max_contacts = 10;
+  req.max_contacts_per_pair = 2;
+  req.contacts = true;
+
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(.4, .4, .4);
+  Eigen::Isometry3d pos1 = Eigen::Isometry3d::Identity();
+  pos1.translation().z() = 0.3;
+  c_env_->getWorld()->addToObject("box", shape_ptr, pos1);
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  ASSERT_TRUE(res.collision);
+  const collision_detection::CollisionResult::ContactMap contacts = res.contacts;
+
+  req.flat_contacts = true;
+  collision_detection::CollisionResult flat_res;
+  flat_res.reserveFlatContacts(req.max_contacts);
+  const collision_detection::FlatContact* flat_data = flat_res.flat_contacts.data();
+  for (int i = 0; i < 2; ++i)
+  {
+    flat_res.clear();
+    c_env_->checkRobotCollision(req, flat_res, *robot_state_, *acm_);
+    ASSERT_TRUE(flat_res.collision);
+    EXPECT_EQ(flat_res.flat_contacts.data(), flat_data);
+    EXPECT_TRUE(flat_res.contacts.empty());
+    EXPECT_EQ(flat_res.contact_count, res.contact_count);
+    EXPECT_EQ(flat_res.flat_contacts.size(), res.contact_count);
+    EXPECT_EQ(flat_res.contact_pairs.size(), contacts.size());
+    for (const collision_detection::ContactPair& pair : flat_res.contact_pairs)
+      EXPECT_LE(pair.contact_count, req.max_contacts_per_pair);
+
+    collision_detection::CollisionResult::ContactMap flat_contacts;
+    flat_res.getFlatContacts(flat_contacts);
+    ASSERT_EQ(flat_contacts.size(), contacts.size());
+    for (const auto& [pair, pair_contacts] : contacts)
+    {
+      ASSERT_EQ(flat_contacts.count(pair), 1u);
+      EXPECT_EQ(flat_contacts.at(pair).size(), pair_contacts.size());
+    }
+  }
+}
+
 /** \brief Tests the padding through expanding the link geometry in such a way that a collision occurs. */
 TEST_F(CollisionDetectionEnvTest, PaddingTest)
 {
@@ -267,10 +313,8 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionSelf)
   res.clear();
 }
 
-/** \brief Two similar robot poses are used as start and end pose of a continuous collision check.
- *
- *  Functionality not supported yet. */
-TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
+/** \brief Two similar robot poses are used as start and end pose of a continuous collision check. */
+TEST_F(CollisionDetectionEnvTest, ContinuousCollisionWorld)
 {
   collision_detection::CollisionRequest req;
   req.contacts = true;
@@ -314,8 +358,364 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
 
   c_env_->checkRobotCollision(req, res, state1, state2, *acm_);
   ASSERT_TRUE(res.collision);
+  // one contact with the box for each of the links sweeping through it, as in the Bullet continuous check
   ASSERT_EQ(res.contact_count, 4u);
+  ASSERT_EQ(res.contacts.size(), 4u);
+  for (auto& contact_pair : res.contacts)
+  {
+    for (collision_detection::Contact& contact : contact_pair.second)
+    {
+      collision_detection::BodyType contact_type1 = contact.body_name_1 == "box" ?
+                                                        collision_detection::BodyType::WORLD_OBJECT :
+                                                        collision_detection::BodyType::ROBOT_LINK;
+      collision_detection::BodyType contact_type2 = contact.body_name_2 == "box" ?
+                                                        collision_detection::BodyType::WORLD_OBJECT :
+                                                        collision_detection::BodyType::ROBOT_LINK;
+      ASSERT_EQ(contact.body_type_1, contact_type1);
+      ASSERT_EQ(contact.body_type_2, contact_type2);
+      // neither end state is in collision
+      EXPECT_GT(contact.percent_interpolation, 0.0);
+      EXPECT_LT(contact.percent_interpolation, 1.0);
+    }
+  }
+  res.clear();
+
+  // without contacts, the check stops at the first collision
+  req.contacts = false;
+  c_env_->checkRobotCollision(req, res, state1, state2);
+  ASSERT_TRUE(res.collision);
+  res.clear();
+}
+
+/** \brief Distance queries ignore objects beyond the distance threshold and stop below the stop threshold. */
+TEST_F(CollisionDetectionEnvTest, BoundedDistance)
+{
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  Eigen::Isometry3d pos = Eigen::Isometry3d::Identity();
+  pos.translation().x() = 1.0;
+  pos.translation().z() = 0.3;
+  c_env_->getWorld()->addToObject("box", shape_ptr, pos);
+
+  collision_detection::CollisionRequest req;
+  req.distance = true;
+  collision_detection::CollisionResult res;
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  ASSERT_FALSE(res.collision);
+  const double distance = res.distance;
+  ASSERT_GT(distance, 0.1);
+  ASSERT_LT(distance, 1.0);
+  res.clear();
+
+  req.distance_threshold = distance + 0.01;
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_NEAR(res.distance, distance, 1e-6);
+  res.clear();
+
+  req.distance_threshold = distance - 0.01;
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_EQ(res.distance, std::numeric_limits<double>::max());
   res.clear();
+
+  // the query stops at the first link closer than the stop threshold, which need not be the closest one
+  req.distance_threshold = std::numeric_limits<double>::max();
+  req.distance_stop_threshold = 10.0;
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_LT(res.distance, 10.0);
+  EXPECT_GE(res.distance, distance - 1e-6);
+}
+
+/** \brief Query statistics are only collected when enabled and count each query once. */
+TEST_F(CollisionDetectionEnvTest, QueryStatistics)
+{
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  EXPECT_EQ(c_env_->getStatistics().collision_queries, 0u);
+  EXPECT_GT(res.broadphase_pairs, 0u);
+  res.clear();
+
+  c_env_->setStatisticsEnabled(true);
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  collision_detection::CollisionStatistics stats = c_env_->getStatistics();
+  EXPECT_EQ(stats.collision_queries, 2u);
+  EXPECT_EQ(stats.distance_queries, 0u);
+  EXPECT_EQ(stats.broadphase_pairs, res.broadphase_pairs);
+  EXPECT_EQ(stats.narrowphase_tests, res.narrowphase_tests);
+  // pairs allowed to collide by the ACM are filtered before the narrowphase
+  EXPECT_LT(stats.narrowphase_tests, stats.broadphase_pairs);
+  EXPECT_GT(stats.collision_time, 0.0);
+
+  collision_detection::DistanceRequest dreq;
+  collision_detection::DistanceResult dres;
+  dreq.acm = acm_.get();
+  c_env_->distanceSelf(dreq, dres, *robot_state_);
+  stats = c_env_->getStatistics();
+  EXPECT_EQ(stats.distance_queries, 1u);
+  EXPECT_EQ(stats.narrowphase_tests, res.narrowphase_tests + dres.narrowphase_tests);
+
+  c_env_->resetStatistics();
+  stats = c_env_->getStatistics();
+  EXPECT_EQ(stats.collision_queries, 0u);
+  EXPECT_EQ(stats.broadphase_pairs, 0u);
+  EXPECT_EQ(stats.collision_time, 0.0);
+}
+
+/** \brief An overlay sees the objects of its parent except the ones it changed, and leaves the parent alone */
+TEST_F(CollisionDetectionEnvTest, Overlay)
+{
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  Eigen::Isometry3d near = Eigen::Isometry3d::Identity();
+  near.translation().z() = 0.3;
+  Eigen::Isometry3d far = Eigen::Isometry3d::Identity();
+  far.translation().x() = 1.0;
+  far.translation().z() = 0.3;
+
+  auto world = std::make_shared<collision_detection::World>();
+  world->addToObject("box", shape_ptr, near);
+  world->addToObject("far_box", shape_ptr, far);
+  auto parent = std::make_shared<const collision_detection::CollisionEnvFCL>(robot_model_, world);
+
+  const auto check = [this](const collision_detection::CollisionEnv& env) {
+    collision_detection::CollisionRequest req;
+    collision_detection::CollisionResult res;
+    env.checkRobotCollision(req, res, *robot_state_, *acm_);
+    return res.collision;
+  };
+  const auto distance = [this](const collision_detection::CollisionEnv& env) {
+    collision_detection::DistanceRequest req;
+    collision_detection::DistanceResult res;
+    req.acm = acm_.get();
+    req.enableGroup(robot_model_);
+    env.distanceRobot(req, res, *robot_state_);
+    return res.minimum_distance.distance;
+  };
+
+  collision_detection::CollisionEnvFCL overlay(parent, std::make_shared<collision_detection::World>(*world));
+  EXPECT_TRUE(check(overlay));
+
+  // moving the parent's object away hides its copy in the parent
+  overlay.getWorld()->moveObject("box", far);
+  EXPECT_FALSE(check(overlay));
+  EXPECT_TRUE(check(*parent));
+  EXPECT_GT(distance(overlay), 0.0);
+  EXPECT_NEAR(distance(overlay), distance(collision_detection::CollisionEnvFCL(robot_model_, overlay.getWorld())),
+              1e-6);
+
+  overlay.getWorld()->addToObject("other_box", shape_ptr, near);
+  EXPECT_TRUE(check(overlay));
+  EXPECT_FALSE(parent->getWorld()->hasObject("other_box"));
+
+  // a copy of an overlay holds all of its objects, an overlay of the copy refers to the copy
+  auto overlay_ptr = std::make_shared<const collision_detection::CollisionEnvFCL>(
+      overlay, std::make_shared<collision_detection::World>(*overlay.getWorld()));
+  collision_detection::CollisionEnvFCL nested(overlay_ptr, std::make_shared<collision_detection::World>(
+                                                               *overlay_ptr->getWorld()));
+  EXPECT_TRUE(check(nested));
+  nested.getWorld()->removeObject("other_box");
+  EXPECT_FALSE(check(nested));
+  EXPECT_TRUE(check(overlay));
+
+  nested.getWorld()->removeObject("far_box");
+  nested.getWorld()->removeObject("box");
+  EXPECT_EQ(distance(nested), std::numeric_limits<double>::max());
+  EXPECT_TRUE(check(*parent));
+
+  // changes to the parent after copying an overlay don't show up in the copy
+  auto other_world = std::make_shared<collision_detection::World>();
+  other_world->addToObject("far_box", shape_ptr, far);
+  auto other_parent = std::make_shared<const collision_detection::CollisionEnvFCL>(robot_model_, other_world);
+  collision_detection::CollisionEnvFCL other_overlay(other_parent,
+                                                     std::make_shared<collision_detection::World>(*other_world));
+  collision_detection::CollisionEnvFCL copy(other_overlay,
+                                            std::make_shared<collision_detection::World>(*other_overlay.getWorld()));
+  other_world->addToObject("box", shape_ptr, near);
+  EXPECT_TRUE(check(*other_parent));
+  EXPECT_FALSE(check(copy));
+  EXPECT_GT(distance(copy), 0.0);
+  EXPECT_LT(distance(copy), std::numeric_limits<double>::max());
+}
+
+/** \brief Cached robot-world results are reused for the same state, and dropped when the world changes */
+TEST_F(CollisionDetectionEnvTest, RobotCollisionCache)
+{
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  Eigen::Isometry3d near = Eigen::Isometry3d::Identity();
+  near.translation().z() = 0.3;
+  Eigen::Isometry3d away = Eigen::Isometry3d::Identity();
+  away.translation().x() = 5.0;
+
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  env.getWorld()->addToObject("box", shape_ptr, near);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  const auto check = [&]() {
+    res.clear();
+    env.checkRobotCollision(req, res, *robot_state_, *acm_);
+    return res.collision;
+  };
+
+  // disabled by default
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.broadphase_pairs, 0u);
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.broadphase_pairs, 0u);
+
+  env.setRobotCollisionCacheSize(8);
+  EXPECT_EQ(env.getRobotCollisionCacheSize(), 8u);
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.broadphase_pairs, 0u);
+  // the second check of the same state is answered without the broadphase
+  EXPECT_TRUE(check());
+  EXPECT_EQ(res.broadphase_pairs, 0u);
+
+  // queries for more than the collision flag are not cached
+  req.contacts = true;
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.contact_count, 0u);
+  req.contacts = false;
+
+  // other objects don't affect a collision with the box
+  env.getWorld()->addToObject("other_box", shape_ptr, away);
+  EXPECT_TRUE(check());
+  EXPECT_EQ(res.broadphase_pairs, 0u);
+
+  env.getWorld()->moveObject("box", away);
+  EXPECT_FALSE(check());
+
+  // a collision-free result is dropped when an object moves close to the robot
+  EXPECT_FALSE(check());
+  env.getWorld()->setObjectPose("other_box", near);
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.broadphase_pairs, 0u);
+
+  env.getWorld()->removeObject("other_box");
+  EXPECT_FALSE(check());
+
+  // a different allowed collision matrix needs a new check
+  env.getWorld()->setObjectPose("box", near);
+  EXPECT_TRUE(check());
+  collision_detection::AllowedCollisionMatrix acm(*acm_);
+  acm.setDefaultEntry("box", true);
+  res.clear();
+  env.checkRobotCollision(req, res, *robot_state_, acm);
+  EXPECT_FALSE(res.collision);
+}
+
+/** \brief Padded link geometry is shared by all users of the same scale and padding */
+TEST_F(CollisionDetectionEnvTest, SharedPaddedGeometry)
+{
+  const moveit::core::LinkModel* link = robot_model_->getLinkModel("panda_link1");
+  const shapes::ShapeConstPtr& shape = link->getShapes()[0];
+
+  collision_detection::FCLGeometryConstPtr padded =
+      collision_detection::createCollisionGeometry(shape, 1.0, 0.05, link, 0);
+  ASSERT_TRUE(padded);
+  EXPECT_EQ(padded, collision_detection::createCollisionGeometry(shape, 1.0, 0.05, link, 0));
+  EXPECT_NE(padded, collision_detection::createCollisionGeometry(shape, 1.0, 0.1, link, 0));
+  EXPECT_NE(padded, collision_detection::createCollisionGeometry(shape, 1.1, 0.05, link, 0));
+
+  // environments with the same padding share the geometry
+  collision_detection::CollisionEnvFCL env1(robot_model_, 0.05);
+  collision_detection::CollisionEnvFCL env2(robot_model_);
+  env2.setPadding(0.05);
+  shapes::ShapeConstPtr box = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().z() = 0.3;
+  env1.getWorld()->addToObject("box", box, pose);
+  env2.getWorld()->addToObject("box", box, pose);
+
+  collision_detection::DistanceRequest req;
+  req.acm = acm_.get();
+  collision_detection::DistanceResult res1, res2;
+  env1.distanceRobot(req, res1, *robot_state_);
+  env2.distanceRobot(req, res2, *robot_state_);
+  EXPECT_DOUBLE_EQ(res1.minimum_distance.distance, res2.minimum_distance.distance);
+  EXPECT_EQ(padded, collision_detection::createCollisionGeometry(shape, 1.0, 0.05, link, 0));
+}
+
+/** \brief The broadphase is skipped while the robot's bounding volumes are apart from all world objects */
+TEST_F(CollisionDetectionEnvTest, WorldAABBEarlyOut)
+{
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  const auto check = [&]() {
+    res.clear();
+    env.checkRobotCollision(req, res, *robot_state_, *acm_);
+    return res.collision;
+  };
+
+  EXPECT_FALSE(check());
+  EXPECT_EQ(res.broadphase_pairs, 0u);
+
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<shapes::Box>(0.1, 0.1, 0.1);
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 3.0;
+  env.getWorld()->addToObject("box", shape_ptr, pose);
+  EXPECT_FALSE(check());
+  EXPECT_EQ(res.broadphase_pairs, 0u);
+
+  // the world AABB follows the objects
+  env.getWorld()->setObjectPose("box", Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, 0.3)));
+  EXPECT_TRUE(check());
+  EXPECT_GT(res.broadphase_pairs, 0u);
+
+  // objects on both sides of the robot have a world AABB around it, the broadphase still finds no collision
+  env.getWorld()->setObjectPose("box", pose);
+  pose.translation().x() = -3.0;
+  env.getWorld()->addToObject("other_box", shape_ptr, pose);
+  EXPECT_FALSE(check());
+
+  env.getWorld()->removeObject("other_box");
+  EXPECT_FALSE(check());
+  EXPECT_EQ(res.broadphase_pairs, 0u);
+}
+
+/** \brief The links of the hand move rigidly with the last arm link while only the arm moves */
+TEST_F(CollisionDetectionEnvTest, RigidLinkPairs)
+{
+  const collision_detection::RigidLinkPairs rigid_link_pairs =
+      collision_detection::getRigidLinkPairs(*robot_model_->getJointModelGroup("panda_arm"));
+
+  std::set<std::pair<std::string, std::string>> pairs;
+  for (const auto& [link1, link2] : rigid_link_pairs.pairs)
+    pairs.emplace(std::min(link1->getName(), link2->getName()), std::max(link1->getName(), link2->getName()));
+  EXPECT_TRUE(pairs.count({ "panda_hand", "panda_link7" }));
+  EXPECT_TRUE(pairs.count({ "panda_leftfinger", "panda_rightfinger" }));
+  EXPECT_TRUE(pairs.count({ "panda_leftfinger", "panda_link7" }));
+  EXPECT_FALSE(pairs.count({ "panda_link6", "panda_link7" }));
+  EXPECT_FALSE(pairs.count({ "panda_link0", "panda_link1" }));
+
+  // the finger joints are frozen, the arm joints are not
+  std::set<std::string> frozen;
+  for (std::size_t index : rigid_link_pairs.frozen_variables)
+    frozen.insert(robot_model_->getVariableNames()[index]);
+  EXPECT_TRUE(frozen.count("panda_finger_joint1"));
+  EXPECT_FALSE(frozen.count("panda_joint7"));
+
+  // self-collision checks for the group skip the pairs, but find the same collisions
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionRequest group_req;
+  group_req.group_name = "panda_arm";
+  random_numbers::RandomNumberGenerator rng(42);
+  std::size_t narrowphase_tests = 0;
+  std::size_t group_narrowphase_tests = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    robot_state_->setToRandomPositions(robot_model_->getJointModelGroup("panda_arm"), rng);
+    robot_state_->update();
+    collision_detection::CollisionResult res;
+    collision_detection::CollisionResult group_res;
+    env.checkSelfCollision(req, res, *robot_state_, *acm_);
+    env.checkSelfCollision(group_req, group_res, *robot_state_, *acm_);
+    EXPECT_EQ(res.collision, group_res.collision);
+    narrowphase_tests += res.narrowphase_tests;
+    group_narrowphase_tests += group_res.narrowphase_tests;
+  }
+  EXPECT_LE(group_narrowphase_tests, narrowphase_tests);
 }
 
 int main(int argc, char** argv)
@@ -40,6 +40,7 @@
 #include <string>
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include <float.h>
 
 #include <geometric_shapes/shapes.h>
@@ -353,6 +354,7 @@ public:
 
   PosedBodyPointDecomposition(const BodyDecompositionConstPtr& body_decomposition, const Eigen::Isometry3d& pose);
 
+  /** \brief Decompose an octree into one point per occupied cell at the finest tree resolution */
   PosedBodyPointDecomposition(const std::shared_ptr<const octomap::OcTree>& octree);
 
   const EigenSTL::vector_Vector3d& getCollisionPoints() const
@@ -362,9 +364,30 @@ public:
   // the collision spheres, and the posed collision points
   void updatePose(const Eigen::Isometry3d& linkTransform);
 
+  /** \brief The octree this decomposition was built from, or nullptr for body decompositions */
+  const std::shared_ptr<const octomap::OcTree>& getOctree() const
+  {
+    return octree_;
+  }
+
+  /** \brief Bring the points of an octree decomposition in sync with the keys the octree reports as changed.
+   *
+   * Requires change detection to be enabled on the octree; the caller is responsible for resetting it once the
+   * changes have been consumed. Points of cells that became occupied are appended to \e added_points, points of
+   * cells that stopped being occupied are appended to \e removed_points.
+   * \return false if this is not an octree decomposition or the octree does not track changes */
+  bool updateFromOctreeChanges(EigenSTL::vector_Vector3d& added_points, EigenSTL::vector_Vector3d& removed_points);
+
 protected:
+  void addOctreeCell(const octomap::OcTreeKey& key);
+
   BodyDecompositionConstPtr body_decomposition_;
   EigenSTL::vector_Vector3d posed_collision_points_;
+
+  std::shared_ptr<const octomap::OcTree> octree_;
+  // octree key of each entry in posed_collision_points_ and the reverse lookup
+  std::vector<octomap::OcTreeKey> octree_keys_;
+  std::unordered_map<octomap::OcTreeKey, std::size_t, octomap::OcTreeKey::KeyHash> octree_key_indices_;
 };
 
 class PosedBodySphereDecompositionVector
@@ -207,6 +207,7 @@ public:
 
   collision_detection::GroupStateRepresentationConstPtr getLastGroupStateRepresentation() const
   {
+    std::scoped_lock lock(last_gsr_lock_);
     return last_gsr_;
   }
 
@@ -216,6 +217,13 @@ public:
   void getAllCollisions(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                         const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
+  /** \brief Check whether any collision sphere of the links of \e group_name (all links if empty) or of the attached
+   *  bodies is closer than \e margin to the environment. Distances beyond the maximum propagation distance of the
+   *  field are not detected. Spheres reaching closer than \e margin to the bounds of the field are always reported as
+   *  near, as obstacles outside of the field are not represented in it. */
+  bool isRobotNearEnvironment(const std::string& group_name, const moveit::core::RobotState& state,
+                              double margin) const;
+
 protected:
   bool getSelfProximityGradients(GroupStateRepresentationPtr& gsr) const;
 
@@ -274,6 +282,11 @@ protected:
   void updateDistanceObject(const std::string& id, CollisionEnvDistanceField::DistanceFieldCacheEntryWorldPtr& dfce,
                             EigenSTL::vector_Vector3d& add_points, EigenSTL::vector_Vector3d& subtract_points);
 
+  /** \brief Apply the changed cells of an octree object that is already part of \e dfce.
+   * \return false if the object has to go through updateDistanceObject() instead */
+  bool updateOctreeDistanceObject(const ObjectConstPtr& obj, DistanceFieldCacheEntryWorldPtr& dfce,
+                                  EigenSTL::vector_Vector3d& add_points, EigenSTL::vector_Vector3d& subtract_points);
+
   bool getEnvironmentCollisions(const CollisionRequest& req, CollisionResult& res,
                                 const distance_field::DistanceFieldConstPtr& env_distance_field,
                                 GroupStateRepresentationPtr& gsr) const;
@@ -305,7 +318,12 @@ protected:
 
   mutable std::mutex update_cache_lock_world_;
   DistanceFieldCacheEntryWorldPtr distance_field_cache_entry_world_;
-  GroupStateRepresentationPtr last_gsr_;
+
+  /** \brief Remember the representation of the last query; guarded so that queries may run concurrently */
+  void setLastGroupStateRepresentation(const GroupStateRepresentationPtr& gsr) const;
+
+  mutable std::mutex last_gsr_lock_;
+  mutable GroupStateRepresentationPtr last_gsr_;
   World::ObserverHandle observer_handle_;
 };
 }  // namespace collision_detection
@@ -43,6 +43,18 @@
 
 namespace collision_detection
 {
+/** \brief How CollisionEnvHybrid::checkRobotCollision() combines FCL and the distance field */
+enum class HybridCollisionCheckMode
+{
+  /** \brief Only FCL checks for collisions */
+  FCL,
+  /** \brief FCL and the distance field check in parallel, either reporting a collision is a collision */
+  PARALLEL,
+  /** \brief The distance field checks first, FCL only checks if some collision sphere is within the proximity margin
+   *  of the environment */
+  DISTANCE_FIELD_FIRST
+};
+
 /** \brief This hybrid collision environment combines FCL and a distance field. Both can be used to calculate
  *  collisions. */
 class CollisionEnvHybrid : public collision_detection::CollisionEnvFCL
@@ -134,6 +146,40 @@ public:
 
   void setWorld(const WorldPtr& world) override;
 
+  void checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                           const moveit::core::RobotState& state) const override;
+
+  void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
+                           const AllowedCollisionMatrix& acm) const override;
+
+  // the continuous checks are not changed
+  using CollisionEnvFCL::checkRobotCollision;
+
+  /** \brief Set how checkRobotCollision() combines FCL and the distance field, FCL only by default */
+  void setRobotCollisionCheckMode(HybridCollisionCheckMode mode)
+  {
+    robot_collision_check_mode_ = mode;
+  }
+
+  HybridCollisionCheckMode getRobotCollisionCheckMode() const
+  {
+    return robot_collision_check_mode_;
+  }
+
+  /** \brief Set the distance to the environment below which HybridCollisionCheckMode::DISTANCE_FIELD_FIRST runs FCL.
+   *
+   *  The collision spheres only approximate the link geometry, so the margin should cover how far the geometry can
+   *  stick out of the spheres, e.g. a few cells of the distance field. */
+  void setProximityMargin(double margin)
+  {
+    proximity_margin_ = margin;
+  }
+
+  double getProximityMargin() const
+  {
+    return proximity_margin_;
+  }
+
   void getCollisionGradients(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                              const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
@@ -146,6 +192,12 @@ public:
   }
 
 protected:
+  /** \brief Check with FCL, combined with the distance field according to the robot collision check mode */
+  void checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
+
   CollisionEnvDistanceFieldPtr cenv_distance_;
+  HybridCollisionCheckMode robot_collision_check_mode_ = HybridCollisionCheckMode::FCL;
+  double proximity_margin_ = DEFAULT_RESOLUTION * 2.0;
 };
 }  // namespace collision_detection
@@ -43,8 +43,6 @@
 #include <rclcpp/time.hpp>
 #include <memory>
 
-const static double EPSILON{ 0.0001 };
-
 namespace collision_detection
 {
 static const rclcpp::Logger LOGGER =
@@ -141,6 +139,48 @@ bool PosedDistanceField::getCollisionSphereGradients(const std::vector<Collision
   return in_collision;
 }
 
+namespace
+{
+/** \brief Structure-of-arrays buffers for querying the distance field for all spheres of a link at once.
+ *
+ *  The buffers only grow, and are kept per thread so the collision checks do not allocate. */
+struct SphereDistanceQuery
+{
+  Eigen::MatrixX3d centers;
+  Eigen::VectorXd distances;
+  Eigen::MatrixX3d gradients;
+
+  // Query the distances and gradients of the first \e count sphere centers, either of the closest cells or
+  // interpolated between the cells around each center
+  void query(const distance_field::DistanceField* distance_field, const EigenSTL::vector_Vector3d& sphere_centers,
+             std::size_t count, bool interpolate = false)
+  {
+    const Eigen::Index n = static_cast<Eigen::Index>(count);
+    if (centers.rows() < n)
+    {
+      centers.resize(n, 3);
+      distances.resize(n);
+      gradients.resize(n, 3);
+    }
+    for (Eigen::Index i = 0; i < n; ++i)
+      centers.row(i) = sphere_centers[i].transpose();
+
+    // Points out of bounds get the uninitialized distance and a zero gradient, so they are treated like any point far
+    // away from obstacles by the checks below
+    if (interpolate)
+      distance_field->getInterpolatedDistanceGradients(centers.topRows(n), distances.head(n), gradients.topRows(n));
+    else
+      distance_field->getDistanceGradients(centers.topRows(n), distances.head(n), gradients.topRows(n));
+  }
+};
+
+SphereDistanceQuery& getSphereDistanceQuery()
+{
+  static thread_local SphereDistanceQuery query;
+  return query;
+}
+}  // namespace
+
 bool getCollisionSphereGradients(const distance_field::DistanceField* distance_field,
                                  const std::vector<CollisionSphere>& sphere_list,
                                  const EigenSTL::vector_Vector3d& sphere_centers, GradientInfo& gradient,
@@ -149,19 +189,15 @@ bool getCollisionSphereGradients(const distance_field::DistanceField* distance_f
 {
   // assumes gradient is properly initialized
 
+  // interpolate, so the distances and gradients used by optimizing planners like CHOMP change continuously with the
+  // sphere positions
+  SphereDistanceQuery& query = getSphereDistanceQuery();
+  query.query(distance_field, sphere_centers, sphere_list.size(), true);
+
   bool in_collision{ false };
   for (unsigned int i{ 0 }; i < sphere_list.size(); ++i)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && grad.norm() > EPSILON)
-    {
-      RCLCPP_DEBUG(LOGGER, "Collision sphere point is out of bounds %lf, %lf, %lf", p.x(), p.y(), p.z());
-      return true;
-    }
-
+    double dist = query.distances[i];
     if (dist < maximum_value)
     {
       if (subtract_radii)
@@ -190,7 +226,7 @@ bool getCollisionSphereGradients(const distance_field::DistanceField* distance_f
       {
         gradient.types[i] = type;
         gradient.distances[i] = dist;
-        gradient.gradients[i] = grad;
+        gradient.gradients[i] = query.gradients.row(i).transpose();
       }
     }
 
@@ -207,19 +243,12 @@ bool getCollisionSphereCollision(const distance_field::DistanceField* distance_f
                                  const EigenSTL::vector_Vector3d& sphere_centers, double maximum_value,
                                  double tolerance)
 {
+  SphereDistanceQuery& query = getSphereDistanceQuery();
+  query.query(distance_field, sphere_centers, sphere_list.size());
+
   for (unsigned int i{ 0 }; i < sphere_list.size(); ++i)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds = true;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-
-    if (!in_bounds && grad.norm() > 0)
-    {
-      RCLCPP_DEBUG(LOGGER, "Collision sphere point is out of bounds");
-      return true;
-    }
-
+    const double dist = query.distances[i];
     if ((maximum_value > dist) && (sphere_list[i].radius_ - dist > tolerance))
     {
       return true;
@@ -235,17 +264,12 @@ bool getCollisionSphereCollision(const distance_field::DistanceField* distance_f
                                  double tolerance, unsigned int num_coll, std::vector<unsigned int>& colls)
 {
   colls.clear();
+  SphereDistanceQuery& query = getSphereDistanceQuery();
+  query.query(distance_field, sphere_centers, sphere_list.size());
+
   for (unsigned int i = 0; i < sphere_list.size(); ++i)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds{ true };
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && (grad.norm() > 0))
-    {
-      RCLCPP_DEBUG(LOGGER, "Collision sphere point is out of bounds");
-      return true;
-    }
+    const double dist = query.distances[i];
     if (maximum_value > dist && (sphere_list[i].radius_ - dist > tolerance))
     {
       if (num_coll == 0)
@@ -347,15 +371,78 @@ PosedBodyPointDecomposition::PosedBodyPointDecomposition(const BodyDecomposition
 }
 
 PosedBodyPointDecomposition::PosedBodyPointDecomposition(const std::shared_ptr<const octomap::OcTree>& octree)
-  : body_decomposition_()
+  : body_decomposition_(), octree_(octree)
 {
-  int num_nodes = octree->getNumLeafNodes();
-  posed_collision_points_.reserve(num_nodes);
-  for (octomap::OcTree::tree_iterator tree_iter = octree->begin_tree(); tree_iter != octree->end_tree(); ++tree_iter)
+  const unsigned int tree_depth = octree->getTreeDepth();
+  posed_collision_points_.reserve(octree->getNumLeafNodes());
+  for (octomap::OcTree::leaf_iterator leaf_iter = octree->begin_leafs(); leaf_iter != octree->end_leafs(); ++leaf_iter)
   {
-    Eigen::Vector3d p = Eigen::Vector3d(tree_iter.getX(), tree_iter.getY(), tree_iter.getZ());
-    posed_collision_points_.push_back(p);
+    if (!octree->isNodeOccupied(*leaf_iter))
+      continue;
+
+    // pruned leaves cover several cells; expand them so every point matches one key the octree can report as changed
+    const octomap::OcTreeKey base_key = leaf_iter.getIndexKey();
+    const unsigned int cells_per_axis = 1u << (tree_depth - leaf_iter.getDepth());
+    octomap::OcTreeKey key;
+    for (unsigned int dx = 0; dx < cells_per_axis; ++dx)
+    {
+      key[0] = base_key[0] + dx;
+      for (unsigned int dy = 0; dy < cells_per_axis; ++dy)
+      {
+        key[1] = base_key[1] + dy;
+        for (unsigned int dz = 0; dz < cells_per_axis; ++dz)
+        {
+          key[2] = base_key[2] + dz;
+          addOctreeCell(key);
+        }
+      }
+    }
+  }
+}
+
+void PosedBodyPointDecomposition::addOctreeCell(const octomap::OcTreeKey& key)
+{
+  const octomap::point3d p = octree_->keyToCoord(key);
+  octree_key_indices_[key] = posed_collision_points_.size();
+  octree_keys_.push_back(key);
+  posed_collision_points_.emplace_back(p.x(), p.y(), p.z());
+}
+
+bool PosedBodyPointDecomposition::updateFromOctreeChanges(EigenSTL::vector_Vector3d& added_points,
+                                                          EigenSTL::vector_Vector3d& removed_points)
+{
+  if (!octree_ || !octree_->isChangeDetectionEnabled())
+    return false;
+
+  for (octomap::KeyBoolMap::const_iterator it = octree_->changedKeysBegin(); it != octree_->changedKeysEnd(); ++it)
+  {
+    const octomap::OcTreeKey& key = it->first;
+    const octomap::OcTreeNode* node = octree_->search(key);
+    const bool occupied = node && octree_->isNodeOccupied(node);
+    const auto index_it = octree_key_indices_.find(key);
+
+    if (occupied && index_it == octree_key_indices_.end())
+    {
+      addOctreeCell(key);
+      added_points.push_back(posed_collision_points_.back());
+    }
+    else if (!occupied && index_it != octree_key_indices_.end())
+    {
+      // swap-remove, keeping the reverse lookup of the moved entry valid
+      const std::size_t index = index_it->second;
+      removed_points.push_back(posed_collision_points_[index]);
+      octree_key_indices_.erase(index_it);
+      if (index + 1 != posed_collision_points_.size())
+      {
+        posed_collision_points_[index] = posed_collision_points_.back();
+        octree_keys_[index] = octree_keys_.back();
+        octree_key_indices_[octree_keys_[index]] = index;
+      }
+      posed_collision_points_.pop_back();
+      octree_keys_.pop_back();
+    }
   }
+  return true;
 }
 
 void PosedBodyPointDecomposition::updatePose(const Eigen::Isometry3d& trans)
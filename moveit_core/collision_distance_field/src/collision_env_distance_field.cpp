@@ -45,6 +45,7 @@
 #include <moveit/collision_distance_field/collision_common_distance_field.h>
 #include <moveit/distance_field/propagation_distance_field.h>
 #include <moveit/collision_distance_field/collision_detector_allocator_distance_field.h>
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -180,9 +181,10 @@ void CollisionEnvDistanceField::checkSelfCollisionHelper(const collision_detecti
                                                          const collision_detection::AllowedCollisionMatrix* acm,
                                                          GroupStateRepresentationPtr& gsr) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, acm, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, acm, gsr, true);
   }
   else
   {
@@ -1390,9 +1392,10 @@ void CollisionEnvDistanceField::checkCollision(const CollisionRequest& req, Coll
                                                const moveit::core::RobotState& state,
                                                GroupStateRepresentationPtr& gsr) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, nullptr, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, nullptr, gsr, true);
   }
   else
   {
@@ -1408,7 +1411,7 @@ void CollisionEnvDistanceField::checkCollision(const CollisionRequest& req, Coll
     getEnvironmentCollisions(req, res, distance_field_cache_entry_world_->distance_field_, gsr);
   }
 
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 }
 
 void CollisionEnvDistanceField::checkCollision(const CollisionRequest& req, CollisionResult& res,
@@ -1423,9 +1426,10 @@ void CollisionEnvDistanceField::checkCollision(const CollisionRequest& req, Coll
                                                const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
                                                GroupStateRepresentationPtr& gsr) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, &acm, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, &acm, gsr, true);
   }
   else
   {
@@ -1441,7 +1445,7 @@ void CollisionEnvDistanceField::checkCollision(const CollisionRequest& req, Coll
     getEnvironmentCollisions(req, res, distance_field_cache_entry_world_->distance_field_, gsr);
   }
 
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 }
 
 void CollisionEnvDistanceField::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
@@ -1455,17 +1459,18 @@ void CollisionEnvDistanceField::checkRobotCollision(const CollisionRequest& req,
                                                     const moveit::core::RobotState& state,
                                                     GroupStateRepresentationPtr& gsr) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
   distance_field::DistanceFieldConstPtr env_distance_field = distance_field_cache_entry_world_->distance_field_;
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, nullptr, gsr, false);
+    generateCollisionCheckingStructures(req.getGroupName(), state, nullptr, gsr, false);
   }
   else
   {
     updateGroupStateRepresentationState(state, gsr);
   }
   getEnvironmentCollisions(req, res, env_distance_field, gsr);
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 
   // checkRobotCollisionHelper(req, res, robot, state, &acm);
 }
@@ -1483,18 +1488,19 @@ void CollisionEnvDistanceField::checkRobotCollision(const CollisionRequest& req,
                                                     const AllowedCollisionMatrix& acm,
                                                     GroupStateRepresentationPtr& gsr) const
 {
+  QueryRecorder<CollisionResult> recorder(*this, res);
   distance_field::DistanceFieldConstPtr env_distance_field = distance_field_cache_entry_world_->distance_field_;
 
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, &acm, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, &acm, gsr, true);
   }
   else
   {
     updateGroupStateRepresentationState(state, gsr);
   }
   getEnvironmentCollisions(req, res, env_distance_field, gsr);
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 
   // checkRobotCollisionHelper(req, res, robot, state, &acm);
 }
@@ -1514,6 +1520,12 @@ void CollisionEnvDistanceField::checkRobotCollision(const CollisionRequest& /*re
   RCLCPP_ERROR(LOGGER, "Continuous collision checking not implemented");
 }
 
+void CollisionEnvDistanceField::setLastGroupStateRepresentation(const GroupStateRepresentationPtr& gsr) const
+{
+  std::scoped_lock lock(last_gsr_lock_);
+  last_gsr_ = gsr;
+}
+
 void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& req, CollisionResult& /*res*/,
                                                       const moveit::core::RobotState& state,
                                                       const AllowedCollisionMatrix* acm,
@@ -1523,7 +1535,7 @@ void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& re
 
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, acm, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, acm, gsr, true);
   }
   else
   {
@@ -1534,7 +1546,7 @@ void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& re
   getIntraGroupProximityGradients(gsr);
   getEnvironmentProximityGradients(env_distance_field, gsr);
 
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 }
 
 void CollisionEnvDistanceField::getAllCollisions(const CollisionRequest& req, CollisionResult& res,
@@ -1544,7 +1556,7 @@ void CollisionEnvDistanceField::getAllCollisions(const CollisionRequest& req, Co
 {
   if (!gsr)
   {
-    generateCollisionCheckingStructures(req.group_name, state, acm, gsr, true);
+    generateCollisionCheckingStructures(req.getGroupName(), state, acm, gsr, true);
   }
   else
   {
@@ -1555,7 +1567,44 @@ void CollisionEnvDistanceField::getAllCollisions(const CollisionRequest& req, Co
   distance_field::DistanceFieldConstPtr env_distance_field = distance_field_cache_entry_world_->distance_field_;
   getEnvironmentCollisions(req, res, env_distance_field, gsr);
 
-  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
+}
+
+bool CollisionEnvDistanceField::isRobotNearEnvironment(const std::string& group_name,
+                                                       const moveit::core::RobotState& state, double margin) const
+{
+  distance_field::DistanceFieldConstPtr env_distance_field = distance_field_cache_entry_world_->distance_field_;
+  GroupStateRepresentationPtr gsr;
+  generateCollisionCheckingStructures(group_name, state, nullptr, gsr, false);
+
+  // obstacles outside of the field are not represented in it, so spheres that might be near them count as near
+  const Eigen::Array3d field_min(env_distance_field->getOriginX(), env_distance_field->getOriginY(),
+                                 env_distance_field->getOriginZ());
+  const Eigen::Array3d field_max =
+      field_min +
+      Eigen::Array3d(env_distance_field->getSizeX(), env_distance_field->getSizeY(), env_distance_field->getSizeZ());
+  const auto leaves_field = [&](const std::vector<CollisionSphere>& spheres, const EigenSTL::vector_Vector3d& centers) {
+    for (std::size_t i = 0; i < spheres.size(); ++i)
+    {
+      const double extent = spheres[i].radius_ + margin;
+      if ((centers[i].array() - extent < field_min).any() || (centers[i].array() + extent > field_max).any())
+        return true;
+    }
+    return false;
+  };
+
+  // a negative tolerance reports spheres that are up to margin away from the environment
+  const auto is_near = [&](const auto& decomposition) {
+    return leaves_field(decomposition->getCollisionSpheres(), decomposition->getSphereCenters()) ||
+           getCollisionSphereCollision(env_distance_field.get(), decomposition->getCollisionSpheres(),
+                                       decomposition->getSphereCenters(), max_propogation_distance_, -margin);
+  };
+  for (std::size_t i = 0; i < gsr->dfce_->link_names_.size(); ++i)
+  {
+    if (gsr->dfce_->link_has_geometry_[i] && is_near(gsr->link_body_decompositions_[i]))
+      return true;
+  }
+  return std::any_of(gsr->attached_body_decompositions_.begin(), gsr->attached_body_decompositions_.end(), is_near);
 }
 
 bool CollisionEnvDistanceField::getEnvironmentCollisions(const CollisionRequest& req, CollisionResult& res,
@@ -1708,6 +1757,15 @@ void CollisionEnvDistanceField::notifyObjectChange(const ObjectConstPtr& obj, Wo
 
   EigenSTL::vector_Vector3d add_points;
   EigenSTL::vector_Vector3d subtract_points;
+  if (action == World::MOVE_SHAPE &&
+      updateOctreeDistanceObject(obj, distance_field_cache_entry_world_, add_points, subtract_points))
+  {
+    // only the cells the octree reported as changed are touched
+    distance_field_cache_entry_world_->distance_field_->updatePointsInField(subtract_points, add_points);
+    RCLCPP_DEBUG(LOGGER, "Incrementally updating octree %s (%zu added, %zu removed cells) took %lf s",
+                 obj->id_.c_str(), add_points.size(), subtract_points.size(), (clock.now() - start_time).seconds());
+    return;
+  }
   updateDistanceObject(obj->id_, distance_field_cache_entry_world_, add_points, subtract_points);
 
   if (action == World::DESTROY)
@@ -1778,6 +1836,28 @@ void CollisionEnvDistanceField::updateDistanceObject(const std::string& id, Dist
   }
 }
 
+bool CollisionEnvDistanceField::updateOctreeDistanceObject(const ObjectConstPtr& obj,
+                                                           DistanceFieldCacheEntryWorldPtr& dfce,
+                                                           EigenSTL::vector_Vector3d& add_points,
+                                                           EigenSTL::vector_Vector3d& subtract_points)
+{
+  if (obj->shapes_.size() != 1 || obj->shapes_[0]->type != shapes::OCTREE)
+    return false;
+
+  const auto cur_it = dfce->posed_body_point_decompositions_.find(obj->id_);
+  if (cur_it == dfce->posed_body_point_decompositions_.end() || cur_it->second.size() != 1)
+    return false;
+
+  // the octree object is decomposed in world coordinates regardless of its pose, so only a content change of the
+  // same octree instance can be applied incrementally
+  const shapes::OcTree* octree_shape = static_cast<const shapes::OcTree*>(obj->shapes_[0].get());
+  PosedBodyPointDecompositionPtr& decomposition = cur_it->second.front();
+  if (decomposition->getOctree() != octree_shape->octree)
+    return false;
+
+  return decomposition->updateFromOctreeChanges(add_points, subtract_points);
+}
+
 CollisionEnvDistanceField::DistanceFieldCacheEntryWorldPtr
 CollisionEnvDistanceField::generateDistanceFieldCacheEntryWorld()
 {
@@ -36,6 +36,7 @@
 
 #include <moveit/collision_distance_field/collision_detector_allocator_hybrid.h>
 #include <moveit/collision_distance_field/collision_env_hybrid.h>
+#include <future>
 
 namespace collision_detection
 {
@@ -69,6 +70,8 @@ CollisionEnvHybrid::CollisionEnvHybrid(const CollisionEnvHybrid& other, const Wo
   : CollisionEnvFCL(other, world)
   , cenv_distance_(std::make_shared<collision_detection::CollisionEnvDistanceField>(
         *other.getCollisionWorldDistanceField(), world))
+  , robot_collision_check_mode_(other.robot_collision_check_mode_)
+  , proximity_margin_(other.proximity_margin_)
 {
 }
 
@@ -169,6 +172,62 @@ void CollisionEnvHybrid::setWorld(const WorldPtr& world)
   CollisionEnvFCL::setWorld(world);
 }
 
+void CollisionEnvHybrid::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                             const moveit::core::RobotState& state) const
+{
+  checkRobotCollisionHybrid(req, res, state, nullptr);
+}
+
+void CollisionEnvHybrid::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                             const moveit::core::RobotState& state,
+                                             const AllowedCollisionMatrix& acm) const
+{
+  checkRobotCollisionHybrid(req, res, state, &acm);
+}
+
+void CollisionEnvHybrid::checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state,
+                                                   const AllowedCollisionMatrix* acm) const
+{
+  const auto check_fcl = [&] {
+    if (acm)
+      CollisionEnvFCL::checkRobotCollision(req, res, state, *acm);
+    else
+      CollisionEnvFCL::checkRobotCollision(req, res, state);
+  };
+
+  switch (robot_collision_check_mode_)
+  {
+    case HybridCollisionCheckMode::FCL:
+      check_fcl();
+      break;
+    case HybridCollisionCheckMode::PARALLEL:
+    {
+      // the distance field only reports whether there is a collision, contacts and distances come from FCL
+      CollisionRequest distance_field_req = req;
+      distance_field_req.contacts = false;
+      distance_field_req.distance = false;
+      CollisionResult distance_field_res;
+      std::future<void> distance_field_check = std::async(std::launch::async, [&] {
+        if (acm)
+          cenv_distance_->checkRobotCollision(distance_field_req, distance_field_res, state, *acm);
+        else
+          cenv_distance_->checkRobotCollision(distance_field_req, distance_field_res, state);
+      });
+      check_fcl();
+      distance_field_check.get();
+      res.collision = res.collision || distance_field_res.collision;
+      break;
+    }
+    case HybridCollisionCheckMode::DISTANCE_FIELD_FIRST:
+      // distances and costs are only computed by FCL
+      if (req.distance || req.cost ||
+          cenv_distance_->isRobotNearEnvironment(req.getGroupName(), state, proximity_margin_))
+        check_fcl();
+      break;
+  }
+}
+
 void CollisionEnvHybrid::getCollisionGradients(const CollisionRequest& req, CollisionResult& res,
                                                const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
                                                GroupStateRepresentationPtr& gsr) const
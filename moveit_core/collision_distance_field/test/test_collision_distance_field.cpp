@@ -39,6 +39,7 @@
 #include <moveit/transforms/transforms.h>
 #include <moveit/collision_distance_field/collision_distance_field_types.h>
 #include <moveit/collision_distance_field/collision_env_distance_field.h>
+#include <moveit/collision_distance_field/collision_env_hybrid.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
 #include <geometric_shapes/shape_operations.h>
@@ -330,6 +331,85 @@ TEST_F(DistanceFieldCollisionDetectionTester, AttachedBodyTester)
   ASSERT_TRUE(res.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, HybridRobotCollisionCheckModes)
+{
+  collision_detection::CollisionEnvHybrid cenv(robot_model_);
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  Eigen::Isometry3d pos1 = Eigen::Isometry3d::Identity();
+  pos1.translation().x() = 1.0;
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+
+  for (const collision_detection::HybridCollisionCheckMode mode :
+       { collision_detection::HybridCollisionCheckMode::FCL, collision_detection::HybridCollisionCheckMode::PARALLEL,
+         collision_detection::HybridCollisionCheckMode::DISTANCE_FIELD_FIRST })
+  {
+    cenv.setRobotCollisionCheckMode(mode);
+
+    collision_detection::CollisionResult res;
+    cenv.checkRobotCollision(req, res, robot_state, *acm_);
+    EXPECT_FALSE(res.collision);
+
+    cenv.getWorld()->addToObject("box", std::make_shared<const shapes::Box>(.25, .25, .25), pos1);
+    EXPECT_TRUE(cenv.getCollisionWorldDistanceField()->isRobotNearEnvironment(req.group_name, robot_state, 0.0));
+    res = collision_detection::CollisionResult();
+    cenv.checkRobotCollision(req, res, robot_state, *acm_);
+    EXPECT_TRUE(res.collision);
+    cenv.getWorld()->removeObject("box");
+  }
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, HybridObstacleOutsideDistanceField)
+{
+  // a field that does not cover the robot, the obstacle at the gripper is not represented in it
+  collision_detection::CollisionEnvHybrid cenv(robot_model_, {}, 1.0, 1.0, 1.0, Eigen::Vector3d(-2.0, 0.0, 0.0));
+  cenv.setRobotCollisionCheckMode(collision_detection::HybridCollisionCheckMode::DISTANCE_FIELD_FIRST);
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  Eigen::Isometry3d pos1 = Eigen::Isometry3d::Identity();
+  pos1.translation().x() = 1.0;
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+
+  cenv.getWorld()->addToObject("box", std::make_shared<const shapes::Box>(.25, .25, .25), pos1);
+  EXPECT_TRUE(cenv.getCollisionWorldDistanceField()->isRobotNearEnvironment(req.group_name, robot_state, 0.0));
+  collision_detection::CollisionResult res;
+  cenv.checkRobotCollision(req, res, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+}
+
+TEST(PosedBodyPointDecomposition, OctreeChangeDetection)
+{
+  auto octree = std::make_shared<octomap::OcTree>(0.1);
+  octree->updateNode(octomap::point3d(0.05, 0.05, 0.05), true);
+  octree->updateNode(octomap::point3d(0.45, 0.05, 0.05), true);
+  octree->updateNode(octomap::point3d(0.85, 0.05, 0.05), false);
+
+  collision_detection::PosedBodyPointDecomposition decomposition(octree);
+  // free cells must not become obstacles
+  ASSERT_EQ(decomposition.getCollisionPoints().size(), 2u);
+
+  EigenSTL::vector_Vector3d added_points, removed_points;
+  ASSERT_FALSE(decomposition.updateFromOctreeChanges(added_points, removed_points));
+
+  octree->enableChangeDetection(true);
+  for (int i = 0; i < 3; ++i)
+    octree->updateNode(octomap::point3d(0.05, 0.05, 0.05), false);
+  octree->updateNode(octomap::point3d(0.85, 0.05, 0.05), true);
+  octree->updateNode(octomap::point3d(0.05, 0.85, 0.05), true);
+
+  ASSERT_TRUE(decomposition.updateFromOctreeChanges(added_points, removed_points));
+  ASSERT_EQ(added_points.size(), 2u);
+  ASSERT_EQ(removed_points.size(), 1u);
+  EXPECT_NEAR(removed_points[0].x(), 0.05, 1e-6);
+  EXPECT_EQ(decomposition.getCollisionPoints().size(), 3u);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -55,6 +55,11 @@ public:
   {
   }
 
+  /** \brief Called once after the allocator is loaded, so that it can read its parameters from \e node */
+  virtual void initialize(const rclcpp::Node::SharedPtr& /*node*/)
+  {
+  }
+
   virtual ConstraintSamplerPtr alloc(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
                                      const moveit_msgs::msg::Constraints& constr) = 0;
 
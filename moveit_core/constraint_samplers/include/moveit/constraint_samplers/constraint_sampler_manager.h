@@ -75,6 +75,24 @@ public:
   {
     sampler_alloc_.push_back(sa);
   }
+
+  /**
+   * \brief Sets the number of threads used by the IKConstraintSamplers returned from \ref selectSampler
+   *
+   * See IKConstraintSampler::setThreadCount(). The default of 1 samples on the calling thread.
+   *
+   * @param thread_count The thread count, where 0 means one thread per hardware core
+   */
+  void setIKSamplerThreadCount(std::size_t thread_count)
+  {
+    ik_sampler_thread_count_ = thread_count;
+  }
+
+  /** \brief Gets the number of threads used by the IKConstraintSamplers returned from \ref selectSampler */
+  std::size_t getIKSamplerThreadCount() const
+  {
+    return ik_sampler_thread_count_;
+  }
   /**
    * \brief Selects among the potential sampler allocators.
    *
@@ -144,5 +162,6 @@ public:
 private:
   std::vector<ConstraintSamplerAllocatorPtr>
       sampler_alloc_; /**< \brief Holds the constraint sampler allocators, which will be tested in order  */
+  std::size_t ik_sampler_thread_count_ = 1; /**< \brief Thread count for the selected IK constraint samplers */
 };
 }  // namespace constraint_samplers
@@ -37,10 +37,12 @@
 #pragma once
 
 #include <moveit/constraint_samplers/constraint_sampler.h>
+#include <moveit/constraint_samplers/halton_sequence.h>
 #include <moveit/macros/class_forward.h>
 #include <random_numbers/random_numbers.h>
 #include <rclcpp/rclcpp.hpp>
 #include <string>
+#include <vector>
 #include <Eigen/Geometry>
 
 namespace constraint_samplers
@@ -163,6 +165,27 @@ public:
     return unbounded_.size();
   }
 
+  /**
+   * \brief Draw the values of all single-variable joints from a scrambled
+   * Halton sequence instead of independent uniform draws.
+   *
+   * The samples then cover narrow constraint regions more evenly.
+   * Joints with several variables are always sampled pseudo-randomly.
+   * The sequence is scrambled from the sampler's random number
+   * generator, so differently seeded samplers produce different
+   * points.
+   */
+  void setQuasiRandomSampling(bool enable)
+  {
+    quasi_random_ = enable;
+    halton_sequence_ = HaltonSequence();
+  }
+
+  bool getQuasiRandomSampling() const
+  {
+    return quasi_random_;
+  }
+
   /**
    * \brief Get the name of the constraint sampler, for debugging purposes
    * should be in CamelCase format.
@@ -219,6 +242,10 @@ protected:
                                                              limits */
   std::vector<unsigned int> uindex_; /**< \brief The index of the unbounded joints in the joint state vector */
   std::vector<double> values_;       /**< \brief Values associated with this group to avoid continuously reallocating */
+
+  bool quasi_random_ = false;        /**< \brief Whether to sample from \e halton_sequence_ */
+  HaltonSequence halton_sequence_;   /**< \brief Points for the single-variable joints when sampling quasi-randomly */
+  std::vector<double> halton_point_; /**< \brief The current point of \e halton_sequence_ */
 };
 
 /**
@@ -418,6 +445,31 @@ public:
     ik_timeout_ = timeout;
   }
 
+  /**
+   * \brief Gets the number of threads used to run IK attempts concurrently
+   *
+   * @return The thread count, where 1 means sampling on the calling thread and 0 means one thread per hardware core
+   */
+  std::size_t getThreadCount() const
+  {
+    return thread_count_;
+  }
+
+  /**
+   * \brief Sets the number of threads used to run IK attempts concurrently
+   *
+   * With more than one thread, the IK solver of the group and the group state validity callback are called
+   * concurrently, so both need to be thread-safe. Each thread uses its own random number generator, seeded from the
+   * generator of this sampler. Which of the concurrent attempts succeeds first is not deterministic.
+   *
+   * @param thread_count The thread count, where 1 means sampling on the calling thread and 0 means one thread per
+   * hardware core
+   */
+  void setThreadCount(std::size_t thread_count)
+  {
+    thread_count_ = thread_count;
+  }
+
   /**
    * \brief Gets the position constraint associated with this sampler.
    *
@@ -486,6 +538,23 @@ public:
   bool sample(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
               unsigned int max_attempts) override;
 
+  /**
+   * \brief Produces up to \e count valid IK samples, sharing \e max_attempts attempts among getThreadCount() threads.
+   *
+   * Sampling stops as soon as \e count samples are found or all attempts are used up. The samples are sorted by their
+   * distance to \e reference_state in the joints of the group, closest first.
+   *
+   * @param samples The valid samples that were found
+   * @param reference_state The state used for sampling poses and as the IK seed of the first attempt
+   * @param count The number of samples to produce
+   * @param max_attempts The number of attempts to both sample and try IK, shared among all threads
+   *
+   * @return The number of samples that were found
+   */
+  std::size_t sampleMultiple(std::vector<moveit::core::RobotState>& samples,
+                             const moveit::core::RobotState& reference_state, std::size_t count,
+                             unsigned int max_attempts);
+
   /**
    * \brief Returns a pose that falls within the constraint regions.
    *
@@ -511,6 +580,14 @@ public:
   bool samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& quat, const moveit::core::RobotState& ks,
                   unsigned int max_attempts);
 
+  /**
+   * \brief Returns a pose that lies within the constraint regions, drawing random numbers from \e rng.
+   *
+   * See samplePose(Eigen::Vector3d&, Eigen::Quaterniond&, const moveit::core::RobotState&, unsigned int).
+   */
+  bool samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& quat, const moveit::core::RobotState& ks,
+                  unsigned int max_attempts, random_numbers::RandomNumberGenerator& rng) const;
+
   /**
    * \brief Get the name of the constraint sampler, for debugging purposes
    * should be in CamelCase format.
@@ -546,8 +623,26 @@ protected:
   bool callIK(const geometry_msgs::msg::Pose& ik_query,
               const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
               moveit::core::RobotState& state, bool use_as_seed);
+  virtual bool callIK(const geometry_msgs::msg::Pose& ik_query,
+                      const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
+                      moveit::core::RobotState& state, bool use_as_seed,
+                      random_numbers::RandomNumberGenerator& rng) const;
+  /** \brief Calls IK on the given pose starting from \e seed, given in the variable order of the group */
+  bool callIKWithSeed(const geometry_msgs::msg::Pose& ik_query,
+                      const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
+                      moveit::core::RobotState& state, const std::vector<double>& seed) const;
   bool sampleHelper(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
                     unsigned int max_attempts);
+  /** \brief Sample a pose and convert it into a query for the IK solver */
+  bool sampleIKQuery(geometry_msgs::msg::Pose& ik_query, const moveit::core::RobotState& reference_state,
+                     unsigned int max_attempts, random_numbers::RandomNumberGenerator& rng) const;
+  /** \brief Adapt the group state validity callback to the IK solver, setting joint values on \e state */
+  kinematics::KinematicsBase::IKCallbackFn adaptIKValidityCallback(moveit::core::RobotState& state) const;
+  /** \brief Run the attempts of sampleMultiple() on getThreadCount() threads, seeding IK from \e seed_state */
+  std::size_t sampleConcurrently(std::vector<moveit::core::RobotState>& samples,
+                                 const moveit::core::RobotState& seed_state,
+                                 const moveit::core::RobotState& reference_state, std::size_t count,
+                                 unsigned int max_attempts);
   bool validate(moveit::core::RobotState& state) const;
 
   random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random generator used by the sampler */
@@ -560,5 +655,6 @@ protected:
   bool need_eef_to_ik_tip_transform_; /**< \brief True if the tip frame of the inverse kinematic is different than the
                                         frame of the end effector */
   Eigen::Isometry3d eef_to_ik_tip_transform_; /**< \brief Holds the transformation from end effector to IK tip frame */
+  std::size_t thread_count_ = 1; /**< \brief Number of threads for concurrent IK attempts, 0 for hardware_concurrency */
 };
 }  // namespace constraint_samplers
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <random_numbers/random_numbers.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace constraint_samplers
+{
+/**
+ * \brief A low-discrepancy (quasi-random) sequence of points in the
+ * unit cube [0, 1)^d.
+ *
+ * Consecutive points of a Halton sequence fill the unit cube more
+ * evenly than independent uniform draws, so a given number of samples
+ * covers small regions of the sampled space more reliably.  Dimension
+ * i uses the radical inverse of the point index in the base of the
+ * i-th prime.
+ *
+ * The sequence can be scrambled with a random shift of every dimension
+ * (Cranley-Patterson rotation), which keeps the low discrepancy but
+ * gives independent samplers, e.g. one per planning thread, different
+ * points.
+ */
+class HaltonSequence
+{
+public:
+  /** \brief Create an unscrambled sequence of points with \e dimension coordinates */
+  explicit HaltonSequence(std::size_t dimension = 0);
+
+  /** \brief Create a sequence of points with \e dimension coordinates, scrambled with shifts drawn from \e rng */
+  HaltonSequence(std::size_t dimension, random_numbers::RandomNumberGenerator& rng);
+
+  /** \brief Get the number of coordinates of each point */
+  std::size_t getDimension() const
+  {
+    return bases_.size();
+  }
+
+  /**
+   * \brief Compute the next point of the sequence
+   *
+   * @param [out] point The getDimension() coordinates of the point, each in [0, 1)
+   */
+  void next(double* point);
+
+  /** \brief Restart the sequence at its first point */
+  void reset()
+  {
+    index_ = 1;
+  }
+
+  /** \brief Get the radical inverse of \e index in \e base, i.e. its digits mirrored at the radix point */
+  static double radicalInverse(std::uint64_t index, unsigned int base);
+
+private:
+  std::vector<unsigned int> bases_;
+  std::vector<double> shifts_;
+  // the first point (index 0) would be the origin in every dimension
+  std::uint64_t index_ = 1;
+};
+}  // namespace constraint_samplers
@@ -0,0 +1,109 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/constraint_samplers/reachability_map.h>
+#include <moveit/macros/class_forward.h>
+#include <algorithm>
+
+namespace constraint_samplers
+{
+MOVEIT_CLASS_FORWARD(ReachabilityConstraintSampler);  // Defines ReachabilityConstraintSamplerPtr, ConstPtr, WeakPtr...
+
+/**
+ * \brief An IKConstraintSampler that seeds IK with configurations looked up in a ReachabilityMap
+ *
+ * Poses are sampled from the constraints exactly as by the IKConstraintSampler. Instead of starting IK from a random
+ * seed, the sampler looks up the configurations the map stores near the sampled pose and refines them with IK. Poses
+ * the map has no configuration near are rejected without calling IK, as they are most likely unreachable.
+ *
+ * The map is only used if it was built for the base and tip frames of the IK solver of the group, as returned by
+ * getMapFrames(). Otherwise the sampler behaves like the IKConstraintSampler.
+ */
+class ReachabilityConstraintSampler : public IKConstraintSampler
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * @param [in] scene The planning scene used to check the constraint
+   * @param [in] group_name The group name associated with the constraint
+   * @param [in] map The reachability map of the group
+   * @param [in] seeds_per_attempt The number of configurations from the map refined by IK per sampled pose
+   */
+  ReachabilityConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                                const ReachabilityMapConstPtr& map, unsigned int seeds_per_attempt = 3)
+    : IKConstraintSampler(scene, group_name), map_(map), seeds_per_attempt_(std::max(1u, seeds_per_attempt))
+  {
+  }
+
+  /**
+   * \brief Get the frames a reachability map for \e jmg needs to be built for to be used by this sampler
+   *
+   * These are the base frame of the IK solver of the group, or the model frame if the solver works in the model
+   * frame, and the tip frame of the solver.
+   *
+   * @return False if the group has no IK solver
+   */
+  static bool getMapFrames(const moveit::core::JointModelGroup* jmg, std::string& base_frame, std::string& tip_frame);
+
+  const ReachabilityMapConstPtr& getReachabilityMap() const
+  {
+    return map_;
+  }
+
+  const std::string& getName() const override
+  {
+    static const std::string SAMPLER_NAME = "ReachabilityConstraintSampler";
+    return SAMPLER_NAME;
+  }
+
+protected:
+  using IKConstraintSampler::callIK;
+
+  /** \brief Refine the configurations stored near \e ik_query, unless the current state is to be used as seed */
+  bool callIK(const geometry_msgs::msg::Pose& ik_query,
+              const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
+              moveit::core::RobotState& state, bool use_as_seed,
+              random_numbers::RandomNumberGenerator& rng) const override;
+
+  /** \brief True if the map was built for the frames of the loaded IK solver */
+  bool mapMatchesSolver() const;
+
+  ReachabilityMapConstPtr map_;    /**< \brief The map IK seeds are looked up in */
+  unsigned int seeds_per_attempt_; /**< \brief The maximum number of seeds refined per sampled pose */
+};
+}  // namespace constraint_samplers
@@ -0,0 +1,155 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/robot_model.h>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace constraint_samplers
+{
+MOVEIT_CLASS_FORWARD(ReachabilityMap);  // Defines ReachabilityMapPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief A discretized map from poses of the tip frame of a group to joint configurations that reach them
+ *
+ * The map is a regular grid over the positions of the tip frame relative to a base frame. Every cell stores a small
+ * number of entries, each consisting of the orientation of the tip frame and the variable values of the group that
+ * produced it. All data is kept in a single contiguous buffer, so maps can be written to a file and mapped back into
+ * memory without parsing or copying. Processes mapping the same file share its pages.
+ */
+class ReachabilityMap
+{
+public:
+  /// \brief Parameters for building a map
+  struct Options
+  {
+    double resolution = 0.05;              /**< \brief The side length of a cell, in meters */
+    std::size_t sample_count = 200000;     /**< \brief The number of random configurations to sample */
+    std::size_t max_entries_per_cell = 16; /**< \brief The maximum number of configurations stored per cell */
+    unsigned int seed = 0;                 /**< \brief The seed for sampling the configurations */
+  };
+
+  /**
+   * \brief Build a map by sampling random configurations of a group
+   *
+   * Variables of the robot that are not part of the group are kept at their default values.
+   *
+   * @param robot_model The robot model
+   * @param group_name The group whose variables are sampled
+   * @param base_frame The frame that poses are expressed in, either the model frame or a link
+   * @param tip_frame The link whose poses are stored
+   * @param options The resolution and density of the map
+   *
+   * @return The map, or nullptr if the group or a frame is unknown
+   */
+  static ReachabilityMapPtr build(const moveit::core::RobotModelConstPtr& robot_model, const std::string& group_name,
+                                  const std::string& base_frame, const std::string& tip_frame,
+                                  const Options& options);
+
+  /**
+   * \brief Map a file written by writeToFile() into memory
+   *
+   * @return The map, or nullptr if the file can not be read or was built for a different robot, group or frames
+   */
+  static ReachabilityMapPtr readFromFile(const std::string& filename,
+                                         const moveit::core::RobotModelConstPtr& robot_model,
+                                         const std::string& group_name, const std::string& base_frame,
+                                         const std::string& tip_frame);
+
+  /** \brief Write the map to \e filename, in a format that readFromFile() maps without copying */
+  bool writeToFile(const std::string& filename) const;
+
+  const std::string& getGroupName() const
+  {
+    return group_name_;
+  }
+
+  const std::string& getBaseFrame() const
+  {
+    return base_frame_;
+  }
+
+  const std::string& getTipFrame() const
+  {
+    return tip_frame_;
+  }
+
+  /** \brief The number of variables of the group, stored for every entry */
+  std::size_t getVariableCount() const;
+
+  /** \brief The total number of stored configurations */
+  std::size_t getEntryCount() const;
+
+  /**
+   * \brief Find the stored configurations whose tip pose is closest to \e pose
+   *
+   * Candidates are the entries of the cell containing the position of \e pose and of the cells around it. They are
+   * ordered by the angle between their orientation and the orientation of \e pose.
+   *
+   * @param pose The pose of the tip frame relative to the base frame
+   * @param max_count The maximum number of configurations to return
+   * @param configurations The configurations found, in the variable order of the group
+   *
+   * @return The number of configurations found; 0 means the map saw no configuration near \e pose
+   */
+  std::size_t findConfigurations(const Eigen::Isometry3d& pose, std::size_t max_count,
+                                 std::vector<std::vector<double>>& configurations) const;
+
+private:
+  ReachabilityMap() = default;
+
+  /** \brief Point the accessors into \e data, which must hold a complete and validated map */
+  void setData(const char* data, std::shared_ptr<const void> owner);
+
+  std::string group_name_;
+  std::string base_frame_;
+  std::string tip_frame_;
+
+  const char* data_ = nullptr;                       /**< \brief The complete map, starting with its header */
+  std::size_t data_size_ = 0;                        /**< \brief The size of data_ in bytes */
+  std::shared_ptr<const void> owner_;                /**< \brief Keeps data_ alive, a buffer or a mapped file */
+  const std::uint32_t* cells_ = nullptr;             /**< \brief Index of the first entry of each cell, and the end */
+  const float* entries_ = nullptr;                   /**< \brief Orientation (x, y, z, w) and variables per entry */
+  std::size_t entry_stride_ = 0;                     /**< \brief The number of floats per entry */
+  std::size_t num_cells_[3] = { 0, 0, 0 };           /**< \brief The number of cells along each axis */
+  double resolution_ = 0.0;                          /**< \brief The side length of a cell */
+  Eigen::Vector3d origin_ = Eigen::Vector3d::Zero(); /**< \brief The minimum corner of the grid */
+};
+}  // namespace constraint_samplers
@@ -39,24 +39,45 @@
 #include <moveit/constraint_samplers/union_constraint_sampler.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <algorithm>
 #include <sstream>
 
 namespace constraint_samplers
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_constraint_samplers.constraint_sampler_manager");
 
+namespace
+{
+// apply the thread count to all IK samplers in sampler, including those combined in union samplers
+void setIKSamplerThreadCount(const ConstraintSamplerPtr& sampler, std::size_t thread_count)
+{
+  if (auto iks = std::dynamic_pointer_cast<IKConstraintSampler>(sampler))
+    iks->setThreadCount(thread_count);
+  else if (auto ucs = std::dynamic_pointer_cast<UnionConstraintSampler>(sampler))
+  {
+    for (const ConstraintSamplerPtr& child : ucs->getSamplers())
+      setIKSamplerThreadCount(child, thread_count);
+  }
+}
+}  // namespace
+
 ConstraintSamplerPtr ConstraintSamplerManager::selectSampler(const planning_scene::PlanningSceneConstPtr& scene,
                                                              const std::string& group_name,
                                                              const moveit_msgs::msg::Constraints& constr) const
 {
-  for (const ConstraintSamplerAllocatorPtr& sampler : sampler_alloc_)
-  {
-    if (sampler->canService(scene, group_name, constr))
-      return sampler->alloc(scene, group_name, constr);
-  }
+  ConstraintSamplerPtr result;
+  const auto allocator = std::find_if(sampler_alloc_.begin(), sampler_alloc_.end(),
+                                      [&](const ConstraintSamplerAllocatorPtr& sampler) {
+                                        return sampler->canService(scene, group_name, constr);
+                                      });
+  if (allocator != sampler_alloc_.end())
+    result = (*allocator)->alloc(scene, group_name, constr);
+  else
+    result = selectDefaultSampler(scene, group_name, constr);  // no allocator can service the constraints
 
-  // if no default sampler was used, try a default one
-  return selectDefaultSampler(scene, group_name, constr);
+  if (result)
+    setIKSamplerThreadCount(result, ik_sampler_thread_count_);
+  return result;
 }
 
 ConstraintSamplerPtr ConstraintSamplerManager::selectDefaultSampler(const planning_scene::PlanningSceneConstPtr& scene,
@@ -37,8 +37,13 @@
 #include <moveit/constraint_samplers/default_constraint_samplers.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 namespace constraint_samplers
 {
@@ -169,19 +174,47 @@ bool JointConstraintSampler::sample(moveit::core::RobotState& state,
     return false;
   }
 
+  // a point of the Halton sequence has one coordinate per single-variable joint, constrained joints first
+  const double* quasi_random = nullptr;
+  if (quasi_random_)
+  {
+    std::size_t dimension = bounds_.size();
+    for (const moveit::core::JointModel* joint : unbounded_)
+      dimension += joint->getVariableCount() == 1;
+    if (halton_sequence_.getDimension() != dimension)
+    {
+      halton_sequence_ = HaltonSequence(dimension, random_number_generator_);
+      halton_point_.resize(dimension);
+    }
+    halton_sequence_.next(halton_point_.data());
+    quasi_random = halton_point_.data() + bounds_.size();
+  }
+
   // sample the unbounded joints first (in case some joint variables are bounded)
   std::vector<double> v;
   for (std::size_t i = 0; i < unbounded_.size(); ++i)
   {
     v.resize(unbounded_[i]->getVariableCount());
-    unbounded_[i]->getVariableRandomPositions(random_number_generator_, &v[0]);
+    if (quasi_random && v.size() == 1)
+    {
+      const moveit::core::VariableBounds& bounds = unbounded_[i]->getVariableBounds()[0];
+      v[0] = bounds.min_position_ + *quasi_random++ * (bounds.max_position_ - bounds.min_position_);
+    }
+    else
+      unbounded_[i]->getVariableRandomPositions(random_number_generator_, &v[0]);
     for (std::size_t j = 0; j < v.size(); ++j)
       values_[uindex_[i] + j] = v[j];
   }
 
   // enforce the constraints for the constrained components (could be all of them)
-  for (const JointInfo& bound : bounds_)
-    values_[bound.index_] = random_number_generator_.uniformReal(bound.min_bound_, bound.max_bound_);
+  for (std::size_t i = 0; i < bounds_.size(); ++i)
+  {
+    const JointInfo& bound = bounds_[i];
+    if (quasi_random_)
+      values_[bound.index_] = bound.min_bound_ + halton_point_[i] * (bound.max_bound_ - bound.min_bound_);
+    else
+      values_[bound.index_] = random_number_generator_.uniformReal(bound.min_bound_, bound.max_bound_);
+  }
 
   state.setJointGroupPositions(jmg_, values_);
 
@@ -195,6 +228,7 @@ void JointConstraintSampler::clear()
   bounds_.clear();
   unbounded_.clear();
   uindex_.clear();
+  halton_sequence_ = HaltonSequence();
   values_.clear();
 }
 
@@ -433,6 +467,12 @@ bool IKConstraintSampler::loadIKSolver()
 
 bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& quat, const moveit::core::RobotState& ks,
                                      unsigned int max_attempts)
+{
+  return samplePose(pos, quat, ks, max_attempts, random_number_generator_);
+}
+
+bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& quat, const moveit::core::RobotState& ks,
+                                     unsigned int max_attempts, random_numbers::RandomNumberGenerator& rng) const
 {
   if (ks.dirtyLinkTransforms())
   {
@@ -448,10 +488,10 @@ bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& q
     if (!b.empty())
     {
       bool found = false;
-      std::size_t k = random_number_generator_.uniformInteger(0, b.size() - 1);
+      std::size_t k = rng.uniformInteger(0, b.size() - 1);
       for (std::size_t i = 0; i < b.size(); ++i)
       {
-        if (b[(i + k) % b.size()]->samplePointInside(random_number_generator_, max_attempts, pos))
+        if (b[(i + k) % b.size()]->samplePointInside(rng, max_attempts, pos))
         {
           found = true;
           break;
@@ -479,7 +519,7 @@ bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& q
   {
     // do FK for rand state
     moveit::core::RobotState temp_state(ks);
-    temp_state.setToRandomPositions(jmg_);
+    temp_state.setToRandomPositions(jmg_, rng);
     pos = temp_state.getGlobalLinkTransform(sampling_pose_.orientation_constraint_->getLinkModel()).translation();
   }
 
@@ -487,13 +527,13 @@ bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& q
   {
     // sample a rotation matrix within the allowed bounds
     double angle_x =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (rng.uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getXAxisTolerance() - std::numeric_limits<double>::epsilon());
     double angle_y =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (rng.uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getYAxisTolerance() - std::numeric_limits<double>::epsilon());
     double angle_z =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (rng.uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getZAxisTolerance() - std::numeric_limits<double>::epsilon());
 
     Eigen::Isometry3d diff;
@@ -536,7 +576,7 @@ bool IKConstraintSampler::samplePose(Eigen::Vector3d& pos, Eigen::Quaterniond& q
   {
     // sample a random orientation
     double q[4];
-    random_number_generator_.quaternion(q);
+    rng.quaternion(q);
     quat = Eigen::Quaterniond(q[3], q[0], q[1], q[2]);  // quat is normalized by contract
   }
 
@@ -574,7 +614,26 @@ void samplingIkCallbackFnAdapter(moveit::core::RobotState* state, const moveit::
 bool IKConstraintSampler::sample(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
                                  unsigned int max_attempts)
 {
-  return sampleHelper(state, reference_state, max_attempts);
+  if (thread_count_ == 1)
+    return sampleHelper(state, reference_state, max_attempts);
+
+  std::vector<moveit::core::RobotState> samples;
+  if (sampleConcurrently(samples, state, reference_state, 1, max_attempts) == 0)
+    return false;
+  state = samples.front();
+  return true;
+}
+
+std::size_t IKConstraintSampler::sampleMultiple(std::vector<moveit::core::RobotState>& samples,
+                                                const moveit::core::RobotState& reference_state, std::size_t count,
+                                                unsigned int max_attempts)
+{
+  sampleConcurrently(samples, reference_state, reference_state, count, max_attempts);
+  std::sort(samples.begin(), samples.end(),
+            [this, &reference_state](const moveit::core::RobotState& a, const moveit::core::RobotState& b) {
+              return reference_state.distance(a, jmg_) < reference_state.distance(b, jmg_);
+            });
+  return samples.size();
 }
 
 bool IKConstraintSampler::sampleHelper(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
@@ -586,62 +645,136 @@ bool IKConstraintSampler::sampleHelper(moveit::core::RobotState& state, const mo
     return false;
   }
 
-  kinematics::KinematicsBase::IKCallbackFn adapted_ik_validity_callback;
-  if (group_state_validity_callback_)
-  {
-    adapted_ik_validity_callback = [this, state_ptr = &state](const geometry_msgs::msg::Pose&,
-                                                              const std::vector<double>& joints,
-                                                              moveit_msgs::msg::MoveItErrorCodes& error_code) {
-      return samplingIkCallbackFnAdapter(state_ptr, jmg_, group_state_validity_callback_, joints, error_code);
-    };
-  }
-
+  const kinematics::KinematicsBase::IKCallbackFn adapted_ik_validity_callback = adaptIKValidityCallback(state);
   for (unsigned int a = 0; a < max_attempts; ++a)
   {
-    // sample a point in the constraint region
-    Eigen::Vector3d point;
-    Eigen::Quaterniond quat;  // quat is normalized by contract
-    if (!samplePose(point, quat, reference_state, max_attempts))
+    geometry_msgs::msg::Pose ik_query;
+    if (!sampleIKQuery(ik_query, reference_state, max_attempts, random_number_generator_))
     {
       if (verbose_)
         RCLCPP_INFO(LOGGER, "IK constraint sampler was unable to produce a pose to run IK for");
       return false;
     }
 
-    // we now have the transform we wish to perform IK for, in the planning frame
-    if (transform_ik_)
-    {
-      // we need to convert this transform to the frame expected by the IK solver
-      // both the planning frame and the frame for the IK are assumed to be robot links
-      Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
-      // getFrameTransform() returns a valid isometry by contract
-      ikq = reference_state.getFrameTransform(ik_frame_).inverse() * ikq;  // valid isometry * valid isometry
-      point = ikq.translation();
-      quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
-    }
+    if (callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, a == 0))
+      return true;
+  }
+  return false;
+}
 
-    if (need_eef_to_ik_tip_transform_)
+std::size_t IKConstraintSampler::sampleConcurrently(std::vector<moveit::core::RobotState>& samples,
+                                                    const moveit::core::RobotState& seed_state,
+                                                    const moveit::core::RobotState& reference_state, std::size_t count,
+                                                    unsigned int max_attempts)
+{
+  samples.clear();
+  if (!is_valid_)
+  {
+    RCLCPP_WARN(LOGGER, "IKConstraintSampler not configured, won't sample");
+    return 0;
+  }
+  if (count == 0 || max_attempts == 0)
+    return 0;
+
+  std::size_t thread_count = thread_count_ == 0 ? std::thread::hardware_concurrency() : thread_count_;
+  thread_count = std::max<std::size_t>(1, std::min<std::size_t>(thread_count, max_attempts));
+
+  // every thread draws from its own random stream, seeded from this sampler to keep seeded samplers reproducible
+  std::vector<std::uint32_t> seeds(thread_count);
+  for (std::uint32_t& seed : seeds)
+    seed = static_cast<std::uint32_t>(random_number_generator_.uniformInteger(0, std::numeric_limits<int>::max()));
+
+  std::atomic<unsigned int> next_attempt(0);
+  std::atomic<bool> done(false);
+  std::mutex samples_lock;
+  const auto worker = [&](std::uint32_t seed) {
+    random_numbers::RandomNumberGenerator rng(seed);
+    moveit::core::RobotState state(seed_state);
+    const kinematics::KinematicsBase::IKCallbackFn adapted_ik_validity_callback = adaptIKValidityCallback(state);
+    for (unsigned int a = next_attempt++; a < max_attempts && !done; a = next_attempt++)
     {
-      // After sampling the pose needs to be transformed to the ik chain tip
-      Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
-      ikq = ikq * eef_to_ik_tip_transform_;  // eef_to_ik_tip_transform_ is valid isometry (checked in loadIKSolver())
-      point = ikq.translation();
-      quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
+      geometry_msgs::msg::Pose ik_query;
+      if (!sampleIKQuery(ik_query, reference_state, max_attempts, rng))
+      {
+        if (verbose_)
+          RCLCPP_INFO(LOGGER, "IK constraint sampler was unable to produce a pose to run IK for");
+        done = true;
+        break;
+      }
+
+      // like in sampleHelper(), only the first attempt is seeded with the given state
+      if (!callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, a == 0, rng))
+        continue;
+
+      std::scoped_lock slock(samples_lock);
+      if (samples.size() < count)
+        samples.push_back(state);
+      if (samples.size() >= count)
+        done = true;
     }
+  };
 
-    geometry_msgs::msg::Pose ik_query;
-    ik_query.position.x = point.x();
-    ik_query.position.y = point.y();
-    ik_query.position.z = point.z();
-    ik_query.orientation.x = quat.x();
-    ik_query.orientation.y = quat.y();
-    ik_query.orientation.z = quat.z();
-    ik_query.orientation.w = quat.w();
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (std::size_t i = 1; i < thread_count; ++i)
+    threads.emplace_back(worker, seeds[i]);
+  worker(seeds[0]);
+  for (std::thread& thread : threads)
+    thread.join();
 
-    if (callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, a == 0))
-      return true;
+  return samples.size();
+}
+
+bool IKConstraintSampler::sampleIKQuery(geometry_msgs::msg::Pose& ik_query,
+                                        const moveit::core::RobotState& reference_state, unsigned int max_attempts,
+                                        random_numbers::RandomNumberGenerator& rng) const
+{
+  // sample a point in the constraint region
+  Eigen::Vector3d point;
+  Eigen::Quaterniond quat;  // quat is normalized by contract
+  if (!samplePose(point, quat, reference_state, max_attempts, rng))
+    return false;
+
+  // we now have the transform we wish to perform IK for, in the planning frame
+  if (transform_ik_)
+  {
+    // we need to convert this transform to the frame expected by the IK solver
+    // both the planning frame and the frame for the IK are assumed to be robot links
+    Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
+    // getFrameTransform() returns a valid isometry by contract
+    ikq = reference_state.getFrameTransform(ik_frame_).inverse() * ikq;  // valid isometry * valid isometry
+    point = ikq.translation();
+    quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
   }
-  return false;
+
+  if (need_eef_to_ik_tip_transform_)
+  {
+    // After sampling the pose needs to be transformed to the ik chain tip
+    Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
+    ikq = ikq * eef_to_ik_tip_transform_;  // eef_to_ik_tip_transform_ is valid isometry (checked in loadIKSolver())
+    point = ikq.translation();
+    quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
+  }
+
+  ik_query.position.x = point.x();
+  ik_query.position.y = point.y();
+  ik_query.position.z = point.z();
+  ik_query.orientation.x = quat.x();
+  ik_query.orientation.y = quat.y();
+  ik_query.orientation.z = quat.z();
+  ik_query.orientation.w = quat.w();
+  return true;
+}
+
+kinematics::KinematicsBase::IKCallbackFn
+IKConstraintSampler::adaptIKValidityCallback(moveit::core::RobotState& state) const
+{
+  if (!group_state_validity_callback_)
+    return kinematics::KinematicsBase::IKCallbackFn();
+  return [this, state_ptr = &state](const geometry_msgs::msg::Pose&, const std::vector<double>& joints,
+                                    moveit_msgs::msg::MoveItErrorCodes& error_code) {
+    return samplingIkCallbackFnAdapter(state_ptr, jmg_, group_state_validity_callback_, joints, error_code);
+  };
 }
 
 bool IKConstraintSampler::validate(moveit::core::RobotState& state) const
@@ -657,10 +790,15 @@ bool IKConstraintSampler::callIK(const geometry_msgs::msg::Pose& ik_query,
                                  const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
                                  double timeout, moveit::core::RobotState& state, bool use_as_seed)
 {
-  const std::vector<size_t>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
-  std::vector<double> seed(ik_joint_bijection.size(), 0.0);
-  std::vector<double> vals;
+  return callIK(ik_query, adapted_ik_validity_callback, timeout, state, use_as_seed, random_number_generator_);
+}
 
+bool IKConstraintSampler::callIK(const geometry_msgs::msg::Pose& ik_query,
+                                 const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
+                                 double timeout, moveit::core::RobotState& state, bool use_as_seed,
+                                 random_numbers::RandomNumberGenerator& rng) const
+{
+  std::vector<double> vals;
   if (use_as_seed)
   {
     state.copyJointGroupPositions(jmg_, vals);
@@ -668,9 +806,18 @@ bool IKConstraintSampler::callIK(const geometry_msgs::msg::Pose& ik_query,
   else
   {
     // sample a seed value
-    jmg_->getVariableRandomPositions(random_number_generator_, vals);
+    jmg_->getVariableRandomPositions(rng, vals);
   }
+  return callIKWithSeed(ik_query, adapted_ik_validity_callback, timeout, state, vals);
+}
 
+bool IKConstraintSampler::callIKWithSeed(const geometry_msgs::msg::Pose& ik_query,
+                                         const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
+                                         double timeout, moveit::core::RobotState& state,
+                                         const std::vector<double>& vals) const
+{
+  const std::vector<size_t>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
+  std::vector<double> seed(ik_joint_bijection.size(), 0.0);
   assert(vals.size() == ik_joint_bijection.size());
   for (std::size_t i = 0; i < ik_joint_bijection.size(); ++i)
     seed[i] = vals[ik_joint_bijection[i]];
@@ -0,0 +1,99 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/halton_sequence.h>
+
+namespace constraint_samplers
+{
+namespace
+{
+std::vector<unsigned int> firstPrimes(std::size_t count)
+{
+  std::vector<unsigned int> primes;
+  primes.reserve(count);
+  for (unsigned int candidate = 2; primes.size() < count; ++candidate)
+  {
+    bool is_prime = true;
+    for (unsigned int prime : primes)
+    {
+      if (prime * prime > candidate)
+        break;
+      if (candidate % prime == 0)
+      {
+        is_prime = false;
+        break;
+      }
+    }
+    if (is_prime)
+      primes.push_back(candidate);
+  }
+  return primes;
+}
+}  // namespace
+
+HaltonSequence::HaltonSequence(std::size_t dimension) : bases_(firstPrimes(dimension)), shifts_(dimension, 0.0)
+{
+}
+
+HaltonSequence::HaltonSequence(std::size_t dimension, random_numbers::RandomNumberGenerator& rng)
+  : HaltonSequence(dimension)
+{
+  for (double& shift : shifts_)
+    shift = rng.uniform01();
+}
+
+double HaltonSequence::radicalInverse(std::uint64_t index, unsigned int base)
+{
+  const double inv_base = 1.0 / base;
+  double inv_base_power = inv_base;
+  double result = 0.0;
+  while (index > 0)
+  {
+    result += static_cast<double>(index % base) * inv_base_power;
+    index /= base;
+    inv_base_power *= inv_base;
+  }
+  return result;
+}
+
+void HaltonSequence::next(double* point)
+{
+  for (std::size_t i = 0; i < bases_.size(); ++i)
+  {
+    const double value = radicalInverse(index_, bases_[i]) + shifts_[i];
+    point[i] = value < 1.0 ? value : value - 1.0;
+  }
+  ++index_;
+}
+}  // namespace constraint_samplers
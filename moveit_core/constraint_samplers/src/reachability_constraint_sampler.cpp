@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/reachability_constraint_sampler.h>
+#include <moveit/transforms/transforms.h>
+#include <tf2_eigen/tf2_eigen.hpp>
+
+namespace constraint_samplers
+{
+namespace
+{
+std::string stripLeadingSlash(const std::string& frame)
+{
+  return !frame.empty() && frame[0] == '/' ? frame.substr(1) : frame;
+}
+}  // namespace
+
+bool ReachabilityConstraintSampler::getMapFrames(const moveit::core::JointModelGroup* jmg, std::string& base_frame,
+                                                 std::string& tip_frame)
+{
+  const kinematics::KinematicsBaseConstPtr& solver = jmg->getSolverInstance();
+  if (!solver)
+    return false;
+
+  // mirror IKConstraintSampler::loadIKSolver(), which only transforms queries into base frames that are links
+  const moveit::core::RobotModel& robot_model = jmg->getParentModel();
+  base_frame = stripLeadingSlash(solver->getBaseFrame());
+  if (moveit::core::Transforms::sameFrame(base_frame, robot_model.getModelFrame()) ||
+      !robot_model.hasLinkModel(base_frame))
+    base_frame = robot_model.getModelFrame();
+  tip_frame = stripLeadingSlash(solver->getTipFrame());
+  return robot_model.hasLinkModel(tip_frame);
+}
+
+bool ReachabilityConstraintSampler::mapMatchesSolver() const
+{
+  std::string base_frame, tip_frame;
+  return map_ && map_->getGroupName() == jmg_->getName() && getMapFrames(jmg_, base_frame, tip_frame) &&
+         map_->getBaseFrame() == base_frame && map_->getTipFrame() == tip_frame;
+}
+
+bool ReachabilityConstraintSampler::callIK(const geometry_msgs::msg::Pose& ik_query,
+                                           const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
+                                           double timeout, moveit::core::RobotState& state, bool use_as_seed,
+                                           random_numbers::RandomNumberGenerator& rng) const
+{
+  if (use_as_seed || !mapMatchesSolver())
+    return IKConstraintSampler::callIK(ik_query, adapted_ik_validity_callback, timeout, state, use_as_seed, rng);
+
+  Eigen::Isometry3d pose;
+  tf2::fromMsg(ik_query, pose);
+  std::vector<std::vector<double>> seeds;
+  if (map_->findConfigurations(pose, seeds_per_attempt_, seeds) == 0)
+    return false;
+
+  // the seeds share the timeout of a single attempt
+  const double seed_timeout = timeout / seeds.size();
+  for (const std::vector<double>& seed : seeds)
+  {
+    if (callIKWithSeed(ik_query, adapted_ik_validity_callback, seed_timeout, state, seed))
+      return true;
+  }
+  return false;
+}
+}  // namespace constraint_samplers
@@ -0,0 +1,401 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/reachability_map.h>
+#include <moveit/robot_state/robot_state.h>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <random_numbers/random_numbers.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace constraint_samplers
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_constraint_samplers.reachability_map");
+
+namespace
+{
+/// Header of a map, followed by the cell table at cells_offset and the entries at entries_offset
+struct MapHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t variable_count;
+  std::uint32_t num_cells[3];
+  double resolution;
+  double origin[3];
+  std::uint64_t model_hash;
+  std::uint64_t entry_count;
+  std::uint64_t cells_offset;
+  std::uint64_t entries_offset;
+};
+
+const char MAP_MAGIC[8] = { 'M', 'V', 'I', 'T', 'R', 'M', 'A', 'P' };
+const std::uint32_t MAP_VERSION = 1;
+const std::uint32_t MAP_BYTE_ORDER = 0x01020304;
+// the number of floats storing the orientation of an entry
+const std::size_t ORIENTATION_SIZE = 4;
+// cells are limited so that entry indices fit the cell table
+const std::uint64_t MAX_CELL_COUNT = std::uint64_t(1) << 28;
+
+std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + 63) / 64 * 64;
+}
+
+// FNV-1a hash of everything a map depends on, so that maps of other robots or groups are rejected
+std::uint64_t computeModelHash(const moveit::core::RobotModel& robot_model, const moveit::core::JointModelGroup& jmg,
+                               const std::string& base_frame, const std::string& tip_frame)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  const auto add = [&hash](const std::string& value) {
+    for (const char c : value)
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    hash = hash * 1099511628211ULL;  // separator
+  };
+  add(robot_model.getName());
+  add(jmg.getName());
+  add(base_frame);
+  add(tip_frame);
+  for (const std::string& name : jmg.getVariableNames())
+    add(name);
+  return hash;
+}
+}  // namespace
+
+ReachabilityMapPtr ReachabilityMap::build(const moveit::core::RobotModelConstPtr& robot_model,
+                                          const std::string& group_name, const std::string& base_frame,
+                                          const std::string& tip_frame, const Options& options)
+{
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group_name);
+  if (!jmg)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to build a reachability map for unknown group '%s'", group_name.c_str());
+    return ReachabilityMapPtr();
+  }
+  if (!robot_model->hasLinkModel(base_frame) || !robot_model->hasLinkModel(tip_frame))
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to build a reachability map from '%s' to '%s': unknown link", base_frame.c_str(),
+                 tip_frame.c_str());
+    return ReachabilityMapPtr();
+  }
+  if (options.resolution <= 0.0 || options.sample_count == 0 || options.max_entries_per_cell == 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Reachability maps need a positive resolution, sample count and number of entries per cell");
+    return ReachabilityMapPtr();
+  }
+
+  const moveit::core::LinkModel* base_link = robot_model->getLinkModel(base_frame);
+  const moveit::core::LinkModel* tip_link = robot_model->getLinkModel(tip_frame);
+  const std::size_t variable_count = jmg->getVariableCount();
+  const std::size_t stride = ORIENTATION_SIZE + variable_count;
+
+  // sample configurations and their tip poses
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  random_numbers::RandomNumberGenerator rng(options.seed);
+  std::vector<float> samples(options.sample_count * stride);
+  EigenSTL::vector_Vector3d positions(options.sample_count);
+  Eigen::AlignedBox3d box;
+  std::vector<double> values;
+  for (std::size_t i = 0; i < options.sample_count; ++i)
+  {
+    state.setToRandomPositions(jmg, rng);
+    state.update();
+    const Eigen::Isometry3d pose =
+        state.getGlobalLinkTransform(base_link).inverse() * state.getGlobalLinkTransform(tip_link);
+    positions[i] = pose.translation();
+    box.extend(positions[i]);
+
+    const Eigen::Quaterniond orientation(pose.linear());
+    float* sample = &samples[i * stride];
+    sample[0] = orientation.x();
+    sample[1] = orientation.y();
+    sample[2] = orientation.z();
+    sample[3] = orientation.w();
+    state.copyJointGroupPositions(jmg, values);
+    std::copy(values.begin(), values.end(), sample + ORIENTATION_SIZE);
+  }
+
+  // bin the samples, keeping the first ones seen in each cell
+  std::uint32_t num_cells[3];
+  std::uint64_t cell_count = 1;
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    num_cells[k] = static_cast<std::uint32_t>(std::floor(box.sizes()[k] / options.resolution)) + 1;
+    cell_count *= num_cells[k];
+  }
+  if (cell_count > MAX_CELL_COUNT)
+  {
+    RCLCPP_ERROR(LOGGER, "A reachability map of resolution %f for group '%s' would need %lu cells, which is too many",
+                 options.resolution, group_name.c_str(), static_cast<unsigned long>(cell_count));
+    return ReachabilityMapPtr();
+  }
+
+  const std::uint32_t unused = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> sample_cells(options.sample_count, unused);
+  std::vector<std::uint32_t> cells(cell_count + 1, 0);
+  for (std::size_t i = 0; i < options.sample_count; ++i)
+  {
+    std::uint64_t index = 0;
+    for (std::size_t k = 3; k-- > 0;)
+    {
+      const double offset = (positions[i][k] - box.min()[k]) / options.resolution;
+      index = index * num_cells[k] + std::min<std::uint32_t>(static_cast<std::uint32_t>(offset), num_cells[k] - 1);
+    }
+    if (cells[index + 1] < options.max_entries_per_cell)
+    {
+      ++cells[index + 1];
+      sample_cells[i] = static_cast<std::uint32_t>(index);
+    }
+  }
+  for (std::size_t c = 0; c < cell_count; ++c)
+    cells[c + 1] += cells[c];
+
+  MapHeader header{};
+  std::memcpy(header.magic, MAP_MAGIC, sizeof(header.magic));
+  header.version = MAP_VERSION;
+  header.byte_order = MAP_BYTE_ORDER;
+  header.variable_count = static_cast<std::uint32_t>(variable_count);
+  header.resolution = options.resolution;
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    header.num_cells[k] = num_cells[k];
+    header.origin[k] = box.min()[k];
+  }
+  header.model_hash = computeModelHash(*robot_model, *jmg, base_frame, tip_frame);
+  header.entry_count = cells[cell_count];
+  header.cells_offset = alignOffset(sizeof(MapHeader));
+  header.entries_offset = alignOffset(header.cells_offset + cells.size() * sizeof(std::uint32_t));
+
+  auto buffer = std::make_shared<std::vector<char>>(header.entries_offset +
+                                                    header.entry_count * stride * sizeof(float));
+  std::memcpy(buffer->data(), &header, sizeof(header));
+  std::memcpy(buffer->data() + header.cells_offset, cells.data(), cells.size() * sizeof(std::uint32_t));
+  float* entries = reinterpret_cast<float*>(buffer->data() + header.entries_offset);
+  std::vector<std::uint32_t> next_entry(cells.begin(), cells.end() - 1);
+  for (std::size_t i = 0; i < options.sample_count; ++i)
+  {
+    if (sample_cells[i] != unused)
+      std::copy_n(&samples[i * stride], stride, entries + next_entry[sample_cells[i]]++ * stride);
+  }
+
+  ReachabilityMapPtr map(new ReachabilityMap());
+  map->group_name_ = group_name;
+  map->base_frame_ = base_frame;
+  map->tip_frame_ = tip_frame;
+  map->data_size_ = buffer->size();
+  map->setData(buffer->data(), buffer);
+  RCLCPP_INFO(LOGGER, "Built a reachability map for group '%s' with %lu configurations in %lu cells",
+              group_name.c_str(), static_cast<unsigned long>(header.entry_count),
+              static_cast<unsigned long>(cell_count));
+  return map;
+}
+
+ReachabilityMapPtr ReachabilityMap::readFromFile(const std::string& filename,
+                                                 const moveit::core::RobotModelConstPtr& robot_model,
+                                                 const std::string& group_name, const std::string& base_frame,
+                                                 const std::string& tip_frame)
+{
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group_name);
+  if (!jmg)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to read a reachability map for unknown group '%s'", group_name.c_str());
+    return ReachabilityMapPtr();
+  }
+
+  auto file = std::make_shared<boost::iostreams::mapped_file_source>();
+  try
+  {
+    file->open(filename);
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_DEBUG(LOGGER, "Unable to map reachability map file '%s': %s", filename.c_str(), e.what());
+    return ReachabilityMapPtr();
+  }
+
+  MapHeader header;
+  if (file->size() < sizeof(header))
+  {
+    RCLCPP_ERROR(LOGGER, "Reachability map file '%s' is too short", filename.c_str());
+    return ReachabilityMapPtr();
+  }
+  std::memcpy(&header, file->data(), sizeof(header));
+  if (std::memcmp(header.magic, MAP_MAGIC, sizeof(header.magic)) != 0 || header.version != MAP_VERSION ||
+      header.byte_order != MAP_BYTE_ORDER)
+  {
+    RCLCPP_ERROR(LOGGER, "'%s' is not a reachability map file of version %u", filename.c_str(), MAP_VERSION);
+    return ReachabilityMapPtr();
+  }
+  if (header.model_hash != computeModelHash(*robot_model, *jmg, base_frame, tip_frame) ||
+      header.variable_count != jmg->getVariableCount())
+  {
+    RCLCPP_WARN(LOGGER, "Reachability map file '%s' was built for a different robot, group or frames",
+                filename.c_str());
+    return ReachabilityMapPtr();
+  }
+
+  const std::uint64_t cell_count =
+      std::uint64_t(header.num_cells[0]) * std::uint64_t(header.num_cells[1]) * std::uint64_t(header.num_cells[2]);
+  const std::uint64_t stride = ORIENTATION_SIZE + header.variable_count;
+  const bool layout_valid =
+      cell_count > 0 && cell_count <= MAX_CELL_COUNT && header.resolution > 0.0 && header.cells_offset % 64 == 0 &&
+      header.entries_offset % 64 == 0 && header.cells_offset >= sizeof(MapHeader) &&
+      header.entries_offset >= header.cells_offset + (cell_count + 1) * sizeof(std::uint32_t) &&
+      header.entries_offset <= file->size() &&
+      (file->size() - header.entries_offset) / (stride * sizeof(float)) >= header.entry_count;
+  if (!layout_valid)
+  {
+    RCLCPP_ERROR(LOGGER, "Reachability map file '%s' is truncated or corrupt", filename.c_str());
+    return ReachabilityMapPtr();
+  }
+  const auto* cells = reinterpret_cast<const std::uint32_t*>(file->data() + header.cells_offset);
+  for (std::uint64_t c = 0; c < cell_count; ++c)
+  {
+    if (cells[c] > cells[c + 1] || (c == 0 && cells[0] != 0) || cells[c + 1] > header.entry_count)
+    {
+      RCLCPP_ERROR(LOGGER, "Reachability map file '%s' has an inconsistent cell table", filename.c_str());
+      return ReachabilityMapPtr();
+    }
+  }
+
+  ReachabilityMapPtr map(new ReachabilityMap());
+  map->group_name_ = group_name;
+  map->base_frame_ = base_frame;
+  map->tip_frame_ = tip_frame;
+  map->data_size_ = file->size();
+  map->setData(file->data(), file);
+  return map;
+}
+
+bool ReachabilityMap::writeToFile(const std::string& filename) const
+{
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os.good())
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open '%s' for writing the reachability map", filename.c_str());
+    return false;
+  }
+  os.write(data_, data_size_);
+  os.close();
+  if (os.fail())
+  {
+    RCLCPP_ERROR(LOGGER, "Failed writing the reachability map to '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+void ReachabilityMap::setData(const char* data, std::shared_ptr<const void> owner)
+{
+  MapHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  data_ = data;
+  owner_ = std::move(owner);
+  cells_ = reinterpret_cast<const std::uint32_t*>(data + header.cells_offset);
+  entries_ = reinterpret_cast<const float*>(data + header.entries_offset);
+  entry_stride_ = ORIENTATION_SIZE + header.variable_count;
+  resolution_ = header.resolution;
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    num_cells_[k] = header.num_cells[k];
+    origin_[k] = header.origin[k];
+  }
+}
+
+std::size_t ReachabilityMap::getVariableCount() const
+{
+  return entry_stride_ - ORIENTATION_SIZE;
+}
+
+std::size_t ReachabilityMap::getEntryCount() const
+{
+  return cells_[num_cells_[0] * num_cells_[1] * num_cells_[2]];
+}
+
+std::size_t ReachabilityMap::findConfigurations(const Eigen::Isometry3d& pose, std::size_t max_count,
+                                                std::vector<std::vector<double>>& configurations) const
+{
+  configurations.clear();
+  if (max_count == 0)
+    return 0;
+
+  // the cell containing the position, in grid coordinates; positions far outside of the grid find nothing
+  const Eigen::Vector3d position = (pose.translation() - origin_) / resolution_;
+  long cell[3];
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    if (!(position[k] >= -1.0 && position[k] < static_cast<double>(num_cells_[k]) + 1.0))
+      return 0;
+    cell[k] = static_cast<long>(std::floor(position[k]));
+  }
+
+  // candidates from the cell and its neighbors, by their angle to the requested orientation
+  const Eigen::Quaterniond orientation(pose.linear());
+  std::vector<std::pair<double, const float*>> candidates;
+  for (long z = cell[2] - 1; z <= cell[2] + 1; ++z)
+  {
+    for (long y = cell[1] - 1; y <= cell[1] + 1; ++y)
+    {
+      for (long x = cell[0] - 1; x <= cell[0] + 1; ++x)
+      {
+        if (x < 0 || y < 0 || z < 0 || x >= static_cast<long>(num_cells_[0]) ||
+            y >= static_cast<long>(num_cells_[1]) || z >= static_cast<long>(num_cells_[2]))
+          continue;
+        const std::size_t index = x + num_cells_[0] * (y + num_cells_[1] * z);
+        for (std::uint32_t e = cells_[index]; e < cells_[index + 1]; ++e)
+        {
+          const float* entry = entries_ + e * entry_stride_;
+          const Eigen::Quaterniond entry_orientation(entry[3], entry[0], entry[1], entry[2]);
+          candidates.emplace_back(orientation.angularDistance(entry_orientation), entry);
+        }
+      }
+    }
+  }
+
+  const std::size_t count = std::min(max_count, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                    [](const auto& a, const auto& b) { return a.first < b.first; });
+  configurations.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    configurations.emplace_back(candidates[i].second + ORIENTATION_SIZE, candidates[i].second + entry_stride_);
+  return count;
+}
+}  // namespace constraint_samplers
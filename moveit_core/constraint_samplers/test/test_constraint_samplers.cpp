@@ -40,6 +40,7 @@
 #include <moveit/constraint_samplers/union_constraint_sampler.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/constraint_samplers/constraint_sampler_tools.h>
+#include <moveit/constraint_samplers/reachability_constraint_sampler.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
@@ -710,6 +711,119 @@ TEST_F(LoadPlanningModelsPr2, PoseConstraintSamplerManager)
   EXPECT_NEAR(iks->getOrientationConstraint()->getXAxisTolerance(), .1, .0001);
 }
 
+TEST_F(LoadPlanningModelsPr2, ParallelIKConstraintSamplerManager)
+{
+  moveit::core::RobotState ks(robot_model_);
+  ks.setToDefaultValues();
+  ks.update();
+  moveit::core::RobotState ks_const(robot_model_);
+  ks_const.setToDefaultValues();
+  ks_const.update();
+
+  moveit_msgs::msg::PositionConstraint pcm;
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = robot_model_->getModelFrame();
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::msg::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 0.001;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].position.x = 0.55;
+  pcm.constraint_region.primitive_poses[0].position.y = 0.2;
+  pcm.constraint_region.primitive_poses[0].position.z = 1.25;
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+
+  moveit_msgs::msg::Constraints c;
+  c.position_constraints.push_back(pcm);
+
+  constraint_samplers::ConstraintSamplerManager manager;
+  manager.setIKSamplerThreadCount(4);
+  EXPECT_EQ(manager.getIKSamplerThreadCount(), 4u);
+  constraint_samplers::ConstraintSamplerPtr s = manager.selectSampler(ps_, "left_arm", c);
+  ASSERT_TRUE(s != nullptr);
+  constraint_samplers::IKConstraintSampler* iks = dynamic_cast<constraint_samplers::IKConstraintSampler*>(s.get());
+  ASSERT_TRUE(iks);
+  EXPECT_EQ(iks->getThreadCount(), 4u);
+
+  for (int t = 0; t < 20; ++t)
+  {
+    EXPECT_TRUE(s->sample(ks, ks_const, 100));
+    EXPECT_TRUE(iks->getPositionConstraint()->decide(ks).satisfied);
+  }
+
+  // the samples come back valid and sorted by their distance to the reference state
+  std::vector<moveit::core::RobotState> samples;
+  EXPECT_EQ(iks->sampleMultiple(samples, ks_const, 5, 500), 5u);
+  ASSERT_EQ(samples.size(), 5u);
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("left_arm");
+  for (std::size_t i = 0; i < samples.size(); ++i)
+  {
+    samples[i].update();
+    EXPECT_TRUE(iks->getPositionConstraint()->decide(samples[i]).satisfied);
+    if (i > 0)
+      EXPECT_LE(ks_const.distance(samples[i - 1], jmg), ks_const.distance(samples[i], jmg));
+  }
+}
+
+TEST_F(LoadPlanningModelsPr2, ReachabilityConstraintSampler)
+{
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("left_arm");
+  std::string base_frame, tip_frame;
+  ASSERT_TRUE(constraint_samplers::ReachabilityConstraintSampler::getMapFrames(jmg, base_frame, tip_frame));
+
+  constraint_samplers::ReachabilityMap::Options options;
+  options.resolution = 0.1;
+  options.sample_count = 20000;
+  constraint_samplers::ReachabilityMapConstPtr map =
+      constraint_samplers::ReachabilityMap::build(robot_model_, "left_arm", base_frame, tip_frame, options);
+  ASSERT_TRUE(map != nullptr);
+  EXPECT_EQ(map->getVariableCount(), jmg->getVariableCount());
+  EXPECT_GT(map->getEntryCount(), 0u);
+
+  // the file is mapped back with the same content, and rejected for other groups
+  ASSERT_TRUE(map->writeToFile("test_reachability.rmap"));
+  constraint_samplers::ReachabilityMapConstPtr mapped = constraint_samplers::ReachabilityMap::readFromFile(
+      "test_reachability.rmap", robot_model_, "left_arm", base_frame, tip_frame);
+  ASSERT_TRUE(mapped != nullptr);
+  EXPECT_EQ(mapped->getEntryCount(), map->getEntryCount());
+  EXPECT_TRUE(constraint_samplers::ReachabilityMap::readFromFile("test_reachability.rmap", robot_model_, "right_arm",
+                                                                 base_frame, tip_frame) == nullptr);
+
+  moveit::core::RobotState ks(robot_model_);
+  ks.setToDefaultValues();
+  ks.update();
+  moveit::core::RobotState ks_const(robot_model_);
+  ks_const.setToDefaultValues();
+  ks_const.update();
+
+  moveit_msgs::msg::PositionConstraint pcm;
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = robot_model_->getModelFrame();
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::msg::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 0.001;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].position.x = 0.55;
+  pcm.constraint_region.primitive_poses[0].position.y = 0.2;
+  pcm.constraint_region.primitive_poses[0].position.z = 1.25;
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+
+  moveit_msgs::msg::Constraints c;
+  c.position_constraints.push_back(pcm);
+
+  constraint_samplers::ReachabilityConstraintSampler sampler(ps_, "left_arm", mapped);
+  ASSERT_TRUE(sampler.configure(c));
+  EXPECT_EQ(sampler.getName(), "ReachabilityConstraintSampler");
+  for (int t = 0; t < 20; ++t)
+  {
+    EXPECT_TRUE(sampler.sample(ks, ks_const, 100));
+    EXPECT_TRUE(sampler.getPositionConstraint()->decide(ks).satisfied);
+  }
+}
+
 TEST_F(LoadPlanningModelsPr2, JointVersusPoseConstraintSamplerManager)
 {
   moveit::core::RobotState ks(robot_model_);
@@ -1170,6 +1284,77 @@ TEST_F(LoadPlanningModelsPr2, JointConstraintsSamplerSeeded)
   EXPECT_THAT(joint_positions_v2, Not(ContainerEq(joint_positions_v3)));
 }
 
+TEST(HaltonSequence, RadicalInverse)
+{
+  EXPECT_DOUBLE_EQ(constraint_samplers::HaltonSequence::radicalInverse(0, 2), 0.0);
+  EXPECT_DOUBLE_EQ(constraint_samplers::HaltonSequence::radicalInverse(1, 2), 0.5);
+  EXPECT_DOUBLE_EQ(constraint_samplers::HaltonSequence::radicalInverse(6, 2), 0.375);
+  EXPECT_DOUBLE_EQ(constraint_samplers::HaltonSequence::radicalInverse(5, 3), 7.0 / 9.0);
+
+  constraint_samplers::HaltonSequence sequence(2);
+  double point[2];
+  sequence.next(point);
+  EXPECT_DOUBLE_EQ(point[0], 0.5);
+  EXPECT_DOUBLE_EQ(point[1], 1.0 / 3.0);
+  sequence.next(point);
+  EXPECT_DOUBLE_EQ(point[0], 0.25);
+  EXPECT_DOUBLE_EQ(point[1], 2.0 / 3.0);
+  sequence.reset();
+  sequence.next(point);
+  EXPECT_DOUBLE_EQ(point[0], 0.5);
+}
+
+TEST_F(LoadPlanningModelsPr2, JointConstraintsSamplerQuasiRandom)
+{
+  kinematic_constraints::JointConstraint jc(robot_model_);
+  moveit_msgs::msg::JointConstraint jcm;
+  jcm.position = 0.42;
+  jcm.tolerance_above = 0.01;
+  jcm.tolerance_below = 0.05;
+  jcm.weight = 1.0;
+  jcm.joint_name = "r_shoulder_pan_joint";
+  EXPECT_TRUE(jc.configure(jcm));
+  std::vector<kinematic_constraints::JointConstraint> js;
+  js.push_back(jc);
+
+  constraint_samplers::JointConstraintSampler sampler1(ps_, "right_arm", 314159);
+  constraint_samplers::JointConstraintSampler sampler2(ps_, "right_arm", 314159);
+  sampler1.setQuasiRandomSampling(true);
+  sampler2.setQuasiRandomSampling(true);
+  EXPECT_TRUE(sampler1.getQuasiRandomSampling());
+  EXPECT_TRUE(sampler1.configure(js));
+  EXPECT_TRUE(sampler2.configure(js));
+
+  moveit::core::RobotState ks1(robot_model_);
+  ks1.setToDefaultValues();
+  moveit::core::RobotState ks2(ks1);
+
+  // the samples of the constrained joint are spread evenly over its allowed interval
+  const std::size_t bins = 8;
+  const std::size_t samples = 64;
+  std::vector<std::size_t> counts(bins, 0);
+  for (std::size_t t = 0; t < samples; ++t)
+  {
+    EXPECT_TRUE(sampler1.sample(ks1, ks1, 1));
+    EXPECT_TRUE(sampler2.sample(ks2, ks2, 1));
+    EXPECT_TRUE(jc.decide(ks1).satisfied);
+    ks1.update();
+    EXPECT_TRUE(ks1.satisfiesBounds(robot_model_->getJointModelGroup("right_arm")));
+
+    // equally seeded samplers follow the same sequence
+    const double value = ks1.getVariablePosition("r_shoulder_pan_joint");
+    EXPECT_EQ(value, ks2.getVariablePosition("r_shoulder_pan_joint"));
+
+    const double u = (value - (jcm.position - jcm.tolerance_below)) / (jcm.tolerance_below + jcm.tolerance_above);
+    ++counts[std::min(bins - 1, static_cast<std::size_t>(u * bins))];
+  }
+  for (std::size_t count : counts)
+  {
+    EXPECT_GE(count, samples / bins - 1);
+    EXPECT_LE(count, samples / bins + 1);
+  }
+}
+
 TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerSeeded)
 {
   kinematic_constraints::PositionConstraint pc(robot_model_);
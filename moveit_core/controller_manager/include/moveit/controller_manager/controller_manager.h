@@ -127,6 +127,18 @@ public:
    * Return false when the controller cannot accept the trajectory. */
   virtual bool sendTrajectory(const moveit_msgs::msg::RobotTrajectory& trajectory) = 0;
 
+  /** \brief Replace the tail of the trajectory that is currently executed by the controller.
+   *
+   * The controller keeps following the active trajectory until the header stamp of the given trajectory and then
+   * continues with the given trajectory, without stopping in between. Subsequent calls to waitForExecution() and
+   * getLastExecutionStatus() refer to the spliced trajectory.
+   * Return false when the controller does not support splicing, is not executing a trajectory, or rejected
+   * the trajectory. */
+  virtual bool spliceTrajectory(const moveit_msgs::msg::RobotTrajectory& /* trajectory */)
+  {
+    return false;
+  }
+
   /** \brief Cancel the execution of any motion using this controller.
    *
    * Report false if canceling is not possible.
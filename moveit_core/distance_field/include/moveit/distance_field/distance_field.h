@@ -321,6 +321,44 @@ public:
    */
   double getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z,
                              bool& in_bounds) const;
+
+  /**
+   * \brief Computes distances and gradients for a batch of points, with
+   * the same results as calling getDistanceGradient() for each of them.
+   * Points that are not valid for gradient purposes get the
+   * uninitialized distance and a zero gradient.
+   *
+   * The points are given as rows of a column-major matrix, so that
+   * all X, all Y and all Z coordinates are contiguous in memory.
+   * Derived classes can override this to vectorize the lookup.
+   *
+   * @param [in] points One point per row
+   * @param [out] distances The distance for each point, sized like \e points
+   * @param [out] gradients The gradient for each point, sized like \e points
+   */
+  virtual void getDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                    Eigen::Ref<Eigen::VectorXd> distances,
+                                    Eigen::Ref<Eigen::MatrixX3d> gradients) const;
+
+  /**
+   * \brief Computes distances and gradients for a batch of points by
+   * trilinear interpolation between the distances of the 8 cells
+   * around each point.
+   *
+   * Unlike getDistanceGradient(), the distance is continuous across
+   * cell boundaries and the gradient is the exact derivative of the
+   * interpolated distance.  At cell centers, the distance is the
+   * distance of the cell.  Points for which not all 8 cells lie inside
+   * the boundary cells of the field get the uninitialized distance
+   * and a zero gradient.
+   *
+   * @param [in] points One point per row
+   * @param [out] distances The distance for each point, sized like \e points
+   * @param [out] gradients The gradient for each point, sized like \e points
+   */
+  virtual void getInterpolatedDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                                Eigen::Ref<Eigen::VectorXd> distances,
+                                                Eigen::Ref<Eigen::MatrixX3d> gradients) const;
   /**
    * \brief Gets the distance to the closest obstacle at the given
    * integer cell location. The particulars of this function are
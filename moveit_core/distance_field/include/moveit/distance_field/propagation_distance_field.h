@@ -40,7 +40,9 @@
 #include <moveit/distance_field/distance_field.h>
 #include <vector>
 #include <Eigen/Core>
+#include <algorithm>
 #include <set>
+#include <thread>
 #include <octomap/octomap.h>
 #include <rclcpp/rclcpp.hpp>
 
@@ -140,6 +142,12 @@ struct PropDistanceFieldVoxel
  * gradients pointing out of the volume will be produced.  Depending
  * on the data, calculating this data can significantly impact the
  * time it takes to add and remove obstacle cells.
+ *
+ * The grid always uses DenseVoxelStorage, not BlockSparseVoxelStorage:
+ * fields read with readFromFile() use the memory-mapped file as their
+ * cells, reset() writes a different closest negative point into every
+ * cell, and the multi-threaded distance transform writes cells from
+ * several threads, which would race on allocating bricks.
  */
 class PropagationDistanceField : public DistanceField
 {
@@ -168,10 +176,13 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] thread_count The number of threads used to compute
+   * distances, see \ref setThreadCount.
+   *
    */
   PropagationDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
                            double origin_y, double origin_z, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, std::size_t thread_count = 1);
 
   /**
    * \brief Constructor based on an OcTree and bounding box
@@ -194,10 +205,13 @@ public:
    * and all obstacle cells will be assigned zero distance.  See the
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
+   *
+   * @param [in] thread_count The number of threads used to compute
+   * distances, see \ref setThreadCount.
    */
   PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                            const octomap::point3d& bbx_max, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, std::size_t thread_count = 1);
 
   /**
    * \brief Constructor that takes an istream and reads the contents
@@ -332,6 +346,29 @@ public:
    */
   double getDistance(int x, int y, int z) const override;
 
+  /**
+   * \brief Batched version of getDistanceGradient(), see
+   * DistanceField::getDistanceGradients().
+   *
+   * The cell indices and the bounds checks of all points are
+   * computed with vectorized array operations before the distances
+   * are gathered from the voxel grid.
+   */
+  void getDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points, Eigen::Ref<Eigen::VectorXd> distances,
+                            Eigen::Ref<Eigen::MatrixX3d> gradients) const override;
+
+  /**
+   * \brief Vectorized version of
+   * DistanceField::getInterpolatedDistanceGradients().
+   *
+   * Only gathering the distances of the 8 cells around each point is
+   * done per point, the cell indices, bounds checks and the
+   * interpolation are vectorized array operations over all points.
+   */
+  void getInterpolatedDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                        Eigen::Ref<Eigen::VectorXd> distances,
+                                        Eigen::Ref<Eigen::MatrixX3d> gradients) const override;
+
   bool isCellValid(int x, int y, int z) const override;
   int getXNumCells() const override;
   int getYNumCells() const override;
@@ -375,6 +412,40 @@ public:
    */
   bool readFromStream(std::istream& stream) override;
 
+  /**
+   * \brief Writes the complete distance field to a binary file that
+   * can be memory-mapped by \ref readFromFile.
+   *
+   * Unlike \ref writeToStream, which only stores occupancy, this
+   * stores all voxels uncompressed after a small versioned header
+   * holding the resolution, size, origin, max_distance and
+   * propagate_negative_distances values, so that no propagation is
+   * needed on load.  The file is only readable on machines with the
+   * same byte order and voxel layout.
+   *
+   * @param [in] filename The file to write
+   *
+   * @return True if the file was written successfully; otherwise False.
+   */
+  bool writeToFile(const std::string& filename) const;
+
+  /**
+   * \brief Memory-maps a distance field file written by \ref writeToFile.
+   *
+   * All parameters, including max_distance and
+   * propagate_negative_distances, are taken from the file.  The voxels
+   * are used in place without copying or propagation, so loading takes
+   * time independent of the field size, and processes mapping the same
+   * file share its pages.  The mapping is private: modifying the field
+   * afterwards copies only the touched pages and never changes the file.
+   * On failure, the distance field is left unchanged.
+   *
+   * @param [in] filename The file to map
+   *
+   * @return True if the file is a valid distance field file; otherwise False.
+   */
+  bool readFromFile(const std::string& filename);
+
   // passthrough docs to DistanceField
   double getUninitializedDistance() const override
   {
@@ -452,6 +523,35 @@ public:
     return max_distance_sq_;
   }
 
+  /**
+   * \brief Sets the number of threads used to compute distances.
+   *
+   * With a single thread (the default), changes to the obstacles are
+   * propagated incrementally from the changed cells.  With more than
+   * one thread, every change recomputes the exact Euclidean distance
+   * transform of the whole field with a separable algorithm, whose
+   * passes are split across the threads.  The result does not depend
+   * on the number of threads, but it may differ from the incremental
+   * propagation in the few cells where the propagation overestimates
+   * the distance.  This mode pays off when large parts of the field
+   * change at once, e.g. when it is rebuilt from an octomap.  A value
+   * of 0 uses one thread per hardware core.
+   *
+   * @param [in] thread_count The number of threads
+   */
+  void setThreadCount(std::size_t thread_count)
+  {
+    thread_count_ = thread_count == 0 ? std::max(1u, std::thread::hardware_concurrency()) : thread_count;
+  }
+
+  /**
+   * \brief Gets the number of threads used to compute distances.
+   */
+  std::size_t getThreadCount() const
+  {
+    return thread_count_;
+  }
+
 private:
   /** Typedef for set of integer indices */
   typedef std::set<Eigen::Vector3i, CompareEigenVector3i, Eigen::aligned_allocator<Eigen::Vector3i>> VoxelSet;
@@ -463,6 +563,13 @@ private:
    */
   void initialize();
 
+  /**
+   * \brief Computes max_distance_sq_ and builds the neighborhoods,
+   * bucket queues and sqrt lookup table based on max_distance_, without
+   * touching the voxel grid.
+   */
+  void initializeTables();
+
   /**
    * \brief Adds a valid set of integer points to the voxel grid
    *
@@ -493,6 +600,15 @@ private:
    */
   void propagateNegative();
 
+  /**
+   * \brief Recomputes the positive or negative distances of all cells
+   * from the current obstacle cells with the exact Euclidean distance
+   * transform, using \ref thread_count_ threads.
+   *
+   * @param [in] negative Whether to compute the negative distances
+   */
+  void computeDistanceTransform(bool negative);
+
   /**
    * \brief Determines distance based on actual voxel data
    *
@@ -547,6 +663,8 @@ private:
 
   bool propagate_negative_; /**< \brief Whether or not to propagate negative distances */
 
+  std::size_t thread_count_ = 1; /**< \brief Number of threads used to compute distances */
+
   VoxelGrid<PropDistanceFieldVoxel>::Ptr voxel_grid_; /**< \brief Actual container for distance data */
 
   /// \brief Structure used to hold propagation frontier
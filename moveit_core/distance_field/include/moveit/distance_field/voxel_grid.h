@@ -39,7 +39,10 @@
 #include <algorithm>
 #include <cmath>
 #include <Eigen/Core>
+#include <cstddef>
+#include <memory>
 #include <moveit/macros/declare_ptr.h>
+#include <vector>
 
 namespace distance_field
 {
@@ -51,13 +54,178 @@ enum Dimension
   DIM_Z = 2
 };
 
+/**
+ * \brief Storage for the cells of a VoxelGrid as one dense array in
+ * which Z varies fastest, then Y, then X.
+ *
+ * The array is either allocated by the storage itself or supplied
+ * externally, e.g. as a memory-mapped file.
+ */
+template <typename T>
+class DenseVoxelStorage
+{
+public:
+  /**
+   * \brief Reallocate the storage for the given number of cells in each dimension, discarding all data
+   */
+  void resize(const int num_cells[3])
+  {
+    resize(num_cells, nullptr, nullptr);
+  }
+
+  /**
+   * \brief Use \e data for the given number of cells in each dimension, or allocate the cells if \e data is null
+   *
+   * @param [in] num_cells The number of cells in each dimension
+   * @param [in] data The data of all cells, or nullptr
+   * @param [in] storage The owner of \e data, kept alive as long as \e data is used
+   */
+  void resize(const int num_cells[3], T* data, const std::shared_ptr<void>& storage)
+  {
+    owned_data_.reset();
+    external_storage_ = storage;
+    stride1_ = num_cells[DIM_Y] * num_cells[DIM_Z];
+    stride2_ = num_cells[DIM_Z];
+    num_cells_total_ = num_cells[DIM_X] * stride1_;
+    data_ = data;
+    if (!data_ && num_cells_total_ > 0)
+    {
+      owned_data_.reset(new T[num_cells_total_]);
+      data_ = owned_data_.get();
+    }
+  }
+
+  T& get(int x, int y, int z)
+  {
+    return data_[x * stride1_ + y * stride2_ + z];
+  }
+
+  const T& get(int x, int y, int z) const
+  {
+    return data_[x * stride1_ + y * stride2_ + z];
+  }
+
+  /** \brief Set every cell to \e value */
+  void fill(const T& value)
+  {
+    std::fill(data_, data_ + num_cells_total_, value);
+  }
+
+private:
+  T* data_ = nullptr;                      /**< \brief The data of all cells */
+  std::unique_ptr<T[]> owned_data_;        /**< \brief \e data_ if allocated by the storage itself */
+  std::shared_ptr<void> external_storage_; /**< \brief Owner of \e data_ if not allocated by the storage itself */
+  int num_cells_total_ = 0;                /**< \brief The total number of cells */
+  int stride1_ = 0; /**< \brief The step to take when stepping between consecutive X members in the 1D array */
+  int stride2_ = 0; /**< \brief The step to take when stepping between consecutive Y members given an X */
+};
+
+/**
+ * \brief Storage for the cells of a VoxelGrid in cubic bricks of
+ * 2^BRICK_BITS cells per side that are only allocated once one of
+ * their cells is written.
+ *
+ * Cells of bricks that were never written hold the value of the last
+ * call to fill(), which also frees all bricks.  This keeps the memory
+ * of large, mostly free volumes proportional to the occupied part of
+ * the volume.  Inside a brick the cells are stored in Morton (Z-curve)
+ * order, so the 26-neighborhood of a cell is mostly found in the same
+ * few cache lines.
+ *
+ * References to cells stay valid until the next call to fill() or
+ * resize().  Writing cells from several threads is not safe, even for
+ * disjoint cells, as it may allocate bricks.
+ *
+ * This is meant for VoxelGrid users whose cells are mostly left at the
+ * fill value; PropagationDistanceField keeps using DenseVoxelStorage.
+ */
+template <typename T, int BRICK_BITS = 3>
+class BlockSparseVoxelStorage
+{
+public:
+  static constexpr int BRICK_SIZE = 1 << BRICK_BITS;
+  static constexpr int BRICK_CELLS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+  /**
+   * \brief Reallocate the brick table for the given number of cells in each dimension, discarding all data
+   */
+  void resize(const int num_cells[3])
+  {
+    for (int i = DIM_X; i <= DIM_Z; ++i)
+      num_bricks_[i] = (num_cells[i] + BRICK_SIZE - 1) >> BRICK_BITS;
+    bricks_.clear();
+    bricks_.resize(static_cast<std::size_t>(num_bricks_[DIM_X]) * num_bricks_[DIM_Y] * num_bricks_[DIM_Z]);
+  }
+
+  /** \brief Get a cell for writing, allocating its brick if needed */
+  T& get(int x, int y, int z)
+  {
+    std::unique_ptr<T[]>& brick = bricks_[brickIndex(x, y, z)];
+    if (!brick)
+    {
+      brick.reset(new T[BRICK_CELLS]);
+      std::fill(brick.get(), brick.get() + BRICK_CELLS, fill_value_);
+    }
+    return brick[cellIndex(x, y, z)];
+  }
+
+  const T& get(int x, int y, int z) const
+  {
+    const std::unique_ptr<T[]>& brick = bricks_[brickIndex(x, y, z)];
+    return brick ? brick[cellIndex(x, y, z)] : fill_value_;
+  }
+
+  /** \brief Set every cell to \e value, freeing all bricks */
+  void fill(const T& value)
+  {
+    for (std::unique_ptr<T[]>& brick : bricks_)
+      brick.reset();
+    fill_value_ = value;
+  }
+
+  /** \brief Get the number of bricks that are currently allocated */
+  std::size_t getNumAllocatedBricks() const
+  {
+    return std::count_if(bricks_.begin(), bricks_.end(), [](const std::unique_ptr<T[]>& brick) { return !!brick; });
+  }
+
+private:
+  std::size_t brickIndex(int x, int y, int z) const
+  {
+    return (static_cast<std::size_t>(x >> BRICK_BITS) * num_bricks_[DIM_Y] + (y >> BRICK_BITS)) * num_bricks_[DIM_Z] +
+           (z >> BRICK_BITS);
+  }
+
+  /** \brief Interleave the bits of the coordinates inside the brick, Z being the least significant */
+  static int cellIndex(int x, int y, int z)
+  {
+    constexpr int mask = BRICK_SIZE - 1;
+    return (spreadBits(x & mask) << 2) | (spreadBits(y & mask) << 1) | spreadBits(z & mask);
+  }
+
+  /** \brief Move bit i of \e v to bit 3 * i */
+  static int spreadBits(int v)
+  {
+    int result = 0;
+    for (int i = 0; i < BRICK_BITS; ++i)
+      result |= ((v >> i) & 1) << (3 * i);
+    return result;
+  }
+
+  int num_bricks_[3] = { 0, 0, 0 };           /**< \brief The number of bricks in each dimension */
+  std::vector<std::unique_ptr<T[]>> bricks_; /**< \brief The bricks, X-major, or null if not allocated */
+  T fill_value_{};                           /**< \brief The value of all cells of unallocated bricks */
+};
+
 /**
  * \brief VoxelGrid holds a dense 3D, axis-aligned set of data at a
  * given resolution, where the data is supplied as a template
  * parameter.
  *
+ * How the cells are kept in memory is decided by \e Storage, which is
+ * either DenseVoxelStorage or BlockSparseVoxelStorage.
  */
-template <typename T>
+template <typename T, typename Storage = DenseVoxelStorage<T>>
 class VoxelGrid
 {
 public:
@@ -120,6 +288,21 @@ public:
   void resize(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
               double origin_z, T default_object);
 
+  /**
+   * \brief Resize the VoxelGrid to use externally owned memory for its data.
+   *
+   * Instead of allocating and owning the data, the grid uses \e data,
+   * e.g. a memory-mapped file, which needs to hold all cells in the
+   * same order as the grid's own storage (Z varies fastest, then Y,
+   * then X).  \e storage is kept alive as long as the grid uses \e data.
+   * Only available with DenseVoxelStorage.
+   *
+   * @param [in] data The data of all cells
+   * @param [in] storage The owner of \e data
+   */
+  void resize(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
+              double origin_z, T default_object, T* data, const std::shared_ptr<void>& storage);
+
   /**
    * \brief Operator that gets the value of the given location (x, y,
    * z) given the discretization of the volume.  The location
@@ -285,10 +468,12 @@ public:
    */
   bool isCellValid(Dimension dim, int cell) const;
 
+  /** \brief Get the storage of the cells */
+  const Storage& getStorage() const;
+
 protected:
-  T* data_;                /**< \brief Storage for the full set of data elements */
+  Storage storage_;        /**< \brief Storage for the full set of data elements */
   T default_object_;       /**< \brief The default object to return in case of out-of-bounds query */
-  T*** data_ptrs_;         /**< \brief 3D array of pointers to the data elements */
   double size_[3];         /**< \brief The size of each dimension in meters (in Dimension order) */
   double resolution_;      /**< \brief The resolution of each dimension in meters (in Dimension order) */
   double oo_resolution_;   /**< \brief 1.0/resolution_ */
@@ -296,19 +481,13 @@ protected:
   double origin_minus_[3]; /**< \brief origin - 0.5/resolution */
   int num_cells_[3];       /**< \brief The number of cells in each dimension (in Dimension order) */
   int num_cells_total_;    /**< \brief The total number of voxels in the grid */
-  int stride1_;            /**< \brief The step to take when stepping between consecutive X members in the 1D array */
-  int stride2_; /**< \brief The step to take when stepping between consecutive Y members given an X in the 1D array */
 
   /**
-   * \brief Gets the 1D index into the array, with no validity check.
-   *
-   * @param [in] x The integer X location
-   * @param [in] y The integer Y location
-   * @param [in] z The integer Z location
-   *
-   * @return The computed 1D index
+   * \brief Sets size, resolution, origin and default object and
+   * computes the number of cells, without touching the storage.
    */
-  int ref(int x, int y, int z) const;
+  void setDimensions(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                     double origin_y, double origin_z, T default_object);
 
   /**
    * \brief Gets the cell number from the location
@@ -338,16 +517,15 @@ protected:
 
 //////////////////////////// template function definitions follow //////////////////
 
-template <typename T>
-VoxelGrid<T>::VoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x,
-                        double origin_y, double origin_z, T default_object)
-  : data_(nullptr)
+template <typename T, typename Storage>
+VoxelGrid<T, Storage>::VoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                 double origin_y, double origin_z, T default_object)
 {
   resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
 }
 
-template <typename T>
-VoxelGrid<T>::VoxelGrid() : data_(nullptr)
+template <typename T, typename Storage>
+VoxelGrid<T, Storage>::VoxelGrid()
 {
   for (int i = DIM_X; i <= DIM_Z; ++i)
   {
@@ -359,17 +537,29 @@ VoxelGrid<T>::VoxelGrid() : data_(nullptr)
   resolution_ = 1.0;
   oo_resolution_ = 1.0 / resolution_;
   num_cells_total_ = 0;
-  stride1_ = 0;
-  stride2_ = 0;
 }
 
-template <typename T>
-void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double resolution, double origin_x,
-                          double origin_y, double origin_z, T default_object)
+template <typename T, typename Storage>
+void VoxelGrid<T, Storage>::resize(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                   double origin_y, double origin_z, T default_object)
 {
-  delete[] data_;
-  data_ = nullptr;
+  setDimensions(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
+  storage_.resize(num_cells_);
+}
 
+template <typename T, typename Storage>
+void VoxelGrid<T, Storage>::resize(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                   double origin_y, double origin_z, T default_object, T* data,
+                                   const std::shared_ptr<void>& storage)
+{
+  setDimensions(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
+  storage_.resize(num_cells_, data, storage);
+}
+
+template <typename T, typename Storage>
+void VoxelGrid<T, Storage>::setDimensions(double size_x, double size_y, double size_z, double resolution,
+                                          double origin_x, double origin_y, double origin_z, T default_object)
+{
   size_[DIM_X] = size_x;
   size_[DIM_Y] = size_y;
   size_[DIM_Z] = size_z;
@@ -389,77 +579,67 @@ void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double re
   }
 
   default_object_ = default_object;
-
-  stride1_ = num_cells_[DIM_Y] * num_cells_[DIM_Z];
-  stride2_ = num_cells_[DIM_Z];
-
-  // initialize the data:
-  if (num_cells_total_ > 0)
-    data_ = new T[num_cells_total_];
 }
 
-template <typename T>
-VoxelGrid<T>::~VoxelGrid()
-{
-  delete[] data_;
-}
+template <typename T, typename Storage>
+VoxelGrid<T, Storage>::~VoxelGrid() = default;
 
-template <typename T>
-inline bool VoxelGrid<T>::isCellValid(int x, int y, int z) const
+template <typename T, typename Storage>
+inline bool VoxelGrid<T, Storage>::isCellValid(int x, int y, int z) const
 {
   return (x >= 0 && x < num_cells_[DIM_X] && y >= 0 && y < num_cells_[DIM_Y] && z >= 0 && z < num_cells_[DIM_Z]);
 }
 
-template <typename T>
-inline bool VoxelGrid<T>::isCellValid(const Eigen::Vector3i& pos) const
+template <typename T, typename Storage>
+inline bool VoxelGrid<T, Storage>::isCellValid(const Eigen::Vector3i& pos) const
 {
   return isCellValid(pos.x(), pos.y(), pos.z());
 }
 
-template <typename T>
-inline bool VoxelGrid<T>::isCellValid(Dimension dim, int cell) const
+template <typename T, typename Storage>
+inline bool VoxelGrid<T, Storage>::isCellValid(Dimension dim, int cell) const
 {
   return cell >= 0 && cell < num_cells_[dim];
 }
 
-template <typename T>
-inline int VoxelGrid<T>::ref(int x, int y, int z) const
+template <typename T, typename Storage>
+inline const Storage& VoxelGrid<T, Storage>::getStorage() const
 {
-  return x * stride1_ + y * stride2_ + z;
+  return storage_;
 }
 
-template <typename T>
-inline double VoxelGrid<T>::getSize(Dimension dim) const
+template <typename T, typename Storage>
+inline double VoxelGrid<T, Storage>::getSize(Dimension dim) const
 {
   return size_[dim];
 }
 
-template <typename T>
-inline double VoxelGrid<T>::getResolution() const
+template <typename T, typename Storage>
+inline double VoxelGrid<T, Storage>::getResolution() const
 {
   return resolution_;
 }
 
-template <typename T>
-inline double VoxelGrid<T>::getResolution(Dimension /*dim*/) const
+template <typename T, typename Storage>
+inline double VoxelGrid<T, Storage>::getResolution(Dimension /*dim*/) const
 {
   return resolution_;
 }
 
-template <typename T>
-inline double VoxelGrid<T>::getOrigin(Dimension dim) const
+template <typename T, typename Storage>
+inline double VoxelGrid<T, Storage>::getOrigin(Dimension dim) const
 {
   return origin_[dim];
 }
 
-template <typename T>
-inline int VoxelGrid<T>::getNumCells(Dimension dim) const
+template <typename T, typename Storage>
+inline int VoxelGrid<T, Storage>::getNumCells(Dimension dim) const
 {
   return num_cells_[dim];
 }
 
-template <typename T>
-inline const T& VoxelGrid<T>::operator()(double x, double y, double z) const
+template <typename T, typename Storage>
+inline const T& VoxelGrid<T, Storage>::operator()(double x, double y, double z) const
 {
   int cell_x = getCellFromLocation(DIM_X, x);
   int cell_y = getCellFromLocation(DIM_Y, y);
@@ -469,50 +649,50 @@ inline const T& VoxelGrid<T>::operator()(double x, double y, double z) const
   return getCell(cell_x, cell_y, cell_z);
 }
 
-template <typename T>
-inline const T& VoxelGrid<T>::operator()(const Eigen::Vector3d& pos) const
+template <typename T, typename Storage>
+inline const T& VoxelGrid<T, Storage>::operator()(const Eigen::Vector3d& pos) const
 {
   return operator()(pos.x(), pos.y(), pos.z());
 }
 
-template <typename T>
-inline T& VoxelGrid<T>::getCell(int x, int y, int z)
+template <typename T, typename Storage>
+inline T& VoxelGrid<T, Storage>::getCell(int x, int y, int z)
 {
-  return data_[ref(x, y, z)];
+  return storage_.get(x, y, z);
 }
 
-template <typename T>
-inline const T& VoxelGrid<T>::getCell(int x, int y, int z) const
+template <typename T, typename Storage>
+inline const T& VoxelGrid<T, Storage>::getCell(int x, int y, int z) const
 {
-  return data_[ref(x, y, z)];
+  return storage_.get(x, y, z);
 }
 
-template <typename T>
-inline T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos)
+template <typename T, typename Storage>
+inline T& VoxelGrid<T, Storage>::getCell(const Eigen::Vector3i& pos)
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return storage_.get(pos.x(), pos.y(), pos.z());
 }
 
-template <typename T>
-inline const T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos) const
+template <typename T, typename Storage>
+inline const T& VoxelGrid<T, Storage>::getCell(const Eigen::Vector3i& pos) const
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return storage_.get(pos.x(), pos.y(), pos.z());
 }
 
-template <typename T>
-inline void VoxelGrid<T>::setCell(int x, int y, int z, const T& obj)
+template <typename T, typename Storage>
+inline void VoxelGrid<T, Storage>::setCell(int x, int y, int z, const T& obj)
 {
-  data_[ref(x, y, z)] = obj;
+  storage_.get(x, y, z) = obj;
 }
 
-template <typename T>
-inline void VoxelGrid<T>::setCell(const Eigen::Vector3i& pos, const T& obj)
+template <typename T, typename Storage>
+inline void VoxelGrid<T, Storage>::setCell(const Eigen::Vector3i& pos, const T& obj)
 {
-  data_[ref(pos.x(), pos.y(), pos.z())] = obj;
+  storage_.get(pos.x(), pos.y(), pos.z()) = obj;
 }
 
-template <typename T>
-inline int VoxelGrid<T>::getCellFromLocation(Dimension dim, double loc) const
+template <typename T, typename Storage>
+inline int VoxelGrid<T, Storage>::getCellFromLocation(Dimension dim, double loc) const
 {
   // This implements
   //
@@ -531,36 +711,38 @@ inline int VoxelGrid<T>::getCellFromLocation(Dimension dim, double loc) const
   return int(floor((loc - origin_minus_[dim]) * oo_resolution_));
 }
 
-template <typename T>
-inline double VoxelGrid<T>::getLocationFromCell(Dimension dim, int cell) const
+template <typename T, typename Storage>
+inline double VoxelGrid<T, Storage>::getLocationFromCell(Dimension dim, int cell) const
 {
   return origin_[dim] + resolution_ * (double(cell));
 }
 
-template <typename T>
-inline void VoxelGrid<T>::reset(const T& initial)
+template <typename T, typename Storage>
+inline void VoxelGrid<T, Storage>::reset(const T& initial)
 {
-  std::fill(data_, data_ + num_cells_total_, initial);
+  storage_.fill(initial);
 }
 
-template <typename T>
-inline void VoxelGrid<T>::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
+template <typename T, typename Storage>
+inline void VoxelGrid<T, Storage>::gridToWorld(int x, int y, int z, double& world_x, double& world_y,
+                                               double& world_z) const
 {
   world_x = getLocationFromCell(DIM_X, x);
   world_y = getLocationFromCell(DIM_Y, y);
   world_z = getLocationFromCell(DIM_Z, z);
 }
 
-template <typename T>
-inline void VoxelGrid<T>::gridToWorld(const Eigen::Vector3i& grid, Eigen::Vector3d& world) const
+template <typename T, typename Storage>
+inline void VoxelGrid<T, Storage>::gridToWorld(const Eigen::Vector3i& grid, Eigen::Vector3d& world) const
 {
   world.x() = getLocationFromCell(DIM_X, grid.x());
   world.y() = getLocationFromCell(DIM_Y, grid.y());
   world.z() = getLocationFromCell(DIM_Z, grid.z());
 }
 
-template <typename T>
-inline bool VoxelGrid<T>::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
+template <typename T, typename Storage>
+inline bool VoxelGrid<T, Storage>::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y,
+                                               int& z) const
 {
   x = getCellFromLocation(DIM_X, world_x);
   y = getCellFromLocation(DIM_Y, world_y);
@@ -568,8 +750,8 @@ inline bool VoxelGrid<T>::worldToGrid(double world_x, double world_y, double wor
   return isCellValid(x, y, z);
 }
 
-template <typename T>
-inline bool VoxelGrid<T>::worldToGrid(const Eigen::Vector3d& world, Eigen::Vector3i& grid) const
+template <typename T, typename Storage>
+inline bool VoxelGrid<T, Storage>::worldToGrid(const Eigen::Vector3d& world, Eigen::Vector3i& grid) const
 {
   grid.x() = getCellFromLocation(DIM_X, world.x());
   grid.y() = getCellFromLocation(DIM_Y, world.y());
@@ -90,6 +90,61 @@ double DistanceField::getDistanceGradient(double x, double y, double z, double&
   return getDistance(gx, gy, gz);
 }
 
+void DistanceField::getDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                         Eigen::Ref<Eigen::VectorXd> distances,
+                                         Eigen::Ref<Eigen::MatrixX3d> gradients) const
+{
+  bool in_bounds;
+  for (Eigen::Index i = 0; i < points.rows(); ++i)
+  {
+    distances[i] = getDistanceGradient(points(i, 0), points(i, 1), points(i, 2), gradients(i, 0), gradients(i, 1),
+                                       gradients(i, 2), in_bounds);
+  }
+}
+
+void DistanceField::getInterpolatedDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                                     Eigen::Ref<Eigen::VectorXd> distances,
+                                                     Eigen::Ref<Eigen::MatrixX3d> gradients) const
+{
+  const double oo_resolution = 1.0 / resolution_;
+  const Eigen::Vector3d origin(origin_x_, origin_y_, origin_z_);
+  const Eigen::Vector3i num_cells(getXNumCells(), getYNumCells(), getZNumCells());
+  for (Eigen::Index i = 0; i < points.rows(); ++i)
+  {
+    // position in cells relative to the center of cell (0, 0, 0)
+    const Eigen::Vector3d position = (points.row(i).transpose() - origin) * oo_resolution;
+    const Eigen::Vector3d floor = position.array().floor();
+    const Eigen::Vector3i cell = floor.cast<int>();
+    if ((cell.array() < 1).any() || (cell.array() + 1 >= num_cells.array() - 1).any())
+    {
+      distances[i] = getUninitializedDistance();
+      gradients.row(i).setZero();
+      continue;
+    }
+
+    const Eigen::Vector3d f = position - floor;
+    const Eigen::Vector3d g = Eigen::Vector3d::Ones() - f;
+    const auto d = [&](int dx, int dy, int dz) { return getDistance(cell.x() + dx, cell.y() + dy, cell.z() + dz); };
+
+    // interpolate along Z, then Y, then X
+    const double d00 = d(0, 0, 0) * g.z() + d(0, 0, 1) * f.z();
+    const double d01 = d(0, 1, 0) * g.z() + d(0, 1, 1) * f.z();
+    const double d10 = d(1, 0, 0) * g.z() + d(1, 0, 1) * f.z();
+    const double d11 = d(1, 1, 0) * g.z() + d(1, 1, 1) * f.z();
+    const double d0 = d00 * g.y() + d01 * f.y();
+    const double d1 = d10 * g.y() + d11 * f.y();
+    const double dz00 = d(0, 0, 1) - d(0, 0, 0);
+    const double dz01 = d(0, 1, 1) - d(0, 1, 0);
+    const double dz10 = d(1, 0, 1) - d(1, 0, 0);
+    const double dz11 = d(1, 1, 1) - d(1, 1, 0);
+
+    distances[i] = d0 * g.x() + d1 * f.x();
+    gradients(i, 0) = (d1 - d0) * oo_resolution;
+    gradients(i, 1) = ((d01 - d00) * g.x() + (d11 - d10) * f.x()) * oo_resolution;
+    gradients(i, 2) = ((dz00 * g.y() + dz01 * f.y()) * g.x() + (dz10 * g.y() + dz11 * f.y()) * f.x()) * oo_resolution;
+  }
+}
+
 void DistanceField::getIsoSurfaceMarkers(double min_distance, double max_distance, const std::string& frame_id,
                                          const rclcpp::Time& stamp, visualization_msgs::msg::Marker& inf_marker) const
 {
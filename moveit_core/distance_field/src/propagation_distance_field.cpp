@@ -39,33 +39,129 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
 
 namespace distance_field
 {
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_distance_field.propagation_distance_field");
 
+namespace
+{
+/** \brief Squared 1D distance transform of sampled functions (Felzenszwalb and Huttenlocher), with scratch buffers
+ *  that are reused for all lines of a pass. */
+struct DistanceTransform1D
+{
+  /** \brief Marks samples of \e f without a site, and samples of \e d that have no site in reach */
+  static constexpr int NO_SITE = std::numeric_limits<int>::max();
+
+  explicit DistanceTransform1D(std::size_t size) : f(size), d(size), site(size), v(size), z(size + 1)
+  {
+  }
+
+  /** \brief Computes d[q] = min_p f[p] + (q - p)^2 and the minimizing p for the first n samples */
+  void compute(int n)
+  {
+    int k = -1;
+    for (int q = 0; q < n; ++q)
+    {
+      if (f[q] == NO_SITE)
+        continue;
+      // intersection of the parabola of q with the lower envelope
+      double s = -std::numeric_limits<double>::infinity();
+      while (k >= 0)
+      {
+        const int p = v[k];
+        s = ((static_cast<double>(f[q]) + q * q) - (static_cast<double>(f[p]) + p * p)) / (2.0 * (q - p));
+        if (s > z[k])
+          break;
+        --k;
+      }
+      ++k;
+      v[k] = q;
+      z[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+    }
+
+    if (k < 0)
+    {
+      std::fill(d.begin(), d.begin() + n, NO_SITE);
+      return;
+    }
+
+    int j = 0;
+    for (int q = 0; q < n; ++q)
+    {
+      while (j < k && z[j + 1] < q)
+        ++j;
+      const long long dist = static_cast<long long>(q - v[j]) * (q - v[j]) + f[v[j]];
+      d[q] = dist < NO_SITE ? static_cast<int>(dist) : NO_SITE - 1;
+      site[q] = v[j];
+    }
+  }
+
+  std::vector<int> f;
+  std::vector<int> d;
+  std::vector<int> site;
+
+  // locations and boundaries of the parabolas in the lower envelope
+  std::vector<int> v;
+  std::vector<double> z;
+};
+
+/// Header of the files written by PropagationDistanceField::writeToFile, followed by the voxels at data_offset
+struct MappedFieldHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t voxel_size;
+  std::uint32_t byte_order;
+  std::uint32_t propagate_negative;
+  double resolution;
+  double size[3];
+  double origin[3];
+  double max_distance;
+  std::int32_t num_cells[3];
+  std::int32_t max_distance_sq;
+  std::uint64_t data_offset;
+};
+
+const char MAPPED_FIELD_MAGIC[8] = { 'M', 'V', 'I', 'T', 'P', 'D', 'F', '\0' };
+const std::uint32_t MAPPED_FIELD_VERSION = 1;
+const std::uint32_t MAPPED_FIELD_BYTE_ORDER = 0x01020304;
+// voxels start at a cache line boundary
+const std::uint64_t MAPPED_FIELD_DATA_OFFSET = (sizeof(MappedFieldHeader) + 63) / 64 * 64;
+}  // namespace
+
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z, double resolution,
                                                    double origin_x, double origin_y, double origin_z,
-                                                   double max_distance, bool propagate_negative)
+                                                   double max_distance, bool propagate_negative,
+                                                   std::size_t thread_count)
   : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
   , propagate_negative_(propagate_negative)
   , max_distance_(max_distance)
 {
+  setThreadCount(thread_count);
   initialize();
 }
 
 PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                                                    const octomap::point3d& bbx_max, double max_distance,
-                                                   bool propagate_negative_distances)
+                                                   bool propagate_negative_distances, std::size_t thread_count)
   : DistanceField(bbx_max.x() - bbx_min.x(), bbx_max.y() - bbx_min.y(), bbx_max.z() - bbx_min.z(),
                   octree.getResolution(), bbx_min.x(), bbx_min.y(), bbx_min.z())
   , propagate_negative_(propagate_negative_distances)
   , max_distance_(max_distance)
   , max_distance_sq_(0)  // avoid gcc warning about uninitialized value
 {
+  setThreadCount(thread_count);
   initialize();
   addOcTreeToField(&octree);
 }
@@ -79,10 +175,16 @@ PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_
 
 void PropagationDistanceField::initialize()
 {
-  max_distance_sq_ = ceil(max_distance_ / resolution_) * ceil(max_distance_ / resolution_);
+  initializeTables();
   voxel_grid_ =
       std::make_shared<VoxelGrid<PropDistanceFieldVoxel>>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
                                                           origin_z_, PropDistanceFieldVoxel(max_distance_sq_, 0));
+  reset();
+}
+
+void PropagationDistanceField::initializeTables()
+{
+  max_distance_sq_ = ceil(max_distance_ / resolution_) * ceil(max_distance_ / resolution_);
 
   initNeighborhoods();
 
@@ -93,8 +195,6 @@ void PropagationDistanceField::initialize()
   sqrt_table_.resize(max_distance_sq_ + 1);
   for (int i = 0; i <= max_distance_sq_; ++i)
     sqrt_table_[i] = sqrt(double(i)) * resolution_;
-
-  reset();
 }
 
 void PropagationDistanceField::print(const VoxelSet& set)
@@ -214,6 +314,16 @@ void PropagationDistanceField::removePointsFromField(const EigenSTL::vector_Vect
 
 void PropagationDistanceField::addNewObstacleVoxels(const EigenSTL::vector_Vector3i& voxel_points)
 {
+  if (thread_count_ > 1)
+  {
+    for (const Eigen::Vector3i& voxel_point : voxel_points)
+      voxel_grid_->getCell(voxel_point.x(), voxel_point.y(), voxel_point.z()).distance_square_ = 0;
+    computeDistanceTransform(false);
+    if (propagate_negative_)
+      computeDistanceTransform(true);
+    return;
+  }
+
   int initial_update_direction = getDirectionNumber(0, 0, 0);
   bucket_queue_[0].reserve(voxel_points.size());
   EigenSTL::vector_Vector3i negative_stack;
@@ -297,6 +407,16 @@ void PropagationDistanceField::addNewObstacleVoxels(const EigenSTL::vector_Vecto
 void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vector3i& voxel_points)
 // const VoxelSet& locations )
 {
+  if (thread_count_ > 1)
+  {
+    for (const Eigen::Vector3i& voxel_point : voxel_points)
+      voxel_grid_->getCell(voxel_point.x(), voxel_point.y(), voxel_point.z()).distance_square_ = max_distance_sq_;
+    computeDistanceTransform(false);
+    if (propagate_negative_)
+      computeDistanceTransform(true);
+    return;
+  }
+
   EigenSTL::vector_Vector3i stack;
   EigenSTL::vector_Vector3i negative_stack;
   int initial_update_direction = getDirectionNumber(0, 0, 0);
@@ -497,6 +617,108 @@ void PropagationDistanceField::propagateNegative()
   }
 }
 
+void PropagationDistanceField::computeDistanceTransform(bool negative)
+{
+  // The squared distance transform is separable: it is computed with 1D transforms along Z, then Y, then X, where
+  // the lines of each pass are independent of each other and split across the threads.
+  int PropDistanceFieldVoxel::*distance =
+      negative ? &PropDistanceFieldVoxel::negative_distance_square_ : &PropDistanceFieldVoxel::distance_square_;
+  Eigen::Vector3i PropDistanceFieldVoxel::*closest =
+      negative ? &PropDistanceFieldVoxel::closest_negative_point_ : &PropDistanceFieldVoxel::closest_point_;
+  int PropDistanceFieldVoxel::*direction =
+      negative ? &PropDistanceFieldVoxel::negative_update_direction_ : &PropDistanceFieldVoxel::update_direction_;
+
+  const int num_cells[3] = { getXNumCells(), getYNumCells(), getZNumCells() };
+  const std::size_t max_cells = *std::max_element(num_cells, num_cells + 3);
+
+  // Runs the 1D transform along dimension dim for all lines, distributing the lines along dimension outer_dim
+  const auto transform_lines = [&](int dim, int outer_dim, bool first_pass) {
+    const int inner_dim = 3 - dim - outer_dim;
+    std::vector<std::thread> threads;
+    const int thread_count = std::max(1, static_cast<int>(std::min<std::size_t>(thread_count_, num_cells[outer_dim])));
+    const auto transform_slab = [&, dim, outer_dim, inner_dim, first_pass](int begin, int end) {
+      DistanceTransform1D transform(max_cells);
+      EigenSTL::vector_Vector3i sites(max_cells);
+      Eigen::Vector3i loc;
+      for (int o = begin; o < end; ++o)
+      {
+        loc[outer_dim] = o;
+        for (int i = 0; i < num_cells[inner_dim]; ++i)
+        {
+          loc[inner_dim] = i;
+          for (int q = 0; q < num_cells[dim]; ++q)
+          {
+            loc[dim] = q;
+            const PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+            if (first_pass)
+            {
+              // obstacle cells are the sites of the positive transform, free cells the ones of the negative one
+              const bool is_site = (voxel.distance_square_ == 0) != negative;
+              transform.f[q] = is_site ? 0 : DistanceTransform1D::NO_SITE;
+              sites[q] = loc;
+            }
+            else
+            {
+              transform.f[q] = voxel.*distance;
+              sites[q] = voxel.*closest;
+            }
+          }
+          transform.compute(num_cells[dim]);
+          for (int q = 0; q < num_cells[dim]; ++q)
+          {
+            loc[dim] = q;
+            PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+            voxel.*distance = transform.d[q];
+            if (transform.d[q] != DistanceTransform1D::NO_SITE)
+              voxel.*closest = sites[transform.site[q]];
+          }
+        }
+      }
+    };
+    for (int t = 1; t < thread_count; ++t)
+    {
+      threads.emplace_back(transform_slab, num_cells[outer_dim] * t / thread_count,
+                           num_cells[outer_dim] * (t + 1) / thread_count);
+    }
+    transform_slab(0, num_cells[outer_dim] / thread_count);
+    for (std::thread& thread : threads)
+      thread.join();
+  };
+
+  transform_lines(DIM_Z, DIM_X, true);
+  transform_lines(DIM_Y, DIM_X, false);
+  transform_lines(DIM_X, DIM_Y, false);
+
+  // Limit the distances to the maximum distance, and set the update directions such that incremental updates can
+  // continue from the result
+  const int initial_update_direction = getDirectionNumber(0, 0, 0);
+  for (int x = 0; x < num_cells[DIM_X]; ++x)
+  {
+    for (int y = 0; y < num_cells[DIM_Y]; ++y)
+    {
+      for (int z = 0; z < num_cells[DIM_Z]; ++z)
+      {
+        PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(x, y, z);
+        if (voxel.*distance > max_distance_sq_)
+        {
+          voxel.*distance = max_distance_sq_;
+          (voxel.*closest).setConstant(PropDistanceFieldVoxel::UNINITIALIZED);
+        }
+        else if (voxel.*distance == 0)
+        {
+          voxel.*direction = initial_update_direction;
+        }
+        else
+        {
+          const Eigen::Vector3i diff = Eigen::Vector3i(x, y, z) - voxel.*closest;
+          voxel.*direction = getDirectionNumber((diff.x() > 0) - (diff.x() < 0), (diff.y() > 0) - (diff.y() < 0),
+                                                (diff.z() > 0) - (diff.z() < 0));
+        }
+      }
+    }
+  }
+}
+
 void PropagationDistanceField::reset()
 {
   voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
@@ -595,6 +817,110 @@ double PropagationDistanceField::getDistance(int x, int y, int z) const
   return getDistance(voxel_grid_->getCell(x, y, z));
 }
 
+void PropagationDistanceField::getDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                                    Eigen::Ref<Eigen::VectorXd> distances,
+                                                    Eigen::Ref<Eigen::MatrixX3d> gradients) const
+{
+  const Eigen::Index count = points.rows();
+  if (count == 0)
+    return;
+
+  // Same computation as VoxelGrid::getCellFromLocation(), for all points at once
+  const double resolution = voxel_grid_->getResolution();
+  const double oo_resolution = 1.0 / resolution;
+  const Eigen::RowVector3d origin_minus(voxel_grid_->getOrigin(DIM_X) - 0.5 * resolution,
+                                        voxel_grid_->getOrigin(DIM_Y) - 0.5 * resolution,
+                                        voxel_grid_->getOrigin(DIM_Z) - 0.5 * resolution);
+  const Eigen::ArrayX3i cells = ((points.rowwise() - origin_minus).array() * oo_resolution).floor().cast<int>();
+
+  // we need extra padding of 1 to get gradients
+  Eigen::Array<bool, Eigen::Dynamic, 1> in_bounds = Eigen::Array<bool, Eigen::Dynamic, 1>::Constant(count, true);
+  for (int dim = DIM_X; dim <= DIM_Z; ++dim)
+  {
+    const int upper = voxel_grid_->getNumCells(static_cast<Dimension>(dim)) - 1;
+    in_bounds = in_bounds && (cells.col(dim) >= 1) && (cells.col(dim) < upper);
+  }
+
+  const auto cell_distance = [this](int x, int y, int z) { return getDistance(voxel_grid_->getCell(x, y, z)); };
+  for (Eigen::Index i = 0; i < count; ++i)
+  {
+    if (!in_bounds[i])
+    {
+      distances[i] = getUninitializedDistance();
+      gradients.row(i).setZero();
+      continue;
+    }
+
+    const int x = cells(i, 0);
+    const int y = cells(i, 1);
+    const int z = cells(i, 2);
+    gradients(i, 0) = (cell_distance(x + 1, y, z) - cell_distance(x - 1, y, z)) * inv_twice_resolution_;
+    gradients(i, 1) = (cell_distance(x, y + 1, z) - cell_distance(x, y - 1, z)) * inv_twice_resolution_;
+    gradients(i, 2) = (cell_distance(x, y, z + 1) - cell_distance(x, y, z - 1)) * inv_twice_resolution_;
+    distances[i] = cell_distance(x, y, z);
+  }
+}
+
+void PropagationDistanceField::getInterpolatedDistanceGradients(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                                                                Eigen::Ref<Eigen::VectorXd> distances,
+                                                                Eigen::Ref<Eigen::MatrixX3d> gradients) const
+{
+  const Eigen::Index count = points.rows();
+  if (count == 0)
+    return;
+
+  // position in cells relative to the center of cell (0, 0, 0)
+  const double oo_resolution = 1.0 / voxel_grid_->getResolution();
+  const Eigen::RowVector3d origin(voxel_grid_->getOrigin(DIM_X), voxel_grid_->getOrigin(DIM_Y),
+                                  voxel_grid_->getOrigin(DIM_Z));
+  const Eigen::ArrayX3d positions = (points.rowwise() - origin).array() * oo_resolution;
+  const Eigen::ArrayX3d floors = positions.floor();
+  const Eigen::ArrayX3i cells = floors.cast<int>();
+
+  // all 8 cells around the point need to be inside the boundary cells
+  Eigen::Array<bool, Eigen::Dynamic, 1> in_bounds = Eigen::Array<bool, Eigen::Dynamic, 1>::Constant(count, true);
+  for (int dim = DIM_X; dim <= DIM_Z; ++dim)
+  {
+    const int upper = voxel_grid_->getNumCells(static_cast<Dimension>(dim)) - 2;
+    in_bounds = in_bounds && (cells.col(dim) >= 1) && (cells.col(dim) < upper);
+  }
+
+  // distances of the 8 cells around each point, column 4 * dx + 2 * dy + dz holds cell (x + dx, y + dy, z + dz)
+  Eigen::Array<double, Eigen::Dynamic, 8> corners(count, 8);
+  for (Eigen::Index i = 0; i < count; ++i)
+  {
+    if (!in_bounds[i])
+    {
+      corners.row(i).setZero();
+      continue;
+    }
+    for (int c = 0; c < 8; ++c)
+      corners(i, c) = getDistance(voxel_grid_->getCell(cells(i, 0) + (c >> 2), cells(i, 1) + ((c >> 1) & 1),
+                                                       cells(i, 2) + (c & 1)));
+  }
+
+  // interpolate along Z, then Y, then X
+  const Eigen::ArrayXd fx = positions.col(0) - floors.col(0);
+  const Eigen::ArrayXd fy = positions.col(1) - floors.col(1);
+  const Eigen::ArrayXd fz = positions.col(2) - floors.col(2);
+  const Eigen::ArrayXd gx = 1.0 - fx;
+  const Eigen::ArrayXd gy = 1.0 - fy;
+  const Eigen::ArrayXd gz = 1.0 - fz;
+  const Eigen::ArrayXd d00 = corners.col(0) * gz + corners.col(1) * fz;
+  const Eigen::ArrayXd d01 = corners.col(2) * gz + corners.col(3) * fz;
+  const Eigen::ArrayXd d10 = corners.col(4) * gz + corners.col(5) * fz;
+  const Eigen::ArrayXd d11 = corners.col(6) * gz + corners.col(7) * fz;
+  const Eigen::ArrayXd d0 = d00 * gy + d01 * fy;
+  const Eigen::ArrayXd d1 = d10 * gy + d11 * fy;
+  const Eigen::ArrayXd dz0 = (corners.col(1) - corners.col(0)) * gy + (corners.col(3) - corners.col(2)) * fy;
+  const Eigen::ArrayXd dz1 = (corners.col(5) - corners.col(4)) * gy + (corners.col(7) - corners.col(6)) * fy;
+
+  distances = in_bounds.select(d0 * gx + d1 * fx, getUninitializedDistance()).matrix();
+  gradients.col(0) = in_bounds.select((d1 - d0) * oo_resolution, 0.0).matrix();
+  gradients.col(1) = in_bounds.select(((d01 - d00) * gx + (d11 - d10) * fx) * oo_resolution, 0.0).matrix();
+  gradients.col(2) = in_bounds.select((dz0 * gx + dz1 * fx) * oo_resolution, 0.0).matrix();
+}
+
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
 {
   return voxel_grid_->isCellValid(x, y, z);
@@ -752,4 +1078,130 @@ bool PropagationDistanceField::readFromStream(std::istream& is)
   addNewObstacleVoxels(obs_points);
   return true;
 }
+
+bool PropagationDistanceField::writeToFile(const std::string& filename) const
+{
+  MappedFieldHeader header{};
+  std::memcpy(header.magic, MAPPED_FIELD_MAGIC, sizeof(header.magic));
+  header.version = MAPPED_FIELD_VERSION;
+  header.voxel_size = sizeof(PropDistanceFieldVoxel);
+  header.byte_order = MAPPED_FIELD_BYTE_ORDER;
+  header.propagate_negative = propagate_negative_ ? 1 : 0;
+  header.resolution = resolution_;
+  header.size[0] = size_x_;
+  header.size[1] = size_y_;
+  header.size[2] = size_z_;
+  header.origin[0] = origin_x_;
+  header.origin[1] = origin_y_;
+  header.origin[2] = origin_z_;
+  header.max_distance = max_distance_;
+  header.num_cells[0] = getXNumCells();
+  header.num_cells[1] = getYNumCells();
+  header.num_cells[2] = getZNumCells();
+  header.max_distance_sq = max_distance_sq_;
+  header.data_offset = MAPPED_FIELD_DATA_OFFSET;
+
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os.good())
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open '%s' for writing the distance field", filename.c_str());
+    return false;
+  }
+
+  const char padding[MAPPED_FIELD_DATA_OFFSET - sizeof(MappedFieldHeader)] = {};
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.write(padding, sizeof(padding));
+  // each run of z values is contiguous in the voxel grid
+  for (int x = 0; x < getXNumCells(); ++x)
+  {
+    for (int y = 0; y < getYNumCells() && getZNumCells() > 0; ++y)
+      os.write(reinterpret_cast<const char*>(&getCell(x, y, 0)), getZNumCells() * sizeof(PropDistanceFieldVoxel));
+  }
+  os.close();
+
+  if (os.fail())
+  {
+    RCLCPP_ERROR(LOGGER, "Failed writing the distance field to '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool PropagationDistanceField::readFromFile(const std::string& filename)
+{
+  auto file = std::make_shared<boost::iostreams::mapped_file>();
+  try
+  {
+    boost::iostreams::mapped_file_params params(filename);
+    params.flags = boost::iostreams::mapped_file::priv;
+    file->open(params);
+  }
+  catch (const std::exception& e)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to map distance field file '%s': %s", filename.c_str(), e.what());
+    return false;
+  }
+
+  MappedFieldHeader header;
+  if (file->size() < sizeof(header))
+  {
+    RCLCPP_ERROR(LOGGER, "Distance field file '%s' is too short", filename.c_str());
+    return false;
+  }
+  std::memcpy(&header, file->const_data(), sizeof(header));
+
+  if (std::memcmp(header.magic, MAPPED_FIELD_MAGIC, sizeof(header.magic)) != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "'%s' is not a distance field file", filename.c_str());
+    return false;
+  }
+  if (header.version != MAPPED_FIELD_VERSION || header.voxel_size != sizeof(PropDistanceFieldVoxel) ||
+      header.byte_order != MAPPED_FIELD_BYTE_ORDER)
+  {
+    RCLCPP_ERROR(LOGGER,
+                 "Distance field file '%s' has version %u with %u byte voxels, which is incompatible with version %u "
+                 "with %zu byte voxels on this machine",
+                 filename.c_str(), header.version, header.voxel_size, MAPPED_FIELD_VERSION,
+                 sizeof(PropDistanceFieldVoxel));
+    return false;
+  }
+
+  const std::uint64_t num_cells = static_cast<std::uint64_t>(std::max(header.num_cells[0], 0)) *
+                                  static_cast<std::uint64_t>(std::max(header.num_cells[1], 0)) *
+                                  static_cast<std::uint64_t>(std::max(header.num_cells[2], 0));
+  if (header.data_offset % alignof(PropDistanceFieldVoxel) != 0 || header.data_offset > file->size() ||
+      (file->size() - header.data_offset) / sizeof(PropDistanceFieldVoxel) < num_cells)
+  {
+    RCLCPP_ERROR(LOGGER, "Distance field file '%s' is truncated or corrupt", filename.c_str());
+    return false;
+  }
+
+  const double max_distance_cells = ceil(header.max_distance / header.resolution);
+  auto* data = reinterpret_cast<PropDistanceFieldVoxel*>(file->data() + header.data_offset);
+  auto voxel_grid = std::make_shared<VoxelGrid<PropDistanceFieldVoxel>>();
+  voxel_grid->resize(header.size[0], header.size[1], header.size[2], header.resolution, header.origin[0],
+                     header.origin[1], header.origin[2], PropDistanceFieldVoxel(header.max_distance_sq, 0), data,
+                     file);
+  if (voxel_grid->getNumCells(DIM_X) != header.num_cells[0] || voxel_grid->getNumCells(DIM_Y) != header.num_cells[1] ||
+      voxel_grid->getNumCells(DIM_Z) != header.num_cells[2] ||
+      header.max_distance_sq != max_distance_cells * max_distance_cells)
+  {
+    RCLCPP_ERROR(LOGGER, "Distance field file '%s' has inconsistent dimensions", filename.c_str());
+    return false;
+  }
+
+  resolution_ = header.resolution;
+  inv_twice_resolution_ = 1.0 / (2.0 * resolution_);
+  size_x_ = header.size[0];
+  size_y_ = header.size[1];
+  size_z_ = header.size[2];
+  origin_x_ = header.origin[0];
+  origin_y_ = header.origin[1];
+  origin_z_ = header.origin[2];
+  max_distance_ = header.max_distance;
+  propagate_negative_ = header.propagate_negative != 0;
+  initializeTables();
+  voxel_grid_ = voxel_grid;
+  return true;
+}
 }  // namespace distance_field
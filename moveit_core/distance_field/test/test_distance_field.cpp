@@ -985,6 +985,172 @@ TEST(TestSignedPropagationDistanceField, TestReadWrite)
   EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, df3));
 }
 
+TEST(TestSignedPropagationDistanceField, TestParallelDistanceTransform)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  PropagationDistanceField df_two(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true, 2);
+  PropagationDistanceField df_four(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true, 4);
+  EXPECT_EQ(df_four.getThreadCount(), 4u);
+
+  // a box of obstacle cells and a few separate points
+  EigenSTL::vector_Vector3d points;
+  for (double x = 0.3; x <= 0.6; x += RESOLUTION)
+    for (double y = 0.2; y <= 0.5; y += RESOLUTION)
+      for (double z = 0.4; z <= 0.7; z += RESOLUTION)
+        points.push_back(Eigen::Vector3d(x, y, z));
+  points.push_back(POINT1);
+  points.push_back(POINT2);
+  df.addPointsToField(points);
+  df_two.addPointsToField(points);
+  df_four.addPointsToField(points);
+
+  // the result does not depend on the number of threads
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df_two, df_four));
+
+  // the exact distance transform never exceeds the propagated distances
+  for (int x = 0; x < df.getXNumCells(); ++x)
+  {
+    for (int y = 0; y < df.getYNumCells(); ++y)
+    {
+      for (int z = 0; z < df.getZNumCells(); ++z)
+      {
+        const PropDistanceFieldVoxel& cell = df_four.getCell(x, y, z);
+        EXPECT_LE(cell.distance_square_, df.getCell(x, y, z).distance_square_);
+        EXPECT_LE(cell.negative_distance_square_, df.getCell(x, y, z).negative_distance_square_);
+        if (cell.distance_square_ > 0 && cell.distance_square_ < df_four.getMaximumDistanceSquared())
+        {
+          const Eigen::Vector3i& closest = cell.closest_point_;
+          EXPECT_EQ(df_four.getCell(closest.x(), closest.y(), closest.z()).distance_square_, 0);
+          EXPECT_EQ((closest - Eigen::Vector3i(x, y, z)).squaredNorm(), cell.distance_square_);
+        }
+      }
+    }
+  }
+
+  // removing points gives the same field as never adding them
+  EigenSTL::vector_Vector3d removed{ POINT1, POINT2 };
+  df_four.removePointsFromField(removed);
+  points.resize(points.size() - 2);
+  PropagationDistanceField df_box(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true, 3);
+  df_box.addPointsToField(points);
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df_box, df_four));
+}
+
+TEST(TestSignedPropagationDistanceField, TestBatchedGradients)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  EigenSTL::vector_Vector3d points;
+  points.push_back(POINT1);
+  points.push_back(POINT2);
+  points.push_back(POINT3);
+  df.addPointsToField(points);
+
+  // query points inside the field, on its boundary and outside of it
+  std::srand(0);
+  Eigen::MatrixX3d queries = Eigen::MatrixX3d::Random(500, 3) * WIDTH;
+  queries.row(0) << 0.0, 0.0, 0.0;
+  queries.row(1) << 1000.0, 1000.0, 1000.0;
+
+  Eigen::VectorXd distances(queries.rows());
+  Eigen::MatrixX3d gradients(queries.rows(), 3);
+  df.getDistanceGradients(queries, distances, gradients);
+
+  for (Eigen::Index i = 0; i < queries.rows(); ++i)
+  {
+    double gx, gy, gz;
+    bool in_bounds;
+    const double dist = df.getDistanceGradient(queries(i, 0), queries(i, 1), queries(i, 2), gx, gy, gz, in_bounds);
+    EXPECT_EQ(dist, distances[i]);
+    EXPECT_EQ(gx, gradients(i, 0));
+    EXPECT_EQ(gy, gradients(i, 1));
+    EXPECT_EQ(gz, gradients(i, 2));
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestInterpolatedGradients)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  EigenSTL::vector_Vector3d points;
+  points.push_back(POINT1);
+  points.push_back(POINT2);
+  points.push_back(POINT3);
+  df.addPointsToField(points);
+
+  std::srand(0);
+  Eigen::MatrixX3d queries = Eigen::MatrixX3d::Random(500, 3) * WIDTH;
+  queries.row(0) << 1000.0, 1000.0, 1000.0;
+  // a cell center, where the interpolated distance is the distance of the cell
+  df.gridToWorld(2, 3, 4, queries(1, 0), queries(1, 1), queries(1, 2));
+
+  // the vectorized lookup matches the generic per point implementation
+  Eigen::VectorXd distances(queries.rows());
+  Eigen::MatrixX3d gradients(queries.rows(), 3);
+  df.getInterpolatedDistanceGradients(queries, distances, gradients);
+  Eigen::VectorXd expected_distances(queries.rows());
+  Eigen::MatrixX3d expected_gradients(queries.rows(), 3);
+  df.DistanceField::getInterpolatedDistanceGradients(queries, expected_distances, expected_gradients);
+  for (Eigen::Index i = 0; i < queries.rows(); ++i)
+  {
+    EXPECT_NEAR(expected_distances[i], distances[i], 1e-9);
+    for (int dim = 0; dim < 3; ++dim)
+      EXPECT_NEAR(expected_gradients(i, dim), gradients(i, dim), 1e-9);
+  }
+
+  EXPECT_EQ(distances[0], df.getUninitializedDistance());
+  EXPECT_EQ(gradients.row(0).norm(), 0.0);
+  EXPECT_NEAR(distances[1], df.getDistance(2, 3, 4), 1e-9);
+
+  // the gradient is the derivative of the interpolated distance
+  const double step = 1e-6;
+  for (Eigen::Index i = 2; i < 20; ++i)
+  {
+    if (gradients.row(i).norm() == 0.0)
+      continue;
+    Eigen::MatrixX3d shifted = queries.row(i).replicate(3, 1);
+    shifted += Eigen::Matrix3d::Identity() * step;
+    Eigen::VectorXd shifted_distances(3);
+    Eigen::MatrixX3d shifted_gradients(3, 3);
+    df.getInterpolatedDistanceGradients(shifted, shifted_distances, shifted_gradients);
+    for (int dim = 0; dim < 3; ++dim)
+      EXPECT_NEAR((shifted_distances[dim] - distances[i]) / step, gradients(i, dim), 1e-3);
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestMappedFile)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  EigenSTL::vector_Vector3d points;
+  points.push_back(POINT1);
+  points.push_back(POINT2);
+  points.push_back(POINT3);
+  df.addPointsToField(points);
+  ASSERT_TRUE(df.writeToFile("test_mapped.df"));
+
+  // parameters are taken from the file
+  PropagationDistanceField mapped_df(1.0, 1.0, 1.0, 0.5, 0.0, 0.0, 0.0, 0.5, false);
+  ASSERT_TRUE(mapped_df.readFromFile("test_mapped.df"));
+  EXPECT_EQ(df.getXNumCells(), mapped_df.getXNumCells());
+  EXPECT_EQ(df.getYNumCells(), mapped_df.getYNumCells());
+  EXPECT_EQ(df.getZNumCells(), mapped_df.getZNumCells());
+  EXPECT_EQ(df.getUninitializedDistance(), mapped_df.getUninitializedDistance());
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, mapped_df));
+
+  // modifying the mapped field must neither fail nor change the file
+  mapped_df.addPointsToField(EigenSTL::vector_Vector3d(1, POINT1 + Eigen::Vector3d(0.0, RESOLUTION, 0.0)));
+  PropagationDistanceField reread_df(1.0, 1.0, 1.0, 0.5, 0.0, 0.0, 0.0, 0.5, false);
+  ASSERT_TRUE(reread_df.readFromFile("test_mapped.df"));
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, reread_df));
+  EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, mapped_df));
+
+  // files in other formats are rejected without changing the field
+  std::ofstream f("test_not_mapped.df", std::ios::out);
+  df.writeToStream(f);
+  f.close();
+  EXPECT_FALSE(reread_df.readFromFile("test_not_mapped.df"));
+  EXPECT_FALSE(reread_df.readFromFile("does_not_exist.df"));
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, reread_df));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -107,6 +107,53 @@ TEST(TestVoxelGrid, TestReadWrite)
   }
 }
 
+TEST(TestVoxelGrid, TestBlockSparseReadWrite)
+{
+  using SparseGrid = VoxelGrid<int, BlockSparseVoxelStorage<int>>;
+  const SparseGrid::Ptr vg = std::make_shared<SparseGrid>(0.2, 0.2, 0.1, 0.01, 0, 0, 0, -100);
+  const SparseGrid& const_vg = *vg;
+
+  // bricks are 8x8x8 cells, so the 20x20x10 cells need 3x3x2 bricks
+  EXPECT_EQ(vg->getNumCells(DIM_X), 20);
+  EXPECT_EQ(vg->getNumCells(DIM_Z), 10);
+  vg->reset(7);
+  EXPECT_EQ(vg->getStorage().getNumAllocatedBricks(), 0u);
+
+  // reading through a const grid does not allocate
+  EXPECT_EQ(const_vg.getCell(19, 19, 9), 7);
+  EXPECT_EQ(vg->getStorage().getNumAllocatedBricks(), 0u);
+
+  // writing allocates only the touched brick, the other cells keep the reset value
+  vg->setCell(9, 1, 2, 42);
+  vg->getCell(Eigen::Vector3i(15, 0, 7)) = 43;
+  EXPECT_EQ(vg->getStorage().getNumAllocatedBricks(), 1u);
+  EXPECT_EQ(const_vg.getCell(9, 1, 2), 42);
+  EXPECT_EQ(const_vg.getCell(15, 0, 7), 43);
+  EXPECT_EQ(const_vg.getCell(8, 1, 2), 7);
+  EXPECT_EQ(const_vg.getCell(0, 0, 0), 7);
+
+  // every cell maps to its own slot
+  int i = 0;
+  for (int x = 0; x < vg->getNumCells(DIM_X); ++x)
+    for (int y = 0; y < vg->getNumCells(DIM_Y); ++y)
+      for (int z = 0; z < vg->getNumCells(DIM_Z); ++z)
+        vg->setCell(x, y, z, i++);
+  EXPECT_EQ(vg->getStorage().getNumAllocatedBricks(), 18u);
+  i = 0;
+  for (int x = 0; x < vg->getNumCells(DIM_X); ++x)
+    for (int y = 0; y < vg->getNumCells(DIM_Y); ++y)
+      for (int z = 0; z < vg->getNumCells(DIM_Z); ++z)
+        EXPECT_EQ(const_vg.getCell(x, y, z), i++);
+
+  // out of bounds queries by location return the default object
+  EXPECT_EQ(const_vg(1.0, 0.0, 0.0), -100);
+
+  // resetting frees all bricks
+  vg->reset(3);
+  EXPECT_EQ(vg->getStorage().getNumAllocatedBricks(), 0u);
+  EXPECT_EQ(const_vg.getCell(9, 1, 2), 3);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -41,6 +41,7 @@
 #include <kdl/chainidsolver_recursive_newton_euler.hpp>
 
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 #include <geometry_msgs/msg/vector3.hpp>
 #include <geometry_msgs/msg/wrench.hpp>
 #include <memory>
@@ -50,6 +51,25 @@ namespace dynamics_solver
 {
 MOVEIT_CLASS_FORWARD(DynamicsSolver);  // Defines DynamicsSolverPtr, ConstPtr, WeakPtr... etc
 
+/** \brief The largest torque along a trajectory, relative to the torque limits of the group */
+struct TorqueLimitCheckResult
+{
+  /** \brief The largest ratio of the required torque to the torque limit, over all waypoints and limited joints */
+  double max_torque_ratio = 0.0;
+
+  /** \brief The waypoint at which max_torque_ratio is reached */
+  std::size_t waypoint = 0;
+
+  /** \brief The joint (index within the group) at which max_torque_ratio is reached */
+  unsigned int joint = 0;
+
+  /** \brief True if the required torques of all joints at all waypoints are within the torque limits */
+  bool withinLimits() const
+  {
+    return max_torque_ratio <= 1.0;
+  }
+};
+
 /**
  * This solver currently computes the required torques given a
  * joint configuration, velocities, accelerations and external wrenches
@@ -113,6 +133,34 @@ public:
   bool getPayloadTorques(const std::vector<double>& joint_angles, double payload,
                          std::vector<double>& joint_torques) const;
 
+  /**
+   * @brief Get the torques required at all waypoints of a trajectory (inverse dynamics of the positions,
+   * velocities and accelerations of the waypoints). Velocities and accelerations are taken as 0 if the waypoints
+   * do not have them.
+   * The waypoints are distributed over several threads, each with its own solver and buffers that are reused for all
+   * of its waypoints. The result does not depend on the number of threads.
+   * @param trajectory The trajectory, for the robot model of this solver. Only the joints of the group of this solver
+   * are used, so the trajectory may be for a different group that contains them.
+   * @param payload The payload (in kg) attached to the origin of the last link of this group, see getPayloadTorques()
+   * @param torques The torques of every waypoint, in the order of the joints of this group
+   * @param thread_count The number of threads to use, 0 uses one thread per hardware core
+   * @return False if the solver was not constructed properly or the inverse dynamics failed at a waypoint
+   */
+  bool getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                            std::vector<std::vector<double>>& torques, unsigned int thread_count = 0) const;
+
+  /**
+   * @brief Compare the torques required along a trajectory with the torque limits (getMaxTorques()) of this group.
+   * Joints without a torque limit are not checked.
+   * @param trajectory The trajectory to check, see getTrajectoryTorques()
+   * @param payload The payload (in kg) attached to the origin of the last link of this group
+   * @param result The largest torque relative to its limit and where it occurs
+   * @param thread_count The number of threads to use, 0 uses one thread per hardware core
+   * @return False if the torques could not be computed
+   */
+  bool checkTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                         TorqueLimitCheckResult& result, unsigned int thread_count = 0) const;
+
   /**
    * @brief Get maximum torques for this group
    * @return Vector of max torques
@@ -134,6 +182,12 @@ public:
   }
 
 private:
+  struct Workspace;
+
+  // Compute the torques of one waypoint into torques (size num_joints_), using the solver and buffers of workspace
+  bool computeWaypointTorques(Workspace& workspace, const moveit::core::RobotState& waypoint, double payload,
+                              double* torques) const;
+
   std::shared_ptr<KDL::ChainIdSolver_RNE> chain_id_solver_;  // KDL chain inverse dynamics
   KDL::Chain kdl_chain_;                                     // KDL chain
 
@@ -146,6 +200,7 @@ private:
   unsigned int num_joints_, num_segments_;  // number of joints in group, number of segments in group
   std::vector<double> max_torques_;         // vector of max torques
 
-  double gravity_;  // Norm of the gravity vector passed in initialize()
+  KDL::Vector gravity_vector_;  // Gravity vector passed in initialize()
+  double gravity_;              // Norm of the gravity vector passed in initialize()
 };
 }  // namespace dynamics_solver
@@ -42,6 +42,10 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace dynamics_solver
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_dynamics_solver.dynamics_solver");
@@ -136,12 +140,12 @@ DynamicsSolver::DynamicsSolver(const moveit::core::RobotModelConstPtr& robot_mod
     }
   }
 
-  KDL::Vector gravity(gravity_vector.x, gravity_vector.y,
-                      gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
-  gravity_ = gravity.Norm();
+  gravity_vector_ = KDL::Vector(gravity_vector.x, gravity_vector.y,
+                                gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
+  gravity_ = gravity_vector_.Norm();
   RCLCPP_DEBUG(LOGGER, "Gravity norm set to %f", gravity_);
 
-  chain_id_solver_ = std::make_shared<KDL::ChainIdSolver_RNE>(kdl_chain_, gravity);
+  chain_id_solver_ = std::make_shared<KDL::ChainIdSolver_RNE>(kdl_chain_, gravity_vector_);
 }
 
 bool DynamicsSolver::getTorques(const std::vector<double>& joint_angles, const std::vector<double>& joint_velocities,
@@ -316,6 +320,137 @@ bool DynamicsSolver::getPayloadTorques(const std::vector<double>& joint_angles,
   return getTorques(joint_angles, joint_velocities, joint_accelerations, wrenches, joint_torques);
 }
 
+// The inverse dynamics solver holds intermediate results, so every thread needs its own
+struct DynamicsSolver::Workspace
+{
+  Workspace(const KDL::Chain& chain, const KDL::Vector& gravity, const moveit::core::RobotModelConstPtr& robot_model)
+    : solver(chain, gravity)
+    , angles(chain.getNrOfJoints())
+    , velocities(chain.getNrOfJoints())
+    , accelerations(chain.getNrOfJoints())
+    , torques(chain.getNrOfJoints())
+    , wrenches(chain.getNrOfSegments(), KDL::Wrench::Zero())
+    , state(robot_model)
+  {
+    state.setToDefaultValues();
+  }
+
+  KDL::ChainIdSolver_RNE solver;
+  KDL::JntArray angles, velocities, accelerations, torques;
+  KDL::Wrenches wrenches;
+  moveit::core::RobotState state;  // Used to compute the payload wrench
+};
+
+bool DynamicsSolver::computeWaypointTorques(Workspace& workspace, const moveit::core::RobotState& waypoint,
+                                            double payload, double* torques) const
+{
+  waypoint.copyJointGroupPositions(joint_model_group_, workspace.angles.data.data());
+  if (waypoint.hasVelocities())
+    waypoint.copyJointGroupVelocities(joint_model_group_, workspace.velocities.data.data());
+  else
+    workspace.velocities.data.setZero();
+  if (waypoint.hasAccelerations())
+    waypoint.copyJointGroupAccelerations(joint_model_group_, workspace.accelerations.data.data());
+  else
+    workspace.accelerations.data.setZero();
+
+  if (payload != 0.0)
+  {
+    // Same wrench as in getPayloadTorques()
+    workspace.state.setJointGroupPositions(joint_model_group_, workspace.angles.data.data());
+    const Eigen::Isometry3d transform =
+        workspace.state.getFrameTransform(tip_name_).inverse() * workspace.state.getFrameTransform(base_name_);
+    const Eigen::Vector3d force = transform.linear() * Eigen::Vector3d(0.0, 0.0, payload * gravity_);
+    workspace.wrenches.back() = KDL::Wrench(KDL::Vector(force.x(), force.y(), force.z()), KDL::Vector::Zero());
+  }
+
+  if (workspace.solver.CartToJnt(workspace.angles, workspace.velocities, workspace.accelerations, workspace.wrenches,
+                                 workspace.torques) < 0)
+    return false;
+
+  std::copy(workspace.torques.data.data(), workspace.torques.data.data() + num_joints_, torques);
+  return true;
+}
+
+bool DynamicsSolver::getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                                          std::vector<std::vector<double>>& torques, unsigned int thread_count) const
+{
+  if (!joint_model_group_)
+  {
+    RCLCPP_DEBUG(LOGGER, "Did not construct DynamicsSolver object properly. "
+                         "Check error logs.");
+    return false;
+  }
+  if (joint_model_group_->getVariableCount() != num_joints_)
+  {
+    RCLCPP_ERROR(LOGGER, "Group '%s' has %d variables, but the chain has %d joints",
+                 joint_model_group_->getName().c_str(), joint_model_group_->getVariableCount(), num_joints_);
+    return false;
+  }
+
+  const std::size_t waypoint_count = trajectory.getWayPointCount();
+  torques.resize(waypoint_count);
+  for (std::vector<double>& waypoint_torques : torques)
+    waypoint_torques.resize(num_joints_);
+  if (waypoint_count == 0)
+    return true;
+
+  // Every waypoint is computed into its own slot, so the result is the same for any number of threads
+  std::atomic<std::size_t> next_waypoint{ 0 };
+  std::atomic<bool> failed{ false };
+  const auto compute = [&]() {
+    Workspace workspace(kdl_chain_, gravity_vector_, robot_model_);
+    for (std::size_t i = next_waypoint++; i < waypoint_count && !failed; i = next_waypoint++)
+    {
+      if (!computeWaypointTorques(workspace, trajectory.getWayPoint(i), payload, torques[i].data()))
+      {
+        RCLCPP_ERROR(LOGGER, "Something went wrong computing torques at waypoint %zu", i);
+        failed = true;
+      }
+    }
+  };
+
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t worker_count = std::min<std::size_t>(thread_count, waypoint_count) - 1;
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (std::size_t t = 0; t < worker_count; ++t)
+    workers.emplace_back(compute);
+  compute();
+  for (std::thread& worker : workers)
+    worker.join();
+
+  return !failed;
+}
+
+bool DynamicsSolver::checkTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                                       TorqueLimitCheckResult& result, unsigned int thread_count) const
+{
+  std::vector<std::vector<double>> torques;
+  if (!getTrajectoryTorques(trajectory, payload, torques, thread_count))
+    return false;
+
+  result = TorqueLimitCheckResult();
+  for (std::size_t i = 0; i < torques.size(); ++i)
+  {
+    for (unsigned int j = 0; j < num_joints_; ++j)
+    {
+      // Joints without an effort limit in the URDF have a maximum torque of 0
+      if (max_torques_[j] <= 0.0)
+        continue;
+      const double ratio = std::fabs(torques[i][j]) / max_torques_[j];
+      if (ratio > result.max_torque_ratio)
+      {
+        result.max_torque_ratio = ratio;
+        result.waypoint = i;
+        result.joint = j;
+      }
+    }
+  }
+  return true;
+}
+
 const std::vector<double>& DynamicsSolver::getMaxTorques() const
 {
   return max_torques_;
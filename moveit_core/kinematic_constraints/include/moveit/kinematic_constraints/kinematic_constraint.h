@@ -38,6 +38,7 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_batch.h>
 #include <moveit/transforms/transforms.h>
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/macros/class_forward.h>
@@ -46,8 +47,14 @@
 #include <moveit_msgs/msg/constraints.hpp>
 
 #include <iostream>
+#include <mutex>
 #include <vector>
 
+namespace collision_detection
+{
+class CollisionEnvFCL;
+}
+
 /** \brief Representation and evaluation of kinematic constraints */
 namespace kinematic_constraints
 {
@@ -71,6 +78,20 @@ struct ConstraintEvaluationResult
   double distance; /**< \brief The distance evaluation from the constraint or constraints */
 };
 
+/// \brief Struct for containing the results of constraint evaluation over a batch of states, packed per state
+struct ConstraintBatchEvaluationResult
+{
+  /** \brief Resize the result to \e size states that are all satisfied with zero distance */
+  void reset(std::size_t size)
+  {
+    satisfied.assign(size, 1);
+    distance.assign(size, 0.0);
+  }
+
+  std::vector<uint8_t> satisfied; /**< \brief For each state, whether or not the constraints were satisfied */
+  std::vector<double> distance;   /**< \brief For each state, the summed distance evaluation from the constraints */
+};
+
 MOVEIT_CLASS_FORWARD(KinematicConstraint);  // Defines KinematicConstraintPtr, ConstPtr, WeakPtr... etc
 
 /// \brief Base class for representing a kinematic constraint
@@ -108,6 +129,19 @@ public:
    */
   virtual ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const = 0;
 
+  /**
+   * \brief Decide whether the constraint is satisfied in each state of a batch, combining the outcome into \e results
+   *
+   * States that violate the constraint are marked as not satisfied and the distance of every state is added to the
+   * distance stored for it. The default implementation calls decide() for every state; derived classes evaluate the
+   * whole batch at once where possible.
+   *
+   * @param [in] states The states used for evaluation, with up to date link transforms
+   * @param [in,out] results The results of the batch, sized to the number of states
+   */
+  virtual void accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                                   ConstraintBatchEvaluationResult& results) const;
+
   /** \brief This function returns true if this constraint is
       configured and able to decide whether states do meet the
       constraint or not. If this function returns false it means
@@ -246,6 +280,8 @@ public:
   bool equal(const KinematicConstraint& other, double margin) const override;
 
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                           ConstraintBatchEvaluationResult& results) const override;
   bool enabled() const override;
   void clear() override;
   void print(std::ostream& out = std::cout) const override;
@@ -396,6 +432,8 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                           ConstraintBatchEvaluationResult& results) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -484,6 +522,10 @@ public:
   }
 
 protected:
+  /** \brief Compute the absolute error per axis for the rotation \e diff between the desired and the actual link
+   * orientation, using the configured parameterization */
+  Eigen::Vector3d computeOrientationError(const Eigen::Matrix3d& diff) const;
+
   const moveit::core::LinkModel* link_model_;   /**< \brief The target link model */
   Eigen::Matrix3d desired_rotation_matrix_;     /**< \brief The desired rotation matrix in the tf frame. Guaranteed to
                                                  * be valid rotation matrix. */
@@ -496,6 +538,47 @@ protected:
       absolute_z_axis_tolerance_; /**< \brief Storage for the tolerances */
 };
 
+MOVEIT_CLASS_FORWARD(MeshRegionGrid);  // Defines MeshRegionGridPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief Precomputed inside/outside classification of a mesh region on a regular grid
+ *
+ * The grid covers the bounding box of the region in the frame of the region. Cells that may be crossed by the
+ * surface of the region are marked as UNKNOWN, so points in these cells need to be tested against the region
+ * itself. All other cells are either entirely inside or entirely outside of the region.
+ */
+class MeshRegionGrid
+{
+public:
+  /// \brief The classification of a grid cell
+  enum Cell : uint8_t
+  {
+    OUTSIDE,
+    INSIDE,
+    UNKNOWN
+  };
+
+  /** \brief The default number of cells along the longest side of the bounding box of a region */
+  static constexpr std::size_t DEFAULT_CELLS_PER_AXIS = 32;
+
+  /**
+   * \brief Classify the cells of a grid for \e mesh
+   *
+   * @param [in] mesh The region, with up to date internal data
+   * @param [in] cells_per_axis The number of cells along the longest side of the bounding box of \e mesh
+   */
+  MeshRegionGrid(const bodies::ConvexMesh& mesh, std::size_t cells_per_axis = DEFAULT_CELLS_PER_AXIS);
+
+  /** \brief Classify \e point, given in the frame of the region. Points outside of the grid are OUTSIDE. */
+  Cell classify(const Eigen::Vector3d& point) const;
+
+private:
+  Eigen::Vector3d origin_;  /**< \brief The minimum corner of the grid */
+  double resolution_;       /**< \brief The side length of a cell */
+  std::size_t size_[3];     /**< \brief The number of cells along each axis */
+  std::vector<Cell> cells_; /**< \brief The cells, indexed as x + size_[0] * (y + size_[1] * z) */
+};
+
 MOVEIT_CLASS_FORWARD(PositionConstraint);  // Defines PositionConstraintPtr, ConstPtr, WeakPtr... etc
 
 /**
@@ -572,6 +655,8 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                           ConstraintBatchEvaluationResult& results) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -653,9 +738,17 @@ protected:
   std::vector<bodies::BodyPtr> constraint_region_; /**< \brief The constraint region vector */
   /** \brief The constraint region pose vector. All isometries are guaranteed to be valid. */
   EigenSTL::vector_Isometry3d constraint_region_pose_;
+  /** \brief For each constraint region, the precomputed containment grid for meshes, or nullptr */
+  std::vector<MeshRegionGridConstPtr> constraint_region_grid_;
   bool mobile_frame_;                         /**< \brief Whether or not a mobile frame is employed*/
   std::string constraint_frame_id_;           /**< \brief The constraint frame id */
   const moveit::core::LinkModel* link_model_; /**< \brief The link model constraint subject */
+
+  /** \brief Classify \e pt with the containment grid of constraint region \e index, placed at \e region_pose.
+   *
+   * Returns UNKNOWN if the region has no grid, in which case the region itself needs to be tested. */
+  MeshRegionGrid::Cell classifyRegionPoint(std::size_t index, const Eigen::Isometry3d& region_pose,
+                                           const Eigen::Vector3d& pt) const;
 };
 
 MOVEIT_CLASS_FORWARD(VisibilityConstraint);  // Defines VisibilityConstraintPtr, ConstPtr, WeakPtr... etc
@@ -819,6 +912,24 @@ public:
   shapes::Mesh* getVisibilityCone(const Eigen::Isometry3d& tform_world_to_sensor,
                                   const Eigen::Isometry3d& tform_world_to_target) const;
 
+  /**
+   * \brief Check the visibility cone by casting rays from the sensor to the center and the rim of the target disc
+   * instead of checking the robot for collisions with the cone mesh.
+   *
+   * This is much faster, but approximate: links between the rays are missed and link meshes are represented by their
+   * convex hulls. The penalty distance of violations is always 0. Disabled by default.
+   */
+  void setUseRayCasts(bool use_ray_casts)
+  {
+    use_ray_casts_ = use_ray_casts;
+  }
+
+  /** \brief Whether the visibility cone is checked by casting rays, see setUseRayCasts() */
+  bool getUseRayCasts() const
+  {
+    return use_ray_casts_;
+  }
+
   /**
    * \brief Adds markers associated with the visibility cone, sensor
    * and target to the visualization array
@@ -848,6 +959,22 @@ protected:
    */
   bool decideContact(const collision_detection::Contact& contact) const;
 
+  /** \brief Get the visibility cone in the target frame for a sensor at \e apex (in the target frame). The mesh is
+      reused as long as the sensor does not move relative to the target, so that its collision geometry is cached. */
+  shapes::ShapeConstPtr getCachedVisibilityCone(const Eigen::Vector3d& apex) const;
+
+  /** \brief Check whether any link blocks the rays from \e sensor to the target disc at \e tform_world_to_target */
+  bool isRayBlocked(const moveit::core::RobotState& state, const Eigen::Vector3d& sensor,
+                    const Eigen::Isometry3d& tform_world_to_target, bool verbose) const;
+
+  /** \brief A collision geometry of a link, in the frame of its collision body, for ray casts */
+  struct RayCastBody
+  {
+    const moveit::core::LinkModel* link;
+    std::size_t shape_index;
+    bodies::BodyConstPtr body;
+  };
+
   moveit::core::RobotModelConstPtr robot_model_; /**< \brief A copy of the robot model used to create collision
                                                              environments to check the cone against robot links */
 
@@ -861,6 +988,15 @@ protected:
   double target_radius_;             /**< \brief Storage for the target radius */
   double max_view_angle_;            /**< \brief Storage for the max view angle */
   double max_range_angle_;           /**< \brief Storage for the max range angle */
+  bool use_ray_casts_;               /**< \brief Whether the cone is checked with ray casts */
+
+  /** \brief The robot without world objects, overlaid with the cone for each evaluation */
+  std::shared_ptr<const collision_detection::CollisionEnvFCL> collision_env_;
+  std::vector<RayCastBody> ray_cast_bodies_; /**< \brief The collision geometries of the links blocking rays */
+
+  mutable std::mutex cone_lock_;       /**< \brief Protects cone_ and cone_apex_ */
+  mutable shapes::ShapeConstPtr cone_; /**< \brief The last visibility cone, in the target frame */
+  mutable Eigen::Vector3d cone_apex_;  /**< \brief The apex of cone_, in the target frame */
 };
 
 MOVEIT_CLASS_FORWARD(KinematicConstraintSet);  // Defines KinematicConstraintSetPtr, ConstPtr, WeakPtr... etc
@@ -978,6 +1114,16 @@ public:
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state,
                                     std::vector<ConstraintEvaluationResult>& results, bool verbose = false) const;
 
+  /**
+   * \brief Determines for each state of a batch whether all constraints are satisfied
+   *
+   * @param [in] states The states to test; their link transforms need to be up to date
+   *
+   * @param [out] results For each state, whether all constraints are satisfied and the sum of all individual
+   * distances.
+   */
+  void decide(const moveit::core::RobotStateBatch& states, ConstraintBatchEvaluationResult& results) const;
+
   /**
    * \brief Whether or not another KinematicConstraintSet is equal to
    * this one.
@@ -44,6 +44,8 @@
 #include <rclcpp/logging.hpp>
 #include <rclcpp/time.hpp>
 #include <tf2_eigen/tf2_eigen.hpp>
+#include <algorithm>
+#include <cassert>
 #include <functional>
 #include <limits>
 #include <math.h>
@@ -131,6 +133,20 @@ KinematicConstraint::KinematicConstraint(const moveit::core::RobotModelConstPtr&
 
 KinematicConstraint::~KinematicConstraint() = default;
 
+void KinematicConstraint::accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                                              ConstraintBatchEvaluationResult& results) const
+{
+  moveit::core::RobotState state(states.getRobotModel());
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    states.copyVariablePositions(i, state);
+    state.update();
+    const ConstraintEvaluationResult r = decide(state);
+    results.satisfied[i] &= static_cast<uint8_t>(r.satisfied);
+    results.distance[i] += r.distance;
+  }
+}
+
 bool JointConstraint::configure(const moveit_msgs::msg::JointConstraint& jc)
 {
   // clearing before we configure to get rid of any old data
@@ -319,6 +335,35 @@ ConstraintEvaluationResult JointConstraint::decide(const moveit::core::RobotStat
   return ConstraintEvaluationResult(result, constraint_weight_ * fabs(dif));
 }
 
+void JointConstraint::accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                                          ConstraintBatchEvaluationResult& results) const
+{
+  if (!joint_model_)
+    return;
+
+  // same evaluation as decide(), but over the contiguous positions of the constrained variable
+  const double* positions = states.getVariablePositions(joint_variable_index_);
+  const double upper = joint_tolerance_above_ + 2.0 * std::numeric_limits<double>::epsilon();
+  const double lower = -joint_tolerance_below_ - 2.0 * std::numeric_limits<double>::epsilon();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    double dif;
+    if (joint_is_continuous_)
+    {
+      dif = normalizeAngle(positions[i]) - joint_position_;
+      if (dif > M_PI)
+        dif = 2.0 * M_PI - dif;
+      else if (dif < -M_PI)
+        dif += 2.0 * M_PI;
+    }
+    else
+      dif = positions[i] - joint_position_;
+
+    results.satisfied[i] &= static_cast<uint8_t>(dif <= upper && dif >= lower);
+    results.distance[i] += constraint_weight_ * fabs(dif);
+  }
+}
+
 bool JointConstraint::enabled() const
 {
   return joint_model_;
@@ -351,6 +396,80 @@ void JointConstraint::print(std::ostream& out) const
     out << "No constraint" << '\n';
 }
 
+MeshRegionGrid::MeshRegionGrid(const bodies::ConvexMesh& mesh, std::size_t cells_per_axis)
+  : origin_(Eigen::Vector3d::Zero()), resolution_(1.0), size_{ 0, 0, 0 }
+{
+  const EigenSTL::vector_Vector3d& vertices = mesh.getScaledVertices();
+  const std::vector<unsigned int>& triangles = mesh.getTriangles();
+  Eigen::AlignedBox3d box;
+  for (const Eigen::Vector3d& vertex : vertices)
+    box.extend(vertex);
+  if (box.isEmpty() || cells_per_axis == 0)
+    return;
+
+  // the margin keeps the surface away from the border of the grid and covers the tolerance of the exact test
+  const double margin = mesh.getPadding() + 1e-6;
+  origin_ = box.min() - Eigen::Vector3d::Constant(margin);
+  const Eigen::Vector3d extent = box.sizes() + Eigen::Vector3d::Constant(2.0 * margin);
+  resolution_ = extent.maxCoeff() / static_cast<double>(cells_per_axis);
+  for (std::size_t k = 0; k < 3; ++k)
+    size_[k] = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(extent[k] / resolution_)));
+  cells_.assign(size_[0] * size_[1] * size_[2], OUTSIDE);
+
+  const auto cell_center = [this](std::size_t x, std::size_t y, std::size_t z) {
+    return Eigen::Vector3d(origin_.x() + (x + 0.5) * resolution_, origin_.y() + (y + 0.5) * resolution_,
+                           origin_.z() + (z + 0.5) * resolution_);
+  };
+  const auto cell_index = [this](double value, std::size_t axis) {
+    const double index = std::floor((value - origin_[axis]) / resolution_);
+    return static_cast<std::size_t>(std::clamp(index, 0.0, static_cast<double>(size_[axis] - 1)));
+  };
+
+  // mark the cells in the bounding box of each triangle that overlap the plane of the triangle
+  for (std::size_t t = 0; t + 2 < triangles.size(); t += 3)
+  {
+    const Eigen::Vector3d& a = vertices[triangles[t]];
+    const Eigen::Vector3d& b = vertices[triangles[t + 1]];
+    const Eigen::Vector3d& c = vertices[triangles[t + 2]];
+    const Eigen::Vector3d normal = (b - a).cross(c - a);
+    const double radius = 0.5 * resolution_ * normal.cwiseAbs().sum() + margin * normal.norm();
+    const Eigen::Vector3d lo = a.cwiseMin(b).cwiseMin(c) - Eigen::Vector3d::Constant(margin);
+    const Eigen::Vector3d hi = a.cwiseMax(b).cwiseMax(c) + Eigen::Vector3d::Constant(margin);
+    for (std::size_t z = cell_index(lo.z(), 2); z <= cell_index(hi.z(), 2); ++z)
+      for (std::size_t y = cell_index(lo.y(), 1); y <= cell_index(hi.y(), 1); ++y)
+        for (std::size_t x = cell_index(lo.x(), 0); x <= cell_index(hi.x(), 0); ++x)
+          if (fabs(normal.dot(cell_center(x, y, z) - a)) <= radius)
+            cells_[x + size_[0] * (y + size_[1] * z)] = UNKNOWN;
+  }
+
+  // the remaining cells are not crossed by the surface, so their center decides for the entire cell
+  const Eigen::Isometry3d& pose = mesh.getPose();
+  for (std::size_t z = 0; z < size_[2]; ++z)
+    for (std::size_t y = 0; y < size_[1]; ++y)
+      for (std::size_t x = 0; x < size_[0]; ++x)
+      {
+        Cell& cell = cells_[x + size_[0] * (y + size_[1] * z)];
+        if (cell != UNKNOWN)
+          cell = mesh.containsPoint(pose * cell_center(x, y, z)) ? INSIDE : OUTSIDE;
+      }
+}
+
+MeshRegionGrid::Cell MeshRegionGrid::classify(const Eigen::Vector3d& point) const
+{
+  if (cells_.empty())
+    return UNKNOWN;
+  const Eigen::Vector3d p = (point - origin_) / resolution_;
+  // written to also reject NaN
+  if (!(p.array() >= 0.0).all())
+    return OUTSIDE;
+  const std::size_t x = static_cast<std::size_t>(p.x());
+  const std::size_t y = static_cast<std::size_t>(p.y());
+  const std::size_t z = static_cast<std::size_t>(p.z());
+  if (x >= size_[0] || y >= size_[1] || z >= size_[2])
+    return OUTSIDE;
+  return cells_[x + size_[0] * (y + size_[1] * z)];
+}
+
 bool PositionConstraint::configure(const moveit_msgs::msg::PositionConstraint& pc, const moveit::core::Transforms& tf)
 {
   // clearing before we configure to get rid of any old data
@@ -441,6 +560,14 @@ bool PositionConstraint::configure(const moveit_msgs::msg::PositionConstraint& p
     }
   }
 
+  // mesh regions are expensive to test exactly, so most of their queries are answered by a precomputed grid
+  constraint_region_grid_.resize(constraint_region_.size());
+  for (std::size_t i = 0; i < constraint_region_.size(); ++i)
+  {
+    if (const auto* mesh = dynamic_cast<const bodies::ConvexMesh*>(constraint_region_[i].get()))
+      constraint_region_grid_[i] = std::make_shared<const MeshRegionGrid>(*mesh);
+  }
+
   if (pc.weight <= std::numeric_limits<double>::epsilon())
   {
     RCLCPP_WARN(LOGGER, "The weight on position constraint for link '%s' is near zero.  Setting to 1.0.",
@@ -524,7 +651,9 @@ ConstraintEvaluationResult PositionConstraint::decide(const moveit::core::RobotS
     for (std::size_t i = 0; i < constraint_region_.size(); ++i)
     {
       Eigen::Isometry3d tmp = state.getFrameTransform(constraint_frame_id_) * constraint_region_pose_[i];
-      bool result = constraint_region_[i]->cloneAt(tmp)->containsPoint(pt, verbose);
+      const MeshRegionGrid::Cell cell = classifyRegionPoint(i, tmp, pt);
+      bool result = cell == MeshRegionGrid::UNKNOWN ? constraint_region_[i]->cloneAt(tmp)->containsPoint(pt, verbose) :
+                                                      cell == MeshRegionGrid::INSIDE;
       if (result || (i + 1 == constraint_region_pose_.size()))
       {
         return finishPositionConstraintDecision(pt, tmp.translation(), link_model_->getName(), constraint_weight_,
@@ -541,7 +670,9 @@ ConstraintEvaluationResult PositionConstraint::decide(const moveit::core::RobotS
   {
     for (std::size_t i = 0; i < constraint_region_.size(); ++i)
     {
-      bool result = constraint_region_[i]->containsPoint(pt, true);
+      const MeshRegionGrid::Cell cell = classifyRegionPoint(i, constraint_region_pose_[i], pt);
+      bool result = cell == MeshRegionGrid::UNKNOWN ? constraint_region_[i]->containsPoint(pt, true) :
+                                                      cell == MeshRegionGrid::INSIDE;
       if (result || (i + 1 == constraint_region_.size()))
       {
         return finishPositionConstraintDecision(pt, constraint_region_[i]->getPose().translation(),
@@ -557,6 +688,56 @@ ConstraintEvaluationResult PositionConstraint::decide(const moveit::core::RobotS
   return ConstraintEvaluationResult(false, 0.0);
 }
 
+void PositionConstraint::accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                                             ConstraintBatchEvaluationResult& results) const
+{
+  if (!link_model_ || constraint_region_.empty())
+    return;
+  if (mobile_frame_)
+  {
+    KinematicConstraint::accumulateDecisions(states, results);
+    return;
+  }
+
+  // compute the constrained point for all states at once, one coordinate at a time
+  const std::size_t count = states.size();
+  std::vector<double> points(3 * count);
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double* r0 = states.getGlobalLinkTransformComponent(link_model_, row);
+    const double* r1 = states.getGlobalLinkTransformComponent(link_model_, 3 + row);
+    const double* r2 = states.getGlobalLinkTransformComponent(link_model_, 6 + row);
+    const double* t = states.getGlobalLinkTransformComponent(link_model_, 9 + row);
+    double* out = &points[row * count];
+    for (std::size_t i = 0; i < count; ++i)
+      out[i] = r0[i] * offset_.x() + r1[i] * offset_.y() + r2[i] * offset_.z() + t[i];
+  }
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const Eigen::Vector3d pt(points[i], points[count + i], points[2 * count + i]);
+    for (std::size_t j = 0; j < constraint_region_.size(); ++j)
+    {
+      const MeshRegionGrid::Cell cell = classifyRegionPoint(j, constraint_region_pose_[j], pt);
+      const bool result = cell == MeshRegionGrid::UNKNOWN ? constraint_region_[j]->containsPoint(pt) :
+                                                            cell == MeshRegionGrid::INSIDE;
+      if (result || (j + 1 == constraint_region_.size()))
+      {
+        results.satisfied[i] &= static_cast<uint8_t>(result);
+        results.distance[i] += constraint_weight_ * (constraint_region_[j]->getPose().translation() - pt).norm();
+        break;
+      }
+    }
+  }
+}
+
+MeshRegionGrid::Cell PositionConstraint::classifyRegionPoint(std::size_t index, const Eigen::Isometry3d& region_pose,
+                                                             const Eigen::Vector3d& pt) const
+{
+  const MeshRegionGridConstPtr& grid = constraint_region_grid_[index];
+  return grid ? grid->classify(region_pose.inverse() * pt) : MeshRegionGrid::UNKNOWN;
+}
+
 void PositionConstraint::print(std::ostream& out) const
 {
   if (enabled())
@@ -575,6 +756,7 @@ void PositionConstraint::clear()
   has_offset_ = false;
   constraint_region_.clear();
   constraint_region_pose_.clear();
+  constraint_region_grid_.clear();
   mobile_frame_ = false;
   constraint_frame_id_ = "";
   link_model_ = nullptr;
@@ -697,31 +879,14 @@ bool OrientationConstraint::enabled() const
   return link_model_;
 }
 
-ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::RobotState& state, bool verbose) const
+Eigen::Vector3d OrientationConstraint::computeOrientationError(const Eigen::Matrix3d& diff) const
 {
-  if (!link_model_)
-    return ConstraintEvaluationResult(true, 0.0);
-
-  Eigen::Isometry3d diff;
-  if (mobile_frame_)
-  {
-    // getFrameTransform() returns a valid isometry by contract
-    Eigen::Matrix3d tmp = state.getFrameTransform(desired_rotation_frame_id_).linear() * desired_rotation_matrix_;
-    // getGlobalLinkTransform() returns a valid isometry by contract
-    diff = Eigen::Isometry3d(tmp.transpose() * state.getGlobalLinkTransform(link_model_).linear());  // valid isometry
-  }
-  else
-  {
-    // diff is valid isometry by construction
-    diff = Eigen::Isometry3d(desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).linear());
-  }
-
   // This needs to live outside the if-block scope (as xyz_rotation points to its data).
   std::tuple<Eigen::Vector3d, bool> euler_angles_error;
   Eigen::Vector3d xyz_rotation;
   if (parameterization_type_ == moveit_msgs::msg::OrientationConstraint::XYZ_EULER_ANGLES)
   {
-    euler_angles_error = CalcEulerAngles(diff.linear());
+    euler_angles_error = CalcEulerAngles(diff);
     // Converting from a rotation matrix to intrinsic XYZ Euler angles has 2 singularities:
     // pitch ~= pi/2 ==> roll + yaw = theta
     // pitch ~= -pi/2 ==> roll - yaw = theta
@@ -742,7 +907,7 @@ ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::Rob
   }
   else if (parameterization_type_ == moveit_msgs::msg::OrientationConstraint::ROTATION_VECTOR)
   {
-    Eigen::AngleAxisd aa(diff.linear());
+    Eigen::AngleAxisd aa(diff);
     xyz_rotation = aa.axis() * aa.angle();
     xyz_rotation(0) = fabs(xyz_rotation(0));
     xyz_rotation(1) = fabs(xyz_rotation(1));
@@ -754,6 +919,30 @@ ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::Rob
     RCLCPP_ERROR(LOGGER, "The parameterization type for the orientation constraints is invalid.");
   }
 
+  return xyz_rotation;
+}
+
+ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::RobotState& state, bool verbose) const
+{
+  if (!link_model_)
+    return ConstraintEvaluationResult(true, 0.0);
+
+  Eigen::Isometry3d diff;
+  if (mobile_frame_)
+  {
+    // getFrameTransform() returns a valid isometry by contract
+    Eigen::Matrix3d tmp = state.getFrameTransform(desired_rotation_frame_id_).linear() * desired_rotation_matrix_;
+    // getGlobalLinkTransform() returns a valid isometry by contract
+    diff = Eigen::Isometry3d(tmp.transpose() * state.getGlobalLinkTransform(link_model_).linear());  // valid isometry
+  }
+  else
+  {
+    // diff is valid isometry by construction
+    diff = Eigen::Isometry3d(desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).linear());
+  }
+
+  const Eigen::Vector3d xyz_rotation = computeOrientationError(diff.linear());
+
   bool result = xyz_rotation(2) < absolute_z_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
                 xyz_rotation(1) < absolute_y_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
                 xyz_rotation(0) < absolute_x_axis_tolerance_ + std::numeric_limits<double>::epsilon();
@@ -773,6 +962,51 @@ ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::Rob
   return ConstraintEvaluationResult(result, constraint_weight_ * (xyz_rotation(0) + xyz_rotation(1) + xyz_rotation(2)));
 }
 
+void OrientationConstraint::accumulateDecisions(const moveit::core::RobotStateBatch& states,
+                                                ConstraintBatchEvaluationResult& results) const
+{
+  if (!link_model_)
+    return;
+  if (mobile_frame_)
+  {
+    KinematicConstraint::accumulateDecisions(states, results);
+    return;
+  }
+
+  // diff = desired_rotation_matrix_inv_ * R for all states at once, one matrix component at a time,
+  // using the column major component layout of RobotStateBatch
+  const std::size_t count = states.size();
+  std::vector<double> diffs(9 * count);
+  for (std::size_t col = 0; col < 3; ++col)
+  {
+    const double* r0 = states.getGlobalLinkTransformComponent(link_model_, col * 3);
+    const double* r1 = states.getGlobalLinkTransformComponent(link_model_, col * 3 + 1);
+    const double* r2 = states.getGlobalLinkTransformComponent(link_model_, col * 3 + 2);
+    for (std::size_t row = 0; row < 3; ++row)
+    {
+      const double a0 = desired_rotation_matrix_inv_(row, 0);
+      const double a1 = desired_rotation_matrix_inv_(row, 1);
+      const double a2 = desired_rotation_matrix_inv_(row, 2);
+      double* out = &diffs[(col * 3 + row) * count];
+      for (std::size_t i = 0; i < count; ++i)
+        out[i] = a0 * r0[i] + a1 * r1[i] + a2 * r2[i];
+    }
+  }
+
+  Eigen::Matrix3d diff;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    for (std::size_t c = 0; c < 9; ++c)
+      diff(c % 3, c / 3) = diffs[c * count + i];
+    const Eigen::Vector3d xyz_rotation = computeOrientationError(diff);
+    const bool result = xyz_rotation(2) < absolute_z_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
+                        xyz_rotation(1) < absolute_y_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
+                        xyz_rotation(0) < absolute_x_axis_tolerance_ + std::numeric_limits<double>::epsilon();
+    results.satisfied[i] &= static_cast<uint8_t>(result);
+    results.distance[i] += constraint_weight_ * (xyz_rotation(0) + xyz_rotation(1) + xyz_rotation(2));
+  }
+}
+
 void OrientationConstraint::print(std::ostream& out) const
 {
   if (link_model_)
@@ -786,7 +1020,7 @@ void OrientationConstraint::print(std::ostream& out) const
 }
 
 VisibilityConstraint::VisibilityConstraint(const moveit::core::RobotModelConstPtr& model)
-  : KinematicConstraint(model), robot_model_{ model }
+  : KinematicConstraint(model), robot_model_{ model }, use_ray_casts_(false)
 {
   type_ = VISIBILITY_CONSTRAINT;
 }
@@ -803,6 +1037,10 @@ void VisibilityConstraint::clear()
   target_radius_ = -1.0;
   max_view_angle_ = 0.0;
   max_range_angle_ = 0.0;
+  collision_env_.reset();
+  ray_cast_bodies_.clear();
+  std::scoped_lock slock(cone_lock_);
+  cone_.reset();
 }
 
 bool VisibilityConstraint::configure(const moveit_msgs::msg::VisibilityConstraint& vc,
@@ -874,6 +1112,26 @@ bool VisibilityConstraint::configure(const moveit_msgs::msg::VisibilityConstrain
   max_range_angle_ = vc.max_range_angle;
   sensor_view_direction_ = vc.sensor_view_direction;
 
+  if (target_radius_ > std::numeric_limits<double>::epsilon())
+  {
+    // the geometry of the robot is created once, each evaluation only adds the cone
+    collision_env_ = std::make_shared<const collision_detection::CollisionEnvFCL>(robot_model_);
+
+    // the sensor and the target may touch the cone, see decideContact()
+    for (const moveit::core::LinkModel* link : robot_model_->getLinkModelsWithCollisionGeometry())
+    {
+      if (moveit::core::Transforms::sameFrame(link->getName(), sensor_frame_id_) ||
+          moveit::core::Transforms::sameFrame(link->getName(), target_frame_id_))
+        continue;
+      for (std::size_t i = 0; i < link->getShapes().size(); ++i)
+      {
+        // bodies stay at the identity pose so that they can be shared by concurrent evaluations
+        if (bodies::Body* body = bodies::createBodyFromShape(link->getShapes()[i].get()))
+          ray_cast_bodies_.push_back({ link, i, bodies::BodyConstPtr(body) });
+      }
+    }
+  }
+
   return enabled();
 }
 
@@ -987,6 +1245,63 @@ shapes::Mesh* VisibilityConstraint::getVisibilityCone(const Eigen::Isometry3d& t
   return m;
 }
 
+shapes::ShapeConstPtr VisibilityConstraint::getCachedVisibilityCone(const Eigen::Vector3d& apex) const
+{
+  std::scoped_lock slock(cone_lock_);
+  if (!cone_ || (cone_apex_ - apex).norm() > 1e-9)
+  {
+    cone_.reset(getVisibilityCone(Eigen::Isometry3d(Eigen::Translation3d(apex)), Eigen::Isometry3d::Identity()));
+    cone_apex_ = apex;
+  }
+  return cone_;
+}
+
+bool VisibilityConstraint::isRayBlocked(const moveit::core::RobotState& state, const Eigen::Vector3d& sensor,
+                                        const Eigen::Isometry3d& tform_world_to_target, bool verbose) const
+{
+  // rays to the center of the target disc and the points on its rim
+  EigenSTL::vector_Vector3d targets;
+  targets.reserve(points_.size() + 1);
+  targets.push_back(tform_world_to_target.translation());
+  for (const Eigen::Vector3d& point : points_)
+    targets.push_back(tform_world_to_target * point);
+
+  EigenSTL::vector_Vector3d intersections;
+  for (const RayCastBody& ray_cast_body : ray_cast_bodies_)
+  {
+    // cast the rays in the frame of the body
+    const Eigen::Isometry3d to_body =
+        state.getCollisionBodyTransform(ray_cast_body.link, ray_cast_body.shape_index).inverse();
+    const Eigen::Vector3d origin = to_body * sensor;
+    // a body enclosing the sensor is taken to be its housing
+    if (ray_cast_body.body->containsPoint(origin))
+      continue;
+    for (const Eigen::Vector3d& target : targets)
+    {
+      const Eigen::Vector3d ray = to_body * target - origin;
+      const double length = ray.norm();
+      if (length <= std::numeric_limits<double>::epsilon())
+        continue;
+      intersections.clear();
+      if (!ray_cast_body.body->intersectsRay(origin, ray / length, &intersections))
+        continue;
+      for (const Eigen::Vector3d& intersection : intersections)
+      {
+        if ((intersection - origin).norm() < length)
+        {
+          if (verbose)
+          {
+            RCLCPP_INFO(LOGGER, "Visibility constraint is violated because link '%s' blocks the view of the target",
+                        ray_cast_body.link->getName().c_str());
+          }
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
 void VisibilityConstraint::getMarkers(const moveit::core::RobotState& state,
                                       visualization_msgs::msg::MarkerArray& markers) const
 {
@@ -1132,16 +1447,25 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
   // Check visibility cone collision constraint
   if (target_radius_ > std::numeric_limits<double>::epsilon())
   {
-    shapes::Mesh* m = getVisibilityCone(tform_world_to_sensor, tform_world_to_target);
-    if (!m)
+    if (use_ray_casts_)
+    {
+      const bool blocked = isRayBlocked(state, tform_world_to_sensor.translation(), tform_world_to_target, verbose);
+      return ConstraintEvaluationResult(!blocked, 0.0);
+    }
+
+    // the cone only changes shape when the sensor moves relative to the target, otherwise it is just moved along
+    const shapes::ShapeConstPtr cone =
+        getCachedVisibilityCone(tform_world_to_target.inverse() * tform_world_to_sensor.translation());
+    if (!cone)
     {
       RCLCPP_ERROR(LOGGER, "Visibility constraint is violated because we could not create the visibility cone mesh.");
       return ConstraintEvaluationResult(false, 0.0);
     }
 
-    // add the visibility cone as an object
-    const auto collision_env_local = std::make_shared<collision_detection::CollisionEnvFCL>(robot_model_);
-    collision_env_local->getWorld()->addToObject("cone", shapes::ShapeConstPtr(m), Eigen::Isometry3d::Identity());
+    // add the visibility cone as an object, on top of the robot geometry created in configure()
+    const auto world = std::make_shared<collision_detection::World>();
+    const auto collision_env_local = std::make_shared<collision_detection::CollisionEnvFCL>(collision_env_, world);
+    world->addToObject("cone", cone, tform_world_to_target);
 
     // check for collisions between the robot and the cone
     collision_detection::AllowedCollisionMatrix acm;
@@ -1161,13 +1485,11 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
     if (verbose)
     {
       std::stringstream ss;
-      m->print(ss);
-      RCLCPP_INFO(LOGGER, "Visibility constraint %ssatisfied. Visibility cone approximation:\n %s",
+      cone->print(ss);
+      RCLCPP_INFO(LOGGER, "Visibility constraint %ssatisfied. Visibility cone approximation in the target frame:\n %s",
                   res.collision ? "not " : "", ss.str().c_str());
     }
 
-    collision_env_local->getWorld()->removeObject("cone");
-
     return ConstraintEvaluationResult(!res.collision, res.collision ? res.contacts.begin()->second.front().depth : 0.0);
   }
 
@@ -1322,6 +1644,15 @@ ConstraintEvaluationResult KinematicConstraintSet::decide(const moveit::core::Ro
   return result;
 }
 
+void KinematicConstraintSet::decide(const moveit::core::RobotStateBatch& states,
+                                    ConstraintBatchEvaluationResult& results) const
+{
+  assert(!states.dirty());
+  results.reset(states.size());
+  for (const KinematicConstraintPtr& kinematic_constraint : kinematic_constraints_)
+    kinematic_constraint->accumulateDecisions(states, results);
+}
+
 void KinematicConstraintSet::print(std::ostream& out) const
 {
   out << kinematic_constraints_.size() << " kinematic constraints" << '\n';
@@ -37,6 +37,8 @@
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <gtest/gtest.h>
 #include <urdf_parser/urdf_parser.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <geometric_shapes/shapes.h>
 #include <fstream>
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <math.h>
@@ -661,6 +663,35 @@ TEST_F(LoadPlanningModelsPr2, OrientationConstraintsSimple)
   EXPECT_FALSE(oc.decide(robot_state).satisfied);
 }
 
+TEST(MeshRegionGrid, AgreesWithExactContainment)
+{
+  const shapes::Box box(0.2, 0.3, 0.4);
+  std::unique_ptr<shapes::Mesh> mesh(shapes::createMeshFromShape(box));
+  ASSERT_TRUE(mesh);
+  bodies::ConvexMesh body(mesh.get());
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.5, -0.2, 1.0);
+  pose.rotate(Eigen::AngleAxisd(0.7, Eigen::Vector3d(1.0, 1.0, 0.0).normalized()));
+  body.setPose(pose);
+
+  const kinematic_constraints::MeshRegionGrid grid(body);
+  random_numbers::RandomNumberGenerator rng(42);
+  std::size_t known = 0;
+  const std::size_t count = 10000;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const Eigen::Vector3d point(rng.uniformReal(-0.3, 0.3), rng.uniformReal(-0.3, 0.3), rng.uniformReal(-0.3, 0.3));
+    const kinematic_constraints::MeshRegionGrid::Cell cell = grid.classify(point);
+    if (cell == kinematic_constraints::MeshRegionGrid::UNKNOWN)
+      continue;
+    ++known;
+    EXPECT_EQ(cell == kinematic_constraints::MeshRegionGrid::INSIDE, body.containsPoint(pose * point))
+        << point.transpose();
+  }
+  // most points are decided by the grid alone
+  EXPECT_GT(known, count / 2);
+}
+
 TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsSimple)
 {
   moveit::core::RobotState robot_state(robot_model_);
@@ -789,6 +820,48 @@ TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsPR2)
   EXPECT_FALSE(vc.decide(robot_state, true).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsRayCasts)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+
+  // a sensor high above the robot, looking down through it
+  moveit_msgs::msg::VisibilityConstraint vcm;
+  vcm.sensor_pose.header.frame_id = "base_footprint";
+  vcm.sensor_pose.pose.position.z = 3.0;
+  vcm.sensor_pose.pose.orientation.y = 1.0;
+  vcm.sensor_pose.pose.orientation.w = 0.0;
+  vcm.target_pose.header.frame_id = "base_footprint";
+  vcm.target_pose.pose.position.z = -0.5;
+  vcm.target_pose.pose.orientation.w = 1.0;
+  vcm.target_radius = 0.1;
+  vcm.cone_sides = 10;
+  vcm.sensor_view_direction = moveit_msgs::msg::VisibilityConstraint::SENSOR_Z;
+  vcm.weight = 1.0;
+
+  kinematic_constraints::VisibilityConstraint cone(robot_model_);
+  kinematic_constraints::VisibilityConstraint rays(robot_model_);
+  rays.setUseRayCasts(true);
+  EXPECT_TRUE(cone.configure(vcm, tf));
+  EXPECT_TRUE(rays.configure(vcm, tf));
+  EXPECT_TRUE(rays.getUseRayCasts());
+
+  EXPECT_FALSE(cone.decide(robot_state).satisfied);
+  EXPECT_FALSE(rays.decide(robot_state).satisfied);
+  // evaluating again reuses the cached cone
+  EXPECT_FALSE(cone.decide(robot_state).satisfied);
+
+  // next to the robot, the view is clear
+  vcm.sensor_pose.pose.position.x = 5.0;
+  vcm.target_pose.pose.position.x = 5.0;
+  EXPECT_TRUE(cone.configure(vcm, tf));
+  EXPECT_TRUE(rays.configure(vcm, tf));
+  EXPECT_TRUE(cone.decide(robot_state).satisfied);
+  EXPECT_TRUE(rays.decide(robot_state).satisfied);
+}
+
 TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSet)
 {
   moveit::core::RobotState robot_state(robot_model_);
@@ -934,6 +1007,84 @@ TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetEquality)
   EXPECT_TRUE(kcs2.equal(kcs, .1));
 }
 
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetBatch)
+{
+  moveit::core::RobotState reference(robot_model_);
+  reference.setToDefaultValues();
+  reference.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+
+  moveit_msgs::msg::Constraints constraints;
+  constraints.joint_constraints.resize(2);
+  constraints.joint_constraints[0].joint_name = "r_elbow_flex_joint";
+  constraints.joint_constraints[0].position = reference.getVariablePosition("r_elbow_flex_joint");
+  constraints.joint_constraints[0].tolerance_above = 0.2;
+  constraints.joint_constraints[0].tolerance_below = 0.2;
+  constraints.joint_constraints[0].weight = 1.0;
+  // a continuous joint
+  constraints.joint_constraints[1] = constraints.joint_constraints[0];
+  constraints.joint_constraints[1].joint_name = "r_forearm_roll_joint";
+  constraints.joint_constraints[1].position = 3.0;
+  constraints.joint_constraints[1].tolerance_above = 0.5;
+
+  const Eigen::Isometry3d& wrist = reference.getGlobalLinkTransform("r_wrist_roll_link");
+  moveit_msgs::msg::PositionConstraint pcm;
+  pcm.header.frame_id = robot_model_->getModelFrame();
+  pcm.link_name = "r_wrist_roll_link";
+  pcm.target_point_offset.x = 0.1;
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::msg::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.push_back(0.15);
+  pcm.constraint_region.primitive_poses.push_back(tf2::toMsg(wrist));
+  pcm.weight = 1.0;
+  constraints.position_constraints.push_back(pcm);
+
+  moveit_msgs::msg::OrientationConstraint ocm;
+  ocm.header.frame_id = robot_model_->getModelFrame();
+  ocm.link_name = "r_wrist_roll_link";
+  ocm.orientation = tf2::toMsg(Eigen::Quaterniond(wrist.linear()));
+  ocm.absolute_x_axis_tolerance = 0.4;
+  ocm.absolute_y_axis_tolerance = 0.4;
+  ocm.absolute_z_axis_tolerance = 0.4;
+  ocm.weight = 1.0;
+  constraints.orientation_constraints.push_back(ocm);
+  ocm.parameterization = moveit_msgs::msg::OrientationConstraint::ROTATION_VECTOR;
+  constraints.orientation_constraints.push_back(ocm);
+  // a mobile frame is evaluated state by state
+  ocm.header.frame_id = "r_shoulder_pan_link";
+  ocm.orientation.w = 1.0;
+  ocm.orientation.x = ocm.orientation.y = ocm.orientation.z = 0.0;
+  ocm.absolute_x_axis_tolerance = ocm.absolute_y_axis_tolerance = ocm.absolute_z_axis_tolerance = M_PI;
+  constraints.orientation_constraints.push_back(ocm);
+
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+  EXPECT_TRUE(kcs.add(constraints, tf));
+
+  const std::size_t count = 50;
+  const moveit::core::JointModelGroup* group = robot_model_->getJointModelGroup("right_arm");
+  moveit::core::RobotStateBatch batch(robot_model_, count);
+  std::vector<moveit::core::RobotState> states(count, reference);
+  random_numbers::RandomNumberGenerator rng(42);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    states[i].setToRandomPositionsNearBy(group, reference, 0.3, rng);
+    states[i].update();
+    batch.setVariablePositions(i, states[i]);
+  }
+  batch.updateLinkTransforms();
+
+  kinematic_constraints::ConstraintBatchEvaluationResult results;
+  kcs.decide(batch, results);
+  ASSERT_EQ(results.satisfied.size(), count);
+  ASSERT_EQ(results.distance.size(), count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const kinematic_constraints::ConstraintEvaluationResult expected = kcs.decide(states[i]);
+    EXPECT_EQ(results.satisfied[i] != 0, expected.satisfied) << "state " << i;
+    EXPECT_NEAR(results.distance[i], expected.distance, 1e-9) << "state " << i;
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -326,6 +326,28 @@ public:
     return false;
   }
 
+  /**
+   * @brief Search for joint angles reaching each of many independent poses of the (single) tip frame.
+   * This is the batch version of searchPositionIK(), e.g. for sampling goals or reachability analysis, and saves the
+   * per-query overhead of calling the solver once for every pose. The default implementation simply loops over
+   * searchPositionIK(), plugins override it to share setup between the poses or to solve them concurrently.
+   * @param ik_poses the desired poses of the tip link
+   * @param ik_seed_states either a single seed state shared by all poses or one seed state per pose
+   * @param timeout The amount of time (in seconds) available to the solver for each pose
+   * @param solutions the solution vector for each pose, only valid if the matching error code is SUCCESS
+   * @param error_codes the error code for each pose
+   * @param solution_callback A callback to validate an IK solution, it is never called concurrently
+   * @param options container for other IK options. See definition of KinematicsQueryOptions for details.
+   * @return True if all poses were solved, false otherwise
+   */
+  virtual bool
+  searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                        const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                        std::vector<std::vector<double>>& solutions,
+                        std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                        const IKCallbackFn& solution_callback = IKCallbackFn(),
+                        const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
   /**
    * @brief Given a set of desired poses for a planning group with multiple end-effectors, search for the joint angles
    * required to reach them. This is useful for e.g. biped robots that need to perform whole-body IK.
@@ -506,6 +528,16 @@ public:
    */
   virtual bool supportsGroup(const moveit::core::JointModelGroup* jmg, std::string* error_text_out = nullptr) const;
 
+  /**
+   * \brief Check if the queries of this solver instance may be called concurrently from several threads.
+   *
+   * The default implementation returns false, callers then have to serialize all queries of an instance.
+   */
+  virtual bool supportsConcurrentQueries() const
+  {
+    return false;
+  }
+
   /**
    * @brief  Set the search discretization value for all the redundant joints
    */
@@ -649,6 +681,15 @@ protected:
                    const std::string& base_frame, const std::vector<std::string>& tip_frames,
                    double search_discretization);
 
+  /**
+   * @brief Check the arguments of searchPositionIKBatch() and size its outputs to the number of poses
+   * @return False, with an error logged, if ik_seed_states holds neither a single nor one seed state per pose
+   */
+  bool prepareBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                    const std::vector<std::vector<double>>& ik_seed_states,
+                    std::vector<std::vector<double>>& solutions,
+                    std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes) const;
+
 private:
   std::string removeSlash(const std::string& str) const;
 };
@@ -154,6 +154,44 @@ KinematicsBase::KinematicsBase() : default_timeout_(DEFAULT_TIMEOUT)
 
 KinematicsBase::~KinematicsBase() = default;
 
+bool KinematicsBase::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                           const std::vector<std::vector<double> >& ik_seed_states, double timeout,
+                                           std::vector<std::vector<double> >& solutions,
+                                           std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                           const IKCallbackFn& solution_callback,
+                                           const KinematicsQueryOptions& options) const
+{
+  if (!prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  bool all_solved = true;
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    const std::vector<double>& seed = ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i];
+    if (!searchPositionIK(ik_poses[i], seed, timeout, solutions[i], solution_callback, error_codes[i], options))
+      all_solved = false;
+  }
+  return all_solved;
+}
+
+bool KinematicsBase::prepareBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                  const std::vector<std::vector<double> >& ik_seed_states,
+                                  std::vector<std::vector<double> >& solutions,
+                                  std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes) const
+{
+  solutions.resize(ik_poses.size());
+  error_codes.resize(ik_poses.size());
+  if (ik_seed_states.size() != 1 && ik_seed_states.size() != ik_poses.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Batch IK requires a single seed state or one per pose, but %zu were given for %zu poses",
+                 ik_seed_states.size(), ik_poses.size());
+    for (moveit_msgs::msg::MoveItErrorCodes& error_code : error_codes)
+      error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return false;
+  }
+  return true;
+}
+
 bool KinematicsBase::getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
                                    const std::vector<double>& ik_seed_state,
                                    std::vector<std::vector<double> >& solutions, KinematicsResult& result,
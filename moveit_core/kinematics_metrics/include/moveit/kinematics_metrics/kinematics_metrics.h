@@ -43,6 +43,16 @@ namespace kinematics_metrics
 {
 MOVEIT_CLASS_FORWARD(KinematicsMetrics);  // Defines KinematicsMetricsPtr, ConstPtr, WeakPtr... etc
 
+/** \brief The manipulability measures of a group at one joint configuration */
+struct Manipulability
+{
+  /** \brief The manipulability index sqrt(det(JJ^T)), see KinematicsMetrics::getManipulabilityIndex() */
+  double index = 0.0;
+
+  /** \brief The ratio sigma_min/sigma_max of the singular values of J, see KinematicsMetrics::getManipulability() */
+  double condition_number = 0.0;
+};
+
 /**
  * \brief Compute different kinds of metrics for kinematics evaluation. Currently includes
  * manipulability.
@@ -124,6 +134,43 @@ public:
   bool getManipulability(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* joint_model_group,
                          double& condition_number, bool translation = false) const;
 
+  /**
+   * @brief Compute the Jacobians of a chain group at many joint configurations, with reference to the origin of the
+   * last link of the group.
+   * The configurations are distributed over several threads, each with its own copy of \e reference_state.
+   * @param reference_state The state that provides the positions of all joints that are not part of the group
+   * @param joint_model_group The chain group to compute the Jacobians for
+   * @param group_positions The joint positions of the group, one vector (in the order of the group variables) each
+   * @param jacobians The computed Jacobians, one per configuration
+   * @param thread_count The number of threads to use, 0 uses one thread per hardware core
+   * @return False if the group is not a chain
+   */
+  bool getJacobians(const moveit::core::RobotState& reference_state,
+                    const moveit::core::JointModelGroup* joint_model_group,
+                    const std::vector<std::vector<double>>& group_positions, std::vector<Eigen::MatrixXd>& jacobians,
+                    unsigned int thread_count = 0) const;
+
+  /**
+   * @brief Get the manipulability index and condition number of a chain group at many joint configurations, e.g. to
+   * rank grasp candidates. Both measures are computed from a single SVD of the Jacobian per configuration, and the
+   * configurations are distributed over several threads. The results equal those of getManipulabilityIndex() and
+   * getManipulability() up to rounding.
+   * @param reference_state The state that provides the positions of all joints that are not part of the group
+   * @param joint_model_group The chain group to compute the measures for
+   * @param group_positions The joint positions of the group, one vector (in the order of the group variables) each
+   * @param manipulabilities The computed measures, one per configuration
+   * @param translation Only consider the translation part of the Jacobian
+   * @param thread_count The number of threads to use, 0 uses one thread per hardware core
+   * @param tip_poses If not null, filled with the pose of the last link of the group in the model frame for every
+   * configuration
+   * @return False if the group is not a chain
+   */
+  bool getManipulabilities(const moveit::core::RobotState& reference_state,
+                           const moveit::core::JointModelGroup* joint_model_group,
+                           const std::vector<std::vector<double>>& group_positions,
+                           std::vector<Manipulability>& manipulabilities, bool translation = false,
+                           unsigned int thread_count = 0, std::vector<Eigen::Isometry3d>* tip_poses = nullptr) const;
+
   void setPenaltyMultiplier(double multiplier)
   {
     penalty_multiplier_ = fabs(multiplier);
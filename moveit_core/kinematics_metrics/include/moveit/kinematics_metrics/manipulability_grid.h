@@ -0,0 +1,117 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: A precomputed map of the manipulability of a group over the workspace */
+
+#pragma once
+
+#include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <cstdint>
+
+namespace kinematics_metrics
+{
+MOVEIT_CLASS_FORWARD(ManipulabilityGrid);  // Defines ManipulabilityGridPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief A precomputed map of the manipulability of a chain group over a box of the workspace.
+ * The box is divided into cubic cells. Every cell stores the best manipulability of the sampled joint configurations
+ * that place the origin of the last link of the group inside the cell, so that a query only indexes an array.
+ */
+class ManipulabilityGrid
+{
+public:
+  /**
+   * @brief Construct an empty grid
+   * @param min_corner The corner of the box with the smallest coordinates, in the model frame
+   * @param max_corner The corner of the box with the largest coordinates, in the model frame
+   * @param resolution The edge length of the cells
+   */
+  ManipulabilityGrid(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner, double resolution);
+
+  /**
+   * @brief Fill the grid from random joint configurations of a group. Can be called repeatedly to add more samples.
+   * @param metrics The metrics used to compute the manipulability, including its joint limits penalty
+   * @param reference_state The state that provides the positions of all joints that are not part of the group
+   * @param joint_model_group The chain group
+   * @param sample_count The number of random configurations to evaluate
+   * @param translation Only consider the translation part of the Jacobian
+   * @param seed The seed of the random configurations, the grid is the same for any number of threads
+   * @param thread_count The number of threads to use, 0 uses one thread per hardware core
+   * @return False if the group is not a chain
+   */
+  bool build(const KinematicsMetrics& metrics, const moveit::core::RobotState& reference_state,
+             const moveit::core::JointModelGroup* joint_model_group, std::size_t sample_count, bool translation = false,
+             std::uint32_t seed = 0, unsigned int thread_count = 0);
+
+  /**
+   * @brief Get the precomputed manipulability at a position
+   * @param position The position in the model frame
+   * @param manipulability The best manipulability of the cell that contains the position
+   * @return False if the position is outside of the grid or no sample reached its cell
+   */
+  bool getManipulability(const Eigen::Vector3d& position, Manipulability& manipulability) const;
+
+  /** \brief Remove all samples from the grid */
+  void clear();
+
+  const Eigen::Vector3d& getMinCorner() const
+  {
+    return min_corner_;
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief The number of cells along the x, y and z axes */
+  const Eigen::Vector3i& getSize() const
+  {
+    return size_;
+  }
+
+  /** \brief The number of cells that were reached by at least one sample */
+  std::size_t getReachedCellCount() const;
+
+private:
+  /** \brief Get the index of the cell that contains a position. Returns false if the position is outside the grid. */
+  bool getCellIndex(const Eigen::Vector3d& position, std::size_t& index) const;
+
+  Eigen::Vector3d min_corner_;
+  double resolution_;
+  Eigen::Vector3i size_;
+  std::vector<Manipulability> cells_;
+  std::vector<bool> reached_;
+};
+}  // namespace kinematics_metrics
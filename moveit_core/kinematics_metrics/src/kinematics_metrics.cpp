@@ -36,16 +36,68 @@
 
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <math.h>
 #include <moveit/kinematics_metrics/kinematics_metrics.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <thread>
 
 namespace kinematics_metrics
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_kinematics_metrics.kinematics_metrics");
 
+namespace
+{
+// Call compute(state, i, workspace) for every configuration i, with the configurations distributed over several
+// threads. Every thread works on its own copy of reference_state, with the group positions of configuration i set,
+// and on its own workspace, which it reuses for all of its configurations.
+template <typename Workspace, typename ComputeFn>
+void forEachConfiguration(const moveit::core::RobotState& reference_state,
+                          const moveit::core::JointModelGroup* joint_model_group,
+                          const std::vector<std::vector<double>>& group_positions, unsigned int thread_count,
+                          const ComputeFn& compute)
+{
+  if (group_positions.empty())
+    return;
+
+  std::atomic<std::size_t> next_configuration{ 0 };
+  const auto work = [&]() {
+    moveit::core::RobotState state(reference_state);
+    Workspace workspace;
+    for (std::size_t i = next_configuration++; i < group_positions.size(); i = next_configuration++)
+    {
+      state.setJointGroupPositions(joint_model_group, group_positions[i]);
+      state.updateLinkTransforms();
+      compute(static_cast<const moveit::core::RobotState&>(state), i, workspace);
+    }
+  };
+
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t worker_count = std::min<std::size_t>(thread_count, group_positions.size()) - 1;
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (std::size_t t = 0; t < worker_count; ++t)
+    workers.emplace_back(work);
+  work();
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+struct NoWorkspace
+{
+};
+
+struct ManipulabilityWorkspace
+{
+  Eigen::MatrixXd jacobian;
+  Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver;
+};
+}  // namespace
+
 double KinematicsMetrics::getJointLimitsPenalty(const moveit::core::RobotState& state,
                                                 const moveit::core::JointModelGroup* joint_model_group) const
 {
@@ -255,4 +307,68 @@ bool KinematicsMetrics::getManipulability(const moveit::core::RobotState& state,
   return true;
 }
 
+bool KinematicsMetrics::getJacobians(const moveit::core::RobotState& reference_state,
+                                     const moveit::core::JointModelGroup* joint_model_group,
+                                     const std::vector<std::vector<double>>& group_positions,
+                                     std::vector<Eigen::MatrixXd>& jacobians, unsigned int thread_count) const
+{
+  // state.getJacobian() only works for chain groups.
+  if (!joint_model_group->isChain())
+  {
+    return false;
+  }
+
+  jacobians.resize(group_positions.size());
+  const moveit::core::LinkModel* tip = joint_model_group->getLinkModels().back();
+  std::atomic<bool> failed{ false };
+  forEachConfiguration<NoWorkspace>(
+      reference_state, joint_model_group, group_positions, thread_count,
+      [&](const moveit::core::RobotState& state, std::size_t i, NoWorkspace& /* unused */) {
+        if (!state.getJacobian(joint_model_group, tip, Eigen::Vector3d::Zero(), jacobians[i]))
+          failed = true;
+      });
+  return !failed;
+}
+
+bool KinematicsMetrics::getManipulabilities(const moveit::core::RobotState& reference_state,
+                                            const moveit::core::JointModelGroup* joint_model_group,
+                                            const std::vector<std::vector<double>>& group_positions,
+                                            std::vector<Manipulability>& manipulabilities, bool translation,
+                                            unsigned int thread_count, std::vector<Eigen::Isometry3d>* tip_poses) const
+{
+  // state.getJacobian() only works for chain groups.
+  if (!joint_model_group->isChain())
+  {
+    return false;
+  }
+
+  manipulabilities.resize(group_positions.size());
+  if (tip_poses)
+    tip_poses->resize(group_positions.size());
+  const moveit::core::LinkModel* tip = joint_model_group->getLinkModels().back();
+  std::atomic<bool> failed{ false };
+  forEachConfiguration<ManipulabilityWorkspace>(
+      reference_state, joint_model_group, group_positions, thread_count,
+      [&](const moveit::core::RobotState& state, std::size_t i, ManipulabilityWorkspace& workspace) {
+        if (!state.getJacobian(joint_model_group, tip, Eigen::Vector3d::Zero(), workspace.jacobian))
+        {
+          failed = true;
+          return;
+        }
+        if (translation)
+          workspace.svdsolver.compute(workspace.jacobian.topRows(3));
+        else
+          workspace.svdsolver.compute(workspace.jacobian);
+
+        // The product of the singular values equals sqrt(det(JJ^T)) if J has at least as many columns as rows
+        const Eigen::VectorXd& singular_values = workspace.svdsolver.singularValues();
+        const double penalty = getJointLimitsPenalty(state, joint_model_group);
+        manipulabilities[i].index = penalty * singular_values.prod();
+        manipulabilities[i].condition_number = penalty * singular_values.minCoeff() / singular_values.maxCoeff();
+        if (tip_poses)
+          (*tip_poses)[i] = state.getGlobalLinkTransform(tip);
+      });
+  return !failed;
+}
+
 }  // end of namespace kinematics_metrics
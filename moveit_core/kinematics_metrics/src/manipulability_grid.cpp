@@ -0,0 +1,126 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: A precomputed map of the manipulability of a group over the workspace */
+
+#include <moveit/kinematics_metrics/manipulability_grid.h>
+#include <random_numbers/random_numbers.h>
+#include <algorithm>
+#include <cmath>
+
+namespace kinematics_metrics
+{
+namespace
+{
+// Bound the memory used for the sampled configurations when many samples are requested
+constexpr std::size_t MAX_BATCH_SIZE = 10000;
+}  // namespace
+
+ManipulabilityGrid::ManipulabilityGrid(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner,
+                                       double resolution)
+  : min_corner_(min_corner), resolution_(resolution)
+{
+  for (int i = 0; i < 3; ++i)
+    size_[i] = std::max(1, static_cast<int>(std::ceil((max_corner[i] - min_corner[i]) / resolution_)));
+  const std::size_t cell_count = static_cast<std::size_t>(size_.x()) * size_.y() * size_.z();
+  cells_.resize(cell_count);
+  reached_.resize(cell_count, false);
+}
+
+bool ManipulabilityGrid::build(const KinematicsMetrics& metrics, const moveit::core::RobotState& reference_state,
+                               const moveit::core::JointModelGroup* joint_model_group, std::size_t sample_count,
+                               bool translation, std::uint32_t seed, unsigned int thread_count)
+{
+  if (!joint_model_group->isChain())
+    return false;
+
+  random_numbers::RandomNumberGenerator rng(seed);
+  std::vector<std::vector<double>> group_positions;
+  std::vector<Manipulability> manipulabilities;
+  std::vector<Eigen::Isometry3d> tip_poses;
+  for (std::size_t done = 0; done < sample_count;)
+  {
+    // The configurations are sampled sequentially, so that they do not depend on the number of threads
+    group_positions.resize(std::min(MAX_BATCH_SIZE, sample_count - done));
+    for (std::vector<double>& positions : group_positions)
+      joint_model_group->getVariableRandomPositions(rng, positions);
+
+    if (!metrics.getManipulabilities(reference_state, joint_model_group, group_positions, manipulabilities,
+                                     translation, thread_count, &tip_poses))
+      return false;
+
+    for (std::size_t i = 0; i < group_positions.size(); ++i)
+    {
+      std::size_t index;
+      if (!getCellIndex(tip_poses[i].translation(), index))
+        continue;
+      if (!reached_[index] || manipulabilities[i].index > cells_[index].index)
+        cells_[index] = manipulabilities[i];
+      reached_[index] = true;
+    }
+    done += group_positions.size();
+  }
+  return true;
+}
+
+bool ManipulabilityGrid::getManipulability(const Eigen::Vector3d& position, Manipulability& manipulability) const
+{
+  std::size_t index;
+  if (!getCellIndex(position, index) || !reached_[index])
+    return false;
+  manipulability = cells_[index];
+  return true;
+}
+
+void ManipulabilityGrid::clear()
+{
+  std::fill(cells_.begin(), cells_.end(), Manipulability());
+  std::fill(reached_.begin(), reached_.end(), false);
+}
+
+std::size_t ManipulabilityGrid::getReachedCellCount() const
+{
+  return static_cast<std::size_t>(std::count(reached_.begin(), reached_.end(), true));
+}
+
+bool ManipulabilityGrid::getCellIndex(const Eigen::Vector3d& position, std::size_t& index) const
+{
+  const Eigen::Vector3d cell = ((position - min_corner_) / resolution_).array().floor();
+  if (!cell.allFinite() || (cell.array() < 0.0).any() || (cell.array() >= size_.cast<double>().array()).any())
+    return false;
+  index = (static_cast<std::size_t>(cell.z()) * size_.y() + static_cast<std::size_t>(cell.y())) * size_.x() +
+          static_cast<std::size_t>(cell.x());
+  return true;
+}
+}  // namespace kinematics_metrics
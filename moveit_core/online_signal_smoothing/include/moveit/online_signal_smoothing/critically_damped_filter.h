@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: A critically damped low-pass filter of higher order, built as a cascade of first-order Butterworth
+   filters. Like the first-order filter it does not overshoot, but it suppresses high-frequency noise more strongly.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+
+// Auto-generated
+#include <moveit_critically_damped_filter_parameters.hpp>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/online_signal_smoothing/butterworth_filter.h>
+#include <moveit/online_signal_smoothing/smoothing_base_class.h>
+
+namespace online_signal_smoothing
+{
+/**
+ * Class CriticallyDampedFilter - Low-pass filter of several signals, built as a cascade of identical first-order
+ * Butterworth filters. All poles of the cascade are real and equal, so the filter is critically damped: its step
+ * response does not overshoot, while the attenuation above the cutoff frequency grows with the order of the filter.
+ * The coefficient of the stages is chosen such that the cascade has the same cutoff frequency as a first-order filter
+ * with the given coefficient, see computeStageCoefficient().
+ */
+class CriticallyDampedFilter
+{
+public:
+  /**
+   * Constructor.
+   * @param low_pass_filter_coeff Coefficient of the first-order filter with the same cutoff frequency,
+   * see ButterworthFilter. Larger filter_coeff-> more smoothing of commands, but more lag.
+   * @param order Number of first-order stages
+   * @param num_channels Number of signals that are filtered
+   * @throws std::length_error if the order is 0 or the coefficient of the stages is < 1
+   */
+  CriticallyDampedFilter(double low_pass_filter_coeff, std::size_t order, std::size_t num_channels);
+  CriticallyDampedFilter() = delete;
+
+  /**
+   * Filter a new measurement of every channel in place
+   * @param measurements One measurement per channel, replaced by the filtered values
+   */
+  void filter(Eigen::Ref<Eigen::ArrayXd> measurements);
+
+  /**
+   * Reset the filter states of all channels to steady values
+   * @param data One value per channel
+   */
+  void reset(const Eigen::Ref<const Eigen::ArrayXd>& data);
+
+  std::size_t getNumChannels() const
+  {
+    return stages_.front().getNumChannels();
+  }
+
+  /**
+   * Compute the coefficient of the stages of a cascade of \e order first-order filters that has the cutoff frequency
+   * of a single first-order filter with \e low_pass_filter_coeff.
+   * The coefficient is 1 / tan(omega_d * T / 2), so a cascade of n stages with gain 1/sqrt(2) at the cutoff frequency
+   * needs stages with the coefficient low_pass_filter_coeff * sqrt(2^(1/n) - 1).
+   */
+  static double computeStageCoefficient(double low_pass_filter_coeff, std::size_t order);
+
+private:
+  std::vector<MultiChannelButterworthFilter> stages_;
+};
+
+// Plugin
+class CriticallyDampedFilterPlugin : public SmoothingBaseClass
+{
+public:
+  /**
+   * Initialize the smoothing algorithm
+   * @param node ROS node, used for parameter retrieval
+   * @param robot_model typically used to retrieve vel/accel/jerk limits
+   * @param num_joints number of actuated joints in the JointGroup Servo controls
+   * @return True if initialization was successful
+   */
+  bool initialize(rclcpp::Node::SharedPtr node, moveit::core::RobotModelConstPtr robot_model,
+                  size_t num_joints) override;
+
+  /**
+   * Smooth the command signals for all DOF
+   * @param position_vector array of joint position commands
+   * @return True if initialization was successful
+   */
+  bool doSmoothing(std::vector<double>& position_vector) override;
+
+  /**
+   * Reset to a given joint state
+   * @param joint_positions reset the filters to these joint positions
+   * @return True if reset was successful
+   */
+  bool reset(const std::vector<double>& joint_positions) override;
+
+private:
+  rclcpp::Node::SharedPtr node_;
+  std::unique_ptr<CriticallyDampedFilter> position_filter_;
+};
+}  // namespace online_signal_smoothing
@@ -45,22 +45,14 @@ namespace online_signal_smoothing
 namespace
 {
 constexpr double EPSILON = 1e-9;
-}
 
-ButterworthFilter::ButterworthFilter(double low_pass_filter_coeff)
-  : previous_measurements_{ 0., 0. }
-  , previous_filtered_measurement_(0.)
-  , scale_term_(1. / (1. + low_pass_filter_coeff))
-  , feedback_term_(1. - low_pass_filter_coeff)
+// Throw if the filter described by the coefficient and the terms calculated from it is unstable or degenerate
+void checkFilterTerms(double low_pass_filter_coeff, double scale_term, double feedback_term)
 {
-  // guarantee this doesn't change because the logic below depends on this length implicitly
-  static_assert(ButterworthFilter::FILTER_LENGTH == 2,
-                "online_signal_smoothing::ButterworthFilter::FILTER_LENGTH should be 2");
-
-  if (std::isinf(feedback_term_))
+  if (std::isinf(feedback_term))
     throw std::length_error("online_signal_smoothing::ButterworthFilter: infinite feedback_term_");
 
-  if (std::isinf(scale_term_))
+  if (std::isinf(scale_term))
     throw std::length_error("online_signal_smoothing::ButterworthFilter: infinite scale_term_");
 
   if (low_pass_filter_coeff < 1)
@@ -69,12 +61,26 @@ ButterworthFilter::ButterworthFilter(double low_pass_filter_coeff)
         "online_signal_smoothing::ButterworthFilter: Filter coefficient < 1. makes the lowpass filter unstable");
   }
 
-  if (std::abs(feedback_term_) < EPSILON)
+  if (std::abs(feedback_term) < EPSILON)
   {
     throw std::length_error(
         "online_signal_smoothing::ButterworthFilter: Filter coefficient value resulted in feedback term of 0");
   }
 }
+}  // namespace
+
+ButterworthFilter::ButterworthFilter(double low_pass_filter_coeff)
+  : previous_measurements_{ 0., 0. }
+  , previous_filtered_measurement_(0.)
+  , scale_term_(1. / (1. + low_pass_filter_coeff))
+  , feedback_term_(1. - low_pass_filter_coeff)
+{
+  // guarantee this doesn't change because the logic below depends on this length implicitly
+  static_assert(ButterworthFilter::FILTER_LENGTH == 2,
+                "online_signal_smoothing::ButterworthFilter::FILTER_LENGTH should be 2");
+
+  checkFilterTerms(low_pass_filter_coeff, scale_term_, feedback_term_);
+}
 
 double ButterworthFilter::filter(double new_measurement)
 {
@@ -95,6 +101,30 @@ void ButterworthFilter::reset(const double data)
   previous_filtered_measurement_ = data;
 }
 
+MultiChannelButterworthFilter::MultiChannelButterworthFilter(double low_pass_filter_coeff, std::size_t num_channels)
+  : previous_measurements_(Eigen::ArrayXd::Zero(num_channels))
+  , previous_filtered_measurements_(Eigen::ArrayXd::Zero(num_channels))
+  , scale_term_(1. / (1. + low_pass_filter_coeff))
+  , feedback_term_(1. - low_pass_filter_coeff)
+{
+  checkFilterTerms(low_pass_filter_coeff, scale_term_, feedback_term_);
+}
+
+void MultiChannelButterworthFilter::filter(Eigen::Ref<Eigen::ArrayXd> measurements)
+{
+  // Same operations in the same order as ButterworthFilter::filter(), for all channels at once
+  previous_filtered_measurements_ =
+      scale_term_ * (previous_measurements_ + measurements - feedback_term_ * previous_filtered_measurements_);
+  previous_measurements_ = measurements;
+  measurements = previous_filtered_measurements_;
+}
+
+void MultiChannelButterworthFilter::reset(const Eigen::Ref<const Eigen::ArrayXd>& data)
+{
+  previous_measurements_ = data;
+  previous_filtered_measurements_ = data;
+}
+
 bool ButterworthFilterPlugin::initialize(rclcpp::Node::SharedPtr node, moveit::core::RobotModelConstPtr /* unused */,
                                          size_t num_joints)
 {
@@ -104,16 +134,13 @@ bool ButterworthFilterPlugin::initialize(rclcpp::Node::SharedPtr node, moveit::c
   online_signal_smoothing::ParamListener param_listener(node_);
   double filter_coeff = param_listener.get_params().butterworth_filter_coeff;
 
-  for (std::size_t i = 0; i < num_joints_; ++i)
-  {
-    position_filters_.emplace_back(filter_coeff);
-  }
+  position_filter_ = std::make_unique<MultiChannelButterworthFilter>(filter_coeff, num_joints_);
   return true;
 };
 
 bool ButterworthFilterPlugin::doSmoothing(std::vector<double>& position_vector)
 {
-  if (position_vector.size() != position_filters_.size())
+  if (!position_filter_ || position_vector.size() != position_filter_->getNumChannels())
   {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -122,17 +149,14 @@ bool ButterworthFilterPlugin::doSmoothing(std::vector<double>& position_vector)
 #pragma GCC diagnostic pop
     return false;
   }
-  for (size_t i = 0; i < position_vector.size(); ++i)
-  {
-    // Lowpass filter the position command
-    position_vector[i] = position_filters_.at(i).filter(position_vector[i]);
-  }
+  // Lowpass filter the position commands of all joints at once
+  position_filter_->filter(Eigen::Map<Eigen::ArrayXd>(position_vector.data(), position_vector.size()));
   return true;
 };
 
 bool ButterworthFilterPlugin::reset(const std::vector<double>& joint_positions)
 {
-  if (joint_positions.size() != position_filters_.size())
+  if (!position_filter_ || joint_positions.size() != position_filter_->getNumChannels())
   {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -141,10 +165,7 @@ bool ButterworthFilterPlugin::reset(const std::vector<double>& joint_positions)
 #pragma GCC diagnostic pop
     return false;
   }
-  for (size_t joint_idx = 0; joint_idx < joint_positions.size(); ++joint_idx)
-  {
-    position_filters_.at(joint_idx).reset(joint_positions.at(joint_idx));
-  }
+  position_filter_->reset(Eigen::Map<const Eigen::ArrayXd>(joint_positions.data(), joint_positions.size()));
   return true;
 };
 
@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: A critically damped low-pass filter of higher order, built as a cascade of first-order Butterworth
+   filters.
+ */
+
+#include <moveit/online_signal_smoothing/critically_damped_filter.h>
+#include <rclcpp/clock.hpp>
+#include <rclcpp/logging.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace online_signal_smoothing
+{
+CriticallyDampedFilter::CriticallyDampedFilter(double low_pass_filter_coeff, std::size_t order,
+                                               std::size_t num_channels)
+{
+  if (order == 0)
+    throw std::length_error("online_signal_smoothing::CriticallyDampedFilter: The filter order must be at least 1");
+
+  const double stage_coeff = computeStageCoefficient(low_pass_filter_coeff, order);
+  if (stage_coeff < 1)
+  {
+    throw std::length_error("online_signal_smoothing::CriticallyDampedFilter: Filter coefficient " +
+                            std::to_string(low_pass_filter_coeff) + " is too small for order " +
+                            std::to_string(order) + ", the coefficient of the stages would be < 1.");
+  }
+  stages_.reserve(order);
+  for (std::size_t i = 0; i < order; ++i)
+  {
+    stages_.emplace_back(stage_coeff, num_channels);
+  }
+}
+
+double CriticallyDampedFilter::computeStageCoefficient(double low_pass_filter_coeff, std::size_t order)
+{
+  return low_pass_filter_coeff * std::sqrt(std::pow(2.0, 1.0 / static_cast<double>(order)) - 1.0);
+}
+
+void CriticallyDampedFilter::filter(Eigen::Ref<Eigen::ArrayXd> measurements)
+{
+  for (MultiChannelButterworthFilter& stage : stages_)
+  {
+    stage.filter(measurements);
+  }
+}
+
+void CriticallyDampedFilter::reset(const Eigen::Ref<const Eigen::ArrayXd>& data)
+{
+  for (MultiChannelButterworthFilter& stage : stages_)
+  {
+    stage.reset(data);
+  }
+}
+
+bool CriticallyDampedFilterPlugin::initialize(rclcpp::Node::SharedPtr node,
+                                              moveit::core::RobotModelConstPtr /* unused */, size_t num_joints)
+{
+  node_ = node;
+
+  critically_damped_filter::ParamListener param_listener(node_);
+  const auto params = param_listener.get_params();
+  try
+  {
+    position_filter_ = std::make_unique<CriticallyDampedFilter>(
+        params.critically_damped_filter_coeff, params.critically_damped_filter_order, num_joints);
+  }
+  catch (const std::length_error& e)
+  {
+    RCLCPP_ERROR(node_->get_logger(), "%s", e.what());
+    return false;
+  }
+  return true;
+}
+
+bool CriticallyDampedFilterPlugin::doSmoothing(std::vector<double>& position_vector)
+{
+  if (!position_filter_ || position_vector.size() != position_filter_->getNumChannels())
+  {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    RCLCPP_ERROR_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                          "Position vector to be smoothed does not have the right length.");
+#pragma GCC diagnostic pop
+    return false;
+  }
+  position_filter_->filter(Eigen::Map<Eigen::ArrayXd>(position_vector.data(), position_vector.size()));
+  return true;
+}
+
+bool CriticallyDampedFilterPlugin::reset(const std::vector<double>& joint_positions)
+{
+  if (!position_filter_ || joint_positions.size() != position_filter_->getNumChannels())
+  {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    RCLCPP_ERROR_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                          "Position vector to be reset does not have the right length.");
+#pragma GCC diagnostic pop
+    return false;
+  }
+  position_filter_->reset(Eigen::Map<const Eigen::ArrayXd>(joint_positions.data(), joint_positions.size()));
+  return true;
+}
+}  // namespace online_signal_smoothing
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(online_signal_smoothing::CriticallyDampedFilterPlugin,
+                       online_signal_smoothing::SmoothingBaseClass)
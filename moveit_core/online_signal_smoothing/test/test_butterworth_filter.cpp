@@ -42,6 +42,9 @@
 #include <gtest/gtest.h>
 #include <moveit/online_signal_smoothing/butterworth_filter.h>
 
+#include <cmath>
+#include <vector>
+
 TEST(SMOOTHING_PLUGINS, FilterConverge)
 {
   online_signal_smoothing::ButterworthFilter lpf(2.0);
@@ -71,3 +74,30 @@ TEST(SMOOTHING_PLUGINS, FilterReset)
   // Then check that a different measurement changes the value
   EXPECT_NE(5.0, lpf.filter(100.0));
 }
+
+TEST(SMOOTHING_PLUGINS, MultiChannelFilterMatchesScalarFilters)
+{
+  constexpr std::size_t num_channels = 7;
+  online_signal_smoothing::MultiChannelButterworthFilter multi_channel_lpf(2.0, num_channels);
+  std::vector<online_signal_smoothing::ButterworthFilter> lpfs(num_channels,
+                                                              online_signal_smoothing::ButterworthFilter(2.0));
+
+  Eigen::ArrayXd reset_values = Eigen::ArrayXd::LinSpaced(num_channels, -1.0, 1.0);
+  multi_channel_lpf.reset(reset_values);
+  for (std::size_t j = 0; j < num_channels; ++j)
+  {
+    lpfs[j].reset(reset_values[j]);
+  }
+
+  for (std::size_t i = 0; i < 50; ++i)
+  {
+    Eigen::ArrayXd measurements = Eigen::ArrayXd::LinSpaced(num_channels, 0.0, 3.0) * std::sin(0.3 * i);
+    Eigen::ArrayXd filtered = measurements;
+    multi_channel_lpf.filter(filtered);
+    for (std::size_t j = 0; j < num_channels; ++j)
+    {
+      // Check that every channel is filtered exactly like an independent filter
+      EXPECT_EQ(lpfs[j].filter(measurements[j]), filtered[j]);
+    }
+  }
+}
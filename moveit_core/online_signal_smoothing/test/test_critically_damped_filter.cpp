@@ -0,0 +1,126 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: Unit test for online_signal_smoothing::CriticallyDampedFilter
+ */
+
+#include <gtest/gtest.h>
+#include <moveit/online_signal_smoothing/critically_damped_filter.h>
+
+#include <cmath>
+#include <stdexcept>
+
+using online_signal_smoothing::ButterworthFilter;
+using online_signal_smoothing::CriticallyDampedFilter;
+
+TEST(CriticallyDampedFilter, FirstOrderMatchesButterworthFilter)
+{
+  CriticallyDampedFilter cdf(2.0, 1, 1);
+  ButterworthFilter lpf(2.0);
+  EXPECT_DOUBLE_EQ(2.0, CriticallyDampedFilter::computeStageCoefficient(2.0, 1));
+
+  Eigen::ArrayXd value(1);
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    value[0] = std::cos(0.5 * i);
+    const double expected = lpf.filter(value[0]);
+    cdf.filter(value);
+    EXPECT_DOUBLE_EQ(expected, value[0]);
+  }
+}
+
+TEST(CriticallyDampedFilter, StepResponseDoesNotOvershoot)
+{
+  for (std::size_t order = 1; order <= 4; ++order)
+  {
+    CriticallyDampedFilter cdf(8.0, order, 3);
+    Eigen::ArrayXd previous = Eigen::ArrayXd::Zero(3);
+    for (std::size_t i = 0; i < 500; ++i)
+    {
+      Eigen::ArrayXd value = Eigen::ArrayXd::Constant(3, 5.0);
+      cdf.filter(value);
+      // The response rises monotonically towards the step without exceeding it
+      EXPECT_TRUE((value <= 5.0 + 1e-12).all()) << "order " << order << ", sample " << i;
+      EXPECT_TRUE((value >= previous - 1e-12).all()) << "order " << order << ", sample " << i;
+      previous = value;
+    }
+    // Check that the filter converges to the step
+    EXPECT_NEAR(5.0, previous[0], 1e-9);
+  }
+}
+
+TEST(CriticallyDampedFilter, HigherOrderAttenuatesNoiseMore)
+{
+  CriticallyDampedFilter first_order(4.0, 1, 1);
+  CriticallyDampedFilter third_order(4.0, 3, 1);
+
+  // Feed a signal alternating at the Nyquist frequency and compare the residual amplitudes
+  double first_order_amplitude = 0.0;
+  double third_order_amplitude = 0.0;
+  for (std::size_t i = 0; i < 200; ++i)
+  {
+    Eigen::ArrayXd first(1), third(1);
+    first[0] = third[0] = (i % 2 == 0) ? 1.0 : -1.0;
+    first_order.filter(first);
+    third_order.filter(third);
+    if (i >= 100)
+    {
+      first_order_amplitude = std::max(first_order_amplitude, std::abs(first[0]));
+      third_order_amplitude = std::max(third_order_amplitude, std::abs(third[0]));
+    }
+  }
+  EXPECT_LT(third_order_amplitude, first_order_amplitude);
+}
+
+TEST(CriticallyDampedFilter, FilterReset)
+{
+  CriticallyDampedFilter cdf(4.0, 3, 2);
+  Eigen::ArrayXd data(2);
+  data << 5.0, -2.0;
+  cdf.reset(data);
+  Eigen::ArrayXd value = data;
+  cdf.filter(value);
+
+  // Check that all stages were properly set to the desired values
+  EXPECT_DOUBLE_EQ(5.0, value[0]);
+  EXPECT_DOUBLE_EQ(-2.0, value[1]);
+}
+
+TEST(CriticallyDampedFilter, InvalidParametersThrow)
+{
+  // The stages of an 8th-order filter with coefficient 2 would have a coefficient < 1
+  EXPECT_THROW(CriticallyDampedFilter(2.0, 8, 1), std::length_error);
+  EXPECT_THROW(CriticallyDampedFilter(4.0, 0, 1), std::length_error);
+  EXPECT_NO_THROW(CriticallyDampedFilter(8.0, 8, 1));
+}
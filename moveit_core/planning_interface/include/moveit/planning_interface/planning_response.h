@@ -64,6 +64,9 @@ struct MotionPlanResponse
   /// The full starting state used for planning
   moveit_msgs::msg::RobotState start_state;
   std::string planner_id;
+  /// Wall time in seconds spent in each stage of the planning pipeline, as (stage description, time) pairs.
+  /// The time of a planning request adapter excludes the time of the adapters and the planner it wraps.
+  std::vector<std::pair<std::string, double>> stage_times;
 
   // \brief Enable checking of query success or failure, for example if(response) ...
   explicit operator bool() const
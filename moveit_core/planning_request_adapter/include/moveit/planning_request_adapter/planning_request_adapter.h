@@ -40,6 +40,7 @@
 #include <moveit/planning_interface/planning_interface.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <functional>
+#include <optional>
 #include <rclcpp/logging.hpp>
 #include <rclcpp/node.hpp>
 
@@ -48,6 +49,67 @@ namespace planning_request_adapter
 {
 MOVEIT_CLASS_FORWARD(PlanningRequestAdapter);  // Defines PlanningRequestAdapterPtr, ConstPtr, WeakPtr... etc
 
+/** @brief The start state of a motion plan request and the results of checks on it, shared by the adapters of a
+ * PlanningRequestAdapterChain so that the start state is converted and checked only once.
+ *
+ * The results belong to the start state, group and path constraints of the request they were computed for, and are
+ * recomputed as soon as they are asked for with a request that differs in any of these, e.g. after an adapter fixed
+ * the start state. They also assume that the planning scene does not change while the context is used.
+ */
+class PlanningRequestContext
+{
+public:
+  /// \brief Checks of the start state that can be computed before the adapters ask for them
+  enum StartStateCheck : unsigned int
+  {
+    NO_CHECKS = 0,
+    COLLISION = 1 << 0,        ///< isStartStateColliding()
+    VALIDITY = 1 << 1,         ///< isStartStateValid()
+    PATH_CONSTRAINTS = 1 << 2  ///< isStartStateValidWithPathConstraints()
+  };
+
+  /** \brief Get the start state of a request
+   *  @param planning_scene The scene whose current state is completed by the start state of \e req
+   *  @param req Motion planning request
+   *  @return The start state, with updated transforms */
+  const moveit::core::RobotState& getStartState(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                const planning_interface::MotionPlanRequest& req);
+
+  /** \brief Check whether the start state of \e req collides, for the group of \e req */
+  bool isStartStateColliding(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                             const planning_interface::MotionPlanRequest& req);
+
+  /** \brief Check whether the start state of \e req is valid for the group of \e req, ignoring path constraints */
+  bool isStartStateValid(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                         const planning_interface::MotionPlanRequest& req);
+
+  /** \brief Check whether the start state of \e req is valid for the group and the path constraints of \e req */
+  bool isStartStateValidWithPathConstraints(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                            const planning_interface::MotionPlanRequest& req);
+
+  /** \brief Compute several checks of the start state of \e req concurrently
+   *  @param checks Combination of StartStateCheck values */
+  void prefetch(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                const planning_interface::MotionPlanRequest& req, unsigned int checks);
+
+  /** \brief Forget the start state and all results */
+  void clear();
+
+private:
+  /** \brief Make the cached results belong to \e req, dropping them if they were computed for another request */
+  void update(const planning_scene::PlanningSceneConstPtr& planning_scene,
+              const planning_interface::MotionPlanRequest& req);
+
+  const planning_scene::PlanningScene* planning_scene_ = nullptr;
+  moveit_msgs::msg::RobotState start_state_msg_;
+  std::string group_name_;
+  moveit_msgs::msg::Constraints path_constraints_;
+  std::optional<moveit::core::RobotState> start_state_;
+  std::optional<bool> colliding_;
+  std::optional<bool> valid_;
+  std::optional<bool> valid_with_path_constraints_;
+};
+
 /** @brief Concept in MoveIt which can be used to modify the planning problem and resulting trajectory (pre-processing
  * and/or post-processing) for a motion planner. PlanningRequestAdapter enable using multiple motion planning and
  * trajectory generation algorithms in sequence to produce robust motion plans.
@@ -127,7 +189,19 @@ public:
                             planning_interface::MotionPlanResponse& res,
                             std::vector<std::size_t>& added_path_index) const = 0;
 
+  /** \brief Get the checks of the start state this adapter asks the request context for
+   *  @return Combination of PlanningRequestContext::StartStateCheck values, which a PlanningRequestAdapterChain
+   *  computes concurrently before it runs the adapters */
+  virtual unsigned int getStartStateChecks() const
+  {
+    return PlanningRequestContext::NO_CHECKS;
+  }
+
 protected:
+  /** \brief Get the request context shared by the adapters of the chain that is running on this thread. Outside of
+   *  a chain, the returned context holds no results. */
+  static PlanningRequestContext& getRequestContext();
+
   /** \brief Helper param for getting a parameter using a namespace **/
   template <typename T>
   T getParam(const rclcpp::Node::SharedPtr& node, const rclcpp::Logger& logger, const std::string& parameter_namespace,
@@ -35,10 +35,13 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/robot_state/conversions.h>
 #include <moveit/utils/moveit_error_code.h>
 #include <rclcpp/logger.hpp>
 #include <functional>
 #include <algorithm>
+#include <chrono>
+#include <future>
 
 namespace planning_request_adapter
 {
@@ -46,6 +49,37 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.planning_request
 
 namespace
 {
+// the context of the chain running on this thread
+thread_local PlanningRequestContext* current_request_context = nullptr;
+
+// Makes a context the current one of this thread for the lifetime of this object
+class RequestContextScope
+{
+public:
+  RequestContextScope(PlanningRequestContext& context) : previous_(current_request_context)
+  {
+    current_request_context = &context;
+  }
+
+  ~RequestContextScope()
+  {
+    current_request_context = previous_;
+  }
+
+private:
+  PlanningRequestContext* previous_;
+};
+
+bool isStateColliding(const planning_scene::PlanningScene& planning_scene,
+                      const planning_interface::MotionPlanRequest& req, const moveit::core::RobotState& state)
+{
+  collision_detection::CollisionRequest creq;
+  creq.group_name = req.group_name;
+  collision_detection::CollisionResult cres;
+  planning_scene.checkCollision(creq, cres, state);
+  return cres.collision;
+}
+
 bool callPlannerInterfaceSolve(const planning_interface::PlannerManager& planner,
                                const planning_scene::PlanningSceneConstPtr& planning_scene,
                                const planning_interface::MotionPlanRequest& req,
@@ -84,6 +118,115 @@ bool callAdapter(const PlanningRequestAdapter& adapter, const PlanningRequestAda
 
 }  // namespace
 
+void PlanningRequestContext::update(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                    const planning_interface::MotionPlanRequest& req)
+{
+  if (start_state_ && planning_scene_ == planning_scene.get() && start_state_msg_ == req.start_state &&
+      group_name_ == req.group_name)
+  {
+    if (valid_with_path_constraints_ && path_constraints_ != req.path_constraints)
+      valid_with_path_constraints_.reset();
+    return;
+  }
+
+  clear();
+  planning_scene_ = planning_scene.get();
+  start_state_msg_ = req.start_state;
+  group_name_ = req.group_name;
+  start_state_.emplace(planning_scene->getCurrentState());
+  moveit::core::robotStateMsgToRobotState(planning_scene->getTransforms(), req.start_state, *start_state_);
+  start_state_->update();
+}
+
+const moveit::core::RobotState& PlanningRequestContext::getStartState(
+    const planning_scene::PlanningSceneConstPtr& planning_scene, const planning_interface::MotionPlanRequest& req)
+{
+  update(planning_scene, req);
+  return *start_state_;
+}
+
+bool PlanningRequestContext::isStartStateColliding(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                   const planning_interface::MotionPlanRequest& req)
+{
+  update(planning_scene, req);
+  if (!colliding_)
+    colliding_ = isStateColliding(*planning_scene, req, *start_state_);
+  return *colliding_;
+}
+
+bool PlanningRequestContext::isStartStateValid(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                               const planning_interface::MotionPlanRequest& req)
+{
+  update(planning_scene, req);
+  if (!valid_)
+    valid_ = planning_scene->isStateValid(*start_state_, req.group_name);
+  return *valid_;
+}
+
+bool PlanningRequestContext::isStartStateValidWithPathConstraints(
+    const planning_scene::PlanningSceneConstPtr& planning_scene, const planning_interface::MotionPlanRequest& req)
+{
+  update(planning_scene, req);
+  if (!valid_with_path_constraints_)
+  {
+    path_constraints_ = req.path_constraints;
+    valid_with_path_constraints_ = planning_scene->isStateValid(*start_state_, req.path_constraints, req.group_name);
+  }
+  return *valid_with_path_constraints_;
+}
+
+void PlanningRequestContext::prefetch(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                      const planning_interface::MotionPlanRequest& req, unsigned int checks)
+{
+  update(planning_scene, req);
+
+  // the checks only read the scene and the start state, the results are stored once all of them are done
+  const moveit::core::RobotState& state = *start_state_;
+  std::future<bool> colliding;
+  std::future<bool> valid;
+  std::future<bool> valid_with_path_constraints;
+  if ((checks & COLLISION) && !colliding_)
+    colliding = std::async(std::launch::async, [&] { return isStateColliding(*planning_scene, req, state); });
+  if ((checks & VALIDITY) && !valid_)
+    valid = std::async(std::launch::async, [&] { return planning_scene->isStateValid(state, req.group_name); });
+  if ((checks & PATH_CONSTRAINTS) && !valid_with_path_constraints_)
+  {
+    valid_with_path_constraints = std::async(std::launch::async, [&] {
+      return planning_scene->isStateValid(state, req.path_constraints, req.group_name);
+    });
+  }
+
+  if (colliding.valid())
+    colliding_ = colliding.get();
+  if (valid.valid())
+    valid_ = valid.get();
+  if (valid_with_path_constraints.valid())
+  {
+    path_constraints_ = req.path_constraints;
+    valid_with_path_constraints_ = valid_with_path_constraints.get();
+  }
+}
+
+void PlanningRequestContext::clear()
+{
+  planning_scene_ = nullptr;
+  start_state_.reset();
+  colliding_.reset();
+  valid_.reset();
+  valid_with_path_constraints_.reset();
+}
+
+PlanningRequestContext& PlanningRequestAdapter::getRequestContext()
+{
+  if (current_request_context)
+    return *current_request_context;
+
+  // without a chain, results cannot be shared and the scene may change between calls
+  static thread_local PlanningRequestContext unscoped_context;
+  unscoped_context.clear();
+  return unscoped_context;
+}
+
 bool PlanningRequestAdapter::adaptAndPlan(const planning_interface::PlannerManagerPtr& planner,
                                           const planning_scene::PlanningSceneConstPtr& planning_scene,
                                           const planning_interface::MotionPlanRequest& req,
@@ -131,32 +274,62 @@ bool PlanningRequestAdapterChain::adaptAndPlan(const planning_interface::Planner
   if (adapters_.empty())
   {
     added_path_index.clear();
-    return callPlannerInterfaceSolve(*planner, planning_scene, req, res);
+    const auto start = std::chrono::steady_clock::now();
+    bool result = callPlannerInterfaceSolve(*planner, planning_scene, req, res);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    res.stage_times.emplace_back(planner->getDescription(), elapsed.count());
+    return result;
   }
+  // share the start state between the adapters, and compute the checks they ask for concurrently up front
+  PlanningRequestContext context;
+  const RequestContextScope context_scope(context);
+  unsigned int start_state_checks = PlanningRequestContext::NO_CHECKS;
+  for (const PlanningRequestAdapterConstPtr& adapter : adapters_)
+    start_state_checks |= adapter->getStartStateChecks();
+  if (start_state_checks != PlanningRequestContext::NO_CHECKS)
+    context.prefetch(planning_scene, req, start_state_checks);
+
   // the index values added by each adapter
   std::vector<std::vector<std::size_t>> added_path_index_each(adapters_.size());
 
+  // the time spent in each adapter, including the nested adapters, and in the planner (last entry)
+  std::vector<double> inclusive_times(adapters_.size() + 1, 0.0);
+
   // if there are adapters, construct a function for each, in order,
   // so that in the end we have a nested sequence of functions that calls all adapters
   // and eventually the planner in the correct order.
-  PlanningRequestAdapter::PlannerFn fn = [&planner = *planner](const planning_scene::PlanningSceneConstPtr& scene,
-                                                               const planning_interface::MotionPlanRequest& req,
-                                                               planning_interface::MotionPlanResponse& res) {
-    return callPlannerInterfaceSolve(planner, scene, req, res);
+  PlanningRequestAdapter::PlannerFn fn = [&planner = *planner, &time = inclusive_times.back()](
+                                             const planning_scene::PlanningSceneConstPtr& scene,
+                                             const planning_interface::MotionPlanRequest& req,
+                                             planning_interface::MotionPlanResponse& res) {
+    const auto start = std::chrono::steady_clock::now();
+    bool result = callPlannerInterfaceSolve(planner, scene, req, res);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    time += elapsed.count();
+    return result;
   };
 
   for (int i = adapters_.size() - 1; i >= 0; --i)
   {
-    fn = [&adapter = *adapters_[i], fn, &added_path_index = added_path_index_each[i]](
+    fn = [&adapter = *adapters_[i], fn, &added_path_index = added_path_index_each[i], &time = inclusive_times[i]](
              const planning_scene::PlanningSceneConstPtr& scene, const planning_interface::MotionPlanRequest& req,
              planning_interface::MotionPlanResponse& res) {
-      return callAdapter(adapter, fn, scene, req, res, added_path_index);
+      const auto start = std::chrono::steady_clock::now();
+      bool result = callAdapter(adapter, fn, scene, req, res, added_path_index);
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      time += elapsed.count();
+      return result;
     };
   }
 
   bool result = fn(planning_scene, req, res);
   added_path_index.clear();
 
+  // report the time of each stage without the time of the stages it wraps
+  for (std::size_t i = 0; i < adapters_.size(); ++i)
+    res.stage_times.emplace_back(adapters_[i]->getDescription(), inclusive_times[i] - inclusive_times[i + 1]);
+  res.stage_times.emplace_back(planner->getDescription(), inclusive_times.back());
+
   // merge the index values from each adapter
   for (std::vector<std::size_t>& added_states_by_each_adapter : added_path_index_each)
   {
@@ -0,0 +1,144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Tests that the PlanningRequestContext recomputes its results when the scene or the request changes */
+
+#include <gtest/gtest.h>
+
+#include <geometric_shapes/shapes.h>
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+namespace
+{
+const std::string GROUP = "panda_arm";
+const std::string JOINT = "panda_joint1";
+
+// A request for the arm whose start state differs from the current state of the scene in the first joint only
+planning_interface::MotionPlanRequest makeRequest(double joint_position)
+{
+  planning_interface::MotionPlanRequest req;
+  req.group_name = GROUP;
+  req.start_state.is_diff = true;
+  req.start_state.joint_state.name.push_back(JOINT);
+  req.start_state.joint_state.position.push_back(joint_position);
+  return req;
+}
+
+moveit_msgs::msg::Constraints makeJointConstraint(double position)
+{
+  moveit_msgs::msg::Constraints constraints;
+  moveit_msgs::msg::JointConstraint joint_constraint;
+  joint_constraint.joint_name = JOINT;
+  joint_constraint.position = position;
+  joint_constraint.tolerance_above = 0.1;
+  joint_constraint.tolerance_below = 0.1;
+  joint_constraint.weight = 1.0;
+  constraints.joint_constraints.push_back(joint_constraint);
+  return constraints;
+}
+}  // namespace
+
+class PlanningRequestContextTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    free_scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model_);
+
+    // a box around the first link of the arm, which collides in every configuration
+    planning_scene::PlanningScenePtr blocked_scene = free_scene_->diff();
+    Eigen::Isometry3d box_pose = Eigen::Isometry3d::Identity();
+    box_pose.translation().z() = 0.333;
+    blocked_scene->getWorldNonConst()->addToObject("box", box_pose, std::make_shared<const shapes::Box>(0.3, 0.3, 0.3),
+                                                   Eigen::Isometry3d::Identity());
+    blocked_scene_ = blocked_scene;
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  planning_scene::PlanningSceneConstPtr free_scene_;
+  planning_scene::PlanningSceneConstPtr blocked_scene_;
+  planning_request_adapter::PlanningRequestContext context_;
+};
+
+TEST_F(PlanningRequestContextTest, SceneChangeRecomputesChecks)
+{
+  const planning_interface::MotionPlanRequest req = makeRequest(0.0);
+  context_.prefetch(free_scene_, req,
+                    planning_request_adapter::PlanningRequestContext::COLLISION |
+                        planning_request_adapter::PlanningRequestContext::VALIDITY);
+  EXPECT_FALSE(context_.isStartStateColliding(free_scene_, req));
+  EXPECT_TRUE(context_.isStartStateValid(free_scene_, req));
+
+  EXPECT_TRUE(context_.isStartStateColliding(blocked_scene_, req));
+  EXPECT_FALSE(context_.isStartStateValid(blocked_scene_, req));
+
+  EXPECT_FALSE(context_.isStartStateColliding(free_scene_, req));
+  EXPECT_TRUE(context_.isStartStateValid(free_scene_, req));
+}
+
+TEST_F(PlanningRequestContextTest, StartStateChangeRebuildsState)
+{
+  planning_interface::MotionPlanRequest req = makeRequest(0.0);
+  req.path_constraints = makeJointConstraint(0.0);
+  EXPECT_EQ(context_.getStartState(free_scene_, req).getVariablePosition(JOINT), 0.0);
+  EXPECT_TRUE(context_.isStartStateValidWithPathConstraints(free_scene_, req));
+
+  // the start state is converted again and the checks are done for it
+  req.start_state = makeRequest(0.5).start_state;
+  const moveit::core::RobotState& start_state = context_.getStartState(free_scene_, req);
+  EXPECT_EQ(start_state.getVariablePosition(JOINT), 0.5);
+  EXPECT_FALSE(start_state.dirtyLinkTransforms());
+  EXPECT_FALSE(context_.isStartStateValidWithPathConstraints(free_scene_, req));
+  EXPECT_TRUE(context_.isStartStateValid(free_scene_, req));
+}
+
+TEST_F(PlanningRequestContextTest, PathConstraintsChangeRecomputesValidity)
+{
+  planning_interface::MotionPlanRequest req = makeRequest(0.5);
+  req.path_constraints = makeJointConstraint(0.0);
+  EXPECT_FALSE(context_.isStartStateValidWithPathConstraints(free_scene_, req));
+
+  req.path_constraints = makeJointConstraint(0.5);
+  EXPECT_TRUE(context_.isStartStateValidWithPathConstraints(free_scene_, req));
+  EXPECT_EQ(context_.getStartState(free_scene_, req).getVariablePosition(JOINT), 0.5);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -51,9 +51,15 @@
 #include <moveit_msgs/msg/constraints.hpp>
 #include <moveit_msgs/msg/planning_scene_components.hpp>
 #include <octomap_msgs/msg/octomap_with_pose.hpp>
+#include <octomap/OcTreeKey.h>
+#include <eigen_stl_containers/eigen_stl_vector_container.h>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <functional>
+#include <shared_mutex>
 #include <thread>
+#include <unordered_map>
 #include <variant>
 #include <rclcpp/rclcpp.hpp>
 
@@ -111,6 +117,18 @@ public:
   static const std::string OCTOMAP_NS;
   static const std::string DEFAULT_SCENE_NAME;
 
+  /** \brief Predicted motion of a world object, as poses of the object at increasing times. Times are in seconds
+   * since the start of the motion being checked, the object keeps its first pose before the first time and its last
+   * pose after the last time, and poses in between are interpolated. */
+  struct PredictedObjectMotion
+  {
+    std::vector<double> times;
+    EigenSTL::vector_Isometry3d poses;
+  };
+
+  /** \brief Type id of octomap messages that only carry the cells changed since the previous octomap message */
+  static const std::string OCTOMAP_UPDATE_ID;
+
   ~PlanningScene();
 
   /** \brief Get the name of the planning scene. This is empty by default */
@@ -141,6 +159,14 @@ public:
    * has the diffs specified by \e msg applied. */
   PlanningScenePtr diff(const moveit_msgs::msg::PlanningScene& msg) const;
 
+  /** \brief Return a new child PlanningScene like diff(), meant for cheaply evaluating hypothetical changes.
+   *
+   *  The collision environments of the child overlay the ones of this scene instead of copying their world objects,
+   *  so creating the child does not depend on the number of objects in the world. Objects that are added, changed or
+   *  removed in the child are kept by the child alone. This scene must not be modified while the child exists.
+   *  Collision detectors without support for overlays copy the collision environments, like diff(). */
+  PlanningScenePtr overlay() const;
+
   /** \brief Get the parent scene (with respect to which the diffs are maintained). This may be empty */
   const PlanningSceneConstPtr& getParent() const
   {
@@ -286,6 +312,14 @@ public:
    * This can be used to set padding and link scale on the active collision_robot. */
   const collision_detection::CollisionEnvPtr& getCollisionEnvNonConst();
 
+  /** \brief Estimate the memory held by the geometry of this scene and of the scenes it is a diff of.
+   *
+   *  The first entry is this scene, followed by its parent, the parent of its parent and so on. Each entry only counts
+   *  the world objects that differ from the parent scene and the geometry the active collision environment built for
+   *  them, so geometry shared with the parent is counted once, in the scene it was added to. Robot links are counted
+   *  in the last entry. */
+  std::vector<collision_detection::MemoryUsage> getMemoryUsage() const;
+
   /** \brief Get the allowed collision matrix */
   const collision_detection::AllowedCollisionMatrix& getAllowedCollisionMatrix() const
   {
@@ -331,11 +365,46 @@ public:
   bool isStateColliding(const moveit::core::RobotState& state, const std::string& group = "",
                         bool verbose = false) const;
 
+  /** \brief Check if a given state is in collision (with the environment or self collision)
+      If \e group is not nullptr, collision checking is done for that group only (plus descendent links). It is
+     expected that the link transforms of \e state are up to date. Unlike the overloads taking a group name, this
+     does not look up the group, which makes it the better choice when checking many states. */
+  bool isStateColliding(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                        bool verbose = false) const;
+
   /** \brief Check if a given state is in collision (with the environment or self collision)
       If a group name is specified, collision checking is done for that group only (plus descendent links). */
   bool isStateColliding(const moveit_msgs::msg::RobotState& state, const std::string& group = "",
                         bool verbose = false) const;
 
+  /** \brief Check if a given state is in collision at \e time seconds since the start of the motion, with the world
+      objects that have a predicted motion at their predicted poses. Without predicted motions this is the same as
+      isStateColliding(). It is expected that the link transforms of \e state are up to date.
+      The scene must be owned by a shared pointer, as it is overlaid with the predicted poses. */
+  bool isStateCollidingAt(const moveit::core::RobotState& state, const std::string& group, double time,
+                          bool verbose = false) const;
+
+  /** \brief Same as the overload taking a group name, for \e group (the complete robot if nullptr) */
+  bool isStateCollidingAt(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                          double time, bool verbose = false) const;
+
+  /** \brief Set the predicted motion of the world object \e object_id, used by isStateCollidingAt() and by
+      isPathValid() at the time of each waypoint. Returns false if the object does not exist or the motion is invalid.
+      Predicted motions are not part of planning scene messages. */
+  bool setPredictedObjectMotion(const std::string& object_id, const PredictedObjectMotion& motion);
+
+  /** \brief Remove the predicted motion of \e object_id, so the object is checked at its pose in the world */
+  void removePredictedObjectMotion(const std::string& object_id);
+
+  /** \brief Check whether any world object has a predicted motion */
+  bool hasPredictedObjectMotions() const
+  {
+    return !predicted_object_motions_.empty();
+  }
+
+  /** \brief Get the predicted pose of \e object_id at \e time. Returns false if the object has no predicted motion. */
+  bool getPredictedObjectPose(const std::string& object_id, double time, Eigen::Isometry3d& pose) const;
+
   /** \brief Check whether the current state is in collision, and if needed, updates the collision transforms of the
    * current state before the computation. */
   void checkCollision(const collision_detection::CollisionRequest& req, collision_detection::CollisionResult& res);
@@ -684,6 +753,15 @@ public:
   /** \brief Construct a message (\e octomap) with the octomap data from the planning_scene */
   bool getOctomapMsg(octomap_msgs::msg::OctomapWithPose& octomap) const;
 
+  /** \brief Construct a message (\e octomap) with the current value of the octomap cells in \e changed_keys.
+   *
+   * The message is of type OCTOMAP_UPDATE_ID and is applied by processOctomapMsg() to the octomap of a scene that
+   * received the last full octomap and the \e index - 1 updates following it.
+   * \param changed_keys the keys of the cells changed since the previous octomap message
+   * \param index the number of this update since the last full octomap, starting at 1 */
+  bool getOctomapUpdateMsg(const octomap::KeySet& changed_keys, std::uint32_t index,
+                           octomap_msgs::msg::OctomapWithPose& octomap) const;
+
   /** \brief Construct a vector of messages (\e object_colors) with the colors of the objects from the planning_scene */
   void getObjectColorMsgs(std::vector<moveit_msgs::msg::ObjectColor>& object_colors) const;
 
@@ -716,6 +794,8 @@ public:
 
   bool processPlanningSceneWorldMsg(const moveit_msgs::msg::PlanningSceneWorld& world);
 
+  /** \brief Replace the octomap of the scene, or update it if the message is of type OCTOMAP_UPDATE_ID. Updates that
+   * do not directly follow the octomap of the scene are ignored until the next full octomap. */
   void processOctomapMsg(const octomap_msgs::msg::OctomapWithPose& map);
   void processOctomapMsg(const octomap_msgs::msg::Octomap& map);
   void processOctomapPtr(const std::shared_ptr<const octomap::OcTree>& octree, const Eigen::Isometry3d& t);
@@ -831,6 +911,11 @@ public:
    * links of \e group. */
   bool isStateValid(const moveit::core::RobotState& state, const std::string& group = "", bool verbose = false) const;
 
+  /** \brief Check if a given state is valid. This means checking for collisions and feasibility. Includes descendent
+   * links of \e group, or the complete robot if \e group is nullptr. */
+  bool isStateValid(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                    bool verbose = false) const;
+
   /** \brief Check if a given state is valid. This means checking for collisions, feasibility  and whether the user
    * specified validity conditions hold as well. Includes descendent links of \e group. */
   bool isStateValid(const moveit_msgs::msg::RobotState& state, const moveit_msgs::msg::Constraints& constr,
@@ -846,6 +931,12 @@ public:
   bool isStateValid(const moveit::core::RobotState& state, const kinematic_constraints::KinematicConstraintSet& constr,
                     const std::string& group = "", bool verbose = false) const;
 
+  /** \brief Check if a given state is valid. This means checking for collisions, feasibility  and whether the user
+   * specified validity conditions hold as well. Includes descendent links of \e group, or the complete robot if
+   * \e group is nullptr. */
+  bool isStateValid(const moveit::core::RobotState& state, const kinematic_constraints::KinematicConstraintSet& constr,
+                    const moveit::core::JointModelGroup* group, bool verbose = false) const;
+
   /** \brief Check if a given path is valid. Each state is checked for validity (collision avoidance and feasibility).
    * Includes descendent links of \e group. */
   bool isPathValid(const moveit_msgs::msg::RobotState& start_state, const moveit_msgs::msg::RobotTrajectory& trajectory,
@@ -902,6 +993,36 @@ public:
   bool isPathValid(const robot_trajectory::RobotTrajectory& trajectory, const std::string& group = "",
                    bool verbose = false, std::vector<std::size_t>* invalid_index = nullptr) const;
 
+  /** \brief Set the number of threads isPathValid() distributes the waypoints of a trajectory to.
+   *
+   *  A value of 1 (the default) checks the waypoints sequentially, 0 uses one thread per hardware core. When multiple
+   *  threads are used, the collision detector and the state feasibility predicate need to support concurrent queries.
+   *  Without \e invalid_index, all threads stop as soon as one of them finds an invalid waypoint. */
+  void setPathValidityThreadCount(std::size_t thread_count)
+  {
+    path_validity_thread_count_ = thread_count;
+  }
+
+  /** \brief Get the number of threads isPathValid() distributes the waypoints of a trajectory to. */
+  std::size_t getPathValidityThreadCount() const
+  {
+    return path_validity_thread_count_;
+  }
+
+  /** \brief Check if two time-parameterized trajectories of different groups collide when executed simultaneously.
+   *
+   *  Both trajectories are sampled at the same times, every \e sample_duration seconds from the start until the end of
+   *  the longer trajectory, which is sampled as well. A trajectory that already ended holds its last waypoint. Each
+   *  sampled state of \e trajectory1 gets the joint values of the group of \e trajectory2 from the sample of
+   *  \e trajectory2, and is checked for collisions of the whole robot, with itself and with the environment.
+   *  The groups may not share active joints. The samples are distributed to getPathValidityThreadCount() threads.
+   *
+   *  \param colliding_times If not nullptr, all samples are checked and the times of the colliding ones are stored here
+   *  \return True if a sample is in collision, or if the trajectories cannot be checked */
+  bool areTrajectoriesColliding(const robot_trajectory::RobotTrajectory& trajectory1,
+                                const robot_trajectory::RobotTrajectory& trajectory2, double sample_duration,
+                                bool verbose = false, std::vector<double>* colliding_times = nullptr) const;
+
   /** \brief Get the top \e max_costs cost sources for a specified trajectory. The resulting costs are stored in \e
    * costs */
   void getCostSources(const robot_trajectory::RobotTrajectory& trajectory, std::size_t max_costs,
@@ -961,13 +1082,36 @@ public:
   }
 
 private:
-  /* Private constructor used by the diff() methods. */
-  PlanningScene(const PlanningSceneConstPtr& parent);
+  /* Private constructor used by the diff() and overlay() methods. */
+  PlanningScene(const PlanningSceneConstPtr& parent, bool overlay = false);
 
   /* Initialize the scene.  This should only be called by the constructors.
    * Requires a valid robot_model_ */
   void initialize();
 
+  /* Apply an octomap message of type OCTOMAP_UPDATE_ID to the octomap of the scene */
+  void processOctomapUpdateMsg(const octomap_msgs::msg::OctomapWithPose& map);
+
+  /* Where a frame of the scene was found by resolveFrame() */
+  struct FrameResolution
+  {
+    enum Source
+    {
+      MODEL_FRAME,   // the model frame of the robot
+      ROBOT_LINK,    // a link of the robot, at the pose of link in the state
+      WORLD_OBJECT,  // a world object or one of its subframes, at transform
+      OTHER          // a fixed frame, or a frame unknown to the scene
+    };
+
+    Source source;
+    const moveit::core::LinkModel* link;
+    const Eigen::Isometry3d* transform;
+  };
+
+  /* Find out whether a frame is a robot link, a world object or neither. Attached bodies are not considered, as they
+   * belong to the state. The result is cached until the world changes. */
+  FrameResolution resolveFrame(const std::string& frame_id) const;
+
   /* Helper functions for processing collision objects */
   bool processCollisionObjectAdd(const moveit_msgs::msg::CollisionObject& object);
   bool processCollisionObjectRemove(const moveit_msgs::msg::CollisionObject& object);
@@ -975,7 +1119,8 @@ private:
 
   MOVEIT_STRUCT_FORWARD(CollisionDetector);
 
-  /* Construct a new CollisionDector from allocator, copy-construct environments from parent_detector if not nullptr */
+  /* Construct a new CollisionDector from allocator, copy-construct environments from parent_detector if not nullptr
+   * (or construct overlays of them if overlay_ is set) */
   void allocateCollisionDetector(const collision_detection::CollisionDetectorAllocatorPtr& allocator,
                                  const CollisionDetectorPtr& parent_detector);
 
@@ -1004,6 +1149,7 @@ private:
   std::string name_;  // may be empty
 
   PlanningSceneConstPtr parent_;  // Null unless this is a diff scene
+  bool overlay_ = false;          // True if the collision environments overlay the ones of parent_
 
   moveit::core::RobotModelConstPtr robot_model_;  // Never null (may point to same model as parent)
 
@@ -1019,6 +1165,7 @@ private:
   collision_detection::WorldPtr world_;             // never nullptr, never shared with parent/child
   collision_detection::WorldConstPtr world_const_;  // copy of world_
   collision_detection::WorldDiffPtr world_diff_;    // nullptr unless this is a diff scene
+  std::uint32_t octomap_update_index_ = 0;          // number of octomap updates applied since the last full octomap
   collision_detection::World::ObserverCallbackFn current_world_object_update_callback_;
   collision_detection::World::ObserverHandle current_world_object_update_observer_handle_;
 
@@ -1029,9 +1176,19 @@ private:
   StateFeasibilityFn state_feasibility_;
   MotionFeasibilityFn motion_feasibility_;
 
+  std::size_t path_validity_thread_count_ = 1;
+
   std::unique_ptr<ObjectColorMap> object_colors_;
 
   // a map of object types
   std::unique_ptr<ObjectTypeMap> object_types_;
+
+  // Predicted motions of world objects, copied from the parent
+  std::map<std::string, PredictedObjectMotion> predicted_object_motions_;
+
+  // Frames resolved by resolveFrame(), valid while the change count of world_ is frame_cache_world_changes_
+  mutable std::unordered_map<std::string, FrameResolution> frame_cache_;
+  mutable std::size_t frame_cache_world_changes_ = 0;
+  mutable std::shared_mutex frame_cache_mutex_;
 };
 }  // namespace planning_scene
@@ -49,8 +49,14 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <tf2_eigen/tf2_eigen.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <set>
+#include <thread>
 
 namespace planning_scene
 {
@@ -58,6 +64,22 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_planning_scene.p
 
 const std::string PlanningScene::OCTOMAP_NS = "<octomap>";
 const std::string PlanningScene::DEFAULT_SCENE_NAME = "(noname)";
+const std::string PlanningScene::OCTOMAP_UPDATE_ID = "OcTreeUpdate";
+
+namespace
+{
+// An octomap update is the update index followed by the key and log-odds of each changed cell, NaN for deleted cells
+constexpr std::size_t OCTOMAP_UPDATE_CELL_SIZE = 3 * sizeof(octomap::key_type) + sizeof(float);
+
+// The group checked for a group name, nullptr for the complete robot if the name is empty or not a group
+const moveit::core::JointModelGroup* findCheckedGroup(const moveit::core::RobotModel& robot_model,
+                                                      const std::string& group)
+{
+  if (group.empty() || !robot_model.hasJointModelGroup(group))
+    return nullptr;
+  return robot_model.getJointModelGroup(group);
+}
+}  // namespace
 
 namespace utilities
 {
@@ -208,7 +230,7 @@ void PlanningScene::initialize()
   allocateCollisionDetector(collision_detection::CollisionDetectorAllocatorFCL::create());
 }
 
-PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(parent)
+PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent, bool overlay) : parent_(parent), overlay_(overlay)
 {
   if (!parent_)
     throw moveit::ConstructException("nullptr parent pointer for planning scene");
@@ -225,9 +247,13 @@ PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(pare
 
   // record changes to the world
   world_diff_ = std::make_shared<collision_detection::WorldDiff>(world_);
+  octomap_update_index_ = parent_->octomap_update_index_;
+  predicted_object_motions_ = parent_->predicted_object_motions_;
 
   allocateCollisionDetector(parent_->collision_detector_->alloc_, parent_->collision_detector_);
   collision_detector_->copyPadding(*parent_->collision_detector_);
+
+  path_validity_thread_count_ = parent_->path_validity_thread_count_;
 }
 
 PlanningScenePtr PlanningScene::clone(const PlanningSceneConstPtr& scene)
@@ -250,6 +276,11 @@ PlanningScenePtr PlanningScene::diff(const moveit_msgs::msg::PlanningScene& msg)
   return result;
 }
 
+PlanningScenePtr PlanningScene::overlay() const
+{
+  return PlanningScenePtr(new PlanningScene(shared_from_this(), true));
+}
+
 void PlanningScene::CollisionDetector::copyPadding(const PlanningScene::CollisionDetector& src)
 {
   cenv_->setLinkPadding(src.getCollisionEnv()->getLinkPadding());
@@ -268,7 +299,13 @@ void PlanningScene::allocateCollisionDetector(const collision_detection::Collisi
 
   // If parent_detector is specified, copy-construct collision environments (copies link shapes and attached objects)
   // Otherwise, construct new collision environment from world and robot model
-  if (parent_detector)
+  if (parent_detector && overlay_)
+  {
+    collision_detector_->cenv_ = collision_detector_->alloc_->allocateOverlayEnv(parent_detector->cenv_, world_);
+    collision_detector_->cenv_unpadded_ =
+        collision_detector_->alloc_->allocateOverlayEnv(parent_detector->cenv_unpadded_, world_);
+  }
+  else if (parent_detector)
   {
     collision_detector_->cenv_ = collision_detector_->alloc_->allocateEnv(parent_detector->cenv_, world_);
     collision_detector_->cenv_unpadded_ =
@@ -326,6 +363,7 @@ void PlanningScene::clearDiffs()
   world_ = std::make_shared<collision_detection::World>(*parent_->world_);
   world_const_ = world_;
   world_diff_ = std::make_shared<collision_detection::WorldDiff>(world_);
+  frame_cache_.clear();
   if (current_world_object_update_callback_)
     current_world_object_update_observer_handle_ = world_->addObserver(current_world_object_update_callback_);
 
@@ -371,6 +409,8 @@ void PlanningScene::pushDiffs(const PlanningScenePtr& scene)
 
   if (world_diff_)
   {
+    scene->octomap_update_index_ = octomap_update_index_;
+    scene->predicted_object_motions_ = predicted_object_motions_;
     for (const std::pair<const std::string, collision_detection::World::Action>& it : *world_diff_)
     {
       if (it.second == collision_detection::World::DESTROY)
@@ -532,6 +572,33 @@ const collision_detection::CollisionEnvPtr& PlanningScene::getCollisionEnvNonCon
   return collision_detector_->cenv_;
 }
 
+std::vector<collision_detection::MemoryUsage> PlanningScene::getMemoryUsage() const
+{
+  std::vector<collision_detection::MemoryUsage> layers;
+  for (const PlanningScene* scene = this; scene; scene = scene->parent_.get())
+  {
+    collision_detection::MemoryUsage& usage = layers.emplace_back();
+    const PlanningScene* parent = scene->parent_.get();
+    std::set<std::string> own_objects;
+    for (const auto& [id, object] : *scene->world_)
+    {
+      if (parent && parent->world_->getObject(id) == object)
+        continue;
+      collision_detection::addObjectMemoryUsage(*object, usage);
+      own_objects.insert(id);
+    }
+
+    std::map<std::string, std::size_t> geometry;
+    scene->getCollisionEnv()->getCollisionGeometryMemoryUsage(geometry);
+    for (const auto& [name, bytes] : geometry)
+    {
+      if (!parent || own_objects.count(name))
+        usage.collision_geometry[name] = bytes;
+    }
+  }
+  return layers;
+}
+
 moveit::core::RobotState& PlanningScene::getCurrentStateNonConst()
 {
   if (!robot_state_)
@@ -832,6 +899,41 @@ bool PlanningScene::getOctomapMsg(octomap_msgs::msg::OctomapWithPose& octomap) c
   return false;
 }
 
+bool PlanningScene::getOctomapUpdateMsg(const octomap::KeySet& changed_keys, std::uint32_t index,
+                                        octomap_msgs::msg::OctomapWithPose& octomap) const
+{
+  octomap.header.frame_id = getPlanningFrame();
+  octomap.octomap = octomap_msgs::msg::Octomap();
+
+  collision_detection::CollisionEnv::ObjectConstPtr map = world_->getObject(OCTOMAP_NS);
+  if (!map || map->shapes_.size() != 1)
+    return false;
+
+  const octomap::OcTree& tree = *static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree;
+  octomap.octomap.binary = false;
+  octomap.octomap.id = OCTOMAP_UPDATE_ID;
+  octomap.octomap.resolution = tree.getResolution();
+  octomap.octomap.data.resize(sizeof(index) + changed_keys.size() * OCTOMAP_UPDATE_CELL_SIZE);
+
+  char* out = reinterpret_cast<char*>(octomap.octomap.data.data());
+  std::memcpy(out, &index, sizeof(index));
+  out += sizeof(index);
+  for (const octomap::OcTreeKey& key : changed_keys)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      std::memcpy(out, &key[i], sizeof(octomap::key_type));
+      out += sizeof(octomap::key_type);
+    }
+    const octomap::OcTreeNode* node = tree.search(key);
+    const float log_odds = node ? node->getLogOdds() : std::numeric_limits<float>::quiet_NaN();
+    std::memcpy(out, &log_odds, sizeof(log_odds));
+    out += sizeof(log_odds);
+  }
+  octomap.origin = tf2::toMsg(map->shape_poses_[0]);
+  return true;
+}
+
 void PlanningScene::getObjectColorMsgs(std::vector<moveit_msgs::msg::ObjectColor>& object_colors) const
 {
   object_colors.clear();
@@ -1173,6 +1275,13 @@ void PlanningScene::decoupleParent()
 
   world_diff_.reset();
 
+  // the parent may be modified once it is decoupled, so the collision environments cannot overlay it anymore
+  if (overlay_)
+  {
+    overlay_ = false;
+    allocateCollisionDetector(collision_detector_->alloc_, nullptr);
+  }
+
   if (!object_colors_)
   {
     ObjectColorMap kc;
@@ -1335,6 +1444,7 @@ void PlanningScene::processOctomapMsg(const octomap_msgs::msg::Octomap& map)
 {
   // each octomap replaces any previous one
   world_->removeObject(OCTOMAP_NS);
+  octomap_update_index_ = 0;
 
   if (map.data.empty())
     return;
@@ -1373,8 +1483,15 @@ void PlanningScene::removeAllCollisionObjects()
 
 void PlanningScene::processOctomapMsg(const octomap_msgs::msg::OctomapWithPose& map)
 {
+  if (map.octomap.id == OCTOMAP_UPDATE_ID)
+  {
+    processOctomapUpdateMsg(map);
+    return;
+  }
+
   // each octomap replaces any previous one
   world_->removeObject(OCTOMAP_NS);
+  octomap_update_index_ = 0;
 
   if (map.octomap.data.empty())
     return;
@@ -1394,6 +1511,67 @@ void PlanningScene::processOctomapMsg(const octomap_msgs::msg::OctomapWithPose&
   world_->addToObject(OCTOMAP_NS, std::make_shared<const shapes::OcTree>(om), p);
 }
 
+void PlanningScene::processOctomapUpdateMsg(const octomap_msgs::msg::OctomapWithPose& map)
+{
+  const std::vector<int8_t>& data = map.octomap.data;
+  std::uint32_t index;
+  if (data.size() < sizeof(index) || (data.size() - sizeof(index)) % OCTOMAP_UPDATE_CELL_SIZE != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Received octomap update of invalid size %zu", data.size());
+    return;
+  }
+  const char* in = reinterpret_cast<const char*>(data.data());
+  std::memcpy(&index, in, sizeof(index));
+  in += sizeof(index);
+
+  collision_detection::CollisionEnv::ObjectConstPtr object = world_->getObject(OCTOMAP_NS);
+  if (!object || object->shapes_.size() != 1 || index != octomap_update_index_ + 1)
+  {
+    RCLCPP_WARN(LOGGER, "Ignoring octomap update %u which does not follow the octomap of the scene, waiting for the "
+                        "next full octomap",
+                index);
+    return;
+  }
+  const shapes::OcTree* shape = static_cast<const shapes::OcTree*>(object->shapes_[0].get());
+  if (shape->octree->getResolution() != map.octomap.resolution)
+  {
+    RCLCPP_ERROR(LOGGER, "Received octomap update of resolution %f for an octomap of resolution %f",
+                 map.octomap.resolution, shape->octree->getResolution());
+    return;
+  }
+
+  // the octree may be shared with other scenes, so the update is applied to a copy
+  auto om = std::make_shared<collision_detection::OccMapTree>(*shape->octree);
+  object.reset();
+  for (const int8_t* end = data.data() + data.size(); in != reinterpret_cast<const char*>(end);)
+  {
+    octomap::OcTreeKey key;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      std::memcpy(&key[i], in, sizeof(octomap::key_type));
+      in += sizeof(octomap::key_type);
+    }
+    float log_odds;
+    std::memcpy(&log_odds, in, sizeof(log_odds));
+    in += sizeof(log_odds);
+
+    if (std::isnan(log_odds))
+      om->deleteNode(key);
+    else
+      om->setNodeValue(key, log_odds, true);
+  }
+  om->updateInnerOccupancy();
+  om->prune();
+
+  const Eigen::Isometry3d& t = getFrameTransform(map.header.frame_id);
+  Eigen::Isometry3d p;
+  utilities::poseMsgToEigen(map.origin, p);
+  p = t * p;
+  world_->removeObject(OCTOMAP_NS);
+  world_->addToObject(OCTOMAP_NS, std::make_shared<const shapes::OcTree>(om), p);
+  octomap_update_index_ = index;
+}
+
 void PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTree>& octree, const Eigen::Isometry3d& t)
 {
   collision_detection::CollisionEnv::ObjectConstPtr map = world_->getObject(OCTOMAP_NS);
@@ -1408,6 +1586,14 @@ void PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTre
         // if the pose changed, we update it
         if (map->shape_poses_[0].isApprox(t, std::numeric_limits<double>::epsilon() * 100.0))
         {
+          // the content of the shared octree changed in place; let observers that track the octree cells
+          // (e.g. distance fields) consume the changed keys instead of rebuilding from scratch
+          if (octree->isChangeDetectionEnabled() && octree->numChangesDetected() > 0)
+          {
+            shapes::ShapeConstPtr shape = map->shapes_[0];
+            map.reset();
+            world_->moveShapeInObject(OCTOMAP_NS, shape, t);
+          }
           if (world_diff_)
           {
             world_diff_->set(OCTOMAP_NS, collision_detection::World::DESTROY | collision_detection::World::CREATE |
@@ -1859,6 +2045,23 @@ bool PlanningScene::processCollisionObjectMove(const moveit_msgs::msg::Collision
   return false;
 }
 
+namespace
+{
+// Check if an attached body of the state is named frame_id or could have a subframe named frame_id
+bool hasAttachedBodyFrame(const moveit::core::RobotState& state, const std::string& frame_id)
+{
+  if (state.hasAttachedBody(frame_id))
+    return true;
+  // subframes are named "<body id>/<subframe>", where the body id may contain slashes itself
+  for (std::size_t pos = frame_id.find('/'); pos != std::string::npos; pos = frame_id.find('/', pos + 1))
+  {
+    if (state.hasAttachedBody(frame_id.substr(0, pos)))
+      return true;
+  }
+  return false;
+}
+}  // namespace
+
 const Eigen::Isometry3d& PlanningScene::getFrameTransform(const std::string& frame_id) const
 {
   return getFrameTransform(getCurrentState(), frame_id);
@@ -1882,17 +2085,26 @@ const Eigen::Isometry3d& PlanningScene::getFrameTransform(const moveit::core::Ro
   if (!frame_id.empty() && frame_id[0] == '/')
   {
     // Recursively call itself without the slash in front of frame name
-    return getFrameTransform(frame_id.substr(1));
+    return getFrameTransform(state, frame_id.substr(1));
   }
 
-  bool frame_found;
-  const Eigen::Isometry3d& t1 = state.getFrameTransform(frame_id, &frame_found);
-  if (frame_found)
-    return t1;
+  const FrameResolution resolution = resolveFrame(frame_id);
+  if (resolution.source == FrameResolution::MODEL_FRAME)
+    return state.getFrameTransform(frame_id);
+  if (resolution.source == FrameResolution::ROBOT_LINK)
+    return state.getGlobalLinkTransform(resolution.link);
+
+  // attached bodies take precedence over the world objects and fixed frames
+  if (hasAttachedBodyFrame(state, frame_id))
+  {
+    bool frame_found;
+    const Eigen::Isometry3d& transform = state.getFrameTransform(frame_id, &frame_found);
+    if (frame_found)
+      return transform;
+  }
 
-  const Eigen::Isometry3d& t2 = getWorld()->getTransform(frame_id, frame_found);
-  if (frame_found)
-    return t2;
+  if (resolution.source == FrameResolution::WORLD_OBJECT)
+    return *resolution.transform;
   return getTransforms().Transforms::getTransform(frame_id);
 }
 
@@ -1904,15 +2116,61 @@ bool PlanningScene::knowsFrameTransform(const std::string& frame_id) const
 bool PlanningScene::knowsFrameTransform(const moveit::core::RobotState& state, const std::string& frame_id) const
 {
   if (!frame_id.empty() && frame_id[0] == '/')
-    return knowsFrameTransform(frame_id.substr(1));
+    return knowsFrameTransform(state, frame_id.substr(1));
 
-  if (state.knowsFrameTransform(frame_id))
+  const FrameResolution resolution = resolveFrame(frame_id);
+  if (resolution.source == FrameResolution::MODEL_FRAME || resolution.source == FrameResolution::ROBOT_LINK)
+    return true;
+  if (hasAttachedBodyFrame(state, frame_id) && state.knowsFrameTransform(frame_id))
     return true;
-  if (getWorld()->knowsTransform(frame_id))
+  if (resolution.source == FrameResolution::WORLD_OBJECT)
     return true;
   return getTransforms().Transforms::canTransform(frame_id);
 }
 
+PlanningScene::FrameResolution PlanningScene::resolveFrame(const std::string& frame_id) const
+{
+  const std::size_t world_changes = world_->getChangeCount();
+  {
+    std::shared_lock<std::shared_mutex> lock(frame_cache_mutex_);
+    if (frame_cache_world_changes_ == world_changes)
+    {
+      const auto it = frame_cache_.find(frame_id);
+      if (it != frame_cache_.end())
+        return it->second;
+    }
+  }
+
+  FrameResolution resolution{ FrameResolution::OTHER, nullptr, nullptr };
+  bool found;
+  if (frame_id == robot_model_->getModelFrame())
+  {
+    resolution.source = FrameResolution::MODEL_FRAME;
+  }
+  else if ((resolution.link = robot_model_->getLinkModel(frame_id, &found)))
+  {
+    resolution.source = FrameResolution::ROBOT_LINK;
+  }
+  else
+  {
+    const Eigen::Isometry3d& transform = world_->getTransform(frame_id, found);
+    if (found)
+    {
+      resolution.source = FrameResolution::WORLD_OBJECT;
+      resolution.transform = &transform;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(frame_cache_mutex_);
+  if (frame_cache_world_changes_ != world_changes)
+  {
+    frame_cache_.clear();
+    frame_cache_world_changes_ = world_changes;
+  }
+  frame_cache_.emplace(frame_id, resolution);
+  return resolution;
+}
+
 bool PlanningScene::hasObjectType(const std::string& object_id) const
 {
   if (object_types_)
@@ -2041,15 +2299,105 @@ bool PlanningScene::isStateColliding(const std::string& group, bool verbose)
 }
 
 bool PlanningScene::isStateColliding(const moveit::core::RobotState& state, const std::string& group, bool verbose) const
+{
+  return isStateColliding(state, findCheckedGroup(*getRobotModel(), group), verbose);
+}
+
+bool PlanningScene::isStateColliding(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                                     bool verbose) const
 {
   collision_detection::CollisionRequest req;
   req.verbose = verbose;
-  req.group_name = group;
+  req.group = group;
   collision_detection::CollisionResult res;
   checkCollision(req, res, state);
   return res.collision;
 }
 
+bool PlanningScene::isStateCollidingAt(const moveit::core::RobotState& state, const std::string& group, double time,
+                                       bool verbose) const
+{
+  return isStateCollidingAt(state, findCheckedGroup(*getRobotModel(), group), time, verbose);
+}
+
+bool PlanningScene::isStateCollidingAt(const moveit::core::RobotState& state,
+                                       const moveit::core::JointModelGroup* group, double time, bool verbose) const
+{
+  if (predicted_object_motions_.empty())
+    return isStateColliding(state, group, verbose);
+
+  const PlanningSceneConstPtr self = weak_from_this().lock();
+  if (!self)
+  {
+    RCLCPP_ERROR(LOGGER, "Predicted object motions require the planning scene to be owned by a shared pointer. "
+                         "Checking the objects at their current poses.");
+    return isStateColliding(state, group, verbose);
+  }
+
+  // move the predicted objects in an overlay, which leaves the collision environments of this scene untouched
+  const PlanningScenePtr at_time = self->overlay();
+  Eigen::Isometry3d pose;
+  for (const auto& [object_id, motion] : predicted_object_motions_)
+  {
+    if (world_->hasObject(object_id) && getPredictedObjectPose(object_id, time, pose))
+      at_time->world_->setObjectPose(object_id, pose);
+  }
+  return at_time->isStateColliding(state, group, verbose);
+}
+
+bool PlanningScene::setPredictedObjectMotion(const std::string& object_id, const PredictedObjectMotion& motion)
+{
+  if (!world_->hasObject(object_id))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot set the predicted motion of '%s', the object does not exist", object_id.c_str());
+    return false;
+  }
+  if (motion.times.empty() || motion.times.size() != motion.poses.size() ||
+      !std::is_sorted(motion.times.begin(), motion.times.end()))
+  {
+    RCLCPP_ERROR(LOGGER, "The predicted motion of '%s' needs one pose for each of its increasing times",
+                 object_id.c_str());
+    return false;
+  }
+  predicted_object_motions_[object_id] = motion;
+  return true;
+}
+
+void PlanningScene::removePredictedObjectMotion(const std::string& object_id)
+{
+  predicted_object_motions_.erase(object_id);
+}
+
+bool PlanningScene::getPredictedObjectPose(const std::string& object_id, double time, Eigen::Isometry3d& pose) const
+{
+  const auto it = predicted_object_motions_.find(object_id);
+  if (it == predicted_object_motions_.end())
+    return false;
+
+  const std::vector<double>& times = it->second.times;
+  const EigenSTL::vector_Isometry3d& poses = it->second.poses;
+  const auto after = std::upper_bound(times.begin(), times.end(), time);
+  if (after == times.begin())
+  {
+    pose = poses.front();
+    return true;
+  }
+  if (after == times.end())
+  {
+    pose = poses.back();
+    return true;
+  }
+
+  const std::size_t i = after - times.begin();
+  const double alpha = (time - times[i - 1]) / (times[i] - times[i - 1]);
+  pose = Eigen::Isometry3d::Identity();
+  pose.translation() = (1.0 - alpha) * poses[i - 1].translation() + alpha * poses[i].translation();
+  pose.linear() = Eigen::Quaterniond(poses[i - 1].linear())
+                      .slerp(alpha, Eigen::Quaterniond(poses[i].linear()))
+                      .toRotationMatrix();
+  return true;
+}
+
 bool PlanningScene::isStateFeasible(const moveit_msgs::msg::RobotState& state, bool verbose) const
 {
   if (state_feasibility_)
@@ -2108,8 +2456,15 @@ bool PlanningScene::isStateConstrained(const moveit::core::RobotState& state,
 
 bool PlanningScene::isStateValid(const moveit::core::RobotState& state, const std::string& group, bool verbose) const
 {
-  static const moveit_msgs::msg::Constraints EMP_CONSTRAINTS;
-  return isStateValid(state, EMP_CONSTRAINTS, group, verbose);
+  return isStateValid(state, findCheckedGroup(*getRobotModel(), group), verbose);
+}
+
+bool PlanningScene::isStateValid(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                                 bool verbose) const
+{
+  if (isStateColliding(state, group, verbose))
+    return false;
+  return isStateFeasible(state, verbose);
 }
 
 bool PlanningScene::isStateValid(const moveit_msgs::msg::RobotState& state, const std::string& group, bool verbose) const
@@ -2139,6 +2494,13 @@ bool PlanningScene::isStateValid(const moveit::core::RobotState& state, const mo
 bool PlanningScene::isStateValid(const moveit::core::RobotState& state,
                                  const kinematic_constraints::KinematicConstraintSet& constr, const std::string& group,
                                  bool verbose) const
+{
+  return isStateValid(state, constr, findCheckedGroup(*getRobotModel(), group), verbose);
+}
+
+bool PlanningScene::isStateValid(const moveit::core::RobotState& state,
+                                 const kinematic_constraints::KinematicConstraintSet& constr,
+                                 const moveit::core::JointModelGroup* group, bool verbose) const
 {
   if (isStateColliding(state, group, verbose))
     return false;
@@ -2199,18 +2561,64 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
   ks_p.add(path_constraints, getTransforms());
   std::size_t n_wp = trajectory.getWayPointCount();
-  for (std::size_t i = 0; i < n_wp; ++i)
-  {
-    const moveit::core::RobotState& st = trajectory.getWayPoint(i);
+  const moveit::core::JointModelGroup* checked_group = findCheckedGroup(*getRobotModel(), group);
 
+  // with predicted object motions, each waypoint is checked at its time in the trajectory
+  const bool timed = !predicted_object_motions_.empty();
+  const auto is_waypoint_valid = [&](std::size_t i) {
+    const moveit::core::RobotState& st = trajectory.getWayPoint(i);
     bool this_state_valid = true;
-    if (isStateColliding(st, group, verbose))
+    if (timed ? isStateCollidingAt(st, checked_group, trajectory.getWayPointDurationFromStart(i), verbose) :
+                isStateColliding(st, checked_group, verbose))
       this_state_valid = false;
     if (!isStateFeasible(st, verbose))
       this_state_valid = false;
     if (!ks_p.empty() && !ks_p.decide(st, verbose).satisfied)
       this_state_valid = false;
+    return this_state_valid;
+  };
 
+  std::size_t thread_count = path_validity_thread_count_;
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, n_wp);
+
+  // validity of all waypoints is computed up front when multiple threads are used
+  std::vector<char> waypoint_valid;
+  if (thread_count > 1)
+  {
+    waypoint_valid.assign(n_wp, true);
+    std::atomic<std::size_t> next_waypoint{ 0 };
+    std::atomic<bool> abort{ false };
+    const auto check_waypoints = [&]() {
+      while (!abort)
+      {
+        const std::size_t i = next_waypoint++;
+        if (i >= n_wp)
+          break;
+        waypoint_valid[i] = is_waypoint_valid(i);
+        if (!waypoint_valid[i] && !invalid_index)
+          abort = true;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (std::size_t t = 1; t < thread_count; ++t)
+      threads.emplace_back(check_waypoints);
+    check_waypoints();
+    for (std::thread& thread : threads)
+      thread.join();
+
+    if (abort)
+      return false;
+  }
+
+  for (std::size_t i = 0; i < n_wp; ++i)
+  {
+    const moveit::core::RobotState& st = trajectory.getWayPoint(i);
+
+    bool this_state_valid = waypoint_valid.empty() ? is_waypoint_valid(i) : static_cast<bool>(waypoint_valid[i]);
     if (!this_state_valid)
     {
       if (invalid_index)
@@ -2274,6 +2682,84 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   return isPathValid(trajectory, EMP_CONSTRAINTS, EMP_CONSTRAINTS_VECTOR, group, verbose, invalid_index);
 }
 
+bool PlanningScene::areTrajectoriesColliding(const robot_trajectory::RobotTrajectory& trajectory1,
+                                             const robot_trajectory::RobotTrajectory& trajectory2,
+                                             double sample_duration, bool verbose,
+                                             std::vector<double>* colliding_times) const
+{
+  if (colliding_times)
+    colliding_times->clear();
+
+  const moveit::core::JointModelGroup* group1 = trajectory1.getGroup();
+  const moveit::core::JointModelGroup* group2 = trajectory2.getGroup();
+  if (!group1 || !group2 || trajectory1.empty() || trajectory2.empty() || !(sample_duration > 0.0))
+  {
+    RCLCPP_ERROR(LOGGER, "Checking a pair of trajectories requires two non-empty trajectories of joint model groups "
+                         "and a positive sample duration");
+    return true;
+  }
+  for (const moveit::core::JointModel* joint : group2->getActiveJointModels())
+  {
+    if (group1->hasJointModel(joint->getName()))
+    {
+      RCLCPP_ERROR(LOGGER, "Cannot check trajectories of groups '%s' and '%s', which share joint '%s'",
+                   group1->getName().c_str(), group2->getName().c_str(), joint->getName().c_str());
+      return true;
+    }
+  }
+
+  const double duration = std::max(trajectory1.getDuration(), trajectory2.getDuration());
+  const std::size_t sample_count = static_cast<std::size_t>(std::ceil(duration / sample_duration)) + 1;
+  const auto sample_time = [&](std::size_t i) { return std::min(static_cast<double>(i) * sample_duration, duration); };
+
+  std::size_t thread_count = path_validity_thread_count_;
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, sample_count);
+
+  std::vector<char> sample_colliding(sample_count, false);
+  std::atomic<std::size_t> next_sample{ 0 };
+  std::atomic<bool> abort{ false };
+  const auto check_samples = [&]() {
+    auto state = std::make_shared<moveit::core::RobotState>(trajectory1.getWayPoint(0));
+    auto state2 = std::make_shared<moveit::core::RobotState>(trajectory2.getWayPoint(0));
+    std::vector<double> group2_positions;
+    while (!abort)
+    {
+      const std::size_t i = next_sample++;
+      if (i >= sample_count)
+        break;
+      trajectory1.getStateAtDurationFromStart(sample_time(i), state);
+      trajectory2.getStateAtDurationFromStart(sample_time(i), state2);
+      state2->copyJointGroupPositions(group2, group2_positions);
+      state->setJointGroupPositions(group2, group2_positions);
+      sample_colliding[i] = isStateColliding(*state, nullptr, verbose);
+      if (sample_colliding[i] && !colliding_times)
+        abort = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(check_samples);
+  check_samples();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  bool colliding = false;
+  for (std::size_t i = 0; i < sample_count; ++i)
+  {
+    if (sample_colliding[i])
+    {
+      colliding = true;
+      if (colliding_times)
+        colliding_times->push_back(sample_time(i));
+    }
+  }
+  return colliding;
+}
+
 void PlanningScene::getCostSources(const robot_trajectory::RobotTrajectory& trajectory, std::size_t max_costs,
                                    std::set<collision_detection::CostSource>& costs, double overlap_fraction) const
 {
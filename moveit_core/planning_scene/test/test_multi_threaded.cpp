@@ -141,6 +141,43 @@ TEST_P(CollisionDetectorTests, Threaded)
   planning_scene_.reset();
 }
 
+/** \brief Tests that checking a path in multiple threads reports the same invalid waypoints as a sequential check. */
+TEST_P(CollisionDetectorTests, ThreadedPathValidity)
+{
+  const std::string plugin_name = GetParam();
+  SCOPED_TRACE(plugin_name);
+
+  collision_detection::CollisionPluginCache loader;
+  if (!loader.activate(plugin_name, planning_scene_))
+  {
+#if defined(GTEST_SKIP_)
+    GTEST_SKIP_("Failed to load collision plugin");
+#else
+    return;
+#endif
+  }
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, "panda_arm");
+  moveit::core::RobotState state{ robot_model_ };
+  for (unsigned int i = 0; i < 200; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+    trajectory.addSuffixWayPoint(state, 0.1);
+  }
+
+  std::vector<std::size_t> sequential_invalid;
+  const bool sequential_valid = planning_scene_->isPathValid(trajectory, "panda_arm", false, &sequential_invalid);
+
+  planning_scene_->setPathValidityThreadCount(4);
+  std::vector<std::size_t> threaded_invalid;
+  EXPECT_EQ(sequential_valid, planning_scene_->isPathValid(trajectory, "panda_arm", false, &threaded_invalid));
+  EXPECT_EQ(sequential_invalid, threaded_invalid);
+  EXPECT_EQ(sequential_valid, planning_scene_->isPathValid(trajectory, "panda_arm"));
+
+  planning_scene_.reset();
+}
+
 #ifndef INSTANTIATE_TEST_SUITE_P  // prior to gtest 1.10
 #define INSTANTIATE_TEST_SUITE_P(...) INSTANTIATE_TEST_CASE_P(__VA_ARGS__)
 #endif
@@ -46,6 +46,7 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/collision_detection/occupancy_map.h>
 #include <moveit/collision_detection/collision_plugin_cache.h>
 
 // Test not setting the object's pose should use the shape pose as the object pose
@@ -75,6 +76,49 @@ TEST(PlanningScene, TestOneShapeObjectPose)
   EXPECT_TRUE(expected_transfrom.isApprox(ps.getFrameTransform(object_name)));
 }
 
+// Frames resolved once are updated when the world changes
+TEST(PlanningScene, FrameTransformsFollowWorldChanges)
+{
+  urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
+  srdf::ModelSharedPtr srdf_model = std::make_shared<srdf::Model>();
+  planning_scene::PlanningScene ps(urdf_model, srdf_model);
+  const collision_detection::WorldPtr& world = ps.getWorldNonConst();
+
+  EXPECT_FALSE(ps.knowsFrameTransform("object"));
+  EXPECT_FALSE(ps.knowsFrameTransform("object/tip"));
+  EXPECT_TRUE(ps.knowsFrameTransform("r_gripper_palm_link"));
+  EXPECT_TRUE(ps.getFrameTransform("r_gripper_palm_link")
+                  .isApprox(ps.getCurrentState().getGlobalLinkTransform("r_gripper_palm_link")));
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 1.0;
+  world->addToObject("object", std::make_shared<shapes::Box>(0.1, 0.1, 0.1), pose);
+  ASSERT_TRUE(ps.knowsFrameTransform("object"));
+  EXPECT_TRUE(ps.getFrameTransform("object").isApprox(pose));
+  EXPECT_FALSE(ps.knowsFrameTransform("object/tip"));
+
+  Eigen::Isometry3d tip = Eigen::Isometry3d::Identity();
+  tip.translation().z() = 0.5;
+  moveit::core::FixedTransformsMap subframes;
+  subframes["tip"] = tip;
+  ASSERT_TRUE(world->setSubframesOfObject("object", subframes));
+  ASSERT_TRUE(ps.knowsFrameTransform("object/tip"));
+  EXPECT_TRUE(ps.getFrameTransform("/object/tip").isApprox(pose * tip));
+
+  Eigen::Isometry3d new_pose = Eigen::Isometry3d::Identity();
+  new_pose.translation().y() = 2.0;
+  ASSERT_TRUE(world->setObjectPose("object", new_pose));
+  EXPECT_TRUE(ps.getFrameTransform("object").isApprox(new_pose));
+  EXPECT_TRUE(ps.getFrameTransform("object/tip").isApprox(new_pose * tip));
+
+  // fixed frames are looked up once the world does not know the frame anymore
+  ps.getTransformsNonConst().setTransform(pose, "object");
+  ASSERT_TRUE(world->removeObject("object"));
+  EXPECT_TRUE(ps.knowsFrameTransform("object"));
+  EXPECT_TRUE(ps.getFrameTransform("object").isApprox(pose));
+  EXPECT_FALSE(ps.knowsFrameTransform("object/tip"));
+}
+
 TEST(PlanningScene, LoadRestore)
 {
   urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
@@ -191,6 +235,81 @@ TEST(PlanningScene, isStateValid)
   }
 }
 
+TEST(PlanningScene, TrajectoriesColliding)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  auto ps = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  ASSERT_FALSE(ps->isStateColliding(state));
+
+  // the left arm stays where it is for 3s, the right arm swings out during 2s
+  robot_trajectory::RobotTrajectory left(robot_model, "left_arm");
+  left.addSuffixWayPoint(state, 0.0).addSuffixWayPoint(state, 3.0);
+  robot_trajectory::RobotTrajectory right(robot_model, "right_arm");
+  right.addSuffixWayPoint(state, 0.0);
+  moveit::core::RobotState swung_out(state);
+  swung_out.setVariablePosition("r_shoulder_pan_joint", -0.5);
+  swung_out.update();
+  right.addSuffixWayPoint(swung_out, 2.0);
+
+  EXPECT_FALSE(ps->areTrajectoriesColliding(left, right, 0.1));
+
+  // put a small box where the right gripper ends up
+  ps->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.05, 0.05, 0.05),
+                                      swung_out.getGlobalLinkTransform("r_gripper_palm_link"));
+  std::vector<double> colliding_times;
+  EXPECT_TRUE(ps->areTrajectoriesColliding(left, right, 0.1, false, &colliding_times));
+  ASSERT_FALSE(colliding_times.empty());
+  EXPECT_GT(colliding_times.front(), 0.0);
+  EXPECT_LE(colliding_times.front(), 2.0);
+  EXPECT_DOUBLE_EQ(colliding_times.back(), 3.0);
+
+  // the samples do not depend on the number of threads
+  ps->setPathValidityThreadCount(4);
+  std::vector<double> parallel_colliding_times;
+  EXPECT_TRUE(ps->areTrajectoriesColliding(left, right, 0.1, false, &parallel_colliding_times));
+  EXPECT_EQ(parallel_colliding_times, colliding_times);
+  EXPECT_TRUE(ps->areTrajectoriesColliding(right, left, 0.1));
+
+  // groups sharing joints cannot be checked
+  robot_trajectory::RobotTrajectory both(robot_model, "arms");
+  both.addSuffixWayPoint(state, 0.0);
+  EXPECT_TRUE(ps->areTrajectoriesColliding(both, right, 0.1));
+}
+
+TEST(PlanningScene, GroupHandles)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  auto ps = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  ps->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.05, 0.05, 0.05),
+                                      state.getGlobalLinkTransform("r_gripper_palm_link"));
+
+  // checks of a group handle agree with the checks of the group name
+  const moveit::core::JointModelGroup* left_arm = robot_model->getJointModelGroup("left_arm");
+  const moveit::core::JointModelGroup* right_arm = robot_model->getJointModelGroup("right_arm");
+  EXPECT_FALSE(ps->isStateColliding(state, "left_arm"));
+  EXPECT_FALSE(ps->isStateColliding(state, left_arm));
+  EXPECT_TRUE(ps->isStateValid(state, left_arm));
+  EXPECT_TRUE(ps->isStateColliding(state, "right_arm"));
+  EXPECT_TRUE(ps->isStateColliding(state, right_arm));
+  EXPECT_FALSE(ps->isStateValid(state, right_arm));
+  EXPECT_TRUE(ps->isStateColliding(state, nullptr));
+  EXPECT_TRUE(ps->isStateColliding(state, ""));
+
+  // a handle set in a request takes precedence over the group name
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+  req.group = left_arm;
+  collision_detection::CollisionResult res;
+  ps->checkCollision(req, res, state);
+  EXPECT_FALSE(res.collision);
+}
+
 TEST(PlanningScene, loadGoodSceneGeometryNewFormat)
 {
   moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
@@ -303,6 +422,134 @@ TEST(PlanningScene, FailRetrievingNonExistentObject)
   EXPECT_FALSE(ps.getCollisionObjectMsg(obj, "non_existent_object"));
 }
 
+TEST(PlanningScene, OctomapUpdates)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  planning_scene::PlanningScene sender{ robot_model };
+  planning_scene::PlanningScene receiver{ robot_model };
+
+  auto octree = std::make_shared<collision_detection::OccMapTree>(0.1);
+  octree->updateNode(octomap::point3d(1.0, 0.0, 0.0), true);
+  octree->updateNode(octomap::point3d(1.0, 1.0, 0.0), true);
+  sender.processOctomapPtr(octree, Eigen::Isometry3d::Identity());
+
+  octomap_msgs::msg::OctomapWithPose full;
+  ASSERT_TRUE(sender.getOctomapMsg(full));
+  receiver.processOctomapMsg(full);
+
+  // occupy one cell and delete another
+  auto changed_octree = std::make_shared<collision_detection::OccMapTree>(*octree);
+  const octomap::OcTreeKey added = changed_octree->coordToKey(0.0, 2.0, 0.0);
+  const octomap::OcTreeKey deleted = changed_octree->coordToKey(1.0, 1.0, 0.0);
+  changed_octree->updateNode(added, true);
+  changed_octree->deleteNode(deleted);
+  sender.processOctomapPtr(changed_octree, Eigen::Isometry3d::Identity());
+
+  octomap_msgs::msg::OctomapWithPose update;
+  ASSERT_TRUE(sender.getOctomapUpdateMsg({ added, deleted }, 1, update));
+  EXPECT_EQ(update.octomap.id, planning_scene::PlanningScene::OCTOMAP_UPDATE_ID);
+  receiver.processOctomapMsg(update);
+
+  const auto received_octree = [&receiver] {
+    const collision_detection::World::ObjectConstPtr object =
+        receiver.getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+    EXPECT_TRUE(object);
+    return static_cast<const shapes::OcTree*>(object->shapes_[0].get())->octree;
+  };
+  const octomap::OcTreeNode* added_node = received_octree()->search(added);
+  ASSERT_NE(added_node, nullptr);
+  EXPECT_TRUE(received_octree()->isNodeOccupied(added_node));
+  EXPECT_EQ(received_octree()->search(deleted), nullptr);
+  EXPECT_NE(received_octree()->search(octomap::point3d(1.0, 0.0, 0.0)), nullptr);
+
+  // updates that do not follow the last applied one are ignored
+  const octomap::OcTreeKey skipped = changed_octree->coordToKey(0.0, 3.0, 0.0);
+  changed_octree->updateNode(skipped, true);
+  ASSERT_TRUE(sender.getOctomapUpdateMsg({ skipped }, 3, update));
+  receiver.processOctomapMsg(update);
+  EXPECT_EQ(received_octree()->search(skipped), nullptr);
+}
+
+TEST(PlanningScene, MemoryUsage)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  auto parent = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  parent->getWorldNonConst()->addToObject("box", std::make_shared<const shapes::Box>(0.1, 0.1, 0.1),
+                                         Eigen::Isometry3d::Identity());
+  auto octree = std::make_shared<collision_detection::OccMapTree>(0.1);
+  octree->updateNode(octomap::point3d(1.0, 0.0, 0.0), true);
+  parent->processOctomapPtr(octree, Eigen::Isometry3d::Identity());
+
+  planning_scene::PlanningScenePtr child = parent->diff();
+  child->getWorldNonConst()->addToObject("sphere", std::make_shared<const shapes::Sphere>(0.1),
+                                        Eigen::Isometry3d::Identity());
+
+  const std::vector<collision_detection::MemoryUsage> layers = child->getMemoryUsage();
+  ASSERT_EQ(layers.size(), 2u);
+
+  // the child only counts the object it added
+  EXPECT_EQ(layers[0].world_objects.size(), 1u);
+  EXPECT_EQ(layers[0].world_objects.count("sphere"), 1u);
+  EXPECT_TRUE(layers[0].octrees.empty());
+  EXPECT_EQ(layers[0].collision_geometry.count("sphere"), 1u);
+  EXPECT_EQ(layers[0].collision_geometry.count("box"), 0u);
+
+  // the parent counts its objects, the octree and the robot links
+  EXPECT_EQ(layers[1].world_objects.count("box"), 1u);
+  EXPECT_EQ(layers[1].world_objects.count("sphere"), 0u);
+  ASSERT_EQ(layers[1].octrees.count(planning_scene::PlanningScene::OCTOMAP_NS), 1u);
+  EXPECT_GE(layers[1].octrees.at(planning_scene::PlanningScene::OCTOMAP_NS), octree->memoryUsage());
+  EXPECT_EQ(layers[1].collision_geometry.count("box"), 1u);
+  EXPECT_EQ(layers[1].collision_geometry.count("base_link"), 1u);
+  EXPECT_GT(layers[1].getTotal(), layers[0].getTotal());
+}
+
+TEST(PlanningScene, PredictedObjectMotion)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  auto ps = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  // only collisions with the world are of interest here
+  ps->getAllowedCollisionMatrixNonConst().setEntry(true);
+  Eigen::Isometry3d far = Eigen::Isometry3d::Identity();
+  far.translation().x() = 10.0;
+  ps->getWorldNonConst()->addToObject("agv", far, std::make_shared<shapes::Box>(0.5, 0.5, 0.5),
+                                      Eigen::Isometry3d::Identity());
+
+  moveit::core::RobotState state = ps->getCurrentState();
+  state.updateCollisionBodyTransforms();
+  EXPECT_FALSE(ps->isStateColliding(state, ""));
+
+  // the object drives into the robot base within one second
+  planning_scene::PlanningScene::PredictedObjectMotion motion;
+  motion.times = { 0.0, 1.0 };
+  motion.poses = { far, Eigen::Isometry3d::Identity() };
+  EXPECT_FALSE(ps->setPredictedObjectMotion("unknown", motion));
+  ASSERT_TRUE(ps->setPredictedObjectMotion("agv", motion));
+
+  Eigen::Isometry3d pose;
+  ASSERT_TRUE(ps->getPredictedObjectPose("agv", 0.5, pose));
+  EXPECT_NEAR(pose.translation().x(), 5.0, 1e-9);
+  ASSERT_TRUE(ps->getPredictedObjectPose("agv", 2.0, pose));
+  EXPECT_TRUE(pose.isApprox(Eigen::Isometry3d::Identity()));
+
+  EXPECT_FALSE(ps->isStateCollidingAt(state, "", 0.0));
+  EXPECT_TRUE(ps->isStateCollidingAt(state, "", 1.0));
+  // the world itself is not changed by the predictions
+  EXPECT_FALSE(ps->isStateColliding(state, ""));
+
+  // a path is checked at the time of each waypoint
+  robot_trajectory::RobotTrajectory trajectory(robot_model);
+  trajectory.addSuffixWayPoint(state, 0.0);
+  EXPECT_TRUE(ps->isPathValid(trajectory));
+  trajectory.addSuffixWayPoint(state, 1.0);
+  std::vector<std::size_t> invalid_index;
+  EXPECT_FALSE(ps->isPathValid(trajectory, "", false, &invalid_index));
+  EXPECT_EQ(invalid_index, std::vector<std::size_t>{ 1 });
+
+  ps->removePredictedObjectMotion("agv");
+  EXPECT_FALSE(ps->isStateCollidingAt(state, "", 1.0));
+}
+
 class CollisionDetectorTests : public testing::TestWithParam<const char*>
 {
 };
@@ -391,6 +638,70 @@ TEST_P(CollisionDetectorTests, ClearDiff)
   parent.reset();
 }
 
+TEST_P(CollisionDetectorTests, Overlay)
+{
+  const std::string plugin_name = GetParam();
+  SCOPED_TRACE(plugin_name);
+
+  urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
+  srdf::ModelSharedPtr srdf_model = std::make_shared<srdf::Model>();
+  planning_scene::PlanningScenePtr parent = std::make_shared<planning_scene::PlanningScene>(urdf_model, srdf_model);
+
+  collision_detection::CollisionPluginCache loader;
+  if (!loader.activate(plugin_name, parent))
+  {
+#if defined(GTEST_SKIP_)
+    GTEST_SKIP_("Failed to load collision plugin");
+#else
+    return;
+#endif
+  }
+
+  moveit_msgs::msg::CollisionObject co;
+  co.header.frame_id = "base_link";
+  co.operation = moveit_msgs::msg::CollisionObject::ADD;
+  co.id = "box";
+  co.pose.orientation.w = 1.0;
+  {
+    shape_msgs::msg::SolidPrimitive sp;
+    sp.type = shape_msgs::msg::SolidPrimitive::BOX;
+    sp.dimensions = { 1., 1., 1. };
+    co.primitives.push_back(sp);
+    geometry_msgs::msg::Pose sp_pose;
+    sp_pose.orientation.w = 1.0;
+    co.primitive_poses.push_back(sp_pose);
+  }
+  EXPECT_TRUE(parent->processCollisionObjectMsg(co));
+
+  moveit::core::RobotState state(parent->getRobotModel());
+  state.setToDefaultValues();
+  state.update();
+  const auto in_collision = [&state](const planning_scene::PlanningScene& scene) {
+    collision_detection::CollisionRequest req;
+    collision_detection::CollisionResult res;
+    scene.getCollisionEnv()->checkRobotCollision(req, res, state, scene.getAllowedCollisionMatrix());
+    return res.collision;
+  };
+
+  planning_scene::PlanningScenePtr child = parent->overlay();
+  EXPECT_TRUE(in_collision(*child));
+
+  // removing the object in the child does not affect the parent
+  co.operation = moveit_msgs::msg::CollisionObject::REMOVE;
+  EXPECT_TRUE(child->processCollisionObjectMsg(co));
+  EXPECT_FALSE(in_collision(*child));
+  EXPECT_TRUE(in_collision(*parent));
+
+  child->clearDiffs();
+  EXPECT_TRUE(in_collision(*child));
+
+  // a decoupled child does not depend on the parent anymore
+  child->decoupleParent();
+  EXPECT_TRUE(parent->processCollisionObjectMsg(co));
+  EXPECT_FALSE(in_collision(*parent));
+  EXPECT_TRUE(in_collision(*child));
+}
+
 // Returns a planning scene diff message
 moveit_msgs::msg::PlanningScene create_planning_scene_diff(const planning_scene::PlanningScene& ps,
                                                            const std::string& object_name, const int8_t operation,
@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Geometry>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+class JointModel;
+
+MOVEIT_CLASS_FORWARD(CompiledForwardKinematics);  // Defines CompiledForwardKinematicsPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Forward kinematics generated for the subtree of one joint of a specific robot model.
+
+    Implementations are generated from the URDF of the robot, with the fixed transforms of the subtree folded into
+    constants and the joint transforms specialized for their types and axes (see create_compiled_fk_plugin.py in
+    moveit_kinematics). A RobotModel given such an implementation with RobotModel::setCompiledForwardKinematics()
+    makes RobotState compute the transforms of the subtree with it instead of dispatching per joint. */
+class CompiledForwardKinematics
+{
+public:
+  virtual ~CompiledForwardKinematics() = default;
+
+  /** \brief The name of the robot model the kinematics were generated for */
+  virtual std::string getRobotModelName() const = 0;
+
+  /** \brief The joint whose subtree the kinematics compute */
+  virtual std::string getRootJointName() const = 0;
+
+  /** \brief The links below the root joint, in the order their transforms are computed; each link comes after its
+      parent link */
+  virtual std::vector<std::string> getLinkNames() const = 0;
+
+  /** \brief The variables the transforms depend on, in the order of \e variable_indices in computeLinkTransforms() */
+  virtual std::vector<std::string> getVariableNames() const = 0;
+
+  /** \brief Compute the global transforms of the links below the root joint.
+      \param base The global transform of the parent link of the root joint
+      \param positions The variable positions of a robot state; variable i of getVariableNames() is at
+                       positions[variable_indices[i]]
+      \param link_transforms The global link transforms of a robot state; the transform of link i of getLinkNames() is
+                             written to link_transforms[link_indices[i]] */
+  virtual void computeLinkTransforms(const Eigen::Isometry3d& base, const double* positions,
+                                     const int* variable_indices, Eigen::Isometry3d* link_transforms,
+                                     const int* link_indices) const = 0;
+};
+
+/** \brief A CompiledForwardKinematics resolved against the links and variables of a robot model */
+struct CompiledForwardKinematicsBinding
+{
+  CompiledForwardKinematicsConstPtr kinematics;
+  const JointModel* root_joint;
+  std::vector<int> variable_indices;
+  std::vector<int> link_indices;
+};
+}  // namespace core
+}  // namespace moveit
@@ -368,6 +368,35 @@ public:
   void getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng, double* values,
                                   const JointBoundsVector& active_joint_bounds) const;
 
+  /** \brief Matrix of states of the joint group, one state per row */
+  using VariablePositionsMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /** \brief Compute \e count random states of the joint group, one per row of \e values
+   *
+   * The rows are sampled in blocks, each from its own random stream seeded from \e rng, so the result doesn't depend
+   * on \e thread_count. Revolute and prismatic joints are sampled a column of a block at a time, other joints one
+   * state at a time. */
+  void getVariableRandomPositionsBatch(random_numbers::RandomNumberGenerator& rng, VariablePositionsMatrix& values,
+                                       std::size_t count, std::size_t thread_count = 1) const
+  {
+    getVariableRandomPositionsBatch(rng, values, count, active_joint_models_bounds_, nullptr, 0.0, thread_count);
+  }
+
+  /** \brief Compute \e count random states of the joint group within \e distance of \e near for every variable, one
+   * per row of \e values. The same as getVariableRandomPositionsBatch() otherwise. */
+  void getVariableRandomPositionsNearByBatch(random_numbers::RandomNumberGenerator& rng,
+                                             VariablePositionsMatrix& values, std::size_t count, const double* near,
+                                             double distance, std::size_t thread_count = 1) const
+  {
+    getVariableRandomPositionsBatch(rng, values, count, active_joint_models_bounds_, near, distance, thread_count);
+  }
+
+  /** \brief Compute \e count random states of the joint group within \e active_joint_bounds, one per row of \e values.
+   * If \e near is not nullptr, the states are sampled within \e distance of it. */
+  void getVariableRandomPositionsBatch(random_numbers::RandomNumberGenerator& rng, VariablePositionsMatrix& values,
+                                       std::size_t count, const JointBoundsVector& active_joint_bounds,
+                                       const double* near, double distance, std::size_t thread_count = 1) const;
+
   /** \brief Compute random values for the state of the joint group */
   void getVariableRandomPositionsNearBy(random_numbers::RandomNumberGenerator& rng, double* values,
                                         const JointBoundsVector& active_joint_bounds, const double* near,
@@ -0,0 +1,148 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <geometric_shapes/shapes.h>
+#include <Eigen/Core>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(MeshCache);  // Defines MeshCachePtr, ConstPtr, WeakPtr... etc
+
+/** \brief Meshes loaded for the links of a robot model, keyed by their resource and scale
+
+    Loading and parsing mesh resources dominates the construction time of a RobotModel. A RobotModel constructed with a
+    cache takes the meshes it already holds and adds the ones it loads, so that the cache can be written to a file
+    and read by later processes instead of loading the resources again.
+    The key identifies the robot description the meshes were loaded for; a cache is only read back for the same key.
+    The cache can also replace each mesh by a simplified collision geometry; the simplified meshes are keyed by a
+    hash of the mesh they were computed from and are written to the file as well, so they are computed only once.
+    This class is not thread safe, but loadMeshes() loads resources concurrently. */
+class MeshCache
+{
+public:
+  /** \brief The collision geometry returned by getMesh() */
+  enum class Simplification
+  {
+    NONE,        // the mesh as loaded from the resource
+    CONVEX_HULL  // the convex hull of the loaded mesh
+  };
+
+  /** \brief Compute a key identifying a robot description from its URDF and SRDF documents */
+  static std::uint64_t computeKey(const std::string& urdf_string, const std::string& srdf_string);
+
+  explicit MeshCache(std::uint64_t key = 0) : key_(key)
+  {
+  }
+
+  std::uint64_t getKey() const
+  {
+    return key_;
+  }
+
+  /** \brief Set the simplification applied to the meshes returned by getMesh() */
+  void setSimplification(Simplification simplification)
+  {
+    simplification_ = simplification;
+  }
+
+  Simplification getSimplification() const
+  {
+    return simplification_;
+  }
+
+  /** \brief Compute a hash of the vertices and triangles of \e mesh */
+  static std::uint64_t computeMeshHash(const shapes::Mesh& mesh);
+
+  /** \brief Get the mesh loaded from \e resource with \e scale, loading the resource if the cache does not hold it
+      yet, and simplified as set by setSimplification(). Returns nullptr if the resource can not be loaded. */
+  shapes::ShapePtr getMesh(const std::string& resource, const Eigen::Vector3d& scale);
+
+  /** \brief Load the meshes in \e resources (resource and scale) that the cache does not hold yet, using up to
+      \e thread_count threads (0 uses one thread per core). The cache contents do not depend on the number of threads.
+      Resources that fail to load are remembered and not loaded again by getMesh(). The simplified meshes that are
+      missing are computed concurrently as well. */
+  void loadMeshes(const std::vector<std::pair<std::string, Eigen::Vector3d>>& resources, unsigned int thread_count = 0);
+
+  /** \brief The number of meshes in the cache */
+  std::size_t size() const
+  {
+    return meshes_.size();
+  }
+
+  /** \brief The number of simplified meshes in the cache */
+  std::size_t simplifiedSize() const
+  {
+    return hulls_.size();
+  }
+
+  /** \brief True if meshes were loaded or simplified since the cache was created or read */
+  bool isModified() const
+  {
+    return modified_;
+  }
+
+  /** \brief Write the cache to \e filename, returns false on failure */
+  bool writeToFile(const std::string& filename) const;
+
+  /** \brief Read a cache written by writeToFile(). Returns nullptr if the file can not be read, is of another version
+      or was written for a different key. */
+  static MeshCachePtr readFromFile(const std::string& filename, std::uint64_t key);
+
+private:
+  using MeshKey = std::pair<std::string, std::array<double, 3>>;
+
+  /** \brief The convex hull of \e mesh, or \e mesh itself if the hull is degenerate */
+  static std::shared_ptr<const shapes::Mesh> computeConvexHull(const std::shared_ptr<const shapes::Mesh>& mesh);
+
+  std::uint64_t key_;
+  Simplification simplification_ = Simplification::NONE;
+  std::map<MeshKey, std::shared_ptr<const shapes::Mesh>> meshes_;
+  std::map<std::uint64_t, std::shared_ptr<const shapes::Mesh>> hulls_;  // keyed by the hash of the original mesh
+  std::set<MeshKey> failed_;  // resources that could not be loaded
+  bool modified_ = false;
+};
+}  // namespace core
+}  // namespace moveit
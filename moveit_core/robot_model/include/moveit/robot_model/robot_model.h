@@ -48,6 +48,8 @@
 #include <moveit/robot_model/planar_joint_model.h>
 #include <moveit/robot_model/revolute_joint_model.h>
 #include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/mesh_cache.h>
+#include <moveit/robot_model/compiled_forward_kinematics.h>
 #include <rclcpp/logging.hpp>
 #include <Eigen/Geometry>
 #include <iostream>
@@ -78,6 +80,11 @@ public:
   /** \brief Construct a kinematic model from a parsed description and a list of planning groups */
   RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model);
 
+  /** \brief Construct a kinematic model, taking link meshes from \e mesh_cache and adding the ones it does not hold yet
+   */
+  RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model,
+             const MeshCachePtr& mesh_cache);
+
   /** \brief Destructor. Clear all memory. */
   ~RobotModel();
 
@@ -373,8 +380,9 @@ public:
   /** \brief Check if the JointModelGroup \e group exists */
   bool hasJointModelGroup(const std::string& group) const;
 
-  /** \brief Get a joint group from this model (by name) */
-  const JointModelGroup* getJointModelGroup(const std::string& name) const;
+  /** \brief Get a joint group from this model (by name). Output error and return nullptr when the group is missing,
+   * unless \e has_group is given, which reports whether it exists instead. */
+  const JointModelGroup* getJointModelGroup(const std::string& name, bool* has_group = nullptr) const;
 
   /** \brief Get a joint group from this model (by name) */
   JointModelGroup* getJointModelGroup(const std::string& name);
@@ -460,6 +468,18 @@ public:
   /// A map of known kinematics solvers (associated to their group name)
   void setKinematicsAllocators(const std::map<std::string, SolverAllocatorFn>& allocators);
 
+  /** \brief Make robot states compute the transforms of the links below the root joint of \e kinematics with them.
+      The kinematics are compared to the ones of the model for a few random configurations and are not used if they
+      differ, e.g. because they were generated for an older version of the URDF. They replace kinematics set before
+      for overlapping subtrees. This is not thread safe: call it before any robot state of the model is used. */
+  bool setCompiledForwardKinematics(const CompiledForwardKinematicsConstPtr& kinematics);
+
+  /** \brief The compiled forward kinematics that compute the transform of \e link, nullptr if there are none */
+  const CompiledForwardKinematicsBinding* getCompiledForwardKinematics(const LinkModel* link) const
+  {
+    return compiled_kinematics_of_link_.empty() ? nullptr : compiled_kinematics_of_link_[link->getLinkIndex()];
+  }
+
 protected:
   /** \brief Get the transforms between link and all its rigidly attached descendants */
   void computeFixedTransforms(const LinkModel* link, const Eigen::Isometry3d& transform,
@@ -484,6 +504,9 @@ protected:
 
   urdf::ModelInterfaceSharedPtr urdf_;
 
+  /** \brief The cache meshes are taken from while the model is built; a temporary one if none was passed */
+  MeshCachePtr mesh_cache_;
+
   // LINKS
 
   /** \brief The first physical link for the robot */
@@ -555,6 +578,12 @@ protected:
    */
   std::vector<int> common_joint_roots_;
 
+  /** \brief Compiled forward kinematics of disjoint subtrees, see setCompiledForwardKinematics() */
+  std::vector<std::unique_ptr<CompiledForwardKinematicsBinding>> compiled_kinematics_;
+
+  /** \brief For each link index, the compiled forward kinematics computing its transform, if any */
+  std::vector<const CompiledForwardKinematicsBinding*> compiled_kinematics_of_link_;
+
   // INDEXING
 
   /** \brief The names of the DOF that make up this state (this is just a sequence of joint variable names; not
@@ -42,6 +42,11 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
 
 #include "order_robot_model_items.inc"
 
@@ -346,6 +351,115 @@ void JointModelGroup::getVariableRandomPositions(random_numbers::RandomNumberGen
   updateMimicJoints(values);
 }
 
+void JointModelGroup::getVariableRandomPositionsBatch(random_numbers::RandomNumberGenerator& rng,
+                                                      VariablePositionsMatrix& values, std::size_t count,
+                                                      const JointBoundsVector& active_joint_bounds, const double* near,
+                                                      double distance, std::size_t thread_count) const
+{
+  assert(active_joint_bounds.size() == active_joint_model_vector_.size());
+  values.resize(count, variable_count_);
+
+  // revolute and prismatic joints are uniform in an interval, which is sampled for a column of a block at once
+  struct IntervalColumn
+  {
+    std::size_t column;
+    double min;
+    double max;
+    bool wrap;  // continuous revolute joints sampled near a state are wrapped to [-pi, pi]
+  };
+  std::vector<IntervalColumn> interval_columns;
+  std::vector<std::size_t> other_joints;
+  for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
+  {
+    const JointModel* joint = active_joint_model_vector_[i];
+    const JointModel::Bounds& bounds = *active_joint_bounds[i];
+    const std::size_t column = active_joint_model_start_index_[i];
+    if (joint->getType() == JointModel::PRISMATIC ||
+        (joint->getType() == JointModel::REVOLUTE && !static_cast<const RevoluteJointModel*>(joint)->isContinuous()))
+    {
+      if (near)
+      {
+        interval_columns.push_back({ column, std::max(bounds[0].min_position_, near[column] - distance),
+                                     std::min(bounds[0].max_position_, near[column] + distance), false });
+      }
+      else
+        interval_columns.push_back({ column, bounds[0].min_position_, bounds[0].max_position_, false });
+    }
+    else if (joint->getType() == JointModel::REVOLUTE)
+    {
+      if (near)
+        interval_columns.push_back({ column, near[column] - distance, near[column] + distance, true });
+      else
+        interval_columns.push_back({ column, bounds[0].min_position_, bounds[0].max_position_, false });
+    }
+    else
+      other_joints.push_back(i);
+  }
+
+  constexpr std::size_t BLOCK_SIZE = 256;
+  const std::size_t block_count = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::vector<std::uint32_t> seeds(block_count);
+  for (std::uint32_t& seed : seeds)
+    seed = static_cast<std::uint32_t>(rng.uniformInteger(0, std::numeric_limits<int>::max()));
+
+  std::atomic<std::size_t> next_block{ 0 };
+  const auto sample_blocks = [&] {
+    for (std::size_t block = next_block++; block < block_count; block = next_block++)
+    {
+      random_numbers::RandomNumberGenerator block_rng(seeds[block]);
+      const std::size_t begin = block * BLOCK_SIZE;
+      const std::size_t end = std::min(count, begin + BLOCK_SIZE);
+      for (const IntervalColumn& interval : interval_columns)
+      {
+        const double range = interval.max - interval.min;
+        for (std::size_t row = begin; row < end; ++row)
+          values(row, interval.column) = interval.min + range * block_rng.uniform01();
+        if (interval.wrap)
+        {
+          for (std::size_t row = begin; row < end; ++row)
+          {
+            double& v = values(row, interval.column);
+            if (v <= -M_PI || v > M_PI)
+            {
+              v = fmod(v, 2.0 * M_PI);
+              if (v <= -M_PI)
+                v += 2.0 * M_PI;
+              else if (v > M_PI)
+                v -= 2.0 * M_PI;
+            }
+          }
+        }
+      }
+      for (std::size_t row = begin; row < end; ++row)
+      {
+        double* state = values.row(row).data();
+        for (const std::size_t i : other_joints)
+        {
+          const JointModel* joint = active_joint_model_vector_[i];
+          const std::size_t start = active_joint_model_start_index_[i];
+          if (near)
+          {
+            joint->getVariableRandomPositionsNearBy(block_rng, state + start, *active_joint_bounds[i], near + start,
+                                                    distance);
+          }
+          else
+            joint->getVariableRandomPositions(block_rng, state + start, *active_joint_bounds[i]);
+        }
+        updateMimicJoints(state);
+      }
+    }
+  };
+
+  thread_count = std::max<std::size_t>(1, std::min(thread_count, block_count));
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(sample_blocks);
+  sample_blocks();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
 void JointModelGroup::getVariableRandomPositionsNearBy(random_numbers::RandomNumberGenerator& rng, double* values,
                                                        const JointBoundsVector& active_joint_bounds, const double* near,
                                                        double distance) const
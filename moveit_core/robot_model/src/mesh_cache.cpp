@@ -0,0 +1,386 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/mesh_cache.h>
+#include <geometric_shapes/bodies.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace moveit
+{
+namespace core
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_robot_model.mesh_cache");
+
+namespace
+{
+/// Header of a cache file; the entries follow, each as resource length, resource, scale, counts, vertices, triangles.
+/// After the entries come the number of simplified meshes and each of them as hash, counts, vertices, triangles.
+struct CacheHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t key;
+  std::uint64_t entry_count;
+};
+
+const char CACHE_MAGIC[8] = { 'M', 'V', 'I', 'T', 'M', 'E', 'S', 'H' };
+const std::uint32_t CACHE_VERSION = 2;
+const std::uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+template <typename T>
+void writeValue(std::ostream& os, const T& value)
+{
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::istream& is, T& value)
+{
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void writeMesh(std::ostream& os, const shapes::Mesh& mesh)
+{
+  writeValue(os, static_cast<std::uint32_t>(mesh.vertex_count));
+  writeValue(os, static_cast<std::uint32_t>(mesh.triangle_count));
+  os.write(reinterpret_cast<const char*>(mesh.vertices), sizeof(double) * 3 * mesh.vertex_count);
+  os.write(reinterpret_cast<const char*>(mesh.triangles), sizeof(unsigned int) * 3 * mesh.triangle_count);
+}
+
+/// Read a mesh written by writeMesh(), returns nullptr (and logs) if it is truncated or corrupt
+std::shared_ptr<shapes::Mesh> readMesh(std::istream& is, const std::string& filename)
+{
+  std::uint32_t vertex_count, triangle_count;
+  if (!readValue(is, vertex_count) || !readValue(is, triangle_count))
+  {
+    RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is truncated", filename.c_str());
+    return nullptr;
+  }
+  auto mesh = std::make_shared<shapes::Mesh>(vertex_count, triangle_count);
+  const bool ok = is.read(reinterpret_cast<char*>(mesh->vertices), sizeof(double) * 3 * vertex_count) &&
+                  is.read(reinterpret_cast<char*>(mesh->triangles), sizeof(unsigned int) * 3 * triangle_count);
+  if (!ok)
+  {
+    RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is truncated", filename.c_str());
+    return nullptr;
+  }
+  for (std::size_t t = 0; t < 3 * mesh->triangle_count; ++t)
+  {
+    if (mesh->triangles[t] >= mesh->vertex_count)
+    {
+      RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is corrupt", filename.c_str());
+      return nullptr;
+    }
+  }
+  // same as the meshes loaded from resources
+  mesh->computeTriangleNormals();
+  mesh->computeVertexNormals();
+  return mesh;
+}
+
+/// Call \e fn for every index below \e count, on up to \e thread_count threads (0 uses one thread per core)
+template <typename Function>
+void forEachConcurrently(std::size_t count, unsigned int thread_count, const Function& fn)
+{
+  if (count == 0)
+    return;
+  std::atomic<std::size_t> next{ 0 };
+  const auto run = [&]() {
+    for (std::size_t i = next++; i < count; i = next++)
+      fn(i);
+  };
+
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t worker_count = std::min<std::size_t>(thread_count, count) - 1;
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (std::size_t t = 0; t < worker_count; ++t)
+    workers.emplace_back(run);
+  run();
+  for (std::thread& worker : workers)
+    worker.join();
+}
+}  // namespace
+
+std::uint64_t MeshCache::computeKey(const std::string& urdf_string, const std::string& srdf_string)
+{
+  // FNV-1a over both documents, with a separator so that moving text from one document to the other changes the key
+  std::uint64_t hash = 14695981039346656037ULL;
+  const auto add = [&hash](const std::string& value) {
+    for (const char c : value)
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    hash = hash * 1099511628211ULL;
+  };
+  add(urdf_string);
+  add(srdf_string);
+  return hash;
+}
+
+std::uint64_t MeshCache::computeMeshHash(const shapes::Mesh& mesh)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  const auto add = [&hash](const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  };
+  const auto vertex_count = static_cast<std::uint64_t>(mesh.vertex_count);
+  const auto triangle_count = static_cast<std::uint64_t>(mesh.triangle_count);
+  add(&vertex_count, sizeof(vertex_count));
+  add(&triangle_count, sizeof(triangle_count));
+  add(mesh.vertices, sizeof(double) * 3 * mesh.vertex_count);
+  add(mesh.triangles, sizeof(unsigned int) * 3 * mesh.triangle_count);
+  return hash;
+}
+
+std::shared_ptr<const shapes::Mesh> MeshCache::computeConvexHull(const std::shared_ptr<const shapes::Mesh>& mesh)
+{
+  const bodies::ConvexMesh body(mesh.get());
+  const EigenSTL::vector_Vector3d& vertices = body.getVertices();
+  const std::vector<unsigned int>& triangles = body.getTriangles();
+  if (vertices.size() < 4 || triangles.size() < 12)
+    return mesh;
+
+  auto hull = std::make_shared<shapes::Mesh>(vertices.size(), triangles.size() / 3);
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    hull->vertices[3 * i] = vertices[i].x();
+    hull->vertices[3 * i + 1] = vertices[i].y();
+    hull->vertices[3 * i + 2] = vertices[i].z();
+  }
+  std::copy(triangles.begin(), triangles.end(), hull->triangles);
+  hull->computeTriangleNormals();
+  hull->computeVertexNormals();
+  return hull;
+}
+
+shapes::ShapePtr MeshCache::getMesh(const std::string& resource, const Eigen::Vector3d& scale)
+{
+  const MeshKey key(resource, { scale.x(), scale.y(), scale.z() });
+  auto it = meshes_.find(key);
+  if (it == meshes_.end())
+  {
+    if (failed_.count(key))
+      return shapes::ShapePtr();
+    std::shared_ptr<const shapes::Mesh> mesh(shapes::createMeshFromResource(resource, scale));
+    if (!mesh)
+    {
+      failed_.insert(key);
+      return shapes::ShapePtr();
+    }
+    it = meshes_.emplace(key, mesh).first;
+    modified_ = true;
+  }
+  if (simplification_ == Simplification::NONE)
+    return shapes::ShapePtr(it->second->clone());
+
+  const std::uint64_t hash = computeMeshHash(*it->second);
+  auto hull = hulls_.find(hash);
+  if (hull == hulls_.end())
+  {
+    hull = hulls_.emplace(hash, computeConvexHull(it->second)).first;
+    modified_ = true;
+  }
+  return shapes::ShapePtr(hull->second->clone());
+}
+
+void MeshCache::loadMeshes(const std::vector<std::pair<std::string, Eigen::Vector3d>>& resources,
+                           unsigned int thread_count)
+{
+  std::vector<MeshKey> missing;
+  std::set<MeshKey> seen;
+  for (const auto& [resource, scale] : resources)
+  {
+    const MeshKey key(resource, { scale.x(), scale.y(), scale.z() });
+    if (!meshes_.count(key) && !failed_.count(key) && seen.insert(key).second)
+      missing.push_back(key);
+  }
+
+  // every resource is loaded into its own slot, so the result is the same for any number of threads
+  std::vector<std::shared_ptr<const shapes::Mesh>> loaded(missing.size());
+  forEachConcurrently(missing.size(), thread_count, [&](std::size_t i) {
+    const std::array<double, 3>& scale = missing[i].second;
+    loaded[i].reset(shapes::createMeshFromResource(missing[i].first, Eigen::Vector3d(scale[0], scale[1], scale[2])));
+  });
+
+  for (std::size_t i = 0; i < missing.size(); ++i)
+  {
+    if (loaded[i])
+    {
+      meshes_.emplace(missing[i], loaded[i]);
+      modified_ = true;
+    }
+    else
+      failed_.insert(missing[i]);
+  }
+
+  if (simplification_ == Simplification::NONE)
+    return;
+
+  // computing the hulls is as expensive as loading, so the missing ones are computed concurrently as well
+  std::vector<std::pair<std::uint64_t, std::shared_ptr<const shapes::Mesh>>> unsimplified;
+  for (const auto& [resource, scale] : resources)
+  {
+    const auto it = meshes_.find(MeshKey(resource, { scale.x(), scale.y(), scale.z() }));
+    if (it == meshes_.end())
+      continue;
+    const std::uint64_t hash = computeMeshHash(*it->second);
+    if (!hulls_.count(hash) && std::none_of(unsimplified.begin(), unsimplified.end(),
+                                            [hash](const auto& entry) { return entry.first == hash; }))
+      unsimplified.emplace_back(hash, it->second);
+  }
+  std::vector<std::shared_ptr<const shapes::Mesh>> hulls(unsimplified.size());
+  forEachConcurrently(unsimplified.size(), thread_count,
+                      [&](std::size_t i) { hulls[i] = computeConvexHull(unsimplified[i].second); });
+  for (std::size_t i = 0; i < unsimplified.size(); ++i)
+  {
+    hulls_.emplace(unsimplified[i].first, hulls[i]);
+    modified_ = true;
+  }
+}
+
+bool MeshCache::writeToFile(const std::string& filename) const
+{
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os.good())
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open '%s' for writing the mesh cache", filename.c_str());
+    return false;
+  }
+
+  CacheHeader header{};
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+  header.version = CACHE_VERSION;
+  header.byte_order = CACHE_BYTE_ORDER;
+  header.key = key_;
+  header.entry_count = meshes_.size();
+  writeValue(os, header);
+  for (const auto& [mesh_key, mesh] : meshes_)
+  {
+    writeValue(os, static_cast<std::uint32_t>(mesh_key.first.size()));
+    os.write(mesh_key.first.data(), mesh_key.first.size());
+    writeValue(os, mesh_key.second);
+    writeMesh(os, *mesh);
+  }
+  writeValue(os, static_cast<std::uint64_t>(hulls_.size()));
+  for (const auto& [hash, hull] : hulls_)
+  {
+    writeValue(os, hash);
+    writeMesh(os, *hull);
+  }
+  os.close();
+  if (os.fail())
+  {
+    RCLCPP_ERROR(LOGGER, "Failed writing the mesh cache to '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+MeshCachePtr MeshCache::readFromFile(const std::string& filename, std::uint64_t key)
+{
+  std::ifstream is(filename, std::ios::binary);
+  if (!is.good())
+  {
+    RCLCPP_DEBUG(LOGGER, "No mesh cache at '%s'", filename.c_str());
+    return MeshCachePtr();
+  }
+
+  CacheHeader header;
+  if (!readValue(is, header) || std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != CACHE_VERSION || header.byte_order != CACHE_BYTE_ORDER)
+  {
+    RCLCPP_WARN(LOGGER, "'%s' is not a mesh cache of version %u", filename.c_str(), CACHE_VERSION);
+    return MeshCachePtr();
+  }
+  if (header.key != key)
+  {
+    RCLCPP_INFO(LOGGER, "Mesh cache '%s' was written for a different robot description", filename.c_str());
+    return MeshCachePtr();
+  }
+
+  auto cache = std::make_shared<MeshCache>(key);
+  for (std::uint64_t i = 0; i < header.entry_count; ++i)
+  {
+    std::uint32_t resource_size;
+    MeshKey mesh_key;
+    bool ok = readValue(is, resource_size);
+    if (ok)
+    {
+      mesh_key.first.resize(resource_size);
+      ok = static_cast<bool>(is.read(&mesh_key.first[0], resource_size));
+    }
+    if (!ok || !readValue(is, mesh_key.second))
+    {
+      RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is truncated", filename.c_str());
+      return MeshCachePtr();
+    }
+    std::shared_ptr<shapes::Mesh> mesh = readMesh(is, filename);
+    if (!mesh)
+      return MeshCachePtr();
+    cache->meshes_.emplace(std::move(mesh_key), std::move(mesh));
+  }
+
+  std::uint64_t hull_count;
+  if (!readValue(is, hull_count))
+  {
+    RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is truncated", filename.c_str());
+    return MeshCachePtr();
+  }
+  for (std::uint64_t i = 0; i < hull_count; ++i)
+  {
+    std::uint64_t hash;
+    if (!readValue(is, hash))
+    {
+      RCLCPP_ERROR(LOGGER, "Mesh cache '%s' is truncated", filename.c_str());
+      return MeshCachePtr();
+    }
+    std::shared_ptr<shapes::Mesh> hull = readMesh(is, filename);
+    if (!hull)
+      return MeshCachePtr();
+    cache->hulls_.emplace(hash, std::move(hull));
+  }
+  return cache;
+}
+}  // namespace core
+}  // namespace moveit
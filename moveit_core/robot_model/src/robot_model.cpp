@@ -59,6 +59,18 @@ RobotModel::RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const sr
   buildModel(*urdf_model, *srdf_model);
 }
 
+RobotModel::RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model,
+                       const MeshCachePtr& mesh_cache)
+{
+  root_joint_ = nullptr;
+  urdf_ = urdf_model;
+  srdf_ = srdf_model;
+  mesh_cache_ = mesh_cache;
+  buildModel(*urdf_model, *srdf_model);
+  // the model does not need the cache after construction
+  mesh_cache_.reset();
+}
+
 RobotModel::~RobotModel()
 {
   for (std::pair<const std::string, JointModelGroup*>& it : joint_model_group_map_)
@@ -79,6 +91,31 @@ const LinkModel* RobotModel::getRootLink() const
   return root_link_;
 }
 
+namespace
+{
+// Collect the mesh resources and scales of the collision geometry of all links, as constructLinkModel() uses them
+std::vector<std::pair<std::string, Eigen::Vector3d>> getCollisionMeshResources(const urdf::ModelInterface& urdf_model)
+{
+  std::vector<std::pair<std::string, Eigen::Vector3d>> resources;
+  for (const auto& [name, urdf_link] : urdf_model.links_)
+  {
+    const std::vector<urdf::CollisionSharedPtr>& col_array =
+        urdf_link->collision_array.empty() ? std::vector<urdf::CollisionSharedPtr>(1, urdf_link->collision) :
+                                             urdf_link->collision_array;
+    for (const urdf::CollisionSharedPtr& col : col_array)
+    {
+      if (col && col->geometry && col->geometry->type == urdf::Geometry::MESH)
+      {
+        const urdf::Mesh* mesh = static_cast<const urdf::Mesh*>(col->geometry.get());
+        if (!mesh->filename.empty())
+          resources.emplace_back(mesh->filename, Eigen::Vector3d(mesh->scale.x, mesh->scale.y, mesh->scale.z));
+      }
+    }
+  }
+  return resources;
+}
+}  // namespace
+
 void RobotModel::buildModel(const urdf::ModelInterface& urdf_model, const srdf::Model& srdf_model)
 {
   root_joint_ = nullptr;
@@ -93,8 +130,18 @@ void RobotModel::buildModel(const urdf::ModelInterface& urdf_model, const srdf::
     const urdf::Link* root_link_ptr = urdf_model.getRoot().get();
     model_frame_ = root_link_ptr->name;
 
+    // loading the collision meshes dominates the construction time, so they are all loaded concurrently up front;
+    // the links then take them from the cache
+    RCLCPP_DEBUG(LOGGER, "... loading collision meshes");
+    const bool own_mesh_cache = !mesh_cache_;
+    if (own_mesh_cache)
+      mesh_cache_ = std::make_shared<MeshCache>();
+    mesh_cache_->loadMeshes(getCollisionMeshResources(urdf_model));
+
     RCLCPP_DEBUG(LOGGER, "... building kinematic chain");
     root_joint_ = buildRecursive(nullptr, root_link_ptr, srdf_model);
+    if (own_mesh_cache)
+      mesh_cache_.reset();
     if (root_joint_)
       root_link_ = root_joint_->getChildLinkModel();
     RCLCPP_DEBUG(LOGGER, "... building mimic joints");
@@ -502,12 +549,15 @@ bool RobotModel::hasJointModelGroup(const std::string& name) const
   return joint_model_group_map_.find(name) != joint_model_group_map_.end();
 }
 
-const JointModelGroup* RobotModel::getJointModelGroup(const std::string& name) const
+const JointModelGroup* RobotModel::getJointModelGroup(const std::string& name, bool* has_group) const
 {
   JointModelGroupMap::const_iterator it = joint_model_group_map_.find(name);
+  if (has_group)
+    *has_group = it != joint_model_group_map_.end();
   if (it == joint_model_group_map_.end())
   {
-    RCLCPP_ERROR(LOGGER, "Group '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
+    if (!has_group)
+      RCLCPP_ERROR(LOGGER, "Group '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
     return nullptr;
   }
   return it->second;
@@ -1270,6 +1320,8 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
       if (!mesh->filename.empty())
       {
         Eigen::Vector3d scale(mesh->scale.x, mesh->scale.y, mesh->scale.z);
+        if (mesh_cache_)
+          return mesh_cache_->getMesh(mesh->filename, scale);
         shapes::Mesh* m = shapes::createMeshFromResource(mesh->filename, scale);
         new_shape = m;
       }
@@ -1576,6 +1628,112 @@ void RobotModel::setKinematicsAllocators(const std::map<std::string, SolverAlloc
   }
 }
 
+bool RobotModel::setCompiledForwardKinematics(const CompiledForwardKinematicsConstPtr& kinematics)
+{
+  if (kinematics->getRobotModelName() != model_name_)
+  {
+    RCLCPP_ERROR(LOGGER, "Compiled forward kinematics were generated for robot '%s', not '%s'",
+                 kinematics->getRobotModelName().c_str(), model_name_.c_str());
+    return false;
+  }
+  const std::string root_joint_name = kinematics->getRootJointName();
+  if (!hasJointModel(root_joint_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Compiled forward kinematics start at unknown joint '%s'", root_joint_name.c_str());
+    return false;
+  }
+
+  auto binding = std::make_unique<CompiledForwardKinematicsBinding>();
+  binding->kinematics = kinematics;
+  binding->root_joint = getJointModel(root_joint_name);
+  const LinkModel* base_link = binding->root_joint->getParentLinkModel();
+
+  // the kinematics must compute every link of the subtree, each after its parent
+  const std::vector<const LinkModel*>& subtree = binding->root_joint->getDescendantLinkModels();
+  std::vector<bool> computed(link_model_vector_.size(), false);
+  for (const std::string& link_name : kinematics->getLinkNames())
+  {
+    const LinkModel* link = hasLinkModel(link_name) ? getLinkModel(link_name) : nullptr;
+    if (!link || std::find(subtree.begin(), subtree.end(), link) == subtree.end() ||
+        computed[link->getLinkIndex()] ||
+        (link->getParentLinkModel() != base_link && !computed[link->getParentLinkModel()->getLinkIndex()]))
+    {
+      RCLCPP_ERROR(LOGGER, "Compiled forward kinematics of joint '%s' do not match link '%s' of robot '%s'",
+                   root_joint_name.c_str(), link_name.c_str(), model_name_.c_str());
+      return false;
+    }
+    computed[link->getLinkIndex()] = true;
+    binding->link_indices.push_back(link->getLinkIndex());
+  }
+  if (binding->link_indices.size() != subtree.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Compiled forward kinematics of joint '%s' compute %zu of its %zu links",
+                 root_joint_name.c_str(), binding->link_indices.size(), subtree.size());
+    return false;
+  }
+  for (const std::string& variable : kinematics->getVariableNames())
+  {
+    const auto it = joint_variables_index_map_.find(variable);
+    if (it == joint_variables_index_map_.end())
+    {
+      RCLCPP_ERROR(LOGGER, "Compiled forward kinematics of joint '%s' use unknown variable '%s'",
+                   root_joint_name.c_str(), variable.c_str());
+      return false;
+    }
+    binding->variable_indices.push_back(static_cast<int>(it->second));
+  }
+
+  // compare to the joint models for random configurations below an arbitrary base transform
+  random_numbers::RandomNumberGenerator rng(0);
+  const Eigen::Isometry3d base =
+      Eigen::Translation3d(0.1, -0.2, 0.3) * Eigen::AngleAxisd(0.4, Eigen::Vector3d(1.0, 2.0, 3.0).normalized());
+  std::vector<double> positions(variable_count_);
+  EigenSTL::vector_Isometry3d expected(link_model_vector_.size(), Eigen::Isometry3d::Identity());
+  EigenSTL::vector_Isometry3d transforms(link_model_vector_.size(), Eigen::Isometry3d::Identity());
+  for (std::size_t sample = 0; sample < 10; ++sample)
+  {
+    getVariableRandomPositions(rng, positions);
+    kinematics->computeLinkTransforms(base, positions.data(), binding->variable_indices.data(), transforms.data(),
+                                      binding->link_indices.data());
+    for (const LinkModel* link : subtree)
+    {
+      const LinkModel* parent = link->getParentLinkModel();
+      const JointModel* joint = link->getParentJointModel();
+      Eigen::Isometry3d joint_transform;
+      joint->computeTransform(positions.data() + joint->getFirstVariableIndex(), joint_transform);
+      const int index = link->getLinkIndex();
+      expected[index] =
+          (parent == base_link ? base : expected[parent->getLinkIndex()]) * link->getJointOriginTransform() *
+          joint_transform;
+      if (!expected[index].matrix().isApprox(transforms[index].matrix(), 1e-9))
+      {
+        RCLCPP_ERROR(LOGGER, "Compiled forward kinematics of joint '%s' compute a wrong transform for link '%s'",
+                     root_joint_name.c_str(), link->getName().c_str());
+        return false;
+      }
+    }
+  }
+
+  // replace the kinematics of overlapping subtrees
+  compiled_kinematics_.erase(
+      std::remove_if(compiled_kinematics_.begin(), compiled_kinematics_.end(),
+                     [&computed](const std::unique_ptr<CompiledForwardKinematicsBinding>& other) {
+                       return std::any_of(other->link_indices.begin(), other->link_indices.end(),
+                                          [&computed](int index) { return computed[index]; });
+                     }),
+      compiled_kinematics_.end());
+  compiled_kinematics_.push_back(std::move(binding));
+  compiled_kinematics_of_link_.assign(link_model_vector_.size(), nullptr);
+  for (const std::unique_ptr<CompiledForwardKinematicsBinding>& other : compiled_kinematics_)
+  {
+    for (int index : other->link_indices)
+      compiled_kinematics_of_link_[index] = other.get();
+  }
+  RCLCPP_INFO(LOGGER, "Using compiled forward kinematics for the %zu links below joint '%s'", subtree.size(),
+              root_joint_name.c_str());
+  return true;
+}
+
 void RobotModel::printModelInfo(std::ostream& out) const
 {
   out << "Model " << model_name_ << " in frame " << model_frame_ << ", using " << getVariableCount() << " variables\n";
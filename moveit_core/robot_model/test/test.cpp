@@ -36,6 +36,7 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <urdf_parser/urdf_parser.h>
+#include <algorithm>
 #include <fstream>
 #include <gtest/gtest.h>
 
@@ -90,6 +91,117 @@ TEST_F(LoadPlanningModelsPr2, Model)
   EXPECT_FALSE(bounds.position_bounded_);
   EXPECT_FALSE(bounds.acceleration_bounded_);
   EXPECT_FALSE(bounds.jerk_bounded_);
+
+  // groups can be looked up without reporting missing ones as errors
+  bool has_group = false;
+  const moveit::core::RobotModel& const_model = *robot_model_;
+  EXPECT_EQ(const_model.getJointModelGroup("right_arm", &has_group), robot_model_->getJointModelGroup("right_arm"));
+  EXPECT_TRUE(has_group);
+  EXPECT_EQ(const_model.getJointModelGroup("no_such_group", &has_group), nullptr);
+  EXPECT_FALSE(has_group);
+}
+
+TEST(MeshCache, ReusesLoadedMeshes)
+{
+  const urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
+  const srdf::ModelSharedPtr srdf_model = moveit::core::loadSRDFModel("pr2");
+  const std::uint64_t key = moveit::core::MeshCache::computeKey("pr2 urdf", "pr2 srdf");
+  EXPECT_NE(key, moveit::core::MeshCache::computeKey("pr2 urdfpr2", " srdf"));
+
+  // building a model fills the cache with the meshes of its links
+  auto cache = std::make_shared<moveit::core::MeshCache>(key);
+  const moveit::core::RobotModel model(urdf_model, srdf_model, cache);
+  ASSERT_GT(cache->size(), 0u);
+  EXPECT_TRUE(cache->isModified());
+  ASSERT_TRUE(cache->writeToFile("test_mesh_cache.bin"));
+  EXPECT_FALSE(moveit::core::MeshCache::readFromFile("test_mesh_cache.bin", key + 1));
+
+  // a model built from the cache file loads no resources and has the same geometry
+  const moveit::core::MeshCachePtr read_cache = moveit::core::MeshCache::readFromFile("test_mesh_cache.bin", key);
+  ASSERT_TRUE(read_cache);
+  EXPECT_EQ(read_cache->size(), cache->size());
+  const moveit::core::RobotModel cached_model(urdf_model, srdf_model, read_cache);
+  EXPECT_FALSE(read_cache->isModified());
+  ASSERT_EQ(cached_model.getLinkModelCount(), model.getLinkModelCount());
+  for (const moveit::core::LinkModel* link : model.getLinkModels())
+  {
+    const moveit::core::LinkModel* cached_link = cached_model.getLinkModel(link->getName());
+    ASSERT_EQ(cached_link->getShapes().size(), link->getShapes().size());
+    EXPECT_TRUE(cached_link->getShapeExtentsAtOrigin().isApprox(link->getShapeExtentsAtOrigin()));
+    EXPECT_TRUE(cached_link->getCenteredBoundingBoxOffset().isApprox(link->getCenteredBoundingBoxOffset()));
+  }
+}
+
+TEST(MeshCache, ConcurrentLoadingIsDeterministic)
+{
+  const urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
+  std::vector<std::pair<std::string, Eigen::Vector3d>> resources;
+  for (const auto& [name, link] : urdf_model->links_)
+  {
+    if (link->collision && link->collision->geometry && link->collision->geometry->type == urdf::Geometry::MESH)
+      resources.emplace_back(static_cast<const urdf::Mesh*>(link->collision->geometry.get())->filename,
+                             Eigen::Vector3d::Ones());
+  }
+  ASSERT_FALSE(resources.empty());
+
+  moveit::core::MeshCache sequential_cache;
+  sequential_cache.loadMeshes(resources, 1);
+  moveit::core::MeshCache concurrent_cache;
+  concurrent_cache.loadMeshes(resources, 4);
+  ASSERT_GT(sequential_cache.size(), 0u);
+  ASSERT_EQ(concurrent_cache.size(), sequential_cache.size());
+
+  for (const auto& [resource, scale] : resources)
+  {
+    const auto mesh = std::static_pointer_cast<const shapes::Mesh>(sequential_cache.getMesh(resource, scale));
+    const auto concurrent_mesh =
+        std::static_pointer_cast<const shapes::Mesh>(concurrent_cache.getMesh(resource, scale));
+    ASSERT_TRUE(mesh && concurrent_mesh);
+    ASSERT_EQ(concurrent_mesh->vertex_count, mesh->vertex_count);
+    ASSERT_EQ(concurrent_mesh->triangle_count, mesh->triangle_count);
+    EXPECT_TRUE(std::equal(mesh->vertices, mesh->vertices + 3 * mesh->vertex_count, concurrent_mesh->vertices));
+    EXPECT_TRUE(std::equal(mesh->triangles, mesh->triangles + 3 * mesh->triangle_count, concurrent_mesh->triangles));
+  }
+  // getMesh() found all meshes in the caches
+  EXPECT_EQ(concurrent_cache.size(), sequential_cache.size());
+}
+
+TEST(MeshCache, ConvexHullSimplification)
+{
+  const urdf::ModelInterfaceSharedPtr urdf_model = moveit::core::loadModelInterface("pr2");
+  const srdf::ModelSharedPtr srdf_model = moveit::core::loadSRDFModel("pr2");
+  const std::uint64_t key = moveit::core::MeshCache::computeKey("pr2 urdf", "pr2 srdf");
+
+  auto cache = std::make_shared<moveit::core::MeshCache>(key);
+  cache->setSimplification(moveit::core::MeshCache::Simplification::CONVEX_HULL);
+  const moveit::core::RobotModel model(urdf_model, srdf_model, cache);
+  ASSERT_GT(cache->simplifiedSize(), 0u);
+  EXPECT_LE(cache->simplifiedSize(), cache->size());
+
+  // the hulls are read back with the meshes and not computed again
+  ASSERT_TRUE(cache->writeToFile("test_mesh_cache_hulls.bin"));
+  const moveit::core::MeshCachePtr read_cache =
+      moveit::core::MeshCache::readFromFile("test_mesh_cache_hulls.bin", key);
+  ASSERT_TRUE(read_cache);
+  EXPECT_EQ(read_cache->simplifiedSize(), cache->simplifiedSize());
+  read_cache->setSimplification(moveit::core::MeshCache::Simplification::CONVEX_HULL);
+  const moveit::core::RobotModel cached_model(urdf_model, srdf_model, read_cache);
+  EXPECT_FALSE(read_cache->isModified());
+
+  // a hull has no more vertices than its mesh and, being spanned by the outermost ones, the same extents
+  const moveit::core::RobotModel full_model(urdf_model, srdf_model);
+  for (const moveit::core::LinkModel* link : full_model.getLinkModels())
+  {
+    const moveit::core::LinkModel* hull_link = cached_model.getLinkModel(link->getName());
+    ASSERT_EQ(hull_link->getShapes().size(), link->getShapes().size());
+    EXPECT_TRUE(hull_link->getShapeExtentsAtOrigin().isApprox(link->getShapeExtentsAtOrigin(), 1e-9));
+    for (std::size_t i = 0; i < link->getShapes().size(); ++i)
+    {
+      if (link->getShapes()[i]->type == shapes::MESH)
+        EXPECT_LE(static_cast<const shapes::Mesh*>(hull_link->getShapes()[i].get())->vertex_count,
+                  static_cast<const shapes::Mesh*>(link->getShapes()[i].get())->vertex_count);
+    }
+  }
 }
 
 TEST(SiblingAssociateLinks, SimpleYRobot)
@@ -128,6 +240,41 @@ TEST(SiblingAssociateLinks, SimpleYRobot)
   }
 }
 
+TEST_F(LoadPlanningModelsPr2, RandomPositionsBatch)
+{
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("right_arm");
+  ASSERT_TRUE(jmg);
+  const std::size_t count = 1000;
+
+  random_numbers::RandomNumberGenerator rng1(42);
+  moveit::core::JointModelGroup::VariablePositionsMatrix single;
+  jmg->getVariableRandomPositionsBatch(rng1, single, count);
+  ASSERT_EQ(static_cast<std::size_t>(single.rows()), count);
+  ASSERT_EQ(single.cols(), jmg->getVariableCount());
+  for (Eigen::Index i = 0; i < single.rows(); ++i)
+    EXPECT_TRUE(jmg->satisfiesPositionBounds(single.row(i).data()));
+
+  // the result must not depend on the number of threads
+  random_numbers::RandomNumberGenerator rng2(42);
+  moveit::core::JointModelGroup::VariablePositionsMatrix threaded;
+  jmg->getVariableRandomPositionsBatch(rng2, threaded, count, 4);
+  EXPECT_EQ(single, threaded);
+
+  const double distance = 0.1;
+  const Eigen::VectorXd near = single.row(0);
+  moveit::core::JointModelGroup::VariablePositionsMatrix near_by;
+  jmg->getVariableRandomPositionsNearByBatch(rng1, near_by, count, near.data(), distance, 2);
+  for (Eigen::Index i = 0; i < near_by.rows(); ++i)
+  {
+    EXPECT_TRUE(jmg->satisfiesPositionBounds(near_by.row(i).data()));
+    for (const moveit::core::JointModel* joint : jmg->getActiveJointModels())
+    {
+      const int index = jmg->getVariableGroupIndex(joint->getName());
+      EXPECT_LE(joint->distance(near_by.row(i).data() + index, near.data() + index), distance + 1e-9);
+    }
+  }
+}
+
 TEST(FloatingJointTest, interpolation_test)
 {
   // Create a simple floating joint model with some dummy parameters (these are not used by the test)
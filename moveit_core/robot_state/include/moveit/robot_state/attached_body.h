@@ -41,8 +41,10 @@
 #include <geometric_shapes/check_isometry.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <trajectory_msgs/msg/joint_trajectory.hpp>
+#include <atomic>
 #include <set>
 #include <functional>
+#include <mutex>
 
 namespace moveit
 {
@@ -85,7 +87,7 @@ public:
   /** \brief Get the pose of the attached body, relative to the world */
   const Eigen::Isometry3d& getGlobalPose() const
   {
-    return global_pose_;
+    return getGlobalTransforms().pose;
   }
 
   /** \brief Get the name of the link this body is attached to */
@@ -151,7 +153,7 @@ public:
   /** \brief Get subframes of this object (in the world frame) */
   const moveit::core::FixedTransformsMap& getGlobalSubframeTransforms() const
   {
-    return global_subframe_poses_;
+    return getGlobalTransforms().subframe_poses;
   }
 
   /** \brief Set all subframes of this object.
@@ -166,6 +168,9 @@ public:
       ASSERT_ISOMETRY(t.second)  // unsanitized input, could contain a non-isometry
     }
     subframe_poses_ = subframe_poses;
+    std::scoped_lock slock(global_.mutex);
+    global_.subframe_poses = subframe_poses;
+    global_.valid = false;
   }
 
   /** \brief Get the fixed transform to a named subframe on this body (relative to the body's pose)
@@ -198,7 +203,7 @@ public:
    *  guaranteed to be valid isometries. */
   const EigenSTL::vector_Isometry3d& getGlobalCollisionBodyTransforms() const
   {
-    return global_collision_body_transforms_;
+    return getGlobalTransforms().collision_body_transforms;
   }
 
   /** \brief Set the padding for the shapes of this attached object */
@@ -207,10 +212,44 @@ public:
   /** \brief Set the scale for the shapes of this attached object */
   void setScale(double scale);
 
-  /** \brief Recompute global_collision_body_transform given the transform of the parent link */
+  /** \brief Set the transform of the parent link. The global transforms of the body, its shapes and its subframes
+      are only recomputed when they are accessed after the parent link moved. */
   void computeTransform(const Eigen::Isometry3d& parent_link_global_transform);
 
 private:
+  /** \brief The transforms of the body in the model frame, computed lazily from the parent link transform. Copies
+      lock the original, as it may be computing its transforms in another thread. */
+  struct GlobalTransforms
+  {
+    GlobalTransforms() = default;
+    GlobalTransforms(const GlobalTransforms& other)
+    {
+      std::scoped_lock slock(other.mutex);
+      parent_link_transform = other.parent_link_transform;
+      pose = other.pose;
+      collision_body_transforms = other.collision_body_transforms;
+      subframe_poses = other.subframe_poses;
+      valid = other.valid.load();
+    }
+
+    Eigen::Isometry3d parent_link_transform;
+    Eigen::Isometry3d pose;
+    EigenSTL::vector_Isometry3d collision_body_transforms;
+    moveit::core::FixedTransformsMap subframe_poses;
+    std::atomic<bool> valid{ false };  ///< Whether the transforms are up to date with parent_link_transform
+    mutable std::mutex mutex;          // computing the transforms is the only modification of a const body
+  };
+
+  /** \brief Get the global transforms, computing them if the parent link moved since they were last accessed */
+  const GlobalTransforms& getGlobalTransforms() const
+  {
+    if (!global_.valid.load(std::memory_order_acquire))
+      updateGlobalTransforms();
+    return global_;
+  }
+
+  void updateGlobalTransforms() const;
+
   /** \brief The link that owns this attached body */
   const LinkModel* parent_link_model_;
 
@@ -220,9 +259,6 @@ private:
   /** \brief The transform from the parent link to the attached body's pose*/
   Eigen::Isometry3d pose_;
 
-  /** \brief The transform from the model frame to the attached body's pose  */
-  Eigen::Isometry3d global_pose_;
-
   /** \brief The geometries of the attached body */
   std::vector<shapes::ShapeConstPtr> shapes_;
 
@@ -232,9 +268,6 @@ private:
   /** \brief The transforms from the link to the object's geometries*/
   EigenSTL::vector_Isometry3d shape_poses_in_link_frame_;
 
-  /** \brief The global transforms for the attached bodies (computed by forward kinematics) */
-  EigenSTL::vector_Isometry3d global_collision_body_transforms_;
-
   /** \brief The set of links this body is allowed to touch */
   std::set<std::string> touch_links_;
 
@@ -245,8 +278,8 @@ private:
   /** \brief Transforms to subframes on the object, relative to the object's pose. */
   moveit::core::FixedTransformsMap subframe_poses_;
 
-  /** \brief Transforms to subframes on the object, relative to the model frame. */
-  moveit::core::FixedTransformsMap global_subframe_poses_;
+  /** \brief The transforms of the body, its shapes and its subframes relative to the model frame */
+  mutable GlobalTransforms global_;
 };
 }  // namespace core
 }  // namespace moveit
@@ -38,6 +38,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include <moveit/robot_state/robot_state.h>
 
 namespace moveit
@@ -90,6 +92,23 @@ struct MaxEEFStep
   double rotation;     // Radians
 };
 
+/** \brief Struct for configuring the Jacobian stepping mode of computeCartesianPath
+
+    When enabled, each interpolated pose is approached from the joint values of the previous pose with damped
+    least-squares Jacobian steps. The IK solver is only called if the pose error still exceeds the tolerances after
+    \e max_iterations steps, or if the group is not a chain. States reached by Jacobian steps are passed to the
+    validity callback in batches of \e validation_batch_size, which are bisected to find the first invalid state.
+    That state is then computed again by the IK solver. */
+struct JacobianStepping
+{
+  bool enabled = false;
+  double translation_tolerance = 1e-5;  // Meters
+  double rotation_tolerance = 1e-4;     // Radians
+  double damping = 1e-3;
+  unsigned int max_iterations = 5;
+  std::size_t validation_batch_size = 16;
+};
+
 class CartesianInterpolator
 {
   // TODO(mlautman): Eventually, this planner should be moved out of robot_state
@@ -169,14 +188,17 @@ public:
      for revolute joints or \e prismatic_jump_threshold for prismatic joints then this step is considered a failure and
      the returned path is truncated up to just before the jump.
 
-     Kinematics solvers may use cost functions to prioritize certain solutions, which may be specified with \e cost_function. */
+     Kinematics solvers may use cost functions to prioritize certain solutions, which may be specified with \e cost_function.
+
+     For densely sampled paths, \e jacobian_stepping avoids calling the IK solver for every pose. */
   static Distance computeCartesianPath(
       RobotState* start_state, const JointModelGroup* group, std::vector<std::shared_ptr<RobotState>>& traj,
       const LinkModel* link, const Eigen::Vector3d& translation, bool global_reference_frame,
       const MaxEEFStep& max_step, const JumpThreshold& jump_threshold,
       const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
-      const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn());
+      const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn(),
+      const JacobianStepping& jacobian_stepping = JacobianStepping());
 
   /** \brief Compute the sequence of joint values that correspond to a straight Cartesian path, for a particular link.
 
@@ -188,10 +210,11 @@ public:
       const MaxEEFStep& max_step, const JumpThreshold& jump_threshold,
       const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
-      const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn())
+      const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn(),
+      const JacobianStepping& jacobian_stepping = JacobianStepping())
   {
     return computeCartesianPath(start_state, group, traj, link, distance * direction, global_reference_frame, max_step,
-                                jump_threshold, validCallback, options, cost_function);
+                                jump_threshold, validCallback, options, cost_function, jacobian_stepping);
   }
 
   /** \brief Compute the sequence of joint values that correspond to a straight Cartesian path, for a particular frame.
@@ -208,14 +231,22 @@ public:
       const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
       const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn(),
-      const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity());
+      const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity(),
+      const JacobianStepping& jacobian_stepping = JacobianStepping());
 
   /** \brief Compute the sequence of joint values that perform a general Cartesian path.
 
      In contrast to the previous functions, the Cartesian path is specified as a set of \e waypoints to be sequentially
      reached by the virtual frame attached to the robot \e link. The waypoints are transforms given either w.r.t. the global
      reference frame or the virtual frame at the immediately preceding waypoint. The virtual frame needs
-     to move in a straight line between two consecutive waypoints. All other comments apply. */
+     to move in a straight line between two consecutive waypoints. All other comments apply.
+
+     With a \e thread_count other than 1 (0 uses all hardware threads), the start states of all segments are solved
+     by IK up front and the segments are computed concurrently. They are joined in order: a segment whose first step
+     from the end of the previous segment is a larger joint-space jump than its own steps (the IK solution at the
+     joining waypoint lies on a different branch), and a segment whose start state could not be solved, is computed
+     again from the end of the previous segment. \e validCallback is called from multiple threads in this case. The
+     kinematics solver of \e group is only called by one thread at a time. */
   static Percentage computeCartesianPath(
       RobotState* start_state, const JointModelGroup* group, std::vector<std::shared_ptr<RobotState>>& traj,
       const LinkModel* link, const EigenSTL::vector_Isometry3d& waypoints, bool global_reference_frame,
@@ -223,7 +254,8 @@ public:
       const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
       const kinematics::KinematicsBase::IKCostFn& cost_function = kinematics::KinematicsBase::IKCostFn(),
-      const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity());
+      const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity(),
+      const JacobianStepping& jacobian_stepping = JacobianStepping(), std::size_t thread_count = 1);
 
   /** \brief Tests joint space jumps of a trajectory.
 
@@ -278,6 +310,32 @@ public:
   static Percentage checkAbsoluteJointSpaceJump(const JointModelGroup* group,
                                                 std::vector<std::shared_ptr<RobotState>>& traj,
                                                 double revolute_jump_threshold, double prismatic_jump_threshold);
+
+private:
+  /** \brief Compute the path to \e target like computeCartesianPath(), holding \e ik_mutex (if any) while calling
+     the kinematics solver.
+
+     Return the fraction of the path that was achieved. */
+  static double computeSegment(RobotState* start_state, const JointModelGroup* group,
+                               std::vector<std::shared_ptr<RobotState>>& traj, const LinkModel* link,
+                               const Eigen::Isometry3d& target, bool global_reference_frame, const MaxEEFStep& max_step,
+                               const JumpThreshold& jump_threshold, const GroupStateValidityCallbackFn& validCallback,
+                               const kinematics::KinematicsQueryOptions& options,
+                               const kinematics::KinematicsBase::IKCostFn& cost_function,
+                               const Eigen::Isometry3d& link_offset, const JacobianStepping& jacobian_stepping,
+                               std::mutex* ik_mutex);
+
+  /** \brief Compute the segments between \e waypoints on \e thread_count threads and join them into \e traj.
+
+     Return the fraction of the path that was achieved, before testing for joint space jumps. */
+  static double computeSegmentsInParallel(RobotState* start_state, const JointModelGroup* group,
+                                          std::vector<std::shared_ptr<RobotState>>& traj, const LinkModel* link,
+                                          const EigenSTL::vector_Isometry3d& waypoints, bool global_reference_frame,
+                                          const MaxEEFStep& max_step, const GroupStateValidityCallbackFn& validCallback,
+                                          const kinematics::KinematicsQueryOptions& options,
+                                          const kinematics::KinematicsBase::IKCostFn& cost_function,
+                                          const Eigen::Isometry3d& link_offset,
+                                          const JacobianStepping& jacobian_stepping, std::size_t thread_count);
 };
 
 }  // end of namespace core
@@ -39,6 +39,8 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/transforms/transforms.h>
 #include <moveit_msgs/msg/robot_state.hpp>
+#include <geometric_shapes/shape_messages.h>
+#include <map>
 
 namespace moveit
 {
@@ -107,6 +109,72 @@ void robotStateToJointStateMsg(const RobotState& state, sensor_msgs::msg::JointS
 bool jointTrajPointToRobotState(const trajectory_msgs::msg::JointTrajectory& trajectory, std::size_t point_id,
                                 RobotState& state);
 
+/**
+ * @brief Converts recurring robot state messages faster than the free conversion functions
+ *
+ * Messages exchanged with one peer usually have the same joint name layout and
+ * the same attached objects every time. The context remembers the variable
+ * index of each joint name of the last layout, so a message with the same
+ * layout is copied into the state without name lookups. It also remembers the
+ * attached bodies it created and the messages it created them from. An attached
+ * object that is unchanged and still attached to the state is not constructed
+ * again. In the other direction, the messages of the shapes of attached bodies
+ * are reused as long as the bodies share the same shapes.
+ *
+ * The results are the same as those of the free functions. A context is not
+ * thread-safe. Use one context per message source.
+ */
+class RobotStateConversionContext
+{
+public:
+  /** @brief Same as moveit::core::robotStateMsgToRobotState() */
+  bool robotStateMsgToRobotState(const moveit_msgs::msg::RobotState& robot_state, RobotState& state,
+                                 bool copy_attached_bodies = true);
+
+  /** @brief Same as moveit::core::robotStateMsgToRobotState() with extra transforms */
+  bool robotStateMsgToRobotState(const Transforms& tf, const moveit_msgs::msg::RobotState& robot_state,
+                                 RobotState& state, bool copy_attached_bodies = true);
+
+  /** @brief Same as moveit::core::robotStateToRobotStateMsg() */
+  void robotStateToRobotStateMsg(const RobotState& state, moveit_msgs::msg::RobotState& robot_state,
+                                 bool copy_attached_bodies = true);
+
+  /** @brief Forget all cached layouts, attached bodies and shape messages */
+  void clear();
+
+private:
+  /// An attached body created by this context and the message it was created from
+  struct AttachedBodyEntry
+  {
+    moveit_msgs::msg::AttachedCollisionObject msg;
+    std::vector<shapes::ShapeConstPtr> shapes;
+    FixedTransformsMap subframes;
+  };
+
+  bool msgToRobotState(const Transforms* tf, const moveit_msgs::msg::RobotState& robot_state, RobotState& state,
+                       bool copy_attached_bodies);
+  bool jointStateToRobotState(const sensor_msgs::msg::JointState& joint_state, RobotState& state);
+  void attachedCollisionObjectsToRobotState(const Transforms* tf, const moveit_msgs::msg::RobotState& robot_state,
+                                            RobotState& state);
+  bool isAttachedBodyUnchanged(const moveit_msgs::msg::AttachedCollisionObject& aco, const RobotState& state) const;
+  void setRobotModel(const RobotModelConstPtr& robot_model);
+
+  RobotModelConstPtr robot_model_;
+
+  // joint names of the last message and the variable index of each name
+  std::vector<std::string> joint_names_;
+  std::vector<int> variable_indices_;
+  // true if the joint names are all variables of a model without mimic joints, in order
+  bool identity_layout_ = false;
+
+  // single-DOF joints of the model and their variable, the layout of created messages
+  std::vector<std::string> single_dof_joint_names_;
+  std::vector<int> single_dof_variable_indices_;
+
+  std::map<std::string, AttachedBodyEntry> attached_bodies_;
+  std::map<shapes::ShapeConstPtr, shapes::ShapeMsg> shape_msgs_;
+};
+
 /**
  * @brief Convert a MoveIt robot state to common separated values (CSV) on a single line that is
  *        outputted to a stream e.g. for file saving
@@ -39,11 +39,13 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/attached_body.h>
+#include <moveit/robot_state/robot_state_arena.h>
 #include <moveit/transforms/transforms.h>
 #include <sensor_msgs/msg/joint_state.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 #include <std_msgs/msg/color_rgba.hpp>
 #include <geometry_msgs/msg/twist.hpp>
+#include <array>
 #include <cassert>
 
 #include <rclcpp/duration.hpp>
@@ -97,6 +99,16 @@ public:
   /** \brief Copy constructor. */
   RobotState(const RobotState& other);
 
+  /** \brief Copy constructor, optionally sharing the transforms with \e other (copy-on-write).
+
+      If \e share_transforms is true, the (potentially large) memory holding joint, link and collision body
+      transforms is not copied, but shared between both states until one of them needs to recompute a transform.
+      Only then, that state creates its own copy. This makes cloning cheap in loops where most clones are
+      never updated or are discarded quickly.
+      Note that references to transforms obtained from either state before the copy may refer to
+      the shared memory afterwards and might not reflect later updates of that state. */
+  RobotState(const RobotState& other, bool share_transforms);
+
   /** \brief Copy operator */
   RobotState& operator=(const RobotState& other);
 
@@ -1047,6 +1059,21 @@ public:
                           const GroupStateValidityCallbackFn& constraint = GroupStateValidityCallbackFn(),
                           const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions());
 
+  /** \brief Solve IK for many independent poses of a single tip at once, using the batch interface of the group's
+      kinematics solver. Every pose is seeded with the current joint values of the group; this state is not changed.
+      The poses are assumed to be in the reference frame of the kinematic model.
+      @param poses The poses the tip needs to achieve
+      @param tip The name of the frame for which IK is attempted, as for setFromIK()
+      @param states Returned copies of this state, one per pose, holding the solution of the pose if it was solved
+      @param solved Returned flags telling which poses were solved
+      @param timeout The timeout passed to the kinematics solver for each pose
+      @param constraint A state validity constraint to be required for IK solutions, it is never called concurrently
+      @return True if all poses were solved */
+  bool setFromIKBatch(const JointModelGroup* group, const EigenSTL::vector_Isometry3d& poses, const std::string& tip,
+                      std::vector<RobotState>& states, std::vector<bool>& solved, double timeout = 0.0,
+                      const GroupStateValidityCallbackFn& constraint = GroupStateValidityCallbackFn(),
+                      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions());
+
   /** \brief Set the joint values from a Cartesian velocity applied during a time dt
    * @param group the group of joints this function operates on
    * @param twist a Cartesian velocity on the 'tip' frame
@@ -1152,6 +1179,8 @@ public:
                    Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false) const;
 
   /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group.
+   * Link transforms are updated first, if needed. The result of the last call is cached and returned
+   * without recomputation as long as the state's link transforms don't change.
    * \param group The group to compute the Jacobian for
    * \param link The link model to compute the Jacobian for
    * \param reference_point_position The reference point position (with respect to the link specified in link)
@@ -1161,11 +1190,29 @@ public:
    * \return True if jacobian was successfully computed, false otherwise
    */
   bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
-                   Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false)
+                   Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false);
+
+  /** \brief Compute the Jacobian and its time derivative with reference to a particular point on a given link,
+   * for a specified group. The time derivative is computed from the current joint velocities (zero if the state
+   * has no velocities). Only revolute and prismatic joints are supported.
+   * \param group The group to compute the Jacobian for
+   * \param link The link model to compute the Jacobian for
+   * \param reference_point_position The reference point position (with respect to the link specified in link)
+   * \param jacobian The resultant 6xN jacobian. Its memory is reused if it has the correct size already.
+   * \param jacobian_derivative The resultant 6xN time derivative of the jacobian. Its memory is reused as well.
+   * \return True if jacobian was successfully computed, false otherwise
+   */
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::MatrixXd& jacobian, Eigen::MatrixXd& jacobian_derivative) const;
+
+  /** \brief Compute the Jacobian and its time derivative with reference to a particular point on a given link,
+   * for a specified group. See the const version for details. */
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::MatrixXd& jacobian, Eigen::MatrixXd& jacobian_derivative)
   {
     updateLinkTransforms();
     return static_cast<const RobotState*>(this)->getJacobian(group, link, reference_point_position, jacobian,
-                                                             use_quaternion_representation);
+                                                             jacobian_derivative);
   }
 
   /** \brief Compute the Jacobian with reference to the last link of a specified group. If the group is not a chain, an
@@ -1184,11 +1231,7 @@ public:
    * \return The computed Jacobian.
    */
   Eigen::MatrixXd getJacobian(const JointModelGroup* group,
-                              const Eigen::Vector3d& reference_point_position = Eigen::Vector3d(0.0, 0.0, 0.0))
-  {
-    updateLinkTransforms();
-    return static_cast<const RobotState*>(this)->getJacobian(group, reference_point_position);
-  }
+                              const Eigen::Vector3d& reference_point_position = Eigen::Vector3d(0.0, 0.0, 0.0));
 
   /** \brief Given a twist for a particular link (\e tip), compute the corresponding velocity for every variable and
    * store it in \e qdot */
@@ -1304,6 +1347,13 @@ public:
    * for coordinate transforms. */
   void updateLinkTransforms();
 
+  /** \brief Update the reference frame transforms only for those dirty links whose transforms depend on \e group.
+   *
+   * Dirty subtrees unrelated to the group (e.g. the other arm of a dual-arm robot) are left dirty
+   * and will be updated by the next call to updateLinkTransforms(). A dirty subtree above the group is
+   * updated completely, as it is required to compute the group's link transforms. */
+  void updateLinkTransforms(const JointModelGroup* group);
+
   /** \brief Update all transforms. */
   void update(bool force = false);
 
@@ -1366,7 +1416,7 @@ public:
     {
       throw Exception("Invalid link");
     }
-    assert(checkLinkTransforms());
+    assert(checkLinkTransform(link));
     return global_link_transforms_[link->getLinkIndex()];
   }
 
@@ -1413,6 +1463,7 @@ public:
     unsigned char& dirty = dirty_joint_transforms_[idx];
     if (dirty)
     {
+      ensureUniqueTransforms();
       joint->computeTransform(position_ + joint->getFirstVariableIndex(), variable_joint_transforms_[idx]);
       dirty = 0;
     }
@@ -1440,6 +1491,9 @@ public:
     return dirty_link_transforms_;
   }
 
+  /** \brief Returns true if the transform of \e link is not up to date */
+  bool dirtyLinkTransform(const LinkModel* link) const;
+
   bool dirtyCollisionBodyTransforms() const
   {
     return dirty_link_transforms_ || dirty_collision_body_transforms_;
@@ -1824,25 +1878,64 @@ public:
 
 private:
   void allocMemory();
+  void allocTransforms();
   void initTransforms();
-  void copyFrom(const RobotState& other);
+  void copyFrom(const RobotState& other, bool share_transforms = false);
+
+  /** \brief Make sure the transforms are not shared with another state before modifying them */
+  void ensureUniqueTransforms()
+  {
+    if (transforms_memory_.use_count() > 1)
+      unshareTransforms();
+  }
+  void unshareTransforms();
 
   void markDirtyJointTransforms(const JointModel* joint)
   {
     dirty_joint_transforms_[joint->getJointIndex()] = 1;
-    dirty_link_transforms_ =
-        dirty_link_transforms_ == nullptr ? joint : robot_model_->getCommonRoot(dirty_link_transforms_, joint);
+    markDirtyLinkTransforms(joint);
   }
 
   void markDirtyJointTransforms(const JointModelGroup* group)
   {
     for (const JointModel* jm : group->getActiveJointModels())
       dirty_joint_transforms_[jm->getJointIndex()] = 1;
-    dirty_link_transforms_ = dirty_link_transforms_ == nullptr ?
-                                 group->getCommonRoot() :
-                                 robot_model_->getCommonRoot(dirty_link_transforms_, group->getCommonRoot());
+    markDirtyLinkTransforms(group->getCommonRoot());
   }
 
+  /** \brief Mark the link transforms of the subtree starting at \e joint as dirty */
+  void markDirtyLinkTransforms(const JointModel* joint)
+  {
+    if (dirty_link_transforms_ == nullptr)
+    {
+      dirty_link_transforms_ = joint;
+      dirty_link_roots_count_ = 0;
+    }
+    else if (dirty_link_transforms_ == joint)
+      dirty_link_roots_count_ = 0;  // joint is the common root of all dirty subtrees, so it covers all of them
+    else
+      addDirtyLinkRoot(joint);
+  }
+
+  /** \brief Add the subtree at \e joint to the set of independent dirty subtrees */
+  void addDirtyLinkRoot(const JointModel* joint);
+
+  /** \brief Set all link transforms dirty, discarding the individual dirty subtrees */
+  void markAllLinkTransformsDirty()
+  {
+    dirty_link_transforms_ = robot_model_->getRootJoint();
+    dirty_link_roots_count_ = 0;
+  }
+
+  /** \brief Returns true if all link transforms need to be recomputed */
+  bool allLinkTransformsDirty() const
+  {
+    return dirty_link_transforms_ == robot_model_->getRootJoint() && dirty_link_roots_count_ == 0;
+  }
+
+  /** \brief Update the transforms of attached bodies from the global link transforms */
+  void updateAttachedBodyTransforms();
+
   void markVelocity();
   void markAcceleration();
   void markEffort();
@@ -1886,6 +1979,23 @@ private:
 
   void updateLinkTransformsInternal(const JointModel* start);
 
+  /** \brief Cache for the Jacobian computed by the non-const getJacobian() overloads */
+  struct JacobianCache
+  {
+    bool valid = false;
+    const JointModelGroup* group = nullptr;
+    const LinkModel* link = nullptr;
+    Eigen::Vector3d reference_point_position;
+    bool use_quaternion_representation = false;
+    Eigen::MatrixXd jacobian;
+  };
+
+  void invalidateJacobianCache()
+  {
+    if (jacobian_cache_)
+      jacobian_cache_->valid = false;
+  }
+
   void getMissingKeys(const std::map<std::string, double>& variable_map,
                       std::vector<std::string>& missing_variables) const;
   void getStateTreeJointString(std::ostream& ss, const JointModel* jm, const std::string& pfx0, bool last) const;
@@ -1896,11 +2006,18 @@ private:
   /** \brief This function is only called in debug mode */
   bool checkLinkTransforms() const;
 
+  /** \brief This function is only called in debug mode */
+  bool checkLinkTransform(const LinkModel* link) const;
+
   /** \brief This function is only called in debug mode */
   bool checkCollisionTransforms() const;
 
   RobotModelConstPtr robot_model_;
-  void* memory_;
+  void* memory_;  ///< dirty flags, positions, velocities and accelerations
+
+  /** \brief Aligned memory for all transforms. This may be shared with copies of this state, see
+      RobotState(const RobotState&, bool). */
+  std::shared_ptr<void> transforms_memory_;
 
   double* position_;
   double* velocity_;
@@ -1910,10 +2027,18 @@ private:
   bool has_acceleration_;
   bool has_effort_;
 
-  const JointModel* dirty_link_transforms_;
+  /** \brief Maximum number of independent dirty subtrees tracked before falling back to their common root */
+  static constexpr std::size_t MAX_DIRTY_LINK_ROOTS = 4;
+
+  const JointModel* dirty_link_transforms_;  ///< common root of all dirty link transforms
   const JointModel* dirty_collision_body_transforms_;
 
-  // All the following transform variables point into aligned memory in memory_
+  // Roots of disjoint subtrees with dirty link transforms, all below dirty_link_transforms_.
+  // If dirty_link_roots_count_ is 0, dirty_link_transforms_ is the only dirty root.
+  std::array<const JointModel*, MAX_DIRTY_LINK_ROOTS> dirty_link_roots_;
+  std::size_t dirty_link_roots_count_;
+
+  // All the following transform variables point into aligned memory in transforms_memory_
   // They are updated lazily, based on the flags in dirty_joint_transforms_
   // resp. the pointers dirty_link_transforms_ and dirty_collision_body_transforms_
   Eigen::Isometry3d* variable_joint_transforms_;         ///< Local transforms of all joints
@@ -1921,6 +2046,12 @@ private:
   Eigen::Isometry3d* global_collision_body_transforms_;  ///< Transforms from model frame to collision bodies
   unsigned char* dirty_joint_transforms_;
 
+  /** \brief The arena memory_ and transforms_memory_ are allocated from, if any (see RobotStateArena) */
+  RobotStateArenaPtr arena_;
+
+  /** \brief Allocated on first use of the non-const getJacobian(). Only valid with up-to-date link transforms. */
+  std::unique_ptr<JacobianCache> jacobian_cache_;
+
   /** \brief All attached bodies that are part of this state, indexed by their name */
   std::map<std::string, std::unique_ptr<AttachedBody>> attached_body_map_;
 
@@ -0,0 +1,112 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(RobotStateArena);  // Defines RobotStateArenaPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Pooled memory for the robot states created while serving one request, e.g. a motion plan request.
+
+    Bind an arena to the current thread with a Scope; every RobotState constructed on that thread while the scope is
+    alive takes its variable and transform buffers from the arena instead of the global heap. The arena carves them out
+    of large chunks and recycles the buffers of destroyed states for new states of the same size, so after warming up a
+    request allocates no further memory for its states. States keep their arena alive, so states that outlive the
+    request (e.g. the waypoints of the planned trajectory) remain valid; the chunks are released wholesale once the
+    arena and all its states are gone. Buffers may be returned from any thread. */
+class RobotStateArena
+{
+public:
+  /** \brief Counters describing the use of an arena */
+  struct Statistics
+  {
+    std::size_t allocations = 0;       ///< Buffers handed out
+    std::size_t recycled = 0;          ///< Buffers handed out again after they were returned
+    std::size_t heap_allocations = 0;  ///< Chunks allocated from the global heap
+    std::size_t heap_bytes = 0;        ///< Total size of the chunks
+    std::size_t buffers_in_use = 0;    ///< Buffers handed out and not returned yet
+  };
+
+  /** \brief Binds an arena to the current thread for the lifetime of the scope. Scopes may be nested. */
+  class Scope
+  {
+  public:
+    Scope(const RobotStateArenaPtr& arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    RobotStateArenaPtr previous_;
+  };
+
+  /** \brief Construct an arena allocating chunks of \e chunk_size bytes; larger buffers get a chunk of their own */
+  RobotStateArena(std::size_t chunk_size = 64 * 1024);
+  ~RobotStateArena();
+
+  RobotStateArena(const RobotStateArena&) = delete;
+  RobotStateArena& operator=(const RobotStateArena&) = delete;
+
+  /** \brief The arena bound to the current thread, nullptr if there is none */
+  static const RobotStateArenaPtr& getCurrent();
+
+  /** \brief Get a buffer of \e bytes bytes, aligned like malloc() */
+  void* allocate(std::size_t bytes);
+
+  /** \brief Return a buffer obtained from allocate() with the same \e bytes */
+  void deallocate(void* buffer, std::size_t bytes);
+
+  /** \brief Get the counters of the arena */
+  Statistics getStatistics() const;
+
+private:
+  const std::size_t chunk_size_;
+  mutable std::mutex lock_;
+  std::vector<void*> chunks_;
+  char* chunk_position_ = nullptr;  ///< Unused memory at the end of the last chunk
+  std::size_t chunk_remaining_ = 0;
+  std::unordered_map<std::size_t, std::vector<void*>> free_buffers_;  ///< Returned buffers by size
+  Statistics statistics_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,156 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Geometry>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+class RobotState;
+
+MOVEIT_CLASS_FORWARD(RobotStateBatch);  // Defines RobotStateBatchPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Forward kinematics for many configurations of the same robot at once.
+
+    Joint positions and global link transforms are stored as structure-of-arrays:
+    for every variable (resp. every component of a link's 3x4 affine transform) the values
+    of all states in the batch are contiguous in memory. Walking the kinematic tree
+    once and updating all states per link keeps the inner loops branch-free, so that
+    the compiler can vectorize them across states. This is useful whenever many
+    candidate configurations need to be evaluated, e.g. in sampling-based planners.
+
+    Only positions and link transforms are handled; attached bodies and collision body
+    transforms remain the responsibility of RobotState. */
+class RobotStateBatch
+{
+public:
+  /** \brief Number of stored components per transform: 3x3 rotation followed by translation, column major */
+  static constexpr std::size_t TRANSFORM_COMPONENTS = 12;
+
+  /** \brief Construct a batch of \e size states for \e robot_model. Positions are not initialized. */
+  RobotStateBatch(const RobotModelConstPtr& robot_model, std::size_t size = 0);
+
+  /** \brief Get the robot model this batch is constructed for. */
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** \brief Get the number of states in this batch */
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  /** \brief Change the number of states in this batch. Existing positions are not preserved. */
+  void resize(std::size_t size);
+
+  /** \brief Set all variable positions (including mimic joints) of the state at \e state_index.
+      \e positions is expected to be ordered like RobotState::getVariablePositions(). */
+  void setVariablePositions(std::size_t state_index, const double* positions);
+
+  /** \brief Set all variable positions of the state at \e state_index from \e state */
+  void setVariablePositions(std::size_t state_index, const RobotState& state);
+
+  /** \brief Copy all variable positions of the state at \e state_index into \e positions */
+  void copyVariablePositions(std::size_t state_index, double* positions) const;
+
+  /** \brief Copy the variable positions of the state at \e state_index into \e state */
+  void copyVariablePositions(std::size_t state_index, RobotState& state) const;
+
+  /** \brief Get the contiguous array of size() values of variable \e variable_index across all states.
+      If these values are modified, dirty() is set and transforms are recomputed on the next update. */
+  double* getVariablePositions(std::size_t variable_index)
+  {
+    dirty_ = true;
+    return &positions_[variable_index * size_];
+  }
+
+  const double* getVariablePositions(std::size_t variable_index) const
+  {
+    return &positions_[variable_index * size_];
+  }
+
+  /** \brief Compute the global link transforms of all links for all states in the batch */
+  void updateLinkTransforms();
+
+  /** \brief Returns true if positions were changed since the last call to updateLinkTransforms() */
+  bool dirty() const
+  {
+    return dirty_;
+  }
+
+  /** \brief Assemble the global transform of \e link for the state at \e state_index.
+      updateLinkTransforms() needs to be called before. */
+  Eigen::Isometry3d getGlobalLinkTransform(std::size_t state_index, const LinkModel* link) const;
+
+  /** \brief Get the contiguous array of size() values of one \e component (see TRANSFORM_COMPONENTS)
+      of the global transform of \e link across all states */
+  const double* getGlobalLinkTransformComponent(const LinkModel* link, std::size_t component) const
+  {
+    return &link_transforms_[(link->getLinkIndex() * TRANSFORM_COMPONENTS + component) * size_];
+  }
+
+private:
+  double* linkTransform(std::size_t link_index)
+  {
+    return &link_transforms_[link_index * TRANSFORM_COMPONENTS * size_];
+  }
+
+  /** \brief Compute the local transform of \e joint for all states into joint_transforms_ */
+  void computeJointTransforms(const JointModel* joint);
+
+  RobotModelConstPtr robot_model_;
+  std::size_t size_;
+  bool dirty_;
+
+  /** \brief Positions, indexed as [variable_index * size_ + state_index] */
+  std::vector<double> positions_;
+
+  /** \brief Global link transforms, indexed as [(link_index * TRANSFORM_COMPONENTS + component) * size_ + state_index]
+   */
+  std::vector<double> link_transforms_;
+
+  /** \brief Scratch buffers holding the joint transform and the parent * origin transform of the current link */
+  std::vector<double> joint_transforms_;
+  std::vector<double> parent_transforms_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -55,7 +55,6 @@ AttachedBody::AttachedBody(const LinkModel* parent, const std::string& id, const
   , touch_links_(touch_links)
   , detach_posture_(detach_posture)
   , subframe_poses_(subframe_poses)
-  , global_subframe_poses_(subframe_poses)
 {
   ASSERT_ISOMETRY(pose)  // unsanitized input, could contain a non-isometry
   for (const auto& t : shape_poses_)
@@ -68,10 +67,12 @@ AttachedBody::AttachedBody(const LinkModel* parent, const std::string& id, const
   }
 
   // Global poses are initialized to identity to allow efficient Isometry calculations
-  global_pose_.setIdentity();
-  global_collision_body_transforms_.resize(shape_poses.size());
-  for (Eigen::Isometry3d& global_collision_body_transform : global_collision_body_transforms_)
+  global_.parent_link_transform.setIdentity();
+  global_.pose.setIdentity();
+  global_.collision_body_transforms.resize(shape_poses.size());
+  for (Eigen::Isometry3d& global_collision_body_transform : global_.collision_body_transforms)
     global_collision_body_transform.setIdentity();
+  global_.subframe_poses = subframe_poses;
 
   shape_poses_in_link_frame_.clear();
   shape_poses_in_link_frame_.reserve(shape_poses_.size());
@@ -105,16 +106,29 @@ void AttachedBody::setScale(double scale)
 void AttachedBody::computeTransform(const Eigen::Isometry3d& parent_link_global_transform)
 {
   ASSERT_ISOMETRY(parent_link_global_transform)  // unsanitized input, could contain a non-isometry
-  global_pose_ = parent_link_global_transform * pose_;
+  // the transforms only need to be recomputed if the parent link moved
+  if (global_.parent_link_transform.affine() == parent_link_global_transform.affine())
+    return;
+  global_.parent_link_transform = parent_link_global_transform;
+  global_.valid.store(false, std::memory_order_release);
+}
+
+void AttachedBody::updateGlobalTransforms() const
+{
+  std::scoped_lock slock(global_.mutex);
+  if (global_.valid.load(std::memory_order_relaxed))
+    return;
+  global_.pose = global_.parent_link_transform * pose_;
 
   // update collision body transforms
-  for (std::size_t i = 0; i < global_collision_body_transforms_.size(); ++i)
-    global_collision_body_transforms_[i] = global_pose_ * shape_poses_[i];  // valid isometry
+  for (std::size_t i = 0; i < global_.collision_body_transforms.size(); ++i)
+    global_.collision_body_transforms[i] = global_.pose * shape_poses_[i];  // valid isometry
 
   // update subframe transforms
-  for (auto global = global_subframe_poses_.begin(), end = global_subframe_poses_.end(), local = subframe_poses_.begin();
-       global != end; ++global, ++local)
-    global->second = global_pose_ * local->second;  // valid isometry
+  auto local = subframe_poses_.cbegin();
+  for (auto& global : global_.subframe_poses)
+    global.second = global_.pose * (local++)->second;  // valid isometry
+  global_.valid.store(true, std::memory_order_release);
 }
 
 void AttachedBody::setPadding(double padding)
@@ -158,8 +172,9 @@ const Eigen::Isometry3d& AttachedBody::getGlobalSubframeTransform(const std::str
 {
   if (frame_name.rfind(id_, 0) == 0 && frame_name[id_.length()] == '/')
   {
-    auto it = global_subframe_poses_.find(frame_name.substr(id_.length() + 1));
-    if (it != global_subframe_poses_.end())
+    const FixedTransformsMap& global_subframe_poses = getGlobalTransforms().subframe_poses;
+    auto it = global_subframe_poses.find(frame_name.substr(id_.length() + 1));
+    if (it != global_subframe_poses.end())
     {
       if (found)
         *found = true;
@@ -36,7 +36,10 @@
 
 /* Author: Ioan Sucan, Sachin Chitta, Acorn Pooley, Mario Prats, Dave Coleman */
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <moveit/robot_state/cartesian_interpolator.h>
 #include <geometric_shapes/check_isometry.h>
 #include <rclcpp/logger.hpp>
@@ -54,11 +57,106 @@ static const std::size_t MIN_STEPS_FOR_JUMP_THRESH = 10;
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_robot_state.cartesian_interpolator");
 
+namespace
+{
+// Move the virtual frame link * link_offset of state towards target with damped least-squares Jacobian steps, starting
+// from the current joint values. Return false if the tolerances are not reached or a consistency limit is exceeded.
+bool stepWithJacobian(RobotState& state, const JointModelGroup* group, const LinkModel* link,
+                      const Eigen::Isometry3d& link_offset, const Eigen::Isometry3d& target,
+                      const std::vector<double>& consistency_limits, const JacobianStepping& stepping)
+{
+  Eigen::VectorXd positions;
+  state.copyJointGroupPositions(group, positions);
+  if (!consistency_limits.empty() && consistency_limits.size() != static_cast<std::size_t>(positions.size()))
+    return false;
+  const Eigen::VectorXd start_positions = positions;
+
+  // the Jacobian is expressed in the frame of the group's root link
+  const LinkModel* root_link = group->getJointModels()[0]->getParentLinkModel();
+  Eigen::MatrixXd jacobian;
+  Eigen::Matrix<double, 6, 1> twist;
+  for (unsigned int iteration = 0;; ++iteration)
+  {
+    const Eigen::Isometry3d pose = state.getGlobalLinkTransform(link) * link_offset;
+    const Eigen::Vector3d translation_error = target.translation() - pose.translation();
+    const Eigen::AngleAxisd rotation_error(target.linear() * pose.linear().transpose());
+    if (translation_error.norm() <= stepping.translation_tolerance &&
+        std::fabs(rotation_error.angle()) <= stepping.rotation_tolerance)
+      break;
+    if (iteration == stepping.max_iterations)
+      return false;
+
+    const Eigen::Matrix3d root_rotation =
+        root_link ? state.getGlobalLinkTransform(root_link).linear().transpose() : Eigen::Matrix3d::Identity();
+    twist.head<3>() = root_rotation * translation_error;
+    twist.tail<3>() = root_rotation * (rotation_error.angle() * rotation_error.axis());
+    if (!static_cast<const RobotState&>(state).getJacobian(group, link, link_offset.translation(), jacobian))
+      return false;
+
+    // dq = J^T (J J^T + lambda^2 I)^-1 e
+    Eigen::Matrix<double, 6, 6> jjt = jacobian * jacobian.transpose();
+    jjt.diagonal().array() += stepping.damping * stepping.damping;
+    positions += jacobian.transpose() * jjt.ldlt().solve(twist);
+
+    state.setJointGroupPositions(group, positions);
+    state.enforceBounds(group);
+    state.copyJointGroupPositions(group, positions);
+    state.updateLinkTransforms();
+  }
+
+  for (std::size_t i = 0; i < consistency_limits.size(); ++i)
+  {
+    if (std::fabs(positions[i] - start_positions[i]) > consistency_limits[i])
+      return false;
+  }
+  return true;
+}
+
+// Find the first state of traj in [begin, end) rejected by valid_callback. Midpoints are checked coarse to fine, so
+// an invalid state is usually found early and the states behind it are not checked at all. Return end if all are valid.
+std::size_t findFirstInvalidState(const JointModelGroup* group, const std::vector<RobotStatePtr>& traj,
+                                  std::size_t begin, std::size_t end,
+                                  const GroupStateValidityCallbackFn& valid_callback)
+{
+  if (!valid_callback || begin >= end)
+    return end;
+
+  std::size_t first_invalid = end;
+  std::vector<double> positions;
+  std::vector<std::pair<std::size_t, std::size_t>> ranges{ { begin, end } };
+  for (std::size_t r = 0; r < ranges.size(); ++r)
+  {
+    const std::size_t lo = ranges[r].first;
+    const std::size_t hi = std::min(ranges[r].second, first_invalid);
+    if (lo >= hi)
+      continue;
+    const std::size_t mid = lo + (hi - lo) / 2;
+    RobotState state(*traj[mid]);
+    state.copyJointGroupPositions(group, positions);
+    if (!valid_callback(&state, group, positions.data()))
+      first_invalid = mid;
+    ranges.emplace_back(lo, mid);
+    ranges.emplace_back(mid + 1, hi);
+  }
+  return first_invalid;
+}
+
+// The largest joint-space distance between consecutive states of traj
+double maxStepDistance(const JointModelGroup* group, const std::vector<RobotStatePtr>& traj)
+{
+  double max_distance = 0.0;
+  for (std::size_t i = 1; i < traj.size(); ++i)
+    max_distance = std::max(max_distance, traj[i]->distance(*traj[i - 1], group));
+  return max_distance;
+}
+}  // namespace
+
 CartesianInterpolator::Distance CartesianInterpolator::computeCartesianPath(
     RobotState* start_state, const JointModelGroup* group, std::vector<RobotStatePtr>& traj, const LinkModel* link,
     const Eigen::Vector3d& translation, bool global_reference_frame, const MaxEEFStep& max_step,
     const JumpThreshold& jump_threshold, const GroupStateValidityCallbackFn& validCallback,
-    const kinematics::KinematicsQueryOptions& options, const kinematics::KinematicsBase::IKCostFn& cost_function)
+    const kinematics::KinematicsQueryOptions& options, const kinematics::KinematicsBase::IKCostFn& cost_function,
+    const JacobianStepping& jacobian_stepping)
 {
   const double distance = translation.norm();
   // The target pose is obtained by adding the translation vector to the link's current pose
@@ -70,7 +168,9 @@ CartesianInterpolator::Distance CartesianInterpolator::computeCartesianPath(
   // call computeCartesianPath for the computed target pose in the global reference frame
   return CartesianInterpolator::Distance(distance) * computeCartesianPath(start_state, group, traj, link, pose, true,
                                                                           max_step, jump_threshold, validCallback,
-                                                                          options, cost_function);
+                                                                          options, cost_function,
+                                                                          Eigen::Isometry3d::Identity(),
+                                                                          jacobian_stepping);
 }
 
 CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
@@ -78,7 +178,23 @@ CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
     const Eigen::Isometry3d& target, bool global_reference_frame, const MaxEEFStep& max_step,
     const JumpThreshold& jump_threshold, const GroupStateValidityCallbackFn& validCallback,
     const kinematics::KinematicsQueryOptions& options, const kinematics::KinematicsBase::IKCostFn& cost_function,
-    const Eigen::Isometry3d& link_offset)
+    const Eigen::Isometry3d& link_offset, const JacobianStepping& jacobian_stepping)
+{
+  return CartesianInterpolator::Percentage(computeSegment(start_state, group, traj, link, target,
+                                                          global_reference_frame, max_step, jump_threshold,
+                                                          validCallback, options, cost_function, link_offset,
+                                                          jacobian_stepping, nullptr));
+}
+
+double CartesianInterpolator::computeSegment(RobotState* start_state, const JointModelGroup* group,
+                                             std::vector<RobotStatePtr>& traj, const LinkModel* link,
+                                             const Eigen::Isometry3d& target, bool global_reference_frame,
+                                             const MaxEEFStep& max_step, const JumpThreshold& jump_threshold,
+                                             const GroupStateValidityCallbackFn& validCallback,
+                                             const kinematics::KinematicsQueryOptions& options,
+                                             const kinematics::KinematicsBase::IKCostFn& cost_function,
+                                             const Eigen::Isometry3d& link_offset,
+                                             const JacobianStepping& jacobian_stepping, std::mutex* ik_mutex)
 {
   // check unsanitized inputs for non-isometry
   ASSERT_ISOMETRY(target)
@@ -151,32 +267,82 @@ CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
   traj.clear();
   traj.push_back(std::make_shared<moveit::core::RobotState>(*start_state));
 
-  double last_valid_percentage = 0.0;
-  for (std::size_t i = 1; i <= steps; ++i)
+  // traj[i] holds the state of step i; the states in [validated, traj.size()) were reached by Jacobian steps and are
+  // not yet checked by validCallback
+  std::size_t validated = traj.size();
+  const std::size_t batch_size = std::max<std::size_t>(jacobian_stepping.validation_batch_size, 1);
+  const bool use_jacobian = jacobian_stepping.enabled && group->isChain();
+  bool force_ik = false;
+  std::size_t i = 1;
+  while (i <= steps)
   {
     double percentage = static_cast<double>(i) / static_cast<double>(steps);
 
     Eigen::Isometry3d pose(start_quaternion.slerp(percentage, target_quaternion));
     pose.translation() = percentage * rotated_target.translation() + (1 - percentage) * start_pose.translation();
 
-    // Explicitly use a single IK attempt only: We want a smooth trajectory.
-    // Random seeding (of additional attempts) would probably create IK jumps.
-    if (start_state->setFromIK(group, pose * offset, link->getName(), consistency_limits, 0.0, validCallback, options,
-                               cost_function))
+    const bool jacobian_step = use_jacobian && !force_ik;
+    if (jacobian_step &&
+        stepWithJacobian(*start_state, group, link, link_offset, pose, consistency_limits, jacobian_stepping))
     {
       traj.push_back(std::make_shared<moveit::core::RobotState>(*start_state));
+      if (traj.size() - validated < batch_size && i < steps)
+      {
+        ++i;
+        continue;
+      }
     }
     else
     {
-      break;
+      // the Jacobian steps did not converge, continue from the last state of the path
+      if (jacobian_step)
+        *start_state = *traj.back();
+
+      if (validated == traj.size())
+      {
+        // Explicitly use a single IK attempt only: We want a smooth trajectory.
+        // Random seeding (of additional attempts) would probably create IK jumps.
+        std::unique_lock<std::mutex> ik_lock;
+        if (ik_mutex)
+          ik_lock = std::unique_lock<std::mutex>(*ik_mutex);
+        if (!start_state->setFromIK(group, pose * offset, link->getName(), consistency_limits, 0.0, validCallback,
+                                    options, cost_function))
+          break;
+        ik_lock = std::unique_lock<std::mutex>();
+        traj.push_back(std::make_shared<moveit::core::RobotState>(*start_state));
+        validated = traj.size();
+        force_ik = false;
+        ++i;
+        continue;
+      }
     }
 
-    last_valid_percentage = percentage;
+    // validate the pending states reached by Jacobian steps; the first invalid one is computed again by the IK solver
+    const std::size_t invalid = findFirstInvalidState(group, traj, validated, traj.size(), validCallback);
+    if (invalid < traj.size())
+    {
+      traj.resize(invalid);
+      *start_state = *traj.back();
+      i = invalid;
+      force_ik = true;
+    }
+    else if (traj.size() == i + 1)
+    {
+      // the batch ended with a Jacobian step
+      ++i;
+    }
+    else
+    {
+      // the Jacobian steps did not converge for step i
+      force_ik = true;
+    }
+    validated = traj.size();
   }
 
+  double last_valid_percentage = static_cast<double>(traj.size() - 1) / static_cast<double>(steps);
   last_valid_percentage *= checkJointSpaceJump(group, traj, jump_threshold);
 
-  return CartesianInterpolator::Percentage(last_valid_percentage);
+  return last_valid_percentage;
 }
 
 CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
@@ -184,8 +350,19 @@ CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
     const EigenSTL::vector_Isometry3d& waypoints, bool global_reference_frame, const MaxEEFStep& max_step,
     const JumpThreshold& jump_threshold, const GroupStateValidityCallbackFn& validCallback,
     const kinematics::KinematicsQueryOptions& options, const kinematics::KinematicsBase::IKCostFn& cost_function,
-    const Eigen::Isometry3d& link_offset)
+    const Eigen::Isometry3d& link_offset, const JacobianStepping& jacobian_stepping, std::size_t thread_count)
 {
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  if (thread_count > 1 && waypoints.size() > 1)
+  {
+    double percentage_solved =
+        computeSegmentsInParallel(start_state, group, traj, link, waypoints, global_reference_frame, max_step,
+                                  validCallback, options, cost_function, link_offset, jacobian_stepping, thread_count);
+    percentage_solved *= checkJointSpaceJump(group, traj, jump_threshold);
+    return CartesianInterpolator::Percentage(percentage_solved);
+  }
+
   double percentage_solved = 0.0;
   for (std::size_t i = 0; i < waypoints.size(); ++i)
   {
@@ -194,7 +371,8 @@ CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
     std::vector<RobotStatePtr> waypoint_traj;
     double wp_percentage_solved =
         computeCartesianPath(start_state, group, waypoint_traj, link, waypoints[i], global_reference_frame, max_step,
-                             NO_JOINT_SPACE_JUMP_TEST, validCallback, options, cost_function, link_offset);
+                             NO_JOINT_SPACE_JUMP_TEST, validCallback, options, cost_function, link_offset,
+                             jacobian_stepping);
     if (fabs(wp_percentage_solved - 1.0) < std::numeric_limits<double>::epsilon())
     {
       percentage_solved = static_cast<double>((i + 1)) / static_cast<double>(waypoints.size());
@@ -219,6 +397,103 @@ CartesianInterpolator::Percentage CartesianInterpolator::computeCartesianPath(
   return CartesianInterpolator::Percentage(percentage_solved);
 }
 
+double CartesianInterpolator::computeSegmentsInParallel(
+    RobotState* start_state, const JointModelGroup* group, std::vector<RobotStatePtr>& traj, const LinkModel* link,
+    const EigenSTL::vector_Isometry3d& waypoints, bool global_reference_frame, const MaxEEFStep& max_step,
+    const GroupStateValidityCallbackFn& validCallback, const kinematics::KinematicsQueryOptions& options,
+    const kinematics::KinematicsBase::IKCostFn& cost_function, const Eigen::Isometry3d& link_offset,
+    const JacobianStepping& jacobian_stepping, std::size_t thread_count)
+{
+  // Don't test joint space jumps for every segment, test them later on the whole trajectory.
+  static const JumpThreshold NO_JOINT_SPACE_JUMP_TEST;
+  const std::size_t segment_count = waypoints.size();
+
+  // the waypoints in the global reference frame
+  EigenSTL::vector_Isometry3d targets(segment_count);
+  Eigen::Isometry3d target = start_state->getGlobalLinkTransform(link) * link_offset;
+  for (std::size_t k = 0; k < segment_count; ++k)
+  {
+    target = global_reference_frame ? waypoints[k] : target * waypoints[k];
+    targets[k] = target;
+  }
+
+  // the start state of each segment is the IK solution at the preceding waypoint, seeded with the previous one
+  std::vector<RobotStatePtr> segment_starts(segment_count);
+  segment_starts[0] = std::make_shared<RobotState>(*start_state);
+  const Eigen::Isometry3d offset = link_offset.inverse();
+  for (std::size_t k = 1; k < segment_count; ++k)
+  {
+    auto segment_start = std::make_shared<RobotState>(*segment_starts[k - 1]);
+    if (!segment_start->setFromIK(group, targets[k - 1] * offset, link->getName(), 0.0, validCallback, options,
+                                  cost_function))
+      break;
+    segment_starts[k] = segment_start;
+  }
+
+  // the kinematics solver of the group is not thread-safe, so the segments take turns in calling it
+  std::mutex ik_mutex;
+  std::vector<std::vector<RobotStatePtr>> segments(segment_count);
+  std::vector<double> fractions(segment_count, 0.0);
+  const auto compute_segment = [&](std::size_t k, const RobotState& segment_start) {
+    RobotState state(segment_start);
+    segments[k].clear();
+    fractions[k] = computeSegment(&state, group, segments[k], link, targets[k], true, max_step,
+                                  NO_JOINT_SPACE_JUMP_TEST, validCallback, options, cost_function, link_offset,
+                                  jacobian_stepping, &ik_mutex);
+  };
+
+  std::atomic<std::size_t> next_segment{ 0 };
+  const auto compute_segments = [&]() {
+    for (std::size_t k = next_segment++; k < segment_count; k = next_segment++)
+    {
+      if (segment_starts[k])
+        compute_segment(k, *segment_starts[k]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (std::size_t t = 1; t < std::min(thread_count, segment_count); ++t)
+    threads.emplace_back(compute_segments);
+  compute_segments();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  // join the segments in order
+  std::vector<RobotStatePtr> path;
+  double percentage_solved = 0.0;
+  for (std::size_t k = 0; k < segment_count; ++k)
+  {
+    if (k > 0)
+    {
+      // The end of the previous segment and the start of this one solve the same waypoint. If they are further apart
+      // than the steps of the two segments, IK picked another branch, so the segment is computed again locally.
+      const RobotState& previous_end = *path.back();
+      const double step_distance =
+          std::max(maxStepDistance(group, segments[k - 1]), maxStepDistance(group, segments[k]));
+      if (!segment_starts[k] || segment_starts[k]->distance(previous_end, group) > step_distance)
+        compute_segment(k, previous_end);
+    }
+
+    std::vector<RobotStatePtr>::iterator start = segments[k].begin();
+    if (k > 0 && !segments[k].empty())
+      std::advance(start, 1);
+    path.insert(path.end(), start, segments[k].end());
+
+    if (fabs(fractions[k] - 1.0) < std::numeric_limits<double>::epsilon())
+    {
+      percentage_solved = static_cast<double>((k + 1)) / static_cast<double>(segment_count);
+    }
+    else
+    {
+      percentage_solved += fractions[k] / static_cast<double>(segment_count);
+      break;
+    }
+  }
+
+  *start_state = *path.back();
+  traj.insert(traj.end(), path.begin(), path.end());
+  return percentage_solved;
+}
+
 CartesianInterpolator::Percentage CartesianInterpolator::checkJointSpaceJump(const JointModelGroup* group,
                                                                              std::vector<RobotStatePtr>& traj,
                                                                              const JumpThreshold& jump_threshold)
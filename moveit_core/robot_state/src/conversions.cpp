@@ -40,6 +40,8 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <tf2_eigen/tf2_eigen.hpp>
+#include <algorithm>
+#include <set>
 #include <string>
 
 namespace moveit
@@ -195,7 +197,10 @@ private:
   const geometry_msgs::msg::Pose* pose_;
 };
 
-static void _attachedBodyToMsg(const AttachedBody& attached_body, moveit_msgs::msg::AttachedCollisionObject& aco)
+// cached_shape_msgs are reused instead of converting the shapes again, used_shape_msgs collects the messages used
+static void _attachedBodyToMsg(const AttachedBody& attached_body, moveit_msgs::msg::AttachedCollisionObject& aco,
+                               const std::map<shapes::ShapeConstPtr, shapes::ShapeMsg>* cached_shape_msgs = nullptr,
+                               std::map<shapes::ShapeConstPtr, shapes::ShapeMsg>* used_shape_msgs = nullptr)
 {
   aco.link_name = attached_body.getAttachedLinkName();
   aco.detach_posture = attached_body.getDetachPosture();
@@ -219,12 +224,23 @@ static void _attachedBodyToMsg(const AttachedBody& attached_body, moveit_msgs::m
   aco.object.plane_poses.clear();
   for (std::size_t j = 0; j < ab_shapes.size(); ++j)
   {
-    shapes::ShapeMsg sm;
-    if (shapes::constructMsgFromShape(ab_shapes[j].get(), sm))
+    shapes::ShapeMsg constructed_sm;
+    const shapes::ShapeMsg* sm = nullptr;
+    if (cached_shape_msgs)
     {
+      const auto cached = cached_shape_msgs->find(ab_shapes[j]);
+      if (cached != cached_shape_msgs->end())
+        sm = &cached->second;
+    }
+    if (!sm && shapes::constructMsgFromShape(ab_shapes[j].get(), constructed_sm))
+      sm = &constructed_sm;
+    if (sm)
+    {
+      if (used_shape_msgs)
+        used_shape_msgs->emplace(ab_shapes[j], *sm);
       geometry_msgs::msg::Pose p;
       p = tf2::toMsg(shape_poses[j]);
-      sv.addToObject(sm, p);
+      sv.addToObject(*sm, p);
     }
   }
   aco.object.subframe_names.clear();
@@ -570,5 +586,254 @@ void streamToRobotState(RobotState& state, const std::string& line, const std::s
   }
 }
 
+// ********************************************
+// * RobotStateConversionContext
+// ********************************************
+
+bool RobotStateConversionContext::robotStateMsgToRobotState(const moveit_msgs::msg::RobotState& robot_state,
+                                                            RobotState& state, bool copy_attached_bodies)
+{
+  bool result = msgToRobotState(nullptr, robot_state, state, copy_attached_bodies);
+  state.update();
+  return result;
+}
+
+bool RobotStateConversionContext::robotStateMsgToRobotState(const Transforms& tf,
+                                                            const moveit_msgs::msg::RobotState& robot_state,
+                                                            RobotState& state, bool copy_attached_bodies)
+{
+  bool result = msgToRobotState(&tf, robot_state, state, copy_attached_bodies);
+  state.update();
+  return result;
+}
+
+void RobotStateConversionContext::robotStateToRobotStateMsg(const RobotState& state,
+                                                            moveit_msgs::msg::RobotState& robot_state,
+                                                            bool copy_attached_bodies)
+{
+  setRobotModel(state.getRobotModel());
+  robot_state.is_diff = false;
+
+  // same content as robotStateToJointStateMsg(), but without looking up the joints and reusing the message buffers
+  sensor_msgs::msg::JointState& joint_state = robot_state.joint_state;
+  joint_state.header = std_msgs::msg::Header();
+  joint_state.header.frame_id = robot_model_->getModelFrame();
+  joint_state.name = single_dof_joint_names_;
+  const std::size_t count = single_dof_variable_indices_.size();
+  joint_state.position.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+    joint_state.position[i] = state.getVariablePosition(single_dof_variable_indices_[i]);
+  if (state.hasVelocities())
+  {
+    joint_state.velocity.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+      joint_state.velocity[i] = state.getVariableVelocity(single_dof_variable_indices_[i]);
+  }
+  else
+    joint_state.velocity.clear();
+  joint_state.effort.clear();
+
+  _robotStateToMultiDOFJointState(state, robot_state.multi_dof_joint_state);
+
+  if (copy_attached_bodies)
+  {
+    std::vector<const AttachedBody*> attached_bodies;
+    state.getAttachedBodies(attached_bodies);
+    robot_state.attached_collision_objects.resize(attached_bodies.size());
+    std::map<shapes::ShapeConstPtr, shapes::ShapeMsg> used_shape_msgs;
+    for (std::size_t i = 0; i < attached_bodies.size(); ++i)
+      _attachedBodyToMsg(*attached_bodies[i], robot_state.attached_collision_objects[i], &shape_msgs_,
+                         &used_shape_msgs);
+    // only keep the messages of shapes that are still attached
+    shape_msgs_.swap(used_shape_msgs);
+  }
+}
+
+void RobotStateConversionContext::clear()
+{
+  robot_model_.reset();
+  joint_names_.clear();
+  variable_indices_.clear();
+  identity_layout_ = false;
+  single_dof_joint_names_.clear();
+  single_dof_variable_indices_.clear();
+  attached_bodies_.clear();
+  shape_msgs_.clear();
+}
+
+void RobotStateConversionContext::setRobotModel(const RobotModelConstPtr& robot_model)
+{
+  if (robot_model == robot_model_)
+    return;
+
+  clear();
+  robot_model_ = robot_model;
+  for (const JointModel* joint_model : robot_model_->getSingleDOFJointModels())
+  {
+    single_dof_joint_names_.push_back(joint_model->getName());
+    single_dof_variable_indices_.push_back(joint_model->getFirstVariableIndex());
+  }
+}
+
+bool RobotStateConversionContext::msgToRobotState(const Transforms* tf, const moveit_msgs::msg::RobotState& robot_state,
+                                                  RobotState& state, bool copy_attached_bodies)
+{
+  if (!robot_state.is_diff && robot_state.joint_state.name.empty() &&
+      robot_state.multi_dof_joint_state.joint_names.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "Found empty JointState message");
+    return false;
+  }
+
+  bool result1 = jointStateToRobotState(robot_state.joint_state, state);
+  bool result2 = _multiDOFJointsToRobotState(robot_state.multi_dof_joint_state, state, tf);
+  bool valid = result1 || result2;
+
+  if (valid && copy_attached_bodies)
+    attachedCollisionObjectsToRobotState(tf, robot_state, state);
+
+  return valid;
+}
+
+bool RobotStateConversionContext::jointStateToRobotState(const sensor_msgs::msg::JointState& joint_state,
+                                                         RobotState& state)
+{
+  if (joint_state.name.size() != joint_state.position.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Different number of names and positions in JointState message: %zu, %zu",
+                 joint_state.name.size(), joint_state.position.size());
+    return false;
+  }
+
+  setRobotModel(state.getRobotModel());
+  if (joint_state.name != joint_names_)
+  {
+    // a new layout, unknown names throw as in RobotState::setVariablePositions()
+    std::vector<int> variable_indices;
+    variable_indices.reserve(joint_state.name.size());
+    for (const std::string& name : joint_state.name)
+      variable_indices.push_back(robot_model_->getVariableIndex(name));
+    variable_indices_.swap(variable_indices);
+    joint_names_ = joint_state.name;
+
+    // without mimic joints, a message with all variables in order is copied as a whole
+    identity_layout_ = robot_model_->getMimicJointModels().empty() &&
+                       variable_indices_.size() == robot_model_->getVariableCount() && !variable_indices_.empty();
+    for (std::size_t i = 0; identity_layout_ && i < variable_indices_.size(); ++i)
+      identity_layout_ = variable_indices_[i] == static_cast<int>(i);
+  }
+
+  const std::size_t count = variable_indices_.size();
+  if (identity_layout_)
+    state.setVariablePositions(joint_state.position.data());
+  else
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      state.setVariablePosition(variable_indices_[i], joint_state.position[i]);
+  }
+
+  if (!joint_state.velocity.empty())
+  {
+    if (identity_layout_ && joint_state.velocity.size() == count)
+      state.setVariableVelocities(joint_state.velocity.data());
+    else
+    {
+      for (std::size_t i = 0; i < count && i < joint_state.velocity.size(); ++i)
+        state.setVariableVelocity(variable_indices_[i], joint_state.velocity[i]);
+    }
+  }
+  return true;
+}
+
+bool RobotStateConversionContext::isAttachedBodyUnchanged(const moveit_msgs::msg::AttachedCollisionObject& aco,
+                                                          const RobotState& state) const
+{
+  // the pose of an object given relative to another frame depends on the joint values
+  if (aco.object.operation != moveit_msgs::msg::CollisionObject::ADD ||
+      !Transforms::sameFrame(aco.object.header.frame_id, aco.link_name))
+    return false;
+
+  const auto entry = attached_bodies_.find(aco.object.id);
+  if (entry == attached_bodies_.end() || !state.hasAttachedBody(aco.object.id))
+    return false;
+
+  // the entry keeps the shapes alive, so a body with the same shapes was created by this context or copied from it
+  const AttachedBody* body = state.getAttachedBody(aco.object.id);
+  if (body->getShapes() != entry->second.shapes || body->getAttachedLinkName() != aco.link_name)
+    return false;
+
+  // subframes are the only part of an attached body that can be changed afterwards
+  const FixedTransformsMap& subframes = body->getSubframes();
+  if (subframes.size() != entry->second.subframes.size() ||
+      !std::equal(subframes.begin(), subframes.end(), entry->second.subframes.begin(),
+                  [](const auto& subframe, const auto& entry_subframe) {
+                    return subframe.first == entry_subframe.first &&
+                           subframe.second.matrix() == entry_subframe.second.matrix();
+                  }))
+    return false;
+
+  return entry->second.msg == aco;
+}
+
+void RobotStateConversionContext::attachedCollisionObjectsToRobotState(const Transforms* tf,
+                                                                       const moveit_msgs::msg::RobotState& robot_state,
+                                                                       RobotState& state)
+{
+  const std::vector<moveit_msgs::msg::AttachedCollisionObject>& acos = robot_state.attached_collision_objects;
+
+  // objects that are attached exactly as the message describes them are kept
+  std::map<std::string, std::size_t> occurrences;
+  for (const moveit_msgs::msg::AttachedCollisionObject& aco : acos)
+    ++occurrences[aco.object.id];
+  std::set<std::string> unchanged;
+  for (const moveit_msgs::msg::AttachedCollisionObject& aco : acos)
+  {
+    if (occurrences[aco.object.id] == 1 && isAttachedBodyUnchanged(aco, state))
+      unchanged.insert(aco.object.id);
+  }
+
+  if (!robot_state.is_diff)
+  {
+    // as clearAttachedBodies(), except for the unchanged bodies
+    std::vector<const AttachedBody*> attached_bodies;
+    state.getAttachedBodies(attached_bodies);
+    for (const AttachedBody* attached_body : attached_bodies)
+    {
+      const std::string id = attached_body->getName();
+      if (unchanged.find(id) == unchanged.end())
+        state.clearAttachedBody(id);
+    }
+    for (auto entry = attached_bodies_.begin(); entry != attached_bodies_.end();)
+    {
+      if (occurrences.find(entry->first) == occurrences.end())
+        entry = attached_bodies_.erase(entry);
+      else
+        ++entry;
+    }
+  }
+
+  for (const moveit_msgs::msg::AttachedCollisionObject& aco : acos)
+  {
+    if (unchanged.find(aco.object.id) != unchanged.end())
+      continue;
+
+    const AttachedBody* previous_body =
+        state.hasAttachedBody(aco.object.id) ? state.getAttachedBody(aco.object.id) : nullptr;
+    _msgToAttachedBody(tf, aco, state);
+    const AttachedBody* body = state.hasAttachedBody(aco.object.id) ? state.getAttachedBody(aco.object.id) : nullptr;
+
+    // remember newly attached bodies whose pose does not depend on the joint values
+    if (body && body != previous_body && Transforms::sameFrame(aco.object.header.frame_id, aco.link_name))
+    {
+      AttachedBodyEntry& entry = attached_bodies_[aco.object.id];
+      entry.msg = aco;
+      entry.shapes = body->getShapes();
+      entry.subframes = body->getSubframes();
+    }
+    else
+      attached_bodies_.erase(aco.object.id);
+  }
+}
+
 }  // end of namespace core
 }  // end of namespace moveit
@@ -45,8 +45,11 @@
 #include <rclcpp/logging.hpp>
 #include <rclcpp/time.hpp>
 #include <tf2_eigen/tf2_eigen.hpp>
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <optional>
+#include <thread>
 #include <moveit/macros/console_colors.h>
 #include <moveit/robot_model/aabb.h>
 
@@ -57,6 +60,24 @@ namespace core
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_robot_state.robot_state");
 
+namespace
+{
+std::size_t getTransformCount(const RobotModel& robot_model)
+{
+  return robot_model.getJointModelCount() + robot_model.getLinkModelCount() + robot_model.getLinkGeometryCount();
+}
+
+int getDoublesForDirtyJointTransforms(const RobotModel& robot_model)
+{
+  return 1 + robot_model.getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+}
+
+std::size_t getMemoryBytes(const RobotModel& robot_model)
+{
+  return sizeof(double) * (robot_model.getVariableCount() * 3 + getDoublesForDirtyJointTransforms(robot_model));
+}
+}  // namespace
+
 RobotState::RobotState(const RobotModelConstPtr& robot_model)
   : robot_model_(robot_model)
   , has_velocity_(false)
@@ -64,6 +85,8 @@ RobotState::RobotState(const RobotModelConstPtr& robot_model)
   , has_effort_(false)
   , dirty_link_transforms_(nullptr)
   , dirty_collision_body_transforms_(nullptr)
+  , dirty_link_roots_count_(0)
+  , arena_(RobotStateArena::getCurrent())
   , rng_(nullptr)
 {
   if (robot_model == nullptr)
@@ -73,66 +96,98 @@ RobotState::RobotState(const RobotModelConstPtr& robot_model)
 
   dirty_link_transforms_ = robot_model_->getRootJoint();
   allocMemory();
+  allocTransforms();
   initTransforms();
 }
 
-RobotState::RobotState(const RobotState& other) : rng_(nullptr)
+RobotState::RobotState(const RobotState& other) : arena_(RobotStateArena::getCurrent()), rng_(nullptr)
 {
   robot_model_ = other.robot_model_;
   allocMemory();
   copyFrom(other);
 }
 
+RobotState::RobotState(const RobotState& other, bool share_transforms)
+  : arena_(RobotStateArena::getCurrent()), rng_(nullptr)
+{
+  robot_model_ = other.robot_model_;
+  allocMemory();
+  copyFrom(other, share_transforms);
+}
+
 RobotState::~RobotState()
 {
   clearAttachedBodies();
-  free(memory_);
+  if (arena_)
+    arena_->deallocate(memory_, getMemoryBytes(*robot_model_));
+  else
+    free(memory_);
   if (rng_)
     delete rng_;
 }
 
 void RobotState::allocMemory()
+{
+  // memory for the dirty joint transforms, followed by positions, velocities and accelerations
+  const int nr_doubles_for_dirty_joint_transforms = getDoublesForDirtyJointTransforms(*robot_model_);
+  const size_t bytes = getMemoryBytes(*robot_model_);
+  memory_ = arena_ ? arena_->allocate(bytes) : malloc(bytes);
+
+  dirty_joint_transforms_ = reinterpret_cast<unsigned char*>(memory_);
+  position_ = reinterpret_cast<double*>(memory_) + nr_doubles_for_dirty_joint_transforms;
+  velocity_ = position_ + robot_model_->getVariableCount();
+  // acceleration and effort share the memory (not both can be specified)
+  effort_ = acceleration_ = velocity_ + robot_model_->getVariableCount();
+}
+
+void RobotState::allocTransforms()
 {
   static_assert((sizeof(Eigen::Isometry3d) / EIGEN_MAX_ALIGN_BYTES) * EIGEN_MAX_ALIGN_BYTES == sizeof(Eigen::Isometry3d),
                 "sizeof(Eigen::Isometry3d) should be a multiple of EIGEN_MAX_ALIGN_BYTES");
 
   constexpr unsigned int extra_alignment_bytes = EIGEN_MAX_ALIGN_BYTES - 1;
-  // memory for the dirty joint transforms
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  const size_t bytes =
-      sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                   robot_model_->getLinkGeometryCount()) +
-      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
-      extra_alignment_bytes;
-  memory_ = malloc(bytes);
+  const size_t bytes = sizeof(Eigen::Isometry3d) * getTransformCount(*robot_model_) + extra_alignment_bytes;
+  if (arena_)
+  {
+    // the arena outlives the transforms, which may be shared with states outside of it
+    transforms_memory_ = std::shared_ptr<void>(
+        arena_->allocate(bytes), [arena = arena_, bytes](void* memory) { arena->deallocate(memory, bytes); });
+  }
+  else
+    transforms_memory_ = std::shared_ptr<void>(malloc(bytes), free);
 
   // make the memory for transforms align at EIGEN_MAX_ALIGN_BYTES
   // https://eigen.tuxfamily.org/dox/classEigen_1_1aligned__allocator.html
   // NOLINTNEXTLINE(performance-no-int-to-ptr)
   variable_joint_transforms_ = reinterpret_cast<Eigen::Isometry3d*>(
-      (reinterpret_cast<uintptr_t>(memory_) + extra_alignment_bytes) & ~static_cast<uintptr_t>(extra_alignment_bytes));
+      (reinterpret_cast<uintptr_t>(transforms_memory_.get()) + extra_alignment_bytes) &
+      ~static_cast<uintptr_t>(extra_alignment_bytes));
   global_link_transforms_ = variable_joint_transforms_ + robot_model_->getJointModelCount();
   global_collision_body_transforms_ = global_link_transforms_ + robot_model_->getLinkModelCount();
-  dirty_joint_transforms_ =
-      reinterpret_cast<unsigned char*>(global_collision_body_transforms_ + robot_model_->getLinkGeometryCount());
-  position_ = reinterpret_cast<double*>(dirty_joint_transforms_) + nr_doubles_for_dirty_joint_transforms;
-  velocity_ = position_ + robot_model_->getVariableCount();
-  // acceleration and effort share the memory (not both can be specified)
-  effort_ = acceleration_ = velocity_ + robot_model_->getVariableCount();
 }
 
 void RobotState::initTransforms()
 {
   // mark all transforms as dirty
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_joint_transforms);
+  memset(dirty_joint_transforms_, 1, sizeof(double) * getDoublesForDirtyJointTransforms(*robot_model_));
 
   // initialize last row of transformation matrices, which will not be modified by transform updates anymore
-  for (size_t i = 0, end = robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                           robot_model_->getLinkGeometryCount();
-       i != end; ++i)
+  for (size_t i = 0, end = getTransformCount(*robot_model_); i != end; ++i)
+    variable_joint_transforms_[i].makeAffine();
+}
+
+void RobotState::unshareTransforms()
+{
+  const Eigen::Isometry3d* shared = variable_joint_transforms_;
+  // keep the shared memory alive until it is copied
+  const std::shared_ptr<void> shared_memory = transforms_memory_;
+  allocTransforms();
+
+  // if all link transforms are dirty anyway, only the joint transforms need to be preserved
+  const size_t total = getTransformCount(*robot_model_);
+  const size_t count = allLinkTransformsDirty() ? robot_model_->getJointModelCount() : total;
+  memcpy(static_cast<void*>(variable_joint_transforms_), shared, sizeof(Eigen::Isometry3d) * count);
+  for (size_t i = count; i != total; ++i)
     variable_joint_transforms_[i].makeAffine();
 }
 
@@ -143,7 +198,7 @@ RobotState& RobotState::operator=(const RobotState& other)
   return *this;
 }
 
-void RobotState::copyFrom(const RobotState& other)
+void RobotState::copyFrom(const RobotState& other, bool share_transforms)
 {
   has_velocity_ = other.has_velocity_;
   has_acceleration_ = other.has_acceleration_;
@@ -151,29 +206,45 @@ void RobotState::copyFrom(const RobotState& other)
 
   dirty_collision_body_transforms_ = other.dirty_collision_body_transforms_;
   dirty_link_transforms_ = other.dirty_link_transforms_;
+  dirty_link_roots_ = other.dirty_link_roots_;
+  dirty_link_roots_count_ = other.dirty_link_roots_count_;
+  invalidateJacobianCache();
 
-  if (dirty_link_transforms_ == robot_model_->getRootJoint())
+  if (allLinkTransformsDirty())
   {
     // everything is dirty; no point in copying transforms; copy positions, potentially velocity & acceleration
     memcpy(position_, other.position_,
            robot_model_->getVariableCount() * sizeof(double) *
                (1 + (has_velocity_ ? 1 : 0) + ((has_acceleration_ || has_effort_) ? 1 : 0)));
     // and just initialize transforms
+    if (!transforms_memory_ || transforms_memory_.use_count() > 1)
+      allocTransforms();
     initTransforms();
   }
   else
   {
-    // copy all the memory; maybe avoid copying velocity and acceleration if possible
-    const int nr_doubles_for_dirty_joint_transforms =
-        1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+    // copy dirty flags and positions; maybe avoid copying velocity and acceleration if possible
     const size_t bytes =
-        sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                     robot_model_->getLinkGeometryCount()) +
         sizeof(double) *
-            (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
-                                                 ((has_acceleration_ || has_effort_) ? 1 : 0)) +
-             nr_doubles_for_dirty_joint_transforms);
-    memcpy(static_cast<void*>(variable_joint_transforms_), other.variable_joint_transforms_, bytes);
+        (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
+                                             ((has_acceleration_ || has_effort_) ? 1 : 0)) +
+         getDoublesForDirtyJointTransforms(*robot_model_));
+    memcpy(memory_, other.memory_, bytes);
+
+    if (share_transforms)
+    {
+      transforms_memory_ = other.transforms_memory_;
+      variable_joint_transforms_ = other.variable_joint_transforms_;
+      global_link_transforms_ = other.global_link_transforms_;
+      global_collision_body_transforms_ = other.global_collision_body_transforms_;
+    }
+    else
+    {
+      if (!transforms_memory_ || transforms_memory_.use_count() > 1)
+        allocTransforms();
+      memcpy(static_cast<void*>(variable_joint_transforms_), other.variable_joint_transforms_,
+             sizeof(Eigen::Isometry3d) * getTransformCount(*robot_model_));
+    }
   }
 
   // copy attached bodies
@@ -202,6 +273,16 @@ bool RobotState::checkLinkTransforms() const
   return true;
 }
 
+bool RobotState::checkLinkTransform(const LinkModel* link) const
+{
+  if (dirtyLinkTransform(link))
+  {
+    RCLCPP_WARN(LOGGER, "Returning dirty link transform for link '%s'", link->getName().c_str());
+    return false;
+  }
+  return true;
+}
+
 bool RobotState::checkCollisionTransforms() const
 {
   if (dirtyCollisionBodyTransforms())
@@ -286,7 +367,7 @@ void RobotState::setToRandomPositions()
   random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
   robot_model_->getVariableRandomPositions(rng, position_);
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markAllLinkTransformsDirty();
   // mimic values are correctly set in RobotModel
 }
 
@@ -364,7 +445,7 @@ void RobotState::setToDefaultValues()
   // set velocity & acceleration to 0
   memset(velocity_, 0, sizeof(double) * 2 * robot_model_->getVariableCount());
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markAllLinkTransformsDirty();
 }
 
 void RobotState::setVariablePositions(const double* position)
@@ -376,7 +457,7 @@ void RobotState::setVariablePositions(const double* position)
 
   // Since all joint values have potentially changed, we will need to recompute all transforms
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markAllLinkTransformsDirty();
 }
 
 void RobotState::setVariablePositions(const std::map<std::string, double>& variable_map)
@@ -681,7 +762,7 @@ void RobotState::update(bool force)
   if (force)
   {
     memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-    dirty_link_transforms_ = robot_model_->getRootJoint();
+    markAllLinkTransformsDirty();
   }
 
   // this actually triggers all needed updates
@@ -695,6 +776,7 @@ void RobotState::updateCollisionBodyTransforms()
 
   if (dirty_collision_body_transforms_ != nullptr)
   {
+    ensureUniqueTransforms();
     const std::vector<const LinkModel*>& links = dirty_collision_body_transforms_->getDescendantLinkModels();
     dirty_collision_body_transforms_ = nullptr;
 
@@ -720,11 +802,67 @@ void RobotState::updateCollisionBodyTransforms()
   }
 }
 
+void RobotState::addDirtyLinkRoot(const JointModel* joint)
+{
+  if (dirty_link_roots_count_ == 0)
+  {
+    dirty_link_roots_[0] = dirty_link_transforms_;
+    dirty_link_roots_count_ = 1;
+  }
+  dirty_link_transforms_ = robot_model_->getCommonRoot(dirty_link_transforms_, joint);
+
+  // the dirty subtrees are disjoint: if joint is not covered by one of them, drop those covered by joint
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < dirty_link_roots_count_; ++i)
+  {
+    const JointModel* root = dirty_link_roots_[i];
+    const JointModel* common = robot_model_->getCommonRoot(root, joint);
+    if (common == root)
+      return;  // joint is already dirty
+    if (common != joint)
+      dirty_link_roots_[kept++] = root;
+  }
+
+  if (kept == MAX_DIRTY_LINK_ROOTS)
+  {
+    // too many subtrees to track, fall back to their common root
+    dirty_link_roots_count_ = 0;
+    return;
+  }
+  dirty_link_roots_[kept++] = joint;
+  dirty_link_roots_count_ = kept;
+}
+
+bool RobotState::dirtyLinkTransform(const LinkModel* link) const
+{
+  if (dirty_link_transforms_ == nullptr)
+    return false;
+  const JointModel* joint = link->getParentJointModel();
+  if (dirty_link_roots_count_ == 0)
+    return robot_model_->getCommonRoot(dirty_link_transforms_, joint) == dirty_link_transforms_;
+  for (std::size_t i = 0; i < dirty_link_roots_count_; ++i)
+  {
+    if (robot_model_->getCommonRoot(dirty_link_roots_[i], joint) == dirty_link_roots_[i])
+      return true;
+  }
+  return false;
+}
+
 void RobotState::updateLinkTransforms()
 {
   if (dirty_link_transforms_ != nullptr)
   {
-    updateLinkTransformsInternal(dirty_link_transforms_);
+    ensureUniqueTransforms();
+    if (dirty_link_roots_count_ > 1)
+    {
+      // only update the disjoint dirty subtrees, not everything below their common root
+      for (std::size_t i = 0; i < dirty_link_roots_count_; ++i)
+        updateLinkTransformsInternal(dirty_link_roots_[i]);
+    }
+    else
+      updateLinkTransformsInternal(dirty_link_transforms_);
+    updateAttachedBodyTransforms();
+
     if (dirty_collision_body_transforms_)
     {
       dirty_collision_body_transforms_ =
@@ -735,13 +873,85 @@ void RobotState::updateLinkTransforms()
       dirty_collision_body_transforms_ = dirty_link_transforms_;
     }
     dirty_link_transforms_ = nullptr;
+    dirty_link_roots_count_ = 0;
+  }
+}
+
+void RobotState::updateLinkTransforms(const JointModelGroup* group)
+{
+  if (dirty_link_transforms_ == nullptr)
+    return;
+  if (dirty_link_roots_count_ == 0)
+  {
+    dirty_link_roots_[0] = dirty_link_transforms_;
+    dirty_link_roots_count_ = 1;
+  }
+  ensureUniqueTransforms();
+
+  const JointModel* updated = nullptr;
+  const JointModel* remaining = nullptr;
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < dirty_link_roots_count_; ++i)
+  {
+    const JointModel* root = dirty_link_roots_[i];
+    // the subtree is relevant if it is either above or below one of the group's roots
+    bool relevant = false;
+    for (const JointModel* group_root : group->getJointRoots())
+    {
+      const JointModel* common = robot_model_->getCommonRoot(root, group_root);
+      if (common == root || common == group_root)
+      {
+        relevant = true;
+        break;
+      }
+    }
+    if (relevant)
+    {
+      updateLinkTransformsInternal(root);
+      updated = robot_model_->getCommonRoot(updated, root);
+    }
+    else
+    {
+      dirty_link_roots_[kept++] = root;
+      remaining = robot_model_->getCommonRoot(remaining, root);
+    }
+  }
+  dirty_link_transforms_ = remaining;
+  dirty_link_roots_count_ = kept > 1 ? kept : 0;
+
+  if (updated)
+  {
+    updateAttachedBodyTransforms();
+    dirty_collision_body_transforms_ = robot_model_->getCommonRoot(dirty_collision_body_transforms_, updated);
   }
 }
 
 void RobotState::updateLinkTransformsInternal(const JointModel* start)
 {
+  invalidateJacobianCache();
+  const CompiledForwardKinematicsBinding* compiled = nullptr;  // the compiled kinematics of the last subtree
   for (const LinkModel* link : start->getDescendantLinkModels())
   {
+    if (const CompiledForwardKinematicsBinding* binding = robot_model_->getCompiledForwardKinematics(link))
+    {
+      // the links of a subtree are computed together, when its first link comes up
+      if (binding == compiled)
+        continue;
+      if (binding->root_joint == link->getParentJointModel())
+      {
+        const LinkModel* parent = link->getParentLinkModel();
+        binding->kinematics->computeLinkTransforms(
+            parent ? global_link_transforms_[parent->getLinkIndex()] : Eigen::Isometry3d::Identity(), position_,
+            binding->variable_indices.data(), global_link_transforms_, binding->link_indices.data());
+        // the joint transforms are not needed by the compiled kinematics, but the const accessors expect them updated
+        getJointTransform(binding->root_joint);
+        for (const JointModel* joint : binding->root_joint->getDescendantJointModels())
+          getJointTransform(joint);
+        compiled = binding;
+        continue;
+      }
+    }
+
     int idx_link = link->getLinkIndex();
     const LinkModel* parent = link->getParentLinkModel();
     if (parent)  // root JointModel will not have a parent
@@ -780,7 +990,10 @@ void RobotState::updateLinkTransformsInternal(const JointModel* start)
       }
     }
   }
+}
 
+void RobotState::updateAttachedBodyTransforms()
+{
   // update attached bodies tf; these are usually very few, so we update them all
   for (const auto& attached_body : attached_body_map_)
   {
@@ -792,6 +1005,8 @@ void RobotState::updateLinkTransformsInternal(const JointModel* start)
 void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isometry3d& transform, bool backward)
 {
   updateLinkTransforms();  // no link transforms must be dirty, otherwise the transform we set will be overwritten
+  ensureUniqueTransforms();
+  invalidateJacobianCache();
 
   // update the fact that collision body transforms are out of date
   if (dirty_collision_body_transforms_)
@@ -841,12 +1056,7 @@ void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isome
     dirty_collision_body_transforms_ = parent_link->getParentJointModel();
   }
 
-  // update attached bodies tf; these are usually very few, so we update them all
-  for (const auto& attached_body : attached_body_map_)
-  {
-    attached_body.second->computeTransform(
-        global_link_transforms_[attached_body.second->getAttachedLink()->getLinkIndex()]);
-  }
+  updateAttachedBodyTransforms();
 }
 
 const LinkModel* RobotState::getRigidlyConnectedParentLinkModel(const std::string& frame) const
@@ -1009,7 +1219,7 @@ void RobotState::interpolate(const RobotState& to, double t, RobotState& state)
   robot_model_->interpolate(getVariablePositions(), to.getVariablePositions(), t, state.getVariablePositions());
 
   memset(state.dirty_joint_transforms_, 1, state.robot_model_->getJointModelCount() * sizeof(unsigned char));
-  state.dirty_link_transforms_ = state.robot_model_->getRootJoint();
+  state.markAllLinkTransformsDirty();
 }
 
 void RobotState::interpolate(const RobotState& to, double t, RobotState& state, const JointModelGroup* joint_group) const
@@ -1345,6 +1555,118 @@ Eigen::MatrixXd RobotState::getJacobian(const JointModelGroup* group,
   return result;
 }
 
+Eigen::MatrixXd RobotState::getJacobian(const JointModelGroup* group, const Eigen::Vector3d& reference_point_position)
+{
+  Eigen::MatrixXd result;
+  if (!getJacobian(group, group->getLinkModels().back(), reference_point_position, result, false))
+    throw Exception("Unable to compute Jacobian");
+  return result;
+}
+
+bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
+                             bool use_quaternion_representation)
+{
+  updateLinkTransforms();
+  if (!jacobian_cache_)
+    jacobian_cache_ = std::make_unique<JacobianCache>();
+
+  JacobianCache& cache = *jacobian_cache_;
+  if (!cache.valid || cache.group != group || cache.link != link ||
+      cache.use_quaternion_representation != use_quaternion_representation ||
+      cache.reference_point_position != reference_point_position)
+  {
+    cache.valid = static_cast<const RobotState*>(this)->getJacobian(group, link, reference_point_position,
+                                                                    cache.jacobian, use_quaternion_representation);
+    if (!cache.valid)
+      return false;
+    cache.group = group;
+    cache.link = link;
+    cache.reference_point_position = reference_point_position;
+    cache.use_quaternion_representation = use_quaternion_representation;
+  }
+  jacobian = cache.jacobian;
+  return true;
+}
+
+bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
+                             Eigen::MatrixXd& jacobian_derivative) const
+{
+  if (!getJacobian(group, link, reference_point_position, jacobian, false))
+    return false;
+
+  const int columns = group->getVariableCount();
+  jacobian_derivative.setZero(6, columns);
+  if (!has_velocity_)
+    return true;
+
+  // angular velocity of the link due to all joints of the group
+  const std::vector<int>& variable_index_list = group->getVariableIndexList();
+  Eigen::Vector3d angular_velocity = Eigen::Vector3d::Zero();
+  for (int i = 0; i < columns; ++i)
+    angular_velocity += jacobian.block<3, 1>(3, i) * velocity_[variable_index_list[i]];
+
+  const moveit::core::JointModel* root_joint_model = group->getJointModels()[0];
+  const moveit::core::LinkModel* root_link_model = root_joint_model->getParentLinkModel();
+  const Eigen::Isometry3d reference_transform =
+      root_link_model ? getGlobalLinkTransform(root_link_model).inverse() : Eigen::Isometry3d::Identity();
+  const Eigen::Vector3d point_transform = reference_transform * getGlobalLinkTransform(link) * reference_point_position;
+
+  // Walking from the tip towards the root, accumulate the angular velocity and the linear velocity of the point
+  // caused by the joints passed so far. Together with the total angular velocity, this yields the velocity of
+  // each joint axis (due to the joints above it) and of the point relative to the joint, whose products with the
+  // axis give the derivative of each column.
+  Eigen::Vector3d angular_velocity_below = Eigen::Vector3d::Zero();
+  Eigen::Vector3d linear_velocity_below = Eigen::Vector3d::Zero();
+  while (link)
+  {
+    const JointModel* pjm = link->getParentJointModel();
+    if (pjm->getVariableCount() > 0)
+    {
+      if (!group->hasJointModel(pjm->getName()))
+      {
+        link = pjm->getParentLinkModel();
+        continue;
+      }
+      const unsigned int joint_index = group->getVariableGroupIndex(pjm->getName());
+      const double joint_velocity = velocity_[pjm->getFirstVariableIndex()];
+      const Eigen::Isometry3d joint_transform = reference_transform * getGlobalLinkTransform(link);
+      if (pjm->getType() == moveit::core::JointModel::REVOLUTE)
+      {
+        const Eigen::Vector3d joint_axis =
+            joint_transform.linear() * static_cast<const moveit::core::RevoluteJointModel*>(pjm)->getAxis();
+        const Eigen::Vector3d lever = point_transform - joint_transform.translation();
+        angular_velocity_below += joint_axis * joint_velocity;
+        linear_velocity_below += joint_axis.cross(lever) * joint_velocity;
+        const Eigen::Vector3d angular_velocity_above = angular_velocity - angular_velocity_below;
+        const Eigen::Vector3d joint_axis_derivative = angular_velocity_above.cross(joint_axis);
+        jacobian_derivative.block<3, 1>(0, joint_index) +=
+            joint_axis_derivative.cross(lever) +
+            joint_axis.cross(angular_velocity_above.cross(lever) + linear_velocity_below);
+        jacobian_derivative.block<3, 1>(3, joint_index) += joint_axis_derivative;
+      }
+      else if (pjm->getType() == moveit::core::JointModel::PRISMATIC)
+      {
+        const Eigen::Vector3d joint_axis =
+            joint_transform.linear() * static_cast<const moveit::core::PrismaticJointModel*>(pjm)->getAxis();
+        linear_velocity_below += joint_axis * joint_velocity;
+        const Eigen::Vector3d angular_velocity_above = angular_velocity - angular_velocity_below;
+        jacobian_derivative.block<3, 1>(0, joint_index) += angular_velocity_above.cross(joint_axis);
+      }
+      else
+      {
+        RCLCPP_ERROR(LOGGER, "Jacobian derivative is only supported for revolute and prismatic joints");
+        return false;
+      }
+    }
+    if (pjm == root_joint_model)
+      break;
+    link = pjm->getParentLinkModel();
+  }
+  return true;
+}
+
 bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
                              const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
                              bool use_quaternion_representation) const
@@ -1371,7 +1693,7 @@ bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link
       root_link_model ? getGlobalLinkTransform(root_link_model).inverse() : Eigen::Isometry3d::Identity();
   int rows = use_quaternion_representation ? 7 : 6;
   int columns = group->getVariableCount();
-  jacobian = Eigen::MatrixXd::Zero(rows, columns);
+  jacobian.setZero(rows, columns);  // reuses the memory of jacobian if it has the right size already
 
   // getGlobalLinkTransform() returns a valid isometry by contract
   Eigen::Isometry3d link_transform = reference_transform * getGlobalLinkTransform(link);  // valid isometry
@@ -1443,7 +1765,7 @@ bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link
     //        [z]           [ -y  x  w ]
     Eigen::Quaterniond q(link_transform.linear());
     double w = q.w(), x = q.x(), y = q.y(), z = q.z();
-    Eigen::MatrixXd quaternion_update_matrix(4, 3);
+    Eigen::Matrix<double, 4, 3> quaternion_update_matrix;
     quaternion_update_matrix << -x, -y, -z, w, -z, y, z, w, -x, -y, x, w;
     jacobian.block(3, 0, 4, columns) = 0.5 * quaternion_update_matrix * jacobian.block(3, 0, 3, columns);
   }
@@ -1601,6 +1923,42 @@ bool ikCallbackFnAdapter(RobotState* state, const JointModelGroup* group,
   }
   return true;
 }
+
+// Subgroups can be solved concurrently if each has a solver of its own, no moving joint is shared between them and
+// none of them moves the base frame of another subgroup's solver
+bool areSubgroupsIndependent(const RobotModel& robot_model, const std::vector<const JointModelGroup*>& sub_groups,
+                             const std::vector<kinematics::KinematicsBaseConstPtr>& solvers)
+{
+  for (std::size_t i = 0; i < sub_groups.size(); ++i)
+  {
+    std::string base_frame = solvers[i]->getBaseFrame();
+    if (!base_frame.empty() && base_frame[0] == '/')
+      base_frame = base_frame.substr(1);
+    if (!robot_model.hasLinkModel(base_frame))
+      return false;
+    const LinkModel* base_link = robot_model.getLinkModel(base_frame);
+
+    for (std::size_t j = 0; j < sub_groups.size(); ++j)
+    {
+      if (i == j)
+        continue;
+      if (solvers[i] == solvers[j])
+        return false;
+      for (const JointModel* joint_model : sub_groups[i]->getJointModels())
+      {
+        if (joint_model->getType() != JointModel::FIXED && sub_groups[j]->hasJointModel(joint_model->getName()))
+          return false;
+      }
+      for (const LinkModel* link = base_link; link; link = link->getParentLinkModel())
+      {
+        const JointModel* joint_model = link->getParentJointModel();
+        if (joint_model->getType() != JointModel::FIXED && sub_groups[j]->hasJointModel(joint_model->getName()))
+          return false;
+      }
+    }
+  }
+  return true;
+}
 }  // namespace
 
 bool RobotState::setToIKSolverFrame(Eigen::Isometry3d& pose, const kinematics::KinematicsBaseConstPtr& solver)
@@ -1894,6 +2252,120 @@ bool RobotState::setFromIK(const JointModelGroup* jmg, const EigenSTL::vector_Is
   return false;
 }
 
+bool RobotState::setFromIKBatch(const JointModelGroup* jmg, const EigenSTL::vector_Isometry3d& poses_in,
+                                const std::string& tip_in, std::vector<RobotState>& states, std::vector<bool>& solved,
+                                double timeout, const GroupStateValidityCallbackFn& constraint,
+                                const kinematics::KinematicsQueryOptions& options)
+{
+  states.clear();
+  solved.assign(poses_in.size(), false);
+
+  const kinematics::KinematicsBaseConstPtr& solver = jmg->getSolverInstance();
+  if (!solver)
+  {
+    RCLCPP_ERROR(LOGGER, "No kinematics solver instantiated for group '%s'", jmg->getName().c_str());
+    return false;
+  }
+  if (solver->getTipFrames().size() != 1)
+  {
+    RCLCPP_ERROR(LOGGER, "Batch IK for group '%s' requires a kinematics solver with a single tip frame",
+                 jmg->getName().c_str());
+    return false;
+  }
+
+  // remove the frame '/' if there is one, so we can avoid calling Transforms::sameFrame()
+  std::string pose_frame = (!tip_in.empty() && tip_in[0] == '/') ? tip_in.substr(1) : tip_in;
+  std::string solver_tip_frame = solver->getTipFrame();
+  if (!solver_tip_frame.empty() && solver_tip_frame[0] == '/')
+    solver_tip_frame = solver_tip_frame.substr(1);
+
+  // the offset from the requested tip frame to the solver's tip frame is the same for all poses
+  Eigen::Isometry3d tip_offset = Eigen::Isometry3d::Identity();
+  if (pose_frame != solver_tip_frame && hasAttachedBody(pose_frame))
+  {
+    const AttachedBody* body = getAttachedBody(pose_frame);
+    pose_frame = body->getAttachedLinkName();
+    tip_offset = body->getPose().inverse();
+  }
+  if (pose_frame != solver_tip_frame)
+  {
+    const moveit::core::LinkModel* link_model = getLinkModel(pose_frame);
+    if (!link_model)
+    {
+      RCLCPP_ERROR(LOGGER, "The following Pose Frame does not exist: %s", pose_frame.c_str());
+      return false;
+    }
+    for (const std::pair<const LinkModel* const, Eigen::Isometry3d>& fixed_link :
+         link_model->getAssociatedFixedTransforms())
+    {
+      if (Transforms::sameFrame(fixed_link.first->getName(), solver_tip_frame))
+      {
+        pose_frame = solver_tip_frame;
+        tip_offset = tip_offset * fixed_link.second;
+        break;
+      }
+    }
+  }
+  if (pose_frame != solver_tip_frame)
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot compute IK for pose reference frame '%s', the solver's tip frame is '%s'",
+                 pose_frame.c_str(), solver_tip_frame.c_str());
+    return false;
+  }
+
+  // so is the transform to the frame of the IK solver
+  Eigen::Isometry3d solver_frame = Eigen::Isometry3d::Identity();
+  if (!setToIKSolverFrame(solver_frame, solver))
+    return false;
+
+  std::vector<geometry_msgs::msg::Pose> ik_queries(poses_in.size());
+  for (std::size_t i = 0; i < poses_in.size(); ++i)
+    ik_queries[i] = tf2::toMsg(solver_frame * poses_in[i] * tip_offset);
+
+  // if no timeout has been specified, use the default one
+  if (timeout < std::numeric_limits<double>::epsilon())
+    timeout = jmg->getDefaultIKTimeout();
+
+  // the constraint may modify the state it is given, so it works on a copy; calls are serialized by the solver
+  std::optional<RobotState> constraint_state;
+  kinematics::KinematicsBase::IKCallbackFn ik_callback_fn;
+  if (constraint)
+  {
+    constraint_state.emplace(*this);
+    ik_callback_fn = [&constraint_state, jmg, &constraint](const geometry_msgs::msg::Pose& pose,
+                                                           const std::vector<double>& joints,
+                                                           moveit_msgs::msg::MoveItErrorCodes& error_code) {
+      ikCallbackFnAdapter(&*constraint_state, jmg, constraint, pose, joints, error_code);
+    };
+  }
+
+  const std::vector<size_t>& bij = jmg->getKinematicsSolverJointBijection();
+  std::vector<double> initial_values;
+  copyJointGroupPositions(jmg, initial_values);
+  std::vector<double> seed(bij.size());
+  for (std::size_t i = 0; i < bij.size(); ++i)
+    seed[i] = initial_values[bij[i]];
+
+  std::vector<std::vector<double>> ik_sols;
+  std::vector<moveit_msgs::msg::MoveItErrorCodes> errors;
+  const bool all_solved =
+      solver->searchPositionIKBatch(ik_queries, { seed }, timeout, ik_sols, errors, ik_callback_fn, options);
+
+  states.reserve(poses_in.size());
+  std::vector<double> solution(bij.size());
+  for (std::size_t i = 0; i < poses_in.size(); ++i)
+  {
+    states.push_back(*this);
+    if (errors[i].val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+      continue;
+    for (std::size_t j = 0; j < bij.size(); ++j)
+      solution[bij[j]] = ik_sols[i][j];
+    states.back().setJointGroupPositions(jmg, solution);
+    solved[i] = true;
+  }
+  return all_solved;
+}
+
 bool RobotState::setFromIKSubgroups(const JointModelGroup* jmg, const EigenSTL::vector_Isometry3d& poses_in,
                                     const std::vector<std::string>& tips_in,
                                     const std::vector<std::vector<double> >& consistency_limits, double timeout,
@@ -2036,6 +2508,38 @@ bool RobotState::setFromIKSubgroups(const JointModelGroup* jmg, const EigenSTL::
   if (timeout < std::numeric_limits<double>::epsilon())
     timeout = jmg->getDefaultIKTimeout();
 
+  // independent subgroups, e.g. the arms of a dual-arm group, are solved concurrently with a timeout each
+  const bool solve_concurrently = sub_groups.size() > 1 && areSubgroupsIndependent(*robot_model_, sub_groups, solvers);
+  RCLCPP_DEBUG(LOGGER, "Solving IK for the %zu subgroups of '%s' %s", sub_groups.size(), jmg->getName().c_str(),
+               solve_concurrently ? "concurrently" : "sequentially");
+
+  // solve a single subgroup, starting from the current state on the first attempt and from a random state otherwise
+  std::vector<std::vector<double>> sub_solutions(sub_groups.size());
+  const auto solve_subgroup = [&](std::size_t sg, bool first_seed, double sg_timeout,
+                                  random_numbers::RandomNumberGenerator& rng) {
+    const std::vector<size_t>& bij = sub_groups[sg]->getKinematicsSolverJointBijection();
+    std::vector<double> values;
+    if (first_seed)
+      copyJointGroupPositions(sub_groups[sg], values);
+    else
+      sub_groups[sg]->getVariableRandomPositions(rng, values);
+    std::vector<double> seed(bij.size());
+    for (std::size_t i = 0; i < bij.size(); ++i)
+      seed[i] = values[bij[i]];
+
+    // compute the IK solution
+    std::vector<double> ik_sol;
+    moveit_msgs::msg::MoveItErrorCodes error;
+    const std::vector<double>& climits = consistency_limits.empty() ? std::vector<double>() : consistency_limits[sg];
+    if (!solvers[sg]->searchPositionIK(ik_queries[sg], seed, sg_timeout, climits, ik_sol, error))
+      return false;
+
+    sub_solutions[sg].resize(bij.size());
+    for (std::size_t i = 0; i < bij.size(); ++i)
+      sub_solutions[sg][bij[i]] = ik_sol[i];
+    return true;
+  };
+
   auto start = std::chrono::system_clock::now();
   double elapsed = 0;
 
@@ -2046,44 +2550,41 @@ bool RobotState::setFromIKSubgroups(const JointModelGroup* jmg, const EigenSTL::
     ++attempts;
     RCLCPP_DEBUG(LOGGER, "IK attempt: %d", attempts);
     bool found_solution = true;
-    for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+    if (solve_concurrently)
     {
-      const std::vector<size_t>& bij = sub_groups[sg]->getKinematicsSolverJointBijection();
-      std::vector<double> seed(bij.size());
-      // the first seed is the initial state
-      if (first_seed)
-      {
-        std::vector<double> initial_values;
-        copyJointGroupPositions(sub_groups[sg], initial_values);
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          seed[i] = initial_values[bij[i]];
-      }
-      else
+      // the state is only read while solving, solutions are applied once all threads are done
+      random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
+      std::vector<char> found(sub_groups.size(), false);
+      std::vector<std::thread> threads;
+      for (std::size_t sg = 1; sg < sub_groups.size(); ++sg)
       {
-        // sample a random seed
-        random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
-        std::vector<double> random_values;
-        sub_groups[sg]->getVariableRandomPositions(rng, random_values);
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          seed[i] = random_values[bij[i]];
+        threads.emplace_back([&, sg] {
+          random_numbers::RandomNumberGenerator thread_rng;
+          found[sg] = solve_subgroup(sg, first_seed, timeout - elapsed, thread_rng);
+        });
       }
+      found[0] = solve_subgroup(0, first_seed, timeout - elapsed, rng);
+      for (std::thread& thread : threads)
+        thread.join();
 
-      // compute the IK solution
-      std::vector<double> ik_sol;
-      moveit_msgs::msg::MoveItErrorCodes error;
-      const std::vector<double>& climits = consistency_limits.empty() ? std::vector<double>() : consistency_limits[sg];
-      if (solvers[sg]->searchPositionIK(ik_queries[sg], seed, (timeout - elapsed) / sub_groups.size(), climits, ik_sol,
-                                        error))
+      found_solution = std::all_of(found.begin(), found.end(), [](char sg_found) { return sg_found; });
+      if (found_solution)
       {
-        std::vector<double> solution(bij.size());
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          solution[bij[i]] = ik_sol[i];
-        setJointGroupPositions(sub_groups[sg], solution);
+        for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+          setJointGroupPositions(sub_groups[sg], sub_solutions[sg]);
       }
-      else
+    }
+    else
+    {
+      // later subgroups depend on the solutions of earlier ones, so they are solved one after the other
+      for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
       {
-        found_solution = false;
-        break;
+        if (!solve_subgroup(sg, first_seed, (timeout - elapsed) / sub_groups.size(), getRandomNumberGenerator()))
+        {
+          found_solution = false;
+          break;
+        }
+        setJointGroupPositions(sub_groups[sg], sub_solutions[sg]);
       }
     }
     if (found_solution)
@@ -2096,7 +2597,7 @@ bool RobotState::setFromIKSubgroups(const JointModelGroup* jmg, const EigenSTL::
         return true;
       }
     }
-    elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - start).count();
+    elapsed = std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
     first_seed = false;
   } while (elapsed < timeout);
   return false;
@@ -0,0 +1,134 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/robot_state_arena.h>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+RobotStateArenaPtr& currentArena()
+{
+  static thread_local RobotStateArenaPtr arena;
+  return arena;
+}
+
+std::size_t alignedSize(std::size_t bytes)
+{
+  constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+  return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+}  // namespace
+
+RobotStateArena::Scope::Scope(const RobotStateArenaPtr& arena) : previous_(currentArena())
+{
+  currentArena() = arena;
+}
+
+RobotStateArena::Scope::~Scope()
+{
+  currentArena() = std::move(previous_);
+}
+
+RobotStateArena::RobotStateArena(std::size_t chunk_size) : chunk_size_(alignedSize(chunk_size))
+{
+}
+
+RobotStateArena::~RobotStateArena()
+{
+  for (void* chunk : chunks_)
+    free(chunk);
+}
+
+const RobotStateArenaPtr& RobotStateArena::getCurrent()
+{
+  return currentArena();
+}
+
+void* RobotStateArena::allocate(std::size_t bytes)
+{
+  bytes = alignedSize(bytes);
+  std::scoped_lock slock(lock_);
+  ++statistics_.allocations;
+  ++statistics_.buffers_in_use;
+
+  std::vector<void*>& free_buffers = free_buffers_[bytes];
+  if (!free_buffers.empty())
+  {
+    void* buffer = free_buffers.back();
+    free_buffers.pop_back();
+    ++statistics_.recycled;
+    return buffer;
+  }
+
+  if (bytes > chunk_remaining_)
+  {
+    // the rest of the current chunk is abandoned; buffers of the same sizes keep getting recycled instead
+    const std::size_t size = std::max(bytes, chunk_size_);
+    void* chunk = malloc(size);
+    if (!chunk)
+      throw std::bad_alloc();
+    chunks_.push_back(chunk);
+    ++statistics_.heap_allocations;
+    statistics_.heap_bytes += size;
+    if (size > chunk_size_)
+      return chunk;
+    chunk_position_ = static_cast<char*>(chunk);
+    chunk_remaining_ = size;
+  }
+  void* buffer = chunk_position_;
+  chunk_position_ += bytes;
+  chunk_remaining_ -= bytes;
+  return buffer;
+}
+
+void RobotStateArena::deallocate(void* buffer, std::size_t bytes)
+{
+  std::scoped_lock slock(lock_);
+  --statistics_.buffers_in_use;
+  free_buffers_[alignedSize(bytes)].push_back(buffer);
+}
+
+RobotStateArena::Statistics RobotStateArena::getStatistics() const
+{
+  std::scoped_lock slock(lock_);
+  return statistics_;
+}
+}  // namespace core
+}  // namespace moveit
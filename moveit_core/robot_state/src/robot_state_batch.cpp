@@ -0,0 +1,294 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/robot_state_batch.h>
+#include <moveit/robot_state/robot_state.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// All transforms below are stored as structure-of-arrays with stride n: component k = col * 3 + row
+// of the 3x4 affine matrix of state i is found at [k * n + i].
+
+// c = m for all states
+void fillConstant(const Eigen::Isometry3d& m, double* c, std::size_t n)
+{
+  for (std::size_t col = 0; col < 4; ++col)
+    for (std::size_t row = 0; row < 3; ++row)
+      std::fill(c + (col * 3 + row) * n, c + (col * 3 + row + 1) * n, m.matrix()(row, col));
+}
+
+// c = a * m, m constant across all states
+void multiplyConstant(const double* a, const Eigen::Isometry3d& m, double* c, std::size_t n)
+{
+  const Eigen::Matrix4d& mm = m.matrix();
+  for (std::size_t col = 0; col < 4; ++col)
+  {
+    for (std::size_t row = 0; row < 3; ++row)
+    {
+      const double m0 = mm(0, col), m1 = mm(1, col), m2 = mm(2, col);
+      const double* a0 = a + row * n;
+      const double* a1 = a + (3 + row) * n;
+      const double* a2 = a + (6 + row) * n;
+      double* out = c + (col * 3 + row) * n;
+      if (col < 3)
+      {
+        for (std::size_t i = 0; i < n; ++i)
+          out[i] = a0[i] * m0 + a1[i] * m1 + a2[i] * m2;
+      }
+      else
+      {
+        const double* at = a + (9 + row) * n;
+        for (std::size_t i = 0; i < n; ++i)
+          out[i] = a0[i] * m0 + a1[i] * m1 + a2[i] * m2 + at[i];
+      }
+    }
+  }
+}
+
+// c = a * b, both varying across states
+void multiply(const double* a, const double* b, double* c, std::size_t n)
+{
+  for (std::size_t col = 0; col < 4; ++col)
+  {
+    const double* b0 = b + (col * 3) * n;
+    const double* b1 = b + (col * 3 + 1) * n;
+    const double* b2 = b + (col * 3 + 2) * n;
+    for (std::size_t row = 0; row < 3; ++row)
+    {
+      const double* a0 = a + row * n;
+      const double* a1 = a + (3 + row) * n;
+      const double* a2 = a + (6 + row) * n;
+      double* out = c + (col * 3 + row) * n;
+      if (col < 3)
+      {
+        for (std::size_t i = 0; i < n; ++i)
+          out[i] = a0[i] * b0[i] + a1[i] * b1[i] + a2[i] * b2[i];
+      }
+      else
+      {
+        const double* at = a + (9 + row) * n;
+        for (std::size_t i = 0; i < n; ++i)
+          out[i] = a0[i] * b0[i] + a1[i] * b1[i] + a2[i] * b2[i] + at[i];
+      }
+    }
+  }
+}
+
+// c = a * R(axis, q), see RevoluteJointModel::computeTransform()
+void multiplyRevolute(const double* a, const Eigen::Vector3d& axis, const double* q, double* c, std::size_t n)
+{
+  const double x = axis.x(), y = axis.y(), z = axis.z();
+  const double x2 = x * x, y2 = y * y, z2 = z * z, xy = x * y, xz = x * z, yz = y * z;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double cq = std::cos(q[i]);
+    const double sq = std::sin(q[i]);
+    const double t = 1.0 - cq;
+    const double txy = t * xy, txz = t * xz, tyz = t * yz;
+    const double xs = x * sq, ys = y * sq, zs = z * sq;
+    const double r00 = t * x2 + cq, r10 = txy + zs, r20 = txz - ys;
+    const double r01 = txy - zs, r11 = t * y2 + cq, r21 = tyz + xs;
+    const double r02 = txz + ys, r12 = tyz - xs, r22 = t * z2 + cq;
+    for (std::size_t row = 0; row < 3; ++row)
+    {
+      const double a0 = a[row * n + i];
+      const double a1 = a[(3 + row) * n + i];
+      const double a2 = a[(6 + row) * n + i];
+      c[row * n + i] = a0 * r00 + a1 * r10 + a2 * r20;
+      c[(3 + row) * n + i] = a0 * r01 + a1 * r11 + a2 * r21;
+      c[(6 + row) * n + i] = a0 * r02 + a1 * r12 + a2 * r22;
+    }
+  }
+  // a revolute joint does not translate
+  std::memcpy(c + 9 * n, a + 9 * n, 3 * n * sizeof(double));
+}
+
+// c = a * Translation(axis * q), see PrismaticJointModel::computeTransform()
+void multiplyPrismatic(const double* a, const Eigen::Vector3d& axis, const double* q, double* c, std::size_t n)
+{
+  // a prismatic joint does not rotate
+  std::memcpy(c, a, 9 * n * sizeof(double));
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double* a0 = a + row * n;
+    const double* a1 = a + (3 + row) * n;
+    const double* a2 = a + (6 + row) * n;
+    const double* at = a + (9 + row) * n;
+    double* out = c + (9 + row) * n;
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = (a0[i] * axis.x() + a1[i] * axis.y() + a2[i] * axis.z()) * q[i] + at[i];
+  }
+}
+}  // namespace
+
+RobotStateBatch::RobotStateBatch(const RobotModelConstPtr& robot_model, std::size_t size)
+  : robot_model_(robot_model), size_(0), dirty_(true)
+{
+  if (robot_model == nullptr)
+  {
+    throw std::invalid_argument("RobotStateBatch cannot be constructed with nullptr RobotModelConstPtr");
+  }
+  resize(size);
+}
+
+void RobotStateBatch::resize(std::size_t size)
+{
+  size_ = size;
+  positions_.assign(robot_model_->getVariableCount() * size_, 0.0);
+  link_transforms_.resize(robot_model_->getLinkModelCount() * TRANSFORM_COMPONENTS * size_);
+  joint_transforms_.resize(TRANSFORM_COMPONENTS * size_);
+  parent_transforms_.resize(TRANSFORM_COMPONENTS * size_);
+  dirty_ = true;
+}
+
+void RobotStateBatch::setVariablePositions(std::size_t state_index, const double* positions)
+{
+  assert(state_index < size_);
+  for (std::size_t v = 0, end = robot_model_->getVariableCount(); v < end; ++v)
+    positions_[v * size_ + state_index] = positions[v];
+  dirty_ = true;
+}
+
+void RobotStateBatch::setVariablePositions(std::size_t state_index, const RobotState& state)
+{
+  assert(state.getRobotModel() == robot_model_);
+  setVariablePositions(state_index, state.getVariablePositions());
+}
+
+void RobotStateBatch::copyVariablePositions(std::size_t state_index, double* positions) const
+{
+  assert(state_index < size_);
+  for (std::size_t v = 0, end = robot_model_->getVariableCount(); v < end; ++v)
+    positions[v] = positions_[v * size_ + state_index];
+}
+
+void RobotStateBatch::copyVariablePositions(std::size_t state_index, RobotState& state) const
+{
+  assert(state.getRobotModel() == robot_model_);
+  std::vector<double> positions(robot_model_->getVariableCount());
+  copyVariablePositions(state_index, positions.data());
+  state.setVariablePositions(positions.data());
+}
+
+void RobotStateBatch::computeJointTransforms(const JointModel* joint)
+{
+  // generic (and slower) path for joints with several variables: evaluate each state separately
+  const std::size_t first = joint->getFirstVariableIndex();
+  std::vector<double> values(joint->getVariableCount());
+  Eigen::Isometry3d transform;
+  for (std::size_t i = 0; i < size_; ++i)
+  {
+    for (std::size_t v = 0; v < values.size(); ++v)
+      values[v] = positions_[(first + v) * size_ + i];
+    joint->computeTransform(values.data(), transform);
+    for (std::size_t col = 0; col < 4; ++col)
+      for (std::size_t row = 0; row < 3; ++row)
+        joint_transforms_[(col * 3 + row) * size_ + i] = transform.matrix()(row, col);
+  }
+}
+
+void RobotStateBatch::updateLinkTransforms()
+{
+  if (size_ == 0)
+  {
+    dirty_ = false;
+    return;
+  }
+
+  // links are ordered such that parents are always processed before their children
+  for (const LinkModel* link : robot_model_->getRootJoint()->getDescendantLinkModels())
+  {
+    const JointModel* joint = link->getParentJointModel();
+    const LinkModel* parent = link->getParentLinkModel();
+
+    // transform of the joint origin frame: parent * origin
+    const double* origin;
+    if (parent && link->jointOriginTransformIsIdentity())
+    {
+      origin = linkTransform(parent->getLinkIndex());
+    }
+    else
+    {
+      if (parent)
+        multiplyConstant(linkTransform(parent->getLinkIndex()), link->getJointOriginTransform(),
+                         parent_transforms_.data(), size_);
+      else
+        fillConstant(link->getJointOriginTransform(), parent_transforms_.data(), size_);
+      origin = parent_transforms_.data();
+    }
+
+    double* out = linkTransform(link->getLinkIndex());
+    const double* q = &positions_[joint->getFirstVariableIndex() * size_];
+    switch (joint->getType())
+    {
+      case JointModel::FIXED:
+        std::memcpy(out, origin, TRANSFORM_COMPONENTS * size_ * sizeof(double));
+        break;
+      case JointModel::REVOLUTE:
+        multiplyRevolute(origin, static_cast<const RevoluteJointModel*>(joint)->getAxis(), q, out, size_);
+        break;
+      case JointModel::PRISMATIC:
+        multiplyPrismatic(origin, static_cast<const PrismaticJointModel*>(joint)->getAxis(), q, out, size_);
+        break;
+      default:
+        computeJointTransforms(joint);
+        multiply(origin, joint_transforms_.data(), out, size_);
+        break;
+    }
+  }
+  dirty_ = false;
+}
+
+Eigen::Isometry3d RobotStateBatch::getGlobalLinkTransform(std::size_t state_index, const LinkModel* link) const
+{
+  assert(state_index < size_);
+  assert(!dirty_);
+  Eigen::Isometry3d result;
+  result.makeAffine();
+  const double* data = &link_transforms_[link->getLinkIndex() * TRANSFORM_COMPONENTS * size_];
+  for (std::size_t col = 0; col < 4; ++col)
+    for (std::size_t row = 0; row < 3; ++row)
+      result.matrix()(row, col) = data[(col * 3 + row) * size_ + state_index];
+  return result;
+}
+}  // namespace core
+}  // namespace moveit
@@ -35,6 +35,7 @@
 /* Author: Robert Haschke */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_batch.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <chrono>
@@ -106,6 +107,74 @@ TEST_F(Timing, stateUpdate)
   }
 }
 
+TEST_F(Timing, cloneAndUpdate)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* arm = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(arm);
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+  const std::size_t runs = 1e5;
+
+  double gold_standard = 0;
+  for (bool share_transforms : { false, true })
+  {
+    ScopedTimer t(share_transforms ? "RobotState clone (shared transforms): " : "RobotState clone (full copy): ",
+                  &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      moveit::core::RobotState clone(state, share_transforms);
+      // only every other clone gets modified, like in a validity check that rejects early
+      if (i % 2)
+      {
+        clone.setToRandomPositions(arm);
+        clone.updateLinkTransforms();
+      }
+    }
+  }
+}
+
+TEST_F(Timing, batchStateUpdate)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const std::size_t batch_size = 1000;
+  const std::size_t runs = 100;
+
+  moveit::core::RobotState state(model);
+  std::vector<std::vector<double>> positions(batch_size);
+  for (std::vector<double>& p : positions)
+  {
+    state.setToRandomPositions();
+    p.assign(state.getVariablePositions(), state.getVariablePositions() + state.getVariableCount());
+  }
+
+  double gold_standard = 0;
+  {
+    ScopedTimer t("RobotState::updateLinkTransforms(): ", &gold_standard);
+    for (std::size_t r = 0; r < runs; ++r)
+    {
+      for (const std::vector<double>& p : positions)
+      {
+        state.setVariablePositions(p);
+        state.updateLinkTransforms();
+      }
+    }
+  }
+  moveit::core::RobotStateBatch batch(model, batch_size);
+  {
+    ScopedTimer t("RobotStateBatch::updateLinkTransforms(): ", &gold_standard);
+    for (std::size_t r = 0; r < runs; ++r)
+    {
+      for (std::size_t i = 0; i < batch_size; ++i)
+        batch.setVariablePositions(i, positions[i].data());
+      batch.updateLinkTransforms();
+    }
+  }
+}
+
 TEST_F(Timing, multiply)
 {
   size_t runs = 1e7;
@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_batch.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <urdf_parser/urdf_parser.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
@@ -714,6 +715,414 @@ TEST_F(OneRobot, rigidlyConnectedParent)
   EXPECT_EQ(nullptr, state.getRigidlyConnectedParentLinkModel("/"));
 }
 
+TEST(RobotState, sharedTransformsCopyOnWrite)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* arm = model->getJointModelGroup("left_arm");
+  ASSERT_TRUE(arm);
+  const moveit::core::LinkModel* tip = arm->getLinkModels().back();
+
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+  const Eigen::Isometry3d original_tip = state.getGlobalLinkTransform(tip);
+
+  moveit::core::RobotState clone(state, true);
+  EXPECT_FALSE(clone.dirty());
+  expect_near(original_tip.matrix(), clone.getGlobalLinkTransform(tip).matrix());
+
+  // modifying the clone must not affect the original state
+  clone.setToRandomPositions(arm);
+  clone.update();
+  expect_near(original_tip.matrix(), state.getGlobalLinkTransform(tip).matrix());
+
+  // and the clone must be consistent with a regular copy
+  moveit::core::RobotState reference(clone);
+  reference.update(true);
+  expect_near(reference.getGlobalLinkTransform(tip).matrix(), clone.getGlobalLinkTransform(tip).matrix(), EPSILON);
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), clone.getGlobalLinkTransform(link).matrix(), EPSILON);
+
+  // modifying the original after sharing must not affect the clone either
+  moveit::core::RobotState second_clone(state, true);
+  state.setToRandomPositions(arm);
+  state.update();
+  expect_near(original_tip.matrix(), second_clone.getGlobalLinkTransform(tip).matrix());
+}
+
+TEST(RobotState, arenaAllocation)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  moveit::core::RobotState reference(model);
+  reference.setToRandomPositions();
+  reference.update();
+
+  auto arena = std::make_shared<moveit::core::RobotStateArena>();
+  std::unique_ptr<moveit::core::RobotState> survivor;
+  {
+    moveit::core::RobotStateArena::Scope scope(arena);
+    EXPECT_EQ(moveit::core::RobotStateArena::getCurrent(), arena);
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+      auto state = std::make_shared<moveit::core::RobotState>(reference);
+      state->setToRandomPositions();
+      state->update();
+    }
+    // every state reuses the buffers of the previous one: the number of heap allocations is bounded
+    const moveit::core::RobotStateArena::Statistics statistics = arena->getStatistics();
+    EXPECT_EQ(statistics.allocations, 200u);
+    EXPECT_EQ(statistics.recycled, 198u);
+    EXPECT_EQ(statistics.buffers_in_use, 0u);
+    EXPECT_LE(statistics.heap_allocations, 2u);
+
+    survivor = std::make_unique<moveit::core::RobotState>(reference);
+  }
+  EXPECT_FALSE(moveit::core::RobotStateArena::getCurrent());
+
+  // states outside of the scope use the heap, states created inside it keep the arena alive
+  moveit::core::RobotState outside(reference);
+  EXPECT_EQ(arena->getStatistics().allocations, 202u);
+  const std::weak_ptr<moveit::core::RobotStateArena> weak_arena = arena;
+  arena.reset();
+  EXPECT_FALSE(weak_arena.expired());
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), survivor->getGlobalLinkTransform(link).matrix());
+  survivor.reset();
+  EXPECT_TRUE(weak_arena.expired());
+}
+
+TEST(RobotState, lazyAttachedBodyTransforms)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* left_arm = model->getJointModelGroup("left_arm");
+  const moveit::core::JointModelGroup* right_arm = model->getJointModelGroup("right_arm");
+  const moveit::core::LinkModel* tool_link = left_arm->getLinkModels().back();
+
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.1, 0.0, 0.0);
+  Eigen::Isometry3d tip = Eigen::Isometry3d::Identity();
+  tip.translation() = Eigen::Vector3d(0.0, 0.0, 0.2);
+  state.attachBody(std::make_unique<moveit::core::AttachedBody>(
+      tool_link, "tool", pose, std::vector<shapes::ShapeConstPtr>{ std::make_shared<shapes::Box>(0.1, 0.1, 0.1) },
+      EigenSTL::vector_Isometry3d{ Eigen::Isometry3d::Identity() }, std::set<std::string>{},
+      trajectory_msgs::msg::JointTrajectory{}, moveit::core::FixedTransformsMap{ { "tip", tip } }));
+
+  const auto expect_attached_transforms = [&](const moveit::core::RobotState& s) {
+    const moveit::core::AttachedBody* body = s.getAttachedBody("tool");
+    const Eigen::Isometry3d expected = s.getGlobalLinkTransform(tool_link) * pose;
+    expect_near(expected.matrix(), body->getGlobalPose().matrix(), EPSILON);
+    expect_near(expected.matrix(), body->getGlobalCollisionBodyTransforms()[0].matrix(), EPSILON);
+    expect_near((expected * tip).matrix(), body->getGlobalSubframeTransform("tool/tip").matrix(), EPSILON);
+    expect_near((expected * tip).matrix(), s.getFrameTransform("tool/tip").matrix(), EPSILON);
+  };
+  expect_attached_transforms(state);
+
+  // moving another arm leaves the body untouched, moving its link updates it on access
+  const Eigen::Isometry3d before = state.getAttachedBody("tool")->getGlobalPose();
+  state.setToRandomPositions(right_arm);
+  state.update();
+  expect_near(before.matrix(), state.getAttachedBody("tool")->getGlobalPose().matrix());
+  state.setToRandomPositions(left_arm);
+  state.update();
+  expect_attached_transforms(state);
+
+  // copies carry the body along
+  moveit::core::RobotState copy(state);
+  copy.setToRandomPositions(left_arm);
+  copy.update();
+  expect_attached_transforms(copy);
+  expect_attached_transforms(state);
+}
+
+TEST(RobotState, independentDirtySubtrees)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* left_arm = model->getJointModelGroup("left_arm");
+  const moveit::core::JointModelGroup* right_arm = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(left_arm);
+  ASSERT_TRUE(right_arm);
+  const moveit::core::LinkModel* left_tip = left_arm->getLinkModels().back();
+  const moveit::core::LinkModel* right_tip = right_arm->getLinkModels().back();
+  const moveit::core::LinkModel* torso = model->getLinkModel("torso_lift_link");
+  ASSERT_TRUE(torso);
+
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+
+  state.setToRandomPositions(left_arm);
+  state.setToRandomPositions(right_arm);
+  EXPECT_TRUE(state.dirtyLinkTransforms());
+  EXPECT_TRUE(state.dirtyLinkTransform(left_tip));
+  EXPECT_TRUE(state.dirtyLinkTransform(right_tip));
+  // the common parent of both arms is not affected
+  EXPECT_FALSE(state.dirtyLinkTransform(torso));
+
+  moveit::core::RobotState reference(state);
+  reference.update(true);
+
+  // only update the left arm
+  state.updateLinkTransforms(left_arm);
+  EXPECT_FALSE(state.dirtyLinkTransform(left_tip));
+  EXPECT_TRUE(state.dirtyLinkTransform(right_tip));
+  EXPECT_TRUE(state.dirtyLinkTransforms());
+  const moveit::core::RobotState& const_state = state;
+  expect_near(reference.getGlobalLinkTransform(left_tip).matrix(), const_state.getGlobalLinkTransform(left_tip).matrix(),
+              EPSILON);
+
+  // a full update takes care of the rest
+  state.updateLinkTransforms();
+  EXPECT_FALSE(state.dirtyLinkTransforms());
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), state.getGlobalLinkTransform(link).matrix(), EPSILON);
+}
+
+TEST(RobotState, dirtyCommonRootAfterSubtrees)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* left_arm = model->getJointModelGroup("left_arm");
+  const moveit::core::JointModelGroup* right_arm = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(left_arm);
+  ASSERT_TRUE(right_arm);
+  const moveit::core::JointModel* common_root =
+      model->getCommonRoot(left_arm->getCommonRoot(), right_arm->getCommonRoot());
+  ASSERT_TRUE(common_root);
+  ASSERT_EQ(common_root->getVariableCount(), 1u);
+  // a link below the common root of both arms, but in neither arm
+  const moveit::core::LinkModel* sibling = model->getLinkModel("head_pan_link");
+  ASSERT_TRUE(sibling);
+
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+
+  // dirty both arms, then the joint above both of them
+  state.setToRandomPositions(left_arm);
+  state.setToRandomPositions(right_arm);
+  const moveit::core::VariableBounds& bounds = common_root->getVariableBounds()[0];
+  const double position = 0.5 * (bounds.min_position_ + bounds.max_position_) + 0.01;
+  state.setJointPositions(common_root, &position);
+  EXPECT_TRUE(state.dirtyLinkTransform(sibling));
+
+  moveit::core::RobotState reference(model);
+  reference.setVariablePositions(state.getVariablePositions());
+  reference.update(true);
+
+  state.updateLinkTransforms();
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), state.getGlobalLinkTransform(link).matrix(), EPSILON);
+}
+
+namespace
+{
+// Kinematics of the subtree of a joint computed from its joint models, standing in for generated code
+class SubtreeKinematics : public moveit::core::CompiledForwardKinematics
+{
+public:
+  SubtreeKinematics(const moveit::core::RobotModel& model, const std::string& root_joint, double error = 0.0)
+    : model_name_(model.getName()), root_joint_(model.getJointModel(root_joint)), error_(error)
+  {
+    for (const moveit::core::LinkModel* link : root_joint_->getDescendantLinkModels())
+    {
+      links_.push_back(link);
+      link_names_.push_back(link->getName());
+      for (const std::string& variable : link->getParentJointModel()->getVariableNames())
+        variable_names_.push_back(variable);
+    }
+  }
+
+  std::string getRobotModelName() const override
+  {
+    return model_name_;
+  }
+  std::string getRootJointName() const override
+  {
+    return root_joint_->getName();
+  }
+  std::vector<std::string> getLinkNames() const override
+  {
+    return link_names_;
+  }
+  std::vector<std::string> getVariableNames() const override
+  {
+    return variable_names_;
+  }
+
+  void computeLinkTransforms(const Eigen::Isometry3d& base, const double* positions, const int* variable_indices,
+                             Eigen::Isometry3d* link_transforms, const int* link_indices) const override
+  {
+    ++calls;
+    std::size_t variable = 0;
+    for (std::size_t i = 0; i < links_.size(); ++i)
+    {
+      const moveit::core::JointModel* joint = links_[i]->getParentJointModel();
+      std::vector<double> values;
+      for (std::size_t j = 0; j < joint->getVariableCount(); ++j)
+        values.push_back(positions[variable_indices[variable++]] + error_);
+      Eigen::Isometry3d joint_transform;
+      joint->computeTransform(values.data(), joint_transform);
+      const moveit::core::LinkModel* parent = links_[i]->getParentLinkModel();
+      const Eigen::Isometry3d& parent_transform =
+          parent == root_joint_->getParentLinkModel() ? base : link_transforms[parent->getLinkIndex()];
+      link_transforms[link_indices[i]] = parent_transform * links_[i]->getJointOriginTransform() * joint_transform;
+    }
+  }
+
+  mutable std::size_t calls = 0;
+
+private:
+  std::string model_name_;
+  const moveit::core::JointModel* root_joint_;
+  double error_;
+  std::vector<const moveit::core::LinkModel*> links_;
+  std::vector<std::string> link_names_;
+  std::vector<std::string> variable_names_;
+};
+}  // namespace
+
+TEST(RobotState, compiledForwardKinematics)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* left_arm = model->getJointModelGroup("left_arm");
+  const std::string root_joint = left_arm->getJointModels().front()->getName();
+
+  // kinematics that disagree with the model are rejected
+  EXPECT_FALSE(model->setCompiledForwardKinematics(std::make_shared<SubtreeKinematics>(*model, root_joint, 0.01)));
+  EXPECT_FALSE(model->getCompiledForwardKinematics(left_arm->getLinkModels().back()));
+
+  moveit::core::RobotState reference(model);
+  reference.setToRandomPositions();
+  reference.update(true);
+
+  auto kinematics = std::make_shared<SubtreeKinematics>(*model, root_joint);
+  ASSERT_TRUE(model->setCompiledForwardKinematics(kinematics));
+  EXPECT_TRUE(model->getCompiledForwardKinematics(left_arm->getLinkModels().back()));
+  EXPECT_FALSE(model->getCompiledForwardKinematics(model->getRootLink()));
+
+  kinematics->calls = 0;
+  moveit::core::RobotState state(model);
+  state.setVariablePositions(reference.getVariablePositions());
+  state.update(true);
+  EXPECT_EQ(kinematics->calls, 1u);
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), state.getGlobalLinkTransform(link).matrix(), EPSILON);
+
+  // updates of the subtree use the compiled kinematics, updates below its root joint the joint models
+  state.setToRandomPositions(left_arm);
+  state.update();
+  EXPECT_EQ(kinematics->calls, 2u);
+  const moveit::core::JointModel* wrist = left_arm->getActiveJointModels().back();
+  const double wrist_position = 0.3;
+  state.setJointPositions(wrist, &wrist_position);
+  state.update();
+  EXPECT_EQ(kinematics->calls, 2u);
+  reference.setVariablePositions(state.getVariablePositions());
+  reference.update(true);
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    expect_near(reference.getGlobalLinkTransform(link).matrix(), state.getGlobalLinkTransform(link).matrix(), EPSILON);
+
+  // the joint transforms of the subtree are updated as well
+  state.setToRandomPositions(left_arm);
+  state.update();
+  EXPECT_EQ(kinematics->calls, 3u);
+  reference.setVariablePositions(state.getVariablePositions());
+  reference.update(true);
+  const moveit::core::RobotState& const_state = state;
+  for (const moveit::core::JointModel* joint : model->getJointModel(root_joint)->getDescendantJointModels())
+  {
+    EXPECT_FALSE(state.dirtyJointTransform(joint)) << joint->getName();
+    expect_near(reference.getJointTransform(joint).matrix(), const_state.getJointTransform(joint).matrix(), EPSILON);
+  }
+}
+
+TEST(RobotState, jacobianCacheAndDerivative)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  ASSERT_TRUE(group);
+  const moveit::core::LinkModel* tip = group->getLinkModels().back();
+  const Eigen::Vector3d reference_point(0.1, 0.0, 0.05);
+
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.setToRandomPositions(group);
+  Eigen::VectorXd positions, velocities = Eigen::VectorXd::Random(group->getVariableCount());
+  state.copyJointGroupPositions(group, positions);
+  state.setJointGroupVelocities(group, velocities);
+  state.update();
+
+  // the cached jacobian must match a fresh computation, also after changing the state
+  Eigen::MatrixXd cached, reference;
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, cached));
+  ASSERT_TRUE(static_cast<const moveit::core::RobotState&>(state).getJacobian(group, tip, reference_point, reference));
+  expect_near(reference, cached, EPSILON);
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, cached));
+  expect_near(reference, cached, EPSILON);
+  ASSERT_TRUE(state.getJacobian(group, tip, Eigen::Vector3d::Zero(), cached));
+  expect_near(state.getJacobian(group), cached, EPSILON);
+
+  // the derivative must match central differences along the joint velocities
+  Eigen::MatrixXd jacobian, jacobian_derivative;
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, jacobian, jacobian_derivative));
+  expect_near(reference, jacobian, EPSILON);
+
+  const double dt = 1e-6;
+  Eigen::MatrixXd jacobian_plus, jacobian_minus;
+  state.setJointGroupPositions(group, positions + velocities * dt);
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, jacobian_plus));
+  state.setJointGroupPositions(group, positions - velocities * dt);
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, jacobian_minus));
+  expect_near((jacobian_plus - jacobian_minus) / (2 * dt), jacobian_derivative, 1e-6);
+
+  // without velocities, the derivative vanishes
+  state.dropVelocities();
+  ASSERT_TRUE(state.getJacobian(group, tip, reference_point, jacobian, jacobian_derivative));
+  EXPECT_EQ(jacobian_derivative.norm(), 0.0);
+}
+
+TEST(RobotStateBatch, matchesRobotStateFK)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+
+  const std::size_t batch_size = 17;
+  moveit::core::RobotStateBatch batch(model, batch_size);
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < batch_size; ++i)
+  {
+    states.emplace_back(model);
+    states.back().setToRandomPositions();
+    batch.setVariablePositions(i, states.back());
+  }
+  EXPECT_TRUE(batch.dirty());
+  batch.updateLinkTransforms();
+  EXPECT_FALSE(batch.dirty());
+
+  for (std::size_t i = 0; i < batch_size; ++i)
+  {
+    states[i].updateLinkTransforms();
+    for (const moveit::core::LinkModel* link : model->getLinkModels())
+      expect_near(states[i].getGlobalLinkTransform(link).matrix(), batch.getGlobalLinkTransform(i, link).matrix(),
+                  1e-9);
+  }
+
+  // round trip of positions
+  moveit::core::RobotState copy(model);
+  batch.copyVariablePositions(3, copy);
+  for (std::size_t v = 0; v < model->getVariableCount(); ++v)
+    EXPECT_EQ(copy.getVariablePosition(v), states[3].getVariablePosition(v));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
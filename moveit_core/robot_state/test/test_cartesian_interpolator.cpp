@@ -34,6 +34,10 @@
 
 /* Author: Michael Lautman */
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/cartesian_interpolator.h>
@@ -353,6 +357,123 @@ protected:
 //   EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_) * offset, goal, prec_);
 // }
 
+TEST_F(PandaRobot, testJacobianStepping)
+{
+  // Jacobian steps follow a densely sampled path without calling the IK solver
+  JacobianStepping stepping;
+  stepping.enabled = true;
+  Eigen::Isometry3d goal = start_pose_;
+  goal.translation().x() += 0.1;
+  goal.rotate(Eigen::AngleAxisd(0.1, Eigen::Vector3d::UnitZ()));
+
+  const double fraction = CartesianInterpolator::computeCartesianPath(
+      start_state_.get(), jmg_, result_, link_, goal, true, MaxEEFStep(0.01), JumpThreshold(),
+      GroupStateValidityCallbackFn(), kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(),
+      Eigen::Isometry3d::Identity(), stepping);
+  ASSERT_DOUBLE_EQ(fraction, 1.0);
+  EXPECT_EIGEN_NEAR(result_.front()->getGlobalLinkTransform(link_), start_pose_, prec_);
+  EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_), goal, 1e-4);
+}
+
+TEST_F(PandaRobot, testJacobianSteppingValidation)
+{
+  // states beyond 5cm are rejected; the batch is bisected to the first of them, which the IK solver cannot fix
+  JacobianStepping stepping;
+  stepping.enabled = true;
+  const double max_x = start_pose_.translation().x() + 0.05;
+  const GroupStateValidityCallbackFn valid = [max_x](RobotState* state, const JointModelGroup* group,
+                                                     const double* values) {
+    state->setJointGroupPositions(group, values);
+    state->update();
+    return state->getGlobalLinkTransform(link_).translation().x() <= max_x;
+  };
+  Eigen::Isometry3d goal = start_pose_;
+  goal.translation().x() += 0.1;
+
+  // 11 steps of 0.1 / 11, of which the first 5 stay within 5cm
+  const double fraction = CartesianInterpolator::computeCartesianPath(
+      start_state_.get(), jmg_, result_, link_, goal, true, MaxEEFStep(0.01), JumpThreshold(), valid,
+      kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(), Eigen::Isometry3d::Identity(),
+      stepping);
+  EXPECT_NEAR(fraction, 5.0 / 11.0, prec_);
+  ASSERT_EQ(result_.size(), 6u);
+  for (const auto& waypoint : result_)
+    EXPECT_LE(waypoint->getGlobalLinkTransform(link_).translation().x(), max_x);
+}
+
+TEST_F(PandaRobot, testParallelSegments)
+{
+  // segments computed on multiple threads are joined into the same path as the sequential computation
+  JacobianStepping stepping;
+  stepping.enabled = true;
+  EigenSTL::vector_Isometry3d waypoints;
+  for (const Eigen::Vector3d& translation :
+       { Eigen::Vector3d(0.05, 0, 0), Eigen::Vector3d(0, 0.05, 0), Eigen::Vector3d(0, 0, -0.05) })
+    waypoints.push_back(Eigen::Isometry3d(Eigen::Translation3d(translation)));
+
+  RobotState parallel_start(*start_state_);
+  std::vector<std::shared_ptr<RobotState>> sequential_result;
+  const double sequential_fraction = CartesianInterpolator::computeCartesianPath(
+      start_state_.get(), jmg_, sequential_result, link_, waypoints, false, MaxEEFStep(0.007), JumpThreshold(),
+      GroupStateValidityCallbackFn(), kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(),
+      Eigen::Isometry3d::Identity(), stepping);
+  const double parallel_fraction = CartesianInterpolator::computeCartesianPath(
+      &parallel_start, jmg_, result_, link_, waypoints, false, MaxEEFStep(0.007), JumpThreshold(),
+      GroupStateValidityCallbackFn(), kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(),
+      Eigen::Isometry3d::Identity(), stepping, 3);
+
+  ASSERT_DOUBLE_EQ(sequential_fraction, 1.0);
+  ASSERT_DOUBLE_EQ(parallel_fraction, 1.0);
+  ASSERT_EQ(result_.size(), sequential_result.size());
+  Eigen::Isometry3d goal = start_pose_;
+  for (const Eigen::Isometry3d& waypoint : waypoints)
+    goal = goal * waypoint;
+  EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_), goal, 1e-4);
+  EXPECT_EIGEN_NEAR(parallel_start.getGlobalLinkTransform(link_), goal, 1e-4);
+}
+
+TEST_F(PandaRobot, testParallelSegmentsWithIK)
+{
+  // without Jacobian stepping, every step is solved by IK; the segment threads must not call the solver concurrently
+  EigenSTL::vector_Isometry3d waypoints;
+  for (const Eigen::Vector3d& translation :
+       { Eigen::Vector3d(0.05, 0, 0), Eigen::Vector3d(0, 0.05, 0), Eigen::Vector3d(0, 0, -0.05) })
+    waypoints.push_back(Eigen::Isometry3d(Eigen::Translation3d(translation)));
+
+  // with IK only, the validity callback is only called by the solver
+  std::atomic<int> active_calls{ 0 };
+  std::atomic<int> max_active_calls{ 0 };
+  const GroupStateValidityCallbackFn valid = [&](RobotState* /*state*/, const JointModelGroup* /*group*/,
+                                                 const double* /*values*/) {
+    const int active = ++active_calls;
+    int max_active = max_active_calls;
+    while (active > max_active && !max_active_calls.compare_exchange_weak(max_active, active))
+      ;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    --active_calls;
+    return true;
+  };
+
+  RobotState parallel_start(*start_state_);
+  std::vector<std::shared_ptr<RobotState>> sequential_result;
+  const double sequential_fraction = CartesianInterpolator::computeCartesianPath(
+      start_state_.get(), jmg_, sequential_result, link_, waypoints, false, MaxEEFStep(0.007), JumpThreshold(), valid);
+  const double parallel_fraction = CartesianInterpolator::computeCartesianPath(
+      &parallel_start, jmg_, result_, link_, waypoints, false, MaxEEFStep(0.007), JumpThreshold(), valid,
+      kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(), Eigen::Isometry3d::Identity(),
+      JacobianStepping(), 3);
+
+  ASSERT_DOUBLE_EQ(sequential_fraction, 1.0);
+  ASSERT_DOUBLE_EQ(parallel_fraction, 1.0);
+  EXPECT_EQ(max_active_calls, 1);
+  ASSERT_EQ(result_.size(), sequential_result.size());
+  Eigen::Isometry3d goal = start_pose_;
+  for (const Eigen::Isometry3d& waypoint : waypoints)
+    goal = goal * waypoint;
+  EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_), goal, 1e-4);
+  EXPECT_EIGEN_NEAR(parallel_start.getGlobalLinkTransform(link_), goal, 1e-4);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -38,6 +38,7 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/conversions.h>
 #include <urdf_parser/urdf_parser.h>
+#include <algorithm>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <geometric_shapes/shapes.h>
@@ -351,6 +352,64 @@ TEST_F(LoadPlanningModelsPr2, ObjectPoseAndSubframes)
   EXPECT_TRUE(p.isApprox(p2, EPSILON));
 }
 
+TEST_F(LoadPlanningModelsPr2, ConversionContext)
+{
+  moveit::core::RobotState ks(robot_model_);
+  ks.setToRandomPositions();
+  ks.setVariableVelocity(robot_model_->getSingleDOFJointModels().front()->getFirstVariableIndex(), 0.5);
+
+  std::vector<shapes::ShapeConstPtr> shapes = { std::make_shared<shapes::Box>(.1, .1, .1) };
+  EigenSTL::vector_Isometry3d poses = { Eigen::Isometry3d::Identity() };
+  trajectory_msgs::msg::JointTrajectory empty_state;
+  ks.attachBody(std::make_unique<moveit::core::AttachedBody>(robot_model_->getLinkModel("r_gripper_palm_link"), "box",
+                                                             Eigen::Isometry3d(Eigen::Translation3d(0, 0, 1)), shapes,
+                                                             poses, std::set<std::string>(), empty_state));
+
+  // the context creates the same messages as the free function
+  moveit::core::RobotStateConversionContext context;
+  moveit_msgs::msg::RobotState msg, expected_msg;
+  moveit::core::robotStateToRobotStateMsg(ks, expected_msg);
+  context.robotStateToRobotStateMsg(ks, msg);
+  EXPECT_EQ(msg, expected_msg);
+  context.robotStateToRobotStateMsg(ks, msg);
+  EXPECT_EQ(msg, expected_msg);
+
+  moveit::core::RobotState ks2(robot_model_);
+  ks2.setToDefaultValues();
+  ASSERT_TRUE(context.robotStateMsgToRobotState(msg, ks2));
+  ASSERT_TRUE(ks2.hasAttachedBody("box"));
+  const moveit::core::AttachedBody* body = ks2.getAttachedBody("box");
+
+  // an unchanged object stays attached, a changed one is attached again
+  ks2.setToDefaultValues();
+  ASSERT_TRUE(context.robotStateMsgToRobotState(msg, ks2));
+  EXPECT_EQ(ks2.getAttachedBody("box"), body);
+  for (std::size_t i = 0; i < robot_model_->getVariableCount(); ++i)
+    EXPECT_EQ(ks2.getVariablePosition(i), ks.getVariablePosition(i));
+  EXPECT_TRUE(ks2.getAttachedBody("box")->getGlobalPose().isApprox(ks.getAttachedBody("box")->getGlobalPose()));
+
+  msg.attached_collision_objects[0].object.pose.position.z = 2.0;
+  ASSERT_TRUE(context.robotStateMsgToRobotState(msg, ks2));
+  ASSERT_TRUE(ks2.hasAttachedBody("box"));
+  EXPECT_EQ(ks2.getAttachedBody("box")->getPose().translation().z(), 2.0);
+
+  // a message with a different layout sets the same values
+  moveit_msgs::msg::RobotState reversed_msg = expected_msg;
+  sensor_msgs::msg::JointState& joint_state = reversed_msg.joint_state;
+  std::reverse(joint_state.name.begin(), joint_state.name.end());
+  std::reverse(joint_state.position.begin(), joint_state.position.end());
+  std::reverse(joint_state.velocity.begin(), joint_state.velocity.end());
+  moveit::core::RobotState ks3(robot_model_);
+  ks3.setToDefaultValues();
+  ASSERT_TRUE(context.robotStateMsgToRobotState(reversed_msg, ks3));
+  for (std::size_t i = 0; i < robot_model_->getVariableCount(); ++i)
+  {
+    EXPECT_EQ(ks3.getVariablePosition(i), ks.getVariablePosition(i));
+    EXPECT_EQ(ks3.getVariableVelocity(i), ks.getVariableVelocity(i));
+  }
+  EXPECT_TRUE(ks3.hasAttachedBody("box"));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
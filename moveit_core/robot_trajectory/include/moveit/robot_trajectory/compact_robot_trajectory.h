@@ -0,0 +1,192 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace robot_trajectory
+{
+MOVEIT_CLASS_FORWARD(CompactRobotTrajectory);  // Defines CompactRobotTrajectoryPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Joint-space trajectory that stores waypoints compactly instead of as full RobotStates.
+ *
+ *  Positions, velocities and accelerations of the group's variables are stored column-wise in contiguous matrices
+ *  (one column per waypoint), together with the durations between waypoints. Variables outside of the group are
+ *  taken from a single reference state. RobotStates are only materialized when requested, which makes long
+ *  trajectories cheap to store, copy, iterate and serialize.
+ *
+ *  Velocities (accelerations) are only reported if all waypoints had them. Effort is not stored.
+ */
+class CompactRobotTrajectory
+{
+public:
+  using ConstMatrixMap = Eigen::Map<const Eigen::MatrixXd>;
+
+  /** @brief Construct an empty trajectory for the JointModelGroup
+   *  @param reference_state Values of all variables outside of the group, used when materializing RobotStates
+   *  @param group The group whose variables are stored. If nullptr, all variables of the robot are stored.
+   */
+  CompactRobotTrajectory(const moveit::core::RobotState& reference_state, const moveit::core::JointModelGroup* group);
+
+  /** @brief Convert a RobotTrajectory. Its first waypoint (or the default state if it is empty) becomes the reference
+   * state. */
+  explicit CompactRobotTrajectory(const RobotTrajectory& trajectory);
+
+  const moveit::core::RobotModelConstPtr& getRobotModel() const
+  {
+    return reference_state_.getRobotModel();
+  }
+
+  const moveit::core::JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  const moveit::core::RobotState& getReferenceState() const
+  {
+    return reference_state_;
+  }
+
+  /** @brief Indices of the stored variables within a RobotState, i.e. the rows of the matrices */
+  const std::vector<int>& getVariableIndices() const
+  {
+    return variable_indices_;
+  }
+
+  std::size_t getVariableCount() const
+  {
+    return variable_indices_.size();
+  }
+
+  std::size_t getWayPointCount() const
+  {
+    return durations_.size();
+  }
+
+  bool empty() const
+  {
+    return durations_.empty();
+  }
+
+  bool hasVelocities() const
+  {
+    return !empty() && has_velocities_;
+  }
+
+  bool hasAccelerations() const
+  {
+    return !empty() && has_accelerations_;
+  }
+
+  /** @brief Positions of all waypoints, one column per waypoint */
+  ConstMatrixMap getPositions() const
+  {
+    return ConstMatrixMap(positions_.data(), getVariableCount(), getWayPointCount());
+  }
+
+  /** @brief Velocities of all waypoints, one column per waypoint. Zero if hasVelocities() is false. */
+  ConstMatrixMap getVelocities() const
+  {
+    return ConstMatrixMap(velocities_.data(), getVariableCount(), getWayPointCount());
+  }
+
+  /** @brief Accelerations of all waypoints, one column per waypoint. Zero if hasAccelerations() is false. */
+  ConstMatrixMap getAccelerations() const
+  {
+    return ConstMatrixMap(accelerations_.data(), getVariableCount(), getWayPointCount());
+  }
+
+  const std::vector<double>& getWayPointDurations() const
+  {
+    return durations_;
+  }
+
+  double getWayPointDurationFromPrevious(std::size_t index) const
+  {
+    return index < durations_.size() ? durations_[index] : 0.0;
+  }
+
+  /** @brief  Returns the duration after start that a waypoint will be reached.
+   *  @param  The waypoint index.
+   *  @return The duration from start; returns overall duration if index is out of range.
+   */
+  double getWayPointDurationFromStart(std::size_t index) const;
+
+  double getDuration() const;
+
+  /** @brief Reserve storage for the given number of waypoints */
+  void reserve(std::size_t waypoint_count);
+
+  /**
+   * \brief Add a point to the trajectory. Only the group's variables of \e state are stored.
+   * \param state - current robot state
+   * \param dt - duration from previous
+   */
+  CompactRobotTrajectory& addSuffixWayPoint(const moveit::core::RobotState& state, double dt);
+
+  CompactRobotTrajectory& clear();
+
+  /** @brief Write the group's variables of a waypoint into \e state, leaving all other variables untouched.
+   *  This does not allocate. Call state.update() before querying transforms.
+   */
+  void getWayPoint(std::size_t index, moveit::core::RobotState& state) const;
+
+  /** @brief Materialize a waypoint as a new, updated RobotState based on the reference state */
+  moveit::core::RobotStatePtr getWayPointPtr(std::size_t index) const;
+
+  /** @brief Materialize all waypoints into a RobotTrajectory */
+  void getRobotTrajectory(RobotTrajectory& trajectory) const;
+
+  /** @brief Same as RobotTrajectory::getRobotTrajectoryMsg(), but reads directly from the compact storage */
+  void getRobotTrajectoryMsg(moveit_msgs::msg::RobotTrajectory& trajectory,
+                             const std::vector<std::string>& joint_filter = std::vector<std::string>()) const;
+
+private:
+  moveit::core::RobotState reference_state_;
+  const moveit::core::JointModelGroup* group_;
+  std::vector<int> variable_indices_;
+  /** Active joints and the row of their first variable */
+  std::vector<std::pair<const moveit::core::JointModel*, std::size_t>> active_joints_;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  std::vector<double> durations_;
+  bool has_velocities_;
+  bool has_accelerations_;
+};
+}  // namespace robot_trajectory
@@ -42,7 +42,9 @@
 #include <moveit_msgs/msg/robot_state.hpp>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
 
 #include <rcl/error_handling.h>
 #include <rcl/time.h>
@@ -85,6 +87,8 @@ public:
    */
   RobotTrajectory(const RobotTrajectory& other, bool deepcopy = false);
 
+  class DurationCursor;
+
   const moveit::core::RobotModelConstPtr& getRobotModel() const
   {
     return robot_model_;
@@ -149,7 +153,8 @@ public:
     return duration_from_previous_;
   }
 
-  /** @brief  Returns the duration after start that a waypoint will be reached.
+  /** @brief  Returns the duration after start that a waypoint will be reached, in constant time once the durations
+   *          from start are indexed (see findWayPointIndicesForDurationAfterStart()).
    *  @param  The waypoint index.
    *  @return The duration from start; returns overall duration if index is out of range.
    */
@@ -174,6 +179,7 @@ public:
     if (duration_from_previous_.size() <= index)
       duration_from_previous_.resize(index + 1, 0.0);
     duration_from_previous_[index] = value;
+    invalidateTimeFromStart(index);
     return *this;
   }
 
@@ -215,6 +221,7 @@ public:
     state->update();
     waypoints_.push_front(state);
     duration_from_previous_.push_front(dt);
+    invalidateTimeFromStart(0);
     return *this;
   }
 
@@ -228,6 +235,7 @@ public:
     state->update();
     waypoints_.insert(waypoints_.begin() + index, state);
     duration_from_previous_.insert(duration_from_previous_.begin() + index, dt);
+    invalidateTimeFromStart(index);
     return *this;
   }
 
@@ -250,6 +258,7 @@ public:
   {
     waypoints_.clear();
     duration_from_previous_.clear();
+    invalidateTimeFromStart(0);
     return *this;
   }
 
@@ -297,6 +306,9 @@ public:
   RobotTrajectory& unwind(const moveit::core::RobotState& state);
 
   /** @brief Finds the waypoint indices before and after a duration from start.
+   *  The durations from start of the waypoints are indexed on the first call, so that this is a binary search. The
+   *  index is extended when waypoints are added at the end and recomputed from the first waypoint that changed
+   *  otherwise. Use a DurationCursor to sample durations in increasing order.
    *  @param The duration from start.
    *  @param The waypoint index before the supplied duration.
    *  @param The waypoint index after (or equal to) the supplied duration.
@@ -313,6 +325,12 @@ public:
    */
   bool getStateAtDurationFromStart(const double request_duration, moveit::core::RobotStatePtr& output_state) const;
 
+  /** @brief Sample the trajectory every \e sample_duration from start, using linear time interpolation.
+   *  The samples, including one at the end of the trajectory, become the waypoints of \e resampled.
+   *  @return False if the trajectory is empty or \e sample_duration is not positive.
+   */
+  bool resample(double sample_duration, RobotTrajectory& resampled) const;
+
   class Iterator
   {
     std::deque<moveit::core::RobotStatePtr>::iterator waypoint_iterator_;
@@ -383,10 +401,64 @@ public:
   void print(std::ostream& out, std::vector<int> variable_indexes = std::vector<int>()) const;
 
 private:
+  /** \brief The durations from start of all waypoints, computed from the first invalid one if needed */
+  const std::vector<double>& getTimeFromStart() const;
+
+  /** \brief Find the waypoints around \e duration, given the \e index of the first waypoint reached at or after it
+      (the waypoint count if there is none) */
+  void getWayPointIndicesAt(std::size_t index, double duration, int& before, int& after, double& blend) const;
+
+  /** \brief Mark the durations from start of the waypoints from \e index on as invalid */
+  void invalidateTimeFromStart(std::size_t index)
+  {
+    time_from_start_.valid = std::min(time_from_start_.valid, index);
+  }
+
+  /** \brief Durations from start of the waypoints, of which the first \e valid entries are up to date. Copies start
+      out empty, so that copying a trajectory only copies its waypoints. */
+  struct TimeFromStart
+  {
+    TimeFromStart() = default;
+    TimeFromStart(const TimeFromStart& /*other*/)
+    {
+    }
+    TimeFromStart& operator=(const TimeFromStart& /*other*/)
+    {
+      valid = 0;
+      return *this;
+    }
+
+    std::vector<double> times;
+    std::size_t valid = 0;
+    std::mutex mutex;  // computing the durations from start is the only modification of a const trajectory
+  };
+
   moveit::core::RobotModelConstPtr robot_model_;
   const moveit::core::JointModelGroup* group_;
   std::deque<moveit::core::RobotStatePtr> waypoints_;
   std::deque<double> duration_from_previous_;
+  mutable TimeFromStart time_from_start_;
+};
+
+/** @brief Samples the states of a trajectory at a sequence of durations from start. If the durations increase, each
+ *  one is found in amortized constant time by searching forward from the previous one; otherwise the cursor falls back
+ *  to a binary search. The trajectory must outlive the cursor and not change while it is used. */
+class RobotTrajectory::DurationCursor
+{
+public:
+  explicit DurationCursor(const RobotTrajectory& trajectory) : trajectory_(trajectory)
+  {
+  }
+
+  /** @brief Same as RobotTrajectory::findWayPointIndicesForDurationAfterStart() */
+  void findWayPointIndicesForDurationAfterStart(double duration, int& before, int& after, double& blend);
+
+  /** @brief Same as RobotTrajectory::getStateAtDurationFromStart() */
+  bool getStateAtDurationFromStart(double duration, moveit::core::RobotStatePtr& output_state);
+
+private:
+  const RobotTrajectory& trajectory_;
+  std::size_t index_ = 0;  // the index found for the previous duration
 };
 
 /** @brief Operator overload for printing trajectory to a stream */
@@ -0,0 +1,69 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <trajectory_msgs/msg/joint_trajectory.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace robot_trajectory
+{
+/** \brief Options for encodeJointTrajectory() */
+struct TrajectoryEncodingOptions
+{
+  /** \brief Positions are rounded to multiples of this step (in rad or m). If 0, positions are stored losslessly. */
+  double position_resolution = 1e-6;
+
+  /** \brief Store velocities, accelerations and efforts as single instead of double precision floats */
+  bool single_precision_derivatives = true;
+};
+
+/** \brief Encode a joint trajectory into a compact byte array, e.g. to transport it in a uint8[] message field.
+ *
+ *  Joint names are stored once. Positions are quantized to \e options.position_resolution and stored as
+ *  variable-length differences to the previous waypoint, time_from_start is stored as variable-length
+ *  differences in nanoseconds. Velocities, accelerations and efforts are stored as contiguous arrays, if all
+ *  waypoints have them. The encoding does not depend on the byte order of the host.
+ *
+ *  Return false, leaving \e data empty, if the trajectory cannot be encoded: waypoints with a position count that
+ *  does not match the number of joints, velocities, accelerations or efforts that only some waypoints have,
+ *  or positions that are not finite.
+ */
+bool encodeJointTrajectory(const trajectory_msgs::msg::JointTrajectory& trajectory, std::vector<std::uint8_t>& data,
+                           const TrajectoryEncodingOptions& options = TrajectoryEncodingOptions());
+
+/** \brief Decode a joint trajectory written by encodeJointTrajectory(). Return false if \e data is malformed. */
+bool decodeJointTrajectory(const std::vector<std::uint8_t>& data, trajectory_msgs::msg::JointTrajectory& trajectory);
+}  // namespace robot_trajectory
@@ -0,0 +1,278 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <rclcpp/duration.hpp>
+#include <rclcpp/time.hpp>
+#include <tf2_eigen/tf2_eigen.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace robot_trajectory
+{
+namespace
+{
+moveit::core::RobotState getInitialReferenceState(const RobotTrajectory& trajectory)
+{
+  if (!trajectory.empty())
+    return trajectory.getFirstWayPoint();
+
+  moveit::core::RobotState state(trajectory.getRobotModel());
+  state.setToDefaultValues();
+  return state;
+}
+}  // namespace
+
+CompactRobotTrajectory::CompactRobotTrajectory(const moveit::core::RobotState& reference_state,
+                                               const moveit::core::JointModelGroup* group)
+  : reference_state_(reference_state), group_(group), has_velocities_(true), has_accelerations_(true)
+{
+  const moveit::core::RobotModel& robot_model = *reference_state_.getRobotModel();
+  if (group_)
+  {
+    variable_indices_ = group_->getVariableIndexList();
+  }
+  else
+  {
+    variable_indices_.resize(robot_model.getVariableCount());
+    std::iota(variable_indices_.begin(), variable_indices_.end(), 0);
+  }
+
+  // Map each active joint to the row of its first variable
+  const std::vector<const moveit::core::JointModel*>& joints =
+      group_ ? group_->getActiveJointModels() : robot_model.getActiveJointModels();
+  for (const moveit::core::JointModel* joint : joints)
+  {
+    auto it = std::find(variable_indices_.begin(), variable_indices_.end(), joint->getFirstVariableIndex());
+    if (it != variable_indices_.end())
+      active_joints_.emplace_back(joint, it - variable_indices_.begin());
+  }
+}
+
+CompactRobotTrajectory::CompactRobotTrajectory(const RobotTrajectory& trajectory)
+  : CompactRobotTrajectory(getInitialReferenceState(trajectory), trajectory.getGroup())
+{
+  reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+}
+
+double CompactRobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
+{
+  if (durations_.empty())
+    return 0.0;
+  index = std::min(index, durations_.size() - 1);
+  return std::accumulate(durations_.begin(), durations_.begin() + index + 1, 0.0);
+}
+
+double CompactRobotTrajectory::getDuration() const
+{
+  return std::accumulate(durations_.begin(), durations_.end(), 0.0);
+}
+
+void CompactRobotTrajectory::reserve(std::size_t waypoint_count)
+{
+  const std::size_t size = waypoint_count * getVariableCount();
+  positions_.reserve(size);
+  velocities_.reserve(size);
+  accelerations_.reserve(size);
+  durations_.reserve(waypoint_count);
+}
+
+CompactRobotTrajectory& CompactRobotTrajectory::addSuffixWayPoint(const moveit::core::RobotState& state, double dt)
+{
+  has_velocities_ = has_velocities_ && state.hasVelocities();
+  has_accelerations_ = has_accelerations_ && state.hasAccelerations();
+  for (int index : variable_indices_)
+  {
+    positions_.push_back(state.getVariablePosition(index));
+    velocities_.push_back(state.hasVelocities() ? state.getVariableVelocity(index) : 0.0);
+    accelerations_.push_back(state.hasAccelerations() ? state.getVariableAcceleration(index) : 0.0);
+  }
+  durations_.push_back(dt);
+  return *this;
+}
+
+CompactRobotTrajectory& CompactRobotTrajectory::clear()
+{
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  durations_.clear();
+  has_velocities_ = true;
+  has_accelerations_ = true;
+  return *this;
+}
+
+void CompactRobotTrajectory::getWayPoint(std::size_t index, moveit::core::RobotState& state) const
+{
+  const std::size_t offset = index * getVariableCount();
+  for (std::size_t j = 0; j < variable_indices_.size(); ++j)
+  {
+    state.setVariablePosition(variable_indices_[j], positions_[offset + j]);
+    if (hasVelocities())
+      state.setVariableVelocity(variable_indices_[j], velocities_[offset + j]);
+    if (hasAccelerations())
+      state.setVariableAcceleration(variable_indices_[j], accelerations_[offset + j]);
+  }
+}
+
+moveit::core::RobotStatePtr CompactRobotTrajectory::getWayPointPtr(std::size_t index) const
+{
+  auto state = std::make_shared<moveit::core::RobotState>(reference_state_);
+  getWayPoint(index, *state);
+  state->update();
+  return state;
+}
+
+void CompactRobotTrajectory::getRobotTrajectory(RobotTrajectory& trajectory) const
+{
+  trajectory = RobotTrajectory(getRobotModel(), group_);
+  for (std::size_t i = 0; i < getWayPointCount(); ++i)
+    trajectory.addSuffixWayPoint(getWayPointPtr(i), durations_[i]);
+}
+
+void CompactRobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::msg::RobotTrajectory& trajectory,
+                                                   const std::vector<std::string>& joint_filter) const
+{
+  trajectory = moveit_msgs::msg::RobotTrajectory();
+  if (empty())
+    return;
+
+  std::vector<std::pair<const moveit::core::JointModel*, std::size_t>> onedof;
+  std::vector<std::pair<const moveit::core::JointModel*, std::size_t>> mdof;
+  for (const auto& [joint, row] : active_joints_)
+  {
+    // only consider joints listed in joint_filter
+    if (!joint_filter.empty() &&
+        std::find(joint_filter.begin(), joint_filter.end(), joint->getName()) == joint_filter.end())
+      continue;
+
+    if (joint->getVariableCount() == 1)
+    {
+      trajectory.joint_trajectory.joint_names.push_back(joint->getName());
+      onedof.emplace_back(joint, row);
+    }
+    else
+    {
+      trajectory.multi_dof_joint_trajectory.joint_names.push_back(joint->getName());
+      mdof.emplace_back(joint, row);
+    }
+  }
+
+  const std::string& model_frame = getRobotModel()->getModelFrame();
+  const std::size_t num_points = getWayPointCount();
+  if (!onedof.empty())
+  {
+    trajectory.joint_trajectory.header.frame_id = model_frame;
+    trajectory.joint_trajectory.header.stamp = rclcpp::Time(0, 0, RCL_ROS_TIME);
+    trajectory.joint_trajectory.points.resize(num_points);
+  }
+  if (!mdof.empty())
+  {
+    trajectory.multi_dof_joint_trajectory.header.frame_id = model_frame;
+    trajectory.multi_dof_joint_trajectory.header.stamp = rclcpp::Time(0, 0, RCL_ROS_TIME);
+    trajectory.multi_dof_joint_trajectory.points.resize(num_points);
+  }
+
+  double total_time = 0.0;
+  Eigen::Isometry3d transform;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    total_time += durations_[i];
+    const auto time_from_start = rclcpp::Duration::from_seconds(total_time);
+    const std::size_t offset = i * getVariableCount();
+
+    if (!onedof.empty())
+    {
+      trajectory_msgs::msg::JointTrajectoryPoint& point = trajectory.joint_trajectory.points[i];
+      point.positions.resize(onedof.size());
+      if (hasVelocities())
+        point.velocities.resize(onedof.size());
+      if (hasAccelerations())
+        point.accelerations.resize(onedof.size());
+      for (std::size_t j = 0; j < onedof.size(); ++j)
+      {
+        const std::size_t k = offset + onedof[j].second;
+        point.positions[j] = positions_[k];
+        if (hasVelocities())
+          point.velocities[j] = velocities_[k];
+        if (hasAccelerations())
+          point.accelerations[j] = accelerations_[k];
+      }
+      point.time_from_start = time_from_start;
+    }
+
+    if (!mdof.empty())
+    {
+      trajectory_msgs::msg::MultiDOFJointTrajectoryPoint& point = trajectory.multi_dof_joint_trajectory.points[i];
+      point.transforms.resize(mdof.size());
+      for (std::size_t j = 0; j < mdof.size(); ++j)
+      {
+        const moveit::core::JointModel* joint = mdof[j].first;
+        const std::size_t k = offset + mdof[j].second;
+        joint->computeTransform(&positions_[k], transform);
+        point.transforms[j] = tf2::eigenToTransform(transform).transform;
+        // TODO: currently only checking for planar multi DOF joints / need to add check for floating
+        if (hasVelocities() && (joint->getType() == moveit::core::JointModel::JointType::PLANAR))
+        {
+          const std::vector<std::string>& names = joint->getVariableNames();
+          geometry_msgs::msg::Twist point_velocity;
+          for (std::size_t v = 0; v < names.size(); ++v)
+          {
+            if (names[v].find("/x") != std::string::npos)
+            {
+              point_velocity.linear.x = velocities_[k + v];
+            }
+            else if (names[v].find("/y") != std::string::npos)
+            {
+              point_velocity.linear.y = velocities_[k + v];
+            }
+            else if (names[v].find("/z") != std::string::npos)
+            {
+              point_velocity.linear.z = velocities_[k + v];
+            }
+            else if (names[v].find("/theta") != std::string::npos)
+            {
+              point_velocity.angular.z = velocities_[k + v];
+            }
+          }
+          point.velocities.push_back(point_velocity);
+        }
+      }
+      point.time_from_start = time_from_start;
+    }
+  }
+}
+}  // namespace robot_trajectory
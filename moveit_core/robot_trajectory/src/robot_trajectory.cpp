@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan, Adam Leeper */
 
 #include <math.h>
+#include <algorithm>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/robot_state/conversions.h>
 #include <rclcpp/duration.hpp>
@@ -86,7 +87,29 @@ const std::string& RobotTrajectory::getGroupName() const
 
 double RobotTrajectory::getDuration() const
 {
-  return std::accumulate(duration_from_previous_.begin(), duration_from_previous_.end(), 0.0);
+  if (duration_from_previous_.empty())
+    return 0.0;
+  return getTimeFromStart().back();
+}
+
+const std::vector<double>& RobotTrajectory::getTimeFromStart() const
+{
+  // once the index is complete, concurrent readers find it valid and no longer modify it
+  std::scoped_lock lock(time_from_start_.mutex);
+  std::vector<double>& times = time_from_start_.times;
+  const std::size_t count = duration_from_previous_.size();
+  if (time_from_start_.valid < count || times.size() != count)
+  {
+    times.resize(count);
+    double time = time_from_start_.valid > 0 ? times[time_from_start_.valid - 1] : 0.0;
+    for (std::size_t i = time_from_start_.valid; i < count; ++i)
+    {
+      time += duration_from_previous_[i];
+      times[i] = time;
+    }
+  }
+  time_from_start_.valid = count;
+  return times;
 }
 
 double RobotTrajectory::getAverageSegmentDuration() const
@@ -118,6 +141,8 @@ void RobotTrajectory::swap(RobotTrajectory& other)
   std::swap(group_, other.group_);
   waypoints_.swap(other.waypoints_);
   duration_from_previous_.swap(other.duration_from_previous_);
+  invalidateTimeFromStart(0);
+  other.invalidateTimeFromStart(0);
 }
 
 RobotTrajectory& RobotTrajectory::append(const RobotTrajectory& source, double dt, size_t start_index, size_t end_index)
@@ -133,6 +158,7 @@ RobotTrajectory& RobotTrajectory::append(const RobotTrajectory& source, double d
                                  std::next(source.duration_from_previous_.begin(), end_index));
   if (duration_from_previous_.size() > index)
     duration_from_previous_[index] = dt;
+  invalidateTimeFromStart(index);
 
   return *this;
 }
@@ -150,6 +176,7 @@ RobotTrajectory& RobotTrajectory::reverse()
     duration_from_previous_.push_back(duration_from_previous_.front());
     std::reverse(duration_from_previous_.begin(), duration_from_previous_.end());
     duration_from_previous_.pop_back();
+    invalidateTimeFromStart(0);
   }
 
   return *this;
@@ -501,26 +528,41 @@ void RobotTrajectory::findWayPointIndicesForDurationAfterStart(const double& dur
     return;
   }
 
-  // Find indices
-  std::size_t index = 0, num_points = waypoints_.size();
-  double running_duration = 0.0;
-  for (; index < num_points; ++index)
+  const std::vector<double>& times = getTimeFromStart();
+  getWayPointIndicesAt(std::lower_bound(times.begin(), times.end(), duration) - times.begin(), duration, before, after,
+                       blend);
+}
+
+void RobotTrajectory::getWayPointIndicesAt(std::size_t index, double duration, int& before, int& after,
+                                           double& blend) const
+{
+  const std::size_t num_points = waypoints_.size();
+  if (num_points == 0)
   {
-    running_duration += duration_from_previous_[index];
-    if (running_duration >= duration)
-      break;
+    before = 0;
+    after = 0;
+    blend = 0;
+    return;
+  }
+  // past the end, the last waypoint is used
+  if (index >= num_points)
+  {
+    before = num_points - 1;
+    after = num_points - 1;
+    blend = 1.0;
+    return;
   }
-  before = std::max<int>(index - 1, 0);
-  after = std::min<int>(index, num_points - 1);
+  before = std::max<int>(static_cast<int>(index) - 1, 0);
+  after = index;
 
   // Compute duration blend
-  double before_time = running_duration - duration_from_previous_[index];
   if (after == before)
   {
     blend = 1.0;
   }
   else
   {
+    const double before_time = time_from_start_.times[index] - duration_from_previous_[index];
     blend = (duration - before_time) / duration_from_previous_[index];
   }
 }
@@ -531,11 +573,7 @@ double RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
     return 0.0;
   if (index >= duration_from_previous_.size())
     index = duration_from_previous_.size() - 1;
-
-  double time = 0.0;
-  for (std::size_t i = 0; i <= index; ++i)
-    time += duration_from_previous_[i];
-  return time;
+  return getTimeFromStart()[index];
 }
 
 double RobotTrajectory::getWaypointDurationFromStart(std::size_t index) const
@@ -559,6 +597,67 @@ bool RobotTrajectory::getStateAtDurationFromStart(const double request_duration,
   return true;
 }
 
+bool RobotTrajectory::resample(double sample_duration, RobotTrajectory& resampled) const
+{
+  if (empty() || sample_duration <= 0.0)
+    return false;
+
+  const double duration = getDuration();
+  const std::size_t sample_count = static_cast<std::size_t>(std::ceil(duration / sample_duration)) + 1;
+  RobotTrajectory samples(robot_model_, group_);
+  DurationCursor cursor(*this);
+  double previous_time = 0.0;
+  for (std::size_t i = 0; i < sample_count; ++i)
+  {
+    const double time = std::min(static_cast<double>(i) * sample_duration, duration);
+    auto state = std::make_shared<moveit::core::RobotState>(*waypoints_.front());
+    cursor.getStateAtDurationFromStart(time, state);
+    samples.addSuffixWayPoint(state, time - previous_time);
+    previous_time = time;
+  }
+  resampled.swap(samples);
+  return true;
+}
+
+void RobotTrajectory::DurationCursor::findWayPointIndicesForDurationAfterStart(double duration, int& before,
+                                                                               int& after, double& blend)
+{
+  if (duration < 0.0)
+  {
+    before = 0;
+    after = 0;
+    blend = 0;
+    return;
+  }
+
+  const std::vector<double>& times = trajectory_.getTimeFromStart();
+  index_ = std::min(index_, times.size());
+  if (index_ > 0 && times[index_ - 1] >= duration)
+  {
+    // going backwards
+    index_ = std::lower_bound(times.begin(), times.begin() + index_, duration) - times.begin();
+  }
+  else
+  {
+    while (index_ < times.size() && times[index_] < duration)
+      ++index_;
+  }
+  trajectory_.getWayPointIndicesAt(index_, duration, before, after, blend);
+}
+
+bool RobotTrajectory::DurationCursor::getStateAtDurationFromStart(double duration,
+                                                                  moveit::core::RobotStatePtr& output_state)
+{
+  if (trajectory_.empty())
+    return false;
+
+  int before = 0, after = 0;
+  double blend = 1.0;
+  findWayPointIndicesForDurationAfterStart(duration, before, after, blend);
+  trajectory_.waypoints_[before]->interpolate(*trajectory_.waypoints_[after], blend, *output_state);
+  return true;
+}
+
 void RobotTrajectory::print(std::ostream& out, std::vector<int> variable_indexes) const
 {
   size_t num_points = getWayPointCount();
@@ -0,0 +1,453 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/trajectory_encoding.h>
+#include <rclcpp/logging.hpp>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace robot_trajectory
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_robot_trajectory.trajectory_encoding");
+
+namespace
+{
+constexpr char MAGIC[] = { 'M', 'V', 'J', 'T' };
+constexpr std::uint8_t VERSION = 1;
+
+enum Flags : std::uint8_t
+{
+  HAS_VELOCITIES = 1 << 0,
+  HAS_ACCELERATIONS = 1 << 1,
+  HAS_EFFORTS = 1 << 2,
+  QUANTIZED_POSITIONS = 1 << 3,
+  SINGLE_PRECISION = 1 << 4
+};
+
+// Positions are quantized to integers of at most this magnitude, so differences cannot overflow int64
+constexpr double MAX_QUANTIZED = 4.0e18;
+
+template <typename T>
+using UnsignedOfSize =
+    std::conditional_t<sizeof(T) == 1, std::uint8_t,
+                       std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                                          std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+// Add without undefined behavior on overflow, corrupt data may contain arbitrary values
+std::int64_t wrappingAdd(std::int64_t a, std::int64_t b)
+{
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(a) + static_cast<std::uint64_t>(b));
+}
+
+class Writer
+{
+public:
+  explicit Writer(std::vector<std::uint8_t>& data) : data_(data)
+  {
+  }
+
+  void writeBytes(const void* bytes, std::size_t count)
+  {
+    const auto* begin = static_cast<const std::uint8_t*>(bytes);
+    data_.insert(data_.end(), begin, begin + count);
+  }
+
+  template <typename T>
+  void writeFixed(T value)
+  {
+    // little endian, independent of the host
+    UnsignedOfSize<T> bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+      data_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+  }
+
+  void writeVarint(std::uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      data_.push_back(static_cast<std::uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    data_.push_back(static_cast<std::uint8_t>(value));
+  }
+
+  void writeSignedVarint(std::int64_t value)
+  {
+    // zigzag encoding keeps small negative values short
+    writeVarint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+
+  void writeString(const std::string& value)
+  {
+    writeVarint(value.size());
+    writeBytes(value.data(), value.size());
+  }
+
+  void writeValue(double value, bool single_precision)
+  {
+    if (single_precision)
+      writeFixed(static_cast<float>(value));
+    else
+      writeFixed(value);
+  }
+
+private:
+  std::vector<std::uint8_t>& data_;
+};
+
+class Reader
+{
+public:
+  explicit Reader(const std::vector<std::uint8_t>& data) : data_(data), pos_(0)
+  {
+  }
+
+  bool readBytes(void* bytes, std::size_t count)
+  {
+    if (count > data_.size() - pos_)
+      return false;
+    if (count > 0)
+      std::memcpy(bytes, data_.data() + pos_, count);
+    pos_ += count;
+    return true;
+  }
+
+  template <typename T>
+  bool readFixed(T& value)
+  {
+    if (sizeof(T) > data_.size() - pos_)
+      return false;
+    UnsignedOfSize<T> bits = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+      bits |= static_cast<UnsignedOfSize<T>>(static_cast<UnsignedOfSize<T>>(data_[pos_++]) << (8 * i));
+    std::memcpy(&value, &bits, sizeof(T));
+    return true;
+  }
+
+  bool readVarint(std::uint64_t& value)
+  {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+      if (pos_ >= data_.size())
+        return false;
+      const std::uint8_t byte = data_[pos_++];
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool readSignedVarint(std::int64_t& value)
+  {
+    std::uint64_t encoded;
+    if (!readVarint(encoded))
+      return false;
+    value = static_cast<std::int64_t>(encoded >> 1) ^ -static_cast<std::int64_t>(encoded & 1);
+    return true;
+  }
+
+  // Read a count of items that take at least one byte each, rejecting counts the remaining data cannot hold
+  bool readCount(std::size_t& count)
+  {
+    std::uint64_t value;
+    if (!readVarint(value) || value > data_.size() - pos_)
+      return false;
+    count = static_cast<std::size_t>(value);
+    return true;
+  }
+
+  bool readString(std::string& value)
+  {
+    std::size_t size;
+    if (!readCount(size))
+      return false;
+    value.assign(reinterpret_cast<const char*>(data_.data() + pos_), size);
+    pos_ += size;
+    return true;
+  }
+
+  bool readValue(double& value, bool single_precision)
+  {
+    if (!single_precision)
+      return readFixed(value);
+    float single;
+    if (!readFixed(single))
+      return false;
+    value = single;
+    return true;
+  }
+
+  bool atEnd() const
+  {
+    return pos_ == data_.size();
+  }
+
+private:
+  const std::vector<std::uint8_t>& data_;
+  std::size_t pos_;
+};
+
+using PointField = std::vector<double> trajectory_msgs::msg::JointTrajectoryPoint::*;
+
+// Return false if only some of the points have the field
+bool hasField(const trajectory_msgs::msg::JointTrajectory& trajectory, PointField field, bool& present)
+{
+  const std::size_t joint_count = trajectory.joint_names.size();
+  std::size_t count = 0;
+  for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+  {
+    const std::vector<double>& values = point.*field;
+    if (values.size() == joint_count && joint_count > 0)
+      ++count;
+    else if (!values.empty())
+      return false;
+  }
+  present = count > 0 && count == trajectory.points.size();
+  return count == 0 || present;
+}
+
+std::int64_t toNanoseconds(const builtin_interfaces::msg::Duration& duration)
+{
+  return static_cast<std::int64_t>(duration.sec) * 1000000000 + duration.nanosec;
+}
+
+bool fromNanoseconds(std::int64_t nanoseconds, builtin_interfaces::msg::Duration& duration)
+{
+  std::int64_t sec = nanoseconds / 1000000000;
+  std::int64_t nanosec = nanoseconds % 1000000000;
+  if (nanosec < 0)
+  {
+    nanosec += 1000000000;
+    --sec;
+  }
+  if (sec < std::numeric_limits<std::int32_t>::min() || sec > std::numeric_limits<std::int32_t>::max())
+    return false;
+  duration.sec = static_cast<std::int32_t>(sec);
+  duration.nanosec = static_cast<std::uint32_t>(nanosec);
+  return true;
+}
+}  // namespace
+
+bool encodeJointTrajectory(const trajectory_msgs::msg::JointTrajectory& trajectory, std::vector<std::uint8_t>& data,
+                           const TrajectoryEncodingOptions& options)
+{
+  data.clear();
+  const std::size_t joint_count = trajectory.joint_names.size();
+  const bool quantized = options.position_resolution > 0.0;
+
+  bool velocities, accelerations, efforts;
+  if (!hasField(trajectory, &trajectory_msgs::msg::JointTrajectoryPoint::velocities, velocities) ||
+      !hasField(trajectory, &trajectory_msgs::msg::JointTrajectoryPoint::accelerations, accelerations) ||
+      !hasField(trajectory, &trajectory_msgs::msg::JointTrajectoryPoint::effort, efforts))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot encode a trajectory in which only some waypoints have velocities, accelerations or "
+                         "efforts");
+    return false;
+  }
+  for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+  {
+    if (point.positions.size() != joint_count)
+    {
+      RCLCPP_ERROR(LOGGER, "Cannot encode a waypoint with %zu positions for %zu joints", point.positions.size(),
+                   joint_count);
+      return false;
+    }
+    for (double position : point.positions)
+    {
+      if (!std::isfinite(position) || (quantized && std::abs(position / options.position_resolution) > MAX_QUANTIZED))
+      {
+        RCLCPP_ERROR(LOGGER, "Cannot encode position %g with resolution %g", position, options.position_resolution);
+        return false;
+      }
+    }
+  }
+
+  std::uint8_t flags = 0;
+  if (velocities)
+    flags |= HAS_VELOCITIES;
+  if (accelerations)
+    flags |= HAS_ACCELERATIONS;
+  if (efforts)
+    flags |= HAS_EFFORTS;
+  if (quantized)
+    flags |= QUANTIZED_POSITIONS;
+  if (options.single_precision_derivatives)
+    flags |= SINGLE_PRECISION;
+
+  Writer writer(data);
+  writer.writeBytes(MAGIC, sizeof(MAGIC));
+  writer.writeFixed(VERSION);
+  writer.writeFixed(flags);
+  writer.writeString(trajectory.header.frame_id);
+  writer.writeFixed(trajectory.header.stamp.sec);
+  writer.writeFixed(trajectory.header.stamp.nanosec);
+  writer.writeVarint(joint_count);
+  for (const std::string& name : trajectory.joint_names)
+    writer.writeString(name);
+  writer.writeVarint(trajectory.points.size());
+  if (quantized)
+    writer.writeFixed(options.position_resolution);
+
+  std::int64_t previous_time = 0;
+  for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+  {
+    const std::int64_t time = toNanoseconds(point.time_from_start);
+    writer.writeSignedVarint(time - previous_time);
+    previous_time = time;
+  }
+
+  if (quantized)
+  {
+    std::vector<std::int64_t> previous(joint_count, 0);
+    for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+    {
+      for (std::size_t j = 0; j < joint_count; ++j)
+      {
+        const std::int64_t value = std::llround(point.positions[j] / options.position_resolution);
+        writer.writeSignedVarint(value - previous[j]);
+        previous[j] = value;
+      }
+    }
+  }
+  else
+  {
+    for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+      for (double position : point.positions)
+        writer.writeFixed(position);
+  }
+
+  for (PointField field : { &trajectory_msgs::msg::JointTrajectoryPoint::velocities,
+                            &trajectory_msgs::msg::JointTrajectoryPoint::accelerations,
+                            &trajectory_msgs::msg::JointTrajectoryPoint::effort })
+  {
+    if (trajectory.points.empty() || (trajectory.points.front().*field).empty())
+      continue;
+    for (const trajectory_msgs::msg::JointTrajectoryPoint& point : trajectory.points)
+      for (double value : point.*field)
+        writer.writeValue(value, options.single_precision_derivatives);
+  }
+  return true;
+}
+
+bool decodeJointTrajectory(const std::vector<std::uint8_t>& data, trajectory_msgs::msg::JointTrajectory& trajectory)
+{
+  Reader reader(data);
+  char magic[sizeof(MAGIC)];
+  std::uint8_t version, flags;
+  if (!reader.readBytes(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !reader.readFixed(version) || version != VERSION || !reader.readFixed(flags))
+  {
+    RCLCPP_ERROR(LOGGER, "Data is not an encoded joint trajectory of a supported version");
+    return false;
+  }
+
+  trajectory_msgs::msg::JointTrajectory result;
+  std::size_t joint_count, point_count;
+  bool ok = reader.readString(result.header.frame_id) && reader.readFixed(result.header.stamp.sec) &&
+            reader.readFixed(result.header.stamp.nanosec) && reader.readCount(joint_count);
+  for (std::size_t j = 0; ok && j < joint_count; ++j)
+  {
+    result.joint_names.emplace_back();
+    ok = reader.readString(result.joint_names.back());
+  }
+  ok = ok && reader.readCount(point_count);
+
+  const bool quantized = flags & QUANTIZED_POSITIONS;
+  const bool single_precision = flags & SINGLE_PRECISION;
+  double resolution = 0.0;
+  ok = ok && (!quantized || (reader.readFixed(resolution) && resolution > 0.0));
+
+  if (ok)
+    result.points.resize(point_count);
+  std::int64_t time = 0;
+  for (std::size_t i = 0; ok && i < point_count; ++i)
+  {
+    std::int64_t delta;
+    ok = reader.readSignedVarint(delta);
+    time = wrappingAdd(time, delta);
+    ok = ok && fromNanoseconds(time, result.points[i].time_from_start);
+  }
+
+  std::vector<std::int64_t> previous(joint_count, 0);
+  for (std::size_t i = 0; ok && i < point_count; ++i)
+  {
+    std::vector<double>& positions = result.points[i].positions;
+    positions.resize(joint_count);
+    for (std::size_t j = 0; ok && j < joint_count; ++j)
+    {
+      if (quantized)
+      {
+        std::int64_t delta;
+        ok = reader.readSignedVarint(delta);
+        previous[j] = wrappingAdd(previous[j], delta);
+        positions[j] = previous[j] * resolution;
+      }
+      else
+        ok = reader.readFixed(positions[j]);
+    }
+  }
+
+  const std::pair<PointField, std::uint8_t> fields[] = {
+    { &trajectory_msgs::msg::JointTrajectoryPoint::velocities, HAS_VELOCITIES },
+    { &trajectory_msgs::msg::JointTrajectoryPoint::accelerations, HAS_ACCELERATIONS },
+    { &trajectory_msgs::msg::JointTrajectoryPoint::effort, HAS_EFFORTS },
+  };
+  for (const auto& [field, flag] : fields)
+  {
+    if (!(flags & flag))
+      continue;
+    for (std::size_t i = 0; ok && i < point_count; ++i)
+    {
+      std::vector<double>& values = result.points[i].*field;
+      values.resize(joint_count);
+      for (std::size_t j = 0; ok && j < joint_count; ++j)
+        ok = reader.readValue(values[j], single_precision);
+    }
+  }
+
+  if (!ok || !reader.atEnd())
+  {
+    RCLCPP_ERROR(LOGGER, "Encoded joint trajectory is truncated or corrupt");
+    return false;
+  }
+  trajectory = std::move(result);
+  return true;
+}
+}  // namespace robot_trajectory
@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+class CompactRobotTrajectoryTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    group_ = robot_model_->getJointModelGroup("panda_arm");
+    ASSERT_TRUE(group_);
+
+    trajectory_ = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, group_);
+    moveit::core::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    state.zeroVelocities();
+    state.zeroAccelerations();
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+      std::vector<double> positions(group_->getVariableCount(), 0.1 * i);
+      std::vector<double> velocities(group_->getVariableCount(), 0.01 * i);
+      state.setJointGroupPositions(group_, positions);
+      state.setJointGroupVelocities(group_, velocities);
+      trajectory_->addSuffixWayPoint(state, i == 0 ? 0.0 : 0.1);
+    }
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  const moveit::core::JointModelGroup* group_;
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+};
+
+TEST_F(CompactRobotTrajectoryTest, ConvertFromRobotTrajectory)
+{
+  robot_trajectory::CompactRobotTrajectory compact(*trajectory_);
+  ASSERT_EQ(compact.getWayPointCount(), trajectory_->getWayPointCount());
+  EXPECT_EQ(compact.getVariableCount(), group_->getVariableCount());
+  EXPECT_TRUE(compact.hasVelocities());
+  EXPECT_TRUE(compact.hasAccelerations());
+  EXPECT_DOUBLE_EQ(compact.getDuration(), trajectory_->getDuration());
+  EXPECT_DOUBLE_EQ(compact.getWayPointDurationFromStart(4), trajectory_->getWayPointDurationFromStart(4));
+
+  const auto& positions = compact.getPositions();
+  for (std::size_t i = 0; i < compact.getWayPointCount(); ++i)
+  {
+    std::vector<double> expected;
+    trajectory_->getWayPoint(i).copyJointGroupPositions(group_, expected);
+    for (std::size_t j = 0; j < expected.size(); ++j)
+      EXPECT_DOUBLE_EQ(positions(j, i), expected[j]);
+  }
+}
+
+TEST_F(CompactRobotTrajectoryTest, MaterializeWayPoints)
+{
+  robot_trajectory::CompactRobotTrajectory compact(*trajectory_);
+  moveit::core::RobotStatePtr state = compact.getWayPointPtr(5);
+  const moveit::core::RobotState& expected = trajectory_->getWayPoint(5);
+  for (std::size_t i = 0; i < robot_model_->getVariableCount(); ++i)
+  {
+    EXPECT_DOUBLE_EQ(state->getVariablePosition(i), expected.getVariablePosition(i));
+    EXPECT_DOUBLE_EQ(state->getVariableVelocity(i), expected.getVariableVelocity(i));
+  }
+  EXPECT_TRUE(state->getGlobalLinkTransform("panda_link8").isApprox(expected.getGlobalLinkTransform("panda_link8")));
+
+  robot_trajectory::RobotTrajectory materialized(robot_model_);
+  compact.getRobotTrajectory(materialized);
+  EXPECT_EQ(materialized.getGroup(), group_);
+  ASSERT_EQ(materialized.getWayPointCount(), trajectory_->getWayPointCount());
+  EXPECT_DOUBLE_EQ(materialized.getDuration(), trajectory_->getDuration());
+}
+
+TEST_F(CompactRobotTrajectoryTest, RobotTrajectoryMsg)
+{
+  robot_trajectory::CompactRobotTrajectory compact(*trajectory_);
+  moveit_msgs::msg::RobotTrajectory expected;
+  trajectory_->getRobotTrajectoryMsg(expected);
+  moveit_msgs::msg::RobotTrajectory msg;
+  compact.getRobotTrajectoryMsg(msg);
+  EXPECT_EQ(msg, expected);
+
+  const std::vector<std::string> joint_filter{ "panda_joint2", "panda_joint4" };
+  trajectory_->getRobotTrajectoryMsg(expected, joint_filter);
+  compact.getRobotTrajectoryMsg(msg, joint_filter);
+  EXPECT_EQ(msg, expected);
+}
+
+TEST_F(CompactRobotTrajectoryTest, MissingVelocities)
+{
+  robot_trajectory::CompactRobotTrajectory compact(trajectory_->getFirstWayPoint(), group_);
+  compact.addSuffixWayPoint(trajectory_->getWayPoint(0), 0.0);
+  moveit::core::RobotState state(robot_model_);
+  state.setToDefaultValues();
+  compact.addSuffixWayPoint(state, 0.1);
+  EXPECT_FALSE(compact.hasVelocities());
+
+  moveit_msgs::msg::RobotTrajectory msg;
+  compact.getRobotTrajectoryMsg(msg);
+  ASSERT_EQ(msg.joint_trajectory.points.size(), 2u);
+  EXPECT_TRUE(msg.joint_trajectory.points[0].velocities.empty());
+
+  compact.clear();
+  EXPECT_TRUE(compact.empty());
+  EXPECT_FALSE(compact.hasVelocities());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
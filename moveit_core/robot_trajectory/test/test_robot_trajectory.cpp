@@ -559,6 +559,85 @@ TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryDensity)
   EXPECT_FALSE(robot_trajectory::waypoint_density(*trajectory).has_value());
 }
 
+TEST_F(RobotTrajectoryTestFixture, DurationFromStartIndex)
+{
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+  initTestTrajectory(trajectory);
+  const auto expect_durations_from_start = [&trajectory]() {
+    double time = 0.0;
+    for (std::size_t i = 0; i < trajectory->size(); ++i)
+    {
+      time += trajectory->getWayPointDurationFromPrevious(i);
+      EXPECT_EQ(trajectory->getWayPointDurationFromStart(i), time);
+    }
+    EXPECT_EQ(trajectory->getDuration(), time);
+  };
+  expect_durations_from_start();
+
+  // every kind of edit updates the index
+  trajectory->addSuffixWayPoint(*robot_state_, 0.2);
+  expect_durations_from_start();
+  trajectory->insertWayPoint(2, *robot_state_, 0.05);
+  expect_durations_from_start();
+  trajectory->setWayPointDurationFromPrevious(1, 0.3);
+  expect_durations_from_start();
+  trajectory->addPrefixWayPoint(*robot_state_, 0.0);
+  expect_durations_from_start();
+  trajectory->reverse();
+  expect_durations_from_start();
+  robot_trajectory::RobotTrajectory other(*trajectory);
+  trajectory->append(other, 0.4);
+  expect_durations_from_start();
+
+  int before, after;
+  double blend;
+  trajectory->findWayPointIndicesForDurationAfterStart(trajectory->getWayPointDurationFromStart(3), before, after,
+                                                       blend);
+  EXPECT_EQ(before, 2);
+  EXPECT_EQ(after, 3);
+  EXPECT_DOUBLE_EQ(blend, 1.0);
+  trajectory->findWayPointIndicesForDurationAfterStart(trajectory->getDuration() + 1.0, before, after, blend);
+  EXPECT_EQ(before, static_cast<int>(trajectory->size()) - 1);
+  EXPECT_EQ(after, static_cast<int>(trajectory->size()) - 1);
+
+  // the cursor finds the same waypoints for increasing and decreasing durations
+  robot_trajectory::RobotTrajectory::DurationCursor cursor(*trajectory);
+  const double duration = trajectory->getDuration();
+  for (double time : { 0.0, 0.01, 0.3, 0.3, 0.75, 1.2, duration, duration + 0.5, 0.6, 0.0, 1.0 })
+  {
+    int cursor_before, cursor_after;
+    double cursor_blend;
+    cursor.findWayPointIndicesForDurationAfterStart(time, cursor_before, cursor_after, cursor_blend);
+    trajectory->findWayPointIndicesForDurationAfterStart(time, before, after, blend);
+    EXPECT_EQ(cursor_before, before) << time;
+    EXPECT_EQ(cursor_after, after) << time;
+    EXPECT_EQ(cursor_blend, blend) << time;
+  }
+}
+
+TEST_F(RobotTrajectoryTestFixture, Resample)
+{
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+  initTestTrajectory(trajectory);
+  std::vector<double> positions;
+  trajectory->getWayPointPtr(4)->copyJointGroupPositions(arm_jmg_name_, positions);
+  positions[0] += 0.5;
+  trajectory->getWayPointPtr(4)->setJointGroupPositions(arm_jmg_name_, positions);
+
+  robot_trajectory::RobotTrajectory resampled(robot_model_, arm_jmg_name_);
+  EXPECT_FALSE(trajectory->resample(0.0, resampled));
+  ASSERT_TRUE(trajectory->resample(0.04, resampled));
+  // 0.5 seconds every 0.04 seconds and the end
+  ASSERT_EQ(resampled.size(), 14u);
+  EXPECT_NEAR(resampled.getDuration(), trajectory->getDuration(), 1e-12);
+  auto state = std::make_shared<moveit::core::RobotState>(*robot_state_);
+  for (std::size_t i = 0; i < resampled.size(); ++i)
+  {
+    trajectory->getStateAtDurationFromStart(resampled.getWayPointDurationFromStart(i), state);
+    EXPECT_NEAR(resampled.getWayPoint(i).distance(*state), 0.0, 1e-9) << i;
+  }
+}
+
 TEST_F(OneRobot, Unwind)
 {
   const double epsilon = 1e-4;
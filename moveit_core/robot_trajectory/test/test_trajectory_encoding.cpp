@@ -0,0 +1,178 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/trajectory_encoding.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace
+{
+trajectory_msgs::msg::JointTrajectory makeTrajectory(std::size_t joint_count, std::size_t point_count)
+{
+  trajectory_msgs::msg::JointTrajectory trajectory;
+  trajectory.header.frame_id = "world";
+  trajectory.header.stamp.sec = 42;
+  trajectory.header.stamp.nanosec = 7;
+  for (std::size_t j = 0; j < joint_count; ++j)
+    trajectory.joint_names.push_back("axis_" + std::to_string(j));
+  for (std::size_t i = 0; i < point_count; ++i)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    for (std::size_t j = 0; j < joint_count; ++j)
+    {
+      const double t = 0.01 * i;
+      point.positions.push_back(std::sin(t + j) * (j + 1));
+      point.velocities.push_back(std::cos(t + j) * (j + 1));
+      point.accelerations.push_back(-std::sin(t + j) * (j + 1));
+    }
+    point.time_from_start.sec = static_cast<int32_t>(i / 100);
+    point.time_from_start.nanosec = static_cast<uint32_t>((i % 100) * 10000000);
+    trajectory.points.push_back(point);
+  }
+  return trajectory;
+}
+}  // namespace
+
+TEST(TrajectoryEncoding, QuantizedRoundTrip)
+{
+  const trajectory_msgs::msg::JointTrajectory trajectory = makeTrajectory(12, 500);
+  robot_trajectory::TrajectoryEncodingOptions options;
+  options.position_resolution = 1e-5;
+
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(robot_trajectory::encodeJointTrajectory(trajectory, data, options));
+  // the uncompressed positions, velocities and accelerations alone take 3 * 8 bytes per value
+  EXPECT_LT(data.size(), 12 * 500 * 3 * 8 / 2);
+
+  trajectory_msgs::msg::JointTrajectory decoded;
+  ASSERT_TRUE(robot_trajectory::decodeJointTrajectory(data, decoded));
+  EXPECT_EQ(decoded.header.frame_id, "world");
+  EXPECT_EQ(decoded.header.stamp.sec, 42);
+  EXPECT_EQ(decoded.header.stamp.nanosec, 7u);
+  EXPECT_EQ(decoded.joint_names, trajectory.joint_names);
+  ASSERT_EQ(decoded.points.size(), trajectory.points.size());
+  for (std::size_t i = 0; i < trajectory.points.size(); ++i)
+  {
+    const auto& expected = trajectory.points[i];
+    const auto& actual = decoded.points[i];
+    EXPECT_EQ(actual.time_from_start.sec, expected.time_from_start.sec);
+    EXPECT_EQ(actual.time_from_start.nanosec, expected.time_from_start.nanosec);
+    ASSERT_EQ(actual.positions.size(), 12u);
+    ASSERT_EQ(actual.velocities.size(), 12u);
+    ASSERT_EQ(actual.accelerations.size(), 12u);
+    EXPECT_TRUE(actual.effort.empty());
+    for (std::size_t j = 0; j < 12; ++j)
+    {
+      EXPECT_NEAR(actual.positions[j], expected.positions[j], 0.5 * options.position_resolution);
+      EXPECT_NEAR(actual.velocities[j], expected.velocities[j], 1e-6 * (j + 1));
+      EXPECT_NEAR(actual.accelerations[j], expected.accelerations[j], 1e-6 * (j + 1));
+    }
+  }
+}
+
+TEST(TrajectoryEncoding, LosslessRoundTrip)
+{
+  trajectory_msgs::msg::JointTrajectory trajectory = makeTrajectory(3, 20);
+  for (auto& point : trajectory.points)
+    point.effort = { 1.0 / 3.0, -2.5, 1e-12 };
+  robot_trajectory::TrajectoryEncodingOptions options;
+  options.position_resolution = 0.0;
+  options.single_precision_derivatives = false;
+
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(robot_trajectory::encodeJointTrajectory(trajectory, data, options));
+  trajectory_msgs::msg::JointTrajectory decoded;
+  ASSERT_TRUE(robot_trajectory::decodeJointTrajectory(data, decoded));
+  ASSERT_EQ(decoded.points.size(), trajectory.points.size());
+  for (std::size_t i = 0; i < trajectory.points.size(); ++i)
+  {
+    EXPECT_EQ(decoded.points[i].positions, trajectory.points[i].positions);
+    EXPECT_EQ(decoded.points[i].velocities, trajectory.points[i].velocities);
+    EXPECT_EQ(decoded.points[i].accelerations, trajectory.points[i].accelerations);
+    EXPECT_EQ(decoded.points[i].effort, trajectory.points[i].effort);
+  }
+}
+
+TEST(TrajectoryEncoding, EmptyTrajectory)
+{
+  const trajectory_msgs::msg::JointTrajectory trajectory = makeTrajectory(2, 0);
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(robot_trajectory::encodeJointTrajectory(trajectory, data));
+  trajectory_msgs::msg::JointTrajectory decoded;
+  ASSERT_TRUE(robot_trajectory::decodeJointTrajectory(data, decoded));
+  EXPECT_EQ(decoded.joint_names, trajectory.joint_names);
+  EXPECT_TRUE(decoded.points.empty());
+}
+
+TEST(TrajectoryEncoding, RejectsInconsistentTrajectories)
+{
+  std::vector<uint8_t> data;
+  trajectory_msgs::msg::JointTrajectory trajectory = makeTrajectory(3, 5);
+  trajectory.points[2].velocities.clear();
+  EXPECT_FALSE(robot_trajectory::encodeJointTrajectory(trajectory, data));
+  EXPECT_TRUE(data.empty());
+
+  trajectory = makeTrajectory(3, 5);
+  trajectory.points[1].positions.pop_back();
+  EXPECT_FALSE(robot_trajectory::encodeJointTrajectory(trajectory, data));
+
+  trajectory = makeTrajectory(3, 5);
+  trajectory.points[4].positions[0] = std::nan("");
+  EXPECT_FALSE(robot_trajectory::encodeJointTrajectory(trajectory, data));
+}
+
+TEST(TrajectoryEncoding, RejectsCorruptData)
+{
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(robot_trajectory::encodeJointTrajectory(makeTrajectory(4, 10), data));
+  trajectory_msgs::msg::JointTrajectory decoded;
+
+  std::vector<uint8_t> truncated(data.begin(), data.end() - 1);
+  EXPECT_FALSE(robot_trajectory::decodeJointTrajectory(truncated, decoded));
+
+  std::vector<uint8_t> extended = data;
+  extended.push_back(0);
+  EXPECT_FALSE(robot_trajectory::decodeJointTrajectory(extended, decoded));
+
+  std::vector<uint8_t> wrong_magic = data;
+  wrong_magic[0] = 'X';
+  EXPECT_FALSE(robot_trajectory::decodeJointTrajectory(wrong_magic, decoded));
+  EXPECT_TRUE(decoded.points.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
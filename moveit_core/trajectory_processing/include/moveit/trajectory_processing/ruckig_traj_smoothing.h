@@ -37,6 +37,7 @@
 
 #include <Eigen/Core>
 #include <list>
+#include <memory>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <ruckig/ruckig.hpp>
 
@@ -45,6 +46,33 @@ namespace trajectory_processing
 class RuckigSmoothing
 {
 public:
+  /**
+   * \brief Buffers that can be reused across calls of applySmoothing().
+   * Once a workspace has been used with a trajectory of a given size, smoothing trajectories of the same group and up
+   * to that size does not allocate for 6 and 7 DOF groups, which use fixed-size Ruckig types.
+   * A workspace must not be used by several threads at the same time.
+   */
+  class Workspace
+  {
+  public:
+    Workspace();
+    ~Workspace();
+
+  private:
+    friend class RuckigSmoothing;
+    template <size_t DOFs>
+    struct Buffers;
+
+    template <size_t DOFs>
+    Buffers<DOFs>& getBuffers(size_t num_dof);
+
+    std::unique_ptr<Buffers<6>> buffers_6_;
+    std::unique_ptr<Buffers<7>> buffers_7_;
+    std::unique_ptr<Buffers<ruckig::DynamicDOFs>> dynamic_buffers_;
+    /** Durations of the input trajectory, restored when extending the duration of a segment */
+    std::vector<double> original_durations_;
+  };
+
   /**
    * \brief Apply smoothing to a time-parameterized trajectory so that jerk limits are not violated.
    * \param[in,out] trajectory A path which needs smoothing.
@@ -59,6 +87,21 @@ public:
                              const double max_acceleration_scaling_factor = 1.0, const bool mitigate_overshoot = false,
                              const double overshoot_threshold = 0.01);
 
+  /**
+   * \brief Apply smoothing to a time-parameterized trajectory so that jerk limits are not violated.
+   * \param[in,out] workspace Buffers reused from previous calls to avoid allocations.
+   * \param[in,out] trajectory A path which needs smoothing.
+   * \param max_velocity_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+   * \param max_acceleration_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+   * \param mitigate_overshoot If true, overshoot is mitigated by extending trajectory duration.
+   * \param overshoot_threshold If an overshoot is greater than this, duration is extended (radians, for a single joint)
+   * \return true if successful.
+   */
+  static bool applySmoothing(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                             const double max_velocity_scaling_factor = 1.0,
+                             const double max_acceleration_scaling_factor = 1.0, const bool mitigate_overshoot = false,
+                             const double overshoot_threshold = 0.01);
+
   /**
    * \brief Apply smoothing to a time-parameterized trajectory so that jerk limits are not violated.
    * \param[in,out] trajectory A path which needs smoothing.
@@ -79,6 +122,27 @@ public:
                              const double max_acceleration_scaling_factor = 1.0, const bool mitigate_overshoot = false,
                              const double overshoot_threshold = 0.01);
 
+  /**
+   * \brief Apply smoothing to a time-parameterized trajectory so that jerk limits are not violated.
+   * \param[in,out] workspace Buffers reused from previous calls to avoid allocations.
+   * \param[in,out] trajectory A path which needs smoothing.
+   * \param velocity_limits Joint names and velocity limits in rad/s
+   * \param acceleration_limits Joint names and acceleration limits in rad/s^2
+   * \param jerk_limits Joint names and jerk limits in rad/s^3
+   * \param max_velocity_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+   * \param max_acceleration_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+   * \param mitigate_overshoot If true, overshoot is mitigated by extending trajectory duration.
+   * \param overshoot_threshold If an overshoot is greater than this, duration is extended (radians, for a single joint)
+   * \return true if successful.
+   */
+  static bool applySmoothing(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                             const std::unordered_map<std::string, double>& velocity_limits,
+                             const std::unordered_map<std::string, double>& acceleration_limits,
+                             const std::unordered_map<std::string, double>& jerk_limits,
+                             const double max_velocity_scaling_factor = 1.0,
+                             const double max_acceleration_scaling_factor = 1.0, const bool mitigate_overshoot = false,
+                             const double overshoot_threshold = 0.01);
+
   /**
    * \brief Apply smoothing to a time-parameterized trajectory so that jerk limits are not violated.
    * \param[in,out] trajectory A path which needs smoothing.
@@ -99,6 +163,29 @@ private:
    */
   [[nodiscard]] static bool validateGroup(const robot_trajectory::RobotTrajectory& trajectory);
 
+  /**
+   * \brief Select the buffers matching the group's DOF and run Ruckig with robot model limits, overridden by the
+   * custom limits where given.
+   */
+  [[nodiscard]] static bool smoothTrajectory(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                                             const std::unordered_map<std::string, double>& velocity_limits,
+                                             const std::unordered_map<std::string, double>& acceleration_limits,
+                                             const std::unordered_map<std::string, double>& jerk_limits,
+                                             const double max_velocity_scaling_factor,
+                                             const double max_acceleration_scaling_factor,
+                                             const bool mitigate_overshoot, const double overshoot_threshold);
+
+  /** \brief smoothTrajectory() for a fixed number of DOFs, or ruckig::DynamicDOFs. */
+  template <size_t DOFs>
+  [[nodiscard]] static bool smoothTrajectory(Workspace::Buffers<DOFs>& buffers, std::vector<double>& original_durations,
+                                             robot_trajectory::RobotTrajectory& trajectory,
+                                             const std::unordered_map<std::string, double>& velocity_limits,
+                                             const std::unordered_map<std::string, double>& acceleration_limits,
+                                             const std::unordered_map<std::string, double>& jerk_limits,
+                                             const double max_velocity_scaling_factor,
+                                             const double max_acceleration_scaling_factor,
+                                             const bool mitigate_overshoot, const double overshoot_threshold);
+
   /**
    * \brief A utility function to get bounds from a JointModelGroup and save them for Ruckig.
    * \param max_velocity_scaling_factor       Scale all joint velocity limits by this factor. Usually 1.0.
@@ -106,10 +193,11 @@ private:
    * \param group      The RobotModel and the limits are retrieved from this group.
    * \param[out] ruckig_input     The limits are stored in this ruckig::InputParameter, for use in Ruckig.
    */
+  template <size_t DOFs>
   [[nodiscard]] static bool getRobotModelBounds(const double max_velocity_scaling_factor,
                                                 const double max_acceleration_scaling_factor,
                                                 moveit::core::JointModelGroup const* const group,
-                                                ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input);
+                                                ruckig::InputParameter<DOFs>& ruckig_input);
 
   /**
    * \brief Feed previous output back as input for next iteration. Get next target state from the next waypoint.
@@ -118,10 +206,11 @@ private:
    * \param joint_group         The MoveIt JointModelGroup of interest
    * \param[out] ruckig_input   The Rucking parameters for the next iteration
    */
-  static void getNextRuckigInput(const moveit::core::RobotStateConstPtr& current_waypoint,
-                                 const moveit::core::RobotStateConstPtr& next_waypoint,
+  template <size_t DOFs>
+  static void getNextRuckigInput(const moveit::core::RobotState& current_waypoint,
+                                 const moveit::core::RobotState& next_waypoint,
                                  const moveit::core::JointModelGroup* joint_group,
-                                 ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input);
+                                 ruckig::InputParameter<DOFs>& ruckig_input);
 
   /**
    * \brief Initialize Ruckig position/vel/accel. This initializes ruckig_input and ruckig_output to the same values
@@ -129,38 +218,43 @@ private:
    * \param joint_group     The MoveIt JointModelGroup of interest
    * \param[out] rucking_input   Input parameters to Ruckig. Initialized here.
    */
+  template <size_t DOFs>
   static void initializeRuckigState(const moveit::core::RobotState& first_waypoint,
                                     const moveit::core::JointModelGroup* joint_group,
-                                    ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input);
+                                    ruckig::InputParameter<DOFs>& ruckig_input);
 
   /**
    * \brief A utility function to instantiate and run Ruckig for a series of waypoints.
+   * \param[in, out] buffers        Ruckig input, trajectory and sampling buffers. The input contains kinematic limits
+   * (vel, accel, jerk)
+   * \param[in, out] original_durations Buffer for the waypoint durations of the input trajectory
    * \param[in, out] trajectory      Trajectory to smooth.
-   * \param[in, out] ruckig_input    Necessary input for Ruckig smoothing. Contains kinematic limits (vel, accel, jerk)
    * \param mitigate_overshoot If true, overshoot is mitigated by extending trajectory duration.
    * \param overshoot_threshold If an overshoot is greater than this, duration is extended (radians, for a single joint)
    */
-  [[nodiscard]] static bool runRuckig(robot_trajectory::RobotTrajectory& trajectory,
-                                      ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
+  template <size_t DOFs>
+  [[nodiscard]] static bool runRuckig(Workspace::Buffers<DOFs>& buffers, std::vector<double>& original_durations,
+                                      robot_trajectory::RobotTrajectory& trajectory,
                                       const bool mitigate_overshoot = false, const double overshoot_threshold = 0.01);
 
   /**
-   * \brief Extend the duration of every trajectory segment
-   * \param[in] duration_extension_factor A number greater than 1. Extend every timestep by this much.
-   * \param[in] num_waypoints Number of waypoints in the trajectory.
+   * \brief Extend the duration of the trajectory segment that ends at waypoint \e waypoint_idx + 1
+   * \param[in] duration_extension_factor A number greater than 1. Extend the original duration of the segment by this
+   * much.
+   * \param[in] waypoint_idx Index of the waypoint the segment starts at.
    * \param[in] num_dof Degrees of freedom in the manipulator.
    * \param[in] move_group_idx For accessing the joints of interest out of the full RobotState.
-   * \param[in] original_trajectory Durations are extended based on the data in this original trajectory.
+   * \param[in] original_durations Durations are extended based on these waypoint durations of the original trajectory.
    * \param[in, out] trajectory This trajectory will be returned with modified waypoint durations.
    */
-  static void extendTrajectoryDuration(const double duration_extension_factor, size_t num_waypoints,
+  static void extendTrajectoryDuration(const double duration_extension_factor, size_t waypoint_idx,
                                        const size_t num_dof, const std::vector<int>& move_group_idx,
-                                       const robot_trajectory::RobotTrajectory& original_trajectory,
+                                       const std::vector<double>& original_durations,
                                        robot_trajectory::RobotTrajectory& trajectory);
 
   /** \brief Check if a trajectory out of Ruckig overshoots the target state */
-  static bool checkOvershoot(ruckig::Trajectory<ruckig::DynamicDOFs, ruckig::StandardVector>& ruckig_trajectory,
-                             const size_t num_dof, ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
+  template <size_t DOFs>
+  static bool checkOvershoot(Workspace::Buffers<DOFs>& buffers, const size_t num_dof,
                              const double overshoot_threshold);
 };
 }  // namespace trajectory_processing
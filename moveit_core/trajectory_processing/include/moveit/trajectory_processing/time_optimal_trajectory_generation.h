@@ -40,6 +40,7 @@
 
 #include <Eigen/Core>
 #include <list>
+#include <vector>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/trajectory_processing/time_parameterization.h>
 
@@ -69,7 +70,7 @@ public:
   virtual Eigen::VectorXd getConfig(double s) const = 0;
   virtual Eigen::VectorXd getTangent(double s) const = 0;
   virtual Eigen::VectorXd getCurvature(double s) const = 0;
-  virtual std::list<double> getSwitchingPoints() const = 0;
+  virtual std::vector<double> getSwitchingPoints() const = 0;
   virtual PathSegment* clone() const = 0;
 
   double position_;
@@ -81,6 +82,7 @@ protected:
 class Path
 {
 public:
+  Path(const std::vector<Eigen::VectorXd>& path, double max_deviation = 0.0);
   Path(const std::list<Eigen::VectorXd>& path, double max_deviation = 0.0);
   Path(const Path& path);
   double getLength() const;
@@ -95,22 +97,24 @@ public:
    **/
   double getNextSwitchingPoint(double s, bool& discontinuity) const;
 
-  /// @brief Return a list of all switching points as a pair (arc length to switching point, discontinuity)
-  std::list<std::pair<double, bool>> getSwitchingPoints() const;
+  /// @brief Return all switching points, sorted by arc length, as a pair (arc length to switching point, discontinuity)
+  const std::vector<std::pair<double, bool>>& getSwitchingPoints() const;
 
 private:
   PathSegment* getPathSegment(double& s) const;
   double length_;
-  std::list<std::pair<double, bool>> switching_points_;
-  std::list<std::unique_ptr<PathSegment>> path_segments_;
+  std::vector<std::pair<double, bool>> switching_points_;
+  std::vector<std::unique_ptr<PathSegment>> path_segments_;
 };
 
 class Trajectory
 {
 public:
-  /// @brief Generates a time-optimal trajectory
+  /** @brief Generates a time-optimal trajectory
+     @param initial_path_velocity Path velocity at the start of the path, e.g. when continuing a moving trajectory.
+     It is clamped to the maximum path velocity allowed at the start. The trajectory always ends at rest. **/
   Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
-             double time_step = 0.001);
+             double time_step = 0.001, double initial_path_velocity = 0.0);
 
   ~Trajectory();
 
@@ -150,8 +154,8 @@ private:
                                          double& before_acceleration, double& after_acceleration);
   bool getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep& next_switching_point, double& before_acceleration,
                                      double& after_acceleration);
-  bool integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration);
-  void integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+  bool integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration);
+  void integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                          double acceleration);
   double getMinMaxPathAcceleration(double path_position, double path_velocity, bool max);
   double getMinMaxPhaseSlope(double path_position, double path_velocity, bool max);
@@ -160,20 +164,17 @@ private:
   double getAccelerationMaxPathVelocityDeriv(double path_pos);
   double getVelocityMaxPathVelocityDeriv(double path_pos);
 
-  std::list<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
+  std::vector<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
 
   Path path_;
   Eigen::VectorXd max_velocity_;
   Eigen::VectorXd max_acceleration_;
   unsigned int joint_num_;
   bool valid_;
-  std::list<TrajectoryStep> trajectory_;
-  std::list<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+  std::vector<TrajectoryStep> trajectory_;
+  std::vector<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
 
   const double time_step_;
-
-  mutable double cached_time_;
-  mutable std::list<TrajectoryStep>::const_iterator cached_trajectory_segment_;
 };
 
 MOVEIT_CLASS_FORWARD(TimeOptimalTrajectoryGeneration);
@@ -242,10 +243,67 @@ public:
                          const double max_velocity_scaling_factor = 1.0,
                          const double max_acceleration_scaling_factor = 1.0) const override;
 
+  // clang-format off
+/**
+  * \brief Compute time stamps for many independent trajectories concurrently, e.g. for the robots of a robot cell.
+  * Each trajectory is time-parameterized as by computeTimeStamps() with the joint limits of its robot model.
+  * The trajectories must be distinct objects.
+  * \param[in,out] trajectories Paths which need time-parameterization.
+  * \param max_velocity_scaling_factor A factor in the range [0,1] which can slow down the trajectories.
+  * \param max_acceleration_scaling_factor A factor in the range [0,1] which can slow down the trajectories.
+  * \param num_threads Number of worker threads, 0 uses all hardware threads.
+  * \return true if all trajectories were parameterized successfully.
+  */
+  // clang-format on
+  bool computeTimeStamps(const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories,
+                         const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0, const unsigned int num_threads = 0) const;
+
+  // clang-format off
+/**
+  * \brief Re-time only the suffix of a trajectory that grows by appending waypoints, e.g. in hybrid planning or
+  * when building a Pilz sequence.
+  * Waypoints up to and including splice_index are assumed to be time-parameterized already and are kept unchanged.
+  * All following waypoints are resampled as by computeTimeStamps(), starting with the velocity of the waypoint at
+  * splice_index, so the cost scales with the length of the suffix instead of the whole trajectory.
+  * The previous parameterization came to rest at its last waypoint; to blend into the appended waypoints without
+  * stopping, splice at an earlier waypoint, e.g. where the old trajectory started to decelerate. The velocity at the
+  * splice has to point towards the waypoint after it, as the suffix cannot change direction instantly.
+  * Position and velocity are continuous at the splice. Like every TOTG trajectory, the acceleration of the suffix is
+  * bang-bang within the limits, so apply smoothing afterwards if jerk limits matter.
+  * \param[in,out] trajectory A time-parameterized trajectory with appended, not yet time-parameterized waypoints.
+  * \param splice_index Index of the last waypoint whose timing is kept.
+  * \param max_velocity_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+  * \param max_acceleration_scaling_factor A factor in the range [0,1] which can slow down the trajectory.
+  * \return false if the suffix could not be parameterized, e.g. because it is too short to stop from the splice
+  * velocity, or because the splice velocity does not point along the suffix. The trajectory is left unchanged in that
+  * case.
+  */
+  // clang-format on
+  bool computeTimeStampsIncremental(robot_trajectory::RobotTrajectory& trajectory, const std::size_t splice_index,
+                                    const double max_velocity_scaling_factor = 1.0,
+                                    const double max_acceleration_scaling_factor = 1.0) const;
+
 private:
+  /**
+   * \brief Time-parameterize a trajectory with the given limits.
+   * \param initial_velocity Joint velocity at the first waypoint, which has to point along the path. Leave empty to
+   * start at rest.
+   */
   bool doTimeParameterizationCalculations(robot_trajectory::RobotTrajectory& trajectory,
                                           const Eigen::VectorXd& max_velocity,
-                                          const Eigen::VectorXd& max_acceleration) const;
+                                          const Eigen::VectorXd& max_acceleration,
+                                          const Eigen::VectorXd& initial_velocity = Eigen::VectorXd()) const;
+
+  /**
+   * @brief Get the scaled velocity and acceleration limits of all active joints of the group from the robot model.
+   * \param[out] max_velocity Velocity limit of each active joint
+   * \param[out] max_acceleration Acceleration limit of each active joint
+   * \return false if any limit is missing or invalid.
+   */
+  bool getRobotModelBounds(const moveit::core::JointModelGroup* group, const double max_velocity_scaling_factor,
+                           const double max_acceleration_scaling_factor, Eigen::VectorXd& max_velocity,
+                           Eigen::VectorXd& max_acceleration) const;
 
   /**
    * @brief Check if a combination of revolute and prismatic joints is used. path_tolerance_ is not valid, if so.
@@ -40,6 +40,7 @@
 #include <Eigen/Geometry>
 #include <limits>
 #include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
+#include <optional>
 #include <vector>
 
 namespace trajectory_processing
@@ -54,37 +55,91 @@ constexpr double MAX_DURATION_EXTENSION_FACTOR = 10.0;
 constexpr double DURATION_EXTENSION_FRACTION = 1.1;
 // If "mitigate_overshoot" is enabled, overshoot is checked with this timestep
 constexpr double OVERSHOOT_CHECK_PERIOD = 0.01;  // sec
+// Used when only the limits of the RobotModel apply
+const std::unordered_map<std::string, double> NO_CUSTOM_LIMITS;
+
+// Construct a Ruckig type, which takes the number of DOFs as constructor argument only if they are dynamic
+template <class T, size_t DOFs>
+T makeRuckigType(size_t num_dof)
+{
+  if constexpr (DOFs == ruckig::DynamicDOFs)
+    return T(num_dof);
+  else
+    return T();
+}
 }  // namespace
 
-bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajectory,
-                                     const double max_velocity_scaling_factor,
-                                     const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
-                                     const double overshoot_threshold)
+template <size_t DOFs>
+struct RuckigSmoothing::Workspace::Buffers
 {
-  if (!validateGroup(trajectory))
+  explicit Buffers(size_t num_dof)
+    : num_dof(num_dof)
+    , input(makeRuckigType<ruckig::InputParameter<DOFs>, DOFs>(num_dof))
+    , trajectory(makeRuckigType<ruckig::Trajectory<DOFs, ruckig::StandardVector>, DOFs>(num_dof))
+    , position(makeRuckigType<ruckig::StandardVector<double, DOFs>, DOFs>(num_dof))
+    , velocity(makeRuckigType<ruckig::StandardVector<double, DOFs>, DOFs>(num_dof))
+    , acceleration(makeRuckigType<ruckig::StandardVector<double, DOFs>, DOFs>(num_dof))
   {
-    return false;
   }
 
-  const size_t num_waypoints = trajectory.getWayPointCount();
-  if (num_waypoints < 2)
+  /** \brief (Re-)create the Ruckig instance for the given cycle time */
+  ruckig::Ruckig<DOFs>& resetRuckig(double delta_time)
   {
-    RCLCPP_WARN(LOGGER,
-                "Trajectory does not have enough points to smooth with Ruckig. Returning an unmodified trajectory.");
-    return true;
+    if constexpr (DOFs == ruckig::DynamicDOFs)
+      ruckig.emplace(num_dof, delta_time);
+    else
+      ruckig.emplace(delta_time);
+    return *ruckig;
   }
 
-  // Kinematic limits (vels/accels/jerks) from RobotModel
-  moveit::core::JointModelGroup const* const group = trajectory.getGroup();
-  const size_t num_dof = group->getVariableCount();
-  ruckig::InputParameter<ruckig::DynamicDOFs> ruckig_input{ num_dof };
-  if (!getRobotModelBounds(max_velocity_scaling_factor, max_acceleration_scaling_factor, group, ruckig_input))
-  {
-    RCLCPP_ERROR(LOGGER, "Error while retrieving kinematic limits (vel/accel/jerk) from RobotModel.");
-    return false;
-  }
+  const size_t num_dof;
+  ruckig::InputParameter<DOFs> input;
+  ruckig::Trajectory<DOFs, ruckig::StandardVector> trajectory;
+  std::optional<ruckig::Ruckig<DOFs>> ruckig;
+  // Samples of the Ruckig trajectory for the overshoot check
+  ruckig::StandardVector<double, DOFs> position;
+  ruckig::StandardVector<double, DOFs> velocity;
+  ruckig::StandardVector<double, DOFs> acceleration;
+};
+
+RuckigSmoothing::Workspace::Workspace() = default;
+
+RuckigSmoothing::Workspace::~Workspace() = default;
+
+template <size_t DOFs>
+RuckigSmoothing::Workspace::Buffers<DOFs>& RuckigSmoothing::Workspace::getBuffers(size_t num_dof)
+{
+  std::unique_ptr<Buffers<DOFs>>* buffers;
+  if constexpr (DOFs == 6)
+    buffers = &buffers_6_;
+  else if constexpr (DOFs == 7)
+    buffers = &buffers_7_;
+  else
+    buffers = &dynamic_buffers_;
+
+  if (!*buffers || (*buffers)->num_dof != num_dof)
+    *buffers = std::make_unique<Buffers<DOFs>>(num_dof);
+  return **buffers;
+}
+
+bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajectory,
+                                     const double max_velocity_scaling_factor,
+                                     const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
+                                     const double overshoot_threshold)
+{
+  Workspace workspace;
+  return applySmoothing(workspace, trajectory, max_velocity_scaling_factor, max_acceleration_scaling_factor,
+                        mitigate_overshoot, overshoot_threshold);
+}
 
-  return runRuckig(trajectory, ruckig_input, mitigate_overshoot, overshoot_threshold);
+bool RuckigSmoothing::applySmoothing(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                                     const double max_velocity_scaling_factor,
+                                     const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
+                                     const double overshoot_threshold)
+{
+  return applySmoothing(workspace, trajectory, NO_CUSTOM_LIMITS, NO_CUSTOM_LIMITS, NO_CUSTOM_LIMITS,
+                        max_velocity_scaling_factor, max_acceleration_scaling_factor, mitigate_overshoot,
+                        overshoot_threshold);
 }
 
 bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajectory,
@@ -94,6 +149,20 @@ bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajecto
                                      const double max_velocity_scaling_factor,
                                      const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
                                      const double overshoot_threshold)
+{
+  Workspace workspace;
+  return applySmoothing(workspace, trajectory, velocity_limits, acceleration_limits, jerk_limits,
+                        max_velocity_scaling_factor, max_acceleration_scaling_factor, mitigate_overshoot,
+                        overshoot_threshold);
+}
+
+bool RuckigSmoothing::applySmoothing(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                                     const std::unordered_map<std::string, double>& velocity_limits,
+                                     const std::unordered_map<std::string, double>& acceleration_limits,
+                                     const std::unordered_map<std::string, double>& jerk_limits,
+                                     const double max_velocity_scaling_factor,
+                                     const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
+                                     const double overshoot_threshold)
 {
   if (!validateGroup(trajectory))
   {
@@ -108,42 +177,9 @@ bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajecto
     return true;
   }
 
-  // Set default kinematic limits (vels/accels/jerks)
-  moveit::core::JointModelGroup const* const group = trajectory.getGroup();
-  const size_t num_dof = group->getVariableCount();
-  ruckig::InputParameter<ruckig::DynamicDOFs> ruckig_input{ num_dof };
-  if (!getRobotModelBounds(max_velocity_scaling_factor, max_acceleration_scaling_factor, group, ruckig_input))
-  {
-    RCLCPP_ERROR(LOGGER, "Error while retrieving kinematic limits (vel/accel/jerk) from RobotModel.");
-    return false;
-  }
-
-  // Check if custom limits were supplied as arguments to overwrite the defaults
-  const std::vector<std::string>& vars = group->getVariableNames();
-  const unsigned num_joints = group->getVariableCount();
-  for (size_t j = 0; j < num_joints; ++j)
-  {
-    // Velocity
-    auto it = velocity_limits.find(vars[j]);
-    if (it != velocity_limits.end())
-    {
-      ruckig_input.max_velocity.at(j) = it->second * max_velocity_scaling_factor;
-    }
-    // Acceleration
-    it = acceleration_limits.find(vars[j]);
-    if (it != acceleration_limits.end())
-    {
-      ruckig_input.max_acceleration.at(j) = it->second * max_acceleration_scaling_factor;
-    }
-    // Jerk
-    it = jerk_limits.find(vars[j]);
-    if (it != jerk_limits.end())
-    {
-      ruckig_input.max_jerk.at(j) = it->second;
-    }
-  }
-
-  return runRuckig(trajectory, ruckig_input, mitigate_overshoot, overshoot_threshold);
+  return smoothTrajectory(workspace, trajectory, velocity_limits, acceleration_limits, jerk_limits,
+                          max_velocity_scaling_factor, max_acceleration_scaling_factor, mitigate_overshoot,
+                          overshoot_threshold);
 }
 
 bool RuckigSmoothing::applySmoothing(robot_trajectory::RobotTrajectory& trajectory,
@@ -185,10 +221,86 @@ bool RuckigSmoothing::validateGroup(const robot_trajectory::RobotTrajectory& tra
   return true;
 }
 
+bool RuckigSmoothing::smoothTrajectory(Workspace& workspace, robot_trajectory::RobotTrajectory& trajectory,
+                                       const std::unordered_map<std::string, double>& velocity_limits,
+                                       const std::unordered_map<std::string, double>& acceleration_limits,
+                                       const std::unordered_map<std::string, double>& jerk_limits,
+                                       const double max_velocity_scaling_factor,
+                                       const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
+                                       const double overshoot_threshold)
+{
+  // Common arm sizes use fixed-size Ruckig types, which do not allocate once the workspace buffers exist
+  const size_t num_dof = trajectory.getGroup()->getVariableCount();
+  switch (num_dof)
+  {
+    case 6:
+      return smoothTrajectory(workspace.getBuffers<6>(num_dof), workspace.original_durations_, trajectory,
+                              velocity_limits, acceleration_limits, jerk_limits, max_velocity_scaling_factor,
+                              max_acceleration_scaling_factor, mitigate_overshoot, overshoot_threshold);
+    case 7:
+      return smoothTrajectory(workspace.getBuffers<7>(num_dof), workspace.original_durations_, trajectory,
+                              velocity_limits, acceleration_limits, jerk_limits, max_velocity_scaling_factor,
+                              max_acceleration_scaling_factor, mitigate_overshoot, overshoot_threshold);
+    default:
+      return smoothTrajectory(workspace.getBuffers<ruckig::DynamicDOFs>(num_dof), workspace.original_durations_,
+                              trajectory, velocity_limits, acceleration_limits, jerk_limits,
+                              max_velocity_scaling_factor, max_acceleration_scaling_factor, mitigate_overshoot,
+                              overshoot_threshold);
+  }
+}
+
+template <size_t DOFs>
+bool RuckigSmoothing::smoothTrajectory(Workspace::Buffers<DOFs>& buffers, std::vector<double>& original_durations,
+                                       robot_trajectory::RobotTrajectory& trajectory,
+                                       const std::unordered_map<std::string, double>& velocity_limits,
+                                       const std::unordered_map<std::string, double>& acceleration_limits,
+                                       const std::unordered_map<std::string, double>& jerk_limits,
+                                       const double max_velocity_scaling_factor,
+                                       const double max_acceleration_scaling_factor, const bool mitigate_overshoot,
+                                       const double overshoot_threshold)
+{
+  // Kinematic limits (vels/accels/jerks) from RobotModel
+  moveit::core::JointModelGroup const* const group = trajectory.getGroup();
+  ruckig::InputParameter<DOFs>& ruckig_input = buffers.input;
+  if (!getRobotModelBounds(max_velocity_scaling_factor, max_acceleration_scaling_factor, group, ruckig_input))
+  {
+    RCLCPP_ERROR(LOGGER, "Error while retrieving kinematic limits (vel/accel/jerk) from RobotModel.");
+    return false;
+  }
+
+  // Check if custom limits were supplied as arguments to overwrite the defaults
+  const std::vector<std::string>& vars = group->getVariableNames();
+  const unsigned num_joints = group->getVariableCount();
+  for (size_t j = 0; j < num_joints; ++j)
+  {
+    // Velocity
+    auto it = velocity_limits.find(vars[j]);
+    if (it != velocity_limits.end())
+    {
+      ruckig_input.max_velocity.at(j) = it->second * max_velocity_scaling_factor;
+    }
+    // Acceleration
+    it = acceleration_limits.find(vars[j]);
+    if (it != acceleration_limits.end())
+    {
+      ruckig_input.max_acceleration.at(j) = it->second * max_acceleration_scaling_factor;
+    }
+    // Jerk
+    it = jerk_limits.find(vars[j]);
+    if (it != jerk_limits.end())
+    {
+      ruckig_input.max_jerk.at(j) = it->second;
+    }
+  }
+
+  return runRuckig(buffers, original_durations, trajectory, mitigate_overshoot, overshoot_threshold);
+}
+
+template <size_t DOFs>
 bool RuckigSmoothing::getRobotModelBounds(const double max_velocity_scaling_factor,
                                           const double max_acceleration_scaling_factor,
                                           moveit::core::JointModelGroup const* const group,
-                                          ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input)
+                                          ruckig::InputParameter<DOFs>& ruckig_input)
 {
   const size_t num_dof = group->getVariableCount();
   const std::vector<std::string>& vars = group->getVariableNames();
@@ -239,78 +351,76 @@ bool RuckigSmoothing::getRobotModelBounds(const double max_velocity_scaling_fact
   return true;
 }
 
-bool RuckigSmoothing::runRuckig(robot_trajectory::RobotTrajectory& trajectory,
-                                ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
-                                const bool mitigate_overshoot, const double overshoot_threshold)
+template <size_t DOFs>
+bool RuckigSmoothing::runRuckig(Workspace::Buffers<DOFs>& buffers, std::vector<double>& original_durations,
+                                robot_trajectory::RobotTrajectory& trajectory, const bool mitigate_overshoot,
+                                const double overshoot_threshold)
 {
   const size_t num_waypoints = trajectory.getWayPointCount();
   moveit::core::JointModelGroup const* const group = trajectory.getGroup();
   const size_t num_dof = group->getVariableCount();
-  ruckig::OutputParameter<ruckig::DynamicDOFs> ruckig_output{ num_dof };
+  ruckig::InputParameter<DOFs>& ruckig_input = buffers.input;
 
   // This lib does not work properly when angles wrap, so we need to unwind the path first
   trajectory.unwind();
 
   // Initialize the smoother
-  ruckig::Ruckig<ruckig::DynamicDOFs> ruckig(num_dof, trajectory.getAverageSegmentDuration());
+  ruckig::Ruckig<DOFs>& ruckig = buffers.resetRuckig(trajectory.getAverageSegmentDuration());
   initializeRuckigState(*trajectory.getFirstWayPointPtr(), group, ruckig_input);
 
-  // Cache the trajectory in case we need to reset it
-  robot_trajectory::RobotTrajectory original_trajectory =
-      robot_trajectory::RobotTrajectory(trajectory, true /* deep copy */);
+  // Cache the durations in case we need to reset the trajectory
+  original_durations.resize(num_waypoints);
+  for (size_t waypoint_idx = 0; waypoint_idx < num_waypoints; ++waypoint_idx)
+  {
+    original_durations[waypoint_idx] = trajectory.getWayPointDurationFromPrevious(waypoint_idx);
+  }
 
-  ruckig::Result ruckig_result;
-  double duration_extension_factor = 1;
-  bool smoothing_complete = false;
-  size_t waypoint_idx = 0;
-  while ((duration_extension_factor < MAX_DURATION_EXTENSION_FACTOR) && !smoothing_complete)
+  // Retries only extend the failing segment. Every segment starts from its original duration and has its own budget
+  // of extensions, so a segment that needed a long extension does not slow down or exhaust the retries of later ones.
+  const std::vector<int>& move_group_idx = group->getVariableIndexList();
+  ruckig::Result ruckig_result = ruckig::Result::Working;
+  for (size_t waypoint_idx = 0; waypoint_idx < num_waypoints - 1; ++waypoint_idx)
   {
-    while (waypoint_idx < num_waypoints - 1)
+    double duration_extension_factor = 1;
+    while (true)
     {
-      moveit::core::RobotStatePtr curr_waypoint = trajectory.getWayPointPtr(waypoint_idx);
-      moveit::core::RobotStatePtr next_waypoint = trajectory.getWayPointPtr(waypoint_idx + 1);
-
-      getNextRuckigInput(curr_waypoint, next_waypoint, group, ruckig_input);
+      getNextRuckigInput(trajectory.getWayPoint(waypoint_idx), trajectory.getWayPoint(waypoint_idx + 1), group,
+                         ruckig_input);
 
       // Run Ruckig
-      ruckig::Trajectory<ruckig::DynamicDOFs, ruckig::StandardVector> ruckig_trajectory(num_dof);
-      ruckig_result = ruckig.calculate(ruckig_input, ruckig_trajectory);
+      ruckig_result = ruckig.calculate(ruckig_input, buffers.trajectory);
 
       // Step through the trajectory at the given OVERSHOOT_CHECK_PERIOD and check for overshoot.
       // We will extend the duration to mitigate it.
-      bool overshoots = false;
-      if (mitigate_overshoot)
-      {
-        overshoots = checkOvershoot(ruckig_trajectory, num_dof, ruckig_input, overshoot_threshold);
-      }
+      const bool overshoots = mitigate_overshoot && checkOvershoot(buffers, num_dof, overshoot_threshold);
 
       // The difference between Result::Working and Result::Finished is that Finished can be reached in one
       // Ruckig timestep (constructor parameter). Both are acceptable for trajectories.
       // (The difference is only relevant for streaming mode.)
-
-      // If successful and at the last trajectory segment
-      if (!overshoots && (waypoint_idx == num_waypoints - 2) &&
-          (ruckig_result == ruckig::Result::Working || ruckig_result == ruckig::Result::Finished))
+      const bool success = ruckig_result == ruckig::Result::Working || ruckig_result == ruckig::Result::Finished;
+      if (success && !overshoots)
       {
-        trajectory.setWayPointDurationFromPrevious(waypoint_idx + 1, ruckig_trajectory.get_duration());
-        smoothing_complete = true;
+        // If at the last trajectory segment
+        if (waypoint_idx == num_waypoints - 2)
+        {
+          trajectory.setWayPointDurationFromPrevious(waypoint_idx + 1, buffers.trajectory.get_duration());
+        }
         break;
       }
-
-      // Extend the trajectory duration if Ruckig could not reach the waypoint successfully
-      if (overshoots || (ruckig_result != ruckig::Result::Working && ruckig_result != ruckig::Result::Finished))
+      if (duration_extension_factor * DURATION_EXTENSION_FRACTION >= MAX_DURATION_EXTENSION_FACTOR)
       {
-        duration_extension_factor *= DURATION_EXTENSION_FRACTION;
-
-        const std::vector<int>& move_group_idx = group->getVariableIndexList();
-        extendTrajectoryDuration(duration_extension_factor, waypoint_idx, num_dof, move_group_idx, original_trajectory,
-                                 trajectory);
-
-        initializeRuckigState(*trajectory.getFirstWayPointPtr(), group, ruckig_input);
-        // Continue the loop from failed segment, but with increased duration extension factor
         break;
       }
-      ++waypoint_idx;
+
+      // Extend the segment duration if Ruckig could not reach the waypoint successfully
+      duration_extension_factor *= DURATION_EXTENSION_FRACTION;
+      extendTrajectoryDuration(duration_extension_factor, waypoint_idx, num_dof, move_group_idx, original_durations,
+                               trajectory);
+    }
+
+    if (ruckig_result != ruckig::Result::Working && ruckig_result != ruckig::Result::Finished)
+    {
+      break;
     }
   }
 
@@ -325,23 +435,24 @@ bool RuckigSmoothing::runRuckig(robot_trajectory::RobotTrajectory& trajectory,
 
 void RuckigSmoothing::extendTrajectoryDuration(const double duration_extension_factor, size_t waypoint_idx,
                                                const size_t num_dof, const std::vector<int>& move_group_idx,
-                                               const robot_trajectory::RobotTrajectory& original_trajectory,
+                                               const std::vector<double>& original_durations,
                                                robot_trajectory::RobotTrajectory& trajectory)
 {
+  const double previous_timestep = trajectory.getWayPointDurationFromPrevious(waypoint_idx + 1);
   trajectory.setWayPointDurationFromPrevious(waypoint_idx + 1,
-                                             duration_extension_factor *
-                                                 original_trajectory.getWayPointDurationFromPrevious(waypoint_idx + 1));
+                                             duration_extension_factor * original_durations[waypoint_idx + 1]);
   // re-calculate waypoint velocity and acceleration
   auto target_state = trajectory.getWayPointPtr(waypoint_idx + 1);
   const auto prev_state = trajectory.getWayPointPtr(waypoint_idx);
 
   double timestep = trajectory.getWayPointDurationFromPrevious(waypoint_idx + 1);
+  // Scale relative to the current duration, so that repeated extensions of a segment do not compound
+  const double velocity_scale = timestep > 0.0 ? previous_timestep / timestep : 1.0;
 
   for (size_t joint = 0; joint < num_dof; ++joint)
   {
     target_state->setVariableVelocity(move_group_idx.at(joint),
-                                      (1 / duration_extension_factor) *
-                                          target_state->getVariableVelocity(move_group_idx.at(joint)));
+                                      velocity_scale * target_state->getVariableVelocity(move_group_idx.at(joint)));
 
     double prev_velocity = prev_state->getVariableVelocity(move_group_idx.at(joint));
     double curr_velocity = target_state->getVariableVelocity(move_group_idx.at(joint));
@@ -349,51 +460,45 @@ void RuckigSmoothing::extendTrajectoryDuration(const double duration_extension_f
   }
 }
 
+template <size_t DOFs>
 void RuckigSmoothing::initializeRuckigState(const moveit::core::RobotState& first_waypoint,
                                             const moveit::core::JointModelGroup* joint_group,
-                                            ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input)
+                                            ruckig::InputParameter<DOFs>& ruckig_input)
 {
   const size_t num_dof = joint_group->getVariableCount();
   const std::vector<int>& idx = joint_group->getVariableIndexList();
 
-  std::vector<double> current_positions_vector(num_dof);
-  std::vector<double> current_velocities_vector(num_dof);
-  std::vector<double> current_accelerations_vector(num_dof);
-
   for (size_t i = 0; i < num_dof; ++i)
   {
-    current_positions_vector.at(i) = first_waypoint.getVariablePosition(idx.at(i));
-    current_velocities_vector.at(i) = first_waypoint.getVariableVelocity(idx.at(i));
-    current_accelerations_vector.at(i) = first_waypoint.getVariableAcceleration(idx.at(i));
+    ruckig_input.current_position.at(i) = first_waypoint.getVariablePosition(idx.at(i));
     // Clamp velocities/accelerations in case they exceed the limit due to small numerical errors
-    current_velocities_vector.at(i) =
-        std::clamp(current_velocities_vector.at(i), -ruckig_input.max_velocity.at(i), ruckig_input.max_velocity.at(i));
-    current_accelerations_vector.at(i) = std::clamp(
-        current_accelerations_vector.at(i), -ruckig_input.max_acceleration.at(i), ruckig_input.max_acceleration.at(i));
+    ruckig_input.current_velocity.at(i) = std::clamp(first_waypoint.getVariableVelocity(idx.at(i)),
+                                                     -ruckig_input.max_velocity.at(i), ruckig_input.max_velocity.at(i));
+    ruckig_input.current_acceleration.at(i) =
+        std::clamp(first_waypoint.getVariableAcceleration(idx.at(i)), -ruckig_input.max_acceleration.at(i),
+                   ruckig_input.max_acceleration.at(i));
   }
-  std::copy_n(current_positions_vector.begin(), num_dof, ruckig_input.current_position.begin());
-  std::copy_n(current_velocities_vector.begin(), num_dof, ruckig_input.current_velocity.begin());
-  std::copy_n(current_accelerations_vector.begin(), num_dof, ruckig_input.current_acceleration.begin());
 }
 
-void RuckigSmoothing::getNextRuckigInput(const moveit::core::RobotStateConstPtr& current_waypoint,
-                                         const moveit::core::RobotStateConstPtr& next_waypoint,
+template <size_t DOFs>
+void RuckigSmoothing::getNextRuckigInput(const moveit::core::RobotState& current_waypoint,
+                                         const moveit::core::RobotState& next_waypoint,
                                          const moveit::core::JointModelGroup* joint_group,
-                                         ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input)
+                                         ruckig::InputParameter<DOFs>& ruckig_input)
 {
   const size_t num_dof = joint_group->getVariableCount();
   const std::vector<int>& idx = joint_group->getVariableIndexList();
 
   for (size_t joint = 0; joint < num_dof; ++joint)
   {
-    ruckig_input.current_position.at(joint) = current_waypoint->getVariablePosition(idx.at(joint));
-    ruckig_input.current_velocity.at(joint) = current_waypoint->getVariableVelocity(idx.at(joint));
-    ruckig_input.current_acceleration.at(joint) = current_waypoint->getVariableAcceleration(idx.at(joint));
+    ruckig_input.current_position.at(joint) = current_waypoint.getVariablePosition(idx.at(joint));
+    ruckig_input.current_velocity.at(joint) = current_waypoint.getVariableVelocity(idx.at(joint));
+    ruckig_input.current_acceleration.at(joint) = current_waypoint.getVariableAcceleration(idx.at(joint));
 
     // Target state is the next waypoint
-    ruckig_input.target_position.at(joint) = next_waypoint->getVariablePosition(idx.at(joint));
-    ruckig_input.target_velocity.at(joint) = next_waypoint->getVariableVelocity(idx.at(joint));
-    ruckig_input.target_acceleration.at(joint) = next_waypoint->getVariableAcceleration(idx.at(joint));
+    ruckig_input.target_position.at(joint) = next_waypoint.getVariablePosition(idx.at(joint));
+    ruckig_input.target_velocity.at(joint) = next_waypoint.getVariableVelocity(idx.at(joint));
+    ruckig_input.target_acceleration.at(joint) = next_waypoint.getVariableAcceleration(idx.at(joint));
 
     // Clamp velocities/accelerations in case they exceed the limit due to small numerical errors
     ruckig_input.current_velocity.at(joint) =
@@ -411,23 +516,21 @@ void RuckigSmoothing::getNextRuckigInput(const moveit::core::RobotStateConstPtr&
   }
 }
 
-bool RuckigSmoothing::checkOvershoot(ruckig::Trajectory<ruckig::DynamicDOFs, ruckig::StandardVector>& ruckig_trajectory,
-                                     const size_t num_dof, ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
+template <size_t DOFs>
+bool RuckigSmoothing::checkOvershoot(Workspace::Buffers<DOFs>& buffers, const size_t num_dof,
                                      const double overshoot_threshold)
 {
+  const ruckig::InputParameter<DOFs>& ruckig_input = buffers.input;
   // For every timestep
-  for (double time_from_start = OVERSHOOT_CHECK_PERIOD; time_from_start < ruckig_trajectory.get_duration();
+  for (double time_from_start = OVERSHOOT_CHECK_PERIOD; time_from_start < buffers.trajectory.get_duration();
        time_from_start += OVERSHOOT_CHECK_PERIOD)
   {
-    std::vector<double> new_position(num_dof);
-    std::vector<double> new_velocity(num_dof);
-    std::vector<double> new_acceleration(num_dof);
-    ruckig_trajectory.at_time(time_from_start, new_position, new_velocity, new_acceleration);
+    buffers.trajectory.at_time(time_from_start, buffers.position, buffers.velocity, buffers.acceleration);
     // For every joint
     for (size_t joint = 0; joint < num_dof; ++joint)
     {
       // If the sign of the error changed and the threshold difference was exceeded
-      double error = new_position[joint] - ruckig_input.target_position.at(joint);
+      double error = buffers.position[joint] - ruckig_input.target_position.at(joint);
       if (((error / (ruckig_input.current_position.at(joint) - ruckig_input.target_position.at(joint))) < 0.0) &&
           std::fabs(error) > overshoot_threshold)
       {
@@ -43,6 +43,8 @@
 #include <algorithm>
 #include <cmath>
 #include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 namespace trajectory_processing
@@ -54,6 +56,8 @@ static const rclcpp::Logger LOGGER =
 constexpr double DEFAULT_TIMESTEP = 1e-3;
 constexpr double EPS = 1e-6;
 constexpr double DEFAULT_SCALING_FACTOR = 1.0;
+// Relative part of the initial velocity that may point off the path
+constexpr double INITIAL_VELOCITY_TOLERANCE = 1e-3;
 }  // namespace
 
 class LinearPathSegment : public PathSegment
@@ -81,9 +85,9 @@ public:
     return Eigen::VectorXd::Zero(start_.size());
   }
 
-  std::list<double> getSwitchingPoints() const override
+  std::vector<double> getSwitchingPoints() const override
   {
-    return std::list<double>();
+    return std::vector<double>();
   }
 
   LinearPathSegment* clone() const override
@@ -161,9 +165,9 @@ public:
     return -1.0 / radius_ * (x_ * cos(angle) + y_ * sin(angle));
   }
 
-  std::list<double> getSwitchingPoints() const override
+  std::vector<double> getSwitchingPoints() const override
   {
-    std::list<double> switching_points;
+    std::vector<double> switching_points;
     const double dim = x_.size();
     for (unsigned int i = 0; i < dim; ++i)
     {
@@ -178,7 +182,7 @@ public:
         switching_points.push_back(switching_point);
       }
     }
-    switching_points.sort();
+    std::sort(switching_points.begin(), switching_points.end());
     return switching_points;
   }
 
@@ -194,24 +198,18 @@ private:
   Eigen::VectorXd y_;
 };
 
-Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
+Path::Path(const std::vector<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
 {
   if (path.size() < 2)
     return;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator1 = path.begin();
-  std::list<Eigen::VectorXd>::const_iterator path_iterator2 = path_iterator1;
-  ++path_iterator2;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator3;
-  Eigen::VectorXd start_config = *path_iterator1;
-  while (path_iterator2 != path.end())
+  path_segments_.reserve(max_deviation > 0.0 ? 2 * path.size() : path.size());
+  Eigen::VectorXd start_config = path.front();
+  for (std::size_t i = 1; i < path.size(); ++i)
   {
-    path_iterator3 = path_iterator2;
-    ++path_iterator3;
-    if (max_deviation > 0.0 && path_iterator3 != path.end())
+    if (max_deviation > 0.0 && i + 1 < path.size())
     {
-      CircularPathSegment* blend_segment =
-          new CircularPathSegment(0.5 * (*path_iterator1 + *path_iterator2), *path_iterator2,
-                                  0.5 * (*path_iterator2 + *path_iterator3), max_deviation);
+      CircularPathSegment* blend_segment = new CircularPathSegment(
+          0.5 * (path[i - 1] + path[i]), path[i], 0.5 * (path[i] + path[i + 1]), max_deviation);
       Eigen::VectorXd end_config = blend_segment->getConfig(0.0);
       if ((end_config - start_config).norm() > 0.000001)
       {
@@ -223,11 +221,9 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
     }
     else
     {
-      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, *path_iterator2));
-      start_config = *path_iterator2;
+      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, path[i]));
+      start_config = path[i];
     }
-    path_iterator1 = path_iterator2;
-    ++path_iterator2;
   }
 
   // Create list of switching point candidates, calculate total path length and
@@ -235,11 +231,9 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   for (std::unique_ptr<PathSegment>& path_segment : path_segments_)
   {
     path_segment->position_ = length_;
-    std::list<double> local_switching_points = path_segment->getSwitchingPoints();
-    for (std::list<double>::const_iterator point = local_switching_points.begin();
-         point != local_switching_points.end(); ++point)
+    for (const double point : path_segment->getSwitchingPoints())
     {
-      switching_points_.push_back(std::make_pair(length_ + *point, false));
+      switching_points_.push_back(std::make_pair(length_ + point, false));
     }
     length_ += path_segment->getLength();
     while (!switching_points_.empty() && switching_points_.back().first >= length_)
@@ -249,8 +243,14 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   switching_points_.pop_back();
 }
 
+Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation)
+  : Path(std::vector<Eigen::VectorXd>(path.begin(), path.end()), max_deviation)
+{
+}
+
 Path::Path(const Path& path) : length_(path.length_), switching_points_(path.switching_points_)
 {
+  path_segments_.reserve(path.path_segments_.size());
   for (const std::unique_ptr<PathSegment>& path_segment : path.path_segments_)
   {
     path_segments_.emplace_back(path_segment->clone());
@@ -264,14 +264,12 @@ double Path::getLength() const
 
 PathSegment* Path::getPathSegment(double& s) const
 {
-  std::list<std::unique_ptr<PathSegment>>::const_iterator it = path_segments_.begin();
-  std::list<std::unique_ptr<PathSegment>>::const_iterator next = it;
-  ++next;
-  while (next != path_segments_.end() && s >= (*next)->position_)
-  {
-    it = next;
-    ++next;
-  }
+  // last segment starting at or before s, the first segment otherwise
+  auto it = std::upper_bound(path_segments_.begin() + 1, path_segments_.end(), s,
+                             [](double s, const std::unique_ptr<PathSegment>& segment) {
+                               return s < segment->position_;
+                             });
+  --it;
   s -= (*it)->position_;
   return (*it).get();
 }
@@ -296,11 +294,8 @@ Eigen::VectorXd Path::getCurvature(double s) const
 
 double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
 {
-  std::list<std::pair<double, bool>>::const_iterator it = switching_points_.begin();
-  while (it != switching_points_.end() && it->first <= s)
-  {
-    ++it;
-  }
+  auto it = std::upper_bound(switching_points_.begin(), switching_points_.end(), s,
+                             [](double s, const std::pair<double, bool>& point) { return s < point.first; });
   if (it == switching_points_.end())
   {
     discontinuity = true;
@@ -310,23 +305,25 @@ double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
   return it->first;
 }
 
-std::list<std::pair<double, bool>> Path::getSwitchingPoints() const
+const std::vector<std::pair<double, bool>>& Path::getSwitchingPoints() const
 {
   return switching_points_;
 }
 
 Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
-                       double time_step)
+                       double time_step, double initial_path_velocity)
   : path_(path)
   , max_velocity_(max_velocity)
   , max_acceleration_(max_acceleration)
   , joint_num_(max_velocity.size())
   , valid_(true)
   , time_step_(time_step)
-  , cached_time_(std::numeric_limits<double>::max())
 {
-  trajectory_.push_back(TrajectoryStep(0.0, 0.0));
-  double after_acceleration = getMinMaxPathAcceleration(0.0, 0.0, true);
+  // Never start above the limit curves, the forward integration could not recover from that
+  initial_path_velocity = std::max(0.0, std::min({ initial_path_velocity, getVelocityMaxPathVelocity(0.0),
+                                                   getAccelerationMaxPathVelocity(0.0) }));
+  trajectory_.push_back(TrajectoryStep(0.0, initial_path_velocity));
+  double after_acceleration = getMinMaxPathAcceleration(0.0, initial_path_velocity, true);
   while (valid_ && !integrateForward(trajectory_, after_acceleration) && valid_)
   {
     double before_acceleration;
@@ -347,16 +344,13 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   if (valid_)
   {
     // Calculate timing
-    std::list<TrajectoryStep>::iterator previous = trajectory_.begin();
-    std::list<TrajectoryStep>::iterator it = previous;
-    it->time_ = 0.0;
-    ++it;
-    while (it != trajectory_.end())
+    trajectory_.front().time_ = 0.0;
+    for (std::size_t i = 1; i < trajectory_.size(); ++i)
     {
-      it->time_ =
-          previous->time_ + (it->path_pos_ - previous->path_pos_) / ((it->path_vel_ + previous->path_vel_) / 2.0);
-      previous = it;
-      ++it;
+      const TrajectoryStep& previous = trajectory_[i - 1];
+      TrajectoryStep& step = trajectory_[i];
+      step.time_ =
+          previous.time_ + (step.path_pos_ - previous.path_pos_) / ((step.path_vel_ + previous.path_vel_) / 2.0);
     }
   }
 }
@@ -509,13 +503,13 @@ bool Trajectory::getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep&
 }
 
 // Returns true if end of path is reached
-bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration)
+bool Trajectory::integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration)
 {
   double path_pos = trajectory.back().path_pos_;
   double path_vel = trajectory.back().path_vel_;
 
-  std::list<std::pair<double, bool>> switching_points = path_.getSwitchingPoints();
-  std::list<std::pair<double, bool>>::iterator next_discontinuity = switching_points.begin();
+  const std::vector<std::pair<double, bool>>& switching_points = path_.getSwitchingPoints();
+  auto next_discontinuity = switching_points.begin();
 
   while (true)
   {
@@ -625,32 +619,31 @@ bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double
   }
 }
 
-void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+void Trajectory::integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                                    double acceleration)
 {
-  std::list<TrajectoryStep>::iterator start2 = start_trajectory.end();
-  --start2;
-  std::list<TrajectoryStep>::iterator start1 = start2;
-  --start1;
-  std::list<TrajectoryStep> trajectory;
+  std::size_t start2 = start_trajectory.size() - 1;
+  std::size_t start1 = start2 - 1;
+  // backward trajectory in reverse order, i.e. back() is the step with the smallest path position
+  std::vector<TrajectoryStep> trajectory;
   double slope;
-  assert(start1->path_pos_ <= path_pos);
+  assert(start_trajectory[start1].path_pos_ <= path_pos);
 
-  while (start1 != start_trajectory.begin() || path_pos >= 0.0)
+  while (start1 != 0 || path_pos >= 0.0)
   {
-    if (start1->path_pos_ <= path_pos)
+    if (start_trajectory[start1].path_pos_ <= path_pos)
     {
-      trajectory.push_front(TrajectoryStep(path_pos, path_vel));
+      trajectory.push_back(TrajectoryStep(path_pos, path_vel));
       path_vel -= time_step_ * acceleration;
-      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.front().path_vel_);
+      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.back().path_vel_);
       acceleration = getMinMaxPathAcceleration(path_pos, path_vel, false);
-      slope = (trajectory.front().path_vel_ - path_vel) / (trajectory.front().path_pos_ - path_pos);
+      slope = (trajectory.back().path_vel_ - path_vel) / (trajectory.back().path_pos_ - path_pos);
 
       if (path_vel < 0.0)
       {
         valid_ = false;
         RCLCPP_ERROR(LOGGER, "Error while integrating backward: Negative path velocity");
-        end_trajectory_ = trajectory;
+        end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
         return;
       }
     }
@@ -662,24 +655,25 @@ void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory,
 
     // Check for intersection between current start trajectory and backward
     // trajectory segments
-    const double start_slope = (start2->path_vel_ - start1->path_vel_) / (start2->path_pos_ - start1->path_pos_);
+    const TrajectoryStep& step1 = start_trajectory[start1];
+    const TrajectoryStep& step2 = start_trajectory[start2];
+    const double start_slope = (step2.path_vel_ - step1.path_vel_) / (step2.path_pos_ - step1.path_pos_);
     const double intersection_path_pos =
-        (start1->path_vel_ - path_vel + slope * path_pos - start_slope * start1->path_pos_) / (slope - start_slope);
-    if (std::max(start1->path_pos_, path_pos) - EPS <= intersection_path_pos &&
-        intersection_path_pos <= EPS + std::min(start2->path_pos_, trajectory.front().path_pos_))
+        (step1.path_vel_ - path_vel + slope * path_pos - start_slope * step1.path_pos_) / (slope - start_slope);
+    if (std::max(step1.path_pos_, path_pos) - EPS <= intersection_path_pos &&
+        intersection_path_pos <= EPS + std::min(step2.path_pos_, trajectory.back().path_pos_))
     {
-      const double intersection_path_vel =
-          start1->path_vel_ + start_slope * (intersection_path_pos - start1->path_pos_);
-      start_trajectory.erase(start2, start_trajectory.end());
+      const double intersection_path_vel = step1.path_vel_ + start_slope * (intersection_path_pos - step1.path_pos_);
+      start_trajectory.resize(start2);
       start_trajectory.push_back(TrajectoryStep(intersection_path_pos, intersection_path_vel));
-      start_trajectory.splice(start_trajectory.end(), trajectory);
+      start_trajectory.insert(start_trajectory.end(), trajectory.rbegin(), trajectory.rend());
       return;
     }
   }
 
   valid_ = false;
   RCLCPP_ERROR(LOGGER, "Error while integrating backward: Did not hit start trajectory");
-  end_trajectory_ = trajectory;
+  end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
 }
 
 double Trajectory::getMinMaxPathAcceleration(double path_pos, double path_vel, bool max)
@@ -781,33 +775,24 @@ double Trajectory::getDuration() const
   return trajectory_.back().time_;
 }
 
-std::list<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
+std::vector<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
 {
   if (time >= trajectory_.back().time_)
   {
-    std::list<TrajectoryStep>::const_iterator last = trajectory_.end();
-    last--;
-    return last;
+    return trajectory_.end() - 1;
   }
   else
   {
-    if (time < cached_time_)
-    {
-      cached_trajectory_segment_ = trajectory_.begin();
-    }
-    while (time >= cached_trajectory_segment_->time_)
-    {
-      ++cached_trajectory_segment_;
-    }
-    cached_time_ = time;
-    return cached_trajectory_segment_;
+    // first step after time
+    return std::upper_bound(trajectory_.begin(), trajectory_.end(), time,
+                            [](double time, const TrajectoryStep& step) { return time < step.time_; });
   }
 }
 
 Eigen::VectorXd Trajectory::getPosition(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -823,8 +808,8 @@ Eigen::VectorXd Trajectory::getPosition(double time) const
 
 Eigen::VectorXd Trajectory::getVelocity(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -840,8 +825,8 @@ Eigen::VectorXd Trajectory::getVelocity(double time) const
 
 Eigen::VectorXd Trajectory::getAcceleration(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -878,6 +863,21 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
     return false;
   }
 
+  Eigen::VectorXd max_velocity;
+  Eigen::VectorXd max_acceleration;
+  if (!getRobotModelBounds(group, max_velocity_scaling_factor, max_acceleration_scaling_factor, max_velocity,
+                           max_acceleration))
+    return false;
+
+  return doTimeParameterizationCalculations(trajectory, max_velocity, max_acceleration);
+}
+
+bool TimeOptimalTrajectoryGeneration::getRobotModelBounds(const moveit::core::JointModelGroup* group,
+                                                          const double max_velocity_scaling_factor,
+                                                          const double max_acceleration_scaling_factor,
+                                                          Eigen::VectorXd& max_velocity,
+                                                          Eigen::VectorXd& max_acceleration) const
+{
   // Validate scaling
   double velocity_scaling_factor = verifyScalingFactor(max_velocity_scaling_factor, VELOCITY);
   double acceleration_scaling_factor = verifyScalingFactor(max_acceleration_scaling_factor, ACCELERATION);
@@ -892,8 +892,8 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
   }
 
   const size_t num_active_joints = active_joint_indices.size();
-  Eigen::VectorXd max_velocity(num_active_joints);
-  Eigen::VectorXd max_acceleration(num_active_joints);
+  max_velocity.resize(num_active_joints);
+  max_acceleration.resize(num_active_joints);
   for (size_t idx = 0; idx < num_active_joints; ++idx)
   {
     // For active joints only (skip mimic joints and other types)
@@ -940,7 +940,7 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
     }
   }
 
-  return doTimeParameterizationCalculations(trajectory, max_velocity, max_acceleration);
+  return true;
 }
 
 bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
@@ -1072,6 +1072,87 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(
   return doTimeParameterizationCalculations(trajectory, max_velocity, max_acceleration);
 }
 
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(
+    const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories, const double max_velocity_scaling_factor,
+    const double max_acceleration_scaling_factor, const unsigned int num_threads) const
+{
+  std::atomic<std::size_t> next_trajectory{ 0 };
+  std::atomic<bool> success{ true };
+  const auto worker = [&] {
+    for (std::size_t i = next_trajectory++; i < trajectories.size(); i = next_trajectory++)
+    {
+      if (!computeTimeStamps(*trajectories[i], max_velocity_scaling_factor, max_acceleration_scaling_factor))
+      {
+        RCLCPP_ERROR(LOGGER, "Failed to time-parameterize trajectory %zu", i);
+        success = false;
+      }
+    }
+  };
+
+  std::size_t thread_count = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, trajectories.size());
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < thread_count; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return success;
+}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStampsIncremental(robot_trajectory::RobotTrajectory& trajectory,
+                                                                   const std::size_t splice_index,
+                                                                   const double max_velocity_scaling_factor,
+                                                                   const double max_acceleration_scaling_factor) const
+{
+  const std::size_t num_points = trajectory.getWayPointCount();
+  if (splice_index >= num_points)
+  {
+    RCLCPP_ERROR(LOGGER, "Splice index %zu is out of range for a trajectory with %zu waypoints", splice_index,
+                 num_points);
+    return false;
+  }
+  // Nothing was appended after the splice
+  if (splice_index + 1 == num_points)
+    return true;
+
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  if (!group)
+  {
+    RCLCPP_ERROR(LOGGER, "It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+
+  Eigen::VectorXd max_velocity;
+  Eigen::VectorXd max_acceleration;
+  if (!getRobotModelBounds(group, max_velocity_scaling_factor, max_acceleration_scaling_factor, max_velocity,
+                           max_acceleration))
+    return false;
+
+  // Copy the suffix, so that the trajectory is left untouched if parameterization fails
+  robot_trajectory::RobotTrajectory suffix(trajectory.getRobotModel(), group);
+  for (std::size_t p = splice_index; p < num_points; ++p)
+    suffix.addSuffixWayPoint(trajectory.getWayPoint(p), 0.0);
+
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const moveit::core::RobotState& splice_waypoint = trajectory.getWayPoint(splice_index);
+  Eigen::VectorXd initial_velocity(idx.size());
+  for (size_t j = 0; j < idx.size(); ++j)
+    initial_velocity[j] = splice_waypoint.getVariableVelocity(idx[j]);
+
+  if (!doTimeParameterizationCalculations(suffix, max_velocity, max_acceleration, initial_velocity))
+    return false;
+
+  // Keep the prefix including the splice waypoint, then continue with the re-timed suffix
+  robot_trajectory::RobotTrajectory spliced(trajectory.getRobotModel(), group);
+  spliced.append(trajectory, trajectory.getWayPointDurationFromPrevious(0), 0, splice_index + 1);
+  if (suffix.getWayPointCount() > 1)
+    spliced.append(suffix, suffix.getWayPointDurationFromPrevious(1), 1);
+  trajectory.swap(spliced);
+  return true;
+}
+
 bool totgComputeTimeStamps(const size_t num_waypoints, robot_trajectory::RobotTrajectory& trajectory,
                            const double max_velocity_scaling_factor, const double max_acceleration_scaling_factor)
 {
@@ -1099,10 +1180,15 @@ bool totgComputeTimeStamps(const size_t num_waypoints, robot_trajectory::RobotTr
 
 bool TimeOptimalTrajectoryGeneration::doTimeParameterizationCalculations(robot_trajectory::RobotTrajectory& trajectory,
                                                                          const Eigen::VectorXd& max_velocity,
-                                                                         const Eigen::VectorXd& max_acceleration) const
+                                                                         const Eigen::VectorXd& max_acceleration,
+                                                                         const Eigen::VectorXd& initial_velocity) const
 {
-  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
-  trajectory.unwind();
+  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first.
+  // When continuing a moving trajectory, the first waypoint must keep its exact position.
+  if (initial_velocity.size() == 0)
+    trajectory.unwind();
+  else
+    trajectory.unwind(moveit::core::RobotState(trajectory.getWayPoint(0)));
 
   const moveit::core::JointModelGroup* group = trajectory.getGroup();
   if (!group)
@@ -1123,7 +1209,8 @@ bool TimeOptimalTrajectoryGeneration::doTimeParameterizationCalculations(robot_t
 
   // Have to convert into Eigen data structs and remove repeated points
   //  (https://github.com/tobiaskunz/trajectories/issues/3)
-  std::list<Eigen::VectorXd> points;
+  std::vector<Eigen::VectorXd> points;
+  points.reserve(num_points);
   for (size_t p = 0; p < num_points; ++p)
   {
     moveit::core::RobotStatePtr waypoint = trajectory.getWayPointPtr(p);
@@ -1156,6 +1243,11 @@ bool TimeOptimalTrajectoryGeneration::doTimeParameterizationCalculations(robot_t
   // Return trajectory with only the first waypoint if there are not multiple diverse points
   if (points.size() == 1)
   {
+    if (initial_velocity.size() > 0 && !initial_velocity.isZero())
+    {
+      RCLCPP_ERROR(LOGGER, "Unable to come to rest from a moving start without any diverse waypoints.");
+      return false;
+    }
     moveit::core::RobotState waypoint = moveit::core::RobotState(trajectory.getWayPoint(0));
     waypoint.zeroVelocities();
     waypoint.zeroAccelerations();
@@ -1165,7 +1257,25 @@ bool TimeOptimalTrajectoryGeneration::doTimeParameterizationCalculations(robot_t
   }
 
   // Now actually call the algorithm
-  Trajectory parameterized(Path(points, path_tolerance_), max_velocity, max_acceleration, DEFAULT_TIMESTEP);
+  Path path(points, path_tolerance_);
+  // The path can only start with a velocity along its direction, any other velocity would jump at the start
+  double initial_path_velocity = 0.0;
+  if (initial_velocity.size() > 0)
+  {
+    const Eigen::VectorXd tangent = path.getTangent(0.0);
+    initial_path_velocity = tangent.dot(initial_velocity);
+    const double off_path_velocity = (initial_velocity - initial_path_velocity * tangent).norm();
+    if (initial_path_velocity < -EPS || off_path_velocity > EPS + INITIAL_VELOCITY_TOLERANCE * initial_velocity.norm())
+    {
+      RCLCPP_ERROR(LOGGER,
+                   "The initial velocity does not point along the path: %f along it, %f off it. Splice where the "
+                   "robot moves towards the appended waypoints.",
+                   initial_path_velocity, off_path_velocity);
+      return false;
+    }
+    initial_path_velocity = std::max(0.0, initial_path_velocity);
+  }
+  Trajectory parameterized(path, max_velocity, max_acceleration, DEFAULT_TIMESTEP, initial_path_velocity);
   if (!parameterized.isValid())
   {
     RCLCPP_ERROR(LOGGER, "Unable to parameterize trajectory.");
@@ -139,6 +139,49 @@ TEST_F(RuckigTests, trajectory_duration)
   EXPECT_LT(trajectory_->getWayPointDurationFromStart(trajectory_->getWayPointCount() - 1), 1.11 * ideal_duration);
 }
 
+TEST_F(RuckigTests, reuse_workspace)
+{
+  // Smoothing with a reused workspace must give the same result as smoothing with fresh buffers
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.zeroVelocities();
+  robot_state.zeroAccelerations();
+  for (double position : { 0.0, 0.1, 0.3, 0.2 })
+  {
+    robot_state.setVariablePosition("panda_joint1", position);
+    trajectory_->addSuffixWayPoint(robot_state, DEFAULT_TIMESTEP);
+  }
+  const robot_trajectory::RobotTrajectory input_trajectory(*trajectory_, true /* deep copy */);
+
+  ASSERT_TRUE(smoother_.applySmoothing(*trajectory_, 1.0 /* max vel scaling factor */,
+                                       1.0 /* max accel scaling factor */, true /* mitigate overshoot */));
+
+  // Use the workspace a few times, also with a longer trajectory in between
+  trajectory_processing::RuckigSmoothing::Workspace workspace;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    robot_trajectory::RobotTrajectory trajectory(input_trajectory, true /* deep copy */);
+    if (i == 1)
+    {
+      trajectory.append(robot_trajectory::RobotTrajectory(input_trajectory, true /* deep copy */), DEFAULT_TIMESTEP);
+    }
+    ASSERT_TRUE(smoother_.applySmoothing(workspace, trajectory, 1.0 /* max vel scaling factor */,
+                                         1.0 /* max accel scaling factor */, true /* mitigate overshoot */));
+    if (i == 1)
+    {
+      continue;
+    }
+
+    ASSERT_EQ(trajectory.getWayPointCount(), trajectory_->getWayPointCount());
+    for (size_t waypoint_idx = 0; waypoint_idx < trajectory.getWayPointCount(); ++waypoint_idx)
+    {
+      EXPECT_DOUBLE_EQ(trajectory.getWayPointDurationFromPrevious(waypoint_idx),
+                       trajectory_->getWayPointDurationFromPrevious(waypoint_idx));
+    }
+  }
+}
+
 TEST_F(RuckigTests, single_waypoint)
 {
   // With only one waypoint, Ruckig cannot smooth the trajectory.
@@ -167,6 +210,33 @@ TEST_F(RuckigTests, single_waypoint)
   }
 }
 
+TEST_F(RuckigTests, long_trajectory_with_overshoot_mitigation)
+{
+  // Every segment is extended on its own, so the intermediate segments stay within the maximum extension of their
+  // original duration, however many other segments needed one
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.zeroVelocities();
+  robot_state.zeroAccelerations();
+  std::vector<double> joint_positions;
+  robot_state.copyJointGroupPositions(JOINT_GROUP, joint_positions);
+  for (size_t waypoint_idx = 0; waypoint_idx < 100; ++waypoint_idx)
+  {
+    // alternate the direction of joint 0, so that segments start and end at rest but with changing targets
+    joint_positions.at(0) += (waypoint_idx % 2 == 0) ? 0.05 : -0.03;
+    robot_state.setJointGroupPositions(JOINT_GROUP, joint_positions);
+    trajectory_->addSuffixWayPoint(robot_state, DEFAULT_TIMESTEP);
+  }
+
+  EXPECT_TRUE(smoother_.applySmoothing(*trajectory_, 1.0 /* max vel scaling factor */,
+                                       1.0 /* max accel scaling factor */, true /* mitigate overshoot */));
+  for (size_t waypoint_idx = 1; waypoint_idx < trajectory_->getWayPointCount() - 1; ++waypoint_idx)
+  {
+    EXPECT_GE(trajectory_->getWayPointDurationFromPrevious(waypoint_idx), DEFAULT_TIMESTEP);
+    EXPECT_LT(trajectory_->getWayPointDurationFromPrevious(waypoint_idx), 10.0 * DEFAULT_TIMESTEP);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
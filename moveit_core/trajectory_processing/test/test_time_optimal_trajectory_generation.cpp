@@ -342,6 +342,155 @@ TEST(time_optimal_trajectory_generation, testLastWaypoint)
                          }));
 }
 
+// Batched parameterization should produce the same result as parameterizing each trajectory on its own
+TEST(time_optimal_trajectory_generation, testBatchedComputeTimeStamps)
+{
+  constexpr auto robot_name{ "panda" };
+  constexpr auto group_name{ "panda_arm" };
+
+  auto robot_model = moveit::core::loadTestingRobotModel(robot_name);
+  ASSERT_TRUE(robot_model) << "Failed to load robot model" << robot_name;
+  set_acceleration_limits(robot_model);
+  auto group = robot_model->getJointModelGroup(group_name);
+  ASSERT_TRUE(group) << "Failed to load joint model group " << group_name;
+  moveit::core::RobotState waypoint_state(robot_model);
+  waypoint_state.setToDefaultValues();
+
+  std::vector<robot_trajectory::RobotTrajectoryPtr> batch;
+  std::vector<robot_trajectory::RobotTrajectoryPtr> expected;
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, group);
+    const double offset = 0.05 * i;
+    waypoint_state.setJointGroupPositions(group, std::vector<double>{ offset, 0, 0, -1.5, 0, 1.5, 0 });
+    trajectory->addSuffixWayPoint(waypoint_state, 0.0);
+    waypoint_state.setJointGroupPositions(group, std::vector<double>{ offset + 0.5, 0.3, 0, -1.2, 0, 1.5, 0 });
+    trajectory->addSuffixWayPoint(waypoint_state, 0.0);
+    waypoint_state.setJointGroupPositions(group, std::vector<double>{ offset + 1.0, 0.1, 0.4, -1.0, 0.2, 1.5, 0 });
+    trajectory->addSuffixWayPoint(waypoint_state, 0.0);
+    batch.push_back(trajectory);
+    expected.push_back(std::make_shared<robot_trajectory::RobotTrajectory>(*trajectory, true));
+  }
+
+  TimeOptimalTrajectoryGeneration totg;
+  for (const auto& trajectory : expected)
+    ASSERT_TRUE(totg.computeTimeStamps(*trajectory));
+  ASSERT_TRUE(totg.computeTimeStamps(batch, 1.0, 1.0, 4));
+
+  for (std::size_t i = 0; i < batch.size(); ++i)
+  {
+    ASSERT_EQ(batch[i]->getWayPointCount(), expected[i]->getWayPointCount());
+    EXPECT_DOUBLE_EQ(batch[i]->getDuration(), expected[i]->getDuration());
+  }
+}
+
+// Appending waypoints and re-timing only the suffix should keep the prefix and continue from the splice velocity
+TEST(time_optimal_trajectory_generation, testIncrementalComputeTimeStamps)
+{
+  constexpr auto robot_name{ "panda" };
+  constexpr auto group_name{ "panda_arm" };
+
+  auto robot_model = moveit::core::loadTestingRobotModel(robot_name);
+  ASSERT_TRUE(robot_model) << "Failed to load robot model" << robot_name;
+  set_acceleration_limits(robot_model);
+  auto group = robot_model->getJointModelGroup(group_name);
+  ASSERT_TRUE(group) << "Failed to load joint model group " << group_name;
+  moveit::core::RobotState waypoint_state(robot_model);
+  waypoint_state.setToDefaultValues();
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ 0, 0, 0, -1.5, 0, 1.5, 0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.0);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ 1.0, 0.3, 0, -1.2, 0, 1.5, 0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.0);
+
+  TimeOptimalTrajectoryGeneration totg;
+  ASSERT_TRUE(totg.computeTimeStamps(trajectory));
+  EXPECT_FALSE(totg.computeTimeStampsIncremental(trajectory, trajectory.getWayPointCount()));
+
+  // Splice in the middle of the old trajectory, where the robot is still moving
+  const std::size_t splice_index = trajectory.getWayPointCount() / 2;
+  const double splice_time = trajectory.getWayPointDurationFromStart(splice_index);
+  const moveit::core::RobotState splice_waypoint = trajectory.getWayPoint(splice_index);
+  ASSERT_GT(splice_waypoint.getVariableVelocity("panda_joint1"), 0.0);
+
+  const std::vector<double> goal{ 1.5, 0.6, 0.2, -1.0, 0.1, 1.5, 0 };
+  waypoint_state.setJointGroupPositions(group, goal);
+  trajectory.addSuffixWayPoint(waypoint_state, 0.0);
+  ASSERT_TRUE(totg.computeTimeStampsIncremental(trajectory, splice_index));
+
+  // The prefix is kept as it was
+  EXPECT_DOUBLE_EQ(trajectory.getWayPointDurationFromStart(splice_index), splice_time);
+  EXPECT_DOUBLE_EQ(trajectory.getWayPoint(splice_index).getVariableVelocity("panda_joint1"),
+                   splice_waypoint.getVariableVelocity("panda_joint1"));
+
+  // Velocity is continuous across the splice: it cannot change faster than the acceleration limit allows
+  const double dt = trajectory.getWayPointDurationFromPrevious(splice_index + 1);
+  for (const std::string& variable : group->getVariableNames())
+  {
+    EXPECT_NEAR(trajectory.getWayPoint(splice_index + 1).getVariableVelocity(variable),
+                splice_waypoint.getVariableVelocity(variable), 1.0 * dt + 1e-3)
+        << "Velocity jump at the splice for " << variable;
+  }
+
+  // The spliced velocity is kept, not projected: the displacement of the first step of the suffix matches it
+  Eigen::VectorXd splice_position, next_position, splice_velocity;
+  splice_waypoint.copyJointGroupPositions(group, splice_position);
+  splice_waypoint.copyJointGroupVelocities(group, splice_velocity);
+  trajectory.getWayPoint(splice_index + 1).copyJointGroupPositions(group, next_position);
+  EXPECT_LE((next_position - splice_position - splice_velocity * dt).norm(), 0.5 * dt * dt * std::sqrt(7.0) + 1e-3);
+
+  // The robot comes to rest at the appended goal
+  std::vector<double> last_waypoint;
+  trajectory.getLastWayPoint().copyJointGroupPositions(group, last_waypoint);
+  for (std::size_t i = 0; i < goal.size(); ++i)
+  {
+    EXPECT_NEAR(last_waypoint[i], goal[i], 1e-6);
+    EXPECT_NEAR(trajectory.getLastWayPoint().getVariableVelocity(group->getVariableNames()[i]), 0.0, 1e-6);
+  }
+}
+
+TEST(time_optimal_trajectory_generation, testIncrementalRejectsVelocityOffThePath)
+{
+  constexpr auto robot_name{ "panda" };
+  constexpr auto group_name{ "panda_arm" };
+
+  auto robot_model = moveit::core::loadTestingRobotModel(robot_name);
+  ASSERT_TRUE(robot_model) << "Failed to load robot model" << robot_name;
+  set_acceleration_limits(robot_model);
+  auto group = robot_model->getJointModelGroup(group_name);
+  ASSERT_TRUE(group) << "Failed to load joint model group " << group_name;
+  moveit::core::RobotState waypoint_state(robot_model);
+  waypoint_state.setToDefaultValues();
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ 0, 0, 0, -1.5, 0, 1.5, 0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.0);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ 1.0, 0.3, 0, -1.2, 0, 1.5, 0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.0);
+
+  TimeOptimalTrajectoryGeneration totg;
+  ASSERT_TRUE(totg.computeTimeStamps(trajectory));
+
+  // Keep the old trajectory up to a waypoint where the robot is still moving
+  const std::size_t splice_index = trajectory.getWayPointCount() / 2;
+  ASSERT_GT(trajectory.getWayPoint(splice_index).getVariableVelocity("panda_joint1"), 0.0);
+  robot_trajectory::RobotTrajectory prefix(robot_model, group);
+  prefix.append(trajectory, 0.0, 0, splice_index + 1);
+
+  // Turning away from the direction of motion would need a velocity jump at the splice
+  for (const std::vector<double>& goal : { std::vector<double>{ 0.5, 0.6, 0, -1.3, 0.4, 1.5, 0 },
+                                           std::vector<double>{ 0, 0, 0, -1.5, 0, 1.5, 0 } })
+  {
+    robot_trajectory::RobotTrajectory spliced(prefix, true /* deep copy */);
+    waypoint_state.setJointGroupPositions(group, goal);
+    spliced.addSuffixWayPoint(waypoint_state, 0.0);
+    EXPECT_FALSE(totg.computeTimeStampsIncremental(spliced, splice_index));
+    // The trajectory is left unchanged
+    EXPECT_EQ(spliced.getWayPointCount(), splice_index + 2);
+  }
+}
+
 TEST(time_optimal_trajectory_generation, testPluginAPI)
 {
   constexpr auto robot_name{ "panda" };
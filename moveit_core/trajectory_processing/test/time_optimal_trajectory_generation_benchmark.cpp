@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmarks for time-optimal trajectory generation on long and batched trajectories */
+
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <chrono>
+#include <random>
+#include <gtest/gtest.h>
+
+using trajectory_processing::Path;
+using trajectory_processing::TimeOptimalTrajectoryGeneration;
+using trajectory_processing::Trajectory;
+
+namespace
+{
+// Helper class to measure time within a scoped block and output the result
+class ScopedTimer
+{
+  const char* const msg_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedTimer(const char* msg = "") : msg_(msg), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms\n";
+  }
+};
+
+// The URDF used in moveit::core::loadTestingRobotModel() does not contain acceleration limits,
+// so add them here.
+void set_acceleration_limits(const moveit::core::RobotModelPtr& robot_model)
+{
+  for (auto& joint_model : robot_model->getActiveJointModels())
+  {
+    std::vector<moveit_msgs::msg::JointLimits> joint_bounds_msg(joint_model->getVariableBoundsMsg());
+    for (auto& joint_bound : joint_bounds_msg)
+    {
+      joint_bound.has_acceleration_limits = true;
+      joint_bound.max_acceleration = 1.0;
+    }
+    joint_model->setVariableBounds(joint_bounds_msg);
+  }
+}
+
+// Random walk with a slight drift so that consecutive waypoints are never identical
+std::vector<Eigen::VectorXd> randomWalk(std::size_t num_waypoints, Eigen::Index dof, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> step(-0.05, 0.05);
+  std::vector<Eigen::VectorXd> waypoints;
+  waypoints.reserve(num_waypoints);
+  Eigen::VectorXd waypoint = Eigen::VectorXd::Zero(dof);
+  for (std::size_t i = 0; i < num_waypoints; ++i)
+  {
+    for (Eigen::Index j = 0; j < dof; ++j)
+      waypoint[j] += step(rng) + 0.01;
+    waypoints.push_back(waypoint);
+  }
+  return waypoints;
+}
+}  // namespace
+
+TEST(TimeOptimalTrajectoryGenerationBenchmark, longPath)
+{
+  std::mt19937 rng(42);
+  const Eigen::VectorXd max_velocity = Eigen::VectorXd::Constant(6, 1.0);
+  const Eigen::VectorXd max_acceleration = Eigen::VectorXd::Constant(6, 2.0);
+  for (std::size_t num_waypoints : { 1000, 10000 })
+  {
+    const std::vector<Eigen::VectorXd> waypoints = randomWalk(num_waypoints, 6, rng);
+    std::cerr << num_waypoints << " waypoints: ";
+    ScopedTimer t("Path + Trajectory: ");
+    Trajectory trajectory(Path(waypoints, 0.1), max_velocity, max_acceleration, 0.001);
+    EXPECT_TRUE(trajectory.isValid());
+  }
+}
+
+TEST(TimeOptimalTrajectoryGenerationBenchmark, batchedTrajectories)
+{
+  auto robot_model = moveit::core::loadTestingRobotModel("panda");
+  ASSERT_TRUE(robot_model);
+  set_acceleration_limits(robot_model);
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup("panda_arm");
+  ASSERT_TRUE(group);
+
+  std::mt19937 rng(42);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  auto make_trajectories = [&] {
+    rng.seed(42);
+    std::vector<robot_trajectory::RobotTrajectoryPtr> trajectories;
+    for (std::size_t i = 0; i < 32; ++i)
+    {
+      auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, group);
+      for (const Eigen::VectorXd& waypoint : randomWalk(200, group->getVariableCount(), rng))
+      {
+        state.setJointGroupPositions(group, waypoint);
+        trajectory->addSuffixWayPoint(state, 0.0);
+      }
+      trajectories.push_back(trajectory);
+    }
+    return trajectories;
+  };
+
+  TimeOptimalTrajectoryGeneration totg;
+  {
+    std::vector<robot_trajectory::RobotTrajectoryPtr> trajectories = make_trajectories();
+    ScopedTimer t("32 trajectories, sequential: ");
+    for (const auto& trajectory : trajectories)
+      EXPECT_TRUE(totg.computeTimeStamps(*trajectory));
+  }
+  {
+    std::vector<robot_trajectory::RobotTrajectoryPtr> trajectories = make_trajectories();
+    ScopedTimer t("32 trajectories, batched: ");
+    EXPECT_TRUE(totg.computeTimeStamps(trajectories));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
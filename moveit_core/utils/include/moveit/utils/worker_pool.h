@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief Runs the iterations of a parallel loop on a fixed set of threads
+ *
+ *  Planners that evaluate every waypoint of every iteration in parallel would spend more on starting threads per
+ *  call than they save. The pool keeps its threads waiting between calls instead. The calling thread takes part in
+ *  every loop as worker 0, so a pool of one worker runs everything inline. */
+class WorkerPool
+{
+public:
+  /** \brief Create a pool with \e num_workers workers (including the calling thread), 0 uses all hardware threads */
+  explicit WorkerPool(std::size_t num_workers)
+  {
+    if (num_workers == 0)
+      num_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    threads_.reserve(num_workers - 1);
+    for (std::size_t worker = 1; worker < num_workers; ++worker)
+      threads_.emplace_back([this, worker] { workerLoop(worker); });
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      shutdown_ = true;
+    }
+    wake_up_.notify_all();
+    for (std::thread& thread : threads_)
+      thread.join();
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  std::size_t getNumWorkers() const
+  {
+    return threads_.size() + 1;
+  }
+
+  /** \brief Call fn(index, worker) for every index in [0, \e count) and block until all calls returned.
+   *
+   *  Each worker index is used by one thread at a time, so it can select per-thread scratch data. */
+  void run(std::size_t count, const std::function<void(std::size_t index, std::size_t worker)>& fn)
+  {
+    if (threads_.empty() || count < 2)
+    {
+      for (std::size_t index = 0; index < count; ++index)
+        fn(index, 0);
+      return;
+    }
+
+    std::scoped_lock run_lock(run_mutex_);
+    {
+      std::scoped_lock lock(mutex_);
+      fn_ = &fn;
+      count_ = count;
+      next_index_ = 0;
+      busy_workers_ = threads_.size();
+      ++generation_;
+    }
+    wake_up_.notify_all();
+
+    runIndices(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_workers_ == 0; });
+    fn_ = nullptr;
+  }
+
+private:
+  void runIndices(std::size_t worker)
+  {
+    for (std::size_t index = next_index_++; index < count_; index = next_index_++)
+      (*fn_)(index, worker);
+  }
+
+  void workerLoop(std::size_t worker)
+  {
+    std::size_t generation = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_up_.wait(lock, [&] { return shutdown_ || generation_ != generation; });
+        if (shutdown_)
+          return;
+        generation = generation_;
+      }
+
+      runIndices(worker);
+
+      {
+        std::scoped_lock lock(mutex_);
+        --busy_workers_;
+      }
+      done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex run_mutex_;  // serializes concurrent run() calls
+
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  std::condition_variable done_;
+  const std::function<void(std::size_t, std::size_t)>* fn_ = nullptr;
+  std::size_t count_ = 0;
+  std::atomic<std::size_t> next_index_{ 0 };
+  std::size_t busy_workers_ = 0;
+  std::size_t generation_ = 0;
+  bool shutdown_ = false;
+};
+}  // namespace core
+}  // namespace moveit
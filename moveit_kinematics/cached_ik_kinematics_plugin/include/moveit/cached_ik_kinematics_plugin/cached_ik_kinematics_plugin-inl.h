@@ -190,6 +190,68 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
   return solution_found;
 }
 
+template <class KinematicsPlugin>
+bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIKBatch(
+    const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<std::vector<double>>& ik_seed_states,
+    double timeout, std::vector<std::vector<double>>& solutions,
+    std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes, const IKCallbackFn& solution_callback,
+    const KinematicsQueryOptions& options) const
+{
+  if (!KinematicsPlugin::prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  std::chrono::time_point<std::chrono::system_clock> start(std::chrono::system_clock::now());
+  std::vector<Pose> poses;
+  // entries are copied, as updating the cache may invalidate references to them
+  std::vector<IKEntry> nearest;
+  std::vector<std::vector<double>> cache_seeds;
+  poses.reserve(ik_poses.size());
+  nearest.reserve(ik_poses.size());
+  cache_seeds.reserve(ik_poses.size());
+  for (const geometry_msgs::msg::Pose& ik_pose : ik_poses)
+  {
+    poses.emplace_back(ik_pose);
+    nearest.push_back(cache_.getBestApproximateIKSolution(poses.back()));
+    cache_seeds.push_back(nearest.back().second);
+  }
+
+  bool all_solved = KinematicsPlugin::searchPositionIKBatch(ik_poses, cache_seeds, timeout, solutions, error_codes,
+                                                            solution_callback, options);
+  if (!all_solved)
+  {
+    std::vector<std::size_t> failed;
+    std::vector<geometry_msgs::msg::Pose> failed_poses;
+    std::vector<std::vector<double>> failed_seeds;
+    for (std::size_t i = 0; i < ik_poses.size(); ++i)
+    {
+      if (error_codes[i].val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+        continue;
+      failed.push_back(i);
+      failed_poses.push_back(ik_poses[i]);
+      failed_seeds.push_back(ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i]);
+    }
+
+    std::chrono::duration<double> diff = std::chrono::system_clock::now() - start;
+    std::vector<std::vector<double>> retry_solutions;
+    std::vector<moveit_msgs::msg::MoveItErrorCodes> retry_error_codes;
+    all_solved = KinematicsPlugin::searchPositionIKBatch(failed_poses, failed_seeds, diff.count() / ik_poses.size(),
+                                                         retry_solutions, retry_error_codes, solution_callback,
+                                                         options);
+    for (std::size_t i = 0; i < failed.size(); ++i)
+    {
+      solutions[failed[i]] = std::move(retry_solutions[i]);
+      error_codes[failed[i]] = retry_error_codes[i];
+    }
+  }
+
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    if (error_codes[i].val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+      cache_.updateCache(nearest[i], poses[i], solutions[i]);
+  }
+  return all_solved;
+}
+
 template <class KinematicsPlugin>
 bool CachedMultiTipIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
     const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state, double timeout,
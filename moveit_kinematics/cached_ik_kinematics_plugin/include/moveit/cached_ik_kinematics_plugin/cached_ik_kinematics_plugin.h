@@ -42,7 +42,10 @@
 #include <moveit/robot_model/robot_model.h>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/LinearMath/Vector3.h>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <filesystem>
@@ -122,6 +125,12 @@ protected:
   /** save current state of cache to disk */
   void saveCache() const;
 
+  /** append (poses,config) to the cache and, in batches, to the nearest neighbor data structure */
+  void addEntry(const std::vector<Pose>& poses, const std::vector<double>& config) const;
+
+  /** create an empty nearest neighbor data structure over IK cache entries */
+  static std::unique_ptr<NearestNeighborsGNAT<IKEntry*>> createNearestNeighbors();
+
   /** number of joints in the system */
   unsigned int num_joints_;
 
@@ -136,17 +145,29 @@ protected:
 
   /**
     the IK methods are declared const in the base class, but the
-    wrapped methods need to modify the cache, so the next four members
+    wrapped methods need to modify the cache, so the next six members
     are mutable
     cache of IK solutions
   */
   mutable std::vector<IKEntry> ik_cache_;
-  /** nearest neighbor data structure over IK cache entries */
-  mutable NearestNeighborsGNAT<IKEntry*> ik_nn_;
+  /**
+    nearest neighbor data structure over IK cache entries; null while
+    it is being built for a cache loaded from disk
+  */
+  mutable std::unique_ptr<NearestNeighborsGNAT<IKEntry*>> ik_nn_;
+  /** cache entries not yet added to ik_nn_ */
+  mutable std::vector<IKEntry*> pending_entries_;
   /** size of the cache when it was last saved */
   mutable unsigned int last_saved_cache_size_{ 0 };
-  /** mutex for changing IK cache */
+  /** mutex for changing IK cache, pending_entries_ and the cache file */
   mutable std::mutex lock_;
+  /**
+    mutex for ik_nn_; queries share it, so they only wait while a batch
+    of pending entries is added
+  */
+  mutable std::shared_mutex nn_lock_;
+  /** thread building ik_nn_ for a cache loaded from disk */
+  std::thread index_thread_;
 };
 
 /** a container of IK caches for cases where there is no fixed base frame */
@@ -261,6 +282,15 @@ public:
                         const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
                         const KinematicsQueryOptions& options = KinematicsQueryOptions()) const override;
 
+  /** seed each pose with its nearest cache entry and solve all of them with a single batch query of the wrapped
+      solver, retrying the failed ones from the given seed states */
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                             const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                             std::vector<std::vector<double>>& solutions,
+                             std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                             const IKCallbackFn& solution_callback = IKCallbackFn(),
+                             const KinematicsQueryOptions& options = KinematicsQueryOptions()) const override;
+
 private:
   rclcpp::Node::SharedPtr node_;
   std::shared_ptr<cached_ik_kinematics::ParamListener> param_listener_;
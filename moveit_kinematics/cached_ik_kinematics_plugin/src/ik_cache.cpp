@@ -34,6 +34,7 @@
 
 /* Author: Mark Moll */
 
+#include <algorithm>
 #include <numeric>
 #include <filesystem>
 #include <fstream>
@@ -42,26 +43,44 @@
 
 namespace cached_ik_kinematics_plugin
 {
-IKCache::IKCache()
+namespace
+{
+/** number of new cache entries that are added to the nearest neighbor data structure at once */
+const std::size_t PENDING_BATCH_SIZE = 16;
+}  // namespace
+
+IKCache::IKCache() : ik_nn_(createNearestNeighbors())
 {
-  // set distance function for nearest-neighbor queries
-  ik_nn_.setDistanceFunction([](const IKEntry* entry1, const IKEntry* entry2) {
-    double dist = 0.;
-    for (unsigned int i = 0; i < entry1->first.size(); ++i)
-      dist += entry1->first[i].distance(entry2->first[i]);
-    return dist;
-  });
 }
 
 IKCache::~IKCache()
 {
+  if (index_thread_.joinable())
+    index_thread_.join();
   if (!ik_cache_.empty())
     saveCache();
 }
 
+std::unique_ptr<NearestNeighborsGNAT<IKCache::IKEntry*>> IKCache::createNearestNeighbors()
+{
+  auto nn = std::make_unique<NearestNeighborsGNAT<IKEntry*>>();
+  // set distance function for nearest-neighbor queries
+  nn->setDistanceFunction([](const IKEntry* entry1, const IKEntry* entry2) {
+    double dist = 0.;
+    for (unsigned int i = 0; i < entry1->first.size(); ++i)
+      dist += entry1->first[i].distance(entry2->first[i]);
+    return dist;
+  });
+  return nn;
+}
+
 void IKCache::initializeCache(const std::string& robot_id, const std::string& group_name, const std::string& cache_name,
                               const unsigned int num_joints, const Options& opts)
 {
+  // wait for the index of a previously loaded cache
+  if (index_thread_.joinable())
+    index_thread_.join();
+
   // read ROS parameters
   max_cache_size_ = opts.max_cache_size;
   ik_cache_.reserve(max_cache_size_);
@@ -83,7 +102,11 @@ void IKCache::initializeCache(const std::string& robot_id, const std::string& gr
                                std::to_string(std::sqrt(min_config_distance2_)) + ".ikcache");
 
   ik_cache_.clear();
-  ik_nn_.clear();
+  pending_entries_.clear();
+  {
+    std::unique_lock<std::shared_mutex> nn_lock(nn_lock_);
+    ik_nn_ = createNearestNeighbors();
+  }
   last_saved_cache_size_ = 0;
   if (std::filesystem::exists(cache_file_name_))
   {
@@ -104,32 +127,53 @@ void IKCache::initializeCache(const std::string& robot_id, const std::string& gr
     unsigned int config_size = num_dofs * sizeof(double);
     unsigned int offset_conf = pose_size * num_tips;
     unsigned int bufsize = offset_conf + config_size;
-    char* buffer = new char[bufsize];
     IKEntry entry;
     entry.first.resize(num_tips);
     entry.second.resize(num_dofs);
-    ik_cache_.reserve(last_saved_cache_size_);
+    ik_cache_.reserve(std::max(max_cache_size_, last_saved_cache_size_));
+
+    // read all entries at once
+    std::vector<char> buffer(static_cast<std::size_t>(bufsize) * last_saved_cache_size_);
+    cache_file.read(buffer.data(), buffer.size());
+    if (cache_file.gcount() != static_cast<std::streamsize>(buffer.size()))
+    {
+      RCLCPP_ERROR(LOGGER, "cache file %s is truncated", cache_file_name_.string().c_str());
+      last_saved_cache_size_ = cache_file.gcount() / bufsize;
+    }
 
     for (unsigned i = 0; i < last_saved_cache_size_; ++i)
     {
+      const char* entry_buffer = buffer.data() + static_cast<std::size_t>(i) * bufsize;
       unsigned int j = 0;
-      cache_file.read(buffer, bufsize);
       for (auto& pose : entry.first)
       {
-        memcpy(&pose.position[0], buffer + j * pose_size, position_size);
-        memcpy(&pose.orientation[0], buffer + j * pose_size + position_size, orientation_size);
+        memcpy(&pose.position[0], entry_buffer + j * pose_size, position_size);
+        memcpy(&pose.orientation[0], entry_buffer + j * pose_size + position_size, orientation_size);
         ++j;
       }
-      memcpy(&entry.second[0], buffer + offset_conf, config_size);
+      memcpy(&entry.second[0], entry_buffer + offset_conf, config_size);
       ik_cache_.push_back(entry);
     }
-    RCLCPP_INFO(LOGGER, "freeing buffer");
-    delete[] buffer;
-    RCLCPP_INFO(LOGGER, "freed buffer");
+
+    // Building the nearest neighbor data structure takes long for large caches, so do it in the background.
+    // Until it is done, queries return no approximate solution and new entries are kept pending.
     std::vector<IKEntry*> ik_entry_ptrs(last_saved_cache_size_);
     for (unsigned int i = 0; i < last_saved_cache_size_; ++i)
       ik_entry_ptrs[i] = &ik_cache_[i];
-    ik_nn_.add(ik_entry_ptrs);
+    {
+      std::unique_lock<std::shared_mutex> nn_lock(nn_lock_);
+      ik_nn_.reset();
+    }
+    index_thread_ = std::thread([this, ik_entry_ptrs = std::move(ik_entry_ptrs)] {
+      std::unique_ptr<NearestNeighborsGNAT<IKEntry*>> nn = createNearestNeighbors();
+      nn->add(ik_entry_ptrs);
+
+      std::lock_guard<std::mutex> slock(lock_);
+      nn->add(pending_entries_);
+      pending_entries_.clear();
+      std::unique_lock<std::shared_mutex> nn_lock(nn_lock_);
+      ik_nn_ = std::move(nn);
+    });
   }
 
   num_joints_ = num_joints;
@@ -150,67 +194,83 @@ double IKCache::configDistance2(const std::vector<double>& config1, const std::v
 
 const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const Pose& pose) const
 {
-  if (ik_cache_.empty())
+  IKEntry query = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>());
   {
-    static IKEntry dummy = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>(num_joints_, 0.));
-    return dummy;
+    std::shared_lock<std::shared_mutex> nn_lock(nn_lock_);
+    if (ik_nn_ && ik_nn_->size() > 0)
+      return *ik_nn_->nearest(&query);
   }
-  IKEntry query = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>());
-  return *ik_nn_.nearest(&query);
+  static IKEntry dummy = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>(num_joints_, 0.));
+  return dummy;
 }
 
 const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const std::vector<Pose>& poses) const
 {
-  if (ik_cache_.empty())
+  IKEntry query = std::make_pair(poses, std::vector<double>());
   {
-    static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
-    return dummy;
+    std::shared_lock<std::shared_mutex> nn_lock(nn_lock_);
+    if (ik_nn_ && ik_nn_->size() > 0)
+      return *ik_nn_->nearest(&query);
   }
-  IKEntry query = std::make_pair(poses, std::vector<double>());
-  return *ik_nn_.nearest(&query);
+  static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
+  return dummy;
 }
 
 void IKCache::updateCache(const IKEntry& nearest, const Pose& pose, const std::vector<double>& config) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity() && (nearest.first[0].distance(pose) > min_pose_distance_ ||
-                                                  configDistance2(nearest.second, config) > min_config_distance2_))
-  {
-    std::lock_guard<std::mutex> slock(lock_);
-    ik_cache_.emplace_back(std::vector<Pose>(1u, pose), config);
-    ik_nn_.add(&ik_cache_.back());
-    if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-      saveCache();
-  }
+  if (nearest.first[0].distance(pose) > min_pose_distance_ ||
+      configDistance2(nearest.second, config) > min_config_distance2_)
+    addEntry(std::vector<Pose>(1u, pose), config);
 }
 
 void IKCache::updateCache(const IKEntry& nearest, const std::vector<Pose>& poses,
                           const std::vector<double>& config) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity())
+  bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
+  if (!add_to_cache)
   {
-    bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
-    if (!add_to_cache)
+    double dist = 0.;
+    for (unsigned int i = 0; i < poses.size(); ++i)
     {
-      double dist = 0.;
-      for (unsigned int i = 0; i < poses.size(); ++i)
+      dist += nearest.first[i].distance(poses[i]);
+      if (dist > min_pose_distance_)
       {
-        dist += nearest.first[i].distance(poses[i]);
-        if (dist > min_pose_distance_)
-        {
-          add_to_cache = true;
-          break;
-        }
+        add_to_cache = true;
+        break;
       }
     }
-    if (add_to_cache)
+  }
+  if (add_to_cache)
+    addEntry(poses, config);
+}
+
+void IKCache::addEntry(const std::vector<Pose>& poses, const std::vector<double>& config) const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  // never reallocate, as the nearest neighbor data structure and callers hold pointers to the entries
+  if (ik_cache_.size() >= ik_cache_.capacity())
+    return;
+  ik_cache_.emplace_back(poses, config);
+  pending_entries_.push_back(&ik_cache_.back());
+
+  // Add new entries in batches, and only if no query is running unless too many entries are pending,
+  // so that concurrent queries rarely wait for updates.
+  if (pending_entries_.size() >= PENDING_BATCH_SIZE)
+  {
+    std::unique_lock<std::shared_mutex> nn_lock(nn_lock_, std::defer_lock);
+    if (pending_entries_.size() >= 8 * PENDING_BATCH_SIZE)
+      nn_lock.lock();
+    else
+      nn_lock.try_lock();
+    if (nn_lock.owns_lock() && ik_nn_)
     {
-      std::lock_guard<std::mutex> slock(lock_);
-      ik_cache_.emplace_back(poses, config);
-      ik_nn_.add(&ik_cache_.back());
-      if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-        saveCache();
+      ik_nn_->add(pending_entries_);
+      pending_entries_.clear();
     }
   }
+
+  if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
+    saveCache();
 }
 
 void IKCache::saveCache() const
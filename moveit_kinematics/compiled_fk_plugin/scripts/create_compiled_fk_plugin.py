@@ -0,0 +1,380 @@
+#! /usr/bin/env python3
+"""
+Compiled Forward Kinematics Plugin Generator for MoveIt
+
+Creates a moveit::core::CompiledForwardKinematics plugin computing the link
+transforms of the subtree of one joint of a robot from its URDF. The fixed
+joint origins are folded into constants and every joint transform is
+specialized for the type and axis of its joint, so the generated code is
+straight-line arithmetic without any per-joint dispatch.
+
+List the plugin in the ROS parameter
+<robot_description>_planning.compiled_forward_kinematics of the nodes loading
+the robot model to have RobotState use it.
+
+Copyright (c) 2023, PickNik Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of PickNik Inc. nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+"""
+
+import argparse
+import math
+import os
+import re
+import xml.etree.ElementTree as etree
+from getpass import getuser
+
+try:
+    from ament_index_python.packages import (
+        get_package_share_directory,
+        PackageNotFoundError,
+    )
+except ImportError:
+    print(
+        "Failed to import ament_index_python. No ROS2 environment available? Trying without."
+    )
+
+    # define stubs
+    class PackageNotFoundError(Exception):
+        pass
+
+    def get_package_share_directory(pkg_name):
+        raise PackageNotFoundError
+
+
+# Package containing this file
+plugin_gen_pkg = "moveit_kinematics"
+# Coefficients smaller than this are treated as zero and dropped from the generated code
+ZERO_TOLERANCE = 1e-15
+
+
+def create_parser():
+    parser = argparse.ArgumentParser(
+        description="Generate a MoveIt compiled forward kinematics plugin"
+    )
+    parser.add_argument("urdf_file", help="The URDF of your robot")
+    parser.add_argument(
+        "root_joint",
+        help="The joint whose subtree the plugin computes the link transforms of",
+    )
+    parser.add_argument(
+        "--plugin_pkg",
+        help="The name of the plugin package to be created/updated. "
+        "Defaults to <robot_name>_<root_joint>_compiled_fk_plugin",
+    )
+    return parser
+
+
+# Matrix helpers on nested lists, to keep the script free of dependencies
+
+
+def mat_mul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(3)) for j in range(3)] for i in range(3)]
+
+
+def mat_vec(a, v):
+    return [sum(a[i][k] * v[k] for k in range(3)) for i in range(3)]
+
+
+def mat_add(a, b, scale=1.0):
+    return [[a[i][j] + scale * b[i][j] for j in range(3)] for i in range(3)]
+
+
+def rpy_matrix(roll, pitch, yaw):
+    # URDF convention: R = Rz(yaw) * Ry(pitch) * Rx(roll)
+    cr, sr = math.cos(roll), math.sin(roll)
+    cp, sp = math.cos(pitch), math.sin(pitch)
+    cy, sy = math.cos(yaw), math.sin(yaw)
+    return [
+        [cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+        [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+        [-sp, cp * sr, cp * cr],
+    ]
+
+
+def parse_vector(text, default):
+    if text is None:
+        return list(default)
+    return [float(x) for x in text.split()]
+
+
+class Joint:
+    def __init__(self, element):
+        self.name = element.get("name")
+        self.type = element.get("type")
+        self.parent = element.find("parent").get("link")
+        self.child = element.find("child").get("link")
+        origin = element.find("origin")
+        xyz = origin.get("xyz") if origin is not None else None
+        rpy = origin.get("rpy") if origin is not None else None
+        self.translation = parse_vector(xyz, [0.0, 0.0, 0.0])
+        self.rotation = rpy_matrix(*parse_vector(rpy, [0.0, 0.0, 0.0]))
+        axis = element.find("axis")
+        self.axis = parse_vector(axis.get("xyz") if axis is not None else None, [1.0, 0.0, 0.0])
+        norm = math.sqrt(sum(x * x for x in self.axis))
+        if self.type not in ("fixed", "floating", "planar") and norm == 0.0:
+            raise Exception("Joint '%s' has a zero axis" % self.name)
+        if norm > 0.0:
+            self.axis = [x / norm for x in self.axis]
+
+
+def load_subtree(urdf_file, root_joint):
+    """Return the robot name and the joints of the subtree of root_joint, each after the joint of its parent link."""
+    robot = etree.parse(urdf_file).getroot()
+    joints = [Joint(e) for e in robot.findall("joint")]
+    children = {}
+    for joint in joints:
+        children.setdefault(joint.parent, []).append(joint)
+    root = [j for j in joints if j.name == root_joint]
+    if not root:
+        raise Exception("Joint '%s' is not part of '%s'" % (root_joint, urdf_file))
+
+    subtree = []
+    stack = [root[0]]
+    while stack:
+        joint = stack.pop()
+        if joint.type not in ("fixed", "revolute", "continuous", "prismatic"):
+            raise Exception(
+                "Joint '%s' of type '%s' is not supported" % (joint.name, joint.type)
+            )
+        subtree.append(joint)
+        stack.extend(reversed(children.get(joint.child, [])))
+    return robot.get("name"), subtree
+
+
+def literal(value):
+    return repr(float(value)) if abs(value) > ZERO_TOLERANCE else "0.0"
+
+
+def linear_combination(terms):
+    """C++ expression for the sum of (coefficient, factor) terms, factor None being the constant 1."""
+    parts = []
+    for coefficient, factor in terms:
+        if abs(coefficient) <= ZERO_TOLERANCE:
+            continue
+        if factor is None:
+            parts.append(literal(coefficient))
+        elif abs(coefficient - 1.0) <= ZERO_TOLERANCE:
+            parts.append(factor)
+        elif abs(coefficient + 1.0) <= ZERO_TOLERANCE:
+            parts.append("-" + factor)
+        else:
+            parts.append("%s * %s" % (literal(coefficient), factor))
+    if not parts:
+        return "0.0"
+    return " + ".join(parts).replace("+ -", "- ")
+
+
+def generate_transform(joint, link_index, parent, variable_index):
+    """C++ block computing the global transform of the child link of joint from the one of its parent link."""
+    r0 = joint.rotation
+    t0 = joint.translation
+    lines = ["    {"]
+    if joint.type in ("revolute", "continuous"):
+        # origin rotation times Rodrigues' formula, split into the parts scaled by cos, sin and 1
+        k = joint.axis
+        kk = [[k[i] * k[j] for j in range(3)] for i in range(3)]
+        skew = [[0.0, -k[2], k[1]], [k[2], 0.0, -k[0]], [-k[1], k[0], 0.0]]
+        constant = mat_mul(r0, kk)
+        cosine = mat_add(r0, constant, -1.0)
+        sine = mat_mul(r0, skew)
+        lines.append("      const double q = positions[variable_indices[%d]];" % variable_index)
+        lines.append("      const double c = std::cos(q), s = std::sin(q);")
+        entries = [
+            linear_combination([(cosine[i][j], "c"), (sine[i][j], "s"), (constant[i][j], None)])
+            for i in range(3)
+            for j in range(3)
+        ]
+        translation = [linear_combination([(t0[i], None)]) for i in range(3)]
+    else:
+        entries = [literal(r0[i][j]) for i in range(3) for j in range(3)]
+        if joint.type == "prismatic":
+            lines.append("      const double q = positions[variable_indices[%d]];" % variable_index)
+            direction = mat_vec(r0, joint.axis)
+            translation = [linear_combination([(t0[i], None), (direction[i], "q")]) for i in range(3)]
+        else:
+            translation = [literal(t0[i]) for i in range(3)]
+
+    lines.append("      Eigen::Matrix3d r;")
+    rows = [", ".join(entries[3 * i : 3 * i + 3]) for i in range(3)]
+    lines.append("      r << %s;" % ",\n           ".join(rows))
+    lines.append("      const Eigen::Vector3d t(%s);" % ", ".join(translation))
+    lines.append("      Eigen::Isometry3d& result = link_transforms[link_indices[%d]];" % link_index)
+    lines.append("      result.linear().noalias() = %s.linear() * r;" % parent)
+    lines.append("      result.translation() = %s.linear() * t + %s.translation();" % (parent, parent))
+    lines.append("      result.makeAffine();")
+    lines.append("    }")
+    return "\n".join(lines)
+
+
+def generate_code(joints):
+    link_names = []
+    variable_names = []
+    blocks = []
+    link_index = {}
+    for joint in joints:
+        parent = (
+            "base"
+            if joint is joints[0]
+            else "link_transforms[link_indices[%d]]" % link_index[joint.parent]
+        )
+        variable_index = len(variable_names)
+        if joint.type != "fixed":
+            variable_names.append(joint.name)
+        link_index[joint.child] = len(link_names)
+        link_names.append(joint.child)
+        blocks.append("    // " + joint.child)
+        blocks.append(generate_transform(joint, link_index[joint.child], parent, variable_index))
+    return link_names, variable_names, "\n".join(blocks)
+
+
+def identifier(name):
+    return re.sub(r"[^A-Za-z0-9_]", "_", name)
+
+
+def find_template_dir():
+    for candidate in [os.path.dirname(__file__) + "/../templates"]:
+        if os.path.exists(candidate) and os.path.exists(
+            candidate + "/compiled_fk_plugin_template.cpp"
+        ):
+            return os.path.realpath(candidate)
+    try:
+        return os.path.join(
+            get_package_share_directory(plugin_gen_pkg), "compiled_fk_plugin/templates"
+        )
+    except PackageNotFoundError:
+        raise Exception("Can't find package %s" % plugin_gen_pkg)
+
+
+def copy_file(src_path, dest_path, description, replacements):
+    if not os.path.exists(src_path):
+        raise Exception("Can't find %s at '%s'" % (description, src_path))
+    with open(src_path, "r") as f:
+        content = f.read()
+    for key, value in replacements.items():
+        content = content.replace(key, value)
+    with open(dest_path, "w") as f:
+        f.write(content)
+    print("Created %s at '%s'" % (description, dest_path))
+
+
+def write_xml(root, path, description):
+    if hasattr(etree, "indent"):
+        etree.indent(root)
+    etree.ElementTree(root).write(path, xml_declaration=True, encoding="UTF-8")
+    print("Created %s at '%s'" % (description, path))
+
+
+def create_plugin_package(args, robot_name, joints):
+    namespace = identifier(robot_name + "_" + args.root_joint)
+    library_name = namespace + "_compiled_fk_plugin"
+    if args.plugin_pkg is None:
+        args.plugin_pkg = library_name
+    pkg_path = os.path.abspath(args.plugin_pkg)
+    package_name = os.path.basename(pkg_path)
+    src_path = os.path.join(pkg_path, "src")
+    if not os.path.exists(src_path):
+        os.makedirs(src_path)
+
+    pkg_xml_path = os.path.join(pkg_path, "package.xml")
+    if not os.path.exists(pkg_xml_path):
+        root = etree.Element("package", format="3")
+        etree.SubElement(root, "name").text = package_name
+        etree.SubElement(root, "version").text = "0.0.0"
+        etree.SubElement(root, "description").text = (
+            "Compiled forward kinematics of joint %s of %s" % (args.root_joint, robot_name)
+        )
+        user_name = getuser()
+        etree.SubElement(root, "maintainer", email="%s@todo.todo" % user_name).text = user_name
+        etree.SubElement(root, "license").text = "BSD"
+        etree.SubElement(root, "buildtool_depend").text = "ament_cmake"
+        etree.SubElement(root, "depend").text = "moveit_core"
+        etree.SubElement(root, "depend").text = "pluginlib"
+        export = etree.SubElement(root, "export")
+        etree.SubElement(export, "build_type").text = "ament_cmake"
+        write_xml(root, pkg_xml_path, "package.xml")
+
+    plugin_name = namespace + "/CompiledForwardKinematicsPlugin"
+    plugin_def = etree.Element("library", path=library_name)
+    cl = etree.SubElement(
+        plugin_def,
+        "class",
+        name=plugin_name,
+        type=namespace + "::CompiledForwardKinematicsPlugin",
+        base_class_type="moveit::core::CompiledForwardKinematics",
+    )
+    etree.SubElement(cl, "description").text = (
+        "Compiled forward kinematics of joint %s of %s" % (args.root_joint, robot_name)
+    )
+    write_xml(
+        plugin_def,
+        os.path.join(pkg_path, library_name + "_description.xml"),
+        "plugin definition",
+    )
+
+    link_names, variable_names, transforms = generate_code(joints)
+    template_dir = find_template_dir()
+    replacements = {
+        "_PACKAGE_NAME_": package_name,
+        "_LIBRARY_NAME_": library_name,
+        "_NAMESPACE_": namespace,
+        "_ROBOT_NAME_": robot_name,
+        "_ROOT_JOINT_": args.root_joint,
+        "_LINK_NAMES_": ", ".join('"%s"' % name for name in link_names),
+        "_VARIABLE_NAMES_": ", ".join('"%s"' % name for name in variable_names),
+        "_TRANSFORMS_": transforms,
+    }
+    copy_file(
+        os.path.join(template_dir, "compiled_fk_plugin_template.cpp"),
+        os.path.join(src_path, library_name + ".cpp"),
+        "compiled forward kinematics plugin",
+        replacements,
+    )
+    copy_file(
+        os.path.join(template_dir, "CMakeLists.txt"),
+        os.path.join(pkg_path, "CMakeLists.txt"),
+        "cmake file",
+        replacements,
+    )
+    print(
+        "\nAdd '%s' to the parameter <robot_description>_planning.compiled_forward_kinematics "
+        "to use the plugin." % plugin_name
+    )
+
+
+def main():
+    parser = create_parser()
+    args = parser.parse_args()
+    robot_name, joints = load_subtree(args.urdf_file, args.root_joint)
+    print(
+        "Generating forward kinematics of %d links below joint '%s' of '%s'"
+        % (len(joints), args.root_joint, robot_name)
+    )
+    create_plugin_package(args, robot_name, joints)
+
+
+if __name__ == "__main__":
+    main()
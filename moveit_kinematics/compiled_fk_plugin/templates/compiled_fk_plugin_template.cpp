@@ -0,0 +1,79 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/*
+ * Forward kinematics of the subtree of joint _ROOT_JOINT_ of robot _ROBOT_NAME_.
+ *
+ * AUTO-GENERATED by create_compiled_fk_plugin.py in moveit_kinematics package.
+ * Regenerate it whenever the URDF of the robot changes; RobotModel rejects kinematics that no longer match.
+ */
+
+#include <moveit/robot_model/compiled_forward_kinematics.h>
+#include <pluginlib/class_list_macros.hpp>
+#include <cmath>
+
+namespace _NAMESPACE_
+{
+class CompiledForwardKinematicsPlugin : public moveit::core::CompiledForwardKinematics
+{
+public:
+  std::string getRobotModelName() const override
+  {
+    return "_ROBOT_NAME_";
+  }
+
+  std::string getRootJointName() const override
+  {
+    return "_ROOT_JOINT_";
+  }
+
+  std::vector<std::string> getLinkNames() const override
+  {
+    return { _LINK_NAMES_ };
+  }
+
+  std::vector<std::string> getVariableNames() const override
+  {
+    return { _VARIABLE_NAMES_ };
+  }
+
+  void computeLinkTransforms(const Eigen::Isometry3d& base, const double* positions, const int* variable_indices,
+                             Eigen::Isometry3d* link_transforms, const int* link_indices) const override
+  {
+_TRANSFORMS_
+  }
+};
+}  // namespace _NAMESPACE_
+
+PLUGINLIB_EXPORT_CLASS(_NAMESPACE_::CompiledForwardKinematicsPlugin, moveit::core::CompiledForwardKinematics);
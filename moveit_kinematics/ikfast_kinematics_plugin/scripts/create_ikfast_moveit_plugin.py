@@ -188,7 +188,14 @@ def create_parameter_dict():
                 "default_value": "",
                 "type": "string",
                 "description": "prefix added to tip- and baseframe to allow different namespaces or multi-robot setups",
-            }
+            },
+            "num_threads": {
+                "default_value": 1,
+                "type": "int",
+                "description": "Number of threads used to search the free joint discretization in searchPositionIK "
+                "and to solve batch getPositionIK queries. 1 solves sequentially, 0 uses all hardware threads",
+                "validation": {"gt_eq<>": [0]},
+            },
         }
     }
     return parameter_dict
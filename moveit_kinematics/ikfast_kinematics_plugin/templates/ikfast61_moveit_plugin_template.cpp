@@ -49,6 +49,10 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <ikfast_kinematics_parameters.hpp>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 using namespace moveit::core;
 
 // Need a floating point tolerance when checking joint limits, in case the joint starts at limit
@@ -239,6 +243,38 @@ public:
                      std::vector<std::vector<double>>& solutions, kinematics::KinematicsResult& result,
                      const kinematics::KinematicsQueryOptions& options) const override;
 
+  /**
+   * @brief Compute all joint solutions within joint limits for many independent poses of the tip link at once.
+   *
+   * The redundant joint is sampled once for all poses according to the discretization method of @a options.
+   * The poses are distributed over num_threads worker threads, each reusing its solver buffers.
+   *
+   * @param ik_poses The desired poses of the tip link
+   * @param ik_seed_state an initial guess solution shared by all poses
+   * @param solutions All joint solutions for each pose
+   * @param results A struct that reports the result of the query for each pose
+   * @param options An option struct which contains the type of redundancy discretization used.
+   * @return True if solutions were found for all poses, false otherwise.
+   */
+  bool getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                     std::vector<std::vector<std::vector<double>>>& solutions,
+                     std::vector<kinematics::KinematicsResult>& results,
+                     const kinematics::KinematicsQueryOptions& options) const;
+
+  /**
+   * @brief Search IK solutions for many independent poses of the tip link at once.
+   *
+   * Without free joints, the poses are distributed over num_threads worker threads and each pose is solved
+   * analytically, picking the solution closest to its seed that passes the (serialized) solution callback.
+   * With free joints, each pose is searched by searchPositionIK(), which parallelizes over the free joint values.
+   */
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<std::vector<double>>& ik_seed_states,
+      double timeout, std::vector<std::vector<double>>& solutions,
+      std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const IKCallbackFn& solution_callback = IKCallbackFn(),
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
+
   /**
    * @brief Given a desired pose of the end-effector, search for the joint angles required to reach it.
    * This particular method is intended for "searching" for a solutions by stepping through the redundancy
@@ -362,6 +398,34 @@ private:
    */
   bool sampleRedundantJoint(kinematics::DiscretizationMethod method, std::vector<double>& sampled_joint_vals) const;
 
+  /**
+   * @brief Computes the values of the redundant joint to solve for, starting with the seed value
+   * @param  ik_seed_state       The seed state providing the first value of the redundant joint
+   * @param  options             The query options selecting the discretization method
+   * @param  sampled_joint_vals  Returned values of the redundant joint, empty if there is none
+   * @param  error               Returned error if sampling failed
+   * @return True if sampling succeeded.
+   */
+  bool getRedundantJointSamples(const std::vector<double>& ik_seed_state,
+                                const kinematics::KinematicsQueryOptions& options,
+                                std::vector<double>& sampled_joint_vals, kinematics::KinematicError& error) const;
+
+  /**
+   * @brief Appends all solutions within joint limits for the given pose in the solver frame and redundant joint values
+   * @param  frame               The pose in the solver frame
+   * @param  ik_seed_state       The seed state that solutions are rotated towards
+   * @param  sampled_joint_vals  Values of the redundant joint, empty if there is none
+   * @param  ik_solutions        Reused buffer for the raw IKFast solutions
+   * @param  vfree               Reused buffer for the free joint values
+   * @param  solutions           Vector the solutions within joint limits are appended to
+   */
+  void collectSolutions(KDL::Frame& frame, const std::vector<double>& ik_seed_state,
+                        const std::vector<double>& sampled_joint_vals, IkSolutionList<IkReal>& ik_solutions,
+                        std::vector<double>& vfree, std::vector<std::vector<double>>& solutions) const;
+
+  /// Number of threads to use for the free joint search and batch queries
+  unsigned int getNumThreads() const;
+
   /// Validate that we can compute a fixed transform between from and to links.
   bool computeRelativeTransform(const std::string& from, const std::string& to, Eigen::Isometry3d& transform,
                                 bool& differs_from_identity);
@@ -986,23 +1050,36 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik
   if ((search_mode & OPTIMIZE_MAX_JOINT) && (num_positive_increments + num_negative_increments) > 1000)
     RCLCPP_WARN_STREAM_ONCE(LOGGER, "Large search space, consider increasing the search discretization");
 
+  // free joint values in the order of the sequential search, alternating around the initial guess
+  std::vector<double> free_values(1, initial_guess);
+  while (getCount(counter, num_positive_increments, -num_negative_increments))
+    free_values.push_back(initial_guess + search_discretization * counter);
+
+  // guards the solution callback, which usually checks collisions on a shared scene, and the best solution
+  std::mutex result_mutex;
   double best_costs = -1.0;
   std::vector<double> best_solution;
-  int nattempts = 0, nvalid = 0;
+  std::atomic<int> nattempts{ 0 }, nvalid{ 0 };
+  // index of the first free joint value with a valid solution, later values need not be searched
+  std::atomic<std::size_t> first_valid{ free_values.size() };
+  std::atomic<std::size_t> next_value{ 0 };
 
-  while (true)
-  {
+  const auto search = [&] {
     IkSolutionList<IkReal> solutions;
-    size_t numsol = solve(frame, vfree, solutions);
-
-    RCLCPP_DEBUG_STREAM(LOGGER, "Found " << numsol << " solutions from IKFast");
+    std::vector<double> vfree_local = vfree;
+    std::vector<double> sol;
+    moveit_msgs::msg::MoveItErrorCodes sol_error_code;
 
-    if (numsol > 0)
+    for (std::size_t v = next_value++; v < free_values.size() && v < first_valid; v = next_value++)
     {
+      vfree_local[0] = free_values[v];
+      size_t numsol = solve(frame, vfree_local, solutions);
+
+      RCLCPP_DEBUG_STREAM(LOGGER, "Found " << numsol << " solutions from IKFast");
+
       for (size_t s = 0; s < numsol; ++s)
       {
         nattempts++;
-        std::vector<double> sol;
         getSolution(solutions, ik_seed_state, s, sol);
 
         bool obeys_limits = true;
@@ -1013,64 +1090,67 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik
             obeys_limits = false;
             break;
           }
-          // RCLCPP_INFO_STREAM(LOGGER,"Num " << i << " value " << sol[i] << " has limits " <<
-          // joint_has_limits_vector_[i] << " " << joint_min_vector_[i] << " " << joint_max_vector_[i]);
         }
-        if (obeys_limits)
+        if (!obeys_limits)
+          continue;
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+        // a free joint value closer to the initial guess was solved meanwhile
+        if (!(search_mode & OPTIMIZE_MAX_JOINT) && v >= first_valid)
+          break;
+
+        // This solution is within joint limits, now check if in collision (if callback provided)
+        if (solution_callback)
+        {
+          solution_callback(ik_pose, sol, sol_error_code);
+        }
+        else
         {
-          getSolution(solutions, ik_seed_state, s, solution);
+          sol_error_code.val = sol_error_code.SUCCESS;
+        }
 
-          // This solution is within joint limits, now check if in collision (if callback provided)
-          if (solution_callback)
+        if (sol_error_code.val == sol_error_code.SUCCESS)
+        {
+          nvalid++;
+          if (search_mode & OPTIMIZE_MAX_JOINT)
           {
-            solution_callback(ik_pose, solution, error_code);
+            // Costs for solution: Largest joint motion
+            double costs = 0.0;
+            for (unsigned int i = 0; i < sol.size(); ++i)
+            {
+              double d = fabs(ik_seed_state[i] - sol[i]);
+              if (d > costs)
+                costs = d;
+            }
+            if (costs < best_costs || best_costs == -1.0)
+            {
+              best_costs = costs;
+              best_solution = sol;
+            }
           }
           else
           {
-            error_code.val = error_code.SUCCESS;
-          }
-
-          if (error_code.val == error_code.SUCCESS)
-          {
-            nvalid++;
-            if (search_mode & OPTIMIZE_MAX_JOINT)
-            {
-              // Costs for solution: Largest joint motion
-              double costs = 0.0;
-              for (unsigned int i = 0; i < solution.size(); ++i)
-              {
-                double d = fabs(ik_seed_state[i] - solution[i]);
-                if (d > costs)
-                  costs = d;
-              }
-              if (costs < best_costs || best_costs == -1.0)
-              {
-                best_costs = costs;
-                best_solution = solution;
-              }
-            }
-            else
-              // Return first feasible solution
-              return true;
+            // Keep first feasible solution
+            first_valid = v;
+            best_solution = sol;
+            break;
           }
         }
       }
     }
+  };
 
-    if (!getCount(counter, num_positive_increments, -num_negative_increments))
-    {
-      // Everything searched
-      error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
-      break;
-    }
-
-    vfree[0] = initial_guess + search_discretization * counter;
-    // RCLCPP_DEBUG_STREAM(LOGGER,"Attempt " << counter << " with 0th free joint having value " << vfree[0]);
-  }
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = std::min<std::size_t>(getNumThreads(), free_values.size());
+  for (std::size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(search);
+  search();
+  for (std::thread& thread : threads)
+    thread.join();
 
-  RCLCPP_DEBUG_STREAM(LOGGER, "Valid solutions: " << nvalid << '/' << nattempts);
+  RCLCPP_DEBUG_STREAM(LOGGER, "Valid solutions: " << nvalid.load() << '/' << nattempts.load());
 
-  if ((search_mode & OPTIMIZE_MAX_JOINT) && best_costs != -1.0)
+  if (first_valid < free_values.size() || ((search_mode & OPTIMIZE_MAX_JOINT) && best_costs != -1.0))
   {
     solution = best_solution;
     error_code.val = error_code.SUCCESS;
@@ -1228,111 +1308,287 @@ bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::msg:
     return false;
   }
 
+  std::vector<double> sampled_joint_vals;
+  if (!getRedundantJointSamples(ik_seed_state, options, sampled_joint_vals, result.kinematic_error))
+    return false;
+
   KDL::Frame frame;
   transformToChainFrame(ik_poses[0], frame);
 
-  // solving ik
-  std::vector<IkSolutionList<IkReal>> solution_set;
   IkSolutionList<IkReal> ik_solutions;
   std::vector<double> vfree;
-  int numsol = 0;
+  const std::size_t num_known_solutions = solutions.size();
+  collectSolutions(frame, ik_seed_state, sampled_joint_vals, ik_solutions, vfree, solutions);
+
+  if (solutions.size() > num_known_solutions)
+  {
+    result.kinematic_error = kinematics::KinematicErrors::OK;
+    return true;
+  }
+
+  RCLCPP_DEBUG_STREAM(LOGGER, "No IK solution");
+  result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
+  return false;
+}
+
+bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                           const std::vector<double>& ik_seed_state,
+                                           std::vector<std::vector<std::vector<double>>>& solutions,
+                                           std::vector<kinematics::KinematicsResult>& results,
+                                           const kinematics::KinematicsQueryOptions& options) const
+{
+  solutions.resize(ik_poses.size());
+  results.resize(ik_poses.size());
+  for (std::vector<std::vector<double>>& pose_solutions : solutions)
+    pose_solutions.clear();
+
+  kinematics::KinematicError error = kinematics::KinematicErrors::OK;
   std::vector<double> sampled_joint_vals;
-  if (!redundant_joint_indices_.empty())
+  if (!initialized_)
+  {
+    RCLCPP_ERROR(LOGGER, "kinematics not active");
+    error = kinematics::KinematicErrors::SOLVER_NOT_ACTIVE;
+  }
+  else if (ik_seed_state.size() < num_joints_)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "ik_seed_state only has " << ik_seed_state.size()
+                                                          << " entries, this ikfast solver requires " << num_joints_);
+    error = kinematics::KinematicErrors::NO_SOLUTION;
+  }
+  else
   {
-    // initializing from seed
-    sampled_joint_vals.push_back(ik_seed_state[redundant_joint_indices_[0]]);
+    getRedundantJointSamples(ik_seed_state, options, sampled_joint_vals, error);
+  }
 
-    // checking joint limits when using no discretization
-    if (options.discretization_method == kinematics::DiscretizationMethods::NO_DISCRETIZATION &&
-        joint_has_limits_vector_[redundant_joint_indices_.front()])
-    {
-      double joint_min = joint_min_vector_[redundant_joint_indices_.front()];
-      double joint_max = joint_max_vector_[redundant_joint_indices_.front()];
+  if (error != kinematics::KinematicErrors::OK)
+  {
+    for (kinematics::KinematicsResult& result : results)
+      result = { error, 0.0 };
+    return false;
+  }
 
-      double jv = sampled_joint_vals[0];
-      if (!((jv > (joint_min - LIMIT_TOLERANCE)) && (jv < (joint_max + LIMIT_TOLERANCE))))
+  std::atomic<std::size_t> next_pose{ 0 };
+  std::atomic<bool> all_solved{ true };
+  const auto solve_poses = [&] {
+    KDL::Frame frame;
+    IkSolutionList<IkReal> ik_solutions;
+    std::vector<double> vfree;
+    for (std::size_t i = next_pose++; i < ik_poses.size(); i = next_pose++)
+    {
+      transformToChainFrame(ik_poses[i], frame);
+      collectSolutions(frame, ik_seed_state, sampled_joint_vals, ik_solutions, vfree, solutions[i]);
+      if (solutions[i].empty())
+      {
+        results[i] = { kinematics::KinematicErrors::NO_SOLUTION, 0.0 };
+        all_solved = false;
+      }
+      else
       {
-        result.kinematic_error = kinematics::KinematicErrors::IK_SEED_OUTSIDE_LIMITS;
-        RCLCPP_ERROR_STREAM(LOGGER, "ik seed is out of bounds");
-        return false;
+        results[i] = { kinematics::KinematicErrors::OK, 1.0 };
       }
     }
+  };
 
-    // computing all solutions sets for each sampled value of the redundant joint
-    if (!sampleRedundantJoint(options.discretization_method, sampled_joint_vals))
-    {
-      result.kinematic_error = kinematics::KinematicErrors::UNSUPORTED_DISCRETIZATION_REQUESTED;
-      return false;
-    }
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = std::min<std::size_t>(getNumThreads(), ik_poses.size());
+  for (std::size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(solve_poses);
+  solve_poses();
+  for (std::thread& thread : threads)
+    thread.join();
 
-    for (unsigned int i = 0; i < sampled_joint_vals.size(); ++i)
-    {
-      vfree.clear();
-      vfree.push_back(sampled_joint_vals[i]);
-      numsol += solve(frame, vfree, ik_solutions);
-      solution_set.push_back(ik_solutions);
-    }
-  }
-  else
+  return all_solved;
+}
+
+bool IKFastKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                   const std::vector<std::vector<double>>& ik_seed_states,
+                                                   double timeout, std::vector<std::vector<double>>& solutions,
+                                                   std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                   const IKCallbackFn& solution_callback,
+                                                   const kinematics::KinematicsQueryOptions& options) const
+{
+  // the search over free joint values is already parallelized per pose
+  if (!free_params_.empty())
+    return KinematicsBase::searchPositionIKBatch(ik_poses, ik_seed_states, timeout, solutions, error_codes,
+                                                 solution_callback, options);
+
+  if (!prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  if (!initialized_)
   {
-    // computing for single solution set
-    numsol = solve(frame, vfree, ik_solutions);
-    solution_set.push_back(ik_solutions);
+    RCLCPP_ERROR(LOGGER, "kinematics not active");
+    for (moveit_msgs::msg::MoveItErrorCodes& error_code : error_codes)
+      error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
   }
 
-  RCLCPP_DEBUG_STREAM(LOGGER, "Found " << numsol << " solutions from IKFast");
-  bool solutions_found = false;
-  if (numsol > 0)
+  for (const std::vector<double>& ik_seed_state : ik_seed_states)
   {
-    /*
-      Iterating through all solution sets and storing those that do not exceed joint limits.
-    */
-    for (unsigned int r = 0; r < solution_set.size(); ++r)
+    if (ik_seed_state.size() < num_joints_)
     {
-      ik_solutions = solution_set[r];
-      numsol = ik_solutions.GetNumSolutions();
-      for (int s = 0; s < numsol; ++s)
+      RCLCPP_ERROR_STREAM(LOGGER, "ik_seed_state only has " << ik_seed_state.size()
+                                                            << " entries, this ikfast solver requires " << num_joints_);
+      for (moveit_msgs::msg::MoveItErrorCodes& error_code : error_codes)
+        error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+      return false;
+    }
+  }
+
+  // solution callbacks usually check collisions on a shared scene and must not run concurrently
+  std::mutex callback_mutex;
+  std::atomic<std::size_t> next_pose{ 0 };
+  std::atomic<bool> all_solved{ true };
+  const auto solve_poses = [&] {
+    const std::vector<double> no_sampled_joint_vals;
+    KDL::Frame frame;
+    IkSolutionList<IkReal> ik_solutions;
+    std::vector<double> vfree;
+    std::vector<std::vector<double>> pose_solutions;
+    std::vector<LimitObeyingSol> solutions_obey_limits;
+    for (std::size_t i = next_pose++; i < ik_poses.size(); i = next_pose++)
+    {
+      const std::vector<double>& ik_seed_state = ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i];
+      transformToChainFrame(ik_poses[i], frame);
+      pose_solutions.clear();
+      collectSolutions(frame, ik_seed_state, no_sampled_joint_vals, ik_solutions, vfree, pose_solutions);
+
+      // sort solutions by their distance to the seed
+      solutions_obey_limits.clear();
+      for (std::vector<double>& pose_solution : pose_solutions)
       {
-        std::vector<double> sol;
-        getSolution(ik_solutions, ik_seed_state, s, sol);
+        double dist_from_seed = 0.0;
+        for (std::size_t j = 0; j < num_joints_; ++j)
+          dist_from_seed += fabs(ik_seed_state[j] - pose_solution[j]);
+        solutions_obey_limits.push_back({ std::move(pose_solution), dist_from_seed });
+      }
+      std::sort(solutions_obey_limits.begin(), solutions_obey_limits.end());
 
-        bool obeys_limits = true;
-        for (unsigned int i = 0; i < sol.size(); ++i)
+      error_codes[i].val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+      for (LimitObeyingSol& candidate : solutions_obey_limits)
+      {
+        if (solution_callback)
         {
-          // Add tolerance to limit check
-          if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
-                                              (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
-          {
-            // One element of solution is not within limits
-            obeys_limits = false;
-            RCLCPP_DEBUG_STREAM(LOGGER, "Not in limits! "
-                                            << i << " value " << sol[i] << " has limit: " << joint_has_limits_vector_[i]
-                                            << "  being  " << joint_min_vector_[i] << " to " << joint_max_vector_[i]);
-            break;
-          }
+          std::lock_guard<std::mutex> lock(callback_mutex);
+          solution_callback(ik_poses[i], candidate.value, error_codes[i]);
         }
-        if (obeys_limits)
+        else
         {
-          // All elements of solution obey limits
-          solutions_found = true;
-          solutions.push_back(sol);
+          error_codes[i].val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+        }
+
+        if (error_codes[i].val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+        {
+          solutions[i] = std::move(candidate.value);
+          break;
         }
       }
+      if (error_codes[i].val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+        all_solved = false;
     }
+  };
+
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = std::min<std::size_t>(getNumThreads(), ik_poses.size());
+  for (std::size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(solve_poses);
+  solve_poses();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return all_solved;
+}
+
+bool IKFastKinematicsPlugin::getRedundantJointSamples(const std::vector<double>& ik_seed_state,
+                                                      const kinematics::KinematicsQueryOptions& options,
+                                                      std::vector<double>& sampled_joint_vals,
+                                                      kinematics::KinematicError& error) const
+{
+  sampled_joint_vals.clear();
+  if (redundant_joint_indices_.empty())
+    return true;
+
+  // initializing from seed
+  sampled_joint_vals.push_back(ik_seed_state[redundant_joint_indices_[0]]);
 
-    if (solutions_found)
+  // checking joint limits when using no discretization
+  if (options.discretization_method == kinematics::DiscretizationMethods::NO_DISCRETIZATION &&
+      joint_has_limits_vector_[redundant_joint_indices_.front()])
+  {
+    double joint_min = joint_min_vector_[redundant_joint_indices_.front()];
+    double joint_max = joint_max_vector_[redundant_joint_indices_.front()];
+
+    double jv = sampled_joint_vals[0];
+    if (!((jv > (joint_min - LIMIT_TOLERANCE)) && (jv < (joint_max + LIMIT_TOLERANCE))))
     {
-      result.kinematic_error = kinematics::KinematicErrors::OK;
-      return true;
+      error = kinematics::KinematicErrors::IK_SEED_OUTSIDE_LIMITS;
+      RCLCPP_ERROR_STREAM(LOGGER, "ik seed is out of bounds");
+      return false;
     }
   }
-  else
+
+  // computing all values of the redundant joint to solve for
+  if (!sampleRedundantJoint(options.discretization_method, sampled_joint_vals))
   {
-    RCLCPP_DEBUG_STREAM(LOGGER, "No IK solution");
+    error = kinematics::KinematicErrors::UNSUPORTED_DISCRETIZATION_REQUESTED;
+    return false;
   }
+  return true;
+}
 
-  result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
-  return false;
+void IKFastKinematicsPlugin::collectSolutions(KDL::Frame& frame, const std::vector<double>& ik_seed_state,
+                                              const std::vector<double>& sampled_joint_vals,
+                                              IkSolutionList<IkReal>& ik_solutions, std::vector<double>& vfree,
+                                              std::vector<std::vector<double>>& solutions) const
+{
+  // a single solution set without redundant joint
+  const std::size_t num_sets = std::max<std::size_t>(sampled_joint_vals.size(), 1);
+  vfree.resize(sampled_joint_vals.empty() ? 0 : 1);
+
+  int numsol = 0;
+  std::vector<double> sol;
+  for (std::size_t r = 0; r < num_sets; ++r)
+  {
+    if (!sampled_joint_vals.empty())
+      vfree[0] = sampled_joint_vals[r];
+    const int set_numsol = solve(frame, vfree, ik_solutions);
+    numsol += set_numsol;
+
+    // storing the solutions that do not exceed joint limits
+    for (int s = 0; s < set_numsol; ++s)
+    {
+      getSolution(ik_solutions, ik_seed_state, s, sol);
+
+      bool obeys_limits = true;
+      for (unsigned int i = 0; i < sol.size(); ++i)
+      {
+        // Add tolerance to limit check
+        if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
+                                            (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
+        {
+          // One element of solution is not within limits
+          obeys_limits = false;
+          RCLCPP_DEBUG_STREAM(LOGGER, "Not in limits! "
+                                          << i << " value " << sol[i] << " has limit: " << joint_has_limits_vector_[i]
+                                          << "  being  " << joint_min_vector_[i] << " to " << joint_max_vector_[i]);
+          break;
+        }
+      }
+      if (obeys_limits)
+      {
+        // All elements of solution obey limits
+        solutions.push_back(sol);
+      }
+    }
+  }
+  RCLCPP_DEBUG_STREAM(LOGGER, "Found " << numsol << " solutions from IKFast");
+}
+
+unsigned int IKFastKinematicsPlugin::getNumThreads() const
+{
+  if (params_.num_threads > 0)
+    return params_.num_threads;
+  return std::max(1u, std::thread::hardware_concurrency());
 }
 
 bool IKFastKinematicsPlugin::sampleRedundantJoint(kinematics::DiscretizationMethod method,
@@ -60,6 +60,7 @@
 #include <moveit/robot_state/robot_state.h>
 
 #include <cfloat>
+#include <mutex>
 
 namespace KDL
 {
@@ -85,6 +86,36 @@ public:
                 std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
                 const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  using KinematicsBase::getPositionIK;
+
+  /**
+   * @brief Solve getPositionIK() for many independent poses of the tip frame at once
+   *
+   * Every pose is solved from @a ik_seed_state without random re-seeding, see searchPositionIKBatch().
+   * @param ik_poses the desired poses of the tip link
+   * @param ik_seed_state an initial guess solution shared by all poses
+   * @param solutions the solution vector for each pose, only valid if the matching error code is SUCCESS
+   * @param error_codes the error code for each pose
+   * @return True if all poses were solved
+   */
+  bool getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                     std::vector<std::vector<double>>& solutions,
+                     std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Search IK solutions for many independent poses of the tip frame at once
+   *
+   * Instead of running the random restarts of one pose in parallel, the poses are distributed over num_threads
+   * worker threads, each of which searches a pose on its own. Solution callbacks are serialized across all poses.
+   */
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<std::vector<double>>& ik_seed_states,
+      double timeout, std::vector<std::vector<double>>& solutions,
+      std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const IKCallbackFn& solution_callback = IKCallbackFn(),
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
+
   bool searchPositionIK(
       const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
       std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
@@ -125,6 +156,14 @@ public:
    */
   const std::vector<std::string>& getLinkNames() const override;
 
+  /**
+   * @brief  Every query uses its own KDL solvers and random number generators
+   */
+  bool supportsConcurrentQueries() const override
+  {
+    return true;
+  }
+
 protected:
   typedef Eigen::Matrix<double, 6, 1> Twist;
 
@@ -134,8 +173,29 @@ protected:
                 KDL::JntArray& q_out, const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
                 const Twist& cartesian_weights) const;
 
+  /// Solve position IK given initial joint values, using the given forward kinematics solver
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  int CartToJnt(KDL::ChainFkSolverPos& fk_solver, KDL::ChainIkSolverVelMimicSVD& ik_solver,
+                const KDL::JntArray& q_init, const KDL::Frame& p_in, KDL::JntArray& q_out, const unsigned int max_iter,
+                const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const;
+
 private:
   void getJointWeights();
+
+  /**
+   * @brief Implementation of searchPositionIK() for a single pose
+   * @param rng Random number generator used for re-seeding on the calling thread
+   * @param num_threads Number of threads running random restarts in parallel
+   * @param callback_mutex Mutex held while calling the solution callback
+   */
+  bool searchPositionIKImpl(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                            double timeout, const std::vector<double>& consistency_limits,
+                            std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                            moveit_msgs::msg::MoveItErrorCodes& error_code,
+                            const kinematics::KinematicsQueryOptions& options,
+                            random_numbers::RandomNumberGenerator& rng, unsigned int num_threads,
+                            std::mutex& callback_mutex) const;
+
   bool timedOut(const rclcpp::Time& start_time, double duration) const;
 
   /** @brief Check whether the solution lies within the consistency limits of the seed state
@@ -147,15 +207,19 @@ private:
   bool checkConsistency(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
                         const Eigen::VectorXd& solution) const;
 
-  void getRandomConfiguration(Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, Eigen::VectorXd& jnt_array) const;
 
   /** @brief Get a random configuration within consistency limits close to the seed state
+   *  @param rng Random number generator to sample from
    *  @param seed_state Seed state
    *  @param consistency_limits
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
-                              Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, const Eigen::VectorXd& seed_state,
+                              const std::vector<double>& consistency_limits, Eigen::VectorXd& jnt_array) const;
+
+  /// Number of threads to use for concurrent restarts and batch queries
+  unsigned int getNumThreads() const;
 
   /// clip q_delta such that joint limits will not be violated
   void clipToJointLimits(const KDL::JntArray& q, KDL::JntArray& q_delta, Eigen::ArrayXd& weighting) const;
@@ -166,7 +230,6 @@ private:
   moveit_msgs::msg::KinematicSolverInfo solver_info_;  ///< Stores information for the inverse kinematics solver
 
   const moveit::core::JointModelGroup* joint_model_group_;
-  moveit::core::RobotStatePtr state_;
   KDL::Chain kdl_chain_;
   std::unique_ptr<KDL::ChainFkSolverPos> fk_solver_;
   std::vector<JointMimic> mimic_joints_;
@@ -45,6 +45,11 @@
 #include <kdl/frames_io.hpp>
 #include <kdl/kinfam_io.hpp>
 
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 namespace kdl_kinematics_plugin
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_kdl_kinematics_plugin.kdl_kinematics_plugin");
@@ -54,18 +59,25 @@ KDLKinematicsPlugin::KDLKinematicsPlugin() : initialized_(false)
 {
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(Eigen::VectorXd& jnt_array) const
+void KDLKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 Eigen::VectorXd& jnt_array) const
 {
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
+  joint_model_group_->getVariableRandomPositions(rng, &jnt_array[0]);
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(const Eigen::VectorXd& seed_state,
+void KDLKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 const Eigen::VectorXd& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  Eigen::VectorXd& jnt_array) const
 {
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), &jnt_array[0],
-                                                       &seed_state[0], consistency_limits);
+  joint_model_group_->getVariableRandomPositionsNearBy(rng, &jnt_array[0], &seed_state[0], consistency_limits);
+}
+
+unsigned int KDLKinematicsPlugin::getNumThreads() const
+{
+  if (params_.num_threads > 0)
+    return params_.num_threads;
+  return std::max(1u, std::thread::hardware_concurrency());
 }
 
 bool KDLKinematicsPlugin::checkConsistency(const Eigen::VectorXd& seed_state,
@@ -227,9 +239,6 @@ bool KDLKinematicsPlugin::initialize(const rclcpp::Node::SharedPtr& node, const
     }
   }
 
-  // Setup the joint state groups that we need
-  state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
-
   fk_solver_ = std::make_unique<KDL::ChainFkSolverPos_recursive>(kdl_chain_);
 
   initialized_ = true;
@@ -254,6 +263,59 @@ bool KDLKinematicsPlugin::getPositionIK(const geometry_msgs::msg::Pose& ik_pose,
                           options);
 }
 
+bool KDLKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                        const std::vector<double>& ik_seed_state,
+                                        std::vector<std::vector<double>>& solutions,
+                                        std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                        const kinematics::KinematicsQueryOptions& options) const
+{
+  // limit search to a single attempt per pose by setting a timeout of zero
+  return searchPositionIKBatch(ik_poses, { ik_seed_state }, 0.0, solutions, error_codes, IKCallbackFn(), options);
+}
+
+bool KDLKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                                                std::vector<std::vector<double>>& solutions,
+                                                std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                const IKCallbackFn& solution_callback,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  // each worker searches one pose at a time, so restarts of a single pose do not need threads of their own
+  const std::vector<double> consistency_limits;
+  std::mutex callback_mutex;
+  std::atomic<std::size_t> next_pose{ 0 };
+  std::atomic<bool> all_solved{ true };
+  const auto worker = [&](random_numbers::RandomNumberGenerator& rng) {
+    for (std::size_t i = next_pose++; i < ik_poses.size(); i = next_pose++)
+    {
+      const std::vector<double>& seed = ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i];
+      if (!searchPositionIKImpl(ik_poses[i], seed, timeout, consistency_limits, solutions[i], solution_callback,
+                                error_codes[i], options, rng, 1, callback_mutex))
+        all_solved = false;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = std::min<std::size_t>(getNumThreads(), ik_poses.size());
+  for (std::size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back([&worker] {
+      random_numbers::RandomNumberGenerator rng;
+      worker(rng);
+    });
+  }
+  // every call uses generators of its own, so concurrent calls do not share any random state
+  random_numbers::RandomNumberGenerator rng;
+  worker(rng);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return all_solved;
+}
+
 bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_pose,
                                            const std::vector<double>& ik_seed_state, double timeout,
                                            std::vector<double>& solution,
@@ -293,6 +355,23 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                            const IKCallbackFn& solution_callback,
                                            moveit_msgs::msg::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
+{
+  // solution callbacks usually check collisions on a shared scene and must not run concurrently
+  std::mutex callback_mutex;
+  // every call uses generators of its own, so concurrent calls do not share any random state
+  random_numbers::RandomNumberGenerator rng;
+  return searchPositionIKImpl(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback,
+                              error_code, options, rng, getNumThreads(), callback_mutex);
+}
+
+bool KDLKinematicsPlugin::searchPositionIKImpl(const geometry_msgs::msg::Pose& ik_pose,
+                                               const std::vector<double>& ik_seed_state, double timeout,
+                                               const std::vector<double>& consistency_limits,
+                                               std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                               moveit_msgs::msg::MoveItErrorCodes& error_code,
+                                               const kinematics::KinematicsQueryOptions& options,
+                                               random_numbers::RandomNumberGenerator& rng, unsigned int num_threads,
+                                               std::mutex& callback_mutex) const
 {
   const rclcpp::Time start_time = steady_clock.now();
   if (!initialized_)
@@ -337,13 +416,7 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
   cartesian_weights.bottomRows<3>().setConstant(orientation_vs_position_weight);
 
   KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
   jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
-  jnt_pos_in = jnt_seed_state;
-
-  KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight == 0.0);
-  solution.resize(dimension_);
 
   KDL::Frame pose_desired;
   tf2::fromMsg(ik_pose, pose_desired);
@@ -353,50 +426,132 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                   << ik_pose.orientation.x << ' ' << ik_pose.orientation.y << ' '
                                   << ik_pose.orientation.z << ' ' << ik_pose.orientation.w);
 
-  unsigned int attempt = 0;
-  do
-  {
-    ++attempt;
-    if (attempt > 1)  // randomly re-seed after first attempt
+  // raised by the first thread finding a solution, checked by all others between attempts
+  std::atomic<bool> stop{ false };
+
+  // randomly re-seeding search, starting from the seed state if requested
+  const auto search = [&](random_numbers::RandomNumberGenerator& search_rng, bool start_at_seed,
+                          std::vector<double>& candidate, moveit_msgs::msg::MoveItErrorCodes& candidate_error_code,
+                          unsigned int& attempt) {
+    KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
+    KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight == 0.0);
+    KDL::JntArray jnt_pos_in(dimension_);
+    KDL::JntArray jnt_pos_out(dimension_);
+    jnt_pos_in = jnt_seed_state;
+    candidate.resize(dimension_);
+
+    do
     {
-      if (!consistency_limits_mimic.empty())
+      ++attempt;
+      if (attempt > 1 || !start_at_seed)  // randomly re-seed after first attempt
       {
-        getRandomConfiguration(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
+        if (!consistency_limits_mimic.empty())
+        {
+          getRandomConfiguration(search_rng, jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
+        }
+        else
+        {
+          getRandomConfiguration(search_rng, jnt_pos_in.data);
+        }
+        RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration (" << attempt << "): " << jnt_pos_in);
       }
-      else
+
+      int ik_valid =
+          CartToJnt(fk_solver, ik_solver_vel, jnt_pos_in, pose_desired, jnt_pos_out, params_.max_solver_iterations,
+                    Eigen::Map<const Eigen::VectorXd>(joint_weights_.data(), joint_weights_.size()), cartesian_weights);
+      if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
       {
-        getRandomConfiguration(jnt_pos_in.data);
+        if (!consistency_limits_mimic.empty() &&
+            !checkConsistency(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_out.data))
+          continue;
+
+        Eigen::Map<Eigen::VectorXd>(candidate.data(), candidate.size()) = jnt_pos_out.data;
+        if (solution_callback)
+        {
+          std::scoped_lock lock(callback_mutex);
+          solution_callback(ik_pose, candidate, candidate_error_code);
+          if (candidate_error_code.val != candidate_error_code.SUCCESS)
+            continue;
+        }
+
+        // solution passed consistency check and solution callback
+        candidate_error_code.val = candidate_error_code.SUCCESS;
+        return true;
       }
-      RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration (" << attempt << "): " << jnt_pos_in);
+    } while (!stop && !timedOut(start_time, timeout));
+    return false;
+  };
+
+  // a single attempt (timeout of zero) is never re-seeded and thus never runs in parallel
+  if (timeout <= 0.0)
+    num_threads = 1;
+  std::vector<std::vector<double>> candidates(num_threads);
+  std::vector<moveit_msgs::msg::MoveItErrorCodes> candidate_error_codes(num_threads);
+  std::vector<unsigned int> attempts(num_threads, 0);
+  std::vector<char> found(num_threads, false);
+  std::atomic<int> first_found{ -1 };
+
+  const auto worker = [&](unsigned int i) {
+    if (i == 0)
+    {
+      // the calling thread starts at the seed state and keeps using the given generator
+      found[i] = search(rng, true, candidates[i], candidate_error_codes[i], attempts[i]);
+    }
+    else
+    {
+      random_numbers::RandomNumberGenerator thread_rng;
+      found[i] = search(thread_rng, false, candidates[i], candidate_error_codes[i], attempts[i]);
+    }
+    if (found[i])
+    {
+      int expected = -1;
+      first_found.compare_exchange_strong(expected, static_cast<int>(i));
+      stop = true;
     }
+  };
 
-    int ik_valid =
-        CartToJnt(ik_solver_vel, jnt_pos_in, pose_desired, jnt_pos_out, params_.max_solver_iterations,
-                  Eigen::Map<const Eigen::VectorXd>(joint_weights_.data(), joint_weights_.size()), cartesian_weights);
-    if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker, i);
+  worker(0);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  unsigned int total_attempts = 0;
+  for (unsigned int attempt : attempts)
+    total_attempts += attempt;
+
+  int best = first_found;
+  if (best >= 0 && params_.parallel_solution_selection == "closest")
+  {
+    double best_distance = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < num_threads; ++i)
     {
-      if (!consistency_limits_mimic.empty() &&
-          !checkConsistency(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_out.data))
+      if (!found[i])
         continue;
-
-      Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = jnt_pos_out.data;
-      if (solution_callback)
+      const double distance =
+          (Eigen::Map<const Eigen::VectorXd>(candidates[i].data(), candidates[i].size()) - jnt_seed_state.data)
+              .squaredNorm();
+      if (distance < best_distance)
       {
-        solution_callback(ik_pose, solution, error_code);
-        if (error_code.val != error_code.SUCCESS)
-          continue;
+        best_distance = distance;
+        best = static_cast<int>(i);
       }
-
-      // solution passed consistency check and solution callback
-      error_code.val = error_code.SUCCESS;
-      RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (steady_clock.now() - start_time).seconds() << " < " << timeout
-                                                  << "s and " << attempt << " attempts");
-      return true;
     }
-  } while (!timedOut(start_time, timeout));
+  }
 
+  if (best >= 0)
+  {
+    solution = std::move(candidates[best]);
+    error_code = candidate_error_codes[best];
+    RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (steady_clock.now() - start_time).seconds() << " < " << timeout
+                                                << "s and " << total_attempts << " attempts");
+    return true;
+  }
+
+  solution = std::move(candidates[0]);
   RCLCPP_DEBUG_STREAM(LOGGER, "IK timed out after " << (steady_clock.now() - start_time).seconds() << " > " << timeout
-                                                    << "s and " << attempt << " attempts");
+                                                    << "s and " << total_attempts << " attempts");
   error_code.val = error_code.TIMED_OUT;
   return false;
 }
@@ -405,6 +560,15 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
 int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, const KDL::JntArray& q_init,
                                    const KDL::Frame& p_in, KDL::JntArray& q_out, const unsigned int max_iter,
                                    const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const
+{
+  return CartToJnt(*fk_solver_, ik_solver, q_init, p_in, q_out, max_iter, joint_weights, cartesian_weights);
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+int KDLKinematicsPlugin::CartToJnt(KDL::ChainFkSolverPos& fk_solver, KDL::ChainIkSolverVelMimicSVD& ik_solver,
+                                   const KDL::JntArray& q_init, const KDL::Frame& p_in, KDL::JntArray& q_out,
+                                   const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
+                                   const Twist& cartesian_weights) const
 {
   double last_delta_twist_norm = DBL_MAX;
   double step_size = 1.0;
@@ -421,7 +585,7 @@ int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, con
   bool success = false;
   for (i = 0; i < max_iter; ++i)
   {
-    fk_solver_->JntToCart(q_out, f);
+    fk_solver.JntToCart(q_out, f);
     delta_twist = diff(f, p_in);
     RCLCPP_DEBUG_STREAM(LOGGER, "[" << std::setw(3) << i << "] delta_twist: " << delta_twist);
 
@@ -524,6 +688,8 @@ bool KDLKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_nam
     return false;
   }
 
+  // KDL solvers keep the error of their last call, so concurrent calls need solvers of their own
+  KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
   KDL::Frame p_out;
   KDL::JntArray jnt_pos_in(dimension_);
   jnt_pos_in.data = Eigen::Map<const Eigen::VectorXd>(joint_angles.data(), joint_angles.size());
@@ -531,7 +697,7 @@ bool KDLKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_nam
   bool valid = true;
   for (unsigned int i = 0; i < poses.size(); ++i)
   {
-    if (fk_solver_->JntToCart(jnt_pos_in, p_out) >= 0)
+    if (fk_solver.JntToCart(jnt_pos_in, p_out) >= 0)
     {
       poses[i] = tf2::toMsg(p_out);
     }
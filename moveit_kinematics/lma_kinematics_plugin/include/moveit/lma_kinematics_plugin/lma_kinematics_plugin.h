@@ -52,12 +52,16 @@
 #include <kdl/config.h>
 #include <kdl/chainfksolver.hpp>
 #include <kdl/chainiksolver.hpp>
+#include <kdl/chainiksolverpos_lma.hpp>
 
 // MoveIt
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 
+#include <memory>
+#include <mutex>
+
 namespace lma_kinematics_plugin
 {
 /**
@@ -77,6 +81,36 @@ public:
                 std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
                 const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  using KinematicsBase::getPositionIK;
+
+  /**
+   * @brief Solve getPositionIK() for many independent poses of the tip frame at once
+   *
+   * Every pose is solved from @a ik_seed_state without random re-seeding, see searchPositionIKBatch().
+   * @param ik_poses the desired poses of the tip link
+   * @param ik_seed_state an initial guess solution shared by all poses
+   * @param solutions the solution vector for each pose, only valid if the matching error code is SUCCESS
+   * @param error_codes the error code for each pose
+   * @return True if all poses were solved
+   */
+  bool getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                     std::vector<std::vector<double>>& solutions,
+                     std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Search IK solutions for many independent poses of the tip frame at once
+   *
+   * Instead of running the random restarts of one pose in parallel, the poses are distributed over num_threads
+   * worker threads, each of which searches a pose on its own. Solution callbacks are serialized across all poses.
+   */
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<std::vector<double>>& ik_seed_states,
+      double timeout, std::vector<std::vector<double>>& solutions,
+      std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const IKCallbackFn& solution_callback = IKCallbackFn(),
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
+
   bool searchPositionIK(
       const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
       std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
@@ -117,7 +151,51 @@ public:
    */
   const std::vector<std::string>& getLinkNames() const override;
 
+  /**
+   * @brief  Every query uses its own solver workspace and random number generators
+   */
+  bool supportsConcurrentQueries() const override
+  {
+    return true;
+  }
+
 private:
+  /** @brief An LMA solver with its joint arrays, allocated once and reused by all queries */
+  struct SolverWorkspace
+  {
+    SolverWorkspace(const KDL::Chain& chain, const Eigen::Matrix<double, 6, 1>& cartesian_weights, double epsilon,
+                    int max_iterations, unsigned int dimension);
+
+    KDL::ChainIkSolverPos_LMA solver;
+    KDL::JntArray jnt_pos_in;
+    KDL::JntArray jnt_pos_out;
+  };
+
+  /** @brief Returns a workspace to the pool of its plugin when it goes out of scope */
+  struct WorkspaceReleaser
+  {
+    const LMAKinematicsPlugin* plugin;
+    void operator()(SolverWorkspace* workspace) const;
+  };
+  using WorkspacePtr = std::unique_ptr<SolverWorkspace, WorkspaceReleaser>;
+
+  /** @brief Take an unused workspace from the pool, creating one if all are in use by concurrent queries */
+  WorkspacePtr acquireWorkspace() const;
+
+  /**
+   * @brief Implementation of searchPositionIK() for a single pose
+   * @param rng Random number generator used for re-seeding on the calling thread
+   * @param num_threads Number of threads running random restarts in parallel
+   * @param callback_mutex Mutex held while calling the solution callback
+   */
+  bool searchPositionIKImpl(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                            double timeout, const std::vector<double>& consistency_limits,
+                            std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                            moveit_msgs::msg::MoveItErrorCodes& error_code,
+                            const kinematics::KinematicsQueryOptions& options,
+                            random_numbers::RandomNumberGenerator& rng, unsigned int num_threads,
+                            std::mutex& callback_mutex) const;
+
   bool timedOut(const rclcpp::Time& start_time, double duration) const;
 
   /** @brief Check whether the solution lies within the consistency limits of the seed state
@@ -133,15 +211,19 @@ private:
   /** Harmonize revolute joint values into the range -2 Pi .. 2 Pi */
   void harmonize(Eigen::VectorXd& values) const;
 
-  void getRandomConfiguration(Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, Eigen::VectorXd& jnt_array) const;
 
   /** @brief Get a random configuration within consistency limits close to the seed state
+   *  @param rng Random number generator to sample from
    *  @param seed_state Seed state
    *  @param consistency_limits
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
-                              Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, const Eigen::VectorXd& seed_state,
+                              const std::vector<double>& consistency_limits, Eigen::VectorXd& jnt_array) const;
+
+  /// Number of threads to use for concurrent restarts and batch queries
+  unsigned int getNumThreads() const;
 
   bool initialized_;  ///< Internal variable that indicates whether solver is configured and ready
 
@@ -149,9 +231,11 @@ private:
   moveit_msgs::msg::KinematicSolverInfo solver_info_;  ///< Stores information for the inverse kinematics solver
 
   const moveit::core::JointModelGroup* joint_model_group_;
-  moveit::core::RobotStatePtr state_;
   KDL::Chain kdl_chain_;
-  std::unique_ptr<KDL::ChainFkSolverPos> fk_solver_;
+  Eigen::Matrix<double, 6, 1> cartesian_weights_;  ///< Weights of position and orientation errors in the LMA solver
+
+  mutable std::mutex workspaces_mutex_;
+  mutable std::vector<std::unique_ptr<SolverWorkspace>> workspaces_;  ///< Workspaces not in use by any query
   std::vector<const moveit::core::JointModel*> joints_;
   std::vector<std::string> joint_names_;
   rclcpp::Node::SharedPtr node_;
@@ -36,13 +36,17 @@
 
 #include <moveit/lma_kinematics_plugin/lma_kinematics_plugin.h>
 #include <kdl/chainfksolverpos_recursive.hpp>
-#include <kdl/chainiksolverpos_lma.hpp>
 
 #include <tf2_kdl/tf2_kdl.hpp>
 #include <kdl_parser/kdl_parser.hpp>
 #include <kdl/frames_io.hpp>
 #include <kdl/kinfam_io.hpp>
 
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 // register as a KinematicsBase implementation
 #include <class_loader/class_loader.hpp>
 CLASS_LOADER_REGISTER_CLASS(lma_kinematics_plugin::LMAKinematicsPlugin, kinematics::KinematicsBase)
@@ -55,18 +59,55 @@ LMAKinematicsPlugin::LMAKinematicsPlugin() : initialized_(false)
 {
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(Eigen::VectorXd& jnt_array) const
+LMAKinematicsPlugin::SolverWorkspace::SolverWorkspace(const KDL::Chain& chain,
+                                                      const Eigen::Matrix<double, 6, 1>& cartesian_weights,
+                                                      double epsilon, int max_iterations, unsigned int dimension)
+  : solver(chain, cartesian_weights, epsilon, max_iterations), jnt_pos_in(dimension), jnt_pos_out(dimension)
+{
+}
+
+void LMAKinematicsPlugin::WorkspaceReleaser::operator()(SolverWorkspace* workspace) const
+{
+  std::scoped_lock slock(plugin->workspaces_mutex_);
+  plugin->workspaces_.emplace_back(workspace);
+}
+
+LMAKinematicsPlugin::WorkspacePtr LMAKinematicsPlugin::acquireWorkspace() const
+{
+  {
+    std::scoped_lock slock(workspaces_mutex_);
+    if (!workspaces_.empty())
+    {
+      WorkspacePtr workspace(workspaces_.back().release(), WorkspaceReleaser{ this });
+      workspaces_.pop_back();
+      return workspace;
+    }
+  }
+  // the solver allocates all of its matrices up front, so that solving does not allocate anymore
+  return WorkspacePtr(new SolverWorkspace(kdl_chain_, cartesian_weights_, params_.epsilon,
+                                          params_.max_solver_iterations, dimension_),
+                      WorkspaceReleaser{ this });
+}
+
+void LMAKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 Eigen::VectorXd& jnt_array) const
 {
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
+  joint_model_group_->getVariableRandomPositions(rng, &jnt_array[0]);
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(const Eigen::VectorXd& seed_state,
+void LMAKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 const Eigen::VectorXd& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  Eigen::VectorXd& jnt_array) const
 {
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), &jnt_array[0],
-                                                       &seed_state[0], consistency_limits);
+  joint_model_group_->getVariableRandomPositionsNearBy(rng, &jnt_array[0], &seed_state[0], consistency_limits);
+}
+
+unsigned int LMAKinematicsPlugin::getNumThreads() const
+{
+  if (params_.num_threads > 0)
+    return params_.num_threads;
+  return std::max(1u, std::thread::hardware_concurrency());
 }
 
 bool LMAKinematicsPlugin::checkConsistency(const Eigen::VectorXd& seed_state,
@@ -131,10 +172,12 @@ bool LMAKinematicsPlugin::initialize(const rclcpp::Node::SharedPtr& node, const
   }
   dimension_ = joints_.size();
 
-  // Setup the joint state groups that we need
-  state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
-
-  fk_solver_ = std::make_unique<KDL::ChainFkSolverPos_recursive>(kdl_chain_);
+  const double orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
+  if (orientation_vs_position_weight == 0.0)
+    RCLCPP_INFO(LOGGER, "Using position only ik");
+  cartesian_weights_ << 1.0, 1.0, 1.0, orientation_vs_position_weight, orientation_vs_position_weight,
+      orientation_vs_position_weight;
+  workspaces_.clear();
 
   initialized_ = true;
   RCLCPP_DEBUG(LOGGER, "LMA solver initialized");
@@ -158,6 +201,59 @@ bool LMAKinematicsPlugin::getPositionIK(const geometry_msgs::msg::Pose& ik_pose,
                           options);
 }
 
+bool LMAKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                        const std::vector<double>& ik_seed_state,
+                                        std::vector<std::vector<double>>& solutions,
+                                        std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                        const kinematics::KinematicsQueryOptions& options) const
+{
+  // limit search to a single attempt per pose by setting a timeout of zero
+  return searchPositionIKBatch(ik_poses, { ik_seed_state }, 0.0, solutions, error_codes, IKCallbackFn(), options);
+}
+
+bool LMAKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                                                std::vector<std::vector<double>>& solutions,
+                                                std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                const IKCallbackFn& solution_callback,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  // each worker searches one pose at a time, so restarts of a single pose do not need threads of their own
+  const std::vector<double> consistency_limits;
+  std::mutex callback_mutex;
+  std::atomic<std::size_t> next_pose{ 0 };
+  std::atomic<bool> all_solved{ true };
+  const auto worker = [&](random_numbers::RandomNumberGenerator& rng) {
+    for (std::size_t i = next_pose++; i < ik_poses.size(); i = next_pose++)
+    {
+      const std::vector<double>& seed = ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i];
+      if (!searchPositionIKImpl(ik_poses[i], seed, timeout, consistency_limits, solutions[i], solution_callback,
+                                error_codes[i], options, rng, 1, callback_mutex))
+        all_solved = false;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = std::min<std::size_t>(getNumThreads(), ik_poses.size());
+  for (std::size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back([&worker] {
+      random_numbers::RandomNumberGenerator rng;
+      worker(rng);
+    });
+  }
+  // every call uses generators of its own, so concurrent calls do not share any random state
+  random_numbers::RandomNumberGenerator rng;
+  worker(rng);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return all_solved;
+}
+
 bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_pose,
                                            const std::vector<double>& ik_seed_state, double timeout,
                                            std::vector<double>& solution,
@@ -215,6 +311,23 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                            const IKCallbackFn& solution_callback,
                                            moveit_msgs::msg::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
+{
+  // solution callbacks usually check collisions on a shared scene and must not run concurrently
+  std::mutex callback_mutex;
+  // every call uses generators of its own, so concurrent calls do not share any random state
+  random_numbers::RandomNumberGenerator rng;
+  return searchPositionIKImpl(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback,
+                              error_code, options, rng, getNumThreads(), callback_mutex);
+}
+
+bool LMAKinematicsPlugin::searchPositionIKImpl(const geometry_msgs::msg::Pose& ik_pose,
+                                               const std::vector<double>& ik_seed_state, double timeout,
+                                               const std::vector<double>& consistency_limits,
+                                               std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                               moveit_msgs::msg::MoveItErrorCodes& error_code,
+                                               const kinematics::KinematicsQueryOptions& options,
+                                               random_numbers::RandomNumberGenerator& rng, unsigned int num_threads,
+                                               std::mutex& callback_mutex) const
 {
   rclcpp::Time start_time = node_->now();
   if (!initialized_)
@@ -239,26 +352,8 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
     return false;
   }
 
-  const auto orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
-  if (orientation_vs_position_weight == 0.0)
-    RCLCPP_INFO(LOGGER, "Using position only ik");
-
-  Eigen::Matrix<double, 6, 1> cartesian_weights;
-  cartesian_weights(0) = 1;
-  cartesian_weights(1) = 1;
-  cartesian_weights(2) = 1;
-  cartesian_weights(3) = orientation_vs_position_weight;
-  cartesian_weights(4) = orientation_vs_position_weight;
-  cartesian_weights(5) = orientation_vs_position_weight;
-
   KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
   jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
-  jnt_pos_in = jnt_seed_state;
-
-  KDL::ChainIkSolverPos_LMA ik_solver_pos(kdl_chain_, cartesian_weights, params_.epsilon, params_.max_solver_iterations);
-  solution.resize(dimension_);
 
   KDL::Frame pose_desired;
   tf2::fromMsg(ik_pose, pose_desired);
@@ -267,50 +362,141 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                   << ik_pose.position.x << ' ' << ik_pose.position.y << ' ' << ik_pose.position.z << ' '
                                   << ik_pose.orientation.x << ' ' << ik_pose.orientation.y << ' '
                                   << ik_pose.orientation.z << ' ' << ik_pose.orientation.w);
-  unsigned int attempt = 0;
-  do
-  {
-    ++attempt;
-    if (attempt > 1)  // randomly re-seed after first attempt
+
+  // raised by the first thread finding a solution, checked by all others between attempts
+  std::atomic<bool> stop{ false };
+
+  // randomly re-seeding search, starting from the seed state if requested
+  const auto search = [&](random_numbers::RandomNumberGenerator& search_rng, bool start_at_seed, bool single_attempt,
+                          std::vector<double>& candidate, moveit_msgs::msg::MoveItErrorCodes& candidate_error_code,
+                          unsigned int& attempt) {
+    const WorkspacePtr workspace = acquireWorkspace();
+    KDL::ChainIkSolverPos_LMA& ik_solver_pos = workspace->solver;
+    KDL::JntArray& jnt_pos_in = workspace->jnt_pos_in;
+    KDL::JntArray& jnt_pos_out = workspace->jnt_pos_out;
+    jnt_pos_in = jnt_seed_state;
+    candidate.resize(dimension_);
+
+    do
     {
-      if (!consistency_limits.empty())
+      ++attempt;
+      if (attempt > 1 || !start_at_seed)  // randomly re-seed after first attempt
       {
-        getRandomConfiguration(jnt_seed_state.data, consistency_limits, jnt_pos_in.data);
+        if (!consistency_limits.empty())
+        {
+          getRandomConfiguration(search_rng, jnt_seed_state.data, consistency_limits, jnt_pos_in.data);
+        }
+        else
+        {
+          getRandomConfiguration(search_rng, jnt_pos_in.data);
+        }
+        RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration (" << attempt << "): " << jnt_pos_in);
+      }
+
+      int ik_valid = ik_solver_pos.CartToJnt(jnt_pos_in, pose_desired, jnt_pos_out);
+      if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
+      {
+        harmonize(jnt_pos_out.data);
+        if (!consistency_limits.empty() && !checkConsistency(jnt_seed_state.data, consistency_limits, jnt_pos_out.data))
+          continue;
+        if (!obeysLimits(jnt_pos_out.data))
+          continue;
+
+        Eigen::Map<Eigen::VectorXd>(candidate.data(), candidate.size()) = jnt_pos_out.data;
+        if (solution_callback)
+        {
+          std::scoped_lock lock(callback_mutex);
+          solution_callback(ik_pose, candidate, candidate_error_code);
+          if (candidate_error_code.val != candidate_error_code.SUCCESS)
+            continue;
+        }
+
+        // solution passed consistency check and solution callback
+        candidate_error_code.val = candidate_error_code.SUCCESS;
+        return true;
+      }
+    } while (!single_attempt && !stop && !timedOut(start_time, timeout));
+    return false;
+  };
+
+  // a single attempt (timeout of zero) is never re-seeded and thus never runs in parallel
+  if (timeout <= 0.0)
+    num_threads = 1;
+  std::vector<std::vector<double>> candidates(num_threads);
+  std::vector<moveit_msgs::msg::MoveItErrorCodes> candidate_error_codes(num_threads);
+  std::vector<unsigned int> attempts(num_threads, 0);
+  std::vector<char> found(num_threads, false);
+  std::atomic<int> first_found{ -1 };
+
+  // queries from nearby seeds, e.g. of Cartesian interpolation, are usually solved at the seed state already, so
+  // that attempt is made on the calling thread before starting any threads for random restarts
+  found[0] = search(rng, true, true, candidates[0], candidate_error_codes[0], attempts[0]);
+  if (found[0])
+    first_found = 0;
+  else if (timeout > 0.0 && !timedOut(start_time, timeout))
+  {
+    const auto worker = [&](unsigned int i) {
+      if (i == 0)
+      {
+        // the calling thread keeps using the given generator
+        found[i] = search(rng, false, false, candidates[i], candidate_error_codes[i], attempts[i]);
       }
       else
       {
-        getRandomConfiguration(jnt_pos_in.data);
+        random_numbers::RandomNumberGenerator thread_rng;
+        found[i] = search(thread_rng, false, false, candidates[i], candidate_error_codes[i], attempts[i]);
       }
-      RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration (" << attempt << "): " << jnt_pos_in);
-    }
+      if (found[i])
+      {
+        int expected = -1;
+        first_found.compare_exchange_strong(expected, static_cast<int>(i));
+        stop = true;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < num_threads; ++i)
+      threads.emplace_back(worker, i);
+    worker(0);
+    for (std::thread& thread : threads)
+      thread.join();
+  }
 
-    int ik_valid = ik_solver_pos.CartToJnt(jnt_pos_in, pose_desired, jnt_pos_out);
-    if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
+  unsigned int total_attempts = 0;
+  for (unsigned int attempt : attempts)
+    total_attempts += attempt;
+
+  int best = first_found;
+  if (best >= 0 && params_.parallel_solution_selection == "closest")
+  {
+    double best_distance = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < num_threads; ++i)
     {
-      harmonize(jnt_pos_out.data);
-      if (!consistency_limits.empty() && !checkConsistency(jnt_seed_state.data, consistency_limits, jnt_pos_out.data))
+      if (!found[i])
         continue;
-      if (!obeysLimits(jnt_pos_out.data))
-        continue;
-
-      Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = jnt_pos_out.data;
-      if (solution_callback)
+      const double distance =
+          (Eigen::Map<const Eigen::VectorXd>(candidates[i].data(), candidates[i].size()) - jnt_seed_state.data)
+              .squaredNorm();
+      if (distance < best_distance)
       {
-        solution_callback(ik_pose, solution, error_code);
-        if (error_code.val != error_code.SUCCESS)
-          continue;
+        best_distance = distance;
+        best = static_cast<int>(i);
       }
-
-      // solution passed consistency check and solution callback
-      error_code.val = error_code.SUCCESS;
-      RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (node_->now() - start_time).seconds() << " < " << timeout
-                                                  << "s and " << attempt << " attempts");
-      return true;
     }
-  } while (!timedOut(start_time, timeout));
+  }
+
+  if (best >= 0)
+  {
+    solution = std::move(candidates[best]);
+    error_code = candidate_error_codes[best];
+    RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (node_->now() - start_time).seconds() << " < " << timeout
+                                                << "s and " << total_attempts << " attempts");
+    return true;
+  }
 
+  solution = std::move(candidates[0]);
   RCLCPP_DEBUG_STREAM(LOGGER, "IK timed out after " << (node_->now() - start_time).seconds() << " > " << timeout
-                                                    << "s and " << attempt << " attempts");
+                                                    << "s and " << total_attempts << " attempts");
   error_code.val = error_code.TIMED_OUT;
   return false;
 }
@@ -331,6 +517,8 @@ bool LMAKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_nam
     return false;
   }
 
+  // KDL solvers keep the error of their last call, so concurrent calls need solvers of their own
+  KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
   KDL::Frame p_out;
   KDL::JntArray jnt_pos_in(dimension_);
   jnt_pos_in.data = Eigen::Map<const Eigen::VectorXd>(joint_angles.data(), joint_angles.size());
@@ -338,7 +526,7 @@ bool LMAKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_nam
   bool valid = true;
   for (unsigned int i = 0; i < poses.size(); ++i)
   {
-    if (fk_solver_->JntToCart(jnt_pos_in, p_out) >= 0)
+    if (fk_solver.JntToCart(jnt_pos_in, p_out) >= 0)
     {
       poses[i] = tf2::toMsg(p_out);
     }
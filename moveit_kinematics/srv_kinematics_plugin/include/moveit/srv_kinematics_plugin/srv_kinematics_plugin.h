@@ -52,6 +52,7 @@
 #include <geometry_msgs/msg/pose.hpp>
 #include <moveit_msgs/msg/kinematic_solver_info.hpp>
 #include <moveit_msgs/msg/move_it_error_codes.hpp>
+#include <moveit_msgs/srv/get_position_ik.hpp>
 
 // MoveIt
 #include <moveit/kinematics_base/kinematics_base.h>
@@ -105,6 +106,20 @@ public:
                         const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
                         const moveit::core::RobotState* context_state = nullptr) const override;
 
+  /**
+   * @brief Search IK solutions for many independent poses of the tip frame at once
+   *
+   * Instead of one blocking round-trip per pose, up to max_in_flight_requests requests are pending at the service at
+   * the same time, so that an external solver can work on several poses concurrently. Each request may take up to
+   * @a timeout seconds. Groups with multiple tip frames fall back to one request after the other.
+   */
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<std::vector<double>>& ik_seed_states,
+      double timeout, std::vector<std::vector<double>>& solutions,
+      std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const IKCallbackFn& solution_callback = IKCallbackFn(),
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
+
   bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                      std::vector<geometry_msgs::msg::Pose>& poses) const override;
 
@@ -137,6 +152,22 @@ private:
 
   bool isRedundantJoint(unsigned int index) const;
 
+  /** @brief Check that the solver is active and that the request matches the group */
+  bool checkRequest(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                    moveit_msgs::msg::MoveItErrorCodes& error_code) const;
+
+  /** @brief Create the service request for the poses of all tip frames */
+  moveit_msgs::srv::GetPositionIK::Request::SharedPtr
+  createRequest(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state) const;
+
+  /** @brief Extract the solution of the group from a service response */
+  bool processResponse(const moveit_msgs::srv::GetPositionIK::Response& response, std::vector<double>& solution,
+                       moveit_msgs::msg::MoveItErrorCodes& error_code) const;
+
+  /** @brief Run the solution callback, if there is one, on a solution of the service */
+  bool checkSolution(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& solution,
+                     const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code) const;
+
   bool active_; /** Internal variable that indicates whether solvers are configured and ready */
 
   moveit_msgs::msg::KinematicSolverInfo ik_group_info_; /** Stores information for the inverse kinematics solver */
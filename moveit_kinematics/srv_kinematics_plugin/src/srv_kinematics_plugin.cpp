@@ -38,6 +38,8 @@
 #include <moveit/srv_kinematics_plugin/srv_kinematics_plugin.h>
 #include <class_loader/class_loader.hpp>
 #include <moveit/robot_state/conversions.h>
+#include <chrono>
+#include <deque>
 #include <iterator>
 
 // Eigen
@@ -243,6 +245,106 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::msg:
                                            moveit_msgs::msg::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& /*options*/,
                                            const moveit::core::RobotState* /*context_state*/) const
+{
+  if (!checkRequest(ik_poses, ik_seed_state, error_code))
+    return false;
+
+  // Create the service message
+  auto ik_srv = createRequest(ik_poses, ik_seed_state);
+
+  RCLCPP_DEBUG(LOGGER, "Calling service: %s", ik_service_client_->get_service_name());
+  auto result_future = ik_service_client_->async_send_request(ik_srv);
+  const auto& response = result_future.get();
+  if (rclcpp::spin_until_future_complete(node_, result_future) != rclcpp::FutureReturnCode::SUCCESS)
+  {
+    RCLCPP_DEBUG_STREAM(LOGGER, "Service call failed to connect to service: " << ik_service_client_->get_service_name());
+    error_code.val = error_code.FAILURE;
+    return false;
+  }
+
+  if (!processResponse(*response, solution, error_code))
+    return false;
+
+  // hack: should use all poses, not just the 0th
+  if (!checkSolution(ik_poses[0], solution, solution_callback, error_code))
+    return false;
+
+  RCLCPP_INFO(LOGGER, "IK Solver Succeeded!");
+  return true;
+}
+
+bool SrvKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                                                std::vector<std::vector<double>>& solutions,
+                                                std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                const IKCallbackFn& solution_callback,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  if (tip_frames_.size() != 1)
+  {
+    return KinematicsBase::searchPositionIKBatch(ik_poses, ik_seed_states, timeout, solutions, error_codes,
+                                                 solution_callback, options);
+  }
+  if (!prepareBatch(ik_poses, ik_seed_states, solutions, error_codes))
+    return false;
+
+  // Requests that were sent to the service, in the order of the poses. The responses are collected in the same order,
+  // so the solution callback is called from this thread only.
+  struct PendingRequest
+  {
+    std::size_t index;
+    rclcpp::Client<moveit_msgs::srv::GetPositionIK>::FutureAndRequestId future;
+    std::chrono::steady_clock::time_point deadline;
+  };
+  std::deque<PendingRequest> pending_requests;
+  const auto max_in_flight_requests = static_cast<std::size_t>(params_.max_in_flight_requests);
+  const auto request_timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(timeout > 0.0 ? timeout : default_timeout_));
+
+  bool all_solved = true;
+  std::size_t next_pose = 0;
+  while (next_pose < ik_poses.size() || !pending_requests.empty())
+  {
+    // Keep the service busy: fill up the pending requests before waiting for the oldest one
+    while (next_pose < ik_poses.size() && pending_requests.size() < max_in_flight_requests)
+    {
+      const std::size_t i = next_pose++;
+      const std::vector<double>& seed = ik_seed_states.size() == 1 ? ik_seed_states[0] : ik_seed_states[i];
+      const std::vector<geometry_msgs::msg::Pose> request_poses{ ik_poses[i] };
+      if (!checkRequest(request_poses, seed, error_codes[i]))
+      {
+        all_solved = false;
+        continue;
+      }
+      pending_requests.push_back({ i, ik_service_client_->async_send_request(createRequest(request_poses, seed)),
+                                   std::chrono::steady_clock::now() + request_timeout });
+    }
+    if (pending_requests.empty())
+      continue;
+
+    // The responses arrive through the executor that spins the node, like for single requests
+    PendingRequest& request = pending_requests.front();
+    const std::size_t i = request.index;
+    if (request.future.wait_until(request.deadline) != std::future_status::ready)
+    {
+      RCLCPP_DEBUG(LOGGER, "IK request %zu of the batch timed out", i);
+      ik_service_client_->remove_pending_request(request.future);
+      error_codes[i].val = moveit_msgs::msg::MoveItErrorCodes::TIMED_OUT;
+      all_solved = false;
+    }
+    else if (!processResponse(*request.future.get(), solutions[i], error_codes[i]) ||
+             !checkSolution(ik_poses[i], solutions[i], solution_callback, error_codes[i]))
+    {
+      all_solved = false;
+    }
+    pending_requests.pop_front();
+  }
+  return all_solved;
+}
+
+bool SrvKinematicsPlugin::checkRequest(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                       const std::vector<double>& ik_seed_state,
+                                       moveit_msgs::msg::MoveItErrorCodes& error_code) const
 {
   // Check if active
   if (!active_)
@@ -270,8 +372,13 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::msg:
     error_code.val = error_code.NO_IK_SOLUTION;
     return false;
   }
+  return true;
+}
 
-  // Create the service message
+moveit_msgs::srv::GetPositionIK::Request::SharedPtr
+SrvKinematicsPlugin::createRequest(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                   const std::vector<double>& ik_seed_state) const
+{
   auto ik_srv = std::make_shared<moveit_msgs::srv::GetPositionIK::Request>();
   ik_srv->ik_request.avoid_collisions = true;
   ik_srv->ik_request.group_name = getGroupName();
@@ -301,43 +408,38 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::msg:
     ik_srv->ik_request.pose_stamped = ik_pose_st;
     ik_srv->ik_request.ik_link_name = getTipFrames()[0];
   }
+  return ik_srv;
+}
 
-  RCLCPP_DEBUG(LOGGER, "Calling service: %s", ik_service_client_->get_service_name());
-  auto result_future = ik_service_client_->async_send_request(ik_srv);
-  const auto& response = result_future.get();
-  if (rclcpp::spin_until_future_complete(node_, result_future) == rclcpp::FutureReturnCode::SUCCESS)
+bool SrvKinematicsPlugin::processResponse(const moveit_msgs::srv::GetPositionIK::Response& response,
+                                          std::vector<double>& solution,
+                                          moveit_msgs::msg::MoveItErrorCodes& error_code) const
+{
+  // Check error code
+  error_code.val = response.error_code.val;
+  if (error_code.val != error_code.SUCCESS)
   {
-    // Check error code
-    error_code.val = response->error_code.val;
-    if (error_code.val != error_code.SUCCESS)
+    // TODO (JafarAbdi) Print the entire message for ROS2?
+    // RCLCPP_DEBUG("srv", "An IK that satisifes the constraints and is collision free could not be found."
+    //                                   << "\nRequest was: \n"
+    //                                   << ik_srv.request.ik_request << "\nResponse was: \n"
+    //                                   << ik_srv.response.solution);
+    switch (error_code.val)
     {
-      // TODO (JafarAbdi) Print the entire message for ROS2?
-      // RCLCPP_DEBUG("srv", "An IK that satisifes the constraints and is collision free could not be found."
-      //                                   << "\nRequest was: \n"
-      //                                   << ik_srv.request.ik_request << "\nResponse was: \n"
-      //                                   << ik_srv.response.solution);
-      switch (error_code.val)
-      {
-        case moveit_msgs::msg::MoveItErrorCodes::FAILURE:
-          RCLCPP_ERROR(LOGGER, "Service failed with with error code: FAILURE");
-          break;
-        case moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION:
-          RCLCPP_DEBUG(LOGGER, "Service failed with with error code: NO IK SOLUTION");
-          break;
-        default:
-          RCLCPP_DEBUG_STREAM(LOGGER, "Service failed with with error code: " << error_code.val);
-      }
-      return false;
+      case moveit_msgs::msg::MoveItErrorCodes::FAILURE:
+        RCLCPP_ERROR(LOGGER, "Service failed with with error code: FAILURE");
+        break;
+      case moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION:
+        RCLCPP_DEBUG(LOGGER, "Service failed with with error code: NO IK SOLUTION");
+        break;
+      default:
+        RCLCPP_DEBUG_STREAM(LOGGER, "Service failed with with error code: " << error_code.val);
     }
-  }
-  else
-  {
-    RCLCPP_DEBUG_STREAM(LOGGER, "Service call failed to connect to service: " << ik_service_client_->get_service_name());
-    error_code.val = error_code.FAILURE;
     return false;
   }
+
   // Convert the robot state message to our robot_state representation
-  if (!moveit::core::robotStateMsgToRobotState(response->solution, *robot_state_))
+  if (!moveit::core::robotStateMsgToRobotState(response.solution, *robot_state_))
   {
     RCLCPP_ERROR(LOGGER, "An error occurred converting received robot state message into internal robot state.");
     error_code.val = error_code.FAILURE;
@@ -346,34 +448,36 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::msg:
 
   // Get just the joints we are concerned about in our planning group
   robot_state_->copyJointGroupPositions(joint_model_group_, solution);
+  return true;
+}
 
+bool SrvKinematicsPlugin::checkSolution(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& solution,
+                                        const IKCallbackFn& solution_callback,
+                                        moveit_msgs::msg::MoveItErrorCodes& error_code) const
+{
   // Run the solution callback (i.e. collision checker) if available
-  if (solution_callback)
-  {
-    RCLCPP_DEBUG(LOGGER, "Calling solution callback on IK solution");
+  if (!solution_callback)
+    return true;
 
-    // hack: should use all poses, not just the 0th
-    solution_callback(ik_poses[0], solution, error_code);
+  RCLCPP_DEBUG(LOGGER, "Calling solution callback on IK solution");
+  solution_callback(ik_pose, solution, error_code);
 
-    if (error_code.val != error_code.SUCCESS)
+  if (error_code.val != error_code.SUCCESS)
+  {
+    switch (error_code.val)
     {
-      switch (error_code.val)
-      {
-        case moveit_msgs::msg::MoveItErrorCodes::FAILURE:
-          RCLCPP_ERROR(LOGGER, "IK solution callback failed with with error code: FAILURE");
-          break;
-        case moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION:
-          RCLCPP_ERROR(LOGGER, "IK solution callback failed with with error code: "
-                               "NO IK SOLUTION");
-          break;
-        default:
-          RCLCPP_ERROR_STREAM(LOGGER, "IK solution callback failed with with error code: " << error_code.val);
-      }
-      return false;
+      case moveit_msgs::msg::MoveItErrorCodes::FAILURE:
+        RCLCPP_ERROR(LOGGER, "IK solution callback failed with with error code: FAILURE");
+        break;
+      case moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION:
+        RCLCPP_ERROR(LOGGER, "IK solution callback failed with with error code: "
+                             "NO IK SOLUTION");
+        break;
+      default:
+        RCLCPP_ERROR_STREAM(LOGGER, "IK solution callback failed with with error code: " << error_code.val);
     }
+    return false;
   }
-
-  RCLCPP_INFO(LOGGER, "IK Solver Succeeded!");
   return true;
 }
 
@@ -626,6 +626,48 @@ TEST_F(KinematicsTest, searchIKWithCallback)
   EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_cb_tests_);
 }
 
+TEST_F(KinematicsTest, searchIKBatch)
+{
+  const std::vector<std::string>& fk_names = kinematics_solver_->getTipFrames();
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+
+  std::vector<geometry_msgs::msg::Pose> poses;
+  for (unsigned int i = 0; i < num_ik_tests_; ++i)
+  {
+    std::vector<double> fk_values;
+    robot_state.setToRandomPositions(jmg_, this->rng_);
+    robot_state.copyJointGroupPositions(jmg_, fk_values);
+    std::vector<geometry_msgs::msg::Pose> fk_poses;
+    ASSERT_TRUE(kinematics_solver_->getPositionFK(fk_names, fk_values, fk_poses));
+    poses.push_back(fk_poses[0]);
+  }
+
+  const std::vector<std::vector<double>> seeds(1, std::vector<double>(kinematics_solver_->getJointNames().size(), 0.0));
+  std::vector<std::vector<double>> solutions;
+  std::vector<moveit_msgs::msg::MoveItErrorCodes> error_codes;
+  kinematics_solver_->searchPositionIKBatch(poses, seeds, timeout_, solutions, error_codes);
+  ASSERT_EQ(solutions.size(), poses.size());
+  ASSERT_EQ(error_codes.size(), poses.size());
+
+  unsigned int success = 0;
+  for (std::size_t i = 0; i < poses.size(); ++i)
+  {
+    if (error_codes[i].val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+      continue;
+    ++success;
+
+    std::vector<geometry_msgs::msg::Pose> reached_poses;
+    kinematics_solver_->getPositionFK(fk_names, solutions[i], reached_poses);
+    EXPECT_NEAR_POSES({ poses[i] }, reached_poses, tolerance_);
+  }
+  EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_tests_);
+
+  // the number of seed states must match the number of poses
+  const std::vector<std::vector<double>> too_many_seeds(poses.size() + 1, seeds[0]);
+  EXPECT_FALSE(kinematics_solver_->searchPositionIKBatch(poses, too_many_seeds, timeout_, solutions, error_codes));
+}
+
 TEST_F(KinematicsTest, getIK)
 {
   std::vector<double> fk_values, solution;
@@ -43,9 +43,12 @@
 #include <moveit/collision_distance_field/collision_env_hybrid.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/utils/worker_pool.h>
 
 #include <Eigen/Core>
 #include <Eigen/StdVector>
+#include <functional>
+#include <memory>
 #include <vector>
 
 namespace chomp
@@ -53,9 +56,13 @@ namespace chomp
 class ChompOptimizer
 {
 public:
+  /**
+   * @param joint_costs Smoothness costs of a previous optimizer (see getJointCosts()) to reuse instead of computing
+   *        them again. They must have been computed for the same group, number of points and cost parameters.
+   */
   ChompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
                  const std::string& planning_group, const ChompParameters* parameters,
-                 const moveit::core::RobotState& start_state);
+                 const moveit::core::RobotState& start_state, const std::vector<ChompCost>* joint_costs = nullptr);
 
   virtual ~ChompOptimizer();
 
@@ -80,6 +87,12 @@ public:
     return is_collision_free_;
   }
 
+  /** \brief The scaled smoothness cost of every joint, only depending on the trajectory layout and cost parameters */
+  const std::vector<ChompCost>& getJointCosts() const
+  {
+    return joint_costs_;
+  }
+
 private:
   inline double getPotential(double field_distance, double radius, double clearance)
   {
@@ -101,14 +114,27 @@ private:
     }
   }
   template <typename Derived>
-  void getJacobian(int trajectoryPoint, Eigen::Vector3d& collision_point_pos, std::string& jointName,
+  void getJacobian(int trajectoryPoint, const Eigen::Vector3d& collision_point_pos, int collision_point,
                    Eigen::MatrixBase<Derived>& jacobian) const;
 
   // void getRandomState(const moveit::core::RobotState& currentState,
   //                     const std::string& group_name,
   //                     Eigen::VectorXd& state_vec);
 
-  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i);
+  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i, moveit::core::RobotState& state) const;
+
+  /** \brief Scratch state of one thread working on the per-point stages of an iteration */
+  struct WorkerScratch
+  {
+    moveit::core::RobotState state;
+    collision_detection::GroupStateRepresentationPtr gsr;
+    Eigen::MatrixXd jacobian;
+    Eigen::MatrixXd jacobian_pseudo_inverse;
+    Eigen::MatrixXd jacobian_jacobian_tranpose;
+  };
+
+  /** \brief Call \e fn for the trajectory points [start, end], split into contiguous blocks over the workers */
+  void forEachPoint(int start, int end, const std::function<void(int, WorkerScratch&)>& fn);
 
   // collision_proximity::CollisionProximitySpace::TrajectorySafety checkCurrentIterValidity();
 
@@ -134,9 +160,13 @@ private:
 
   std::vector<ChompCost> joint_costs_;
   collision_detection::GroupStateRepresentationPtr gsr_;
+  std::vector<WorkerScratch> workers_;
+  /** \brief Threads running the per-point stages, kept between iterations; worker i uses workers_[i] */
+  std::unique_ptr<moveit::core::WorkerPool> worker_pool_;
   bool initialized_;
 
-  std::vector<std::vector<std::string> > collision_point_joint_names_;
+  std::vector<std::vector<int> > collision_point_joints_; /**< Indices of the group joints moving each collision
+                                                             point */
   std::vector<EigenSTL::vector_Vector3d> collision_point_pos_eigen_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_vel_eigen_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_acc_eigen_;
@@ -170,9 +200,6 @@ private:
 
   // temporary variables for all functions:
   Eigen::VectorXd smoothness_derivative_;
-  Eigen::MatrixXd jacobian_;
-  Eigen::MatrixXd jacobian_pseudo_inverse_;
-  Eigen::MatrixXd jacobian_jacobian_tranpose_;
   Eigen::VectorXd random_state_;
   Eigen::VectorXd joint_state_velocities_;
 
@@ -196,7 +223,7 @@ private:
   }
 
   void registerParents(const moveit::core::JointModel* model);
-  void initialize();
+  void initialize(const std::vector<ChompCost>* joint_costs);
   void calculateSmoothnessIncrements();
   void calculateCollisionIncrements();
   void calculateTotalIncrements();
@@ -212,8 +239,10 @@ private:
   void getRandomMomentum();
   void updateMomentum();
   void updatePositionFromMomentum();
-  void calculatePseudoInverse();
-  void computeJointProperties(int trajectoryPoint);
+  void calculatePseudoInverse(WorkerScratch& scratch) const;
+  void computeJointProperties(int trajectoryPoint, const moveit::core::RobotState& state);
+  void computePointCollisionProperties(int trajectory_point, WorkerScratch& scratch);
+  void calculatePointCollisionIncrements(int trajectory_point, WorkerScratch& scratch);
   bool isCurrentTrajectoryMeshToMeshCollisionFree() const;
 };
 }  // namespace chomp
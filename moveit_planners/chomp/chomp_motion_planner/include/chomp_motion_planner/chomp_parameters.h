@@ -94,6 +94,8 @@ public:
                                     an initial path is not found with the specified chomp parameters */
   int max_recovery_attempts_;    /*!< this the maximum recovery attempts to find a collision free path after an initial
                                     failure to find a solution */
+  int num_threads_; /*!< number of threads computing the per-point forward kinematics and collision increments; 0 uses
+                       all hardware threads */
 };
 
 }  // namespace chomp
@@ -36,22 +36,50 @@
 
 #pragma once
 
+#include <chomp_motion_planner/chomp_cost.h>
 #include <chomp_motion_planner/chomp_parameters.h>
 #include <moveit/planning_interface/planning_request.h>
 #include <moveit/planning_interface/planning_response.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 
 namespace chomp
 {
+/** \brief Optimizer state carried from one request to the next, so that repeated planning between the same start and
+    goal (e.g. around a moving obstacle) re-optimizes the previous solution instead of starting over */
+struct ChompWarmStart
+{
+  /** \brief The last successfully optimized trajectory */
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+
+  /** \brief The smoothness costs of the last optimizer, valid for the group and parameters in joint_costs_key */
+  std::vector<ChompCost> joint_costs;
+  std::string joint_costs_group;
+  std::vector<double> joint_costs_key;
+
+  void clear()
+  {
+    trajectory.reset();
+    joint_costs.clear();
+    joint_costs_group.clear();
+    joint_costs_key.clear();
+  }
+};
+
 class ChompPlanner
 {
 public:
   ChompPlanner() = default;
   virtual ~ChompPlanner() = default;
 
+  /**
+   * @param warm_start If given, the previous solution stored in it initializes the trajectory when it connects the
+   *        requested start and goal, and its smoothness costs are reused when they still apply. A successful solve
+   *        stores its result back for the next request.
+   */
   bool solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
              const planning_interface::MotionPlanRequest& req, const ChompParameters& params,
-             planning_interface::MotionPlanDetailedResponse& res) const;
+             planning_interface::MotionPlanDetailedResponse& res, ChompWarmStart* warm_start = nullptr) const;
 };
 }  // namespace chomp
@@ -44,7 +44,9 @@
 #include <rclcpp/logging.hpp>
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/LU>
+#include <algorithm>
 #include <random>
+#include <thread>
 #include <visualization_msgs/msg/marker_array.hpp>
 
 namespace chomp
@@ -53,7 +55,8 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("chomp_optimizer");
 
 ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
                                const std::string& planning_group, const ChompParameters* parameters,
-                               const moveit::core::RobotState& start_state)
+                               const moveit::core::RobotState& start_state,
+                               const std::vector<ChompCost>* joint_costs)
   : full_trajectory_(trajectory)
   , robot_model_(planning_scene->getRobotModel())
   , planning_group_(planning_group)
@@ -74,10 +77,10 @@ ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene
     return;
   }
 
-  initialize();
+  initialize(joint_costs);
 }
 
-void ChompOptimizer::initialize()
+void ChompOptimizer::initialize(const std::vector<ChompCost>* joint_costs)
 {
   // init some variables:
   num_vars_free_ = group_trajectory_.getNumFreePoints();
@@ -101,32 +104,39 @@ void ChompOptimizer::initialize()
     num_collision_points_ += gradient.gradients.size();
   }
 
-  // set up the joint costs:
-  joint_costs_.reserve(num_joints_);
-
-  double max_cost_scale = 0.0;
-
   joint_model_group_ = planning_scene_->getRobotModel()->getJointModelGroup(planning_group_);
 
-  const std::vector<const moveit::core::JointModel*> joint_models = joint_model_group_->getActiveJointModels();
-  for (size_t i = 0; i < joint_models.size(); ++i)
+  // set up the joint costs, unless they have been computed already:
+  if (joint_costs && static_cast<int>(joint_costs->size()) == num_joints_)
   {
-    double joint_cost = 1.0;
-    // nh.param("joint_costs/" + joint_models[i]->getName(), joint_cost, 1.0);
-    std::vector<double> derivative_costs(3);
-    derivative_costs[0] = joint_cost * parameters_->smoothness_cost_velocity_;
-    derivative_costs[1] = joint_cost * parameters_->smoothness_cost_acceleration_;
-    derivative_costs[2] = joint_cost * parameters_->smoothness_cost_jerk_;
-    joint_costs_.push_back(ChompCost(group_trajectory_, i, derivative_costs, parameters_->ridge_factor_));
-    double cost_scale = joint_costs_[i].getMaxQuadCostInvValue();
-    if (max_cost_scale < cost_scale)
-      max_cost_scale = cost_scale;
+    joint_costs_ = *joint_costs;
   }
-
-  // scale the smoothness costs
-  for (int i = 0; i < num_joints_; ++i)
+  else
   {
-    joint_costs_[i].scale(max_cost_scale);
+    joint_costs_.reserve(num_joints_);
+
+    double max_cost_scale = 0.0;
+
+    const std::vector<const moveit::core::JointModel*> joint_models = joint_model_group_->getActiveJointModels();
+    for (size_t i = 0; i < joint_models.size(); ++i)
+    {
+      double joint_cost = 1.0;
+      // nh.param("joint_costs/" + joint_models[i]->getName(), joint_cost, 1.0);
+      std::vector<double> derivative_costs(3);
+      derivative_costs[0] = joint_cost * parameters_->smoothness_cost_velocity_;
+      derivative_costs[1] = joint_cost * parameters_->smoothness_cost_acceleration_;
+      derivative_costs[2] = joint_cost * parameters_->smoothness_cost_jerk_;
+      joint_costs_.push_back(ChompCost(group_trajectory_, i, derivative_costs, parameters_->ridge_factor_));
+      double cost_scale = joint_costs_[i].getMaxQuadCostInvValue();
+      if (max_cost_scale < cost_scale)
+        max_cost_scale = cost_scale;
+    }
+
+    // scale the smoothness costs
+    for (int i = 0; i < num_joints_; ++i)
+    {
+      joint_costs_[i].scale(max_cost_scale);
+    }
   }
 
   // allocate memory for matrices:
@@ -134,16 +144,28 @@ void ChompOptimizer::initialize()
   collision_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   final_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   smoothness_derivative_ = Eigen::VectorXd::Zero(num_vars_all_);
-  jacobian_ = Eigen::MatrixXd::Zero(3, num_joints_);
-  jacobian_pseudo_inverse_ = Eigen::MatrixXd::Zero(num_joints_, 3);
-  jacobian_jacobian_tranpose_ = Eigen::MatrixXd::Zero(3, 3);
   random_state_ = Eigen::VectorXd::Zero(num_joints_);
   joint_state_velocities_ = Eigen::VectorXd::Zero(num_joints_);
 
   group_trajectory_backup_ = group_trajectory_.getTrajectory();
   best_group_trajectory_ = group_trajectory_.getTrajectory();
 
-  collision_point_joint_names_.resize(num_vars_all_, std::vector<std::string>(num_collision_points_));
+  // one scratch state per thread for the per-point stages, each thread needs its own collision representation
+  int num_threads = parameters_->num_threads_ > 0 ? parameters_->num_threads_ :
+                                                    static_cast<int>(std::thread::hardware_concurrency());
+  num_threads = std::clamp(num_threads, 1, std::max(num_vars_all_, 1));
+  workers_.clear();
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i)
+  {
+    workers_.push_back(WorkerScratch{ state_, i == 0 ? gsr_ : nullptr, Eigen::MatrixXd::Zero(3, num_joints_),
+                                      Eigen::MatrixXd::Zero(num_joints_, 3), Eigen::MatrixXd::Zero(3, 3) });
+    if (!workers_.back().gsr)
+      hy_env_->getCollisionGradients(req, res, state_, &planning_scene_->getAllowedCollisionMatrix(),
+                                     workers_.back().gsr);
+  }
+  worker_pool_ = std::make_unique<moveit::core::WorkerPool>(num_threads);
+
   collision_point_pos_eigen_.resize(num_vars_all_, EigenSTL::vector_Vector3d(num_collision_points_));
   collision_point_vel_eigen_.resize(num_vars_all_, EigenSTL::vector_Vector3d(num_collision_points_));
   collision_point_acc_eigen_.resize(num_vars_all_, EigenSTL::vector_Vector3d(num_collision_points_));
@@ -223,26 +245,28 @@ void ChompOptimizer::initialize()
     }
   }
 
-  int start = free_vars_start_;
-  int end = free_vars_end_;
-  for (int i = start; i <= end; ++i)
+  // resolve the group joints moving each collision point once, so the jacobians need no name lookups while optimizing
+  collision_point_joints_.assign(num_collision_points_, std::vector<int>());
+  size_t j = 0;
+  for (const collision_detection::GradientInfo& info : gsr_->gradients_)
   {
-    size_t j = 0;
-    for (const collision_detection::GradientInfo& info : gsr_->gradients_)
+    std::vector<int> ancestor_joints;
+    const auto resolved = fixed_link_resolution_map.find(info.joint_name);
+    if (resolved != fixed_link_resolution_map.end())
     {
-      for (size_t k = 0; k < info.sphere_locations.size(); ++k)
+      for (int k = 0; k < num_joints_; ++k)
       {
-        if (fixed_link_resolution_map.find(info.joint_name) != fixed_link_resolution_map.end())
-        {
-          collision_point_joint_names_[i][j] = fixed_link_resolution_map[info.joint_name];
-        }
-        else
-        {
-          RCLCPP_ERROR(LOGGER, "Couldn't find joint %s!", info.joint_name.c_str());
-        }
-        j++;
+        if (isParent(resolved->second, joint_names_[k]))
+          ancestor_joints.push_back(k);
       }
     }
+    else
+    {
+      RCLCPP_ERROR(LOGGER, "Couldn't find joint %s!", info.joint_name.c_str());
+    }
+
+    for (size_t k = 0; k < info.sphere_locations.size(); ++k)
+      collision_point_joints_[j++] = ancestor_joints;
   }
   initialized_ = true;
 }
@@ -585,15 +609,6 @@ void ChompOptimizer::calculateSmoothnessIncrements()
 
 void ChompOptimizer::calculateCollisionIncrements()
 {
-  double potential;
-  double vel_mag_sq;
-  double vel_mag;
-  Eigen::Vector3d potential_gradient;
-  Eigen::Vector3d normalized_velocity;
-  Eigen::Matrix3d orthogonal_projector;
-  Eigen::Vector3d curvature_vector;
-  Eigen::Vector3d cartesian_gradient;
-
   collision_increments_.setZero(num_vars_free_, num_joints_);
 
   int start_point = 0;
@@ -615,56 +630,61 @@ void ChompOptimizer::calculateCollisionIncrements()
     start_point = free_vars_start_;
   }
 
-  for (int i = start_point; i <= end_point; ++i)
-  {
-    for (int j = 0; j < num_collision_points_; ++j)
-    {
-      potential = collision_point_potential_[i][j];
+  forEachPoint(start_point, end_point,
+               [this](int i, WorkerScratch& scratch) { calculatePointCollisionIncrements(i, scratch); });
+}
 
-      if (potential < 0.0001)
-        continue;
+void ChompOptimizer::calculatePointCollisionIncrements(int i, WorkerScratch& scratch)
+{
+  double potential;
+  double vel_mag_sq;
+  double vel_mag;
+  Eigen::Vector3d potential_gradient;
+  Eigen::Vector3d normalized_velocity;
+  Eigen::Matrix3d orthogonal_projector;
+  Eigen::Vector3d curvature_vector;
+  Eigen::Vector3d cartesian_gradient;
 
-      potential_gradient = -collision_point_potential_gradient_[i][j];
+  for (int j = 0; j < num_collision_points_; ++j)
+  {
+    potential = collision_point_potential_[i][j];
 
-      vel_mag = collision_point_vel_mag_[i][j];
-      vel_mag_sq = vel_mag * vel_mag;
+    if (potential < 0.0001)
+      continue;
 
-      // all math from the CHOMP paper:
+    potential_gradient = -collision_point_potential_gradient_[i][j];
 
-      normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
-      orthogonal_projector = Eigen::Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
-      curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
-      cartesian_gradient = vel_mag * (orthogonal_projector * potential_gradient - potential * curvature_vector);
+    vel_mag = collision_point_vel_mag_[i][j];
+    vel_mag_sq = vel_mag * vel_mag;
 
-      // pass it through the jacobian transpose to get the increments
-      getJacobian(i, collision_point_pos_eigen_[i][j], collision_point_joint_names_[i][j], jacobian_);
+    // all math from the CHOMP paper:
 
-      if (parameters_->use_pseudo_inverse_)
-      {
-        calculatePseudoInverse();
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_pseudo_inverse_ * cartesian_gradient;
-      }
-      else
-      {
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_.transpose() * cartesian_gradient;
-      }
+    normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
+    orthogonal_projector = Eigen::Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
+    curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
+    cartesian_gradient = vel_mag * (orthogonal_projector * potential_gradient - potential * curvature_vector);
 
-      /*
-        if(point_is_in_collision_[i][j])
-        {
-        break;
-        }
-      */
+    // pass it through the jacobian transpose to get the increments
+    getJacobian(i, collision_point_pos_eigen_[i][j], j, scratch.jacobian);
+
+    if (parameters_->use_pseudo_inverse_)
+    {
+      calculatePseudoInverse(scratch);
+      collision_increments_.row(i - free_vars_start_).transpose() -=
+          scratch.jacobian_pseudo_inverse * cartesian_gradient;
+    }
+    else
+    {
+      collision_increments_.row(i - free_vars_start_).transpose() -= scratch.jacobian.transpose() * cartesian_gradient;
     }
   }
-  // cout << collision_increments_ << endl;
 }
 
-void ChompOptimizer::calculatePseudoInverse()
+void ChompOptimizer::calculatePseudoInverse(WorkerScratch& scratch) const
 {
-  jacobian_jacobian_tranpose_ =
-      jacobian_ * jacobian_.transpose() + Eigen::MatrixXd::Identity(3, 3) * parameters_->pseudo_inverse_ridge_factor_;
-  jacobian_pseudo_inverse_ = jacobian_.transpose() * jacobian_jacobian_tranpose_.inverse();
+  scratch.jacobian_jacobian_tranpose = scratch.jacobian * scratch.jacobian.transpose() +
+                                       Eigen::MatrixXd::Identity(3, 3) * parameters_->pseudo_inverse_ridge_factor_;
+  scratch.jacobian_pseudo_inverse = scratch.jacobian.transpose() * scratch.jacobian_jacobian_tranpose.inverse();
 }
 
 void ChompOptimizer::calculateTotalIncrements()
@@ -752,21 +772,20 @@ double ChompOptimizer::getCollisionCost()
   return parameters_->obstacle_cost_weight_ * collision_cost;
 }
 
-void ChompOptimizer::computeJointProperties(int trajectory_point)
+void ChompOptimizer::computeJointProperties(int trajectory_point, const moveit::core::RobotState& state)
 {
+  const std::vector<const moveit::core::JointModel*>& joint_models = joint_model_group_->getActiveJointModels();
   for (int j = 0; j < num_joints_; ++j)
   {
-    const moveit::core::JointModel* joint_model = state_.getJointModel(joint_names_[j]);
+    const moveit::core::JointModel* joint_model = joint_models[j];
     const moveit::core::RevoluteJointModel* revolute_joint =
         dynamic_cast<const moveit::core::RevoluteJointModel*>(joint_model);
     const moveit::core::PrismaticJointModel* prismatic_joint =
         dynamic_cast<const moveit::core::PrismaticJointModel*>(joint_model);
 
-    std::string parent_link_name = joint_model->getParentLinkModel()->getName();
-    std::string child_link_name = joint_model->getChildLinkModel()->getName();
-    Eigen::Isometry3d joint_transform = state_.getGlobalLinkTransform(parent_link_name) *
-                                        (robot_model_->getLinkModel(child_link_name)->getJointOriginTransform() *
-                                         (state_.getJointTransform(joint_model)));
+    Eigen::Isometry3d joint_transform = state.getGlobalLinkTransform(joint_model->getParentLinkModel()) *
+                                        (joint_model->getChildLinkModel()->getJointOriginTransform() *
+                                         (state.getJointTransform(joint_model)));
 
     // joint_transform = inverseWorldTransform * jointTransform;
     Eigen::Vector3d axis;
@@ -792,27 +811,14 @@ void ChompOptimizer::computeJointProperties(int trajectory_point)
 }
 
 template <typename Derived>
-void ChompOptimizer::getJacobian(int trajectory_point, Eigen::Vector3d& collision_point_pos, std::string& joint_name,
+void ChompOptimizer::getJacobian(int trajectory_point, const Eigen::Vector3d& collision_point_pos, int collision_point,
                                  Eigen::MatrixBase<Derived>& jacobian) const
 {
-  for (int j = 0; j < num_joints_; ++j)
+  jacobian.setZero();
+  for (const int j : collision_point_joints_[collision_point])
   {
-    if (isParent(joint_name, joint_names_[j]))
-    {
-      Eigen::Vector3d column = joint_axes_[trajectory_point][j].cross(
-          Eigen::Vector3d(collision_point_pos(0), collision_point_pos(1), collision_point_pos(2)) -
-          joint_positions_[trajectory_point][j]);
-
-      jacobian.col(j)[0] = column.x();
-      jacobian.col(j)[1] = column.y();
-      jacobian.col(j)[2] = column.z();
-    }
-    else
-    {
-      jacobian.col(j)[0] = 0.0;
-      jacobian.col(j)[1] = 0.0;
-      jacobian.col(j)[2] = 0.0;
-    }
+    jacobian.col(j) =
+        joint_axes_[trajectory_point][j].cross(collision_point_pos - joint_positions_[trajectory_point][j]);
   }
 }
 
@@ -911,66 +917,10 @@ void ChompOptimizer::performForwardKinematics()
     end = num_vars_all_ - 1;
   }
 
-  is_collision_free_ = true;
-
-  auto total_dur = std::chrono::duration<double>::zero();
-
-  // for each point in the trajectory
-  for (int i = start; i <= end; ++i)
-  {
-    // Set Robot state from trajectory point...
-    collision_detection::CollisionRequest req;
-    collision_detection::CollisionResult res;
-    req.group_name = planning_group_;
-    setRobotStateFromPoint(group_trajectory_, i);
-    auto grad = std::chrono::system_clock::now();
-
-    hy_env_->getCollisionGradients(req, res, state_, nullptr, gsr_);
-    total_dur += (std::chrono::system_clock::now() - grad);
-    computeJointProperties(i);
-    state_is_in_collision_[i] = false;
-
-    // Keep vars in scope
-    {
-      size_t j = 0;
-      for (const collision_detection::GradientInfo& info : gsr_->gradients_)
-      {
-        for (size_t k = 0; k < info.sphere_locations.size(); ++k)
-        {
-          collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
-          collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
-          collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
-
-          collision_point_potential_[i][j] =
-              getPotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
-          collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
-          collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
-          collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
-
-          point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
-
-          if (point_is_in_collision_[i][j])
-          {
-            state_is_in_collision_[i] = true;
-            // if(is_collision_free_ == true) {
-            //   RCLCPP_INFO(LOGGER,"We know it's not collision free " << g);
-            //   RCLCPP_INFO(LOGGER,"Sphere location " << info.sphere_locations[k].x() << " " <<
-            //   info.sphere_locations[k].y() << " " << info.sphere_locations[k].z());
-            //   RCLCPP_INFO(LOGGER,"Gradient " << info.gradients[k].x() << " " << info.gradients[k].y() << " " <<
-            //   info.gradients[k].z() << " distance " << info.distances[k] << " radii " << info.sphere_radii[k]);
-            //   RCLCPP_INFO(LOGGER,"Radius " << info.sphere_radii[k] << " potential " <<
-            //   collision_point_potential_[i][j]);
-            // }
-
-            is_collision_free_ = false;
-          }
-          j++;
-        }
-      }
-    }
-  }
-
-  // RCLCPP_INFO(LOGGER,"Total dur " << total_dur << " total checks " << end-start+1);
+  // the points are independent, only the finite differencing below needs all of them
+  forEachPoint(start, end, [this](int i, WorkerScratch& scratch) { computePointCollisionProperties(i, scratch); });
+  is_collision_free_ = std::none_of(state_is_in_collision_.begin() + start, state_is_in_collision_.begin() + end + 1,
+                                    [](int in_collision) { return in_collision; });
 
   // now, get the vel and acc for each collision point (using finite differencing)
   for (int i = free_vars_start_; i <= free_vars_end_; ++i)
@@ -993,7 +943,63 @@ void ChompOptimizer::performForwardKinematics()
   }
 }
 
-void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i)
+void ChompOptimizer::computePointCollisionProperties(int i, WorkerScratch& scratch)
+{
+  // Set Robot state from trajectory point...
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  req.group_name = planning_group_;
+  setRobotStateFromPoint(group_trajectory_, i, scratch.state);
+
+  hy_env_->getCollisionGradients(req, res, scratch.state, nullptr, scratch.gsr);
+  computeJointProperties(i, scratch.state);
+  state_is_in_collision_[i] = false;
+
+  size_t j = 0;
+  for (const collision_detection::GradientInfo& info : scratch.gsr->gradients_)
+  {
+    for (size_t k = 0; k < info.sphere_locations.size(); ++k)
+    {
+      collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
+      collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
+      collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
+
+      collision_point_potential_[i][j] =
+          getPotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
+      collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
+      collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
+      collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
+
+      point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
+
+      if (point_is_in_collision_[i][j])
+        state_is_in_collision_[i] = true;
+      j++;
+    }
+  }
+}
+
+void ChompOptimizer::forEachPoint(int start, int end, const std::function<void(int, WorkerScratch&)>& fn)
+{
+  const int num_points = end - start + 1;
+  const int num_workers = std::min(static_cast<int>(workers_.size()), num_points);
+  if (num_workers <= 1)
+  {
+    for (int i = start; i <= end; ++i)
+      fn(i, workers_[0]);
+    return;
+  }
+
+  // one contiguous block of points per worker, the scratch is selected by the thread running the block
+  worker_pool_->run(num_workers, [&](std::size_t block, std::size_t worker) {
+    const int block_end = start + num_points * (static_cast<int>(block) + 1) / num_workers;
+    for (int i = start + num_points * static_cast<int>(block) / num_workers; i < block_end; ++i)
+      fn(i, workers_[worker]);
+  });
+}
+
+void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i,
+                                            moveit::core::RobotState& state) const
 {
   const Eigen::MatrixXd::RowXpr& point = group_trajectory.getTrajectoryPoint(i);
 
@@ -1002,8 +1008,8 @@ void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, i
   for (size_t j = 0; j < group_trajectory.getNumJoints(); ++j)
     joint_states.emplace_back(point(0, j));
 
-  state_.setJointGroupPositions(planning_group_, joint_states);
-  state_.update();
+  state.setJointGroupPositions(planning_group_, joint_states);
+  state.update();
 }
 
 void ChompOptimizer::perturbTrajectory()
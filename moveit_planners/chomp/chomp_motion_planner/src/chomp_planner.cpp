@@ -48,9 +48,12 @@ namespace chomp
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("chomp_planner");
 
+// how close (in joint space) a previous solution must start and end to the request to warm-start from it
+static const double WARM_START_TOLERANCE = 1e-3;
+
 bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
                          const planning_interface::MotionPlanRequest& req, const ChompParameters& params,
-                         planning_interface::MotionPlanDetailedResponse& res) const
+                         planning_interface::MotionPlanDetailedResponse& res, ChompWarmStart* warm_start) const
 {
   auto start_time = std::chrono::system_clock::now();
   if (!planning_scene)
@@ -122,8 +125,27 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     }
   }
 
+  // re-optimize the previous solution if it connects the same start and goal, the scene may have changed since
+  bool warm_started = false;
+  if (warm_start && warm_start->trajectory && warm_start->trajectory->getGroup() == model_group &&
+      warm_start->trajectory->getWayPointCount() >= 2 &&
+      warm_start->trajectory->getFirstWayPoint().distance(start_state, model_group) < WARM_START_TOLERANCE &&
+      warm_start->trajectory->getLastWayPoint().distance(goal_state, model_group) < WARM_START_TOLERANCE)
+  {
+    // keep the exact start and goal of this request
+    const Eigen::RowVectorXd start_point = trajectory.getTrajectoryPoint(0);
+    const Eigen::RowVectorXd goal_point = trajectory.getTrajectoryPoint(goal_index);
+    warm_started = trajectory.fillInFromTrajectory(*warm_start->trajectory);
+    trajectory.getTrajectoryPoint(0) = start_point;
+    trajectory.getTrajectoryPoint(goal_index) = goal_point;
+  }
+
   // fill in an initial trajectory based on user choice from the chomp_config.yaml file
-  if (params.trajectory_initialization_method_.compare("quintic-spline") == 0)
+  if (warm_started)
+  {
+    RCLCPP_INFO(LOGGER, "CHOMP trajectory initialized from the previous solution");
+  }
+  else if (params.trajectory_initialization_method_.compare("quintic-spline") == 0)
   {
     trajectory.fillInMinJerk();
   }
@@ -155,8 +177,11 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     return false;
   }
 
-  RCLCPP_INFO(LOGGER, "CHOMP trajectory initialized using method: %s ",
-              (params.trajectory_initialization_method_).c_str());
+  if (!warm_started)
+  {
+    RCLCPP_INFO(LOGGER, "CHOMP trajectory initialized using method: %s ",
+                (params.trajectory_initialization_method_).c_str());
+  }
 
   // optimize!
   auto create_time = std::chrono::system_clock::now();
@@ -173,6 +198,7 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
   org_max_iterations = params.max_iterations_;
 
   std::unique_ptr<ChompOptimizer> optimizer;
+  std::vector<double> joint_costs_key;
 
   // create a non_const_params variable which stores the non constant version of the const params variable
   ChompParameters params_nonconst = params;
@@ -190,8 +216,14 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
 
     // initialize a ChompOptimizer object to load up the optimizer with default parameters or with updated parameters in
     // case of a recovery behaviour
-    optimizer =
-        std::make_unique<ChompOptimizer>(&trajectory, planning_scene, req.group_name, &params_nonconst, start_state);
+    // the smoothness costs only depend on the trajectory layout and these parameters
+    joint_costs_key = { static_cast<double>(trajectory.getNumPoints()), trajectory.getDiscretization(),
+                        params_nonconst.smoothness_cost_velocity_,      params_nonconst.smoothness_cost_acceleration_,
+                        params_nonconst.smoothness_cost_jerk_,          params_nonconst.ridge_factor_ };
+    const bool reuse_joint_costs = warm_start && warm_start->joint_costs_group == req.group_name &&
+                                   warm_start->joint_costs_key == joint_costs_key;
+    optimizer = std::make_unique<ChompOptimizer>(&trajectory, planning_scene, req.group_name, &params_nonconst,
+                                                 start_state, reuse_joint_costs ? &warm_start->joint_costs : nullptr);
     if (!optimizer->isInitialized())
     {
       RCLCPP_ERROR(LOGGER, "Could not initialize optimizer");
@@ -288,6 +320,15 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     }
   }
 
+  if (warm_start)
+  {
+    // copy, the response trajectory is usually post-processed further
+    warm_start->trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(*result, true);
+    warm_start->joint_costs = optimizer->getJointCosts();
+    warm_start->joint_costs_group = req.group_name;
+    warm_start->joint_costs_key = joint_costs_key;
+  }
+
   res.processing_time.resize(1);
   res.processing_time[0] = std::chrono::duration<double>(std::chrono::system_clock::now() - start_time).count();
 
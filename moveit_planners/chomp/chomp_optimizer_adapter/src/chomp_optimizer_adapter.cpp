@@ -49,6 +49,7 @@
 #include <rclcpp/logging.hpp>
 #include <rclcpp/node.hpp>
 #include <rclcpp/parameter_value.hpp>
+#include <mutex>
 #include <vector>
 
 namespace chomp
@@ -155,6 +156,16 @@ public:
       RCLCPP_DEBUG(LOGGER, "Param use_stochastic_descent was not set. Using default value: %d",
                    params_.use_stochastic_descent_);
     }
+    if (!node->get_parameter("chomp.enable_warm_start", enable_warm_start_))
+    {
+      enable_warm_start_ = false;
+      RCLCPP_DEBUG(LOGGER, "Param enable_warm_start was not set. Using default value: %d", enable_warm_start_);
+    }
+    if (!node->get_parameter("chomp.num_threads", params_.num_threads_))
+    {
+      params_.num_threads_ = 1;
+      RCLCPP_DEBUG(LOGGER, "Param num_threads was not set. Using default value: %d", params_.num_threads_);
+    }
     params_.trajectory_initialization_method_ = "quintic-spline";
     std::string method;
     if (node->get_parameter("chomp.trajectory_initialization_method", method) &&
@@ -183,20 +194,39 @@ public:
     if (!planner(ps, req, res))
       return false;
 
-    // create a hybrid collision detector to set the collision checker as hybrid
-    collision_detection::CollisionDetectorAllocatorPtr hybrid_cd(
-        collision_detection::CollisionDetectorAllocatorHybrid::create());
+    // the warm start state is used by one request at a time, concurrent requests plan from scratch
+    std::unique_lock<std::mutex> warm_start_lock(warm_start_mutex_, std::defer_lock);
+    const bool warm_start = enable_warm_start_ && warm_start_lock.try_lock();
 
-    // create a writable planning scene
-    planning_scene::PlanningScenePtr planning_scene = ps->diff();
-    RCLCPP_DEBUG(LOGGER, "Configuring Planning Scene for CHOMP ...");
-    planning_scene->allocateCollisionDetector(hybrid_cd);
+    planning_scene::PlanningScenePtr planning_scene;
+    if (warm_start && warm_start_scene_ && canReuseScene(*ps, *warm_start_scene_))
+    {
+      // the distance field of the world is still valid, only take over the robot state and allowed collisions
+      RCLCPP_DEBUG(LOGGER, "Reusing the CHOMP planning scene of the previous request");
+      planning_scene = warm_start_scene_;
+      planning_scene->setCurrentState(ps->getCurrentState());
+      planning_scene->getAllowedCollisionMatrixNonConst() = ps->getAllowedCollisionMatrix();
+    }
+    else
+    {
+      // create a hybrid collision detector to set the collision checker as hybrid
+      collision_detection::CollisionDetectorAllocatorPtr hybrid_cd(
+          collision_detection::CollisionDetectorAllocatorHybrid::create());
+
+      // create a writable planning scene
+      planning_scene = ps->diff();
+      RCLCPP_DEBUG(LOGGER, "Configuring Planning Scene for CHOMP ...");
+      planning_scene->allocateCollisionDetector(hybrid_cd);
+      if (warm_start)
+        warm_start_scene_ = planning_scene;
+    }
 
     chomp::ChompPlanner chomp_planner;
     planning_interface::MotionPlanDetailedResponse res_detailed;
     res_detailed.trajectory.push_back(res.trajectory);
 
-    bool planning_success = chomp_planner.solve(planning_scene, req, params_, res_detailed);
+    bool planning_success =
+        chomp_planner.solve(planning_scene, req, params_, res_detailed, warm_start ? &warm_start_ : nullptr);
 
     if (planning_success)
     {
@@ -209,7 +239,38 @@ public:
   }
 
 private:
+  /** \brief Check whether a scene prepared for a previous request still has the world of \e scene. World objects
+      are copied on write while shared, so unchanged objects are the very same instances. Octrees are updated in
+      place and therefore never considered unchanged. */
+  static bool canReuseScene(const planning_scene::PlanningScene& scene,
+                            const planning_scene::PlanningScene& warm_start_scene)
+  {
+    if (scene.getRobotModel() != warm_start_scene.getRobotModel())
+      return false;
+
+    const collision_detection::World& world = *scene.getWorld();
+    const collision_detection::World& warm_start_world = *warm_start_scene.getWorld();
+    if (world.size() != warm_start_world.size())
+      return false;
+    for (auto it = world.begin(), warm_start_it = warm_start_world.begin(); it != world.end(); ++it, ++warm_start_it)
+    {
+      if (it->second != warm_start_it->second)
+        return false;
+      for (const shapes::ShapeConstPtr& shape : it->second->shapes_)
+      {
+        if (shape->type == shapes::OCTREE)
+          return false;
+      }
+    }
+    return true;
+  }
+
   chomp::ChompParameters params_;
+  bool enable_warm_start_ = false;
+
+  mutable std::mutex warm_start_mutex_;
+  mutable planning_scene::PlanningScenePtr warm_start_scene_;
+  mutable chomp::ChompWarmStart warm_start_;
 };
 }  // namespace chomp
 
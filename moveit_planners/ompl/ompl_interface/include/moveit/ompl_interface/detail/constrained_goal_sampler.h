@@ -43,20 +43,49 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_model/joint_model_group.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace ompl_interface
 {
 class ModelBasedPlanningContext;
 
 /** @class ConstrainedGoalSampler
- *  An interface to the OMPL goal lazy sampler*/
+ *  An interface to the OMPL goal lazy sampler
+ *
+ *  Goals are sampled on the GoalLazySamples thread. Each additional constraint sampler passed at construction runs
+ *  on its own producer thread, adding goal states concurrently while the sampling thread is active. The producers
+ *  share the kinematics solvers of the planning groups with the sampling thread, so additional constraint samplers
+ *  must only be passed if these solvers support concurrent queries. They are opt-in through the goal_sampling_threads
+ *  planner configuration key, which is ignored for groups with other solvers. */
 class ConstrainedGoalSampler : public ompl::base::GoalLazySamples
 {
 public:
   ConstrainedGoalSampler(const ModelBasedPlanningContext* pc, kinematic_constraints::KinematicConstraintSetPtr ks,
-                         constraint_samplers::ConstraintSamplerPtr cs = constraint_samplers::ConstraintSamplerPtr());
+                         constraint_samplers::ConstraintSamplerPtr cs = constraint_samplers::ConstraintSamplerPtr(),
+                         const std::vector<constraint_samplers::ConstraintSamplerPtr>& additional_cs = {});
+
+  ~ConstrainedGoalSampler() override;
 
 private:
+  /** \brief The state used by one of the additional producer threads */
+  struct GoalProducer
+  {
+    constraint_samplers::ConstraintSamplerPtr constraint_sampler;
+    ompl::base::StateSamplerPtr default_sampler;
+    moveit::core::RobotState work_state;
+    std::thread thread;
+  };
+
   bool sampleUsingConstraintSampler(const ompl::base::GoalLazySamples* gls, ompl::base::State* new_goal);
+  bool samplingFinished(const ompl::base::GoalLazySamples* gls) const;
+  bool sampleGoal(const constraint_samplers::ConstraintSamplerPtr& constraint_sampler,
+                  const ompl::base::StateSamplerPtr& default_sampler, moveit::core::RobotState& work_state,
+                  ompl::base::State* new_goal, unsigned int attempts_so_far, bool verbose);
+  void produceGoals(GoalProducer& producer);
+  void startProducers();
+  void stopProducers();
   bool stateValidityCallback(ompl::base::State* new_goal, moveit::core::RobotState const* state,
                              const moveit::core::JointModelGroup* /*jmg*/, const double* /*jpos*/,
                              bool verbose = false) const;
@@ -68,8 +97,15 @@ private:
   constraint_samplers::ConstraintSamplerPtr constraint_sampler_;
   ompl::base::StateSamplerPtr default_sampler_;
   moveit::core::RobotState work_state_;
-  unsigned int invalid_sampled_constraints_;
-  bool warned_invalid_samples_;
+  std::atomic<unsigned int> invalid_sampled_constraints_;
+  std::atomic<bool> warned_invalid_samples_;
   unsigned int verbose_display_;
+
+  std::vector<GoalProducer> producers_;
+  bool producers_started_;
+  std::atomic<bool> stop_producers_;
+  std::atomic<bool> producers_interrupted_;
+  std::atomic<unsigned int> active_producers_;
+  std::atomic<unsigned int> producer_attempts_;
 };
 }  // namespace ompl_interface
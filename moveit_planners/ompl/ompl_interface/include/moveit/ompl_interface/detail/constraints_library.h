@@ -42,6 +42,8 @@
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <ompl/base/StateStorage.h>
 #include <boost/serialization/map.hpp>
+#include <atomic>
+#include <mutex>
 
 namespace ompl_interface
 {
@@ -58,6 +60,12 @@ public:
                           moveit_msgs::msg::Constraints msg, std::string filename, ompl::base::StateStoragePtr storage,
                           std::size_t milestones = 0);
 
+  /** \brief Create an approximation whose states are read from the database at \e path only when a planning request
+      first needs them. */
+  ConstraintApproximation(std::string group, std::string state_space_parameterization, bool explicit_motions,
+                          moveit_msgs::msg::Constraints msg, std::string filename, std::string path,
+                          ompl::base::StateSpacePtr state_space, std::size_t milestones);
+
   virtual ~ConstraintApproximation()
   {
   }
@@ -101,17 +109,34 @@ public:
     return constraint_msg_;
   }
 
+  /** \brief Get the stored states, loading them from the database first if that hasn't happened yet */
   const ompl::base::StateStoragePtr& getStateStorage() const
   {
+    loadStateStorage();
     return state_storage_ptr_;
   }
 
+  /** \brief Check whether the stored states are in memory */
+  bool isLoaded() const
+  {
+    return loaded_;
+  }
+
   const std::string& getFilename() const
   {
     return ompldb_filename_;
   }
 
+  /** \brief Get the path of the database the states are loaded from, empty if they were constructed in memory */
+  const std::string& getPath() const
+  {
+    return ompldb_path_;
+  }
+
 protected:
+  /** \brief Read the stored states from the database, once */
+  void loadStateStorage() const;
+
   std::string group_;
   std::string state_space_parameterization_;
   bool explicit_motions_;
@@ -121,8 +146,14 @@ protected:
   std::vector<int> space_signature_;
 
   std::string ompldb_filename_;
-  ompl::base::StateStoragePtr state_storage_ptr_;
-  ConstraintApproximationStateStorage* state_storage_;
+  std::string ompldb_path_;
+  ompl::base::StateSpacePtr state_space_;
+
+  // filled by loadStateStorage() for approximations read from a database
+  mutable std::once_flag load_once_;
+  mutable std::atomic<bool> loaded_;
+  mutable ompl::base::StateStoragePtr state_storage_ptr_;
+  mutable ConstraintApproximationStateStorage* state_storage_;
   std::size_t milestones_;
 };
 
@@ -135,6 +166,8 @@ struct ConstraintApproximationConstructionOptions
     , explicit_motions(false)
     , explicit_points_resolution(0.0)
     , max_explicit_points(0)
+    , num_threads(1)
+    , append(false)
   {
   }
 
@@ -145,6 +178,15 @@ struct ConstraintApproximationConstructionOptions
   bool explicit_motions;
   double explicit_points_resolution;
   unsigned int max_explicit_points;
+
+  /** \brief Number of threads used to sample states and compute connections (0 uses all hardware threads).
+      States generated by a constraint sampler are always sampled sequentially, as the IK solvers they rely on are
+      shared. */
+  unsigned int num_threads;
+
+  /** \brief If an approximation with the same name is already in the library, keep its states and connections and
+      add \e samples new states to it instead of constructing it from scratch */
+  bool append;
 };
 
 struct ConstraintApproximationConstructionResults
@@ -156,6 +198,17 @@ struct ConstraintApproximationConstructionResults
   double sampling_success_rate;
 };
 
+/** \brief Connect the milestones [0, \e milestones) of \e cass by motions shorter than options.max_edge_length that
+    satisfy \e kset, with up to options.edges_per_sample connections per milestone. Milestones are connected greedily
+    in the order of their indices, so the result does not depend on options.num_threads. Pairs of the first
+    \e old_milestones milestones, which belong to an extended approximation, are not connected again.
+    \return The number of added connections */
+std::size_t connectConstraintApproximationMilestones(ModelBasedPlanningContext* pcontext,
+                                                     ConstraintApproximationStateStorage* cass, std::size_t milestones,
+                                                     std::size_t old_milestones,
+                                                     const kinematic_constraints::KinematicConstraintSet& kset,
+                                                     const ConstraintApproximationConstructionOptions& options);
+
 MOVEIT_CLASS_FORWARD(ConstraintsLibrary);  // Defines ConstraintsLibraryPtr, ConstPtr, WeakPtr... etc
 
 class ConstraintsLibrary
@@ -165,6 +218,8 @@ public:
   {
   }
 
+  /** \brief Register the approximations listed in the manifest at \e path. The states of each one are only read
+      from its database when it is first requested. */
   void loadConstraintApproximations(const std::string& path);
 
   void saveConstraintApproximations(const std::string& path);
@@ -195,7 +250,8 @@ private:
                                                                const moveit_msgs::msg::Constraints& constr_sampling,
                                                                const moveit_msgs::msg::Constraints& constr_hard,
                                                                const ConstraintApproximationConstructionOptions& options,
-                                                               ConstraintApproximationConstructionResults& result);
+                                                               ConstraintApproximationConstructionResults& result,
+                                                               const ConstraintApproximationPtr& existing);
 
   ModelBasedPlanningContext* context_;
   std::map<std::string, ConstraintApproximationPtr> constraint_approximations_;
@@ -0,0 +1,91 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit/collision_detection/collision_common.h>
+#include <ompl/base/DiscreteMotionValidator.h>
+#include <ompl/base/MotionValidator.h>
+
+namespace ompl_interface
+{
+class ModelBasedPlanningContext;
+
+/** @class ContinuousMotionValidator
+ *  @brief A motion validator that checks the robot against the world with one continuous collision query per motion.
+ *
+ *  The swept query of the collision checker covers the whole motion, instead of only the states OMPL samples along
+ *  it at the resolution given by `longest_valid_segment_fraction`. Both Bullet and FCL move each link on a straight
+ *  line between its poses in the two states, which approximates the joint space motion closely for the short motions
+ *  of sampling-based planners. Bullet casts the collision shapes along that line; FCL samples it finely enough that
+ *  no point moves more than a centimeter between samples.
+ *
+ *  Continuous checks don't cover self-collisions, path constraints and feasibility, so the states between the ends of
+ *  the motion are still checked for those at the resolution of the state space. Collision checkers without
+ *  continuous checks fall back to the discrete motion validation of OMPL.
+ *
+ *  Selected with `motion_validator: continuous` in the planner configuration of a group.
+ */
+class ContinuousMotionValidator : public ompl::base::MotionValidator
+{
+public:
+  ContinuousMotionValidator(const ModelBasedPlanningContext* planning_context);
+
+  bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const override;
+
+  /** \brief Check the motion from \e s1 to \e s2. If it is invalid, the last valid state and its fraction of the
+   * motion are searched along the motion at the resolution of the state space, like the discrete motion validator
+   * does. If no sampled state is invalid, the motion is only valid up to \e s1. */
+  bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                   std::pair<ompl::base::State*, double>& last_valid) const override;
+
+  /** \brief True if the collision checker of the planning scene supports continuous collision checks */
+  bool isContinuous() const
+  {
+    return continuous_;
+  }
+
+private:
+  /** \brief Check the motion without counting it as valid or invalid motion */
+  bool isMotionValid(const ompl::base::State* s1, const ompl::base::State* s2) const;
+
+  const ModelBasedPlanningContext* planning_context_;
+  bool continuous_;
+  ompl::base::DiscreteMotionValidator discrete_validator_;
+  TSStateStorage tss_start_;
+  TSStateStorage tss_end_;
+  collision_detection::CollisionRequest collision_request_;
+};
+}  // namespace ompl_interface
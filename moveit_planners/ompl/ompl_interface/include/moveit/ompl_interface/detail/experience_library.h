@@ -0,0 +1,107 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Library of previously planned paths, recalled for similar planning requests */
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/joint_model_group.h>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(ExperienceLibrary);  // Defines ExperienceLibraryPtr, ConstPtr, WeakPtr... etc
+
+/** \brief A path planned for a joint model group, as the group's joint values of every waypoint */
+typedef std::vector<std::vector<double>> ExperiencePath;
+
+/** \brief Library of successfully planned paths, recalled and repaired for similar planning requests.
+ *
+ * Experiences are indexed by their start and goal waypoints. A request is similar if the start of a stored path is
+ * close to its start state and the goal of the path satisfies its goal constraints. Stored paths that start and end
+ * at the same waypoints as a new one are replaced by it. The library is shared by all planning contexts and is
+ * thread-safe. Experiences are destroyed once they are replaced or dropped and no longer used, so observers can
+ * track them with weak pointers. */
+class ExperienceLibrary
+{
+public:
+  /** \brief Callback for every experience added with notification, e.g. to store it persistently. It is called on the
+   * thread adding the experience, so it should return quickly. */
+  typedef std::function<void(const moveit::core::JointModelGroup* group,
+                             const std::shared_ptr<const ExperiencePath>& path)>
+      InsertionCallback;
+
+  /** \brief Keep at most \e capacity experiences per joint model group, dropping the oldest ones */
+  ExperienceLibrary(std::size_t capacity = 1000);
+
+  /** \brief Add the \e path planned for \e group. Paths with fewer than two waypoints are ignored.
+   * \param notify Whether to call the insertion callback, e.g. not when loading stored experiences
+   * \return The added experience, or nullptr if the path was ignored */
+  std::shared_ptr<const ExperiencePath> addExperience(const moveit::core::JointModelGroup* group, ExperiencePath path,
+                                                      bool notify = true);
+
+  /** \brief Get up to \e count experiences of \e group, ordered by the distance of their start to \e start, whose
+   * last waypoint satisfies \e is_goal. Experiences starting farther than \e max_start_distance away are ignored. */
+  std::vector<std::shared_ptr<const ExperiencePath>>
+  findExperiences(const moveit::core::JointModelGroup* group, const double* start,
+                  const std::function<bool(const std::vector<double>& waypoint)>& is_goal, std::size_t count,
+                  double max_start_distance = std::numeric_limits<double>::infinity()) const;
+
+  /** \brief Get the number of experiences of \e group */
+  std::size_t size(const std::string& group) const;
+
+  /** \brief Remove all experiences */
+  void clear();
+
+  void setInsertionCallback(const InsertionCallback& callback)
+  {
+    std::scoped_lock lock(lock_);
+    insertion_callback_ = callback;
+  }
+
+private:
+  const std::size_t capacity_;
+  std::map<std::string, std::deque<std::shared_ptr<const ExperiencePath>>> experiences_;
+  InsertionCallback insertion_callback_;
+  mutable std::mutex lock_;
+};
+}  // namespace ompl_interface
@@ -0,0 +1,114 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Per-thread cache of link positions, shared by the state validity checker and projection evaluators */
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_state/robot_state.h>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(FKCache);  // Defines FKCachePtr, ConstPtr, WeakPtr... etc
+
+/** \brief Cache of the link positions the state validity checker computed for recently checked states.
+ *
+ * KPIECE and ProjEST project every new tree node, usually right after the state validity checker computed forward
+ * kinematics for the same joint values. The checker records the positions of the links registered here, keyed by a
+ * hash of the joint group values, and projection evaluators look them up instead of running forward kinematics again.
+ *
+ * Every thread records into its own ring of \e capacity entries, so neither insert() nor lookup() takes a lock once a
+ * thread used the cache. Entries depend on the joints outside of the group, so clear() must be called whenever the
+ * start state changes. */
+class FKCache
+{
+public:
+  FKCache(std::size_t capacity = 64);
+
+  /** \brief Record the position of \e link for inserted states. Not thread-safe; register links before planning. */
+  void addLink(const moveit::core::LinkModel* link);
+
+  /** \brief True if no links are registered, i.e. there is nothing to record */
+  bool empty() const
+  {
+    return links_.empty();
+  }
+
+  /** \brief Invalidate the entries of all threads */
+  void clear();
+
+  /** \brief Record the positions of the registered links in \e robot_state, whose link transforms must be up to date,
+   * for the \e count joint group \e values */
+  void insert(const double* values, std::size_t count, const moveit::core::RobotState& robot_state) const;
+
+  /** \brief Look up the position of \e link that the calling thread recorded for the joint group \e values */
+  bool lookup(const double* values, std::size_t count, const moveit::core::LinkModel* link,
+              Eigen::Vector3d& position) const;
+
+private:
+  struct Entry
+  {
+    std::size_t hash = 0;
+    std::uint64_t generation = 0;
+    std::vector<double> values;
+    std::vector<Eigen::Vector3d> positions;
+  };
+
+  struct ThreadEntries
+  {
+    std::vector<Entry> entries;
+    std::size_t next_entry = 0;
+  };
+
+  ThreadEntries* getThreadEntries() const;
+  ThreadEntries* getThreadEntriesLocked() const;
+
+  /// Unique id of this cache; unlike its address, it is never reused, so thread_local cache entries can't go stale
+  const std::uint64_t id_;
+  const std::size_t capacity_;
+  std::vector<const moveit::core::LinkModel*> links_;
+  /// Entries recorded before the last clear() have an older generation and are ignored
+  std::atomic<std::uint64_t> generation_;
+  mutable std::map<std::thread::id, std::unique_ptr<ThreadEntries>> thread_entries_;
+  mutable std::mutex lock_;
+};
+}  // namespace ompl_interface
@@ -211,6 +211,15 @@ public:
   }
 
 protected:
+  /** \brief Get the calling thread's robot state, with the positions of the group set to joint_values.
+   *
+   * The state doubles as a single-entry memo keyed on the joint values: if it already holds joint_values, it is
+   * returned untouched, so its link transforms and cached Jacobian are reused. OMPL's projection evaluates `function`
+   * and `jacobian` on the same joint values in every Newton iteration, which now runs forward kinematics once instead
+   * of three times.
+   * */
+  moveit::core::RobotState* getRobotState(const Eigen::Ref<const Eigen::VectorXd>& joint_values) const;
+
   /** \brief Thread-safe storage of the robot state.
    *
    * The robot state is modified for kinematic calculations. As an instance of this class is possibly used in multiple
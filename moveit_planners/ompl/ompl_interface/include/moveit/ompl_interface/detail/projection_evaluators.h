@@ -61,6 +61,8 @@ private:
   const ModelBasedPlanningContext* planning_context_;
   const moveit::core::LinkModel* link_;
   TSStateStorage tss_;
+  /// look up the link position computed by the state validity checker before running forward kinematics
+  bool use_fk_cache_;
 };
 
 /** @class ProjectionEvaluatorJointValue
@@ -41,6 +41,14 @@
  * - Kinematic path constraints.
  * - Generic user-specified feasibility using the `isStateFeasible` of the planning scene.
  *
+ * After the bounds check, the remaining checks run in the order given by the planner configuration parameter
+ * `validity_check_order` (a comma-separated list of `path_constraints`, `feasibility` and `collision`; unlisted
+ * checks run last in this default order), so that the stage rejecting most states in a given setup can be put first.
+ * With `validity_check_broadphase`, bounding spheres of the robot links are tested against bounding spheres of the
+ * world objects before the exact collision check, which then only checks self-collision if they don't overlap.
+ * With `validity_check_statistics`, the number of states rejected by each stage is counted and reported after
+ * planning.
+ *
  * IMPORTANT: Although the isValid method takes the state as `const ompl::base::State* state`,
  * it uses const_cast to modify the validity of the state with `markInvalid` and `markValid` for caching.
  * **/
@@ -51,6 +59,10 @@
 #include <moveit/collision_detection/collision_common.h>
 #include <ompl/base/StateValidityChecker.h>
 
+#include <array>
+#include <atomic>
+#include <vector>
+
 namespace ompl_interface
 {
 class ModelBasedPlanningContext;
@@ -86,7 +98,91 @@ public:
 
   void setVerbose(bool flag);
 
+  /** \brief The checks run after the bounds check, in configurable order */
+  enum class CheckStage
+  {
+    PATH_CONSTRAINTS,
+    FEASIBILITY,
+    COLLISION
+  };
+
+  /** \brief Number of checked states and of states rejected by each stage */
+  struct Statistics
+  {
+    std::size_t checked_states = 0;
+    std::size_t bounds_rejections = 0;
+    std::size_t path_constraints_rejections = 0;
+    std::size_t feasibility_rejections = 0;
+    std::size_t collision_rejections = 0;
+    /// collision checks reduced to self-collision because the broadphase found no overlap with the world
+    std::size_t broadphase_world_skips = 0;
+  };
+
+  const std::vector<CheckStage>& getCheckOrder() const
+  {
+    return check_order_;
+  }
+
+  /** \brief Set the order of the checks run after the bounds check; stages missing in \e order are not run */
+  void setCheckOrder(const std::vector<CheckStage>& order)
+  {
+    check_order_ = order;
+  }
+
+  /** \brief Enable the conservative bounding sphere test between robot links and world objects */
+  void setBroadphaseEnabled(bool flag);
+  bool isBroadphaseEnabled() const
+  {
+    return broadphase_enabled_;
+  }
+
+  /** \brief Enable counting the states rejected by each stage. Counting is disabled by default, as the shared
+   * counters are updated by all planning threads */
+  void setStatisticsEnabled(bool flag)
+  {
+    statistics_enabled_ = flag;
+  }
+  bool isStatisticsEnabled() const
+  {
+    return statistics_enabled_;
+  }
+
+  /** \brief Get the statistics counted since construction or the last call to resetStatistics() */
+  Statistics getStatistics() const;
+  void resetStatistics();
+
 protected:
+  enum Counter
+  {
+    CHECKED_STATES,
+    BOUNDS_REJECTIONS,
+    PATH_CONSTRAINTS_REJECTIONS,
+    FEASIBILITY_REJECTIONS,
+    COLLISION_REJECTIONS,
+    BROADPHASE_WORLD_SKIPS,
+    NUM_COUNTERS
+  };
+
+  struct BoundingSphere
+  {
+    Eigen::Vector3d center;
+    double radius;
+  };
+
+  void count(Counter counter) const
+  {
+    if (statistics_enabled_)
+    {
+      counters_[counter].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /** \brief True if no robot link can overlap with a world object in \e robot_state */
+  bool isClearOfWorld(const moveit::core::RobotState& robot_state) const;
+
+  /** \brief Record the link positions needed by projection evaluators for \e state, which \e robot_state holds */
+  void cacheLinkPositions(const ompl::base::State* state, const moveit::core::RobotState& robot_state) const;
+
   const ModelBasedPlanningContext* planning_context_;
   std::string group_name_;
   TSStateStorage tss_;
@@ -97,6 +193,16 @@ protected:
 
   collision_detection::CollisionRequest collision_request_with_cost_;
   bool verbose_;
+
+  std::vector<CheckStage> check_order_;
+
+  bool broadphase_enabled_;
+  /// bounding spheres of the links with collision geometry in link frame, and of the world objects
+  std::vector<std::pair<const moveit::core::LinkModel*, BoundingSphere>> link_spheres_;
+  std::vector<BoundingSphere> world_spheres_;
+
+  bool statistics_enabled_;
+  mutable std::array<std::atomic<std::size_t>, NUM_COUNTERS> counters_;
 };
 
 /** \brief A StateValidityChecker that can handle states of type `ompl::base::ConstraintStateSpace::StateType`.
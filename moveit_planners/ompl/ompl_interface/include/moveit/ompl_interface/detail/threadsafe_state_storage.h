@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/robot_state/robot_state.h>
+#include <cstdint>
 #include <thread>
 #include <mutex>
 
@@ -49,9 +50,17 @@ public:
   TSStateStorage(const moveit::core::RobotState& start_state);
   ~TSStateStorage();
 
+  /** \brief Get the state owned by the calling thread, created as a copy of the start state on first access.
+   *
+   * Threads remember the states of the storages they used last in a thread_local cache, so the lock is only taken
+   * when a thread accesses this storage for the first time (or after its cache entry was evicted). */
   moveit::core::RobotState* getStateStorage() const;
 
 private:
+  moveit::core::RobotState* getStateStorageLocked() const;
+
+  /// Unique id of this storage; unlike its address, it is never reused, so thread_local cache entries can't go stale
+  const std::uint64_t id_;
   moveit::core::RobotState start_state_;
   mutable std::map<std::thread::id, moveit::core::RobotState*> thread_states_;
   mutable std::mutex lock_;
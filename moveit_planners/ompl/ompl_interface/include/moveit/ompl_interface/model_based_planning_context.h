@@ -37,6 +37,8 @@
 #pragma once
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/ompl_interface/detail/experience_library.h>
+#include <moveit/ompl_interface/detail/fk_cache.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/planning_interface/planning_interface.h>
 
@@ -61,6 +63,9 @@ typedef std::function<ob::PlannerPtr(const ompl::base::SpaceInformationPtr& si,
     ConfiguredPlannerAllocator;
 typedef std::function<ConfiguredPlannerAllocator(const std::string& planner_type)> ConfiguredPlannerSelector;
 
+/** \brief Callback receiving the first solution of an anytime planning request and every later improvement of it */
+typedef std::function<void(const robot_trajectory::RobotTrajectory& trajectory)> SolutionCallback;
+
 struct ModelBasedPlanningContextSpecification
 {
   std::map<std::string, std::string> config_;
@@ -269,6 +274,12 @@ public:
     return constraints_library_;
   }
 
+  /** \brief Link positions computed by the state validity checker, for reuse by projection evaluators */
+  const FKCachePtr& getFKCache() const
+  {
+    return fk_cache_;
+  }
+
   bool simplifySolutions() const
   {
     return simplify_solutions_;
@@ -279,6 +290,18 @@ public:
     simplify_solutions_ = flag;
   }
 
+  /* \brief Get the number of threads simplifySolution() runs independent simplifications of the solution in */
+  unsigned int getSimplificationThreads() const
+  {
+    return simplification_threads_;
+  }
+
+  /* \brief Set the number of threads simplifySolution() runs independent simplifications of the solution in */
+  void setSimplificationThreads(unsigned int simplification_threads)
+  {
+    simplification_threads_ = simplification_threads;
+  }
+
   void setInterpolation(bool flag)
   {
     interpolate_ = flag;
@@ -289,6 +312,37 @@ public:
     hybridize_ = flag;
   }
 
+  /** \brief Enable anytime planning: solve(MotionPlanResponse&) stops the planner at the first exact solution and
+   * spends the remaining planning time on shortcutting it in getMaximumPlanningThreads() threads. The first solution
+   * and every improvement are passed to the solution callback */
+  void setAnytime(bool flag)
+  {
+    anytime_ = flag;
+  }
+
+  void setSolutionCallback(const SolutionCallback& callback)
+  {
+    solution_callback_ = callback;
+  }
+
+  /** \brief Set the library of planned paths that experience-based planning recalls and adds to */
+  void setExperienceLibrary(const ExperienceLibraryPtr& experience_library)
+  {
+    experience_library_ = experience_library;
+  }
+
+  const ExperienceLibraryPtr& getExperienceLibrary() const
+  {
+    return experience_library_;
+  }
+
+  /** \brief Enable experience-based planning: solve() first tries to repair a similar path of the experience
+   * library for the request and only runs the planner if that fails. Planned solutions are added to the library */
+  void setUseExperience(bool flag)
+  {
+    use_experience_ = flag;
+  }
+
   /* @brief Solve the planning problem. Return true if the problem is solved
      @param timeout The time to spend on solving
      @param count The number of runs to combine the paths of, in an attempt to generate better quality paths
@@ -315,13 +369,19 @@ public:
     return last_simplify_time_;
   }
 
-  /* @brief Apply smoothing and try to simplify the plan
+  /* @brief Apply smoothing and try to simplify the plan. With more than one simplification thread, every thread
+     simplifies its own copy of the plan and the best result is kept
      @param timeout The amount of time allowed to be spent on simplifying the plan*/
   void simplifySolution(double timeout);
 
   /* @brief Interpolate the solution*/
   void interpolateSolution();
 
+  /* @brief Shortcut the solution in parallel threads until no shortcut is found anymore or the timeout is reached,
+     passing every improvement to the solution callback
+     @param timeout The amount of time allowed to be spent on refining the plan*/
+  void refineSolution(double timeout);
+
   /* @brief Get the solution as a RobotTrajectory object*/
   bool getSolutionPath(robot_trajectory::RobotTrajectory& traj) const;
 
@@ -344,10 +404,43 @@ public:
    * */
   virtual void configure(const rclcpp::Node::SharedPtr& node, bool use_constraints_approximations);
 
+  /** \brief Check whether configure() was last run with the current specification config and solution segment length.
+   *
+   * In that case, a subsequent configure() only updates the start state, state validity checker and goal. The
+   * constraint approximations, state space signature, planner parameters and the allocated planner (including its
+   * data structures) of the previous request are kept, so cached contexts can be reused without the full setup.
+   * */
+  bool isConfigured(bool use_constraints_approximations) const;
+
+  /** \brief Force the next call to configure() to run the full setup again */
+  void resetConfiguration()
+  {
+    configured_ = false;
+  }
+
 protected:
   void preSolve();
   void postSolve();
 
+  /* @brief Solve with an anytime planner: return the first solution through the solution callback and refine it with
+     the remaining planning time */
+  bool solveAnytime(planning_interface::MotionPlanResponse& res);
+
+  /* @brief Simplify copies of the solution in simplification_threads_ threads and keep the best one */
+  void simplifySolutionInParallel(const ob::PlannerTerminationCondition& ptc);
+
+  /* @brief Interpolate a path as configured for the solution */
+  void interpolatePath(og::PathGeometric& pg) const;
+
+  /* @brief Pass a path to the solution callback, if there is one */
+  void publishSolution(const og::PathGeometric& pg) const;
+
+  /* @brief Make the repaired path of a similar experience the solution. Return false if there is none */
+  bool recallExperience();
+
+  /* @brief Add the current solution path to the experience library, unless it was recalled from there */
+  void storeExperience() const;
+
   void startSampling();
   void stopSampling();
 
@@ -445,12 +538,42 @@ protected:
 
   ConstraintsLibraryPtr constraints_library_;
 
+  FKCachePtr fk_cache_;
+
   bool simplify_solutions_;
 
+  // number of threads simplifying copies of the solution, the best result is kept
+  unsigned int simplification_threads_;
+
   // if false the final solution is not interpolated
   bool interpolate_;
 
   // if false parallel plan returns the first solution found
   bool hybridize_;
+
+  // if true the planner stops at the first solution, which is then refined with the remaining planning time
+  bool anytime_;
+
+  // if true motions are validated with continuous collision checks instead of at discrete states
+  bool continuous_motion_validation_;
+
+  SolutionCallback solution_callback_;
+
+  ExperienceLibraryPtr experience_library_;
+
+  // if true solve() tries the experience library before planning
+  bool use_experience_;
+
+  // experiences starting farther than this from the start state are not recalled
+  double experience_max_start_distance_;
+
+  // true if the current solution was recalled from the experience library
+  bool solved_from_experience_;
+
+  // true if configure() completed; the remaining configured_* members hold the settings it was run with
+  bool configured_;
+  std::map<std::string, std::string> configured_config_;
+  double configured_max_solution_segment_length_;
+  bool configured_use_constraints_approximations_;
 };
 }  // namespace ompl_interface
@@ -116,6 +116,18 @@ public:
     return use_constraints_approximations_;
   }
 
+  /** @brief Set the callback the planning contexts pass the solutions of anytime planning requests to */
+  void setSolutionCallback(const SolutionCallback& callback)
+  {
+    solution_callback_ = callback;
+  }
+
+  /** @brief Get the library of planned paths shared by the planning contexts of groups using experience */
+  const ExperienceLibraryPtr& getExperienceLibrary() const
+  {
+    return experience_library_;
+  }
+
   /** @brief Print the status of this node*/
   void printStatus();
 
@@ -149,6 +161,10 @@ protected:
 
   bool use_constraints_approximations_;
 
+  SolutionCallback solution_callback_;
+
+  ExperienceLibraryPtr experience_library_;
+
 private:
   constraint_sampler_manager_loader::ConstraintSamplerManagerLoaderPtr constraint_sampler_manager_loader_;
 };
@@ -51,5 +51,20 @@ public:
   {
     return PARAMETERIZATION_TYPE;
   }
+
+  double distance(const ompl::base::State* state1, const ompl::base::State* state2) const override;
+
+  /** \brief True if the group consists only of single-variable revolute and prismatic joints, in which case
+      distance() evaluates a flat weighted sum over the state values instead of dispatching per joint model */
+  bool hasFlatDistance() const
+  {
+    return !distance_indices_.empty();
+  }
+
+private:
+  // variable index, distance factor and wrap-around flag of each active joint, in group order
+  std::vector<unsigned int> distance_indices_;
+  std::vector<double> distance_factors_;
+  std::vector<char> distance_continuous_;
 };
 }  // namespace ompl_interface
@@ -41,6 +41,7 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <moveit/constraint_samplers/constraint_sampler.h>
+#include <memory>
 
 namespace ompl_interface
 {
@@ -257,6 +258,29 @@ public:
   double getTagSnapToSegment() const;
   void setTagSnapToSegment(double snap);
 
+  /**
+   * \brief Release the memory of pooled states that are no longer in use, e.g. between planning queries.
+   *
+   * States are allocated from slabs with contiguous value storage. After trimming, the pool allocates a slab
+   * large enough for the peak number of states in use so far the next time it grows.
+   */
+  void trimStatePool();
+
+  /// Get the number of states that can be allocated without allocating more memory
+  std::size_t getStatePoolCapacity() const;
+
+  /// Whether the default state sampler draws its uniform samples from a low-discrepancy (Halton) sequence
+  bool getQuasiRandomSampling() const
+  {
+    return quasi_random_sampling_;
+  }
+
+  /// Make state samplers allocated afterwards fill the single-variable joints from a scrambled Halton sequence
+  void setQuasiRandomSampling(bool enable)
+  {
+    quasi_random_sampling_ = enable;
+  }
+
 protected:
   ModelBasedStateSpaceSpecification spec_;
   std::vector<moveit::core::JointModel::Bounds> joint_bounds_storage_;
@@ -269,5 +293,10 @@ protected:
 
   double tag_snap_to_segment_;
   double tag_snap_to_segment_complement_;
+
+  bool quasi_random_sampling_ = false;
+
+  class StatePool;
+  std::unique_ptr<StatePool> state_pool_;
 };
 }  // namespace ompl_interface
@@ -39,10 +39,13 @@
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/parameterization/model_based_state_space_factory.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
+#include <moveit/planning_scene/planning_scene.h>
 #include <moveit/macros/class_forward.h>
 
 #include <ompl/base/PlannerDataStorage.h>
 
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <map>
 
@@ -58,7 +61,27 @@ public:
   ob::PlannerPtr allocatePlanner(const ob::SpaceInformationPtr& si, const std::string& new_name,
                                  const ModelBasedPlanningContextSpecification& spec);
 
+  /** \brief Set the planning scene that the roadmap of the multi-query planner \e name is validated against.
+   *
+   * When the planner is allocated again (or its planner data is loaded from disk), vertices and edges that collide
+   * with world objects added or moved since the roadmap was last validated are removed. Other objects are not
+   * rechecked. Returns true if such objects exist for an already allocated planner, i.e. the planner needs to be
+   * reallocated before it is used with \e scene. */
+  bool updatePlanningScene(const std::string& name, const planning_scene::PlanningSceneConstPtr& scene);
+
 private:
+  /// Hash of the shapes and poses of each world object, indexed by object id
+  using WorldFingerprint = std::map<std::string, std::uint64_t>;
+
+  static WorldFingerprint computeWorldFingerprint(const collision_detection::World& world);
+  static bool loadWorldFingerprint(const std::string& file_path, WorldFingerprint& fingerprint);
+  static bool storeWorldFingerprint(const std::string& file_path, const WorldFingerprint& fingerprint);
+
+  /** \brief Remove the vertices and edges in \e data that collide with objects of the scene stored for \e name that
+   * differ from \e validated_world, and mark the roadmap as validated against that scene */
+  void revalidatePlannerData(ob::PlannerData& data, const std::string& name, const WorldFingerprint& validated_world,
+                             const ModelBasedPlanningContextSpecification& spec);
+
   template <typename T>
   ob::PlannerPtr allocatePlannerImpl(const ob::SpaceInformationPtr& si, const std::string& new_name,
                                      const ModelBasedPlanningContextSpecification& spec, bool load_planner_data = false,
@@ -74,6 +97,11 @@ private:
 
   // Store and load planner data
   ob::PlannerDataStorage storage_;
+
+  // Scenes the multi-query planners are used with, and the world their roadmaps were last validated against
+  std::map<std::string, planning_scene::PlanningSceneConstPtr> planning_scenes_;
+  std::map<std::string, WorldFingerprint> validated_worlds_;
+  std::mutex scenes_lock_;
 };
 
 class PlanningContextManager
@@ -177,6 +205,9 @@ public:
    * This last step involves setting the start, goal, and state validity checker using the method
    * ModelBasedPlanningContext::configure.
    *
+   * Cached contexts that are reused with unchanged settings are warm-started: configure() keeps their planner
+   * (and, for multi-query planners, its roadmap) and only updates the start state, validity checker and goal.
+   *
    * */
   ModelBasedPlanningContextPtr getPlanningContext(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                                   const planning_interface::MotionPlanRequest& req,
@@ -261,7 +292,7 @@ protected:
   unsigned int minimum_waypoint_count_;
 
   /// Multi-query planner allocator
-  MultiQueryPlannerAllocator planner_allocator_;
+  mutable MultiQueryPlannerAllocator planner_allocator_;
 
 private:
   MOVEIT_STRUCT_FORWARD(CachedContexts);
@@ -99,6 +99,12 @@ struct GenerateStateDatabaseParameters
     node->get_parameter_or("state_space_parameterization", construction_opts.state_space_parameterization,
                            std::string("JointModel"));
 
+    // threads used for sampling and connecting states (0 uses all hardware threads)
+    get_uint_parameter_or(node, "num_threads", construction_opts.num_threads, 0);
+
+    // extend an approximation already saved in output_folder instead of replacing it
+    node->get_parameter_or("append", construction_opts.append, false);
+
     node->get_parameter_or("output_folder", output_folder, std::string("constraint_approximation_database"));
 
     if (!node->get_parameter("planning_group", planning_group))
@@ -154,6 +160,9 @@ void computeDB(const rclcpp::Node::SharedPtr& node, const planning_scene::Planni
   RCLCPP_INFO_STREAM(LOGGER, "Generating Joint Space Constraint Approximation Database for constraint:\n"
                                  << params.constraints.name);
 
+  if (params.construction_opts.append)
+    context->getConstraintsLibraryNonConst()->loadConstraintApproximations(params.output_folder);
+
   ompl_interface::ConstraintApproximationConstructionResults result =
       context->getConstraintsLibraryNonConst()->addConstraintApproximation(params.constraints, params.planning_group,
                                                                            scene, params.construction_opts);
@@ -45,9 +45,10 @@ namespace ompl_interface
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.constrained_goal_sampler");
 }  // namespace ompl_interface
 
-ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(const ModelBasedPlanningContext* pc,
-                                                               kinematic_constraints::KinematicConstraintSetPtr ks,
-                                                               constraint_samplers::ConstraintSamplerPtr cs)
+ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(
+    const ModelBasedPlanningContext* pc, kinematic_constraints::KinematicConstraintSetPtr ks,
+    constraint_samplers::ConstraintSamplerPtr cs,
+    const std::vector<constraint_samplers::ConstraintSamplerPtr>& additional_cs)
   : ob::GoalLazySamples(
         pc->getOMPLSimpleSetup()->getSpaceInformation(),
         [this](const GoalLazySamples* gls, ompl::base::State* state) {
@@ -61,13 +62,32 @@ ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(const ModelBasedP
   , invalid_sampled_constraints_(0)
   , warned_invalid_samples_(false)
   , verbose_display_(0)
+  , producers_started_(false)
+  , stop_producers_(false)
+  , producers_interrupted_(false)
+  , active_producers_(0)
+  , producer_attempts_(0)
 {
   if (!constraint_sampler_)
     default_sampler_ = si_->allocStateSampler();
-  RCLCPP_DEBUG(LOGGER, "Constructed a ConstrainedGoalSampler instance at address %p", this);
+  producers_.reserve(additional_cs.size());
+  for (const constraint_samplers::ConstraintSamplerPtr& producer_cs : additional_cs)
+  {
+    if (producer_cs)
+      producers_.push_back(GoalProducer{ producer_cs, nullptr, pc->getCompleteInitialRobotState(), std::thread() });
+  }
+  RCLCPP_DEBUG(LOGGER, "Constructed a ConstrainedGoalSampler instance at address %p with %zu additional producers",
+               this, producers_.size());
   startSampling();
 }
 
+ompl_interface::ConstrainedGoalSampler::~ConstrainedGoalSampler()
+{
+  // the sampling thread starts the producers, so it has to be stopped first
+  stopSampling();
+  stopProducers();
+}
+
 bool ompl_interface::ConstrainedGoalSampler::checkStateValidity(ob::State* new_goal,
                                                                 const moveit::core::RobotState& state,
                                                                 bool verbose) const
@@ -88,6 +108,112 @@ bool ompl_interface::ConstrainedGoalSampler::stateValidityCallback(ob::State* ne
   return checkStateValidity(new_goal, solution_state, verbose);
 }
 
+bool ompl_interface::ConstrainedGoalSampler::samplingFinished(const ob::GoalLazySamples* gls) const
+{
+  // terminate after a maximum number of samples
+  if (gls->getStateCount() >= planning_context_->getMaximumGoalSamples())
+    return true;
+
+  // terminate the sampling thread when a solution has been found
+  return planning_context_->getOMPLSimpleSetup()->getProblemDefinition()->hasSolution();
+}
+
+bool ompl_interface::ConstrainedGoalSampler::sampleGoal(
+    const constraint_samplers::ConstraintSamplerPtr& constraint_sampler, const ob::StateSamplerPtr& default_sampler,
+    moveit::core::RobotState& work_state, ob::State* new_goal, unsigned int attempts_so_far, bool verbose)
+{
+  if (constraint_sampler)
+  {
+    // makes the constraint sampler also perform a validity callback
+    moveit::core::GroupStateValidityCallbackFn gsvcf = [this, new_goal,
+                                                        verbose](moveit::core::RobotState* robot_state,
+                                                                 const moveit::core::JointModelGroup* joint_group,
+                                                                 const double* joint_group_variable_values) {
+      return stateValidityCallback(new_goal, robot_state, joint_group, joint_group_variable_values, verbose);
+    };
+    constraint_sampler->setGroupStateValidityCallback(gsvcf);
+
+    if (constraint_sampler->sample(work_state, planning_context_->getMaximumStateSamplingAttempts()))
+    {
+      work_state.update();
+      if (kinematic_constraint_set_->decide(work_state, verbose).satisfied)
+      {
+        if (checkStateValidity(new_goal, work_state, verbose))
+          return true;
+      }
+      else
+      {
+        invalid_sampled_constraints_++;
+        if (invalid_sampled_constraints_ >= (attempts_so_far * 8) / 10 && !warned_invalid_samples_.exchange(true))
+        {
+          RCLCPP_WARN(LOGGER, "More than 80%% of the sampled goal states "
+                              "fail to satisfy the constraints imposed on the goal sampler. "
+                              "Is the constrained sampler working correctly?");
+        }
+      }
+    }
+  }
+  else
+  {
+    default_sampler->sampleUniform(new_goal);
+    if (static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(new_goal, verbose))
+    {
+      planning_context_->getOMPLStateSpace()->copyToRobotState(work_state, new_goal);
+      if (kinematic_constraint_set_->decide(work_state, verbose).satisfied)
+        return true;
+    }
+  }
+  return false;
+}
+
+void ompl_interface::ConstrainedGoalSampler::produceGoals(GoalProducer& producer)
+{
+  const unsigned int max_attempts = planning_context_->getMaximumGoalSamplingAttempts();
+  ob::State* new_goal = si_->allocState();
+  while (!stop_producers_)
+  {
+    if (!isSampling())
+    {
+      producers_interrupted_ = true;
+      break;
+    }
+    // the additional producers share one budget of attempts
+    unsigned int attempts_so_far = producer_attempts_++;
+    if (attempts_so_far >= max_attempts || samplingFinished(this))
+      break;
+    // same acceptance test as the GoalLazySamples sampling thread applies to the states returned to it
+    if (sampleGoal(producer.constraint_sampler, producer.default_sampler, producer.work_state, new_goal,
+                   attempts_so_far, false) &&
+        si_->satisfiesBounds(new_goal) && si_->isValid(new_goal))
+      addStateIfDifferent(new_goal, minDist_);
+  }
+  si_->freeState(new_goal);
+  --active_producers_;
+}
+
+void ompl_interface::ConstrainedGoalSampler::startProducers()
+{
+  stopProducers();
+  producer_attempts_ = 0;
+  producers_interrupted_ = false;
+  active_producers_ = producers_.size();
+  for (GoalProducer& producer : producers_)
+    producer.thread = std::thread([this, &producer] { produceGoals(producer); });
+  producers_started_ = true;
+}
+
+void ompl_interface::ConstrainedGoalSampler::stopProducers()
+{
+  stop_producers_ = true;
+  for (GoalProducer& producer : producers_)
+  {
+    if (producer.thread.joinable())
+      producer.thread.join();
+  }
+  stop_producers_ = false;
+  producers_started_ = false;
+}
+
 bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const ob::GoalLazySamples* gls,
                                                                           ob::State* new_goal)
 {
@@ -95,16 +221,16 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
   unsigned int attempts_so_far = gls->samplingAttemptsCount();
 
   // terminate after too many attempts
-  if (attempts_so_far >= max_attempts)
-    return false;
-
-  // terminate after a maximum number of samples
-  if (gls->getStateCount() >= planning_context_->getMaximumGoalSamples())
+  if (attempts_so_far >= max_attempts || samplingFinished(gls))
+  {
+    stopProducers();
     return false;
+  }
 
-  // terminate the sampling thread when a solution has been found
-  if (planning_context_->getOMPLSimpleSetup()->getProblemDefinition()->hasSolution())
-    return false;
+  // (re)start the additional producers along with the sampling thread; producers that left because sampling was
+  // stopped are restarted when it resumes
+  if (!producers_.empty() && (!producers_started_ || (active_producers_ == 0 && producers_interrupted_)))
+    startProducers();
 
   unsigned int max_attempts_div2 = max_attempts / 2;
   for (unsigned int a = gls->samplingAttemptsCount(); a < max_attempts && gls->isSampling(); ++a)
@@ -119,48 +245,9 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       }
     }
 
-    if (constraint_sampler_)
-    {
-      // makes the constraint sampler also perform a validity callback
-      moveit::core::GroupStateValidityCallbackFn gsvcf = [this, new_goal,
-                                                          verbose](moveit::core::RobotState* robot_state,
-                                                                   const moveit::core::JointModelGroup* joint_group,
-                                                                   const double* joint_group_variable_values) {
-        return stateValidityCallback(new_goal, robot_state, joint_group, joint_group_variable_values, verbose);
-      };
-      constraint_sampler_->setGroupStateValidityCallback(gsvcf);
-
-      if (constraint_sampler_->sample(work_state_, planning_context_->getMaximumStateSamplingAttempts()))
-      {
-        work_state_.update();
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
-        {
-          if (checkStateValidity(new_goal, work_state_, verbose))
-            return true;
-        }
-        else
-        {
-          invalid_sampled_constraints_++;
-          if (!warned_invalid_samples_ && invalid_sampled_constraints_ >= (attempts_so_far * 8) / 10)
-          {
-            warned_invalid_samples_ = true;
-            RCLCPP_WARN(LOGGER, "More than 80%% of the sampled goal states "
-                                "fail to satisfy the constraints imposed on the goal sampler. "
-                                "Is the constrained sampler working correctly?");
-          }
-        }
-      }
-    }
-    else
-    {
-      default_sampler_->sampleUniform(new_goal);
-      if (static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(new_goal, verbose))
-      {
-        planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, new_goal);
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
-          return true;
-      }
-    }
+    if (sampleGoal(constraint_sampler_, default_sampler_, work_state_, new_goal, attempts_so_far, verbose))
+      return true;
   }
+  stopProducers();
   return false;
 }
@@ -41,6 +41,10 @@
 #include <moveit/ompl_interface/detail/constraints_library.h>
 
 #include <ompl/tools/config/SelfConfig.h>
+#include <atomic>
+#include <mutex>
+#include <system_error>
+#include <thread>
 #include <utility>
 
 namespace ompl_interface
@@ -99,6 +103,19 @@ void hexToMsg(const std::string& hex, T& msg)
     return;
   }
 }
+
+// Read the states stored in the database at path
+bool loadStateStorageFile(const std::string& path, ompl::base::StateStorage& storage)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in.good())
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open constraint approximation database '%s'", path.c_str());
+    return false;
+  }
+  storage.load(in);
+  return true;
+}
 }  // namespace
 
 class ConstraintApproximationStateSampler : public ob::StateSampler
@@ -215,7 +232,10 @@ bool interpolateUsingStoredStates(const ConstraintApproximationStateStorage* sta
 
 ompl_interface::InterpolationFunction ompl_interface::ConstraintApproximation::getInterpolationFunction() const
 {
-  if (explicit_motions_ && milestones_ > 0 && milestones_ < state_storage_->size())
+  if (!explicit_motions_ || milestones_ == 0)
+    return InterpolationFunction();
+  loadStateStorage();
+  if (milestones_ < state_storage_->size())
   {
     return
         [this](const ompl::base::State* from, const ompl::base::State* to, const double t, ompl::base::State* state) {
@@ -252,18 +272,73 @@ ompl_interface::ConstraintApproximation::ConstraintApproximation(
   , explicit_motions_(explicit_motions)
   , constraint_msg_(std::move(msg))
   , ompldb_filename_(std::move(filename))
+  , loaded_(true)
   , state_storage_ptr_(std::move(storage))
   , milestones_(milestones)
 {
+  std::call_once(load_once_, [] {});
   state_storage_ = static_cast<ConstraintApproximationStateStorage*>(state_storage_ptr_.get());
-  state_storage_->getStateSpace()->computeSignature(space_signature_);
+  state_space_ = state_storage_->getStateSpace();
+  state_space_->computeSignature(space_signature_);
+  if (milestones_ == 0)
+    milestones_ = state_storage_->size();
+}
+
+ompl_interface::ConstraintApproximation::ConstraintApproximation(
+    std::string group, std::string state_space_parameterization, bool explicit_motions,
+    moveit_msgs::msg::Constraints msg, std::string filename, std::string path, ompl::base::StateSpacePtr state_space,
+    std::size_t milestones)
+  : group_(std::move(group))
+  , state_space_parameterization_(std::move(state_space_parameterization))
+  , explicit_motions_(explicit_motions)
+  , constraint_msg_(std::move(msg))
+  , ompldb_filename_(std::move(filename))
+  , ompldb_path_(std::move(path))
+  , state_space_(std::move(state_space))
+  , loaded_(false)
+  , state_storage_(nullptr)
+  , milestones_(milestones)
+{
+  state_space_->computeSignature(space_signature_);
+  // without a milestone count in the manifest, the states have to be counted right away
   if (milestones_ == 0)
+  {
+    loadStateStorage();
     milestones_ = state_storage_->size();
+  }
+}
+
+void ompl_interface::ConstraintApproximation::loadStateStorage() const
+{
+  std::call_once(load_once_, [this] {
+    auto* cass = new ConstraintApproximationStateStorage(state_space_);
+    state_storage_ptr_.reset(cass);
+    state_storage_ = cass;
+
+    rclcpp::Clock clock;
+    const auto start = clock.now();
+    if (loadStateStorageFile(ompldb_path_, *cass))
+    {
+      std::size_t sum = 0;
+      for (std::size_t i = 0; i < cass->size(); ++i)
+        sum += cass->getMetadata(i).first.size();
+      const std::size_t milestones = milestones_ > 0 ? milestones_ : cass->size();
+      RCLCPP_INFO(LOGGER,
+                  "Loaded %lu states (%lu milestones) and %lu connections (%0.1lf per state) "
+                  "for constraint named '%s'%s in %lf seconds",
+                  cass->size(), milestones, sum,
+                  milestones > 0 ? static_cast<double>(sum) / static_cast<double>(milestones) : 0.0,
+                  constraint_msg_.name.c_str(), explicit_motions_ ? " with explicit motions" : "",
+                  (clock.now() - start).seconds());
+    }
+    loaded_ = true;
+  });
 }
 
 ompl::base::StateSamplerAllocator
 ompl_interface::ConstraintApproximation::getStateSamplerAllocator(const moveit_msgs::msg::Constraints& /*unused*/) const
 {
+  loadStateStorage();
   if (state_storage_->size() == 0)
     return ompl::base::StateSamplerAllocator();
   return [this](const ompl::base::StateSpace* ss) {
@@ -358,26 +433,18 @@ void ompl_interface::ConstraintsLibrary::loadConstraintApproximations(const std:
       continue;
     }
 
-    RCLCPP_INFO(LOGGER, "Loading constraint approximation of type '%s' for group '%s' from '%s'...",
-                state_space_parameterization.c_str(), group.c_str(), filename.c_str());
     moveit_msgs::msg::Constraints msg;
     hexToMsg(serialization, msg);
-    auto* cass = new ConstraintApproximationStateStorage(context_->getOMPLSimpleSetup()->getStateSpace());
-    cass->load((std::string{ path }.append("/").append(filename)).c_str());
-    auto cap = std::make_shared<ConstraintApproximation>(group, state_space_parameterization, explicit_motions, msg,
-                                                         filename, ompl::base::StateStoragePtr(cass), milestones);
+    RCLCPP_INFO(LOGGER,
+                "Registering constraint approximation named '%s' of type '%s' for group '%s' from '%s'. "
+                "Its states are loaded on first use.",
+                msg.name.c_str(), state_space_parameterization.c_str(), group.c_str(), filename.c_str());
+    auto cap = std::make_shared<ConstraintApproximation>(
+        group, state_space_parameterization, explicit_motions, msg, filename,
+        std::string{ path }.append("/").append(filename), context_->getOMPLSimpleSetup()->getStateSpace(), milestones);
     if (constraint_approximations_.find(cap->getName()) != constraint_approximations_.end())
       RCLCPP_WARN(LOGGER, "Overwriting constraint approximation named '%s'", cap->getName().c_str());
     constraint_approximations_[cap->getName()] = cap;
-    std::size_t sum = 0;
-    for (std::size_t i = 0; i < cass->size(); ++i)
-      sum += cass->getMetadata(i).first.size();
-    RCLCPP_INFO(LOGGER,
-                "Loaded %lu states (%lu milestones) and %lu connections (%0.1lf per state) "
-                "for constraint named '%s'%s",
-                cass->size(), cap->getMilestoneCount(), sum,
-                static_cast<double>(sum) / static_cast<double>(cap->getMilestoneCount()), msg.name.c_str(),
-                explicit_motions ? ". Explicit motions included." : "");
   }
   RCLCPP_INFO(LOGGER, "Done loading constrained space approximations.");
 }
@@ -408,8 +475,23 @@ void ompl_interface::ConstraintsLibrary::saveConstraintApproximations(const std:
       msgToHex(it->second->getConstraintsMsg(), serialization);
       fout << serialization << '\n';
       fout << it->second->getFilename() << '\n';
-      if (it->second->getStateStorage())
-        it->second->getStateStorage()->store((path + "/" + it->second->getFilename()).c_str());
+      const std::string ompldb_path = path + "/" + it->second->getFilename();
+      if (it->second->isLoaded())
+      {
+        if (it->second->getStateStorage())
+          it->second->getStateStorage()->store(ompldb_path.c_str());
+      }
+      else
+      {
+        // states that were never requested are copied over without loading them
+        std::error_code ec;
+        if (!std::filesystem::equivalent(it->second->getPath(), ompldb_path, ec))
+          std::filesystem::copy_file(it->second->getPath(), ompldb_path,
+                                     std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec)
+          RCLCPP_ERROR(LOGGER, "Unable to copy constraint approximation database '%s' to '%s': %s",
+                       it->second->getPath().c_str(), ompldb_path.c_str(), ec.message().c_str());
+      }
     }
   }
   else
@@ -479,19 +561,39 @@ ompl_interface::ConstraintsLibrary::addConstraintApproximation(const moveit_msgs
   context_->setPlanningScene(scene);
   context_->setCompleteInitialState(scene->getCurrentState());
 
+  ConstraintApproximationPtr existing;
+  if (options.append)
+  {
+    auto it = constraint_approximations_.find(constr_hard.name);
+    if (it != constraint_approximations_.end() && it->second->getStateStorage() && it->second->getGroup() == group &&
+        it->second->getStateSpaceParameterization() == options.state_space_parameterization &&
+        it->second->hasExplicitMotions() == options.explicit_motions)
+    {
+      existing = it->second;
+      RCLCPP_INFO(LOGGER, "Appending to constraint approximation named '%s' (%lu milestones)",
+                  existing->getName().c_str(), existing->getMilestoneCount());
+    }
+    else
+      RCLCPP_WARN(LOGGER, "No compatible constraint approximation named '%s' to append to. Constructing a new one.",
+                  constr_hard.name.c_str());
+  }
+
   rclcpp::Clock clock;
   auto start = clock.now();
   ompl::base::StateStoragePtr state_storage =
-      constructConstraintApproximation(context_, constr_sampling, constr_hard, options, res);
+      constructConstraintApproximation(context_, constr_sampling, constr_hard, options, res, existing);
   RCLCPP_INFO(LOGGER, "Spent %lf seconds constructing the database", (clock.now() - start).seconds());
   if (state_storage)
   {
+    // an extended database replaces the file it was loaded from when the library is saved again
     auto constraint_approx = std::make_shared<ConstraintApproximation>(
         group, options.state_space_parameterization, options.explicit_motions, constr_hard,
-        group + "_" + boost::posix_time::to_iso_extended_string(boost::posix_time::microsec_clock::universal_time()) +
-            ".ompldb",
+        existing ? existing->getFilename() :
+                   group + "_" +
+                       boost::posix_time::to_iso_extended_string(boost::posix_time::microsec_clock::universal_time()) +
+                       ".ompldb",
         state_storage, res.milestones);
-    if (constraint_approximations_.find(constraint_approx->getName()) != constraint_approximations_.end())
+    if (!existing && constraint_approximations_.find(constraint_approx->getName()) != constraint_approximations_.end())
       RCLCPP_WARN(LOGGER, "Overwriting constraint approximation named '%s'", constraint_approx->getName().c_str());
     constraint_approximations_[constraint_approx->getName()] = constraint_approx;
     res.approx = constraint_approx;
@@ -501,13 +603,174 @@ ompl_interface::ConstraintsLibrary::addConstraintApproximation(const moveit_msgs
   return res;
 }
 
+namespace ompl_interface
+{
+namespace
+{
+// Run \e worker with the indices [0, num_threads); the calling thread runs the worker with index 0
+template <typename Worker>
+void runWorkers(unsigned int num_threads, const Worker& worker)
+{
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (unsigned int t = 1; t < num_threads; ++t)
+    threads.emplace_back(worker, t);
+  worker(0);
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+unsigned int explicitPointCount(const ConstraintApproximationConstructionOptions& options, double distance)
+{
+  return std::min<unsigned int>(options.max_explicit_points, distance / options.explicit_points_resolution);
+}
+
+// Fill \e int_states with \e isteps states on the motion from \e from to \e to. If \e kset is given, stop as soon as
+// one of the interpolated states violates it and return false.
+bool interpolateMotion(const ModelBasedStateSpacePtr& space, const ob::State* from, const ob::State* to,
+                       unsigned int isteps, const std::vector<ob::State*>& int_states,
+                       moveit::core::RobotState& robot_state,
+                       const kinematic_constraints::KinematicConstraintSet* kset)
+{
+  if (isteps == 0)
+    return true;
+  double step = 1.0 / static_cast<double>(isteps);
+  space->interpolate(from, to, step, int_states[0]);
+  for (unsigned int k = 1; k < isteps; ++k)
+  {
+    double this_step = step / (1.0 - (k - 1) * step);
+    space->interpolate(int_states[k - 1], to, this_step, int_states[k]);
+    if (kset)
+    {
+      space->copyToRobotState(robot_state, int_states[k]);
+      if (!kset->decide(robot_state).satisfied)
+        return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+std::size_t connectConstraintApproximationMilestones(ModelBasedPlanningContext* pcontext,
+                                                     ConstraintApproximationStateStorage* cass, std::size_t milestones,
+                                                     std::size_t old_milestones,
+                                                     const kinematic_constraints::KinematicConstraintSet& kset,
+                                                     const ConstraintApproximationConstructionOptions& options)
+{
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+  const ob::SpaceInformationPtr& si = pcontext->getOMPLSimpleSetup()->getSpaceInformation();
+  const unsigned int num_threads =
+      options.num_threads > 0 ? options.num_threads : std::max(1u, std::thread::hardware_concurrency());
+
+  // Check whether the motion between milestones i > j is a connection candidate, it is shorter than the maximum edge
+  // length and satisfies the constraints
+  const auto is_candidate = [&](std::size_t j, std::size_t i, moveit::core::RobotState& robot_state,
+                                const std::vector<ob::State*>& int_states) {
+    const double d = space->distance(cass->getState(i), cass->getState(j));
+    return d < options.max_edge_length &&
+           interpolateMotion(space, cass->getState(i), cass->getState(j), explicitPointCount(options, d), int_states,
+                             robot_state, &kset);
+  };
+
+  // Verify the candidate connections of each milestone in parallel. Only connections to milestones with a larger
+  // index are considered, and only pairs with at least one new milestone when an approximation is extended. The
+  // connections each milestone has before are not modified here, so they can be read concurrently. They are a lower
+  // bound of its final degree, so candidates are collected until it would be full with them, the scan position is
+  // kept to continue from there if some candidates are rejected later.
+  std::vector<std::vector<std::size_t>> candidates(milestones);
+  std::vector<std::size_t> scanned(milestones, milestones);
+  std::atomic<std::size_t> next_milestone{ 0 };
+  std::atomic<std::size_t> verified{ 0 };
+  const moveit::core::RobotState& default_state = pcontext->getCompleteInitialRobotState();
+  auto find_candidates = [&](unsigned int thread_index) {
+    moveit::core::RobotState robot_state(default_state);
+    std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
+    si->allocStates(int_states);
+    int progress = -1;
+    for (std::size_t j = next_milestone++; j < milestones; j = next_milestone++)
+    {
+      if (thread_index == 0)
+      {
+        int progress_now = 100 * verified / milestones;
+        if (progress != progress_now)
+        {
+          progress = progress_now;
+          RCLCPP_INFO(LOGGER, "%d%% complete", progress);
+        }
+      }
+      const std::size_t degree = cass->getMetadata(j).first.size();
+      const std::size_t capacity = degree < options.edges_per_sample ? options.edges_per_sample - degree : 0;
+      std::size_t i = std::max(j + 1, old_milestones);
+      for (; i < milestones && candidates[j].size() < capacity; ++i)
+      {
+        if (cass->getMetadata(i).first.size() < options.edges_per_sample &&
+            is_candidate(j, i, robot_state, int_states))
+          candidates[j].push_back(i);
+      }
+      scanned[j] = i;
+      ++verified;
+    }
+    si->freeStates(int_states);
+  };
+  runWorkers(num_threads, find_candidates);
+
+  // Add the connections in the order of the sequential construction, which makes the result independent of the number
+  // of threads. Milestones whose candidates are used up before they are full continue scanning where they stopped.
+  moveit::core::RobotState robot_state(default_state);
+  std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
+  si->allocStates(int_states);
+  std::size_t good = 0;
+  const auto connect = [&](std::size_t j, std::size_t i) {
+    cass->getMetadata(i).first.push_back(j);
+    cass->getMetadata(j).first.push_back(i);
+
+    if (options.explicit_motions)
+    {
+      const ob::State* state_i = cass->getState(i);
+      const ob::State* state_j = cass->getState(j);
+      unsigned int isteps = explicitPointCount(options, space->distance(state_i, state_j));
+      interpolateMotion(space, state_i, state_j, isteps, int_states, robot_state, nullptr);
+      cass->getMetadata(i).second[j].first = cass->size();
+      for (unsigned int k = 0; k < isteps; ++k)
+      {
+        int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
+        cass->addState(int_states[k]);
+      }
+      cass->getMetadata(i).second[j].second = cass->size();
+      cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
+    }
+    ++good;
+  };
+  for (std::size_t j = 0; j < milestones; ++j)
+  {
+    for (std::size_t i : candidates[j])
+    {
+      if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
+        break;
+      if (cass->getMetadata(i).first.size() < options.edges_per_sample)
+        connect(j, i);
+    }
+    for (std::size_t i = scanned[j]; i < milestones && cass->getMetadata(j).first.size() < options.edges_per_sample;
+         ++i)
+    {
+      if (cass->getMetadata(i).first.size() < options.edges_per_sample && is_candidate(j, i, robot_state, int_states))
+        connect(j, i);
+    }
+  }
+  si->freeStates(int_states);
+  return good;
+}
+}  // namespace ompl_interface
+
 ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstraintApproximation(
     ModelBasedPlanningContext* pcontext, const moveit_msgs::msg::Constraints& constr_sampling,
     const moveit_msgs::msg::Constraints& constr_hard, const ConstraintApproximationConstructionOptions& options,
-    ConstraintApproximationConstructionResults& result)
+    ConstraintApproximationConstructionResults& result, const ConstraintApproximationPtr& existing)
 {
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+
   // state storage structure
-  ConstraintApproximationStateStorage* cass = new ConstraintApproximationStateStorage(pcontext->getOMPLStateSpace());
+  ConstraintApproximationStateStorage* cass = new ConstraintApproximationStateStorage(space);
   ob::StateStoragePtr state_storage(cass);
 
   // construct a sampler for the sampling constraints
@@ -517,16 +780,30 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
 
   const moveit::core::RobotState& default_state = pcontext->getCompleteInitialRobotState();
 
-  unsigned int attempts = 0;
+  const unsigned int num_threads =
+      options.num_threads > 0 ? options.num_threads : std::max(1u, std::thread::hardware_concurrency());
 
   double bounds_val = std::numeric_limits<double>::max() / 2.0 - 1.0;
-  pcontext->getOMPLStateSpace()->setPlanningVolume(-bounds_val, bounds_val, -bounds_val, bounds_val, -bounds_val,
-                                                   bounds_val);
-  pcontext->getOMPLStateSpace()->setup();
+  space->setPlanningVolume(-bounds_val, bounds_val, -bounds_val, bounds_val, -bounds_val, bounds_val);
+  space->setup();
 
-  // construct the constrained states
+  // the milestones of an extended approximation keep their indices, so their connections remain valid
+  std::size_t old_milestones = 0;
+  const ConstraintApproximationStateStorage* old_cass = nullptr;
+  if (existing)
+  {
+    old_cass = static_cast<const ConstraintApproximationStateStorage*>(existing->getStateStorage().get());
+    old_milestones = std::min(existing->getMilestoneCount(), old_cass->size());
+    for (std::size_t i = 0; i < old_milestones; ++i)
+    {
+      ConstrainedStateMetadata md;
+      md.first = old_cass->getMetadata(i).first;
+      cass->addState(old_cass->getState(i), md);
+    }
+  }
+  const std::size_t target_milestones = old_milestones + options.samples;
 
-  moveit::core::RobotState robot_state(default_state);
+  // construct the constrained states
   const constraint_samplers::ConstraintSamplerManagerPtr& csmng = pcontext->getConstraintSamplerManager();
   ConstrainedSampler* constrained_sampler = nullptr;
   if (csmng)
@@ -538,136 +815,100 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
   }
 
   ob::StateSamplerPtr ss(constrained_sampler ? ob::StateSamplerPtr(constrained_sampler) :
-                                               pcontext->getOMPLStateSpace()->allocDefaultStateSampler());
-
-  ompl::base::ScopedState<> temp(pcontext->getOMPLStateSpace());
+                                               space->allocDefaultStateSampler());
+
+  // constraint samplers share the IK solver of the group and cannot be used concurrently
+  const unsigned int sampling_threads = constrained_sampler ? 1 : num_threads;
+  std::mutex storage_lock;
+  std::atomic<std::size_t> new_states{ 0 };
+  std::atomic<unsigned int> attempts{ 0 };
+  std::atomic<bool> slow_warn{ false };
+  std::atomic<bool> failed{ false };
   int done = -1;
-  bool slow_warn = false;
-  ompl::time::point start = ompl::time::now();
-  while (state_storage->size() < options.samples)
-  {
-    ++attempts;
-    int done_now = 100 * state_storage->size() / options.samples;
-    if (done != done_now)
-    {
-      done = done_now;
-      RCLCPP_INFO(LOGGER, "%d%% complete (kept %0.1lf%% sampled states)", done,
-                  100.0 * static_cast<double>(state_storage->size()) / static_cast<double>(attempts));
-    }
-
-    if (!slow_warn && attempts > 10 && attempts > state_storage->size() * 100)
+  auto sample_states = [&](unsigned int thread_index) {
+    ob::StateSamplerPtr sampler = thread_index == 0 ? ss : space->allocDefaultStateSampler();
+    moveit::core::RobotState robot_state(default_state);
+    ompl::base::ScopedState<> temp(space);
+    while (new_states < options.samples && !failed)
     {
-      slow_warn = true;
-      RCLCPP_WARN(LOGGER, "Computation of valid state database is very slow...");
-    }
+      unsigned int attempt = ++attempts;
+      if (attempt > 10 && attempt > new_states * 100 && !slow_warn.exchange(true))
+        RCLCPP_WARN(LOGGER, "Computation of valid state database is very slow...");
 
-    if (attempts > options.samples && state_storage->size() == 0)
-    {
-      RCLCPP_ERROR(LOGGER, "Unable to generate any samples");
-      break;
-    }
+      if (attempt > options.samples && new_states == 0)
+      {
+        if (!failed.exchange(true))
+          RCLCPP_ERROR(LOGGER, "Unable to generate any samples");
+        break;
+      }
 
-    ss->sampleUniform(temp.get());
-    pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, temp.get());
-    if (kset.decide(robot_state).satisfied)
-    {
-      if (state_storage->size() < options.samples)
+      sampler->sampleUniform(temp.get());
+      space->copyToRobotState(robot_state, temp.get());
+      if (kset.decide(robot_state).satisfied)
       {
-        temp->as<ModelBasedStateSpace::StateType>()->tag = state_storage->size();
-        state_storage->addState(temp.get());
+        std::scoped_lock slock(storage_lock);
+        if (new_states < options.samples)
+        {
+          temp->as<ModelBasedStateSpace::StateType>()->tag = state_storage->size();
+          state_storage->addState(temp.get());
+          int done_now = 100 * ++new_states / options.samples;
+          if (done != done_now)
+          {
+            done = done_now;
+            RCLCPP_INFO(LOGGER, "%d%% complete (kept %0.1lf%% sampled states)", done,
+                        100.0 * static_cast<double>(new_states) / static_cast<double>(attempts));
+          }
+        }
       }
     }
-  }
+  };
+
+  ompl::time::point start = ompl::time::now();
+  runWorkers(sampling_threads, sample_states);
 
   result.state_sampling_time = ompl::time::seconds(ompl::time::now() - start);
-  RCLCPP_INFO(LOGGER, "Generated %u states in %lf seconds", static_cast<unsigned int>(state_storage->size()),
-              result.state_sampling_time);
+  RCLCPP_INFO(LOGGER, "Generated %u states in %lf seconds using %u thread(s)",
+              static_cast<unsigned int>(new_states.load()), result.state_sampling_time, sampling_threads);
   if (constrained_sampler)
   {
     result.sampling_success_rate = constrained_sampler->getConstrainedSamplingRate();
     RCLCPP_INFO(LOGGER, "Constrained sampling rate: %lf", result.sampling_success_rate);
   }
 
-  result.milestones = state_storage->size();
-  if (options.edges_per_sample > 0)
-  {
-    RCLCPP_INFO(LOGGER, "Computing graph connections (max %u edges per sample) ...", options.edges_per_sample);
-
-    // construct connections
-    const ob::StateSpacePtr& space = pcontext->getOMPLSimpleSetup()->getStateSpace();
-    unsigned int milestones = state_storage->size();
-    std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
-    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
-
-    ompl::time::point start = ompl::time::now();
-    int good = 0;
-    int done = -1;
-
-    for (std::size_t j = 0; j < milestones; ++j)
-    {
-      int done_now = 100 * j / milestones;
-      if (done != done_now)
-      {
-        done = done_now;
-        RCLCPP_INFO(LOGGER, "%d%% complete", done);
-      }
-      if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
-        continue;
-
-      const ob::State* sj = state_storage->getState(j);
+  const std::size_t milestones = state_storage->size();
+  result.milestones = milestones;
+  if (target_milestones > milestones)
+    RCLCPP_WARN(LOGGER, "Only %lu of %lu requested milestones were generated", milestones, target_milestones);
 
-      for (std::size_t i = j + 1; i < milestones; ++i)
+  // the explicit motions of connections that are kept are stored again after the new milestones
+  if (old_cass && options.explicit_motions)
+  {
+    for (std::size_t j = 0; j < old_milestones; ++j)
+      for (const std::pair<const std::size_t, std::pair<std::size_t, std::size_t>>& motion :
+           old_cass->getMetadata(j).second)
       {
-        if (cass->getMetadata(i).first.size() >= options.edges_per_sample)
-          continue;
-        double d = space->distance(state_storage->getState(i), sj);
-        if (d >= options.max_edge_length)
+        if (motion.first <= j)
           continue;
-        unsigned int isteps =
-            std::min<unsigned int>(options.max_explicit_points, d / options.explicit_points_resolution);
-        double step = 1.0 / static_cast<double>(isteps);
-        bool ok = true;
-        space->interpolate(state_storage->getState(i), sj, step, int_states[0]);
-        for (unsigned int k = 1; k < isteps; ++k)
-        {
-          double this_step = step / (1.0 - (k - 1) * step);
-          space->interpolate(int_states[k - 1], sj, this_step, int_states[k]);
-          pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, int_states[k]);
-          if (!kset.decide(robot_state).satisfied)
-          {
-            ok = false;
-            break;
-          }
-        }
-
-        if (ok)
-        {
-          cass->getMetadata(i).first.push_back(j);
-          cass->getMetadata(j).first.push_back(i);
-
-          if (options.explicit_motions)
-          {
-            cass->getMetadata(i).second[j].first = state_storage->size();
-            for (unsigned int k = 0; k < isteps; ++k)
-            {
-              int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
-              state_storage->addState(int_states[k]);
-            }
-            cass->getMetadata(i).second[j].second = state_storage->size();
-            cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
-          }
-
-          good++;
-          if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
-            break;
-        }
+        std::pair<std::size_t, std::size_t>& range = cass->getMetadata(j).second[motion.first];
+        range.first = state_storage->size();
+        for (std::size_t k = motion.second.first; k < motion.second.second; ++k)
+          state_storage->addState(old_cass->getState(k));
+        range.second = state_storage->size();
+        cass->getMetadata(motion.first).second[j] = range;
       }
-    }
+  }
+
+  if (options.edges_per_sample > 0)
+  {
+    RCLCPP_INFO(LOGGER, "Computing graph connections (max %u edges per sample) using %u thread(s) ...",
+                options.edges_per_sample, num_threads);
 
+    start = ompl::time::now();
+    const std::size_t good =
+        connectConstraintApproximationMilestones(pcontext, cass, milestones, old_milestones, kset, options);
     result.state_connection_time = ompl::time::seconds(ompl::time::now() - start);
-    RCLCPP_INFO(LOGGER, "Computed possible connexions in %lf seconds. Added %d connexions",
+    RCLCPP_INFO(LOGGER, "Computed possible connexions in %lf seconds. Added %zu connexions",
                 result.state_connection_time, good);
-    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->freeStates(int_states);
 
     return state_storage;
   }
@@ -0,0 +1,154 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/continuous_motion_validator.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+
+namespace ompl_interface
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.continuous_motion_validator");
+
+namespace
+{
+// the collision checkers that implement continuous collision checks of the robot against the world
+bool hasContinuousCollisionChecks(const std::string& collision_detector_name)
+{
+  return collision_detector_name == "FCL" || collision_detector_name == "Bullet";
+}
+}  // namespace
+
+ContinuousMotionValidator::ContinuousMotionValidator(const ModelBasedPlanningContext* planning_context)
+  : ompl::base::MotionValidator(planning_context->getOMPLSimpleSetup()->getSpaceInformation())
+  , planning_context_(planning_context)
+  , continuous_(hasContinuousCollisionChecks(planning_context->getPlanningScene()->getCollisionDetectorName()))
+  , discrete_validator_(si_)
+  , tss_start_(planning_context->getCompleteInitialRobotState())
+  , tss_end_(planning_context->getCompleteInitialRobotState())
+{
+  collision_request_.group = planning_context->getJointModelGroup();
+  if (!continuous_)
+  {
+    RCLCPP_WARN(LOGGER,
+                "Collision checker '%s' has no continuous collision checks, motions are validated at discrete states",
+                planning_context->getPlanningScene()->getCollisionDetectorName().c_str());
+  }
+}
+
+bool ContinuousMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const
+{
+  if (isMotionValid(s1, s2))
+  {
+    valid_++;
+    return true;
+  }
+  invalid_++;
+  return false;
+}
+
+bool ContinuousMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                                            std::pair<ompl::base::State*, double>& last_valid) const
+{
+  if (isMotionValid(s1, s2))
+  {
+    valid_++;
+    return true;
+  }
+  invalid_++;
+
+  // the continuous check doesn't tell where the motion becomes invalid, so the sampled states are searched for it
+  if (continuous_ && discrete_validator_.checkMotion(s1, s2, last_valid))
+  {
+    // all sampled states are valid, the collision is between them
+    last_valid.second = 0.0;
+    if (last_valid.first)
+      si_->copyState(last_valid.first, s1);
+  }
+  return false;
+}
+
+bool ContinuousMotionValidator::isMotionValid(const ompl::base::State* s1, const ompl::base::State* s2) const
+{
+  if (!continuous_)
+    return discrete_validator_.checkMotion(s1, s2);
+
+  // s1 is valid by contract of the motion validator, s2 is checked completely
+  if (!si_->isValid(s2))
+    return false;
+
+  const planning_scene::PlanningSceneConstPtr& planning_scene = planning_context_->getPlanningScene();
+  const ModelBasedStateSpacePtr& state_space = planning_context_->getOMPLStateSpace();
+  moveit::core::RobotState* start_state = tss_start_.getStateStorage();
+  moveit::core::RobotState* end_state = tss_end_.getStateStorage();
+  state_space->copyToRobotState(*start_state, s1);
+  state_space->copyToRobotState(*end_state, s2);
+
+  collision_detection::CollisionResult res;
+  planning_scene->getCollisionEnv()->checkRobotCollision(collision_request_, res, *start_state, *end_state,
+                                                         planning_scene->getAllowedCollisionMatrix());
+  if (res.collision)
+    return false;
+
+  // the states in between are checked for everything the continuous check doesn't cover
+  const unsigned int segment_count = si_->getStateSpace()->validSegmentCount(s1, s2);
+  if (segment_count < 2)
+    return true;
+
+  const kinematic_constraints::KinematicConstraintSetPtr& path_constraints = planning_context_->getPathConstraints();
+  ompl::base::State* state = si_->allocState();
+  bool valid = true;
+  for (unsigned int i = 1; valid && i < segment_count; ++i)
+  {
+    si_->getStateSpace()->interpolate(s1, s2, static_cast<double>(i) / static_cast<double>(segment_count), state);
+    state_space->copyToRobotState(*start_state, state);
+    if (path_constraints && !path_constraints->decide(*start_state).satisfied)
+    {
+      valid = false;
+    }
+    else if (!planning_scene->isStateFeasible(*start_state))
+    {
+      valid = false;
+    }
+    else
+    {
+      res.clear();
+      planning_scene->checkSelfCollision(collision_request_, res, *start_state);
+      valid = !res.collision;
+    }
+  }
+  si_->freeState(state);
+  return valid;
+}
+}  // namespace ompl_interface
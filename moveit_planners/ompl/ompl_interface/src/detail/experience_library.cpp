@@ -0,0 +1,131 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/experience_library.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace ompl_interface
+{
+namespace
+{
+// joint space distance below which two waypoints are considered the same
+constexpr double SAME_WAYPOINT_DISTANCE = 1e-3;
+
+bool isSameWaypoint(const moveit::core::JointModelGroup* group, const std::vector<double>& a,
+                    const std::vector<double>& b)
+{
+  return group->distance(a.data(), b.data()) < SAME_WAYPOINT_DISTANCE;
+}
+}  // namespace
+
+ExperienceLibrary::ExperienceLibrary(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1))
+{
+}
+
+std::shared_ptr<const ExperiencePath>
+ExperienceLibrary::addExperience(const moveit::core::JointModelGroup* group, ExperiencePath path, bool notify)
+{
+  if (path.size() < 2)
+    return nullptr;
+  auto experience = std::make_shared<const ExperiencePath>(std::move(path));
+
+  InsertionCallback callback;
+  {
+    std::scoped_lock lock(lock_);
+    std::deque<std::shared_ptr<const ExperiencePath>>& experiences = experiences_[group->getName()];
+    const auto same_endpoints = [group, &experience](const std::shared_ptr<const ExperiencePath>& other) {
+      return isSameWaypoint(group, other->front(), experience->front()) &&
+             isSameWaypoint(group, other->back(), experience->back());
+    };
+    experiences.erase(std::remove_if(experiences.begin(), experiences.end(), same_endpoints), experiences.end());
+    experiences.push_back(experience);
+    if (experiences.size() > capacity_)
+      experiences.pop_front();
+    if (notify)
+      callback = insertion_callback_;
+  }
+
+  // storing the experience may take a while, so don't block other threads meanwhile
+  if (callback)
+    callback(group, experience);
+  return experience;
+}
+
+std::vector<std::shared_ptr<const ExperiencePath>>
+ExperienceLibrary::findExperiences(const moveit::core::JointModelGroup* group, const double* start,
+                                   const std::function<bool(const std::vector<double>& waypoint)>& is_goal,
+                                   std::size_t count, double max_start_distance) const
+{
+  std::vector<std::pair<double, std::shared_ptr<const ExperiencePath>>> candidates;
+  {
+    std::scoped_lock lock(lock_);
+    const auto it = experiences_.find(group->getName());
+    if (it == experiences_.end())
+      return {};
+    candidates.reserve(it->second.size());
+    for (const std::shared_ptr<const ExperiencePath>& experience : it->second)
+    {
+      const double distance = group->distance(start, experience->front().data());
+      if (distance <= max_start_distance)
+        candidates.emplace_back(distance, experience);
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+  std::vector<std::shared_ptr<const ExperiencePath>> result;
+  for (const auto& candidate : candidates)
+  {
+    if (result.size() >= count)
+      break;
+    if (is_goal(candidate.second->back()))
+      result.push_back(candidate.second);
+  }
+  return result;
+}
+
+std::size_t ExperienceLibrary::size(const std::string& group) const
+{
+  std::scoped_lock lock(lock_);
+  const auto it = experiences_.find(group);
+  return it == experiences_.end() ? 0 : it->second.size();
+}
+
+void ExperienceLibrary::clear()
+{
+  std::scoped_lock lock(lock_);
+  experiences_.clear();
+}
+}  // namespace ompl_interface
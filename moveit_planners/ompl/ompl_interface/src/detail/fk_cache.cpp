@@ -0,0 +1,149 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/fk_cache.h>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+std::atomic<std::uint64_t> next_cache_id{ 1 };
+
+// Per-thread entries of the caches a thread accessed last, as in TSStateStorage
+struct ThreadEntriesCache
+{
+  struct Entry
+  {
+    std::uint64_t cache_id = 0;
+    void* entries = nullptr;
+  };
+  std::array<Entry, 4> entries;
+  std::size_t next_entry = 0;
+};
+thread_local ThreadEntriesCache thread_entries_cache;
+}  // namespace
+
+namespace ompl_interface
+{
+FKCache::FKCache(std::size_t capacity)
+  : id_(next_cache_id++), capacity_(std::max<std::size_t>(capacity, 1)), generation_(1)
+{
+}
+
+void FKCache::addLink(const moveit::core::LinkModel* link)
+{
+  if (std::find(links_.begin(), links_.end(), link) == links_.end())
+  {
+    links_.push_back(link);
+  }
+}
+
+void FKCache::clear()
+{
+  ++generation_;
+}
+
+void FKCache::insert(const double* values, std::size_t count, const moveit::core::RobotState& robot_state) const
+{
+  ThreadEntries* thread_entries = getThreadEntries();
+  Entry& entry = thread_entries->entries[thread_entries->next_entry];
+  thread_entries->next_entry = (thread_entries->next_entry + 1) % capacity_;
+
+  entry.hash = boost::hash_range(values, values + count);
+  entry.generation = generation_.load(std::memory_order_relaxed);
+  entry.values.assign(values, values + count);
+  entry.positions.resize(links_.size());
+  for (std::size_t i = 0; i < links_.size(); ++i)
+  {
+    entry.positions[i] = robot_state.getGlobalLinkTransform(links_[i]).translation();
+  }
+}
+
+bool FKCache::lookup(const double* values, std::size_t count, const moveit::core::LinkModel* link,
+                     Eigen::Vector3d& position) const
+{
+  const std::size_t link_index = std::find(links_.begin(), links_.end(), link) - links_.begin();
+  if (link_index == links_.size())
+  {
+    return false;
+  }
+
+  const ThreadEntries* thread_entries = getThreadEntries();
+  const std::size_t hash = boost::hash_range(values, values + count);
+  const std::uint64_t generation = generation_.load(std::memory_order_relaxed);
+  // search backwards from the latest entry, which is the most likely match
+  for (std::size_t i = 1; i <= capacity_; ++i)
+  {
+    const Entry& entry = thread_entries->entries[(thread_entries->next_entry + capacity_ - i) % capacity_];
+    if (entry.hash == hash && entry.generation == generation && link_index < entry.positions.size() &&
+        std::equal(values, values + count, entry.values.begin(), entry.values.end()))
+    {
+      position = entry.positions[link_index];
+      return true;
+    }
+  }
+  return false;
+}
+
+FKCache::ThreadEntries* FKCache::getThreadEntries() const
+{
+  ThreadEntriesCache& cache = thread_entries_cache;
+  for (const ThreadEntriesCache::Entry& entry : cache.entries)
+  {
+    if (entry.cache_id == id_)
+    {
+      return static_cast<ThreadEntries*>(entry.entries);
+    }
+  }
+
+  ThreadEntries* thread_entries = getThreadEntriesLocked();
+  cache.entries[cache.next_entry] = { id_, thread_entries };
+  cache.next_entry = (cache.next_entry + 1) % cache.entries.size();
+  return thread_entries;
+}
+
+FKCache::ThreadEntries* FKCache::getThreadEntriesLocked() const
+{
+  std::unique_lock<std::mutex> slock(lock_);
+  std::unique_ptr<ThreadEntries>& thread_entries = thread_entries_[std::this_thread::get_id()];
+  if (!thread_entries)
+  {
+    thread_entries = std::make_unique<ThreadEntries>();
+    thread_entries->entries.resize(capacity_);
+  }
+  return thread_entries.get();
+}
+}  // namespace ompl_interface
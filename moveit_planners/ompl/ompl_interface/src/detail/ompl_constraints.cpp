@@ -153,17 +153,32 @@ void BaseConstraint::jacobian(const Eigen::Ref<const Eigen::VectorXd>& joint_val
   }
 }
 
-Eigen::Isometry3d BaseConstraint::forwardKinematics(const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
+moveit::core::RobotState* BaseConstraint::getRobotState(const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
 {
   moveit::core::RobotState* robot_state = state_storage_.getStateStorage();
-  robot_state->setJointGroupPositions(joint_model_group_, joint_values);
-  return robot_state->getGlobalLinkTransform(link_name_);
+
+  // Setting the positions marks the link transforms dirty even if they do not change, so skip it for the same values
+  const std::vector<int>& variable_indices = joint_model_group_->getVariableIndexList();
+  const double* positions = robot_state->getVariablePositions();
+  for (std::size_t i = 0; i < variable_indices.size(); ++i)
+  {
+    if (positions[variable_indices[i]] != joint_values[i])
+    {
+      robot_state->setJointGroupPositions(joint_model_group_, joint_values);
+      break;
+    }
+  }
+  return robot_state;
+}
+
+Eigen::Isometry3d BaseConstraint::forwardKinematics(const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
+{
+  return getRobotState(joint_values)->getGlobalLinkTransform(link_name_);
 }
 
 Eigen::MatrixXd BaseConstraint::robotGeometricJacobian(const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
 {
-  moveit::core::RobotState* robot_state = state_storage_.getStateStorage();
-  robot_state->setJointGroupPositions(joint_model_group_, joint_values);
+  moveit::core::RobotState* robot_state = getRobotState(joint_values);
   Eigen::MatrixXd jacobian;
   // return value (success) not used, could return a garbage jacobian.
   robot_state->getJacobian(joint_model_group_, joint_model_group_->getLinkModel(link_name_),
@@ -287,7 +302,8 @@ void EqualityPositionConstraint::jacobian(const Eigen::Ref<const Eigen::VectorXd
                                           Eigen::Ref<Eigen::MatrixXd> out) const
 {
   out.setZero();
-  Eigen::MatrixXd jac = target_orientation_.matrix().transpose() * robotGeometricJacobian(joint_values).topRows(3);
+  const Eigen::Matrix<double, 3, Eigen::Dynamic> jac =
+      target_orientation_.matrix().transpose() * robotGeometricJacobian(joint_values).topRows(3);
   for (std::size_t dim = 0; dim < 3; ++dim)
   {
     if (is_dim_constrained_.at(dim))
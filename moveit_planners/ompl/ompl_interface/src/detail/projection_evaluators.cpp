@@ -37,6 +37,7 @@
 #include <moveit/ompl_interface/detail/projection_evaluators.h>
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/ompl_interface/parameterization/joint_space/constrained_planning_state_space.h>
 
 #include <utility>
 
@@ -46,7 +47,14 @@ ompl_interface::ProjectionEvaluatorLinkPose::ProjectionEvaluatorLinkPose(const M
   , planning_context_(pc)
   , link_(planning_context_->getJointModelGroup()->getLinkModel(link))
   , tss_(planning_context_->getCompleteInitialRobotState())
+  , use_fk_cache_(pc->getOMPLStateSpace()->getParameterizationType() !=
+                  ConstrainedPlanningStateSpace::PARAMETERIZATION_TYPE)
 {
+  // constrained states wrap the model based ones, the validity checker does not record them
+  if (use_fk_cache_)
+  {
+    planning_context_->getFKCache()->addLink(link_);
+  }
 }
 
 unsigned int ompl_interface::ProjectionEvaluatorLinkPose::getDimension() const
@@ -65,10 +73,16 @@ void ompl_interface::ProjectionEvaluatorLinkPose::defaultCellSizes()
 void ompl_interface::ProjectionEvaluatorLinkPose::project(const ompl::base::State* state,
                                                           OMPLProjection projection) const
 {
-  moveit::core::RobotState* s = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
-
-  const Eigen::Vector3d& o = s->getGlobalLinkTransform(link_).translation();
+  // the state validity checker has usually just computed forward kinematics for this state
+  Eigen::Vector3d o;
+  if (!use_fk_cache_ ||
+      !planning_context_->getFKCache()->lookup(state->as<ModelBasedStateSpace::StateType>()->values,
+                                               planning_context_->getJointModelGroup()->getVariableCount(), link_, o))
+  {
+    moveit::core::RobotState* s = tss_.getStateStorage();
+    planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
+    o = s->getGlobalLinkTransform(link_).translation();
+  }
   projection(0) = o.x();
   projection(1) = o.y();
   projection(2) = o.z();
@@ -37,9 +37,17 @@
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <ompl/base/spaces/constraint/ConstrainedStateSpace.h>
+#include <geometric_shapes/bodies.h>
+#include <geometric_shapes/body_operations.h>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
 namespace ompl_interface
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.state_validity_checker");
@@ -50,6 +58,9 @@ ompl_interface::StateValidityChecker::StateValidityChecker(const ModelBasedPlann
   , group_name_(pc->getGroupName())
   , tss_(pc->getCompleteInitialRobotState())
   , verbose_(false)
+  , check_order_({ CheckStage::PATH_CONSTRAINTS, CheckStage::FEASIBILITY, CheckStage::COLLISION })
+  , broadphase_enabled_(false)
+  , statistics_enabled_(false)
 {
   specs_.clearanceComputationType = ompl::base::StateValidityCheckerSpecs::APPROXIMATE;
   specs_.hasValidDirectionComputation = false;
@@ -57,15 +68,172 @@ ompl_interface::StateValidityChecker::StateValidityChecker(const ModelBasedPlann
   collision_request_with_distance_.distance = true;
   collision_request_with_cost_.cost = true;
 
-  collision_request_simple_.group_name = planning_context_->getGroupName();
-  collision_request_with_distance_.group_name = planning_context_->getGroupName();
-  collision_request_with_cost_.group_name = planning_context_->getGroupName();
+  collision_request_simple_.group = planning_context_->getJointModelGroup();
+  collision_request_with_distance_.group = planning_context_->getJointModelGroup();
+  collision_request_with_cost_.group = planning_context_->getJointModelGroup();
 
   collision_request_simple_verbose_ = collision_request_simple_;
   collision_request_simple_verbose_.verbose = true;
 
   collision_request_with_distance_verbose_ = collision_request_with_distance_;
   collision_request_with_distance_verbose_.verbose = true;
+
+  resetStatistics();
+
+  const std::map<std::string, std::string>& config = pc->getSpecificationConfig();
+  auto it = config.find("validity_check_order");
+  if (it != config.end())
+  {
+    static const std::map<std::string, CheckStage> STAGE_NAMES = { { "path_constraints", CheckStage::PATH_CONSTRAINTS },
+                                                                   { "feasibility", CheckStage::FEASIBILITY },
+                                                                   { "collision", CheckStage::COLLISION } };
+    std::vector<CheckStage> order;
+    std::stringstream stages(it->second);
+    std::string stage;
+    while (std::getline(stages, stage, ','))
+    {
+      auto stage_it = STAGE_NAMES.find(boost::trim_copy(stage));
+      if (stage_it == STAGE_NAMES.end())
+      {
+        RCLCPP_WARN(LOGGER, "Ignoring unknown check '%s' in 'validity_check_order'", stage.c_str());
+      }
+      else if (std::find(order.begin(), order.end(), stage_it->second) == order.end())
+      {
+        order.push_back(stage_it->second);
+      }
+    }
+    // Never skip a check because it was not listed
+    for (const CheckStage default_stage : check_order_)
+    {
+      if (std::find(order.begin(), order.end(), default_stage) == order.end())
+      {
+        order.push_back(default_stage);
+      }
+    }
+    check_order_ = order;
+  }
+
+  it = config.find("validity_check_broadphase");
+  if (it != config.end() && boost::lexical_cast<bool>(it->second))
+  {
+    setBroadphaseEnabled(true);
+  }
+
+  it = config.find("validity_check_statistics");
+  if (it != config.end())
+  {
+    statistics_enabled_ = boost::lexical_cast<bool>(it->second);
+  }
+}
+
+void ompl_interface::StateValidityChecker::setBroadphaseEnabled(bool flag)
+{
+  broadphase_enabled_ = false;
+  link_spheres_.clear();
+  world_spheres_.clear();
+  if (!flag)
+  {
+    return;
+  }
+
+  const planning_scene::PlanningSceneConstPtr& scene = planning_context_->getPlanningScene();
+  if (!scene)
+  {
+    RCLCPP_WARN(LOGGER, "Broadphase requires a planning scene to be set in the planning context");
+    return;
+  }
+
+  // Attached bodies and scaled links are not covered by the link bounding spheres
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  planning_context_->getCompleteInitialRobotState().getAttachedBodies(attached_bodies);
+  if (!attached_bodies.empty())
+  {
+    RCLCPP_DEBUG(LOGGER, "Broadphase is not used with attached bodies");
+    return;
+  }
+  const collision_detection::CollisionEnvConstPtr& collision_env = scene->getCollisionEnv();
+  for (const moveit::core::LinkModel* link : planning_context_->getRobotModel()->getLinkModelsWithCollisionGeometry())
+  {
+    if (collision_env->getLinkScale(link->getName()) != 1.0)
+    {
+      RCLCPP_DEBUG(LOGGER, "Broadphase is not used with scaled links");
+      link_spheres_.clear();
+      return;
+    }
+    const double radius = 0.5 * link->getShapeExtentsAtOrigin().norm() + collision_env->getLinkPadding(link->getName());
+    link_spheres_.push_back({ link, { link->getCenteredBoundingBoxOffset(), radius } });
+  }
+
+  for (const auto& [id, object] : *scene->getWorld())
+  {
+    for (std::size_t i = 0; i < object->shapes_.size(); ++i)
+    {
+      // Shapes such as planes and octomaps have no (useful) bounding sphere
+      std::unique_ptr<bodies::Body> body(object->shapes_[i]->type == shapes::OCTREE ?
+                                             nullptr :
+                                             bodies::createBodyFromShape(object->shapes_[i].get()));
+      if (!body)
+      {
+        RCLCPP_DEBUG(LOGGER, "Broadphase is not used, as world object '%s' can not be bounded", id.c_str());
+        link_spheres_.clear();
+        world_spheres_.clear();
+        return;
+      }
+      body->setPose(object->global_shape_poses_[i]);
+      bodies::BoundingSphere sphere;
+      body->computeBoundingSphere(sphere);
+      world_spheres_.push_back({ sphere.center, sphere.radius });
+    }
+  }
+  broadphase_enabled_ = true;
+}
+
+bool ompl_interface::StateValidityChecker::isClearOfWorld(const moveit::core::RobotState& robot_state) const
+{
+  for (const auto& [link, link_sphere] : link_spheres_)
+  {
+    const Eigen::Vector3d center = robot_state.getGlobalLinkTransform(link) * link_sphere.center;
+    for (const BoundingSphere& world_sphere : world_spheres_)
+    {
+      const double min_distance = link_sphere.radius + world_sphere.radius;
+      if ((center - world_sphere.center).squaredNorm() < min_distance * min_distance)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+StateValidityChecker::Statistics StateValidityChecker::getStatistics() const
+{
+  Statistics statistics;
+  statistics.checked_states = counters_[CHECKED_STATES].load(std::memory_order_relaxed);
+  statistics.bounds_rejections = counters_[BOUNDS_REJECTIONS].load(std::memory_order_relaxed);
+  statistics.path_constraints_rejections = counters_[PATH_CONSTRAINTS_REJECTIONS].load(std::memory_order_relaxed);
+  statistics.feasibility_rejections = counters_[FEASIBILITY_REJECTIONS].load(std::memory_order_relaxed);
+  statistics.collision_rejections = counters_[COLLISION_REJECTIONS].load(std::memory_order_relaxed);
+  statistics.broadphase_world_skips = counters_[BROADPHASE_WORLD_SKIPS].load(std::memory_order_relaxed);
+  return statistics;
+}
+
+void StateValidityChecker::resetStatistics()
+{
+  for (std::atomic<std::size_t>& counter : counters_)
+  {
+    counter.store(0, std::memory_order_relaxed);
+  }
+}
+
+void StateValidityChecker::cacheLinkPositions(const ompl::base::State* state,
+                                              const moveit::core::RobotState& robot_state) const
+{
+  const FKCachePtr& fk_cache = planning_context_->getFKCache();
+  if (!fk_cache->empty())
+  {
+    fk_cache->insert(state->as<ModelBasedStateSpace::StateType>()->values,
+                     planning_context_->getJointModelGroup()->getVariableCount(), robot_state);
+  }
 }
 
 void ompl_interface::StateValidityChecker::setVerbose(bool flag)
@@ -81,6 +249,7 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, bool verbose)
   {
     return state->as<ModelBasedStateSpace::StateType>()->isMarkedValid();
   }
+  count(CHECKED_STATES);
 
   if (!si_->satisfiesBounds(state))
   {
@@ -88,41 +257,70 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, bool verbose)
     {
       RCLCPP_INFO(LOGGER, "State outside bounds");
     }
+    count(BOUNDS_REJECTIONS);
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
     return false;
   }
 
   moveit::core::RobotState* robot_state = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  cacheLinkPositions(state, *robot_state);
 
-  // check path constraints
-  const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*robot_state, verbose).satisfied)
+  for (const CheckStage stage : check_order_)
   {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
-  }
-
-  // check feasibility
-  if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
+    switch (stage)
+    {
+      case CheckStage::PATH_CONSTRAINTS:
+      {
+        // check path constraints
+        const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
+        if (kset && !kset->decide(*robot_state, verbose).satisfied)
+        {
+          count(PATH_CONSTRAINTS_REJECTIONS);
+          const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+          return false;
+        }
+        break;
+      }
+      case CheckStage::FEASIBILITY:
+      {
+        // check feasibility
+        if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
+        {
+          count(FEASIBILITY_REJECTIONS);
+          const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+          return false;
+        }
+        break;
+      }
+      case CheckStage::COLLISION:
+      {
+        // check collision avoidance, only against the robot itself if the broadphase rules out world contacts
+        collision_detection::CollisionResult res;
+        const collision_detection::CollisionRequest& req =
+            verbose ? collision_request_simple_verbose_ : collision_request_simple_;
+        if (broadphase_enabled_ && isClearOfWorld(*robot_state))
+        {
+          count(BROADPHASE_WORLD_SKIPS);
+          planning_context_->getPlanningScene()->checkSelfCollision(req, res, *robot_state);
+        }
+        else
+        {
+          planning_context_->getPlanningScene()->checkCollision(req, res, *robot_state);
+        }
+        if (res.collision)
+        {
+          count(COLLISION_REJECTIONS);
+          const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+          return false;
+        }
+        break;
+      }
+    }
   }
 
-  // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(
-      verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *robot_state);
-  if (!res.collision)
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
-  }
-  else
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-  }
-  return !res.collision;
+  const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
+  return true;
 }
 
 bool StateValidityChecker::isValid(const ompl::base::State* state, double& dist, bool verbose) const
@@ -135,6 +333,7 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, double& dist,
     dist = state->as<ModelBasedStateSpace::StateType>()->distance;
     return state->as<ModelBasedStateSpace::StateType>()->isMarkedValid();
   }
+  count(CHECKED_STATES);
 
   if (!si_->satisfiesBounds(state))
   {
@@ -142,39 +341,65 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, double& dist,
     {
       RCLCPP_INFO(LOGGER, "State outside bounds");
     }
+    count(BOUNDS_REJECTIONS);
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid(0.0);
     return false;
   }
 
   moveit::core::RobotState* robot_state = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  cacheLinkPositions(state, *robot_state);
 
-  // check path constraints
-  const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset)
+  dist = std::numeric_limits<double>::max();
+  for (const CheckStage stage : check_order_)
   {
-    kinematic_constraints::ConstraintEvaluationResult cer = kset->decide(*robot_state, verbose);
-    if (!cer.satisfied)
+    switch (stage)
     {
-      dist = cer.distance;
-      const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid(dist);
-      return false;
+      case CheckStage::PATH_CONSTRAINTS:
+      {
+        // check path constraints
+        const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
+        if (kset)
+        {
+          kinematic_constraints::ConstraintEvaluationResult cer = kset->decide(*robot_state, verbose);
+          if (!cer.satisfied)
+          {
+            count(PATH_CONSTRAINTS_REJECTIONS);
+            dist = cer.distance;
+            const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid(dist);
+            return false;
+          }
+        }
+        break;
+      }
+      case CheckStage::FEASIBILITY:
+      {
+        // check feasibility
+        if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
+        {
+          count(FEASIBILITY_REJECTIONS);
+          dist = 0.0;
+          return false;
+        }
+        break;
+      }
+      case CheckStage::COLLISION:
+      {
+        // check collision avoidance; the distance to the world is needed, so the broadphase is not used here
+        collision_detection::CollisionResult res;
+        planning_context_->getPlanningScene()->checkCollision(
+            verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *robot_state);
+        dist = res.distance;
+        if (res.collision)
+        {
+          count(COLLISION_REJECTIONS);
+          return false;
+        }
+        break;
+      }
     }
   }
-
-  // check feasibility
-  if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
-  {
-    dist = 0.0;
-    return false;
-  }
-
-  // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(
-      verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *robot_state);
-  dist = res.distance;
-  return !res.collision;
+  return true;
 }
 
 double StateValidityChecker::cost(const ompl::base::State* state) const
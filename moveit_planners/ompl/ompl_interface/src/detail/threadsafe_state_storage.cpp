@@ -36,13 +36,36 @@
 
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
 
+#include <array>
+#include <atomic>
+
+namespace
+{
+std::atomic<std::uint64_t> next_storage_id{ 1 };
+
+// Per-thread states of the storages a thread accessed last. A thread typically uses a few storages at a time (e.g.
+// the state validity checker and the constraint samplers of one planning context), so a small array suffices.
+struct ThreadStateCache
+{
+  struct Entry
+  {
+    std::uint64_t storage_id = 0;
+    moveit::core::RobotState* state = nullptr;
+  };
+  std::array<Entry, 4> entries;
+  std::size_t next_entry = 0;
+};
+thread_local ThreadStateCache thread_state_cache;
+}  // namespace
+
 ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotModelPtr& robot_model)
-  : start_state_(robot_model)
+  : id_(next_storage_id++), start_state_(robot_model)
 {
   start_state_.setToDefaultValues();
 }
 
-ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotState& start_state) : start_state_(start_state)
+ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotState& start_state)
+  : id_(next_storage_id++), start_state_(start_state)
 {
 }
 
@@ -55,9 +78,26 @@ ompl_interface::TSStateStorage::~TSStateStorage()
 }
 
 moveit::core::RobotState* ompl_interface::TSStateStorage::getStateStorage() const
+{
+  ThreadStateCache& cache = thread_state_cache;
+  for (const ThreadStateCache::Entry& entry : cache.entries)
+  {
+    if (entry.storage_id == id_)
+    {
+      return entry.state;
+    }
+  }
+
+  moveit::core::RobotState* st = getStateStorageLocked();
+  cache.entries[cache.next_entry] = { id_, st };
+  cache.next_entry = (cache.next_entry + 1) % cache.entries.size();
+  return st;
+}
+
+moveit::core::RobotState* ompl_interface::TSStateStorage::getStateStorageLocked() const
 {
   moveit::core::RobotState* st = nullptr;
-  std::unique_lock<std::mutex> slock(lock_);  /// \todo use Thread Local Storage?
+  std::unique_lock<std::mutex> slock(lock_);
   std::map<std::thread::id, moveit::core::RobotState*>::const_iterator it =
       thread_states_.find(std::this_thread::get_id());
   if (it == thread_states_.end())
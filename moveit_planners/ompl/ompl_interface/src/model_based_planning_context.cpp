@@ -41,6 +41,7 @@
 
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <moveit/ompl_interface/detail/continuous_motion_validator.h>
 #include <moveit/ompl_interface/detail/constrained_sampler.h>
 #include <moveit/ompl_interface/detail/constrained_goal_sampler.h>
 #include <moveit/ompl_interface/detail/goal_union.h>
@@ -48,6 +49,8 @@
 #include <moveit/ompl_interface/detail/constraints_library.h>
 
 #include <moveit/kinematic_constraints/utils.h>
+#include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/constraint_samplers/union_constraint_sampler.h>
 
 #include <moveit/utils/lexical_casts.h>
 
@@ -66,10 +69,51 @@
 #include <ompl/base/objectives/StateCostIntegralObjective.h>
 #include <ompl/base/objectives/MaximizeMinClearanceObjective.h>
 #include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/PathSimplifier.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 namespace ompl_interface
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.model_based_planning_context");
+
+// the number of similar experiences experience-based planning tries to repair before planning from scratch
+constexpr std::size_t MAX_RECALLED_EXPERIENCES = 3;
+// the number of states sampled around each invalid waypoint of a recalled path
+constexpr unsigned int EXPERIENCE_REPAIR_ATTEMPTS = 10;
+// the joint space distance of the start of a recalled path to the start state, beyond which repairing the connection
+// between them is unlikely to be faster than planning
+constexpr double DEFAULT_EXPERIENCE_MAX_START_DISTANCE = 1.0;
+
+// switch the joint constraint samplers, also those combined in a union, to low-discrepancy sampling
+static void enableQuasiRandomSampling(const constraint_samplers::ConstraintSamplerPtr& sampler)
+{
+  if (const auto joint_sampler = std::dynamic_pointer_cast<constraint_samplers::JointConstraintSampler>(sampler))
+    joint_sampler->setQuasiRandomSampling(true);
+  else if (const auto union_sampler = std::dynamic_pointer_cast<constraint_samplers::UnionConstraintSampler>(sampler))
+  {
+    for (const constraint_samplers::ConstraintSamplerPtr& member : union_sampler->getSamplers())
+      enableQuasiRandomSampling(member);
+  }
+}
+
+// check if all kinematics solvers the group samples goals with may be queried from several threads at once
+static bool supportsConcurrentIK(const moveit::core::JointModelGroup* jmg)
+{
+  const auto& group_kinematics = jmg->getGroupKinematics();
+  if (group_kinematics.first.solver_instance_ && !group_kinematics.first.solver_instance_->supportsConcurrentQueries())
+    return false;
+  for (const auto& subgroup_kinematics : group_kinematics.second)
+  {
+    if (subgroup_kinematics.second.solver_instance_ &&
+        !subgroup_kinematics.second.solver_instance_->supportsConcurrentQueries())
+      return false;
+  }
+  return true;
+}
 }  // namespace ompl_interface
 
 ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::string& name,
@@ -91,27 +135,45 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
   , minimum_waypoint_count_(0)
   , multi_query_planning_enabled_(false)  // maintain "old" behavior by default
   , simplify_solutions_(true)
+  , simplification_threads_(1)
   , interpolate_(true)
   , hybridize_(true)
+  , anytime_(false)
+  , continuous_motion_validation_(false)
+  , use_experience_(false)
+  , experience_max_start_distance_(DEFAULT_EXPERIENCE_MAX_START_DISTANCE)
+  , solved_from_experience_(false)
+  , configured_(false)
+  , configured_max_solution_segment_length_(0.0)
+  , configured_use_constraints_approximations_(false)
 {
   complete_initial_robot_state_.setToDefaultValues();  // avoid uninitialized memory
   complete_initial_robot_state_.update();
 
   constraints_library_ = std::make_shared<ConstraintsLibrary>(this);
+  fk_cache_ = std::make_shared<FKCache>();
 }
 
 void ompl_interface::ModelBasedPlanningContext::configure(const rclcpp::Node::SharedPtr& node,
                                                           bool use_constraints_approximations)
 {
-  loadConstraintApproximations(node);
-  if (!use_constraints_approximations)
+  // a context reused with the same settings keeps its planner and parameters; only the problem itself is updated
+  const bool warm_start = isConfigured(use_constraints_approximations);
+  configured_ = false;
+  if (!warm_start)
   {
-    setConstraintsApproximations(ConstraintsLibraryPtr());
+    loadConstraintApproximations(node);
+    if (!use_constraints_approximations)
+    {
+      setConstraintsApproximations(ConstraintsLibraryPtr());
+    }
+    ompl_simple_setup_->getStateSpace()->computeSignature(space_signature_);
+    ompl_simple_setup_->getStateSpace()->setStateSamplerAllocator(
+        [this](const ompl::base::StateSpace* ss) { return allocPathConstrainedSampler(ss); });
   }
   complete_initial_robot_state_.update();
-  ompl_simple_setup_->getStateSpace()->computeSignature(space_signature_);
-  ompl_simple_setup_->getStateSpace()->setStateSamplerAllocator(
-      [this](const ompl::base::StateSpace* ss) { return allocPathConstrainedSampler(ss); });
+  // cached link positions depend on the joints outside of the group, which come from the start state
+  fk_cache_->clear();
 
   if (spec_.constrained_state_space_)
   {
@@ -141,9 +203,38 @@ void ompl_interface::ModelBasedPlanningContext::configure(const rclcpp::Node::Sh
     }
   }
 
-  useConfig();
+  if (warm_start)
+  {
+    RCLCPP_DEBUG(LOGGER, "%s: Reusing planner configuration of the previous request", name_.c_str());
+  }
+  else
+  {
+    useConfig();
+  }
+
+  // like the state validity checker, the motion validator holds the start state, so it is recreated for each request
+  const ompl::base::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  if (continuous_motion_validation_)
+  {
+    si->setMotionValidator(std::make_shared<ContinuousMotionValidator>(this));
+  }
+  else if (std::dynamic_pointer_cast<ContinuousMotionValidator>(si->getMotionValidator()))
+  {
+    si->setMotionValidator(std::make_shared<ompl::base::DiscreteMotionValidator>(si));
+  }
   if (ompl_simple_setup_->getGoal())
     ompl_simple_setup_->setup();
+
+  configured_ = true;
+  configured_config_ = spec_.config_;
+  configured_max_solution_segment_length_ = max_solution_segment_length_;
+  configured_use_constraints_approximations_ = use_constraints_approximations;
+}
+
+bool ompl_interface::ModelBasedPlanningContext::isConfigured(bool use_constraints_approximations) const
+{
+  return configured_ && configured_use_constraints_approximations_ == use_constraints_approximations &&
+         configured_max_solution_segment_length_ == max_solution_segment_length_ && configured_config_ == spec_.config_;
 }
 
 void ompl_interface::ModelBasedPlanningContext::setProjectionEvaluator(const std::string& peval)
@@ -270,6 +361,8 @@ ompl_interface::ModelBasedPlanningContext::allocPathConstrainedSampler(const omp
 
     if (constraint_sampler)
     {
+      if (spec_.state_space_->getQuasiRandomSampling())
+        enableQuasiRandomSampling(constraint_sampler);
       RCLCPP_INFO(LOGGER, "%s: Allocating specialized state sampler for state space", name_.c_str());
       return std::make_shared<ConstrainedSampler>(this, constraint_sampler);
     }
@@ -280,6 +373,7 @@ ompl_interface::ModelBasedPlanningContext::allocPathConstrainedSampler(const omp
 
 void ompl_interface::ModelBasedPlanningContext::useConfig()
 {
+  continuous_motion_validation_ = false;
   const std::map<std::string, std::string>& config = spec_.config_;
   if (config.empty())
     return;
@@ -318,6 +412,37 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // choose between pseudo-random ("uniform", the default) and low-discrepancy ("quasi_random") state sampling
+  it = cfg.find("state_sampling");
+  if (it != cfg.end())
+  {
+    const std::string state_sampling = boost::trim_copy(it->second);
+    if (state_sampling != "uniform" && state_sampling != "quasi_random")
+      RCLCPP_WARN(LOGGER, "%s: Unknown state sampling '%s', using 'uniform'", name_.c_str(), state_sampling.c_str());
+    spec_.state_space_->setQuasiRandomSampling(state_sampling == "quasi_random");
+    cfg.erase(it);
+  }
+
+  // choose between validating motions at discrete states ("discrete", the default) and with continuous collision
+  // checks ("continuous")
+  it = cfg.find("motion_validator");
+  if (it != cfg.end())
+  {
+    const std::string motion_validator = boost::trim_copy(it->second);
+    if (motion_validator == "continuous" && spec_.constrained_state_space_)
+    {
+      RCLCPP_WARN(LOGGER, "%s: Continuous motion validation is not supported in constrained state spaces",
+                  name_.c_str());
+    }
+    else if (motion_validator != "discrete" && motion_validator != "continuous")
+    {
+      RCLCPP_WARN(LOGGER, "%s: Unknown motion validator '%s', using 'discrete'", name_.c_str(),
+                  motion_validator.c_str());
+    }
+    continuous_motion_validation_ = motion_validator == "continuous" && !spec_.constrained_state_space_;
+    cfg.erase(it);
+  }
+
   if (cfg.empty())
   {
     return;
@@ -386,6 +511,14 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // the number of threads simplifying the solution path
+  it = cfg.find("simplification_threads");
+  if (it != cfg.end())
+  {
+    simplification_threads_ = std::max(1u, boost::lexical_cast<unsigned int>(it->second));
+    cfg.erase(it);
+  }
+
   // check whether solution paths from parallel planning should be hybridized
   it = cfg.find("hybridize");
   if (it != cfg.end())
@@ -394,6 +527,33 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // check whether the first solution should be returned right away and refined with the remaining planning time
+  it = cfg.find("anytime");
+  if (it != cfg.end())
+  {
+    anytime_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
+  // check whether similar paths planned before should be tried before planning
+  it = cfg.find("use_experience");
+  if (it != cfg.end())
+  {
+    use_experience_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+  it = cfg.find("experience_max_start_distance");
+  if (it != cfg.end())
+  {
+    experience_max_start_distance_ = moveit::core::toDouble(it->second);
+    cfg.erase(it);
+  }
+
+  // the number of goal sampling threads is read by constructGoal()
+  it = cfg.find("goal_sampling_threads");
+  if (it != cfg.end())
+    cfg.erase(it);
+
   // remove the 'type' parameter; the rest are parameters for the planner itself
   it = cfg.find("type");
   if (it == cfg.end())
@@ -446,37 +606,247 @@ void ompl_interface::ModelBasedPlanningContext::simplifySolution(double timeout)
   ompl::time::point start = ompl::time::now();
   ob::PlannerTerminationCondition ptc = constructPlannerTerminationCondition(timeout, start);
   registerTerminationCondition(ptc);
-  ompl_simple_setup_->simplifySolution(ptc);
-  last_simplify_time_ = ompl_simple_setup_->getLastSimplificationTime();
+  if (simplification_threads_ > 1 && ompl_simple_setup_->haveSolutionPath())
+  {
+    simplifySolutionInParallel(ptc);
+    last_simplify_time_ = ompl::time::seconds(ompl::time::now() - start);
+  }
+  else
+  {
+    ompl_simple_setup_->simplifySolution(ptc);
+    last_simplify_time_ = ompl_simple_setup_->getLastSimplificationTime();
+  }
   unregisterTerminationCondition();
 }
 
+void ompl_interface::ModelBasedPlanningContext::simplifySolutionInParallel(const ob::PlannerTerminationCondition& ptc)
+{
+  // Shortcuts are chosen at random, so the simplifications of the copies differ and the best one is kept
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  std::vector<og::PathGeometric> paths(simplification_threads_, ompl_simple_setup_->getSolutionPath());
+  const auto simplify = [this, &pdef, &ptc](og::PathGeometric& path) {
+    og::PathSimplifier simplifier(ompl_simple_setup_->getSpaceInformation(), pdef->getGoal(),
+                                  pdef->getOptimizationObjective());
+    simplifier.simplify(path, ptc);
+  };
+
+  std::vector<std::thread> simplification_threads;
+  simplification_threads.reserve(paths.size() - 1);
+  for (std::size_t i = 1; i < paths.size(); ++i)
+  {
+    simplification_threads.emplace_back(simplify, std::ref(paths[i]));
+  }
+  simplify(paths[0]);
+  for (std::thread& simplification_thread : simplification_threads)
+  {
+    simplification_thread.join();
+  }
+
+  // Paths are compared by the optimization objective if there is one, otherwise by length
+  const ob::OptimizationObjectivePtr& objective = pdef->getOptimizationObjective();
+  const auto is_better = [&objective](const og::PathGeometric& a, const og::PathGeometric& b) {
+    if (objective)
+      return objective->isCostBetterThan(a.cost(objective), b.cost(objective));
+    return a.length() < b.length();
+  };
+  const auto best_path = std::min_element(paths.begin(), paths.end(), is_better);
+  RCLCPP_DEBUG(LOGGER, "%s: Kept the best of %zu parallel simplifications", name_.c_str(), paths.size());
+  ompl_simple_setup_->getSolutionPath() = *best_path;
+}
+
 void ompl_interface::ModelBasedPlanningContext::interpolateSolution()
 {
   if (ompl_simple_setup_->haveSolutionPath())
   {
-    og::PathGeometric& pg = ompl_simple_setup_->getSolutionPath();
+    interpolatePath(ompl_simple_setup_->getSolutionPath());
+  }
+}
 
-    // Find the number of states that will be in the interpolated solution.
-    // This is what interpolate() does internally.
-    unsigned int eventual_states = 1;
-    std::vector<ompl::base::State*> states = pg.getStates();
-    for (size_t i = 0; i < states.size() - 1; ++i)
+void ompl_interface::ModelBasedPlanningContext::interpolatePath(og::PathGeometric& pg) const
+{
+  // Find the number of states that will be in the interpolated solution.
+  // This is what interpolate() does internally.
+  unsigned int eventual_states = 1;
+  std::vector<ompl::base::State*> states = pg.getStates();
+  for (size_t i = 0; i < states.size() - 1; ++i)
+  {
+    eventual_states += ompl_simple_setup_->getStateSpace()->validSegmentCount(states[i], states[i + 1]);
+  }
+
+  if (eventual_states < minimum_waypoint_count_)
+  {
+    // If that's not enough states, use the minimum amount instead.
+    pg.interpolate(minimum_waypoint_count_);
+  }
+  else
+  {
+    // Interpolate the path to have as the exact states that are checked when validating motions.
+    pg.interpolate();
+  }
+}
+
+void ompl_interface::ModelBasedPlanningContext::publishSolution(const og::PathGeometric& pg) const
+{
+  if (!solution_callback_)
+  {
+    return;
+  }
+
+  og::PathGeometric solution = pg;
+  if (interpolate_)
+  {
+    interpolatePath(solution);
+  }
+  robot_trajectory::RobotTrajectory trajectory(getRobotModel(), getGroupName());
+  convertPath(solution, trajectory);
+  solution_callback_(trajectory);
+}
+
+bool ompl_interface::ModelBasedPlanningContext::recallExperience()
+{
+  // states of the constrained state space can't be created from stored joint values
+  if (!use_experience_ || !experience_library_ || spec_.constrained_state_space_)
+  {
+    return false;
+  }
+
+  const ompl::time::point start = ompl::time::now();
+  ompl_simple_setup_->setup();
+  const ob::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  if (pdef->getStartStateCount() == 0)
+  {
+    return false;
+  }
+
+  const moveit::core::JointModelGroup* group = getJointModelGroup();
+  moveit::core::RobotState robot_state = complete_initial_robot_state_;
+  std::vector<double> start_values;
+  robot_state.copyJointGroupPositions(group, start_values);
+  const auto is_goal = [this, group, &robot_state](const std::vector<double>& waypoint) {
+    robot_state.setJointGroupPositions(group, waypoint);
+    robot_state.update();
+    return std::any_of(goal_constraints_.begin(), goal_constraints_.end(),
+                       [&robot_state](const kinematic_constraints::KinematicConstraintSetPtr& goal_constraint) {
+                         return goal_constraint->decide(robot_state).satisfied;
+                       });
+  };
+
+  const std::vector<std::shared_ptr<const ExperiencePath>> experiences =
+      experience_library_->findExperiences(group, start_values.data(), is_goal, MAX_RECALLED_EXPERIENCES,
+                                           experience_max_start_distance_);
+  ob::State* state = si->allocState();
+  for (const std::shared_ptr<const ExperiencePath>& experience : experiences)
+  {
+    // connect the start state of the request to the stored path
+    auto path = std::make_shared<og::PathGeometric>(si, pdef->getStartState(0));
+    for (const std::vector<double>& waypoint : *experience)
     {
-      eventual_states += ompl_simple_setup_->getStateSpace()->validSegmentCount(states[i], states[i + 1]);
+      robot_state.setJointGroupPositions(group, waypoint);
+      spec_.state_space_->copyToOMPLState(state, robot_state);
+      path->append(state);
     }
 
-    if (eventual_states < minimum_waypoint_count_)
+    // move waypoints that became invalid, e.g. because of new obstacles, to valid states nearby
+    path->checkAndRepair(EXPERIENCE_REPAIR_ATTEMPTS);
+    if (path->check())
     {
-      // If that's not enough states, use the minimum amount instead.
-      pg.interpolate(minimum_waypoint_count_);
+      si->freeState(state);
+      pdef->clearSolutionPaths();
+      pdef->addSolutionPath(path, false, 0.0, "experience");
+      solved_from_experience_ = true;
+      RCLCPP_INFO(LOGGER, "%s: Recalled a path with %zu waypoints from %zu experiences in %f seconds", name_.c_str(),
+                  experience->size(), experience_library_->size(group->getName()),
+                  ompl::time::seconds(ompl::time::now() - start));
+      return true;
     }
-    else
+  }
+  si->freeState(state);
+  RCLCPP_DEBUG(LOGGER, "%s: None of %zu similar experiences could be repaired, planning from scratch", name_.c_str(),
+               experiences.size());
+  return false;
+}
+
+void ompl_interface::ModelBasedPlanningContext::storeExperience() const
+{
+  if (!use_experience_ || !experience_library_ || solved_from_experience_ || spec_.constrained_state_space_ ||
+      !ompl_simple_setup_->haveExactSolutionPath())
+  {
+    return;
+  }
+
+  const og::PathGeometric& solution = ompl_simple_setup_->getSolutionPath();
+  moveit::core::RobotState robot_state = complete_initial_robot_state_;
+  ExperiencePath path(solution.getStateCount());
+  for (std::size_t i = 0; i < path.size(); ++i)
+  {
+    spec_.state_space_->copyToRobotState(robot_state, solution.getState(i));
+    robot_state.copyJointGroupPositions(getJointModelGroup(), path[i]);
+  }
+  experience_library_->addExperience(getJointModelGroup(), std::move(path));
+}
+
+void ompl_interface::ModelBasedPlanningContext::refineSolution(double timeout)
+{
+  if (!ompl_simple_setup_->haveSolutionPath())
+  {
+    return;
+  }
+
+  // A plain time limit, as a configured termination condition like ExactSolution would stop right away
+  const ompl::time::point start = ompl::time::now();
+  ob::PlannerTerminationCondition ptc = ob::timedPlannerTerminationCondition(timeout);
+  registerTerminationCondition(ptc);
+
+  og::PathGeometric best_path = ompl_simple_setup_->getSolutionPath();
+  double best_length = best_path.length();
+  std::mutex best_path_mutex;
+
+  // Every thread shortcuts a copy of the best path found so far. Shortcuts are chosen at random, so the threads try
+  // different ones and the shortest result wins. A thread gives up once several rounds in a row brought no improvement
+  const unsigned int max_rounds_without_improvement = 3;
+  const auto refine = [&] {
+    og::PathSimplifier simplifier(ompl_simple_setup_->getSpaceInformation());
+    unsigned int rounds_without_improvement = 0;
+    while (!ptc && rounds_without_improvement < max_rounds_without_improvement)
     {
-      // Interpolate the path to have as the exact states that are checked when validating motions.
-      pg.interpolate();
+      og::PathGeometric path = [&] {
+        std::lock_guard<std::mutex> lock(best_path_mutex);
+        return best_path;
+      }();
+      simplifier.shortcutPath(path);
+      simplifier.reduceVertices(path);
+
+      std::lock_guard<std::mutex> lock(best_path_mutex);
+      const double length = path.length();
+      if (length < best_length * (1.0 - std::numeric_limits<float>::epsilon()))
+      {
+        best_path = path;
+        best_length = length;
+        rounds_without_improvement = 0;
+        publishSolution(best_path);
+      }
+      else
+      {
+        ++rounds_without_improvement;
+      }
     }
+  };
+
+  std::vector<std::thread> refinement_threads;
+  for (unsigned int i = 1; i < std::max(1u, max_planning_threads_); ++i)
+  {
+    refinement_threads.emplace_back(refine);
   }
+  refine();
+  for (std::thread& refinement_thread : refinement_threads)
+  {
+    refinement_thread.join();
+  }
+
+  ompl_simple_setup_->getSolutionPath() = best_path;
+  last_simplify_time_ = ompl::time::seconds(ompl::time::now() - start);
+  unregisterTerminationCondition();
 }
 
 void ompl_interface::ModelBasedPlanningContext::convertPath(const ompl::geometric::PathGeometric& pg,
@@ -512,19 +882,47 @@ ompl::base::GoalPtr ompl_interface::ModelBasedPlanningContext::constructGoal()
 {
   // ******************* set up the goal representation, based on goal constraints
 
+  // number of threads sampling each goal, read here as the goal is constructed before the configuration is used.
+  // The threads call the kinematics solvers of the group concurrently, so more than one is only used if all of them
+  // support concurrent queries.
+  unsigned int goal_sampling_threads = 1;
+  auto it = spec_.config_.find("goal_sampling_threads");
+  if (it != spec_.config_.end())
+  {
+    goal_sampling_threads = boost::lexical_cast<unsigned int>(it->second);
+    if (goal_sampling_threads == 0)
+      goal_sampling_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (goal_sampling_threads > 1 && !supportsConcurrentIK(getJointModelGroup()))
+    {
+      RCLCPP_WARN(LOGGER,
+                  "A kinematics solver of group '%s' does not support concurrent queries, sampling goals on a single "
+                  "thread instead of %u",
+                  getGroupName().c_str(), goal_sampling_threads);
+      goal_sampling_threads = 1;
+    }
+  }
+
   std::vector<ob::GoalPtr> goals;
   for (kinematic_constraints::KinematicConstraintSetPtr& goal_constraint : goal_constraints_)
   {
     constraint_samplers::ConstraintSamplerPtr constraint_sampler;
+    std::vector<constraint_samplers::ConstraintSamplerPtr> additional_samplers;
     if (spec_.constraint_sampler_manager_)
     {
       constraint_sampler = spec_.constraint_sampler_manager_->selectSampler(getPlanningScene(), getGroupName(),
                                                                             goal_constraint->getAllConstraints());
+      // every producer thread needs its own sampler, as samplers keep their state between samples
+      for (unsigned int t = 1; constraint_sampler && t < goal_sampling_threads; ++t)
+      {
+        additional_samplers.push_back(spec_.constraint_sampler_manager_->selectSampler(
+            getPlanningScene(), getGroupName(), goal_constraint->getAllConstraints()));
+      }
     }
 
     if (constraint_sampler)
     {
-      ob::GoalPtr goal = std::make_shared<ConstrainedGoalSampler>(this, goal_constraint, constraint_sampler);
+      ob::GoalPtr goal =
+          std::make_shared<ConstrainedGoalSampler>(this, goal_constraint, constraint_sampler, additional_samplers);
       goals.push_back(goal);
     }
   }
@@ -642,6 +1040,7 @@ void ompl_interface::ModelBasedPlanningContext::clear()
   path_constraints_.reset();
   goal_constraints_.clear();
   getOMPLStateSpace()->setInterpolationFunction(InterpolationFunction());
+  getOMPLStateSpace()->trimStatePool();
 }
 
 bool ompl_interface::ModelBasedPlanningContext::setPathConstraints(const moveit_msgs::msg::Constraints& path_constraints,
@@ -754,6 +1153,18 @@ void ompl_interface::ModelBasedPlanningContext::postSolve()
   int iv = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getInvalidMotionCount();
   RCLCPP_DEBUG(LOGGER, "There were %d valid motions and %d invalid motions.", v, iv);
 
+  const auto checker =
+      std::dynamic_pointer_cast<const StateValidityChecker>(ompl_simple_setup_->getStateValidityChecker());
+  if (checker && checker->isStatisticsEnabled())
+  {
+    const StateValidityChecker::Statistics stats = checker->getStatistics();
+    RCLCPP_INFO(LOGGER,
+                "%s: Checked %zu states. Rejected by bounds: %zu, path constraints: %zu, feasibility: %zu, "
+                "collision: %zu. Broadphase reduced %zu collision checks to self-collision.",
+                name_.c_str(), stats.checked_states, stats.bounds_rejections, stats.path_constraints_rejections,
+                stats.feasibility_rejections, stats.collision_rejections, stats.broadphase_world_skips);
+  }
+
   // Debug OMPL setup and solution
   std::stringstream debug_out;
   ompl_simple_setup_->print(debug_out);
@@ -762,6 +1173,11 @@ void ompl_interface::ModelBasedPlanningContext::postSolve()
 
 bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::MotionPlanResponse& res)
 {
+  if (anytime_)
+  {
+    return solveAnytime(res);
+  }
+
   res.error_code = solve(request_.allowed_planning_time, request_.num_planning_attempts);
   if (res.error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
   {
@@ -771,6 +1187,7 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
       simplifySolution(request_.allowed_planning_time - ptime);
       ptime += getLastSimplifyTime();
     }
+    storeExperience();
 
     if (interpolate_)
     {
@@ -793,6 +1210,57 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
   }
 }
 
+bool ompl_interface::ModelBasedPlanningContext::solveAnytime(planning_interface::MotionPlanResponse& res)
+{
+  const ompl::time::point start = ompl::time::now();
+  preSolve();
+
+  solved_from_experience_ = false;
+  if (recallExperience())
+  {
+    res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+    last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+  }
+  else
+  {
+    // Optimizing planners would use up the whole planning time, so the planner stops at the first exact solution
+    RCLCPP_DEBUG(LOGGER, "%s: Solving the planning problem up to the first solution...", name_.c_str());
+    ob::PlannerTerminationCondition ptc = ob::plannerOrTerminationCondition(
+        constructPlannerTerminationCondition(request_.allowed_planning_time, start),
+        ob::exactSolnPlannerTerminationCondition(ompl_simple_setup_->getProblemDefinition()));
+    registerTerminationCondition(ptc);
+    ompl_simple_setup_->solve(ptc);
+    last_plan_time_ = ompl_simple_setup_->getLastPlanComputationTime();
+    unregisterTerminationCondition();
+    res.error_code.val = logPlannerStatus(ompl_simple_setup_);
+  }
+  postSolve();
+
+  if (res.error_code.val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+  {
+    RCLCPP_INFO(LOGGER, "Unable to solve the planning problem");
+    return false;
+  }
+
+  publishSolution(ompl_simple_setup_->getSolutionPath());
+  if (simplify_solutions_)
+  {
+    refineSolution(request_.allowed_planning_time - ompl::time::seconds(ompl::time::now() - start));
+  }
+  storeExperience();
+  if (interpolate_)
+  {
+    interpolateSolution();
+  }
+
+  RCLCPP_DEBUG(LOGGER, "%s: Returning refined solution with %lu states", getName().c_str(),
+               getOMPLSimpleSetup()->getSolutionPath().getStateCount());
+  res.trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(getRobotModel(), getGroupName());
+  getSolutionPath(*res.trajectory);
+  res.planning_time = ompl::time::seconds(ompl::time::now() - start);
+  return true;
+}
+
 bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::MotionPlanDetailedResponse& res)
 {
   moveit_msgs::msg::MoveItErrorCodes moveit_result =
@@ -819,6 +1287,7 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
       res.trajectory.back() = std::make_shared<robot_trajectory::RobotTrajectory>(getRobotModel(), getGroupName());
       getSolutionPath(*res.trajectory.back());
     }
+    storeExperience();
 
     if (interpolate_)
     {
@@ -852,7 +1321,13 @@ const moveit_msgs::msg::MoveItErrorCodes ompl_interface::ModelBasedPlanningConte
 
   moveit_msgs::msg::MoveItErrorCodes result;
   result.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
-  if (count <= 1 || multi_query_planning_enabled_)  // multi-query planners should always run in single instances
+  solved_from_experience_ = false;
+  if (recallExperience())
+  {
+    result.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+    last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+  }
+  else if (count <= 1 || multi_query_planning_enabled_)  // multi-query planners should always run in single instances
   {
     RCLCPP_DEBUG(LOGGER, "%s: Solving the planning problem once...", name_.c_str());
     ob::PlannerTerminationCondition ptc = constructPlannerTerminationCondition(timeout, start);
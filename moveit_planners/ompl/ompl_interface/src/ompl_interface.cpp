@@ -52,6 +52,7 @@ OMPLInterface::OMPLInterface(const moveit::core::RobotModelConstPtr& robot_model
   , constraint_sampler_manager_(std::make_shared<constraint_samplers::ConstraintSamplerManager>())
   , context_manager_(robot_model, constraint_sampler_manager_)
   , use_constraints_approximations_(true)
+  , experience_library_(std::make_shared<ExperienceLibrary>())
 {
   RCLCPP_DEBUG(LOGGER, "Initializing OMPL interface using ROS parameters");
   loadPlannerConfigurations();
@@ -67,6 +68,7 @@ OMPLInterface::OMPLInterface(const moveit::core::RobotModelConstPtr& robot_model
   , constraint_sampler_manager_(std::make_shared<constraint_samplers::ConstraintSamplerManager>())
   , context_manager_(robot_model, constraint_sampler_manager_)
   , use_constraints_approximations_(true)
+  , experience_library_(std::make_shared<ExperienceLibrary>())
 {
   RCLCPP_DEBUG(LOGGER, "Initializing OMPL interface using specified configuration");
   setPlannerConfigurations(pconfig);
@@ -108,6 +110,11 @@ OMPLInterface::getPlanningContext(const planning_scene::PlanningSceneConstPtr& p
 {
   ModelBasedPlanningContextPtr ctx =
       context_manager_.getPlanningContext(planning_scene, req, error_code, node_, use_constraints_approximations_);
+  if (ctx)
+  {
+    ctx->setSolutionCallback(solution_callback_);
+    ctx->setExperienceLibrary(experience_library_);
+  }
   return ctx;
 }
 
@@ -162,7 +169,13 @@ void OMPLInterface::loadPlannerConfigurations()
       { "projection_evaluator", rclcpp::ParameterType::PARAMETER_STRING },
       { "longest_valid_segment_fraction", rclcpp::ParameterType::PARAMETER_DOUBLE },
       { "enforce_joint_model_state_space", rclcpp::ParameterType::PARAMETER_BOOL },
-      { "enforce_constrained_state_space", rclcpp::ParameterType::PARAMETER_BOOL }
+      { "enforce_constrained_state_space", rclcpp::ParameterType::PARAMETER_BOOL },
+      { "anytime", rclcpp::ParameterType::PARAMETER_BOOL },
+      { "state_sampling", rclcpp::ParameterType::PARAMETER_STRING },
+      { "motion_validator", rclcpp::ParameterType::PARAMETER_STRING },
+      { "use_experience", rclcpp::ParameterType::PARAMETER_BOOL },
+      { "experience_max_start_distance", rclcpp::ParameterType::PARAMETER_DOUBLE },
+      { "simplification_threads", rclcpp::ParameterType::PARAMETER_INTEGER }
     };
 
     const std::string group_name_param = parameter_namespace_ + "." + group_name;
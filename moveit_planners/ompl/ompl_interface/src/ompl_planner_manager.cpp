@@ -37,13 +37,24 @@
 #include <moveit/ompl_interface/ompl_interface.h>
 #include <moveit/planning_interface/planning_interface.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/warehouse/experience_storage.h>
+#include <moveit_msgs/msg/display_trajectory.hpp>
 
 #include <ompl/util/Console.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace ompl_interface
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.ompl_planner_manager");
 static const rclcpp::Logger OMPL_LOGGER = rclcpp::get_logger("ompl");
+static const std::string ANYTIME_PATH_TOPIC = "display_anytime_path";
 
 class OMPLPlannerManager : public planning_interface::PlannerManager
 {
@@ -82,11 +93,41 @@ public:
     ompl::msg::useOutputHandler(output_handler_.get());
   }
 
+  ~OMPLPlannerManager() override
+  {
+    if (!experience_storage_thread_.joinable())
+      return;
+    // the library may outlive the manager in planning contexts, so stop queueing experiences before storing the rest
+    ompl_interface_->getExperienceLibrary()->setInsertionCallback(nullptr);
+    {
+      std::scoped_lock lock(experience_storage_lock_);
+      stop_experience_storage_ = true;
+    }
+    experience_storage_condition_.notify_all();
+    experience_storage_thread_.join();
+  }
+
   bool initialize(const moveit::core::RobotModelConstPtr& model, const rclcpp::Node::SharedPtr& node,
                   const std::string& parameter_namespace) override
   {
     ompl_interface_ = std::make_unique<OMPLInterface>(model, node, parameter_namespace);
     setPlannerConfigurations(ompl_interface_->getPlannerConfigurations());
+
+    // publish the first solution and every improvement of anytime planning requests
+    anytime_path_publisher_ = node->create_publisher<moveit_msgs::msg::DisplayTrajectory>(ANYTIME_PATH_TOPIC, 10);
+    ompl_interface_->setSolutionCallback([this, model_id = model->getName()](
+                                             const robot_trajectory::RobotTrajectory& trajectory) {
+      if (anytime_path_publisher_->get_subscription_count() == 0 || trajectory.empty())
+        return;
+      moveit_msgs::msg::DisplayTrajectory disp;
+      disp.model_id = model_id;
+      disp.trajectory.resize(1);
+      trajectory.getRobotTrajectoryMsg(disp.trajectory[0]);
+      moveit::core::robotStateToRobotStateMsg(trajectory.getFirstWayPoint(), disp.trajectory_start);
+      anytime_path_publisher_->publish(disp);
+    });
+
+    loadExperienceDatabase(model, node, parameter_namespace);
     return true;
   }
 
@@ -126,9 +167,150 @@ public:
   }
 
 private:
+  /* \brief Fill the experience library from the warehouse and store new experiences there, if the parameter
+   * experience_database.host is set */
+  void loadExperienceDatabase(const moveit::core::RobotModelConstPtr& model, const rclcpp::Node::SharedPtr& node,
+                              const std::string& parameter_namespace)
+  {
+    std::string host;
+    int port = 33829;
+    if (!node->get_parameter(parameter_namespace + ".experience_database.host", host) || host.empty())
+      return;
+    node->get_parameter(parameter_namespace + ".experience_database.port", port);
+
+    try
+    {
+      warehouse_ros::DatabaseConnection::Ptr conn = moveit_warehouse::loadDatabase(node);
+      conn->setParams(host, port);
+      if (!conn->connect())
+      {
+        RCLCPP_ERROR(LOGGER, "Failed to connect to the experience database on %s:%d", host.c_str(), port);
+        return;
+      }
+      experience_storage_ = std::make_shared<moveit_warehouse::ExperienceStorage>(conn);
+    }
+    catch (std::exception& ex)
+    {
+      RCLCPP_ERROR(LOGGER, "%s", ex.what());
+      return;
+    }
+
+    robot_name_ = model->getName();
+    const ExperienceLibraryPtr& library = ompl_interface_->getExperienceLibrary();
+    std::vector<moveit_warehouse::ExperienceWithMetadata> experiences;
+    experience_storage_->getExperiences(experiences, robot_name_);
+    std::size_t loaded = 0;
+    for (const moveit_warehouse::ExperienceWithMetadata& experience : experiences)
+    {
+      const std::string name = experience->lookupString(moveit_warehouse::ExperienceStorage::EXPERIENCE_ID_NAME);
+      const std::string group_name =
+          experience->lookupString(moveit_warehouse::ExperienceStorage::EXPERIENCE_GROUP_NAME);
+      const moveit::core::JointModelGroup* group = model->getJointModelGroup(group_name);
+      if (!group || experience->joint_trajectory.joint_names != group->getVariableNames())
+      {
+        RCLCPP_WARN(LOGGER, "Ignoring stored experience of group '%s', which does not match the robot model",
+                    group_name.c_str());
+        continue;
+      }
+      ExperiencePath path;
+      for (const trajectory_msgs::msg::JointTrajectoryPoint& point : experience->joint_trajectory.points)
+        path.push_back(point.positions);
+      if (std::shared_ptr<const ExperiencePath> added = library->addExperience(group, std::move(path), false))
+        stored_experiences_.push_back({ added, name, group_name });
+      ++loaded;
+    }
+    // stored paths with the same start and goal as later ones, or beyond the capacity of the library, are dropped
+    removeDroppedExperiences();
+    RCLCPP_INFO(LOGGER, "Loaded %zu experiences from the database on %s:%d", loaded, host.c_str(), port);
+
+    // store every newly planned path, without blocking the planning thread on the database
+    experience_storage_thread_ = std::thread([this] { storeExperiences(); });
+    library->setInsertionCallback(
+        [this](const moveit::core::JointModelGroup* group, const std::shared_ptr<const ExperiencePath>& path) {
+          {
+            std::scoped_lock lock(experience_storage_lock_);
+            pending_experiences_.emplace_back(group, path);
+          }
+          experience_storage_condition_.notify_one();
+        });
+  }
+
+  // Store the queued experiences until the manager is destroyed
+  void storeExperiences()
+  {
+    std::unique_lock<std::mutex> lock(experience_storage_lock_);
+    while (true)
+    {
+      experience_storage_condition_.wait(
+          lock, [this] { return stop_experience_storage_ || !pending_experiences_.empty(); });
+      if (pending_experiences_.empty())
+        return;
+      auto [group, path] = std::move(pending_experiences_.front());
+      pending_experiences_.pop_front();
+      lock.unlock();
+
+      moveit_msgs::msg::RobotTrajectory msg;
+      msg.joint_trajectory.joint_names = group->getVariableNames();
+      msg.joint_trajectory.points.resize(path->size());
+      for (std::size_t i = 0; i < path->size(); ++i)
+        msg.joint_trajectory.points[i].positions = (*path)[i];
+      const std::string name = std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "_" +
+                               std::to_string(++stored_experience_count_);
+      try
+      {
+        experience_storage_->addExperience(msg, name, robot_name_, group->getName());
+        stored_experiences_.push_back({ path, name, group->getName() });
+        path.reset();
+        // the new experience may have replaced stored ones
+        removeDroppedExperiences();
+      }
+      catch (std::exception& ex)
+      {
+        RCLCPP_ERROR(LOGGER, "Failed to store experience: %s", ex.what());
+      }
+
+      lock.lock();
+    }
+  }
+
+  // Remove the stored experiences from the database that the library replaced or dropped
+  void removeDroppedExperiences()
+  {
+    const auto dropped = [this](const StoredExperience& experience) {
+      if (!experience.path.expired())
+        return false;
+      experience_storage_->removeExperience(experience.name, robot_name_, experience.group);
+      return true;
+    };
+    stored_experiences_.erase(std::remove_if(stored_experiences_.begin(), stored_experiences_.end(), dropped),
+                              stored_experiences_.end());
+  }
+
   rclcpp::Node::SharedPtr node_;
   std::unique_ptr<OMPLInterface> ompl_interface_;
+  rclcpp::Publisher<moveit_msgs::msg::DisplayTrajectory>::SharedPtr anytime_path_publisher_;
   std::shared_ptr<ompl::msg::OutputHandler> output_handler_;
+  struct StoredExperience
+  {
+    std::weak_ptr<const ExperiencePath> path;
+    std::string name;
+    std::string group;
+  };
+
+  moveit_warehouse::ExperienceStoragePtr experience_storage_;
+  std::string robot_name_;
+
+  // the experiences in the database, only accessed by experience_storage_thread_ once it runs
+  std::vector<StoredExperience> stored_experiences_;
+  std::size_t stored_experience_count_ = 0;
+
+  // experiences added to the library that experience_storage_thread_ has not stored yet
+  std::deque<std::pair<const moveit::core::JointModelGroup*, std::shared_ptr<const ExperiencePath>>>
+      pending_experiences_;
+  bool stop_experience_storage_ = false;
+  std::mutex experience_storage_lock_;
+  std::condition_variable experience_storage_condition_;
+  std::thread experience_storage_thread_;
 };
 
 }  // namespace ompl_interface
@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/robot_model/revolute_joint_model.h>
 
 const std::string ompl_interface::JointModelStateSpace::PARAMETERIZATION_TYPE = "JointModel";
 
@@ -42,4 +43,47 @@ ompl_interface::JointModelStateSpace::JointModelStateSpace(const ModelBasedState
   : ModelBasedStateSpace(spec)
 {
   setName(getName() + "_" + PARAMETERIZATION_TYPE);
+
+  // groups made of single-variable joints only are by far the most common case (the arms used for planning),
+  // and their distance reduces to a weighted sum over the state values
+  const std::vector<const moveit::core::JointModel*>& joints = spec_.joint_model_group_->getActiveJointModels();
+  for (const moveit::core::JointModel* joint : joints)
+  {
+    if (joint->getType() != moveit::core::JointModel::REVOLUTE &&
+        joint->getType() != moveit::core::JointModel::PRISMATIC)
+    {
+      distance_indices_.clear();
+      distance_factors_.clear();
+      distance_continuous_.clear();
+      break;
+    }
+    distance_indices_.push_back(spec_.joint_model_group_->getVariableGroupIndex(joint->getName()));
+    distance_factors_.push_back(joint->getDistanceFactor());
+    distance_continuous_.push_back(joint->getType() == moveit::core::JointModel::REVOLUTE &&
+                                   static_cast<const moveit::core::RevoluteJointModel*>(joint)->isContinuous());
+  }
+}
+
+double ompl_interface::JointModelStateSpace::distance(const ompl::base::State* state1,
+                                                      const ompl::base::State* state2) const
+{
+  if (distance_function_ || distance_indices_.empty())
+    return ModelBasedStateSpace::distance(state1, state2);
+
+  // same terms and summation order as JointModelGroup::distance()
+  const double* values1 = state1->as<StateType>()->values;
+  const double* values2 = state2->as<StateType>()->values;
+  double d = 0.0;
+  for (std::size_t i = 0; i < distance_indices_.size(); ++i)
+  {
+    double dv = fabs(values1[distance_indices_[i]] - values2[distance_indices_[i]]);
+    if (distance_continuous_[i])
+    {
+      dv = fmod(dv, 2.0 * M_PI);
+      if (dv > M_PI)
+        dv = 2.0 * M_PI - dv;
+    }
+    d += distance_factors_[i] * dv;
+  }
+  return d;
 }
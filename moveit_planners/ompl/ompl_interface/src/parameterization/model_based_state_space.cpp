@@ -35,13 +35,116 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/constraint_samplers/halton_sequence.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <utility>
 
 namespace ompl_interface
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.model_based_state_space");
+
+// bounds on the number of states allocated at once by the state pool
+constexpr std::size_t MIN_STATE_SLAB_SIZE = 64;
+constexpr std::size_t MAX_STATE_SLAB_SIZE = 65536;
 }  // namespace ompl_interface
 
+/** \brief Thread-safe pool of states, allocated in slabs whose states share one contiguous array of values */
+class ompl_interface::ModelBasedStateSpace::StatePool
+{
+public:
+  explicit StatePool(std::size_t variable_count) : variable_count_(variable_count)
+  {
+  }
+
+  StateType* allocate()
+  {
+    std::scoped_lock lock(mutex_);
+    if (free_states_.empty())
+      addSlab();
+    StateType* state = free_states_.back();
+    free_states_.pop_back();
+    ++findSlab(state).in_use;
+    peak_in_use_ = std::max(peak_in_use_, ++in_use_);
+    return state;
+  }
+
+  void release(StateType* state)
+  {
+    // the next user expects a freshly constructed state
+    state->tag = -1;
+    state->flags = 0;
+    state->distance = 0.0;
+
+    std::scoped_lock lock(mutex_);
+    --findSlab(state).in_use;
+    --in_use_;
+    free_states_.push_back(state);
+  }
+
+  void trim()
+  {
+    std::scoped_lock lock(mutex_);
+    for (auto it = slabs_.begin(); it != slabs_.end();)
+      it = it->second.in_use == 0 ? slabs_.erase(it) : std::next(it);
+    free_states_.erase(std::remove_if(free_states_.begin(), free_states_.end(),
+                                      [this](const StateType* state) { return !ownsState(state); }),
+                       free_states_.end());
+    next_slab_size_ = std::clamp(peak_in_use_, MIN_STATE_SLAB_SIZE, MAX_STATE_SLAB_SIZE);
+  }
+
+  std::size_t capacity() const
+  {
+    std::scoped_lock lock(mutex_);
+    return in_use_ + free_states_.size();
+  }
+
+private:
+  struct Slab
+  {
+    std::unique_ptr<StateType[]> states;
+    std::unique_ptr<double[]> values;
+    std::size_t size;
+    std::size_t in_use;
+  };
+
+  void addSlab()
+  {
+    const std::size_t size = next_slab_size_;
+    next_slab_size_ = std::min(2 * next_slab_size_, MAX_STATE_SLAB_SIZE);
+
+    Slab slab{ std::make_unique<StateType[]>(size), std::make_unique<double[]>(size * variable_count_), size, 0 };
+    // hand out the states in memory order
+    for (std::size_t i = size; i-- > 0;)
+    {
+      slab.states[i].values = slab.values.get() + i * variable_count_;
+      free_states_.push_back(&slab.states[i]);
+    }
+    StateType* begin = slab.states.get();
+    slabs_.emplace(begin, std::move(slab));
+  }
+
+  Slab& findSlab(const StateType* state)
+  {
+    return std::prev(slabs_.upper_bound(state))->second;
+  }
+
+  bool ownsState(const StateType* state) const
+  {
+    auto it = slabs_.upper_bound(state);
+    return it != slabs_.begin() && state < std::prev(it)->first + std::prev(it)->second.size;
+  }
+
+  const std::size_t variable_count_;
+  mutable std::mutex mutex_;
+  std::map<const StateType*, Slab> slabs_;  // by address of the first state
+  std::vector<StateType*> free_states_;
+  std::size_t next_slab_size_ = MIN_STATE_SLAB_SIZE;
+  std::size_t in_use_ = 0;
+  std::size_t peak_in_use_ = 0;  // high-water mark of the states in use, to size the slab after trimming
+};
+
 ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(ModelBasedStateSpaceSpecification spec)
   : ompl::base::StateSpace(), spec_(std::move(spec))
 {
@@ -50,6 +153,7 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(ModelBasedStateSpaceS
   variable_count_ = spec_.joint_model_group_->getVariableCount();
   state_values_size_ = variable_count_ * sizeof(double);
   joint_model_vector_ = spec_.joint_model_group_->getActiveJointModels();
+  state_pool_ = std::make_unique<StatePool>(variable_count_);
 
   // make sure we have bounds for every joint stored within the spec (use default bounds if not specified)
   if (!spec_.joint_bounds_.empty() && spec_.joint_bounds_.size() != joint_model_vector_.size())
@@ -105,15 +209,22 @@ void ompl_interface::ModelBasedStateSpace::setTagSnapToSegment(double snap)
 
 ompl::base::State* ompl_interface::ModelBasedStateSpace::allocState() const
 {
-  auto* state = new StateType();
-  state->values = new double[variable_count_];
-  return state;
+  return state_pool_->allocate();
 }
 
 void ompl_interface::ModelBasedStateSpace::freeState(ompl::base::State* state) const
 {
-  delete[] state->as<StateType>()->values;
-  delete state->as<StateType>();
+  state_pool_->release(state->as<StateType>());
+}
+
+void ompl_interface::ModelBasedStateSpace::trimStatePool()
+{
+  state_pool_->trim();
+}
+
+std::size_t ompl_interface::ModelBasedStateSpace::getStatePoolCapacity() const
+{
+  return state_pool_->capacity();
 }
 
 void ompl_interface::ModelBasedStateSpace::copyState(ompl::base::State* destination,
@@ -270,14 +381,55 @@ ompl::base::StateSamplerPtr ompl_interface::ModelBasedStateSpace::allocDefaultSt
   {
   public:
     DefaultStateSampler(const ompl::base::StateSpace* space, const moveit::core::JointModelGroup* group,
-                        const moveit::core::JointBoundsVector* joint_bounds)
+                        const moveit::core::JointBoundsVector* joint_bounds, bool quasi_random)
       : ompl::base::StateSampler(space), joint_model_group_(group), joint_bounds_(joint_bounds)
     {
+      if (!quasi_random)
+        return;
+
+      // one coordinate of the Halton sequence per single-variable joint, the others are sampled pseudo-randomly
+      const std::vector<const moveit::core::JointModel*>& joints = group->getActiveJointModels();
+      for (std::size_t i = 0; i < joints.size(); ++i)
+      {
+        const JointIndex joint{ i, group->getVariableGroupIndex(joints[i]->getName()) };
+        (joints[i]->getVariableCount() == 1 ? quasi_random_joints_ : random_joints_).push_back(joint);
+      }
+      for (const moveit::core::JointModel* mimic : group->getMimicJointModels())
+      {
+        if (group->hasJointModel(mimic->getMimic()->getName()))
+        {
+          mimic_joints_.push_back({ group->getVariableGroupIndex(mimic->getMimic()->getName()),
+                                    group->getVariableGroupIndex(mimic->getName()), mimic->getMimicFactor(),
+                                    mimic->getMimicOffset() });
+        }
+      }
+      halton_sequence_ = constraint_samplers::HaltonSequence(quasi_random_joints_.size(), moveit_rng_);
+      halton_point_.resize(quasi_random_joints_.size());
     }
 
     void sampleUniform(ompl::base::State* state) override
     {
-      joint_model_group_->getVariableRandomPositions(moveit_rng_, state->as<StateType>()->values, *joint_bounds_);
+      double* values = state->as<StateType>()->values;
+      if (halton_point_.empty())
+        joint_model_group_->getVariableRandomPositions(moveit_rng_, values, *joint_bounds_);
+      else
+      {
+        halton_sequence_.next(halton_point_.data());
+        for (std::size_t i = 0; i < quasi_random_joints_.size(); ++i)
+        {
+          const moveit::core::VariableBounds& bounds = (*(*joint_bounds_)[quasi_random_joints_[i].joint])[0];
+          values[quasi_random_joints_[i].variable] =
+              bounds.min_position_ + halton_point_[i] * (bounds.max_position_ - bounds.min_position_);
+        }
+        const std::vector<const moveit::core::JointModel*>& joints = joint_model_group_->getActiveJointModels();
+        for (const JointIndex& joint : random_joints_)
+        {
+          joints[joint.joint]->getVariableRandomPositions(moveit_rng_, values + joint.variable,
+                                                          *(*joint_bounds_)[joint.joint]);
+        }
+        for (const MimicJoint& mimic : mimic_joints_)
+          values[mimic.dest] = values[mimic.src] * mimic.factor + mimic.offset;
+      }
       state->as<StateType>()->clearKnownInformation();
     }
 
@@ -294,13 +446,33 @@ ompl::base::StateSamplerPtr ompl_interface::ModelBasedStateSpace::allocDefaultSt
     }
 
   protected:
+    struct JointIndex
+    {
+      std::size_t joint;  // index among the active joints of the group
+      int variable;       // index of the first variable in the group state
+    };
+    struct MimicJoint
+    {
+      int src;
+      int dest;
+      double factor;
+      double offset;
+    };
+
     random_numbers::RandomNumberGenerator moveit_rng_;
     const moveit::core::JointModelGroup* joint_model_group_;
     const moveit::core::JointBoundsVector* joint_bounds_;
+
+    // only used when sampling quasi-randomly
+    constraint_samplers::HaltonSequence halton_sequence_;
+    std::vector<double> halton_point_;
+    std::vector<JointIndex> quasi_random_joints_;
+    std::vector<JointIndex> random_joints_;
+    std::vector<MimicJoint> mimic_joints_;
   };
 
   return ompl::base::StateSamplerPtr(static_cast<ompl::base::StateSampler*>(
-      new DefaultStateSampler(this, spec_.joint_model_group_, &spec_.joint_bounds_)));
+      new DefaultStateSampler(this, spec_.joint_model_group_, &spec_.joint_bounds_, quasi_random_sampling_)));
 }
 
 void ompl_interface::ModelBasedStateSpace::printSettings(std::ostream& out) const
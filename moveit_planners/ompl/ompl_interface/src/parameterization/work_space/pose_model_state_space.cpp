@@ -108,7 +108,9 @@ void ompl_interface::PoseModelStateSpace::freeState(ompl::base::State* state) co
   for (std::size_t i = 0; i < poses_.size(); ++i)
     poses_[i].state_space_->freeState(state->as<StateType>()->poses[i]);
   delete[] state->as<StateType>()->poses;
-  ModelBasedStateSpace::freeState(state);
+  // allocated by allocState() above rather than by the state pool of ModelBasedStateSpace
+  delete[] state->as<StateType>()->values;
+  delete state->as<StateType>();
 }
 
 void ompl_interface::PoseModelStateSpace::copyState(ompl::base::State* destination,
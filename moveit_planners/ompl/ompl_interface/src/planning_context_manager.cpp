@@ -37,8 +37,13 @@
 #include <moveit/ompl_interface/planning_context_manager.h>
 #include <moveit/robot_state/conversions.h>
 
+#include <fstream>
+#include <sstream>
 #include <utility>
 
+#include <geometric_shapes/shape_operations.h>
+#include <octomap/octomap.h>
+
 #include <ompl/geometric/planners/AnytimePathShortening.h>
 #include <ompl/geometric/planners/rrt/RRT.h>
 #include <ompl/geometric/planners/rrt/pRRT.h>
@@ -83,6 +88,21 @@ namespace ompl_interface
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.planning_context_manager");
 
+namespace
+{
+// 64-bit FNV-1a, which unlike std::hash is stable across runs and platforms, so fingerprints can be stored on disk
+std::uint64_t hashString(const std::string& str)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (const char c : str)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+}  // namespace
+
 struct PlanningContextManager::CachedContexts
 {
   std::map<std::pair<std::string, std::string>, std::vector<ModelBasedPlanningContextPtr> > contexts_;
@@ -99,7 +119,208 @@ MultiQueryPlannerAllocator::~MultiQueryPlannerAllocator()
     RCLCPP_INFO_STREAM(LOGGER, "Storing planner data. NumEdges: " << data.numEdges()
                                                                   << ", NumVertices: " << data.numVertices());
     storage_.store(data, entry.second.c_str());
+
+    // Remember which world the roadmap is valid in, so that only changed objects are rechecked on loading
+    auto validated_world = validated_worlds_.find(entry.first);
+    if (validated_world != validated_worlds_.end() &&
+        !storeWorldFingerprint(entry.second + ".world", validated_world->second))
+    {
+      RCLCPP_WARN(LOGGER, "Unable to store the world fingerprint of planner data to '%s.world'", entry.second.c_str());
+    }
+  }
+}
+
+bool MultiQueryPlannerAllocator::updatePlanningScene(const std::string& name,
+                                                     const planning_scene::PlanningSceneConstPtr& scene)
+{
+  const WorldFingerprint world = computeWorldFingerprint(*scene->getWorld());
+
+  std::lock_guard<std::mutex> slock(scenes_lock_);
+  planning_scenes_[name] = scene;
+  auto validated_world = validated_worlds_.find(name);
+  if (validated_world == validated_worlds_.end())
+  {
+    return false;
+  }
+  for (const auto& [id, hash] : world)
+  {
+    auto it = validated_world->second.find(id);
+    if (it == validated_world->second.end() || it->second != hash)
+    {
+      return true;
+    }
+  }
+  // At most objects were removed, which leaves all vertices and edges of the roadmap valid
+  validated_world->second = world;
+  return false;
+}
+
+MultiQueryPlannerAllocator::WorldFingerprint
+MultiQueryPlannerAllocator::computeWorldFingerprint(const collision_detection::World& world)
+{
+  WorldFingerprint fingerprint;
+  for (const auto& [id, object] : world)
+  {
+    std::ostringstream out;
+    out.precision(9);
+    for (std::size_t i = 0; i < object->shapes_.size(); ++i)
+    {
+      const shapes::Shape* shape = object->shapes_[i].get();
+      if (shape->type == shapes::OCTREE)
+      {
+        static_cast<const shapes::OcTree*>(shape)->octree->writeBinaryConst(out);
+      }
+      else
+      {
+        shapes::saveAsText(shape, out);
+      }
+      const Eigen::Matrix4d& pose = object->global_shape_poses_[i].matrix();
+      for (int row = 0; row < 3; ++row)
+      {
+        for (int col = 0; col < 4; ++col)
+        {
+          out << pose(row, col) << ' ';
+        }
+      }
+      out << '\n';
+    }
+    fingerprint[id] = hashString(out.str());
+  }
+  return fingerprint;
+}
+
+bool MultiQueryPlannerAllocator::loadWorldFingerprint(const std::string& file_path, WorldFingerprint& fingerprint)
+{
+  std::ifstream in(file_path);
+  if (!in.good())
+  {
+    return false;
+  }
+  fingerprint.clear();
+  std::uint64_t hash;
+  std::string id;
+  while (in >> hash && std::getline(in >> std::ws, id))
+  {
+    fingerprint[id] = hash;
   }
+  return true;
+}
+
+bool MultiQueryPlannerAllocator::storeWorldFingerprint(const std::string& file_path,
+                                                       const WorldFingerprint& fingerprint)
+{
+  std::ofstream out(file_path);
+  for (const auto& [id, hash] : fingerprint)
+  {
+    out << hash << ' ' << id << '\n';
+  }
+  return out.good();
+}
+
+void MultiQueryPlannerAllocator::revalidatePlannerData(ob::PlannerData& data, const std::string& name,
+                                                       const WorldFingerprint& validated_world,
+                                                       const ModelBasedPlanningContextSpecification& spec)
+{
+  planning_scene::PlanningSceneConstPtr scene;
+  {
+    std::lock_guard<std::mutex> slock(scenes_lock_);
+    auto it = planning_scenes_.find(name);
+    if (it == planning_scenes_.end())
+    {
+      return;
+    }
+    scene = it->second;
+  }
+  const WorldFingerprint world = computeWorldFingerprint(*scene->getWorld());
+
+  // Collision checks are done in a scene that only contains the objects added or moved since the last validation
+  planning_scene::PlanningScenePtr changed_scene = scene->diff();
+  std::size_t num_changed_objects = 0;
+  for (const auto& [id, hash] : world)
+  {
+    auto it = validated_world.find(id);
+    if (it != validated_world.end() && it->second == hash)
+    {
+      changed_scene->getWorldNonConst()->removeObject(id);
+    }
+    else
+    {
+      ++num_changed_objects;
+    }
+  }
+
+  if (num_changed_objects > 0 && spec.constrained_state_space_)
+  {
+    RCLCPP_WARN(LOGGER, "Planner data of '%s' can not be revalidated in a constrained state space", name.c_str());
+  }
+  else if (num_changed_objects > 0)
+  {
+    const ob::SpaceInformationPtr& si = data.getSpaceInformation();
+    const collision_detection::CollisionEnvConstPtr& collision_env = changed_scene->getCollisionEnv();
+    const collision_detection::AllowedCollisionMatrix& acm = changed_scene->getAllowedCollisionMatrix();
+    moveit::core::RobotState robot_state = scene->getCurrentState();
+    collision_detection::CollisionRequest request;
+    request.group_name = spec.state_space_->getJointModelGroup()->getName();
+    const auto is_colliding = [&](const ob::State* state) {
+      spec.state_space_->copyToRobotState(robot_state, state);
+      collision_detection::CollisionResult result;
+      collision_env->checkRobotCollision(request, result, robot_state, acm);
+      return result.collision;
+    };
+
+    // Removing a vertex only shifts the indices of the vertices after it
+    std::size_t num_removed_vertices = 0;
+    for (unsigned int i = data.numVertices(); i-- > 0;)
+    {
+      if (is_colliding(data.getVertex(i).getState()))
+      {
+        data.removeVertex(i);
+        ++num_removed_vertices;
+      }
+    }
+
+    std::vector<std::pair<unsigned int, unsigned int>> colliding_edges;
+    std::vector<unsigned int> edges;
+    ob::State* interpolated_state = si->allocState();
+    for (unsigned int i = 0; i < data.numVertices(); ++i)
+    {
+      const ob::State* from = data.getVertex(i).getState();
+      data.getEdges(i, edges);
+      for (const unsigned int j : edges)
+      {
+        // Undirected roadmaps store both directions of an edge, only check it once
+        if (j < i && data.edgeExists(j, i))
+        {
+          continue;
+        }
+        const ob::State* to = data.getVertex(j).getState();
+        const unsigned int num_segments = si->getStateSpace()->validSegmentCount(from, to);
+        for (unsigned int k = 1; k < num_segments; ++k)
+        {
+          si->getStateSpace()->interpolate(from, to, static_cast<double>(k) / num_segments, interpolated_state);
+          if (is_colliding(interpolated_state))
+          {
+            colliding_edges.emplace_back(i, j);
+            break;
+          }
+        }
+      }
+    }
+    si->freeState(interpolated_state);
+
+    for (const auto& [from, to] : colliding_edges)
+    {
+      data.removeEdge(from, to);
+      data.removeEdge(to, from);
+    }
+    RCLCPP_INFO(LOGGER,
+                "Revalidated planner data of '%s' against %zu added or moved world objects. "
+                "Removed %zu vertices and %zu edges.",
+                name.c_str(), num_changed_objects, num_removed_vertices, colliding_edges.size());
+  }
+
+  std::lock_guard<std::mutex> slock(scenes_lock_);
+  validated_worlds_[name] = world;
 }
 
 template <typename T>
@@ -127,6 +348,12 @@ ompl::base::PlannerPtr MultiQueryPlannerAllocator::allocatePlanner(const ob::Spa
       planner_map_it->second->getPlannerData(data);
       RCLCPP_INFO_STREAM(LOGGER, "Reusing planner data. NumEdges: " << data.numEdges()
                                                                     << ", NumVertices: " << data.numVertices());
+      WorldFingerprint validated_world;
+      {
+        std::lock_guard<std::mutex> slock(scenes_lock_);
+        validated_world = validated_worlds_[new_name];
+      }
+      revalidatePlannerData(data, new_name, validated_world, spec);
       planners_[planner_map_it->first] = std::shared_ptr<ob::Planner>{ allocatePersistentPlanner<T>(data) };
       return planners_[planner_map_it->first];
     }
@@ -136,6 +363,8 @@ ompl::base::PlannerPtr MultiQueryPlannerAllocator::allocatePlanner(const ob::Spa
     // 'store_planner_data'. The storage file path is set using the parameter 'planner_data_path'.
     // File read and write access are handled by the PlannerDataStorage class. If the file path is invalid
     // an error message is printed and the planner is constructed/destructed with default values.
+    // Next to the planner data, a fingerprint of the world objects it is valid in is stored as
+    // 'planner_data_path'.world. On loading, only vertices and edges near changed objects are rechecked.
     it = cfg.find("load_planner_data");
     bool load_planner_data = false;
     if (it != cfg.end())
@@ -157,6 +386,16 @@ ompl::base::PlannerPtr MultiQueryPlannerAllocator::allocatePlanner(const ob::Spa
       planner_data_path = it->second;
       cfg.erase(it);
     }
+    if (!load_planner_data)
+    {
+      // A new roadmap is built in the current scene
+      std::lock_guard<std::mutex> slock(scenes_lock_);
+      auto scene = planning_scenes_.find(new_name);
+      if (scene != planning_scenes_.end())
+      {
+        validated_worlds_[new_name] = computeWorldFingerprint(*scene->second->getWorld());
+      }
+    }
     // Store planner instance for multi-query use
     planners_[new_name] =
         allocatePlannerImpl<T>(si, new_name, spec, load_planner_data, store_planner_data, planner_data_path);
@@ -184,6 +423,13 @@ MultiQueryPlannerAllocator::allocatePlannerImpl(const ob::SpaceInformationPtr& s
     storage_.load(file_path.c_str(), data);
     RCLCPP_INFO_STREAM(LOGGER, "Loading planner data. NumEdges: " << data.numEdges()
                                                                   << ", NumVertices: " << data.numVertices());
+    // Without a fingerprint, the planner data is rechecked against all world objects
+    WorldFingerprint validated_world;
+    if (!loadWorldFingerprint(file_path + ".world", validated_world))
+    {
+      RCLCPP_WARN(LOGGER, "No world fingerprint found for planner data '%s'", file_path.c_str());
+    }
+    revalidatePlannerData(data, new_name, validated_world, spec);
     planner = std::shared_ptr<ob::Planner>{ allocatePersistentPlanner<T>(data) };
     if (!planner)
     {
@@ -568,6 +814,14 @@ ModelBasedPlanningContextPtr PlanningContextManager::getPlanningContext(
 
   if (context)
   {
+    // Multi-query planners are reallocated if their roadmap needs to be revalidated in the new scene
+    auto multi_query_it = pc->second.config.find("multi_query_planning_enabled");
+    if (multi_query_it != pc->second.config.end() && boost::lexical_cast<bool>(multi_query_it->second) &&
+        planner_allocator_.updatePlanningScene(context->getGroupName() + "/" + context->getName(), planning_scene))
+    {
+      context->resetConfiguration();
+    }
+
     context->clear();
 
     moveit::core::RobotStatePtr start_state = planning_scene->getCurrentStateUpdated(req.start_state);
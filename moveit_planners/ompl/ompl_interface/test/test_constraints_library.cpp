@@ -0,0 +1,242 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Tests that constraint approximations connect their milestones independently of the number of threads and
+   survive being saved and loaded */
+
+#include "load_test_robot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <moveit/ompl_interface/detail/constraints_library.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/planning_scene/planning_scene.h>
+
+#include <ompl/geometric/SimpleSetup.h>
+
+class TestConstraintsLibrary : public ompl_interface_testing::LoadTestRobot, public testing::Test
+{
+public:
+  TestConstraintsLibrary(const std::string& robot_name, const std::string& group_name)
+    : LoadTestRobot(robot_name, group_name)
+  {
+  }
+
+  void testParallelConnections()
+  {
+    SCOPED_TRACE("testParallelConnections");
+
+    // the same milestones are connected sequentially and in parallel
+    constexpr std::size_t MILESTONES = 200;
+    auto sequential = std::make_unique<ompl_interface::ConstraintApproximationStateStorage>(state_space_);
+    auto parallel = std::make_unique<ompl_interface::ConstraintApproximationStateStorage>(state_space_);
+    ompl::base::StateSamplerPtr sampler = state_space_->allocDefaultStateSampler();
+    ompl::base::ScopedState<> state(state_space_);
+    for (std::size_t i = 0; i < MILESTONES; ++i)
+    {
+      sampler->sampleUniform(state.get());
+      sequential->addState(state.get());
+      parallel->addState(state.get());
+    }
+
+    // a maximum edge length that rejects most connections, so milestones are often full before their candidates are
+    // used up and have to look for more
+    std::vector<double> distances;
+    for (std::size_t j = 0; j < MILESTONES; ++j)
+      for (std::size_t i = j + 1; i < MILESTONES; ++i)
+        distances.push_back(state_space_->distance(sequential->getState(i), sequential->getState(j)));
+    std::nth_element(distances.begin(), distances.begin() + distances.size() / 5, distances.end());
+
+    ompl_interface::ConstraintApproximationConstructionOptions options;
+    options.edges_per_sample = 2;
+    options.max_edge_length = distances[distances.size() / 5];
+    const kinematic_constraints::KinematicConstraintSet kset(robot_model_);
+
+    options.num_threads = 1;
+    const std::size_t sequential_edges = ompl_interface::connectConstraintApproximationMilestones(
+        planning_context_.get(), sequential.get(), MILESTONES, 0, kset, options);
+    options.num_threads = 4;
+    const std::size_t parallel_edges = ompl_interface::connectConstraintApproximationMilestones(
+        planning_context_.get(), parallel.get(), MILESTONES, 0, kset, options);
+    EXPECT_EQ(sequential_edges, parallel_edges);
+
+    // the greedy construction in the order of the milestone indices, which all motions are valid for
+    std::vector<std::vector<std::size_t>> expected(MILESTONES);
+    std::size_t expected_edges = 0;
+    for (std::size_t j = 0; j < MILESTONES; ++j)
+    {
+      for (std::size_t i = j + 1; i < MILESTONES && expected[j].size() < options.edges_per_sample; ++i)
+      {
+        if (expected[i].size() < options.edges_per_sample &&
+            state_space_->distance(sequential->getState(i), sequential->getState(j)) < options.max_edge_length)
+        {
+          expected[i].push_back(j);
+          expected[j].push_back(i);
+          ++expected_edges;
+        }
+      }
+    }
+    EXPECT_EQ(sequential_edges, expected_edges);
+
+    for (std::size_t j = 0; j < MILESTONES; ++j)
+    {
+      EXPECT_EQ(sequential->getMetadata(j).first, expected[j]) << "milestone " << j;
+      EXPECT_EQ(parallel->getMetadata(j).first, expected[j]) << "milestone " << j;
+    }
+  }
+
+  void testSaveLoad()
+  {
+    SCOPED_TRACE("testSaveLoad");
+
+    moveit_msgs::msg::Constraints constraints;
+    constraints.name = "first_joint_centered";
+    moveit_msgs::msg::JointConstraint joint_constraint;
+    joint_constraint.joint_name = joint_model_group_->getActiveJointModelNames().front();
+    joint_constraint.position = 0.0;
+    joint_constraint.tolerance_above = 1.0;
+    joint_constraint.tolerance_below = 1.0;
+    joint_constraint.weight = 1.0;
+    constraints.joint_constraints.push_back(joint_constraint);
+
+    ompl_interface::ConstraintApproximationConstructionOptions options;
+    options.state_space_parameterization = state_space_->getParameterizationType();
+    options.samples = 50;
+    options.edges_per_sample = 3;
+    options.explicit_motions = true;
+    options.explicit_points_resolution = 0.2;
+    options.max_explicit_points = 5;
+    options.num_threads = 2;
+
+    ompl_interface::ConstraintsLibrary library(planning_context_.get());
+    const ompl_interface::ConstraintApproximationConstructionResults result =
+        library.addConstraintApproximation(constraints, group_name_, planning_scene_, options);
+    ASSERT_TRUE(result.approx);
+    ASSERT_GT(result.milestones, 0u);
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() /
+        ("test_constraints_library_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    library.saveConstraintApproximations(path.string());
+
+    ompl_interface::ConstraintsLibrary loaded_library(planning_context_.get());
+    loaded_library.loadConstraintApproximations(path.string());
+    const ompl_interface::ConstraintApproximationPtr& loaded = loaded_library.getConstraintApproximation(constraints);
+    ASSERT_TRUE(loaded);
+    EXPECT_FALSE(loaded->isLoaded());
+    EXPECT_EQ(loaded->getGroup(), group_name_);
+    EXPECT_EQ(loaded->getStateSpaceParameterization(), options.state_space_parameterization);
+    EXPECT_TRUE(loaded->hasExplicitMotions());
+    EXPECT_EQ(loaded->getMilestoneCount(), result.milestones);
+
+    // the states, connections and explicit motions are restored
+    const auto* saved_states =
+        static_cast<const ompl_interface::ConstraintApproximationStateStorage*>(result.approx->getStateStorage().get());
+    const auto* loaded_states =
+        static_cast<const ompl_interface::ConstraintApproximationStateStorage*>(loaded->getStateStorage().get());
+    ASSERT_NE(loaded_states, nullptr);
+    EXPECT_TRUE(loaded->isLoaded());
+    ASSERT_EQ(loaded_states->size(), saved_states->size());
+    EXPECT_GT(saved_states->size(), result.milestones) << "no explicit motions were stored";
+    for (std::size_t i = 0; i < saved_states->size(); ++i)
+    {
+      EXPECT_TRUE(state_space_->equalStates(loaded_states->getState(i), saved_states->getState(i))) << "state " << i;
+      EXPECT_EQ(loaded_states->getMetadata(i).first, saved_states->getMetadata(i).first) << "state " << i;
+      EXPECT_EQ(loaded_states->getMetadata(i).second, saved_states->getMetadata(i).second) << "state " << i;
+    }
+
+    std::filesystem::remove_all(path);
+  }
+
+protected:
+  void SetUp() override
+  {
+    ompl_interface::ModelBasedStateSpaceSpecification space_spec(robot_model_, group_name_);
+    state_space_ = std::make_shared<ompl_interface::JointModelStateSpace>(space_spec);
+    state_space_->computeLocations();
+
+    planning_context_spec_.state_space_ = state_space_;
+    planning_context_spec_.ompl_simple_setup_ = std::make_shared<ompl::geometric::SimpleSetup>(state_space_);
+    planning_context_ =
+        std::make_shared<ompl_interface::ModelBasedPlanningContext>(group_name_, planning_context_spec_);
+
+    planning_scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model_);
+    planning_context_->setPlanningScene(planning_scene_);
+    moveit::core::RobotState start_state(robot_model_);
+    start_state.setToDefaultValues();
+    planning_context_->setCompleteInitialState(start_state);
+  }
+
+  ompl_interface::ModelBasedStateSpacePtr state_space_;
+  ompl_interface::ModelBasedPlanningContextSpecification planning_context_spec_;
+  ompl_interface::ModelBasedPlanningContextPtr planning_context_;
+  planning_scene::PlanningScenePtr planning_scene_;
+};
+
+/***************************************************************************
+ * Run all tests on the Panda robot
+ * ************************************************************************/
+class PandaConstraintsLibraryTest : public TestConstraintsLibrary
+{
+protected:
+  PandaConstraintsLibraryTest() : TestConstraintsLibrary("panda", "panda_arm")
+  {
+  }
+};
+
+TEST_F(PandaConstraintsLibraryTest, testParallelConnections)
+{
+  testParallelConnections();
+}
+
+TEST_F(PandaConstraintsLibraryTest, testSaveLoad)
+{
+  testSaveLoad();
+}
+
+/***************************************************************************
+ * MAIN
+ * ************************************************************************/
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Tests that the ExperienceLibrary recalls the stored paths closest to a start that reach the goal */
+
+#include "load_test_robot.h"
+#include <moveit/ompl_interface/detail/experience_library.h>
+#include <gtest/gtest.h>
+
+class TestExperienceLibrary : public ompl_interface_testing::LoadTestRobot, public testing::Test
+{
+public:
+  TestExperienceLibrary(const std::string& robot_name, const std::string& group_name)
+    : LoadTestRobot(robot_name, group_name)
+  {
+  }
+
+  std::vector<double> getRandomWaypoint() const
+  {
+    const Eigen::VectorXd q = getRandomState();
+    return std::vector<double>(q.data(), q.data() + q.size());
+  }
+
+  void testFindExperiences()
+  {
+    SCOPED_TRACE("testFindExperiences");
+
+    ompl_interface::ExperienceLibrary library(3);
+    std::size_t inserted = 0;
+    library.setInsertionCallback([&inserted](const moveit::core::JointModelGroup* /*group*/,
+                                             const std::shared_ptr<const ompl_interface::ExperiencePath>& /*path*/) {
+      ++inserted;
+    });
+
+    const std::vector<double> goal = getRandomWaypoint();
+    const std::vector<double> near_start = getRandomWaypoint();
+    std::vector<double> far_start = near_start;
+    for (double& value : far_start)
+      value += 0.2;
+    const auto is_goal = [&goal](const std::vector<double>& waypoint) { return waypoint == goal; };
+
+    // paths with a single waypoint are ignored
+    EXPECT_FALSE(library.addExperience(joint_model_group_, { goal }));
+    EXPECT_EQ(library.size(group_name_), 0u);
+
+    const std::weak_ptr<const ompl_interface::ExperiencePath> far_experience =
+        library.addExperience(joint_model_group_, { far_start, goal });
+    EXPECT_FALSE(far_experience.expired());
+    library.addExperience(joint_model_group_, { near_start, getRandomWaypoint(), goal });
+    library.addExperience(joint_model_group_, { near_start, getRandomWaypoint() }, false);
+    EXPECT_EQ(library.size(group_name_), 3u);
+    EXPECT_EQ(inserted, 2u);
+
+    // only paths reaching the goal are returned, the one with the closest start first
+    std::vector<std::shared_ptr<const ompl_interface::ExperiencePath>> found =
+        library.findExperiences(joint_model_group_, near_start.data(), is_goal, 5);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_EQ(found[0]->size(), 3u);
+    EXPECT_EQ(found[1]->front(), far_start);
+    EXPECT_EQ(library.findExperiences(joint_model_group_, near_start.data(), is_goal, 1).size(), 1u);
+
+    // paths starting too far away are not recalled
+    const double far_distance = joint_model_group_->distance(near_start.data(), far_start.data());
+    found = library.findExperiences(joint_model_group_, near_start.data(), is_goal, 5, 0.5 * far_distance);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0]->front(), near_start);
+
+    // a path with the same start and goal replaces the stored one
+    library.addExperience(joint_model_group_, { near_start, goal });
+    EXPECT_EQ(library.size(group_name_), 3u);
+    found = library.findExperiences(joint_model_group_, near_start.data(), is_goal, 1);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0]->size(), 2u);
+
+    // the oldest experience is dropped once the library is full, and destroyed as it is no longer used
+    found.clear();
+    library.addExperience(joint_model_group_, { getRandomWaypoint(), getRandomWaypoint() });
+    EXPECT_EQ(library.size(group_name_), 3u);
+    EXPECT_TRUE(far_experience.expired());
+    found = library.findExperiences(joint_model_group_, near_start.data(), is_goal, 5);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0]->front(), near_start);
+
+    library.clear();
+    EXPECT_EQ(library.size(group_name_), 0u);
+    EXPECT_TRUE(library.findExperiences(joint_model_group_, near_start.data(), is_goal, 5).empty());
+  }
+};
+
+/***************************************************************************
+ * Run all tests on the Panda robot
+ * ************************************************************************/
+class PandaExperienceLibraryTest : public TestExperienceLibrary
+{
+protected:
+  PandaExperienceLibraryTest() : TestExperienceLibrary("panda", "panda_arm")
+  {
+  }
+};
+
+TEST_F(PandaExperienceLibraryTest, testFindExperiences)
+{
+  testFindExperiences();
+}
+
+/***************************************************************************
+ * MAIN
+ * ************************************************************************/
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
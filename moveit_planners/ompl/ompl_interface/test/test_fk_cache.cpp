@@ -0,0 +1,140 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Tests that link positions recorded in the FKCache are only returned for the same state and thread */
+
+#include "load_test_robot.h"
+#include <moveit/ompl_interface/detail/fk_cache.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+class TestFKCache : public ompl_interface_testing::LoadTestRobot, public testing::Test
+{
+public:
+  TestFKCache(const std::string& robot_name, const std::string& group_name) : LoadTestRobot(robot_name, group_name)
+  {
+  }
+
+  void testLookup()
+  {
+    SCOPED_TRACE("testLookup");
+
+    const moveit::core::LinkModel* link = robot_model_->getLinkModel(ee_link_name_);
+    ompl_interface::FKCache cache(4);
+    cache.addLink(link);
+    EXPECT_FALSE(cache.empty());
+
+    const Eigen::VectorXd q = getRandomState();
+    robot_state_->update();
+    cache.insert(q.data(), q.size(), *robot_state_);
+
+    Eigen::Vector3d position;
+    ASSERT_TRUE(cache.lookup(q.data(), q.size(), link, position));
+    EXPECT_TRUE(position.isApprox(robot_state_->getGlobalLinkTransform(link).translation()));
+
+    // unregistered links and other joint values are not found
+    EXPECT_FALSE(cache.lookup(q.data(), q.size(), robot_model_->getLinkModel(base_link_name_), position));
+    Eigen::VectorXd q_other = q;
+    q_other[0] += 0.1;
+    EXPECT_FALSE(cache.lookup(q_other.data(), q_other.size(), link, position));
+
+    // entries of other threads are not visible
+    bool found_by_other_thread = true;
+    std::thread([&] {
+      Eigen::Vector3d other_position;
+      found_by_other_thread = cache.lookup(q.data(), q.size(), link, other_position);
+    }).join();
+    EXPECT_FALSE(found_by_other_thread);
+
+    // the oldest entry is overwritten once the ring is full
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      const Eigen::VectorXd q_next = getRandomState();
+      robot_state_->update();
+      cache.insert(q_next.data(), q_next.size(), *robot_state_);
+    }
+    EXPECT_TRUE(cache.lookup(q.data(), q.size(), link, position));
+    const Eigen::VectorXd q_last = getRandomState();
+    robot_state_->update();
+    cache.insert(q_last.data(), q_last.size(), *robot_state_);
+    EXPECT_FALSE(cache.lookup(q.data(), q.size(), link, position));
+
+    // clearing invalidates all entries
+    ASSERT_TRUE(cache.lookup(q_last.data(), q_last.size(), link, position));
+    cache.clear();
+    EXPECT_FALSE(cache.lookup(q_last.data(), q_last.size(), link, position));
+  }
+};
+
+/***************************************************************************
+ * Run all tests on the Panda robot
+ * ************************************************************************/
+class PandaFKCacheTest : public TestFKCache
+{
+protected:
+  PandaFKCacheTest() : TestFKCache("panda", "panda_arm")
+  {
+  }
+};
+
+TEST_F(PandaFKCacheTest, testLookup)
+{
+  testLookup();
+}
+
+/***************************************************************************
+ * Run all tests on the Fanuc robot
+ * ************************************************************************/
+class FanucFKCacheTest : public TestFKCache
+{
+protected:
+  FanucFKCacheTest() : TestFKCache("fanuc", "manipulator")
+  {
+  }
+};
+
+TEST_F(FanucFKCacheTest, testLookup)
+{
+  testLookup();
+}
+
+/***************************************************************************
+ * MAIN
+ * ************************************************************************/
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -293,6 +293,27 @@ protected:
     EXPECT_NE(jac.row(0).squaredNorm(), 0.0);
   }
 
+  /** \brief Alternate between joint values, so results memoized for the previous joint values must not be reused. **/
+  void testAlternatingEvaluation()
+  {
+    SCOPED_TRACE("testAlternatingEvaluation");
+
+    const Eigen::VectorXd q_1 = getRandomState();
+    const Eigen::VectorXd q_2 = getRandomState();
+    const Eigen::VectorXd error_1 = constraint_->calcError(q_1);
+    const Eigen::MatrixXd jac_1 = constraint_->calcErrorJacobian(q_1);
+
+    for (int i = 0; i < 3; ++i)
+    {
+      const Eigen::Vector3d expected_error_2 =
+          constraint_->getTargetOrientation().matrix().transpose() *
+          (fk(q_2, constraint_->getLinkName()).translation() - constraint_->getTargetPosition());
+      EXPECT_TRUE(constraint_->calcError(q_2).isApprox(expected_error_2));
+      EXPECT_TRUE(constraint_->calcError(q_1).isApprox(error_1));
+      EXPECT_TRUE(constraint_->calcErrorJacobian(q_1).isApprox(jac_1));
+    }
+  }
+
 protected:
   std::shared_ptr<ompl_interface::BaseConstraint> constraint_;
 };
@@ -324,6 +345,12 @@ TEST_F(PandaConstraintTest, PositionConstraintJacobian)
   testJacobian();
 }
 
+TEST_F(PandaConstraintTest, PositionConstraintAlternatingEvaluation)
+{
+  setPositionConstraints();
+  testAlternatingEvaluation();
+}
+
 TEST_F(PandaConstraintTest, PositionConstraintOMPLCheck)
 {
   setPositionConstraints();
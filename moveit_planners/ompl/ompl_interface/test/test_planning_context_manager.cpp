@@ -111,6 +111,137 @@ public:
     ASSERT_TRUE(pc->solve(res));
   }
 
+  void testWarmStart(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    SCOPED_TRACE("testWarmStart");
+
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" }, { "type", "geometric::RRTConnect" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::msg::MoveItErrorCodes error_code;
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    auto pc = pcm.getPlanningContext(planning_scene_, createRequest(start, goal), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_TRUE(pc->isConfigured(false));
+    EXPECT_FALSE(pc->isConfigured(true));
+
+    planning_interface::MotionPlanDetailedResponse res;
+    ASSERT_TRUE(pc->solve(res));
+
+    const ompl_interface::ModelBasedPlanningContext* first_context = pc.get();
+    const ompl::base::Planner* first_planner = pc->getOMPLSimpleSetup()->getPlanner().get();
+    ASSERT_NE(first_planner, nullptr);
+    pc.reset();
+
+    // the cached context is reused for the reverse query and keeps its planner
+    pc = pcm.getPlanningContext(planning_scene_, createRequest(goal, start), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_EQ(pc.get(), first_context);
+    EXPECT_EQ(pc->getOMPLSimpleSetup()->getPlanner().get(), first_planner);
+
+    planning_interface::MotionPlanDetailedResponse res2;
+    ASSERT_TRUE(pc->solve(res2));
+    ASSERT_FALSE(res2.trajectory.empty());
+    const auto& trajectory = res2.trajectory.back();
+    std::vector<double> first_positions;
+    trajectory->getFirstWayPoint().copyJointGroupPositions(joint_model_group_, first_positions);
+    ASSERT_EQ(first_positions.size(), goal.size());
+    for (std::size_t i = 0; i < goal.size(); ++i)
+    {
+      EXPECT_NEAR(first_positions[i], goal[i], 1e-6);
+    }
+
+    // changing the settings the context was configured with invalidates the warm start
+    pcm.setMaximumSolutionSegmentLength(0.05);
+    pc->setMaximumSolutionSegmentLength(0.05);
+    EXPECT_FALSE(pc->isConfigured(false));
+    pc.reset();
+
+    pc = pcm.getPlanningContext(planning_scene_, createRequest(start, goal), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_TRUE(pc->isConfigured(false));
+    planning_interface::MotionPlanDetailedResponse res3;
+    ASSERT_TRUE(pc->solve(res3));
+  }
+
+  void testParallelGoalSampling(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    SCOPED_TRACE("testParallelGoalSampling");
+
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" },
+                                { "type", "geometric::RRTConnect" },
+                                { "goal_sampling_threads", "4" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::msg::MoveItErrorCodes error_code;
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    // solve repeatedly so the goal producers are started and stopped along with the sampling thread
+    auto pc = pcm.getPlanningContext(planning_scene_, createRequest(start, goal), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    for (int i = 0; i < 3; ++i)
+    {
+      planning_interface::MotionPlanDetailedResponse res;
+      ASSERT_TRUE(pc->solve(res));
+      ASSERT_FALSE(res.trajectory.empty());
+      std::vector<double> last_positions;
+      res.trajectory.back()->getLastWayPoint().copyJointGroupPositions(joint_model_group_, last_positions);
+      ASSERT_EQ(last_positions.size(), goal.size());
+      for (std::size_t j = 0; j < goal.size(); ++j)
+        EXPECT_NEAR(last_positions[j], goal[j], 1e-3);
+    }
+  }
+
+  void testMultiQueryRevalidation(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    SCOPED_TRACE("testMultiQueryRevalidation");
+
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" },
+                                { "type", "geometric::PRM" },
+                                { "multi_query_planning_enabled", "1" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::msg::MoveItErrorCodes error_code;
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    auto pc = pcm.getPlanningContext(planning_scene_, createRequest(start, goal), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    planning_interface::MotionPlanDetailedResponse res;
+    ASSERT_TRUE(pc->solve(res));
+    pc.reset();
+
+    // adding an object invalidates the warm start, so the roadmap is revalidated in the new scene
+    planning_scene::PlanningScenePtr scene = planning_scene_->diff();
+    Eigen::Isometry3d box_pose = Eigen::Isometry3d::Identity();
+    box_pose.translation() = Eigen::Vector3d(0.0, 1.5, 0.3);
+    scene->getWorldNonConst()->addToObject("box", box_pose, std::make_shared<const shapes::Box>(0.2, 0.2, 0.2),
+                                           Eigen::Isometry3d::Identity());
+
+    pc = pcm.getPlanningContext(scene, createRequest(goal, start), error_code, node_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_TRUE(pc->isConfigured(false));
+    planning_interface::MotionPlanDetailedResponse res2;
+    ASSERT_TRUE(pc->solve(res2));
+    ASSERT_FALSE(res2.trajectory.empty());
+    EXPECT_TRUE(scene->isPathValid(*res2.trajectory.back(), group_name_));
+  }
+
   void testPathConstraints(const std::vector<double>& start, const std::vector<double>& goal)
   {
     SCOPED_TRACE("testPathConstraints");
@@ -321,6 +452,21 @@ TEST_F(PandaTestPlanningContext, testSimpleRequest)
   testSimpleRequest({ 0., -0.785, 0., -2.356, 0, 1.571, 0.785 }, { 0., -0.785, 0., -2.356, 0, 1.571, 0.685 });
 }
 
+TEST_F(PandaTestPlanningContext, testWarmStart)
+{
+  testWarmStart({ 0., -0.785, 0., -2.356, 0, 1.571, 0.785 }, { 0., -0.785, 0., -2.356, 0, 1.571, 0.685 });
+}
+
+TEST_F(PandaTestPlanningContext, testMultiQueryRevalidation)
+{
+  testMultiQueryRevalidation({ 0., -0.785, 0., -2.356, 0, 1.571, 0.785 }, { 0., -0.785, 0., -2.356, 0, 1.571, 0.685 });
+}
+
+TEST_F(PandaTestPlanningContext, testParallelGoalSampling)
+{
+  testParallelGoalSampling({ 0., -0.785, 0., -2.356, 0, 1.571, 0.785 }, { 0., -0.785, 0., -2.356, 0, 1.571, 0.685 });
+}
+
 // TODO(seng): This test is temporarily disabled as it is flaky since #1300. Re-enable when #2015 is resolved.
 // TEST_F(PandaTestPlanningContext, testPathConstraints)
 // {
@@ -343,6 +489,11 @@ TEST_F(FanucTestPlanningContext, testSimpleRequest)
   testSimpleRequest({ 0., 0., 0., 0., 0., 0. }, { 0., 0., 0., 0., 0., 0.1 });
 }
 
+TEST_F(FanucTestPlanningContext, testWarmStart)
+{
+  testWarmStart({ 0., 0., 0., 0., 0., 0. }, { 0., 0., 0., 0., 0., 0.1 });
+}
+
 TEST_F(FanucTestPlanningContext, testPathConstraints)
 {
   testPathConstraints({ 0., 0., 0., 0., 0., 0. }, { 0., 0., 0., 0., 0., 0.1 });
@@ -34,6 +34,7 @@
 
 /* Author: Ioan Sucan */
 
+#include <algorithm>
 #include <limits>
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
@@ -184,6 +185,89 @@ TEST_F(LoadPlanningModelsPr2, StateSpaceCopy)
   joint_model_state_space.freeState(state);
 }
 
+TEST_F(LoadPlanningModelsPr2, FlatDistance)
+{
+  // whole_body contains the planar base joint and keeps the per-joint distance
+  ompl_interface::ModelBasedStateSpaceSpecification whole_body_spec(robot_model_, "whole_body");
+  ompl_interface::JointModelStateSpace whole_body(whole_body_spec);
+  EXPECT_FALSE(whole_body.hasFlatDistance());
+
+  // the right arm includes continuous joints, whose distance wraps around
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::JointModelStateSpace ss(spec);
+  ss.setup();
+  ASSERT_TRUE(ss.hasFlatDistance());
+
+  const moveit::core::JointModelGroup* joint_model_group = robot_model_->getJointModelGroup("right_arm");
+  moveit::core::RobotState robot_state1(robot_model_);
+  moveit::core::RobotState robot_state2(robot_model_);
+  ompl::base::State* state1 = ss.allocState();
+  ompl::base::State* state2 = ss.allocState();
+  for (int i = 0; i < 100; ++i)
+  {
+    robot_state1.setToRandomPositions(joint_model_group);
+    robot_state2.setToRandomPositions(joint_model_group);
+    ss.copyToOMPLState(state1, robot_state1);
+    ss.copyToOMPLState(state2, robot_state2);
+    EXPECT_NEAR(ss.distance(state1, state2),
+                joint_model_group->distance(state1->as<ompl_interface::ModelBasedStateSpace::StateType>()->values,
+                                            state2->as<ompl_interface::ModelBasedStateSpace::StateType>()->values),
+                EPSILON);
+    EXPECT_NEAR(ss.distance(state1, state2), robot_state1.distance(robot_state2, joint_model_group), 1e-9);
+  }
+  ss.freeState(state1);
+  ss.freeState(state2);
+}
+
+TEST_F(LoadPlanningModelsPr2, StatePool)
+{
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::JointModelStateSpace ss(spec);
+  ss.setup();
+  const unsigned int variable_count = ss.getDimension();
+
+  std::vector<ompl::base::State*> states;
+  for (int i = 0; i < 1000; ++i)
+  {
+    states.push_back(ss.allocState());
+    auto* state = states.back()->as<ompl_interface::ModelBasedStateSpace::StateType>();
+    EXPECT_EQ(state->tag, -1);
+    EXPECT_EQ(state->flags, 0);
+    std::fill(state->values, state->values + variable_count, static_cast<double>(i));
+    state->tag = i;
+  }
+  EXPECT_GE(ss.getStatePoolCapacity(), states.size());
+
+  // the values of the states do not overlap
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    const auto* state = states[i]->as<ompl_interface::ModelBasedStateSpace::StateType>();
+    EXPECT_EQ(state->values[0], static_cast<double>(i));
+    EXPECT_EQ(state->values[variable_count - 1], static_cast<double>(i));
+  }
+
+  // freed states are reused and handed out like new ones
+  ompl::base::State* freed = states.back();
+  ss.freeState(freed);
+  states.back() = ss.allocState();
+  EXPECT_EQ(states.back(), freed);
+  EXPECT_EQ(states.back()->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag, -1);
+
+  // trimming keeps the memory of states in use
+  ss.trimStatePool();
+  EXPECT_GE(ss.getStatePoolCapacity(), states.size());
+
+  for (ompl::base::State* state : states)
+    ss.freeState(state);
+  ss.trimStatePool();
+  EXPECT_LT(ss.getStatePoolCapacity(), states.size());
+
+  // the pool is sized for the peak number of states when it grows again
+  ompl::base::State* state = ss.allocState();
+  EXPECT_GE(ss.getStatePoolCapacity(), states.size());
+  ss.freeState(state);
+}
+
 // Run the OMPL sanity checks on the diff drive model
 TEST(TestDiffDrive, TestStateSpace)
 {
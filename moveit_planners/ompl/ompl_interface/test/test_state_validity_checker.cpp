@@ -55,11 +55,13 @@
 
 #include <gtest/gtest.h>
 
+#include <moveit/ompl_interface/detail/continuous_motion_validator.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
 #include <moveit/planning_scene/planning_scene.h>
 
+#include <ompl/base/DiscreteMotionValidator.h>
 #include <ompl/geometric/SimpleSetup.h>
 
 /** \brief This flag sets the verbosity level for the state validity checker. **/
@@ -192,6 +194,132 @@ public:
     EXPECT_FALSE(checker->isValid(ompl_state.get()));
   }
 
+  /** This test checks the statistics of the configurable check order, using a collision-free state in joint limits **/
+  void testCheckOrderStatistics(const std::vector<double>& position_in_joint_limits)
+  {
+    SCOPED_TRACE("testCheckOrderStatistics");
+
+    robot_state_->setJointGroupPositions(joint_model_group_, position_in_joint_limits);
+
+    // path constraints that the given state does not satisfy
+    moveit_msgs::msg::Constraints path_constraints;
+    Eigen::Isometry3d ee_pose = robot_state_->getGlobalLinkTransform(ee_link_name_);
+    path_constraints.name = "test_position_constraints";
+    path_constraints.position_constraints.push_back(createPositionConstraint(
+        { ee_pose.translation().x(), ee_pose.translation().y(), ee_pose.translation().z() + 0.2 }, { 0.1, 0.1, 0.1 }));
+    moveit_msgs::msg::MoveItErrorCodes error_code_not_used;
+    ASSERT_TRUE(planning_context_->setPathConstraints(path_constraints, &error_code_not_used));
+
+    auto checker = std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get());
+    checker->setVerbose(VERBOSE);
+    checker->setStatisticsEnabled(true);
+    checker->setCheckOrder({ ompl_interface::StateValidityChecker::CheckStage::COLLISION,
+                             ompl_interface::StateValidityChecker::CheckStage::PATH_CONSTRAINTS });
+
+    ompl::base::ScopedState<> ompl_state(state_space_);
+    state_space_->copyToOMPLState(ompl_state.get(), *robot_state_);
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+
+    // the cached validity is used for the second check, so it is not counted
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+
+    ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->values[0] = std::numeric_limits<double>::max();
+    ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->clearKnownInformation();
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+
+    ompl_interface::StateValidityChecker::Statistics stats = checker->getStatistics();
+    EXPECT_EQ(stats.checked_states, 2u);
+    EXPECT_EQ(stats.bounds_rejections, 1u);
+    EXPECT_EQ(stats.path_constraints_rejections, 1u);
+    EXPECT_EQ(stats.collision_rejections, 0u);
+
+    checker->resetStatistics();
+    EXPECT_EQ(checker->getStatistics().checked_states, 0u);
+  }
+
+  /** This test checks that the broadphase only skips world collision checks for objects far from the robot **/
+  void testBroadphase(const std::vector<double>& position_in_joint_limits)
+  {
+    SCOPED_TRACE("testBroadphase");
+
+    robot_state_->setJointGroupPositions(joint_model_group_, position_in_joint_limits);
+    robot_state_->update();
+    ompl::base::ScopedState<> ompl_state(state_space_);
+    state_space_->copyToOMPLState(ompl_state.get(), *robot_state_);
+
+    Eigen::Isometry3d box_pose = Eigen::Isometry3d::Identity();
+    box_pose.translation() = Eigen::Vector3d(5.0, 5.0, 5.0);
+    planning_scene_->getWorldNonConst()->addToObject(
+        "box", box_pose, std::make_shared<const shapes::Box>(0.1, 0.1, 0.1), Eigen::Isometry3d::Identity());
+
+    auto checker = std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get());
+    checker->setVerbose(VERBOSE);
+    checker->setStatisticsEnabled(true);
+    checker->setBroadphaseEnabled(true);
+    ASSERT_TRUE(checker->isBroadphaseEnabled());
+    EXPECT_TRUE(checker->isValid(ompl_state.get()));
+    EXPECT_EQ(checker->getStatistics().broadphase_world_skips, 1u);
+
+    // a box around the end-effector requires the exact collision check, which rejects the state
+    planning_scene_->getWorldNonConst()->setObjectPose("box", robot_state_->getGlobalLinkTransform(ee_link_name_));
+    checker = std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get());
+    checker->setStatisticsEnabled(true);
+    checker->setBroadphaseEnabled(true);
+    ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->clearKnownInformation();
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+    EXPECT_EQ(checker->getStatistics().broadphase_world_skips, 0u);
+    EXPECT_EQ(checker->getStatistics().collision_rejections, 1u);
+
+    planning_scene_->getWorldNonConst()->removeObject("box");
+  }
+
+  /** This test checks that the continuous motion validator finds a collision between the states OMPL samples **/
+  void testContinuousMotionValidator(const std::vector<double>& position_in_joint_limits)
+  {
+    SCOPED_TRACE("testContinuousMotionValidator");
+
+    const ompl::base::SpaceInformationPtr& si = planning_context_->getOMPLSimpleSetup()->getSpaceInformation();
+    si->setStateValidityChecker(std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get()));
+    // only the end states of a motion are sampled
+    si->setStateValidityCheckingResolution(1.0);
+    si->setup();
+
+    // swing the arm around its first joint, through a box where the end-effector is halfway
+    robot_state_->setJointGroupPositions(joint_model_group_, position_in_joint_limits);
+    robot_state_->update();
+    planning_scene_->getWorldNonConst()->addToObject("box", robot_state_->getGlobalLinkTransform(ee_link_name_),
+                                                     std::make_shared<const shapes::Box>(0.1, 0.1, 0.1),
+                                                     Eigen::Isometry3d::Identity());
+    std::vector<double> positions = position_in_joint_limits;
+    ompl::base::ScopedState<> start(state_space_);
+    ompl::base::ScopedState<> end(state_space_);
+    positions[0] = position_in_joint_limits[0] - 1.0;
+    robot_state_->setJointGroupPositions(joint_model_group_, positions);
+    state_space_->copyToOMPLState(start.get(), *robot_state_);
+    positions[0] = position_in_joint_limits[0] + 1.0;
+    robot_state_->setJointGroupPositions(joint_model_group_, positions);
+    state_space_->copyToOMPLState(end.get(), *robot_state_);
+    ASSERT_TRUE(si->isValid(start.get()));
+    ASSERT_TRUE(si->isValid(end.get()));
+
+    ompl::base::DiscreteMotionValidator discrete_validator(si);
+    EXPECT_TRUE(discrete_validator.checkMotion(start.get(), end.get()));
+
+    ompl_interface::ContinuousMotionValidator validator(planning_context_.get());
+    ASSERT_TRUE(validator.isContinuous());
+    EXPECT_FALSE(validator.checkMotion(start.get(), end.get()));
+    EXPECT_TRUE(validator.checkMotion(start.get(), start.get()));
+
+    ompl::base::ScopedState<> last_valid(state_space_);
+    std::pair<ompl::base::State*, double> last_valid_pair(last_valid.get(), 1.0);
+    EXPECT_FALSE(validator.checkMotion(start.get(), end.get(), last_valid_pair));
+    EXPECT_LT(last_valid_pair.second, 0.5);
+    EXPECT_EQ(validator.getValidMotionCount(), 1u);
+    EXPECT_EQ(validator.getInvalidMotionCount(), 2u);
+
+    planning_scene_->getWorldNonConst()->removeObject("box");
+  }
+
 protected:
   void SetUp() override
   {
@@ -285,6 +413,21 @@ TEST_F(PandaValidity, testSelfCollision)
   testSelfCollision({ 2.31827, -0.169668, 2.5225, -2.98568, -0.36355, 0.808339, 0.0843406 });
 }
 
+TEST_F(PandaValidity, testCheckOrderStatistics)
+{
+  testCheckOrderStatistics({ 0., -0.785, 0., -2.356, 0., 1.571, 0.785 });
+}
+
+TEST_F(PandaValidity, testBroadphase)
+{
+  testBroadphase({ 0., -0.785, 0., -2.356, 0., 1.571, 0.785 });
+}
+
+TEST_F(PandaValidity, testContinuousMotionValidator)
+{
+  testContinuousMotionValidator({ 0., -0.785, 0., -2.356, 0., 1.571, 0.785 });
+}
+
 TEST_F(PandaValidity, testPathConstraints)
 {
   // use the panda "ready" state from the srdf config
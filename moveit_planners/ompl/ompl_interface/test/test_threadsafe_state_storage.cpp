@@ -42,6 +42,9 @@ The skeleton of this test was taken from test_state_validity_checker.cpp by Jero
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
 #include <gtest/gtest.h>
 
+#include <set>
+#include <thread>
+
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ompl_planning.test.test_thread_safe_storage");
 
 /** \brief Generic implementation of the tests that can be executed on different robots. **/
@@ -76,6 +79,64 @@ public:
     }
   }
 
+  /** This test checks that every thread gets its own state, which stays the same across calls and storages **/
+  void testThreadStates()
+  {
+    SCOPED_TRACE("testThreadStates");
+
+    // more storages than fit into the thread_local cache, to also exercise eviction
+    std::vector<std::unique_ptr<ompl_interface::TSStateStorage>> storages;
+    for (std::size_t i = 0; i < 6; ++i)
+    {
+      storages.push_back(std::make_unique<ompl_interface::TSStateStorage>(*robot_state_));
+    }
+
+    constexpr std::size_t NUM_THREADS = 4;
+    std::vector<std::vector<moveit::core::RobotState*>> thread_states(NUM_THREADS);
+    // not std::vector<bool>, whose elements can't be written concurrently
+    std::vector<int> thread_states_stable(NUM_THREADS, 1);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < NUM_THREADS; ++t)
+    {
+      threads.emplace_back([&, t] {
+        for (const auto& storage : storages)
+        {
+          thread_states[t].push_back(storage->getStateStorage());
+        }
+        for (std::size_t iteration = 0; iteration < 100; ++iteration)
+        {
+          for (std::size_t i = 0; i < storages.size(); ++i)
+          {
+            thread_states_stable[t] = thread_states_stable[t] && storages[i]->getStateStorage() == thread_states[t][i];
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    std::set<moveit::core::RobotState*> unique_states;
+    for (std::size_t t = 0; t < NUM_THREADS; ++t)
+    {
+      EXPECT_TRUE(thread_states_stable[t]) << "Thread " << t << " got different states from the same storage";
+      unique_states.insert(thread_states[t].begin(), thread_states[t].end());
+    }
+    EXPECT_EQ(unique_states.size(), NUM_THREADS * storages.size());
+
+    // a new storage (possibly at the same address) must not return a state of a destroyed one cached by this thread
+    storages.front()->getStateStorage();
+    storages.front().reset();
+    storages.front() = std::make_unique<ompl_interface::TSStateStorage>(*robot_state_);
+    moveit::core::RobotState* new_state = storages.front()->getStateStorage();
+    EXPECT_NE(new_state, nullptr);
+    for (auto const& joint_name : robot_state_->getVariableNames())
+    {
+      EXPECT_EQ(new_state->getVariablePosition(joint_name), robot_state_->getVariablePosition(joint_name));
+    }
+  }
+
 protected:
   void SetUp() override
   {
@@ -98,6 +159,11 @@ TEST_F(PandaTest, testConstruction)
   testReadback({ 0., -0.785, 0., -2.356, 0., 1.571, 0.785 });
 }
 
+TEST_F(PandaTest, testThreadStates)
+{
+  testThreadStates();
+}
+
 /***************************************************************************
  * Run all tests on the Fanuc robot
  * ************************************************************************/
@@ -0,0 +1,146 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Contention benchmark for the per-thread robot states of TSStateStorage */
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace
+{
+// Helper class to measure time within a scoped block and output the result
+class ScopedTimer
+{
+  const char* const msg_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedTimer(const char* msg = "") : msg_(msg), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms\n";
+  }
+};
+
+// The previous lookup scheme of TSStateStorage, as reference: a mutex-protected map indexed by thread id
+class LockedStateStorage
+{
+public:
+  LockedStateStorage(const moveit::core::RobotState& start_state) : start_state_(start_state)
+  {
+  }
+
+  moveit::core::RobotState* getStateStorage() const
+  {
+    std::unique_lock<std::mutex> slock(lock_);
+    auto it = thread_states_.find(std::this_thread::get_id());
+    if (it == thread_states_.end())
+    {
+      it = thread_states_.emplace(std::this_thread::get_id(), std::make_unique<moveit::core::RobotState>(start_state_))
+               .first;
+    }
+    return it->second.get();
+  }
+
+private:
+  moveit::core::RobotState start_state_;
+  mutable std::map<std::thread::id, std::unique_ptr<moveit::core::RobotState>> thread_states_;
+  mutable std::mutex lock_;
+};
+
+constexpr std::size_t NUM_LOOKUPS = 1000000;
+
+// Look up the state of every thread NUM_LOOKUPS times, alternating between two storages like a validity checker
+// and a constraint sampler would
+template <typename Storage>
+void lookupStates(const Storage& first, const Storage& second, std::size_t num_threads)
+{
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < num_threads; ++t)
+  {
+    threads.emplace_back([&] {
+      for (std::size_t i = 0; i < NUM_LOOKUPS; ++i)
+      {
+        moveit::core::RobotState* state = (i % 2 ? first : second).getStateStorage();
+        state->setVariablePosition(0, static_cast<double>(i % 100) * 0.01);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+}  // namespace
+
+TEST(TSStateStorageBenchmark, contention)
+{
+  auto robot_model = moveit::core::loadTestingRobotModel("panda");
+  ASSERT_TRUE(robot_model);
+  moveit::core::RobotState start_state(robot_model);
+  start_state.setToDefaultValues();
+
+  const std::size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+  for (std::size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+  {
+    std::cerr << num_threads << " threads, " << NUM_LOOKUPS << " lookups each:\n";
+    {
+      const LockedStateStorage first(start_state), second(start_state);
+      ScopedTimer t("  mutex-protected map: ");
+      lookupStates(first, second, num_threads);
+    }
+    {
+      const ompl_interface::TSStateStorage first(start_state), second(start_state);
+      ScopedTimer t("  TSStateStorage: ");
+      lookupStates(first, second, num_threads);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -38,6 +38,7 @@
 
 #include <memory>
 #include <functional>
+#include <optional>
 
 #include <moveit/planning_interface/planning_interface.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
@@ -113,6 +114,7 @@ private:
   using RobotState_OptRef = const std::optional<std::reference_wrapper<const moveit::core::RobotState>>;
   using RadiiCont = std::vector<double>;
   using GroupNamesCont = std::vector<std::string>;
+  using StartStateCont = std::vector<std::optional<moveit_msgs::msg::RobotState>>;
 
 private:
   /**
@@ -137,6 +139,21 @@ private:
                                         const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                                         const moveit_msgs::msg::MotionSequenceRequest& req_list) const;
 
+  /**
+   * @brief Solve all sequence items with a predicted start state concurrently.
+   *
+   * @param start_states Container of predicted start states, see
+   * predictStartStates().
+   *
+   * @return Container of successful responses, entries without prediction or
+   * with a failed planning attempt are empty.
+   */
+  std::vector<std::optional<planning_interface::MotionPlanResponse>>
+  solveSequenceItemsConcurrently(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                 const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                 const moveit_msgs::msg::MotionSequenceRequest& req_list,
+                                 const StartStateCont& start_states) const;
+
   /**
    * @return TRUE if the blending radii of specified trajectories overlap,
    * otherwise FALSE. The functions returns FALSE if both trajectories are from
@@ -160,6 +177,24 @@ private:
   static void setStartState(const MotionResponseCont& motion_plan_responses, const std::string& group_name,
                             moveit_msgs::msg::RobotState& start_state);
 
+  /**
+   * @return Container of start states which are known before planning.
+   *
+   * The start state of the first request of a group is the given one. The
+   * following requests of the group start at the joint goal of their
+   * predecessor. After a request without a complete joint goal, the start
+   * states of the group are unknown until the request has been solved.
+   */
+  static StartStateCont predictStartStates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                           const moveit_msgs::msg::MotionSequenceRequest& req_list);
+
+  /**
+   * @return True if both start states have the same joint names and
+   * (within a small epsilon) the same joint positions and velocities.
+   */
+  static bool isStartStateEqual(const moveit_msgs::msg::RobotState& state_A,
+                                const moveit_msgs::msg::RobotState& state_B);
+
   /**
    * @return Container of radii extracted from the specified request list.
    *
@@ -223,6 +258,10 @@ private:
 
   std::shared_ptr<cartesian_limits::ParamListener> param_listener_;
   cartesian_limits::Params params_;
+
+  //! Number of threads used for planning the sequence items, 0 uses all
+  //! hardware threads and 1 plans sequentially.
+  size_t num_threads_{ 1 };
 };
 
 inline void CommandListManager::checkLastBlendRadiusZero(const moveit_msgs::msg::MotionSequenceRequest& req_list)
@@ -44,6 +44,7 @@
 
 #include <pluginlib/class_loader.hpp>
 #include <memory>
+#include <mutex>
 
 #include <cartesian_limits_parameters.hpp>
 
@@ -118,6 +119,14 @@ public:
   void registerContextLoader(const pilz_industrial_motion_planner::PlanningContextLoaderPtr& planning_context_loader);
 
 private:
+  /**
+   * @brief Pass the limits to all context loaders again if the Cartesian limits parameters changed
+   *
+   * The loaders drop their cached trajectory generators when the limits are set.
+   * Has to be called with limits_mutex_ locked.
+   */
+  void updateCartesianLimits() const;
+
   /// Plugin loader
   std::unique_ptr<pluginlib::ClassLoader<PlanningContextLoader>> planner_context_loader_;
 
@@ -135,7 +144,10 @@ private:
 
   /// cartesian limit
   std::shared_ptr<cartesian_limits::ParamListener> param_listener_;
-  cartesian_limits::Params params_;
+  mutable cartesian_limits::Params params_;
+
+  /// Guards updating the limits of the context loaders against loading contexts
+  mutable std::mutex limits_mutex_;
 };
 
 MOVEIT_CLASS_FORWARD(CommandPlanner);
@@ -45,6 +45,7 @@
 #include <moveit/robot_state/conversions.h>
 
 #include <atomic>
+#include <memory>
 #include <thread>
 
 namespace pilz_industrial_motion_planner
@@ -63,7 +64,26 @@ public:
     , terminated_(false)
     , model_(model)
     , limits_(limits)
-    , generator_(model, limits_, group)
+    , generator_(std::make_shared<GeneratorT>(model, limits_, group))
+  {
+  }
+
+  /**
+   * @brief Create a context that uses an existing trajectory generator
+   *
+   * Constructing a generator validates the limits for the group, so generators
+   * are shared by all contexts of a group, see PlanningContextLoader::getGenerator().
+   * The generator has to be created for the same group, model and limits.
+   */
+  PlanningContextBase<GeneratorT>(const std::string& name, const std::string& group,
+                                  const moveit::core::RobotModelConstPtr& model,
+                                  const pilz_industrial_motion_planner::LimitsContainer& limits,
+                                  const std::shared_ptr<GeneratorT>& generator)
+    : planning_interface::PlanningContext(name, group)
+    , terminated_(false)
+    , model_(model)
+    , limits_(limits)
+    , generator_(generator)
   {
   }
 
@@ -113,7 +133,8 @@ public:
   pilz_industrial_motion_planner::LimitsContainer limits_;
 
 protected:
-  GeneratorT generator_;
+  /// Generator of the trajectories, possibly shared with other contexts of the same group
+  std::shared_ptr<GeneratorT> generator_;
 };
 
 template <typename GeneratorT>
@@ -128,7 +149,7 @@ bool pilz_industrial_motion_planner::PlanningContextBase<GeneratorT>::solve(plan
       moveit::core::robotStateToRobotStateMsg(getPlanningScene()->getCurrentState(), current_state);
       request_.start_state = current_state;
     }
-    bool result = generator_.generate(getPlanningScene(), request_, res);
+    bool result = generator_->generate(getPlanningScene(), request_, res);
     return result;
     // res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_MOTION_PLAN;
     // return false; // TODO
@@ -62,6 +62,14 @@ public:
     : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorCIRC>(name, group, model, limits)
   {
   }
+
+  PlanningContextCIRC(const std::string& name, const std::string& group, const moveit::core::RobotModelConstPtr& model,
+                      const pilz_industrial_motion_planner::LimitsContainer& limits,
+                      const std::shared_ptr<TrajectoryGeneratorCIRC>& generator)
+    : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorCIRC>(name, group, model, limits,
+                                                                                   generator)
+  {
+  }
 };
 
 }  // namespace pilz_industrial_motion_planner
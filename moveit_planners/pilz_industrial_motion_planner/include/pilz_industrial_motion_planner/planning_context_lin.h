@@ -60,6 +60,13 @@ public:
     : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorLIN>(name, group, model, limits)
   {
   }
+
+  PlanningContextLIN(const std::string& name, const std::string& group, const moveit::core::RobotModelConstPtr& model,
+                     const pilz_industrial_motion_planner::LimitsContainer& limits,
+                     const std::shared_ptr<TrajectoryGeneratorLIN>& generator)
+    : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorLIN>(name, group, model, limits, generator)
+  {
+  }
 };
 
 }  // namespace pilz_industrial_motion_planner
@@ -35,8 +35,11 @@
 #pragma once
 
 #include <pilz_industrial_motion_planner/limits_container.h>
+#include <pilz_industrial_motion_planner/trajectory_generator.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <moveit/planning_interface/planning_interface.h>
@@ -97,6 +100,19 @@ protected:
   bool loadContext(planning_interface::PlanningContextPtr& planning_context, const std::string& name,
                    const std::string& group) const;
 
+  /**
+   * @brief Return the trajectory generator of type GeneratorT for a planning group
+   *
+   * Constructing a generator validates the limits of the group, which takes
+   * longer than planning a short PTP motion. The generator is therefore created
+   * on first use and shared by all later contexts of the group, until the
+   * model or the limits are set again.
+   * @param group name of the planning group
+   * @throw the exceptions of the GeneratorT constructor
+   */
+  template <typename GeneratorT>
+  std::shared_ptr<GeneratorT> getGenerator(const std::string& group) const;
+
 protected:
   /// Name of the algorithm
   std::string alg_;
@@ -112,6 +128,11 @@ protected:
 
   /// The robot model
   moveit::core::RobotModelConstPtr model_;
+
+private:
+  /// Cached trajectory generators by planning group, see getGenerator()
+  mutable std::map<std::string, std::shared_ptr<TrajectoryGenerator>> generators_;
+  mutable std::mutex generators_mutex_;
 };
 
 typedef std::shared_ptr<PlanningContextLoader> PlanningContextLoaderPtr;
@@ -141,4 +162,19 @@ bool PlanningContextLoader::loadContext(planning_interface::PlanningContextPtr&
   }
 }
 
+template <typename GeneratorT>
+std::shared_ptr<GeneratorT> PlanningContextLoader::getGenerator(const std::string& group) const
+{
+  std::lock_guard<std::mutex> lock(generators_mutex_);
+  std::shared_ptr<TrajectoryGenerator>& generator = generators_[group];
+  if (!generator)
+  {
+    // nothing is cached if the constructor throws
+    std::shared_ptr<GeneratorT> new_generator = std::make_shared<GeneratorT>(model_, limits_, group);
+    generator = new_generator;
+    return new_generator;
+  }
+  return std::static_pointer_cast<GeneratorT>(generator);
+}
+
 }  // namespace pilz_industrial_motion_planner
@@ -62,6 +62,13 @@ public:
     : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorPTP>(name, group, model, limits)
   {
   }
+
+  PlanningContextPTP(const std::string& name, const std::string& group, const moveit::core::RobotModelConstPtr& model,
+                     const pilz_industrial_motion_planner::LimitsContainer& limits,
+                     const std::shared_ptr<TrajectoryGeneratorPTP>& generator)
+    : pilz_industrial_motion_planner::PlanningContextBase<TrajectoryGeneratorPTP>(name, group, model, limits, generator)
+  {
+  }
 };
 
 }  // namespace pilz_industrial_motion_planner
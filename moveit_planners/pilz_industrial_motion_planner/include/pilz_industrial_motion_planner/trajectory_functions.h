@@ -73,6 +73,50 @@ bool computePoseIK(const planning_scene::PlanningSceneConstPtr& scene, const std
                    const std::map<std::string, double>& seed, std::map<std::string, double>& solution,
                    bool check_self_collision = true, const double timeout = 0.0);
 
+/**
+ * @brief compute the inverse kinematics of a pose that is close to the seed
+ * by a few Jacobian-based Newton steps, also check robot self collision
+ *
+ * This is a fast path for densely sampled Cartesian paths where the previous
+ * solution is an excellent seed. No IK solver is called, so the function fails
+ * quickly if the pose is not reached, the joint bounds are violated or the
+ * Jacobian is singular. Callers are expected to fall back to computePoseIK().
+ * @param scene: planning scene
+ * @param group_name: name of planning group
+ * @param link_name: name of target link
+ * @param pose: target pose in model frame
+ * @param seed: seed state, usually the solution of the previous sample
+ * @param solution: solution of IK
+ * @param check_self_collision: true to enable self collision checking
+ * @return true if succeed
+ */
+bool computePoseIKFromSeed(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                           const std::string& link_name, const Eigen::Isometry3d& pose,
+                           const std::map<std::string, double>& seed, std::map<std::string, double>& solution,
+                           bool check_self_collision = true);
+
+/**
+ * @brief compute the inverse kinematics of a sequence of densely sampled poses,
+ * also check robot self collision
+ *
+ * The poses are solved in order and one robot state is reused for all of them.
+ * Each pose is first approached by the Newton steps of computePoseIKFromSeed(),
+ * warm-started from the previous solution extrapolated by the joint step between
+ * the two previous solutions. Poses not reached this way are solved by computePoseIK().
+ * @param scene: planning scene
+ * @param group_name: name of planning group
+ * @param link_name: name of target link
+ * @param poses: target poses in model frame
+ * @param seed: joint positions before the first pose
+ * @param solutions: IK solution of each pose, on failure only of the poses before the failing one
+ * @param check_self_collision: true to enable self collision checking
+ * @return true if all poses are solved
+ */
+bool computePoseIKSequence(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                           const std::string& link_name, const std::vector<Eigen::Isometry3d>& poses,
+                           const std::map<std::string, double>& seed,
+                           std::vector<std::map<std::string, double>>& solutions, bool check_self_collision = true);
+
 /**
  * @brief compute the pose of a link at give robot state
  * @param robot_model: kinematic model of the robot
@@ -199,6 +243,29 @@ bool linearSearchIntersectionPoint(const std::string& link_name, const Eigen::Ve
                                    const double& r, const robot_trajectory::RobotTrajectoryPtr& traj, bool inverseOrder,
                                    std::size_t& index);
 
+/**
+ * @brief Performs a binary search for the intersection point of the trajectory
+ * with the blending radius.
+ *
+ * Unlike linearSearchIntersectionPoint() the search starts at the blending
+ * sphere center with exponentially growing steps and bisects the first step
+ * leaving the sphere, so only O(log n) waypoints of the n waypoints inside the
+ * sphere are evaluated. The distance to the center is assumed to grow
+ * monotonically with the distance in samples from the center, which holds for
+ * the segments of a motion sequence as long as the sphere does not contain a
+ * turning point of the trajectory. The index has the same meaning as in
+ * linearSearchIntersectionPoint().
+ * @param center_position Center of blending sphere.
+ * @param r Radius of blending sphere.
+ * @param traj The trajectory.
+ * @param inverseOrder TRUE: Farthest element from blending sphere center is
+ * located at the smallest index of trajectroy.
+ * @param index The intersection index which has to be determined.
+ */
+bool binarySearchIntersectionPoint(const std::string& link_name, const Eigen::Vector3d& center_position,
+                                   const double& r, const robot_trajectory::RobotTrajectoryPtr& traj, bool inverseOrder,
+                                   std::size_t& index);
+
 bool intersectionFound(const Eigen::Vector3d& p_center, const Eigen::Vector3d& p_current, const Eigen::Vector3d& p_next,
                        const double& r);
 
@@ -36,6 +36,7 @@
 
 #include <kdl/velocityprofile.hpp>
 #include <iostream>
+#include <vector>
 
 namespace pilz_industrial_motion_planner
 {
@@ -168,6 +169,21 @@ public:
    * @return
    */
   double Acc(double time) const override;
+  /**
+   * @brief Get position, velocity and acceleration at several times in one pass
+   *
+   * Equivalent to calling Pos(), Vel() and Acc() for each time, but without
+   * virtual calls. Sample i is written to index i * stride of each output
+   * buffer, so that the samples of several axes can be interleaved in one
+   * contiguous buffer.
+   * @param times: sample times
+   * @param positions: output buffer for positions
+   * @param velocities: output buffer for velocities
+   * @param accelerations: output buffer for accelerations
+   * @param stride: distance between two consecutive samples in the buffers
+   */
+  void sampleProfile(const std::vector<double>& times, double* positions, double* velocities, double* accelerations,
+                     std::size_t stride = 1) const;
   /**
    * @brief Write basic information
    * @param os
@@ -36,9 +36,11 @@
 
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <sstream>
+#include <thread>
 
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/robot_state/conversions.h>
@@ -52,6 +54,9 @@
 namespace pilz_industrial_motion_planner
 {
 static const std::string PARAM_NAMESPACE_LIMITS = "robot_description_planning";
+static const std::string PARAM_SEQUENCE_NUM_THREADS = "pilz_industrial_motion_planner.sequence_num_threads";
+// Tolerance for accepting a predicted start state as the actual end state of the previous trajectory
+static constexpr double START_STATE_PREDICTION_EPSILON = 1e-9;
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.pilz_industrial_motion_planner.command_list_manager");
 
 CommandListManager::CommandListManager(const rclcpp::Node::SharedPtr& node,
@@ -72,6 +77,15 @@ CommandListManager::CommandListManager(const rclcpp::Node::SharedPtr& node,
   limits.setJointLimits(aggregated_limit_active_joints);
   limits.setCartesianLimits(params_);
 
+  // Sequence items are planned sequentially unless configured otherwise
+  if (node_->has_parameter(PARAM_SEQUENCE_NUM_THREADS))
+  {
+    int num_threads = 1;
+    node_->get_parameter(PARAM_SEQUENCE_NUM_THREADS, num_threads);
+    num_threads_ = num_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) :
+                                      static_cast<size_t>(std::max(1, num_threads));
+  }
+
   plan_comp_builder_.setModel(model);
   plan_comp_builder_.setBlender(std::unique_ptr<pilz_industrial_motion_planner::TrajectoryBlender>(
       new pilz_industrial_motion_planner::TrajectoryBlenderTransitionWindow(limits)));
@@ -230,6 +244,17 @@ CommandListManager::solveSequenceItems(const planning_scene::PlanningSceneConstP
                                        const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                                        const moveit_msgs::msg::MotionSequenceRequest& req_list) const
 {
+  // Items with a start state that is known up front are planned concurrently first. The sequential pass
+  // below only replans the items whose actual start state differs from the predicted one.
+  StartStateCont predicted_start_states(req_list.items.size());
+  std::vector<std::optional<planning_interface::MotionPlanResponse>> predicted_responses(req_list.items.size());
+  if (num_threads_ > 1 && req_list.items.size() > 1)
+  {
+    predicted_start_states = predictStartStates(planning_scene, req_list);
+    predicted_responses =
+        solveSequenceItemsConcurrently(planning_scene, planning_pipeline, req_list, predicted_start_states);
+  }
+
   MotionResponseCont motion_plan_responses;
   size_t curr_req_index{ 0 };
   const size_t num_req{ req_list.items.size() };
@@ -238,6 +263,15 @@ CommandListManager::solveSequenceItems(const planning_scene::PlanningSceneConstP
     planning_interface::MotionPlanRequest req{ seq_item.req };
     setStartState(motion_plan_responses, req.group_name, req.start_state);
 
+    const auto& predicted_start_state = predicted_start_states.at(curr_req_index);
+    auto& predicted_response = predicted_responses.at(curr_req_index);
+    if (predicted_response && isStartStateEqual(*predicted_start_state, req.start_state))
+    {
+      motion_plan_responses.emplace_back(std::move(*predicted_response));
+      RCLCPP_DEBUG_STREAM(LOGGER, "Solved [" << ++curr_req_index << '/' << num_req << "] concurrently");
+      continue;
+    }
+
     planning_interface::MotionPlanResponse res;
     planning_pipeline->generatePlan(planning_scene, req, res);
     if (res.error_code.val != res.error_code.SUCCESS)
@@ -252,6 +286,140 @@ CommandListManager::solveSequenceItems(const planning_scene::PlanningSceneConstP
   return motion_plan_responses;
 }
 
+std::vector<std::optional<planning_interface::MotionPlanResponse>>
+CommandListManager::solveSequenceItemsConcurrently(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                   const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                                   const moveit_msgs::msg::MotionSequenceRequest& req_list,
+                                                   const StartStateCont& start_states) const
+{
+  std::vector<std::optional<planning_interface::MotionPlanResponse>> responses(req_list.items.size());
+  std::atomic<size_t> next_index{ 0 };
+  const auto solve_items = [&]() {
+    for (size_t i = next_index++; i < req_list.items.size(); i = next_index++)
+    {
+      if (!start_states.at(i))
+      {
+        continue;
+      }
+      planning_interface::MotionPlanRequest req{ req_list.items.at(i).req };
+      req.start_state = *start_states.at(i);
+      planning_interface::MotionPlanResponse res;
+      try
+      {
+        planning_pipeline->generatePlan(planning_scene, req, res);
+      }
+      catch (const std::exception& ex)
+      {
+        // The sequential pass replans this item and reports the error
+        RCLCPP_DEBUG_STREAM(LOGGER, "Concurrent planning of request [" << i << "] failed: " << ex.what());
+        continue;
+      }
+      if (res.error_code.val == res.error_code.SUCCESS)
+      {
+        responses.at(i) = std::move(res);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const size_t num_threads{ std::min(num_threads_, req_list.items.size()) };
+  for (size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back(solve_items);
+  }
+  solve_items();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  return responses;
+}
+
+CommandListManager::StartStateCont
+CommandListManager::predictStartStates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                       const moveit_msgs::msg::MotionSequenceRequest& req_list)
+{
+  StartStateCont start_states(req_list.items.size());
+  // Predicted end state of the last request of each group, empty if it is not known up front
+  std::map<std::string, std::optional<moveit::core::RobotState>> end_states;
+  for (size_t i = 0; i < req_list.items.size(); ++i)
+  {
+    const planning_interface::MotionPlanRequest& req{ req_list.items.at(i).req };
+    auto end_state_it = end_states.find(req.group_name);
+    if (end_state_it == end_states.end())
+    {
+      start_states.at(i) = req.start_state;
+      end_state_it =
+          end_states.emplace(req.group_name, *planning_scene->getCurrentStateUpdated(req.start_state)).first;
+    }
+    else if (end_state_it->second)
+    {
+      start_states.at(i).emplace();
+      moveit::core::robotStateToRobotStateMsg(*end_state_it->second, *start_states.at(i));
+    }
+
+    auto& end_state = end_state_it->second;
+    if (!end_state)
+    {
+      continue;
+    }
+
+    // Only a single goal of joint constraints for all active joints of the group determines the end state
+    const moveit::core::JointModelGroup* group = planning_scene->getRobotModel()->getJointModelGroup(req.group_name);
+    if (!group || req.goal_constraints.size() != 1 || !req.goal_constraints.front().position_constraints.empty() ||
+        !req.goal_constraints.front().orientation_constraints.empty() ||
+        !req.goal_constraints.front().visibility_constraints.empty())
+    {
+      end_state.reset();
+      continue;
+    }
+    std::map<std::string, double> goal_positions;
+    for (const auto& joint_constraint : req.goal_constraints.front().joint_constraints)
+    {
+      goal_positions[joint_constraint.joint_name] = joint_constraint.position;
+    }
+    const auto& joint_names = group->getActiveJointModelNames();
+    if (!std::all_of(joint_names.cbegin(), joint_names.cend(),
+                     [&goal_positions](const std::string& name) { return goal_positions.count(name) > 0; }))
+    {
+      end_state.reset();
+      continue;
+    }
+    for (const auto& joint_name : joint_names)
+    {
+      end_state->setVariablePosition(joint_name, goal_positions.at(joint_name));
+    }
+    end_state->update();
+  }
+  return start_states;
+}
+
+bool CommandListManager::isStartStateEqual(const moveit_msgs::msg::RobotState& state_A,
+                                           const moveit_msgs::msg::RobotState& state_B)
+{
+  const auto& joints_A = state_A.joint_state;
+  const auto& joints_B = state_B.joint_state;
+  if (joints_A.name != joints_B.name || joints_A.position.size() != joints_B.position.size() ||
+      state_A.multi_dof_joint_state.joint_names != state_B.multi_dof_joint_state.joint_names)
+  {
+    return false;
+  }
+
+  // Missing velocities are zero
+  const auto velocity = [](const sensor_msgs::msg::JointState& joints, size_t i) {
+    return i < joints.velocity.size() ? joints.velocity.at(i) : 0.0;
+  };
+  for (size_t i = 0; i < joints_A.position.size(); ++i)
+  {
+    if (std::abs(joints_A.position.at(i) - joints_B.position.at(i)) > START_STATE_PREDICTION_EPSILON ||
+        std::abs(velocity(joints_A, i) - velocity(joints_B, i)) > START_STATE_PREDICTION_EPSILON)
+    {
+      return false;
+    }
+  }
+  return state_A.multi_dof_joint_state.transforms == state_B.multi_dof_joint_state.transforms;
+}
+
 void CommandListManager::checkForNegativeRadii(const moveit_msgs::msg::MotionSequenceRequest& req_list)
 {
   if (!std::all_of(req_list.items.begin(), req_list.items.end(),
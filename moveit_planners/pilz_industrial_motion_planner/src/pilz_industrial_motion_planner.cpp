@@ -139,8 +139,16 @@ CommandPlanner::getPlanningContext(const planning_scene::PlanningSceneConstPtr&
   }
 
   planning_interface::PlanningContextPtr planning_context;
+  bool context_loaded;
+  {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    updateCartesianLimits();
+    // the loaders reuse the trajectory generator of the group, so this is cheap after the first request
+    context_loaded =
+        context_loader_map_.at(req.planner_id)->loadContext(planning_context, req.planner_id, req.group_name);
+  }
 
-  if (context_loader_map_.at(req.planner_id)->loadContext(planning_context, req.planner_id, req.group_name))
+  if (context_loaded)
   {
     RCLCPP_DEBUG_STREAM(LOGGER, "Found planning context loader for " << req.planner_id << " group:" << req.group_name);
     planning_context->setMotionPlanRequest(req);
@@ -154,6 +162,24 @@ CommandPlanner::getPlanningContext(const planning_scene::PlanningSceneConstPtr&
   }
 }
 
+void CommandPlanner::updateCartesianLimits() const
+{
+  if (!param_listener_->is_old(params_))
+  {
+    return;
+  }
+  params_ = param_listener_->get_params();
+
+  pilz_industrial_motion_planner::LimitsContainer limits;
+  limits.setJointLimits(aggregated_limit_active_joints_);
+  limits.setCartesianLimits(params_);
+  for (const auto& context_loader : context_loader_map_)
+  {
+    context_loader.second->setLimits(limits);
+  }
+  RCLCPP_INFO(LOGGER, "Cartesian limits changed, trajectory generators are created again.");
+}
+
 bool CommandPlanner::canServiceRequest(const moveit_msgs::msg::MotionPlanRequest& req) const
 {
   return context_loader_map_.find(req.planner_id) != context_loader_map_.end();
@@ -44,6 +44,8 @@ pilz_industrial_motion_planner::PlanningContextLoader::~PlanningContextLoader()
 
 bool pilz_industrial_motion_planner::PlanningContextLoader::setModel(const moveit::core::RobotModelConstPtr& model)
 {
+  std::lock_guard<std::mutex> lock(generators_mutex_);
+  generators_.clear();
   model_ = model;
   model_set_ = true;
   return true;
@@ -52,6 +54,8 @@ bool pilz_industrial_motion_planner::PlanningContextLoader::setModel(const movei
 bool pilz_industrial_motion_planner::PlanningContextLoader::setLimits(
     const pilz_industrial_motion_planner::LimitsContainer& limits)
 {
+  std::lock_guard<std::mutex> lock(generators_mutex_);
+  generators_.clear();
   limits_ = limits;
   limits_set_ = true;
   return true;
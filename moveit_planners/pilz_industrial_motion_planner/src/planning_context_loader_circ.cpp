@@ -62,7 +62,8 @@ bool pilz_industrial_motion_planner::PlanningContextLoaderCIRC::loadContext(
 {
   if (limits_set_ && model_set_)
   {
-    planning_context = std::make_shared<PlanningContextCIRC>(name, group, model_, limits_);
+    planning_context = std::make_shared<PlanningContextCIRC>(name, group, model_, limits_,
+                                                             getGenerator<TrajectoryGeneratorCIRC>(group));
     return true;
   }
   else
@@ -58,7 +58,8 @@ bool pilz_industrial_motion_planner::PlanningContextLoaderPTP::loadContext(
 {
   if (limits_set_ && model_set_)
   {
-    planning_context = std::make_shared<PlanningContextPTP>(name, group, model_, limits_);
+    planning_context = std::make_shared<PlanningContextPTP>(name, group, model_, limits_,
+                                                            getGenerator<TrajectoryGeneratorPTP>(group));
     return true;
   }
   else
@@ -43,6 +43,55 @@
 namespace
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.pilz_industrial_motion_planner.trajectory_functions");
+
+// Newton steps tried by computePoseIKFromSeed() before giving up, each step roughly squares the remaining error
+static const int SEEDED_IK_MAX_ITERATIONS = 3;
+static const double SEEDED_IK_POSITION_TOLERANCE = 1e-6;
+static const double SEEDED_IK_ORIENTATION_TOLERANCE = 1e-6;
+
+// run the Newton steps of computePoseIKFromSeed() on rstate, which holds the seed and is left at the solution
+bool reachPoseFromSeed(moveit::core::RobotState& rstate, const moveit::core::JointModelGroup* jmg,
+                       const moveit::core::LinkModel* link, const Eigen::Isometry3d& pose, Eigen::VectorXd& positions)
+{
+  rstate.copyJointGroupPositions(jmg, positions);
+  Eigen::MatrixXd jacobian;
+  Eigen::Matrix<double, 6, 1> error;
+  for (int iteration = 0;; ++iteration)
+  {
+    // pose error in model frame, linear part first as in RobotState::getJacobian()
+    const Eigen::Isometry3d& current = rstate.getGlobalLinkTransform(link);
+    const Eigen::AngleAxisd rotation_error(pose.linear() * current.linear().transpose());
+    error.head<3>() = pose.translation() - current.translation();
+    error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+    if (error.head<3>().norm() < SEEDED_IK_POSITION_TOLERANCE &&
+        error.tail<3>().norm() < SEEDED_IK_ORIENTATION_TOLERANCE)
+    {
+      break;
+    }
+    if (iteration == SEEDED_IK_MAX_ITERATIONS)
+    {
+      return false;
+    }
+
+    if (!rstate.getJacobian(jmg, link, Eigen::Vector3d::Zero(), jacobian))
+    {
+      return false;
+    }
+    const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> decomposition(jacobian);
+    if (decomposition.rank() < 6)
+    {
+      return false;
+    }
+    positions += decomposition.solve(error);
+    rstate.setJointGroupPositions(jmg, positions);
+    if (!rstate.satisfiesBounds(jmg))
+    {
+      return false;
+    }
+    rstate.update();
+  }
+  return true;
+}
 }
 
 bool pilz_industrial_motion_planner::computePoseIK(const planning_scene::PlanningSceneConstPtr& scene,
@@ -118,6 +167,119 @@ bool pilz_industrial_motion_planner::computePoseIK(const planning_scene::Plannin
                        timeout);
 }
 
+bool pilz_industrial_motion_planner::computePoseIKFromSeed(const planning_scene::PlanningSceneConstPtr& scene,
+                                                           const std::string& group_name, const std::string& link_name,
+                                                           const Eigen::Isometry3d& pose,
+                                                           const std::map<std::string, double>& seed,
+                                                           std::map<std::string, double>& solution,
+                                                           bool check_self_collision)
+{
+  const moveit::core::RobotModelConstPtr& robot_model = scene->getRobotModel();
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group_name);
+  const moveit::core::LinkModel* link = robot_model->getLinkModel(link_name);
+  // a full pose can only be reached by a group with at least six variables
+  if (!jmg || !link || jmg->getVariableCount() < 6)
+  {
+    return false;
+  }
+
+  moveit::core::RobotState rstate(robot_model);
+  rstate.setToDefaultValues();
+  rstate.setVariablePositions(seed);
+  rstate.update();
+
+  Eigen::VectorXd positions;
+  if (!reachPoseFromSeed(rstate, jmg, link, pose, positions))
+  {
+    return false;
+  }
+
+  if (!isStateColliding(check_self_collision, scene, &rstate, jmg, positions.data()))
+  {
+    return false;
+  }
+
+  for (const auto& joint_name : jmg->getActiveJointModelNames())
+  {
+    solution[joint_name] = rstate.getVariablePosition(joint_name);
+  }
+  return true;
+}
+
+bool pilz_industrial_motion_planner::computePoseIKSequence(const planning_scene::PlanningSceneConstPtr& scene,
+                                                           const std::string& group_name, const std::string& link_name,
+                                                           const std::vector<Eigen::Isometry3d>& poses,
+                                                           const std::map<std::string, double>& seed,
+                                                           std::vector<std::map<std::string, double>>& solutions,
+                                                           bool check_self_collision)
+{
+  solutions.clear();
+  solutions.reserve(poses.size());
+
+  const moveit::core::RobotModelConstPtr& robot_model = scene->getRobotModel();
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group_name);
+  const moveit::core::LinkModel* link = robot_model->getLinkModel(link_name);
+  // a full pose can only be reached by a group with at least six variables
+  const bool use_newton_steps = jmg && link && jmg->getVariableCount() >= 6;
+
+  // one robot state is reused for all samples instead of one per sample as in computePoseIKFromSeed()
+  moveit::core::RobotState rstate(robot_model);
+  rstate.setToDefaultValues();
+  rstate.setVariablePositions(seed);
+  rstate.update();
+
+  std::map<std::string, double> solution_last = seed;
+  Eigen::VectorXd positions, positions_last, positions_before_last;
+  if (use_newton_steps)
+  {
+    rstate.copyJointGroupPositions(jmg, positions_last);
+    positions_before_last = positions_last;
+  }
+
+  for (const Eigen::Isometry3d& pose : poses)
+  {
+    std::map<std::string, double> solution;
+    bool solved = false;
+    if (use_newton_steps)
+    {
+      // warm start from the last solution, extrapolated by the joint step of the last sample
+      positions = 2 * positions_last - positions_before_last;
+      rstate.setJointGroupPositions(jmg, positions);
+      rstate.enforceBounds(jmg);
+      rstate.update();
+      solved = reachPoseFromSeed(rstate, jmg, link, pose, positions) &&
+               isStateColliding(check_self_collision, scene, &rstate, jmg, positions.data());
+      if (solved)
+      {
+        for (const auto& joint_name : jmg->getActiveJointModelNames())
+        {
+          solution[joint_name] = rstate.getVariablePosition(joint_name);
+        }
+      }
+    }
+
+    if (!solved)
+    {
+      if (!computePoseIK(scene, group_name, link_name, pose, robot_model->getModelFrame(), solution_last, solution,
+                         check_self_collision))
+      {
+        return false;
+      }
+      if (use_newton_steps)
+      {
+        rstate.setVariablePositions(solution);
+        rstate.copyJointGroupPositions(jmg, positions);
+      }
+    }
+
+    positions_before_last = positions_last;
+    positions_last = positions;
+    solution_last = solution;
+    solutions.push_back(std::move(solution));
+  }
+  return true;
+}
+
 bool pilz_industrial_motion_planner::computeLinkFK(const moveit::core::RobotModelConstPtr& robot_model,
                                                    const std::string& link_name,
                                                    const std::map<std::string, double>& joint_state,
@@ -239,7 +401,9 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
   {
     tf2::transformKDLToEigen(trajectory.Pos(*time_iter), pose_sample);
 
-    if (!computePoseIK(scene, group_name, link_name, pose_sample, robot_model->getModelFrame(), ik_solution_last,
+    if (!computePoseIKFromSeed(scene, group_name, link_name, pose_sample, ik_solution_last, ik_solution,
+                               check_self_collision) &&
+        !computePoseIK(scene, group_name, link_name, pose_sample, robot_model->getModelFrame(), ik_solution_last,
                        ik_solution, check_self_collision))
     {
       RCLCPP_ERROR(LOGGER, "Failed to compute inverse kinematics solution for sampled Cartesian pose.");
@@ -330,7 +494,6 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
 {
   RCLCPP_DEBUG(LOGGER, "Generate joint trajectory from a Cartesian trajectory.");
 
-  const moveit::core::RobotModelConstPtr& robot_model = scene->getRobotModel();
   rclcpp::Clock clock;
   rclcpp::Time generation_begin = clock.now();
 
@@ -343,12 +506,21 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
   {
     joint_trajectory.joint_names.push_back(joint_position.first);
   }
-  std::map<std::string, double> ik_solution;
+
+  // compute inverse kinematics of all samples at once, each warm-started from the previous solution
+  std::vector<Eigen::Isometry3d> pose_samples(trajectory.points.size());
+  for (size_t i = 0; i < trajectory.points.size(); ++i)
+  {
+    tf2::convert<geometry_msgs::msg::Pose, Eigen::Isometry3d>(trajectory.points.at(i).pose, pose_samples[i]);
+  }
+  // on failure only the samples before the failing one are solved
+  std::vector<std::map<std::string, double>> ik_solutions;
+  computePoseIKSequence(scene, group_name, link_name, pose_samples, initial_joint_position, ik_solutions,
+                        check_self_collision);
+
   for (size_t i = 0; i < trajectory.points.size(); ++i)
   {
-    // compute inverse kinematics
-    if (!computePoseIK(scene, group_name, link_name, trajectory.points.at(i).pose, robot_model->getModelFrame(),
-                       ik_solution_last, ik_solution, check_self_collision))
+    if (i == ik_solutions.size())
     {
       RCLCPP_ERROR(LOGGER, "Failed to compute inverse kinematics solution for sampled "
                            "Cartesian pose.");
@@ -357,6 +529,8 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
       return false;
     }
 
+    const std::map<std::string, double>& ik_solution = ik_solutions[i];
+
     // verify the joint limits
     if (i == 0)
     {
@@ -567,6 +741,57 @@ bool pilz_industrial_motion_planner::linearSearchIntersectionPoint(const std::st
   return false;
 }
 
+bool pilz_industrial_motion_planner::binarySearchIntersectionPoint(const std::string& link_name,
+                                                                   const Eigen::Vector3d& center_position,
+                                                                   const double& r,
+                                                                   const robot_trajectory::RobotTrajectoryPtr& traj,
+                                                                   bool inverseOrder, std::size_t& index)
+{
+  RCLCPP_DEBUG(LOGGER, "Start binary search for intersection point.");
+
+  const size_t waypoint_num = traj->getWayPointCount();
+  if (waypoint_num < 2)
+  {
+    return false;
+  }
+
+  // distance to the center of the waypoint that is the given number of steps away from the center
+  auto distance = [&](std::size_t steps) {
+    const std::size_t i = inverseOrder ? waypoint_num - 1 - steps : steps;
+    return (traj->getWayPointPtr(i)->getFrameTransform(link_name).translation() - center_position).norm();
+  };
+
+  // double the step away from the center until a waypoint outside of the sphere is found
+  std::size_t inside = 0;
+  std::size_t outside = 1;
+  while (distance(outside) < r)
+  {
+    inside = outside;
+    if (outside == waypoint_num - 1)
+    {
+      return false;
+    }
+    outside = std::min(2 * outside, waypoint_num - 1);
+  }
+
+  // bisect until the two waypoints are neighbors
+  while (outside - inside > 1)
+  {
+    const std::size_t middle = inside + (outside - inside) / 2;
+    if (distance(middle) < r)
+    {
+      inside = middle;
+    }
+    else
+    {
+      outside = middle;
+    }
+  }
+
+  index = inverseOrder ? waypoint_num - 1 - inside : inside;
+  return true;
+}
+
 bool pilz_industrial_motion_planner::intersectionFound(const Eigen::Vector3d& p_center,
                                                        const Eigen::Vector3d& p_current, const Eigen::Vector3d& p_next,
                                                        const double& r)
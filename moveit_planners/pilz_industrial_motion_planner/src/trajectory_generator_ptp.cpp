@@ -189,18 +189,28 @@ void TrajectoryGeneratorPTP::planPTP(const std::map<std::string, double>& start_
   // add last time
   time_samples.push_back(max_duration);
 
+  // sample all axes into contiguous buffers, one row of joint values per time sample
+  const std::size_t num_joints = joint_trajectory.joint_names.size();
+  std::vector<double> positions(time_samples.size() * num_joints);
+  std::vector<double> velocities(positions.size());
+  std::vector<double> accelerations(positions.size());
+  for (std::size_t j = 0; j < num_joints; ++j)
+  {
+    velocity_profile.at(joint_trajectory.joint_names[j])
+        .sampleProfile(time_samples, &positions[j], &velocities[j], &accelerations[j], num_joints);
+  }
+
   // construct joint trajectory point
-  for (double time_stamp : time_samples)
+  joint_trajectory.points.reserve(time_samples.size());
+  for (std::size_t i = 0; i < time_samples.size(); ++i)
   {
     trajectory_msgs::msg::JointTrajectoryPoint point;
-    point.time_from_start = rclcpp::Duration::from_seconds(time_stamp);
-    for (std::string& joint_name : joint_trajectory.joint_names)
-    {
-      point.positions.push_back(velocity_profile.at(joint_name).Pos(time_stamp));
-      point.velocities.push_back(velocity_profile.at(joint_name).Vel(time_stamp));
-      point.accelerations.push_back(velocity_profile.at(joint_name).Acc(time_stamp));
-    }
-    joint_trajectory.points.push_back(point);
+    point.time_from_start = rclcpp::Duration::from_seconds(time_samples[i]);
+    const auto row = static_cast<std::ptrdiff_t>(i * num_joints);
+    point.positions.assign(positions.begin() + row, positions.begin() + row + num_joints);
+    point.velocities.assign(velocities.begin() + row, velocities.begin() + row + num_joints);
+    point.accelerations.assign(accelerations.begin() + row, accelerations.begin() + row + num_joints);
+    joint_trajectory.points.push_back(std::move(point));
   }
 
   // Set last point velocity and acceleration to zero
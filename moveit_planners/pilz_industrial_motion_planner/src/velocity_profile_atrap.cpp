@@ -381,6 +381,18 @@ double VelocityProfileATrap::Acc(double time) const
   }
 }
 
+void VelocityProfileATrap::sampleProfile(const std::vector<double>& times, double* positions, double* velocities,
+                                         double* accelerations, std::size_t stride) const
+{
+  // qualified calls are not dispatched virtually and can be inlined
+  for (std::size_t i = 0; i < times.size(); ++i)
+  {
+    positions[i * stride] = VelocityProfileATrap::Pos(times[i]);
+    velocities[i * stride] = VelocityProfileATrap::Vel(times[i]);
+    accelerations[i * stride] = VelocityProfileATrap::Acc(times[i]);
+  }
+}
+
 KDL::VelocityProfile* VelocityProfileATrap::Clone() const
 {
   VelocityProfileATrap* trap = new VelocityProfileATrap(max_vel_, max_acc_, max_dec_);
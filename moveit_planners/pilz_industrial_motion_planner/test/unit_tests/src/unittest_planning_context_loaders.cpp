@@ -171,6 +171,40 @@ TEST_P(PlanningContextLoadersTest, LoadContext)
   EXPECT_EQ(true, res) << "Context could not be loaded!";
 }
 
+/**
+ * @brief Check that contexts loaded for the same group share nothing request
+ * specific and can still be loaded after the limits changed
+ */
+TEST_P(PlanningContextLoadersTest, LoadContextRepeatedly)
+{
+  const std::string& group_name = "manipulator";
+  pilz_industrial_motion_planner::LimitsContainer limits;
+  limits.setJointLimits(testutils::createFakeLimits(robot_model_->getVariableNames()));
+  cartesian_limits::Params cart_limits;
+  cart_limits.max_trans_vel = 1 * M_PI;
+  cart_limits.max_trans_acc = 2;
+  cart_limits.max_trans_dec = 2;
+  cart_limits.max_rot_vel = 1;
+  limits.setCartesianLimits(cart_limits);
+
+  planning_context_loader_->setLimits(limits);
+  planning_context_loader_->setModel(robot_model_);
+
+  planning_interface::PlanningContextPtr first_context, second_context;
+  ASSERT_TRUE(planning_context_loader_->loadContext(first_context, "first", group_name));
+  ASSERT_TRUE(planning_context_loader_->loadContext(second_context, "second", group_name));
+  ASSERT_NE(first_context, second_context);
+  EXPECT_EQ("first", first_context->getName());
+  EXPECT_EQ("second", second_context->getName());
+
+  // setting the limits again drops the cached generators
+  cart_limits.max_trans_vel = 0.5;
+  limits.setCartesianLimits(cart_limits);
+  planning_context_loader_->setLimits(limits);
+  planning_interface::PlanningContextPtr third_context;
+  EXPECT_TRUE(planning_context_loader_->loadContext(third_context, "third", group_name));
+}
+
 int main(int argc, char** argv)
 {
   rclcpp::init(argc, argv);
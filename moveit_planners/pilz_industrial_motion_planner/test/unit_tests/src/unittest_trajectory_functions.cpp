@@ -429,6 +429,160 @@ TEST_F(TrajectoryFunctionsTestFlangeAndGripper, testComputePoseIKInvalidFrameId)
                                                              "InvalidFrameId", ik_seed, ik_actual, false));
 }
 
+/**
+ * @brief Test computePoseIKFromSeed for poses close to the seed state
+ */
+TEST_F(TrajectoryFunctionsTestFlangeAndGripper, testComputePoseIKFromSeed)
+{
+  moveit::core::RobotState rstate(robot_model_);
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup(planning_group_);
+  // small offset as between two consecutive samples of a Cartesian trajectory
+  const double seed_offset = 1e-3;
+
+  while (random_test_number_ > 0)
+  {
+    // sample random robot state
+    rstate.setToRandomPositions(jmg, rng_);
+    rstate.update();
+    Eigen::Isometry3d pose_expect = rstate.getFrameTransform(tcp_link_);
+
+    // set the ik seed towards the middle of the joint ranges
+    std::map<std::string, double> ik_seed;
+    for (const auto& joint_name : jmg->getActiveJointModelNames())
+    {
+      const double position = rstate.getVariablePosition(joint_name);
+      ik_seed[joint_name] = position > 0 ? position - seed_offset : position + seed_offset;
+    }
+
+    std::map<std::string, double> ik_actual;
+    EXPECT_TRUE(pilz_industrial_motion_planner::computePoseIKFromSeed(planning_scene_, planning_group_, tcp_link_,
+                                                                      pose_expect, ik_seed, ik_actual, false));
+
+    // the solution has to reach the pose
+    Eigen::Isometry3d pose_actual;
+    ASSERT_TRUE(pilz_industrial_motion_planner::computeLinkFK(robot_model_, tcp_link_, ik_actual, pose_actual));
+    EXPECT_TRUE(tfNear(pose_expect, pose_actual, EPSILON));
+
+    --random_test_number_;
+  }
+}
+
+/**
+ * @brief Test computePoseIKFromSeed for invalid group_name
+ */
+TEST_F(TrajectoryFunctionsTestFlangeAndGripper, testComputePoseIKFromSeedInvalidGroupName)
+{
+  Eigen::Isometry3d pose_expect = Eigen::Isometry3d::Identity();
+  std::map<std::string, double> ik_seed, ik_actual;
+  EXPECT_FALSE(pilz_industrial_motion_planner::computePoseIKFromSeed(planning_scene_, "InvalidGroupName", tcp_link_,
+                                                                     pose_expect, ik_seed, ik_actual, false));
+}
+
+/**
+ * @brief Test computePoseIKSequence for densely sampled poses along a joint space path
+ */
+TEST_F(TrajectoryFunctionsTestFlangeAndGripper, testComputePoseIKSequence)
+{
+  moveit::core::RobotState rstate(robot_model_);
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup(planning_group_);
+  const std::size_t sample_num = 20;
+  const double joint_step = 1e-3;
+
+  while (random_test_number_ > 0)
+  {
+    // sample a random start state and move all joints towards the middle of their ranges
+    rstate.setToRandomPositions(jmg, rng_);
+    std::map<std::string, double> ik_seed;
+    for (const auto& joint_name : jmg->getActiveJointModelNames())
+    {
+      ik_seed[joint_name] = rstate.getVariablePosition(joint_name);
+    }
+
+    std::vector<Eigen::Isometry3d> poses_expect;
+    for (std::size_t i = 1; i <= sample_num; ++i)
+    {
+      for (const auto& joint_name : jmg->getActiveJointModelNames())
+      {
+        const double seed_position = ik_seed.at(joint_name);
+        rstate.setVariablePosition(joint_name, seed_position > 0 ? seed_position - i * joint_step :
+                                                                   seed_position + i * joint_step);
+      }
+      rstate.update();
+      poses_expect.push_back(rstate.getFrameTransform(tcp_link_));
+    }
+
+    std::vector<std::map<std::string, double>> ik_actual;
+    EXPECT_TRUE(pilz_industrial_motion_planner::computePoseIKSequence(planning_scene_, planning_group_, tcp_link_,
+                                                                      poses_expect, ik_seed, ik_actual, false));
+    ASSERT_EQ(poses_expect.size(), ik_actual.size());
+
+    // every solution has to reach its pose
+    for (std::size_t i = 0; i < sample_num; ++i)
+    {
+      Eigen::Isometry3d pose_actual;
+      ASSERT_TRUE(pilz_industrial_motion_planner::computeLinkFK(robot_model_, tcp_link_, ik_actual[i], pose_actual));
+      EXPECT_TRUE(tfNear(poses_expect[i], pose_actual, EPSILON));
+    }
+
+    --random_test_number_;
+  }
+}
+
+/**
+ * @brief Check that the binary search for the intersection point with the
+ * blending sphere finds the same waypoint as the linear search.
+ *
+ * Test Sequence:
+ *    1. Rotate the bent arm around its first joint, so that the distance of
+ *       the tcp to its start position grows monotonically.
+ *    2. Search the intersection point for several radii in both orders.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Both searches return the same result and index.
+ */
+TEST_F(TrajectoryFunctionsTestFlangeAndGripper, testBinarySearchIntersectionPoint)
+{
+  const std::size_t waypoint_num = 100;
+  robot_trajectory::RobotTrajectoryPtr forward_trajectory =
+      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
+  robot_trajectory::RobotTrajectoryPtr backward_trajectory =
+      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
+
+  moveit::core::RobotState rstate(robot_model_);
+  rstate.setToDefaultValues();
+  rstate.setVariablePosition(joint_names_.at(1), 1.0);
+  for (std::size_t i = 0; i < waypoint_num; ++i)
+  {
+    rstate.setVariablePosition(joint_names_.front(), i * 1e-2);
+    rstate.update();
+    forward_trajectory->addSuffixWayPoint(rstate, 0.1);
+    backward_trajectory->addPrefixWayPoint(rstate, 0.1);
+  }
+  const Eigen::Vector3d center = forward_trajectory->getFirstWayPoint().getFrameTransform(tcp_link_).translation();
+  const double max_distance =
+      (forward_trajectory->getLastWayPoint().getFrameTransform(tcp_link_).translation() - center).norm();
+  ASSERT_GT(max_distance, 0.0);
+
+  for (double r : { 0.001, 0.1 * max_distance, 0.5 * max_distance, 0.99 * max_distance, 2 * max_distance })
+  {
+    for (const auto& inverse_order : { false, true })
+    {
+      const auto& trajectory = inverse_order ? backward_trajectory : forward_trajectory;
+      std::size_t linear_index = 0;
+      std::size_t binary_index = 0;
+      const bool linear_found = pilz_industrial_motion_planner::linearSearchIntersectionPoint(
+          tcp_link_, center, r, trajectory, inverse_order, linear_index);
+      EXPECT_EQ(linear_found, pilz_industrial_motion_planner::binarySearchIntersectionPoint(
+                                  tcp_link_, center, r, trajectory, inverse_order, binary_index));
+      if (linear_found)
+      {
+        EXPECT_EQ(linear_index, binary_index);
+      }
+    }
+  }
+}
+
 // /**
 //  * @brief Test if activated self collision for a pose that would be in self
 //  * collision without the check results in a
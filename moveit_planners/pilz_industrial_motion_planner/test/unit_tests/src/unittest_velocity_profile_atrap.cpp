@@ -624,6 +624,34 @@ TEST(ATrapTest, Test_Clone)
   delete vp_clone;
 }
 
+/**
+ * @brief Test that sampleProfile() matches Pos(), Vel() and Acc()
+ */
+TEST(ATrapTest, Test_sampleProfile)
+{
+  pilz_industrial_motion_planner::VelocityProfileATrap vp =
+      pilz_industrial_motion_planner::VelocityProfileATrap(4, 2, 1);
+  vp.SetProfile(3, 35);
+
+  // include samples outside of the profile and at the phase boundaries
+  std::vector<double> times = { -1.0, 0.0, 2.0, 8.0, 11.0, 12.0 };
+  for (double t = 0.0; t < vp.Duration(); t += 0.01)
+  {
+    times.push_back(t);
+  }
+
+  // interleave with a second axis to test the stride
+  const std::size_t stride = 2;
+  std::vector<double> positions(times.size() * stride), velocities(positions.size()), accelerations(positions.size());
+  vp.sampleProfile(times, &positions[1], &velocities[1], &accelerations[1], stride);
+  for (std::size_t i = 0; i < times.size(); ++i)
+  {
+    EXPECT_EQ(positions[i * stride + 1], vp.Pos(times[i]));
+    EXPECT_EQ(velocities[i * stride + 1], vp.Vel(times[i]));
+    EXPECT_EQ(accelerations[i * stride + 1], vp.Acc(times[i]));
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -85,6 +85,9 @@ void set_joint_positions(const Eigen::VectorXd& values, const Joints& joints, mo
 /**
  * Writes the provided position value sequence into a robot trajectory.
  *
+ * If the trajectory already holds the same number of waypoints, these are updated in place instead of allocating
+ * new robot states. Waypoints that are shared with other owners are never modified.
+ *
  * @param trajectory_values The joint value sequence to copy the waypoints from
  * @param reference_state   A robot state providing default joint values and robot model
  * @param trajectory        The robot trajectory containing waypoints with updated values
@@ -92,12 +95,32 @@ void set_joint_positions(const Eigen::VectorXd& values, const Joints& joints, mo
 void fill_robot_trajectory(const Eigen::MatrixXd& trajectory_values, const moveit::core::RobotState& reference_state,
                            robot_trajectory::RobotTrajectory& trajectory)
 {
-  trajectory.clear();
   const auto& active_joints = trajectory.getGroup() ? trajectory.getGroup()->getActiveJointModels() :
                                                       trajectory.getRobotModel()->getActiveJointModels();
   assert(static_cast<std::size_t>(trajectory_values.rows()) == active_joints.size());
 
-  for (int timestep = 0; timestep < trajectory_values.cols(); ++timestep)
+  const std::size_t waypoint_count = static_cast<std::size_t>(trajectory_values.cols());
+  bool reuse_waypoints = trajectory.getWayPointCount() == waypoint_count;
+  for (std::size_t timestep = 0; reuse_waypoints && timestep < waypoint_count; ++timestep)
+  {
+    const auto& waypoint = trajectory.getWayPointPtr(timestep);
+    reuse_waypoints = waypoint.use_count() == 1 && waypoint->getRobotModel() == reference_state.getRobotModel();
+  }
+
+  if (reuse_waypoints)
+  {
+    for (std::size_t timestep = 0; timestep < waypoint_count; ++timestep)
+    {
+      auto& waypoint = *trajectory.getWayPointPtr(timestep);
+      waypoint = reference_state;
+      set_joint_positions(trajectory_values.col(timestep), active_joints, waypoint);
+      trajectory.setWayPointDurationFromPrevious(timestep, 0.1 /* placeholder dt */);
+    }
+    return;
+  }
+
+  trajectory.clear();
+  for (std::size_t timestep = 0; timestep < waypoint_count; ++timestep)
   {
     const auto waypoint = std::make_shared<moveit::core::RobotState>(reference_state);
     set_joint_positions(trajectory_values.col(timestep), active_joints, *waypoint);
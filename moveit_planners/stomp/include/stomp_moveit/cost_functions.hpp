@@ -43,14 +43,22 @@
 
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/collision_distance_field/collision_distance_field_types.h>
+#include <moveit/collision_distance_field/collision_env_distance_field.h>
+#include <moveit/distance_field/propagation_distance_field.h>
+#include <moveit/utils/worker_pool.h>
 
 #include <stomp_moveit/stomp_moveit_task.hpp>
 #include <stomp_moveit/conversion_functions.hpp>
 
 namespace stomp_moveit
 {
+using moveit::core::WorkerPool;
+
 // Decides if the given state position vector is valid or not - example use cases are collision or constraint checking
 using StateValidatorFn = std::function<bool(const Eigen::VectorXd& state_positions)>;
+// Creates a StateValidatorFn with its own scratch data (e.g. a RobotState), so that several can run concurrently
+using StateValidatorFactoryFn = std::function<StateValidatorFn()>;
 
 namespace costs
 {
@@ -67,29 +75,36 @@ constexpr double CONSTRAINT_CHECK_DISTANCE = 0.1;
  * Penalty costs are being smoothed out using a Gaussian so that valid neighboring states (near collisions) are
  * optimized as well.
  *
- * @param state_validator_fn      The validator function that tests for binary conditions
+ * The path segments are validated independently of each other, so they are distributed over the workers of
+ * worker_pool if one is given. Each worker then uses its own validator created with make_validator.
+ *
+ * @param make_validator          Creates the validator functions that test for binary conditions
  * @param interpolation_step_size The L2 norm distance step used for interpolation
  * @param penalty                 The penalty cost value applied to invalid states
+ * @param worker_pool             Optional worker pool for validating segments in parallel
  *
  * @return                        Cost function that computes smooth costs for binary validity conditions
  */
-CostFn get_cost_function_from_state_validator(const StateValidatorFn& state_validator_fn,
-                                              double interpolation_step_size, double penalty)
+CostFn get_cost_function_from_state_validator(const StateValidatorFactoryFn& make_validator,
+                                              double interpolation_step_size, double penalty,
+                                              const std::shared_ptr<WorkerPool>& worker_pool)
 {
+  std::vector<StateValidatorFn> validators;
+  const size_t num_workers = worker_pool ? worker_pool->getNumWorkers() : 1;
+  for (size_t worker = 0; worker < num_workers; ++worker)
+  {
+    validators.push_back(make_validator());
+  }
+
   CostFn cost_fn = [=](const Eigen::MatrixXd& values, Eigen::VectorXd& costs, bool& validity) {
     costs.setZero(values.cols());
 
-    validity = true;
-    std::vector<std::pair<long, long>> invalid_windows;
-    bool in_invalid_window = false;
-
-    // Iterate over sample waypoint pairs and check for validity in each segment.
-    // If an invalid state is found, weighted penalty costs are applied to both waypoints.
-    // Subsequent invalid states are assumed to have the same cause, so we are keeping track
-    // of "invalid windows" which are used for smoothing out the costs per violation cause
-    // with a gaussian, penalizing neighboring valid states as well.
-    for (int timestep = 0; timestep < values.cols() - 1; ++timestep)
-    {
+    // Check each segment between two sample waypoints for validity, stopping at the first invalid state.
+    // The interpolation fraction of that state determines how the penalty is split between both waypoints.
+    const size_t num_segments = std::max(values.cols() - 1, Eigen::Index(0));
+    std::vector<char> segment_invalid(num_segments, false);
+    std::vector<double> segment_fraction(num_segments, 0.0);
+    const auto check_segment = [&](size_t timestep, size_t worker) {
       Eigen::VectorXd current = values.col(timestep);
       Eigen::VectorXd next = values.col(timestep + 1);
       const double segment_distance = (next - current).norm();
@@ -100,13 +115,38 @@ CostFn get_cost_function_from_state_validator(const StateValidatorFn& state_vali
       {
         Eigen::VectorXd sample_vec = (1 - interpolation_fraction) * current + interpolation_fraction * next;
 
-        found_invalid_state = !state_validator_fn(sample_vec);
+        found_invalid_state = !validators[worker](sample_vec);
         interpolation_fraction += interpolation_step;
       }
+      segment_invalid[timestep] = found_invalid_state;
+      segment_fraction[timestep] = interpolation_fraction;
+    };
+    if (worker_pool)
+    {
+      worker_pool->run(num_segments, check_segment);
+    }
+    else
+    {
+      for (size_t timestep = 0; timestep < num_segments; ++timestep)
+      {
+        check_segment(timestep, 0);
+      }
+    }
 
-      if (found_invalid_state)
+    validity = true;
+    std::vector<std::pair<long, long>> invalid_windows;
+    bool in_invalid_window = false;
+
+    // If an invalid state was found in a segment, weighted penalty costs are applied to both waypoints.
+    // Subsequent invalid states are assumed to have the same cause, so we are keeping track
+    // of "invalid windows" which are used for smoothing out the costs per violation cause
+    // with a gaussian, penalizing neighboring valid states as well.
+    for (long timestep = 0; timestep < static_cast<long>(num_segments); ++timestep)
+    {
+      if (segment_invalid[timestep])
       {
         // Apply weighted penalties -> This trajectory is definitely invalid
+        const double interpolation_fraction = segment_fraction[timestep];
         costs(timestep) = (1 - interpolation_fraction) * penalty;
         costs(timestep + 1) = interpolation_fraction * penalty;
         validity = false;
@@ -154,6 +194,23 @@ CostFn get_cost_function_from_state_validator(const StateValidatorFn& state_vali
   return cost_fn;
 }
 
+/**
+ * Creates a cost function from a single binary robot state validation function, which is applied sequentially.
+ * See the StateValidatorFactoryFn overload for details.
+ *
+ * @param state_validator_fn      The validator function that tests for binary conditions
+ * @param interpolation_step_size The L2 norm distance step used for interpolation
+ * @param penalty                 The penalty cost value applied to invalid states
+ *
+ * @return                        Cost function that computes smooth costs for binary validity conditions
+ */
+CostFn get_cost_function_from_state_validator(const StateValidatorFn& state_validator_fn,
+                                              double interpolation_step_size, double penalty)
+{
+  return get_cost_function_from_state_validator([state_validator_fn] { return state_validator_fn; },
+                                                interpolation_step_size, penalty, nullptr);
+}
+
 /**
  * Creates a cost function for binary collisions of group states in the planning scene.
  * This function uses a StateValidatorFn for computing smooth penalty costs from binary
@@ -162,26 +219,30 @@ CostFn get_cost_function_from_state_validator(const StateValidatorFn& state_vali
  * @param planning_scene    The planning scene instance to use for collision checking
  * @param group             The group to use for computing link transforms from joint positions
  * @param collision_penalty The penalty cost value applied to colliding states
+ * @param worker_pool       Optional worker pool for running collision checks in parallel
  *
  * @return                  Cost function that computes smooth costs for colliding path segments
  */
 CostFn get_collision_cost_function(const std::shared_ptr<const planning_scene::PlanningScene>& planning_scene,
-                                   const moveit::core::JointModelGroup* group, double collision_penalty)
+                                   const moveit::core::JointModelGroup* group, double collision_penalty,
+                                   const std::shared_ptr<WorkerPool>& worker_pool = nullptr)
 {
   const auto& joints = group ? group->getActiveJointModels() : planning_scene->getRobotModel()->getActiveJointModels();
   const auto& group_name = group ? group->getName() : "";
 
-  StateValidatorFn collision_validator_fn = [=](const Eigen::VectorXd& positions) {
-    static moveit::core::RobotState state(planning_scene->getCurrentState());
+  StateValidatorFactoryFn make_collision_validator = [=]() -> StateValidatorFn {
+    auto state = std::make_shared<moveit::core::RobotState>(planning_scene->getCurrentState());
+    return [=](const Eigen::VectorXd& positions) {
+      // Update robot state values
+      set_joint_positions(positions, joints, *state);
+      state->update();
 
-    // Update robot state values
-    set_joint_positions(positions, joints, state);
-    state.update();
-
-    return !planning_scene->isStateColliding(state, group_name);
+      return !planning_scene->isStateColliding(*state, group_name);
+    };
   };
 
-  return get_cost_function_from_state_validator(collision_validator_fn, COL_CHECK_DISTANCE, collision_penalty);
+  return get_cost_function_from_state_validator(make_collision_validator, COL_CHECK_DISTANCE, collision_penalty,
+                                                worker_pool);
 }
 
 /**
@@ -193,32 +254,152 @@ CostFn get_collision_cost_function(const std::shared_ptr<const planning_scene::P
  * @param group               The group to use for computing link transforms from joint positions
  * @param constraints_msg     The constraints used for validating group states
  * @param constraints_penalty The penalty cost value applied to invalid states
+ * @param worker_pool         Optional worker pool for running constraint checks in parallel
  *
  * @return                    Cost function that computes smooth costs for invalid path segments
  */
 CostFn get_constraints_cost_function(const std::shared_ptr<const planning_scene::PlanningScene>& planning_scene,
                                      const moveit::core::JointModelGroup* group,
-                                     const moveit_msgs::msg::Constraints& constraints_msg, double constraints_penalty)
+                                     const moveit_msgs::msg::Constraints& constraints_msg, double constraints_penalty,
+                                     const std::shared_ptr<WorkerPool>& worker_pool = nullptr)
 {
   const auto& joints = group ? group->getActiveJointModels() : planning_scene->getRobotModel()->getActiveJointModels();
 
-  kinematic_constraints::KinematicConstraintSet constraints(planning_scene->getRobotModel());
-  constraints.add(constraints_msg, planning_scene->getTransforms());
+  auto constraints = std::make_shared<kinematic_constraints::KinematicConstraintSet>(planning_scene->getRobotModel());
+  constraints->add(constraints_msg, planning_scene->getTransforms());
+
+  StateValidatorFactoryFn make_constraints_validator = [=]() -> StateValidatorFn {
+    auto state = std::make_shared<moveit::core::RobotState>(planning_scene->getCurrentState());
+    return [=](const Eigen::VectorXd& positions) {
+      // Update robot state values
+      set_joint_positions(positions, joints, *state);
+      state->update();
 
-  StateValidatorFn constraints_validator_fn = [=](const Eigen::VectorXd& positions) {
-    static moveit::core::RobotState state(planning_scene->getCurrentState());
+      // NOTE: the returned ConstraintEvaluationResult also provides a `double distance` which might be used as an
+      // actual cost gradient instead of the binary state penalty
+      return constraints->decide(*state).satisfied;
+    };
+  };
 
-    // Update robot state values
-    set_joint_positions(positions, joints, state);
-    state.update();
+  return get_cost_function_from_state_validator(make_constraints_validator, CONSTRAINT_CHECK_DISTANCE,
+                                                constraints_penalty, worker_pool);
+}
 
-    // NOTE: the returned ConstraintEvaluationResult also provides a `double distance` which might be used as an
-    // actual cost gradient instead of the binary state penalty
-    return constraints.decide(state).satisfied;
+/**
+ * Creates a cost function that penalizes the proximity of the group links to the world objects of the planning scene.
+ * The link geometry is approximated with the collision spheres of collision_distance_field's BodyDecomposition and the
+ * world is rasterized into a PropagationDistanceField once when the cost function is created. Each waypoint is then
+ * assigned the summed clearance violation of all spheres, which provides a smooth cost gradient towards free space.
+ *
+ * The cost function doesn't decide path validity, it should be combined with get_collision_cost_function().
+ * Waypoints are evaluated independently of each other, so they are distributed over the workers of worker_pool if
+ * one is given.
+ *
+ * @param planning_scene The planning scene providing the robot state and the world objects
+ * @param group          The group whose links are checked for clearance
+ * @param clearance      The distance to obstacles below which a sphere is penalized
+ * @param weight         The weight multiplied onto the summed clearance violation of each waypoint
+ * @param worker_pool    Optional worker pool for evaluating waypoints in parallel
+ *
+ * @return               Cost function that computes smooth costs for waypoints close to obstacles
+ */
+CostFn get_distance_field_cost_function(const std::shared_ptr<const planning_scene::PlanningScene>& planning_scene,
+                                        const moveit::core::JointModelGroup* group, double clearance, double weight,
+                                        const std::shared_ptr<WorkerPool>& worker_pool = nullptr)
+{
+  using namespace collision_detection;
+  const auto& joints = group ? group->getActiveJointModels() : planning_scene->getRobotModel()->getActiveJointModels();
+  const auto& links = group ? group->getUpdatedLinkModelsWithGeometry() :
+                              planning_scene->getRobotModel()->getLinkModelsWithCollisionGeometry();
+
+  // Rasterize the world into a distance field with the same extents as CollisionEnvDistanceField uses by default
+  const Eigen::Vector3d size(DEFAULT_SIZE_X, DEFAULT_SIZE_Y, DEFAULT_SIZE_Z);
+  auto distance_field = std::make_shared<distance_field::PropagationDistanceField>(
+      size.x(), size.y(), size.z(), DEFAULT_RESOLUTION, -0.5 * size.x(), -0.5 * size.y(), -0.5 * size.z(),
+      std::max(clearance, DEFAULT_MAX_PROPOGATION_DISTANCE));
+  const auto& world = planning_scene->getWorld();
+  EigenSTL::vector_Vector3d world_points;
+  for (const auto& [id, object] : *world)
+  {
+    for (std::size_t i = 0; i < object->shapes_.size(); ++i)
+    {
+      const auto& shape = object->shapes_[i];
+      std::shared_ptr<PosedBodyPointDecomposition> points;
+      if (shape->type == shapes::OCTREE)
+      {
+        points = std::make_shared<PosedBodyPointDecomposition>(
+            static_cast<const shapes::OcTree*>(shape.get())->octree);
+      }
+      else
+      {
+        const auto decomposition = std::make_shared<const BodyDecomposition>(shape, DEFAULT_RESOLUTION);
+        points = std::make_shared<PosedBodyPointDecomposition>(decomposition, world->getGlobalShapeTransform(id, i));
+      }
+      world_points.insert(world_points.end(), points->getCollisionPoints().begin(), points->getCollisionPoints().end());
+    }
+  }
+  distance_field->addPointsToField(world_points);
+
+  // Flat sphere model: the spheres of link i are in [sphere_offsets[i], sphere_offsets[i + 1])
+  std::vector<std::size_t> sphere_offsets = { 0 };
+  EigenSTL::vector_Vector3d sphere_centers;
+  std::vector<double> sphere_radii;
+  for (const auto& link : links)
+  {
+    const BodyDecomposition decomposition(link->getShapes(), link->getCollisionOriginTransforms(), DEFAULT_RESOLUTION,
+                                          0.0 /* padding */);
+    for (const auto& sphere : decomposition.getCollisionSpheres())
+    {
+      sphere_centers.push_back(sphere.relative_vec_);
+      sphere_radii.push_back(sphere.radius_);
+    }
+    sphere_offsets.push_back(sphere_centers.size());
+  }
+
+  std::vector<std::shared_ptr<moveit::core::RobotState>> states;
+  const size_t num_workers = worker_pool ? worker_pool->getNumWorkers() : 1;
+  for (size_t worker = 0; worker < num_workers; ++worker)
+  {
+    states.push_back(std::make_shared<moveit::core::RobotState>(planning_scene->getCurrentState()));
+  }
+
+  CostFn cost_fn = [=](const Eigen::MatrixXd& values, Eigen::VectorXd& costs, bool& validity) {
+    costs.setZero(values.cols());
+    const auto waypoint_cost = [&](size_t timestep, size_t worker) {
+      auto& state = *states[worker];
+      set_joint_positions(values.col(timestep), joints, state);
+      state.update();
+
+      double violation = 0.0;
+      for (std::size_t i = 0; i < links.size(); ++i)
+      {
+        const Eigen::Isometry3d& link_transform = state.getGlobalLinkTransform(links[i]);
+        for (std::size_t j = sphere_offsets[i]; j < sphere_offsets[i + 1]; ++j)
+        {
+          const Eigen::Vector3d center = link_transform * sphere_centers[j];
+          const double distance = distance_field->getDistance(center.x(), center.y(), center.z()) - sphere_radii[j];
+          violation += std::max(0.0, clearance - distance);
+        }
+      }
+      costs(timestep) = weight * violation;
+    };
+    if (worker_pool)
+    {
+      worker_pool->run(values.cols(), waypoint_cost);
+    }
+    else
+    {
+      for (size_t timestep = 0; timestep < static_cast<size_t>(values.cols()); ++timestep)
+      {
+        waypoint_cost(timestep, 0);
+      }
+    }
+
+    validity = true;
+    return true;
   };
 
-  return get_cost_function_from_state_validator(constraints_validator_fn, CONSTRAINT_CHECK_DISTANCE,
-                                                constraints_penalty);
+  return cost_fn;
 }
 
 /**
@@ -68,11 +68,13 @@ FilterFn simple_smoothing_matrix(size_t num_timesteps)
   // adapter after solving the STOMP trajectory.
   Eigen::MatrixXd smoothing_matrix;
   stomp::generateSmoothingMatrix(num_timesteps, 1.0 /* dt */, smoothing_matrix);
+  // Smoothing all joint rows at once is a single matrix product, written into a reused buffer to avoid allocations
+  const Eigen::MatrixXd smoothing_matrix_transpose = smoothing_matrix.transpose();
+  auto buffer = std::make_shared<Eigen::MatrixXd>();
   return [=](const Eigen::MatrixXd& /*values*/, Eigen::MatrixXd& filtered_values) {
-    for (auto row : filtered_values.rowwise())
-    {
-      row.transpose() = smoothing_matrix * row.transpose();
-    }
+    buffer->resize(filtered_values.rows(), filtered_values.cols());
+    buffer->noalias() = filtered_values * smoothing_matrix_transpose;
+    filtered_values.swap(*buffer);
     return true;
   };
 }
@@ -107,12 +109,14 @@ FilterFn enforce_position_bounds(const moveit::core::JointModelGroup* group)
  */
 FilterFn chain(const std::vector<FilterFn>& filter_functions)
 {
+  // The intermediate values are stored in a reused buffer, copying doesn't reallocate once the size is known
+  auto values_in = std::make_shared<Eigen::MatrixXd>();
   return [=](const Eigen::MatrixXd& values, Eigen::MatrixXd& filtered_values) {
-    Eigen::MatrixXd values_in = values;
+    *values_in = values;
     for (const auto& filter_fn : filter_functions)
     {
-      filter_fn(values_in, filtered_values);
-      values_in = filtered_values;
+      filter_fn(*values_in, filtered_values);
+      *values_in = filtered_values;
     }
     return true;
   };
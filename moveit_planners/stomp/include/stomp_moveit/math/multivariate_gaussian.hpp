@@ -47,6 +47,7 @@
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/shared_ptr.hpp>
+#include <cassert>
 #include <cstdlib>
 
 namespace stomp_moveit
@@ -73,6 +74,17 @@ public:
   template <typename Derived>
   void sample(Eigen::MatrixBase<Derived>& output, bool use_covariance = true);
 
+  /**
+   * @brief generates one random sample per column of the output matrix.
+   *
+   * All columns are drawn from the same random number generator and transformed with a single matrix product,
+   * which is considerably cheaper than calling sample() for each column.
+   * @param output          The random values, the row count must match the distribution size
+   * @param use_covariance  True to apply the covariance matrix onto the random values, false otherwise
+   */
+  template <typename Derived>
+  void sampleColumns(Eigen::MatrixBase<Derived>& output, bool use_covariance = true);
+
 private:
   Eigen::VectorXd mean_;                /**< Mean of the gaussian distribution */
   Eigen::MatrixXd covariance_;          /**< Covariance of the gaussian distribution */
@@ -111,5 +123,23 @@ void MultivariateGaussian::sample(Eigen::MatrixBase<Derived>& output, bool use_c
     output = mean_ + output;
   }
 }
+
+template <typename Derived>
+void MultivariateGaussian::sampleColumns(Eigen::MatrixBase<Derived>& output, bool use_covariance)
+{
+  assert(output.rows() == size_);
+  for (int j = 0; j < output.cols(); ++j)
+  {
+    for (int i = 0; i < size_; ++i)
+      output(i, j) = (*gaussian_)();
+  }
+
+  if (use_covariance)
+  {
+    // the cholesky factor is lower triangular, skip multiplying the upper zero block
+    output = covariance_cholesky_.triangularView<Eigen::Lower>() * output;
+  }
+  output.colwise() += mean_;
+}
 }  // namespace math
 }  // namespace stomp_moveit
@@ -80,24 +80,20 @@ NoiseGeneratorFn get_normal_distribution_generator(size_t num_timesteps, const s
   covariance = covariance.fullPivLu().inverse();
   covariance /= covariance.array().abs().matrix().maxCoeff();
 
-  // create random generators
-  std::vector<math::MultivariateGaussianPtr> rand_generators(stddev.size());
-  for (auto& r : rand_generators)
-  {
-    r = std::make_shared<math::MultivariateGaussian>(Eigen::VectorXd::Zero(num_timesteps), covariance);
-  }
+  // All joints share the same covariance, so a single generator samples the noise of all joints at once
+  auto rand_generator = std::make_shared<math::MultivariateGaussian>(Eigen::VectorXd::Zero(num_timesteps), covariance);
 
-  auto raw_noise = std::make_shared<Eigen::VectorXd>(num_timesteps);
+  // Preallocated buffers, reused for every rollout
+  const Eigen::VectorXd scale = Eigen::Map<const Eigen::VectorXd>(stddev.data(), stddev.size());
+  auto raw_noise = std::make_shared<Eigen::MatrixXd>(num_timesteps, stddev.size());
   NoiseGeneratorFn noise_generator_fn = [=](const Eigen::MatrixXd& values, Eigen::MatrixXd& noisy_values,
                                             Eigen::MatrixXd& noise) {
-    for (int i = 0; i < values.rows(); ++i)
-    {
-      rand_generators[i]->sample(*raw_noise);
-      raw_noise->head(1).setZero();
-      raw_noise->tail(1).setZero();  // zeroing out the start and end noise values
-      noise.row(i).transpose() = stddev.at(i) * (*raw_noise);
-      noisy_values.row(i) = values.row(i) + noise.row(i);
-    }
+    assert(values.rows() == scale.size());
+    rand_generator->sampleColumns(*raw_noise);
+    raw_noise->row(0).setZero();
+    raw_noise->row(raw_noise->rows() - 1).setZero();  // zeroing out the start and end noise values
+    noise = (*raw_noise * scale.asDiagonal()).transpose();
+    noisy_values = values + noise;
     return true;
   };
   return noise_generator_fn;
@@ -136,7 +136,8 @@ bool extractSeedTrajectory(const planning_interface::MotionPlanRequest& req,
 }
 
 // @brief Build a STOMP task that uses MoveIt callback types for planning in STOMP
-stomp::TaskPtr createStompTask(const stomp::StompConfiguration& config, StompPlanningContext& context)
+stomp::TaskPtr createStompTask(const stomp::StompConfiguration& config, StompPlanningContext& context,
+                               const stomp_moveit::Params& params)
 {
   const size_t num_timesteps = config.num_timesteps;
   const auto planning_scene = context.getPlanningScene();
@@ -151,17 +152,25 @@ stomp::TaskPtr createStompTask(const stomp::StompConfiguration& config, StompPla
   // Cost, noise and filter functions are provided for planning.
   // TODO(henningkayser): parameterize cost penalties
   using namespace stomp_moveit;
-  CostFn cost_fn;
+  // The pool lives as long as the cost functions that share it
+  std::shared_ptr<WorkerPool> worker_pool;
+  if (params.num_threads != 1)
+  {
+    worker_pool = std::make_shared<WorkerPool>(static_cast<size_t>(params.num_threads));
+  }
+  std::vector<CostFn> cost_functions = { costs::get_collision_cost_function(
+      planning_scene, group, 1.0 /* collision penalty */, worker_pool) };
   if (!constraints.empty())
   {
-    cost_fn = costs::sum({ costs::get_collision_cost_function(planning_scene, group, 1.0 /* collision penalty */),
-                           costs::get_constraints_cost_function(planning_scene, group, constraints.getAllConstraints(),
-                                                                1.0 /* constraint penalty */) });
+    cost_functions.push_back(costs::get_constraints_cost_function(
+        planning_scene, group, constraints.getAllConstraints(), 1.0 /* constraint penalty */, worker_pool));
   }
-  else
+  if (params.distance_field_cost_weight > 0.0)
   {
-    cost_fn = costs::get_collision_cost_function(planning_scene, group, 1.0 /* collision penalty */);
+    cost_functions.push_back(costs::get_distance_field_cost_function(
+        planning_scene, group, params.distance_field_clearance, params.distance_field_cost_weight, worker_pool));
   }
+  CostFn cost_fn = cost_functions.size() == 1 ? cost_functions.front() : costs::sum(cost_functions);
 
   // TODO(henningkayser): parameterize stddev
   const std::vector<double> stddev(group->getActiveJointModels().size(), 0.1);
@@ -232,7 +241,7 @@ bool StompPlanningContext::solve(planning_interface::MotionPlanResponse& res)
   {
     config.num_timesteps = input_trajectory->size();
   }
-  const auto task = createStompTask(config, *this);
+  const auto task = createStompTask(config, *this, params_);
   stomp_ = std::make_shared<stomp::Stomp>(config, task);
 
   std::condition_variable cv;
@@ -51,6 +51,7 @@
 #include <rclcpp/node.hpp>
 #include <rclcpp/parameter_value.hpp>
 #include <rclcpp/time.hpp>
+#include <future>
 #include <map>
 #include <memory>
 #include <queue>
@@ -102,8 +103,12 @@ class Ros2ControlManager : public moveit_controller_manager::MoveItControllerMan
 
   rclcpp::Time controllers_stamp_{ 0, 0, RCL_ROS_TIME };
 
+  /** @brief Response of an asynchronous list_controllers request that was not applied yet, if any. */
+  std::shared_future<controller_manager_msgs::srv::ListControllers::Response::SharedPtr> pending_discovery_;
+
   /**
-   * @brief Protects access to managed_controllers_, active_controllers_, allocators_, handles_, and controllers_stamp.
+   * @brief Protects access to managed_controllers_, active_controllers_, allocators_, handles_, controllers_stamp and
+   * pending_discovery_.
    */
   std::mutex controllers_mutex_;
 
@@ -127,19 +132,44 @@ class Ros2ControlManager : public moveit_controller_manager::MoveItControllerMan
   /**
    * \brief  Call list_controllers and populate managed_controllers_ and active_controllers_. Allocates handles if
    * needed.
-   * Throttled down to 1 Hz, controllers_mutex_ must be locked externally
-   * @param force force rediscover
+   * Unless forced, this never blocks: outdated controller information triggers an asynchronous list_controllers
+   * request, whose response is applied by the next call after it arrived. Requests are throttled down to 1 Hz,
+   * controllers_mutex_ must be locked externally
+   * @param force block until the controller information is rediscovered
    */
   void discover(bool force = false)
   {
-    // Skip if controller stamp is too new for new discovery, enforce update if force==true
-    if (!force && ((node_->now() - controllers_stamp_) < CONTROLLER_INFORMATION_VALIDITY_AGE))
+    if (pending_discovery_.valid())
     {
-      RCLCPP_WARN_STREAM(LOGGER, "Controller information from " << list_controllers_service_->get_service_name()
-                                                                << " is out of date, skipping discovery");
+      if (pending_discovery_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+      {
+        auto result = pending_discovery_.get();
+        pending_discovery_ = {};
+        applyControllerList(result);
+      }
+      else if ((node_->now() - controllers_stamp_).seconds() > SERVICE_CALL_TIMEOUT)
+      {
+        RCLCPP_WARN_STREAM(LOGGER, "Failed to read controllers from " << list_controllers_service_->get_service_name()
+                                                                      << " within " << SERVICE_CALL_TIMEOUT
+                                                                      << " seconds");
+        pending_discovery_ = {};
+      }
+    }
+
+    if (!force)
+    {
+      // Keep using the cached information if it is recent enough or a refresh is already underway
+      if (pending_discovery_.valid() || (node_->now() - controllers_stamp_) < CONTROLLER_INFORMATION_VALIDITY_AGE)
+        return;
+
+      controllers_stamp_ = node_->now();
+      auto request = std::make_shared<controller_manager_msgs::srv::ListControllers::Request>();
+      pending_discovery_ = list_controllers_service_->async_send_request(request).future.share();
       return;
     }
 
+    // a pending response is older than the one requested now
+    pending_discovery_ = {};
     controllers_stamp_ = node_->now();
 
     auto request = std::make_shared<controller_manager_msgs::srv::ListControllers::Request>();
@@ -151,11 +181,19 @@ class Ros2ControlManager : public moveit_controller_manager::MoveItControllerMan
                                                                     << " seconds");
       return;
     }
+    applyControllerList(result_future.get());
+  }
 
+  /**
+   * \brief Replace managed_controllers_ and active_controllers_ by the content of a list_controllers response.
+   * Allocates handles if needed, controllers_mutex_ must be locked externally
+   * @param result response of the list_controllers service
+   */
+  void applyControllerList(std::shared_ptr<controller_manager_msgs::srv::ListControllers::Response> result)
+  {
     managed_controllers_.clear();
     active_controllers_.clear();
 
-    auto result = result_future.get();
     if (!Ros2ControlManager::fixChainedControllers(result))
     {
       return;
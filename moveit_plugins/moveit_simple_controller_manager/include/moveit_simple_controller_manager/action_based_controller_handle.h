@@ -41,7 +41,10 @@
 #include <rclcpp_action/rclcpp_action.hpp>
 #include <moveit/controller_manager/controller_manager.h>
 #include <moveit/macros/class_forward.h>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace moveit_simple_controller_manager
 {
@@ -97,10 +100,12 @@ public:
   {
     if (!controller_action_client_)
       return false;
-    if (!done_)
+    std::uint64_t goal_id;
+    const auto goal = getCurrentGoal(goal_id);
+    if (!done_ && goal)
     {
       RCLCPP_INFO_STREAM(logger_, "Cancelling execution for " << name_);
-      auto cancel_result_future = controller_action_client_->async_cancel_goal(current_goal_);
+      auto cancel_result_future = controller_action_client_->async_cancel_goal(goal);
 
       const auto& result = cancel_result_future.get();
       if (!result)
@@ -125,11 +130,140 @@ public:
    * @return True if a result was received, false on timeout.
    */
   bool waitForExecution(const rclcpp::Duration& timeout = rclcpp::Duration::from_seconds(-1.0)) override
+  {
+    const auto start = node_->now();
+    while (true)
+    {
+      auto remaining = timeout;
+      if (timeout >= std::chrono::nanoseconds(0))
+      {
+        remaining = timeout - (node_->now() - start);
+        if (remaining < std::chrono::nanoseconds(0))
+          remaining = rclcpp::Duration::from_seconds(0.0);
+      }
+
+      std::uint64_t goal_id;
+      const auto goal = getCurrentGoal(goal_id);
+      if (!goal)
+      {
+        // nothing to wait for, unless a goal is being sent by another thread right now
+        if (done_)
+          return true;
+        if (timeout >= std::chrono::nanoseconds(0) && remaining <= std::chrono::nanoseconds(0))
+        {
+          RCLCPP_WARN(logger_, "waitForExecution timed out");
+          return false;
+        }
+        std::this_thread::sleep_for(10ms);
+        continue;
+      }
+      if (!waitForGoal(goal, goal_id, remaining))
+        return false;
+
+      // a spliced trajectory superseded the goal we waited for, continue with its replacement
+      if (isCurrentGoal(goal_id))
+        return true;
+    }
+  }
+
+  moveit_controller_manager::ExecutionStatus getLastExecutionStatus() override
+  {
+    return last_exec_;
+  }
+
+  void addJoint(const std::string& name) override
+  {
+    joints_.push_back(name);
+  }
+
+  void getJoints(std::vector<std::string>& joints) override
+  {
+    joints = joints_;
+  }
+
+protected:
+  /**
+   * @brief A pointer to the node, required to read parameters and get the time.
+   */
+  const rclcpp::Node::SharedPtr node_;
+
+  /**
+   * @brief Starts a new goal, to be called before the goal is sent. From then on, results of the goals it supersedes
+   * do not change the execution status, even if they arrive before the new goal is accepted.
+   * @return The identifier of the new goal.
+   */
+  std::uint64_t beginGoal()
+  {
+    std::scoped_lock lock(goal_mutex_);
+    current_goal_.reset();
+    return ++current_goal_id_;
+  }
+
+  /**
+   * @brief Stores the handle of an accepted goal, unless the goal was superseded in the meantime.
+   * @param goal_id The identifier returned by beginGoal() for the goal.
+   * @param goal The handle of the goal.
+   */
+  void setGoalHandle(std::uint64_t goal_id, const typename rclcpp_action::ClientGoalHandle<T>::SharedPtr& goal)
+  {
+    std::scoped_lock lock(goal_mutex_);
+    if (goal_id == current_goal_id_)
+      current_goal_ = goal;
+  }
+
+  /**
+   * @brief Makes a goal that is still executing the current goal again after the goal that was to supersede it was
+   * rejected, unless yet another goal was started in the meantime.
+   * @param goal_id The identifier returned by beginGoal() for the rejected goal.
+   * @param previous_goal_id The identifier of the goal to restore.
+   * @param previous_goal The handle of the goal to restore.
+   */
+  void restoreGoal(std::uint64_t goal_id, std::uint64_t previous_goal_id,
+                   const typename rclcpp_action::ClientGoalHandle<T>::SharedPtr& previous_goal)
+  {
+    std::scoped_lock lock(goal_mutex_);
+    if (goal_id != current_goal_id_)
+      return;
+    current_goal_id_ = previous_goal_id;
+    current_goal_ = previous_goal;
+  }
+
+  /**
+   * @brief Get the handle of the current goal, nullptr if it was not accepted (yet).
+   * @param goal_id Set to the identifier of the current goal.
+   */
+  typename rclcpp_action::ClientGoalHandle<T>::SharedPtr getCurrentGoal(std::uint64_t& goal_id)
+  {
+    std::scoped_lock lock(goal_mutex_);
+    goal_id = current_goal_id_;
+    return current_goal_;
+  }
+
+  /**
+   * @brief Check whether the goal with the given identifier has not been superseded by another goal.
+   */
+  bool isCurrentGoal(std::uint64_t goal_id)
+  {
+    std::scoped_lock lock(goal_mutex_);
+    return goal_id == current_goal_id_;
+  }
+
+  /**
+   * @brief Blocks waiting for the result of the given goal. Results of goals that were superseded by a spliced
+   * trajectory do not change the execution status.
+   * @param goal The goal to wait for.
+   * @param goal_id The identifier of the goal.
+   * @param timeout Duration to wait for a result before failing. Negative values indicate no timeout.
+   * @return True if a result was received, false on timeout.
+   */
+  bool waitForGoal(const typename rclcpp_action::ClientGoalHandle<T>::SharedPtr& goal, std::uint64_t goal_id,
+                   const rclcpp::Duration& timeout)
   {
     auto result_callback_done = std::make_shared<std::promise<bool>>();
     auto result_future = controller_action_client_->async_get_result(
-        current_goal_, [this, result_callback_done](const auto& wrapped_result) {
-          controllerDoneCallback(wrapped_result);
+        goal, [this, goal_id, result_callback_done](const auto& wrapped_result) {
+          if (isCurrentGoal(goal_id))
+            controllerDoneCallback(wrapped_result);
           result_callback_done->set_value(true);
         });
     if (timeout < std::chrono::nanoseconds(0))
@@ -167,27 +301,6 @@ public:
     return true;
   }
 
-  moveit_controller_manager::ExecutionStatus getLastExecutionStatus() override
-  {
-    return last_exec_;
-  }
-
-  void addJoint(const std::string& name) override
-  {
-    joints_.push_back(name);
-  }
-
-  void getJoints(std::vector<std::string>& joints) override
-  {
-    joints = joints_;
-  }
-
-protected:
-  /**
-   * @brief A pointer to the node, required to read parameters and get the time.
-   */
-  const rclcpp::Node::SharedPtr node_;
-
   /**
    * @brief Check if the controller's action server is ready to receive action goals.
    * @return True if the action server is ready, false if it is not ready or does not exist.
@@ -270,9 +383,19 @@ protected:
   typename rclcpp_action::Client<T>::SharedPtr controller_action_client_;
 
   /**
-   * @brief Current goal that has been sent to the action server.
+   * @brief Protects current_goal_ and current_goal_id_, which are accessed from executor and caller threads.
+   */
+  std::mutex goal_mutex_;
+
+  /**
+   * @brief Current goal that has been sent to the action server, nullptr until it was accepted.
    */
   typename rclcpp_action::ClientGoalHandle<T>::SharedPtr current_goal_;
+
+  /**
+   * @brief Identifier of the current goal, incremented by beginGoal() before each goal is sent.
+   */
+  std::uint64_t current_goal_id_ = 0;
 };
 
 }  // namespace moveit_simple_controller_manager
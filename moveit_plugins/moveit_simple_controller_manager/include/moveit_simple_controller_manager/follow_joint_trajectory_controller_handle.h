@@ -41,6 +41,7 @@
 #include <control_msgs/action/follow_joint_trajectory.hpp>
 #include <control_msgs/msg/joint_tolerance.hpp>
 #include <functional>
+#include <mutex>
 
 namespace moveit_simple_controller_manager
 {
@@ -52,15 +53,37 @@ class FollowJointTrajectoryControllerHandle
   : public ActionBasedControllerHandle<control_msgs::action::FollowJointTrajectory>
 {
 public:
+  /**
+   * @param feedback_period Minimum time in seconds between two processed feedback messages of the action server.
+   * Feedback is ignored if the value is not positive.
+   */
   FollowJointTrajectoryControllerHandle(const rclcpp::Node::SharedPtr& node, const std::string& name,
-                                        const std::string& action_ns)
+                                        const std::string& action_ns, double feedback_period = 0.0)
     : ActionBasedControllerHandle<control_msgs::action::FollowJointTrajectory>(
           node, name, action_ns, "moveit.simple_controller_manager.follow_joint_trajectory_controller_handle")
+    , feedback_period_(rclcpp::Duration::from_seconds(feedback_period))
   {
   }
 
   bool sendTrajectory(const moveit_msgs::msg::RobotTrajectory& trajectory) override;
 
+  /**
+   * @brief Sends the trajectory as a new goal while the current one is still executing.
+   *
+   * This relies on the trajectory replacement of the controller: it must keep executing the active trajectory up to
+   * the header stamp of the new one and replace the rest, as the joint_trajectory_controller of ROS 1 does. A
+   * controller that preempts the active goal by switching to the new trajectory as soon as it is received moves
+   * from its current state to the first waypoint of the new trajectory instead. The result of the preempted goal is
+   * ignored, the execution status follows the new goal.
+   */
+  bool spliceTrajectory(const moveit_msgs::msg::RobotTrajectory& trajectory) override;
+
+  /**
+   * @brief Get the most recent feedback message that passed the feedback throttling, or nullptr if none was received
+   * for the current trajectory.
+   */
+  std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback> getLastFeedback();
+
   // TODO(JafarAbdi): Revise parameter lookup
   // void configure(XmlRpc::XmlRpcValue& config) override;
 
@@ -72,7 +95,23 @@ protected:
       const rclcpp_action::ClientGoalHandle<control_msgs::action::FollowJointTrajectory>::WrappedResult& wrapped_result)
       override;
 
+  /**
+   * @brief Sends a single goal to the action server and makes it the current goal.
+   */
+  bool sendGoal(const control_msgs::action::FollowJointTrajectory::Goal& goal);
+
+  /**
+   * @brief Stores the feedback if at least feedback_period_ passed since the last stored feedback.
+   */
+  void feedbackCallback(const std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback>& feedback);
+
   control_msgs::action::FollowJointTrajectory::Goal goal_template_;
+
+  const rclcpp::Duration feedback_period_;
+
+  std::mutex feedback_mutex_;
+  std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback> last_feedback_;
+  rclcpp::Time last_feedback_time_;
 };
 
 }  // end namespace moveit_simple_controller_manager
@@ -153,13 +153,15 @@ public:
         [this](const rclcpp_action::Client<control_msgs::action::GripperCommand>::GoalHandle::SharedPtr&
                /* unused-arg */) { RCLCPP_DEBUG_STREAM(logger_, name_ << " started execution"); };
     // Send goal
+    const std::uint64_t goal_id = beginGoal();
     auto current_goal_future = controller_action_client_->async_send_goal(goal, send_goal_options);
-    current_goal_ = current_goal_future.get();
-    if (!current_goal_)
+    const auto goal_handle = current_goal_future.get();
+    if (!goal_handle)
     {
       RCLCPP_ERROR(logger_, "Goal was rejected by server");
       return false;
     }
+    setGoalHandle(goal_id, goal_handle);
 
     done_ = false;
     last_exec_ = moveit_controller_manager::ExecutionStatus::RUNNING;
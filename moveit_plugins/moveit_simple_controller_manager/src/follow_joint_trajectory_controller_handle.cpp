@@ -36,6 +36,8 @@
 /* Author: Michael Ferguson, Ioan Sucan, E. Gil Jones */
 
 #include <moveit_simple_controller_manager/follow_joint_trajectory_controller_handle.h>
+#include <action_msgs/msg/goal_status.hpp>
+#include <algorithm>
 
 using namespace std::placeholders;
 
@@ -63,10 +65,21 @@ bool FollowJointTrajectoryControllerHandle::sendTrajectory(const moveit_msgs::ms
     RCLCPP_INFO_STREAM(logger_, "sending continuation for the currently executed trajectory to " << name_);
   }
 
+  done_ = false;
+  last_exec_ = moveit_controller_manager::ExecutionStatus::RUNNING;
+  {
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    last_feedback_.reset();
+  }
+
   control_msgs::action::FollowJointTrajectory::Goal goal = goal_template_;
   goal.trajectory = trajectory.joint_trajectory;
   goal.multi_dof_trajectory = trajectory.multi_dof_joint_trajectory;
+  return sendGoal(goal);
+}
 
+bool FollowJointTrajectoryControllerHandle::sendGoal(const control_msgs::action::FollowJointTrajectory::Goal& goal)
+{
   rclcpp_action::Client<control_msgs::action::FollowJointTrajectory>::SendGoalOptions send_goal_options;
   // Active callback
   send_goal_options.goal_response_callback =
@@ -82,21 +95,82 @@ bool FollowJointTrajectoryControllerHandle::sendTrajectory(const moveit_msgs::ms
           RCLCPP_INFO(logger_, "Goal request accepted!");
         }
       };
+  if (feedback_period_ > rclcpp::Duration::from_seconds(0.0))
+  {
+    send_goal_options.feedback_callback =
+        [this](const rclcpp_action::Client<control_msgs::action::FollowJointTrajectory>::GoalHandle::SharedPtr&,
+               const std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback>& feedback) {
+          feedbackCallback(feedback);
+        };
+  }
 
-  done_ = false;
-  last_exec_ = moveit_controller_manager::ExecutionStatus::RUNNING;
+  // The controller preempts the goal this one supersedes when it receives it, so the results of the superseded goal
+  // are ignored from now on
+  std::uint64_t previous_goal_id;
+  const auto previous_goal = getCurrentGoal(previous_goal_id);
+  const std::uint64_t goal_id = beginGoal();
 
   // Send goal
   auto current_goal_future = controller_action_client_->async_send_goal(goal, send_goal_options);
-  current_goal_ = current_goal_future.get();
-  if (!current_goal_)
+  const auto goal_handle = current_goal_future.get();
+  if (!goal_handle)
   {
     RCLCPP_ERROR(logger_, "Goal was rejected by server");
+    // a rejected goal does not preempt anything, keep following the goal that is still executing
+    const int8_t previous_status =
+        previous_goal ? previous_goal->get_status() : action_msgs::msg::GoalStatus::STATUS_UNKNOWN;
+    if (previous_status == action_msgs::msg::GoalStatus::STATUS_ACCEPTED ||
+        previous_status == action_msgs::msg::GoalStatus::STATUS_EXECUTING ||
+        previous_status == action_msgs::msg::GoalStatus::STATUS_CANCELING)
+    {
+      restoreGoal(goal_id, previous_goal_id, previous_goal);
+    }
+    else
+    {
+      last_exec_ = moveit_controller_manager::ExecutionStatus::FAILED;
+      done_ = true;
+    }
     return false;
   }
+  setGoalHandle(goal_id, goal_handle);
   return true;
 }
 
+void FollowJointTrajectoryControllerHandle::feedbackCallback(
+    const std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback>& feedback)
+{
+  const rclcpp::Time now = node_->now();
+  std::lock_guard<std::mutex> lock(feedback_mutex_);
+  if (last_feedback_ && now - last_feedback_time_ < feedback_period_)
+    return;
+  last_feedback_ = feedback;
+  last_feedback_time_ = now;
+}
+
+std::shared_ptr<const control_msgs::action::FollowJointTrajectory::Feedback>
+FollowJointTrajectoryControllerHandle::getLastFeedback()
+{
+  std::lock_guard<std::mutex> lock(feedback_mutex_);
+  return last_feedback_;
+}
+
+bool FollowJointTrajectoryControllerHandle::spliceTrajectory(const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  if (done_)
+  {
+    RCLCPP_ERROR_STREAM(logger_, "Cannot splice a trajectory: " << name_ << " is not executing a trajectory");
+    return false;
+  }
+
+  // the controller merges trajectories at the header stamp of the newer goal and cancels the older goal
+  if (rclcpp::Time(trajectory.joint_trajectory.header.stamp).nanoseconds() == 0)
+  {
+    RCLCPP_ERROR_STREAM(logger_, "Cannot splice a trajectory without a start time into " << name_);
+    return false;
+  }
+  return sendTrajectory(trajectory);
+}
+
 // TODO(JafarAbdi): Revise parameter lookup
 // void FollowJointTrajectoryControllerHandle::configure(XmlRpc::XmlRpcValue& config)
 //{
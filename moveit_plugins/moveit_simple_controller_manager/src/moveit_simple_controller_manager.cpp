@@ -178,7 +178,12 @@ public:
         }
         else if (type == "FollowJointTrajectory")
         {
-          new_handle = std::make_shared<FollowJointTrajectoryControllerHandle>(node_, controller_name, action_ns);
+          double feedback_period;
+          node_->get_parameter_or(makeParameterName(PARAM_BASE_NAME, controller_name, "feedback_period"),
+                                  feedback_period, 0.0);
+
+          new_handle = std::make_shared<FollowJointTrajectoryControllerHandle>(node_, controller_name, action_ns,
+                                                                               feedback_period);
           RCLCPP_INFO_STREAM(LOGGER, "Added FollowJointTrajectory controller for " << controller_name);
           controllers_[controller_name] = new_handle;
         }
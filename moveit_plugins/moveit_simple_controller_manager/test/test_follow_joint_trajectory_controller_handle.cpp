@@ -0,0 +1,221 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit_simple_controller_manager/follow_joint_trajectory_controller_handle.h>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using FollowJointTrajectory = control_msgs::action::FollowJointTrajectory;
+using ServerGoalHandle = rclcpp_action::ServerGoalHandle<FollowJointTrajectory>;
+
+namespace
+{
+// Action server standing in for a trajectory controller, which the tests complete goals of by hand
+class FakeController
+{
+public:
+  FakeController(const rclcpp::Node::SharedPtr& node, const std::string& action_name)
+  {
+    server_ = rclcpp_action::create_server<FollowJointTrajectory>(
+        node, action_name,
+        [this](const rclcpp_action::GoalUUID& /*uuid*/, const std::shared_ptr<const FollowJointTrajectory::Goal>&) {
+          if (on_goal)
+            on_goal();
+          return reject_goals ? rclcpp_action::GoalResponse::REJECT :
+                                rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+        },
+        [](const std::shared_ptr<ServerGoalHandle>& /*goal*/) { return rclcpp_action::CancelResponse::ACCEPT; },
+        [this](const std::shared_ptr<ServerGoalHandle>& goal) {
+          std::scoped_lock lock(mutex_);
+          goals_.push_back(goal);
+        });
+  }
+
+  std::shared_ptr<ServerGoalHandle> getGoal(std::size_t index)
+  {
+    std::scoped_lock lock(mutex_);
+    return index < goals_.size() ? goals_[index] : nullptr;
+  }
+
+  // called before a goal is accepted or rejected
+  std::function<void()> on_goal;
+  bool reject_goals = false;
+
+private:
+  rclcpp_action::Server<FollowJointTrajectory>::SharedPtr server_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ServerGoalHandle>> goals_;
+};
+
+// Exposes the connection check of the handle
+class Handle : public moveit_simple_controller_manager::FollowJointTrajectoryControllerHandle
+{
+public:
+  using FollowJointTrajectoryControllerHandle::FollowJointTrajectoryControllerHandle;
+  using FollowJointTrajectoryControllerHandle::isConnected;
+};
+
+moveit_msgs::msg::RobotTrajectory makeTrajectory(const rclcpp::Time& stamp)
+{
+  moveit_msgs::msg::RobotTrajectory trajectory;
+  trajectory.joint_trajectory.header.stamp = stamp;
+  trajectory.joint_trajectory.joint_names = { "joint" };
+  trajectory.joint_trajectory.points.resize(2);
+  trajectory.joint_trajectory.points[0].positions = { 0.0 };
+  trajectory.joint_trajectory.points[1].positions = { 1.0 };
+  trajectory.joint_trajectory.points[1].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  return trajectory;
+}
+}  // namespace
+
+class FollowJointTrajectoryControllerHandleTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("follow_joint_trajectory_controller_handle_test");
+    controller_ = std::make_unique<FakeController>(node_, "controller/follow_joint_trajectory");
+    executor_.add_node(node_);
+    spin_thread_ = std::thread([this] { executor_.spin(); });
+
+    handle_ = std::make_shared<Handle>(node_, "controller", "follow_joint_trajectory");
+    handle_->addJoint("joint");
+    const auto start = std::chrono::steady_clock::now();
+    while (!handle_->isConnected() && std::chrono::steady_clock::now() - start < 10s)
+      std::this_thread::sleep_for(10ms);
+    ASSERT_TRUE(handle_->isConnected());
+  }
+
+  void TearDown() override
+  {
+    executor_.cancel();
+    spin_thread_.join();
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  std::unique_ptr<FakeController> controller_;
+  rclcpp::executors::MultiThreadedExecutor executor_;
+  std::thread spin_thread_;
+  std::shared_ptr<Handle> handle_;
+};
+
+TEST_F(FollowJointTrajectoryControllerHandleTest, ReportsResultOfGoal)
+{
+  ASSERT_TRUE(handle_->sendTrajectory(makeTrajectory(rclcpp::Time(0, 0, RCL_ROS_TIME))));
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::RUNNING);
+  auto goal = controller_->getGoal(0);
+  ASSERT_TRUE(goal);
+  goal->succeed(std::make_shared<FollowJointTrajectory::Result>());
+  EXPECT_TRUE(handle_->waitForExecution(rclcpp::Duration::from_seconds(10.0)));
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::SUCCEEDED);
+}
+
+TEST_F(FollowJointTrajectoryControllerHandleTest, IgnoresResultOfSplicedGoal)
+{
+  ASSERT_TRUE(handle_->sendTrajectory(makeTrajectory(rclcpp::Time(0, 0, RCL_ROS_TIME))));
+  auto first = controller_->getGoal(0);
+  ASSERT_TRUE(first);
+  auto waiting = std::async(std::launch::async,
+                            [this] { return handle_->waitForExecution(rclcpp::Duration::from_seconds(10.0)); });
+
+  // like a trajectory controller, preempt the active goal as soon as the new one arrives, before accepting it
+  controller_->on_goal = [first] {
+    auto result = std::make_shared<FollowJointTrajectory::Result>();
+    first->abort(result);
+  };
+  ASSERT_TRUE(handle_->spliceTrajectory(makeTrajectory(node_->now() + rclcpp::Duration::from_seconds(0.5))));
+  auto second = controller_->getGoal(1);
+  ASSERT_TRUE(second);
+
+  // the aborted goal does not end the execution
+  EXPECT_EQ(waiting.wait_for(200ms), std::future_status::timeout);
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::RUNNING);
+
+  second->succeed(std::make_shared<FollowJointTrajectory::Result>());
+  EXPECT_TRUE(waiting.get());
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::SUCCEEDED);
+}
+
+TEST_F(FollowJointTrajectoryControllerHandleTest, RejectedSpliceKeepsFollowingActiveGoal)
+{
+  ASSERT_TRUE(handle_->sendTrajectory(makeTrajectory(rclcpp::Time(0, 0, RCL_ROS_TIME))));
+  auto first = controller_->getGoal(0);
+  ASSERT_TRUE(first);
+
+  controller_->reject_goals = true;
+  EXPECT_FALSE(handle_->spliceTrajectory(makeTrajectory(node_->now() + rclcpp::Duration::from_seconds(0.5))));
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::RUNNING);
+
+  first->succeed(std::make_shared<FollowJointTrajectory::Result>());
+  EXPECT_TRUE(handle_->waitForExecution(rclcpp::Duration::from_seconds(10.0)));
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::SUCCEEDED);
+}
+
+TEST_F(FollowJointTrajectoryControllerHandleTest, RejectedGoalFails)
+{
+  controller_->reject_goals = true;
+  EXPECT_FALSE(handle_->sendTrajectory(makeTrajectory(rclcpp::Time(0, 0, RCL_ROS_TIME))));
+  EXPECT_TRUE(handle_->waitForExecution(rclcpp::Duration::from_seconds(1.0)));
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::FAILED);
+}
+
+TEST_F(FollowJointTrajectoryControllerHandleTest, CancelsCurrentGoal)
+{
+  ASSERT_TRUE(handle_->sendTrajectory(makeTrajectory(rclcpp::Time(0, 0, RCL_ROS_TIME))));
+  ASSERT_TRUE(handle_->spliceTrajectory(makeTrajectory(node_->now() + rclcpp::Duration::from_seconds(0.5))));
+  auto second = controller_->getGoal(1);
+  ASSERT_TRUE(second);
+
+  EXPECT_TRUE(handle_->cancelExecution());
+  EXPECT_TRUE(second->is_canceling());
+  EXPECT_EQ(handle_->getLastExecutionStatus(), moveit_controller_manager::ExecutionStatus::PREEMPTED);
+}
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  testing::InitGoogleTest(&argc, argv);
+  const int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
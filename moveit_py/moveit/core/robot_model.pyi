@@ -33,6 +33,8 @@ class RobotModel:
     def name(self) -> Any: ...
     @property
     def root_joint_name(self) -> Any: ...
+    @property
+    def variable_names(self) -> Any: ...
 
 class VariableBounds:
     def __init__(self, *args, **kwargs) -> None: ...
@@ -6,6 +6,7 @@ class RobotState:
     joint_efforts: Any
     joint_positions: Any
     joint_velocities: Any
+    variable_positions: Any
     def __init__(self, *args, **kwargs) -> None: ...
     def clear_attached_bodies(self, *args, **kwargs) -> Any: ...
     def get_frame_transform(self, *args, **kwargs) -> Any: ...
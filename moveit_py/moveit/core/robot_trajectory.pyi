@@ -3,8 +3,12 @@ from typing import Any
 class RobotTrajectory:
     joint_model_group_name: Any
     def __init__(self, *args, **kwargs) -> None: ...
+    def apply_ruckig_smoothing(self, *args, **kwargs) -> Any: ...
+    def apply_totg_time_parameterization(self, *args, **kwargs) -> Any: ...
     def get_robot_trajectory_msg(self, *args, **kwargs) -> Any: ...
     def get_waypoint_durations(self, *args, **kwargs) -> Any: ...
+    def get_waypoint_positions(self, *args, **kwargs) -> Any: ...
+    def get_waypoint_velocities(self, *args, **kwargs) -> Any: ...
     def set_robot_trajectory_msg(self, *args, **kwargs) -> Any: ...
     def unwind(self, *args, **kwargs) -> Any: ...
     def __getitem__(self, index) -> Any: ...
@@ -17,3 +21,20 @@ class RobotTrajectory:
     def duration(self) -> Any: ...
     @property
     def robot_model(self) -> Any: ...
+
+class TimedPath:
+    def __init__(self, *args, **kwargs) -> None: ...
+    @property
+    def accelerations(self) -> Any: ...
+    @property
+    def positions(self) -> Any: ...
+    @property
+    def success(self) -> Any: ...
+    @property
+    def time_from_start(self) -> Any: ...
+    @property
+    def valid(self) -> Any: ...
+    @property
+    def velocities(self) -> Any: ...
+
+def retime_paths(*args, **kwargs) -> Any: ...
@@ -71,6 +71,59 @@ moveit_msgs::msg::PlanningScene get_planning_scene_msg(std::shared_ptr<planning_
   return planning_scene_msg;
 }
 
+namespace
+{
+// Evaluate check on a copy of the current state for every row of positions, without holding the GIL
+template <typename Check>
+Eigen::Matrix<bool, Eigen::Dynamic, 1>
+checkStates(const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+            const std::string& joint_model_group_name, const Eigen::Ref<const JointPositionMatrix>& positions,
+            const Check& check)
+{
+  const moveit::core::JointModelGroup* group =
+      planning_scene->getRobotModel()->getJointModelGroup(joint_model_group_name);
+  if (!group)
+    throw std::invalid_argument("Unknown joint model group '" + joint_model_group_name + "'");
+  if (static_cast<std::size_t>(positions.cols()) != group->getVariableCount())
+  {
+    throw std::invalid_argument("Expected an array with " + std::to_string(group->getVariableCount()) +
+                                " columns for group '" + joint_model_group_name + "', got " +
+                                std::to_string(positions.cols()));
+  }
+
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> results(positions.rows());
+  py::gil_scoped_release release;
+  moveit::core::RobotState state(planning_scene->getCurrentState());
+  for (Eigen::Index i = 0; i < positions.rows(); ++i)
+  {
+    state.setJointGroupPositions(group, positions.row(i).data());
+    state.update();
+    results[i] = check(state);
+  }
+  return results;
+}
+}  // namespace
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1>
+are_states_colliding(const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                     const std::string& joint_model_group_name, const Eigen::Ref<const JointPositionMatrix>& positions)
+{
+  return checkStates(planning_scene, joint_model_group_name, positions,
+                     [&](const moveit::core::RobotState& state) {
+                       return planning_scene->isStateColliding(state, joint_model_group_name);
+                     });
+}
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1>
+are_states_valid(const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                 const std::string& joint_model_group_name, const Eigen::Ref<const JointPositionMatrix>& positions)
+{
+  return checkStates(planning_scene, joint_model_group_name, positions,
+                     [&](const moveit::core::RobotState& state) {
+                       return planning_scene->isStateValid(state, joint_model_group_name);
+                     });
+}
+
 void init_planning_scene(py::module& m)
 {
   py::module planning_scene = m.def_submodule("planning_scene");
@@ -216,14 +269,15 @@ void init_planning_scene(py::module& m)
            This method will remove all collision object from the scene except for attached collision objects.
            )")
 
-      // checking state validity
+      // checking state validity; these release the GIL, so other Python threads run during collision checking
       .def("is_state_valid",
            py::overload_cast<const moveit::core::RobotState&, const std::string&, bool>(
                &planning_scene::PlanningScene::isStateValid, py::const_),
-           py::arg("robot_state"), py::arg("joint_model_group_name"), py::arg("verbose") = false)
+           py::arg("robot_state"), py::arg("joint_model_group_name"), py::arg("verbose") = false,
+           py::call_guard<py::gil_scoped_release>())
       .def("is_state_colliding",
            py::overload_cast<const std::string&, bool>(&planning_scene::PlanningScene::isStateColliding),
-           py::arg("joint_model_group_name"), py::arg("verbose") = false,
+           py::arg("joint_model_group_name"), py::arg("verbose") = false, py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -238,6 +292,7 @@ void init_planning_scene(py::module& m)
            py::overload_cast<const moveit::core::RobotState&, const std::string&, bool>(
                &planning_scene::PlanningScene::isStateColliding, py::const_),
            py::arg("robot_state"), py::arg("joint_model_group_name"), py::arg("verbose") = false,
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -253,6 +308,7 @@ void init_planning_scene(py::module& m)
            py::overload_cast<const moveit::core::RobotState&, const moveit_msgs::msg::Constraints&, bool>(
                &planning_scene::PlanningScene::isStateConstrained, py::const_),
            py::arg("state"), py::arg("constraints"), py::arg("verbose") = false,
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state fulfills the passed constraints
 
@@ -268,7 +324,7 @@ void init_planning_scene(py::module& m)
            py::overload_cast<const robot_trajectory::RobotTrajectory&, const std::string&, bool,
                              std::vector<std::size_t>*>(&planning_scene::PlanningScene::isPathValid, py::const_),
            py::arg("trajectory"), py::arg("joint_model_group_name"), py::arg("verbose") = false,
-           py::arg("invalid_index") = nullptr,
+           py::arg("invalid_index") = nullptr, py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if a given path is valid. Each state is checked for validity (collision avoidance and feasibility)
 
@@ -282,12 +338,36 @@ void init_planning_scene(py::module& m)
                bool: true if the path is valid otherwise false.
            )")
 
+      .def("are_states_colliding", &moveit_py::bind_planning_scene::are_states_colliding,
+           py::arg("joint_model_group_name"), py::arg("joint_positions"),
+           R"(
+           Check a batch of states for collisions. Variables outside of the group keep the values of the current state.
+
+	   Args:
+               joint_model_group_name (str): The name of the group to check collision for.
+               joint_positions (:py:class:`numpy.ndarray`): An N x dof array holding the positions of the group variables of one state per row. C-contiguous float64 arrays are read without copying.
+           Returns:
+               :py:class:`numpy.ndarray`: N booleans, true for the states that are in collision.
+           )")
+
+      .def("are_states_valid", &moveit_py::bind_planning_scene::are_states_valid, py::arg("joint_model_group_name"),
+           py::arg("joint_positions"),
+           R"(
+           Check a batch of states for validity, like is_state_valid. Variables outside of the group keep the values of the current state.
+
+	   Args:
+               joint_model_group_name (str): The name of the group to check.
+               joint_positions (:py:class:`numpy.ndarray`): An N x dof array holding the positions of the group variables of one state per row. C-contiguous float64 arrays are read without copying.
+           Returns:
+               :py:class:`numpy.ndarray`: N booleans, true for the states that are valid.
+           )")
+
       // TODO (peterdavidfagan): remove collision result from input parameters and write separate binding code.
       // TODO (peterdavidfagan): consider merging check_collision and check_collision_unpadded into one function with unpadded_param
       .def("check_collision",
            py::overload_cast<const collision_detection::CollisionRequest&, collision_detection::CollisionResult&>(
                &planning_scene::PlanningScene::checkCollision),
-           py::arg("collision_request"), py::arg("collision_result"),
+           py::arg("collision_request"), py::arg("collision_result"), py::call_guard<py::gil_scoped_release>(),
            R"(
            Check whether the current state is in collision, and if needed, updates the collision transforms of the current state before the computation.
 
@@ -303,6 +383,7 @@ void init_planning_scene(py::module& m)
            py::overload_cast<const collision_detection::CollisionRequest&, collision_detection::CollisionResult&,
                              moveit::core::RobotState&>(&planning_scene::PlanningScene::checkCollision, py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -320,6 +401,7 @@ void init_planning_scene(py::module& m)
                              moveit::core::RobotState&, const collision_detection::AllowedCollisionMatrix&>(
                &planning_scene::PlanningScene::checkCollision, py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"), py::arg("acm"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -336,7 +418,7 @@ void init_planning_scene(py::module& m)
       .def("check_collision_unpadded",
            py::overload_cast<const collision_detection::CollisionRequest&, collision_detection::CollisionResult&>(
                &planning_scene::PlanningScene::checkCollisionUnpadded),
-           py::arg("req"), py::arg("result"),
+           py::arg("req"), py::arg("result"), py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -353,6 +435,7 @@ void init_planning_scene(py::module& m)
                              moveit::core::RobotState&>(&planning_scene::PlanningScene::checkCollisionUnpadded,
                                                         py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -370,6 +453,7 @@ void init_planning_scene(py::module& m)
                              moveit::core::RobotState&, const collision_detection::AllowedCollisionMatrix&>(
                &planning_scene::PlanningScene::checkCollisionUnpadded, py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"), py::arg("acm"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -386,7 +470,7 @@ void init_planning_scene(py::module& m)
       .def("check_self_collision",
            py::overload_cast<const collision_detection::CollisionRequest&, collision_detection::CollisionResult&>(
                &planning_scene::PlanningScene::checkSelfCollision),
-           py::arg("collision_request"), py::arg("collision_result"),
+           py::arg("collision_request"), py::arg("collision_result"), py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -402,6 +486,7 @@ void init_planning_scene(py::module& m)
            py::overload_cast<const collision_detection::CollisionRequest&, collision_detection::CollisionResult&,
                              moveit::core::RobotState&>(&planning_scene::PlanningScene::checkSelfCollision, py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
@@ -419,6 +504,7 @@ void init_planning_scene(py::module& m)
                              moveit::core::RobotState&, const collision_detection::AllowedCollisionMatrix&>(
                &planning_scene::PlanningScene::checkSelfCollision, py::const_),
            py::arg("collision_request"), py::arg("collision_result"), py::arg("state"), py::arg("acm"),
+           py::call_guard<py::gil_scoped_release>(),
            R"(
            Check if the robot state is in collision.
 
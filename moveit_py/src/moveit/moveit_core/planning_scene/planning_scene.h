@@ -58,6 +58,17 @@ Eigen::MatrixXd get_frame_transform(std::shared_ptr<planning_scene::PlanningScen
 
 moveit_msgs::msg::PlanningScene get_planning_scene_msg(std::shared_ptr<planning_scene::PlanningScene>& planning_scene);
 
+/// Joint positions of several states, one state per row
+using JointPositionMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1>
+are_states_colliding(const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                     const std::string& joint_model_group_name, const Eigen::Ref<const JointPositionMatrix>& positions);
+
+Eigen::Matrix<bool, Eigen::Dynamic, 1>
+are_states_valid(const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                 const std::string& joint_model_group_name, const Eigen::Ref<const JointPositionMatrix>& positions);
+
 void init_planning_scene(py::module& m);
 }  // namespace bind_planning_scene
 }  // namespace moveit_py
@@ -120,6 +120,11 @@ void init_robot_model(py::module& m)
               str: Formatted string containing generic robot model information.
           )")
 
+      .def_property("variable_names", &moveit::core::RobotModel::getVariableNames, nullptr,
+                    R"(
+                    list of str: The names of the variables of the robot model, in the order they are stored in a robot state.
+                    )")
+
       // Interacting with joint model groups
       .def_property("joint_model_group_names", &moveit::core::RobotModel::getJointModelGroupNames, nullptr,
                     R"(
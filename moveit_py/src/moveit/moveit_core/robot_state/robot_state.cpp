@@ -158,6 +158,27 @@ void set_joint_efforts(moveit::core::RobotState* self, std::map<std::string, dou
   }
 }
 
+py::array_t<double> get_variable_positions(const py::object& self)
+{
+  // the array aliases the memory of the state and keeps the state alive through its base object
+  const auto* state = self.cast<const moveit::core::RobotState*>();
+  py::array_t<double> positions({ static_cast<py::ssize_t>(state->getVariableCount()) },
+                                { static_cast<py::ssize_t>(sizeof(double)) }, state->getVariablePositions(), self);
+  // writes would bypass the dirty flags of the state, so they go through set_variable_positions instead
+  py::detail::array_proxy(positions.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+  return positions;
+}
+
+void set_variable_positions(moveit::core::RobotState* self, const Eigen::Ref<const Eigen::VectorXd>& positions)
+{
+  if (static_cast<std::size_t>(positions.size()) != self->getVariableCount())
+  {
+    throw std::invalid_argument("Expected " + std::to_string(self->getVariableCount()) + " variable positions, got " +
+                                std::to_string(positions.size()));
+  }
+  self->setVariablePositions(positions.data());
+}
+
 Eigen::VectorXd copy_joint_group_positions(const moveit::core::RobotState* self,
                                            const std::string& joint_model_group_name)
 {
@@ -341,6 +362,12 @@ void init_robot_state(py::module& m)
       .def_property("joint_efforts", &moveit_py::bind_robot_state::get_joint_efforts,
                     &moveit_py::bind_robot_state::set_joint_efforts, py::return_value_policy::copy)
 
+      .def_property("variable_positions", &moveit_py::bind_robot_state::get_variable_positions,
+                    &moveit_py::bind_robot_state::set_variable_positions,
+                    R"(
+                    :py:class:`numpy.ndarray`: The positions of all variables, in the order of RobotModel.variable_names. Reading returns a read-only view of the memory of the state, without copying, which reflects later changes of the state. Assigning an array copies it into the state.
+                    )")
+
       .def("set_joint_group_positions",
            py::overload_cast<const std::string&, const Eigen::VectorXd&>(
                &moveit::core::RobotState::setJointGroupPositions),
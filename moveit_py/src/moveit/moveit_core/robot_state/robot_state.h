@@ -39,6 +39,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <moveit_py/moveit_py_utils/copy_ros_msg.h>
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <moveit/robot_state/robot_state.h>
@@ -57,6 +58,10 @@ Eigen::MatrixXd get_global_link_transform(const moveit::core::RobotState* self,
 
 geometry_msgs::msg::Pose get_pose(const moveit::core::RobotState* self, const std::string& link_name);
 
+py::array_t<double> get_variable_positions(const py::object& self);
+
+void set_variable_positions(moveit::core::RobotState* self, const Eigen::Ref<const Eigen::VectorXd>& positions);
+
 Eigen::VectorXd copy_joint_group_positions(const moveit::core::RobotState* self,
                                            const std::string& joint_model_group_name);
 Eigen::VectorXd copy_joint_group_velocities(const moveit::core::RobotState* self,
@@ -36,6 +36,12 @@
 
 #include "robot_trajectory.h"
 #include <moveit_py/moveit_py_utils/ros_msg_typecasters.h>
+#include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
 
 namespace moveit_py
 {
@@ -57,6 +63,168 @@ set_robot_trajectory_msg(const std::shared_ptr<robot_trajectory::RobotTrajectory
   return robot_trajectory->setRobotTrajectoryMsg(robot_state, msg);
 }
 
+namespace
+{
+// Copy the variables of the trajectory group, or of the whole robot if there is no group, into one row per waypoint
+template <typename GroupCopy, typename StateValues>
+WaypointMatrix get_waypoint_values(const robot_trajectory::RobotTrajectory& robot_trajectory,
+                                   const GroupCopy& group_copy, const StateValues& state_values)
+{
+  const moveit::core::JointModelGroup* group = robot_trajectory.getGroup();
+  const std::size_t columns = group ? group->getVariableCount() : robot_trajectory.getRobotModel()->getVariableCount();
+  WaypointMatrix values(robot_trajectory.getWayPointCount(), columns);
+  for (std::size_t i = 0; i < robot_trajectory.getWayPointCount(); ++i)
+  {
+    const moveit::core::RobotState& waypoint = robot_trajectory.getWayPoint(i);
+    if (group)
+      group_copy(waypoint, group, values.row(i).data());
+    else
+      std::copy_n(state_values(waypoint), columns, values.row(i).data());
+  }
+  return values;
+}
+}  // namespace
+
+WaypointMatrix get_waypoint_positions(const robot_trajectory::RobotTrajectory& robot_trajectory)
+{
+  return get_waypoint_values(
+      robot_trajectory,
+      [](const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group, double* values) {
+        state.copyJointGroupPositions(group, values);
+      },
+      [](const moveit::core::RobotState& state) { return state.getVariablePositions(); });
+}
+
+WaypointMatrix get_waypoint_velocities(const robot_trajectory::RobotTrajectory& robot_trajectory)
+{
+  return get_waypoint_values(
+      robot_trajectory,
+      [](const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group, double* values) {
+        state.copyJointGroupVelocities(group, values);
+      },
+      [](const moveit::core::RobotState& state) { return state.getVariableVelocities(); });
+}
+
+bool apply_totg_time_parameterization(robot_trajectory::RobotTrajectory& robot_trajectory,
+                                      double velocity_scaling_factor, double acceleration_scaling_factor,
+                                      double path_tolerance, double resample_dt, double min_angle_change)
+{
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg(path_tolerance, resample_dt, min_angle_change);
+  return totg.computeTimeStamps(robot_trajectory, velocity_scaling_factor, acceleration_scaling_factor);
+}
+
+bool apply_ruckig_smoothing(robot_trajectory::RobotTrajectory& robot_trajectory, double velocity_scaling_factor,
+                            double acceleration_scaling_factor, bool mitigate_overshoot, double overshoot_threshold)
+{
+  return trajectory_processing::RuckigSmoothing::applySmoothing(robot_trajectory, velocity_scaling_factor,
+                                                                acceleration_scaling_factor, mitigate_overshoot,
+                                                                overshoot_threshold);
+}
+
+std::vector<TimedPath> retime_paths(const std::shared_ptr<const moveit::core::RobotModel>& robot_model,
+                                    const std::string& joint_model_group_name, const PathArray& paths,
+                                    const std::string& algorithm, double velocity_scaling_factor,
+                                    double acceleration_scaling_factor,
+                                    const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                                    std::size_t num_threads, double path_tolerance, double resample_dt,
+                                    double min_angle_change)
+{
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup(joint_model_group_name);
+  if (!group)
+    throw std::invalid_argument("Unknown joint model group '" + joint_model_group_name + "'");
+  if (algorithm != "totg" && algorithm != "ruckig")
+    throw std::invalid_argument("Unknown time parameterization algorithm '" + algorithm +
+                                "', expected 'totg' or 'ruckig'");
+  if (paths.ndim() != 3)
+    throw std::invalid_argument("Expected an array of shape (N, T, dof), got " + std::to_string(paths.ndim()) +
+                                " dimensions");
+  if (static_cast<std::size_t>(paths.shape(2)) != group->getVariableCount())
+  {
+    throw std::invalid_argument("Expected paths with " + std::to_string(group->getVariableCount()) +
+                                " variables for group '" + joint_model_group_name + "', got " +
+                                std::to_string(paths.shape(2)));
+  }
+  if (planning_scene && planning_scene->getRobotModel() != robot_model)
+    throw std::invalid_argument("The planning scene is for a different robot model");
+
+  const std::size_t path_count = paths.shape(0);
+  const std::size_t waypoint_count = paths.shape(1);
+  const std::size_t dof = paths.shape(2);
+  const double* const data = paths.data();
+  std::vector<TimedPath> timed_paths(path_count);
+
+  py::gil_scoped_release release;
+  moveit::core::RobotState reference_state(robot_model);
+  if (planning_scene)
+    reference_state = planning_scene->getCurrentState();
+  else
+    reference_state.setToDefaultValues();
+
+  // the workers take the next path from a shared counter, so long and short paths balance out
+  std::atomic<std::size_t> next_path(0);
+  const auto worker = [&] {
+    trajectory_processing::TimeOptimalTrajectoryGeneration totg(path_tolerance, resample_dt, min_angle_change);
+    trajectory_processing::RuckigSmoothing::Workspace ruckig_workspace;
+    moveit::core::RobotState state(reference_state);
+    for (std::size_t i = next_path++; i < path_count; i = next_path++)
+    {
+      robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+      const double* path = data + i * waypoint_count * dof;
+      for (std::size_t j = 0; j < waypoint_count; ++j)
+      {
+        state.setJointGroupPositions(group, path + j * dof);
+        trajectory.addSuffixWayPoint(state, 0.0);
+      }
+
+      TimedPath& timed_path = timed_paths[i];
+      // Ruckig smooths a timed trajectory, so it starts from the TOTG result
+      timed_path.success =
+          totg.computeTimeStamps(trajectory, velocity_scaling_factor, acceleration_scaling_factor) &&
+          (algorithm != "ruckig" ||
+           trajectory_processing::RuckigSmoothing::applySmoothing(ruckig_workspace, trajectory, velocity_scaling_factor,
+                                                                  acceleration_scaling_factor));
+      if (!timed_path.success)
+        continue;
+
+      if (planning_scene)
+      {
+        for (std::size_t j = 0; j < trajectory.getWayPointCount(); ++j)
+          trajectory.getWayPointPtr(j)->update();
+        timed_path.valid = planning_scene->isPathValid(trajectory, joint_model_group_name);
+      }
+      else
+        timed_path.valid = true;
+
+      timed_path.time_from_start.resize(trajectory.getWayPointCount());
+      double time = 0.0;
+      for (std::size_t j = 0; j < trajectory.getWayPointCount(); ++j)
+      {
+        time += trajectory.getWayPointDurationFromPrevious(j);
+        timed_path.time_from_start[j] = time;
+      }
+      timed_path.positions = get_waypoint_positions(trajectory);
+      timed_path.velocities = get_waypoint_velocities(trajectory);
+      timed_path.accelerations = get_waypoint_values(
+          trajectory,
+          [](const moveit::core::RobotState& waypoint, const moveit::core::JointModelGroup* jmg, double* values) {
+            waypoint.copyJointGroupAccelerations(jmg, values);
+          },
+          [](const moveit::core::RobotState& waypoint) { return waypoint.getVariableAccelerations(); });
+    }
+  };
+
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, path_count);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+  return timed_paths;
+}
+
 void init_robot_trajectory(py::module& m)
 {
   py::module robot_trajectory = m.def_submodule("robot_trajectory");
@@ -146,8 +314,112 @@ void init_robot_trajectory(py::module& m)
            py::arg("robot_state"), py::arg("msg"),
            R"(
            Set the trajectory from a moveit_msgs.msg.RobotTrajectory message.
+           )")
+
+      .def("get_waypoint_positions", &moveit_py::bind_robot_trajectory::get_waypoint_positions,
+           py::return_value_policy::move,
+           R"(
+           Get the positions of all waypoints. The array is filled once and handed to Python without further copies.
+
+           Returns:
+               :py:class:`numpy.ndarray`: An N x dof array with the positions of the group variables, or of all variables if the trajectory has no group, of one waypoint per row.
+           )")
+
+      .def("get_waypoint_velocities", &moveit_py::bind_robot_trajectory::get_waypoint_velocities,
+           py::return_value_policy::move,
+           R"(
+           Get the velocities of all waypoints. The array is filled once and handed to Python without further copies.
+
+           Returns:
+               :py:class:`numpy.ndarray`: An N x dof array with the velocities of the group variables, or of all variables if the trajectory has no group, of one waypoint per row.
+           )")
+
+      .def("apply_totg_time_parameterization", &moveit_py::bind_robot_trajectory::apply_totg_time_parameterization,
+           py::arg("velocity_scaling_factor"), py::arg("acceleration_scaling_factor"), py::arg("path_tolerance") = 0.1,
+           py::arg("resample_dt") = 0.1, py::arg("min_angle_change") = 0.001, py::call_guard<py::gil_scoped_release>(),
+           R"(
+           Adds time parameterization to the trajectory using the Time-Optimal Trajectory Generation (TOTG) algorithm. The GIL is released during the computation.
+
+           Args:
+               velocity_scaling_factor (float): The velocity scaling factor.
+               acceleration_scaling_factor (float): The acceleration scaling factor.
+               path_tolerance (float): The path tolerance to use for time parameterization (default: 0.1).
+               resample_dt (float): The time step to use for time parameterization (default: 0.1).
+               min_angle_change (float): The minimum angle change to use for time parameterization (default: 0.001).
+           Returns:
+               bool: True if the trajectory was successfully retimed, false otherwise.
+           )")
+
+      .def("apply_ruckig_smoothing", &moveit_py::bind_robot_trajectory::apply_ruckig_smoothing,
+           py::arg("velocity_scaling_factor"), py::arg("acceleration_scaling_factor"),
+           py::arg("mitigate_overshoot") = false, py::arg("overshoot_threshold") = 0.01,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(
+           Applies Ruckig smoothing to the trajectory. The GIL is released during the computation.
+
+           Args:
+               velocity_scaling_factor (float): The velocity scaling factor.
+               acceleration_scaling_factor (float): The acceleration scaling factor.
+               mitigate_overshoot (bool): Whether to check the trajectory for overshoot and retry with longer durations (default: False).
+               overshoot_threshold (float): The maximum allowed overshoot, in radians (default: 0.01).
+           Returns:
+               bool: True if the trajectory was successfully smoothed, false otherwise.
            )");
   // TODO (peterdavidfagan): support other methods such as appending trajectories
+
+  py::class_<TimedPath>(robot_trajectory, "TimedPath",
+                        R"(
+                        A path retimed by retime_paths.
+                        )")
+      .def_readonly("success", &TimedPath::success,
+                    R"(
+                    bool: Whether the time parameterization succeeded. The arrays are empty otherwise.
+                    )")
+      .def_readonly("valid", &TimedPath::valid,
+                    R"(
+                    bool: Whether all waypoints are valid in the planning scene, true if no planning scene was given.
+                    )")
+      .def_readonly("time_from_start", &TimedPath::time_from_start,
+                    R"(
+                    :py:class:`numpy.ndarray`: The time of each waypoint from the start of the path.
+                    )")
+      .def_readonly("positions", &TimedPath::positions,
+                    R"(
+                    :py:class:`numpy.ndarray`: The group positions of one waypoint per row.
+                    )")
+      .def_readonly("velocities", &TimedPath::velocities,
+                    R"(
+                    :py:class:`numpy.ndarray`: The group velocities of one waypoint per row.
+                    )")
+      .def_readonly("accelerations", &TimedPath::accelerations,
+                    R"(
+                    :py:class:`numpy.ndarray`: The group accelerations of one waypoint per row.
+                    )");
+
+  robot_trajectory.def("retime_paths", &moveit_py::bind_robot_trajectory::retime_paths, py::arg("robot_model"),
+                       py::arg("joint_model_group_name"), py::arg("paths"), py::arg("algorithm") = "totg",
+                       py::arg("velocity_scaling_factor") = 1.0, py::arg("acceleration_scaling_factor") = 1.0,
+                       py::arg("planning_scene") = nullptr, py::arg("num_threads") = 0,
+                       py::arg("path_tolerance") = 0.1, py::arg("resample_dt") = 0.1,
+                       py::arg("min_angle_change") = 0.001,
+                       R"(
+                       Time parameterize and validate a batch of joint space paths in parallel. The GIL is released during the computation.
+
+                       Args:
+                           robot_model (:py:class:`moveit_py.core.RobotModel`): The robot model of the paths.
+                           joint_model_group_name (str): The group whose variables the paths hold.
+                           paths (:py:class:`numpy.ndarray`): An (N, T, dof) array of N paths of T waypoints each. C-contiguous float64 arrays are read without copying.
+                           algorithm (str): "totg" for Time-Optimal Trajectory Generation, or "ruckig" to additionally smooth the TOTG result with Ruckig (default: "totg").
+                           velocity_scaling_factor (float): The velocity scaling factor (default: 1.0).
+                           acceleration_scaling_factor (float): The acceleration scaling factor (default: 1.0).
+                           planning_scene (:py:class:`moveit_py.core.PlanningScene`): If given, the timed paths are checked for validity in this scene, and variables outside of the group keep the values of its current state (default: None).
+                           num_threads (int): The number of threads, 0 for one per hardware thread (default: 0).
+                           path_tolerance (float): The path tolerance of TOTG (default: 0.1).
+                           resample_dt (float): The time step TOTG resamples the paths with (default: 0.1).
+                           min_angle_change (float): The minimum angle change of TOTG (default: 0.001).
+                       Returns:
+                           list of :py:class:`moveit_py.core.TimedPath`: One timed path per input path, in the input order.
+                       )");
 }
 }  // namespace bind_robot_trajectory
 }  // namespace moveit_py
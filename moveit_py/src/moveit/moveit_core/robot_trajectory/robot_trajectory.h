@@ -39,6 +39,8 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit_msgs/msg/robot_trajectory.hpp>
 
@@ -55,6 +57,45 @@ robot_trajectory::RobotTrajectory
 set_robot_trajectory_msg(const std::shared_ptr<robot_trajectory::RobotTrajectory>& robot_trajectory,
                          const moveit::core::RobotState& robot_state, const moveit_msgs::msg::RobotTrajectory& msg);
 
+/// Values of all waypoints, one waypoint per row
+using WaypointMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+WaypointMatrix get_waypoint_positions(const robot_trajectory::RobotTrajectory& robot_trajectory);
+
+WaypointMatrix get_waypoint_velocities(const robot_trajectory::RobotTrajectory& robot_trajectory);
+
+bool apply_totg_time_parameterization(robot_trajectory::RobotTrajectory& robot_trajectory,
+                                      double velocity_scaling_factor, double acceleration_scaling_factor,
+                                      double path_tolerance, double resample_dt, double min_angle_change);
+
+bool apply_ruckig_smoothing(robot_trajectory::RobotTrajectory& robot_trajectory, double velocity_scaling_factor,
+                            double acceleration_scaling_factor, bool mitigate_overshoot, double overshoot_threshold);
+
+/// A path of retime_paths, timed and validated
+struct TimedPath
+{
+  /// Whether the time parameterization succeeded
+  bool success = false;
+  /// Whether all waypoints are valid in the planning scene, true if no scene was given
+  bool valid = false;
+  /// Time of each waypoint from the start of the path
+  Eigen::VectorXd time_from_start;
+  WaypointMatrix positions;
+  WaypointMatrix velocities;
+  WaypointMatrix accelerations;
+};
+
+/// Paths of joint model group positions, of shape (N, T, dof)
+using PathArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+std::vector<TimedPath> retime_paths(const std::shared_ptr<const moveit::core::RobotModel>& robot_model,
+                                    const std::string& joint_model_group_name, const PathArray& paths,
+                                    const std::string& algorithm, double velocity_scaling_factor,
+                                    double acceleration_scaling_factor,
+                                    const std::shared_ptr<planning_scene::PlanningScene>& planning_scene,
+                                    std::size_t num_threads, double path_tolerance, double resample_dt,
+                                    double min_angle_change);
+
 void init_robot_trajectory(py::module& m);
 }  // namespace bind_robot_trajectory
 }  // namespace moveit_py
@@ -130,9 +130,9 @@ void init_moveit_py(py::module& m)
       .def("execute",
            py::overload_cast<const robot_trajectory::RobotTrajectoryPtr&, const std::vector<std::string>&>(
                &moveit_cpp::MoveItCpp::execute),
-           py::arg("robot_trajectory"), py::arg("controllers"),
+           py::arg("robot_trajectory"), py::arg("controllers"), py::call_guard<py::gil_scoped_release>(),
            R"(
-	   Execute a trajectory (planning group is inferred from robot trajectory object).
+	   Execute a trajectory (planning group is inferred from robot trajectory object). The GIL is released until the execution finishes.
 	   )")
       .def("get_planning_component", &moveit_py::bind_moveit_cpp::get_planning_component,
            py::arg("planning_component_name"), py::return_value_policy::take_ownership,
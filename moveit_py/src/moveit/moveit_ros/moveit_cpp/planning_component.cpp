@@ -326,8 +326,9 @@ void init_planning_component(py::module& m)
       .def("plan", &moveit_py::bind_planning_component::plan, py::arg("single_plan_parameters") = nullptr,
            py::arg("multi_plan_parameters") = nullptr, py::arg("solution_selection_function") = nullptr,
            py::arg("stopping_criterion_callback") = nullptr, py::return_value_policy::move,
+           py::call_guard<py::gil_scoped_release>(),
            R"(
-           Plan a motion plan using the current start and goal states.
+           Plan a motion plan using the current start and goal states. The GIL is released while planning; Python callbacks acquire it when they are called.
 
 	   Args:
                plan_parameters (moveit_py.core.PlanParameters): The parameters to use for planning.
@@ -113,6 +113,28 @@ class TestRobotState(unittest.TestCase):
             robot_state.get_joint_group_positions("panda_arm").tolist(),
         )
 
+    def test_variable_positions(self):
+        """
+        Test that variable positions are a read-only view of the state
+        """
+        robot_model = get_robot_model()
+        robot_state = RobotState(robot_model)
+        robot_state.set_to_default_values()
+        positions = robot_state.variable_positions
+
+        self.assertEqual(len(positions), len(robot_model.variable_names))
+        self.assertFalse(positions.flags.writeable)
+        with self.assertRaises(ValueError):
+            positions[0] = 1.0
+
+        # the view reflects changes of the state
+        new_positions = np.arange(len(positions), dtype=float) * 0.01
+        robot_state.variable_positions = new_positions
+        self.assertEqual(positions.tolist(), new_positions.tolist())
+
+        with self.assertRaises(ValueError):
+            robot_state.variable_positions = np.zeros(len(positions) + 1)
+
     def test_set_joint_group_velocities(self):
         """
         Test that the joint group velocities can be set
@@ -46,6 +46,7 @@
 #include <moveit/warehouse/constraints_storage.h>
 #include <moveit/warehouse/trajectory_constraints_storage.h>
 #include <moveit/moveit_cpp/moveit_cpp.h>
+#include <moveit/moveit_cpp/planning_component.h>
 #include <warehouse_ros/database_loader.h>
 #include <pluginlib/class_loader.hpp>
 
@@ -196,6 +197,19 @@ protected:
   /// Execute the given motion plan request on the set of planners for the set number of runs
   void runBenchmark(moveit_msgs::msg::MotionPlanRequest request, const BenchmarkOptions& options);
 
+  /// Solve the request of a single run with a planning component that is configured for this run
+  typedef std::function<void(moveit_cpp::PlanningComponent& planning_component,
+                             const planning_scene::PlanningScenePtr& planning_scene,
+                             planning_interface::MotionPlanDetailedResponse& response)>
+      SolveFunction;
+
+  /// Execute all runs of a single planner configuration and append the results to benchmark_data_.
+  /// With more than one parallel run (0 for one per hardware thread), the runs are distributed over workers on the
+  /// planning executor that each plan on their own copy of the planning scene. Pre-run events, post-run events and
+  /// the collected metrics are still invoked and ordered by run, so the results are written in the same order.
+  void runPlanner(moveit_msgs::msg::MotionPlanRequest& request, const SolveFunction& solve,
+                  const BenchmarkOptions& options, int parallel_runs, const std::function<void()>& run_completed);
+
   std::shared_ptr<planning_scene_monitor::PlanningSceneMonitor> planning_scene_monitor_;
   std::shared_ptr<moveit_warehouse::PlanningSceneStorage> planning_scene_storage_;
   std::shared_ptr<moveit_warehouse::PlanningSceneWorldStorage> planning_scene_world_storage_;
@@ -57,6 +57,8 @@ namespace moveit_ros_benchmarks
 ///     parameters:
 ///         name: # Experiment name
 ///         runs: # Number of experiment runs
+///         parallel_runs: # Number of runs executed at the same time (1 by default, 0 for one per hardware thread)
+///         cpu_affinity: # CPU cores the parallel runs are pinned to, e.g. a set of isolated cores (optional)
 ///         group: # Joint group name
 ///         timeout: # Experiment timeout
 ///         output_directory: # Output directory for results file
@@ -103,6 +105,8 @@ struct BenchmarkOptions
 
   /// Benchmark parameters
   int runs;                                   // Number of experiment runs
+  int parallel_runs;                          // Number of runs executed at the same time, 0 for hardware threads
+  std::vector<int> cpu_affinity;              // CPU cores the workers of parallel runs are pinned to
   double timeout;                             // Experiment timeout
   std::string benchmark_name;                 // Experiment name
   std::string group_name;                     // Joint group name
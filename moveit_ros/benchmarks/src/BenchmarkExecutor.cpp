@@ -51,13 +51,21 @@
 #undef BOOST_ALLOW_DEPRECATED_HEADERS
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <limits>
 #include <filesystem>
+#include <thread>
 #ifndef _WIN32
 #include <unistd.h>
 #else
 #include <winsock2.h>
 #endif
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #undef max
 
@@ -65,6 +73,58 @@ using namespace moveit_ros_benchmarks;
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.benchmarks.BenchmarkExecutor");
 
+namespace
+{
+/// Number of workers used for the given number of parallel runs, where 0 means one per hardware thread
+std::size_t getNumWorkers(int parallel_runs, int runs)
+{
+  std::size_t num_workers = parallel_runs > 0 ? static_cast<std::size_t>(parallel_runs) :
+                                                std::max(1u, std::thread::hardware_concurrency());
+  return std::min(num_workers, static_cast<std::size_t>(std::max(runs, 0)));
+}
+
+/// Pins the calling thread to a CPU core while in scope, so that runs executed in parallel do not migrate between cores
+class ScopedCpuAffinity
+{
+public:
+  /// Pin to \e cpu, or leave the affinity unchanged if \e cpu is negative
+  explicit ScopedCpuAffinity(int cpu)
+  {
+    if (cpu < 0)
+      return;
+#ifdef __linux__
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previous_), &previous_) != 0)
+      return;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    pinned_ = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+    if (!pinned_)
+      RCLCPP_WARN(LOGGER, "Failed to pin benchmark worker to CPU %d", cpu);
+#else
+    RCLCPP_WARN(LOGGER, "Pinning benchmark workers to CPU cores is not supported on this platform");
+#endif
+  }
+
+  ~ScopedCpuAffinity()
+  {
+#ifdef __linux__
+    if (pinned_)
+      pthread_setaffinity_np(pthread_self(), sizeof(previous_), &previous_);
+#endif
+  }
+
+  ScopedCpuAffinity(const ScopedCpuAffinity&) = delete;
+  ScopedCpuAffinity& operator=(const ScopedCpuAffinity&) = delete;
+
+private:
+#ifdef __linux__
+  cpu_set_t previous_;
+#endif
+  bool pinned_ = false;
+};
+}  // namespace
+
 template <class Clock, class Duration>
 boost::posix_time::ptime toBoost(const std::chrono::time_point<Clock, Duration>& from)
 {
@@ -633,10 +693,12 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
     return true;
   }
 
+  // fetch all matching queries at once, instead of one database round trip per query
+  std::vector<moveit_warehouse::MotionPlanRequestWithMetadata> planning_queries;
   std::vector<std::string> query_names;
   try
   {
-    planning_scene_storage_->getPlanningQueriesNames(regex, query_names, scene_name);
+    planning_scene_storage_->getPlanningQueries(regex, planning_queries, query_names, scene_name);
   }
   catch (std::exception& ex)
   {
@@ -650,22 +712,12 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
     return false;
   }
 
-  for (const std::string& query_name : query_names)
+  queries.reserve(queries.size() + planning_queries.size());
+  for (std::size_t i = 0; i < planning_queries.size(); ++i)
   {
-    moveit_warehouse::MotionPlanRequestWithMetadata planning_query;
-    try
-    {
-      planning_scene_storage_->getPlanningQuery(planning_query, scene_name, query_name);
-    }
-    catch (std::exception& ex)
-    {
-      RCLCPP_ERROR(LOGGER, "Error loading motion planning query '%s': %s", query_name.c_str(), ex.what());
-      continue;
-    }
-
     BenchmarkRequest query;
-    query.name = query_name;
-    query.request = static_cast<moveit_msgs::msg::MotionPlanRequest>(*planning_query);
+    query.name = query_names[i];
+    query.request = static_cast<moveit_msgs::msg::MotionPlanRequest>(*planning_queries[i]);
     queries.push_back(query);
   }
   RCLCPP_INFO(LOGGER, "Loaded queries successfully");
@@ -811,26 +863,13 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
   boost::progress_display progress(num_planners * options.runs, std::cout);
 
   // Iterate through all planning pipelines
-  auto planning_pipelines = moveit_cpp_->getPlanningPipelines();
   for (const std::pair<const std::string, std::vector<std::string>>& pipeline_entry : options.planning_pipelines)
   {
     // Iterate through all planners configured for the pipeline
     for (const std::string& planner_id : pipeline_entry.second)
     {
-      // This container stores all of the benchmark data for this planner
-      PlannerBenchmarkData planner_data(options.runs);
-      // This vector stores all motion plan results for further evaluation
-      std::vector<planning_interface::MotionPlanDetailedResponse> responses(options.runs);
-      std::vector<bool> solved(options.runs);
-
       request.planner_id = planner_id;
 
-      // Planner start events
-      for (PlannerStartEventFunction& planner_start_function : planner_start_functions_)
-      {
-        planner_start_function(request, planner_data);
-      }
-
       moveit_cpp::PlanningComponent::PlanRequestParameters plan_req_params = {
         .planner_id = planner_id,
         .planning_pipeline = pipeline_entry.first,
@@ -840,67 +879,20 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
         .max_acceleration_scaling_factor = request.max_acceleration_scaling_factor
       };
 
-      // Iterate runs
-      for (int j = 0; j < options.runs; ++j)
-      {
-        // Pre-run events
-        for (PreRunEventFunction& pre_event_function : pre_event_functions_)
-          pre_event_function(request);
-
-        // Create planning component
-        auto planning_component = std::make_shared<moveit_cpp::PlanningComponent>(request.group_name, moveit_cpp_);
-        moveit::core::RobotState start_state(planning_scene_monitor_->getRobotModel());
-        moveit::core::robotStateMsgToRobotState(request.start_state, start_state);
-
-        planning_component->setStartState(start_state);
-        planning_component->setGoal(request.goal_constraints);
-        planning_component->setPathConstraints(request.path_constraints);
-        planning_component->setTrajectoryConstraints(request.trajectory_constraints);
-
-        // Solve problem
-        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-
-        // Planning pipeline benchmark
-        auto const response = planning_component->plan(plan_req_params, planning_scene_);
-
-        solved[j] = bool(response.error_code);
-
-        responses[j].error_code = response.error_code;
-        if (response.trajectory)
-        {
-          responses[j].description.push_back("plan");
-          responses[j].trajectory.push_back(response.trajectory);
-          responses[j].processing_time.push_back(response.planning_time);
-        }
-
-        std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
-        double total_time = dt.count();
-
-        // Collect data
-        start = std::chrono::system_clock::now();
-
-        // Post-run events
-        for (PostRunEventFunction& post_event_fn : post_event_functions_)
+      // Planning pipeline benchmark
+      const SolveFunction solve = [&plan_req_params](moveit_cpp::PlanningComponent& planning_component,
+                                                     const planning_scene::PlanningScenePtr& planning_scene,
+                                                     planning_interface::MotionPlanDetailedResponse& response) {
+        auto const plan_response = planning_component.plan(plan_req_params, planning_scene);
+        response.error_code = plan_response.error_code;
+        if (plan_response.trajectory)
         {
-          post_event_fn(request, responses[j], planner_data[j]);
+          response.description.push_back("plan");
+          response.trajectory.push_back(plan_response.trajectory);
+          response.processing_time.push_back(plan_response.planning_time);
         }
-        collectMetrics(planner_data[j], responses[j], solved[j], total_time);
-        dt = std::chrono::system_clock::now() - start;
-        double metriconstraints_storage_time = dt.count();
-        RCLCPP_DEBUG(LOGGER, "Spent %lf seconds collecting metrics", metriconstraints_storage_time);
-
-        ++progress;
-      }
-
-      computeAveragePathSimilarities(planner_data, responses, solved);
-
-      // Planner completion events
-      for (PlannerCompletionEventFunction& planner_completion_fn : planner_completion_functions_)
-      {
-        planner_completion_fn(request, planner_data);
-      }
-
-      benchmark_data_.push_back(planner_data);
+      };
+      runPlanner(request, solve, options, options.parallel_runs, [&progress] { ++progress; });
     }
   }
 
@@ -910,18 +902,6 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
     for (const std::pair<const std::string, std::vector<std::pair<std::string, std::string>>>& parallel_pipeline_entry :
          options.parallel_planning_pipelines)
     {
-      // This container stores all of the benchmark data for this planner
-      PlannerBenchmarkData planner_data(options.runs);
-      // This vector stores all motion plan results for further evaluation
-      std::vector<planning_interface::MotionPlanDetailedResponse> responses(options.runs);
-      std::vector<bool> solved(options.runs);
-
-      // Planner start events
-      for (PlannerStartEventFunction& planner_start_function : planner_start_functions_)
-      {
-        planner_start_function(request, planner_data);
-      }
-
       // Create multi-pipeline request
       moveit_cpp::PlanningComponent::MultiPipelinePlanRequestParameters multi_pipeline_plan_request;
       for (auto const& pipeline_planner_id_pair : parallel_pipeline_entry.second)
@@ -937,74 +917,152 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
         multi_pipeline_plan_request.plan_request_parameter_vector.push_back(plan_req_params);
       }
 
-      // Iterate runs
-      for (int j = 0; j < options.runs; ++j)
-      {
-        // Pre-run events
-        for (PreRunEventFunction& pre_event_function : pre_event_functions_)
-        {
-          pre_event_function(request);
-        }
-
-        // Create planning component
-        auto planning_component = std::make_shared<moveit_cpp::PlanningComponent>(request.group_name, moveit_cpp_);
-        moveit::core::RobotState start_state(planning_scene_monitor_->getRobotModel());
-        moveit::core::robotStateMsgToRobotState(request.start_state, start_state);
-
-        planning_component->setStartState(start_state);
-        planning_component->setGoal(request.goal_constraints);
-        planning_component->setPathConstraints(request.path_constraints);
-        planning_component->setTrajectoryConstraints(request.trajectory_constraints);
-
-        // Solve problem
-        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-
+      const SolveFunction solve = [&multi_pipeline_plan_request](
+                                      moveit_cpp::PlanningComponent& planning_component,
+                                      const planning_scene::PlanningScenePtr& planning_scene,
+                                      planning_interface::MotionPlanDetailedResponse& response) {
         auto const t1 = std::chrono::system_clock::now();
-        auto const response = planning_component->plan(multi_pipeline_plan_request,
-                                                       &moveit::planning_pipeline_interfaces::getShortestSolution,
-                                                       nullptr, planning_scene_);
+        auto const plan_response = planning_component.plan(
+            multi_pipeline_plan_request, &moveit::planning_pipeline_interfaces::getShortestSolution, nullptr,
+            planning_scene);
         auto const t2 = std::chrono::system_clock::now();
 
-        solved[j] = bool(response.error_code);
-
-        responses[j].error_code = response.error_code;
-        if (response.trajectory)
+        response.error_code = plan_response.error_code;
+        if (plan_response.trajectory)
         {
-          responses[j].description.push_back("plan");
-          responses[j].trajectory.push_back(response.trajectory);
-          responses[j].processing_time.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+          response.description.push_back("plan");
+          response.trajectory.push_back(plan_response.trajectory);
+          response.processing_time.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
         }
+      };
+      // The pipelines of a single run already plan in parallel on the planning executor. Runs started from the same
+      // executor would plan them one after the other, so these runs are always executed sequentially.
+      runPlanner(request, solve, options, 1, [&progress] { ++progress; });
+    }
+  }
+}
 
-        std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
-        double total_time = dt.count();
+void BenchmarkExecutor::runPlanner(moveit_msgs::msg::MotionPlanRequest& request, const SolveFunction& solve,
+                                   const BenchmarkOptions& options, int parallel_runs,
+                                   const std::function<void()>& run_completed)
+{
+  // This container stores all of the benchmark data for this planner
+  PlannerBenchmarkData planner_data(options.runs);
+  // This vector stores all motion plan results for further evaluation
+  std::vector<planning_interface::MotionPlanDetailedResponse> responses(options.runs);
+  std::vector<bool> solved(options.runs);
+  std::vector<double> total_times(options.runs);
+
+  // Planner start events
+  for (PlannerStartEventFunction& planner_start_function : planner_start_functions_)
+  {
+    planner_start_function(request, planner_data);
+  }
 
-        // Collect data
-        start = std::chrono::system_clock::now();
-        // Post-run events
-        for (PostRunEventFunction& post_event_fn : post_event_functions_)
-        {
-          post_event_fn(request, responses[j], planner_data[j]);
-        }
+  const auto solve_run = [&](const moveit_msgs::msg::MotionPlanRequest& run_request,
+                             const planning_scene::PlanningScenePtr& planning_scene, int j) {
+    // Create planning component
+    moveit_cpp::PlanningComponent planning_component(run_request.group_name, moveit_cpp_);
+    moveit::core::RobotState start_state(planning_scene_monitor_->getRobotModel());
+    moveit::core::robotStateMsgToRobotState(run_request.start_state, start_state);
+
+    planning_component.setStartState(start_state);
+    planning_component.setGoal(run_request.goal_constraints);
+    planning_component.setPathConstraints(run_request.path_constraints);
+    planning_component.setTrajectoryConstraints(run_request.trajectory_constraints);
+
+    // Solve problem
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    solve(planning_component, planning_scene, responses[j]);
+    solved[j] = bool(responses[j].error_code);
+    std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
+    total_times[j] = dt.count();
+  };
+
+  const auto collect_run = [&](const moveit_msgs::msg::MotionPlanRequest& run_request, int j) {
+    // Collect data
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+
+    // Post-run events
+    for (PostRunEventFunction& post_event_fn : post_event_functions_)
+    {
+      post_event_fn(run_request, responses[j], planner_data[j]);
+    }
+    collectMetrics(planner_data[j], responses[j], solved[j], total_times[j]);
+    std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
+    double metriconstraints_storage_time = dt.count();
+    RCLCPP_DEBUG(LOGGER, "Spent %lf seconds collecting metrics", metriconstraints_storage_time);
 
-        collectMetrics(planner_data[j], responses[j], solved[j], total_time);
-        dt = std::chrono::system_clock::now() - start;
-        double metriconstraints_storage_time = dt.count();
-        RCLCPP_DEBUG(LOGGER, "Spent %lf seconds collecting metrics", metriconstraints_storage_time);
+    run_completed();
+  };
 
-        ++progress;
+  const std::size_t num_workers = getNumWorkers(parallel_runs, options.runs);
+  if (num_workers <= 1)
+  {
+    // Iterate runs
+    for (int j = 0; j < options.runs; ++j)
+    {
+      // Pre-run events
+      for (PreRunEventFunction& pre_event_function : pre_event_functions_)
+      {
+        pre_event_function(request);
       }
-
-      computeAveragePathSimilarities(planner_data, responses, solved);
-
-      // Planner completion events
-      for (PlannerCompletionEventFunction& planner_completion_fn : planner_completion_functions_)
+      solve_run(request, planning_scene_, j);
+      collect_run(request, j);
+    }
+  }
+  else
+  {
+    // Pre-run events are invoked in the order of the runs before any run is started
+    std::vector<moveit_msgs::msg::MotionPlanRequest> run_requests(options.runs);
+    for (int j = 0; j < options.runs; ++j)
+    {
+      for (PreRunEventFunction& pre_event_function : pre_event_functions_)
       {
-        planner_completion_fn(request, planner_data);
+        pre_event_function(request);
       }
+      run_requests[j] = request;
+    }
 
-      benchmark_data_.push_back(planner_data);
+    // Each worker plans on its own copy of the planning scene and picks up the next run once it finishes one. Planning
+    // components started from an executor task plan on the thread of that task, so the runs of a worker are pinned
+    // together with the worker.
+    const auto& executor = moveit_cpp_->getPlanningExecutor();
+    if (executor->getThreadCount() < num_workers)
+    {
+      RCLCPP_WARN(LOGGER, "The planning executor has %zu threads, only that many of the %zu parallel runs are executed "
+                  "at the same time", executor->getThreadCount(), num_workers);
     }
+    std::atomic<int> next_run{ 0 };
+    std::vector<std::future<void>> workers;
+    workers.reserve(num_workers);
+    for (std::size_t w = 0; w < num_workers; ++w)
+    {
+      const int cpu = options.cpu_affinity.empty() ? -1 : options.cpu_affinity[w % options.cpu_affinity.size()];
+      const planning_scene::PlanningScenePtr planning_scene = planning_scene::PlanningScene::clone(planning_scene_);
+      workers.push_back(executor->submit([&, cpu, planning_scene] {
+        ScopedCpuAffinity affinity(cpu);
+        for (int j = next_run++; j < options.runs; j = next_run++)
+          solve_run(run_requests[j], planning_scene, j);
+      }));
+    }
+    for (std::future<void>& worker : workers)
+      worker.get();
+
+    // Post-run events and metrics are collected in the order of the runs, so the output does not depend on timing
+    for (int j = 0; j < options.runs; ++j)
+      collect_run(run_requests[j], j);
   }
+
+  computeAveragePathSimilarities(planner_data, responses, solved);
+
+  // Planner completion events
+  for (PlannerCompletionEventFunction& planner_completion_fn : planner_completion_functions_)
+  {
+    planner_completion_fn(request, planner_data);
+  }
+
+  benchmark_data_.push_back(planner_data);
 }
 
 void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
@@ -67,6 +67,12 @@ bool BenchmarkOptions::readBenchmarkOptions(const rclcpp::Node::SharedPtr& node)
     // Read benchmark parameters
     node->get_parameter_or(std::string("benchmark_config.parameters.name"), benchmark_name, std::string(""));
     node->get_parameter_or(std::string("benchmark_config.parameters.runs"), runs, 10);
+    node->get_parameter_or(std::string("benchmark_config.parameters.parallel_runs"), parallel_runs, 1);
+    std::vector<int64_t> cpus;
+    node->get_parameter_or(std::string("benchmark_config.parameters.cpu_affinity"), cpus, {});
+    cpu_affinity.clear();
+    for (int64_t cpu : cpus)
+      cpu_affinity.push_back(static_cast<int>(cpu));
     node->get_parameter_or(std::string("benchmark_config.parameters.timeout"), timeout, 10.0);
     node->get_parameter_or(std::string("benchmark_config.parameters.output_directory"), output_directory,
                            std::string(""));
@@ -124,6 +130,7 @@ bool BenchmarkOptions::readBenchmarkOptions(const rclcpp::Node::SharedPtr& node)
 
     RCLCPP_INFO(LOGGER, "Benchmark name: '%s'", benchmark_name.c_str());
     RCLCPP_INFO(LOGGER, "Benchmark #runs: %d", runs);
+    RCLCPP_INFO(LOGGER, "Benchmark #parallel runs: %d", parallel_runs);
     RCLCPP_INFO(LOGGER, "Benchmark timeout: %f secs", timeout);
     RCLCPP_INFO(LOGGER, "Benchmark group: %s", group_name.c_str());
     RCLCPP_INFO(LOGGER, "Benchmark query regex: '%s'", query_regex.c_str());
@@ -0,0 +1,820 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Load generator measuring throughput and latency of a running move_group under concurrent requests */
+
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/version.h>
+#include <moveit/warehouse/planning_scene_storage.h>
+#include <moveit_msgs/action/execute_trajectory.hpp>
+#include <moveit_msgs/srv/apply_planning_scene.hpp>
+#include <moveit_msgs/srv/get_motion_plan.hpp>
+#include <moveit_msgs/srv/get_position_ik.hpp>
+#include <moveit_msgs/srv/get_state_validity.hpp>
+#include <warehouse_ros/database_loader.h>
+#include <rclcpp/executors/multi_threaded_executor.hpp>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <rclcpp/node.hpp>
+#include <rclcpp/utilities.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <tf2_eigen/tf2_eigen.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.benchmarks.RunMoveGroupLoadTest");
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// The names move_group advertises its capabilities under
+const std::string PLANNER_SERVICE_NAME = "plan_kinematic_path";
+const std::string EXECUTE_ACTION_NAME = "execute_trajectory";
+const std::string IK_SERVICE_NAME = "compute_ik";
+const std::string STATE_VALIDITY_SERVICE_NAME = "check_state_validity";
+const std::string APPLY_PLANNING_SCENE_SERVICE_NAME = "apply_planning_scene";
+
+enum Capability
+{
+  PLAN,
+  EXECUTE,
+  IK,
+  STATE_VALIDITY,
+  SCENE_UPDATE,
+  CAPABILITY_COUNT
+};
+const std::array<std::string, CAPABILITY_COUNT> CAPABILITY_NAMES = { "plan", "execute", "ik", "state_validity",
+                                                                     "scene_update" };
+
+/** \brief Options of a load test, read from the move_group_load_test parameters */
+struct LoadTestOptions
+{
+  std::string group_name;
+  std::string ik_link_name;
+  std::string planner_id;
+  std::string arrivals;
+  std::array<double, CAPABILITY_COUNT> rates{};
+  double duration;
+  double request_timeout;
+  double allowed_planning_time;
+  double ik_timeout;
+  int concurrency;
+  int max_backlog;
+  int baseline_requests;
+  int seed;
+  int scene_object_count;
+  double scene_object_size;
+  std::vector<double> scene_object_position;
+  double scene_object_jitter;
+};
+
+/** \brief Measurements of one request */
+struct Sample
+{
+  bool success = false;
+  // from the scheduled arrival of the request to its response
+  double latency = 0.0;
+  // time spent waiting for a free worker, the part of the latency caused by the load generator's concurrency limit
+  double queue_time = 0.0;
+  // time move_group took to answer, from sending the request to its response
+  double service_time = 0.0;
+};
+
+/** \brief All measurements of one capability */
+struct CapabilityResults
+{
+  std::vector<Sample> samples;
+  // arrivals that were dropped because the backlog was full or the test ended before they were sent
+  std::size_t dropped = 0;
+  // service times measured sequentially before the load test, without concurrent requests
+  std::vector<double> baseline_service_times;
+};
+
+/** \brief A request waiting for a worker */
+struct PendingRequest
+{
+  Capability capability;
+  Clock::time_point arrival;
+};
+
+/** \brief Value at quantile \e q of the sorted \e values */
+double percentile(const std::vector<double>& values, double q)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  const std::size_t index = static_cast<std::size_t>(std::ceil(q * values.size()));
+  return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+double secondsSince(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string getHostname()
+{
+  static const int BUF_SIZE = 1024;
+  char buffer[BUF_SIZE];
+  if (gethostname(buffer, sizeof(buffer)) != 0)
+  {
+    return "UNKNOWN";
+  }
+  buffer[BUF_SIZE - 1] = '\0';
+  return std::string(buffer);
+}
+
+/** \brief Sends the requests of all capabilities to move_group and measures their service times */
+class MoveGroupClient
+{
+public:
+  MoveGroupClient(const rclcpp::Node::SharedPtr& node, const moveit::core::RobotModelConstPtr& robot_model,
+                  const LoadTestOptions& options, std::vector<moveit_msgs::msg::MotionPlanRequest> recorded_queries)
+    : robot_model_(robot_model)
+    , group_(robot_model->getJointModelGroup(options.group_name))
+    , options_(options)
+    , recorded_queries_(std::move(recorded_queries))
+  {
+    plan_client_ = node->create_client<moveit_msgs::srv::GetMotionPlan>(PLANNER_SERVICE_NAME);
+    ik_client_ = node->create_client<moveit_msgs::srv::GetPositionIK>(IK_SERVICE_NAME);
+    state_validity_client_ = node->create_client<moveit_msgs::srv::GetStateValidity>(STATE_VALIDITY_SERVICE_NAME);
+    apply_scene_client_ = node->create_client<moveit_msgs::srv::ApplyPlanningScene>(APPLY_PLANNING_SCENE_SERVICE_NAME);
+    execute_client_ = rclcpp_action::create_client<moveit_msgs::action::ExecuteTrajectory>(node, EXECUTE_ACTION_NAME);
+  }
+
+  /** \brief Wait until move_group offers all capabilities with a nonzero rate */
+  bool waitForServers(std::chrono::duration<double> timeout)
+  {
+    const auto& rates = options_.rates;
+    bool ready = true;
+    if ((rates[PLAN] > 0.0 || rates[EXECUTE] > 0.0) && !plan_client_->wait_for_service(timeout))
+    {
+      RCLCPP_ERROR(LOGGER, "Service '%s' is not available", PLANNER_SERVICE_NAME.c_str());
+      ready = false;
+    }
+    if (rates[EXECUTE] > 0.0 && !execute_client_->wait_for_action_server(timeout))
+    {
+      RCLCPP_ERROR(LOGGER, "Action '%s' is not available", EXECUTE_ACTION_NAME.c_str());
+      ready = false;
+    }
+    if (rates[IK] > 0.0 && !ik_client_->wait_for_service(timeout))
+    {
+      RCLCPP_ERROR(LOGGER, "Service '%s' is not available", IK_SERVICE_NAME.c_str());
+      ready = false;
+    }
+    if (rates[STATE_VALIDITY] > 0.0 && !state_validity_client_->wait_for_service(timeout))
+    {
+      RCLCPP_ERROR(LOGGER, "Service '%s' is not available", STATE_VALIDITY_SERVICE_NAME.c_str());
+      ready = false;
+    }
+    if (rates[SCENE_UPDATE] > 0.0 && !apply_scene_client_->wait_for_service(timeout))
+    {
+      RCLCPP_ERROR(LOGGER, "Service '%s' is not available", APPLY_PLANNING_SCENE_SERVICE_NAME.c_str());
+      ready = false;
+    }
+    return ready;
+  }
+
+  /**
+   * \brief Send one request of \e capability, built from random states of \e state and \e rng
+   *
+   * @param [out] service_time Time move_group took to answer the request
+   * @return True if move_group answered and reported success
+   */
+  bool call(Capability capability, moveit::core::RobotState& state, random_numbers::RandomNumberGenerator& rng,
+            double& service_time)
+  {
+    switch (capability)
+    {
+      case PLAN:
+        return plan(state, rng, service_time);
+      case EXECUTE:
+        return execute(state, rng, service_time);
+      case IK:
+        return computeIK(state, rng, service_time);
+      case STATE_VALIDITY:
+        return checkStateValidity(state, rng, service_time);
+      case SCENE_UPDATE:
+        return updateScene(rng, service_time);
+      default:
+        return false;
+    }
+  }
+
+  /** \brief Remove the objects the scene updates added */
+  void removeSceneObjects()
+  {
+    if (options_.rates[SCENE_UPDATE] <= 0.0)
+    {
+      return;
+    }
+    auto request = std::make_shared<moveit_msgs::srv::ApplyPlanningScene::Request>();
+    request->scene.is_diff = true;
+    request->scene.robot_state.is_diff = true;
+    for (int i = 0; i < options_.scene_object_count; ++i)
+    {
+      moveit_msgs::msg::CollisionObject object;
+      object.id = getSceneObjectName(i);
+      object.header.frame_id = robot_model_->getModelFrame();
+      object.operation = moveit_msgs::msg::CollisionObject::REMOVE;
+      request->scene.world.collision_objects.push_back(object);
+    }
+    double service_time;
+    moveit_msgs::srv::ApplyPlanningScene::Response::SharedPtr response;
+    if (!callService(apply_scene_client_, request, response, service_time) || !response->success)
+    {
+      RCLCPP_WARN(LOGGER, "Failed to remove the objects added by the load test from the planning scene");
+    }
+  }
+
+private:
+  template <typename ServiceT>
+  bool callService(const std::shared_ptr<rclcpp::Client<ServiceT>>& client,
+                   const typename ServiceT::Request::SharedPtr& request,
+                   typename ServiceT::Response::SharedPtr& response, double& service_time)
+  {
+    const auto start = Clock::now();
+    auto future = client->async_send_request(request);
+    if (future.wait_for(std::chrono::duration<double>(options_.request_timeout)) != std::future_status::ready)
+    {
+      client->remove_pending_request(future);
+      service_time = secondsSince(start);
+      return false;
+    }
+    response = future.get();
+    service_time = secondsSince(start);
+    return response != nullptr;
+  }
+
+  /** \brief A request to plan from the current state of move_group to a random goal of the group */
+  moveit_msgs::srv::GetMotionPlan::Request::SharedPtr makeRandomPlanRequest(moveit::core::RobotState& state,
+                                                                           random_numbers::RandomNumberGenerator& rng)
+  {
+    auto request = std::make_shared<moveit_msgs::srv::GetMotionPlan::Request>();
+    moveit_msgs::msg::MotionPlanRequest& motion_plan_request = request->motion_plan_request;
+    state.setToRandomPositions(group_, rng);
+    motion_plan_request.group_name = options_.group_name;
+    motion_plan_request.planner_id = options_.planner_id;
+    motion_plan_request.start_state.is_diff = true;
+    motion_plan_request.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(state, group_));
+    motion_plan_request.allowed_planning_time = options_.allowed_planning_time;
+    motion_plan_request.num_planning_attempts = 1;
+    return request;
+  }
+
+  bool plan(moveit::core::RobotState& state, random_numbers::RandomNumberGenerator& rng, double& service_time)
+  {
+    moveit_msgs::srv::GetMotionPlan::Request::SharedPtr request;
+    if (recorded_queries_.empty())
+    {
+      request = makeRandomPlanRequest(state, rng);
+    }
+    else
+    {
+      request = std::make_shared<moveit_msgs::srv::GetMotionPlan::Request>();
+      request->motion_plan_request = recorded_queries_[next_recorded_query_++ % recorded_queries_.size()];
+    }
+    moveit_msgs::srv::GetMotionPlan::Response::SharedPtr response;
+    return callService(plan_client_, request, response, service_time) &&
+           response->motion_plan_response.error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+  }
+
+  /** \brief Plan from the current state to a random goal and execute the plan; only the execution is timed */
+  bool execute(moveit::core::RobotState& state, random_numbers::RandomNumberGenerator& rng, double& service_time)
+  {
+    // move_group preempts a running execution when a new trajectory arrives, so executions are sent one at a time
+    std::lock_guard<std::mutex> lock(execute_mutex_);
+    service_time = 0.0;
+    moveit_msgs::srv::GetMotionPlan::Response::SharedPtr plan_response;
+    double planning_time;
+    if (!callService(plan_client_, makeRandomPlanRequest(state, rng), plan_response, planning_time) ||
+        plan_response->motion_plan_response.error_code.val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+    {
+      return false;
+    }
+
+    moveit_msgs::action::ExecuteTrajectory::Goal goal;
+    goal.trajectory = plan_response->motion_plan_response.trajectory;
+    const auto start = Clock::now();
+    auto goal_handle_future = execute_client_->async_send_goal(goal);
+    const std::chrono::duration<double> timeout(options_.request_timeout);
+    if (goal_handle_future.wait_for(timeout) != std::future_status::ready || !goal_handle_future.get())
+    {
+      service_time = secondsSince(start);
+      return false;
+    }
+    auto result_future = execute_client_->async_get_result(goal_handle_future.get());
+    // the execution takes as long as the trajectory on top of the request timeout
+    const auto& points = goal.trajectory.joint_trajectory.points;
+    const double trajectory_duration = points.empty() ? 0.0 : rclcpp::Duration(points.back().time_from_start).seconds();
+    if (result_future.wait_for(timeout + std::chrono::duration<double>(trajectory_duration)) !=
+        std::future_status::ready)
+    {
+      execute_client_->async_cancel_goal(goal_handle_future.get());
+      service_time = secondsSince(start);
+      return false;
+    }
+    const auto wrapped_result = result_future.get();
+    service_time = secondsSince(start);
+    return wrapped_result.code == rclcpp_action::ResultCode::SUCCEEDED &&
+           wrapped_result.result->error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+  }
+
+  /** \brief Ask for a solution of a pose that is reachable, the pose of the IK link at a random state */
+  bool computeIK(moveit::core::RobotState& state, random_numbers::RandomNumberGenerator& rng, double& service_time)
+  {
+    state.setToRandomPositions(group_, rng);
+    state.updateLinkTransforms();
+    auto request = std::make_shared<moveit_msgs::srv::GetPositionIK::Request>();
+    moveit_msgs::msg::PositionIKRequest& ik_request = request->ik_request;
+    ik_request.group_name = options_.group_name;
+    ik_request.ik_link_name = options_.ik_link_name;
+    ik_request.robot_state.is_diff = true;
+    ik_request.avoid_collisions = false;
+    ik_request.pose_stamped.header.frame_id = robot_model_->getModelFrame();
+    ik_request.pose_stamped.pose = tf2::toMsg(state.getGlobalLinkTransform(options_.ik_link_name));
+    ik_request.timeout = rclcpp::Duration::from_seconds(options_.ik_timeout);
+    moveit_msgs::srv::GetPositionIK::Response::SharedPtr response;
+    return callService(ik_client_, request, response, service_time) &&
+           response->error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+  }
+
+  /** \brief Check a random state; valid and invalid answers both count as success */
+  bool checkStateValidity(moveit::core::RobotState& state, random_numbers::RandomNumberGenerator& rng,
+                          double& service_time)
+  {
+    state.setToRandomPositions(group_, rng);
+    auto request = std::make_shared<moveit_msgs::srv::GetStateValidity::Request>();
+    moveit::core::robotStateToRobotStateMsg(state, request->robot_state, false);
+    request->group_name = options_.group_name;
+    moveit_msgs::srv::GetStateValidity::Response::SharedPtr response;
+    return callService(state_validity_client_, request, response, service_time);
+  }
+
+  /** \brief Add or move one of the load test's boxes near the configured position */
+  bool updateScene(random_numbers::RandomNumberGenerator& rng, double& service_time)
+  {
+    auto request = std::make_shared<moveit_msgs::srv::ApplyPlanningScene::Request>();
+    request->scene.is_diff = true;
+    request->scene.robot_state.is_diff = true;
+    moveit_msgs::msg::CollisionObject object;
+    object.id = getSceneObjectName(next_scene_object_++ % options_.scene_object_count);
+    object.header.frame_id = robot_model_->getModelFrame();
+    object.operation = moveit_msgs::msg::CollisionObject::ADD;
+    shape_msgs::msg::SolidPrimitive box;
+    box.type = shape_msgs::msg::SolidPrimitive::BOX;
+    box.dimensions.assign(3, options_.scene_object_size);
+    object.primitives.push_back(box);
+    geometry_msgs::msg::Pose pose;
+    pose.position.x = options_.scene_object_position[0] + rng.uniformReal(-1.0, 1.0) * options_.scene_object_jitter;
+    pose.position.y = options_.scene_object_position[1] + rng.uniformReal(-1.0, 1.0) * options_.scene_object_jitter;
+    pose.position.z = options_.scene_object_position[2] + rng.uniformReal(-1.0, 1.0) * options_.scene_object_jitter;
+    pose.orientation.w = 1.0;
+    object.primitive_poses.push_back(pose);
+    request->scene.world.collision_objects.push_back(object);
+    moveit_msgs::srv::ApplyPlanningScene::Response::SharedPtr response;
+    return callService(apply_scene_client_, request, response, service_time) && response->success;
+  }
+
+  static std::string getSceneObjectName(int index)
+  {
+    return "load_test_object_" + std::to_string(index);
+  }
+
+  moveit::core::RobotModelConstPtr robot_model_;
+  const moveit::core::JointModelGroup* group_;
+  const LoadTestOptions& options_;
+  std::vector<moveit_msgs::msg::MotionPlanRequest> recorded_queries_;
+  std::atomic<std::size_t> next_recorded_query_{ 0 };
+  std::atomic<int> next_scene_object_{ 0 };
+  std::mutex execute_mutex_;
+
+  rclcpp::Client<moveit_msgs::srv::GetMotionPlan>::SharedPtr plan_client_;
+  rclcpp::Client<moveit_msgs::srv::GetPositionIK>::SharedPtr ik_client_;
+  rclcpp::Client<moveit_msgs::srv::GetStateValidity>::SharedPtr state_validity_client_;
+  rclcpp::Client<moveit_msgs::srv::ApplyPlanningScene>::SharedPtr apply_scene_client_;
+  rclcpp_action::Client<moveit_msgs::action::ExecuteTrajectory>::SharedPtr execute_client_;
+};
+
+/** \brief Load the stored queries of the warehouse scenes and queries matching the regular expressions */
+bool loadRecordedQueries(const rclcpp::Node::SharedPtr& node, const std::string& ns,
+                         std::vector<moveit_msgs::msg::MotionPlanRequest>& queries)
+{
+  std::string hostname, scene_regex, query_regex;
+  int port;
+  node->get_parameter_or(ns + "warehouse.host", hostname, std::string("127.0.0.1"));
+  node->get_parameter_or(ns + "warehouse.port", port, 33829);
+  node->get_parameter_or(ns + "scenes_regex", scene_regex, std::string(".*"));
+  node->get_parameter_or(ns + "queries_regex", query_regex, std::string(".*"));
+  try
+  {
+    warehouse_ros::DatabaseLoader db_loader(node);
+    warehouse_ros::DatabaseConnection::Ptr warehouse_connection = db_loader.loadDatabase();
+    warehouse_connection->setParams(hostname, port, 20);
+    if (!warehouse_connection->connect())
+    {
+      RCLCPP_ERROR(LOGGER, "Failed to connect to DB");
+      return false;
+    }
+    moveit_warehouse::PlanningSceneStorage planning_scene_storage(warehouse_connection);
+    std::vector<std::string> scene_names;
+    planning_scene_storage.getPlanningSceneNames(scene_regex, scene_names);
+    for (const std::string& scene_name : scene_names)
+    {
+      std::vector<moveit_warehouse::MotionPlanRequestWithMetadata> planning_queries;
+      std::vector<std::string> query_names;
+      planning_scene_storage.getPlanningQueries(query_regex, planning_queries, query_names, scene_name);
+      for (const moveit_warehouse::MotionPlanRequestWithMetadata& planning_query : planning_queries)
+      {
+        queries.push_back(static_cast<moveit_msgs::msg::MotionPlanRequest>(*planning_query));
+      }
+    }
+  }
+  catch (std::exception& e)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to load queries from DB: '%s'", e.what());
+    return false;
+  }
+  return !queries.empty();
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.allow_undeclared_parameters(true);
+  node_options.automatically_declare_parameters_from_overrides(true);
+  rclcpp::Node::SharedPtr node = rclcpp::Node::make_shared("moveit_run_move_group_load_test", node_options);
+
+  // Read load test options from param server
+  const std::string ns = "move_group_load_test.";
+  LoadTestOptions options;
+  std::string benchmark_name, output_directory;
+  bool replay_queries;
+  node->get_parameter_or(ns + "name", benchmark_name, std::string("move_group_load_test"));
+  node->get_parameter_or(ns + "output_directory", output_directory, std::string(""));
+  node->get_parameter_or(ns + "duration", options.duration, 30.0);
+  node->get_parameter_or(ns + "concurrency", options.concurrency, 8);
+  node->get_parameter_or(ns + "arrivals", options.arrivals, std::string("poisson"));
+  node->get_parameter_or(ns + "max_backlog", options.max_backlog, 1000);
+  node->get_parameter_or(ns + "request_timeout", options.request_timeout, 10.0);
+  node->get_parameter_or(ns + "baseline_requests", options.baseline_requests, 10);
+  node->get_parameter_or(ns + "seed", options.seed, 0);
+  node->get_parameter_or(ns + "rates.plan", options.rates[PLAN], 1.0);
+  node->get_parameter_or(ns + "rates.execute", options.rates[EXECUTE], 0.0);
+  node->get_parameter_or(ns + "rates.ik", options.rates[IK], 10.0);
+  node->get_parameter_or(ns + "rates.state_validity", options.rates[STATE_VALIDITY], 50.0);
+  node->get_parameter_or(ns + "rates.scene_update", options.rates[SCENE_UPDATE], 5.0);
+  node->get_parameter_or(ns + "planner_id", options.planner_id, std::string(""));
+  node->get_parameter_or(ns + "allowed_planning_time", options.allowed_planning_time, 1.0);
+  node->get_parameter_or(ns + "ik_timeout", options.ik_timeout, 0.05);
+  node->get_parameter_or(ns + "scene_object_count", options.scene_object_count, 5);
+  node->get_parameter_or(ns + "scene_object_size", options.scene_object_size, 0.1);
+  node->get_parameter_or(ns + "scene_object_position", options.scene_object_position, { 2.0, 0.0, 0.5 });
+  node->get_parameter_or(ns + "scene_object_jitter", options.scene_object_jitter, 0.2);
+  node->get_parameter_or(ns + "replay_queries", replay_queries, false);
+  if (!node->get_parameter(ns + "group", options.group_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Load test group NOT specified");
+    rclcpp::shutdown();
+    return 1;
+  }
+  if (options.arrivals != "poisson" && options.arrivals != "uniform")
+  {
+    RCLCPP_ERROR(LOGGER, "Unknown arrival process '%s', use 'poisson' or 'uniform'", options.arrivals.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+  if (options.scene_object_position.size() != 3)
+  {
+    RCLCPP_ERROR(LOGGER, "scene_object_position needs 3 coordinates");
+    rclcpp::shutdown();
+    return 1;
+  }
+  options.concurrency = std::max(options.concurrency, 1);
+  options.max_backlog = std::max(options.max_backlog, 1);
+  options.scene_object_count = std::max(options.scene_object_count, 1);
+
+  robot_model_loader::RobotModelLoader robot_model_loader(node, "robot_description");
+  const moveit::core::RobotModelPtr& robot_model = robot_model_loader.getModel();
+  if (!robot_model || !robot_model->hasJointModelGroup(options.group_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to load the robot model or its group '%s'", options.group_name.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup(options.group_name);
+  node->get_parameter_or(ns + "ik_link", options.ik_link_name,
+                         group->getLinkModelNames().empty() ? std::string() : group->getLinkModelNames().back());
+  if (options.rates[IK] > 0.0 && !robot_model->hasLinkModel(options.ik_link_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Unknown IK link '%s'", options.ik_link_name.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  std::vector<moveit_msgs::msg::MotionPlanRequest> recorded_queries;
+  if (replay_queries && !loadRecordedQueries(node, ns, recorded_queries))
+  {
+    RCLCPP_ERROR(LOGGER, "No recorded queries to replay");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  // The responses are received by the executor while the workers wait for them
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(node);
+  std::thread spinner([&executor] { executor.spin(); });
+  const auto stop = [&](int status) {
+    executor.cancel();
+    spinner.join();
+    rclcpp::shutdown();
+    return status;
+  };
+
+  MoveGroupClient client(node, robot_model, options, recorded_queries);
+  if (!client.waitForServers(std::chrono::seconds(10)))
+  {
+    return stop(1);
+  }
+
+  std::vector<Capability> capabilities;
+  for (int c = 0; c < CAPABILITY_COUNT; ++c)
+  {
+    if (options.rates[c] > 0.0)
+    {
+      capabilities.push_back(static_cast<Capability>(c));
+    }
+  }
+  if (capabilities.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "All request rates are zero");
+    return stop(1);
+  }
+
+  // Measure each capability without concurrent requests first, the reference for the slowdown under load
+  std::array<CapabilityResults, CAPABILITY_COUNT> results;
+  {
+    moveit::core::RobotState state(robot_model);
+    state.setToDefaultValues();
+    random_numbers::RandomNumberGenerator rng(options.seed);
+    for (const Capability capability : capabilities)
+    {
+      for (int i = 0; i < options.baseline_requests; ++i)
+      {
+        double service_time;
+        if (client.call(capability, state, rng, service_time))
+        {
+          results[capability].baseline_service_times.push_back(service_time);
+        }
+      }
+    }
+  }
+  RCLCPP_INFO(LOGGER, "Running load test for %.1fs with %d concurrent requests", options.duration,
+              options.concurrency);
+
+  // The workers take the requests in arrival order. A request's latency starts at its scheduled arrival, so a
+  // saturated move_group shows in the latency instead of slowing down the arrivals.
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<PendingRequest> backlog;
+  bool finished = false;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < options.concurrency; ++t)
+  {
+    workers.emplace_back([&, t] {
+      moveit::core::RobotState state(robot_model);
+      state.setToDefaultValues();
+      random_numbers::RandomNumberGenerator rng(options.seed + t + 1);
+      while (true)
+      {
+        PendingRequest request;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          condition.wait(lock, [&] { return finished || !backlog.empty(); });
+          if (finished)
+          {
+            return;
+          }
+          request = backlog.front();
+          backlog.pop_front();
+        }
+        Sample sample;
+        sample.queue_time = secondsSince(request.arrival);
+        sample.success = client.call(request.capability, state, rng, sample.service_time);
+        sample.latency = secondsSince(request.arrival);
+        std::lock_guard<std::mutex> lock(mutex);
+        results[request.capability].samples.push_back(sample);
+      }
+    });
+  }
+
+  // Schedule the arrivals of all capabilities, each with its own rate
+  const std::string start_time =
+      boost::posix_time::to_iso_extended_string(boost::posix_time::microsec_clock::universal_time());
+  random_numbers::RandomNumberGenerator arrival_rng(options.seed);
+  const auto next_interval = [&](Capability capability) {
+    const double mean = 1.0 / options.rates[capability];
+    const double interval = options.arrivals == "poisson" ? -mean * std::log(1.0 - arrival_rng.uniform01()) : mean;
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+  };
+  const auto load_start = Clock::now();
+  const auto load_end = load_start + std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(std::max(options.duration, 0.0)));
+  std::array<Clock::time_point, CAPABILITY_COUNT> next_arrivals;
+  for (const Capability capability : capabilities)
+  {
+    next_arrivals[capability] = load_start + next_interval(capability);
+  }
+  while (rclcpp::ok())
+  {
+    const Capability capability = *std::min_element(
+        capabilities.begin(), capabilities.end(),
+        [&](Capability a, Capability b) { return next_arrivals[a] < next_arrivals[b]; });
+    const Clock::time_point arrival = next_arrivals[capability];
+    if (arrival >= load_end)
+    {
+      break;
+    }
+    std::this_thread::sleep_until(arrival);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (backlog.size() < static_cast<std::size_t>(options.max_backlog))
+      {
+        backlog.push_back({ capability, arrival });
+      }
+      else
+      {
+        ++results[capability].dropped;
+      }
+    }
+    condition.notify_one();
+    next_arrivals[capability] += next_interval(capability);
+  }
+
+  // Requests that have not been sent by the end of the test are dropped, the ones in flight are completed
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const PendingRequest& request : backlog)
+    {
+      ++results[request.capability].dropped;
+    }
+    backlog.clear();
+    finished = true;
+  }
+  condition.notify_all();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+  const double load_duration = secondsSince(load_start);
+  client.removeSceneObjects();
+
+  // Report the throughput, latency and the slowdown of move_group under load compared to the baseline
+  for (const Capability capability : capabilities)
+  {
+    CapabilityResults& result = results[capability];
+    std::vector<double> latencies, queue_times, service_times;
+    std::size_t successes = 0;
+    for (const Sample& sample : result.samples)
+    {
+      latencies.push_back(sample.latency);
+      queue_times.push_back(sample.queue_time);
+      service_times.push_back(sample.service_time);
+      successes += sample.success ? 1 : 0;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(queue_times.begin(), queue_times.end());
+    std::sort(service_times.begin(), service_times.end());
+    std::sort(result.baseline_service_times.begin(), result.baseline_service_times.end());
+    const double baseline_p50 = percentile(result.baseline_service_times, 0.5);
+    RCLCPP_INFO(LOGGER,
+                "%s: %.2f QPS offered, %.2f QPS served, %lu/%lu succeeded, %lu dropped, latency p50 %.3fms, "
+                "p99 %.3fms, max %.3fms, queueing p50 %.3fms, p99 %.3fms",
+                CAPABILITY_NAMES[capability].c_str(), options.rates[capability],
+                result.samples.size() / load_duration, successes, result.samples.size(), result.dropped,
+                1000.0 * percentile(latencies, 0.5), 1000.0 * percentile(latencies, 0.99),
+                1000.0 * (latencies.empty() ? 0.0 : latencies.back()), 1000.0 * percentile(queue_times, 0.5),
+                1000.0 * percentile(queue_times, 0.99));
+    RCLCPP_INFO(LOGGER,
+                "%s: service time p50 %.3fms, p99 %.3fms, unloaded p50 %.3fms, slowdown under load p50 %.2fx, "
+                "p99 %.2fx",
+                CAPABILITY_NAMES[capability].c_str(), 1000.0 * percentile(service_times, 0.5),
+                1000.0 * percentile(service_times, 0.99), 1000.0 * baseline_p50,
+                baseline_p50 > 0.0 ? percentile(service_times, 0.5) / baseline_p50 : 0.0,
+                baseline_p50 > 0.0 ? percentile(service_times, 0.99) / baseline_p50 : 0.0);
+  }
+
+  // Write the results in the log format read by moveit_benchmark_statistics.py, one "planner" per capability
+  std::string filename = output_directory;
+  if (!filename.empty() && filename.back() != '/')
+  {
+    filename.append("/");
+  }
+  std::filesystem::create_directories(filename);
+  const std::string host = getHostname();
+  filename += benchmark_name + "_" + host + "_" + start_time + ".log";
+  std::ofstream out(filename.c_str());
+  if (!out)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to open '%s' for benchmark output", filename.c_str());
+    return stop(1);
+  }
+
+  out << "MoveIt version " << MOVEIT_VERSION_STR << '\n';
+  out << "Experiment " << benchmark_name << '\n';
+  out << "Running on " << host << '\n';
+  out << "Starting at " << start_time << '\n';
+  out << "<<<|" << '\n';
+  out << "move_group load test:" << '\n'
+      << "  group_name: " << options.group_name << '\n'
+      << "  concurrency: " << options.concurrency << '\n'
+      << "  arrivals: " << options.arrivals << '\n'
+      << "  replay_queries: " << replay_queries << '\n';
+  for (const Capability capability : capabilities)
+  {
+    out << "  rates." << CAPABILITY_NAMES[capability] << ": " << options.rates[capability] << '\n';
+  }
+  out << "|>>>" << '\n';
+  out << options.seed << " is the random seed" << '\n';
+  out << options.request_timeout << " seconds per run" << '\n';
+  out << "-1 MB per run" << '\n';
+  out << "-1 runs per planner" << '\n';
+  out << load_duration << " seconds spent to collect the data" << '\n';
+  out << "0 enum types" << '\n';
+  out << capabilities.size() << " planners" << '\n';
+  for (const Capability capability : capabilities)
+  {
+    const CapabilityResults& result = results[capability];
+    out << CAPABILITY_NAMES[capability] << '\n';
+    out << "4 common properties" << '\n';
+    out << "offered_qps REAL = " << options.rates[capability] << '\n';
+    out << "served_qps REAL = " << result.samples.size() / load_duration << '\n';
+    out << "dropped INTEGER = " << result.dropped << '\n';
+    out << "unloaded_service_time REAL = " << percentile(result.baseline_service_times, 0.5) << '\n';
+    out << "4 properties for each run" << '\n';
+    out << "solved BOOLEAN" << '\n';
+    out << "time REAL" << '\n';
+    out << "queue_time REAL" << '\n';
+    out << "service_time REAL" << '\n';
+    out << result.samples.size() << " runs" << '\n';
+    for (const Sample& sample : result.samples)
+    {
+      out << sample.success << "; " << sample.latency << "; " << sample.queue_time << "; " << sample.service_time
+          << "; " << '\n';
+    }
+    out << '.' << '\n';
+  }
+  RCLCPP_INFO(LOGGER, "Load test results saved to '%s'", filename.c_str());
+
+  return stop(0);
+}
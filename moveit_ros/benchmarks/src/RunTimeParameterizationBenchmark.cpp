@@ -0,0 +1,361 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Compares time parameterization algorithms on trajectories stored in the warehouse */
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/version.h>
+#include <moveit/warehouse/planning_scene_storage.h>
+#include <warehouse_ros/database_loader.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <rclcpp/node.hpp>
+#include <rclcpp/utilities.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.benchmarks.RunTimeParameterizationBenchmark");
+
+namespace
+{
+/** \brief A time parameterization algorithm under test, which modifies the trajectory in place */
+struct Parameterizer
+{
+  std::string name;
+  std::function<bool(robot_trajectory::RobotTrajectory&)> parameterize;
+};
+
+/** \brief Measurements of one run of a parameterizer on one trajectory */
+struct RunData
+{
+  bool success = false;
+  double time = 0.0;
+  double trajectory_duration = 0.0;
+  double max_jerk = 0.0;
+  std::size_t waypoint_count = 0;
+};
+
+/** \brief Largest finite-difference jerk of the group's variables along a parameterized trajectory */
+double computeMaxJerk(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  const std::vector<int>& indices = trajectory.getGroup()->getVariableIndexList();
+  double max_jerk = 0.0;
+  for (std::size_t i = 1; i < trajectory.getWayPointCount(); ++i)
+  {
+    const double dt = trajectory.getWayPointDurationFromPrevious(i);
+    const moveit::core::RobotState& previous = trajectory.getWayPoint(i - 1);
+    const moveit::core::RobotState& current = trajectory.getWayPoint(i);
+    if (dt <= 0.0 || !previous.hasAccelerations() || !current.hasAccelerations())
+    {
+      continue;
+    }
+    for (const int index : indices)
+    {
+      const double jerk = current.getVariableAcceleration(index) - previous.getVariableAcceleration(index);
+      max_jerk = std::max(max_jerk, std::fabs(jerk) / dt);
+    }
+  }
+  return max_jerk;
+}
+
+/** \brief Value at quantile \e q of the sorted \e values */
+double percentile(const std::vector<double>& values, double q)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  const std::size_t index = static_cast<std::size_t>(std::ceil(q * values.size()));
+  return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+std::string getHostname()
+{
+  static const int BUF_SIZE = 1024;
+  char buffer[BUF_SIZE];
+  if (gethostname(buffer, sizeof(buffer)) != 0)
+  {
+    return "UNKNOWN";
+  }
+  buffer[BUF_SIZE - 1] = '\0';
+  return std::string(buffer);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.allow_undeclared_parameters(true);
+  node_options.automatically_declare_parameters_from_overrides(true);
+  rclcpp::Node::SharedPtr node = rclcpp::Node::make_shared("moveit_run_time_parameterization_benchmark", node_options);
+
+  // Read benchmark options from param server
+  const std::string ns = "time_parameterization_benchmark.";
+  std::string hostname, scene_regex, query_regex, group_name, benchmark_name, output_directory;
+  int port, runs, threads;
+  double velocity_scaling, acceleration_scaling;
+  std::vector<std::string> parameterizer_names;
+  node->get_parameter_or(ns + "warehouse.host", hostname, std::string("127.0.0.1"));
+  node->get_parameter_or(ns + "warehouse.port", port, 33829);
+  node->get_parameter_or(ns + "scenes_regex", scene_regex, std::string(".*"));
+  node->get_parameter_or(ns + "queries_regex", query_regex, std::string(".*"));
+  node->get_parameter_or(ns + "name", benchmark_name, std::string("time_parameterization"));
+  node->get_parameter_or(ns + "output_directory", output_directory, std::string(""));
+  node->get_parameter_or(ns + "runs", runs, 10);
+  node->get_parameter_or(ns + "threads", threads, static_cast<int>(std::thread::hardware_concurrency()));
+  node->get_parameter_or(ns + "velocity_scaling_factor", velocity_scaling, 1.0);
+  node->get_parameter_or(ns + "acceleration_scaling_factor", acceleration_scaling, 1.0);
+  node->get_parameter_or(ns + "parameterizers", parameterizer_names, { "totg", "ruckig" });
+  if (!node->get_parameter(ns + "group", group_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Benchmark group NOT specified");
+    rclcpp::shutdown();
+    return 1;
+  }
+  runs = std::max(runs, 1);
+  threads = std::max(threads, 1);
+
+  robot_model_loader::RobotModelLoader robot_model_loader(node, "robot_description");
+  const moveit::core::RobotModelPtr& robot_model = robot_model_loader.getModel();
+  if (!robot_model || !robot_model->hasJointModelGroup(group_name))
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to load the robot model or its group '%s'", group_name.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup(group_name);
+
+  // Ruckig smooths trajectories that already have timing, so it runs on the output of TOTG
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  std::vector<Parameterizer> parameterizers;
+  for (const std::string& parameterizer_name : parameterizer_names)
+  {
+    if (parameterizer_name == "totg")
+    {
+      parameterizers.push_back({ parameterizer_name, [&](robot_trajectory::RobotTrajectory& trajectory) {
+                                  return totg.computeTimeStamps(trajectory, velocity_scaling, acceleration_scaling);
+                                } });
+    }
+    else if (parameterizer_name == "ruckig")
+    {
+      parameterizers.push_back({ parameterizer_name, [&](robot_trajectory::RobotTrajectory& trajectory) {
+                                  return totg.computeTimeStamps(trajectory, velocity_scaling, acceleration_scaling) &&
+                                         trajectory_processing::RuckigSmoothing::applySmoothing(
+                                             trajectory, velocity_scaling, acceleration_scaling);
+                                } });
+    }
+    else
+    {
+      RCLCPP_WARN(LOGGER, "Ignoring unknown parameterizer '%s'", parameterizer_name.c_str());
+    }
+  }
+
+  // Load the corpus: the stored planning results of all matching queries
+  std::vector<robot_trajectory::RobotTrajectoryPtr> corpus;
+  try
+  {
+    warehouse_ros::DatabaseLoader db_loader(node);
+    warehouse_ros::DatabaseConnection::Ptr warehouse_connection = db_loader.loadDatabase();
+    warehouse_connection->setParams(hostname, port, 20);
+    if (!warehouse_connection->connect())
+    {
+      RCLCPP_ERROR(LOGGER, "Failed to connect to DB");
+      rclcpp::shutdown();
+      return 1;
+    }
+    moveit_warehouse::PlanningSceneStorage planning_scene_storage(warehouse_connection);
+    moveit::core::RobotState reference_state(robot_model);
+    reference_state.setToDefaultValues();
+    std::vector<std::string> scene_names;
+    planning_scene_storage.getPlanningSceneNames(scene_regex, scene_names);
+    for (const std::string& scene_name : scene_names)
+    {
+      std::vector<std::string> query_names;
+      planning_scene_storage.getPlanningQueriesNames(query_regex, query_names, scene_name);
+      for (const std::string& query_name : query_names)
+      {
+        std::vector<moveit_warehouse::RobotTrajectoryWithMetadata> planning_results;
+        planning_scene_storage.getPlanningResults(planning_results, scene_name, query_name);
+        for (const moveit_warehouse::RobotTrajectoryWithMetadata& planning_result : planning_results)
+        {
+          auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, group);
+          trajectory->setRobotTrajectoryMsg(reference_state, *planning_result);
+          if (trajectory->getWayPointCount() > 1)
+          {
+            corpus.push_back(trajectory);
+          }
+        }
+      }
+    }
+  }
+  catch (std::exception& e)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to load trajectories from DB: '%s'", e.what());
+    rclcpp::shutdown();
+    return 1;
+  }
+  if (corpus.empty() || parameterizers.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "No trajectories or parameterizers to benchmark");
+    rclcpp::shutdown();
+    return 1;
+  }
+  RCLCPP_INFO(LOGGER, "Benchmarking %lu parameterizers on %lu trajectories, %d runs each on %d threads",
+              parameterizers.size(), corpus.size(), runs, threads);
+
+  // Run every parameterizer on every trajectory of the corpus; the threads pick the next run from a shared counter
+  const std::string start_time =
+      boost::posix_time::to_iso_extended_string(boost::posix_time::microsec_clock::universal_time());
+  const auto benchmark_start = std::chrono::steady_clock::now();
+  std::vector<std::vector<RunData>> run_data(parameterizers.size());
+  for (std::size_t p = 0; p < parameterizers.size(); ++p)
+  {
+    const std::size_t num_runs = corpus.size() * static_cast<std::size_t>(runs);
+    run_data[p].resize(num_runs);
+    std::atomic<std::size_t> next_run{ 0 };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+      workers.emplace_back([&, p] {
+        for (std::size_t run = next_run++; run < num_runs; run = next_run++)
+        {
+          robot_trajectory::RobotTrajectory trajectory(*corpus[run % corpus.size()], true);
+          RunData& data = run_data[p][run];
+          const auto start = std::chrono::steady_clock::now();
+          data.success = parameterizers[p].parameterize(trajectory);
+          data.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          data.waypoint_count = trajectory.getWayPointCount();
+          if (data.success)
+          {
+            data.trajectory_duration = trajectory.getDuration();
+            data.max_jerk = computeMaxJerk(trajectory);
+          }
+        }
+      });
+    }
+    for (std::thread& worker : workers)
+    {
+      worker.join();
+    }
+
+    std::vector<double> times;
+    std::size_t successes = 0;
+    for (const RunData& data : run_data[p])
+    {
+      times.push_back(data.time);
+      successes += data.success ? 1 : 0;
+    }
+    std::sort(times.begin(), times.end());
+    RCLCPP_INFO(LOGGER, "%s: %lu/%lu succeeded, latency p50 %.3fms, p90 %.3fms, p99 %.3fms, max %.3fms",
+                parameterizers[p].name.c_str(), successes, times.size(), 1000.0 * percentile(times, 0.5),
+                1000.0 * percentile(times, 0.9), 1000.0 * percentile(times, 0.99), 1000.0 * times.back());
+  }
+  const double benchmark_duration =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - benchmark_start).count();
+
+  // Write the results in the log format read by moveit_benchmark_statistics.py, one "planner" per parameterizer
+  std::string filename = output_directory;
+  if (!filename.empty() && filename.back() != '/')
+  {
+    filename.append("/");
+  }
+  std::filesystem::create_directories(filename);
+  const std::string host = getHostname();
+  filename += benchmark_name + "_" + host + "_" + start_time + ".log";
+  std::ofstream out(filename.c_str());
+  if (!out)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to open '%s' for benchmark output", filename.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  out << "MoveIt version " << MOVEIT_VERSION_STR << '\n';
+  out << "Experiment " << benchmark_name << '\n';
+  out << "Running on " << host << '\n';
+  out << "Starting at " << start_time << '\n';
+  out << "<<<|" << '\n';
+  out << "Time parameterization:" << '\n'
+      << "  group_name: " << group_name << '\n'
+      << "  scenes_regex: " << scene_regex << '\n'
+      << "  queries_regex: " << query_regex << '\n'
+      << "  trajectories: " << corpus.size() << '\n'
+      << "  threads: " << threads << '\n'
+      << "  velocity_scaling_factor: " << velocity_scaling << '\n'
+      << "  acceleration_scaling_factor: " << acceleration_scaling << '\n'
+      << "|>>>" << '\n';
+  // There is no randomness, time limit or memory cap
+  out << "0 is the random seed" << '\n';
+  out << "-1 seconds per run" << '\n';
+  out << "-1 MB per run" << '\n';
+  out << corpus.size() * runs << " runs per planner" << '\n';
+  out << benchmark_duration << " seconds spent to collect the data" << '\n';
+  out << "0 enum types" << '\n';
+  out << parameterizers.size() << " planners" << '\n';
+  for (std::size_t p = 0; p < parameterizers.size(); ++p)
+  {
+    out << parameterizers[p].name << '\n';
+    out << "0 common properties" << '\n';
+    out << "5 properties for each run" << '\n';
+    out << "solved BOOLEAN" << '\n';
+    out << "time REAL" << '\n';
+    out << "trajectory_duration REAL" << '\n';
+    out << "max_jerk REAL" << '\n';
+    out << "waypoint_count INTEGER" << '\n';
+    out << run_data[p].size() << " runs" << '\n';
+    for (const RunData& data : run_data[p])
+    {
+      out << data.success << "; " << data.time << "; " << data.trajectory_duration << "; " << data.max_jerk << "; "
+          << data.waypoint_count << "; " << '\n';
+    }
+    out << '.' << '\n';
+  }
+  RCLCPP_INFO(LOGGER, "Benchmark results saved to '%s'", filename.c_str());
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -76,7 +76,8 @@ public:
       const std::shared_ptr<rclcpp_action::ServerGoalHandle<moveit_msgs::action::GlobalPlanner>> global_goal_handle) = 0;
 
   /**
-   * Reset global planner plugin. This should never fail.
+   * Reset global planner plugin. This should never fail. It may be called from another thread while plan() is running,
+   * to preempt the running planning, in which case plan() should return as soon as possible.
    * @return True if reset was successful
    */
   virtual bool reset() noexcept = 0;
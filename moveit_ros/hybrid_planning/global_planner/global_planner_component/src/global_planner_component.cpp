@@ -78,14 +78,16 @@ bool GlobalPlannerComponent::initializeGlobalPlanner()
       [this](const rclcpp_action::GoalUUID& /*unused*/,
              const std::shared_ptr<const moveit_msgs::action::GlobalPlanner::Goal>& /*unused*/) {
         RCLCPP_INFO(LOGGER, "Received global planning goal request");
-        // If another goal is active, cancel it and reject this goal
+        // If another goal is active, preempt it: the newer request supersedes it, so stop its planning right away
         if (long_callback_thread_.joinable())
         {
-          // Try to terminate the execution thread
+          // Resetting the planner terminates the in-flight planning, which makes the execution thread finish
+          global_planner_instance_->reset();
           auto future = std::async(std::launch::async, &std::thread::join, &long_callback_thread_);
           if (future.wait_for(JOIN_THREAD_TIMEOUT) == std::future_status::timeout)
           {
-            RCLCPP_WARN(LOGGER, "Another goal was running. Rejecting the new hybrid planning goal.");
+            RCLCPP_WARN(LOGGER, "Another goal is still running after being preempted. Rejecting the new global "
+                                "planning goal.");
             return rclcpp_action::GoalResponse::REJECT;
           }
           if (!global_planner_instance_->reset())
@@ -100,6 +102,8 @@ bool GlobalPlannerComponent::initializeGlobalPlanner()
         RCLCPP_INFO(LOGGER, "Received request to cancel global planning goal");
         if (long_callback_thread_.joinable())
         {
+          // Terminate the in-flight planning instead of waiting for it to finish
+          global_planner_instance_->reset();
           long_callback_thread_.join();
         }
         if (!global_planner_instance_->reset())
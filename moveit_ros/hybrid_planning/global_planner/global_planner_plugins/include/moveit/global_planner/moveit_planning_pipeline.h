@@ -37,6 +37,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include <rclcpp/rclcpp.hpp>
 #include <moveit/global_planner/global_planner_interface.h>
 
@@ -46,6 +48,28 @@
 
 namespace moveit::hybrid_planning
 {
+/**
+ * Get the part of the last solution that starts at the waypoint closest to the current state and ends halfway to its
+ * first invalid waypoint, to keep a margin to the obstacle that invalidated it. The waypoints keep their timing.
+ * @param is_valid Check whether a waypoint of the last solution is still valid
+ * @param remainder_valid Set to true if the whole rest of the last solution is still valid. It is returned then.
+ * @return The usable part of the last solution, or nullptr if there is none
+ */
+robot_trajectory::RobotTrajectoryPtr
+getWarmStartTrajectory(const robot_trajectory::RobotTrajectory& last_solution,
+                       const moveit::core::RobotState& current_state,
+                       const std::function<bool(const moveit::core::RobotState&)>& is_valid, bool& remainder_valid);
+
+/**
+ * Append a trajectory that was planned from the last waypoint of a warm start trajectory to it. The appended waypoints
+ * are time-parameterized to continue with the velocity at the end of the warm start, or the whole trajectory is
+ * re-timed if the continuation does not leave in the direction of that velocity.
+ * @return false if the combined trajectory could not be time-parameterized, the warm start is unchanged then
+ */
+bool appendToWarmStartTrajectory(robot_trajectory::RobotTrajectory& warm_start,
+                                 const robot_trajectory::RobotTrajectory& continuation,
+                                 double max_velocity_scaling_factor, double max_acceleration_scaling_factor);
+
 class MoveItPlanningPipeline : public GlobalPlannerInterface
 {
 public:
@@ -60,5 +84,12 @@ public:
 private:
   rclcpp::Node::SharedPtr node_ptr_;
   std::shared_ptr<moveit_cpp::MoveItCpp> moveit_cpp_;
+
+  // Whether replanning for the same goal continues from the still valid part of the last solution
+  bool warm_start_ = false;
+
+  // The last solution and the goal it was planned for, the reference trajectory that warm starts continue from
+  robot_trajectory::RobotTrajectoryPtr last_solution_;
+  std::vector<moveit_msgs::msg::Constraints> last_goal_constraints_;
 };
 }  // namespace moveit::hybrid_planning
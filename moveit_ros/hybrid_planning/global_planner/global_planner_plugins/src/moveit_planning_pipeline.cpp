@@ -35,6 +35,9 @@
 #include <moveit/global_planner/moveit_planning_pipeline.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+
+#include <limits>
 
 namespace
 {
@@ -79,6 +82,9 @@ bool MoveItPlanningPipeline::initialize(const rclcpp::Node::SharedPtr& node)
   // Trajectory Execution Functionality (required by the MoveItPlanningPipeline but not used within hybrid planning)
   node->declare_parameter<std::string>("moveit_controller_manager", UNDEFINED);
 
+  // Replan from the valid part of the last solution instead of from the current state
+  warm_start_ = node->declare_parameter<bool>("warm_start", false);
+
   node_ptr_ = node;
 
   // Initialize MoveItCpp API
@@ -90,7 +96,101 @@ bool MoveItPlanningPipeline::initialize(const rclcpp::Node::SharedPtr& node)
 
 bool MoveItPlanningPipeline::reset() noexcept
 {
-  // Do Nothing
+  // Terminate a running plan() so that it returns right away when the global planning goal is preempted
+  if (moveit_cpp_)
+  {
+    for (const auto& [name, planning_pipeline] : moveit_cpp_->getPlanningPipelines())
+    {
+      if (planning_pipeline->isActive())
+      {
+        RCLCPP_INFO(LOGGER, "Terminating planning pipeline '%s'", name.c_str());
+        planning_pipeline->terminate();
+      }
+    }
+  }
+  return true;
+}
+
+robot_trajectory::RobotTrajectoryPtr
+getWarmStartTrajectory(const robot_trajectory::RobotTrajectory& last_solution,
+                       const moveit::core::RobotState& current_state,
+                       const std::function<bool(const moveit::core::RobotState&)>& is_valid, bool& remainder_valid)
+{
+  remainder_valid = false;
+  const moveit::core::JointModelGroup* group = last_solution.getGroup();
+  if (!group || last_solution.empty())
+  {
+    return nullptr;
+  }
+
+  // The robot follows the last solution, so continue from the waypoint it is closest to
+  std::size_t first = 0;
+  double min_distance = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < last_solution.getWayPointCount(); ++i)
+  {
+    const double distance = current_state.distance(last_solution.getWayPoint(i), group);
+    if (distance < min_distance)
+    {
+      min_distance = distance;
+      first = i;
+    }
+  }
+
+  std::size_t first_invalid = last_solution.getWayPointCount();
+  moveit::core::RobotState waypoint(last_solution.getRobotModel());
+  for (std::size_t i = first; i < last_solution.getWayPointCount(); ++i)
+  {
+    waypoint = last_solution.getWayPoint(i);
+    waypoint.update();
+    if (!is_valid(waypoint))
+    {
+      first_invalid = i;
+      break;
+    }
+  }
+
+  remainder_valid = first_invalid == last_solution.getWayPointCount();
+  const std::size_t last = remainder_valid ? first_invalid - 1 : first + (first_invalid - first) / 2;
+  if (!remainder_valid && last <= first)
+  {
+    return nullptr;
+  }
+  // The waypoints keep their timing, which the robot is executing already. Only the first one becomes the start.
+  auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(last_solution.getRobotModel(), group);
+  trajectory->append(last_solution, 0.0, first, last + 1);
+  return trajectory;
+}
+
+bool appendToWarmStartTrajectory(robot_trajectory::RobotTrajectory& warm_start,
+                                 const robot_trajectory::RobotTrajectory& continuation,
+                                 double max_velocity_scaling_factor, double max_acceleration_scaling_factor)
+{
+  if (warm_start.empty() || continuation.getWayPointCount() < 2)
+  {
+    return !warm_start.empty();
+  }
+
+  // The continuation starts at the last waypoint of the warm start, so skip its first waypoint. Its timing starts at
+  // rest though, while the robot still moves at the end of the warm start, so the appended waypoints are re-timed.
+  const std::size_t splice_index = warm_start.getWayPointCount() - 1;
+  robot_trajectory::RobotTrajectory stitched(warm_start, true);
+  stitched.append(continuation, 0.0, 1);
+
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  if (totg.computeTimeStampsIncremental(stitched, splice_index, max_velocity_scaling_factor,
+                                        max_acceleration_scaling_factor))
+  {
+    warm_start = stitched;
+    return true;
+  }
+
+  // The continuation leaves the end of the warm start in another direction, which can't be reached without stopping
+  RCLCPP_DEBUG(LOGGER, "The replanned trajectory does not continue the motion of the warm start, re-timing both");
+  if (!totg.computeTimeStamps(stitched, max_velocity_scaling_factor, max_acceleration_scaling_factor))
+  {
+    return false;
+  }
+  warm_start = stitched;
   return true;
 }
 
@@ -130,19 +230,67 @@ moveit_msgs::msg::MotionPlanResponse MoveItPlanningPipeline::plan(
   // Copy goal constraint into planning component
   planning_components->setGoal(motion_plan_req.goal_constraints);
 
-  // Plan motion
-  auto plan_solution = planning_components->plan(plan_params);
-  if (!bool(plan_solution.error_code))
+  // When replanning for the same goal, keep the part of the last solution that is still valid and only plan the rest
+  robot_trajectory::RobotTrajectoryPtr warm_start_trajectory;
+  bool remainder_valid = false;
+  if (warm_start_ && last_solution_ && last_solution_->getGroupName() == motion_plan_req.group_name &&
+      last_goal_constraints_ == motion_plan_req.goal_constraints)
   {
-    response.error_code = plan_solution.error_code;
-    return response;
+    const moveit::core::RobotStatePtr current_state = moveit_cpp_->getCurrentState();
+    if (current_state)
+    {
+      planning_scene_monitor::LockedPlanningSceneRO scene(moveit_cpp_->getPlanningSceneMonitor());
+      warm_start_trajectory = getWarmStartTrajectory(
+          *last_solution_, *current_state,
+          [&](const moveit::core::RobotState& waypoint) {
+            return scene->isStateValid(waypoint, motion_plan_req.group_name);
+          },
+          remainder_valid);
+    }
+  }
+
+  robot_trajectory::RobotTrajectoryPtr solution;
+  if (warm_start_trajectory && remainder_valid)
+  {
+    RCLCPP_INFO(LOGGER, "The rest of the last solution is still valid, reusing it");
+    solution = warm_start_trajectory;
+  }
+  else
+  {
+    if (warm_start_trajectory)
+    {
+      planning_components->setStartState(warm_start_trajectory->getLastWayPoint());
+    }
+
+    // Plan motion
+    auto plan_solution = planning_components->plan(plan_params);
+    if (!bool(plan_solution.error_code))
+    {
+      response.error_code = plan_solution.error_code;
+      return response;
+    }
+    solution = plan_solution.trajectory;
+
+    if (warm_start_trajectory)
+    {
+      if (!appendToWarmStartTrajectory(*warm_start_trajectory, *solution, plan_params.max_velocity_scaling_factor,
+                                       plan_params.max_acceleration_scaling_factor))
+      {
+        RCLCPP_ERROR(LOGGER, "Failed to time-parameterize the replanned trajectory appended to the warm start");
+        response.error_code.val = moveit_msgs::msg::MoveItErrorCodes::PLANNING_FAILED;
+        return response;
+      }
+      solution = warm_start_trajectory;
+    }
   }
+  last_solution_ = solution;
+  last_goal_constraints_ = motion_plan_req.goal_constraints;
 
   // Transform solution into MotionPlanResponse and publish it
-  response.trajectory_start = plan_solution.start_state;
+  moveit::core::robotStateToRobotStateMsg(solution->getFirstWayPoint(), response.trajectory_start);
   response.group_name = motion_plan_req.group_name;
-  plan_solution.trajectory->getRobotTrajectoryMsg(response.trajectory);
-  response.error_code = plan_solution.error_code;
+  solution->getRobotTrajectoryMsg(response.trajectory);
+  response.error_code.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
 
   return response;
 }
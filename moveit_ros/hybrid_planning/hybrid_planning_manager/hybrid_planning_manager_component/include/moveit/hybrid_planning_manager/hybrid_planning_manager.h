@@ -131,6 +131,10 @@ private:
   // Flag that indicates hybrid planning has been canceled
   std::atomic<bool> stop_hybrid_planning_;
 
+  // Number of global planning goals sent so far. A newer goal preempts the previous one in the global planner, so only
+  // the result of the latest goal is passed on to the planner logic.
+  std::atomic<std::size_t> global_goal_count_;
+
   // Shared hybrid planning goal handle
   std::shared_ptr<rclcpp_action::ServerGoalHandle<moveit_msgs::action::HybridPlanner>> hybrid_planning_goal_handle_;
 
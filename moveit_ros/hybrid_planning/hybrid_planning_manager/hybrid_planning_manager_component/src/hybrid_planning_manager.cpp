@@ -45,7 +45,7 @@ namespace moveit::hybrid_planning
 using namespace std::chrono_literals;
 
 HybridPlanningManager::HybridPlanningManager(const rclcpp::NodeOptions& options)
-  : Node("hybrid_planning_manager", options), initialized_(false), stop_hybrid_planning_(false)
+  : Node("hybrid_planning_manager", options), initialized_(false), stop_hybrid_planning_(false), global_goal_count_(0)
 {
   // Initialize hybrid planning component after construction
   // TODO(sjahr) Remove once life cycle component nodes are available
@@ -228,6 +228,7 @@ void HybridPlanningManager::executeHybridPlannerGoal(
 bool HybridPlanningManager::sendGlobalPlannerAction()
 {
   auto global_goal_options = rclcpp_action::Client<moveit_msgs::action::GlobalPlanner>::SendGoalOptions();
+  const std::size_t global_goal_number = ++global_goal_count_;
 
   // Add goal response callback
   global_goal_options.goal_response_callback =
@@ -246,7 +247,14 @@ bool HybridPlanningManager::sendGlobalPlannerAction()
       };
   // Add result callback
   global_goal_options.result_callback =
-      [this](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::GlobalPlanner>::WrappedResult& global_result) {
+      [this, global_goal_number](
+          const rclcpp_action::ClientGoalHandle<moveit_msgs::action::GlobalPlanner>::WrappedResult& global_result) {
+        // A newer global goal preempted this one, so its result is outdated
+        if (global_goal_number != global_goal_count_)
+        {
+          RCLCPP_DEBUG(LOGGER, "Ignoring the result of a preempted global planning goal");
+          return;
+        }
         // Reaction result from the latest event
         ReactionResult reaction_result =
             ReactionResult(HybridPlanningEvent::UNDEFINED, "", moveit_msgs::msg::MoveItErrorCodes::FAILURE);
@@ -35,7 +35,7 @@
 /* Author: Sebastian Jahr
    Description: Simple hybrid planning logic that runs the global planner once and starts executing the global solution
    with the local planner. In case the local planner detects a collision the global planner is rerun to update the
-   invalidated global trajectory.
+   invalidated global trajectory. A newer replanning request preempts a global planning that is still running.
  */
 
 #include <moveit/planner_logic_plugins/single_plan_execution.h>
@@ -101,13 +101,20 @@ ForwardTrajectory::solve(const robot_trajectory::RobotTrajectory& local_trajecto
   }
   else
   {
-    // Get current planning scene
-    planning_scene_monitor_->updateFrameTransforms();
-
     moveit::core::RobotStatePtr current_state;
     bool is_path_valid = false;
-    // Lock the planning scene as briefly as possible
+    // Check against the latest scene snapshot, if the monitor publishes them. It is kept up to date by the monitor and
+    // can be read without waiting for a lock.
+    if (const planning_scene::PlanningSceneConstPtr snapshot = planning_scene_monitor_->getPlanningSceneSnapshot())
+    {
+      current_state = std::make_shared<moveit::core::RobotState>(snapshot->getCurrentState());
+      is_path_valid = snapshot->isPathValid(local_trajectory, local_trajectory.getGroupName(), false);
+    }
+    // Otherwise, lock the planning scene as briefly as possible
+    else
     {
+      // Get current planning scene
+      planning_scene_monitor_->updateFrameTransforms();
       planning_scene_monitor_->updateSceneWithCurrentState();
       planning_scene_monitor::LockedPlanningSceneRO locked_planning_scene(planning_scene_monitor_);
       current_state = std::make_shared<moveit::core::RobotState>(locked_planning_scene->getCurrentState());
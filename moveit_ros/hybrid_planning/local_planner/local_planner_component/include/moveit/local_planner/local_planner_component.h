@@ -57,6 +57,7 @@
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/local_planner/local_constraint_solver_interface.h>
 #include <moveit/local_planner/trajectory_operator_interface.h>
+#include <moveit/local_planner/trajectory_lookahead_validator.h>
 
 #include <tf2_ros/buffer.h>
 #include <tf2_ros/transform_listener.h>
@@ -117,6 +118,11 @@ public:
                                      undefined, node);
       declareOrGetParam<std::string>("local_planning_action_name", local_planning_action_name, undefined, node);
       declareOrGetParam<double>("local_planning_frequency", local_planning_frequency, 1.0, node);
+      declareOrGetParam<bool>("use_realtime_loop", use_realtime_loop, false, node);
+      declareOrGetParam<int>("realtime_thread_priority", realtime_thread_priority, 40, node);
+      declareOrGetParam<bool>("lookahead_validation", lookahead_validation, false, node);
+      declareOrGetParam<double>("lookahead_check_period", lookahead_check_period, 0.1, node);
+      declareOrGetParam<double>("lookahead_padding", lookahead_padding, 0.05, node);
       declareOrGetParam<std::string>("global_solution_topic", global_solution_topic, undefined, node);
       declareOrGetParam<std::string>("local_solution_topic", local_solution_topic, undefined, node);
       declareOrGetParam<std::string>("local_solution_topic_type", local_solution_topic_type, undefined, node);
@@ -141,6 +147,16 @@ public:
     bool publish_joint_positions;
     bool publish_joint_velocities;
     double local_planning_frequency;
+    // Run the local planner on a dedicated thread with a fixed period instead of a wall timer
+    bool use_realtime_loop;
+    // SCHED_FIFO priority of the local planner thread if a realtime kernel is installed
+    int realtime_thread_priority;
+    // Check the remaining reference trajectory for collisions in the background and report collisions ahead early
+    bool lookahead_validation;
+    // Time between two checks of the remaining reference trajectory in seconds
+    double lookahead_check_period;
+    // Padding in meters for finding the waypoints affected by a change of the world
+    double lookahead_padding;
     std::string monitored_planning_scene_topic;
     std::string collision_object_topic;
     std::string joint_states_topic;
@@ -152,6 +168,8 @@ public:
   /** \brief Destructor */
   ~LocalPlannerComponent()
   {
+    // Stop the realtime local planning loop, if it is running
+    realtime_loop_active_ = false;
     // Join the thread used for long-running callbacks
     if (long_callback_thread_.joinable())
     {
@@ -172,6 +190,15 @@ public:
    */
   void executeIteration();
 
+  /**
+   * Get the number of iterations of the realtime local planning loop that did not finish within the local planning
+   * period, since the component was started.
+   */
+  std::size_t getMissedDeadlineCount() const
+  {
+    return missed_deadline_count_;
+  }
+
   // This function is required to make this class a valid NodeClass
   // see https://docs.ros2.org/foxy/api/rclcpp_components/register__node__macro_8hpp.html
   rclcpp::node_interfaces::NodeBaseInterface::SharedPtr get_node_base_interface()  // NOLINT
@@ -183,6 +210,13 @@ private:
   /** \brief Reset internal data members including state_ = LocalPlannerState::AWAIT_GLOBAL_TRAJECTORY */
   void reset();
 
+  /**
+   * Call executeIteration() with the local planning frequency until reset() is called, on the calling thread. Each
+   * iteration starts at a fixed deadline; iterations that overrun the period are recorded as missed deadlines and the
+   * periods they overran are skipped.
+   */
+  void runRealtimeLoop();
+
   std::shared_ptr<rclcpp::Node> node_;
 
   // Planner configuration
@@ -194,6 +228,12 @@ private:
   // Timer to periodically call executeIteration()
   rclcpp::TimerBase::SharedPtr timer_;
 
+  // True while runRealtimeLoop() should keep calling executeIteration()
+  std::atomic<bool> realtime_loop_active_{ false };
+
+  // Number of realtime loop iterations that overran the local planning period
+  std::atomic<std::size_t> missed_deadline_count_{ 0 };
+
   // Latest action goal handle
   std::shared_ptr<rclcpp_action::ServerGoalHandle<moveit_msgs::action::LocalPlanner>> local_planning_goal_handle_;
 
@@ -229,6 +269,12 @@ private:
   // Trajectory_operator instance handle trajectory matching and blending
   std::shared_ptr<TrajectoryOperatorInterface> trajectory_operator_instance_;
 
+  // Checks the remaining reference trajectory for collisions in the background, if enabled
+  std::unique_ptr<TrajectoryLookaheadValidator> lookahead_validator_;
+
+  // True once a collision found by the lookahead validator has been reported for the current reference trajectory
+  bool lookahead_collision_reported_ = false;
+
   // This thread is used for long-running callbacks. It's a member so they do not go out of scope.
   std::thread long_callback_thread_;
 
@@ -0,0 +1,139 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: Validator that continuously checks the remaining reference trajectory of the local planner for
+   collisions in the background, rechecking only the waypoints affected by changes of the world.
+ */
+
+#pragma once
+
+#include <moveit/collision_detection/world_diff.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+#include <Eigen/Geometry>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace moveit::hybrid_planning
+{
+/**
+ * Class TrajectoryLookaheadValidator - Checks the remaining reference trajectory of the local planner for collisions
+ * on a background thread, so that collisions far ahead of the robot are detected early.
+ * A new trajectory is checked completely once. After that, only the waypoints whose bounding boxes overlap world
+ * objects that were added, moved or removed since the previous check are checked again, based on the changes a
+ * WorldDiff records for the monitored world. Changes of the attached objects cause a complete recheck.
+ */
+class TrajectoryLookaheadValidator
+{
+public:
+  /**
+   * Start checking in the background
+   * @param planning_scene_monitor Monitor of the scene the trajectory is checked in
+   * @param group_name Name of the joint group the trajectory uses
+   * @param check_period Time between two checks in seconds
+   * @param padding Distance in meters the bounding boxes of the waypoints are enlarged by when looking for the
+   * waypoints affected by a world change
+   */
+  TrajectoryLookaheadValidator(const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+                               const std::string& group_name, double check_period, double padding);
+
+  /** \brief Destructor, stops checking */
+  ~TrajectoryLookaheadValidator();
+
+  /**
+   * Set the reference trajectory to check, replacing the previous one
+   * @param trajectory The reference trajectory
+   */
+  void setTrajectory(const robot_trajectory::RobotTrajectory& trajectory);
+
+  /** \brief Stop checking the current reference trajectory */
+  void clearTrajectory();
+
+  /**
+   * Set the index of the reference trajectory waypoint the robot currently moves to. The waypoints before it are not
+   * checked anymore.
+   * @param index Index of the current waypoint
+   */
+  void setCurrentWaypointIndex(std::size_t index);
+
+  /**
+   * Get the first invalid waypoint at or after the current waypoint that the most recent check found
+   * @return Index of the first invalid waypoint, or no value if all waypoints checked so far are valid
+   */
+  std::optional<std::size_t> getFirstInvalidWaypointIndex() const;
+
+private:
+  /** \brief Check the trajectory every check period until the validator is destroyed */
+  void run();
+
+  /** \brief Check the waypoints of the trajectory that are affected by changes since the previous check */
+  void check();
+
+  planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
+  std::string group_name_;
+  std::chrono::duration<double> check_period_;
+  double padding_;
+
+  // Trajectory set by the local planner and the result of the most recent check, guarded by mutex_
+  mutable std::mutex mutex_;
+  std::shared_ptr<const std::vector<moveit::core::RobotState>> trajectory_;
+  std::size_t trajectory_version_ = 0;
+  std::optional<std::size_t> first_invalid_index_;
+  std::atomic<std::size_t> current_index_{ 0 };
+
+  // State of the checking thread
+  std::size_t checked_version_ = 0;
+  std::vector<Eigen::AlignedBox3d> waypoint_boxes_;
+  std::vector<char> waypoint_valid_;
+  collision_detection::WorldDiff world_diff_;
+  std::weak_ptr<const collision_detection::World> recorded_world_;
+  std::map<std::string, Eigen::AlignedBox3d> object_boxes_;
+  std::vector<std::string> attached_body_ids_;
+
+  bool stop_ = false;  // guarded by mutex_
+  std::condition_variable wakeup_;
+  std::thread thread_;
+};
+}  // namespace moveit::hybrid_planning
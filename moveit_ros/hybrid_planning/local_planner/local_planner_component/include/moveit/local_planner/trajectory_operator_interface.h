@@ -101,6 +101,16 @@ public:
    */
   virtual double getTrajectoryProgress(const moveit::core::RobotState& current_state) = 0;
 
+  /**
+   * Return the index of the reference trajectory waypoint that is currently followed, if the operator tracks it.
+   * The waypoints before it are not checked for collisions ahead of the robot anymore.
+   * @return Index of the current waypoint, 0 by default
+   */
+  virtual std::size_t getCurrentWaypointIndex() const
+  {
+    return 0;
+  }
+
   /**
    * Reset trajectory operator to some user-defined initial state
    * @return True if reset was successful
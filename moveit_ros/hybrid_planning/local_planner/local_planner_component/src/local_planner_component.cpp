@@ -33,6 +33,7 @@
  *********************************************************************/
 
 #include <moveit/local_planner/local_planner_component.h>
+#include <moveit/local_planner/feedback_types.h>
 
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_state/robot_state.h>
@@ -41,6 +42,11 @@
 
 #include <moveit_msgs/msg/constraints.hpp>
 
+#include <realtime_tools/thread_priority.hpp>
+
+#include <chrono>
+#include <optional>
+
 namespace moveit::hybrid_planning
 {
 using namespace std::chrono_literals;
@@ -52,6 +58,9 @@ const auto JOIN_THREAD_TIMEOUT = std::chrono::seconds(1);
 
 // If the trajectory progress reaches more than 0.X the global goal state is considered as reached
 constexpr float PROGRESS_THRESHOLD = 0.995;
+
+// Minimum time between warnings about missed deadlines of the realtime loop
+constexpr int MISSED_DEADLINE_WARN_PERIOD_MS = 1000;
 }  // namespace
 
 LocalPlannerComponent::LocalPlannerComponent(const rclcpp::NodeOptions& options)
@@ -98,6 +107,11 @@ bool LocalPlannerComponent::initialize()
   planning_scene_monitor_->startStateMonitor(config_.joint_states_topic, "/attached_collision_object");
   planning_scene_monitor_->monitorDiffs(true);
   planning_scene_monitor_->stopPublishingPlanningScene();
+  // The realtime loop reads immutable scene snapshots so that it never waits for the lock held by scene updates
+  if (config_.use_realtime_loop)
+  {
+    planning_scene_monitor_->publishSceneSnapshots(true);
+  }
 
   // Load trajectory operator plugin
   try
@@ -152,6 +166,12 @@ bool LocalPlannerComponent::initialize()
     return false;
   }
 
+  if (config_.lookahead_validation)
+  {
+    lookahead_validator_ = std::make_unique<TrajectoryLookaheadValidator>(
+        planning_scene_monitor_, config_.group_name, config_.lookahead_check_period, config_.lookahead_padding);
+  }
+
   // Initialize local planning request action server
   cb_group_ = node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
   local_planning_request_server_ = rclcpp_action::create_server<moveit_msgs::action::LocalPlanner>(
@@ -193,6 +213,12 @@ bool LocalPlannerComponent::initialize()
         }
         // Start a local planning loop.
         // This needs to return quickly to avoid blocking the executor, so run the local planner in a new thread.
+        if (config_.use_realtime_loop)
+        {
+          realtime_loop_active_ = true;
+          long_callback_thread_ = std::thread([this]() { runRealtimeLoop(); });
+          return;
+        }
         auto local_planner_timer = [&]() {
           timer_ =
               node_->create_wall_timer(1s / config_.local_planning_frequency, [this]() { return executeIteration(); });
@@ -210,6 +236,11 @@ bool LocalPlannerComponent::initialize()
         moveit::core::robotStateMsgToRobotState(msg->trajectory_start, start_state);
         new_trajectory.setRobotTrajectoryMsg(start_state, msg->trajectory);
         *local_planner_feedback_ = trajectory_operator_instance_->addTrajectorySegment(new_trajectory);
+        if (lookahead_validator_)
+        {
+          lookahead_validator_->setTrajectory(new_trajectory);
+          lookahead_collision_reported_ = false;
+        }
 
         // Feedback is only send when the hybrid planning architecture should react to a discrete event that occurred
         // when the reference trajectory is updated
@@ -268,6 +299,10 @@ void LocalPlannerComponent::executeIteration()
     {
       // Read current robot state
       const moveit::core::RobotState current_robot_state = [this] {
+        if (const planning_scene::PlanningSceneConstPtr snapshot = planning_scene_monitor_->getPlanningSceneSnapshot())
+        {
+          return snapshot->getCurrentState();
+        }
         planning_scene_monitor::LockedPlanningSceneRO ls(planning_scene_monitor_);
         return ls->getCurrentState();
       }();
@@ -296,6 +331,21 @@ void LocalPlannerComponent::executeIteration()
         return;
       }
 
+      // Report collisions that the lookahead validator found further ahead on the reference trajectory, so that
+      // replanning can start before the local constraint solver runs into them
+      if (lookahead_validator_)
+      {
+        lookahead_validator_->setCurrentWaypointIndex(trajectory_operator_instance_->getCurrentWaypointIndex());
+        const std::optional<std::size_t> invalid_index = lookahead_validator_->getFirstInvalidWaypointIndex();
+        if (invalid_index && !lookahead_collision_reported_)
+        {
+          RCLCPP_INFO(LOGGER, "Collision ahead at waypoint %zu of the reference trajectory", *invalid_index);
+          local_planner_feedback_->feedback = toString(LocalFeedbackEnum::COLLISION_AHEAD);
+          local_planning_goal_handle_->publish_feedback(local_planner_feedback_);
+          lookahead_collision_reported_ = true;
+        }
+      }
+
       // Solve local planning problem
       trajectory_msgs::msg::JointTrajectory local_solution;
 
@@ -354,11 +404,64 @@ void LocalPlannerComponent::executeIteration()
   }
 };
 
+void LocalPlannerComponent::runRealtimeLoop()
+{
+  // Check if a realtime kernel is installed. Set a higher thread priority, if so
+  if (realtime_tools::has_realtime_kernel())
+  {
+    if (!realtime_tools::configure_sched_fifo(config_.realtime_thread_priority))
+    {
+      RCLCPP_WARN(LOGGER, "Could not enable FIFO RT scheduling policy");
+    }
+  }
+  else
+  {
+    RCLCPP_INFO(LOGGER, "RT kernel is recommended for better performance");
+  }
+
+  const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / config_.local_planning_frequency));
+  auto deadline = std::chrono::steady_clock::now() + period;
+  while (rclcpp::ok() && realtime_loop_active_)
+  {
+    executeIteration();
+
+    // Watchdog: record the overrun and skip the periods that have already passed, instead of catching up with a burst
+    // of iterations
+    const auto now = std::chrono::steady_clock::now();
+    if (now > deadline)
+    {
+      const auto overrun = now - deadline;
+      ++missed_deadline_count_;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+      RCLCPP_WARN_THROTTLE(LOGGER, *node_->get_clock(), MISSED_DEADLINE_WARN_PERIOD_MS,
+                           "Local planning iteration overran its period by %.3f ms (%zu missed deadlines)",
+                           std::chrono::duration<double, std::milli>(overrun).count(),
+                           missed_deadline_count_.load());
+#pragma GCC diagnostic pop
+      deadline += period * (overrun / period + 1);
+      continue;
+    }
+    std::this_thread::sleep_until(deadline);
+    deadline += period;
+  }
+}
+
 void LocalPlannerComponent::reset()
 {
   local_constraint_solver_instance_->reset();
   trajectory_operator_instance_->reset();
-  timer_->cancel();
+  if (lookahead_validator_)
+  {
+    lookahead_validator_->clearTrajectory();
+  }
+  lookahead_collision_reported_ = false;
+  if (timer_)
+  {
+    timer_->cancel();
+  }
+  realtime_loop_active_ = false;
   state_ = LocalPlannerState::AWAIT_GLOBAL_TRAJECTORY;
 }
 }  // namespace moveit::hybrid_planning
@@ -0,0 +1,292 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/local_planner/trajectory_lookahead_validator.h>
+
+#include <moveit/planning_scene/planning_scene.h>
+
+#include <geometric_shapes/aabb.h>
+#include <geometric_shapes/bodies.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace moveit::hybrid_planning
+{
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("local_planner_component.trajectory_lookahead_validator");
+
+// Bounding box of all shapes of a world object. Shapes without a finite bounding box, e.g. octrees and planes, make the
+// box infinite, so that any change of the object affects all waypoints.
+Eigen::AlignedBox3d computeObjectBox(const collision_detection::World::Object& object)
+{
+  Eigen::AlignedBox3d box;
+  for (std::size_t i = 0; i < object.shapes_.size(); ++i)
+  {
+    const std::unique_ptr<bodies::Body> body(bodies::createBodyFromShape(object.shapes_[i].get()));
+    if (!body)
+    {
+      constexpr double INF = std::numeric_limits<double>::infinity();
+      return Eigen::AlignedBox3d(Eigen::Vector3d::Constant(-INF), Eigen::Vector3d::Constant(INF));
+    }
+    body->setPose(object.global_shape_poses_[i]);
+    bodies::AABB shape_box;
+    body->computeBoundingBox(shape_box);
+    box.extend(shape_box);
+  }
+  return box;
+}
+}  // namespace
+
+TrajectoryLookaheadValidator::TrajectoryLookaheadValidator(
+    const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor, const std::string& group_name,
+    double check_period, double padding)
+  : planning_scene_monitor_(planning_scene_monitor)
+  , group_name_(group_name)
+  , check_period_(check_period)
+  , padding_(padding)
+  , thread_([this] { run(); })
+{
+}
+
+TrajectoryLookaheadValidator::~TrajectoryLookaheadValidator()
+{
+  {
+    std::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+
+  // Unregister from the world while no scene update can notify the diff
+  planning_scene_monitor::LockedPlanningSceneRW scene(planning_scene_monitor_);
+  world_diff_.reset();
+}
+
+void TrajectoryLookaheadValidator::setTrajectory(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  auto waypoints = std::make_shared<std::vector<moveit::core::RobotState>>();
+  waypoints->reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    waypoints->push_back(trajectory.getWayPoint(i));
+    waypoints->back().update();
+  }
+
+  {
+    std::scoped_lock lock(mutex_);
+    trajectory_ = std::move(waypoints);
+    ++trajectory_version_;
+    first_invalid_index_.reset();
+    current_index_ = 0;
+  }
+  // check the new trajectory right away
+  wakeup_.notify_one();
+}
+
+void TrajectoryLookaheadValidator::clearTrajectory()
+{
+  std::scoped_lock lock(mutex_);
+  trajectory_.reset();
+  ++trajectory_version_;
+  first_invalid_index_.reset();
+  current_index_ = 0;
+}
+
+void TrajectoryLookaheadValidator::setCurrentWaypointIndex(std::size_t index)
+{
+  current_index_ = index;
+}
+
+std::optional<std::size_t> TrajectoryLookaheadValidator::getFirstInvalidWaypointIndex() const
+{
+  std::scoped_lock lock(mutex_);
+  if (first_invalid_index_ && *first_invalid_index_ >= current_index_)
+  {
+    return first_invalid_index_;
+  }
+  return std::nullopt;
+}
+
+void TrajectoryLookaheadValidator::run()
+{
+  std::unique_lock lock(mutex_);
+  while (!stop_)
+  {
+    lock.unlock();
+    check();
+    lock.lock();
+    wakeup_.wait_for(lock, check_period_);
+  }
+}
+
+void TrajectoryLookaheadValidator::check()
+{
+  std::shared_ptr<const std::vector<moveit::core::RobotState>> trajectory;
+  std::size_t version;
+  {
+    std::scoped_lock lock(mutex_);
+    trajectory = trajectory_;
+    version = trajectory_version_;
+  }
+  if (!trajectory || trajectory->empty())
+  {
+    return;
+  }
+
+  bool check_all = false;
+  if (version != checked_version_)
+  {
+    checked_version_ = version;
+    waypoint_boxes_.clear();
+    waypoint_boxes_.reserve(trajectory->size());
+    std::vector<double> aabb;
+    for (const moveit::core::RobotState& waypoint : *trajectory)
+    {
+      waypoint.computeAABB(aabb);
+      waypoint_boxes_.emplace_back(Eigen::Vector3d(aabb[0], aabb[2], aabb[4]) - Eigen::Vector3d::Constant(padding_),
+                                   Eigen::Vector3d(aabb[1], aabb[3], aabb[5]) + Eigen::Vector3d::Constant(padding_));
+    }
+    waypoint_valid_.assign(trajectory->size(), true);
+    check_all = true;
+  }
+
+  // Record the changes of a new world, e.g. after the monitor replaced its scene. Registering with the world modifies
+  // it, so this needs the write lock.
+  const bool new_world = [this] {
+    planning_scene_monitor::LockedPlanningSceneRO scene(planning_scene_monitor_);
+    return recorded_world_.lock() != scene->getWorld();
+  }();
+  if (new_world)
+  {
+    planning_scene_monitor::LockedPlanningSceneRW scene(planning_scene_monitor_);
+    world_diff_.reset(scene->getWorldNonConst());
+    recorded_world_ = scene->getWorld();
+    object_boxes_.clear();
+    check_all = true;
+  }
+
+  const std::size_t first_index = std::min<std::size_t>(current_index_, trajectory->size());
+  std::vector<std::size_t> waypoints_to_check;
+  planning_scene::PlanningScenePtr scene_copy;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO scene(planning_scene_monitor_);
+    const collision_detection::World& world = *scene->getWorld();
+
+    // Bounding boxes of the changed objects, before and after the change
+    std::vector<Eigen::AlignedBox3d> changed_boxes;
+    if (check_all)
+    {
+      object_boxes_.clear();
+      for (const std::string& id : world.getObjectIds())
+      {
+        object_boxes_[id] = computeObjectBox(*world.getObject(id));
+      }
+    }
+    else
+    {
+      for (const auto& [id, action] : world_diff_)
+      {
+        auto it = object_boxes_.find(id);
+        if (it != object_boxes_.end())
+        {
+          changed_boxes.push_back(it->second);
+          object_boxes_.erase(it);
+        }
+        if (const collision_detection::World::ObjectConstPtr object = world.getObject(id))
+        {
+          changed_boxes.push_back(computeObjectBox(*object));
+          object_boxes_[id] = changed_boxes.back();
+        }
+      }
+    }
+    // Only this thread reads the diff, and scene updates are excluded by the lock
+    world_diff_.clearChanges();
+
+    // Attached objects move with the robot, so any change of them affects all waypoints
+    std::vector<const moveit::core::AttachedBody*> attached_bodies;
+    scene->getCurrentState().getAttachedBodies(attached_bodies);
+    std::vector<std::string> attached_body_ids;
+    for (const moveit::core::AttachedBody* attached_body : attached_bodies)
+    {
+      attached_body_ids.push_back(attached_body->getName());
+    }
+    std::sort(attached_body_ids.begin(), attached_body_ids.end());
+    if (attached_body_ids != attached_body_ids_)
+    {
+      attached_body_ids_ = std::move(attached_body_ids);
+      check_all = true;
+    }
+
+    for (std::size_t i = first_index; i < trajectory->size(); ++i)
+    {
+      if (check_all || std::any_of(changed_boxes.begin(), changed_boxes.end(), [&](const Eigen::AlignedBox3d& box) {
+            return box.intersects(waypoint_boxes_[i]);
+          }))
+      {
+        waypoints_to_check.push_back(i);
+      }
+    }
+
+    // Check against a copy, so that the scene is not locked while checking
+    if (!waypoints_to_check.empty())
+    {
+      scene_copy = planning_scene::PlanningScene::clone(scene);
+    }
+  }
+
+  for (const std::size_t i : waypoints_to_check)
+  {
+    waypoint_valid_[i] = scene_copy->isStateValid((*trajectory)[i], group_name_);
+  }
+
+  std::optional<std::size_t> first_invalid_index;
+  const auto first_invalid = std::find(waypoint_valid_.begin() + first_index, waypoint_valid_.end(), false);
+  if (first_invalid != waypoint_valid_.end())
+  {
+    first_invalid_index = first_invalid - waypoint_valid_.begin();
+    if (!waypoints_to_check.empty())
+    {
+      RCLCPP_DEBUG(LOGGER, "Waypoint %zu of the reference trajectory is invalid", *first_invalid_index);
+    }
+  }
+
+  std::scoped_lock lock(mutex_);
+  if (trajectory_version_ == version)
+  {
+    first_invalid_index_ = first_invalid_index;
+  }
+}
+}  // namespace moveit::hybrid_planning
@@ -57,6 +57,10 @@ public:
   getLocalTrajectory(const moveit::core::RobotState& current_state,
                      robot_trajectory::RobotTrajectory& local_trajectory) override;
   double getTrajectoryProgress([[maybe_unused]] const moveit::core::RobotState& current_state) override;
+  std::size_t getCurrentWaypointIndex() const override
+  {
+    return next_waypoint_index_;
+  }
   bool reset() override;
 
 private:
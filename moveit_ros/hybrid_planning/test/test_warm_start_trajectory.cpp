@@ -0,0 +1,233 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: Tests of the warm start of the MoveIt planning pipeline global planner plugin */
+
+#include <gtest/gtest.h>
+
+#include <moveit/global_planner/moveit_planning_pipeline.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+namespace
+{
+constexpr double EPSILON = 1e-6;
+const std::string GROUP_NAME = "panda_arm";
+const std::vector<double> START = { 0.0, -0.5, 0.0, -2.0, 0.0, 1.5, 0.8 };
+const std::vector<double> GOAL = { 1.0, 0.3, 0.5, -1.2, 0.5, 2.0, 0.8 };
+const std::vector<double> OTHER_GOAL = { 0.0, 0.3, -0.5, -1.5, -0.5, 1.5, 0.8 };
+
+class WarmStartTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    ASSERT_TRUE(robot_model_);
+    // The URDF does not contain acceleration limits, which time parameterization needs
+    for (moveit::core::JointModel* joint_model : robot_model_->getActiveJointModels())
+    {
+      std::vector<moveit_msgs::msg::JointLimits> joint_bounds_msg(joint_model->getVariableBoundsMsg());
+      for (moveit_msgs::msg::JointLimits& joint_bound : joint_bounds_msg)
+      {
+        joint_bound.has_acceleration_limits = true;
+        joint_bound.max_acceleration = 1.0;
+      }
+      joint_model->setVariableBounds(joint_bounds_msg);
+    }
+    group_ = robot_model_->getJointModelGroup(GROUP_NAME);
+    ASSERT_TRUE(group_);
+  }
+
+  // A time-parameterized straight line in joint space, like a planned solution
+  robot_trajectory::RobotTrajectoryPtr makeSolution(const std::vector<double>& from,
+                                                    const std::vector<double>& to) const
+  {
+    auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, group_);
+    moveit::core::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    std::vector<double> positions(from.size());
+    for (std::size_t i = 0; i <= 10; ++i)
+    {
+      for (std::size_t j = 0; j < from.size(); ++j)
+        positions[j] = from[j] + 0.1 * i * (to[j] - from[j]);
+      state.setJointGroupPositions(group_, positions);
+      trajectory->addSuffixWayPoint(state, 0.0);
+    }
+    EXPECT_TRUE(trajectory_processing::TimeOptimalTrajectoryGeneration().computeTimeStamps(*trajectory));
+    return trajectory;
+  }
+
+  std::vector<double> getPositions(const moveit::core::RobotState& state) const
+  {
+    std::vector<double> positions;
+    state.copyJointGroupPositions(group_, positions);
+    return positions;
+  }
+
+  std::vector<double> getVelocities(const moveit::core::RobotState& state) const
+  {
+    std::vector<double> velocities;
+    state.copyJointGroupVelocities(group_, velocities);
+    return velocities;
+  }
+
+  // Check that the trajectory can be executed, time increases and the joint velocities are within their limits
+  void expectFeasible(const robot_trajectory::RobotTrajectory& trajectory) const
+  {
+    for (std::size_t i = 1; i < trajectory.getWayPointCount(); ++i)
+    {
+      EXPECT_GT(trajectory.getWayPointDurationFromPrevious(i), 0.0) << "waypoint " << i;
+      const std::vector<double> velocities = getVelocities(trajectory.getWayPoint(i));
+      for (std::size_t j = 0; j < velocities.size(); ++j)
+      {
+        const double max_velocity = group_->getActiveJointModels()[j]->getVariableBounds()[0].max_velocity_;
+        EXPECT_LE(std::abs(velocities[j]), max_velocity + EPSILON) << "waypoint " << i << ", joint " << j;
+      }
+    }
+    for (double velocity : getVelocities(trajectory.getLastWayPoint()))
+      EXPECT_NEAR(velocity, 0.0, EPSILON);
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  const moveit::core::JointModelGroup* group_ = nullptr;
+};
+}  // namespace
+
+// The rest of the last solution is reused with the timing the robot is executing already
+TEST_F(WarmStartTest, ReuseValidRemainder)
+{
+  const robot_trajectory::RobotTrajectoryPtr last_solution = makeSolution(START, GOAL);
+  const std::size_t count = last_solution->getWayPointCount();
+  ASSERT_GE(count, 8u);
+  const std::size_t current = count / 4;
+
+  bool remainder_valid = false;
+  const robot_trajectory::RobotTrajectoryPtr warm_start = moveit::hybrid_planning::getWarmStartTrajectory(
+      *last_solution, last_solution->getWayPoint(current), [](const moveit::core::RobotState&) { return true; },
+      remainder_valid);
+  ASSERT_TRUE(warm_start);
+  EXPECT_TRUE(remainder_valid);
+  ASSERT_EQ(warm_start->getWayPointCount(), count - current);
+
+  EXPECT_EQ(warm_start->getWayPointDurationFromPrevious(0), 0.0);
+  for (std::size_t i = 1; i < warm_start->getWayPointCount(); ++i)
+  {
+    EXPECT_NEAR(warm_start->getWayPointDurationFromPrevious(i),
+                last_solution->getWayPointDurationFromPrevious(current + i), EPSILON);
+  }
+  // the robot is moving at the current waypoint already
+  const std::vector<double> start_velocities = getVelocities(warm_start->getFirstWayPoint());
+  const std::vector<double> expected_velocities = getVelocities(last_solution->getWayPoint(current));
+  for (std::size_t j = 0; j < start_velocities.size(); ++j)
+    EXPECT_NEAR(start_velocities[j], expected_velocities[j], EPSILON);
+  expectFeasible(*warm_start);
+}
+
+// A replanned trajectory that continues the motion is appended without stopping at the end of the warm start
+TEST_F(WarmStartTest, ReplanAndAppend)
+{
+  const robot_trajectory::RobotTrajectoryPtr last_solution = makeSolution(START, GOAL);
+  const std::size_t count = last_solution->getWayPointCount();
+  ASSERT_GE(count, 8u);
+  const std::size_t current = count / 4;
+  const std::size_t first_invalid = 3 * count / 4;
+
+  bool remainder_valid = true;
+  const robot_trajectory::RobotTrajectoryPtr warm_start = moveit::hybrid_planning::getWarmStartTrajectory(
+      *last_solution, last_solution->getWayPoint(current),
+      [&](const moveit::core::RobotState& waypoint) {
+        return waypoint.distance(last_solution->getWayPoint(first_invalid), group_) > EPSILON;
+      },
+      remainder_valid);
+  ASSERT_TRUE(warm_start);
+  EXPECT_FALSE(remainder_valid);
+  const std::size_t splice_index = warm_start->getWayPointCount() - 1;
+  ASSERT_EQ(splice_index, (first_invalid - current) / 2);
+
+  const std::vector<double> splice_positions = getPositions(warm_start->getLastWayPoint());
+  const std::vector<double> splice_velocities = getVelocities(warm_start->getLastWayPoint());
+  ASSERT_GT(std::abs(splice_velocities[0]), EPSILON) << "the warm start has to end in motion";
+  const std::vector<double> warm_start_durations(warm_start->getWayPointDurations().begin(),
+                                                 warm_start->getWayPointDurations().end());
+
+  const robot_trajectory::RobotTrajectoryPtr continuation = makeSolution(splice_positions, GOAL);
+  ASSERT_TRUE(moveit::hybrid_planning::appendToWarmStartTrajectory(*warm_start, *continuation, 1.0, 1.0));
+
+  // the warm start keeps its timing and the continuation starts with the velocity at its end
+  ASSERT_GT(warm_start->getWayPointCount(), splice_index + 1);
+  for (std::size_t i = 0; i <= splice_index; ++i)
+    EXPECT_NEAR(warm_start->getWayPointDurationFromPrevious(i), warm_start_durations[i], EPSILON);
+  const std::vector<double> velocities = getVelocities(warm_start->getWayPoint(splice_index));
+  for (std::size_t j = 0; j < velocities.size(); ++j)
+    EXPECT_NEAR(velocities[j], splice_velocities[j], EPSILON);
+
+  const std::vector<double> end_positions = getPositions(warm_start->getLastWayPoint());
+  for (std::size_t j = 0; j < end_positions.size(); ++j)
+    EXPECT_NEAR(end_positions[j], GOAL[j], EPSILON);
+  expectFeasible(*warm_start);
+}
+
+// A replanned trajectory that leaves the end of the warm start in another direction is re-timed with the warm start
+TEST_F(WarmStartTest, ReplanAndAppendTurning)
+{
+  const robot_trajectory::RobotTrajectoryPtr last_solution = makeSolution(START, GOAL);
+  const std::size_t count = last_solution->getWayPointCount();
+  ASSERT_GE(count, 8u);
+
+  bool remainder_valid = true;
+  const robot_trajectory::RobotTrajectoryPtr warm_start = moveit::hybrid_planning::getWarmStartTrajectory(
+      *last_solution, last_solution->getWayPoint(0),
+      [&](const moveit::core::RobotState& waypoint) {
+        return waypoint.distance(last_solution->getWayPoint(count / 2), group_) > EPSILON;
+      },
+      remainder_valid);
+  ASSERT_TRUE(warm_start);
+  EXPECT_FALSE(remainder_valid);
+
+  const robot_trajectory::RobotTrajectoryPtr continuation =
+      makeSolution(getPositions(warm_start->getLastWayPoint()), OTHER_GOAL);
+  ASSERT_TRUE(moveit::hybrid_planning::appendToWarmStartTrajectory(*warm_start, *continuation, 1.0, 1.0));
+
+  const std::vector<double> end_positions = getPositions(warm_start->getLastWayPoint());
+  for (std::size_t j = 0; j < end_positions.size(); ++j)
+    EXPECT_NEAR(end_positions[j], OTHER_GOAL[j], EPSILON);
+  expectFeasible(*warm_start);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -52,8 +52,12 @@ static const std::string SET_PLANNER_PARAMS_SERVICE_NAME =
 static const std::string MOVE_ACTION = "move_action";     // name of 'move' action
 static const std::string IK_SERVICE_NAME = "compute_ik";  // name of ik service
 static const std::string FK_SERVICE_NAME = "compute_fk";  // name of fk service
+static const std::string IK_BATCH_SERVICE_NAME = "compute_ik_batch";  // name of batched ik service
+static const std::string FK_BATCH_SERVICE_NAME = "compute_fk_batch";  // name of batched fk service
 static const std::string STATE_VALIDITY_SERVICE_NAME =
     "check_state_validity";  // name of the service that validates states
+static const std::string BATCH_STATE_VALIDITY_SERVICE_NAME =
+    "check_state_validity_batch";  // name of the service that validates many states at once
 static const std::string CARTESIAN_PATH_SERVICE_NAME =
     "compute_cartesian_path";  // name of the service that computes cartesian paths
 static const std::string GET_PLANNING_SCENE_SERVICE_NAME =
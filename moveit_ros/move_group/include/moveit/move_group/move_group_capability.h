@@ -67,6 +67,10 @@ public:
 
   void setContext(const MoveGroupContextPtr& context);
 
+  /** \brief Set the callback group the capability creates its services and action servers in. Without a callback
+   * group, they are created in the default callback group of the node */
+  void setCallbackGroup(const rclcpp::CallbackGroup::SharedPtr& callback_group);
+
   virtual void initialize() = 0;
 
   const std::string& getName() const
@@ -96,7 +100,14 @@ protected:
 
   planning_pipeline::PlanningPipelinePtr resolvePlanningPipeline(const std::string& pipeline_id) const;
 
+  /** \brief Plan on the MoveItCpp planning executor with the pipeline named by req.pipeline_id, or race the pipelines
+   * of the parallel planning configuration of that name. Returns false if no plan was found */
+  bool generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req,
+                    planning_interface::MotionPlanResponse& res) const;
+
   std::string capability_name_;
   MoveGroupContextPtr context_;
+  rclcpp::CallbackGroup::SharedPtr callback_group_;
 };
 }  // namespace move_group
@@ -38,7 +38,10 @@
 
 #include <rclcpp/rclcpp.hpp>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <moveit/macros/class_forward.h>
+#include <moveit/planning_pipeline_interfaces/planning_pipeline_interfaces.hpp>
 
 namespace moveit_cpp
 {
@@ -71,17 +74,31 @@ MOVEIT_STRUCT_FORWARD(MoveGroupContext);
 
 struct MoveGroupContext
 {
+  /** \brief Planning pipelines that are raced against each other when a request uses the configuration name as
+   * pipeline_id. Loaded from the 'parallel_planning.configs' parameter */
+  struct ParallelPlanningConfig
+  {
+    std::vector<std::string> pipelines;
+    std::vector<std::string> planner_ids;
+    moveit::planning_pipeline_interfaces::StoppingCriterionFunction stopping_criterion;
+    moveit::planning_pipeline_interfaces::SolutionSelectionFunction solution_selection;
+  };
+
   MoveGroupContext(const moveit_cpp::MoveItCppPtr& moveit_cpp, const std::string& default_planning_pipeline,
                    bool allow_trajectory_execution = false, bool debug = false);
   ~MoveGroupContext();
 
   bool status() const;
 
+  /** \brief Get the parallel planning configuration named name, or nullptr if there is none */
+  const ParallelPlanningConfig* getParallelPlanningConfig(const std::string& name) const;
+
   moveit_cpp::MoveItCppPtr moveit_cpp_;
   planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
   trajectory_execution_manager::TrajectoryExecutionManagerPtr trajectory_execution_manager_;
   planning_pipeline::PlanningPipelinePtr planning_pipeline_;
   plan_execution::PlanExecutionPtr plan_execution_;
+  std::unordered_map<std::string, ParallelPlanningConfig> parallel_planning_configs_;
   bool allow_trajectory_execution_;
   bool debug_;
 };
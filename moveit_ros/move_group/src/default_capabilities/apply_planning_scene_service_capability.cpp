@@ -59,7 +59,8 @@ void ApplyPlanningSceneService::initialize()
              const std::shared_ptr<moveit_msgs::srv::ApplyPlanningScene::Request>& req,
              const std::shared_ptr<moveit_msgs::srv::ApplyPlanningScene::Response>& res) {
         return applyScene(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 bool ApplyPlanningSceneService::applyScene(const std::shared_ptr<rmw_request_id_t>& /* unused */,
@@ -0,0 +1,201 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "batch_state_validation_service_capability.h"
+#include <moveit/moveit_cpp/moveit_cpp.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/collision_detection/collision_tools.h>
+#include <moveit/move_group/capability_names.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace move_group
+{
+namespace
+{
+const rclcpp::Logger LOGGER =
+    rclcpp::get_logger("moveit_move_group_default_capabilities.batch_state_validation_service_capability");
+}  // namespace
+
+MoveGroupBatchStateValidationService::MoveGroupBatchStateValidationService()
+  : MoveGroupCapability("BatchStateValidationService")
+{
+}
+
+void MoveGroupBatchStateValidationService::initialize()
+{
+  int thread_count = 0;
+  context_->moveit_cpp_->getNode()->get_parameter_or("state_validity_batch_thread_count", thread_count, 0);
+  thread_count_ = static_cast<std::size_t>(std::max(thread_count, 0));
+
+  validity_service_ =
+      context_->moveit_cpp_->getNode()->create_service<moveit_ros_move_group::srv::GetStateValidityBatch>(
+          BATCH_STATE_VALIDITY_SERVICE_NAME,
+          [this](const std::shared_ptr<rmw_request_id_t>& request_header,
+                 const std::shared_ptr<moveit_ros_move_group::srv::GetStateValidityBatch::Request>& req,
+                 const std::shared_ptr<moveit_ros_move_group::srv::GetStateValidityBatch::Response>& res) {
+            return computeService(request_header, req, res);
+          },
+          rmw_qos_profile_services_default, callback_group_);
+}
+
+bool MoveGroupBatchStateValidationService::computeService(
+    const std::shared_ptr<rmw_request_id_t>& /* unused */,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetStateValidityBatch::Request>& req,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetStateValidityBatch::Response>& res)
+{
+  res->success = false;
+  res->state_count = 0;
+
+  const std::size_t joint_count = req->joint_names.size();
+  if (joint_count == 0 || req->positions.size() % joint_count != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Received %zu joint positions, which is not a multiple of the %zu joint names",
+                 req->positions.size(), joint_count);
+    return true;
+  }
+  const std::size_t state_count = req->positions.size() / joint_count;
+
+  // the scene is locked once for the whole batch
+  planning_scene_monitor::LockedPlanningSceneRO ls(context_->planning_scene_monitor_);
+  const moveit::core::RobotModelConstPtr& robot_model = ls->getRobotModel();
+
+  const std::vector<std::string>& variable_names = robot_model->getVariableNames();
+  std::vector<std::size_t> variable_indices;
+  variable_indices.reserve(joint_count);
+  for (const std::string& joint_name : req->joint_names)
+  {
+    const auto it = std::find(variable_names.begin(), variable_names.end(), joint_name);
+    if (it == variable_names.end())
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not known to model '%s'", joint_name.c_str(),
+                   robot_model->getName().c_str());
+      return true;
+    }
+    variable_indices.push_back(it - variable_names.begin());
+  }
+
+  moveit::core::RobotState reference_state = ls->getCurrentState();
+  moveit::core::robotStateMsgToRobotState(req->reference_state, reference_state);
+
+  // configure collision request, without contacts a colliding state is rejected at its first contact
+  collision_detection::CollisionRequest creq;
+  creq.group_name = req->group_name;
+  if (req->return_contacts)
+  {
+    creq.contacts = true;
+    creq.max_contacts = ls->getWorld()->size() + robot_model->getLinkModelsWithCollisionGeometry().size();
+    creq.max_contacts *= creq.max_contacts;
+  }
+
+  kinematic_constraints::KinematicConstraintSet kset(robot_model);
+  kset.add(req->constraints, ls->getTransforms());
+
+  std::vector<char> state_valid(state_count, false);
+  std::vector<collision_detection::CollisionResult::ContactMap> state_contacts(req->return_contacts ? state_count : 0);
+
+  std::atomic<std::size_t> next_state{ 0 };
+  const auto check_states = [&]() {
+    moveit::core::RobotState state(reference_state);
+    collision_detection::CollisionResult cres;
+    for (std::size_t i = next_state++; i < state_count; i = next_state++)
+    {
+      const double* positions = &req->positions[i * joint_count];
+      for (std::size_t j = 0; j < joint_count; ++j)
+        state.setVariablePosition(variable_indices[j], positions[j]);
+      state.update();
+
+      cres.clear();
+      ls->checkCollision(creq, cres, state);
+      bool valid = !cres.collision;
+      if (cres.collision && req->return_contacts)
+        state_contacts[i] = std::move(cres.contacts);
+      if (valid && !kset.empty())
+        valid = kset.decide(state).satisfied;
+      state_valid[i] = valid;
+    }
+  };
+
+  std::size_t thread_count = thread_count_;
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, state_count);
+
+  std::vector<std::thread> threads;
+  if (thread_count > 1)
+    threads.reserve(thread_count - 1);
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(check_states);
+  check_states();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  // pack the results, bit (i % 8) of byte (i / 8) holds the validity of state i
+  res->valid.assign((state_count + 7) / 8, 0);
+  for (std::size_t i = 0; i < state_count; ++i)
+  {
+    if (state_valid[i])
+      res->valid[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+  }
+
+  if (req->return_contacts)
+  {
+    rclcpp::Time time_now = context_->moveit_cpp_->getNode()->get_clock()->now();
+    for (std::size_t i = 0; i < state_count; ++i)
+    {
+      for (const auto& contact_pair : state_contacts[i])
+      {
+        for (const collision_detection::Contact& contact : contact_pair.second)
+        {
+          res->contacts.resize(res->contacts.size() + 1);
+          collision_detection::contactToMsg(contact, res->contacts.back());
+          res->contacts.back().header.frame_id = ls->getPlanningFrame();
+          res->contacts.back().header.stamp = time_now;
+          res->contact_state_indices.push_back(static_cast<uint32_t>(i));
+        }
+      }
+    }
+  }
+
+  res->state_count = static_cast<uint32_t>(state_count);
+  res->success = true;
+  return true;
+}
+}  // namespace move_group
+
+#include <pluginlib/class_list_macros.hpp>
+
+PLUGINLIB_EXPORT_CLASS(move_group::MoveGroupBatchStateValidationService, move_group::MoveGroupCapability)
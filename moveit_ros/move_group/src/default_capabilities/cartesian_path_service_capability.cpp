@@ -74,6 +74,11 @@ void MoveGroupCartesianPathService::initialize()
 {
   display_path_ = context_->moveit_cpp_->getNode()->create_publisher<moveit_msgs::msg::DisplayTrajectory>(
       planning_pipeline::PlanningPipeline::DISPLAY_PATH_TOPIC, 10);
+  context_->moveit_cpp_->getNode()->get_parameter_or("cartesian_path_jacobian_stepping",
+                                                     jacobian_stepping_.enabled, false);
+  int segment_thread_count = 1;
+  context_->moveit_cpp_->getNode()->get_parameter_or("cartesian_path_segment_thread_count", segment_thread_count, 1);
+  segment_thread_count_ = static_cast<std::size_t>(std::max(segment_thread_count, 0));
 
   cartesian_path_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_msgs::srv::GetCartesianPath>(
 
@@ -82,7 +87,8 @@ void MoveGroupCartesianPathService::initialize()
              const std::shared_ptr<moveit_msgs::srv::GetCartesianPath::Request>& req,
              const std::shared_ptr<moveit_msgs::srv::GetCartesianPath::Response>& res) -> bool {
         return computeService(req_id, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 bool MoveGroupCartesianPathService::computeService(
@@ -171,7 +177,9 @@ bool MoveGroupCartesianPathService::computeService(
           std::vector<moveit::core::RobotStatePtr> traj;
           res->fraction = moveit::core::CartesianInterpolator::computeCartesianPath(
               &start_state, jmg, traj, start_state.getLinkModel(link_name), waypoints, global_frame,
-              moveit::core::MaxEEFStep(req->max_step), moveit::core::JumpThreshold(req->jump_threshold), constraint_fn);
+              moveit::core::MaxEEFStep(req->max_step), moveit::core::JumpThreshold(req->jump_threshold), constraint_fn,
+              kinematics::KinematicsQueryOptions(), kinematics::KinematicsBase::IKCostFn(),
+              Eigen::Isometry3d::Identity(), jacobian_stepping_, segment_thread_count_);
           moveit::core::robotStateToRobotStateMsg(start_state, res->start_state);
 
           robot_trajectory::RobotTrajectory rt(context_->planning_scene_monitor_->getRobotModel(), req->group_name);
@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/move_group/move_group_capability.h>
+#include <moveit/robot_state/cartesian_interpolator.h>
 #include <moveit_msgs/srv/get_cartesian_path.hpp>
 #include <moveit_msgs/msg/display_trajectory.hpp>
 
@@ -58,5 +59,12 @@ private:
   rclcpp::Publisher<moveit_msgs::msg::DisplayTrajectory>::SharedPtr display_path_;
 
   bool display_computed_paths_;
+
+  // follow the interpolated poses with Jacobian steps, read from the cartesian_path_jacobian_stepping parameter
+  moveit::core::JacobianStepping jacobian_stepping_;
+
+  // number of threads the segments between waypoints are computed on, read from the
+  // cartesian_path_segment_thread_count parameter (1 computes them sequentially, 0 uses all hardware threads)
+  std::size_t segment_thread_count_ = 1;
 };
 }  // namespace move_group
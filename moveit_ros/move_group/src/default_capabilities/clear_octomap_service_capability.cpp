@@ -50,7 +50,8 @@ void move_group::ClearOctomapService::initialize()
   service_ = context_->moveit_cpp_->getNode()->create_service<std_srvs::srv::Empty>(
       CLEAR_OCTOMAP_SERVICE_NAME,
       [this](const std::shared_ptr<std_srvs::srv::Empty::Request>& req,
-             const std::shared_ptr<std_srvs::srv::Empty::Response>& res) { return clearOctomap(req, res); });
+             const std::shared_ptr<std_srvs::srv::Empty::Response>& res) { return clearOctomap(req, res); },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 void move_group::ClearOctomapService::clearOctomap(const std::shared_ptr<std_srvs::srv::Empty::Request>& /*req*/,
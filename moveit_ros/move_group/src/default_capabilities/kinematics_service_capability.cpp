@@ -41,6 +41,10 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <moveit/move_group/capability_names.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace move_group
 {
 static const rclcpp::Logger LOGGER =
@@ -57,13 +61,36 @@ void MoveGroupKinematicsService::initialize()
                               const std::shared_ptr<moveit_msgs::srv::GetPositionFK::Request>& req,
                               const std::shared_ptr<moveit_msgs::srv::GetPositionFK::Response>& res) {
         return computeFKService(req_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
   ik_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_msgs::srv::GetPositionIK>(
       IK_SERVICE_NAME, [this](const std::shared_ptr<rmw_request_id_t>& req_header,
                               const std::shared_ptr<moveit_msgs::srv::GetPositionIK::Request>& req,
                               const std::shared_ptr<moveit_msgs::srv::GetPositionIK::Response>& res) {
         return computeIKService(req_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
+
+  int batch_thread_count = 1;
+  context_->moveit_cpp_->getNode()->get_parameter_or("kinematics_batch_thread_count", batch_thread_count, 1);
+  batch_thread_count_ = static_cast<std::size_t>(std::max(batch_thread_count, 0));
+
+  fk_batch_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_ros_move_group::srv::GetPositionFKBatch>(
+      FK_BATCH_SERVICE_NAME,
+      [this](const std::shared_ptr<rmw_request_id_t>& req_header,
+             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Request>& req,
+             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Response>& res) {
+        return computeFKBatchService(req_header, req, res);
+      },
+      rmw_qos_profile_services_default, callback_group_);
+  ik_batch_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_ros_move_group::srv::GetPositionIKBatch>(
+      IK_BATCH_SERVICE_NAME,
+      [this](const std::shared_ptr<rmw_request_id_t>& req_header,
+             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Request>& req,
+             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Response>& res) {
+        return computeIKBatchService(req_header, req, res);
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 namespace
@@ -78,6 +105,54 @@ bool isIKSolutionValid(const planning_scene::PlanningScene* planning_scene,
   return (!planning_scene || !planning_scene->isStateColliding(*state, jmg->getName())) &&
          (!constraint_set || constraint_set->decide(*state).satisfied);
 }
+
+// number of values of a packed pose [x, y, z, qx, qy, qz, qw]
+constexpr std::size_t PACKED_POSE_SIZE = 7;
+
+// Call process(state, i) for every i in [0, count), distributed to thread_count threads that each work on their own
+// copy of reference_state
+template <typename ProcessFn>
+void processBatch(std::size_t count, std::size_t thread_count, const moveit::core::RobotState& reference_state,
+                  const ProcessFn& process)
+{
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, count);
+
+  std::atomic<std::size_t> next{ 0 };
+  const auto work = [&]() {
+    moveit::core::RobotState state(reference_state);
+    for (std::size_t i = next++; i < count; i = next++)
+      process(state, i);
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(work);
+  work();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+// Resolve the variable indices of joint_names, return false if a name is not a variable of robot_model
+bool getVariableIndices(const moveit::core::RobotModel& robot_model, const std::vector<std::string>& joint_names,
+                        std::vector<std::size_t>& indices)
+{
+  const std::vector<std::string>& variable_names = robot_model.getVariableNames();
+  indices.clear();
+  indices.reserve(joint_names.size());
+  for (const std::string& joint_name : joint_names)
+  {
+    const auto it = std::find(variable_names.begin(), variable_names.end(), joint_name);
+    if (it == variable_names.end())
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not known to model '%s'", joint_name.c_str(), robot_model.getName().c_str());
+      return false;
+    }
+    indices.push_back(it - variable_names.begin());
+  }
+  return true;
+}
 }  // namespace
 
 void MoveGroupKinematicsService::computeIK(moveit_msgs::msg::PositionIKRequest& req,
@@ -252,6 +327,214 @@ bool MoveGroupKinematicsService::computeFKService(const std::shared_ptr<rmw_requ
   }
   return true;
 }
+
+bool MoveGroupKinematicsService::lookupFrameTransform(const std::string& source_frame, const std::string& target_frame,
+                                                      Eigen::Isometry3d& transform) const
+{
+  geometry_msgs::msg::PoseStamped origin;
+  origin.header.frame_id = source_frame;
+  origin.pose.orientation.w = 1.0;
+  if (!performTransform(origin, target_frame))
+    return false;
+  tf2::fromMsg(origin.pose, transform);
+  return true;
+}
+
+bool MoveGroupKinematicsService::computeFKBatchService(
+    const std::shared_ptr<rmw_request_id_t>& /* unused */,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Request>& req,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Response>& res)
+{
+  res->state_count = 0;
+  const std::size_t joint_count = req->joint_names.size();
+  if (joint_count == 0 || req->positions.size() % joint_count != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Received %zu joint positions, which is not a multiple of the %zu joint names",
+                 req->positions.size(), joint_count);
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return true;
+  }
+  const std::size_t state_count = req->positions.size() / joint_count;
+
+  const moveit::core::RobotModelConstPtr& robot_model = context_->planning_scene_monitor_->getRobotModel();
+  std::vector<std::size_t> variable_indices;
+  if (!getVariableIndices(*robot_model, req->joint_names, variable_indices))
+  {
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return true;
+  }
+
+  std::vector<const moveit::core::LinkModel*> links;
+  links.reserve(req->fk_link_names.size());
+  for (const std::string& link_name : req->fk_link_names)
+  {
+    if (!robot_model->hasLinkModel(link_name))
+    {
+      RCLCPP_ERROR(LOGGER, "Link '%s' is not known to model '%s'", link_name.c_str(), robot_model->getName().c_str());
+      res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_LINK_NAME;
+      return true;
+    }
+    links.push_back(robot_model->getLinkModel(link_name));
+  }
+  if (links.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "No links specified for FK request");
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_LINK_NAME;
+    return true;
+  }
+
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  // the transform to the requested frame is looked up once for all poses
+  const std::string& default_frame = robot_model->getModelFrame();
+  Eigen::Isometry3d frame_transform = Eigen::Isometry3d::Identity();
+  if (!req->frame_id.empty() && !moveit::core::Transforms::sameFrame(req->frame_id, default_frame) &&
+      !lookupFrameTransform(default_frame, req->frame_id, frame_transform))
+  {
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::FRAME_TRANSFORM_FAILURE;
+    return true;
+  }
+
+  moveit::core::RobotState reference_state =
+      planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_)->getCurrentState();
+  moveit::core::robotStateMsgToRobotState(req->reference_state, reference_state);
+
+  res->poses.resize(state_count * links.size() * PACKED_POSE_SIZE);
+  processBatch(state_count, batch_thread_count_, reference_state, [&](moveit::core::RobotState& state, std::size_t i) {
+    const double* positions = &req->positions[i * joint_count];
+    for (std::size_t j = 0; j < joint_count; ++j)
+      state.setVariablePosition(variable_indices[j], positions[j]);
+    state.updateLinkTransforms();
+
+    double* pose = &res->poses[i * links.size() * PACKED_POSE_SIZE];
+    for (const moveit::core::LinkModel* link : links)
+    {
+      const Eigen::Isometry3d link_pose = frame_transform * state.getGlobalLinkTransform(link);
+      const Eigen::Quaterniond q(link_pose.linear());
+      pose[0] = link_pose.translation().x();
+      pose[1] = link_pose.translation().y();
+      pose[2] = link_pose.translation().z();
+      pose[3] = q.x();
+      pose[4] = q.y();
+      pose[5] = q.z();
+      pose[6] = q.w();
+      pose += PACKED_POSE_SIZE;
+    }
+  });
+
+  res->state_count = static_cast<uint32_t>(state_count);
+  res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
+bool MoveGroupKinematicsService::computeIKBatchService(
+    const std::shared_ptr<rmw_request_id_t>& /* unused */,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Request>& req,
+    const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Response>& res)
+{
+  res->pose_count = 0;
+  if (req->poses.size() % PACKED_POSE_SIZE != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Received %zu pose values, which is not a multiple of %zu", req->poses.size(),
+                 PACKED_POSE_SIZE);
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_GOAL_CONSTRAINTS;
+    return true;
+  }
+  const std::size_t pose_count = req->poses.size() / PACKED_POSE_SIZE;
+
+  const moveit::core::RobotModelConstPtr& robot_model = context_->planning_scene_monitor_->getRobotModel();
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(req->group_name);
+  if (!jmg)
+  {
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_GROUP_NAME;
+    return true;
+  }
+  if (!req->ik_link_name.empty() && !robot_model->hasLinkModel(req->ik_link_name))
+  {
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_LINK_NAME;
+    return true;
+  }
+
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  // the transform from the requested frame is looked up once for all poses
+  const std::string& default_frame = robot_model->getModelFrame();
+  Eigen::Isometry3d frame_transform = Eigen::Isometry3d::Identity();
+  if (!req->frame_id.empty() && !moveit::core::Transforms::sameFrame(req->frame_id, default_frame) &&
+      !lookupFrameTransform(req->frame_id, default_frame, frame_transform))
+  {
+    res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::FRAME_TRANSFORM_FAILURE;
+    return true;
+  }
+
+  const std::size_t variable_count = jmg->getVariableCount();
+  res->joint_names = jmg->getVariableNames();
+  res->solutions.assign(pose_count * variable_count, 0.0);
+  std::vector<char> found(pose_count, false);
+  const double timeout = rclcpp::Duration(req->timeout).seconds();
+
+  const auto solve = [&](moveit::core::RobotState& state, std::size_t i,
+                         const moveit::core::GroupStateValidityCallbackFn& constraint) {
+    const double* p = &req->poses[i * PACKED_POSE_SIZE];
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = Eigen::Vector3d(p[0], p[1], p[2]);
+    pose.linear() = Eigen::Quaterniond(p[6], p[3], p[4], p[5]).normalized().toRotationMatrix();
+    pose = frame_transform * pose;
+
+    bool result_ik = false;
+    if (req->ik_link_name.empty())
+      result_ik = state.setFromIK(jmg, pose, timeout, constraint);
+    else
+      result_ik = state.setFromIK(jmg, pose, req->ik_link_name, timeout, constraint);
+    if (result_ik)
+    {
+      found[i] = true;
+      state.copyJointGroupPositions(jmg, &res->solutions[i * variable_count]);
+    }
+  };
+
+  // The poses are solved one after the other, as the group's IK solver need not support concurrent queries.
+  // Keep the planning scene locked for the whole batch only if solutions are checked against it.
+  if (req->avoid_collisions || !moveit::core::isEmpty(req->constraints))
+  {
+    planning_scene_monitor::LockedPlanningSceneRO ls(context_->planning_scene_monitor_);
+    kinematic_constraints::KinematicConstraintSet kset(ls->getRobotModel());
+    kset.add(req->constraints, ls->getTransforms());
+    moveit::core::RobotState reference_state = ls->getCurrentState();
+    moveit::core::robotStateMsgToRobotState(req->reference_state, reference_state);
+
+    const planning_scene::PlanningScene* scene =
+        req->avoid_collisions ? static_cast<const planning_scene::PlanningSceneConstPtr&>(ls).get() : nullptr;
+    const kinematic_constraints::KinematicConstraintSet* kset_ptr = kset.empty() ? nullptr : &kset;
+    const moveit::core::GroupStateValidityCallbackFn constraint =
+        [scene, kset_ptr](moveit::core::RobotState* robot_state, const moveit::core::JointModelGroup* joint_group,
+                          const double* joint_group_variable_values) {
+          return isIKSolutionValid(scene, kset_ptr, robot_state, joint_group, joint_group_variable_values);
+        };
+    processBatch(pose_count, 1, reference_state,
+                 [&](moveit::core::RobotState& state, std::size_t i) { solve(state, i, constraint); });
+  }
+  else
+  {
+    moveit::core::RobotState reference_state =
+        planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_)->getCurrentState();
+    moveit::core::robotStateMsgToRobotState(req->reference_state, reference_state);
+    processBatch(pose_count, 1, reference_state,
+                 [&](moveit::core::RobotState& state, std::size_t i) { solve(state, i, {}); });
+  }
+
+  // pack the results, bit (i % 8) of byte (i / 8) tells whether pose i was solved
+  res->found.assign((pose_count + 7) / 8, 0);
+  for (std::size_t i = 0; i < pose_count; ++i)
+  {
+    if (found[i])
+      res->found[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+  }
+
+  res->pose_count = static_cast<uint32_t>(pose_count);
+  res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+  return true;
+}
 }  // namespace move_group
 
 #include <pluginlib/class_list_macros.hpp>
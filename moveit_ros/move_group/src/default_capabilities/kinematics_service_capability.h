@@ -39,6 +39,8 @@
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit_msgs/srv/get_position_ik.hpp>
 #include <moveit_msgs/srv/get_position_fk.hpp>
+#include <moveit_ros_move_group/srv/get_position_fk_batch.hpp>
+#include <moveit_ros_move_group/srv/get_position_ik_batch.hpp>
 
 namespace move_group
 {
@@ -56,6 +58,16 @@ private:
   bool computeFKService(const std::shared_ptr<rmw_request_id_t>& request_header,
                         const std::shared_ptr<moveit_msgs::srv::GetPositionFK::Request>& req,
                         const std::shared_ptr<moveit_msgs::srv::GetPositionFK::Response>& res);
+  bool computeFKBatchService(const std::shared_ptr<rmw_request_id_t>& request_header,
+                             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Request>& req,
+                             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionFKBatch::Response>& res);
+  bool computeIKBatchService(const std::shared_ptr<rmw_request_id_t>& request_header,
+                             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Request>& req,
+                             const std::shared_ptr<moveit_ros_move_group::srv::GetPositionIKBatch::Response>& res);
+
+  /** \brief Look up the pose of \e source_frame in \e target_frame, to transform many poses at once */
+  bool lookupFrameTransform(const std::string& source_frame, const std::string& target_frame,
+                            Eigen::Isometry3d& transform) const;
 
   void computeIK(moveit_msgs::msg::PositionIKRequest& req, moveit_msgs::msg::RobotState& solution,
                  moveit_msgs::msg::MoveItErrorCodes& error_code, moveit::core::RobotState& rs,
@@ -64,5 +76,10 @@ private:
 
   rclcpp::Service<moveit_msgs::srv::GetPositionFK>::SharedPtr fk_service_;
   rclcpp::Service<moveit_msgs::srv::GetPositionIK>::SharedPtr ik_service_;
+  rclcpp::Service<moveit_ros_move_group::srv::GetPositionFKBatch>::SharedPtr fk_batch_service_;
+  rclcpp::Service<moveit_ros_move_group::srv::GetPositionIKBatch>::SharedPtr ik_batch_service_;
+
+  // number of threads an FK batch request is distributed to, 0 uses std::thread::hardware_concurrency()
+  std::size_t batch_thread_count_ = 1;
 };
 }  // namespace move_group
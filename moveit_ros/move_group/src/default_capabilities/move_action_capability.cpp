@@ -71,7 +71,8 @@ void MoveGroupMoveAction::initialize()
       },
       [this](std::shared_ptr<MGActionGoal> goal) {
         std::thread{ std::bind(&MoveGroupMoveAction::executeMoveCallback, this, std::placeholders::_1), goal }.detach();
-      });
+      },
+      rcl_action_server_get_default_options(), callback_group_);
 }
 
 void MoveGroupMoveAction::executeMoveCallback(const std::shared_ptr<MGActionGoal>& goal)
@@ -200,18 +201,9 @@ void MoveGroupMoveAction::executeMoveCallbackPlanOnly(const std::shared_ptr<MGAc
     return;
   }
 
-  // Select planning_pipeline to handle request
-  const planning_pipeline::PlanningPipelinePtr planning_pipeline =
-      resolvePlanningPipeline(goal->get_goal()->request.pipeline_id);
-  if (!planning_pipeline)
-  {
-    action_res->error_code.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
-    return;
-  }
-
   try
   {
-    planning_pipeline->generatePlan(the_scene, goal->get_goal()->request, res);
+    generatePlan(the_scene, goal->get_goal()->request, res);
   }
   catch (std::exception& ex)
   {
@@ -232,18 +224,10 @@ bool MoveGroupMoveAction::planUsingPlanningPipeline(const planning_interface::Mo
   bool solved = false;
   planning_interface::MotionPlanResponse res;
 
-  // Select planning_pipeline to handle request
-  const planning_pipeline::PlanningPipelinePtr planning_pipeline = resolvePlanningPipeline(req.pipeline_id);
-  if (!planning_pipeline)
-  {
-    res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
-    return solved;
-  }
-
   planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor);
   try
   {
-    solved = planning_pipeline->generatePlan(plan.planning_scene, req, res);
+    solved = generatePlan(plan.planning_scene, req, res);
   }
   catch (std::exception& ex)
   {
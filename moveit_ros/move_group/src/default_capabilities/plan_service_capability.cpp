@@ -56,7 +56,8 @@ void MoveGroupPlanService::initialize()
                                    const std::shared_ptr<moveit_msgs::srv::GetMotionPlan::Request>& req,
                                    const std::shared_ptr<moveit_msgs::srv::GetMotionPlan::Response>& res) {
         return computePlanService(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 bool MoveGroupPlanService::computePlanService(const std::shared_ptr<rmw_request_id_t>& /* unused */,
@@ -69,20 +70,11 @@ bool MoveGroupPlanService::computePlanService(const std::shared_ptr<rmw_request_
     context_->planning_scene_monitor_->waitForCurrentRobotState(context_->moveit_cpp_->getNode()->get_clock()->now());
   context_->planning_scene_monitor_->updateFrameTransforms();
 
-  // Select planning_pipeline to handle request
-  const planning_pipeline::PlanningPipelinePtr planning_pipeline =
-      resolvePlanningPipeline(req->motion_plan_request.pipeline_id);
-  if (!planning_pipeline)
-  {
-    res->motion_plan_response.error_code.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
-    return true;
-  }
-
   planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
   try
   {
     planning_interface::MotionPlanResponse mp_res;
-    planning_pipeline->generatePlan(ps, req->motion_plan_request, mp_res);
+    generatePlan(ps, req->motion_plan_request, mp_res);
     mp_res.getMessage(res->motion_plan_response);
   }
   catch (std::exception& ex)
@@ -53,21 +53,24 @@ void MoveGroupQueryPlannersService::initialize()
              const std::shared_ptr<moveit_msgs::srv::QueryPlannerInterfaces::Request>& req,
              const std::shared_ptr<moveit_msgs::srv::QueryPlannerInterfaces::Response>& res) {
         return queryInterface(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 
   get_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_msgs::srv::GetPlannerParams>(
       GET_PLANNER_PARAMS_SERVICE_NAME, [this](const std::shared_ptr<rmw_request_id_t>& request_header,
                                               const std::shared_ptr<moveit_msgs::srv::GetPlannerParams::Request>& req,
                                               const std::shared_ptr<moveit_msgs::srv::GetPlannerParams::Response>& res) {
         return getParams(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 
   set_service_ = context_->moveit_cpp_->getNode()->create_service<moveit_msgs::srv::SetPlannerParams>(
       SET_PLANNER_PARAMS_SERVICE_NAME, [this](const std::shared_ptr<rmw_request_id_t>& request_header,
                                               const std::shared_ptr<moveit_msgs::srv::SetPlannerParams::Request>& req,
                                               const std::shared_ptr<moveit_msgs::srv::SetPlannerParams::Response>& res) {
         return setParams(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 bool MoveGroupQueryPlannersService::queryInterface(
@@ -54,7 +54,8 @@ void MoveGroupStateValidationService::initialize()
                                           const std::shared_ptr<moveit_msgs::srv::GetStateValidity::Request>& req,
                                           const std::shared_ptr<moveit_msgs::srv::GetStateValidity::Response>& res) {
         return computeService(request_header, req, res);
-      });
+      },
+      rmw_qos_profile_services_default, callback_group_);
 }
 
 bool MoveGroupStateValidationService::computeService(
@@ -38,23 +38,32 @@
 #include <moveit/moveit_cpp/moveit_cpp.h>
 #include <moveit/utils/message_checks.h>
 #include <moveit/move_group/capability_names.h>
+#include <tf2_ros/qos.hpp>
 #include <tf2_ros/transform_broadcaster.h>
 #include <tf2_eigen/tf2_eigen.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/attached_body.h>
+#include <algorithm>
 
 namespace move_group
 {
 static const rclcpp::Logger LOGGER =
     rclcpp::get_logger("moveit_move_group_default_capabilities.tf_publisher_capability");
 
-TfPublisher::TfPublisher() : MoveGroupCapability("TfPublisher")
+TfPublisher::TfPublisher()
+  : MoveGroupCapability("TfPublisher"), publish_changes_only_(false), scene_changes_(std::make_shared<SceneChanges>())
 {
 }
 
 TfPublisher::~TfPublisher()
 {
   keep_running_ = false;
+  {
+    std::scoped_lock lock(scene_changes_->mutex);
+    scene_changes_->stop = true;
+  }
+  scene_changes_->condition.notify_all();
   thread_.join();
 }
 
@@ -73,6 +82,29 @@ void publishSubframes(tf2_ros::TransformBroadcaster& broadcaster, const moveit::
     broadcaster.sendTransform(transform);
   }
 }
+
+void appendSubframes(std::vector<geometry_msgs::msg::TransformStamped>& transforms,
+                     const moveit::core::FixedTransformsMap& subframes, const std::string& parent_object,
+                     const rclcpp::Time& stamp)
+{
+  for (const auto& [name, pose] : subframes)
+  {
+    geometry_msgs::msg::TransformStamped& transform = transforms.emplace_back(tf2::eigenToTransform(pose));
+    transform.child_frame_id = parent_object + "/" + name;
+    transform.header.stamp = stamp;
+    transform.header.frame_id = parent_object;
+  }
+}
+
+bool sameTransforms(const std::vector<geometry_msgs::msg::TransformStamped>& a,
+                    const std::vector<geometry_msgs::msg::TransformStamped>& b)
+{
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const geometry_msgs::msg::TransformStamped& ta, const geometry_msgs::msg::TransformStamped& tb) {
+                      return ta.child_frame_id == tb.child_frame_id && ta.header.frame_id == tb.header.frame_id &&
+                             ta.transform == tb.transform;
+                    });
+}
 }  // namespace
 
 void TfPublisher::publishPlanningSceneFrames()
@@ -123,16 +155,98 @@ void TfPublisher::publishPlanningSceneFrames()
   }
 }
 
+void TfPublisher::publishChangedPlanningSceneFrames()
+{
+  // Object poses are relative to the planning frame, attached body poses to their link and subframes to their object,
+  // so all frames are static until the scene changes. The full set is republished on /tf_static with each change,
+  // which also drops the frames of removed objects for late joining listeners.
+  auto publisher = context_->moveit_cpp_->getNode()->create_publisher<tf2_msgs::msg::TFMessage>(
+      "/tf_static", tf2_ros::StaticBroadcasterQoS());
+  std::vector<geometry_msgs::msg::TransformStamped> published;
+  std::vector<geometry_msgs::msg::TransformStamped> transforms;
+
+  while (keep_running_)
+  {
+    {
+      std::unique_lock<std::mutex> lock(scene_changes_->mutex);
+      scene_changes_->condition.wait(lock, [this] { return scene_changes_->changed || scene_changes_->stop; });
+      if (scene_changes_->stop)
+        return;
+      scene_changes_->changed = false;
+    }
+
+    // only collect the transforms while the scene is locked
+    transforms.clear();
+    {
+      rclcpp::Time stamp = context_->moveit_cpp_->getNode()->get_clock()->now();
+      planning_scene_monitor::LockedPlanningSceneRO locked_planning_scene(context_->planning_scene_monitor_);
+      const std::string& planning_frame = locked_planning_scene->getPlanningFrame();
+
+      for (const auto& obj : *locked_planning_scene->getWorld())
+      {
+        std::string object_frame = prefix_ + obj.second->id_;
+        geometry_msgs::msg::TransformStamped& transform =
+            transforms.emplace_back(tf2::eigenToTransform(obj.second->pose_));
+        transform.child_frame_id = object_frame;
+        transform.header.stamp = stamp;
+        transform.header.frame_id = planning_frame;
+        appendSubframes(transforms, obj.second->subframe_poses_, object_frame, stamp);
+      }
+
+      std::vector<const moveit::core::AttachedBody*> attached_collision_objects;
+      locked_planning_scene->getCurrentState().getAttachedBodies(attached_collision_objects);
+      for (const moveit::core::AttachedBody* attached_body : attached_collision_objects)
+      {
+        std::string object_frame = prefix_ + attached_body->getName();
+        geometry_msgs::msg::TransformStamped& transform =
+            transforms.emplace_back(tf2::eigenToTransform(attached_body->getPose()));
+        transform.child_frame_id = object_frame;
+        transform.header.stamp = stamp;
+        transform.header.frame_id = attached_body->getAttachedLinkName();
+        appendSubframes(transforms, attached_body->getSubframes(), object_frame, stamp);
+      }
+    }
+
+    if (sameTransforms(transforms, published))
+      continue;
+    tf2_msgs::msg::TFMessage msg;
+    msg.transforms = transforms;
+    publisher->publish(msg);
+    published.swap(transforms);
+  }
+}
+
 void TfPublisher::initialize()
 {
   std::string prefix = context_->moveit_cpp_->getNode()->get_name();
   context_->moveit_cpp_->getNode()->get_parameter_or("planning_scene_frame_publishing_rate", rate_, 10);
   context_->moveit_cpp_->getNode()->get_parameter_or("planning_scene_tf_prefix", prefix_, prefix);
+  context_->moveit_cpp_->getNode()->get_parameter_or("planning_scene_tf_publish_changes_only", publish_changes_only_,
+                                                     false);
   if (!prefix_.empty())
     prefix_ += "/";
 
   keep_running_ = true;
 
+  if (publish_changes_only_)
+  {
+    RCLCPP_INFO(LOGGER, "Initializing MoveGroupTfPublisher to publish frames on /tf_static when the scene changes");
+    // robot motion does not move the frames relative to their parents
+    context_->planning_scene_monitor_->addUpdateCallback(
+        [scene_changes = scene_changes_](planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType type) {
+          if (type == planning_scene_monitor::PlanningSceneMonitor::UPDATE_STATE ||
+              type == planning_scene_monitor::PlanningSceneMonitor::UPDATE_TRANSFORMS)
+            return;
+          {
+            std::scoped_lock lock(scene_changes->mutex);
+            scene_changes->changed = true;
+          }
+          scene_changes->condition.notify_one();
+        });
+    thread_ = std::thread(&TfPublisher::publishChangedPlanningSceneFrames, this);
+    return;
+  }
+
   RCLCPP_INFO(LOGGER, "Initializing MoveGroupTfPublisher with a frame publishing rate of %d", rate_);
   thread_ = std::thread(&TfPublisher::publishPlanningSceneFrames, this);
 }
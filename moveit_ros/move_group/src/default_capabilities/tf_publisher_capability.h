@@ -37,6 +37,9 @@
 #pragma once
 
 #include <moveit/move_group/move_group_capability.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 namespace move_group
@@ -50,10 +53,23 @@ public:
   void initialize() override;
 
 private:
+  /** \brief Signals changes of the planning scene to the publishing thread. Shared with the update callback of the
+   * planning scene monitor, which cannot be removed and may outlive the capability. */
+  struct SceneChanges
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool changed = true;
+    bool stop = false;
+  };
+
   void publishPlanningSceneFrames();
+  void publishChangedPlanningSceneFrames();
   int rate_;
   std::string prefix_;
   std::thread thread_;
   bool keep_running_;
+  bool publish_changes_only_;
+  std::shared_ptr<SceneChanges> scene_changes_;
 };
 }  // namespace move_group
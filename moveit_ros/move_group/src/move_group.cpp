@@ -42,8 +42,18 @@
 #include <boost/tokenizer.hpp>
 #include <moveit/macros/console_colors.h>
 #include <moveit/move_group/move_group_context.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
 #include <memory>
 #include <set>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 static const std::string ROBOT_DESCRIPTION =
     "robot_description";  // name of the robot description (a param name, so it can be changed externally)
@@ -62,12 +72,20 @@ static const char* const DEFAULT_CAPABILITIES[] = {
    "move_group/MoveGroupPlanService",
    "move_group/MoveGroupQueryPlannersService",
    "move_group/MoveGroupStateValidationService",
+   "move_group/MoveGroupBatchStateValidationService",
    "move_group/MoveGroupGetPlanningSceneService",
    "move_group/ApplyPlanningSceneService",
    "move_group/ClearOctomapService",
 };
 // clang-format on
 
+// Capabilities querying the IK solvers of the robot model. Not every solver supports concurrent queries, so by default
+// these capabilities share one mutually exclusive callback group
+static const std::set<std::string> KINEMATICS_CAPABILITIES = { "CartesianPathService", "KinematicsService",
+                                                               "MoveAction",           "MotionPlanService",
+                                                               "SequenceService",      "SequenceAction" };
+static const std::string KINEMATICS_CALLBACK_GROUP = "kinematics";
+
 class MoveGroupExe
 {
 public:
@@ -86,6 +104,15 @@ public:
 
   ~MoveGroupExe()
   {
+    for (CapabilityExecutor& capability_executor : capability_executors_)
+      capability_executor.executor->cancel();
+    for (CapabilityExecutor& capability_executor : capability_executors_)
+    {
+      if (capability_executor.thread.joinable())
+        capability_executor.thread.join();
+    }
+    capability_executors_.clear();
+    shared_callback_groups_.clear();
     capabilities_.clear();
     context_.reset();
     capability_plugin_loader_.reset();
@@ -119,6 +146,94 @@ public:
   }
 
 private:
+  /** \brief The callback group of a capability and the executor threads that serve only this group */
+  struct CapabilityExecutor
+  {
+    std::string capability_name;
+    int nice;
+    rclcpp::CallbackGroup::SharedPtr callback_group;
+    std::shared_ptr<rclcpp::executors::MultiThreadedExecutor> executor;
+    std::thread thread;
+  };
+
+  /** \brief Create the callback group of a capability, so that slow requests of other capabilities (e.g. planning)
+   * do not delay its requests. The parameter capability_executors.<capability name>.threads sets the number of
+   * threads serving the group (default 1, 0 uses the executor of the node) and capability_executors.<capability
+   * name>.nice their nice value (default 0, i.e. unchanged).
+   *
+   * Capabilities with the same capability_executors.<capability name>.group share one mutually exclusive callback
+   * group served by a single thread, with the nice value of the first of them. The capabilities in
+   * KINEMATICS_CAPABILITIES default to the group "kinematics", all others to an empty group, i.e. a callback group
+   * of their own. Returns nullptr if the capability uses the node's executor */
+  rclcpp::CallbackGroup::SharedPtr createCapabilityCallbackGroup(const std::string& capability_name)
+  {
+    const rclcpp::Node::SharedPtr& node = context_->moveit_cpp_->getNode();
+    const std::string prefix = "capability_executors." + capability_name;
+    int threads, nice;
+    std::string group;
+    node->get_parameter_or(prefix + ".threads", threads, 1);
+    node->get_parameter_or(prefix + ".nice", nice, 0);
+    node->get_parameter_or(prefix + ".group", group,
+                           KINEMATICS_CAPABILITIES.count(capability_name) ? KINEMATICS_CALLBACK_GROUP : std::string());
+    if (threads <= 0)
+      return nullptr;
+
+    if (!group.empty())
+    {
+      if (threads > 1)
+      {
+        RCLCPP_WARN(LOGGER,
+                    "'%s' shares the callback group '%s', which is served by a single thread. Ignoring %s.threads",
+                    capability_name.c_str(), group.c_str(), prefix.c_str());
+        threads = 1;
+      }
+      const auto it = shared_callback_groups_.find(group);
+      if (it != shared_callback_groups_.end())
+        return it->second;
+    }
+
+    // requests of a capability are only served concurrently if it has several threads
+    CapabilityExecutor& capability_executor = capability_executors_.emplace_back();
+    capability_executor.capability_name = group.empty() ? capability_name : group;
+    capability_executor.nice = nice;
+    capability_executor.callback_group = node->create_callback_group(
+        threads > 1 ? rclcpp::CallbackGroupType::Reentrant : rclcpp::CallbackGroupType::MutuallyExclusive, false);
+    capability_executor.executor =
+        std::make_shared<rclcpp::executors::MultiThreadedExecutor>(rclcpp::ExecutorOptions(), threads);
+    capability_executor.executor->add_callback_group(capability_executor.callback_group,
+                                                     node->get_node_base_interface());
+    if (!group.empty())
+      shared_callback_groups_[group] = capability_executor.callback_group;
+    return capability_executor.callback_group;
+  }
+
+  void startCapabilityExecutors()
+  {
+    for (CapabilityExecutor& capability_executor : capability_executors_)
+    {
+      capability_executor.thread = std::thread([&capability_executor] {
+        if (capability_executor.nice != 0)
+          setThreadNice(capability_executor);
+        capability_executor.executor->spin();
+      });
+    }
+  }
+
+  static void setThreadNice(const CapabilityExecutor& capability_executor)
+  {
+#if defined(__linux__)
+    // the nice value is a property of the thread on Linux, the threads the executor starts inherit it
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), capability_executor.nice) != 0)
+    {
+      RCLCPP_WARN(LOGGER, "Failed to set the nice value of '%s' to %d: %s",
+                  capability_executor.capability_name.c_str(), capability_executor.nice, strerror(errno));
+    }
+#else
+    RCLCPP_WARN(LOGGER, "Nice values of capabilities are not supported on this platform, ignoring it for '%s'",
+                capability_executor.capability_name.c_str());
+#endif
+  }
+
   void configureCapabilities()
   {
     try
@@ -178,6 +293,7 @@ private:
         printf(MOVEIT_CONSOLE_COLOR_CYAN "Loading '%s'..." MOVEIT_CONSOLE_COLOR_RESET "\n", capability.c_str());
         MoveGroupCapabilityPtr cap = capability_plugin_loader_->createUniqueInstance(capability);
         cap->setContext(context_);
+        cap->setCallbackGroup(createCapabilityCallbackGroup(cap->getName()));
         cap->initialize();
         capabilities_.push_back(cap);
       }
@@ -187,6 +303,7 @@ private:
                             "Exception while loading move_group capability '" << capability << "': " << ex.what());
       }
     }
+    startCapabilityExecutors();
 
     std::stringstream ss;
     ss << '\n';
@@ -202,6 +319,8 @@ private:
   MoveGroupContextPtr context_;
   std::shared_ptr<pluginlib::ClassLoader<MoveGroupCapability>> capability_plugin_loader_;
   std::vector<MoveGroupCapabilityPtr> capabilities_;
+  std::vector<CapabilityExecutor> capability_executors_;
+  std::map<std::string, rclcpp::CallbackGroup::SharedPtr> shared_callback_groups_;
 };
 }  // namespace move_group
 
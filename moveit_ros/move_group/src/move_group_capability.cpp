@@ -36,6 +36,7 @@
 
 #include <moveit/moveit_cpp/moveit_cpp.h>
 #include <moveit/move_group/move_group_capability.h>
+#include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/utils/moveit_error_code.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
@@ -50,6 +51,11 @@ void move_group::MoveGroupCapability::setContext(const MoveGroupContextPtr& cont
   context_ = context;
 }
 
+void move_group::MoveGroupCapability::setCallbackGroup(const rclcpp::CallbackGroup::SharedPtr& callback_group)
+{
+  callback_group_ = callback_group;
+}
+
 void move_group::MoveGroupCapability::convertToMsg(const std::vector<plan_execution::ExecutableTrajectory>& trajectory,
                                                    moveit_msgs::msg::RobotState& first_state_msg,
                                                    std::vector<moveit_msgs::msg::RobotTrajectory>& trajectory_msg) const
@@ -231,3 +237,43 @@ move_group::MoveGroupCapability::resolvePlanningPipeline(const std::string& pipe
 
   return planning_pipeline::PlanningPipelinePtr();
 }
+
+bool move_group::MoveGroupCapability::generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                   const planning_interface::MotionPlanRequest& req,
+                                                   planning_interface::MotionPlanResponse& res) const
+{
+  const auto& planning_executor = context_->moveit_cpp_->getPlanningExecutor();
+  const MoveGroupContext::ParallelPlanningConfig* parallel_config =
+      context_->getParallelPlanningConfig(req.pipeline_id);
+  if (!parallel_config)
+  {
+    const planning_pipeline::PlanningPipelinePtr planning_pipeline = resolvePlanningPipeline(req.pipeline_id);
+    if (!planning_pipeline)
+    {
+      res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
+      return false;
+    }
+    // plan on the executor shared with the other capabilities, which bounds the number of concurrent requests
+    return planning_executor->submit([&] { return planning_pipeline->generatePlan(planning_scene, req, res); }).get();
+  }
+
+  RCLCPP_INFO(LOGGER, "Using parallel planning configuration '%s'", req.pipeline_id.c_str());
+  std::vector<planning_interface::MotionPlanRequest> requests(parallel_config->pipelines.size(), req);
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    requests[i].pipeline_id = parallel_config->pipelines[i];
+    requests[i].planner_id = parallel_config->planner_ids[i];
+  }
+
+  // Each pipeline is planned as a separate task of the shared executor, so the pipelines run concurrently
+  const auto responses = moveit::planning_pipeline_interfaces::planWithParallelPipelines(
+      requests, planning_scene, context_->moveit_cpp_->getPlanningPipelines(), parallel_config->stopping_criterion,
+      parallel_config->solution_selection, nullptr, planning_executor);
+  if (responses.empty())
+  {
+    res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::FAILURE;
+    return false;
+  }
+  res = responses.front();
+  return static_cast<bool>(res);
+}
@@ -39,9 +39,94 @@
 #include <moveit/moveit_cpp/moveit_cpp.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/plan_execution/plan_execution.h>
+#include <moveit/planning_pipeline_interfaces/solution_selection_functions.hpp>
+#include <moveit/planning_pipeline_interfaces/stopping_criterion_functions.hpp>
+
+#include <algorithm>
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_move_group_capabilities_base.move_group_context");
 
+namespace
+{
+// Load the parallel planning configurations listed in 'parallel_planning.configs'. Each configuration reads
+// 'parallel_planning.<name>.pipelines', '.planner_ids', '.stopping_criterion' and '.solution_selection'
+std::unordered_map<std::string, move_group::MoveGroupContext::ParallelPlanningConfig>
+loadParallelPlanningConfigs(const moveit_cpp::MoveItCppPtr& moveit_cpp)
+{
+  std::unordered_map<std::string, move_group::MoveGroupContext::ParallelPlanningConfig> configs;
+  const auto& node = moveit_cpp->getNode();
+  const auto& pipelines = moveit_cpp->getPlanningPipelines();
+
+  std::vector<std::string> config_names;
+  if (!node->get_parameter("parallel_planning.configs", config_names))
+    return configs;
+
+  for (const auto& name : config_names)
+  {
+    const std::string ns = "parallel_planning." + name + ".";
+    if (pipelines.count(name) > 0)
+    {
+      RCLCPP_ERROR(LOGGER, "Parallel planning configuration '%s' shadows the planning pipeline of the same name",
+                   name.c_str());
+      continue;
+    }
+
+    move_group::MoveGroupContext::ParallelPlanningConfig config;
+    node->get_parameter(ns + "pipelines", config.pipelines);
+    node->get_parameter(ns + "planner_ids", config.planner_ids);
+    if (config.pipelines.empty())
+    {
+      RCLCPP_ERROR(LOGGER, "Parallel planning configuration '%s' lists no pipelines", name.c_str());
+      continue;
+    }
+    // Without planner ids, every pipeline uses its default planner
+    if (config.planner_ids.empty())
+      config.planner_ids.resize(config.pipelines.size());
+    if (config.planner_ids.size() != config.pipelines.size())
+    {
+      RCLCPP_ERROR(LOGGER, "Parallel planning configuration '%s' needs one planner id per pipeline", name.c_str());
+      continue;
+    }
+    const auto missing_pipeline =
+        std::find_if(config.pipelines.begin(), config.pipelines.end(),
+                     [&pipelines](const std::string& pipeline) { return pipelines.count(pipeline) == 0; });
+    if (missing_pipeline != config.pipelines.end())
+    {
+      RCLCPP_ERROR(LOGGER, "Parallel planning configuration '%s' uses unknown planning pipeline '%s'", name.c_str(),
+                   missing_pipeline->c_str());
+      continue;
+    }
+
+    // Without a stopping criterion all pipelines plan until they return or their allowed planning time is up
+    std::string stopping_criterion;
+    node->get_parameter_or(ns + "stopping_criterion", stopping_criterion, std::string("first_solution"));
+    if (stopping_criterion == "first_solution")
+      config.stopping_criterion = &moveit::planning_pipeline_interfaces::stopAtFirstSolution;
+    else if (stopping_criterion != "none")
+    {
+      RCLCPP_ERROR(LOGGER, "Unknown stopping criterion '%s' in parallel planning configuration '%s'",
+                   stopping_criterion.c_str(), name.c_str());
+      continue;
+    }
+
+    std::string solution_selection;
+    node->get_parameter_or(ns + "solution_selection", solution_selection, std::string("shortest"));
+    if (solution_selection != "shortest")
+    {
+      RCLCPP_ERROR(LOGGER, "Unknown solution selection '%s' in parallel planning configuration '%s'",
+                   solution_selection.c_str(), name.c_str());
+      continue;
+    }
+    config.solution_selection = &moveit::planning_pipeline_interfaces::getShortestSolution;
+
+    RCLCPP_INFO(LOGGER, "Loaded parallel planning configuration '%s' with %zu pipelines", name.c_str(),
+                config.pipelines.size());
+    configs[name] = std::move(config);
+  }
+  return configs;
+}
+}  // namespace
+
 move_group::MoveGroupContext::MoveGroupContext(const moveit_cpp::MoveItCppPtr& moveit_cpp,
                                                const std::string& default_planning_pipeline,
                                                bool allow_trajectory_execution, bool debug)
@@ -72,6 +157,8 @@ move_group::MoveGroupContext::MoveGroupContext(const moveit_cpp::MoveItCppPtr& m
         default_planning_pipeline.c_str());
   }
 
+  parallel_planning_configs_ = loadParallelPlanningConfigs(moveit_cpp_);
+
   if (allow_trajectory_execution_)
   {
     trajectory_execution_manager_ = moveit_cpp_->getTrajectoryExecutionManagerNonConst();
@@ -88,6 +175,13 @@ move_group::MoveGroupContext::~MoveGroupContext()
   planning_scene_monitor_.reset();
 }
 
+const move_group::MoveGroupContext::ParallelPlanningConfig*
+move_group::MoveGroupContext::getParallelPlanningConfig(const std::string& name) const
+{
+  const auto it = parallel_planning_configs_.find(name);
+  return it != parallel_planning_configs_.end() ? &it->second : nullptr;
+}
+
 bool move_group::MoveGroupContext::status() const
 {
   const planning_interface::PlannerManagerPtr& planner_interface = planning_pipeline_->getPlannerManager();
@@ -39,6 +39,7 @@
 #pragma once
 
 #include <mutex>
+#include <vector>
 
 #include <rclcpp/rclcpp.hpp>
 
@@ -62,6 +63,15 @@ public:
   CollisionCheck(const rclcpp::Node::SharedPtr& node, const servo::Params& servo_params,
                  const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
 
+  /** \brief Constructor for checking several groups of the robot in one timer
+   *  \param servo_params: settings of moveit_servo, one entry per group
+   *  \param planning_scene_monitor: PSM should have scene monitor and state monitor
+   *                                 already started when passed into this class
+   *  The velocity scale of each group is published in the sub-namespace named after its move_group_name.
+   */
+  CollisionCheck(const rclcpp::Node::SharedPtr& node, const std::vector<servo::Params>& servo_params,
+                 const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
+
   ~CollisionCheck()
   {
     stop();
@@ -74,42 +84,57 @@ public:
   void stop();
 
 private:
+  // Settings of the collision check of one group
+  struct GroupCheck
+  {
+    servo::Params servo_params;
+    const moveit::core::JointModelGroup* joint_model_group;
+    double self_velocity_scale_coefficient;
+    double scene_velocity_scale_coefficient;
+    collision_detection::CollisionRequest collision_request;
+    rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr collision_velocity_scale_pub;
+  };
+
+  /** \brief Set up the collision check of one group, publishing in the given sub-namespace */
+  void addGroup(const servo::Params& servo_params, const std::string& group_namespace);
+
   /** \brief Run one iteration of collision checking */
   void run();
 
+  /** \brief Compute the velocity scale of one group for the current state, and for the state a lookahead time
+   * ahead if the group's collision_check_lookahead_time is set */
+  double computeVelocityScale(const GroupCheck& group, const planning_scene::PlanningScene& planning_scene);
+
+  /** \brief Compute the velocity scale of one group for the given state */
+  double computeVelocityScale(const GroupCheck& group, const planning_scene::PlanningScene& planning_scene,
+                              const moveit::core::RobotState& state);
+
   /** \brief Get a read-only copy of the planning scene */
   planning_scene_monitor::LockedPlanningSceneRO getLockedPlanningSceneRO() const;
 
   // Pointer to the ROS node
   const std::shared_ptr<rclcpp::Node> node_;
 
-  servo::Params servo_params_;
-
   // Pointer to the collision environment
   planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
 
-  // Robot state and collision matrix from planning scene
+  // Robot state and collision matrix from planning scene, shared by all groups
   std::shared_ptr<moveit::core::RobotState> current_state_;
 
-  // Scale robot velocity according to collision proximity and user-defined thresholds.
-  // I scaled exponentially (cubic power) so velocity drops off quickly after the threshold.
-  // Proximity decreasing --> decelerate
-  double velocity_scale_ = 1;
-  double self_collision_distance_ = 0;
-  double scene_collision_distance_ = 0;
-  bool collision_detected_ = false;
+  // The current state extrapolated along the joint velocities of a group, allocated on first use
+  std::unique_ptr<moveit::core::RobotState> lookahead_state_;
 
-  const double self_velocity_scale_coefficient_;
-  const double scene_velocity_scale_coefficient_;
+  // Each group's robot velocity is scaled according to collision proximity and its user-defined thresholds.
+  // The scale drops off exponentially so velocity drops off quickly after the threshold.
+  // Proximity decreasing --> decelerate
+  std::vector<GroupCheck> groups_;
 
-  // collision request
-  collision_detection::CollisionRequest collision_request_;
+  // collision result
   collision_detection::CollisionResult collision_result_;
 
   // ROS
   rclcpp::TimerBase::SharedPtr timer_;
   double period_;  // The loop period, in seconds
-  rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr collision_velocity_scale_pub_;
 
   mutable std::mutex joint_state_mutex_;
   sensor_msgs::msg::JointState latest_joint_state_;
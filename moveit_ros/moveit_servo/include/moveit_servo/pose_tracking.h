@@ -159,6 +159,7 @@ private:
   // Joint group used for controlling the motions
   std::string move_group_name_;
 
+  // Used to pace the control loop in low latency mode, otherwise it follows the servo loop
   rclcpp::WallRate loop_rate_;
 
   // ROS interface to Servo
@@ -172,8 +173,9 @@ private:
   // Transforms w.r.t. planning_frame_
   Eigen::Isometry3d command_frame_transform_;
   rclcpp::Time command_frame_transform_stamp_ = rclcpp::Time(0, 0, RCL_ROS_TIME);
-  geometry_msgs::msg::PoseStamped target_pose_;
-  mutable std::mutex target_pose_mtx_;
+  // The latest target pose in planning_frame_, handed over by targetPoseCallback() without locking.
+  // Accessed through std::atomic_load/atomic_store.
+  geometry_msgs::msg::PoseStamped::ConstSharedPtr target_pose_;
 
   // Subscribe to target pose
   rclcpp::Subscription<geometry_msgs::msg::PoseStamped>::SharedPtr target_pose_sub_;
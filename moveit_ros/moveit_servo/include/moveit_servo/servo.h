@@ -40,6 +40,7 @@
 
 // System
 #include <memory>
+#include <vector>
 
 // Moveit2
 #include <moveit_servo/collision_check.h>
@@ -84,6 +85,15 @@ public:
   bool getEEFrameTransform(Eigen::Isometry3d& transform);
   bool getEEFrameTransform(geometry_msgs::msg::TransformStamped& transform);
 
+  /**
+   * Wait until the servo loop updated the command frame and End Effector transforms, once per iteration.
+   * This allows running code on the timing of the servo loop.
+   *
+   * @param timeout the maximum time to wait
+   * @return true if the transforms were updated, false on timeout
+   */
+  bool waitForFrameTransformUpdate(const std::chrono::duration<double>& timeout);
+
   // Give test access to private/protected methods
   friend class ServoFixture;
 
@@ -99,4 +109,67 @@ private:
 // ServoPtr using alias
 using ServoPtr = std::shared_ptr<Servo>;
 
+/**
+ * Class MultiGroupServo - Servo for several groups of one robot in a single node.
+ *
+ * All groups share one planning scene monitor and one collision check timer, which checks every group against
+ * the same state and locked planning scene. Each group still runs its own servo loop. Its services and its
+ * collision velocity scale topic are placed in a sub-namespace of the node named after its move_group_name,
+ * the command and status topics come from its parameters.
+ */
+class MultiGroupServo
+{
+public:
+  /**
+   * @param servo_param_listeners One parameter listener per group, e.g. each reading its own parameter prefix
+   * @exception std::runtime_error if no group is given or a group is given twice
+   */
+  MultiGroupServo(const rclcpp::Node::SharedPtr& node,
+                  const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+                  std::vector<std::unique_ptr<const servo::ParamListener>> servo_param_listeners);
+
+  /** \brief Start servo for all groups */
+  void start();
+
+  /** \brief Stop servo for all groups */
+  void stop();
+
+  /** \brief Get the number of servoed groups, in the order of the parameter listeners */
+  std::size_t getGroupCount() const
+  {
+    return servo_calcs_.size();
+  }
+
+  /**
+   * Get the MoveIt planning link transform of a group.
+   * The transform from the MoveIt planning frame to robot_link_command_frame
+   *
+   * @param group_index index of the group, in the order of the parameter listeners
+   * @param transform the transform that will be calculated
+   * @return true if a valid transform was available
+   */
+  bool getCommandFrameTransform(std::size_t group_index, Eigen::Isometry3d& transform);
+  bool getCommandFrameTransform(std::size_t group_index, geometry_msgs::msg::TransformStamped& transform);
+
+  /**
+   * Get the End Effector link transform of a group.
+   * The transform from the MoveIt planning frame to EE link
+   *
+   * @param group_index index of the group, in the order of the parameter listeners
+   * @param transform the transform that will be calculated
+   * @return true if a valid transform was available
+   */
+  bool getEEFrameTransform(std::size_t group_index, Eigen::Isometry3d& transform);
+  bool getEEFrameTransform(std::size_t group_index, geometry_msgs::msg::TransformStamped& transform);
+
+private:
+  std::vector<servo::Params> servo_params_;
+  // Pointer to the collision environment, shared by all groups
+  planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
+
+  std::vector<std::unique_ptr<ServoCalcs>> servo_calcs_;
+  // Checks all groups with check_collisions enabled, if there are any
+  std::unique_ptr<CollisionCheck> collision_checker_;
+};
+
 }  // namespace moveit_servo
@@ -48,6 +48,7 @@
 #include <control_msgs/msg/joint_jog.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/planning_scene_monitor/shared_state_channel.h>
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit_msgs/srv/change_drift_dimensions.hpp>
 #include <moveit_msgs/srv/change_control_dimensions.hpp>
@@ -57,6 +58,7 @@
 #include <std_msgs/msg/float64.hpp>
 #include <std_msgs/msg/float64_multi_array.hpp>
 #include <std_msgs/msg/int8.hpp>
+#include <std_msgs/msg/u_int64_multi_array.hpp>
 #include <std_srvs/srv/empty.hpp>
 #include <trajectory_msgs/msg/joint_trajectory.hpp>
 
@@ -64,6 +66,7 @@
 #include <moveit/kinematics_base/kinematics_base.h>
 
 // moveit_servo
+#include <moveit_servo/shared_memory_command.h>
 #include <moveit_servo/status_codes.h>
 #include <moveit/online_signal_smoothing/smoothing_base_class.h>
 #include <moveit_servo_lib_parameters.hpp>
@@ -79,9 +82,14 @@ enum class ServoType
 class ServoCalcs
 {
 public:
+  /**
+   * @param group_namespace Sub-namespace of the node for the services and the collision velocity scale topic
+   *                        of this instance, to run several groups in one node. Empty for none.
+   */
   ServoCalcs(const rclcpp::Node::SharedPtr& node,
              const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
-             std::unique_ptr<const servo::ParamListener> servo_param_listener);
+             std::unique_ptr<const servo::ParamListener> servo_param_listener,
+             const std::string& group_namespace = "");
 
   ~ServoCalcs();
 
@@ -121,6 +129,15 @@ public:
   bool getEEFrameTransform(Eigen::Isometry3d& transform);
   bool getEEFrameTransform(geometry_msgs::msg::TransformStamped& transform);
 
+  /**
+   * Wait until the main loop updated the command frame and End Effector transforms.
+   * The main loop updates them once per iteration.
+   *
+   * @param timeout the maximum time to wait
+   * @return true if the transforms were updated, false on timeout
+   */
+  bool waitForFrameTransformUpdate(const std::chrono::duration<double>& timeout);
+
 protected:
   /** \brief Run the main calculation loop */
   void mainCalcLoop();
@@ -198,6 +215,11 @@ protected:
    */
   void insertRedundantPointsIntoTrajectory(trajectory_msgs::msg::JointTrajectory& joint_trajectory, int count) const;
 
+  /** \brief Add the duration of one loop iteration to the latency histogram and publish it about once a second.
+   * Does nothing if latency_histogram_topic is empty.
+   */
+  void recordLatency(const rclcpp::Duration& run_duration);
+
   /**
    * Remove the Jacobian row and the delta-x element of one Cartesian dimension, to take advantage of task redundancy
    *
@@ -280,6 +302,15 @@ protected:
 
   trajectory_msgs::msg::JointTrajectory::SharedPtr last_sent_command_;
 
+  // Outgoing messages, allocated once in start() and refilled in place every iteration
+  trajectory_msgs::msg::JointTrajectory joint_trajectory_;
+  std_msgs::msg::Float64MultiArray multiarray_msg_;
+  std_msgs::msg::Int8 status_msg_;
+
+  // Latency histogram of the loop iteration duration, in buckets of publish_period / 10, plus an overflow bucket
+  std_msgs::msg::UInt64MultiArray latency_histogram_;
+  std::size_t latency_histogram_cycles_ = 0;
+
   // ROS
   rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_state_sub_;
   rclcpp::Subscription<geometry_msgs::msg::TwistStamped>::SharedPtr twist_stamped_sub_;
@@ -288,22 +319,35 @@ protected:
   rclcpp::Publisher<std_msgs::msg::Int8>::SharedPtr status_pub_;
   rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr trajectory_outgoing_cmd_pub_;
   rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr multiarray_outgoing_cmd_pub_;
+  rclcpp::Publisher<std_msgs::msg::UInt64MultiArray>::SharedPtr latency_histogram_pub_;
+
+  // Shared memory output of the commands, if command_out_shared_memory is set
+  std::unique_ptr<SharedMemoryCommandWriter> shared_memory_command_writer_;
+  // Shared memory input of the current state, if joint_state_shared_memory is set
+  planning_scene_monitor::SharedStateReaderPtr shared_state_reader_;
   rclcpp::Service<moveit_msgs::srv::ChangeControlDimensions>::SharedPtr control_dimensions_server_;
   rclcpp::Service<moveit_msgs::srv::ChangeDriftDimensions>::SharedPtr drift_dimensions_server_;
 
   // Main tracking / result publisher loop
   std::thread thread_;
-  bool stop_requested_;
+  std::atomic<bool> stop_requested_;
 
   // Status
   StatusCode status_ = StatusCode::NO_WARNING;
   bool twist_command_is_stale_ = false;
   bool joint_command_is_stale_ = false;
-  double collision_velocity_scale_ = 1.0;
+  std::atomic<double> collision_velocity_scale_ = 1.0;
 
   // Use ArrayXd type to enable more coefficient-wise operations
   Eigen::ArrayXd delta_theta_;
 
+  // Workspaces of the Cartesian servo calculations, kept to reuse their memory between iterations
+  Eigen::MatrixXd jacobian_;
+  Eigen::MatrixXd jacobian_derivative_;
+  Eigen::JacobiSVD<Eigen::MatrixXd> svd_;
+  Eigen::MatrixXd pseudo_inverse_;
+  Eigen::VectorXd joint_velocities_;
+
   const int gazebo_redundant_message_count_ = 30;
 
   unsigned int num_joints_;
@@ -314,18 +358,30 @@ protected:
   // The dimensions to control. In the command frame. [x, y, z, roll, pitch, yaw]
   std::array<bool, 6> control_dimensions_ = { { true, true, true, true, true, true } };
 
-  // main_loop_mutex_ is used to protect the input state and dynamic parameters
+  // main_loop_mutex_ is used to protect the internal state and dynamic parameters
   mutable std::mutex main_loop_mutex_;
+
+  // The frame transforms are read by the C++ API under frame_transforms_mutex_ instead of main_loop_mutex_,
+  // so reading them never waits for a running iteration. Writes of servo_params_, whose frame names are read
+  // along with them, hold it as well.
+  mutable std::mutex frame_transforms_mutex_;
+  std::condition_variable frame_transforms_cv_;
+  uint64_t frame_transforms_update_count_ = 0;
   Eigen::Isometry3d tf_moveit_to_robot_cmd_frame_;
   Eigen::Isometry3d tf_moveit_to_ee_frame_;
+
+  // The latest incoming commands are handed over to the main loop without locking main_loop_mutex_,
+  // so a subscriber callback never waits for a running iteration. Accessed through std::atomic_load/atomic_store.
   geometry_msgs::msg::TwistStamped::ConstSharedPtr latest_twist_stamped_;
   control_msgs::msg::JointJog::ConstSharedPtr latest_joint_cmd_;
-  rclcpp::Time latest_twist_command_stamp_ = rclcpp::Time(0., RCL_ROS_TIME);
-  rclcpp::Time latest_joint_command_stamp_ = rclcpp::Time(0., RCL_ROS_TIME);
+  // Command stamps in nanoseconds of RCL_ROS_TIME
+  std::atomic<int64_t> latest_twist_command_stamp_ns_ = 0;
+  std::atomic<int64_t> latest_joint_command_stamp_ns_ = 0;
 
-  // input condition variable used for low latency mode
+  // input condition variable used for low latency mode, input_mutex_ only guards waiting on it
+  std::mutex input_mutex_;
   std::condition_variable input_cv_;
-  bool new_input_cmd_ = false;
+  std::atomic<bool> new_input_cmd_ = false;
 
   // Load a smoothing plugin
   pluginlib::ClassLoader<online_signal_smoothing::SmoothingBaseClass> smoothing_loader_;
@@ -0,0 +1,187 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/*      Title     : shared_memory_command.h
+ *      Project   : moveit_servo
+ *      Created   : 10/15/2026
+ *
+ *      Desc      : ROS-free joint command channel from servo to a controller on the same host, through POSIX shared
+ *                  memory. It avoids the serialization and transport of the outgoing command topic.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace moveit_servo
+{
+/** \brief Layout of the shared memory segment that holds the latest joint command.
+ *
+ * The command is protected by a sequence lock: the sequence is odd while a command is written and increases by two
+ * with every command. The writer never waits for readers, and a reader that finds a command being written keeps its
+ * previous one, so neither side ever blocks. All command fields are lock-free atomics, so that concurrent access is
+ * well-defined across processes. */
+struct SharedMemoryCommandSegment
+{
+  static constexpr std::uint32_t MAGIC = 0x43565253;  // "SRVC"
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr std::size_t MAX_JOINTS = 32;
+  static constexpr std::size_t MAX_JOINT_NAME_LENGTH = 64;
+
+  /// MAGIC while the writer is alive, 0 before it initialized the segment and after it closed it
+  std::atomic<std::uint32_t> magic;
+  std::uint32_t version;
+  std::uint32_t num_joints;
+  /// Null-terminated joint names, in the order of the joint values of the command
+  char joint_names[MAX_JOINTS][MAX_JOINT_NAME_LENGTH];
+
+  std::atomic<std::uint64_t> sequence;
+  /// SharedMemoryCommand::Field flags of the values set in the command
+  std::atomic<std::uint32_t> fields;
+  /// Time the command was written, in nanoseconds of std::chrono::steady_clock
+  std::atomic<std::int64_t> stamp;
+  std::atomic<double> positions[MAX_JOINTS];
+  std::atomic<double> velocities[MAX_JOINTS];
+  std::atomic<double> accelerations[MAX_JOINTS];
+};
+
+/** \brief A joint command, as written to and read from shared memory */
+struct SharedMemoryCommand
+{
+  enum Field : std::uint32_t
+  {
+    POSITIONS = 1,
+    VELOCITIES = 2,
+    ACCELERATIONS = 4
+  };
+
+  /// Field flags of the values that are set, the vectors of the other values are empty
+  std::uint32_t fields = 0;
+  /// Time the command was written, in nanoseconds of std::chrono::steady_clock
+  std::int64_t stamp = 0;
+  /// Sequence number of the command, increases with every written command
+  std::uint64_t sequence = 0;
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+};
+
+/** \brief Writes joint commands to a shared memory segment, for a single SharedMemoryCommandReader in another process.
+ *
+ * Only one writer may use a segment at a time. The segment is removed when the writer is destroyed. */
+class SharedMemoryCommandWriter
+{
+public:
+  /** \brief Create the segment, replacing any previous segment of the same name
+   * @param name The name of the segment, e.g. "/moveit_servo_command", see shm_open()
+   * @param joint_names The names of the joints, in the order of the values of the written commands
+   * @throws std::runtime_error if the segment cannot be created, or there are too many joints or too long names
+   */
+  SharedMemoryCommandWriter(const std::string& name, const std::vector<std::string>& joint_names);
+
+  ~SharedMemoryCommandWriter();
+
+  SharedMemoryCommandWriter(const SharedMemoryCommandWriter&) = delete;
+  SharedMemoryCommandWriter& operator=(const SharedMemoryCommandWriter&) = delete;
+
+  /** \brief Publish a command. Empty vectors leave the corresponding values unset, others must have a value per joint.
+   *
+   * This is wait-free and does not allocate. */
+  void write(std::int64_t stamp, const std::vector<double>& positions, const std::vector<double>& velocities,
+             const std::vector<double>& accelerations);
+
+private:
+  std::string name_;
+  SharedMemoryCommandSegment* segment_ = nullptr;
+};
+
+/** \brief Reads the joint commands of a SharedMemoryCommandWriter in another process, e.g. in the update() of a
+ * ros2_control controller. */
+class SharedMemoryCommandReader
+{
+public:
+  SharedMemoryCommandReader() = default;
+  ~SharedMemoryCommandReader();
+
+  SharedMemoryCommandReader(const SharedMemoryCommandReader&) = delete;
+  SharedMemoryCommandReader& operator=(const SharedMemoryCommandReader&) = delete;
+
+  /** \brief Map the segment \e name. Returns false if there is no initialized segment of that name (yet). */
+  bool open(const std::string& name);
+
+  /** \brief Unmap the segment */
+  void close();
+
+  bool isOpen() const
+  {
+    return segment_ != nullptr;
+  }
+
+  /** \brief Check if the writer of the open segment still exists. Once it is gone, the segment needs to be reopened
+   * to receive the commands of a new writer. */
+  bool isWriterAlive() const;
+
+  /** \brief Get the names of the joints of the open segment, in the order of the command values */
+  const std::vector<std::string>& getJointNames() const
+  {
+    return joint_names_;
+  }
+
+  /** \brief Read the latest command, if it is newer than the previously read one and completely written.
+   *
+   * This is wait-free. It only allocates during the first reads, while the vectors of \e command and of an internal
+   * buffer are sized to the joints, as long as the same command is passed every time, e.g. from a realtime loop.
+   * Returns false, leaving \e command unchanged, if there is no new command, the command is being written, or the
+   * writer is gone. */
+  bool read(SharedMemoryCommand& command);
+
+  /** \brief Get the number of commands that were written but never read, e.g. because the reader was slower than the
+   * writer */
+  std::uint64_t getMissedCount() const
+  {
+    return missed_count_;
+  }
+
+private:
+  SharedMemoryCommandSegment* segment_ = nullptr;
+  std::vector<std::string> joint_names_;
+  SharedMemoryCommand buffer_;
+  std::uint64_t last_sequence_ = 0;
+  std::uint64_t missed_count_ = 0;
+};
+}  // namespace moveit_servo
@@ -47,6 +47,13 @@
 
 namespace moveit_servo
 {
+/** \brief Name of a topic or service of servo in the private namespace of the node.
+ * @param group_namespace Sub-namespace that keeps the interfaces of several servo groups in one node apart.
+ *                        The name is not placed in a sub-namespace if this is empty.
+ * @param name The name of the topic or service
+ */
+std::string servoInterfaceName(const std::string& group_namespace, const std::string& name);
+
 // Helper function for converting Eigen::Isometry3d to geometry_msgs/TransformStamped
 geometry_msgs::msg::TransformStamped convertIsometryToTransform(const Eigen::Isometry3d& eigen_tf,
                                                                 const std::string& parent_frame,
@@ -74,6 +81,27 @@ double velocityScalingFactorForSingularity(const moveit::core::JointModelGroup*
                                            const double leaving_singularity_threshold_multiplier, rclcpp::Clock& clock,
                                            const moveit::core::RobotStatePtr& current_state, StatusCode& status);
 
+/** \brief Possibly calculate a velocity scaling factor, due to proximity of
+ * singularity and direction of motion. The direction toward the singularity is found from the derivative
+ * of the condition number, so no further Jacobian needs to be decomposed.
+ * @param[in] commanded_twist     The commanded Cartesian twist
+ * @param[in] svd                 A singular value decomposition of the Jacobian, with thin U and V
+ * @param[in] jacobian_derivative The change of the Jacobian for the joint motion pseudo_inverse * u, where u is
+ *                                the last column of svd.matrixU()
+ * @param[in] hard_stop_singularity_threshold  Halt if condition(Jacobian) > hard_stop_singularity_threshold
+ * @param[in] lower_singularity_threshold      Decelerate if condition(Jacobian) > lower_singularity_threshold
+ * @param[in] leaving_singularity_threshold_multiplier      Allow faster motion away from singularity
+ * @param[in, out] clock          A ROS clock, for logging
+ * @param[out] status             Singularity status
+ */
+double velocityScalingFactorForSingularity(const Eigen::VectorXd& commanded_twist,
+                                           const Eigen::JacobiSVD<Eigen::MatrixXd>& svd,
+                                           const Eigen::MatrixXd& jacobian_derivative,
+                                           const double hard_stop_singularity_threshold,
+                                           const double lower_singularity_threshold,
+                                           const double leaving_singularity_threshold_multiplier, rclcpp::Clock& clock,
+                                           StatusCode& status);
+
 /** \brief Joint-wise update of a sensor_msgs::msg::JointState with given delta's
  * Also filters and calculates the previous velocity
  * @param clock A ROS clock, for logging
@@ -40,30 +40,57 @@
 #include <std_msgs/msg/float64.hpp>
 
 #include <moveit_servo/collision_check.h>
+#include <moveit_servo/utilities.h>
+#include <limits>
 // #include <moveit_servo/make_shared_from_pool.h>
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_servo.collision_check");
 static const double MIN_RECOMMENDED_COLLISION_RATE = 10;
 constexpr size_t ROS_LOG_THROTTLE_PERIOD = 30 * 1000;  // Milliseconds to throttle logs inside loops
+// The proximity scale at zero distance
+static const double MIN_LOOKAHEAD_VELOCITY_SCALE = 0.001;
 
 namespace moveit_servo
 {
 // Constructor for the class that handles collision checking
 CollisionCheck::CollisionCheck(const rclcpp::Node::SharedPtr& node, const servo::Params& servo_params,
                                const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
-  : node_(node)
-  , servo_params_(servo_params)
-  , planning_scene_monitor_(planning_scene_monitor)
-  , self_velocity_scale_coefficient_(-log(0.001) / servo_params_.self_collision_proximity_threshold)
-  , scene_velocity_scale_coefficient_(-log(0.001) / servo_params_.scene_collision_proximity_threshold)
-  , period_(1. / servo_params_.collision_check_rate)
+  : node_(node), planning_scene_monitor_(planning_scene_monitor), period_(1. / servo_params.collision_check_rate)
 {
-  // Init collision request
-  collision_request_.group_name = servo_params_.move_group_name;
-  collision_request_.distance = true;  // enable distance-based collision checking
-  collision_request_.contacts = true;  // Record the names of collision pairs
+  addGroup(servo_params, "");
+  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
+}
 
-  if (servo_params_.collision_check_rate < MIN_RECOMMENDED_COLLISION_RATE)
+CollisionCheck::CollisionCheck(const rclcpp::Node::SharedPtr& node, const std::vector<servo::Params>& servo_params,
+                               const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
+  : node_(node), planning_scene_monitor_(planning_scene_monitor), period_(std::numeric_limits<double>::infinity())
+{
+  // The shared timer runs at the highest rate any group asks for
+  for (const servo::Params& params : servo_params)
+  {
+    addGroup(params, params.move_group_name);
+    period_ = std::min(period_, 1. / params.collision_check_rate);
+  }
+  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
+}
+
+void CollisionCheck::addGroup(const servo::Params& servo_params, const std::string& group_namespace)
+{
+  GroupCheck group;
+  group.servo_params = servo_params;
+  group.joint_model_group = planning_scene_monitor_->getRobotModel()->getJointModelGroup(servo_params.move_group_name);
+  group.self_velocity_scale_coefficient = -log(0.001) / servo_params.self_collision_proximity_threshold;
+  group.scene_velocity_scale_coefficient = -log(0.001) / servo_params.scene_collision_proximity_threshold;
+
+  // Init collision request
+  group.collision_request.group_name = servo_params.move_group_name;
+  group.collision_request.distance = true;  // enable distance-based collision checking
+  group.collision_request.contacts = true;  // Record the names of collision pairs
+  // Objects beyond both proximity thresholds do not slow down the robot, so their distance is not needed
+  group.collision_request.distance_threshold =
+      std::max(servo_params.self_collision_proximity_threshold, servo_params.scene_collision_proximity_threshold);
+
+  if (servo_params.collision_check_rate < MIN_RECOMMENDED_COLLISION_RATE)
   {
     auto& clk = *node_->get_clock();
 #pragma GCC diagnostic push
@@ -74,10 +101,10 @@ CollisionCheck::CollisionCheck(const rclcpp::Node::SharedPtr& node, const servo:
   }
 
   // ROS pubs/subs
-  collision_velocity_scale_pub_ =
-      node_->create_publisher<std_msgs::msg::Float64>("~/collision_velocity_scale", rclcpp::SystemDefaultsQoS());
+  group.collision_velocity_scale_pub = node_->create_publisher<std_msgs::msg::Float64>(
+      servoInterfaceName(group_namespace, "collision_velocity_scale"), rclcpp::SystemDefaultsQoS());
 
-  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
+  groups_.push_back(std::move(group));
 }
 
 planning_scene_monitor::LockedPlanningSceneRO CollisionCheck::getLockedPlanningSceneRO() const
@@ -100,62 +127,108 @@ void CollisionCheck::stop()
 
 void CollisionCheck::run()
 {
-  // Update to the latest current state
+  // Update to the latest current state, once for all groups
   current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
   current_state_->updateCollisionBodyTransforms();
-  collision_detected_ = false;
+
+  std::vector<double> velocity_scales;
+  velocity_scales.reserve(groups_.size());
+  {
+    const planning_scene_monitor::LockedPlanningSceneRO planning_scene = getLockedPlanningSceneRO();
+    for (const GroupCheck& group : groups_)
+      velocity_scales.push_back(computeVelocityScale(group, *planning_scene));
+  }
+
+  // publish messages
+  for (std::size_t i = 0; i < groups_.size(); ++i)
+  {
+    auto msg = std::make_unique<std_msgs::msg::Float64>();
+    msg->data = velocity_scales[i];
+    groups_[i].collision_velocity_scale_pub->publish(std::move(msg));
+  }
+}
+
+double CollisionCheck::computeVelocityScale(const GroupCheck& group,
+                                            const planning_scene::PlanningScene& planning_scene)
+{
+  double velocity_scale = computeVelocityScale(group, planning_scene, *current_state_);
+
+  // Look ahead along the current joint velocities, to slow down before getting close to an obstacle
+  const double lookahead_time = group.servo_params.collision_check_lookahead_time;
+  if (lookahead_time > 0.0 && velocity_scale > 0.0 && group.joint_model_group && current_state_->hasVelocities())
+  {
+    if (!lookahead_state_)
+      lookahead_state_ = std::make_unique<moveit::core::RobotState>(*current_state_);
+    else
+      *lookahead_state_ = *current_state_;
+
+    Eigen::VectorXd positions, velocities;
+    current_state_->copyJointGroupPositions(group.joint_model_group, positions);
+    current_state_->copyJointGroupVelocities(group.joint_model_group, velocities);
+    lookahead_state_->setJointGroupPositions(group.joint_model_group, positions + lookahead_time * velocities);
+    lookahead_state_->enforceBounds(group.joint_model_group);
+    lookahead_state_->updateCollisionBodyTransforms();
+
+    // Reaching a collision within the lookahead time slows down as much as touching, but does not halt,
+    // so the robot can still be moved out of that direction
+    const double lookahead_scale =
+        std::max(computeVelocityScale(group, planning_scene, *lookahead_state_), MIN_LOOKAHEAD_VELOCITY_SCALE);
+    velocity_scale = std::min(velocity_scale, lookahead_scale);
+  }
+  return velocity_scale;
+}
+
+double CollisionCheck::computeVelocityScale(const GroupCheck& group,
+                                            const planning_scene::PlanningScene& planning_scene,
+                                            const moveit::core::RobotState& state)
+{
+  const servo::Params& servo_params = group.servo_params;
+  bool collision_detected = false;
 
   // Do a timer-safe distance-based collision detection
   collision_result_.clear();
-  getLockedPlanningSceneRO()->getCollisionEnv()->checkRobotCollision(collision_request_, collision_result_,
-                                                                     *current_state_);
-  scene_collision_distance_ = collision_result_.distance;
-  collision_detected_ |= collision_result_.collision;
+  planning_scene.getCollisionEnv()->checkRobotCollision(group.collision_request, collision_result_, state);
+  const double scene_collision_distance = collision_result_.distance;
+  collision_detected |= collision_result_.collision;
   collision_result_.print();
 
   collision_result_.clear();
   // Self-collisions and scene collisions are checked separately so different thresholds can be used
-  getLockedPlanningSceneRO()->getCollisionEnvUnpadded()->checkSelfCollision(
-      collision_request_, collision_result_, *current_state_, getLockedPlanningSceneRO()->getAllowedCollisionMatrix());
-  self_collision_distance_ = collision_result_.distance;
-  collision_detected_ |= collision_result_.collision;
+  planning_scene.getCollisionEnvUnpadded()->checkSelfCollision(group.collision_request, collision_result_, state,
+                                                               planning_scene.getAllowedCollisionMatrix());
+  const double self_collision_distance = collision_result_.distance;
+  collision_detected |= collision_result_.collision;
   collision_result_.print();
 
-  velocity_scale_ = 1;
+  double velocity_scale = 1;
   // If we're definitely in collision, stop immediately
-  if (collision_detected_)
+  if (collision_detected)
   {
-    velocity_scale_ = 0;
+    velocity_scale = 0;
   }
   else
   {
     // If we are far from a collision, velocity_scale should be 1.
     // If we are very close to a collision, velocity_scale should be ~zero.
     // When scene_collision_proximity_threshold is breached, start decelerating exponentially.
-    if (scene_collision_distance_ < servo_params_.scene_collision_proximity_threshold)
+    if (scene_collision_distance < servo_params.scene_collision_proximity_threshold)
     {
       // velocity_scale = e ^ k * (collision_distance - threshold)
       // k = - ln(0.001) / collision_proximity_threshold
       // velocity_scale should equal one when collision_distance is at collision_proximity_threshold.
       // velocity_scale should equal 0.001 when collision_distance is at zero.
-      velocity_scale_ = std::min(velocity_scale_,
-                                 exp(scene_velocity_scale_coefficient_ *
-                                     (scene_collision_distance_ - servo_params_.scene_collision_proximity_threshold)));
+      velocity_scale = std::min(velocity_scale,
+                                exp(group.scene_velocity_scale_coefficient *
+                                    (scene_collision_distance - servo_params.scene_collision_proximity_threshold)));
     }
 
-    if (self_collision_distance_ < servo_params_.self_collision_proximity_threshold)
+    if (self_collision_distance < servo_params.self_collision_proximity_threshold)
     {
-      velocity_scale_ =
-          std::min(velocity_scale_, exp(self_velocity_scale_coefficient_ *
-                                        (self_collision_distance_ - servo_params_.self_collision_proximity_threshold)));
+      velocity_scale = std::min(velocity_scale,
+                                exp(group.self_velocity_scale_coefficient *
+                                    (self_collision_distance - servo_params.self_collision_proximity_threshold)));
     }
   }
-
-  // publish message
-  {
-    auto msg = std::make_unique<std_msgs::msg::Float64>();
-    msg->data = velocity_scale_;
-    collision_velocity_scale_pub_->publish(std::move(msg));
-  }
+  return velocity_scale;
 }
 }  // namespace moveit_servo
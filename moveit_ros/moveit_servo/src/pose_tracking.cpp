@@ -78,6 +78,7 @@ PoseTracking::PoseTracking(const rclcpp::Node::SharedPtr& node,
   , servo_parameters_(servo_param_listener->get_params())
   , planning_scene_monitor_(planning_scene_monitor)
   , loop_rate_(1.0 / servo_parameters_.publish_period)
+  , target_pose_(std::make_shared<geometry_msgs::msg::PoseStamped>())
   , transform_buffer_(node_->get_clock())
   , transform_listener_(transform_buffer_)
   , stop_requested_(false)
@@ -121,7 +122,7 @@ PoseTrackingStatusCode PoseTracking::moveToPose(const Eigen::Vector3d& positiona
     {
       command_frame_transform_stamp_ = node_->now();
     }
-    std::this_thread::sleep_for(1ms);
+    servo_->waitForFrameTransformUpdate(loop_rate_.period());
   }
 
   if (!haveRecentTargetPose(target_pose_timeout))
@@ -166,7 +167,12 @@ PoseTrackingStatusCode PoseTracking::moveToPose(const Eigen::Vector3d& positiona
     // Compute servo command from PID controller output and send it to the Servo object, for execution
     twist_stamped_pub_->publish(*calculateTwistCommand());
 
-    if (!loop_rate_.sleep())
+    // Follow the timing of the servo loop, which updates the end effector pose once per iteration. In low latency
+    // mode servo computes right after each command, so the rate has to be kept here.
+    const bool on_time = servo_parameters_.low_latency_mode ?
+                             loop_rate_.sleep() :
+                             servo_->waitForFrameTransformUpdate(2 * loop_rate_.period());
+    if (!on_time)
     {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -225,8 +231,8 @@ void PoseTracking::initializePID(const PIDConfig& pid_config, std::vector<contro
 
 bool PoseTracking::haveRecentTargetPose(const double timespan)
 {
-  std::lock_guard<std::mutex> lock(target_pose_mtx_);
-  return ((node_->now() - target_pose_.header.stamp).seconds() < timespan);
+  const auto target_pose = std::atomic_load(&target_pose_);
+  return ((node_->now() - target_pose->header.stamp).seconds() < timespan);
 }
 
 bool PoseTracking::haveRecentEndEffectorPose(const double timespan)
@@ -236,10 +242,10 @@ bool PoseTracking::haveRecentEndEffectorPose(const double timespan)
 
 bool PoseTracking::satisfiesPoseTolerance(const Eigen::Vector3d& positional_tolerance, const double angular_tolerance)
 {
-  std::lock_guard<std::mutex> lock(target_pose_mtx_);
-  double x_error = target_pose_.pose.position.x - command_frame_transform_.translation()(0);
-  double y_error = target_pose_.pose.position.y - command_frame_transform_.translation()(1);
-  double z_error = target_pose_.pose.position.z - command_frame_transform_.translation()(2);
+  const auto target_pose = std::atomic_load(&target_pose_);
+  double x_error = target_pose->pose.position.x - command_frame_transform_.translation()(0);
+  double y_error = target_pose->pose.position.y - command_frame_transform_.translation()(1);
+  double z_error = target_pose->pose.position.z - command_frame_transform_.translation()(2);
 
   // If uninitialized, likely haven't received the target pose yet.
   if (!angular_error_)
@@ -251,25 +257,29 @@ bool PoseTracking::satisfiesPoseTolerance(const Eigen::Vector3d& positional_tole
 
 void PoseTracking::targetPoseCallback(const geometry_msgs::msg::PoseStamped::ConstSharedPtr& msg)
 {
-  std::lock_guard<std::mutex> lock(target_pose_mtx_);
-  target_pose_ = *msg;
   // If the target pose is not defined in planning frame, transform the target pose.
-  if (target_pose_.header.frame_id != planning_frame_)
+  if (msg->header.frame_id != planning_frame_)
   {
+    auto target_pose = std::make_shared<geometry_msgs::msg::PoseStamped>(*msg);
     try
     {
       geometry_msgs::msg::TransformStamped target_to_planning_frame = transform_buffer_.lookupTransform(
-          planning_frame_, target_pose_.header.frame_id, rclcpp::Time(0), rclcpp::Duration(100ms));
-      tf2::doTransform(target_pose_, target_pose_, target_to_planning_frame);
+          planning_frame_, target_pose->header.frame_id, rclcpp::Time(0), rclcpp::Duration(100ms));
+      tf2::doTransform(*target_pose, *target_pose, target_to_planning_frame);
 
       // Prevent doTransform from copying a stamp of 0, which will cause the haveRecentTargetPose check to fail servo motions
-      target_pose_.header.stamp = node_->now();
+      target_pose->header.stamp = node_->now();
     }
     catch (const tf2::TransformException& ex)
     {
       RCLCPP_WARN_STREAM(LOGGER, ex.what());
       return;
     }
+    std::atomic_store(&target_pose_, geometry_msgs::msg::PoseStamped::ConstSharedPtr(std::move(target_pose)));
+  }
+  else
+  {
+    std::atomic_store(&target_pose_, msg);
   }
 }
 
@@ -282,25 +292,25 @@ geometry_msgs::msg::TwistStamped::ConstSharedPtr PoseTracking::calculateTwistCom
   geometry_msgs::msg::Twist& twist = msg->twist;
   Eigen::Quaterniond q_desired;
 
-  // Scope mutex locking only to operations which require access to target pose.
+  // Work on one snapshot of the target pose
   {
-    std::lock_guard<std::mutex> lock(target_pose_mtx_);
-    msg->header.frame_id = target_pose_.header.frame_id;
+    const auto target_pose = std::atomic_load(&target_pose_);
+    msg->header.frame_id = target_pose->header.frame_id;
 
     // Position
     twist.linear.x = cartesian_position_pids_[0].computeCommand(
-        target_pose_.pose.position.x - command_frame_transform_.translation()(0), loop_rate_.period().count());
+        target_pose->pose.position.x - command_frame_transform_.translation()(0), loop_rate_.period().count());
     twist.linear.y = cartesian_position_pids_[1].computeCommand(
-        target_pose_.pose.position.y - command_frame_transform_.translation()(1), loop_rate_.period().count());
+        target_pose->pose.position.y - command_frame_transform_.translation()(1), loop_rate_.period().count());
     twist.linear.z = cartesian_position_pids_[2].computeCommand(
-        target_pose_.pose.position.z - command_frame_transform_.translation()(2), loop_rate_.period().count());
+        target_pose->pose.position.z - command_frame_transform_.translation()(2), loop_rate_.period().count());
 
     // Orientation algorithm:
     // - Find the orientation error as a quaternion: q_error = q_desired * q_current ^ -1
     // - Use the angle-axis PID controller to calculate an angular rate
     // - Convert to angular velocity for the TwistStamped message
-    q_desired = Eigen::Quaterniond(target_pose_.pose.orientation.w, target_pose_.pose.orientation.x,
-                                   target_pose_.pose.orientation.y, target_pose_.pose.orientation.z);
+    q_desired = Eigen::Quaterniond(target_pose->pose.orientation.w, target_pose->pose.orientation.x,
+                                   target_pose->pose.orientation.y, target_pose->pose.orientation.z);
   }
 
   Eigen::Quaterniond q_current(command_frame_transform_.rotation());
@@ -328,10 +338,7 @@ void PoseTracking::stopMotion()
 
   // Send a 0 command to Servo to halt arm motion
   auto msg = moveit::util::make_shared_from_pool<geometry_msgs::msg::TwistStamped>();
-  {
-    std::lock_guard<std::mutex> lock(target_pose_mtx_);
-    msg->header.frame_id = target_pose_.header.frame_id;
-  }
+  msg->header.frame_id = std::atomic_load(&target_pose_)->header.frame_id;
   msg->header.stamp = node_->now();
   twist_stamped_pub_->publish(*msg);
 }
@@ -393,9 +400,9 @@ void PoseTracking::getPIDErrors(double& x_error, double& y_error, double& z_erro
 
 void PoseTracking::resetTargetPose()
 {
-  std::lock_guard<std::mutex> lock(target_pose_mtx_);
-  target_pose_ = geometry_msgs::msg::PoseStamped();
-  target_pose_.header.stamp = rclcpp::Time(RCL_ROS_TIME);
+  auto target_pose = std::make_shared<geometry_msgs::msg::PoseStamped>();
+  target_pose->header.stamp = rclcpp::Time(RCL_ROS_TIME);
+  std::atomic_store(&target_pose_, geometry_msgs::msg::PoseStamped::ConstSharedPtr(std::move(target_pose)));
 }
 
 bool PoseTracking::getCommandFrameTransform(geometry_msgs::msg::TransformStamped& transform)
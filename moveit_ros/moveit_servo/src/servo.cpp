@@ -40,6 +40,8 @@
 #include <moveit_servo/make_shared_from_pool.h>
 #include <moveit_servo/servo.h>
 
+#include <set>
+
 namespace moveit_servo
 {
 namespace
@@ -101,4 +103,91 @@ bool Servo::getEEFrameTransform(geometry_msgs::msg::TransformStamped& transform)
 {
   return servo_calcs_.getEEFrameTransform(transform);
 }
+
+bool Servo::waitForFrameTransformUpdate(const std::chrono::duration<double>& timeout)
+{
+  return servo_calcs_.waitForFrameTransformUpdate(timeout);
+}
+
+MultiGroupServo::MultiGroupServo(const rclcpp::Node::SharedPtr& node,
+                                 const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+                                 std::vector<std::unique_ptr<const servo::ParamListener>> servo_param_listeners)
+  : planning_scene_monitor_{ planning_scene_monitor }
+{
+  if (servo_param_listeners.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "No groups to servo");
+    throw std::runtime_error("No groups to servo");
+  }
+
+  std::set<std::string> group_names;
+  std::vector<servo::Params> collision_check_params;
+  for (std::unique_ptr<const servo::ParamListener>& servo_param_listener : servo_param_listeners)
+  {
+    servo::Params params = servo_param_listener->get_params();
+    if (!group_names.insert(params.move_group_name).second)
+    {
+      RCLCPP_ERROR_STREAM(LOGGER, "Move group `" << params.move_group_name << "` is servoed more than once");
+      throw std::runtime_error("Duplicate move group name");
+    }
+    if (params.check_collisions)
+      collision_check_params.push_back(params);
+
+    servo_calcs_.push_back(std::make_unique<ServoCalcs>(node, planning_scene_monitor_,
+                                                        std::move(servo_param_listener), params.move_group_name));
+    servo_params_.push_back(std::move(params));
+  }
+
+  if (!collision_check_params.empty())
+    collision_checker_ = std::make_unique<CollisionCheck>(node, collision_check_params, planning_scene_monitor_);
+}
+
+void MultiGroupServo::start()
+{
+  for (const servo::Params& params : servo_params_)
+  {
+    if (!planning_scene_monitor_->getStateMonitor()->waitForCompleteState(params.move_group_name,
+                                                                          ROBOT_STATE_WAIT_TIME))
+    {
+      RCLCPP_ERROR_STREAM(LOGGER, "Timeout waiting for current state of group `" << params.move_group_name << '`');
+      return;
+    }
+  }
+
+  // Crunch the numbers of each group in its own loop
+  for (std::unique_ptr<ServoCalcs>& servo_calcs : servo_calcs_)
+    servo_calcs->start();
+
+  // Check collisions of all groups in one timer
+  if (collision_checker_)
+    collision_checker_->start();
+}
+
+void MultiGroupServo::stop()
+{
+  for (std::unique_ptr<ServoCalcs>& servo_calcs : servo_calcs_)
+    servo_calcs->stop();
+  if (collision_checker_)
+    collision_checker_->stop();
+}
+
+bool MultiGroupServo::getCommandFrameTransform(std::size_t group_index, Eigen::Isometry3d& transform)
+{
+  return servo_calcs_.at(group_index)->getCommandFrameTransform(transform);
+}
+
+bool MultiGroupServo::getCommandFrameTransform(std::size_t group_index, geometry_msgs::msg::TransformStamped& transform)
+{
+  return servo_calcs_.at(group_index)->getCommandFrameTransform(transform);
+}
+
+bool MultiGroupServo::getEEFrameTransform(std::size_t group_index, Eigen::Isometry3d& transform)
+{
+  return servo_calcs_.at(group_index)->getEEFrameTransform(transform);
+}
+
+bool MultiGroupServo::getEEFrameTransform(std::size_t group_index, geometry_msgs::msg::TransformStamped& transform)
+{
+  return servo_calcs_.at(group_index)->getEEFrameTransform(transform);
+}
 }  // namespace moveit_servo
@@ -74,7 +74,8 @@ int const THREAD_PRIORITY = 40;
 // Constructor for the class that handles servoing calculations
 ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
                        const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
-                       std::unique_ptr<const servo::ParamListener> servo_param_listener)
+                       std::unique_ptr<const servo::ParamListener> servo_param_listener,
+                       const std::string& group_namespace)
   : node_(node)
   , servo_param_listener_(std::move(servo_param_listener))
   , servo_params_(servo_param_listener_->get_params())
@@ -103,7 +104,7 @@ ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
 
   // ROS Server for allowing drift in some dimensions
   drift_dimensions_server_ = node_->create_service<moveit_msgs::srv::ChangeDriftDimensions>(
-      "~/change_drift_dimensions",
+      servoInterfaceName(group_namespace, "change_drift_dimensions"),
       [this](const std::shared_ptr<moveit_msgs::srv::ChangeDriftDimensions::Request>& req,
              const std::shared_ptr<moveit_msgs::srv::ChangeDriftDimensions::Response>& res) {
         return changeDriftDimensions(req, res);
@@ -111,7 +112,7 @@ ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
 
   // ROS Server for changing the control dimensions
   control_dimensions_server_ = node_->create_service<moveit_msgs::srv::ChangeControlDimensions>(
-      "~/change_control_dimensions",
+      servoInterfaceName(group_namespace, "change_control_dimensions"),
       [this](const std::shared_ptr<moveit_msgs::srv::ChangeControlDimensions::Request>& req,
              const std::shared_ptr<moveit_msgs::srv::ChangeControlDimensions::Response>& res) {
         return changeControlDimensions(req, res);
@@ -119,7 +120,7 @@ ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
 
   // Subscribe to the collision_check topic
   collision_velocity_scale_sub_ = node_->create_subscription<std_msgs::msg::Float64>(
-      "~/collision_velocity_scale", rclcpp::SystemDefaultsQoS(),
+      servoInterfaceName(group_namespace, "collision_velocity_scale"), rclcpp::SystemDefaultsQoS(),
       [this](const std_msgs::msg::Float64::ConstSharedPtr& msg) { return collisionVelocityScaleCB(msg); });
 
   // Publish freshly-calculated joints to the robot.
@@ -138,6 +139,13 @@ ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
   // Publish status
   status_pub_ = node_->create_publisher<std_msgs::msg::Int8>(servo_params_.status_topic, rclcpp::SystemDefaultsQoS());
 
+  // Publish the loop latency histogram, if requested
+  if (!servo_params_.latency_histogram_topic.empty())
+  {
+    latency_histogram_pub_ = node_->create_publisher<std_msgs::msg::UInt64MultiArray>(
+        servo_params_.latency_histogram_topic, rclcpp::SystemDefaultsQoS());
+  }
+
   current_joint_state_.name = joint_model_group_->getActiveJointModelNames();
   num_joints_ = current_joint_state_.name.size();
   current_joint_state_.position.resize(num_joints_);
@@ -150,6 +158,25 @@ ServoCalcs::ServoCalcs(const rclcpp::Node::SharedPtr& node,
     joint_state_name_map_[current_joint_state_.name[i]] = i;
   }
 
+  if (!servo_params_.command_out_shared_memory.empty())
+  {
+    shared_memory_command_writer_ = std::make_unique<SharedMemoryCommandWriter>(
+        servo_params_.command_out_shared_memory, current_joint_state_.name);
+    RCLCPP_INFO_STREAM(LOGGER, "Writing commands to shared memory " << servo_params_.command_out_shared_memory);
+  }
+
+  if (!servo_params_.joint_state_shared_memory.empty())
+  {
+    shared_state_reader_ = planning_scene_monitor::SharedStateReader::open(servo_params_.joint_state_shared_memory,
+                                                                          planning_scene_monitor_->getRobotModel());
+    if (shared_state_reader_)
+      RCLCPP_INFO_STREAM(LOGGER, "Reading the current state from shared memory "
+                                     << servo_params_.joint_state_shared_memory);
+    else
+      RCLCPP_WARN_STREAM(LOGGER, "Unable to read the current state from shared memory "
+                                     << servo_params_.joint_state_shared_memory << ", using the state monitor instead");
+  }
+
   // Load the smoothing plugin
   try
   {
@@ -236,6 +263,16 @@ void ServoCalcs::start()
   current_state_->copyJointGroupVelocities(joint_model_group_, current_joint_state_.velocity);
   // set previous state to same as current state for t = 0
   previous_joint_state_ = current_joint_state_;
+  next_joint_state_ = current_joint_state_;
+
+  // Preallocate the outgoing messages so the main loop only refills them
+  joint_trajectory_ = *last_sent_command_;
+  joint_trajectory_.points.reserve(servo_params_.use_gazebo ? gazebo_redundant_message_count_ : 1);
+  multiarray_msg_.data.reserve(num_joints_);
+
+  // Ten buckets per publish period up to two periods, then one overflow bucket
+  latency_histogram_.data.assign(21, 0);
+  latency_histogram_cycles_ = 0;
 
   // Check that all links are known to the robot
   auto check_link_is_known = [this](const std::string& frame_name) {
@@ -248,10 +285,13 @@ void ServoCalcs::start()
   check_link_is_known(servo_params_.ee_frame_name);
   check_link_is_known(servo_params_.robot_link_command_frame);
 
-  tf_moveit_to_ee_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
-                           current_state_->getGlobalLinkTransform(servo_params_.ee_frame_name);
-  tf_moveit_to_robot_cmd_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
-                                  current_state_->getGlobalLinkTransform(servo_params_.robot_link_command_frame);
+  {
+    const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
+    tf_moveit_to_ee_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
+                             current_state_->getGlobalLinkTransform(servo_params_.ee_frame_name);
+    tf_moveit_to_robot_cmd_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
+                                    current_state_->getGlobalLinkTransform(servo_params_.robot_link_command_frame);
+  }
 
   stop_requested_ = false;
   thread_ = std::thread([this] {
@@ -281,7 +321,7 @@ void ServoCalcs::stop()
   {
     // scope so the mutex is unlocked after so the thread can continue
     // and therefore be joinable
-    const std::lock_guard<std::mutex> lock(main_loop_mutex_);
+    const std::lock_guard<std::mutex> lock(input_mutex_);
     new_input_cmd_ = false;
     input_cv_.notify_all();
   }
@@ -320,6 +360,8 @@ void ServoCalcs::updateParams()
         params.robot_link_command_frame = servo_params_.robot_link_command_frame;
       }
     }
+    // the frame names are read along with the frame transforms
+    const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
     servo_params_ = params;
   }
 }
@@ -330,7 +372,14 @@ void ServoCalcs::mainCalcLoop()
 
   while (rclcpp::ok() && !stop_requested_)
   {
-    // lock the input state mutex
+    // low latency mode -- begin calculations as soon as a new command is received.
+    if (servo_params_.low_latency_mode)
+    {
+      std::unique_lock<std::mutex> input_lock(input_mutex_);
+      input_cv_.wait(input_lock, [this] { return (new_input_cmd_ || stop_requested_); });
+    }
+
+    // lock the internal state mutex
     std::unique_lock<std::mutex> main_loop_lock(main_loop_mutex_);
 
     // Check if any parameters changed
@@ -339,12 +388,6 @@ void ServoCalcs::mainCalcLoop()
       updateParams();
     }
 
-    // low latency mode -- begin calculations as soon as a new command is received.
-    if (servo_params_.low_latency_mode)
-    {
-      input_cv_.wait(main_loop_lock, [this] { return (new_input_cmd_ || stop_requested_); });
-    }
-
     // reset new_input_cmd_ flag
     new_input_cmd_ = false;
 
@@ -361,6 +404,7 @@ void ServoCalcs::mainCalcLoop()
                                   "run_duration: " << run_duration.seconds() << " (" << servo_params_.publish_period
                                                    << ')');
     }
+    recordLatency(run_duration);
 
     // normal mode, unlock input mutex and wait for the period of the loop
     if (!servo_params_.low_latency_mode)
@@ -374,9 +418,8 @@ void ServoCalcs::mainCalcLoop()
 void ServoCalcs::calculateSingleIteration()
 {
   // Publish status each loop iteration
-  auto status_msg = std::make_unique<std_msgs::msg::Int8>();
-  status_msg->data = static_cast<int8_t>(status_);
-  status_pub_->publish(std::move(status_msg));
+  status_msg_.data = static_cast<int8_t>(status_);
+  status_pub_->publish(status_msg_);
 
   // After we publish, status, reset it back to no warnings
   status_ = StatusCode::NO_WARNING;
@@ -384,8 +427,9 @@ void ServoCalcs::calculateSingleIteration()
   // Always update the joints and end-effector transform for 2 reasons:
   // 1) in case the getCommandFrameTransform() method is being used
   // 2) so the low-pass filters are up to date and don't cause a jump
-  // Get the latest joint group positions
-  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
+  // Get the latest joint group positions, updating the state allocated in start() in place
+  if (!shared_state_reader_ || !shared_state_reader_->read(*current_state_))
+    planning_scene_monitor_->getStateMonitor()->setToCurrentState(*current_state_);
   current_state_->copyJointGroupPositions(joint_model_group_, current_joint_state_.position);
   current_state_->copyJointGroupVelocities(joint_model_group_, current_joint_state_.velocity);
 
@@ -394,28 +438,41 @@ void ServoCalcs::calculateSingleIteration()
   // All computations related to computing state q(t + dt) acts only on next_joint_state_ variable.
   next_joint_state_ = current_joint_state_;
 
-  if (latest_twist_stamped_)
-    twist_stamped_cmd_ = *latest_twist_stamped_;
-  if (latest_joint_cmd_)
-    joint_servo_cmd_ = *latest_joint_cmd_;
+  // Take the latest commands handed over by the subscriber callbacks
+  if (const auto latest_twist_stamped = std::atomic_load(&latest_twist_stamped_))
+    twist_stamped_cmd_ = *latest_twist_stamped;
+  if (const auto latest_joint_cmd = std::atomic_load(&latest_joint_cmd_))
+    joint_servo_cmd_ = *latest_joint_cmd;
 
   // Check for stale cmds
-  twist_command_is_stale_ = ((node_->now() - latest_twist_command_stamp_) >=
-                             rclcpp::Duration::from_seconds(servo_params_.incoming_command_timeout));
-  joint_command_is_stale_ = ((node_->now() - latest_joint_command_stamp_) >=
-                             rclcpp::Duration::from_seconds(servo_params_.incoming_command_timeout));
-
-  // Get the transform from MoveIt planning frame to servoing command frame
-  // Calculate this transform to ensure it is available via C++ API
-  // We solve (planning_frame -> base -> robot_link_command_frame)
-  // by computing (base->planning_frame)^-1 * (base->robot_link_command_frame)
-  tf_moveit_to_robot_cmd_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
-                                  current_state_->getGlobalLinkTransform(servo_params_.robot_link_command_frame);
-
-  // Calculate the transform from MoveIt planning frame to End Effector frame
-  // Calculate this transform to ensure it is available via C++ API
-  tf_moveit_to_ee_frame_ = current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse() *
-                           current_state_->getGlobalLinkTransform(servo_params_.ee_frame_name);
+  const rclcpp::Time now = node_->now();
+  const rclcpp::Duration incoming_command_timeout =
+      rclcpp::Duration::from_seconds(servo_params_.incoming_command_timeout);
+  twist_command_is_stale_ =
+      ((now - rclcpp::Time(latest_twist_command_stamp_ns_.load(), RCL_ROS_TIME)) >= incoming_command_timeout);
+  joint_command_is_stale_ =
+      ((now - rclcpp::Time(latest_joint_command_stamp_ns_.load(), RCL_ROS_TIME)) >= incoming_command_timeout);
+
+  {
+    // The C++ API reads the frame transforms under their own mutex, so it does not wait for this iteration
+    const Eigen::Isometry3d tf_planning_frame_inverse =
+        current_state_->getGlobalLinkTransform(servo_params_.planning_frame).inverse();
+    const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
+
+    // Get the transform from MoveIt planning frame to servoing command frame
+    // Calculate this transform to ensure it is available via C++ API
+    // We solve (planning_frame -> base -> robot_link_command_frame)
+    // by computing (base->planning_frame)^-1 * (base->robot_link_command_frame)
+    tf_moveit_to_robot_cmd_frame_ =
+        tf_planning_frame_inverse * current_state_->getGlobalLinkTransform(servo_params_.robot_link_command_frame);
+
+    // Calculate the transform from MoveIt planning frame to End Effector frame
+    // Calculate this transform to ensure it is available via C++ API
+    tf_moveit_to_ee_frame_ =
+        tf_planning_frame_inverse * current_state_->getGlobalLinkTransform(servo_params_.ee_frame_name);
+    ++frame_transforms_update_count_;
+  }
+  frame_transforms_cv_.notify_all();
 
   // Don't end this function without updating the filters
   updated_filters_ = false;
@@ -436,14 +493,14 @@ void ServoCalcs::calculateSingleIteration()
 
   // If not waiting for initial command,
   // Do servoing calculations only if the robot should move, for efficiency
-  // Create new outgoing joint trajectory command message
-  auto joint_trajectory = std::make_unique<trajectory_msgs::msg::JointTrajectory>();
+  // Refill the preallocated outgoing joint trajectory command message
+  trajectory_msgs::msg::JointTrajectory& joint_trajectory = joint_trajectory_;
 
   // Prioritize cartesian servoing above joint servoing
   // Only run commands if not stale
   if (!twist_command_is_stale_)
   {
-    if (!cartesianServoCalcs(twist_stamped_cmd_, *joint_trajectory))
+    if (!cartesianServoCalcs(twist_stamped_cmd_, joint_trajectory))
     {
       resetLowPassFilters(current_joint_state_);
       return;
@@ -451,7 +508,7 @@ void ServoCalcs::calculateSingleIteration()
   }
   else if (!joint_command_is_stale_)
   {
-    if (!jointServoCalcs(joint_servo_cmd_, *joint_trajectory))
+    if (!jointServoCalcs(joint_servo_cmd_, joint_trajectory))
     {
       resetLowPassFilters(current_joint_state_);
       return;
@@ -464,22 +521,22 @@ void ServoCalcs::calculateSingleIteration()
     rclcpp::Clock& clock = *node_->get_clock();
     RCLCPP_DEBUG_STREAM_THROTTLE(LOGGER, clock, ROS_LOG_THROTTLE_PERIOD,
                                  "Skipping publishing because incoming commands are stale.");
-    filteredHalt(*joint_trajectory);
+    filteredHalt(joint_trajectory);
   }
 
   // Clear out position commands if user did not request them (can cause interpolation issues)
   if (!servo_params_.publish_joint_positions)
   {
-    joint_trajectory->points[0].positions.clear();
+    joint_trajectory.points[0].positions.clear();
   }
   // Likewise for velocity and acceleration
   if (!servo_params_.publish_joint_velocities)
   {
-    joint_trajectory->points[0].velocities.clear();
+    joint_trajectory.points[0].velocities.clear();
   }
   if (!servo_params_.publish_joint_accelerations)
   {
-    joint_trajectory->points[0].accelerations.clear();
+    joint_trajectory.points[0].accelerations.clear();
   }
 
   // Put the outgoing msg in the right format
@@ -488,23 +545,30 @@ void ServoCalcs::calculateSingleIteration()
   {
     // When a joint_trajectory_controller receives a new command, a stamp of 0 indicates "begin immediately"
     // See http://wiki.ros.org/joint_trajectory_controller#Trajectory_replacement
-    joint_trajectory->header.stamp = rclcpp::Time(0);
-    *last_sent_command_ = *joint_trajectory;
-    trajectory_outgoing_cmd_pub_->publish(std::move(joint_trajectory));
+    joint_trajectory.header.stamp = rclcpp::Time(0);
+    *last_sent_command_ = joint_trajectory;
+    trajectory_outgoing_cmd_pub_->publish(joint_trajectory);
   }
   else if (servo_params_.command_out_type == "std_msgs/Float64MultiArray")
   {
-    auto joints = std::make_unique<std_msgs::msg::Float64MultiArray>();
-    if (servo_params_.publish_joint_positions && !joint_trajectory->points.empty())
+    if (servo_params_.publish_joint_positions && !joint_trajectory.points.empty())
     {
-      joints->data = joint_trajectory->points[0].positions;
+      multiarray_msg_.data = joint_trajectory.points[0].positions;
     }
-    else if (servo_params_.publish_joint_velocities && !joint_trajectory->points.empty())
+    else if (servo_params_.publish_joint_velocities && !joint_trajectory.points.empty())
     {
-      joints->data = joint_trajectory->points[0].velocities;
+      multiarray_msg_.data = joint_trajectory.points[0].velocities;
     }
-    *last_sent_command_ = *joint_trajectory;
-    multiarray_outgoing_cmd_pub_->publish(std::move(joints));
+    *last_sent_command_ = joint_trajectory;
+    multiarray_outgoing_cmd_pub_->publish(multiarray_msg_);
+  }
+
+  if (shared_memory_command_writer_ && !joint_trajectory.points.empty())
+  {
+    const trajectory_msgs::msg::JointTrajectoryPoint& point = joint_trajectory.points[0];
+    const auto stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+    shared_memory_command_writer_->write(stamp.count(), point.positions, point.velocities, point.accelerations);
   }
 
   // Update the filters if we haven't yet
@@ -531,14 +595,14 @@ bool ServoCalcs::cartesianServoCalcs(geometry_msgs::msg::TwistStamped& cmd,
 
   Eigen::VectorXd delta_x = scaleCartesianCommand(cmd);
 
-  Eigen::MatrixXd jacobian = current_state_->getJacobian(joint_model_group_);
+  const moveit::core::LinkModel* tip_link = joint_model_group_->getLinkModels().back();
+  current_state_->getJacobian(joint_model_group_, tip_link, Eigen::Vector3d::Zero(), jacobian_);
 
-  removeDriftDimensions(jacobian, delta_x);
+  removeDriftDimensions(jacobian_, delta_x);
 
-  Eigen::JacobiSVD<Eigen::MatrixXd> svd =
-      Eigen::JacobiSVD<Eigen::MatrixXd>(jacobian, Eigen::ComputeThinU | Eigen::ComputeThinV);
-  Eigen::MatrixXd matrix_s = svd.singularValues().asDiagonal();
-  Eigen::MatrixXd pseudo_inverse = svd.matrixV() * matrix_s.inverse() * svd.matrixU().transpose();
+  svd_.compute(jacobian_, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  pseudo_inverse_.noalias() =
+      svd_.matrixV() * svd_.singularValues().cwiseInverse().asDiagonal() * svd_.matrixU().transpose();
 
   // Convert from cartesian commands to joint commands
   // Use an IK solver plugin if we have one, otherwise use inverse Jacobian.
@@ -573,14 +637,37 @@ bool ServoCalcs::cartesianServoCalcs(geometry_msgs::msg::TwistStamped& cmd,
   else
   {
     // no supported IK plugin, use inverse Jacobian
-    delta_theta_ = pseudo_inverse * delta_x;
+    delta_theta_ = pseudo_inverse_ * delta_x;
   }
 
-  delta_theta_ *= velocityScalingFactorForSingularity(joint_model_group_, delta_x, svd, pseudo_inverse,
-                                                      servo_params_.hard_stop_singularity_threshold,
-                                                      servo_params_.lower_singularity_threshold,
-                                                      servo_params_.leaving_singularity_threshold_multiplier,
-                                                      *node_->get_clock(), current_state_, status_);
+  if (servo_params_.singularity_direction_from_jacobian_derivative)
+  {
+    // The change of the Jacobian for the joint motion along the last singular vector is computed like a time
+    // derivative, with that motion as joint velocities. The velocities of the state are restored afterwards.
+    current_state_->copyJointGroupVelocities(joint_model_group_, joint_velocities_);
+    current_state_->setJointGroupVelocities(joint_model_group_,
+                                            pseudo_inverse_ * svd_.matrixU().col(delta_x.size() - 1));
+    current_state_->getJacobian(joint_model_group_, tip_link, Eigen::Vector3d::Zero(), jacobian_,
+                                jacobian_derivative_);
+    current_state_->setJointGroupVelocities(joint_model_group_, joint_velocities_);
+
+    Eigen::VectorXd unused_delta_x = Eigen::VectorXd::Zero(jacobian_derivative_.rows());
+    removeDriftDimensions(jacobian_derivative_, unused_delta_x);
+
+    delta_theta_ *= velocityScalingFactorForSingularity(delta_x, svd_, jacobian_derivative_,
+                                                        servo_params_.hard_stop_singularity_threshold,
+                                                        servo_params_.lower_singularity_threshold,
+                                                        servo_params_.leaving_singularity_threshold_multiplier,
+                                                        *node_->get_clock(), status_);
+  }
+  else
+  {
+    delta_theta_ *= velocityScalingFactorForSingularity(joint_model_group_, delta_x, svd_, pseudo_inverse_,
+                                                        servo_params_.hard_stop_singularity_threshold,
+                                                        servo_params_.lower_singularity_threshold,
+                                                        servo_params_.leaving_singularity_threshold_multiplier,
+                                                        *node_->get_clock(), current_state_, status_);
+  }
 
   return internalServoUpdate(delta_theta_, joint_trajectory, ServoType::CARTESIAN_SPACE);
 }
@@ -700,7 +787,9 @@ void ServoCalcs::composeJointTrajMessage(const sensor_msgs::msg::JointState& joi
   joint_trajectory.header.frame_id = servo_params_.planning_frame;
   joint_trajectory.joint_names = joint_state.name;
 
-  trajectory_msgs::msg::JointTrajectoryPoint point;
+  // Reuse the point and its vectors from the previous iteration instead of allocating new ones
+  joint_trajectory.points.resize(1);
+  trajectory_msgs::msg::JointTrajectoryPoint& point = joint_trajectory.points[0];
   point.time_from_start = rclcpp::Duration::from_seconds(servo_params_.publish_period);
   if (servo_params_.publish_joint_positions)
     point.positions = joint_state.position;
@@ -711,10 +800,8 @@ void ServoCalcs::composeJointTrajMessage(const sensor_msgs::msg::JointState& joi
     // I do not know of a robot that takes acceleration commands.
     // However, some controllers check that this data is non-empty.
     // Send all zeros, for now.
-    std::vector<double> acceleration(num_joints_);
-    point.accelerations = acceleration;
+    point.accelerations.assign(num_joints_, 0.0);
   }
-  joint_trajectory.points.push_back(point);
 }
 
 std::vector<const moveit::core::JointModel*>
@@ -773,8 +860,7 @@ ServoCalcs::enforcePositionLimits(sensor_msgs::msg::JointState& joint_state) con
 void ServoCalcs::filteredHalt(trajectory_msgs::msg::JointTrajectory& joint_trajectory)
 {
   // Prepare the joint trajectory message to stop the robot
-  joint_trajectory.points.clear();
-  joint_trajectory.points.emplace_back();
+  joint_trajectory.points.resize(1);
   joint_trajectory.joint_names = joint_model_group_->getActiveJointModelNames();
 
   // Deceleration algorithm:
@@ -788,7 +874,7 @@ void ServoCalcs::filteredHalt(trajectory_msgs::msg::JointTrajectory& joint_traje
   bool done_stopping = true;
   if (servo_params_.publish_joint_velocities)
   {
-    joint_trajectory.points[0].velocities = std::vector<double>(num_joints_, 0);
+    joint_trajectory.points[0].velocities.assign(num_joints_, 0.0);
     for (std::size_t i = 0; i < num_joints_; ++i)
     {
       joint_trajectory.points[0].velocities.at(i) =
@@ -809,7 +895,7 @@ void ServoCalcs::filteredHalt(trajectory_msgs::msg::JointTrajectory& joint_traje
 
   if (servo_params_.publish_joint_accelerations)
   {
-    joint_trajectory.points[0].accelerations = std::vector<double>(num_joints_, 0);
+    joint_trajectory.points[0].accelerations.assign(num_joints_, 0.0);
     for (std::size_t i = 0; i < num_joints_; ++i)
     {
       joint_trajectory.points[0].accelerations.at(i) =
@@ -821,6 +907,24 @@ void ServoCalcs::filteredHalt(trajectory_msgs::msg::JointTrajectory& joint_traje
   joint_trajectory.points[0].time_from_start = rclcpp::Duration::from_seconds(servo_params_.publish_period);
 }
 
+void ServoCalcs::recordLatency(const rclcpp::Duration& run_duration)
+{
+  if (!latency_histogram_pub_)
+    return;
+
+  // Bucket width is a tenth of the publish period; everything past two periods lands in the last bucket
+  const auto bucket =
+      static_cast<std::size_t>(std::max(0.0, run_duration.seconds()) * 10.0 / servo_params_.publish_period);
+  ++latency_histogram_.data[std::min(bucket, latency_histogram_.data.size() - 1)];
+
+  // Publish the cumulative counts about once a second
+  if (++latency_histogram_cycles_ * servo_params_.publish_period >= 1.0)
+  {
+    latency_histogram_cycles_ = 0;
+    latency_histogram_pub_->publish(latency_histogram_);
+  }
+}
+
 void ServoCalcs::suddenHalt(sensor_msgs::msg::JointState& joint_state,
                             const std::vector<const moveit::core::JointModel*>& joints_to_halt) const
 {
@@ -1012,7 +1116,7 @@ void ServoCalcs::enforceControlDimensions(geometry_msgs::msg::TwistStamped& comm
 
 bool ServoCalcs::getCommandFrameTransform(Eigen::Isometry3d& transform)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
+  const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
   transform = tf_moveit_to_robot_cmd_frame_;
 
   // All zeros means the transform wasn't initialized, so return false
@@ -1021,7 +1125,7 @@ bool ServoCalcs::getCommandFrameTransform(Eigen::Isometry3d& transform)
 
 bool ServoCalcs::getCommandFrameTransform(geometry_msgs::msg::TransformStamped& transform)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
+  const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
   // All zeros means the transform wasn't initialized, so return false
   if (tf_moveit_to_robot_cmd_frame_.matrix().isZero(0))
   {
@@ -1035,7 +1139,7 @@ bool ServoCalcs::getCommandFrameTransform(geometry_msgs::msg::TransformStamped&
 
 bool ServoCalcs::getEEFrameTransform(Eigen::Isometry3d& transform)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
+  const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
   transform = tf_moveit_to_ee_frame_;
 
   // All zeros means the transform wasn't initialized, so return false
@@ -1044,7 +1148,7 @@ bool ServoCalcs::getEEFrameTransform(Eigen::Isometry3d& transform)
 
 bool ServoCalcs::getEEFrameTransform(geometry_msgs::msg::TransformStamped& transform)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
+  const std::lock_guard<std::mutex> lock(frame_transforms_mutex_);
   // All zeros means the transform wasn't initialized, so return false
   if (tf_moveit_to_ee_frame_.matrix().isZero(0))
   {
@@ -1056,29 +1160,41 @@ bool ServoCalcs::getEEFrameTransform(geometry_msgs::msg::TransformStamped& trans
   return true;
 }
 
+bool ServoCalcs::waitForFrameTransformUpdate(const std::chrono::duration<double>& timeout)
+{
+  std::unique_lock<std::mutex> lock(frame_transforms_mutex_);
+  const uint64_t update_count = frame_transforms_update_count_;
+  return frame_transforms_cv_.wait_for(lock, timeout,
+                                       [this, update_count] { return frame_transforms_update_count_ != update_count; });
+}
+
 void ServoCalcs::twistStampedCB(const geometry_msgs::msg::TwistStamped::ConstSharedPtr& msg)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
-  latest_twist_stamped_ = msg;
+  std::atomic_store(&latest_twist_stamped_, msg);
 
   if (msg->header.stamp != rclcpp::Time(0.))
-    latest_twist_command_stamp_ = msg->header.stamp;
+    latest_twist_command_stamp_ns_ = rclcpp::Time(msg->header.stamp, RCL_ROS_TIME).nanoseconds();
 
   // notify that we have a new input
-  new_input_cmd_ = true;
+  {
+    const std::lock_guard<std::mutex> lock(input_mutex_);
+    new_input_cmd_ = true;
+  }
   input_cv_.notify_all();
 }
 
 void ServoCalcs::jointCmdCB(const control_msgs::msg::JointJog::ConstSharedPtr& msg)
 {
-  const std::lock_guard<std::mutex> lock(main_loop_mutex_);
-  latest_joint_cmd_ = msg;
+  std::atomic_store(&latest_joint_cmd_, msg);
 
   if (msg->header.stamp != rclcpp::Time(0.))
-    latest_joint_command_stamp_ = msg->header.stamp;
+    latest_joint_command_stamp_ns_ = rclcpp::Time(msg->header.stamp, RCL_ROS_TIME).nanoseconds();
 
   // notify that we have a new input
-  new_input_cmd_ = true;
+  {
+    const std::lock_guard<std::mutex> lock(input_mutex_);
+    new_input_cmd_ = true;
+  }
   input_cv_.notify_all();
 }
 
@@ -0,0 +1,229 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/*      Title     : shared_memory_command.cpp
+ *      Project   : moveit_servo
+ *      Created   : 10/15/2026
+ */
+
+#include <moveit_servo/shared_memory_command.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace moveit_servo
+{
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+              "shared memory commands need lock-free atomics");
+
+namespace
+{
+void writeValues(const std::vector<double>& values, std::size_t count, std::atomic<double>* target)
+{
+  for (std::size_t i = 0; i < std::min(values.size(), count); ++i)
+    target[i].store(values[i], std::memory_order_relaxed);
+}
+
+void readValues(bool is_set, const std::atomic<double>* source, std::size_t count, std::vector<double>& values)
+{
+  values.resize(is_set ? count : 0);
+  for (std::size_t i = 0; i < values.size(); ++i)
+    values[i] = source[i].load(std::memory_order_relaxed);
+}
+}  // namespace
+
+SharedMemoryCommandWriter::SharedMemoryCommandWriter(const std::string& name,
+                                                     const std::vector<std::string>& joint_names)
+  : name_(name)
+{
+  if (joint_names.size() > SharedMemoryCommandSegment::MAX_JOINTS)
+    throw std::runtime_error("Too many joints for a shared memory command");
+  for (const std::string& joint_name : joint_names)
+  {
+    if (joint_name.size() >= SharedMemoryCommandSegment::MAX_JOINT_NAME_LENGTH)
+      throw std::runtime_error("Joint name too long for a shared memory command: " + joint_name);
+  }
+
+  // a reader of a previous segment keeps its mapping, so start from a new segment rather than reusing it
+  shm_unlink(name_.c_str());
+  const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    throw std::runtime_error("Failed to create shared memory segment " + name_ + ": " + std::strerror(errno));
+  if (ftruncate(fd, sizeof(SharedMemoryCommandSegment)) != 0)
+  {
+    const int error = errno;
+    ::close(fd);
+    shm_unlink(name_.c_str());
+    throw std::runtime_error("Failed to size shared memory segment " + name_ + ": " + std::strerror(error));
+  }
+  void* memory = mmap(nullptr, sizeof(SharedMemoryCommandSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED)
+  {
+    shm_unlink(name_.c_str());
+    throw std::runtime_error("Failed to map shared memory segment " + name_);
+  }
+
+  // the new segment is zero-filled, so readers that map it now see no writer until magic is set
+  segment_ = new (memory) SharedMemoryCommandSegment();
+  segment_->version = SharedMemoryCommandSegment::VERSION;
+  segment_->num_joints = static_cast<std::uint32_t>(joint_names.size());
+  for (std::size_t i = 0; i < joint_names.size(); ++i)
+    std::strncpy(segment_->joint_names[i], joint_names[i].c_str(), SharedMemoryCommandSegment::MAX_JOINT_NAME_LENGTH);
+  segment_->magic.store(SharedMemoryCommandSegment::MAGIC, std::memory_order_release);
+}
+
+SharedMemoryCommandWriter::~SharedMemoryCommandWriter()
+{
+  segment_->magic.store(0, std::memory_order_release);
+  munmap(segment_, sizeof(SharedMemoryCommandSegment));
+  shm_unlink(name_.c_str());
+}
+
+void SharedMemoryCommandWriter::write(std::int64_t stamp, const std::vector<double>& positions,
+                                      const std::vector<double>& velocities, const std::vector<double>& accelerations)
+{
+  std::uint32_t fields = 0;
+  if (!positions.empty())
+    fields |= SharedMemoryCommand::POSITIONS;
+  if (!velocities.empty())
+    fields |= SharedMemoryCommand::VELOCITIES;
+  if (!accelerations.empty())
+    fields |= SharedMemoryCommand::ACCELERATIONS;
+
+  // odd while writing, see SharedMemoryCommandSegment
+  const std::uint64_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+  segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  segment_->fields.store(fields, std::memory_order_relaxed);
+  segment_->stamp.store(stamp, std::memory_order_relaxed);
+  writeValues(positions, segment_->num_joints, segment_->positions);
+  writeValues(velocities, segment_->num_joints, segment_->velocities);
+  writeValues(accelerations, segment_->num_joints, segment_->accelerations);
+
+  segment_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+SharedMemoryCommandReader::~SharedMemoryCommandReader()
+{
+  close();
+}
+
+bool SharedMemoryCommandReader::open(const std::string& name)
+{
+  close();
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  void* memory = mmap(nullptr, sizeof(SharedMemoryCommandSegment), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED)
+    return false;
+
+  auto* segment = static_cast<SharedMemoryCommandSegment*>(memory);
+  if (segment->magic.load(std::memory_order_acquire) != SharedMemoryCommandSegment::MAGIC ||
+      segment->version != SharedMemoryCommandSegment::VERSION ||
+      segment->num_joints > SharedMemoryCommandSegment::MAX_JOINTS)
+  {
+    munmap(memory, sizeof(SharedMemoryCommandSegment));
+    return false;
+  }
+
+  segment_ = segment;
+  joint_names_.clear();
+  for (std::size_t i = 0; i < segment_->num_joints; ++i)
+  {
+    joint_names_.emplace_back(segment_->joint_names[i],
+                              strnlen(segment_->joint_names[i], SharedMemoryCommandSegment::MAX_JOINT_NAME_LENGTH));
+  }
+  last_sequence_ = 0;
+  missed_count_ = 0;
+  return true;
+}
+
+void SharedMemoryCommandReader::close()
+{
+  if (!segment_)
+    return;
+  munmap(segment_, sizeof(SharedMemoryCommandSegment));
+  segment_ = nullptr;
+  joint_names_.clear();
+}
+
+bool SharedMemoryCommandReader::isWriterAlive() const
+{
+  return segment_ && segment_->magic.load(std::memory_order_acquire) == SharedMemoryCommandSegment::MAGIC;
+}
+
+bool SharedMemoryCommandReader::read(SharedMemoryCommand& command)
+{
+  if (!isWriterAlive())
+    return false;
+
+  const std::uint64_t sequence = segment_->sequence.load(std::memory_order_acquire);
+  if ((sequence & 1) || sequence == last_sequence_)
+    return false;
+
+  // read into a buffer of its own, so that command stays unchanged if the command turns out to be torn
+  const std::uint32_t fields = segment_->fields.load(std::memory_order_relaxed);
+  const std::int64_t stamp = segment_->stamp.load(std::memory_order_relaxed);
+  const std::size_t num_joints = joint_names_.size();
+  readValues(fields & SharedMemoryCommand::POSITIONS, segment_->positions, num_joints, buffer_.positions);
+  readValues(fields & SharedMemoryCommand::VELOCITIES, segment_->velocities, num_joints, buffer_.velocities);
+  readValues(fields & SharedMemoryCommand::ACCELERATIONS, segment_->accelerations, num_joints, buffer_.accelerations);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (segment_->sequence.load(std::memory_order_relaxed) != sequence)
+    return false;
+
+  buffer_.fields = fields;
+  buffer_.stamp = stamp;
+  buffer_.sequence = sequence / 2;
+  // swapping keeps the memory of both commands, so repeated reads do not allocate
+  std::swap(buffer_, command);
+  if (last_sequence_ != 0)
+    missed_count_ += (sequence - last_sequence_) / 2 - 1;
+  last_sequence_ = sequence;
+  return true;
+}
+}  // namespace moveit_servo
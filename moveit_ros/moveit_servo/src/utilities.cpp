@@ -44,8 +44,51 @@ namespace
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_servo.utilities");
 constexpr auto ROS_LOG_THROTTLE_PERIOD = std::chrono::milliseconds(3000).count();
+
+// Scale the velocity given the condition number of the Jacobian and the singular vector pointing toward the
+// nearest singularity
+double velocityScalingFactorForCondition(const double ini_condition, const Eigen::VectorXd& vector_toward_singularity,
+                                         const Eigen::VectorXd& commanded_twist,
+                                         const double hard_stop_singularity_threshold,
+                                         const double lower_singularity_threshold,
+                                         const double leaving_singularity_threshold_multiplier, rclcpp::Clock& clock,
+                                         StatusCode& status)
+{
+  double velocity_scale = 1;
+
+  // If this dot product is positive, we're moving toward singularity
+  double dot = vector_toward_singularity.dot(commanded_twist);
+  // see https://github.com/ros-planning/moveit2/pull/620#issuecomment-1201418258 for visual explanation of algorithm
+  double upper_threshold = dot > 0 ? hard_stop_singularity_threshold :
+                                     (hard_stop_singularity_threshold - lower_singularity_threshold) *
+                                             leaving_singularity_threshold_multiplier +
+                                         lower_singularity_threshold;
+  if ((ini_condition > lower_singularity_threshold) && (ini_condition < hard_stop_singularity_threshold))
+  {
+    velocity_scale =
+        1. - (ini_condition - lower_singularity_threshold) / (upper_threshold - lower_singularity_threshold);
+    status =
+        dot > 0 ? StatusCode::DECELERATE_FOR_APPROACHING_SINGULARITY : StatusCode::DECELERATE_FOR_LEAVING_SINGULARITY;
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, clock, ROS_LOG_THROTTLE_PERIOD, SERVO_STATUS_CODE_MAP.at(status));
+  }
+
+  // Very close to singularity, so halt.
+  else if (ini_condition >= upper_threshold)
+  {
+    velocity_scale = 0;
+    status = StatusCode::HALT_FOR_SINGULARITY;
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, clock, ROS_LOG_THROTTLE_PERIOD, SERVO_STATUS_CODE_MAP.at(status));
+  }
+
+  return velocity_scale;
+}
 }  // namespace
 
+std::string servoInterfaceName(const std::string& group_namespace, const std::string& name)
+{
+  return group_namespace.empty() ? "~/" + name : "~/" + group_namespace + "/" + name;
+}
+
 /** \brief Helper function for converting Eigen::Isometry3d to geometry_msgs/TransformStamped **/
 geometry_msgs::msg::TransformStamped convertIsometryToTransform(const Eigen::Isometry3d& eigen_tf,
                                                                 const std::string& parent_frame,
@@ -80,7 +123,6 @@ double velocityScalingFactorForSingularity(const moveit::core::JointModelGroup*
                                            const double leaving_singularity_threshold_multiplier, rclcpp::Clock& clock,
                                            const moveit::core::RobotStatePtr& current_state, StatusCode& status)
 {
-  double velocity_scale = 1;
   std::size_t num_dimensions = commanded_twist.size();
 
   // Find the direction away from nearest singularity.
@@ -115,31 +157,50 @@ double velocityScalingFactorForSingularity(const moveit::core::JointModelGroup*
     vector_toward_singularity *= -1;
   }
 
-  // If this dot product is positive, we're moving toward singularity
-  double dot = vector_toward_singularity.dot(commanded_twist);
-  // see https://github.com/ros-planning/moveit2/pull/620#issuecomment-1201418258 for visual explanation of algorithm
-  double upper_threshold = dot > 0 ? hard_stop_singularity_threshold :
-                                     (hard_stop_singularity_threshold - lower_singularity_threshold) *
-                                             leaving_singularity_threshold_multiplier +
-                                         lower_singularity_threshold;
-  if ((ini_condition > lower_singularity_threshold) && (ini_condition < hard_stop_singularity_threshold))
-  {
-    velocity_scale =
-        1. - (ini_condition - lower_singularity_threshold) / (upper_threshold - lower_singularity_threshold);
-    status =
-        dot > 0 ? StatusCode::DECELERATE_FOR_APPROACHING_SINGULARITY : StatusCode::DECELERATE_FOR_LEAVING_SINGULARITY;
-    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, clock, ROS_LOG_THROTTLE_PERIOD, SERVO_STATUS_CODE_MAP.at(status));
-  }
+  return velocityScalingFactorForCondition(ini_condition, vector_toward_singularity, commanded_twist,
+                                           hard_stop_singularity_threshold, lower_singularity_threshold,
+                                           leaving_singularity_threshold_multiplier, clock, status);
+}
 
-  // Very close to singularity, so halt.
-  else if (ini_condition >= upper_threshold)
+/** \brief Possibly calculate a velocity scaling factor, due to proximity of
+ * singularity and direction of motion. The direction toward the singularity is found from the derivative
+ * of the condition number, so no further Jacobian needs to be decomposed.
+ * @param[in] commanded_twist     The commanded Cartesian twist
+ * @param[in] svd                 A singular value decomposition of the Jacobian, with thin U and V
+ * @param[in] jacobian_derivative The change of the Jacobian for the joint motion pseudo_inverse * u, where u is
+ *                                the last column of svd.matrixU()
+ * @param[in] hard_stop_singularity_threshold  Halt if condition(Jacobian) > hard_stop_singularity_threshold
+ * @param[in] lower_singularity_threshold      Decelerate if condition(Jacobian) > lower_singularity_threshold
+ * @param[in] leaving_singularity_threshold_multiplier      Allow faster motion away from singularity
+ * @param[in, out] clock          A ROS clock, for logging
+ * @param[out] status             Singularity status
+ */
+double velocityScalingFactorForSingularity(const Eigen::VectorXd& commanded_twist,
+                                           const Eigen::JacobiSVD<Eigen::MatrixXd>& svd,
+                                           const Eigen::MatrixXd& jacobian_derivative,
+                                           const double hard_stop_singularity_threshold,
+                                           const double lower_singularity_threshold,
+                                           const double leaving_singularity_threshold_multiplier, rclcpp::Clock& clock,
+                                           StatusCode& status)
+{
+  std::size_t num_dimensions = commanded_twist.size();
+  const Eigen::VectorXd& singular_values = svd.singularValues();
+  const Eigen::Index last = singular_values.size() - 1;
+  double ini_condition = singular_values(0) / singular_values(last);
+
+  // The derivative of a singular value s_i = u_i^T J v_i is u_i^T dJ v_i, which gives the derivative of the
+  // condition s_0 / s_n along the last singular vector. If it is positive, the vector points toward the singularity.
+  Eigen::VectorXd vector_toward_singularity = svd.matrixU().col(num_dimensions - 1);
+  const double max_derivative = svd.matrixU().col(0).dot(jacobian_derivative * svd.matrixV().col(0));
+  const double min_derivative = svd.matrixU().col(last).dot(jacobian_derivative * svd.matrixV().col(last));
+  if (max_derivative * singular_values(last) - singular_values(0) * min_derivative <= 0)
   {
-    velocity_scale = 0;
-    status = StatusCode::HALT_FOR_SINGULARITY;
-    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, clock, ROS_LOG_THROTTLE_PERIOD, SERVO_STATUS_CODE_MAP.at(status));
+    vector_toward_singularity *= -1;
   }
 
-  return velocity_scale;
+  return velocityScalingFactorForCondition(ini_condition, vector_toward_singularity, commanded_twist,
+                                           hard_stop_singularity_threshold, lower_singularity_threshold,
+                                           leaving_singularity_threshold_multiplier, clock, status);
 }
 
 bool applyJointUpdate(rclcpp::Clock& clock, const double publish_period, const Eigen::ArrayXd& delta_theta,
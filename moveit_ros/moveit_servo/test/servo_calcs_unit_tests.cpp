@@ -167,6 +167,57 @@ TEST_F(ServoCalcsUnitTests, SingularityScaling)
   EXPECT_EQ(scaling_factor, 0);
 }
 
+TEST_F(ServoCalcsUnitTests, SingularityScalingFromJacobianDerivative)
+{
+  Eigen::VectorXd commanded_twist(6);
+  commanded_twist << 1, 0, 0, 0, 0, 0;
+
+  // Start near a singularity
+  std::shared_ptr<moveit::core::RobotState> robot_state = std::make_shared<moveit::core::RobotState>(robot_model_);
+  robot_state->setToDefaultValues();
+  robot_state->setVariablePosition("panda_joint1", 0.221);
+  robot_state->setVariablePosition("panda_joint2", 0.530);
+  robot_state->setVariablePosition("panda_joint3", -0.231);
+  robot_state->setVariablePosition("panda_joint4", -0.920);
+  robot_state->setVariablePosition("panda_joint5", 0.117);
+  robot_state->setVariablePosition("panda_joint6", 1.439);
+  robot_state->setVariablePosition("panda_joint7", -1.286);
+
+  const moveit::core::LinkModel* tip_link = joint_model_group_->getLinkModels().back();
+  Eigen::MatrixXd jacobian = robot_state->getJacobian(joint_model_group_);
+  Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobian, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  Eigen::MatrixXd pseudo_inverse =
+      svd.matrixV() * svd.singularValues().cwiseInverse().asDiagonal() * svd.matrixU().transpose();
+
+  // change of the Jacobian for the joint motion along the last singular vector
+  Eigen::MatrixXd jacobian_derivative;
+  robot_state->setJointGroupVelocities(joint_model_group_, pseudo_inverse * svd.matrixU().col(5));
+  ASSERT_TRUE(robot_state->getJacobian(joint_model_group_, tip_link, Eigen::Vector3d::Zero(), jacobian,
+                                       jacobian_derivative));
+
+  // Decelerate, so the result depends on the direction toward the singularity
+  const double condition = svd.singularValues()(0) / svd.singularValues()(5);
+  const double hard_stop_singularity_threshold = 2 * condition;
+  const double lower_singularity_threshold = 0.5 * condition;
+  const double leaving_singularity_threshold_multiplier = 2;
+
+  rclcpp::Clock clock;
+  moveit_servo::StatusCode status;
+  const double scaling_factor = moveit_servo::velocityScalingFactorForSingularity(
+      commanded_twist, svd, jacobian_derivative, hard_stop_singularity_threshold, lower_singularity_threshold,
+      leaving_singularity_threshold_multiplier, clock, status);
+  EXPECT_GT(scaling_factor, 0);
+  EXPECT_LT(scaling_factor, 1);
+
+  // Same result as looking ahead with a perturbed state
+  moveit_servo::StatusCode lookahead_status;
+  const double lookahead_scaling_factor = moveit_servo::velocityScalingFactorForSingularity(
+      joint_model_group_, commanded_twist, svd, pseudo_inverse, hard_stop_singularity_threshold,
+      lower_singularity_threshold, leaving_singularity_threshold_multiplier, clock, robot_state, lookahead_status);
+  EXPECT_NEAR(scaling_factor, lookahead_scaling_factor, 1e-9);
+  EXPECT_EQ(status, lookahead_status);
+}
+
 int main(int argc, char** argv)
 {
   rclcpp::init(argc, argv);
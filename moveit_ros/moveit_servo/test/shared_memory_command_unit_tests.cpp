@@ -0,0 +1,138 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/*      Title     : shared_memory_command_unit_tests.cpp
+ *      Project   : moveit_servo
+ *      Created   : 10/15/2026
+ */
+
+#include <gtest/gtest.h>
+
+#include <moveit_servo/shared_memory_command.h>
+
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+std::string segmentName()
+{
+  return "/moveit_servo_test_" + std::to_string(getpid());
+}
+}  // namespace
+
+TEST(SharedMemoryCommand, WriteAndRead)
+{
+  moveit_servo::SharedMemoryCommandReader reader;
+  EXPECT_FALSE(reader.open(segmentName()));
+
+  moveit_servo::SharedMemoryCommand command;
+  {
+    moveit_servo::SharedMemoryCommandWriter writer(segmentName(), { "joint_1", "joint_2" });
+    ASSERT_TRUE(reader.open(segmentName()));
+    EXPECT_EQ(reader.getJointNames(), (std::vector<std::string>{ "joint_1", "joint_2" }));
+    EXPECT_FALSE(reader.read(command));
+
+    writer.write(42, { 1.0, 2.0 }, { 0.1, 0.2 }, {});
+    ASSERT_TRUE(reader.read(command));
+    EXPECT_EQ(command.stamp, 42);
+    EXPECT_EQ(command.fields, moveit_servo::SharedMemoryCommand::POSITIONS |
+                                  moveit_servo::SharedMemoryCommand::VELOCITIES);
+    EXPECT_EQ(command.positions, (std::vector<double>{ 1.0, 2.0 }));
+    EXPECT_EQ(command.velocities, (std::vector<double>{ 0.1, 0.2 }));
+    EXPECT_TRUE(command.accelerations.empty());
+
+    // a command is only read once
+    EXPECT_FALSE(reader.read(command));
+    EXPECT_EQ(command.positions, (std::vector<double>{ 1.0, 2.0 }));
+
+    // commands that were overwritten before being read are counted as missed
+    writer.write(43, { 3.0, 4.0 }, {}, {});
+    writer.write(44, { 5.0, 6.0 }, {}, {});
+    ASSERT_TRUE(reader.read(command));
+    EXPECT_EQ(command.stamp, 44);
+    EXPECT_TRUE(command.velocities.empty());
+    EXPECT_EQ(reader.getMissedCount(), 1u);
+    EXPECT_TRUE(reader.isWriterAlive());
+  }
+  EXPECT_FALSE(reader.isWriterAlive());
+  EXPECT_FALSE(reader.read(command));
+}
+
+TEST(SharedMemoryCommand, ConsistentUnderConcurrentWrites)
+{
+  constexpr int NUM_COMMANDS = 100000;
+  moveit_servo::SharedMemoryCommandWriter writer(segmentName(), { "a", "b", "c" });
+  moveit_servo::SharedMemoryCommandReader reader;
+  ASSERT_TRUE(reader.open(segmentName()));
+
+  std::thread writer_thread([&writer] {
+    for (int i = 1; i <= NUM_COMMANDS; ++i)
+    {
+      const double value = i;
+      writer.write(i, { value, value, value }, { -value, -value, -value }, {});
+    }
+  });
+
+  // every command that is read must be one of the written ones, never a mix of two
+  moveit_servo::SharedMemoryCommand command;
+  std::int64_t last_stamp = 0;
+  while (last_stamp < NUM_COMMANDS)
+  {
+    if (!reader.read(command))
+      continue;
+    ASSERT_GT(command.stamp, last_stamp);
+    last_stamp = command.stamp;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      ASSERT_EQ(command.positions[i], static_cast<double>(command.stamp));
+      ASSERT_EQ(command.velocities[i], -static_cast<double>(command.stamp));
+    }
+  }
+  writer_thread.join();
+}
+
+TEST(SharedMemoryCommand, RejectsTooManyJoints)
+{
+  const std::vector<std::string> joint_names(moveit_servo::SharedMemoryCommandSegment::MAX_JOINTS + 1, "joint");
+  EXPECT_THROW(moveit_servo::SharedMemoryCommandWriter(segmentName(), joint_names), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/collision_detection/occupancy_map.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace occupancy_map_monitor
+{
+/** \brief Applies the cell updates of sensor frames to the occupancy map on a dedicated thread.
+ *
+ *  Octomap updaters compute the free, occupied and model cells of a frame without holding the write lock of the
+ *  tree, and hand them over with pushUpdate(). The integrator thread takes all queued frames at once and applies
+ *  them in order under a single write lock, so planners reading the map wait for at most one short batch.
+ *
+ *  A frame that has been queued for longer than the latency budget is dropped once a newer frame is queued behind
+ *  it. The newest frame is always integrated, so the map keeps up even if integration is slower than the sensors.
+ */
+class OccupancyMapIntegrator
+{
+public:
+  /** @brief Start the integrator thread
+   *  @param tree The map to update
+   *  @param max_latency Latency budget in seconds for queued frames
+   */
+  OccupancyMapIntegrator(const collision_detection::OccMapTreePtr& tree, double max_latency);
+  ~OccupancyMapIntegrator();
+
+  /** @brief Queue the cells of one sensor frame.
+   *
+   *  Free cells are marked free, then occupied cells occupied, and model cells are set to the minimum log odds.
+   *  The caller removes occupied cells from the free cells and model cells from the occupied cells beforehand,
+   *  as for a synchronous update.
+   */
+  void pushUpdate(octomap::KeySet&& free_cells, octomap::KeySet&& occupied_cells, octomap::KeySet&& model_cells);
+
+  /** @brief Block until every queued frame has been integrated or dropped */
+  void waitUntilIdle();
+
+  /** @brief Number of frames dropped because they exceeded the latency budget */
+  std::size_t getDroppedFrameCount() const;
+
+private:
+  struct Frame
+  {
+    octomap::KeySet free_cells;
+    octomap::KeySet occupied_cells;
+    octomap::KeySet model_cells;
+    std::chrono::steady_clock::time_point stamp;
+  };
+
+  /** @brief Drop stale frames from the front of the queue, keeping the newest. Requires queue_lock_ to be held */
+  void dropStaleFrames(std::deque<Frame>& frames);
+  void integrationThread();
+
+  collision_detection::OccMapTreePtr tree_;
+  std::chrono::steady_clock::duration max_latency_;
+
+  mutable std::mutex queue_lock_;
+  std::condition_variable queue_condition_;
+  std::condition_variable idle_condition_;
+  std::deque<Frame> queue_;
+  std::size_t dropped_frames_;
+  bool integrating_;
+  bool running_;
+
+  std::thread integration_thread_;
+};
+}  // namespace occupancy_map_monitor
@@ -64,6 +64,8 @@ public:
     double map_resolution;
     std::string map_frame;
     std::vector<std::pair<std::string, std::string>> sensor_plugins;
+    double rolling_window_extent;     /*!< Edge length of the map kept around the robot, 0 keeps the whole map */
+    std::string rolling_window_frame; /*!< Frame the rolling window is centered on */
   };
 
   /**
@@ -246,7 +248,7 @@ public:
    */
   void setUpdateCallback(const std::function<void()>& update_callback)
   {
-    tree_->setUpdateCallback(update_callback);
+    update_callback_ = update_callback;
   }
 
   /**
@@ -313,6 +315,18 @@ private:
   bool getShapeTransformCache(std::size_t index, const std::string& target_frame, const rclcpp::Time& target_time,
                               ShapeTransformCache& cache) const;
 
+  /**
+   * @brief      Called by the octree whenever an updater modified it. Applies the rolling window before forwarding
+   *             the update to the user callback.
+   */
+  void treeUpdateCallback();
+
+  /**
+   * @brief      Re-centers the rolling window on the rolling window frame and evicts the cells outside of it. The
+   *             window is only moved once its frame moved by more than a tenth of the extent.
+   */
+  void updateRollingWindow();
+
   std::unique_ptr<MiddlewareHandle> middleware_handle_; /*!< The abstract interface to ros */
   std::shared_ptr<tf2_ros::Buffer> tf_buffer_;          /*!< TF buffer */
   Parameters parameters_;
@@ -329,5 +343,10 @@ private:
   std::size_t mesh_handle_count_; /*!< Count of mesh handles */
 
   bool active_; /*!< True when actively monitoring updaters */
+
+  std::function<void()> update_callback_;  /*!< Callback triggered after the octree was updated */
+  std::mutex rolling_window_lock_;         /*!< Serializes rolling window updates from concurrent updaters */
+  bool rolling_window_initialized_;        /*!< True once the rolling window was centered */
+  octomap::point3d rolling_window_center_; /*!< Center of the rolling window in the map frame */
 };
 }  // namespace occupancy_map_monitor
@@ -0,0 +1,152 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map_integrator.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+
+namespace occupancy_map_monitor
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.occupancy_map_monitor.integrator");
+
+OccupancyMapIntegrator::OccupancyMapIntegrator(const collision_detection::OccMapTreePtr& tree, double max_latency)
+  : tree_(tree)
+  , max_latency_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(max_latency)))
+  , dropped_frames_(0)
+  , integrating_(false)
+  , running_(true)
+  , integration_thread_([this] { integrationThread(); })
+{
+}
+
+OccupancyMapIntegrator::~OccupancyMapIntegrator()
+{
+  {
+    std::scoped_lock _(queue_lock_);
+    running_ = false;
+  }
+  queue_condition_.notify_one();
+  integration_thread_.join();
+}
+
+void OccupancyMapIntegrator::pushUpdate(octomap::KeySet&& free_cells, octomap::KeySet&& occupied_cells,
+                                        octomap::KeySet&& model_cells)
+{
+  {
+    std::scoped_lock _(queue_lock_);
+    queue_.push_back(Frame{ std::move(free_cells), std::move(occupied_cells), std::move(model_cells),
+                            std::chrono::steady_clock::now() });
+    // bound the queue right away, in case the integrator is blocked on the write lock
+    dropStaleFrames(queue_);
+  }
+  queue_condition_.notify_one();
+}
+
+void OccupancyMapIntegrator::waitUntilIdle()
+{
+  std::unique_lock<std::mutex> ulock(queue_lock_);
+  idle_condition_.wait(ulock, [this] { return (queue_.empty() && !integrating_) || !running_; });
+}
+
+std::size_t OccupancyMapIntegrator::getDroppedFrameCount() const
+{
+  std::scoped_lock _(queue_lock_);
+  return dropped_frames_;
+}
+
+void OccupancyMapIntegrator::dropStaleFrames(std::deque<Frame>& frames)
+{
+  const auto now = std::chrono::steady_clock::now();
+  std::size_t dropped = 0;
+  while (frames.size() > 1 && now - frames.front().stamp > max_latency_)
+  {
+    frames.pop_front();
+    ++dropped;
+  }
+  if (dropped > 0)
+  {
+    dropped_frames_ += dropped;
+    RCLCPP_DEBUG(LOGGER, "Dropped %zu frames that exceeded the latency budget", dropped);
+  }
+}
+
+void OccupancyMapIntegrator::integrationThread()
+{
+  const float lg = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
+  std::deque<Frame> batch;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> ulock(queue_lock_);
+      integrating_ = false;
+      idle_condition_.notify_all();
+      queue_condition_.wait(ulock, [this] { return !queue_.empty() || !running_; });
+      if (!running_)
+        break;
+      batch.swap(queue_);
+      dropStaleFrames(batch);
+      integrating_ = true;
+    }
+
+    tree_->lockWrite();
+    try
+    {
+      for (const Frame& frame : batch)
+      {
+        /* mark free cells only if not seen occupied in this frame */
+        for (const octomap::OcTreeKey& free_cell : frame.free_cells)
+          tree_->updateNode(free_cell, false);
+
+        /* now mark all occupied cells */
+        for (const octomap::OcTreeKey& occupied_cell : frame.occupied_cells)
+          tree_->updateNode(occupied_cell, true);
+
+        // set the logodds to the minimum for the cells that are part of the model
+        for (const octomap::OcTreeKey& model_cell : frame.model_cells)
+          tree_->updateNode(model_cell, lg);
+      }
+    }
+    catch (...)
+    {
+      RCLCPP_ERROR(LOGGER, "Internal error while updating octree");
+    }
+    tree_->unlockWrite();
+    tree_->triggerUpdateCallback();
+
+    batch.clear();
+  }
+}
+}  // namespace occupancy_map_monitor
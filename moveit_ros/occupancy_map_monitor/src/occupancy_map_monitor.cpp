@@ -43,6 +43,7 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <rclcpp/node.hpp>
+#include <tf2/exceptions.h>
 #include <memory>
 #include <string>
 #include <utility>
@@ -72,10 +73,11 @@ OccupancyMapMonitor::OccupancyMapMonitor(std::unique_ptr<MiddlewareHandle> middl
                                          const std::shared_ptr<tf2_ros::Buffer>& tf_buffer)
   : middleware_handle_{ std::move(middleware_handle) }
   , tf_buffer_{ tf_buffer }
-  , parameters_{ 0.0, "", {} }
+  , parameters_{ 0.0, "", {}, 0.0, "" }
   , debug_info_{ false }
   , mesh_handle_count_{ 0 }
   , active_{ false }
+  , rolling_window_initialized_{ false }
 {
   if (middleware_handle_ == nullptr)
   {
@@ -97,8 +99,22 @@ OccupancyMapMonitor::OccupancyMapMonitor(std::unique_ptr<MiddlewareHandle> middl
                         "No transforms will be applied to received data.");
   }
 
+  if (parameters_.rolling_window_extent > 0.0)
+  {
+    if (tf_buffer_ == nullptr || parameters_.map_frame.empty() || parameters_.rolling_window_frame.empty())
+    {
+      RCLCPP_ERROR(LOGGER, "A rolling window needs a TF buffer, a map frame and a rolling window frame. "
+                           "Keeping the whole map instead.");
+      parameters_.rolling_window_extent = 0.0;
+    }
+    else
+      RCLCPP_INFO(LOGGER, "Keeping a %g m rolling window of the octomap around frame '%s'",
+                  parameters_.rolling_window_extent, parameters_.rolling_window_frame.c_str());
+  }
+
   tree_ = std::make_shared<collision_detection::OccMapTree>(parameters_.map_resolution);
   tree_const_ = tree_;
+  tree_->setUpdateCallback([this] { treeUpdateCallback(); });
 
   for (const auto& [sensor_name, sensor_type] : parameters_.sensor_plugins)
   {
@@ -278,6 +294,54 @@ bool OccupancyMapMonitor::getShapeTransformCache(std::size_t index, const std::s
     return false;
 }
 
+void OccupancyMapMonitor::treeUpdateCallback()
+{
+  if (parameters_.rolling_window_extent > 0.0)
+    updateRollingWindow();
+  if (update_callback_)
+    update_callback_();
+}
+
+void OccupancyMapMonitor::updateRollingWindow()
+{
+  std::string map_frame;
+  {
+    std::lock_guard<std::mutex> _(parameters_lock_);
+    map_frame = parameters_.map_frame;
+  }
+
+  geometry_msgs::msg::TransformStamped transform;
+  try
+  {
+    transform = tf_buffer_->lookupTransform(map_frame, parameters_.rolling_window_frame, tf2::TimePointZero);
+  }
+  catch (tf2::TransformException& ex)
+  {
+    rclcpp::Clock steady_clock(RCL_STEADY_TIME);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    RCLCPP_WARN_THROTTLE(LOGGER, steady_clock, 1000, "Unable to update the rolling window of the octomap: %s",
+                         ex.what());
+#pragma GCC diagnostic pop
+    return;
+  }
+
+  // moving the window evicts everything outside of it, so small motions of the frame are ignored
+  const octomap::point3d center(transform.transform.translation.x, transform.transform.translation.y,
+                                transform.transform.translation.z);
+  const double extent = parameters_.rolling_window_extent;
+  std::lock_guard<std::mutex> _(rolling_window_lock_);
+  if (rolling_window_initialized_ && (center - rolling_window_center_).norm() < 0.1 * extent)
+    return;
+  rolling_window_center_ = center;
+  rolling_window_initialized_ = true;
+
+  const octomap::point3d half_extent(0.5 * extent, 0.5 * extent, 0.5 * extent);
+  tree_->lockWrite();
+  tree_->clearOutsideBBX(center - half_extent, center + half_extent);
+  tree_->unlockWrite();
+}
+
 bool OccupancyMapMonitor::saveMapCallback(const std::shared_ptr<rmw_request_id_t>& /* unused */,
                                           const std::shared_ptr<moveit_msgs::srv::SaveMap::Request>& request,
                                           const std::shared_ptr<moveit_msgs::srv::SaveMap::Response>& response)
@@ -313,6 +377,8 @@ bool OccupancyMapMonitor::loadMapCallback(const std::shared_ptr<rmw_request_id_t
     RCLCPP_ERROR(LOGGER, "Failed to load map from file");
     response->success = false;
   }
+  // the cells read from the file are not reported by change detection
+  tree_->markStructureChanged();
   tree_->unlockWrite();
 
   if (response->success)
@@ -56,7 +56,7 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.occupancy_ma
 OccupancyMapMonitorMiddlewareHandle::OccupancyMapMonitorMiddlewareHandle(const rclcpp::Node::SharedPtr& node,
                                                                          double map_resolution,
                                                                          const std::string& map_frame)
-  : node_{ node }, parameters_{ map_resolution, map_frame, {} }
+  : node_{ node }, parameters_{ map_resolution, map_frame, {}, 0.0, "" }
 {
   try
   {
@@ -88,6 +88,9 @@ OccupancyMapMonitorMiddlewareHandle::OccupancyMapMonitorMiddlewareHandle(const r
     }
   }
 
+  node_->get_parameter("octomap_rolling_window_extent", parameters_.rolling_window_extent);
+  node_->get_parameter("octomap_rolling_window_frame", parameters_.rolling_window_frame);
+
   std::vector<std::string> sensor_names;
   if (!node_->get_parameter("sensors", sensor_names))
   {
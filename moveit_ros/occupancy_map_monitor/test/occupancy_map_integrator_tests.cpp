@@ -0,0 +1,100 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map_integrator.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+namespace
+{
+octomap::KeySet makeKeySet(const collision_detection::OccMapTree& tree, double x, double y, double z)
+{
+  octomap::KeySet keys;
+  keys.insert(tree.coordToKey(x, y, z));
+  return keys;
+}
+
+bool isOccupied(collision_detection::OccMapTree& tree, double x, double y, double z)
+{
+  const octomap::OcTreeNode* node = tree.search(x, y, z);
+  return node && tree.isNodeOccupied(node);
+}
+}  // namespace
+
+TEST(OccupancyMapIntegratorTests, IntegratesQueuedFrames)
+{
+  // GIVEN an integrator for an empty map
+  auto tree = std::make_shared<collision_detection::OccMapTree>(0.1);
+  occupancy_map_monitor::OccupancyMapIntegrator integrator(tree, 1.0);
+
+  // WHEN a frame with one free and one occupied cell is pushed
+  integrator.pushUpdate(makeKeySet(*tree, 0.05, 0.05, 0.05), makeKeySet(*tree, 1.05, 0.05, 0.05), octomap::KeySet());
+  integrator.waitUntilIdle();
+
+  // THEN the cells are integrated into the map
+  ASSERT_NE(tree->search(0.05, 0.05, 0.05), nullptr);
+  EXPECT_FALSE(isOccupied(*tree, 0.05, 0.05, 0.05));
+  EXPECT_TRUE(isOccupied(*tree, 1.05, 0.05, 0.05));
+  EXPECT_EQ(integrator.getDroppedFrameCount(), 0u);
+}
+
+TEST(OccupancyMapIntegratorTests, DropsStaleFramesButKeepsNewest)
+{
+  // GIVEN an integrator without latency budget, blocked because the map is locked
+  auto tree = std::make_shared<collision_detection::OccMapTree>(0.1);
+  occupancy_map_monitor::OccupancyMapIntegrator integrator(tree, 0.0);
+  tree->lockWrite();
+
+  // WHEN three frames are pushed while the integrator cannot write
+  for (double x : { 0.05, 1.05, 2.05 })
+  {
+    integrator.pushUpdate(octomap::KeySet(), makeKeySet(*tree, x, 0.05, 0.05), octomap::KeySet());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  tree->unlockWrite();
+  integrator.waitUntilIdle();
+
+  // THEN stale frames behind newer ones are dropped, and the newest frame is integrated
+  EXPECT_GE(integrator.getDroppedFrameCount(), 1u);
+  EXPECT_TRUE(isOccupied(*tree, 2.05, 0.05, 0.05));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -77,6 +77,50 @@ TEST(OccupancyMapMonitorTests, ConstructorTest)
   };
 }
 
+TEST(OccupancyMapMonitorTests, RollingWindowTest)
+{
+  // GIVEN a monitor keeping a 2 m rolling window around the robot base
+  auto mock_middleware_handle = std::make_unique<MockMiddlewareHandle>();
+  occupancy_map_monitor::OccupancyMapMonitor::Parameters parameters{ 0.1, "map", {}, 2.0, "base" };
+  ON_CALL(*mock_middleware_handle, getParameters).WillByDefault(testing::Return(parameters));
+  EXPECT_CALL(*mock_middleware_handle, getParameters).Times(1);
+  EXPECT_CALL(*mock_middleware_handle, createSaveMapService).Times(1);
+  EXPECT_CALL(*mock_middleware_handle, createLoadMapService).Times(1);
+
+  auto tf_buffer = std::make_shared<tf2_ros::Buffer>(std::make_shared<rclcpp::Clock>());
+  geometry_msgs::msg::TransformStamped transform;
+  transform.header.frame_id = "map";
+  transform.child_frame_id = "base";
+  transform.transform.rotation.w = 1.0;
+  tf_buffer->setTransform(transform, "test", true);
+
+  occupancy_map_monitor::OccupancyMapMonitor occupancy_map_monitor{ std::move(mock_middleware_handle), tf_buffer };
+  std::size_t update_count = 0;
+  occupancy_map_monitor.setUpdateCallback([&update_count] { ++update_count; });
+
+  // WHEN cells near and far from the robot are observed
+  const collision_detection::OccMapTreePtr& tree = occupancy_map_monitor.getOcTreePtr();
+  tree->updateNode(0.5, 0.5, 0.5, true);
+  tree->updateNode(5.0, 0.0, 0.0, true);
+  tree->triggerUpdateCallback();
+
+  // THEN only the cells inside the window are kept and the update is forwarded
+  EXPECT_EQ(update_count, 1u);
+  EXPECT_NE(tree->search(0.5, 0.5, 0.5), nullptr);
+  EXPECT_EQ(tree->search(5.0, 0.0, 0.0), nullptr);
+
+  // WHEN the robot drives to the far cell
+  transform.transform.translation.x = 5.0;
+  tf_buffer->setTransform(transform, "test", true);
+  tree->updateNode(5.0, 0.0, 0.0, true);
+  tree->triggerUpdateCallback();
+
+  // THEN the window follows the robot
+  EXPECT_EQ(update_count, 2u);
+  EXPECT_EQ(tree->search(0.5, 0.5, 0.5), nullptr);
+  EXPECT_NE(tree->search(5.0, 0.0, 0.0), nullptr);
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
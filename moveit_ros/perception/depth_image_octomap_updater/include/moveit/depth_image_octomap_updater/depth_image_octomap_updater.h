@@ -38,6 +38,7 @@
 
 #include <rclcpp/rclcpp.hpp>
 #include <tf2_ros/buffer.h>
+#include <moveit/occupancy_map_monitor/occupancy_map_integrator.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
 #include <moveit/mesh_filter/mesh_filter.h>
 #include <moveit/mesh_filter/stereo_camera_model.h>
@@ -92,6 +93,8 @@ private:
   double padding_scale_;
   double padding_offset_;
   double max_update_rate_;
+  double integration_latency_budget_;
+  unsigned int num_threads_;
   unsigned int skip_vertical_pixels_;
   unsigned int skip_horizontal_pixels_;
 
@@ -102,10 +105,15 @@ private:
 
   std::unique_ptr<mesh_filter::MeshFilter<mesh_filter::StereoCameraModel> > mesh_filter_;
   std::unique_ptr<LazyFreeSpaceUpdater> free_space_updater_;
+  // marks the occupied cells of each image on its own thread if integration_latency_budget is positive
+  std::unique_ptr<OccupancyMapIntegrator> integrator_;
 
   std::vector<float> x_cache_, y_cache_;
   double inv_fx_, inv_fy_, K0_, K2_, K4_, K5_;
   std::vector<unsigned int> filtered_labels_;
+  // key sets of the back-projection threads other than the first, kept to reuse their memory
+  std::vector<octomap::KeySet> thread_occupied_cells_;
+  std::vector<octomap::KeySet> thread_model_cells_;
   rclcpp::Time last_depth_callback_start_;
 };
 }  // namespace occupancy_map_monitor
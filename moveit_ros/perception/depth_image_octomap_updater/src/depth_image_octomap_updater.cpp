@@ -42,13 +42,62 @@
 #include <geometric_shapes/shape_operations.h>
 #include <sensor_msgs/image_encodings.hpp>
 #include <stdint.h>
+#include <Eigen/Core>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 namespace occupancy_map_monitor
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.perception.depth_image_octomap_updater");
 
+namespace
+{
+/* back-project the rows [row_begin, row_end) of a depth image into the map frame and collect the cells of points that
+   were not filtered (occupied) and of points on the far plane or on a model (model cells) */
+template <typename DepthType>
+void projectDepthRows(const DepthType* depth, float depth_scale, const unsigned int* labels, int width, int row_begin,
+                      int row_end, int col_begin, int col_end, const std::vector<float>& x_cache,
+                      const std::vector<float>& y_cache, const Eigen::Matrix3f& rotation,
+                      const Eigen::Vector3f& translation, const collision_detection::OccMapTree& tree,
+                      octomap::KeySet& occupied_cells, octomap::KeySet& model_cells)
+{
+  const int cols = col_end - col_begin;
+  if (cols <= 0)
+    return;
+
+  const Eigen::Map<const Eigen::Array<float, 1, Eigen::Dynamic>> x_factors(&x_cache[col_begin], cols);
+  Eigen::Matrix3Xf sensor_points(3, cols);
+  Eigen::Matrix3Xf map_points(3, cols);
+  for (int y = row_begin; y < row_end; ++y)
+  {
+    const std::size_t row_offset = static_cast<std::size_t>(y) * width + col_begin;
+    const unsigned int* labels_row = labels + row_offset;
+
+    // whole rows are back-projected and transformed at once, so this part vectorizes
+    sensor_points.row(2) =
+        Eigen::Map<const Eigen::Array<DepthType, 1, Eigen::Dynamic>>(depth + row_offset, cols).template cast<float>() *
+        depth_scale;
+    sensor_points.row(0) = (x_factors * sensor_points.row(2).array()).matrix();
+    sensor_points.row(1) = sensor_points.row(2) * y_cache[y];
+    map_points.noalias() = rotation * sensor_points;
+    map_points.colwise() += translation;
+
+    for (int i = 0; i < cols; ++i)
+    {
+      // not filtered
+      if (labels_row[i] == mesh_filter::MeshFilterBase::BACKGROUND)
+        occupied_cells.insert(tree.coordToKey(map_points(0, i), map_points(1, i), map_points(2, i)));
+      // on far plane or a model point -> remove
+      else if (labels_row[i] >= mesh_filter::MeshFilterBase::FAR_CLIP)
+        model_cells.insert(tree.coordToKey(map_points(0, i), map_points(1, i), map_points(2, i)));
+    }
+  }
+}
+}  // namespace
+
 DepthImageOctomapUpdater::DepthImageOctomapUpdater()
   : OccupancyMapUpdater("DepthImageUpdater")
   , image_topic_("depth")
@@ -59,6 +108,8 @@ DepthImageOctomapUpdater::DepthImageOctomapUpdater()
   , padding_scale_(0.0)
   , padding_offset_(0.02)
   , max_update_rate_(0)
+  , integration_latency_budget_(0.0)
+  , num_threads_(1)
   , skip_vertical_pixels_(4)
   , skip_horizontal_pixels_(6)
   , image_callback_count_(0)
@@ -94,6 +145,23 @@ bool DepthImageOctomapUpdater::setParams(const std::string& name_space)
         node_->get_parameter(name_space + ".skip_horizontal_pixels", skip_horizontal_pixels_) &&
         node_->get_parameter(name_space + ".filtered_cloud_topic", filtered_cloud_topic_) &&
         node_->get_parameter(name_space + ".ns", ns_);
+    // With a positive latency budget (in seconds), occupied cells are marked on a separate integrator thread
+    node_->get_parameter_or(name_space + ".integration_latency_budget", integration_latency_budget_, 0.0);
+    if (integration_latency_budget_ > 0.0)
+      integrator_ = std::make_unique<OccupancyMapIntegrator>(tree_, integration_latency_budget_);
+    // Number of threads for back-projecting the image and clearing free space: 1 keeps both single threaded, 0 uses
+    // all cores
+    int num_threads = 1;
+    node_->get_parameter_or(name_space + ".num_threads", num_threads, 1);
+    num_threads_ = num_threads > 0 ? static_cast<unsigned int>(num_threads) : std::thread::hardware_concurrency();
+    num_threads_ = std::max(num_threads_, 1u);
+    if (free_space_updater_)
+      free_space_updater_->setNumThreads(num_threads_);
+    // Read the filtered labels through a pixel buffer object that is filled while the callback does other work
+    bool async_label_readback = false;
+    node_->get_parameter_or(name_space + ".async_label_readback", async_label_readback, false);
+    if (mesh_filter_)
+      mesh_filter_->setAsyncLabelReadback(async_label_readback);
     return true;
   }
   catch (const rclcpp::exceptions::InvalidParameterTypeException& e)
@@ -430,7 +498,6 @@ void DepthImageOctomapUpdater::depthImageCallback(const sensor_msgs::msg::Image:
     filtered_labels_.resize(img_size);
 
   // get the labels of the filtered data
-  const unsigned int* labels_row = &filtered_labels_[0];
   mesh_filter_->getFilteredLabels(&filtered_labels_[0]);
 
   // publish debug information if needed
@@ -497,103 +564,104 @@ void DepthImageOctomapUpdater::depthImageCallback(const sensor_msgs::msg::Image:
     pub_filtered_depth_image_.publish(filtered_msg, *info_msg);
   }
 
+  const tf2::Matrix3x3& basis = map_h_sensor.getBasis();
+  Eigen::Matrix3f rotation;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+      rotation(i, j) = static_cast<float>(basis[i][j]);
+  }
+  const Eigen::Vector3f translation(sensor_origin.x(), sensor_origin.y(), sensor_origin.z());
+
+  // Every thread back-projects its own block of rows into its own key sets, which are merged afterwards
+  const unsigned int thread_count = num_threads_;
+  thread_occupied_cells_.resize(thread_count);
+  thread_model_cells_.resize(thread_count);
+  const int row_begin = skip_vertical_pixels_;
+  const int row_end = h - static_cast<int>(skip_vertical_pixels_);
+  const int col_begin = skip_horizontal_pixels_;
+  const int col_end = w - static_cast<int>(skip_horizontal_pixels_);
+  const int rows_per_thread =
+      std::max(0, row_end - row_begin + static_cast<int>(thread_count) - 1) / static_cast<int>(thread_count);
+  std::atomic<bool> failed(false);
+
   // figure out occupied cells and model cells
   tree_->lockRead();
 
-  try
+#pragma omp parallel for num_threads(thread_count) schedule(static, 1)
+  for (unsigned int t = 0; t < thread_count; ++t)
   {
-    const int h_bound = h - skip_vertical_pixels_;
-    const int w_bound = w - skip_horizontal_pixels_;
-
-    if (is_u_short)
+    // exceptions must not leave the parallel region
+    try
     {
-      const uint16_t* input_row = reinterpret_cast<const uint16_t*>(&depth_msg->data[0]);
-
-      for (int y = skip_vertical_pixels_; y < h_bound; ++y, labels_row += w, input_row += w)
+      octomap::KeySet& thread_occupied_cells = t == 0 ? occupied_cells : thread_occupied_cells_[t];
+      octomap::KeySet& thread_model_cells = t == 0 ? model_cells : thread_model_cells_[t];
+      thread_occupied_cells.clear();
+      thread_model_cells.clear();
+
+      const int begin = row_begin + static_cast<int>(t) * rows_per_thread;
+      const int end = std::min(row_end, begin + rows_per_thread);
+      if (is_u_short)
       {
-        for (int x = skip_horizontal_pixels_; x < w_bound; ++x)
-        {
-          // not filtered
-          if (labels_row[x] == mesh_filter::MeshFilterBase::BACKGROUND)
-          {
-            float zz = static_cast<float>(input_row[x]) * 1e-3;  // scale from mm to m
-            float yy = y_cache_[y] * zz;
-            float xx = x_cache_[x] * zz;
-            /* transform to map frame */
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(xx, yy, zz);
-            occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-          // on far plane or a model point -> remove
-          else if (labels_row[x] >= mesh_filter::MeshFilterBase::FAR_CLIP)
-          {
-            float zz = input_row[x] * 1e-3;
-            float yy = y_cache_[y] * zz;
-            float xx = x_cache_[x] * zz;
-            /* transform to map frame */
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(xx, yy, zz);
-            // add to the list of model cells
-            model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-        }
+        // scale from mm to m
+        projectDepthRows(reinterpret_cast<const uint16_t*>(&depth_msg->data[0]), 1e-3f, &filtered_labels_[0], w, begin,
+                         end, col_begin, col_end, x_cache_, y_cache_, rotation, translation, *tree_,
+                         thread_occupied_cells, thread_model_cells);
       }
-    }
-    else
-    {
-      const float* input_row = reinterpret_cast<const float*>(&depth_msg->data[0]);
-
-      for (int y = skip_vertical_pixels_; y < h_bound; ++y, labels_row += w, input_row += w)
+      else
       {
-        for (int x = skip_horizontal_pixels_; x < w_bound; ++x)
-        {
-          if (labels_row[x] == mesh_filter::MeshFilterBase::BACKGROUND)
-          {
-            float zz = input_row[x];
-            float yy = y_cache_[y] * zz;
-            float xx = x_cache_[x] * zz;
-            /* transform to map frame */
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(xx, yy, zz);
-            occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-          else if (labels_row[x] >= mesh_filter::MeshFilterBase::FAR_CLIP)
-          {
-            float zz = input_row[x];
-            float yy = y_cache_[y] * zz;
-            float xx = x_cache_[x] * zz;
-            /* transform to map frame */
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(xx, yy, zz);
-            // add to the list of model cells
-            model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-        }
+        projectDepthRows(reinterpret_cast<const float*>(&depth_msg->data[0]), 1.0f, &filtered_labels_[0], w, begin,
+                         end, col_begin, col_end, x_cache_, y_cache_, rotation, translation, *tree_,
+                         thread_occupied_cells, thread_model_cells);
       }
     }
+    catch (...)
+    {
+      failed = true;
+    }
   }
-  catch (...)
+  tree_->unlockRead();
+
+  if (failed)
   {
-    tree_->unlockRead();
     RCLCPP_ERROR(LOGGER, "Internal error while parsing depth data");
+    delete occupied_cells_ptr;
+    delete model_cells_ptr;
     return;
   }
-  tree_->unlockRead();
+
+  for (unsigned int t = 1; t < thread_count; ++t)
+  {
+    occupied_cells.insert(thread_occupied_cells_[t].begin(), thread_occupied_cells_[t].end());
+    model_cells.insert(thread_model_cells_[t].begin(), thread_model_cells_[t].end());
+  }
 
   /* cells that overlap with the model are not occupied */
   for (const octomap::OcTreeKey& model_cell : model_cells)
     occupied_cells.erase(model_cell);
 
   // mark occupied cells
-  tree_->lockWrite();
-  try
+  if (integrator_)
   {
-    /* now mark all occupied cells */
-    for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
-      tree_->updateNode(occupied_cell, true);
+    // the occupied cells are also needed by the free space updater, so the integrator gets a copy
+    integrator_->pushUpdate(octomap::KeySet(), octomap::KeySet(occupied_cells), octomap::KeySet());
   }
-  catch (...)
+  else
   {
-    RCLCPP_ERROR(LOGGER, "Internal error while updating octree");
+    tree_->lockWrite();
+    try
+    {
+      /* now mark all occupied cells */
+      for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
+        tree_->updateNode(occupied_cell, true);
+    }
+    catch (...)
+    {
+      RCLCPP_ERROR(LOGGER, "Internal error while updating octree");
+    }
+    tree_->unlockWrite();
+    tree_->triggerUpdateCallback();
   }
-  tree_->unlockWrite();
-  tree_->triggerUpdateCallback();
 
   // at this point we still have not freed the space
   free_space_updater_->pushLazyUpdate(occupied_cells_ptr, model_cells_ptr, sensor_origin);
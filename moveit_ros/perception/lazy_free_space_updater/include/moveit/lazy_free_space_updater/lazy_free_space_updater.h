@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/collision_detection/occupancy_map.h>
+#include <atomic>
 #include <deque>
 #include <unordered_map>
 #include <condition_variable>
@@ -53,6 +54,9 @@ public:
   void pushLazyUpdate(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
                       const octomap::point3d& sensor_origin);
 
+  /** \brief Number of threads tracing the rays of a batch (at least one) */
+  void setNumThreads(unsigned int num_threads);
+
 private:
 #ifdef __APPLE__
   typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
@@ -72,6 +76,7 @@ private:
   bool running_;
   std::size_t max_batch_size_;
   double max_sensor_delta_;
+  std::atomic<unsigned int> num_threads_;
 
   std::deque<octomap::KeySet*> occupied_cells_sets_;
   std::deque<octomap::KeySet*> model_cells_sets_;
@@ -38,15 +38,134 @@
 #include <rclcpp/logging.hpp>
 #include <rclcpp/clock.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 namespace occupancy_map_monitor
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.perception.lazy_free_space_updater");
 
+namespace
+{
+/** \brief Open addressing hash map from octree keys to the number of rays passing through them.
+ *
+ *  Keys are packed into a single 64 bit word and probed linearly. clear() only resets the slots that were used and
+ *  keeps the memory, so after the first batches the table is sized to the sensor frustum and stops rehashing. */
+class KeyCountTable
+{
+public:
+  static std::uint64_t pack(const octomap::OcTreeKey& key)
+  {
+    return static_cast<std::uint64_t>(key[0]) | (static_cast<std::uint64_t>(key[1]) << 16) |
+           (static_cast<std::uint64_t>(key[2]) << 32);
+  }
+
+  static octomap::OcTreeKey unpack(std::uint64_t packed)
+  {
+    return octomap::OcTreeKey(packed & 0xffff, (packed >> 16) & 0xffff, (packed >> 32) & 0xffff);
+  }
+
+  void add(std::uint64_t key, unsigned int count)
+  {
+    if (2 * (used_slots_.size() + 1) > keys_.size())
+      grow();
+    const std::size_t slot = findSlot(key);
+    if (keys_[slot] == EMPTY)
+    {
+      keys_[slot] = key;
+      counts_[slot] = count;
+      used_slots_.push_back(slot);
+    }
+    else
+      counts_[slot] += count;
+  }
+
+  /** \brief Exclude \e key from forEach() until the table is cleared */
+  void remove(std::uint64_t key)
+  {
+    if (keys_.empty())
+      return;
+    const std::size_t slot = findSlot(key);
+    if (keys_[slot] == key)
+      counts_[slot] = 0;
+  }
+
+  template <typename Function>
+  void forEach(const Function& function) const
+  {
+    for (std::size_t slot : used_slots_)
+    {
+      if (counts_[slot] > 0)
+        function(keys_[slot], counts_[slot]);
+    }
+  }
+
+  void clear()
+  {
+    for (std::size_t slot : used_slots_)
+      keys_[slot] = EMPTY;
+    used_slots_.clear();
+  }
+
+  /** \brief Number of keys added since the last clear(), including removed ones */
+  std::size_t size() const
+  {
+    return used_slots_.size();
+  }
+
+private:
+  static constexpr std::uint64_t EMPTY = std::numeric_limits<std::uint64_t>::max();
+
+  std::size_t findSlot(std::uint64_t key) const
+  {
+    // Fibonacci hashing spreads the packed coordinates over the high bits
+    std::size_t slot = (key * 0x9E3779B97F4A7C15ull) >> shift_;
+    while (keys_[slot] != EMPTY && keys_[slot] != key)
+      slot = (slot + 1) & (keys_.size() - 1);
+    return slot;
+  }
+
+  void grow()
+  {
+    std::vector<std::uint64_t> old_keys;
+    std::vector<unsigned int> old_counts;
+    std::vector<std::size_t> old_used_slots;
+    old_keys.swap(keys_);
+    old_counts.swap(counts_);
+    old_used_slots.swap(used_slots_);
+
+    const std::size_t capacity = std::max<std::size_t>(1024, 2 * old_keys.size());
+    keys_.assign(capacity, EMPTY);
+    counts_.assign(capacity, 0);
+    used_slots_.reserve(capacity / 2);
+    shift_ = 64;
+    for (std::size_t c = capacity; c > 1; c >>= 1)
+      --shift_;
+
+    for (std::size_t old_slot : old_used_slots)
+    {
+      const std::size_t slot = findSlot(old_keys[old_slot]);
+      keys_[slot] = old_keys[old_slot];
+      counts_[slot] = old_counts[old_slot];
+      used_slots_.push_back(slot);
+    }
+  }
+
+  std::vector<std::uint64_t> keys_;
+  std::vector<unsigned int> counts_;
+  std::vector<std::size_t> used_slots_;
+  unsigned int shift_ = 64;
+};
+}  // namespace
+
 LazyFreeSpaceUpdater::LazyFreeSpaceUpdater(const collision_detection::OccMapTreePtr& tree, unsigned int max_batch_size)
   : tree_(tree)
   , running_(true)
   , max_batch_size_(max_batch_size)
   , max_sensor_delta_(1e-3)  // 1mm
+  , num_threads_(1)
   , process_occupied_cells_set_(nullptr)
   , process_model_cells_set_(nullptr)
   , update_thread_([this] { lazyUpdateThread(); })
@@ -104,19 +223,23 @@ void LazyFreeSpaceUpdater::pushBatchToProcess(OcTreeKeyCountMap* occupied_cells,
   }
 }
 
+void LazyFreeSpaceUpdater::setNumThreads(unsigned int num_threads)
+{
+  num_threads_ = std::max(num_threads, 1u);
+}
+
 void LazyFreeSpaceUpdater::processThread()
 {
   const float lg_0 = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
   const float lg_miss = tree_->getProbMissLog();
 
-  octomap::KeyRay key_ray1, key_ray2;
-  OcTreeKeyCountMap free_cells1, free_cells2;
+  // ray end points of the batch, weighted by how often they were seen; the buffers are kept across batches
+  std::vector<std::pair<octomap::OcTreeKey, unsigned int>> ray_ends;
+  std::vector<octomap::KeyRay> key_rays;
+  std::vector<KeyCountTable> free_cells;
 
   while (running_)
   {
-    free_cells1.clear();
-    free_cells2.clear();
-
     std::unique_lock<std::mutex> ulock(cell_process_lock_);
     while (!process_occupied_cells_set_ && running_)
       process_condition_.wait(ulock);
@@ -131,52 +254,48 @@ void LazyFreeSpaceUpdater::processThread()
 
     rclcpp::Clock clock;
     rclcpp::Time start = clock.now();
+
+    ray_ends.clear();
+    ray_ends.insert(ray_ends.end(), process_occupied_cells_set_->begin(), process_occupied_cells_set_->end());
+    for (const octomap::OcTreeKey& it : *process_model_cells_set_)
+      ray_ends.emplace_back(it, 1);
+
+    // every thread traces a strided share of the rays into its own table; the tables are merged into the first one
+    const unsigned int thread_count = num_threads_;
+    key_rays.resize(thread_count);
+    free_cells.resize(thread_count);
+
     tree_->lockRead();
 
-#pragma omp sections
+#pragma omp parallel for num_threads(thread_count) schedule(static, 1)
+    for (unsigned int t = 0; t < thread_count; ++t)
     {
-#pragma omp section
-      {
-        /* compute the free cells along each ray that ends at an occupied cell */
-        for (std::pair<const octomap::OcTreeKey, unsigned int>& it : *process_occupied_cells_set_)
-        {
-          if (tree_->computeRayKeys(process_sensor_origin_, tree_->keyToCoord(it.first), key_ray1))
-          {
-            for (octomap::OcTreeKey& jt : key_ray1)
-              free_cells1[jt] += it.second;
-          }
-        }
-      }
-
-#pragma omp section
+      octomap::KeyRay& key_ray = key_rays[t];
+      KeyCountTable& thread_free_cells = free_cells[t];
+      for (std::size_t i = t; i < ray_ends.size(); i += thread_count)
       {
-        /* compute the free cells along each ray that ends at a model cell */
-        for (const octomap::OcTreeKey& it : *process_model_cells_set_)
+        /* compute the free cells along each ray that ends at an occupied or model cell */
+        if (tree_->computeRayKeys(process_sensor_origin_, tree_->keyToCoord(ray_ends[i].first), key_ray))
         {
-          if (tree_->computeRayKeys(process_sensor_origin_, tree_->keyToCoord(it), key_ray2))
-          {
-            for (octomap::OcTreeKey& jt : key_ray2)
-              free_cells2[jt]++;
-          }
+          for (const octomap::OcTreeKey& jt : key_ray)
+            thread_free_cells.add(KeyCountTable::pack(jt), ray_ends[i].second);
         }
       }
     }
 
     tree_->unlockRead();
 
-    for (std::pair<const octomap::OcTreeKey, unsigned int>& it : *process_occupied_cells_set_)
+    for (unsigned int t = 1; t < thread_count; ++t)
     {
-      free_cells1.erase(it.first);
-      free_cells2.erase(it.first);
+      free_cells[t].forEach([&free_cells](std::uint64_t key, unsigned int count) { free_cells[0].add(key, count); });
+      free_cells[t].clear();
     }
 
-    for (const octomap::OcTreeKey& it : *process_model_cells_set_)
-    {
-      free_cells1.erase(it);
-      free_cells2.erase(it);
-    }
-    RCLCPP_DEBUG(LOGGER, "Marking %lu cells as free...",
-                 static_cast<long unsigned int>(free_cells1.size() + free_cells2.size()));
+    /* mark free cells only if not seen occupied in this cloud */
+    for (const std::pair<octomap::OcTreeKey, unsigned int>& it : ray_ends)
+      free_cells[0].remove(KeyCountTable::pack(it.first));
+
+    RCLCPP_DEBUG(LOGGER, "Marking up to %lu cells as free...", static_cast<long unsigned int>(free_cells[0].size()));
 
     tree_->lockWrite();
 
@@ -186,11 +305,9 @@ void LazyFreeSpaceUpdater::processThread()
       for (const octomap::OcTreeKey& it : *process_model_cells_set_)
         tree_->updateNode(it, lg_0);
 
-      /* mark free cells only if not seen occupied in this cloud */
-      for (std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells1)
-        tree_->updateNode(it.first, it.second * lg_miss);
-      for (std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells2)
-        tree_->updateNode(it.first, it.second * lg_miss);
+      free_cells[0].forEach([this, lg_miss](std::uint64_t key, unsigned int count) {
+        tree_->updateNode(KeyCountTable::unpack(key), count * lg_miss);
+      });
     }
     catch (...)
     {
@@ -198,6 +315,7 @@ void LazyFreeSpaceUpdater::processThread()
     }
     tree_->unlockWrite();
     tree_->triggerUpdateCallback();
+    free_cells[0].clear();
 
     RCLCPP_DEBUG(LOGGER, "Marked free cells in %lf ms", (clock.now() - start).seconds() * 1000.0);
 
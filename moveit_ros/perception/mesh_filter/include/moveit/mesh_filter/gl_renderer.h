@@ -101,6 +101,20 @@ public:
    */
   void getColorBuffer(unsigned char* buffer) const;
 
+  /**
+   * \brief starts copying the color buffer into a pixel buffer object without waiting for the transfer to finish
+   * \see readColorBufferTransfer
+   */
+  void startColorBufferTransfer() const;
+
+  /**
+   * \brief retrieves the color buffer copied by the last startColorBufferTransfer call.
+   *        Only waits for the part of the transfer that has not completed yet. Falls back to getColorBuffer if no
+   *        transfer was started since the frame buffers were (re)created.
+   * \param[out] buffer pointer to memory where the color values need to be stored
+   */
+  void readColorBufferTransfer(unsigned char* buffer) const;
+
   /**
    * \brief retrieves the depth buffer from OpenGL
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -277,6 +291,12 @@ private:
   /** \brief handle to depth buffer*/
   GLuint depth_id_;
 
+  /** \brief handle to the pixel buffer object the color buffer is transferred into asynchronously*/
+  GLuint color_pbo_id_;
+
+  /** \brief whether color_pbo_id_ holds the result of a started transfer*/
+  mutable bool color_transfer_started_;
+
   /** \brief handle to program that is currently used*/
   GLuint program_;
 
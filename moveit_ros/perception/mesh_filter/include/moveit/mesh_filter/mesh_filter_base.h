@@ -41,10 +41,13 @@
 #include <moveit/mesh_filter/gl_renderer.h>
 #include <moveit/mesh_filter/sensor_model.h>
 #include <Eigen/Geometry>  // for Isometry3d
+#include <atomic>
 #include <queue>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 // forward declarations
 namespace shapes
@@ -58,6 +61,7 @@ MOVEIT_CLASS_FORWARD(Job);     // Defines JobPtr, ConstPtr, WeakPtr... etc
 MOVEIT_CLASS_FORWARD(GLMesh);  // Defines GLMeshPtr, ConstPtr, WeakPtr... etc
 
 typedef unsigned int MeshHandle;
+typedef unsigned int SensorHandle;
 typedef uint32_t LabelType;
 
 class MeshFilterBase
@@ -77,6 +81,24 @@ public:
     FIRST_LABEL = 16
   };
 
+  /** \brief a depth image of one sensor, filtered along with the images of other sensors in a single batch */
+  struct SensorInput
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /** \brief the sensor that took the image, 0 for the sensor given to the constructor */
+    SensorHandle sensor;
+
+    /** \brief pointer to the depth readings, which need to stay valid until the image is filtered */
+    const void* data;
+
+    /** \brief the representation of the depth readings, GL_FLOAT or GL_UNSIGNED_SHORT */
+    GLushort type;
+
+    /** \brief pose of the sensor in the frame of the mesh transformations returned by the transform callback */
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  };
+
 public:
   /**
    * \brief Constructor
@@ -116,6 +138,25 @@ public:
    */
   void filter(const void* sensor_data, GLushort type, bool wait = false) const;
 
+  /**
+   * \brief adds a sensor that is filtered in the same OpenGL context as the sensor given to the constructor, so that
+   *        the meshes are only uploaded once for all sensors. The sensor needs to be of the same sensor model.
+   * \param[in] sensor_parameters the parameters of the sensor
+   * \return handle to the sensor, to be used in SensorInput and for retrieving its results
+   */
+  SensorHandle addSensor(const SensorModel::Parameters& sensor_parameters);
+
+  /**
+   * \brief label/remove pixels from the depth images of several sensors in a single batch.
+   *        The transform callback is called once per mesh for the whole batch, so it has to return the transformations
+   *        in a frame common to all sensors, in which each SensorInput gives the pose of its sensor. With asynchronous
+   *        label read back, the read back of each sensor is queued right after its image is filtered, so it overlaps
+   *        with filtering the remaining images.
+   * \param[in] inputs the depth images to filter, at most one per sensor
+   * \param[in] wait whether to wait until all images are filtered
+   */
+  void filter(const std::vector<SensorInput>& inputs, bool wait = false) const;
+
   /**
    * \brief retrieves the labels of the input data
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -126,6 +167,9 @@ public:
    */
   void getFilteredLabels(LabelType* labels) const;
 
+  /** \brief same as getFilteredLabels(), for the sensor \e sensor */
+  void getFilteredLabels(SensorHandle sensor, LabelType* labels) const;
+
   /**
    * \brief retrieves the filtered depth values
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -133,6 +177,9 @@ public:
    */
   void getFilteredDepth(float* depth) const;
 
+  /** \brief same as getFilteredDepth(), for the sensor \e sensor */
+  void getFilteredDepth(SensorHandle sensor, float* depth) const;
+
   /**
    * \brief retrieves the labels of the rendered model
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -144,6 +191,9 @@ public:
    */
   void getModelLabels(LabelType* labels) const;
 
+  /** \brief same as getModelLabels(), for the sensor \e sensor */
+  void getModelLabels(SensorHandle sensor, LabelType* labels) const;
+
   /**
    * \brief retrieves the depth values of the rendered model
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -151,6 +201,9 @@ public:
    */
   void getModelDepth(float* depth) const;
 
+  /** \brief same as getModelDepth(), for the sensor \e sensor */
+  void getModelDepth(SensorHandle sensor, float* depth) const;
+
   /**
    * \brief set the shadow threshold. points that are further away than the rendered model are filtered out.
    *        Except they are further away than this threshold. Then these points are kept, but its label is set to
@@ -180,12 +233,46 @@ public:
    */
   void setPaddingOffset(float offset);
 
+  /**
+   * \brief read the filtered labels back through a pixel buffer object.
+   *        The transfer is queued on the GPU right after each filter pass, so getFilteredLabels only waits for what
+   *        is left of it instead of stalling on a synchronous read of the color buffer.
+   * \param[in] enable whether to use the asynchronous read back
+   */
+  void setAsyncLabelReadback(bool enable);
+
 protected:
   /**
    * \brief initializes OpenGL related things as well as renderers
    */
-  void initialize(const std::string& render_vertex_shader, const std::string& render_fragment_shader,
-                  const std::string& filter_vertex_shader, const std::string& filter_fragment_shader);
+  void initialize();
+
+  /** \brief the OpenGL resources of one sensor */
+  struct Sensor
+  {
+    /** \brief the parameters of the sensor model */
+    SensorModel::ParametersPtr parameters;
+
+    /** \brief first pass renderer for rendering the mesh*/
+    GLRendererPtr mesh_renderer;
+
+    /** \brief second pass renderer for filtering the results of first pass*/
+    GLRendererPtr depth_filter;
+
+    /** \brief handle depth texture from sensor data*/
+    GLuint sensor_depth_texture;
+
+    /** \brief handle to GLSL location of shadow threshold*/
+    GLuint shadow_threshold_location;
+  };
+
+  /**
+   * \brief creates the renderers and the depth texture of a sensor in the OpenGL context of the filtering thread
+   */
+  void initializeSensor(Sensor& sensor) const;
+
+  /** \brief throws if \e sensor is not the handle of a sensor */
+  void checkSensor(SensorHandle sensor) const;
 
   /**
    * \brief cleaning up
@@ -195,15 +282,24 @@ protected:
   /**
    * \brief filtering thread
    */
-  void run(const std::string& render_vertex_shader, const std::string& render_fragment_shader,
-           const std::string& filter_vertex_shader, const std::string& filter_fragment_shader);
+  void run();
 
   /**
    * \brief the filter method that does the magic
+   * \param[in] inputs the depth images of the sensors
+   */
+  void doFilter(const std::vector<SensorInput>& inputs) const;
+
+  /**
+   * \brief renders the meshes and filters the depth image of one sensor
+   * \param[in] sensor the sensor that took the image
+   * \param[in] mesh_transforms the meshes and their transformations, in the frame of \e sensor
    * \param[in] sensor_data pointer to the buffer containing the depth readings
    * \param[in] encoding the representation of the depth readings in the buffer
    */
-  void doFilter(const void* sensor_data, const int encoding) const;
+  void filterSensor(const Sensor& sensor,
+                    const std::vector<std::pair<const GLMesh*, Eigen::Isometry3d>>& mesh_transforms,
+                    const void* sensor_data, const int encoding) const;
 
   /**
    * \brief used within a Job to allow the main thread adding meshes
@@ -235,9 +331,21 @@ protected:
   /** \brief storage for meshed to be filtered */
   std::map<MeshHandle, GLMeshPtr> meshes_;
 
-  /** \brief the parameters of the used sensor model*/
+  /** \brief the parameters of the used sensor model, those of sensors_[0] */
   SensorModel::ParametersPtr sensor_parameters_;
 
+  /** \brief the sensors, indexed by their handles. Only accessed in the filtering thread */
+  std::vector<Sensor> sensors_;
+
+  /** \brief the number of sensors, to check handles outside of the filtering thread */
+  std::atomic<std::size_t> sensor_count_;
+
+  /** \brief GLSL sources of the shaders, kept for the renderers of added sensors */
+  std::string render_vertex_shader_;
+  std::string render_fragment_shader_;
+  std::string filter_vertex_shader_;
+  std::string filter_fragment_shader_;
+
   /** \brief next handle to be used for next mesh that is added*/
   MeshHandle next_handle_;
 
@@ -266,21 +374,9 @@ protected:
   /** \brief indicates whether the filtering loop should stop*/
   bool stop_;
 
-  /** \brief first pass renderer for rendering the mesh*/
-  GLRendererPtr mesh_renderer_;
-
-  /** \brief second pass renderer for filtering the results of first pass*/
-  GLRendererPtr depth_filter_;
-
   /** \brief canvas element (screen-filling quad) for second pass*/
   GLuint canvas_;
 
-  /** \brief handle depth texture from sensor data*/
-  GLuint sensor_depth_texture_;
-
-  /** \brief handle to GLSL location of shadow threshold*/
-  GLuint shadow_threshold_location_;
-
   /** \brief callback function for retrieving the mesh transformations*/
   TransformCallback transform_callback_;
 
@@ -292,5 +388,8 @@ protected:
 
   /** \brief threshold for shadowed pixels vs. filtered pixels*/
   float shadow_threshold_;
+
+  /** \brief whether the filtered labels are read back asynchronously through a pixel buffer object*/
+  bool async_label_readback_;
 };
 }  // namespace mesh_filter
@@ -43,6 +43,7 @@
 #endif
 #include <GL/freeglut.h>
 #include <moveit/mesh_filter/gl_renderer.h>
+#include <cstring>
 #include <sstream>
 #include <fstream>
 #include <stdexcept>
@@ -62,6 +63,8 @@ mesh_filter::GLRenderer::GLRenderer(unsigned width, unsigned height, float near,
   , rbo_id_(0)
   , rgb_id_(0)
   , depth_id_(0)
+  , color_pbo_id_(0)
+  , color_transfer_started_(false)
   , program_(0)
   , near_(near)
   , far_(far)
@@ -166,6 +169,12 @@ void mesh_filter::GLRenderer::initFrameBuffers()
     throw runtime_error("Couldn't create frame buffer");
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);  // Unbind our frame buffer
+
+  glGenBuffers(1, &color_pbo_id_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, color_pbo_id_);
+  glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * 4, nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  color_transfer_started_ = false;
 }
 
 void mesh_filter::GLRenderer::deleteFrameBuffers()
@@ -178,8 +187,11 @@ void mesh_filter::GLRenderer::deleteFrameBuffers()
     glDeleteTextures(1, &depth_id_);
   if (rgb_id_)
     glDeleteTextures(1, &rgb_id_);
+  if (color_pbo_id_)
+    glDeleteBuffers(1, &color_pbo_id_);
 
-  rbo_id_ = fbo_id_ = depth_id_ = rgb_id_ = 0;
+  rbo_id_ = fbo_id_ = depth_id_ = rgb_id_ = color_pbo_id_ = 0;
+  color_transfer_started_ = false;
 }
 
 void mesh_filter::GLRenderer::begin() const
@@ -214,6 +226,39 @@ void mesh_filter::GLRenderer::getColorBuffer(unsigned char* buffer) const
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void mesh_filter::GLRenderer::startColorBufferTransfer() const
+{
+  // with a pack buffer bound, glGetTexImage only queues the copy and returns immediately
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, color_pbo_id_);
+  glBindTexture(GL_TEXTURE_2D, rgb_id_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  color_transfer_started_ = true;
+}
+
+void mesh_filter::GLRenderer::readColorBufferTransfer(unsigned char* buffer) const
+{
+  if (!color_transfer_started_)
+  {
+    getColorBuffer(buffer);
+    return;
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, color_pbo_id_);
+  const void* data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (data)
+  {
+    memcpy(buffer, data, width_ * height_ * 4);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  else
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    getColorBuffer(buffer);
+  }
+}
+
 void mesh_filter::GLRenderer::getDepthBuffer(float* buffer) const
 {
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
@@ -45,6 +45,7 @@
 #include <memory>
 #include <stdexcept>
 #include <sstream>
+#include <typeinfo>
 
 // include SSE headers
 #ifdef HAVE_SSE_EXTENSIONS
@@ -58,6 +59,11 @@ mesh_filter::MeshFilterBase::MeshFilterBase(const TransformCallback& transform_c
                                             const std::string& filter_vertex_shader,
                                             const std::string& filter_fragment_shader)
   : sensor_parameters_(sensor_parameters.clone())
+  , sensor_count_(1)
+  , render_vertex_shader_(render_vertex_shader)
+  , render_fragment_shader_(render_fragment_shader)
+  , filter_vertex_shader_(filter_vertex_shader)
+  , filter_fragment_shader_(filter_fragment_shader)
   , next_handle_(FIRST_LABEL)  // 0 and 1 are reserved!
   , min_handle_(FIRST_LABEL)
   , stop_(false)
@@ -65,39 +71,43 @@ mesh_filter::MeshFilterBase::MeshFilterBase(const TransformCallback& transform_c
   , padding_scale_(1.0)
   , padding_offset_(0.01)
   , shadow_threshold_(0.5)
+  , async_label_readback_(false)
 {
-  filter_thread_ =
-      std::thread([this, render_vertex_shader, render_fragment_shader, filter_vertex_shader, filter_fragment_shader] {
-        run(render_vertex_shader, render_fragment_shader, filter_vertex_shader, filter_fragment_shader);
-      });
+  filter_thread_ = std::thread([this] { run(); });
 }
 
-void mesh_filter::MeshFilterBase::initialize(const std::string& render_vertex_shader,
-                                             const std::string& render_fragment_shader,
-                                             const std::string& filter_vertex_shader,
-                                             const std::string& filter_fragment_shader)
+void mesh_filter::MeshFilterBase::initializeSensor(Sensor& sensor) const
 {
-  mesh_renderer_ = std::make_shared<GLRenderer>(sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
-                                                sensor_parameters_->getNearClippingPlaneDistance(),
-                                                sensor_parameters_->getFarClippingPlaneDistance());
-  depth_filter_ = std::make_shared<GLRenderer>(sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
-                                               sensor_parameters_->getNearClippingPlaneDistance(),
-                                               sensor_parameters_->getFarClippingPlaneDistance());
+  const SensorModel::Parameters& parameters = *sensor.parameters;
+  sensor.mesh_renderer =
+      std::make_shared<GLRenderer>(parameters.getWidth(), parameters.getHeight(),
+                                   parameters.getNearClippingPlaneDistance(), parameters.getFarClippingPlaneDistance());
+  sensor.depth_filter =
+      std::make_shared<GLRenderer>(parameters.getWidth(), parameters.getHeight(),
+                                   parameters.getNearClippingPlaneDistance(), parameters.getFarClippingPlaneDistance());
 
-  mesh_renderer_->setShadersFromString(render_vertex_shader, render_fragment_shader);
-  depth_filter_->setShadersFromString(filter_vertex_shader, filter_fragment_shader);
+  sensor.mesh_renderer->setShadersFromString(render_vertex_shader_, render_fragment_shader_);
+  sensor.depth_filter->setShadersFromString(filter_vertex_shader_, filter_fragment_shader_);
 
-  depth_filter_->begin();
+  sensor.depth_filter->begin();
 
-  glGenTextures(1, &sensor_depth_texture_);
+  glGenTextures(1, &sensor.sensor_depth_texture);
 
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "sensor"), 0);
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "depth"), 2);
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "label"), 4);
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "sensor"), 0);
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "depth"), 2);
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "label"), 4);
 
-  shadow_threshold_location_ = glGetUniformLocation(depth_filter_->getProgramID(), "shadow_threshold");
+  sensor.shadow_threshold_location = glGetUniformLocation(sensor.depth_filter->getProgramID(), "shadow_threshold");
 
-  depth_filter_->end();
+  sensor.depth_filter->end();
+}
+
+void mesh_filter::MeshFilterBase::initialize()
+{
+  Sensor sensor;
+  sensor.parameters = sensor_parameters_;
+  initializeSensor(sensor);
+  sensors_.push_back(sensor);
 
   canvas_ = glGenLists(1);
   glNewList(canvas_, GL_COMPILE);
@@ -147,20 +157,53 @@ void mesh_filter::MeshFilterBase::addJob(const JobPtr& job) const
 void mesh_filter::MeshFilterBase::deInitialize()
 {
   glDeleteLists(canvas_, 1);
-  glDeleteTextures(1, &sensor_depth_texture_);
+  for (const Sensor& sensor : sensors_)
+    glDeleteTextures(1, &sensor.sensor_depth_texture);
 
   meshes_.clear();
-  mesh_renderer_.reset();
-  depth_filter_.reset();
+  sensors_.clear();
 }
 
 void mesh_filter::MeshFilterBase::setSize(unsigned int width, unsigned int height)
 {
-  mesh_renderer_->setBufferSize(width, height);
-  mesh_renderer_->setCameraParameters(width, width, width >> 1, height >> 1);
+  for (const Sensor& sensor : sensors_)
+  {
+    sensor.mesh_renderer->setBufferSize(width, height);
+    sensor.mesh_renderer->setCameraParameters(width, width, width >> 1, height >> 1);
 
-  depth_filter_->setBufferSize(width, height);
-  depth_filter_->setCameraParameters(width, width, width >> 1, height >> 1);
+    sensor.depth_filter->setBufferSize(width, height);
+    sensor.depth_filter->setCameraParameters(width, width, width >> 1, height >> 1);
+  }
+}
+
+mesh_filter::SensorHandle mesh_filter::MeshFilterBase::addSensor(const SensorModel::Parameters& sensor_parameters)
+{
+  if (typeid(sensor_parameters) != typeid(*sensor_parameters_))
+    throw std::runtime_error("Could not add sensor. All sensors of a mesh filter need to use the same sensor model!");
+
+  // guards against concurrent additions, which would hand out the same handle
+  std::unique_lock<std::mutex> _(meshes_mutex_);
+
+  SensorModel::ParametersPtr parameters(sensor_parameters.clone());
+  JobPtr job = std::make_shared<FilterJob<void>>([this, parameters] {
+    Sensor sensor;
+    sensor.parameters = parameters;
+    initializeSensor(sensor);
+    sensors_.push_back(sensor);
+  });
+  addJob(job);
+  job->wait();
+  return sensor_count_++;
+}
+
+void mesh_filter::MeshFilterBase::checkSensor(SensorHandle sensor) const
+{
+  if (sensor >= sensor_count_)
+  {
+    std::stringstream msg;
+    msg << "unknown sensor handle \"" << sensor << "\".";
+    throw std::runtime_error(msg.str());
+  }
 }
 
 void mesh_filter::MeshFilterBase::setTransformCallback(const TransformCallback& transform_callback)
@@ -221,18 +264,31 @@ void mesh_filter::MeshFilterBase::setShadowThreshold(float threshold)
 
 void mesh_filter::MeshFilterBase::getModelLabels(LabelType* labels) const
 {
-  JobPtr job(new FilterJob<void>(
-      [&renderer = *mesh_renderer_, labels] { renderer.getColorBuffer(reinterpret_cast<unsigned char*>(labels)); }));
+  getModelLabels(0, labels);
+}
+
+void mesh_filter::MeshFilterBase::getModelLabels(SensorHandle sensor, LabelType* labels) const
+{
+  checkSensor(sensor);
+  JobPtr job(new FilterJob<void>([this, sensor, labels] {
+    sensors_[sensor].mesh_renderer->getColorBuffer(reinterpret_cast<unsigned char*>(labels));
+  }));
   addJob(job);
   job->wait();
 }
 
 void mesh_filter::MeshFilterBase::getModelDepth(float* depth) const
 {
-  JobPtr job1 =
-      std::make_shared<FilterJob<void>>([&renderer = *mesh_renderer_, depth] { renderer.getDepthBuffer(depth); });
+  getModelDepth(0, depth);
+}
+
+void mesh_filter::MeshFilterBase::getModelDepth(SensorHandle sensor, float* depth) const
+{
+  checkSensor(sensor);
+  JobPtr job1 = std::make_shared<FilterJob<void>>(
+      [this, sensor, depth] { sensors_[sensor].mesh_renderer->getDepthBuffer(depth); });
   JobPtr job2 = std::make_shared<FilterJob<void>>(
-      [&parameters = *sensor_parameters_, depth] { parameters.transformModelDepthToMetricDepth(depth); });
+      [this, sensor, depth] { sensors_[sensor].parameters->transformModelDepthToMetricDepth(depth); });
   {
     std::unique_lock<std::mutex> lock(jobs_mutex_);
     jobs_queue_.push(job1);
@@ -245,9 +301,16 @@ void mesh_filter::MeshFilterBase::getModelDepth(float* depth) const
 
 void mesh_filter::MeshFilterBase::getFilteredDepth(float* depth) const
 {
-  JobPtr job1 = std::make_shared<FilterJob<void>>([&filter = *depth_filter_, depth] { filter.getDepthBuffer(depth); });
+  getFilteredDepth(0, depth);
+}
+
+void mesh_filter::MeshFilterBase::getFilteredDepth(SensorHandle sensor, float* depth) const
+{
+  checkSensor(sensor);
+  JobPtr job1 = std::make_shared<FilterJob<void>>(
+      [this, sensor, depth] { sensors_[sensor].depth_filter->getDepthBuffer(depth); });
   JobPtr job2 = std::make_shared<FilterJob<void>>(
-      [&parameters = *sensor_parameters_, depth] { parameters.transformFilteredDepthToMetricDepth(depth); });
+      [this, sensor, depth] { sensors_[sensor].parameters->transformFilteredDepthToMetricDepth(depth); });
   {
     std::unique_lock<std::mutex> lock(jobs_mutex_);
     jobs_queue_.push(job1);
@@ -260,18 +323,26 @@ void mesh_filter::MeshFilterBase::getFilteredDepth(float* depth) const
 
 void mesh_filter::MeshFilterBase::getFilteredLabels(LabelType* labels) const
 {
-  JobPtr job = std::make_shared<FilterJob<void>>(
-      [&filter = *depth_filter_, labels] { filter.getColorBuffer(reinterpret_cast<unsigned char*>(labels)); });
+  getFilteredLabels(0, labels);
+}
+
+void mesh_filter::MeshFilterBase::getFilteredLabels(SensorHandle sensor, LabelType* labels) const
+{
+  checkSensor(sensor);
+  JobPtr job = std::make_shared<FilterJob<void>>([this, sensor, labels, async = async_label_readback_] {
+    GLRenderer& filter = *sensors_[sensor].depth_filter;
+    if (async)
+      filter.readColorBufferTransfer(reinterpret_cast<unsigned char*>(labels));
+    else
+      filter.getColorBuffer(reinterpret_cast<unsigned char*>(labels));
+  });
   addJob(job);
   job->wait();
 }
 
-void mesh_filter::MeshFilterBase::run(const std::string& render_vertex_shader,
-                                      const std::string& render_fragment_shader,
-                                      const std::string& filter_vertex_shader,
-                                      const std::string& filter_fragment_shader)
+void mesh_filter::MeshFilterBase::run()
 {
-  initialize(render_vertex_shader, render_fragment_shader, filter_vertex_shader, filter_fragment_shader);
+  initialize();
 
   while (!stop_)
   {
@@ -301,18 +372,69 @@ void mesh_filter::MeshFilterBase::filter(const void* sensor_data, GLushort type,
     throw std::runtime_error(msg.str());
   }
 
-  JobPtr job = std::make_shared<FilterJob<void>>([this, sensor_data, type] { doFilter(sensor_data, type); });
+  SensorInput input;
+  input.sensor = 0;
+  input.data = sensor_data;
+  input.type = type;
+  filter(std::vector<SensorInput>{ input }, wait);
+}
+
+void mesh_filter::MeshFilterBase::filter(const std::vector<SensorInput>& inputs, bool wait) const
+{
+  for (const SensorInput& input : inputs)
+  {
+    checkSensor(input.sensor);
+    if (input.type != GL_FLOAT && input.type != GL_UNSIGNED_SHORT)
+    {
+      std::stringstream msg;
+      msg << "unknown type \"" << input.type << "\". Allowed values are GL_FLOAT or GL_UNSIGNED_SHORT.";
+      throw std::runtime_error(msg.str());
+    }
+  }
+
+  JobPtr job = std::make_shared<FilterJob<void>>([this, inputs] { doFilter(inputs); });
   addJob(job);
   if (wait)
     job->wait();
 }
 
-void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int encoding) const
+void mesh_filter::MeshFilterBase::doFilter(const std::vector<SensorInput>& inputs) const
 {
-  std::unique_lock<std::mutex> _(transform_callback_mutex_);
+  std::vector<std::pair<const GLMesh*, Eigen::Isometry3d>> mesh_transforms;
+  std::vector<std::pair<const GLMesh*, Eigen::Isometry3d>> sensor_mesh_transforms;
+  mesh_transforms.reserve(meshes_.size());
+  {
+    // query every transformation once for the whole batch
+    std::unique_lock<std::mutex> _(transform_callback_mutex_);
+    Eigen::Isometry3d transform;
+    for (const std::pair<const MeshHandle, GLMeshPtr>& mesh : meshes_)
+    {
+      if (transform_callback_(mesh.first, transform))
+        mesh_transforms.emplace_back(mesh.second.get(), transform);
+    }
+  }
+
+  for (const SensorInput& input : inputs)
+  {
+    const Eigen::Isometry3d sensor_pose_inverse = input.pose.inverse();
+    sensor_mesh_transforms.clear();
+    for (const std::pair<const GLMesh*, Eigen::Isometry3d>& mesh_transform : mesh_transforms)
+      sensor_mesh_transforms.emplace_back(mesh_transform.first, sensor_pose_inverse * mesh_transform.second);
+
+    filterSensor(sensors_[input.sensor], sensor_mesh_transforms, input.data, input.type);
+  }
+}
+
+void mesh_filter::MeshFilterBase::filterSensor(
+    const Sensor& sensor, const std::vector<std::pair<const GLMesh*, Eigen::Isometry3d>>& mesh_transforms,
+    const void* sensor_data, const int encoding) const
+{
+  const SensorModel::Parameters& parameters = *sensor.parameters;
+  GLRenderer& mesh_renderer = *sensor.mesh_renderer;
+  GLRenderer& depth_filter = *sensor.depth_filter;
 
-  mesh_renderer_->begin();
-  sensor_parameters_->setRenderParameters(*mesh_renderer_);
+  mesh_renderer.begin();
+  parameters.setRenderParameters(mesh_renderer);
 
   glEnable(GL_TEXTURE_2D);
   glEnable(GL_DEPTH_TEST);
@@ -322,25 +444,21 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   glDisable(GL_ALPHA_TEST);
   glDisable(GL_BLEND);
 
-  GLuint padding_coefficients_id = glGetUniformLocation(mesh_renderer_->getProgramID(), "padding_coefficients");
+  GLuint padding_coefficients_id = glGetUniformLocation(mesh_renderer.getProgramID(), "padding_coefficients");
   Eigen::Vector3f padding_coefficients =
-      sensor_parameters_->getPaddingCoefficients() * padding_scale_ + Eigen::Vector3f(0, 0, padding_offset_);
+      parameters.getPaddingCoefficients() * padding_scale_ + Eigen::Vector3f(0, 0, padding_offset_);
   glUniform3f(padding_coefficients_id, padding_coefficients[0], padding_coefficients[1], padding_coefficients[2]);
 
-  Eigen::Isometry3d transform;
-  for (const std::pair<const MeshHandle, GLMeshPtr>& mesh : meshes_)
-  {
-    if (transform_callback_(mesh.first, transform))
-      mesh.second->render(transform);
-  }
+  for (const std::pair<const GLMesh*, Eigen::Isometry3d>& mesh_transform : mesh_transforms)
+    mesh_transform.first->render(mesh_transform.second);
 
-  mesh_renderer_->end();
+  mesh_renderer.end();
 
   // now filter the depth_map with the second rendering stage
   // depth_filter_.setBufferSize (width, height);
   // depth_filter_.setCameraParameters (fx, fy, cx, cy);
-  depth_filter_->begin();
-  sensor_parameters_->setFilterParameters(*depth_filter_);
+  depth_filter.begin();
+  parameters.setFilterParameters(depth_filter);
   glEnable(GL_TEXTURE_2D);
   glEnable(GL_DEPTH_TEST);
   glDepthFunc(GL_ALWAYS);
@@ -350,17 +468,16 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
 
   //  glUniform1f (near_location_, depth_filter_.getNearClippingDistance ());
   //  glUniform1f (far_location_, depth_filter_.getFarClippingDistance ());
-  glUniform1f(shadow_threshold_location_, shadow_threshold_);
+  glUniform1f(sensor.shadow_threshold_location, shadow_threshold_);
 
-  GLuint depth_texture = mesh_renderer_->getDepthTexture();
-  GLuint color_texture = mesh_renderer_->getColorTexture();
+  GLuint depth_texture = mesh_renderer.getDepthTexture();
+  GLuint color_texture = mesh_renderer.getColorTexture();
 
   // bind sensor depth
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, sensor_depth_texture_);
+  glBindTexture(GL_TEXTURE_2D, sensor.sensor_depth_texture);
 
-  float scale =
-      1.0 / (sensor_parameters_->getFarClippingPlaneDistance() - sensor_parameters_->getNearClippingPlaneDistance());
+  float scale = 1.0 / (parameters.getFarClippingPlaneDistance() - parameters.getNearClippingPlaneDistance());
 
   if (encoding == GL_UNSIGNED_SHORT)
   {
@@ -375,9 +492,9 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   {
     glPixelTransferf(GL_DEPTH_SCALE, scale);
   }
-  glPixelTransferf(GL_DEPTH_BIAS, -scale * sensor_parameters_->getNearClippingPlaneDistance());
+  glPixelTransferf(GL_DEPTH_BIAS, -scale * parameters.getNearClippingPlaneDistance());
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, sensor_parameters_->getWidth(), sensor_parameters_->getHeight(), 0,
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, parameters.getWidth(), parameters.getHeight(), 0,
                GL_DEPTH_COMPONENT, encoding, sensor_data);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -392,7 +509,11 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   glActiveTexture(GL_TEXTURE4);
   glBindTexture(GL_TEXTURE_2D, color_texture);
   glCallList(canvas_);
-  depth_filter_->end();
+  depth_filter.end();
+
+  // queued right away, so the transfer overlaps with filtering the other sensors of the batch
+  if (async_label_readback_)
+    depth_filter.startColorBufferTransfer();
 }
 
 void mesh_filter::MeshFilterBase::setPaddingOffset(float offset)
@@ -404,3 +525,8 @@ void mesh_filter::MeshFilterBase::setPaddingScale(float scale)
 {
   padding_scale_ = scale;
 }
+
+void mesh_filter::MeshFilterBase::setAsyncLabelReadback(bool enable)
+{
+  async_label_readback_ = enable;
+}
@@ -41,10 +41,12 @@
 #include <tf2_ros/message_filter.h>
 #include <message_filters/subscriber.h>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <moveit/occupancy_map_monitor/occupancy_map_integrator.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
 #include <moveit/point_containment_filter/shape_mask.h>
 
 #include <memory>
+#include <vector>
 
 namespace occupancy_map_monitor
 {
@@ -68,7 +70,13 @@ protected:
 
 private:
   bool getShapeTransform(ShapeHandle h, Eigen::Isometry3d& transform) const;
+  /* label the points of an organized cloud with the GPU mesh filter instead of the ShapeMask, filling mask_.
+     Returns false if the cloud cannot be rendered as a depth image, in which case the ShapeMask is used */
+  bool maskWithMeshFilter(const sensor_msgs::msg::PointCloud2& cloud);
+  void createMeshFilter();
   void cloudMsgCallback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& cloud_msg);
+  void publishFilteredCloud(std::unique_ptr<sensor_msgs::msg::PointCloud2> filtered_cloud,
+                            std::size_t filtered_cloud_size);
   void stopHelper();
 
   // TODO: Enable private node for publishing filtered point cloud
@@ -89,18 +97,43 @@ private:
   double max_range_;
   unsigned int point_subsample_;
   double max_update_rate_;
+  unsigned int num_threads_;
+  double integration_latency_budget_;
   std::string filtered_cloud_topic_;
   std::string ns_;
+  bool use_mesh_filter_;
+  double near_clipping_plane_distance_;
+  double far_clipping_plane_distance_;
+  double shadow_threshold_;
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr filtered_cloud_publisher_;
 
   message_filters::Subscriber<sensor_msgs::msg::PointCloud2>* point_cloud_subscriber_;
   tf2_ros::MessageFilter<sensor_msgs::msg::PointCloud2>* point_cloud_filter_;
 
   /* used to store all cells in the map which a given ray passes through during raycasting.
-     we cache this here because it dynamically pre-allocates a lot of memory in its constructor */
-  octomap::KeyRay key_ray_;
+     we cache this here because it dynamically pre-allocates a lot of memory in its constructor.
+     There is one per thread used for ray casting */
+  std::vector<octomap::KeyRay> key_rays_;
+
+  /* per-callback buffers, kept between callbacks to avoid reallocating them for every cloud.
+     The points that survive subsampling and the NaN check are stored contiguously, one column per point */
+  Eigen::Matrix3Xd sensor_points_;
+  Eigen::Matrix3Xd map_points_;
+  std::vector<int> point_mask_;
+  std::vector<std::size_t> point_indices_;
+  std::vector<octomap::OcTreeKey> point_keys_;
+  std::vector<octomap::OcTreeKey> ray_ends_;
+  std::vector<octomap::KeySet> thread_free_cells_;
+
+  /* applies the cells of each cloud on its own thread if integration_latency_budget is positive */
+  std::unique_ptr<OccupancyMapIntegrator> integrator_;
 
   std::unique_ptr<point_containment_filter::ShapeMask> shape_mask_;
   std::vector<int> mask_;
+
+  /* the mesh filter is only available if moveit_ros_perception is built with OpenGL,
+     so its state is defined in the source file */
+  struct MeshFilterState;
+  std::unique_ptr<MeshFilterState> mesh_filter_state_;
 };
 }  // namespace occupancy_map_monitor
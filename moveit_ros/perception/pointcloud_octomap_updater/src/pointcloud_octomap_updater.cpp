@@ -44,11 +44,42 @@
 #include <tf2_ros/create_timer_interface.h>
 #include <tf2_ros/create_timer_ros.h>
 
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+#include <geometric_shapes/shape_operations.h>
+#include <moveit/mesh_filter/mesh_filter.h>
+#include <moveit/mesh_filter/stereo_camera_model.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace occupancy_map_monitor
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.perception.pointcloud_octomap_updater");
+
+// mask value of points the mesh filter rejects without classifying them, e.g. points closer than the near plane
+static const int MASK_IGNORED = -1;
+
+struct PointCloudOctomapUpdater::MeshFilterState
+{
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+  std::unique_ptr<mesh_filter::MeshFilter<mesh_filter::StereoCameraModel>> mesh_filter;
+
+  /* excludeShape() hands out ShapeMask handles, so the ShapeMask stays usable for unorganized clouds.
+     These map them to and from the handles of the same shapes in the mesh filter */
+  std::mutex handles_lock;
+  std::map<ShapeHandle, mesh_filter::MeshHandle> mesh_handles;
+  std::map<mesh_filter::MeshHandle, ShapeHandle> shape_handles;
+
+  std::vector<float> depth;
+  std::vector<mesh_filter::LabelType> labels;
+#endif
+};
+
 PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   : OccupancyMapUpdater("PointCloudUpdater")
   , scale_(1.0)
@@ -56,6 +87,12 @@ PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   , max_range_(std::numeric_limits<double>::infinity())
   , point_subsample_(1)
   , max_update_rate_(0)
+  , num_threads_(1)
+  , integration_latency_budget_(0.0)
+  , use_mesh_filter_(false)
+  , near_clipping_plane_distance_(0.3)
+  , far_clipping_plane_distance_(5.0)
+  , shadow_threshold_(0.04)
   , point_cloud_subscriber_(nullptr)
   , point_cloud_filter_(nullptr)
 {
@@ -70,13 +107,61 @@ bool PointCloudOctomapUpdater::setParams(const std::string& name_space)
 {
   // This parameter is optional
   node_->get_parameter_or(name_space + ".ns", ns_, std::string());
-  return node_->get_parameter(name_space + ".point_cloud_topic", point_cloud_topic_) &&
-         node_->get_parameter(name_space + ".max_range", max_range_) &&
-         node_->get_parameter(name_space + ".padding_offset", padding_) &&
-         node_->get_parameter(name_space + ".padding_scale", scale_) &&
-         node_->get_parameter(name_space + ".point_subsample", point_subsample_) &&
-         node_->get_parameter(name_space + ".max_update_rate", max_update_rate_) &&
-         node_->get_parameter(name_space + ".filtered_cloud_topic", filtered_cloud_topic_);
+  // Number of threads for key and ray computation: 1 keeps the callback single threaded, 0 uses all cores
+  int num_threads = 1;
+  node_->get_parameter_or(name_space + ".num_threads", num_threads, 1);
+  num_threads_ = num_threads > 0 ? static_cast<unsigned int>(num_threads) : std::thread::hardware_concurrency();
+  num_threads_ = std::max(num_threads_, 1u);
+  // With a positive latency budget (in seconds), the octree is updated on a separate integrator thread
+  node_->get_parameter_or(name_space + ".integration_latency_budget", integration_latency_budget_, 0.0);
+  if (integration_latency_budget_ > 0.0)
+    integrator_ = std::make_unique<OccupancyMapIntegrator>(tree_, integration_latency_budget_);
+  // Optionally filter organized clouds on the GPU, with the same mesh filter as the depth image updater
+  node_->get_parameter_or(name_space + ".use_mesh_filter", use_mesh_filter_, false);
+  node_->get_parameter_or(name_space + ".near_clipping_plane_distance", near_clipping_plane_distance_, 0.3);
+  node_->get_parameter_or(name_space + ".far_clipping_plane_distance", far_clipping_plane_distance_, 5.0);
+  node_->get_parameter_or(name_space + ".shadow_threshold", shadow_threshold_, 0.04);
+  const bool ok = node_->get_parameter(name_space + ".point_cloud_topic", point_cloud_topic_) &&
+                  node_->get_parameter(name_space + ".max_range", max_range_) &&
+                  node_->get_parameter(name_space + ".padding_offset", padding_) &&
+                  node_->get_parameter(name_space + ".padding_scale", scale_) &&
+                  node_->get_parameter(name_space + ".point_subsample", point_subsample_) &&
+                  node_->get_parameter(name_space + ".max_update_rate", max_update_rate_) &&
+                  node_->get_parameter(name_space + ".filtered_cloud_topic", filtered_cloud_topic_);
+  if (ok && use_mesh_filter_)
+    createMeshFilter();
+  return ok;
+}
+
+void PointCloudOctomapUpdater::createMeshFilter()
+{
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+  // Render up to max_range, if it is set, so that points beyond it are labeled as clipped
+  const double far_clipping_plane_distance = std::isfinite(max_range_) ? max_range_ : far_clipping_plane_distance_;
+
+  mesh_filter_state_ = std::make_unique<MeshFilterState>();
+  auto& mesh_filter = mesh_filter_state_->mesh_filter;
+  mesh_filter = std::make_unique<mesh_filter::MeshFilter<mesh_filter::StereoCameraModel>>(
+      mesh_filter::MeshFilterBase::TransformCallback(), mesh_filter::StereoCameraModel::REGISTERED_PSDK_PARAMS);
+  mesh_filter->parameters().setDepthRange(near_clipping_plane_distance_, far_clipping_plane_distance);
+  mesh_filter->setShadowThreshold(shadow_threshold_);
+  mesh_filter->setPaddingOffset(padding_);
+  mesh_filter->setPaddingScale(scale_);
+  mesh_filter->setTransformCallback([this](mesh_filter::MeshHandle mesh, Eigen::Isometry3d& tf) {
+    ShapeHandle shape;
+    {
+      std::scoped_lock _(mesh_filter_state_->handles_lock);
+      auto it = mesh_filter_state_->shape_handles.find(mesh);
+      if (it == mesh_filter_state_->shape_handles.end())
+        return false;
+      shape = it->second;
+    }
+    return getShapeTransform(shape, tf);
+  });
+#else
+  RCLCPP_WARN(LOGGER, "moveit_ros_perception was built without OpenGL, use_mesh_filter is ignored and the robot "
+                      "is filtered from point clouds on the CPU");
+#endif
 }
 
 bool PointCloudOctomapUpdater::initialize(const rclcpp::Node::SharedPtr& node)
@@ -153,6 +238,29 @@ ShapeHandle PointCloudOctomapUpdater::excludeShape(const shapes::ShapeConstPtr&
   {
     RCLCPP_ERROR(LOGGER, "Shape filter not yet initialized!");
   }
+
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+  if (h && mesh_filter_state_)
+  {
+    mesh_filter::MeshHandle mesh_handle = 0;
+    if (shape->type == shapes::MESH)
+    {
+      mesh_handle = mesh_filter_state_->mesh_filter->addMesh(static_cast<const shapes::Mesh&>(*shape));
+    }
+    else
+    {
+      std::unique_ptr<shapes::Mesh> m(shapes::createMeshFromShape(shape.get()));
+      if (m)
+        mesh_handle = mesh_filter_state_->mesh_filter->addMesh(*m);
+    }
+    if (mesh_handle)
+    {
+      std::scoped_lock _(mesh_filter_state_->handles_lock);
+      mesh_filter_state_->mesh_handles[h] = mesh_handle;
+      mesh_filter_state_->shape_handles[mesh_handle] = h;
+    }
+  }
+#endif
   return h;
 }
 
@@ -160,6 +268,23 @@ void PointCloudOctomapUpdater::forgetShape(ShapeHandle handle)
 {
   if (shape_mask_)
     shape_mask_->removeShape(handle);
+
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+  if (mesh_filter_state_)
+  {
+    mesh_filter::MeshHandle mesh_handle = 0;
+    {
+      std::scoped_lock _(mesh_filter_state_->handles_lock);
+      auto it = mesh_filter_state_->mesh_handles.find(handle);
+      if (it == mesh_filter_state_->mesh_handles.end())
+        return;
+      mesh_handle = it->second;
+      mesh_filter_state_->shape_handles.erase(mesh_handle);
+      mesh_filter_state_->mesh_handles.erase(it);
+    }
+    mesh_filter_state_->mesh_filter->removeMesh(mesh_handle);
+  }
+#endif
 }
 
 bool PointCloudOctomapUpdater::getShapeTransform(ShapeHandle h, Eigen::Isometry3d& transform) const
@@ -172,6 +297,90 @@ bool PointCloudOctomapUpdater::getShapeTransform(ShapeHandle h, Eigen::Isometry3
   return it != transform_cache_.end();
 }
 
+bool PointCloudOctomapUpdater::maskWithMeshFilter(const sensor_msgs::msg::PointCloud2& cloud)
+{
+#ifdef MOVEIT_POINTCLOUD_OCTOMAP_UPDATER_MESH_FILTER
+  const unsigned int w = cloud.width;
+  const unsigned int h = cloud.height;
+  const std::size_t img_size = static_cast<std::size_t>(w) * h;
+  if (h < 2 || w < 2)
+    return false;
+
+  /* render the cloud as a depth image. An organized cloud computed from a depth image satisfies
+     col = fx * x / z + cx and row = fy * y / z + cy, so the pinhole parameters follow from a least squares fit */
+  std::vector<float>& depth = mesh_filter_state_->depth;
+  depth.resize(img_size);
+  double n = 0.0, sum_a = 0.0, sum_aa = 0.0, sum_u = 0.0, sum_au = 0.0;
+  double sum_b = 0.0, sum_bb = 0.0, sum_v = 0.0, sum_bv = 0.0;
+  sensor_msgs::PointCloud2ConstIterator<float> pt_iter(cloud, "x");
+  for (unsigned int row = 0; row < h; ++row)
+  {
+    for (unsigned int col = 0; col < w; ++col, ++pt_iter)
+    {
+      const float z = pt_iter[2];
+      if (std::isnan(pt_iter[0]) || std::isnan(pt_iter[1]) || !(z > 0.0f))
+      {
+        // the mesh filter labels pixels without a reading as NEAR_CLIP
+        depth[row * w + col] = 0.0f;
+        continue;
+      }
+      depth[row * w + col] = z;
+      const double a = pt_iter[0] / z;
+      const double b = pt_iter[1] / z;
+      n += 1.0;
+      sum_a += a;
+      sum_aa += a * a;
+      sum_u += col;
+      sum_au += a * col;
+      sum_b += b;
+      sum_bb += b * b;
+      sum_v += row;
+      sum_bv += b * row;
+    }
+  }
+
+  const double den_x = n * sum_aa - sum_a * sum_a;
+  const double den_y = n * sum_bb - sum_b * sum_b;
+  if (n < 2.0 || !(den_x > 0.0) || !(den_y > 0.0))
+    return false;
+  const double fx = (n * sum_au - sum_a * sum_u) / den_x;
+  const double fy = (n * sum_bv - sum_b * sum_v) / den_y;
+  if (!(fx > 0.0) || !(fy > 0.0))
+    return false;
+  const double cx = (sum_u - fx * sum_a) / n;
+  const double cy = (sum_v - fy * sum_b) / n;
+
+  auto& mesh_filter = *mesh_filter_state_->mesh_filter;
+  mesh_filter::StereoCameraModel::Parameters& params = mesh_filter.parameters();
+  params.setCameraParameters(fx, fy, cx, cy);
+  params.setImageSize(w, h);
+  mesh_filter.filter(depth.data(), GL_FLOAT);
+
+  std::vector<mesh_filter::LabelType>& labels = mesh_filter_state_->labels;
+  labels.resize(img_size);
+  mesh_filter.getFilteredLabels(labels.data());
+
+  /* translate the labels to ShapeMask values: shadowed points are real obstacles behind the robot,
+     points on the far plane or beyond are clipped and labeled meshes are part of the robot */
+  mask_.resize(img_size);
+  for (std::size_t i = 0; i < img_size; ++i)
+  {
+    if (labels[i] == mesh_filter::MeshFilterBase::BACKGROUND || labels[i] == mesh_filter::MeshFilterBase::SHADOW)
+      mask_[i] = point_containment_filter::ShapeMask::OUTSIDE;
+    else if (labels[i] == mesh_filter::MeshFilterBase::FAR_CLIP)
+      mask_[i] = point_containment_filter::ShapeMask::CLIP;
+    else if (labels[i] > mesh_filter::MeshFilterBase::FAR_CLIP)
+      mask_[i] = point_containment_filter::ShapeMask::INSIDE;
+    else
+      mask_[i] = MASK_IGNORED;
+  }
+  return true;
+#else
+  (void)cloud;
+  return false;
+#endif
+}
+
 void PointCloudOctomapUpdater::updateMask(const sensor_msgs::msg::PointCloud2& /*cloud*/,
                                           const Eigen::Vector3d& /*sensor_origin*/, std::vector<int>& /*mask*/)
 {
@@ -228,7 +437,14 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
     return;
 
   /* mask out points on the robot */
-  shape_mask_->maskContainment(*cloud_msg, sensor_origin_eigen, 0.0, max_range_, mask_);
+  double clip_range = max_range_;
+  if (mesh_filter_state_ && maskWithMeshFilter(*cloud_msg))
+  {
+    // the far clipping plane of the mesh filter takes the role of max_range
+    clip_range = std::isfinite(max_range_) ? max_range_ : far_clipping_plane_distance_;
+  }
+  else
+    shape_mask_->maskContainment(*cloud_msg, sensor_origin_eigen, 0.0, max_range_, mask_);
   updateMask(*cloud_msg, sensor_origin_eigen, mask_);
 
   octomap::KeySet free_cells, occupied_cells, model_cells, clip_cells;
@@ -256,91 +472,142 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
   }
   size_t filtered_cloud_size = 0;
 
-  tree_->lockRead();
-
-  try
+  /* gather the subsampled points that are not NaN into a contiguous buffer, one column per point.
+     Clipped points are replaced by the point at max range along their ray, so that all points can be
+     transformed into the map frame with a single matrix product */
+  const std::size_t max_points =
+      static_cast<std::size_t>((cloud_msg->height + point_subsample_ - 1) / point_subsample_) *
+      ((cloud_msg->width + point_subsample_ - 1) / point_subsample_);
+  sensor_points_.resize(3, max_points);
+  point_mask_.resize(max_points);
+  point_indices_.resize(max_points);
+  std::size_t num_points = 0;
+  for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
   {
-    /* do ray tracing to find which cells this point cloud indicates should be free, and which it indicates
-     * should be occupied */
-    for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
+    unsigned int row_c = row * cloud_msg->width;
+    sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+    // set iterator to point at start of the current row
+    pt_iter += row_c;
+
+    for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
     {
-      unsigned int row_c = row * cloud_msg->width;
-      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
-      // set iterator to point at start of the current row
-      pt_iter += row_c;
+      /* check for NaN */
+      if (std::isnan(pt_iter[0]) || std::isnan(pt_iter[1]) || std::isnan(pt_iter[2]))
+        continue;
+
+      const int mask = mask_[row_c + col];
+      if (mask == MASK_IGNORED)
+        continue;
+      auto point = sensor_points_.col(num_points);
+      point << pt_iter[0], pt_iter[1], pt_iter[2];
+      if (mask == point_containment_filter::ShapeMask::CLIP)
+        point = point.normalized() * clip_range;
+      point_mask_[num_points] = mask;
+      point_indices_[num_points] = row_c + col;
+      ++num_points;
+    }
+  }
 
-      for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
-      {
-        // if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-        //  continue;
+  /* transform all points to the map frame at once */
+  Eigen::Matrix3d map_r_sensor;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      map_r_sensor(i, j) = map_h_sensor.getBasis()[i][j];
+  map_points_.resize(3, num_points);
+  map_points_.noalias() = map_r_sensor * sensor_points_.leftCols(num_points);
+  map_points_.colwise() += Eigen::Vector3d(sensor_origin_tf.getX(), sensor_origin_tf.getY(), sensor_origin_tf.getZ());
 
-        /* check for NaN */
-        if (!std::isnan(pt_iter[0]) && !std::isnan(pt_iter[1]) && !std::isnan(pt_iter[2]))
-        {
-          /* occupied cell at ray endpoint if ray is shorter than max range and this point
-             isn't on a part of the robot*/
-          if (mask_[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
-          {
-            // transform to map frame
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
-            model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-          else if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-          {
-            tf2::Vector3 clipped_point_tf =
-                map_h_sensor * (tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]).normalize() * max_range_);
-            clip_cells.insert(
-                tree_->coordToKey(clipped_point_tf.getX(), clipped_point_tf.getY(), clipped_point_tf.getZ()));
-          }
-          else
-          {
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
-            occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-            // build list of valid points if we want to publish them
-            if (filtered_cloud)
-            {
-              **iter_filtered_x = pt_iter[0];
-              **iter_filtered_y = pt_iter[1];
-              **iter_filtered_z = pt_iter[2];
-              ++filtered_cloud_size;
-              ++*iter_filtered_x;
-              ++*iter_filtered_y;
-              ++*iter_filtered_z;
-            }
-          }
-        }
-      }
+  /* build list of valid points if we want to publish them */
+  if (filtered_cloud)
+  {
+    sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      if (point_mask_[i] != point_containment_filter::ShapeMask::OUTSIDE)
+        continue;
+      const sensor_msgs::PointCloud2ConstIterator<float> filtered_pt = pt_iter + point_indices_[i];
+      **iter_filtered_x = filtered_pt[0];
+      **iter_filtered_y = filtered_pt[1];
+      **iter_filtered_z = filtered_pt[2];
+      ++filtered_cloud_size;
+      ++*iter_filtered_x;
+      ++*iter_filtered_y;
+      ++*iter_filtered_z;
     }
+  }
 
-    /* compute the free cells along each ray that ends at an occupied cell */
-    for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
+  // Work is split into one strided chunk per thread, so every thread owns its own ray and free cell buffers
+  const unsigned int thread_count = num_threads_;
+  key_rays_.resize(thread_count);
+  thread_free_cells_.resize(thread_count);
+  std::atomic<bool> failed(false);
+
+  tree_->lockRead();
+
+  try
+  {
+    /* find the cell of every ray endpoint */
+    point_keys_.resize(num_points);
+#pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long i = 0; i < static_cast<long>(num_points); ++i)
+      point_keys_[i] = tree_->coordToKey(map_points_(0, i), map_points_(1, i), map_points_(2, i));
+
+    /* occupied cell at ray endpoint if ray is shorter than max range and this point
+       isn't on a part of the robot */
+    for (std::size_t i = 0; i < num_points; ++i)
     {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(occupied_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+      if (point_mask_[i] == point_containment_filter::ShapeMask::INSIDE)
+        model_cells.insert(point_keys_[i]);
+      else if (point_mask_[i] == point_containment_filter::ShapeMask::CLIP)
+        clip_cells.insert(point_keys_[i]);
+      else
+        occupied_cells.insert(point_keys_[i]);
     }
 
-    /* compute the free cells along each ray that ends at a model cell */
-    for (const octomap::OcTreeKey& model_cell : model_cells)
+    /* compute the free cells along each ray that ends at an occupied, model or clipped cell */
+    ray_ends_.clear();
+    ray_ends_.insert(ray_ends_.end(), occupied_cells.begin(), occupied_cells.end());
+    ray_ends_.insert(ray_ends_.end(), model_cells.begin(), model_cells.end());
+    ray_ends_.insert(ray_ends_.end(), clip_cells.begin(), clip_cells.end());
+
+#pragma omp parallel for num_threads(thread_count) schedule(static, 1)
+    for (unsigned int t = 0; t < thread_count; ++t)
     {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(model_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+      // exceptions must not leave the parallel region
+      try
+      {
+        octomap::KeyRay& key_ray = key_rays_[t];
+        octomap::KeySet& thread_free_cells = thread_free_cells_[t];
+        thread_free_cells.clear();
+        for (std::size_t i = t; i < ray_ends_.size(); i += thread_count)
+        {
+          if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(ray_ends_[i]), key_ray))
+            thread_free_cells.insert(key_ray.begin(), key_ray.end());
+        }
+      }
+      catch (...)
+      {
+        failed = true;
+      }
     }
 
-    /* compute the free cells along each ray that ends at a clipped cell */
-    for (const octomap::OcTreeKey& clip_cell : clip_cells)
+    if (!failed)
     {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(clip_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+      free_cells.swap(thread_free_cells_[0]);
+      for (unsigned int t = 1; t < thread_count; ++t)
+        free_cells.insert(thread_free_cells_[t].begin(), thread_free_cells_[t].end());
     }
   }
   catch (...)
   {
-    tree_->unlockRead();
-    return;
+    failed = true;
   }
 
   tree_->unlockRead();
 
+  if (failed)
+    return;
+
   /* cells that overlap with the model are not occupied */
   for (const octomap::OcTreeKey& model_cell : model_cells)
     occupied_cells.erase(model_cell);
@@ -349,6 +616,14 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
   for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
     free_cells.erase(occupied_cell);
 
+  if (integrator_)
+  {
+    integrator_->pushUpdate(std::move(free_cells), std::move(occupied_cells), std::move(model_cells));
+    RCLCPP_DEBUG(LOGGER, "Computed point cloud update in %lf ms", (node_->now() - start).seconds() * 1000.0);
+    publishFilteredCloud(std::move(filtered_cloud), filtered_cloud_size);
+    return;
+  }
+
   tree_->lockWrite();
 
   try
@@ -374,6 +649,12 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
   RCLCPP_DEBUG(LOGGER, "Processed point cloud in %lf ms", (node_->now() - start).seconds() * 1000.0);
   tree_->triggerUpdateCallback();
 
+  publishFilteredCloud(std::move(filtered_cloud), filtered_cloud_size);
+}
+
+void PointCloudOctomapUpdater::publishFilteredCloud(std::unique_ptr<sensor_msgs::msg::PointCloud2> filtered_cloud,
+                                                    std::size_t filtered_cloud_size)
+{
   if (filtered_cloud)
   {
     sensor_msgs::PointCloud2Modifier pcd_modifier(*filtered_cloud);
@@ -40,6 +40,7 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <rclcpp/parameter_value.hpp>
+#include <algorithm>
 #include <memory>
 
 namespace constraint_sampler_manager_loader
@@ -51,6 +52,10 @@ class ConstraintSamplerManagerLoader::Helper
 public:
   Helper(const rclcpp::Node::SharedPtr& node, const constraint_samplers::ConstraintSamplerManagerPtr& csm) : node_(node)
   {
+    int64_t ik_sampler_thread_count;
+    if (node_->get_parameter("ik_constraint_sampler_thread_count", ik_sampler_thread_count))
+      csm->setIKSamplerThreadCount(static_cast<std::size_t>(std::max<int64_t>(ik_sampler_thread_count, 0)));
+
     if (node_->has_parameter("constraint_samplers"))
     {
       std::string constraint_samplers;
@@ -74,6 +79,7 @@ public:
         {
           constraint_samplers::ConstraintSamplerAllocatorPtr csa =
               constraint_sampler_plugin_loader_->createUniqueInstance(*beg);
+          csa->initialize(node_);
           csm->registerSamplerAllocator(csa);
           RCLCPP_INFO(LOGGER, "Loaded constraint sampling plugin %s", std::string(*beg).c_str());
         }
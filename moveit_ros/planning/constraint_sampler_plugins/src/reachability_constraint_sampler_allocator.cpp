@@ -0,0 +1,164 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/constraint_sampler_allocator.h>
+#include <moveit/constraint_samplers/constraint_sampler_manager.h>
+#include <moveit/constraint_samplers/reachability_constraint_sampler.h>
+#include <moveit/constraint_samplers/reachability_map.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <class_loader/class_loader.hpp>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <rclcpp/node.hpp>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace default_constraint_sampler_plugins
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.reachability_constraint_sampler_allocator");
+
+/**
+ * \brief Allocates ReachabilityConstraintSamplers for pose constraints of the groups listed in its parameters
+ *
+ * The reachability map of a group is built the first time a sampler is allocated for it. If a directory is
+ * configured, maps are read from and written to "<directory>/<robot>_<group>.rmap", so that later processes map the
+ * file into memory instead of building the map again.
+ *
+ * Parameters, in the "reachability_map" namespace of the node: groups, directory, resolution, sample_count,
+ * max_entries_per_cell and seeds_per_attempt.
+ */
+class ReachabilityConstraintSamplerAllocator : public constraint_samplers::ConstraintSamplerAllocator
+{
+public:
+  void initialize(const rclcpp::Node::SharedPtr& node) override
+  {
+    const std::string ns = "reachability_map.";
+    const constraint_samplers::ReachabilityMap::Options defaults;
+    int64_t sample_count, max_entries_per_cell, seeds_per_attempt;
+    node->get_parameter_or(ns + "groups", groups_, std::vector<std::string>());
+    node->get_parameter_or(ns + "directory", directory_, std::string());
+    node->get_parameter_or(ns + "resolution", options_.resolution, defaults.resolution);
+    node->get_parameter_or(ns + "sample_count", sample_count, static_cast<int64_t>(defaults.sample_count));
+    node->get_parameter_or(ns + "max_entries_per_cell", max_entries_per_cell,
+                           static_cast<int64_t>(defaults.max_entries_per_cell));
+    node->get_parameter_or(ns + "seeds_per_attempt", seeds_per_attempt, static_cast<int64_t>(seeds_per_attempt_));
+    options_.sample_count = static_cast<std::size_t>(std::max<int64_t>(sample_count, 1));
+    options_.max_entries_per_cell = static_cast<std::size_t>(std::max<int64_t>(max_entries_per_cell, 1));
+    seeds_per_attempt_ = static_cast<unsigned int>(std::max<int64_t>(seeds_per_attempt, 1));
+    if (groups_.empty())
+      RCLCPP_WARN(LOGGER, "No groups are listed in parameter '%sgroups', reachability maps will not be used",
+                  ns.c_str());
+  }
+
+  bool canService(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                  const moveit_msgs::msg::Constraints& constr) const override
+  {
+    if (!constr.joint_constraints.empty() ||
+        (constr.position_constraints.empty() && constr.orientation_constraints.empty()))
+      return false;
+    if (std::find(groups_.begin(), groups_.end(), group_name) == groups_.end())
+      return false;
+    const moveit::core::JointModelGroup* jmg = scene->getRobotModel()->getJointModelGroup(group_name);
+    return jmg && jmg->getSolverInstance();
+  }
+
+  constraint_samplers::ConstraintSamplerPtr alloc(const planning_scene::PlanningSceneConstPtr& scene,
+                                                  const std::string& group_name,
+                                                  const moveit_msgs::msg::Constraints& constr) override
+  {
+    const constraint_samplers::ReachabilityMapConstPtr map = getMap(scene->getRobotModel(), group_name);
+    if (map)
+    {
+      auto sampler = std::make_shared<constraint_samplers::ReachabilityConstraintSampler>(scene, group_name, map,
+                                                                                          seeds_per_attempt_);
+      if (sampler->configure(constr))
+        return sampler;
+    }
+    return constraint_samplers::ConstraintSamplerManager::selectDefaultSampler(scene, group_name, constr);
+  }
+
+private:
+  constraint_samplers::ReachabilityMapConstPtr getMap(const moveit::core::RobotModelConstPtr& robot_model,
+                                                      const std::string& group_name)
+  {
+    // building a map takes a while, so concurrent allocations wait for the first one to finish
+    std::scoped_lock lock(maps_lock_);
+    const std::string key = robot_model->getName() + "_" + group_name;
+    const auto it = maps_.find(key);
+    if (it != maps_.end())
+      return it->second;
+
+    constraint_samplers::ReachabilityMapConstPtr map;
+    std::string base_frame, tip_frame;
+    if (!constraint_samplers::ReachabilityConstraintSampler::getMapFrames(
+            robot_model->getJointModelGroup(group_name), base_frame, tip_frame))
+    {
+      RCLCPP_ERROR(LOGGER, "Group '%s' has no IK solver, no reachability map can be used", group_name.c_str());
+    }
+    else
+    {
+      // a file that does not match the robot is rebuilt and overwritten
+      const std::string filename = directory_.empty() ? std::string() : directory_ + "/" + key + ".rmap";
+      if (!filename.empty())
+        map = constraint_samplers::ReachabilityMap::readFromFile(filename, robot_model, group_name, base_frame,
+                                                                 tip_frame);
+      if (map)
+      {
+        RCLCPP_INFO(LOGGER, "Mapped reachability map '%s'", filename.c_str());
+      }
+      else
+      {
+        constraint_samplers::ReachabilityMapPtr built =
+            constraint_samplers::ReachabilityMap::build(robot_model, group_name, base_frame, tip_frame, options_);
+        if (built && !filename.empty())
+          built->writeToFile(filename);
+        map = built;
+      }
+    }
+    maps_[key] = map;
+    return map;
+  }
+
+  std::vector<std::string> groups_;
+  std::string directory_;
+  constraint_samplers::ReachabilityMap::Options options_;
+  unsigned int seeds_per_attempt_ = 3;
+  std::mutex maps_lock_;
+  std::map<std::string, constraint_samplers::ReachabilityMapConstPtr> maps_;
+};
+}  // namespace default_constraint_sampler_plugins
+
+CLASS_LOADER_REGISTER_CLASS(default_constraint_sampler_plugins::ReachabilityConstraintSamplerAllocator,
+                            constraint_samplers::ConstraintSamplerAllocator)
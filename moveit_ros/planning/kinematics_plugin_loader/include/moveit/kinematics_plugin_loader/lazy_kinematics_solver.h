@@ -0,0 +1,246 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/kinematics_base/kinematics_base.h>
+#include <moveit/robot_model/joint_model_group.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kinematics_plugin_loader
+{
+/** \brief Stands in for the kinematics solver of a chain group until the solver is needed
+ *
+ * Group, frames and joints of a chain are known from the robot model, so the joint model group can be configured
+ * without loading the solver plugin. The solver is created by the first query, or ahead of time by prewarm(), and all
+ * calls are forwarded to it from then on. The solver must report the chain's revolute and prismatic joints in group
+ * order, as the solvers of moveit_kinematics do. */
+class LazyKinematicsSolver : public kinematics::KinematicsBase
+{
+public:
+  using AllocatorFn = std::function<kinematics::KinematicsBasePtr(const moveit::core::JointModelGroup*)>;
+
+  LazyKinematicsSolver(const moveit::core::JointModelGroup* jmg, const std::string& base_frame,
+                       const std::vector<std::string>& tip_frames, double search_discretization, AllocatorFn allocator);
+
+  /** \brief Create the solver unless this has happened already */
+  void prewarm() const
+  {
+    getSolver();
+  }
+
+  bool getPositionIK(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                     std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
+                     const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
+    return false;
+  }
+
+  bool getPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                     std::vector<std::vector<double>>& solutions, kinematics::KinematicsResult& result,
+                     const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver())
+      return solver->getPositionIK(ik_poses, ik_seed_state, solutions, result, options);
+    result.kinematic_error = kinematics::KinematicErrors::SOLVER_NOT_ACTIVE;
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double timeout, std::vector<double>& solution, moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_pose, ik_seed_state, timeout, solution, error_code, options);
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double timeout, const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, error_code,
+                                      options);
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double timeout, std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                        moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_pose, ik_seed_state, timeout, solution, solution_callback, error_code,
+                                      options);
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double timeout, const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution,
+                                      solution_callback, error_code, options);
+    return false;
+  }
+
+  bool searchPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                        double timeout, const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options,
+                        const moveit::core::RobotState* context_state) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_poses, ik_seed_state, timeout, consistency_limits, solution,
+                                      solution_callback, error_code, options, context_state);
+    return false;
+  }
+
+  bool searchPositionIK(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                        double timeout, const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        const IKCallbackFn& solution_callback, const IKCostFn& cost_function,
+                        moveit_msgs::msg::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options,
+                        const moveit::core::RobotState* context_state) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver(error_code))
+      return solver->searchPositionIK(ik_poses, ik_seed_state, timeout, consistency_limits, solution,
+                                      solution_callback, cost_function, error_code, options, context_state);
+    return false;
+  }
+
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                             const std::vector<std::vector<double>>& ik_seed_states, double timeout,
+                             std::vector<std::vector<double>>& solutions,
+                             std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                             const IKCallbackFn& solution_callback,
+                             const kinematics::KinematicsQueryOptions& options) const override
+  {
+    if (const kinematics::KinematicsBasePtr& solver = getSolver())
+      return solver->searchPositionIKBatch(ik_poses, ik_seed_states, timeout, solutions, error_codes,
+                                           solution_callback, options);
+    solutions.resize(ik_poses.size());
+    error_codes.resize(ik_poses.size());
+    for (moveit_msgs::msg::MoveItErrorCodes& error_code : error_codes)
+      error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
+                     std::vector<geometry_msgs::msg::Pose>& poses) const override
+  {
+    const kinematics::KinematicsBasePtr& solver = getSolver();
+    return solver && solver->getPositionFK(link_names, joint_angles, poses);
+  }
+
+  bool setRedundantJoints(const std::vector<unsigned int>& redundant_joint_indices) override
+  {
+    const kinematics::KinematicsBasePtr& solver = getSolver();
+    if (!solver || !solver->setRedundantJoints(redundant_joint_indices))
+      return false;
+    solver->getRedundantJoints(redundant_joint_indices_);
+    return true;
+  }
+
+  const std::vector<std::string>& getJointNames() const override
+  {
+    return joint_names_;
+  }
+
+  const std::vector<std::string>& getLinkNames() const override
+  {
+    return link_names_;
+  }
+
+  bool supportsConcurrentQueries() const override
+  {
+    const kinematics::KinematicsBasePtr& solver = getSolver();
+    return solver && solver->supportsConcurrentQueries();
+  }
+
+private:
+  /** \brief Get the solver, creating it on the first call. Returns nullptr if it can't be created. */
+  const kinematics::KinematicsBasePtr& getSolver() const;
+
+  const kinematics::KinematicsBasePtr& getSolver(moveit_msgs::msg::MoveItErrorCodes& error_code) const
+  {
+    const kinematics::KinematicsBasePtr& solver = getSolver();
+    if (!solver)
+      error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+    return solver;
+  }
+
+  const moveit::core::JointModelGroup* jmg_;
+  AllocatorFn allocator_;
+  std::vector<std::string> joint_names_;
+  std::vector<std::string> link_names_;
+
+  mutable std::once_flag load_once_;
+  mutable kinematics::KinematicsBasePtr solver_;
+};
+
+/** \brief Loads lazily loaded kinematics solvers on a background thread
+ *
+ * The queue of solvers is shared with the thread instead of being owned by the prewarmer: loading a solver may drop the
+ * last reference to the owner of the prewarmer, which is then destroyed on the background thread itself. */
+class KinematicsSolverPrewarmer
+{
+public:
+  KinematicsSolverPrewarmer();
+  ~KinematicsSolverPrewarmer();
+
+  KinematicsSolverPrewarmer(const KinematicsSolverPrewarmer&) = delete;
+  KinematicsSolverPrewarmer& operator=(const KinematicsSolverPrewarmer&) = delete;
+
+  /** \brief Queue \e solver to be loaded, unless it is no longer used by the time the thread gets to it */
+  void prewarm(const std::shared_ptr<LazyKinematicsSolver>& solver);
+
+private:
+  struct Queue;
+  std::shared_ptr<Queue> queue_;
+  std::mutex thread_lock_;
+  std::thread thread_;
+};
+}  // namespace kinematics_plugin_loader
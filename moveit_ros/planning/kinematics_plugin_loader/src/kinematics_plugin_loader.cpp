@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan, Dave Coleman */
 
 #include <moveit/kinematics_plugin_loader/kinematics_plugin_loader.h>
+#include <moveit/kinematics_plugin_loader/lazy_kinematics_solver.h>
 #include <moveit/rdf_loader/rdf_loader.h>
 #include <pluginlib/class_loader.hpp>
 #include <rclcpp/logger.hpp>
@@ -50,7 +51,9 @@
 namespace kinematics_plugin_loader
 {
 rclcpp::Logger LOGGER = rclcpp::get_logger("kinematics_plugin_loader");
+
 class KinematicsPluginLoader::KinematicsLoaderImpl
+  : public std::enable_shared_from_this<KinematicsPluginLoader::KinematicsLoaderImpl>
 {
 public:
   /**
@@ -61,11 +64,13 @@ public:
    */
   KinematicsLoaderImpl(const rclcpp::Node::SharedPtr& node, const std::string& robot_description,
                        const std::map<std::string, std::string>& possible_kinematics_solvers,
-                       const std::map<std::string, double>& search_res)
+                       const std::map<std::string, double>& search_res,
+                       const std::map<std::string, std::string>& initialization)
     : node_(node)
     , robot_description_(robot_description)
     , possible_kinematics_solvers_(possible_kinematics_solvers)
     , search_res_(search_res)
+    , initialization_(initialization)
   {
     try
     {
@@ -134,9 +139,7 @@ public:
 
     RCLCPP_DEBUG(LOGGER, "Trying to allocate kinematics solver for group '%s'", jmg->getName().c_str());
 
-    const std::string& base = links.front()->getParentJointModel()->getParentLinkModel() ?
-                                  links.front()->getParentJointModel()->getParentLinkModel()->getName() :
-                                  jmg->getParentModel().getModelFrame();
+    const std::string base = chooseBaseFrame(jmg);
 
     // just to be sure, do not call the same pluginlib instance allocation function in parallel
     std::scoped_lock slock(lock_);
@@ -158,8 +161,7 @@ public:
           // choose search resolution
           double search_res = search_res_.find(jmg->getName())->second;  // we know this exists, by construction
 
-          if (!result->initialize(node_, jmg->getParentModel(), jmg->getName(),
-                                  (base.empty() || base[0] != '/') ? base : base.substr(1), tips, search_res))
+          if (!result->initialize(node_, jmg->getParentModel(), jmg->getName(), base, tips, search_res))
           {
             RCLCPP_ERROR(LOGGER, "Kinematics solver of type '%s' could not be initialized for group '%s'",
                          solver.c_str(), jmg->getName().c_str());
@@ -189,6 +191,47 @@ public:
     return result;
   }
 
+  /**
+   * \brief Helper function to choose the base frame of the kinematic solver of a planning group
+   * \param jmg - joint model group pointer
+   * \return the parent link of the group's first link, or the model frame
+   */
+  std::string chooseBaseFrame(const moveit::core::JointModelGroup* jmg)
+  {
+    const moveit::core::LinkModel* first_link = jmg->getLinkModels().front();
+    const std::string& base = first_link->getParentJointModel()->getParentLinkModel() ?
+                                  first_link->getParentJointModel()->getParentLinkModel()->getName() :
+                                  jmg->getParentModel().getModelFrame();
+    return (base.empty() || base[0] != '/') ? base : base.substr(1);
+  }
+
+  /** \brief Allocate a stand-in for the solver of a chain group, or nullptr if the solver is to be loaded eagerly */
+  kinematics::KinematicsBasePtr allocLazyKinematicsSolver(const moveit::core::JointModelGroup* jmg)
+  {
+    const auto initialization = initialization_.find(jmg->getName());
+    if (initialization == initialization_.end() || initialization->second == "eager")
+      return nullptr;
+    if (!kinematics_loader_ || !jmg->isChain() || jmg->getLinkModels().empty() ||
+        possible_kinematics_solvers_.find(jmg->getName()) == possible_kinematics_solvers_.end())
+    {
+      RCLCPP_DEBUG(LOGGER, "Loading the kinematics solver of group '%s' eagerly, it is not a chain",
+                   jmg->getName().c_str());
+      return nullptr;
+    }
+
+    // the stand-in keeps this loader, and thus the plugin library, alive as long as it may load its solver
+    auto solver = std::make_shared<LazyKinematicsSolver>(
+        jmg, chooseBaseFrame(jmg), chooseTipFrames(jmg), search_res_.at(jmg->getName()),
+        [self = shared_from_this()](const moveit::core::JointModelGroup* group) {
+          return self->allocKinematicsSolver(group);
+        });
+    RCLCPP_DEBUG(LOGGER, "Deferring the kinematics solver of group '%s' (%s initialization)", jmg->getName().c_str(),
+                 initialization->second.c_str());
+    if (initialization->second == "background")
+      prewarmer_.prewarm(solver);
+    return solver;
+  }
+
   // cache solver between two consecutive calls
   // first call in RobotModelLoader::loadKinematicsSolvers() is just to check suitability for jmg
   // second call in JointModelGroup::setSolverAllocators() is to actually retrieve the instance for use
@@ -200,7 +243,9 @@ public:
       return std::move(cached);  // pass on unique instance
 
     // create a new instance and store in instances_
-    cached = allocKinematicsSolver(jmg);
+    cached = allocLazyKinematicsSolver(jmg);
+    if (!cached)
+      cached = allocKinematicsSolver(jmg);
     return cached;
   }
 
@@ -208,8 +253,8 @@ public:
   {
     for (auto const& [group, solver] : possible_kinematics_solvers_)
     {
-      RCLCPP_INFO(LOGGER, "Solver for group '%s': '%s' (search resolution = %lf)", group.c_str(), solver.c_str(),
-                  search_res_.at(group));
+      RCLCPP_INFO(LOGGER, "Solver for group '%s': '%s' (search resolution = %lf, %s initialization)", group.c_str(),
+                  solver.c_str(), search_res_.at(group), initialization_.at(group).c_str());
     }
   }
 
@@ -218,10 +263,14 @@ private:
   std::string robot_description_;
   std::map<std::string, std::string> possible_kinematics_solvers_;
   std::map<std::string, double> search_res_;
+  std::map<std::string, std::string> initialization_;
   std::shared_ptr<pluginlib::ClassLoader<kinematics::KinematicsBase>> kinematics_loader_;
   std::map<const moveit::core::JointModelGroup*, kinematics::KinematicsBasePtr> instances_;
   std::mutex lock_;
   std::mutex cache_lock_;
+
+  // loads the solvers with background initialization, destroyed first
+  KinematicsSolverPrewarmer prewarmer_;
 };
 
 void KinematicsPluginLoader::status() const
@@ -245,6 +294,7 @@ moveit::core::SolverAllocatorFn KinematicsPluginLoader::getLoaderFunction(const
 
     std::map<std::string, std::string> possible_kinematics_solvers;
     std::map<std::string, double> search_res;
+    std::map<std::string, std::string> initialization;
     std::map<std::string, std::vector<std::string>> iksolver_to_tip_links;
 
     if (srdf_model)
@@ -288,11 +338,13 @@ moveit::core::SolverAllocatorFn KinematicsPluginLoader::getLoaderFunction(const
         ik_timeout_[known_group.name_] = kinematics_solver_timeout;
         RCLCPP_DEBUG(LOGGER, "Found param %s : %f", kinematics_solver_timeout_param_name.c_str(),
                      kinematics_solver_timeout);
+
+        initialization[known_group.name_] = group_params_.at(known_group.name_).kinematics_solver_initialization;
       }
     }
 
-    loader_ =
-        std::make_shared<KinematicsLoaderImpl>(node_, robot_description_, possible_kinematics_solvers, search_res);
+    loader_ = std::make_shared<KinematicsLoaderImpl>(node_, robot_description_, possible_kinematics_solvers, search_res,
+                                                     initialization);
   }
 
   return [&loader = *loader_](const moveit::core::JointModelGroup* jmg) {
@@ -0,0 +1,144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_plugin_loader/lazy_kinematics_solver.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <condition_variable>
+#include <deque>
+
+namespace kinematics_plugin_loader
+{
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("kinematics_plugin_loader");
+}  // namespace
+
+LazyKinematicsSolver::LazyKinematicsSolver(const moveit::core::JointModelGroup* jmg, const std::string& base_frame,
+                                           const std::vector<std::string>& tip_frames, double search_discretization,
+                                           AllocatorFn allocator)
+  : jmg_(jmg), allocator_(std::move(allocator))
+{
+  storeValues(jmg->getParentModel(), jmg->getName(), base_frame, tip_frames, search_discretization);
+  for (const moveit::core::JointModel* joint_model : jmg->getJointModels())
+  {
+    if (joint_model->getType() == moveit::core::JointModel::REVOLUTE ||
+        joint_model->getType() == moveit::core::JointModel::PRISMATIC)
+      joint_names_.push_back(joint_model->getName());
+  }
+  link_names_ = tip_frames_;
+}
+
+const kinematics::KinematicsBasePtr& LazyKinematicsSolver::getSolver() const
+{
+  std::call_once(load_once_, [this] {
+    RCLCPP_DEBUG(LOGGER, "Loading the kinematics solver of group '%s'", getGroupName().c_str());
+    kinematics::KinematicsBasePtr solver = allocator_(jmg_);
+    if (!solver)
+      return;
+    if (solver->getJointNames() != joint_names_)
+    {
+      RCLCPP_ERROR(LOGGER,
+                   "The kinematics solver of group '%s' does not use the joints of the group in order and cannot "
+                   "be loaded lazily. Set its kinematics_solver_initialization to 'eager'.",
+                   getGroupName().c_str());
+      return;
+    }
+    solver->setDefaultTimeout(getDefaultTimeout());
+    solver_ = std::move(solver);
+  });
+  return solver_;
+}
+
+struct KinematicsSolverPrewarmer::Queue
+{
+  // load the queued solvers until stopped
+  void run()
+  {
+    std::unique_lock<std::mutex> ulock(lock);
+    while (true)
+    {
+      condition.wait(ulock, [this] { return stop || !solvers.empty(); });
+      if (stop)
+        return;
+      std::weak_ptr<LazyKinematicsSolver> next = solvers.front();
+      solvers.pop_front();
+      ulock.unlock();
+      // solvers that are no longer used need not be loaded. Releasing solver may destroy the prewarmer, but not this.
+      if (std::shared_ptr<LazyKinematicsSolver> solver = next.lock())
+        solver->prewarm();
+      ulock.lock();
+    }
+  }
+
+  std::mutex lock;
+  std::condition_variable condition;
+  std::deque<std::weak_ptr<LazyKinematicsSolver>> solvers;
+  bool stop = false;
+};
+
+KinematicsSolverPrewarmer::KinematicsSolverPrewarmer() : queue_(std::make_shared<Queue>())
+{
+}
+
+KinematicsSolverPrewarmer::~KinematicsSolverPrewarmer()
+{
+  {
+    std::scoped_lock slock(queue_->lock);
+    queue_->stop = true;
+  }
+  queue_->condition.notify_all();
+  if (thread_.joinable())
+  {
+    // the thread keeps the queue alive and finishes on its own if it destroyed this
+    if (thread_.get_id() == std::this_thread::get_id())
+      thread_.detach();
+    else
+      thread_.join();
+  }
+}
+
+void KinematicsSolverPrewarmer::prewarm(const std::shared_ptr<LazyKinematicsSolver>& solver)
+{
+  {
+    std::scoped_lock slock(queue_->lock);
+    queue_->solvers.push_back(solver);
+  }
+  queue_->condition.notify_one();
+
+  std::scoped_lock slock(thread_lock_);
+  if (!thread_.joinable())
+    thread_ = std::thread([queue = queue_] { queue->run(); });
+}
+}  // namespace kinematics_plugin_loader
@@ -0,0 +1,246 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/kinematics_plugin_loader/lazy_kinematics_solver.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+using namespace kinematics_plugin_loader;
+
+namespace
+{
+// Reports the joints of its group and answers FK queries with identity poses
+class FakeSolver : public kinematics::KinematicsBase
+{
+public:
+  explicit FakeSolver(const moveit::core::JointModelGroup* jmg)
+  {
+    for (const moveit::core::JointModel* joint_model : jmg->getJointModels())
+    {
+      if (joint_model->getType() == moveit::core::JointModel::REVOLUTE ||
+          joint_model->getType() == moveit::core::JointModel::PRISMATIC)
+        joint_names_.push_back(joint_model->getName());
+    }
+    link_names_.push_back(jmg->getLinkModels().back()->getName());
+  }
+
+  bool getPositionIK(const geometry_msgs::msg::Pose& /*ik_pose*/, const std::vector<double>& /*ik_seed_state*/,
+                     std::vector<double>& /*solution*/, moveit_msgs::msg::MoveItErrorCodes& /*error_code*/,
+                     const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& /*ik_pose*/, const std::vector<double>& /*ik_seed_state*/,
+                        double /*timeout*/, std::vector<double>& /*solution*/,
+                        moveit_msgs::msg::MoveItErrorCodes& /*error_code*/,
+                        const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& /*ik_pose*/, const std::vector<double>& /*ik_seed_state*/,
+                        double /*timeout*/, const std::vector<double>& /*consistency_limits*/,
+                        std::vector<double>& /*solution*/, moveit_msgs::msg::MoveItErrorCodes& /*error_code*/,
+                        const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& /*ik_pose*/, const std::vector<double>& /*ik_seed_state*/,
+                        double /*timeout*/, std::vector<double>& /*solution*/,
+                        const IKCallbackFn& /*solution_callback*/, moveit_msgs::msg::MoveItErrorCodes& /*error_code*/,
+                        const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::msg::Pose& /*ik_pose*/, const std::vector<double>& /*ik_seed_state*/,
+                        double /*timeout*/, const std::vector<double>& /*consistency_limits*/,
+                        std::vector<double>& /*solution*/, const IKCallbackFn& /*solution_callback*/,
+                        moveit_msgs::msg::MoveItErrorCodes& /*error_code*/,
+                        const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    return false;
+  }
+
+  bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& /*joint_angles*/,
+                     std::vector<geometry_msgs::msg::Pose>& poses) const override
+  {
+    poses.assign(link_names.size(), geometry_msgs::msg::Pose());
+    return true;
+  }
+
+  const std::vector<std::string>& getJointNames() const override
+  {
+    return joint_names_;
+  }
+
+  const std::vector<std::string>& getLinkNames() const override
+  {
+    return link_names_;
+  }
+
+private:
+  std::vector<std::string> joint_names_;
+  std::vector<std::string> link_names_;
+};
+
+// Owns a prewarmer and reports the thread it is destroyed on
+struct PrewarmerOwner
+{
+  explicit PrewarmerOwner(std::shared_ptr<std::promise<std::thread::id>> destroyed) : destroyed(std::move(destroyed))
+  {
+  }
+
+  ~PrewarmerOwner()
+  {
+    destroyed->set_value(std::this_thread::get_id());
+  }
+
+  // declared last to be destroyed first, as in the kinematics loader
+  std::shared_ptr<std::promise<std::thread::id>> destroyed;
+  KinematicsSolverPrewarmer prewarmer;
+};
+}  // namespace
+
+class LazyKinematicsSolverTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    jmg_ = robot_model_->getJointModelGroup("panda_arm");
+    ASSERT_TRUE(jmg_);
+    tip_frames_.push_back(jmg_->getLinkModels().back()->getName());
+  }
+
+  std::shared_ptr<LazyKinematicsSolver> makeSolver(LazyKinematicsSolver::AllocatorFn allocator)
+  {
+    return std::make_shared<LazyKinematicsSolver>(jmg_, robot_model_->getModelFrame(), tip_frames_, 0.1,
+                                                  std::move(allocator));
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  const moveit::core::JointModelGroup* jmg_ = nullptr;
+  std::vector<std::string> tip_frames_;
+};
+
+TEST_F(LazyKinematicsSolverTest, LoadsOnFirstQuery)
+{
+  std::atomic<int> allocations{ 0 };
+  auto solver = makeSolver([&allocations](const moveit::core::JointModelGroup* jmg) {
+    ++allocations;
+    return std::make_shared<FakeSolver>(jmg);
+  });
+
+  // the group is configured from the robot model alone
+  EXPECT_EQ(solver->getGroupName(), "panda_arm");
+  EXPECT_EQ(solver->getJointNames().size(), 7u);
+  EXPECT_EQ(solver->getTipFrames(), tip_frames_);
+  EXPECT_EQ(allocations, 0);
+
+  std::vector<geometry_msgs::msg::Pose> poses;
+  EXPECT_TRUE(solver->getPositionFK(tip_frames_, std::vector<double>(7, 0.0), poses));
+  EXPECT_EQ(poses.size(), 1u);
+  EXPECT_TRUE(solver->getPositionFK(tip_frames_, std::vector<double>(7, 0.0), poses));
+  EXPECT_EQ(allocations, 1);
+}
+
+TEST_F(LazyKinematicsSolverTest, FailedLoadIsReported)
+{
+  auto solver = makeSolver([](const moveit::core::JointModelGroup* /*jmg*/) { return nullptr; });
+  std::vector<double> solution;
+  moveit_msgs::msg::MoveItErrorCodes error_code;
+  EXPECT_FALSE(solver->getPositionIK(geometry_msgs::msg::Pose(), std::vector<double>(7, 0.0), solution, error_code,
+                                     kinematics::KinematicsQueryOptions()));
+  EXPECT_EQ(error_code.val, moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION);
+}
+
+TEST_F(LazyKinematicsSolverTest, Prewarm)
+{
+  auto loaded = std::make_shared<std::promise<void>>();
+  std::atomic<int> allocations{ 0 };
+  auto solver = makeSolver([&allocations, loaded](const moveit::core::JointModelGroup* jmg) {
+    ++allocations;
+    loaded->set_value();
+    return std::make_shared<FakeSolver>(jmg);
+  });
+
+  KinematicsSolverPrewarmer prewarmer;
+  prewarmer.prewarm(solver);
+  ASSERT_EQ(loaded->get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+
+  std::vector<geometry_msgs::msg::Pose> poses;
+  EXPECT_TRUE(solver->getPositionFK(tip_frames_, std::vector<double>(7, 0.0), poses));
+  EXPECT_EQ(allocations, 1);
+}
+
+TEST_F(LazyKinematicsSolverTest, OwnerDestroyedDuringPrewarm)
+{
+  auto destroyed = std::make_shared<std::promise<std::thread::id>>();
+  std::future<std::thread::id> destroyed_future = destroyed->get_future();
+  auto started = std::make_shared<std::promise<void>>();
+  auto released = std::make_shared<std::promise<void>>();
+  std::shared_future<void> released_future = released->get_future().share();
+
+  auto owner = std::make_shared<PrewarmerOwner>(destroyed);
+  // like the loader, the solver keeps the owner of the prewarmer alive
+  auto solver = makeSolver([owner, started, released_future](const moveit::core::JointModelGroup* jmg) {
+    started->set_value();
+    released_future.wait();
+    return std::make_shared<FakeSolver>(jmg);
+  });
+  owner->prewarmer.prewarm(solver);
+  ASSERT_EQ(started->get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+
+  // the prewarm thread now holds the last reference to the solver, and through it to the owner
+  owner.reset();
+  solver.reset();
+  released->set_value();
+
+  ASSERT_EQ(destroyed_future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  EXPECT_NE(destroyed_future.get(), std::this_thread::get_id());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
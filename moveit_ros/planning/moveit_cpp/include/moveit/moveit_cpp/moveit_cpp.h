@@ -43,6 +43,7 @@
 #include <moveit/controller_manager/controller_manager.h>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/planning_pipeline_interfaces/planning_executor.hpp>
 #include <moveit/trajectory_execution_manager/trajectory_execution_manager.h>
 #include <moveit/robot_state/robot_state.h>
 #include <tf2_ros/buffer.h>
@@ -89,9 +90,18 @@ public:
       const std::string ns = "planning_pipelines.";
       node->get_parameter(ns + "pipeline_names", pipeline_names);
       node->get_parameter(ns + "namespace", parent_namespace);
+      int threads, max_queue_size;
+      node->get_parameter_or(ns + "executor_threads", threads, 0);
+      node->get_parameter_or(ns + "executor_max_queue_size", max_queue_size, 0);
+      executor_threads = static_cast<std::size_t>(std::max(threads, 0));
+      executor_max_queue_size = static_cast<std::size_t>(std::max(max_queue_size, 0));
     }
     std::vector<std::string> pipeline_names;
     std::string parent_namespace;
+    /// Threads of the planning executor, 0 uses one thread per hardware thread
+    std::size_t executor_threads = 0;
+    /// Maximum number of planning requests waiting for the executor, 0 for no limit
+    std::size_t executor_max_queue_size = 0;
   };
 
   /// Parameter container for initializing MoveItCpp
@@ -152,6 +162,9 @@ public:
   /** \brief Get all loaded planning pipeline instances mapped to their reference names */
   const std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr>& getPlanningPipelines() const;
 
+  /** \brief Get the executor shared by all planning requests of this instance */
+  const moveit::planning_pipeline_interfaces::PlanningExecutorPtr& getPlanningExecutor() const;
+
   /** \brief Get the stored instance of the planning scene monitor */
   planning_scene_monitor::PlanningSceneMonitorConstPtr getPlanningSceneMonitor() const;
   planning_scene_monitor::PlanningSceneMonitorPtr getPlanningSceneMonitorNonConst();
@@ -189,6 +202,7 @@ private:
   // Planning
   std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr> planning_pipelines_;
   std::unordered_map<std::string, std::set<std::string>> groups_algorithms_map_;
+  moveit::planning_pipeline_interfaces::PlanningExecutorPtr planning_executor_;
 
   // Execution
   trajectory_execution_manager::TrajectoryExecutionManagerPtr trajectory_execution_manager_;
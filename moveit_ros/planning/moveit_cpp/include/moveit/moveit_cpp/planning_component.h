@@ -199,13 +199,15 @@ public:
 
   /** \brief Run a plan from start or current state to fulfill the last goal constraints provided by setGoal() using the
    * provided PlanRequestParameters. This defaults to taking the full planning time (null stopping_criterion_callback)
-   * and finding the shortest solution in joint space. */
+   * and finding the shortest solution in joint space. Every response is passed to plan_response_callback as soon as its
+   * pipeline returns, so a good enough plan can be used before the remaining pipelines terminate. */
   planning_interface::MotionPlanResponse
   plan(const MultiPipelinePlanRequestParameters& parameters,
        const moveit::planning_pipeline_interfaces::SolutionSelectionFunction& solution_selection_function =
            &moveit::planning_pipeline_interfaces::getShortestSolution,
        const moveit::planning_pipeline_interfaces::StoppingCriterionFunction& stopping_criterion_callback = nullptr,
-       planning_scene::PlanningScenePtr planning_scene = nullptr);
+       planning_scene::PlanningScenePtr planning_scene = nullptr,
+       const moveit::planning_pipeline_interfaces::PlanResponseCallback& plan_response_callback = nullptr);
 
   /** \brief Execute the latest computed solution trajectory computed by plan(). By default this function terminates
    * after the execution is complete. The execution can be run in background by setting blocking to false. */
@@ -135,6 +135,10 @@ bool MoveItCpp::loadPlanningPipelines(const PlanningPipelineOptions& options)
     RCLCPP_ERROR(LOGGER, "Failed to load any planning pipelines.");
     return false;
   }
+
+  planning_executor_ = std::make_shared<moveit::planning_pipeline_interfaces::PlanningExecutor>(
+      options.executor_threads, options.executor_max_queue_size);
+  RCLCPP_DEBUG(LOGGER, "Planning executor running with %zu threads", planning_executor_->getThreadCount());
   return true;
 }
 
@@ -174,6 +178,11 @@ const std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr>& M
   return planning_pipelines_;
 }
 
+const moveit::planning_pipeline_interfaces::PlanningExecutorPtr& MoveItCpp::getPlanningExecutor() const
+{
+  return planning_executor_;
+}
+
 planning_scene_monitor::PlanningSceneMonitorConstPtr MoveItCpp::getPlanningSceneMonitor() const
 {
   return planning_scene_monitor_;
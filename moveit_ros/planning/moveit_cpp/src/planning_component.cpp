@@ -140,16 +140,21 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   // Set start state
   planning_scene->setCurrentState(request.start_state);
 
-  // Run planning attempt
-  return moveit::planning_pipeline_interfaces::planWithSinglePipeline(request, planning_scene,
-                                                                      moveit_cpp_->getPlanningPipelines());
+  // Run planning attempt on the executor shared with all other planning requests of moveit_cpp_
+  return moveit_cpp_->getPlanningExecutor()
+      ->submit([&] {
+        return moveit::planning_pipeline_interfaces::planWithSinglePipeline(request, planning_scene,
+                                                                            moveit_cpp_->getPlanningPipelines());
+      })
+      .get();
 }
 
 planning_interface::MotionPlanResponse PlanningComponent::plan(
     const MultiPipelinePlanRequestParameters& parameters,
     const moveit::planning_pipeline_interfaces::SolutionSelectionFunction& solution_selection_function,
     const moveit::planning_pipeline_interfaces::StoppingCriterionFunction& stopping_criterion_callback,
-    planning_scene::PlanningScenePtr planning_scene)
+    planning_scene::PlanningScenePtr planning_scene,
+    const moveit::planning_pipeline_interfaces::PlanResponseCallback& plan_response_callback)
 {
   auto plan_solution = planning_interface::MotionPlanResponse();
 
@@ -191,7 +196,7 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(
 
   auto const motion_plan_response_vector = moveit::planning_pipeline_interfaces::planWithParallelPipelines(
       requests, planning_scene, moveit_cpp_->getPlanningPipelines(), stopping_criterion_callback,
-      solution_selection_function);
+      solution_selection_function, plan_response_callback, moveit_cpp_->getPlanningExecutor());
 
   try
   {
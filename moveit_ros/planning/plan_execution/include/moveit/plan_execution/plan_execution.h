@@ -41,9 +41,12 @@
 #include <moveit/trajectory_execution_manager/trajectory_execution_manager.h>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/planning_scene_monitor/trajectory_monitor.h>
+#include <moveit/collision_detection/world_diff.h>
 #include <pluginlib/class_loader.hpp>
+#include <Eigen/Geometry>
 
 #include <atomic>
+#include <mutex>
 
 /** \brief This namespace includes functionality specific to the execution and monitoring of motion plans */
 namespace plan_execution
@@ -147,6 +150,10 @@ private:
   void planAndExecuteHelper(ExecutableMotionPlan& plan, const Options& opt);
   bool isRemainingPathValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment);
 
+  /** \brief Start recording the changes of the world of \e plan for the remaining path checks of \e trajectory */
+  void resetRemainingPathCheck(const ExecutableMotionPlan& plan,
+                               const robot_trajectory::RobotTrajectoryConstPtr& trajectory);
+
   void planningSceneUpdatedCallback(const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type);
   void doneWithTrajectoryExecution(const moveit_controller_manager::ExecutionStatus& status);
   void successfulTrajectorySegmentExecution(const ExecutableMotionPlan& plan, std::size_t index);
@@ -179,6 +186,20 @@ private:
 
   bool new_scene_update_;
 
+  /** \brief The last successful check of isRemainingPathValid(). Later checks of the same trajectory only check the
+      waypoints whose AABBs intersect the objects that changed since, if world_diff records the changes. */
+  struct RemainingPathCheck
+  {
+    robot_trajectory::RobotTrajectoryConstPtr trajectory;  // nullptr if there was no check to build on
+    planning_scene::PlanningSceneConstPtr planning_scene;
+    std::size_t first_waypoint = 0;
+    std::size_t acm_version = 0;
+    collision_detection::WorldDiffPtr world_diff;
+    std::vector<Eigen::AlignedBox3d> waypoint_aabbs;  // the AABB of the robot moving from each waypoint to the next
+  };
+  std::mutex remaining_path_check_mutex_;
+  RemainingPathCheck remaining_path_check_;
+
   bool execution_complete_;
   bool path_became_invalid_;
 
@@ -38,6 +38,7 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <moveit/collision_detection/collision_tools.h>
+#include <moveit/collision_detection/world_spatial_index.h>
 #include <moveit/utils/message_checks.h>
 #include <moveit/utils/moveit_error_code.h>
 #include <boost/algorithm/string/join.hpp>
@@ -48,6 +49,9 @@
 #include <rclcpp/rate.hpp>
 #include <rclcpp/utilities.hpp>
 
+#include <algorithm>
+#include <thread>
+
 // #include <dynamic_reconfigure/server.h>
 // #include <moveit_ros_planning/PlanExecutionDynamicReconfigureConfig.h>
 
@@ -262,6 +266,124 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
   }
 }
 
+namespace
+{
+// Robot AABBs are extended by this margin so that objects just touching the robot are not culled
+constexpr double ROBOT_AABB_MARGIN = 0.01;
+// Waypoints are only checked in parallel if every thread gets at least this many of them
+constexpr std::size_t MIN_WAYPOINTS_PER_THREAD = 8;
+
+Eigen::AlignedBox3d computeStateAABB(const moveit::core::RobotState& state)
+{
+  std::vector<double> aabb;
+  state.computeAABB(aabb);
+  return Eigen::AlignedBox3d(Eigen::Vector3d(aabb[0], aabb[2], aabb[4]), Eigen::Vector3d(aabb[1], aabb[3], aabb[5]));
+}
+
+bool isWayPointColliding(const planning_scene::PlanningScene& scene,
+                         const robot_trajectory::RobotTrajectory& trajectory,
+                         const collision_detection::AllowedCollisionMatrix* acm, std::size_t index, bool verbose)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = trajectory.getGroupName();
+  req.verbose = verbose;
+  collision_detection::CollisionResult res;
+  if (acm)
+  {
+    scene.checkCollisionUnpadded(req, res, trajectory.getWayPoint(index), *acm);
+  }
+  else
+  {
+    scene.checkCollisionUnpadded(req, res, trajectory.getWayPoint(index));
+  }
+  return res.collision;
+}
+
+/// The position in \e waypoints of the first waypoint of \e trajectory that is in collision or infeasible,
+/// waypoints.size() if all of them are valid
+std::size_t findFirstInvalidWayPoint(const planning_scene::PlanningScene& scene,
+                                     const robot_trajectory::RobotTrajectory& trajectory,
+                                     const collision_detection::AllowedCollisionMatrix* acm,
+                                     const std::vector<std::size_t>& waypoints)
+{
+  const auto is_invalid = [&](std::size_t i) {
+    return isWayPointColliding(scene, trajectory, acm, waypoints[i], false) ||
+           !scene.isStateFeasible(trajectory.getWayPoint(waypoints[i]), false);
+  };
+
+  // feasibility predicates are not required to be thread safe
+  const std::size_t thread_count =
+      std::min<std::size_t>(std::thread::hardware_concurrency(), waypoints.size() / MIN_WAYPOINTS_PER_THREAD);
+  if (thread_count <= 1 || scene.getStateFeasibilityPredicate())
+  {
+    for (std::size_t i = 0; i < waypoints.size(); ++i)
+    {
+      if (is_invalid(i))
+        return i;
+    }
+    return waypoints.size();
+  }
+
+  // waypoints are handed out in order and only the ones after an invalid waypoint are skipped, so the first invalid
+  // waypoint is found as in the sequential check
+  std::atomic<std::size_t> next_waypoint{ 0 };
+  std::atomic<std::size_t> first_invalid{ waypoints.size() };
+  const auto check_waypoints = [&]() {
+    for (std::size_t i = next_waypoint++; i < first_invalid; i = next_waypoint++)
+    {
+      if (!is_invalid(i))
+        continue;
+      std::size_t current = first_invalid;
+      while (i < current && !first_invalid.compare_exchange_weak(current, i))
+      {
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (std::size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(check_waypoints);
+  check_waypoints();
+  for (std::thread& thread : threads)
+    thread.join();
+  return first_invalid;
+}
+}  // namespace
+
+void plan_execution::PlanExecution::resetRemainingPathCheck(const ExecutableMotionPlan& plan,
+                                                            const robot_trajectory::RobotTrajectoryConstPtr& trajectory)
+{
+  RemainingPathCheck& check = remaining_path_check_;
+  check.trajectory.reset();
+  check.waypoint_aabbs.resize(trajectory->getWayPointCount());
+  for (std::size_t i = 0; i < check.waypoint_aabbs.size(); ++i)
+  {
+    check.waypoint_aabbs[i] = computeStateAABB(trajectory->getWayPoint(i));
+    if (i > 0)
+      check.waypoint_aabbs[i - 1].extend(check.waypoint_aabbs[i]);
+  }
+  for (Eigen::AlignedBox3d& aabb : check.waypoint_aabbs)
+  {
+    aabb.min().array() -= ROBOT_AABB_MARGIN;
+    aabb.max().array() += ROBOT_AABB_MARGIN;
+  }
+
+  if (check.world_diff && check.planning_scene == plan.planning_scene)
+    return;
+
+  // changes of the world can only be recorded for the scene of the monitor; adding and removing the observer
+  // modifies the world, so the scene is locked for writing
+  planning_scene_monitor::LockedPlanningSceneRW lscene(plan.planning_scene_monitor);
+  check.planning_scene = plan.planning_scene;
+  check.world_diff.reset();
+  if (plan.planning_scene_monitor && plan.planning_scene_monitor->getPlanningScene() == plan.planning_scene &&
+      !plan.planning_scene->getParent())
+  {
+    const planning_scene::PlanningScenePtr& scene = plan.planning_scene_monitor->getPlanningScene();
+    check.world_diff = std::make_shared<collision_detection::WorldDiff>(scene->getWorldNonConst());
+  }
+}
+
 bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan& plan,
                                                          const std::pair<int, int>& path_segment)
 {
@@ -269,49 +391,82 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
       plan.plan_components[path_segment.first].trajectory_monitoring)  // If path_segment.second <= 0, the function
                                                                        // will fallback to check the entire trajectory
   {
+    const ExecutableTrajectory& component = plan.plan_components[path_segment.first];
+    const std::size_t first_waypoint = std::max(path_segment.second - 1, 0);
+    std::scoped_lock check_lock(remaining_path_check_mutex_);
+    RemainingPathCheck& check = remaining_path_check_;
+    bool incremental = check.trajectory && check.trajectory == component.trajectory &&
+                       check.planning_scene == plan.planning_scene && check.world_diff &&
+                       first_waypoint >= check.first_waypoint;
+    if (!incremental)
+      resetRemainingPathCheck(plan, component.trajectory);
+
     planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor);  // lock the scene so that it
                                                                                         // does not modify the world
                                                                                         // representation while
                                                                                         // isStateValid() is called
-    const robot_trajectory::RobotTrajectory& t = *plan.plan_components[path_segment.first].trajectory;
-    const collision_detection::AllowedCollisionMatrix* acm =
-        plan.plan_components[path_segment.first].allowed_collision_matrix.get();
-    std::size_t wpc = t.getWayPointCount();
-    collision_detection::CollisionRequest req;
-    req.group_name = t.getGroupName();
-    for (std::size_t i = std::max(path_segment.second - 1, 0); i < wpc; ++i)
+    const planning_scene::PlanningScene& scene = *plan.planning_scene;
+    const robot_trajectory::RobotTrajectory& t = *component.trajectory;
+    const collision_detection::AllowedCollisionMatrix* acm = component.allowed_collision_matrix.get();
+    const std::size_t acm_version = scene.getAllowedCollisionMatrix().getVersion();
+    // feasibility may depend on anything, so with a predicate every waypoint is checked
+    incremental = incremental && acm_version == check.acm_version && !scene.getStateFeasibilityPredicate();
+
+    std::vector<std::size_t> waypoints;
+    if (incremental)
     {
-      collision_detection::CollisionResult res;
-      if (acm)
+      // only objects that exist can make a waypoint invalid, and only if they are near it
+      std::vector<Eigen::AlignedBox3d> changed_aabbs;
+      bool unbounded = false;
+      for (const auto& change : *check.world_diff)
       {
-        plan.planning_scene->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
+        const collision_detection::World::ObjectConstPtr object = scene.getWorld()->getObject(change.first);
+        Eigen::AlignedBox3d aabb;
+        if (!object)
+          continue;
+        if (!collision_detection::WorldSpatialIndex::computeObjectAABB(*object, aabb))
+        {
+          unbounded = true;
+          break;
+        }
+        if (!aabb.isEmpty())
+          changed_aabbs.push_back(aabb);
       }
-      else
+      for (std::size_t i = first_waypoint; i < t.getWayPointCount(); ++i)
       {
-        plan.planning_scene->checkCollisionUnpadded(req, res, t.getWayPoint(i));
+        if (unbounded || std::any_of(changed_aabbs.begin(), changed_aabbs.end(), [&](const Eigen::AlignedBox3d& aabb) {
+              return aabb.intersects(check.waypoint_aabbs[i]);
+            }))
+          waypoints.push_back(i);
       }
+    }
+    else
+    {
+      for (std::size_t i = first_waypoint; i < t.getWayPointCount(); ++i)
+        waypoints.push_back(i);
+    }
+    if (check.world_diff)
+      check.world_diff->clearChanges();
 
-      if (res.collision || !plan.planning_scene->isStateFeasible(t.getWayPoint(i), false))
-      {
-        // Dave's debacle
-        RCLCPP_INFO(LOGGER, "Trajectory component '%s' is invalid",
-                    plan.plan_components[path_segment.first].description.c_str());
-
-        // call the same functions again, in verbose mode, to show what issues have been detected
-        plan.planning_scene->isStateFeasible(t.getWayPoint(i), true);
-        req.verbose = true;
-        res.clear();
-        if (acm)
-        {
-          plan.planning_scene->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
-        }
-        else
-        {
-          plan.planning_scene->checkCollisionUnpadded(req, res, t.getWayPoint(i));
-        }
-        return false;
-      }
+    const std::size_t invalid = findFirstInvalidWayPoint(scene, t, acm, waypoints);
+    if (invalid < waypoints.size())
+    {
+      check.trajectory.reset();
+
+      // Dave's debacle
+      RCLCPP_INFO(LOGGER, "Trajectory component '%s' is invalid", component.description.c_str());
+
+      // call the same functions again, in verbose mode, to show what issues have been detected
+      scene.isStateFeasible(t.getWayPoint(waypoints[invalid]), true);
+      isWayPointColliding(scene, t, acm, waypoints[invalid], true);
+      return false;
     }
+    RCLCPP_DEBUG(LOGGER, "Checked %zu of %zu remaining waypoints of trajectory component '%s'", waypoints.size(),
+                 t.getWayPointCount() - std::min(first_waypoint, t.getWayPointCount()), component.description.c_str());
+
+    check.trajectory = component.trajectory;
+    check.first_waypoint = first_waypoint;
+    check.acm_version = acm_version;
   }
   return true;
 }
@@ -478,6 +633,13 @@ moveit_msgs::msg::MoveItErrorCodes plan_execution::PlanExecution::executeAndMoni
     trajectory_monitor_->swapTrajectory(*plan.executed_trajectory);
   }
 
+  // stop recording the changes of the world for the remaining path checks
+  {
+    std::scoped_lock check_lock(remaining_path_check_mutex_);
+    planning_scene_monitor::LockedPlanningSceneRW lscene(plan.planning_scene_monitor);
+    remaining_path_check_ = RemainingPathCheck();
+  }
+
   // decide return value
   if (path_became_invalid_)
   {
@@ -40,6 +40,8 @@
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
 #include <geometric_shapes/shape_operations.h>
 #include <random_numbers/random_numbers.h>
+#include <algorithm>
+#include <thread>
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/utils/robot_model_test_utils.h>
@@ -242,6 +244,70 @@ void runCollisionDetection(unsigned int trials, const planning_scene::PlanningSc
   scene->setCurrentState(states.back());
 }
 
+/** \brief Runs a collision detection benchmark with several threads checking the same scene concurrently.
+ *
+ *   \param trials The number of repeated collision checks for each state and thread
+ *   \param scene The planning scene
+ *   \param CollisionDetector The type of collision detector
+ *   \param only_self Flag for only self collision check performed
+ *   \param num_threads The number of threads checking concurrently */
+void runCollisionDetectionParallel(unsigned int trials, const planning_scene::PlanningScenePtr& scene,
+                                   const std::vector<moveit::core::RobotState>& states,
+                                   const CollisionDetector col_detector, bool only_self, unsigned int num_threads)
+{
+  ROS_INFO_STREAM("Starting detection using " << (col_detector == CollisionDetector::FCL ? "FCL" : "Bullet")
+                                              << " with " << num_threads << " threads");
+
+  if (col_detector == CollisionDetector::FCL)
+  {
+    scene->allocateCollisionDetector(collision_detection::CollisionDetectorAllocatorFCL::create());
+  }
+  else
+  {
+    scene->allocateCollisionDetector(collision_detection::CollisionDetectorAllocatorBullet::create());
+  }
+
+  collision_detection::CollisionRequest req;
+  if (!only_self)
+  {
+    req.contacts = true;
+    req.max_contacts = 99;
+    req.max_contacts_per_pair = 10;
+  }
+
+  const planning_scene::PlanningSceneConstPtr const_scene = scene;
+  auto check = [&]() {
+    collision_detection::CollisionResult res;
+    for (unsigned int i = 0; i < trials; ++i)
+    {
+      for (auto& state : states)
+      {
+        res.clear();
+        if (only_self)
+        {
+          const_scene->checkSelfCollision(req, res, state);
+        }
+        else
+        {
+          const_scene->checkCollision(req, res, state);
+        }
+      }
+    }
+  };
+
+  ros::WallTime start = ros::WallTime::now();
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < num_threads; ++t)
+    threads.emplace_back(check);
+  for (std::thread& thread : threads)
+    thread.join();
+  double duration = (ros::WallTime::now() - start).toSec();
+
+  const double checks = static_cast<double>(trials) * states.size() * num_threads;
+  ROS_INFO("Performed %lf collision checks per second", checks / duration);
+  ROS_INFO_STREAM("Total number was " << checks << " checks.");
+}
+
 /** \brief Samples valid states of the robot which can be in collision if desired.
  *  \param desired_states Specifier for type for desired state
  *  \param num_states Number of desired states
@@ -354,6 +420,13 @@ int main(int argc, char** argv)
     runCollisionDetection(trials, planning_scene, sampled_states_2, CollisionDetector::BULLET, false);
     runCollisionDetection(trials, planning_scene, sampled_states_2, CollisionDetector::FCL, false);
 
+    const unsigned int num_threads = std::max(2u, std::thread::hardware_concurrency());
+    ROS_INFO("Starting benchmark: Robot in cluttered world, in collision with world, multi-threaded");
+    runCollisionDetectionParallel(trials, planning_scene, sampled_states_2, CollisionDetector::BULLET, false,
+                                  num_threads);
+    runCollisionDetectionParallel(trials, planning_scene, sampled_states_2, CollisionDetector::FCL, false,
+                                  num_threads);
+
     bool visualize;
     node_handle.getParam("/compare_collision_checking_speed/visualization", visualize);
     if (visualize)
@@ -36,10 +36,12 @@
 
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/robot_state_arena.h>
 #include <moveit/collision_detection/collision_tools.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include <chrono>
 #include <sstream>
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros_planning.planning_pipeline");
@@ -254,12 +256,17 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
   // Set planning pipeline active
   active_ = true;
 
+  // the robot states created on this thread for the request share a pool instead of each allocating from the heap
+  const auto arena = std::make_shared<moveit::core::RobotStateArena>();
+  moveit::core::RobotStateArena::Scope arena_scope(arena);
+
   // broadcast the request we are about to work on, if needed
   if (publish_received_requests_)
   {
     received_request_publisher_->publish(req);
   }
   adapter_added_state_index.clear();
+  res.stage_times.clear();
 
   if (!planner_instance_)
   {
@@ -286,9 +293,12 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     }
     else
     {
+      const auto start = std::chrono::steady_clock::now();
       planning_interface::PlanningContextPtr context =
           planner_instance_->getPlanningContext(planning_scene, req, res.error_code);
       solved = context ? context->solve(res) : false;
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      res.stage_times.emplace_back(planner_instance_->getDescription(), elapsed.count());
     }
   }
   catch (std::exception& ex)
@@ -307,6 +317,7 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     RCLCPP_DEBUG(LOGGER, "Motion planner reported a solution path with %ld states", state_count);
     if (check_solution_paths_)
     {
+      const auto start = std::chrono::steady_clock::now();
       visualization_msgs::msg::MarkerArray arr;
       visualization_msgs::msg::Marker m;
       m.action = visualization_msgs::msg::Marker::DELETEALL;
@@ -389,6 +400,8 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
       else
         RCLCPP_DEBUG(LOGGER, "Planned path was found to be valid when rechecked");
       contacts_publisher_->publish(arr);
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      res.stage_times.emplace_back("Solution path check", elapsed.count());
     }
   }
 
@@ -424,6 +437,17 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     }
   }
 
+  if (!res.stage_times.empty())
+  {
+    std::stringstream ss;
+    for (const auto& [stage, time] : res.stage_times)
+      ss << "\n  " << stage << ": " << time << " s";
+    RCLCPP_DEBUG(LOGGER, "Time spent in the planning pipeline stages:%s", ss.str().c_str());
+  }
+  const moveit::core::RobotStateArena::Statistics arena_statistics = arena->getStatistics();
+  RCLCPP_DEBUG(LOGGER, "Robot states of the request used %zu buffers (%zu recycled) from %zu heap allocations",
+               arena_statistics.allocations, arena_statistics.recycled, arena_statistics.heap_allocations);
+
   // Set planning pipeline to inactive
 
   active_ = false;
@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: Learns which planners win parallel planning races per query class */
+
+#pragma once
+
+#include <moveit/planning_pipeline_interfaces/planning_pipeline_interfaces.hpp>
+#include <moveit/planning_pipeline_interfaces/solution_selection_functions.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace planning_pipeline_interfaces
+{
+MOVEIT_CLASS_FORWARD(PlannerPortfolio);  // Defines PlannerPortfolioPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Online statistics about which planners win the races of planWithParallelPipelines()
+ *
+ * Queries are grouped into classes by planning group and goal type. For every class the portfolio counts how often each
+ * planner took part in a race, found a solution and had its solution selected, and how long its successful runs took.
+ * selectRequests() uses these statistics to drop planners that rarely win from future races of the same class, so their
+ * threads are left to the planners that do. Planners are told apart by their planner_id, so each request of a race
+ * needs a distinct one.
+ *
+ * The statistics are updated by update() and the functions returned from getSolutionSelectionFunction(). They can be
+ * saved to and loaded from a file to persist them across restarts. All methods are thread-safe. The returned functions
+ * refer to the portfolio, which needs to outlive them.
+ */
+class PlannerPortfolio
+{
+public:
+  /** \brief Statistics of one planner for one query class */
+  struct PlannerStatistics
+  {
+    std::size_t runs = 0;
+    std::size_t successes = 0;
+    std::size_t wins = 0;
+    double total_success_time = 0.0;
+
+    double getWinRate() const
+    {
+      return runs > 0 ? static_cast<double>(wins) / static_cast<double>(runs) : 0.0;
+    }
+  };
+
+  /** \brief Constructor
+   * \param [in] min_runs Number of races a planner takes part in for a query class before it may be dropped
+   * \param [in] min_win_rate Planners that won fewer than this fraction of their races are dropped
+   * \param [in] exploration_period Every exploration_period-th race of a query class runs all planners, so dropped
+   * planners can recover when conditions change. 0 disables exploration
+   */
+  PlannerPortfolio(std::size_t min_runs = 20, double min_win_rate = 0.05, std::size_t exploration_period = 10);
+
+  /** \brief Get the class of a query, made of the planning group and the type of the first goal constraints */
+  static std::string getQueryClass(const ::planning_interface::MotionPlanRequest& request);
+
+  /** \brief Select the requests of a race worth running
+   * \param [in] requests Requests of the race, all for the same query
+   * \return Requests whose planners have not been ruled out, ordered by decreasing win rate so that the most promising
+   * ones are started first on a saturated executor. At least the most promising request is always returned
+   */
+  std::vector<::planning_interface::MotionPlanRequest>
+  selectRequests(const std::vector<::planning_interface::MotionPlanRequest>& requests);
+
+  /** \brief Get a stopping criterion that stops a race as soon as a solution was found and none of the planners that
+   * are still running has won more often than the best successful one so far */
+  StoppingCriterionFunction getStoppingCriterionFunction() const;
+
+  /** \brief Get a solution selection function that records the outcome of a race before returning its selection
+   * \param [in] request Request the race was started for, used to determine the query class
+   * \param [in] solution_selection_function Function used to select the winner
+   */
+  SolutionSelectionFunction
+  getSolutionSelectionFunction(const ::planning_interface::MotionPlanRequest& request,
+                               const SolutionSelectionFunction& solution_selection_function = &getShortestSolution);
+
+  /** \brief Record the outcome of a race
+   * \param [in] query_class Class of the query, see getQueryClass()
+   * \param [in] solutions Responses of all planners that took part in the race
+   * \param [in] winner Selected response
+   */
+  void update(const std::string& query_class, const std::vector<::planning_interface::MotionPlanResponse>& solutions,
+              const ::planning_interface::MotionPlanResponse& winner);
+
+  /** \brief Get the statistics of a planner for a query class, all zero if it never took part in a race */
+  PlannerStatistics getStatistics(const std::string& query_class, const std::string& planner_id) const;
+
+  /** \brief Save the statistics to a file, returns false if the file could not be written */
+  bool save(const std::string& filename) const;
+
+  /** \brief Replace the statistics by the ones saved in a file, returns false if the file could not be read */
+  bool load(const std::string& filename);
+
+private:
+  // Expects statistics_mutex_ to be locked
+  double getWinRate(const std::string& query_class, const std::string& planner_id) const;
+
+  const std::size_t min_runs_;
+  const double min_win_rate_;
+  const std::size_t exploration_period_;
+
+  mutable std::mutex statistics_mutex_;
+  // Statistics per query class and planner_id
+  std::map<std::string, std::map<std::string, PlannerStatistics>> statistics_;
+  // Number of races selected per query class, used to schedule exploration races
+  std::map<std::string, std::size_t> race_counts_;
+};
+}  // namespace planning_pipeline_interfaces
+}  // namespace moveit
@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Desc: A persistent thread pool executing planning requests by priority */
+
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <moveit/macros/class_forward.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace moveit
+{
+namespace planning_pipeline_interfaces
+{
+MOVEIT_CLASS_FORWARD(PlanningExecutor);  // Defines PlanningExecutorPtr, ConstPtr, WeakPtr... etc
+
+/** \brief A bounded pool of persistent threads that runs planning tasks, highest priority first and in submission
+ * order for equal priorities. Tasks submitted from one of the executor's own threads run immediately on that thread,
+ * so a task may wait for tasks it submits without deadlocking the pool. */
+class PlanningExecutor
+{
+public:
+  /** \brief Queue and throughput metrics */
+  struct Statistics
+  {
+    std::size_t queued = 0;           // tasks waiting for a thread
+    std::size_t active = 0;           // tasks being executed
+    std::size_t max_queued = 0;       // largest number of waiting tasks observed
+    std::size_t completed = 0;        // tasks that finished, including the inline ones
+    std::size_t inlined = 0;          // tasks run immediately on the executor thread that submitted them
+    double total_wait_time = 0.0;     // seconds spent in the queue by the tasks started so far
+  };
+
+  /** \brief Constructor
+   * \param [in] thread_count Number of threads, 0 uses std::thread::hardware_concurrency()
+   * \param [in] max_queue_size Maximum number of waiting tasks, 0 for no limit. When the queue is full, submit() blocks
+   * until a thread picks up a task
+   */
+  PlanningExecutor(std::size_t thread_count = 0, std::size_t max_queue_size = 0);
+
+  /** \brief Run the tasks that are still queued and join the threads */
+  ~PlanningExecutor();
+
+  PlanningExecutor(const PlanningExecutor&) = delete;
+  PlanningExecutor& operator=(const PlanningExecutor&) = delete;
+
+  /** \brief Queue a task
+   * \param [in] task Callable without arguments. Exceptions it throws are rethrown by the returned future
+   * \param [in] priority Tasks with a higher priority are started first
+   * \return Future holding the result of the task
+   */
+  template <typename Task>
+  std::future<std::invoke_result_t<Task>> submit(Task&& task, int priority = 0)
+  {
+    auto packaged_task = std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::forward<Task>(task));
+    std::future<std::invoke_result_t<Task>> result = packaged_task->get_future();
+    enqueue([packaged_task] { (*packaged_task)(); }, priority);
+    return result;
+  }
+
+  /** \brief Number of threads of the pool */
+  std::size_t getThreadCount() const
+  {
+    return threads_.size();
+  }
+
+  /** \brief Snapshot of the queue and throughput metrics */
+  Statistics getStatistics() const;
+
+private:
+  struct QueuedTask
+  {
+    int priority;
+    std::size_t sequence;
+    std::chrono::steady_clock::time_point submit_time;
+    std::function<void()> task;
+
+    bool operator<(const QueuedTask& other) const
+    {
+      // std::priority_queue pops the largest element: higher priority first, then lower sequence number
+      return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+    }
+  };
+
+  void enqueue(std::function<void()> task, int priority);
+  void run();
+
+  std::vector<std::thread> threads_;
+  std::size_t max_queue_size_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::condition_variable space_available_;
+  std::priority_queue<QueuedTask> queue_;
+  std::size_t next_sequence_;
+  bool stop_;
+  Statistics statistics_;
+};
+}  // namespace planning_pipeline_interfaces
+}  // namespace moveit
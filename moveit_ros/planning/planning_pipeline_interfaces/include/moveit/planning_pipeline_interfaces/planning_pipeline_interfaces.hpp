@@ -38,6 +38,7 @@
 #pragma once
 
 #include <moveit/planning_pipeline_interfaces/plan_responses_container.hpp>
+#include <moveit/planning_pipeline_interfaces/planning_executor.hpp>
 #include <moveit/planning_interface/planning_response.h>
 #include <moveit/planning_interface/planning_request.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
@@ -64,6 +65,15 @@ typedef std::function<::planning_interface::MotionPlanResponse(
     const std::vector<::planning_interface::MotionPlanResponse>& solutions)>
     SolutionSelectionFunction;
 
+/** \brief A callback function type to stream the motion plan responses of the parallel planning API as they arrive
+ * \param [in] plan_response Motion plan response that was just produced by one of the planning pipelines. The response
+ * is passed on whether planning succeeded or not, so its error code needs to be checked
+ * \param [in] plan_responses_container Container with all responses produced so far, including plan_response
+ */
+typedef std::function<void(const ::planning_interface::MotionPlanResponse& plan_response,
+                           const PlanResponsesContainer& plan_responses_container)>
+    PlanResponseCallback;
+
 /** \brief Function to calculate the MotionPlanResponse for a given MotionPlanRequest and a PlanningScene
  * \param [in] motion_plan_request Motion planning problem to be solved
  * \param [in] planning_scene Planning scene for which the given planning problem needs to be solved
@@ -82,10 +92,16 @@ typedef std::function<::planning_interface::MotionPlanResponse(
  * \param [in] planning_pipelines Pipelines available to solve the problems, if a requested pipeline is not provided the
  MotionPlanResponse will be FAILURE
  * \param [in] stopping_criterion_callback If this function returns true, the planning pipelines that are still running
- will be terminated and the existing solutions will be evaluated. If no callback is provided, all planning pipelines
+ will be terminated and the existing solutions will be evaluated. Requests whose pipeline has not started planning by
+ then are not planned and return PREEMPTED. If no callback is provided, all planning pipelines
  terminate after the max. planning time defined in the MotionPlanningRequest is reached.
  * \param [in] solution_selection_function Function to select a specific solution out of all available solution. If no
  function is provided, all solutions are returned.
+ * \param [in] plan_response_callback Called with every response as soon as its pipeline returns, before the stopping
+ criterion is evaluated, so callers can act on a good enough solution early. Calls to this callback and to the stopping
+ criterion are serialized.
+ * \param [in] planning_executor Executor the requests are planned on. If none is provided, one thread is created per
+ request. When called from a task of this executor, the requests are planned sequentially on the calling thread.
  + \return If a solution_selection_function is provided a vector containing the selected response is returned, otherwise
  the vector contains all solutions produced.
 */
@@ -94,7 +110,9 @@ const std::vector<::planning_interface::MotionPlanResponse> planWithParallelPipe
     const ::planning_scene::PlanningSceneConstPtr& planning_scene,
     const std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr>& planning_pipelines,
     const StoppingCriterionFunction& stopping_criterion_callback = nullptr,
-    const SolutionSelectionFunction& solution_selection_function = nullptr);
+    const SolutionSelectionFunction& solution_selection_function = nullptr,
+    const PlanResponseCallback& plan_response_callback = nullptr,
+    const PlanningExecutorPtr& planning_executor = nullptr);
 
 /** \brief Utility function to create a map of named planning pipelines
  * \param [in] pipeline_names Vector of planning pipeline names to be used. Each name is also the namespace from which
@@ -0,0 +1,279 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_pipeline_interfaces/planner_portfolio.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace moveit
+{
+namespace planning_pipeline_interfaces
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.planning_pipeline_interfaces.planner_portfolio");
+
+PlannerPortfolio::PlannerPortfolio(std::size_t min_runs, double min_win_rate, std::size_t exploration_period)
+  : min_runs_(min_runs), min_win_rate_(min_win_rate), exploration_period_(exploration_period)
+{
+}
+
+std::string PlannerPortfolio::getQueryClass(const ::planning_interface::MotionPlanRequest& request)
+{
+  std::string goal_type = "none";
+  if (!request.goal_constraints.empty())
+  {
+    const auto& goal = request.goal_constraints.front();
+    if (!goal.position_constraints.empty() || !goal.orientation_constraints.empty())
+    {
+      goal_type = "pose";
+    }
+    else if (!goal.joint_constraints.empty())
+    {
+      goal_type = "joint";
+    }
+    else
+    {
+      goal_type = "other";
+    }
+  }
+  return request.group_name + "/" + goal_type;
+}
+
+double PlannerPortfolio::getWinRate(const std::string& query_class, const std::string& planner_id) const
+{
+  const auto class_it = statistics_.find(query_class);
+  if (class_it == statistics_.end())
+  {
+    return 0.0;
+  }
+  const auto planner_it = class_it->second.find(planner_id);
+  return planner_it != class_it->second.end() ? planner_it->second.getWinRate() : 0.0;
+}
+
+std::vector<::planning_interface::MotionPlanRequest>
+PlannerPortfolio::selectRequests(const std::vector<::planning_interface::MotionPlanRequest>& requests)
+{
+  if (requests.empty())
+  {
+    return requests;
+  }
+
+  const std::string query_class = getQueryClass(requests.front());
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+
+  std::vector<std::pair<double, const ::planning_interface::MotionPlanRequest*>> ranked_requests;
+  ranked_requests.reserve(requests.size());
+  for (const auto& request : requests)
+  {
+    ranked_requests.emplace_back(getWinRate(query_class, request.planner_id), &request);
+  }
+  std::stable_sort(ranked_requests.begin(), ranked_requests.end(),
+                   [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  // Exploration races run every planner, so the statistics of dropped planners keep being updated
+  const std::size_t race_count = race_counts_[query_class]++;
+  const bool explore = exploration_period_ > 0 && race_count % exploration_period_ == 0;
+
+  std::vector<::planning_interface::MotionPlanRequest> selected_requests;
+  selected_requests.reserve(requests.size());
+  const auto class_it = statistics_.find(query_class);
+  for (const auto& [win_rate, request] : ranked_requests)
+  {
+    // Planners are only dropped once they took part in enough races to judge them
+    bool keep = explore || selected_requests.empty() || win_rate >= min_win_rate_ || class_it == statistics_.end();
+    if (!keep)
+    {
+      const auto planner_it = class_it->second.find(request->planner_id);
+      keep = planner_it == class_it->second.end() || planner_it->second.runs < min_runs_;
+    }
+
+    if (keep)
+    {
+      selected_requests.push_back(*request);
+    }
+    else
+    {
+      RCLCPP_DEBUG(LOGGER, "Skipping planner '%s' for query class '%s' with win rate %.3f",
+                   request->planner_id.c_str(), query_class.c_str(), win_rate);
+    }
+  }
+  return selected_requests;
+}
+
+StoppingCriterionFunction PlannerPortfolio::getStoppingCriterionFunction() const
+{
+  return [this](const PlanResponsesContainer& plan_responses_container,
+                const std::vector<::planning_interface::MotionPlanRequest>& plan_requests) {
+    if (plan_requests.empty())
+    {
+      return false;
+    }
+    const std::string query_class = getQueryClass(plan_requests.front());
+    const auto& solutions = plan_responses_container.getSolutions();
+
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    bool found_solution = false;
+    double best_success_win_rate = 0.0;
+    for (const auto& solution : solutions)
+    {
+      if (solution)
+      {
+        best_success_win_rate = std::max(best_success_win_rate, getWinRate(query_class, solution.planner_id));
+        found_solution = true;
+      }
+    }
+    if (!found_solution)
+    {
+      return false;
+    }
+
+    // Keep waiting if a planner that is still running usually beats the solutions found so far
+    for (const auto& request : plan_requests)
+    {
+      const bool returned = std::any_of(solutions.begin(), solutions.end(), [&request](const auto& solution) {
+        return solution.planner_id == request.planner_id;
+      });
+      if (!returned && getWinRate(query_class, request.planner_id) > best_success_win_rate)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+}
+
+SolutionSelectionFunction
+PlannerPortfolio::getSolutionSelectionFunction(const ::planning_interface::MotionPlanRequest& request,
+                                               const SolutionSelectionFunction& solution_selection_function)
+{
+  return [this, query_class = getQueryClass(request),
+          solution_selection_function](const std::vector<::planning_interface::MotionPlanResponse>& solutions) {
+    auto winner = solution_selection_function(solutions);
+    update(query_class, solutions, winner);
+    return winner;
+  };
+}
+
+void PlannerPortfolio::update(const std::string& query_class,
+                              const std::vector<::planning_interface::MotionPlanResponse>& solutions,
+                              const ::planning_interface::MotionPlanResponse& winner)
+{
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  auto& class_statistics = statistics_[query_class];
+  for (const auto& solution : solutions)
+  {
+    auto& planner_statistics = class_statistics[solution.planner_id];
+    ++planner_statistics.runs;
+    if (solution)
+    {
+      ++planner_statistics.successes;
+      planner_statistics.total_success_time += solution.planning_time;
+    }
+  }
+  // A race without any solution has no winner
+  if (winner)
+  {
+    ++class_statistics[winner.planner_id].wins;
+  }
+}
+
+PlannerPortfolio::PlannerStatistics PlannerPortfolio::getStatistics(const std::string& query_class,
+                                                                   const std::string& planner_id) const
+{
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  const auto class_it = statistics_.find(query_class);
+  if (class_it == statistics_.end())
+  {
+    return PlannerStatistics();
+  }
+  const auto planner_it = class_it->second.find(planner_id);
+  return planner_it != class_it->second.end() ? planner_it->second : PlannerStatistics();
+}
+
+bool PlannerPortfolio::save(const std::string& filename) const
+{
+  std::ofstream file(filename);
+  if (!file)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to open '%s' to save the planner portfolio", filename.c_str());
+    return false;
+  }
+
+  // One tab separated line per query class and planner
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  for (const auto& [query_class, class_statistics] : statistics_)
+  {
+    for (const auto& [planner_id, planner_statistics] : class_statistics)
+    {
+      file << query_class << '\t' << planner_id << '\t' << planner_statistics.runs << '\t'
+           << planner_statistics.successes << '\t' << planner_statistics.wins << '\t'
+           << planner_statistics.total_success_time << '\n';
+    }
+  }
+  return static_cast<bool>(file);
+}
+
+bool PlannerPortfolio::load(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if (!file)
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to open '%s' to load the planner portfolio", filename.c_str());
+    return false;
+  }
+
+  std::map<std::string, std::map<std::string, PlannerStatistics>> statistics;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream line_stream(line);
+    std::string query_class, planner_id;
+    PlannerStatistics planner_statistics;
+    if (!std::getline(line_stream, query_class, '\t') || !std::getline(line_stream, planner_id, '\t') ||
+        !(line_stream >> planner_statistics.runs >> planner_statistics.successes >> planner_statistics.wins >>
+          planner_statistics.total_success_time))
+    {
+      RCLCPP_ERROR(LOGGER, "Malformed line in planner portfolio '%s': '%s'", filename.c_str(), line.c_str());
+      return false;
+    }
+    statistics[query_class][planner_id] = planner_statistics;
+  }
+
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  statistics_ = std::move(statistics);
+  return true;
+}
+}  // namespace planning_pipeline_interfaces
+}  // namespace moveit
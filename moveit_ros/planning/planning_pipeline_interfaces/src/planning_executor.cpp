@@ -0,0 +1,139 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_pipeline_interfaces/planning_executor.hpp>
+
+#include <algorithm>
+
+namespace moveit
+{
+namespace planning_pipeline_interfaces
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.planning_pipeline_interfaces.planning_executor");
+
+namespace
+{
+// The executor owning the current thread, used to run nested submissions inline
+thread_local const PlanningExecutor* current_executor = nullptr;
+}  // namespace
+
+PlanningExecutor::PlanningExecutor(std::size_t thread_count, std::size_t max_queue_size)
+  : max_queue_size_(max_queue_size), next_sequence_(0), stop_(false)
+{
+  if (thread_count == 0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i)
+  {
+    threads_.emplace_back([this] { run(); });
+  }
+  RCLCPP_DEBUG(LOGGER, "Started planning executor with %zu threads", thread_count);
+}
+
+PlanningExecutor::~PlanningExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_available_.notify_all();
+  space_available_.notify_all();
+  for (std::thread& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+PlanningExecutor::Statistics PlanningExecutor::getStatistics() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Statistics statistics = statistics_;
+  statistics.queued = queue_.size();
+  return statistics;
+}
+
+void PlanningExecutor::enqueue(std::function<void()> task, int priority)
+{
+  // Waiting for a task queued behind the calling task could block the pool, so nested tasks run right away
+  if (current_executor == this)
+  {
+    task();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++statistics_.inlined;
+    ++statistics_.completed;
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_available_.wait(lock, [this] { return max_queue_size_ == 0 || queue_.size() < max_queue_size_ || stop_; });
+    queue_.push(QueuedTask{ priority, next_sequence_++, std::chrono::steady_clock::now(), std::move(task) });
+    statistics_.max_queued = std::max(statistics_.max_queued, queue_.size());
+  }
+  task_available_.notify_one();
+}
+
+void PlanningExecutor::run()
+{
+  current_executor = this;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    task_available_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty())
+    {
+      return;  // stop_ is set and no task is left
+    }
+
+    // std::priority_queue::top() is const, the task is moved out before popping it
+    std::function<void()> task = std::move(const_cast<QueuedTask&>(queue_.top()).task);
+    statistics_.total_wait_time +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - queue_.top().submit_time).count();
+    queue_.pop();
+    ++statistics_.active;
+    lock.unlock();
+    space_available_.notify_one();
+
+    // packaged tasks store exceptions in their future
+    task();
+
+    lock.lock();
+    --statistics_.active;
+    ++statistics_.completed;
+  }
+}
+}  // namespace planning_pipeline_interfaces
+}  // namespace moveit
@@ -36,6 +36,10 @@
 
 #include <moveit/planning_pipeline_interfaces/planning_pipeline_interfaces.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 namespace moveit
@@ -62,22 +66,49 @@ planWithSinglePipeline(const ::planning_interface::MotionPlanRequest& motion_pla
   return motion_plan_response;
 }
 
+namespace
+{
+// Terminate the planners of all pipelines used by the requests that are currently planning
+void terminateActivePipelines(
+    const std::vector<::planning_interface::MotionPlanRequest>& motion_plan_requests,
+    const std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr>& planning_pipelines)
+{
+  for (const auto& request : motion_plan_requests)
+  {
+    // Requests without a matching pipeline have already failed in planWithSinglePipeline()
+    auto it = planning_pipelines.find(request.pipeline_id);
+    if (it != planning_pipelines.end() && it->second->isActive())
+    {
+      it->second->terminate();
+    }
+  }
+}
+}  // namespace
+
 const std::vector<::planning_interface::MotionPlanResponse> planWithParallelPipelines(
     const std::vector<::planning_interface::MotionPlanRequest>& motion_plan_requests,
     const ::planning_scene::PlanningSceneConstPtr& planning_scene,
     const std::unordered_map<std::string, planning_pipeline::PlanningPipelinePtr>& planning_pipelines,
     const StoppingCriterionFunction& stopping_criterion_callback,
-    const SolutionSelectionFunction& solution_selection_function)
+    const SolutionSelectionFunction& solution_selection_function, const PlanResponseCallback& plan_response_callback,
+    const PlanningExecutorPtr& planning_executor)
 {
   // Create solutions container
   PlanResponsesContainer plan_responses_container{ motion_plan_requests.size() };
   std::vector<std::thread> planning_threads;
-  planning_threads.reserve(motion_plan_requests.size());
+  std::vector<std::future<void>> planning_tasks;
+
+  // Responses are stored, streamed and checked against the stopping criterion one at a time. Once the criterion is met,
+  // requests that did not start yet are skipped and this thread terminates the planners that are still running
+  std::mutex response_mutex;
+  std::condition_variable response_condition;
+  std::size_t finished_count = 0;
+  std::atomic<bool> stop_planning{ false };
 
   // Print a warning if more parallel planning problems than available concurrent threads are defined. If
   // std::thread::hardware_concurrency() is not defined, the command returns 0 so the check does not work
   auto const hardware_concurrency = std::thread::hardware_concurrency();
-  if (motion_plan_requests.size() > hardware_concurrency && hardware_concurrency != 0)
+  if (!planning_executor && motion_plan_requests.size() > hardware_concurrency && hardware_concurrency != 0)
   {
     RCLCPP_WARN(LOGGER,
                 "More parallel planning problems defined ('%ld') than possible to solve concurrently with the "
@@ -85,11 +116,16 @@ const std::vector<::planning_interface::MotionPlanResponse> planWithParallelPipe
                 motion_plan_requests.size(), hardware_concurrency);
   }
 
-  // Launch planning threads
-  for (const auto& request : motion_plan_requests)
-  {
-    auto planning_thread = std::thread([&]() {
-      auto plan_solution = ::planning_interface::MotionPlanResponse();
+  auto plan_request = [&](const ::planning_interface::MotionPlanRequest& request) {
+    auto plan_solution = ::planning_interface::MotionPlanResponse();
+    if (stop_planning)
+    {
+      RCLCPP_DEBUG(LOGGER, "Stopping criterion already met: Not starting planning pipeline '%s'",
+                   request.pipeline_id.c_str());
+      plan_solution.error_code = moveit::core::MoveItErrorCode::PREEMPTED;
+    }
+    else
+    {
       try
       {
         // Use planning scene if provided, otherwise the planning scene from planning scene monitor is used
@@ -101,35 +137,60 @@ const std::vector<::planning_interface::MotionPlanResponse> planWithParallelPipe
         plan_solution = ::planning_interface::MotionPlanResponse();
         plan_solution.error_code = moveit::core::MoveItErrorCode::FAILURE;
       }
-      plan_solution.planner_id = request.planner_id;
+    }
+    plan_solution.planner_id = request.planner_id;
+
+    {
+      std::lock_guard<std::mutex> lock(response_mutex);
       plan_responses_container.pushBack(plan_solution);
 
-      if (stopping_criterion_callback != nullptr)
+      if (plan_response_callback != nullptr)
       {
-        if (stopping_criterion_callback(plan_responses_container, motion_plan_requests))
-        {
-          // Terminate planning pipelines
-          RCLCPP_INFO(LOGGER, "Stopping criterion met: Terminating planning pipelines that are still active");
-          for (const auto& request : motion_plan_requests)
-          {
-            try
-            {
-              const auto& planning_pipeline = planning_pipelines.at(request.pipeline_id);
-              if (planning_pipeline->isActive())
-              {
-                planning_pipeline->terminate();
-              }
-            }
-            catch (const std::out_of_range&)
-            {
-              RCLCPP_WARN(LOGGER, "Cannot terminate pipeline '%s' because no pipeline with that name exists",
-                          request.pipeline_id.c_str());
-            }
-          }
-        }
+        plan_response_callback(plan_solution, plan_responses_container);
       }
-    });
-    planning_threads.push_back(std::move(planning_thread));
+
+      if (!stop_planning && stopping_criterion_callback != nullptr &&
+          stopping_criterion_callback(plan_responses_container, motion_plan_requests))
+      {
+        RCLCPP_INFO(LOGGER, "Stopping criterion met: Terminating planning pipelines that are still active");
+        stop_planning = true;
+      }
+      ++finished_count;
+    }
+    response_condition.notify_all();
+  };
+
+  // Launch planning tasks, on the executor if one is provided and on one thread per request otherwise
+  if (planning_executor)
+  {
+    planning_tasks.reserve(motion_plan_requests.size());
+    for (const auto& request : motion_plan_requests)
+    {
+      planning_tasks.push_back(planning_executor->submit([&plan_request, &request] { plan_request(request); }));
+    }
+  }
+  else
+  {
+    planning_threads.reserve(motion_plan_requests.size());
+    for (const auto& request : motion_plan_requests)
+    {
+      planning_threads.emplace_back(plan_request, std::cref(request));
+    }
+  }
+
+  // Wait until all pipelines returned or the stopping criterion is met. A planner that only creates its planning
+  // context after a termination request would not see it, so termination is repeated until every pipeline returned
+  {
+    std::unique_lock<std::mutex> lock(response_mutex);
+    response_condition.wait(lock, [&] { return stop_planning || finished_count == motion_plan_requests.size(); });
+    while (finished_count < motion_plan_requests.size())
+    {
+      lock.unlock();
+      terminateActivePipelines(motion_plan_requests, planning_pipelines);
+      lock.lock();
+      response_condition.wait_for(lock, std::chrono::milliseconds(10),
+                                  [&] { return finished_count == motion_plan_requests.size(); });
+    }
   }
 
   // Wait for threads to finish
@@ -140,6 +201,10 @@ const std::vector<::planning_interface::MotionPlanResponse> planWithParallelPipe
       planning_thread.join();
     }
   }
+  for (auto& planning_task : planning_tasks)
+  {
+    planning_task.wait();
+  }
 
   // If a solution selection function is provided, it is used to compute the return value
   if (solution_selection_function)
@@ -0,0 +1,209 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/planning_pipeline_interfaces/planner_portfolio.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using moveit::planning_pipeline_interfaces::PlannerPortfolio;
+
+namespace
+{
+const std::vector<std::string> PLANNERS = { "rrt_connect", "ptp", "stomp" };
+
+std::vector<planning_interface::MotionPlanRequest> makeRequests()
+{
+  std::vector<planning_interface::MotionPlanRequest> requests(PLANNERS.size());
+  for (std::size_t i = 0; i < PLANNERS.size(); ++i)
+  {
+    requests[i].group_name = "arm";
+    requests[i].planner_id = PLANNERS[i];
+    requests[i].goal_constraints.resize(1);
+    requests[i].goal_constraints[0].joint_constraints.resize(1);
+  }
+  return requests;
+}
+
+planning_interface::MotionPlanResponse makeResponse(const std::string& planner_id, bool success)
+{
+  planning_interface::MotionPlanResponse response;
+  response.planner_id = planner_id;
+  response.planning_time = 0.1;
+  response.error_code = success ? moveit::core::MoveItErrorCode::SUCCESS : moveit::core::MoveItErrorCode::FAILURE;
+  return response;
+}
+
+// Race in which rrt_connect wins, ptp fails and stomp succeeds too slowly to be selected
+void recordRace(PlannerPortfolio& portfolio, const std::string& query_class)
+{
+  const std::vector<planning_interface::MotionPlanResponse> solutions = { makeResponse("rrt_connect", true),
+                                                                          makeResponse("ptp", false),
+                                                                          makeResponse("stomp", true) };
+  portfolio.update(query_class, solutions, solutions[0]);
+}
+
+std::vector<std::string> plannerIds(const std::vector<planning_interface::MotionPlanRequest>& requests)
+{
+  std::vector<std::string> planner_ids;
+  for (const auto& request : requests)
+    planner_ids.push_back(request.planner_id);
+  return planner_ids;
+}
+}  // namespace
+
+TEST(PlannerPortfolio, QueryClassUsesGroupAndGoalType)
+{
+  auto request = makeRequests().front();
+  EXPECT_EQ(PlannerPortfolio::getQueryClass(request), "arm/joint");
+  request.goal_constraints[0].position_constraints.resize(1);
+  EXPECT_EQ(PlannerPortfolio::getQueryClass(request), "arm/pose");
+  request.goal_constraints.clear();
+  EXPECT_EQ(PlannerPortfolio::getQueryClass(request), "arm/none");
+}
+
+TEST(PlannerPortfolio, RecordsRaceOutcomes)
+{
+  PlannerPortfolio portfolio;
+  recordRace(portfolio, "arm/joint");
+  recordRace(portfolio, "arm/joint");
+
+  const auto winner = portfolio.getStatistics("arm/joint", "rrt_connect");
+  EXPECT_EQ(winner.runs, 2u);
+  EXPECT_EQ(winner.successes, 2u);
+  EXPECT_EQ(winner.wins, 2u);
+  EXPECT_NEAR(winner.total_success_time, 0.2, 1e-9);
+
+  const auto failing = portfolio.getStatistics("arm/joint", "ptp");
+  EXPECT_EQ(failing.runs, 2u);
+  EXPECT_EQ(failing.successes, 0u);
+  EXPECT_EQ(failing.wins, 0u);
+
+  EXPECT_EQ(portfolio.getStatistics("arm/pose", "rrt_connect").runs, 0u);
+}
+
+TEST(PlannerPortfolio, DropsPlannersThatNeverWin)
+{
+  PlannerPortfolio portfolio(/*min_runs=*/5, /*min_win_rate=*/0.1, /*exploration_period=*/0);
+  const auto requests = makeRequests();
+
+  // Without enough races, every planner is kept
+  for (std::size_t i = 0; i < 4; ++i)
+    recordRace(portfolio, "arm/joint");
+  EXPECT_EQ(portfolio.selectRequests(requests).size(), PLANNERS.size());
+
+  recordRace(portfolio, "arm/joint");
+  EXPECT_EQ(plannerIds(portfolio.selectRequests(requests)), std::vector<std::string>{ "rrt_connect" });
+
+  // Other query classes are not affected
+  auto pose_requests = requests;
+  for (auto& request : pose_requests)
+    request.goal_constraints[0].orientation_constraints.resize(1);
+  EXPECT_EQ(portfolio.selectRequests(pose_requests).size(), PLANNERS.size());
+}
+
+TEST(PlannerPortfolio, ExplorationRacesRunAllPlanners)
+{
+  PlannerPortfolio portfolio(/*min_runs=*/1, /*min_win_rate=*/0.1, /*exploration_period=*/3);
+  const auto requests = makeRequests();
+  recordRace(portfolio, "arm/joint");
+
+  EXPECT_EQ(portfolio.selectRequests(requests).size(), PLANNERS.size());
+  EXPECT_EQ(portfolio.selectRequests(requests).size(), 1u);
+  EXPECT_EQ(portfolio.selectRequests(requests).size(), 1u);
+  EXPECT_EQ(portfolio.selectRequests(requests).size(), PLANNERS.size());
+}
+
+TEST(PlannerPortfolio, StopsWhenNoRunningPlannerWinsMoreOften)
+{
+  PlannerPortfolio portfolio;
+  const auto requests = makeRequests();
+  recordRace(portfolio, "arm/joint");
+  const auto stopping_criterion = portfolio.getStoppingCriterionFunction();
+
+  // stomp succeeded, but rrt_connect usually wins and is still running
+  moveit::planning_pipeline_interfaces::PlanResponsesContainer container;
+  container.pushBack(makeResponse("stomp", true));
+  EXPECT_FALSE(stopping_criterion(container, requests));
+
+  container.pushBack(makeResponse("rrt_connect", true));
+  EXPECT_TRUE(stopping_criterion(container, requests));
+}
+
+TEST(PlannerPortfolio, SelectionFunctionUpdatesStatistics)
+{
+  PlannerPortfolio portfolio;
+  const auto requests = makeRequests();
+  const auto selection_function = portfolio.getSolutionSelectionFunction(
+      requests.front(), [](const std::vector<planning_interface::MotionPlanResponse>& solutions) {
+        return solutions.back();
+      });
+
+  const auto winner = selection_function({ makeResponse("ptp", false), makeResponse("stomp", true) });
+  EXPECT_EQ(winner.planner_id, "stomp");
+  EXPECT_EQ(portfolio.getStatistics("arm/joint", "stomp").wins, 1u);
+  EXPECT_EQ(portfolio.getStatistics("arm/joint", "ptp").runs, 1u);
+}
+
+TEST(PlannerPortfolio, SaveAndLoadRoundTrip)
+{
+  const std::string filename = "planner_portfolio_tests.tsv";
+  PlannerPortfolio portfolio;
+  recordRace(portfolio, "arm/joint");
+  ASSERT_TRUE(portfolio.save(filename));
+
+  PlannerPortfolio loaded_portfolio;
+  ASSERT_TRUE(loaded_portfolio.load(filename));
+  std::remove(filename.c_str());
+
+  for (const auto& planner_id : PLANNERS)
+  {
+    const auto expected = portfolio.getStatistics("arm/joint", planner_id);
+    const auto loaded = loaded_portfolio.getStatistics("arm/joint", planner_id);
+    EXPECT_EQ(loaded.runs, expected.runs);
+    EXPECT_EQ(loaded.successes, expected.successes);
+    EXPECT_EQ(loaded.wins, expected.wins);
+    EXPECT_NEAR(loaded.total_success_time, expected.total_success_time, 1e-9);
+  }
+
+  EXPECT_FALSE(loaded_portfolio.load("does_not_exist.tsv"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
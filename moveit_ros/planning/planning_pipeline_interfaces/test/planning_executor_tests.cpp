@@ -0,0 +1,151 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/planning_pipeline_interfaces/planning_executor.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using moveit::planning_pipeline_interfaces::PlanningExecutor;
+
+namespace
+{
+// Occupies a thread of the executor until it is released
+class BlockingTask
+{
+public:
+  explicit BlockingTask(PlanningExecutor& executor)
+  {
+    std::shared_future<void> released = release_.get_future().share();
+    done_ = executor.submit([this, released] {
+      started_.set_value();
+      released.wait();
+    });
+    started_.get_future().wait();
+  }
+
+  void release()
+  {
+    release_.set_value();
+    done_.wait();
+  }
+
+private:
+  std::promise<void> started_;
+  std::promise<void> release_;
+  std::future<void> done_;
+};
+}  // namespace
+
+TEST(PlanningExecutor, HigherPriorityFirstThenSubmissionOrder)
+{
+  PlanningExecutor executor(1);
+  BlockingTask blocking(executor);
+
+  // the tasks all run on the single thread of the executor, one after another
+  std::vector<std::string> order;
+  std::vector<std::future<void>> futures;
+  const std::vector<std::pair<std::string, int>> tasks = { { "a", 0 }, { "b", 1 }, { "c", 0 }, { "d", 2 }, { "e", 1 } };
+  for (const auto& [name, priority] : tasks)
+    futures.push_back(executor.submit([&order, name = name] { order.push_back(name); }, priority));
+  EXPECT_EQ(executor.getStatistics().queued, tasks.size());
+
+  blocking.release();
+  for (std::future<void>& future : futures)
+    future.get();
+  EXPECT_EQ(order, std::vector<std::string>({ "d", "b", "e", "a", "c" }));
+}
+
+TEST(PlanningExecutor, ExceptionsAreRethrownByTheFuture)
+{
+  PlanningExecutor executor(2);
+  std::future<int> failed = executor.submit([]() -> int { throw std::runtime_error("planning failed"); });
+  EXPECT_THROW(failed.get(), std::runtime_error);
+
+  // the thread that ran the failed task keeps serving the queue
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 4; ++i)
+    results.push_back(executor.submit([i] { return i; }));
+  for (int i = 0; i < 4; ++i)
+    EXPECT_EQ(results[i].get(), i);
+}
+
+TEST(PlanningExecutor, SubmitBlocksWhileTheQueueIsFull)
+{
+  PlanningExecutor executor(1, 1);
+  BlockingTask blocking(executor);
+  std::future<int> queued = executor.submit([] { return 1; });
+
+  std::promise<std::future<int>> second_submitted;
+  std::thread submitter([&] { second_submitted.set_value(executor.submit([] { return 2; })); });
+  std::future<std::future<int>> second = second_submitted.get_future();
+  EXPECT_EQ(second.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+  EXPECT_EQ(executor.getStatistics().queued, 1u);
+
+  // picking up the queued task makes room for the blocked submission
+  blocking.release();
+  EXPECT_EQ(queued.get(), 1);
+  EXPECT_EQ(second.get().get(), 2);
+  submitter.join();
+  EXPECT_EQ(executor.getStatistics().max_queued, 1u);
+}
+
+TEST(PlanningExecutor, NestedSubmissionsRunInline)
+{
+  // with a single thread, waiting for a queued nested task would never return
+  PlanningExecutor executor(1);
+  std::future<bool> outer = executor.submit([&executor] {
+    const std::thread::id outer_thread = std::this_thread::get_id();
+    return executor.submit([] { return std::this_thread::get_id(); }).get() == outer_thread;
+  });
+  ASSERT_EQ(outer.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_TRUE(outer.get());
+
+  const PlanningExecutor::Statistics statistics = executor.getStatistics();
+  EXPECT_EQ(statistics.inlined, 1u);
+  EXPECT_GE(statistics.completed, 1u);
+  EXPECT_EQ(statistics.max_queued, 1u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
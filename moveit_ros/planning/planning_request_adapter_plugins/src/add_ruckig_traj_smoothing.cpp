@@ -36,6 +36,7 @@
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
 #include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
 #include <class_loader/class_loader.hpp>
+#include <mutex>
 
 namespace default_planner_request_adapters
 {
@@ -67,7 +68,11 @@ public:
     bool result = planner(planning_scene, req, res);
     if (result && res.trajectory)
     {
-      if (!smoother_.applySmoothing(*res.trajectory, req.max_velocity_scaling_factor,
+      // Reuse the smoothing buffers, unless a concurrent request is using them right now
+      std::unique_lock<std::mutex> lock(workspace_mutex_, std::try_to_lock);
+      RuckigSmoothing::Workspace local_workspace;
+      RuckigSmoothing::Workspace& workspace = lock.owns_lock() ? workspace_ : local_workspace;
+      if (!smoother_.applySmoothing(workspace, *res.trajectory, req.max_velocity_scaling_factor,
                                     req.max_acceleration_scaling_factor))
       {
         result = false;
@@ -79,6 +84,8 @@ public:
 
 private:
   RuckigSmoothing smoother_;
+  mutable std::mutex workspace_mutex_;
+  mutable RuckigSmoothing::Workspace workspace_;
 };
 
 }  // namespace default_planner_request_adapters
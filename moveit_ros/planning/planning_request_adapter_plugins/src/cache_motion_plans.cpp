@@ -0,0 +1,401 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: Planning request adapter that reuses previously computed motion plans for repeated queries */
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/robot_state/conversions.h>
+#include <class_loader/class_loader.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <rclcpp/node.hpp>
+#include <rclcpp/serialization.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace default_planner_request_adapters
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.cache_motion_plans");
+
+namespace
+{
+// 64-bit FNV-1a over raw bytes, chained through the hash argument
+std::uint64_t hashBytes(std::uint64_t hash, const void* data, std::size_t size)
+{
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::uint64_t hashString(std::uint64_t hash, const std::string& str)
+{
+  // Include the length so that consecutive strings cannot alias each other
+  const std::size_t size = str.size();
+  hash = hashBytes(hash, &size, sizeof(size));
+  return hashBytes(hash, str.data(), size);
+}
+
+std::uint64_t hashPose(std::uint64_t hash, const Eigen::Isometry3d& pose)
+{
+  return hashBytes(hash, pose.matrix().data(), sizeof(double) * 16);
+}
+
+// Time stamps change with every request, but they do not change the meaning of a constraint
+std::uint64_t hashConstraints(std::uint64_t hash, moveit_msgs::msg::Constraints constraints)
+{
+  for (auto& constraint : constraints.position_constraints)
+    constraint.header.stamp = builtin_interfaces::msg::Time();
+  for (auto& constraint : constraints.orientation_constraints)
+    constraint.header.stamp = builtin_interfaces::msg::Time();
+  for (auto& constraint : constraints.visibility_constraints)
+  {
+    constraint.target_pose.header.stamp = builtin_interfaces::msg::Time();
+    constraint.sensor_pose.header.stamp = builtin_interfaces::msg::Time();
+  }
+
+  static const rclcpp::Serialization<moveit_msgs::msg::Constraints> SERIALIZER;
+  rclcpp::SerializedMessage serialized;
+  SERIALIZER.serialize_message(&constraints, &serialized);
+  const rcl_serialized_message_t& raw = serialized.get_rcl_serialized_message();
+  return hashBytes(hash, raw.buffer, raw.buffer_length);
+}
+
+// Shapes stored in the world are immutable and replaced (not edited) when an object changes, so an object is
+// identified by its id, its poses and the addresses of its shapes. Anything this misses (e.g. an octree updated in
+// place) is caught when the cached trajectory is revalidated against the scene.
+std::uint64_t hashWorld(std::uint64_t hash, const collision_detection::World& world)
+{
+  for (const auto& object : world)
+  {
+    hash = hashString(hash, object.first);
+    hash = hashPose(hash, object.second->pose_);
+    for (std::size_t i = 0; i < object.second->shapes_.size(); ++i)
+    {
+      const shapes::Shape* shape = object.second->shapes_[i].get();
+      hash = hashBytes(hash, &shape, sizeof(shape));
+      hash = hashPose(hash, object.second->shape_poses_[i]);
+    }
+  }
+  return hash;
+}
+}  // namespace
+
+/** @brief This adapter returns a previously computed trajectory when a request with the same goal, the same world and
+    (within a tolerance) the same start state is planned again. Cached trajectories are always revalidated against the
+    current scene before they are returned, and only successful plans are stored. To cache the final, time
+    parameterized trajectory, list this adapter first. With a positive statistics_period, the hit and miss counters
+    are published as diagnostics. */
+class CacheMotionPlans : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  CacheMotionPlans() : planning_request_adapter::PlanningRequestAdapter()
+  {
+  }
+
+  ~CacheMotionPlans() override
+  {
+    RCLCPP_INFO(LOGGER, "Motion plan cache: %zu hits, %zu misses, %zu invalidated entries", hits_.load(),
+                misses_.load(), invalidated_.load());
+  }
+
+  void initialize(const rclcpp::Node::SharedPtr& node, const std::string& parameter_namespace) override
+  {
+    const int max_entries = getParam(node, LOGGER, parameter_namespace, "max_entries", 100);
+    max_entries_ = static_cast<std::size_t>(std::max(max_entries, 1));
+    start_state_tolerance_ = getParam(node, LOGGER, parameter_namespace, "start_state_tolerance", 0.001);
+    if (start_state_tolerance_ <= 0.0)
+    {
+      RCLCPP_WARN(LOGGER, "The start state tolerance must be positive, using 0.001");
+      start_state_tolerance_ = 0.001;
+    }
+
+    const double statistics_period = getParam(node, LOGGER, parameter_namespace, "statistics_period", 0.0);
+    if (statistics_period > 0.0)
+    {
+      statistics_publisher_ = node->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 1);
+      statistics_timer_ =
+          node->create_wall_timer(std::chrono::duration<double>(statistics_period),
+                                  [this, clock = node->get_clock()] { publishStatistics(clock->now()); });
+    }
+  }
+
+  std::string getDescription() const override
+  {
+    return "Cache Motion Plans";
+  }
+
+  bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
+                    std::vector<std::size_t>& /*added_path_index*/) const override
+  {
+    const moveit::core::JointModelGroup* jmg = planning_scene->getRobotModel()->getJointModelGroup(req.group_name);
+    if (!jmg)
+      return planner(planning_scene, req, res);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    RCLCPP_DEBUG(LOGGER, "Running '%s'", getDescription().c_str());
+
+    moveit::core::RobotState start_state = planning_scene->getCurrentState();
+    moveit::core::robotStateMsgToRobotState(planning_scene->getTransforms(), req.start_state, start_state);
+    std::vector<double> start_positions;
+    start_state.copyJointGroupPositions(jmg, start_positions);
+
+    const std::uint64_t key = computeKey(*planning_scene, req);
+    robot_trajectory::RobotTrajectoryPtr cached = lookup(key, start_positions);
+    if (cached)
+    {
+      robot_trajectory::RobotTrajectoryPtr trajectory = rebaseTrajectory(*cached, start_state, jmg);
+      if (planning_scene->isPathValid(*trajectory, req.path_constraints, req.goal_constraints, req.group_name))
+      {
+        ++hits_;
+        res.trajectory = trajectory;
+        res.error_code = moveit::core::MoveItErrorCode::SUCCESS;
+        res.planning_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        RCLCPP_DEBUG(LOGGER, "Returning cached motion plan (%zu hits, %zu misses)", hits_.load(), misses_.load());
+        return true;
+      }
+      ++invalidated_;
+      erase(key, cached);
+      RCLCPP_DEBUG(LOGGER, "Cached motion plan is no longer valid in the current scene");
+    }
+
+    ++misses_;
+    RCLCPP_DEBUG(LOGGER, "No cached motion plan, planning (%zu hits, %zu misses)", hits_.load(), misses_.load());
+    const bool result = planner(planning_scene, req, res);
+    if (result && res.error_code == moveit::core::MoveItErrorCode::SUCCESS && res.trajectory &&
+        !res.trajectory->empty())
+      insert(key, start_positions, std::make_shared<robot_trajectory::RobotTrajectory>(*res.trajectory, true));
+    return result;
+  }
+
+private:
+  struct Entry
+  {
+    std::uint64_t key;
+    std::vector<double> start_positions;
+    robot_trajectory::RobotTrajectoryPtr trajectory;
+  };
+
+  /** \brief Hash everything of a request except the start state, which is compared to the entries on lookup */
+  std::uint64_t computeKey(const planning_scene::PlanningScene& planning_scene,
+                           const planning_interface::MotionPlanRequest& req) const
+  {
+    std::uint64_t hash = 14695981039346656037ULL;
+    hash = hashString(hash, req.group_name);
+    hash = hashString(hash, req.pipeline_id);
+    hash = hashString(hash, req.planner_id);
+    hash = hashBytes(hash, &req.max_velocity_scaling_factor, sizeof(double));
+    hash = hashBytes(hash, &req.max_acceleration_scaling_factor, sizeof(double));
+    for (const moveit_msgs::msg::Constraints& constraints : req.goal_constraints)
+      hash = hashConstraints(hash, constraints);
+    hash = hashConstraints(hash, req.path_constraints);
+    return hashWorld(hash, *planning_scene.getWorld());
+  }
+
+  /** \brief Largest difference of a joint position, or infinity if the positions are of different groups */
+  static double startStateDistance(const std::vector<double>& a, const std::vector<double>& b)
+  {
+    if (a.size() != b.size())
+      return std::numeric_limits<double>::infinity();
+    double distance = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+      distance = std::max(distance, std::fabs(a[i] - b[i]));
+    return distance;
+  }
+
+  /** \brief Find the entry of \e key whose start state is closest to \e start_positions, within the tolerance.
+      Must be called with cache_mutex_ held. */
+  std::list<Entry>::iterator findEntry(std::uint64_t key, const std::vector<double>& start_positions) const
+  {
+    std::list<Entry>::iterator closest = entries_.end();
+    double closest_distance = start_state_tolerance_;
+    const auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      const double distance = startStateDistance(it->second->start_positions, start_positions);
+      if (distance <= closest_distance)
+      {
+        closest = it->second;
+        closest_distance = distance;
+      }
+    }
+    return closest;
+  }
+
+  /** \brief Remove \e entry from the index and the list. Must be called with cache_mutex_ held. */
+  void eraseEntry(std::list<Entry>::iterator entry) const
+  {
+    const auto range = index_.equal_range(entry->key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == entry)
+      {
+        index_.erase(it);
+        break;
+      }
+    }
+    entries_.erase(entry);
+  }
+
+  robot_trajectory::RobotTrajectoryPtr lookup(std::uint64_t key, const std::vector<double>& start_positions) const
+  {
+    std::scoped_lock lock(cache_mutex_);
+    const std::list<Entry>::iterator entry = findEntry(key, start_positions);
+    if (entry == entries_.end())
+      return nullptr;
+
+    // Mark as most recently used
+    entries_.splice(entries_.begin(), entries_, entry);
+    return entry->trajectory;
+  }
+
+  void insert(std::uint64_t key, std::vector<double> start_positions,
+              const robot_trajectory::RobotTrajectoryPtr& trajectory) const
+  {
+    std::scoped_lock lock(cache_mutex_);
+    const std::list<Entry>::iterator existing = findEntry(key, start_positions);
+    if (existing != entries_.end())
+      eraseEntry(existing);
+    entries_.push_front(Entry{ key, std::move(start_positions), trajectory });
+    index_.emplace(key, entries_.begin());
+
+    while (entries_.size() > max_entries_)
+      eraseEntry(std::prev(entries_.end()));
+  }
+
+  /** \brief Remove the entry of \e key holding \e trajectory, unless it was replaced or evicted meanwhile */
+  void erase(std::uint64_t key, const robot_trajectory::RobotTrajectoryPtr& trajectory) const
+  {
+    std::scoped_lock lock(cache_mutex_);
+    const auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second->trajectory == trajectory)
+      {
+        eraseEntry(it->second);
+        return;
+      }
+    }
+  }
+
+  void publishStatistics(const rclcpp::Time& stamp) const
+  {
+    std::size_t entries;
+    {
+      std::scoped_lock lock(cache_mutex_);
+      entries = entries_.size();
+    }
+
+    diagnostic_msgs::msg::DiagnosticArray msg;
+    msg.header.stamp = stamp;
+    diagnostic_msgs::msg::DiagnosticStatus& status = msg.status.emplace_back();
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = "motion plan cache";
+    status.message = std::to_string(entries) + " cached plans";
+    const auto add_value = [&status](const std::string& key, std::size_t value) {
+      diagnostic_msgs::msg::KeyValue& key_value = status.values.emplace_back();
+      key_value.key = key;
+      key_value.value = std::to_string(value);
+    };
+    add_value("hits", hits_.load());
+    add_value("misses", misses_.load());
+    add_value("invalidated", invalidated_.load());
+    add_value("entries", entries);
+    statistics_publisher_->publish(msg);
+  }
+
+  /** \brief Copy the group motion of a cached trajectory onto the actual start state of the request, so that joints
+      outside the group and the first waypoint match the request exactly */
+  static robot_trajectory::RobotTrajectoryPtr rebaseTrajectory(const robot_trajectory::RobotTrajectory& cached,
+                                                               const moveit::core::RobotState& start_state,
+                                                               const moveit::core::JointModelGroup* jmg)
+  {
+    auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(start_state.getRobotModel(), jmg);
+    std::vector<double> values;
+    for (std::size_t i = 0; i < cached.getWayPointCount(); ++i)
+    {
+      const moveit::core::RobotState& cached_state = cached.getWayPoint(i);
+      auto state = std::make_shared<moveit::core::RobotState>(start_state);
+      if (i > 0)
+      {
+        cached_state.copyJointGroupPositions(jmg, values);
+        state->setJointGroupPositions(jmg, values);
+      }
+      if (cached_state.hasVelocities())
+      {
+        cached_state.copyJointGroupVelocities(jmg, values);
+        state->setJointGroupVelocities(jmg, values);
+      }
+      if (cached_state.hasAccelerations())
+      {
+        cached_state.copyJointGroupAccelerations(jmg, values);
+        state->setJointGroupAccelerations(jmg, values);
+      }
+      state->update();
+      trajectory->addSuffixWayPoint(state, cached.getWayPointDurationFromPrevious(i));
+    }
+    return trajectory;
+  }
+
+  std::size_t max_entries_ = 100;
+  double start_state_tolerance_ = 0.001;
+
+  // Most recently used entries first, indexed by their key; entries of the same key differ in their start state
+  mutable std::list<Entry> entries_;
+  mutable std::unordered_multimap<std::uint64_t, std::list<Entry>::iterator> index_;
+  mutable std::mutex cache_mutex_;
+
+  mutable std::atomic<std::size_t> hits_{ 0 };
+  mutable std::atomic<std::size_t> misses_{ 0 };
+  mutable std::atomic<std::size_t> invalidated_{ 0 };
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr statistics_publisher_;
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+};
+
+}  // namespace default_planner_request_adapters
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::CacheMotionPlans,
+                            planning_request_adapter::PlanningRequestAdapter)
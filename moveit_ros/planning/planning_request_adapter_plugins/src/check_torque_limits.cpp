@@ -0,0 +1,180 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Description: Planning request adapter that checks the joint torques along the planned trajectory against the
+   effort limits of the robot and re-times or rejects trajectories that exceed them */
+
+#include <moveit/dynamics_solver/dynamics_solver.h>
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <class_loader/class_loader.hpp>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <rclcpp/node.hpp>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace default_planner_request_adapters
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.check_torque_limits");
+
+/** @brief This adapter computes the inverse dynamics of all waypoints of the planned trajectory and compares the
+    torques with the effort limits of the URDF. Trajectories that exceed the limits are re-timed with reduced velocity
+    and acceleration scaling. If that does not bring the torques within the limits, the plan fails.
+    It needs to be listed before the time parameterization adapter, so that it checks the timed trajectory. */
+class CheckTorqueLimits : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  CheckTorqueLimits() : planning_request_adapter::PlanningRequestAdapter()
+  {
+  }
+
+  void initialize(const rclcpp::Node::SharedPtr& node, const std::string& parameter_namespace) override
+  {
+    payload_ = getParam(node, LOGGER, parameter_namespace, "torque_limits.payload", 0.0);
+    gravity_.x = getParam(node, LOGGER, parameter_namespace, "torque_limits.gravity_x", 0.0);
+    gravity_.y = getParam(node, LOGGER, parameter_namespace, "torque_limits.gravity_y", 0.0);
+    gravity_.z = getParam(node, LOGGER, parameter_namespace, "torque_limits.gravity_z", -9.81);
+    max_retime_attempts_ = getParam(node, LOGGER, parameter_namespace, "torque_limits.max_retime_attempts", 5);
+    scaling_reduction_ = getParam(node, LOGGER, parameter_namespace, "torque_limits.scaling_reduction", 0.7);
+    thread_count_ = getParam(node, LOGGER, parameter_namespace, "torque_limits.thread_count", 0);
+    path_tolerance_ = getParam(node, LOGGER, parameter_namespace, "path_tolerance", 0.1);
+    resample_dt_ = getParam(node, LOGGER, parameter_namespace, "resample_dt", 0.1);
+    min_angle_change_ = getParam(node, LOGGER, parameter_namespace, "min_angle_change", 0.001);
+  }
+
+  std::string getDescription() const override
+  {
+    return "Check Torque Limits";
+  }
+
+  bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
+                    std::vector<std::size_t>& /*added_path_index*/) const override
+  {
+    bool result = planner(planning_scene, req, res);
+    if (!result || !res.trajectory || res.trajectory->empty() || !res.trajectory->getGroup())
+      return result;
+
+    RCLCPP_DEBUG(LOGGER, " Running '%s'", getDescription().c_str());
+    const dynamics_solver::DynamicsSolverConstPtr solver = getSolver(res.trajectory->getRobotModel(),
+                                                                     res.trajectory->getGroupName());
+    if (!solver->getGroup())
+    {
+      RCLCPP_WARN(LOGGER, "Cannot compute the dynamics of group '%s'. The torques are not checked.",
+                  res.trajectory->getGroupName().c_str());
+      return result;
+    }
+
+    dynamics_solver::TorqueLimitCheckResult check;
+    if (!solver->checkTorqueLimits(*res.trajectory, payload_, check, thread_count_))
+    {
+      RCLCPP_ERROR(LOGGER, "Failed to compute the torques along the trajectory");
+      res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_MOTION_PLAN;
+      return false;
+    }
+
+    const std::vector<std::string>& joint_names = solver->getGroup()->getVariableNames();
+
+    // Lower velocity and acceleration scaling reduce the dynamic part of the torques, but not the static part
+    const robot_trajectory::RobotTrajectory path(*res.trajectory, true);
+    double velocity_scaling = req.max_velocity_scaling_factor > 0.0 ? req.max_velocity_scaling_factor : 1.0;
+    double acceleration_scaling = req.max_acceleration_scaling_factor > 0.0 ? req.max_acceleration_scaling_factor : 1.0;
+    trajectory_processing::TimeOptimalTrajectoryGeneration totg(path_tolerance_, resample_dt_, min_angle_change_);
+    for (int attempt = 0; !check.withinLimits() && attempt < max_retime_attempts_; ++attempt)
+    {
+      RCLCPP_INFO(LOGGER, "Joint '%s' exceeds its torque limit by a factor of %.2f at waypoint %zu. Re-timing.",
+                  joint_names[check.joint].c_str(), check.max_torque_ratio, check.waypoint);
+
+      // Accelerations contribute linearly to the torques and velocities quadratically
+      const double reduction = std::min(scaling_reduction_, 1.0 / check.max_torque_ratio);
+      acceleration_scaling *= reduction;
+      velocity_scaling *= std::sqrt(reduction);
+
+      auto retimed = std::make_shared<robot_trajectory::RobotTrajectory>(path, true);
+      if (!totg.computeTimeStamps(*retimed, velocity_scaling, acceleration_scaling) ||
+          !solver->checkTorqueLimits(*retimed, payload_, check, thread_count_))
+      {
+        RCLCPP_WARN(LOGGER, "Re-timing the trajectory failed.");
+        break;
+      }
+      res.trajectory = retimed;
+    }
+
+    if (!check.withinLimits())
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' exceeds its torque limit by a factor of %.2f at waypoint %zu. Rejecting it.",
+                   joint_names[check.joint].c_str(), check.max_torque_ratio, check.waypoint);
+      res.error_code.val = moveit_msgs::msg::MoveItErrorCodes::INVALID_MOTION_PLAN;
+      return false;
+    }
+    return result;
+  }
+
+private:
+  // Constructing a solver parses the URDF into a KDL tree, so the solver of every group is kept
+  dynamics_solver::DynamicsSolverConstPtr getSolver(const moveit::core::RobotModelConstPtr& robot_model,
+                                                    const std::string& group_name) const
+  {
+    std::scoped_lock lock(solvers_mutex_);
+    if (robot_model != solvers_robot_model_)
+    {
+      solvers_.clear();
+      solvers_robot_model_ = robot_model;
+    }
+    dynamics_solver::DynamicsSolverConstPtr& solver = solvers_[group_name];
+    if (!solver)
+      solver = std::make_shared<const dynamics_solver::DynamicsSolver>(robot_model, group_name, gravity_);
+    return solver;
+  }
+
+  double payload_;
+  geometry_msgs::msg::Vector3 gravity_;
+  int max_retime_attempts_;
+  double scaling_reduction_;
+  int thread_count_;
+  double path_tolerance_;
+  double resample_dt_;
+  double min_angle_change_;
+
+  mutable std::mutex solvers_mutex_;
+  mutable moveit::core::RobotModelConstPtr solvers_robot_model_;
+  mutable std::map<std::string, dynamics_solver::DynamicsSolverConstPtr> solvers_;
+};
+
+}  // namespace default_planner_request_adapters
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::CheckTorqueLimits,
+                            planning_request_adapter::PlanningRequestAdapter)
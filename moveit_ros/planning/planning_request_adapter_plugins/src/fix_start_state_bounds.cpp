@@ -73,8 +73,7 @@ public:
     RCLCPP_DEBUG(LOGGER, "Running '%s'", getDescription().c_str());
 
     // get the specified start state
-    moveit::core::RobotState start_state = planning_scene->getCurrentState();
-    moveit::core::robotStateMsgToRobotState(planning_scene->getTransforms(), req.start_state, start_state);
+    moveit::core::RobotState start_state = getRequestContext().getStartState(planning_scene, req);
 
     const std::vector<const moveit::core::JointModel*>& jmodels =
         planning_scene->getRobotModel()->hasJointModelGroup(req.group_name) ?
@@ -42,6 +42,12 @@
 #include <rclcpp/logging.hpp>
 #include <rclcpp/node.hpp>
 #include <rclcpp/parameter_value.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 namespace default_planner_request_adapters
 {
@@ -53,6 +59,7 @@ public:
   static const std::string DT_PARAM_NAME;
   static const std::string JIGGLE_PARAM_NAME;
   static const std::string ATTEMPTS_PARAM_NAME;
+  static const std::string THREADS_PARAM_NAME;
 
   void initialize(const rclcpp::Node::SharedPtr& node, const std::string& parameter_namespace) override
   {
@@ -65,6 +72,13 @@ public:
       sampling_attempts_ = 1;
       RCLCPP_WARN(LOGGER, "Param '%s' needs to be at least 1.", ATTEMPTS_PARAM_NAME.c_str());
     }
+    // 0 uses all cores, 1 samples sequentially
+    sampling_thread_count_ = getParam(node_, LOGGER, parameter_namespace, THREADS_PARAM_NAME, 1);
+    if (sampling_thread_count_ < 0)
+    {
+      sampling_thread_count_ = 1;
+      RCLCPP_WARN(LOGGER, "Param '%s' needs to be at least 0.", THREADS_PARAM_NAME.c_str());
+    }
   }
 
   std::string getDescription() const override
@@ -72,6 +86,11 @@ public:
     return "Fix Start State In Collision";
   }
 
+  unsigned int getStartStateChecks() const override
+  {
+    return planning_request_adapter::PlanningRequestContext::COLLISION;
+  }
+
   bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
                     std::vector<std::size_t>& added_path_index) const override
@@ -79,14 +98,12 @@ public:
     RCLCPP_DEBUG(LOGGER, "Running '%s'", getDescription().c_str());
 
     // get the specified start state
-    moveit::core::RobotState start_state = planning_scene->getCurrentState();
-    moveit::core::robotStateMsgToRobotState(planning_scene->getTransforms(), req.start_state, start_state);
+    planning_request_adapter::PlanningRequestContext& context = getRequestContext();
+    moveit::core::RobotState start_state = context.getStartState(planning_scene, req);
 
     collision_detection::CollisionRequest creq;
     creq.group_name = req.group_name;
-    collision_detection::CollisionResult cres;
-    planning_scene->checkCollision(creq, cres, start_state);
-    if (cres.collision)
+    if (context.isStartStateColliding(planning_scene, req))
     {
       // Rerun in verbose mode
       collision_detection::CollisionRequest vcreq = creq;
@@ -111,25 +128,68 @@ public:
               planning_scene->getRobotModel()->getJointModelGroup(req.group_name)->getJointModels() :
               planning_scene->getRobotModel()->getJointModels();
 
-      bool found = false;
-      for (int c = 0; !found && c < sampling_attempts_; ++c)
-      {
-        for (std::size_t i = 0; !found && i < jmodels.size(); ++i)
+      // Every attempt draws from its own random stream, so the result does not depend on the number of threads.
+      // Attempts are handed out in order and the valid sample of the lowest attempt wins.
+      const std::size_t attempt_count = sampling_attempts_;
+      std::vector<std::uint32_t> seeds(attempt_count);
+      for (std::uint32_t& seed : seeds)
+        seed = static_cast<std::uint32_t>(rng.uniformInteger(0, std::numeric_limits<int>::max()));
+
+      std::size_t thread_count = sampling_thread_count_ == 0 ? std::max(1u, std::thread::hardware_concurrency()) :
+                                                               static_cast<std::size_t>(sampling_thread_count_);
+      thread_count = std::min(thread_count, attempt_count);
+
+      std::atomic<std::size_t> next_attempt(0);
+      std::atomic<std::size_t> found_attempt(attempt_count);
+      std::mutex found_lock;
+      const auto worker = [&] {
+        moveit::core::RobotState state(*prefix_state);
+        std::vector<double> sampled_variable_values;
+        collision_detection::CollisionResult sample_cres;
+        for (std::size_t c = next_attempt++; c < found_attempt; c = next_attempt++)
         {
-          std::vector<double> sampled_variable_values(jmodels[i]->getVariableCount());
-          const double* original_values = prefix_state->getJointPositions(jmodels[i]);
-          jmodels[i]->getVariableRandomPositionsNearBy(rng, &sampled_variable_values[0], original_values,
-                                                       jmodels[i]->getMaximumExtent() * jiggle_fraction_);
-          start_state.setJointPositions(jmodels[i], sampled_variable_values);
-          collision_detection::CollisionResult cres;
-          planning_scene->checkCollision(creq, cres, start_state);
-          if (!cres.collision)
+          random_numbers::RandomNumberGenerator attempt_rng(seeds[c]);
+          // the sampling radius grows over the first half of the attempts, which prefers valid states close to the
+          // start state and still leaves half of the attempts for the full jiggle fraction
+          const double radius_fraction =
+              jiggle_fraction_ * std::min(1.0, 2.0 * static_cast<double>(c + 1) / static_cast<double>(attempt_count));
+          state = *prefix_state;
+          for (const moveit::core::JointModel* jmodel : jmodels)
           {
-            found = true;
-            RCLCPP_INFO(LOGGER, "Found a valid state near the start state at distance %lf after %d attempts",
-                        prefix_state->distance(start_state), c);
+            sampled_variable_values.resize(jmodel->getVariableCount());
+            jmodel->getVariableRandomPositionsNearBy(attempt_rng, sampled_variable_values.data(),
+                                                     prefix_state->getJointPositions(jmodel),
+                                                     jmodel->getMaximumExtent() * radius_fraction);
+            state.setJointPositions(jmodel, sampled_variable_values);
+            sample_cres.clear();
+            planning_scene->checkCollision(creq, sample_cres, state);
+            if (!sample_cres.collision)
+            {
+              std::scoped_lock slock(found_lock);
+              if (c < found_attempt)
+              {
+                found_attempt = c;
+                start_state = state;
+              }
+              break;
+            }
           }
         }
+      };
+
+      std::vector<std::thread> threads;
+      threads.reserve(thread_count - 1);
+      for (std::size_t i = 1; i < thread_count; ++i)
+        threads.emplace_back(worker);
+      worker();
+      for (std::thread& thread : threads)
+        thread.join();
+
+      const bool found = found_attempt < attempt_count;
+      if (found)
+      {
+        RCLCPP_INFO(LOGGER, "Found a valid state near the start state at distance %lf after %zu attempts",
+                    prefix_state->distance(start_state), found_attempt.load());
       }
 
       if (found)
@@ -180,11 +240,13 @@ private:
   double max_dt_offset_;
   double jiggle_fraction_;
   int sampling_attempts_;
+  int sampling_thread_count_;
 };
 
 const std::string FixStartStateCollision::DT_PARAM_NAME = "start_state_max_dt";
 const std::string FixStartStateCollision::JIGGLE_PARAM_NAME = "jiggle_fraction";
 const std::string FixStartStateCollision::ATTEMPTS_PARAM_NAME = "max_sampling_attempts";
+const std::string FixStartStateCollision::THREADS_PARAM_NAME = "sampling_thread_count";
 }  // namespace default_planner_request_adapters
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::FixStartStateCollision,
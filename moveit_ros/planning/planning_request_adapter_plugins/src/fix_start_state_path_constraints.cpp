@@ -63,22 +63,26 @@ public:
     return "Fix Start State Path Constraints";
   }
 
+  unsigned int getStartStateChecks() const override
+  {
+    return planning_request_adapter::PlanningRequestContext::VALIDITY |
+           planning_request_adapter::PlanningRequestContext::PATH_CONSTRAINTS;
+  }
+
   bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
                     std::vector<std::size_t>& added_path_index) const override
   {
     RCLCPP_DEBUG(LOGGER, "Running '%s'", getDescription().c_str());
 
-    // get the specified start state
-    moveit::core::RobotState start_state = planning_scene->getCurrentState();
-    moveit::core::robotStateMsgToRobotState(planning_scene->getTransforms(), req.start_state, start_state);
-
     // if the start state is otherwise valid but does not meet path constraints
-    if (planning_scene->isStateValid(start_state, req.group_name) &&
-        !planning_scene->isStateValid(start_state, req.path_constraints, req.group_name))
+    planning_request_adapter::PlanningRequestContext& context = getRequestContext();
+    if (context.isStartStateValid(planning_scene, req) &&
+        !context.isStartStateValidWithPathConstraints(planning_scene, req))
     {
       RCLCPP_INFO(LOGGER, "Path constraints not satisfied for start state...");
-      planning_scene->isStateValid(start_state, req.path_constraints, req.group_name, true);
+      planning_scene->isStateValid(context.getStartState(planning_scene, req), req.path_constraints, req.group_name,
+                                   true);
       RCLCPP_INFO(LOGGER, "Planning to path constraints...");
 
       planning_interface::MotionPlanRequest req2 = req;
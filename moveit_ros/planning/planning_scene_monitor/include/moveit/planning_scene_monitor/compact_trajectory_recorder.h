@@ -0,0 +1,170 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_state/robot_state.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace planning_scene_monitor
+{
+MOVEIT_CLASS_FORWARD(CompactTrajectoryRecorder);  // Defines CompactTrajectoryRecorderPtr, ConstPtr, WeakPtr... etc
+
+/** @brief Samples of a compact trajectory recording, see CompactTrajectoryRecorder::read() */
+struct CompactTrajectorySamples
+{
+  std::vector<std::string> variable_names;
+
+  /** @brief Time of each sample, in seconds */
+  std::vector<double> times;
+
+  /** @brief One row of positions per sample, in the order of variable_names */
+  std::vector<double> positions;
+};
+
+/** @brief Records the joint positions of a trajectory in a compact, columnar format.
+ *
+ *  Samples are collected in chunks. A chunk holds the times of its samples and the positions at its first sample.
+ *  Then, for each variable, it holds only the samples at which the variable changed, with the new values. With delta
+ *  encoding, a change is stored as the single precision difference to the previously stored value. The encoder
+ *  tracks the decoded values, so rounding errors do not add up over a chunk.
+ *
+ *  If a file is streamed to, full chunks are written to it. Otherwise the latest Options::max_chunks full chunks are
+ *  kept in memory.
+ *
+ *  The format uses the byte order of the host and aligns all fields to 8 bytes, so a memory-mapped file can be read
+ *  in place:
+ *
+ *      file:   "MVTRAJ01" | uint64 variable count | {uint64 name length | name, padded to 8 bytes} per variable
+ *              | chunks...
+ *      chunk:  uint64 size of the chunk in bytes | uint64 sample count n | uint64 flags (1: delta encoding)
+ *              | double times[n] | double first positions[variable count] | uint64 change counts[variable count]
+ *              | {uint32 sample indices[c], padded | double values[c] or float differences[c], padded}
+ *                per variable with c changes */
+class CompactTrajectoryRecorder
+{
+public:
+  struct Options
+  {
+    /** @brief Number of samples per chunk */
+    std::size_t chunk_size = 1024;
+
+    /** @brief Number of full chunks kept in memory when not streaming to a file */
+    std::size_t max_chunks = 64;
+
+    /** @brief Changes of a variable up to this value are not recorded */
+    double tolerance = 0.0;
+
+    /** @brief Store changes as single precision differences instead of double precision values */
+    bool delta_encoding = false;
+  };
+
+  /** @brief Record the positions of the variables in \e variable_names, in that order */
+  CompactTrajectoryRecorder(std::vector<std::string> variable_names, const Options& options);
+
+  /** @brief Record the variable positions of states of \e robot_model */
+  CompactTrajectoryRecorder(const moveit::core::RobotModelConstPtr& robot_model, const Options& options);
+
+  /** @brief Write the unfinished chunk to the file, if streaming */
+  ~CompactTrajectoryRecorder();
+
+  CompactTrajectoryRecorder(const CompactTrajectoryRecorder&) = delete;
+  CompactTrajectoryRecorder& operator=(const CompactTrajectoryRecorder&) = delete;
+
+  /** @brief Write full chunks to the file at \e path, instead of keeping them in memory. The file is replaced.
+   *  @return false if the file cannot be opened */
+  bool streamToFile(const std::string& path);
+
+  /** @brief Record the (finite) positions of all variables at \e time */
+  void addSample(double time, const double* positions);
+
+  /** @brief Record the variable positions of \e state, which must use the robot model of the recorder */
+  void addState(const moveit::core::RobotState& state, double time);
+
+  /** @brief Finish the unfinished chunk, writing it to the file if streaming */
+  void flush();
+
+  /** @brief Write the file header and the chunks kept in memory to \e out, including the unfinished chunk */
+  void write(std::ostream& out) const;
+
+  /** @brief Drop all recorded samples that are kept in memory, and restart the sample count */
+  void clear();
+
+  /** @brief Get the number of samples recorded so far, including the ones dropped or written to a file */
+  std::size_t getSampleCount() const;
+
+  const std::vector<std::string>& getVariableNames() const
+  {
+    return variable_names_;
+  }
+
+  /** @brief Read a recording written by write() or streamToFile() into \e samples.
+   *  @return false if the data is not a valid recording */
+  static bool read(std::istream& in, CompactTrajectorySamples& samples);
+
+private:
+  std::string encodeHeader() const;
+  std::string encodeChunk() const;
+  void finishChunk();  // requires mutex_ to be locked
+
+  /* Changes of a variable in the unfinished chunk */
+  struct Column
+  {
+    std::vector<std::uint32_t> samples;
+    std::vector<double> values;
+    std::vector<float> differences;
+  };
+
+  std::vector<std::string> variable_names_;
+  Options options_;
+
+  mutable std::mutex mutex_;
+  std::ofstream file_;
+  std::deque<std::string> chunks_;
+  std::size_t sample_count_ = 0;
+
+  std::vector<double> times_;
+  std::vector<double> first_positions_;
+  std::vector<double> last_positions_;  // as they are decoded
+  std::vector<Column> columns_;
+};
+}  // namespace planning_scene_monitor
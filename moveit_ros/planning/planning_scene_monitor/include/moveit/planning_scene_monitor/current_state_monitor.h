@@ -51,6 +51,7 @@
 #include <tf2_ros/buffer.h>
 
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/planning_scene_monitor/shared_state_channel.h>
 
 namespace planning_scene_monitor
 {
@@ -267,6 +268,11 @@ public:
    *  @return Returns the map from joint names to joint state values*/
   std::map<std::string, double> getCurrentStateValues() const;
 
+  /** @brief Get the current positions of a subset of the robot state variables, without copying the whole state
+   *  @param variable_indices The indices of the variables in the robot state
+   *  @param positions Filled with the positions of the variables, in the order of \e variable_indices */
+  void getCurrentVariablePositions(const std::vector<int>& variable_indices, std::vector<double>& positions) const;
+
   /** @brief Wait for at most \e wait_time_s seconds (default 1s) for a robot state more recent than t
    *  @return true on success, false if up-to-date robot state wasn't received within \e wait_time_s
    */
@@ -318,6 +324,13 @@ public:
     copy_dynamics_ = enabled;
   }
 
+  /** @brief Publish every update of the current state on the shared memory segment \e channel.
+   *
+   *  Other processes on the same host can read the state with a SharedStateReader, without subscribing to the joint
+   *  states themselves. Pass an empty string to stop publishing.
+   *  @return false if the shared memory segment cannot be created */
+  bool setSharedStateChannel(const std::string& channel);
+
 private:
   bool haveCompleteStateHelper(const rclcpp::Time& oldest_allowed_update_time,
                                std::vector<std::string>* missing_joints) const;
@@ -331,6 +344,8 @@ private:
   moveit::core::RobotModelConstPtr robot_model_;
   moveit::core::RobotState robot_state_;
   std::map<const moveit::core::JointModel*, rclcpp::Time> joint_time_;
+  // joint models of the names in the joint state messages received so far (nullptr for ignored joints)
+  std::map<std::vector<std::string>, std::vector<const moveit::core::JointModel*>> joint_state_layouts_;
   bool state_monitor_started_;
   bool copy_dynamics_;  // Copy velocity and effort from joint_state
   rclcpp::Time monitor_start_time_ = rclcpp::Time(0, 0, RCL_ROS_TIME);
@@ -340,6 +355,7 @@ private:
   mutable std::mutex state_update_lock_;
   mutable std::condition_variable state_update_condition_;
   std::vector<JointStateUpdateCallback> update_callbacks_;
+  SharedStateWriterPtr shared_state_writer_;
 
   bool use_sim_time_;
 };
@@ -46,6 +46,10 @@
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <moveit/collision_plugin_loader/collision_plugin_loader.h>
 #include <moveit_msgs/srv/get_planning_scene.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <thread>
 #include <shared_mutex>
@@ -116,6 +120,9 @@ public:
   /// name, so the topic is prefixed by the node name)
   static const std::string MONITORED_PLANNING_SCENE_TOPIC;  // "monitored_planning_scene"
 
+  /// The name of the topic the memory usage of the planning scene is published on
+  static const std::string MEMORY_DIAGNOSTICS_TOPIC;  // "/diagnostics"
+
   /** @brief Constructor
    *  @param robot_description The name of the ROS parameter that contains the URDF (in string format)
    *  @param tf_buffer A pointer to a tf2_ros::Buffer
@@ -222,6 +229,26 @@ public:
     return scene_const_;
   }
 
+  /** @brief Enable or disable publishing immutable snapshots of the monitored scene.
+   *
+   * When enabled, each scene update (robot state, transforms, geometry,
+   * octomap and planning scene messages) publishes a new copy of the
+   * monitored scene that is never modified afterwards. Readers obtain the
+   * latest copy with getPlanningSceneSnapshot() without taking any lock,
+   * so they never wait for updates in progress. Changes made through a
+   * LockedPlanningSceneRW are published with the next update or call to
+   * triggerSceneUpdateEvent(). */
+  void publishSceneSnapshots(bool flag);
+
+  /** @brief Get the most recently published immutable snapshot of the monitored scene.
+   *
+   * This neither locks nor blocks. The returned scene stays valid and
+   * unchanged for as long as the pointer is held, even while the monitor
+   * keeps updating; use diff() on it to make local modifications.
+   * @see publishSceneSnapshots()
+   * @return The latest snapshot, or nullptr if snapshots are not published. */
+  planning_scene::PlanningSceneConstPtr getPlanningSceneSnapshot() const;
+
   /** @brief Return true if the scene \e scene can be updated directly
       or indirectly by this monitor. This function will return true if
       the pointer of the scene is the same as the one maintained,
@@ -349,6 +376,32 @@ public:
     }
   }
 
+  /** @brief Collect the collision object updates received within a time window and apply them together, under a
+      single lock of the scene and with a single update event. Pending updates that are superseded by a later update
+      of the same object are dropped. Other updates of the scene apply the pending collision object updates first.
+      @param seconds the length of the window. By default this is 0, which applies every update when it is received. */
+  void setCollisionObjectCoalescingWindow(double seconds);
+
+  /** @brief Periodically publish the estimated memory usage of the planning scene on MEMORY_DIAGNOSTICS_TOPIC, with
+      one diagnostic status per diff layer and one value per world object, octree and collision geometry, see
+      planning_scene::PlanningScene::getMemoryUsage().
+      @param seconds the publishing period. By default this is 0, which does not publish. */
+  void setMemoryDiagnosticsPeriod(double seconds);
+
+  /** @brief Get the time window (seconds) within which collision object updates are applied together */
+  double getCollisionObjectCoalescingWindow() const
+  {
+    return dt_collision_object_coalescing_.count();
+  }
+
+  /** @brief Append a collision object update to a queue of pending updates, dropping the pending updates it
+      supersedes: all updates of the object before an ADD or REMOVE, all updates before a REMOVE of every object
+      and the previous MOVE of the object if only a MOVE follows it.
+      @param pending the queue of pending updates, in the order in which they are to be applied
+      @param update the update received last */
+  static void coalesceCollisionObjectUpdate(std::vector<moveit_msgs::msg::CollisionObject>& pending,
+                                            const moveit_msgs::msg::CollisionObject& update);
+
   /** @brief Start the scene monitor (ROS topic-based)
    *  @param scene_topic The name of the planning scene topic
    */
@@ -451,6 +504,17 @@ protected:
   /** @brief Callback for a new collision object msg*/
   void collisionObjectCallback(const moveit_msgs::msg::CollisionObject::ConstSharedPtr& obj);
 
+  /** @brief Apply the collision object updates collected within the coalescing window */
+  void applyPendingCollisionObjects();
+
+  /** @brief Take the collision object updates collected within the coalescing window and apply them to the scene.
+   *  scene_update_mutex_ must be held exclusively.
+   *  @return true if any of the updates changed the scene */
+  bool processPendingCollisionObjects();
+
+  /** @brief Publish the memory usage of the planning scene */
+  void publishMemoryDiagnostics();
+
   /** @brief Callback for a new planning scene world*/
   void newPlanningSceneWorldCallback(const moveit_msgs::msg::PlanningSceneWorld::ConstSharedPtr& world);
 
@@ -569,6 +633,9 @@ private:
   // publish planning scene update diffs (runs in its own thread)
   void scenePublishingThread();
 
+  // publish a new immutable snapshot of the scene after an update of the given type
+  void updateSceneSnapshot(SceneUpdateType update_type);
+
   // called by current_state_monitor_ when robot state (as monitored on joint state topic) changes
   void onStateUpdate(const sensor_msgs::msg::JointState::ConstSharedPtr& joint_state);
 
@@ -585,6 +652,10 @@ private:
   void updatePublishSettings(bool publish_geom_updates, bool publish_state_updates, bool publish_transform_updates,
                              bool publish_planning_scene, double publish_planning_scene_hz);
 
+  // replace the full octomap of a published scene diff by the cells changed since the last published octomap,
+  // unless a full octomap is due. Called with scene_update_mutex_ and the monitored octree locked.
+  void encodeOctomapUpdate(octomap_msgs::msg::OctomapWithPose& octomap);
+
   // Lock for state_update_pending_ and dt_state_update_
   std::mutex state_pending_mutex_;
 
@@ -607,6 +678,23 @@ private:
 
   rclcpp::TimerBase::SharedPtr state_update_timer_;
 
+  /// Lock for pending_collision_objects_, taken after scene_update_mutex_ when both are needed
+  std::mutex collision_object_queue_mutex_;
+
+  /// Collision object updates received within the current coalescing window
+  // This field is protected by collision_object_queue_mutex_
+  std::vector<moveit_msgs::msg::CollisionObject> pending_collision_objects_;
+
+  /// the time window within which collision object updates are applied together, 0 if they are applied immediately
+  std::chrono::duration<double> dt_collision_object_coalescing_;
+
+  /// timer applying the pending collision object updates at the end of each coalescing window
+  rclcpp::TimerBase::SharedPtr collision_object_coalescing_timer_;
+
+  /// timer publishing the memory usage of the planning scene
+  rclcpp::TimerBase::SharedPtr memory_diagnostics_timer_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr memory_diagnostics_publisher_;
+
   /// Last time the state was updated from current_state_monitor_
   // Only access this from callback functions (and constructor)
   std::chrono::system_clock::time_point last_robot_state_update_wall_time_;
@@ -620,6 +708,60 @@ private:
 
   bool use_sim_time_;
 
+  /// True if every scene update publishes a new scene_snapshot_
+  std::atomic<bool> publish_scene_snapshots_;
+
+  /// Serializes updates of the snapshot members below
+  std::mutex scene_snapshot_mutex_;
+
+  /// Latest immutable copy of the scene, only accessed through std::atomic_load() and std::atomic_store()
+  planning_scene::PlanningSceneConstPtr scene_snapshot_;
+
+  /// Latest full copy of the scene, the parent of snapshots that only differ in the robot state
+  planning_scene::PlanningSceneConstPtr scene_snapshot_base_;
+
+  /// Copy of the monitored octree used by the snapshots, since the monitored one is modified in place
+  std::shared_ptr<const octomap::OcTree> scene_snapshot_octree_;
+
+  /// number of incremental octomap updates published between full octomaps, 0 to always publish the full octomap
+  // This field is protected by scene_update_mutex_
+  unsigned int octomap_keyframe_interval_;
+
+  /// cells of the monitored octree changed since the octomap was last published
+  // This field is protected by scene_update_mutex_
+  octomap::KeySet octomap_changed_keys_;
+
+  /// True if the scene holds snapshots of the monitored octree instead of the octree itself
+  bool use_octomap_snapshots_ = false;
+
+  /// shared memory segment the current state monitor publishes the robot state on, empty for none
+  std::string shared_state_channel_;
+
+  /// snapshots of the monitored octree, updated in octomapUpdateCallback()
+  // This field is protected by octomap_snapshot_mutex_
+  collision_detection::OccMapTreeSnapshots octomap_snapshots_;
+  std::mutex octomap_snapshot_mutex_;
+
+  /// number of the last published octomap update since the last full octomap
+  // This field is protected by scene_update_mutex_
+  std::uint32_t octomap_update_index_;
+
+  /// True if the next published octomap must be a full one, e.g. because the octree was cleared
+  // This field is protected by scene_update_mutex_
+  bool octomap_keyframe_required_;
+
+  /// Incremented on every scene update event and every release of the scene write lock
+  std::atomic<std::uint64_t> scene_version_;
+
+  /// Serializes access to the response cache of the get planning scene service
+  std::mutex scene_msg_cache_mutex_;
+
+  /// Scene version the cached responses were computed for
+  std::uint64_t scene_msg_cache_version_;
+
+  /// Cached responses of the get planning scene service, by requested components
+  std::map<std::uint32_t, moveit_msgs::msg::PlanningScene> scene_msg_cache_;
+
   friend class LockedPlanningSceneRO;
   friend class LockedPlanningSceneRW;
 };
@@ -0,0 +1,122 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_state/robot_state.h>
+#include <rclcpp/time.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace planning_scene_monitor
+{
+namespace shared_state
+{
+struct Header;
+}
+
+MOVEIT_CLASS_FORWARD(SharedStateWriter);  // Defines SharedStateWriterPtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(SharedStateReader);  // Defines SharedStateReaderPtr, ConstPtr, WeakPtr... etc
+
+/** @brief Publishes the variables of a robot state in a POSIX shared memory segment.
+ *
+ *  The positions, velocities and efforts are stored in the variable order of the RobotModel, next to the time stamp
+ *  of the state. A sequence lock guards the segment, so readers never block the writer and always get a consistent
+ *  state. There must be only one writer per channel. The segment is removed when the writer is destroyed. */
+class SharedStateWriter
+{
+public:
+  /** @brief Create the shared memory segment \e channel for states of \e robot_model.
+   *  @return nullptr if the segment cannot be created */
+  static SharedStateWriterPtr create(const std::string& channel, const moveit::core::RobotModelConstPtr& robot_model);
+
+  ~SharedStateWriter();
+
+  SharedStateWriter(const SharedStateWriter&) = delete;
+  SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+
+  /** @brief Publish the variables of \e state, which must use the robot model of the channel */
+  void write(const moveit::core::RobotState& state, const rclcpp::Time& stamp);
+
+  const std::string& getChannel() const
+  {
+    return channel_;
+  }
+
+private:
+  SharedStateWriter(std::string channel, int fd, void* memory, std::size_t size);
+
+  std::string channel_;
+  int fd_;
+  shared_state::Header* header_;
+  std::size_t size_;
+};
+
+/** @brief Reads the robot states published by a SharedStateWriter in the same host. */
+class SharedStateReader
+{
+public:
+  /** @brief Attach to the shared memory segment \e channel.
+   *  @return nullptr if the segment does not exist or was created for a different robot model */
+  static SharedStateReaderPtr open(const std::string& channel, const moveit::core::RobotModelConstPtr& robot_model);
+
+  ~SharedStateReader();
+
+  SharedStateReader(const SharedStateReader&) = delete;
+  SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+  /** @brief Copy the latest published state into \e state. Velocities and efforts are copied if they were published.
+   *  @param stamp If not nullptr, set to the time stamp of the state
+   *  @return false if nothing was published yet */
+  bool read(moveit::core::RobotState& state, rclcpp::Time* stamp = nullptr) const;
+
+  /** @brief Get the sequence number of the latest published state. It changes with every write. */
+  std::uint64_t getSequence() const;
+
+  const std::string& getChannel() const
+  {
+    return channel_;
+  }
+
+private:
+  SharedStateReader(std::string channel, int fd, const void* memory, std::size_t size);
+
+  std::string channel_;
+  int fd_;
+  const shared_state::Header* header_;
+  std::size_t size_;
+};
+}  // namespace planning_scene_monitor
@@ -39,6 +39,7 @@
 #include <moveit/macros/class_forward.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
+#include <moveit/planning_scene_monitor/compact_trajectory_recorder.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <rclcpp/time.hpp>
 #include <memory>
@@ -125,6 +126,13 @@ public:
     state_add_callback_ = callback;
   }
 
+  /// Record the sampled states into \e recorder instead of the trajectory returned by getTrajectory(), which keeps
+  /// long recordings small. Pass nullptr to record into the trajectory again. Do not call this while active.
+  void setCompactRecorder(const CompactTrajectoryRecorderPtr& recorder)
+  {
+    compact_recorder_ = recorder;
+  }
+
 private:
   void recordStates();
 
@@ -140,5 +148,6 @@ private:
 
   std::unique_ptr<std::thread> record_states_thread_;
   TrajectoryStateAddedCallback state_add_callback_;
+  CompactTrajectoryRecorderPtr compact_recorder_;
 };
 }  // namespace planning_scene_monitor
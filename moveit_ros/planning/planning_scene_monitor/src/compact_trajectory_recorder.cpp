@@ -0,0 +1,381 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_scene_monitor/compact_trajectory_recorder.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <utility>
+
+namespace planning_scene_monitor
+{
+static const rclcpp::Logger LOGGER =
+    rclcpp::get_logger("moveit_ros.planning_scene_monitor.compact_trajectory_recorder");
+
+namespace
+{
+constexpr char MAGIC[8] = { 'M', 'V', 'T', 'R', 'A', 'J', '0', '1' };
+constexpr std::uint64_t DELTA_ENCODING = 1;
+
+template <typename T>
+void append(std::string& buffer, const T* data, std::size_t count)
+{
+  buffer.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+  buffer.resize((buffer.size() + 7) & ~std::size_t(7), '\0');
+}
+
+void appendValue(std::string& buffer, std::uint64_t value)
+{
+  append(buffer, &value, 1);
+}
+
+// Reads the padded fields of a recording, failing once the data is exhausted
+class Cursor
+{
+public:
+  Cursor(const std::string& data, std::size_t begin, std::size_t end) : data_(data), pos_(begin), end_(end)
+  {
+  }
+
+  template <typename T>
+  bool read(T* out, std::size_t count)
+  {
+    if (pos_ > end_ || count > (end_ - pos_) / sizeof(T))
+      return false;
+    const std::size_t bytes = count * sizeof(T);
+    const std::size_t padded = (bytes + 7) & ~std::size_t(7);
+    if (padded > end_ - pos_)
+      return false;
+    if (bytes > 0)
+      std::memcpy(out, data_.data() + pos_, bytes);
+    pos_ += padded;
+    return true;
+  }
+
+  bool readValue(std::uint64_t& value)
+  {
+    return read(&value, 1);
+  }
+
+  std::size_t position() const
+  {
+    return pos_;
+  }
+
+private:
+  const std::string& data_;
+  std::size_t pos_;
+  std::size_t end_;
+};
+
+bool readChunk(Cursor& cursor, std::size_t variable_count, CompactTrajectorySamples& samples)
+{
+  std::uint64_t count, flags;
+  if (!cursor.readValue(count) || !cursor.readValue(flags))
+    return false;
+
+  const std::size_t first_sample = samples.times.size();
+  samples.times.resize(first_sample + count);
+  std::vector<double> positions(variable_count);
+  std::vector<std::uint64_t> change_counts(variable_count);
+  if (!cursor.read(samples.times.data() + first_sample, count) || !cursor.read(positions.data(), variable_count) ||
+      !cursor.read(change_counts.data(), variable_count))
+    return false;
+
+  samples.positions.resize(samples.times.size() * variable_count);
+  for (std::size_t v = 0; v < variable_count; ++v)
+  {
+    const std::size_t changes = change_counts[v];
+    std::vector<std::uint32_t> indices(changes);
+    std::vector<double> values(changes);
+    if (!cursor.read(indices.data(), changes))
+      return false;
+    if (flags & DELTA_ENCODING)
+    {
+      std::vector<float> differences(changes);
+      if (!cursor.read(differences.data(), changes))
+        return false;
+      double value = positions[v];
+      for (std::size_t c = 0; c < changes; ++c)
+        values[c] = value += differences[c];
+    }
+    else if (!cursor.read(values.data(), changes))
+    {
+      return false;
+    }
+
+    // fill the column, holding each value until the next change
+    double value = positions[v];
+    std::size_t c = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      while (c < changes && indices[c] <= i)
+        value = values[c++];
+      samples.positions[(first_sample + i) * variable_count + v] = value;
+    }
+    if (c != changes)
+      return false;
+  }
+  return true;
+}
+}  // namespace
+
+CompactTrajectoryRecorder::CompactTrajectoryRecorder(std::vector<std::string> variable_names, const Options& options)
+  : variable_names_(std::move(variable_names))
+  , options_(options)
+  , last_positions_(variable_names_.size())
+  , columns_(variable_names_.size())
+{
+  if (options_.chunk_size == 0)
+    options_.chunk_size = 1;
+}
+
+CompactTrajectoryRecorder::CompactTrajectoryRecorder(const moveit::core::RobotModelConstPtr& robot_model,
+                                                     const Options& options)
+  : CompactTrajectoryRecorder(robot_model->getVariableNames(), options)
+{
+}
+
+CompactTrajectoryRecorder::~CompactTrajectoryRecorder()
+{
+  if (file_.is_open())
+    flush();
+}
+
+bool CompactTrajectoryRecorder::streamToFile(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.close();
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open '%s' for recording the trajectory", path.c_str());
+    return false;
+  }
+  const std::string header = encodeHeader();
+  file_.write(header.data(), header.size());
+  for (const std::string& chunk : chunks_)
+    file_.write(chunk.data(), chunk.size());
+  chunks_.clear();
+  return static_cast<bool>(file_);
+}
+
+void CompactTrajectoryRecorder::addSample(double time, const double* positions)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto index = static_cast<std::uint32_t>(times_.size());
+  times_.push_back(time);
+  ++sample_count_;
+
+  if (index == 0)
+  {
+    first_positions_.assign(positions, positions + variable_names_.size());
+    last_positions_ = first_positions_;
+  }
+  else
+  {
+    for (std::size_t v = 0; v < variable_names_.size(); ++v)
+    {
+      const double change = positions[v] - last_positions_[v];
+      if (std::fabs(change) <= options_.tolerance)
+        continue;
+
+      Column& column = columns_[v];
+      column.samples.push_back(index);
+      if (options_.delta_encoding)
+      {
+        // continue from the decoded value, so the rounding errors of the differences do not add up
+        const auto difference = static_cast<float>(change);
+        column.differences.push_back(difference);
+        last_positions_[v] += difference;
+      }
+      else
+      {
+        column.values.push_back(positions[v]);
+        last_positions_[v] = positions[v];
+      }
+    }
+  }
+
+  if (times_.size() >= options_.chunk_size)
+    finishChunk();
+}
+
+void CompactTrajectoryRecorder::addState(const moveit::core::RobotState& state, double time)
+{
+  assert(state.getVariableCount() == variable_names_.size());
+  addSample(time, state.getVariablePositions());
+}
+
+void CompactTrajectoryRecorder::flush()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  finishChunk();
+  if (file_.is_open())
+    file_.flush();
+}
+
+void CompactTrajectoryRecorder::write(std::ostream& out) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string header = encodeHeader();
+  out.write(header.data(), header.size());
+  for (const std::string& chunk : chunks_)
+    out.write(chunk.data(), chunk.size());
+  if (!times_.empty())
+  {
+    const std::string chunk = encodeChunk();
+    out.write(chunk.data(), chunk.size());
+  }
+}
+
+void CompactTrajectoryRecorder::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  chunks_.clear();
+  times_.clear();
+  for (Column& column : columns_)
+    column = Column();
+  sample_count_ = 0;
+}
+
+std::size_t CompactTrajectoryRecorder::getSampleCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sample_count_;
+}
+
+std::string CompactTrajectoryRecorder::encodeHeader() const
+{
+  std::string header(MAGIC, sizeof(MAGIC));
+  appendValue(header, variable_names_.size());
+  for (const std::string& name : variable_names_)
+  {
+    appendValue(header, name.size());
+    append(header, name.data(), name.size());
+  }
+  return header;
+}
+
+std::string CompactTrajectoryRecorder::encodeChunk() const
+{
+  std::string chunk;
+  appendValue(chunk, 0);  // filled in below
+  appendValue(chunk, times_.size());
+  appendValue(chunk, options_.delta_encoding ? DELTA_ENCODING : 0);
+  append(chunk, times_.data(), times_.size());
+  append(chunk, first_positions_.data(), first_positions_.size());
+  for (const Column& column : columns_)
+    appendValue(chunk, column.samples.size());
+  for (const Column& column : columns_)
+  {
+    append(chunk, column.samples.data(), column.samples.size());
+    if (options_.delta_encoding)
+      append(chunk, column.differences.data(), column.differences.size());
+    else
+      append(chunk, column.values.data(), column.values.size());
+  }
+  const std::uint64_t size = chunk.size();
+  std::memcpy(&chunk[0], &size, sizeof(size));
+  return chunk;
+}
+
+void CompactTrajectoryRecorder::finishChunk()
+{
+  if (times_.empty())
+    return;
+
+  std::string chunk = encodeChunk();
+  if (file_.is_open())
+  {
+    file_.write(chunk.data(), chunk.size());
+  }
+  else
+  {
+    chunks_.push_back(std::move(chunk));
+    while (chunks_.size() > options_.max_chunks)
+      chunks_.pop_front();
+  }
+
+  times_.clear();
+  for (Column& column : columns_)
+  {
+    column.samples.clear();
+    column.values.clear();
+    column.differences.clear();
+  }
+}
+
+bool CompactTrajectoryRecorder::read(std::istream& in, CompactTrajectorySamples& samples)
+{
+  const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  samples = CompactTrajectorySamples();
+  if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+    return false;
+
+  Cursor header(data, sizeof(MAGIC), data.size());
+  std::uint64_t variable_count;
+  if (!header.readValue(variable_count) || variable_count > data.size())
+    return false;
+  samples.variable_names.resize(variable_count);
+  for (std::string& name : samples.variable_names)
+  {
+    std::uint64_t length;
+    if (!header.readValue(length) || length > data.size())
+      return false;
+    name.resize(length);
+    if (!header.read(&name[0], length))
+      return false;
+  }
+
+  std::size_t pos = header.position();
+  while (pos < data.size())
+  {
+    std::uint64_t size;
+    Cursor chunk_size(data, pos, data.size());
+    if (!chunk_size.readValue(size) || size < sizeof(size) || size > data.size() - pos)
+      return false;
+    Cursor chunk(data, chunk_size.position(), pos + size);
+    if (!readChunk(chunk, variable_count, samples))
+      return false;
+    pos += size;
+  }
+  return true;
+}
+}  // namespace planning_scene_monitor
@@ -51,6 +51,8 @@ using namespace std::chrono_literals;
 namespace
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.current_state_monitor");
+// Maximum number of joint name orderings of joint state messages whose joint models are cached
+constexpr std::size_t MAX_JOINT_STATE_LAYOUTS = 16;
 }
 
 CurrentStateMonitor::CurrentStateMonitor(std::unique_ptr<CurrentStateMonitor::MiddlewareHandle> middleware_handle,
@@ -88,6 +90,19 @@ moveit::core::RobotStatePtr CurrentStateMonitor::getCurrentState() const
   return moveit::core::RobotStatePtr(result);
 }
 
+bool CurrentStateMonitor::setSharedStateChannel(const std::string& channel)
+{
+  std::unique_lock<std::mutex> slock(state_update_lock_);
+  shared_state_writer_.reset();
+  if (channel.empty())
+    return true;
+  shared_state_writer_ = SharedStateWriter::create(channel, robot_model_);
+  if (!shared_state_writer_)
+    return false;
+  shared_state_writer_->write(robot_state_, current_state_time_);
+  return true;
+}
+
 rclcpp::Time CurrentStateMonitor::getCurrentStateTime() const
 {
   std::unique_lock<std::mutex> slock(state_update_lock_);
@@ -112,6 +127,16 @@ std::map<std::string, double> CurrentStateMonitor::getCurrentStateValues() const
   return m;
 }
 
+void CurrentStateMonitor::getCurrentVariablePositions(const std::vector<int>& variable_indices,
+                                                      std::vector<double>& positions) const
+{
+  positions.resize(variable_indices.size());
+  std::unique_lock<std::mutex> slock(state_update_lock_);
+  const double* pos = robot_state_.getVariablePositions();
+  for (std::size_t i = 0; i < variable_indices.size(); ++i)
+    positions[i] = pos[variable_indices[i]];
+}
+
 void CurrentStateMonitor::setToCurrentState(moveit::core::RobotState& upd) const
 {
   std::unique_lock<std::mutex> slock(state_update_lock_);
@@ -339,17 +364,33 @@ void CurrentStateMonitor::jointStateCallback(const sensor_msgs::msg::JointState:
 
   {
     std::unique_lock<std::mutex> _(state_update_lock_);
+    // each publisher sends the same joint names in the same order, so the joint models are looked up once per layout
+    auto layout = joint_state_layouts_.find(joint_state->name);
+    if (layout == joint_state_layouts_.end())
+    {
+      // bound the cache in case the joint names keep changing
+      if (joint_state_layouts_.size() >= MAX_JOINT_STATE_LAYOUTS)
+        joint_state_layouts_.clear();
+      std::vector<const moveit::core::JointModel*> joint_models;
+      joint_models.reserve(joint_state->name.size());
+      for (const std::string& name : joint_state->name)
+      {
+        const moveit::core::JointModel* jm = robot_model_->getJointModel(name);
+        // ignore fixed joints, multi-dof joints (they should not even be in the message)
+        joint_models.push_back(jm && jm->getVariableCount() == 1 ? jm : nullptr);
+      }
+      layout = joint_state_layouts_.emplace(joint_state->name, std::move(joint_models)).first;
+    }
+    const std::vector<const moveit::core::JointModel*>& joint_models = layout->second;
+
     // read the received values, and update their time stamps
     std::size_t n = joint_state->name.size();
     current_state_time_ = joint_state->header.stamp;
     for (std::size_t i = 0; i < n; ++i)
     {
-      const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_state->name[i]);
+      const moveit::core::JointModel* jm = joint_models[i];
       if (!jm)
         continue;
-      // ignore fixed joints, multi-dof joints (they should not even be in the message)
-      if (jm->getVariableCount() != 1)
-        continue;
 
       joint_time_.insert_or_assign(jm, joint_state->header.stamp);
 
@@ -400,6 +441,8 @@ void CurrentStateMonitor::jointStateCallback(const sensor_msgs::msg::JointState:
         }
       }
     }
+    if (shared_state_writer_)
+      shared_state_writer_->write(robot_state_, current_state_time_);
   }
 
   // callbacks, if needed
@@ -473,6 +516,8 @@ void CurrentStateMonitor::updateMultiDofJoints()
       robot_state_.setJointPositions(joint, new_values.data());
       update = true;
     }
+    if (changes && shared_state_writer_)
+      shared_state_writer_->write(robot_state_, current_state_time_);
   }
 
   // callbacks, if needed
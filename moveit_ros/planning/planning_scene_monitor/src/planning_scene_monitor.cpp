@@ -46,6 +46,7 @@
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 
 #include <boost/algorithm/string/join.hpp>
+#include <algorithm>
 #include <memory>
 
 #include <std_msgs/msg/string.hpp>
@@ -64,6 +65,7 @@ const std::string PlanningSceneMonitor::DEFAULT_PLANNING_SCENE_WORLD_TOPIC = "pl
 const std::string PlanningSceneMonitor::DEFAULT_PLANNING_SCENE_TOPIC = "planning_scene";
 const std::string PlanningSceneMonitor::DEFAULT_PLANNING_SCENE_SERVICE = "get_planning_scene";
 const std::string PlanningSceneMonitor::MONITORED_PLANNING_SCENE_TOPIC = "monitored_planning_scene";
+const std::string PlanningSceneMonitor::MEMORY_DIAGNOSTICS_TOPIC = "/diagnostics";
 
 PlanningSceneMonitor::PlanningSceneMonitor(const rclcpp::Node::SharedPtr& node, const std::string& robot_description,
                                            const std::string& name)
@@ -96,7 +98,14 @@ PlanningSceneMonitor::PlanningSceneMonitor(const rclcpp::Node::SharedPtr& node,
   , tf_buffer_(std::make_shared<tf2_ros::Buffer>(node->get_clock()))
   , dt_state_update_(0.0)
   , shape_transform_cache_lookup_wait_time_(0, 0)
+  , dt_collision_object_coalescing_(0.0)
+  , octomap_keyframe_interval_(0)
+  , octomap_update_index_(0)
+  , octomap_keyframe_required_(true)
+  , scene_version_(0)
+  , scene_msg_cache_version_(0)
   , rm_loader_(rm_loader)
+  , publish_scene_snapshots_(false)
 {
   std::vector<std::string> new_args = rclcpp::NodeOptions().arguments();
   new_args.push_back("--ros-args");
@@ -127,6 +136,10 @@ PlanningSceneMonitor::~PlanningSceneMonitor()
   }
   stopPublishingPlanningScene();
   stopStateMonitor();
+  if (collision_object_coalescing_timer_)
+    collision_object_coalescing_timer_->cancel();
+  if (memory_diagnostics_timer_)
+    memory_diagnostics_timer_->cancel();
   stopWorldGeometryMonitor();
   stopSceneMonitor();
 
@@ -244,8 +257,34 @@ void PlanningSceneMonitor::initialize(const planning_scene::PlanningScenePtr& sc
         "publish_transforms_updates", false, "Set to True to publish transform updates of the planning scene");
     double publish_planning_scene_hz = declare_parameter(
         "publish_planning_scene_hz", 4.0, "Set the maximum frequency at which planning scene updates are published");
+    int octomap_keyframe_interval =
+        declare_parameter("octomap_keyframe_interval", 0,
+                          "Number of published scene diffs that only carry the changed octomap cells between diffs "
+                          "with the full octomap, 0 to always publish the full octomap");
+    octomap_keyframe_interval_ = static_cast<unsigned int>(std::max(octomap_keyframe_interval, 0));
+    use_octomap_snapshots_ =
+        declare_parameter("octomap_snapshots", false,
+                          "Set to True to check collisions against copies of the octomap, so that collision checks "
+                          "do not wait for sensor updates. Not supported by distance field collision checking");
+    shared_state_channel_ =
+        declare_parameter("shared_state_channel", std::string(),
+                          "Name of a POSIX shared memory segment, e.g. /moveit_current_state, on which the monitored "
+                          "robot state is published for other processes on the same host. Empty to not publish it");
     updatePublishSettings(publish_geometry_updates, publish_state_updates, publish_transform_updates,
                           publish_planning_scene, publish_planning_scene_hz);
+
+    double collision_object_coalescing_window =
+        declare_parameter("collision_object_coalescing_window", 0.0,
+                          "Time window in seconds within which collision object updates are applied together");
+    if (collision_object_coalescing_window > 0.0)
+      setCollisionObjectCoalescingWindow(collision_object_coalescing_window);
+
+    double memory_diagnostics_period =
+        declare_parameter("memory_diagnostics_period", 0.0,
+                          "Period in seconds at which the memory usage of the planning scene is published as "
+                          "diagnostics, 0 to not publish it");
+    if (memory_diagnostics_period > 0.0)
+      setMemoryDiagnosticsPeriod(memory_diagnostics_period);
   }
   catch (const rclcpp::exceptions::InvalidParameterTypeException& e)
   {
@@ -309,6 +348,16 @@ void PlanningSceneMonitor::initialize(const planning_scene::PlanningScenePtr& sc
       {
         publish_planning_scene_hz = parameter.as_double();
       }
+      else if (name == "planning_scene_monitor.collision_object_coalescing_window")
+      {
+        setCollisionObjectCoalescingWindow(parameter.as_double());
+      }
+      else if (name == "planning_scene_monitor.octomap_keyframe_interval")
+      {
+        std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
+        octomap_keyframe_interval_ = static_cast<unsigned int>(std::max<int64_t>(parameter.as_int(), 0));
+        octomap_keyframe_required_ = true;
+      }
     }
 
     if (result.successful)
@@ -368,6 +417,8 @@ void PlanningSceneMonitor::monitorDiffs(bool flag)
         }
       }
     }
+    // the scene may have been renamed or replaced
+    ++scene_version_;
   }
 }
 
@@ -391,7 +442,11 @@ void PlanningSceneMonitor::startPublishingPlanningScene(SceneUpdateType update_t
   publish_update_types_ = update_type;
   if (!publish_planning_scene_ && scene_)
   {
-    planning_scene_publisher_ = pnode_->create_publisher<moveit_msgs::msg::PlanningScene>(planning_scene_topic, 100);
+    // hand scene updates to subscribers in the same process without copying or serializing them
+    rclcpp::PublisherOptions options;
+    options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+    planning_scene_publisher_ =
+        pnode_->create_publisher<moveit_msgs::msg::PlanningScene>(planning_scene_topic, 100, options);
     RCLCPP_INFO(LOGGER, "Publishing maintained planning scene on '%s'", planning_scene_topic.c_str());
     monitorDiffs(true);
     publish_planning_scene_ = std::make_unique<std::thread>([this] { scenePublishingThread(); });
@@ -404,15 +459,21 @@ void PlanningSceneMonitor::scenePublishingThread()
 
   // publish the full planning scene once
   {
-    moveit_msgs::msg::PlanningScene msg;
+    auto msg = std::make_unique<moveit_msgs::msg::PlanningScene>();
     {
+      // receivers may have missed earlier octomap updates
+      {
+        std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
+        octomap_keyframe_required_ = true;
+      }
       collision_detection::OccMapTree::ReadLock lock;
-      if (octomap_monitor_)
+      if (octomap_monitor_ && !use_octomap_snapshots_)
         lock = octomap_monitor_->getOcTreePtr()->reading();
-      scene_->getPlanningSceneMsg(msg);
+      scene_->getPlanningSceneMsg(*msg);
     }
-    planning_scene_publisher_->publish(msg);
-    RCLCPP_DEBUG(LOGGER, "Published the full planning scene: '%s'", msg.name.c_str());
+    const std::string name = msg->name;
+    planning_scene_publisher_->publish(std::move(msg));
+    RCLCPP_DEBUG(LOGGER, "Published the full planning scene: '%s'", name.c_str());
   }
 
   do
@@ -436,9 +497,11 @@ void PlanningSceneMonitor::scenePublishingThread()
           else
           {
             collision_detection::OccMapTree::ReadLock lock;
-            if (octomap_monitor_)
+            if (octomap_monitor_ && !use_octomap_snapshots_)
               lock = octomap_monitor_->getOcTreePtr()->reading();
             scene_->getPlanningSceneDiffMsg(msg);
+            if (!msg.world.octomap.octomap.data.empty())
+              encodeOctomapUpdate(msg.world.octomap);
             if (new_scene_update_ == UPDATE_STATE)
             {
               msg.robot_state.attached_collision_objects.clear();
@@ -468,9 +531,12 @@ void PlanningSceneMonitor::scenePublishingThread()
           if (is_full)
           {
             collision_detection::OccMapTree::ReadLock lock;
-            if (octomap_monitor_)
+            if (octomap_monitor_ && !use_octomap_snapshots_)
               lock = octomap_monitor_->getOcTreePtr()->reading();
             scene_->getPlanningSceneMsg(msg);
+            octomap_update_index_ = 0;
+            octomap_keyframe_required_ = false;
+            octomap_changed_keys_.clear();
           }
           // also publish timestamp of this robot_state
           msg.robot_state.joint_state.header.stamp = last_robot_motion_time_;
@@ -481,9 +547,11 @@ void PlanningSceneMonitor::scenePublishingThread()
     }
     if (publish_msg)
     {
-      planning_scene_publisher_->publish(msg);
+      const std::string name = msg.name;
+      // moving the message lets intra-process subscribers take it over without a copy
+      planning_scene_publisher_->publish(std::make_unique<moveit_msgs::msg::PlanningScene>(std::move(msg)));
       if (is_full)
-        RCLCPP_DEBUG(LOGGER, "Published full planning scene: '%s'", msg.name.c_str());
+        RCLCPP_DEBUG(LOGGER, "Published full planning scene: '%s'", name.c_str());
       rate.sleep();
     }
   } while (publish_planning_scene_);
@@ -534,8 +602,75 @@ bool PlanningSceneMonitor::updatesScene(const planning_scene::PlanningSceneConst
   return sceneIsParentOf(scene_const_, scene.get());
 }
 
+void PlanningSceneMonitor::publishSceneSnapshots(bool flag)
+{
+  publish_scene_snapshots_ = flag;
+  if (flag)
+  {
+    updateSceneSnapshot(UPDATE_SCENE);
+  }
+  else
+  {
+    std::scoped_lock lock(scene_snapshot_mutex_);
+    std::atomic_store(&scene_snapshot_, planning_scene::PlanningSceneConstPtr());
+    scene_snapshot_base_.reset();
+    scene_snapshot_octree_.reset();
+  }
+}
+
+planning_scene::PlanningSceneConstPtr PlanningSceneMonitor::getPlanningSceneSnapshot() const
+{
+  return std::atomic_load(&scene_snapshot_);
+}
+
+void PlanningSceneMonitor::updateSceneSnapshot(SceneUpdateType update_type)
+{
+  std::scoped_lock snapshot_lock(scene_snapshot_mutex_);
+  if (!publish_scene_snapshots_ || !scene_)
+    return;
+
+  // writers only wait for each other here, readers of the snapshot never wait
+  std::shared_lock<std::shared_mutex> lock(scene_update_mutex_);
+  planning_scene::PlanningScenePtr snapshot;
+  if (update_type == UPDATE_STATE && scene_snapshot_base_)
+  {
+    // frequent joint state updates share everything else with the last full copy
+    snapshot = scene_snapshot_base_->diff();
+    snapshot->setName(scene_->getName());
+    snapshot->setCurrentState(scene_->getCurrentState());
+  }
+  else
+  {
+    snapshot = planning_scene::PlanningScene::clone(scene_);
+    if (octomap_monitor_)
+    {
+      const collision_detection::OccMapTreePtr& octree = octomap_monitor_->getOcTreePtr();
+      collision_detection::World::ObjectConstPtr map =
+          snapshot->getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+      if (map && map->shapes_.size() == 1 &&
+          static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree == octree)
+      {
+        if (!scene_snapshot_octree_ || (static_cast<int>(update_type) & static_cast<int>(UPDATE_GEOMETRY)))
+        {
+          octree->lockRead();
+          scene_snapshot_octree_ = std::make_shared<const octomap::OcTree>(*octree);
+          octree->unlockRead();
+        }
+        const Eigen::Isometry3d pose = map->global_shape_poses_[0];
+        map.reset();
+        snapshot->processOctomapPtr(scene_snapshot_octree_, pose);
+      }
+    }
+    scene_snapshot_base_ = snapshot;
+  }
+  std::atomic_store(&scene_snapshot_, planning_scene::PlanningSceneConstPtr(snapshot));
+}
+
 void PlanningSceneMonitor::triggerSceneUpdateEvent(SceneUpdateType update_type)
 {
+  ++scene_version_;
+  updateSceneSnapshot(update_type);
+
   // do not modify update functions while we are calling them
   std::scoped_lock lock(update_lock_);
 
@@ -607,11 +742,62 @@ void PlanningSceneMonitor::getPlanningSceneServiceCallback(
   if (req->components.components & moveit_msgs::msg::PlanningSceneComponents::TRANSFORMS)
     updateFrameTransforms();
 
-  moveit_msgs::msg::PlanningSceneComponents all_components;
-  all_components.components = UINT_MAX;  // Return all scene components if nothing is specified.
+  moveit_msgs::msg::PlanningSceneComponents components;
+  // Return all scene components if nothing is specified.
+  components.components = req->components.components ? req->components.components : UINT_MAX;
 
-  std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
-  scene_->getPlanningSceneMsg(res->scene, req->components.components ? req->components : all_components);
+  // Responses are reused until the scene changes. The version is read before the scene, so a response computed
+  // while the scene changes is labeled with an outdated version and never reused.
+  const std::uint64_t version = scene_version_;
+  {
+    std::scoped_lock lock(scene_msg_cache_mutex_);
+    if (scene_msg_cache_version_ == version)
+    {
+      const auto cached = scene_msg_cache_.find(components.components);
+      if (cached != scene_msg_cache_.end())
+      {
+        res->scene = cached->second;
+        return;
+      }
+    }
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
+    scene_->getPlanningSceneMsg(res->scene, components);
+  }
+
+  std::scoped_lock lock(scene_msg_cache_mutex_);
+  if (version < scene_msg_cache_version_)
+    return;
+  if (version > scene_msg_cache_version_)
+  {
+    scene_msg_cache_.clear();
+    scene_msg_cache_version_ = version;
+  }
+  scene_msg_cache_[components.components] = res->scene;
+}
+
+void PlanningSceneMonitor::encodeOctomapUpdate(octomap_msgs::msg::OctomapWithPose& octomap)
+{
+  if (octomap_keyframe_interval_ > 0 && !octomap_keyframe_required_ &&
+      octomap_update_index_ < octomap_keyframe_interval_)
+  {
+    octomap_msgs::msg::OctomapWithPose update;
+    if (scene_->getOctomapUpdateMsg(octomap_changed_keys_, octomap_update_index_ + 1, update) &&
+        update.octomap.data.size() < octomap.octomap.data.size())
+    {
+      octomap = std::move(update);
+      ++octomap_update_index_;
+      octomap_changed_keys_.clear();
+      return;
+    }
+  }
+
+  // publish the full octomap, the following updates are relative to it
+  octomap_update_index_ = 0;
+  octomap_keyframe_required_ = false;
+  octomap_changed_keys_.clear();
 }
 
 void PlanningSceneMonitor::updatePublishSettings(bool publish_geom_updates, bool publish_state_updates,
@@ -654,6 +840,7 @@ void PlanningSceneMonitor::clearOctomap()
   {
     std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
     removed = scene_->getWorldNonConst()->removeObject(scene_->OCTOMAP_NS);
+    octomap_keyframe_required_ = true;
 
     if (octomap_monitor_)
     {
@@ -676,6 +863,9 @@ bool PlanningSceneMonitor::newPlanningSceneMessage(const moveit_msgs::msg::Plann
   if (!scene_)
     return false;
 
+  // keep the order of updates, pending collision objects were received before this scene
+  applyPendingCollisionObjects();
+
   bool result;
 
   SceneUpdateType upd = UPDATE_SCENE;
@@ -687,6 +877,8 @@ bool PlanningSceneMonitor::newPlanningSceneMessage(const moveit_msgs::msg::Plann
 
     last_update_time_ = rclcpp::Clock().now();
     last_robot_motion_time_ = scene.robot_state.joint_state.header.stamp;
+    // the message may replace the octomap
+    octomap_keyframe_required_ = true;
     RCLCPP_DEBUG(LOGGER, "scene update %f robot stamp: %f", fmod(last_update_time_.seconds(), 10.),
                  fmod(last_robot_motion_time_.seconds(), 10.));
     old_scene_name = scene_->getName();
@@ -758,12 +950,14 @@ void PlanningSceneMonitor::newPlanningSceneWorldCallback(
 {
   if (scene_)
   {
+    applyPendingCollisionObjects();
     updateFrameTransforms();
     {
       std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
       last_update_time_ = rclcpp::Clock().now();
       scene_->getWorldNonConst()->clearObjects();
       scene_->processPlanningSceneWorldMsg(*world);
+      octomap_keyframe_required_ = true;
       if (octomap_monitor_)
       {
         if (world->octomap.octomap.data.empty())
@@ -783,20 +977,178 @@ void PlanningSceneMonitor::collisionObjectCallback(const moveit_msgs::msg::Colli
   if (!scene_)
     return;
 
+  {
+    std::scoped_lock lock(collision_object_queue_mutex_);
+    if (dt_collision_object_coalescing_.count() > 0.0)
+    {
+      coalesceCollisionObjectUpdate(pending_collision_objects_, *obj);
+      return;
+    }
+  }
+
   updateFrameTransforms();
   {
     std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
     last_update_time_ = rclcpp::Clock().now();
-    if (!scene_->processCollisionObjectMsg(*obj))
+    // updates queued before coalescing was turned off were received before this one
+    const bool applied_pending = processPendingCollisionObjects();
+    if (!scene_->processCollisionObjectMsg(*obj) && !applied_pending)
       return;
   }
   triggerSceneUpdateEvent(UPDATE_GEOMETRY);
 }
 
+void PlanningSceneMonitor::coalesceCollisionObjectUpdate(std::vector<moveit_msgs::msg::CollisionObject>& pending,
+                                                         const moveit_msgs::msg::CollisionObject& update)
+{
+  using moveit_msgs::msg::CollisionObject;
+  if (update.operation == CollisionObject::REMOVE && update.id.empty())
+  {
+    // removes all objects
+    pending.clear();
+  }
+  else if (update.operation == CollisionObject::ADD || update.operation == CollisionObject::REMOVE)
+  {
+    // the object is replaced or removed, whatever happened to it before
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [&update](const CollisionObject& object) { return object.id == update.id; }),
+                  pending.end());
+  }
+  else if (update.operation == CollisionObject::MOVE)
+  {
+    // a move sets the pose of the object, so only the last of consecutive moves matters
+    const auto previous = std::find_if(pending.rbegin(), pending.rend(),
+                                       [&update](const CollisionObject& object) { return object.id == update.id; });
+    if (previous != pending.rend() && previous->operation == CollisionObject::MOVE)
+      pending.erase(std::next(previous).base());
+  }
+  pending.push_back(update);
+}
+
+void PlanningSceneMonitor::applyPendingCollisionObjects()
+{
+  {
+    std::scoped_lock lock(collision_object_queue_mutex_);
+    if (pending_collision_objects_.empty())
+      return;
+  }
+  if (!scene_)
+    return;
+
+  updateFrameTransforms();
+  bool updated;
+  {
+    std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
+    last_update_time_ = rclcpp::Clock().now();
+    updated = processPendingCollisionObjects();
+  }
+  if (updated)
+    triggerSceneUpdateEvent(UPDATE_GEOMETRY);
+}
+
+bool PlanningSceneMonitor::processPendingCollisionObjects()
+{
+  // Taking the queue while scene_update_mutex_ is held makes taking and applying it one step, so two batches cannot
+  // be applied out of order by concurrent callers.
+  std::vector<moveit_msgs::msg::CollisionObject> pending;
+  {
+    std::scoped_lock lock(collision_object_queue_mutex_);
+    pending.swap(pending_collision_objects_);
+  }
+  bool updated = false;
+  for (const moveit_msgs::msg::CollisionObject& object : pending)
+    updated |= scene_->processCollisionObjectMsg(object);
+  return updated;
+}
+
+void PlanningSceneMonitor::setCollisionObjectCoalescingWindow(double seconds)
+{
+  if (collision_object_coalescing_timer_)
+  {
+    collision_object_coalescing_timer_->cancel();
+    collision_object_coalescing_timer_.reset();
+  }
+  {
+    std::scoped_lock lock(collision_object_queue_mutex_);
+    dt_collision_object_coalescing_ = std::chrono::duration<double>(std::max(seconds, 0.0));
+  }
+  if (seconds > std::numeric_limits<double>::epsilon())
+  {
+    collision_object_coalescing_timer_ = pnode_->create_wall_timer(
+        dt_collision_object_coalescing_, [this]() { return applyPendingCollisionObjects(); });
+    RCLCPP_INFO(LOGGER, "Applying collision object updates together every %lf seconds", seconds);
+  }
+  else
+  {
+    // updates are applied immediately from now on
+    applyPendingCollisionObjects();
+  }
+}
+
+void PlanningSceneMonitor::setMemoryDiagnosticsPeriod(double seconds)
+{
+  if (memory_diagnostics_timer_)
+  {
+    memory_diagnostics_timer_->cancel();
+    memory_diagnostics_timer_.reset();
+  }
+  if (seconds > std::numeric_limits<double>::epsilon())
+  {
+    if (!memory_diagnostics_publisher_)
+      memory_diagnostics_publisher_ =
+          pnode_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>(MEMORY_DIAGNOSTICS_TOPIC, 1);
+    memory_diagnostics_timer_ = pnode_->create_wall_timer(std::chrono::duration<double>(seconds),
+                                                          [this]() { return publishMemoryDiagnostics(); });
+    RCLCPP_INFO(LOGGER, "Publishing the memory usage of the planning scene every %lf seconds", seconds);
+  }
+}
+
+void PlanningSceneMonitor::publishMemoryDiagnostics()
+{
+  std::vector<collision_detection::MemoryUsage> layers;
+  // the octree of the scene may be the monitored one, which needs to be locked as well
+  lockSceneRead();
+  try
+  {
+    if (scene_)
+      layers = scene_->getMemoryUsage();
+    unlockSceneRead();
+  }
+  catch (...)
+  {
+    unlockSceneRead();
+    throw;
+  }
+
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = pnode_->now();
+  for (std::size_t i = 0; i < layers.size(); ++i)
+  {
+    diagnostic_msgs::msg::DiagnosticStatus& status = msg.status.emplace_back();
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = monitor_name_ + ": planning scene memory, diff layer " + std::to_string(i);
+    status.message = std::to_string(layers[i].getTotal()) + " bytes";
+    const auto add_values = [&status](const std::string& prefix, const std::map<std::string, std::size_t>& usage) {
+      for (const auto& [name, bytes] : usage)
+      {
+        diagnostic_msgs::msg::KeyValue& value = status.values.emplace_back();
+        value.key = prefix + name;
+        value.value = std::to_string(bytes);
+      }
+    };
+    add_values("world_object/", layers[i].world_objects);
+    add_values("octree/", layers[i].octrees);
+    add_values("collision_geometry/", layers[i].collision_geometry);
+  }
+  memory_diagnostics_publisher_->publish(msg);
+}
+
 void PlanningSceneMonitor::attachObjectCallback(const moveit_msgs::msg::AttachedCollisionObject::ConstSharedPtr& obj)
 {
   if (scene_)
   {
+    // attached objects may refer to pending collision objects
+    applyPendingCollisionObjects();
     updateFrameTransforms();
     {
       std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
@@ -1094,13 +1446,13 @@ bool PlanningSceneMonitor::waitForCurrentRobotState(const rclcpp::Time& t, doubl
 void PlanningSceneMonitor::lockSceneRead()
 {
   scene_update_mutex_.lock_shared();
-  if (octomap_monitor_)
+  if (octomap_monitor_ && !use_octomap_snapshots_)
     octomap_monitor_->getOcTreePtr()->lockRead();
 }
 
 void PlanningSceneMonitor::unlockSceneRead()
 {
-  if (octomap_monitor_)
+  if (octomap_monitor_ && !use_octomap_snapshots_)
     octomap_monitor_->getOcTreePtr()->unlockRead();
   scene_update_mutex_.unlock_shared();
 }
@@ -1108,13 +1460,15 @@ void PlanningSceneMonitor::unlockSceneRead()
 void PlanningSceneMonitor::lockSceneWrite()
 {
   scene_update_mutex_.lock();
-  if (octomap_monitor_)
+  if (octomap_monitor_ && !use_octomap_snapshots_)
     octomap_monitor_->getOcTreePtr()->lockWrite();
 }
 
 void PlanningSceneMonitor::unlockSceneWrite()
 {
-  if (octomap_monitor_)
+  // the scene may have been modified without an update event
+  ++scene_version_;
+  if (octomap_monitor_ && !use_octomap_snapshots_)
     octomap_monitor_->getOcTreePtr()->unlockWrite();
   scene_update_mutex_.unlock();
 }
@@ -1127,10 +1481,13 @@ void PlanningSceneMonitor::startSceneMonitor(const std::string& scene_topic)
   // listen for planning scene updates; these messages include transforms, so no need for filters
   if (!scene_topic.empty())
   {
+    // receive scene updates published in the same process without copying or deserializing them
+    rclcpp::SubscriptionOptions options;
+    options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
     planning_scene_subscriber_ = pnode_->create_subscription<moveit_msgs::msg::PlanningScene>(
-        scene_topic, 100, [this](const moveit_msgs::msg::PlanningScene::ConstSharedPtr& scene) {
-          return newPlanningSceneCallback(scene);
-        });
+        scene_topic, 100,
+        [this](const moveit_msgs::msg::PlanningScene::ConstSharedPtr& scene) { return newPlanningSceneCallback(scene); },
+        options);
     RCLCPP_INFO(LOGGER, "Listening to '%s'", planning_scene_subscriber_->get_topic_name());
   }
 }
@@ -1255,6 +1612,9 @@ void PlanningSceneMonitor::startWorldGeometryMonitor(const std::string& collisio
         return getShapeTransformCache(frame, stamp, cache);
       });
       octomap_monitor_->setUpdateCallback([this] { octomapUpdateCallback(); });
+
+      // let distance field based collision environments apply only the cells changed by each update
+      octomap_monitor_->getOcTreePtr()->enableChangeDetection(true);
     }
     octomap_monitor_->startMonitor();
   }
@@ -1274,6 +1634,7 @@ void PlanningSceneMonitor::stopWorldGeometryMonitor()
   }
   if (octomap_monitor_)
     octomap_monitor_->stopMonitor();
+  applyPendingCollisionObjects();
 }
 
 void PlanningSceneMonitor::startStateMonitor(const std::string& joint_states_topic,
@@ -1290,6 +1651,14 @@ void PlanningSceneMonitor::startStateMonitor(const std::string& joint_states_top
     current_state_monitor_->addUpdateCallback(
         [this](const sensor_msgs::msg::JointState::ConstSharedPtr& joint_state) { return onStateUpdate(joint_state); });
     current_state_monitor_->startStateMonitor(joint_states_topic);
+    if (!shared_state_channel_.empty())
+    {
+      if (current_state_monitor_->setSharedStateChannel(shared_state_channel_))
+        RCLCPP_INFO(LOGGER, "Publishing the current robot state on shared memory '%s'", shared_state_channel_.c_str());
+      else
+        RCLCPP_ERROR(LOGGER, "Unable to publish the current robot state on shared memory '%s'",
+                     shared_state_channel_.c_str());
+    }
 
     {
       std::unique_lock<std::mutex> lock(state_pending_mutex_);
@@ -1395,18 +1764,69 @@ void PlanningSceneMonitor::octomapUpdateCallback()
     return;
 
   updateFrameTransforms();
+  if (use_octomap_snapshots_)
+  {
+    // the snapshot is taken without scene_update_mutex_, so collision checks only wait for swapping it in
+    std::scoped_lock snapshot_lock(octomap_snapshot_mutex_);
+    collision_detection::OccMapTree& octree = *octomap_monitor_->getOcTreePtr();
+    std::shared_ptr<const octomap::OcTree> snapshot;
+    octomap::KeySet changed_keys;
+    {
+      // resetting change detection modifies the tree, so writers are excluded as well as other readers
+      collision_detection::OccMapTree::WriteLock lock = octree.writing();
+      snapshot = octomap_snapshots_.update(octree);
+      if (octomap_keyframe_interval_ > 0)
+      {
+        for (auto it = octree.changedKeysBegin(); it != octree.changedKeysEnd(); ++it)
+          changed_keys.insert(it->first);
+      }
+      // the changes are consumed by the snapshot and the keys copied above, octomap_snapshot_mutex_ serializes this
+      octree.resetChangeDetection();
+    }
+
+    std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
+    last_update_time_ = rclcpp::Clock().now();
+    scene_->processOctomapPtr(snapshot, Eigen::Isometry3d::Identity());
+    if (octomap_keyframe_interval_ > 0 && !octomap_keyframe_required_)
+    {
+      octomap_changed_keys_.insert(changed_keys.begin(), changed_keys.end());
+      // when most of the tree changed, a full octomap is smaller than the update
+      if (octomap_changed_keys_.size() > snapshot->size() / 2)
+      {
+        octomap_keyframe_required_ = true;
+        octomap_changed_keys_.clear();
+      }
+    }
+  }
+  else
   {
     std::unique_lock<std::shared_mutex> ulock(scene_update_mutex_);
     last_update_time_ = rclcpp::Clock().now();
-    octomap_monitor_->getOcTreePtr()->lockRead();
+    // the write lock is needed to reset change detection
+    octomap_monitor_->getOcTreePtr()->lockWrite();
     try
     {
       scene_->processOctomapPtr(octomap_monitor_->getOcTreePtr(), Eigen::Isometry3d::Identity());
-      octomap_monitor_->getOcTreePtr()->unlockRead();
+      collision_detection::OccMapTree& octree = *octomap_monitor_->getOcTreePtr();
+      if (octomap_keyframe_interval_ > 0 && !octomap_keyframe_required_)
+      {
+        for (auto it = octree.changedKeysBegin(); it != octree.changedKeysEnd(); ++it)
+          octomap_changed_keys_.insert(it->first);
+        // when most of the tree changed, a full octomap is smaller than the update
+        if (octomap_changed_keys_.size() > octree.size() / 2)
+        {
+          octomap_keyframe_required_ = true;
+          octomap_changed_keys_.clear();
+        }
+      }
+      // the changed keys are only consumed above, with scene_update_mutex_ held exclusively, and writers of the
+      // tree are blocked by the write lock, so no change can be lost between processing and resetting
+      octomap_monitor_->getOcTreePtr()->resetChangeDetection();
+      octomap_monitor_->getOcTreePtr()->unlockWrite();
     }
     catch (...)
     {
-      octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
+      octomap_monitor_->getOcTreePtr()->unlockWrite();  // unlock and rethrow
       throw;
     }
   }
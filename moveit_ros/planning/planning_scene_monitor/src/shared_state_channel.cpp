@@ -0,0 +1,323 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_scene_monitor/shared_state_channel.h>
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace planning_scene_monitor
+{
+namespace shared_state
+{
+// Marks an initialized segment, and the version of its layout
+constexpr std::uint64_t MAGIC = 0x4d6f766549745301;
+
+// Bits of Header::fields
+constexpr std::uint32_t HAS_VELOCITIES = 1;
+constexpr std::uint32_t HAS_EFFORT = 2;
+
+/* Layout of the shared memory segment. The header is followed by the positions, velocities and efforts of all
+ * variables, stored as the bit patterns of the doubles. All values are accessed through lock-free atomics,
+ * which work across processes, so that the sequence lock is free of data races. */
+struct Header
+{
+  std::atomic<std::uint64_t> magic{ 0 };  // written last by the writer
+  std::uint64_t layout_hash = 0;
+  std::uint64_t variable_count = 0;
+  std::atomic<std::uint64_t> sequence{ 0 };  // odd while a write is in progress, 0 before the first write
+  std::atomic<std::int64_t> stamp_nanoseconds{ 0 };
+  std::atomic<std::int32_t> clock_type{ RCL_ROS_TIME };
+  std::atomic<std::uint32_t> fields{ 0 };
+};
+
+using Value = std::atomic<std::uint64_t>;
+static_assert(Value::is_always_lock_free, "shared state values must be lock-free atomics");
+
+}  // namespace shared_state
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.shared_state_channel");
+
+std::string getSegmentName(const std::string& channel)
+{
+  return (!channel.empty() && channel.front() == '/') ? channel : '/' + channel;
+}
+
+std::size_t getSegmentSize(std::size_t variable_count)
+{
+  return sizeof(shared_state::Header) + 3 * variable_count * sizeof(shared_state::Value);
+}
+
+// FNV-1a hash of the model name and the variable names, to reject readers with a different variable layout
+std::uint64_t getLayoutHash(const moveit::core::RobotModel& robot_model)
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+  const auto add = [&hash](const std::string& name) {
+    for (const char c : name)
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    hash = hash * 0x100000001b3;  // terminating zero
+  };
+  add(robot_model.getName());
+  for (const std::string& name : robot_model.getVariableNames())
+    add(name);
+  return hash;
+}
+
+shared_state::Value* getValues(shared_state::Header* header)
+{
+  return reinterpret_cast<shared_state::Value*>(header + 1);
+}
+
+const shared_state::Value* getValues(const shared_state::Header* header)
+{
+  return reinterpret_cast<const shared_state::Value*>(header + 1);
+}
+
+void storeValues(const double* source, std::size_t count, shared_state::Value* target)
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, source + i, sizeof(bits));
+    target[i].store(bits, std::memory_order_relaxed);
+  }
+}
+
+void loadValues(const shared_state::Value* source, std::size_t count, double* target)
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const std::uint64_t bits = source[i].load(std::memory_order_relaxed);
+    std::memcpy(target + i, &bits, sizeof(bits));
+  }
+}
+}  // namespace
+
+SharedStateWriterPtr SharedStateWriter::create(const std::string& channel,
+                                               const moveit::core::RobotModelConstPtr& robot_model)
+{
+  const std::string name = getSegmentName(channel);
+  const std::size_t variable_count = robot_model->getVariableCount();
+  const std::size_t size = getSegmentSize(variable_count);
+
+  // Start with a new segment: readers still attached to a previous one keep their mapping instead of seeing it resized
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to create shared memory segment '%s': %s", name.c_str(), std::strerror(errno));
+    return nullptr;
+  }
+  void* memory = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to map shared memory segment '%s': %s", name.c_str(), std::strerror(errno));
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  shared_state::Header* header = new (memory) shared_state::Header();
+  header->layout_hash = getLayoutHash(*robot_model);
+  header->variable_count = variable_count;
+  shared_state::Value* values = getValues(header);
+  for (std::size_t i = 0; i < 3 * variable_count; ++i)
+    new (values + i) shared_state::Value(0);
+  header->magic.store(shared_state::MAGIC, std::memory_order_release);
+
+  RCLCPP_INFO(LOGGER, "Publishing the robot state on shared memory segment '%s'", name.c_str());
+  return SharedStateWriterPtr(new SharedStateWriter(name, fd, memory, size));
+}
+
+SharedStateWriter::SharedStateWriter(std::string channel, int fd, void* memory, std::size_t size)
+  : channel_(std::move(channel)), fd_(fd), header_(static_cast<shared_state::Header*>(memory)), size_(size)
+{
+}
+
+SharedStateWriter::~SharedStateWriter()
+{
+  munmap(header_, size_);
+  close(fd_);
+  shm_unlink(channel_.c_str());
+}
+
+void SharedStateWriter::write(const moveit::core::RobotState& state, const rclcpp::Time& stamp)
+{
+  const std::size_t count = header_->variable_count;
+  shared_state::Value* values = getValues(header_);
+
+  // Sequence lock: the sequence is odd while the values change
+  const std::uint64_t sequence = header_->sequence.load(std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::uint32_t fields = 0;
+  storeValues(state.getVariablePositions(), count, values);
+  if (state.hasVelocities())
+  {
+    storeValues(state.getVariableVelocities(), count, values + count);
+    fields |= shared_state::HAS_VELOCITIES;
+  }
+  if (state.hasEffort())
+  {
+    storeValues(state.getVariableEffort(), count, values + 2 * count);
+    fields |= shared_state::HAS_EFFORT;
+  }
+  header_->fields.store(fields, std::memory_order_relaxed);
+  header_->stamp_nanoseconds.store(stamp.nanoseconds(), std::memory_order_relaxed);
+  header_->clock_type.store(stamp.get_clock_type(), std::memory_order_relaxed);
+
+  header_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+SharedStateReaderPtr SharedStateReader::open(const std::string& channel,
+                                             const moveit::core::RobotModelConstPtr& robot_model)
+{
+  const std::string name = getSegmentName(channel);
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to open shared memory segment '%s': %s", name.c_str(), std::strerror(errno));
+    return nullptr;
+  }
+
+  const std::size_t variable_count = robot_model->getVariableCount();
+  const std::size_t size = getSegmentSize(variable_count);
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) != size)
+  {
+    RCLCPP_ERROR(LOGGER, "Shared memory segment '%s' does not match the variables of robot model '%s'", name.c_str(),
+                 robot_model->getName().c_str());
+    close(fd);
+    return nullptr;
+  }
+  void* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to map shared memory segment '%s': %s", name.c_str(), std::strerror(errno));
+    close(fd);
+    return nullptr;
+  }
+
+  const shared_state::Header* header = static_cast<const shared_state::Header*>(memory);
+  if (header->magic.load(std::memory_order_acquire) != shared_state::MAGIC ||
+      header->variable_count != variable_count || header->layout_hash != getLayoutHash(*robot_model))
+  {
+    RCLCPP_ERROR(LOGGER, "Shared memory segment '%s' does not match the variables of robot model '%s'", name.c_str(),
+                 robot_model->getName().c_str());
+    munmap(memory, size);
+    close(fd);
+    return nullptr;
+  }
+  return SharedStateReaderPtr(new SharedStateReader(name, fd, memory, size));
+}
+
+SharedStateReader::SharedStateReader(std::string channel, int fd, const void* memory, std::size_t size)
+  : channel_(std::move(channel)), fd_(fd), header_(static_cast<const shared_state::Header*>(memory)), size_(size)
+{
+}
+
+SharedStateReader::~SharedStateReader()
+{
+  munmap(const_cast<shared_state::Header*>(header_), size_);
+  close(fd_);
+}
+
+std::uint64_t SharedStateReader::getSequence() const
+{
+  return header_->sequence.load(std::memory_order_acquire) & ~std::uint64_t(1);
+}
+
+bool SharedStateReader::read(moveit::core::RobotState& state, rclcpp::Time* stamp) const
+{
+  const std::size_t count = header_->variable_count;
+  const shared_state::Value* values = getValues(header_);
+
+  // The values are copied to a buffer first, so that the state only changes once a consistent copy was made
+  thread_local std::vector<double> buffer;
+  buffer.resize(3 * count);
+
+  std::uint32_t fields;
+  std::int64_t stamp_nanoseconds;
+  std::int32_t clock_type;
+  while (true)
+  {
+    const std::uint64_t sequence = header_->sequence.load(std::memory_order_acquire);
+    if (sequence == 0)
+      return false;
+    if (sequence & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    fields = header_->fields.load(std::memory_order_relaxed);
+    stamp_nanoseconds = header_->stamp_nanoseconds.load(std::memory_order_relaxed);
+    clock_type = header_->clock_type.load(std::memory_order_relaxed);
+    loadValues(values, count, buffer.data());
+    if (fields & shared_state::HAS_VELOCITIES)
+      loadValues(values + count, count, buffer.data() + count);
+    if (fields & shared_state::HAS_EFFORT)
+      loadValues(values + 2 * count, count, buffer.data() + 2 * count);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->sequence.load(std::memory_order_relaxed) == sequence)
+      break;
+  }
+
+  state.setVariablePositions(buffer.data());
+  if (fields & shared_state::HAS_VELOCITIES)
+    state.setVariableVelocities(buffer.data() + count);
+  if (fields & shared_state::HAS_EFFORT)
+    state.setVariableEffort(buffer.data() + 2 * count);
+  if (stamp)
+    *stamp = rclcpp::Time(stamp_nanoseconds, static_cast<rcl_clock_type_t>(clock_type));
+  return true;
+}
+}  // namespace planning_scene_monitor
@@ -112,6 +112,8 @@ void planning_scene_monitor::TrajectoryMonitor::clearTrajectory()
   if (restart)
     stopTrajectoryMonitor();
   trajectory_.clear();
+  if (compact_recorder_)
+    compact_recorder_->clear();
   if (restart)
     startTrajectoryMonitor();
 }
@@ -127,7 +129,13 @@ void planning_scene_monitor::TrajectoryMonitor::recordStates()
   {
     middleware_handle_->sleep();
     std::pair<moveit::core::RobotStatePtr, rclcpp::Time> state = current_state_monitor_->getCurrentStateAndTime();
-    if (trajectory_.empty())
+    if (compact_recorder_)
+    {
+      if (compact_recorder_->getSampleCount() == 0)
+        trajectory_start_time_ = state.second;
+      compact_recorder_->addState(*state.first, (state.second - trajectory_start_time_).seconds());
+    }
+    else if (trajectory_.empty())
     {
       trajectory_.addSuffixWayPoint(state.first, 0.0);
       trajectory_start_time_ = state.second;
@@ -0,0 +1,125 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+
+#include <string>
+#include <vector>
+
+using moveit_msgs::msg::CollisionObject;
+using planning_scene_monitor::PlanningSceneMonitor;
+
+namespace
+{
+CollisionObject makeUpdate(const std::string& id, CollisionObject::_operation_type operation, double x = 0.0)
+{
+  CollisionObject object;
+  object.id = id;
+  object.operation = operation;
+  object.pose.position.x = x;
+  return object;
+}
+
+std::vector<CollisionObject> coalesce(const std::vector<CollisionObject>& updates)
+{
+  std::vector<CollisionObject> pending;
+  for (const CollisionObject& update : updates)
+    PlanningSceneMonitor::coalesceCollisionObjectUpdate(pending, update);
+  return pending;
+}
+}  // namespace
+
+TEST(CollisionObjectCoalescing, KeepsIndependentUpdatesInOrder)
+{
+  const std::vector<CollisionObject> pending =
+      coalesce({ makeUpdate("a", CollisionObject::ADD), makeUpdate("b", CollisionObject::ADD),
+                 makeUpdate("a", CollisionObject::APPEND), makeUpdate("b", CollisionObject::MOVE) });
+  ASSERT_EQ(pending.size(), 4u);
+  EXPECT_EQ(pending[0].id, "a");
+  EXPECT_EQ(pending[1].id, "b");
+  EXPECT_EQ(pending[2].operation, CollisionObject::APPEND);
+  EXPECT_EQ(pending[3].operation, CollisionObject::MOVE);
+}
+
+TEST(CollisionObjectCoalescing, AddAndRemoveSupersedeUpdatesOfTheObject)
+{
+  std::vector<CollisionObject> pending =
+      coalesce({ makeUpdate("a", CollisionObject::ADD), makeUpdate("b", CollisionObject::ADD),
+                 makeUpdate("a", CollisionObject::MOVE), makeUpdate("a", CollisionObject::ADD, 1.0) });
+  ASSERT_EQ(pending.size(), 2u);
+  EXPECT_EQ(pending[0].id, "b");
+  EXPECT_EQ(pending[1].id, "a");
+  EXPECT_EQ(pending[1].pose.position.x, 1.0);
+
+  PlanningSceneMonitor::coalesceCollisionObjectUpdate(pending, makeUpdate("b", CollisionObject::REMOVE));
+  ASSERT_EQ(pending.size(), 2u);
+  EXPECT_EQ(pending[0].id, "a");
+  EXPECT_EQ(pending[1].operation, CollisionObject::REMOVE);
+}
+
+TEST(CollisionObjectCoalescing, OnlyLastOfConsecutiveMovesIsKept)
+{
+  const std::vector<CollisionObject> pending = coalesce(
+      { makeUpdate("a", CollisionObject::MOVE, 1.0), makeUpdate("b", CollisionObject::MOVE),
+        makeUpdate("a", CollisionObject::MOVE, 2.0), makeUpdate("a", CollisionObject::MOVE, 3.0) });
+  ASSERT_EQ(pending.size(), 2u);
+  EXPECT_EQ(pending[0].id, "b");
+  EXPECT_EQ(pending[1].id, "a");
+  EXPECT_EQ(pending[1].pose.position.x, 3.0);
+}
+
+TEST(CollisionObjectCoalescing, MoveAfterAppendIsKept)
+{
+  const std::vector<CollisionObject> pending =
+      coalesce({ makeUpdate("a", CollisionObject::MOVE, 1.0), makeUpdate("a", CollisionObject::APPEND),
+                 makeUpdate("a", CollisionObject::MOVE, 2.0) });
+  EXPECT_EQ(pending.size(), 3u);
+}
+
+TEST(CollisionObjectCoalescing, RemoveAllSupersedesEverything)
+{
+  const std::vector<CollisionObject> pending =
+      coalesce({ makeUpdate("a", CollisionObject::ADD), makeUpdate("b", CollisionObject::ADD),
+                 makeUpdate("", CollisionObject::REMOVE), makeUpdate("c", CollisionObject::ADD) });
+  ASSERT_EQ(pending.size(), 2u);
+  EXPECT_TRUE(pending[0].id.empty());
+  EXPECT_EQ(pending[1].id, "c");
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
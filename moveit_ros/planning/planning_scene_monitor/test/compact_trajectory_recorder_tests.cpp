@@ -0,0 +1,194 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/planning_scene_monitor/compact_trajectory_recorder.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using planning_scene_monitor::CompactTrajectoryRecorder;
+using planning_scene_monitor::CompactTrajectorySamples;
+
+namespace
+{
+const std::vector<std::string> NAMES = { "a", "joint_b", "c" };
+
+// Variable "a" moves in every sample, "joint_b" in every tenth and "c" never
+std::vector<double> samplePositions(std::size_t i)
+{
+  return { std::sin(0.01 * i), static_cast<double>(i / 10) * 0.5, 1.25 };
+}
+
+void record(CompactTrajectoryRecorder& recorder, std::size_t first, std::size_t count)
+{
+  for (std::size_t i = first; i < first + count; ++i)
+    recorder.addSample(0.1 * i, samplePositions(i).data());
+}
+
+CompactTrajectorySamples readBack(const CompactTrajectoryRecorder& recorder)
+{
+  std::stringstream stream;
+  recorder.write(stream);
+  CompactTrajectorySamples samples;
+  EXPECT_TRUE(CompactTrajectoryRecorder::read(stream, samples));
+  return samples;
+}
+}  // namespace
+
+TEST(CompactTrajectoryRecorder, RoundTrip)
+{
+  CompactTrajectoryRecorder::Options options;
+  options.chunk_size = 16;
+  CompactTrajectoryRecorder recorder(NAMES, options);
+  record(recorder, 0, 100);
+  EXPECT_EQ(recorder.getSampleCount(), 100u);
+
+  const CompactTrajectorySamples samples = readBack(recorder);
+  EXPECT_EQ(samples.variable_names, NAMES);
+  ASSERT_EQ(samples.times.size(), 100u);
+  ASSERT_EQ(samples.positions.size(), 300u);
+  for (std::size_t i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(samples.times[i], 0.1 * i);
+    const std::vector<double> expected = samplePositions(i);
+    for (std::size_t v = 0; v < NAMES.size(); ++v)
+      EXPECT_EQ(samples.positions[i * NAMES.size() + v], expected[v]) << "sample " << i << ", variable " << v;
+  }
+}
+
+TEST(CompactTrajectoryRecorder, StoresOnlyChanges)
+{
+  CompactTrajectoryRecorder::Options options;
+  options.chunk_size = 1000;
+  CompactTrajectoryRecorder recorder(NAMES, options);
+  std::vector<double> constant = { 1.0, 2.0, 3.0 };
+  for (std::size_t i = 0; i < 1000; ++i)
+    recorder.addSample(0.1 * i, constant.data());
+
+  std::stringstream stream;
+  recorder.write(stream);
+  // the times dominate, the positions are only stored once
+  EXPECT_LT(stream.str().size(), 1000 * sizeof(double) + 200);
+}
+
+TEST(CompactTrajectoryRecorder, DeltaEncoding)
+{
+  CompactTrajectoryRecorder::Options options;
+  options.chunk_size = 500;
+  CompactTrajectoryRecorder exact(NAMES, options);
+  options.delta_encoding = true;
+  CompactTrajectoryRecorder delta(NAMES, options);
+  record(exact, 0, 1000);
+  record(delta, 0, 1000);
+
+  std::stringstream exact_stream, delta_stream;
+  exact.write(exact_stream);
+  delta.write(delta_stream);
+  EXPECT_LT(delta_stream.str().size(), exact_stream.str().size());
+
+  const CompactTrajectorySamples samples = readBack(delta);
+  ASSERT_EQ(samples.times.size(), 1000u);
+  for (std::size_t i = 0; i < 1000; ++i)
+  {
+    const std::vector<double> expected = samplePositions(i);
+    for (std::size_t v = 0; v < NAMES.size(); ++v)
+      EXPECT_NEAR(samples.positions[i * NAMES.size() + v], expected[v], 1e-6);
+  }
+}
+
+TEST(CompactTrajectoryRecorder, KeepsLatestChunks)
+{
+  CompactTrajectoryRecorder::Options options;
+  options.chunk_size = 10;
+  options.max_chunks = 3;
+  CompactTrajectoryRecorder recorder(NAMES, options);
+  record(recorder, 0, 105);
+
+  // three full chunks and the unfinished one
+  const CompactTrajectorySamples samples = readBack(recorder);
+  ASSERT_EQ(samples.times.size(), 35u);
+  EXPECT_EQ(samples.times.front(), 0.1 * 70);
+  EXPECT_EQ(samples.positions[0], samplePositions(70)[0]);
+  EXPECT_EQ(recorder.getSampleCount(), 105u);
+
+  recorder.clear();
+  EXPECT_EQ(recorder.getSampleCount(), 0u);
+  EXPECT_TRUE(readBack(recorder).times.empty());
+}
+
+TEST(CompactTrajectoryRecorder, StreamToFile)
+{
+  const std::string path = testing::TempDir() + "compact_trajectory_recorder_test.bin";
+  {
+    CompactTrajectoryRecorder::Options options;
+    options.chunk_size = 8;
+    options.max_chunks = 1;
+    CompactTrajectoryRecorder recorder(NAMES, options);
+    ASSERT_TRUE(recorder.streamToFile(path));
+    record(recorder, 0, 50);
+  }  // the unfinished chunk is written on destruction
+
+  std::ifstream file(path, std::ios::binary);
+  CompactTrajectorySamples samples;
+  ASSERT_TRUE(CompactTrajectoryRecorder::read(file, samples));
+  ASSERT_EQ(samples.times.size(), 50u);
+  EXPECT_EQ(samples.positions[49 * NAMES.size() + 1], samplePositions(49)[1]);
+  std::remove(path.c_str());
+}
+
+TEST(CompactTrajectoryRecorder, RejectsInvalidData)
+{
+  CompactTrajectoryRecorder recorder(NAMES, CompactTrajectoryRecorder::Options());
+  record(recorder, 0, 20);
+  std::stringstream stream;
+  recorder.write(stream);
+  const std::string data = stream.str();
+
+  CompactTrajectorySamples samples;
+  std::stringstream truncated(data.substr(0, data.size() - 12));
+  EXPECT_FALSE(CompactTrajectoryRecorder::read(truncated, samples));
+  std::stringstream garbage("not a trajectory");
+  EXPECT_FALSE(CompactTrajectoryRecorder::read(garbage, samples));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
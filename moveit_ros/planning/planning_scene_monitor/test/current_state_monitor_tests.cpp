@@ -35,6 +35,7 @@
 /* Author: Tyler Weaver */
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -199,6 +200,64 @@ TEST(CurrentStateMonitorTests, WaitForCompleteStateWaits)
   EXPECT_NEAR(nanoseconds_slept.count(), 1e+9, 1e3);
 }
 
+TEST(CurrentStateMonitorTests, GetCurrentVariablePositions)
+{
+  // GIVEN a CurrentStateMonitor
+  planning_scene_monitor::CurrentStateMonitor current_state_monitor{
+    std::make_unique<MockMiddlewareHandle>(), moveit::core::loadTestingRobotModel("panda"),
+    std::make_shared<tf2_ros::Buffer>(std::make_shared<rclcpp::Clock>()), false
+  };
+
+  // WHEN we ask for the positions of a subset of the variables
+  const std::vector<int> variable_indices = { 3, 0, 5 };
+  std::vector<double> positions;
+  current_state_monitor.getCurrentVariablePositions(variable_indices, positions);
+
+  // THEN we expect them to match the positions in the full current state
+  const moveit::core::RobotStatePtr current_state = current_state_monitor.getCurrentState();
+  ASSERT_EQ(positions.size(), variable_indices.size());
+  for (std::size_t i = 0; i < variable_indices.size(); ++i)
+    EXPECT_EQ(positions[i], current_state->getVariablePosition(variable_indices[i]));
+}
+
+TEST(CurrentStateMonitorTests, JointStatesWithDifferentJointOrders)
+{
+  auto mock_middleware_handle = std::make_unique<MockMiddlewareHandle>();
+  planning_scene_monitor::JointStateUpdateCallback joint_state_callback;
+  EXPECT_CALL(*mock_middleware_handle, createJointStateSubscription)
+      .WillOnce(testing::SaveArg<1>(&joint_state_callback));
+
+  // GIVEN a started CurrentStateMonitor
+  planning_scene_monitor::CurrentStateMonitor current_state_monitor{
+    std::move(mock_middleware_handle), moveit::core::loadTestingRobotModel("panda"),
+    std::make_shared<tf2_ros::Buffer>(std::make_shared<rclcpp::Clock>()), false
+  };
+  current_state_monitor.startStateMonitor();
+  ASSERT_TRUE(joint_state_callback);
+
+  // WHEN joint states arrive with alternating joint orders and an unknown joint
+  auto first = std::make_shared<sensor_msgs::msg::JointState>();
+  first->name = { "panda_joint1", "unknown_joint", "panda_joint2" };
+  first->position = { 0.1, 5.0, 0.2 };
+  auto second = std::make_shared<sensor_msgs::msg::JointState>();
+  second->name = { "panda_joint2", "panda_joint1" };
+  second->position = { 0.4, 0.3 };
+  joint_state_callback(first);
+  joint_state_callback(second);
+  joint_state_callback(first);
+
+  // THEN each message updates the joints it names
+  std::map<std::string, double> values = current_state_monitor.getCurrentStateValues();
+  EXPECT_DOUBLE_EQ(values["panda_joint1"], 0.1);
+  EXPECT_DOUBLE_EQ(values["panda_joint2"], 0.2);
+  EXPECT_EQ(values.count("unknown_joint"), 0u);
+
+  joint_state_callback(second);
+  values = current_state_monitor.getCurrentStateValues();
+  EXPECT_DOUBLE_EQ(values["panda_joint1"], 0.3);
+  EXPECT_DOUBLE_EQ(values["panda_joint2"], 0.4);
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,102 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/planning_scene_monitor/shared_state_channel.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+#include <string>
+#include <unistd.h>
+
+using namespace planning_scene_monitor;
+
+class SharedStateChannelTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    channel_ = "moveit_shared_state_test_" + std::to_string(getpid());
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  std::string channel_;
+};
+
+TEST_F(SharedStateChannelTest, ReadsWrittenState)
+{
+  SharedStateWriterPtr writer = SharedStateWriter::create(channel_, robot_model_);
+  ASSERT_TRUE(writer);
+  SharedStateReaderPtr reader = SharedStateReader::open(channel_, robot_model_);
+  ASSERT_TRUE(reader);
+
+  moveit::core::RobotState state(robot_model_);
+  moveit::core::RobotState read_state(robot_model_);
+  EXPECT_FALSE(reader->read(read_state));
+
+  state.setToRandomPositions();
+  state.zeroVelocities();
+  writer->write(state, rclcpp::Time(42, RCL_STEADY_TIME));
+  rclcpp::Time stamp;
+  ASSERT_TRUE(reader->read(read_state, &stamp));
+  EXPECT_EQ(stamp.nanoseconds(), 42);
+  EXPECT_EQ(stamp.get_clock_type(), RCL_STEADY_TIME);
+  EXPECT_TRUE(read_state.hasVelocities());
+  EXPECT_FALSE(read_state.hasEffort());
+  for (std::size_t i = 0; i < robot_model_->getVariableCount(); ++i)
+    EXPECT_EQ(read_state.getVariablePosition(i), state.getVariablePosition(i));
+
+  const std::uint64_t sequence = reader->getSequence();
+  writer->write(state, rclcpp::Time(43, RCL_STEADY_TIME));
+  EXPECT_NE(reader->getSequence(), sequence);
+}
+
+TEST_F(SharedStateChannelTest, RejectsOtherRobotModels)
+{
+  EXPECT_FALSE(SharedStateReader::open(channel_, robot_model_));
+
+  SharedStateWriterPtr writer = SharedStateWriter::create(channel_, robot_model_);
+  ASSERT_TRUE(writer);
+  EXPECT_FALSE(SharedStateReader::open(channel_, moveit::core::loadTestingRobotModel("pr2")));
+
+  // the segment is removed with the writer
+  writer.reset();
+  EXPECT_FALSE(SharedStateReader::open(channel_, robot_model_));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
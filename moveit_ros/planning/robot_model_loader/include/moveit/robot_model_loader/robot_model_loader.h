@@ -40,6 +40,7 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/rdf_loader/rdf_loader.h>
 #include <moveit/kinematics_plugin_loader/kinematics_plugin_loader.h>
+#include <pluginlib/class_loader.hpp>
 
 namespace robot_model_loader
 {
@@ -74,6 +75,16 @@ public:
     /** @brief Flag indicating whether the kinematics solvers should be loaded as well, using specified ROS parameters
      */
     bool load_kinematics_solvers;
+
+    /** @brief Directory of the mesh cache, see moveit::core::MeshCache. Meshes are read from a cache file for the
+        robot description if one exists, and the file is written otherwise. If empty, the ROS parameter
+        "<robot_description>_planning.mesh_cache_directory" is used; without either, no cache is used. */
+    std::string mesh_cache_directory;
+
+    /** @brief Simplification of the collision meshes, "none" or "convex_hull". Simplified meshes are stored in the
+        mesh cache. If empty, the ROS parameter "<robot_description>_planning.collision_mesh_simplification" is used;
+        without either, the meshes are not simplified. */
+    std::string collision_mesh_simplification;
   };
 
   /** @brief Default constructor */
@@ -129,9 +140,20 @@ public:
 private:
   void configure(const Options& opt);
 
+  /** @brief The directory of the mesh cache from the options or parameters, empty if no cache is used */
+  std::string getMeshCacheDirectory(const Options& opt) const;
+
+  /** @brief The collision mesh simplification from the options or parameters */
+  moveit::core::MeshCache::Simplification getCollisionMeshSimplification(const Options& opt) const;
+
+  /** @brief Load the moveit::core::CompiledForwardKinematics plugins listed in the ROS parameter
+      "<robot_description>_planning.compiled_forward_kinematics" into the model */
+  void loadCompiledForwardKinematics();
+
   moveit::core::RobotModelPtr model_;
   rdf_loader::RDFLoaderPtr rdf_loader_;
   kinematics_plugin_loader::KinematicsPluginLoaderPtr kinematics_loader_;
+  std::shared_ptr<pluginlib::ClassLoader<moveit::core::CompiledForwardKinematics>> compiled_kinematics_loader_;
   const rclcpp::Node::SharedPtr node_;
 };
 }  // namespace robot_model_loader
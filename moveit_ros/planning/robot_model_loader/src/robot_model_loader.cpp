@@ -71,6 +71,7 @@ RobotModelLoader::~RobotModelLoader()
   model_.reset();
   rdf_loader_.reset();
   kinematics_loader_.reset();
+  compiled_kinematics_loader_.reset();
 }
 
 namespace
@@ -101,6 +102,37 @@ bool canSpecifyPosition(const moveit::core::JointModel* jmodel, const unsigned i
 }
 }  // namespace
 
+std::string RobotModelLoader::getMeshCacheDirectory(const Options& opt) const
+{
+  if (!opt.mesh_cache_directory.empty() || rdf_loader_->getRobotDescription().empty())
+    return opt.mesh_cache_directory;
+
+  const std::string param_name = rdf_loader_->getRobotDescription() + "_planning.mesh_cache_directory";
+  if (!node_->has_parameter(param_name))
+    node_->declare_parameter(param_name, rclcpp::ParameterType::PARAMETER_STRING);
+  std::string mesh_cache_directory;
+  node_->get_parameter(param_name, mesh_cache_directory);
+  return mesh_cache_directory;
+}
+
+moveit::core::MeshCache::Simplification RobotModelLoader::getCollisionMeshSimplification(const Options& opt) const
+{
+  std::string simplification = opt.collision_mesh_simplification;
+  if (simplification.empty() && !rdf_loader_->getRobotDescription().empty())
+  {
+    const std::string param_name = rdf_loader_->getRobotDescription() + "_planning.collision_mesh_simplification";
+    if (!node_->has_parameter(param_name))
+      node_->declare_parameter(param_name, rclcpp::ParameterType::PARAMETER_STRING);
+    node_->get_parameter(param_name, simplification);
+  }
+
+  if (simplification == "convex_hull")
+    return moveit::core::MeshCache::Simplification::CONVEX_HULL;
+  if (!simplification.empty() && simplification != "none")
+    RCLCPP_ERROR(LOGGER, "Unknown collision mesh simplification '%s', using 'none'", simplification.c_str());
+  return moveit::core::MeshCache::Simplification::NONE;
+}
+
 void RobotModelLoader::configure(const Options& opt)
 {
   rclcpp::Clock clock;
@@ -117,7 +149,30 @@ void RobotModelLoader::configure(const Options& opt)
   {
     const srdf::ModelSharedPtr& srdf =
         rdf_loader_->getSRDF() ? rdf_loader_->getSRDF() : std::make_shared<srdf::Model>();
-    model_ = std::make_shared<moveit::core::RobotModel>(rdf_loader_->getURDF(), srdf);
+    const std::string mesh_cache_directory = getMeshCacheDirectory(opt);
+    const moveit::core::MeshCache::Simplification simplification = getCollisionMeshSimplification(opt);
+    if (mesh_cache_directory.empty() && simplification == moveit::core::MeshCache::Simplification::NONE)
+    {
+      model_ = std::make_shared<moveit::core::RobotModel>(rdf_loader_->getURDF(), srdf);
+    }
+    else
+    {
+      const std::uint64_t key =
+          moveit::core::MeshCache::computeKey(rdf_loader_->getURDFString(), rdf_loader_->getSRDFString());
+      const std::string filename = mesh_cache_directory.empty() ?
+                                       std::string() :
+                                       mesh_cache_directory + "/" + rdf_loader_->getURDF()->getName() + ".meshes";
+      moveit::core::MeshCachePtr mesh_cache;
+      if (!filename.empty())
+        mesh_cache = moveit::core::MeshCache::readFromFile(filename, key);
+      if (!mesh_cache)
+        mesh_cache = std::make_shared<moveit::core::MeshCache>(key);
+      mesh_cache->setSimplification(simplification);
+      model_ = std::make_shared<moveit::core::RobotModel>(rdf_loader_->getURDF(), srdf, mesh_cache);
+      if (!filename.empty() && mesh_cache->isModified() && mesh_cache->writeToFile(filename))
+        RCLCPP_INFO(LOGGER, "Wrote %zu meshes and %zu simplified meshes to the mesh cache '%s'", mesh_cache->size(),
+                    mesh_cache->simplifiedSize(), filename.c_str());
+    }
   }
 
   if (model_ && !rdf_loader_->getRobotDescription().empty())
@@ -246,12 +301,48 @@ void RobotModelLoader::configure(const Options& opt)
     }
   }
 
+  if (model_ && !rdf_loader_->getRobotDescription().empty())
+    loadCompiledForwardKinematics();
+
   if (model_ && opt.load_kinematics_solvers)
     loadKinematicsSolvers();
 
   RCLCPP_DEBUG(node_->get_logger(), "Loaded kinematic model in %f seconds", (clock.now() - start).seconds());
 }
 
+void RobotModelLoader::loadCompiledForwardKinematics()
+{
+  const std::string param_name = rdf_loader_->getRobotDescription() + "_planning.compiled_forward_kinematics";
+  if (!node_->has_parameter(param_name))
+    node_->declare_parameter(param_name, rclcpp::ParameterType::PARAMETER_STRING_ARRAY);
+  std::vector<std::string> plugin_names;
+  if (!node_->get_parameter(param_name, plugin_names) || plugin_names.empty())
+    return;
+
+  try
+  {
+    compiled_kinematics_loader_ = std::make_shared<pluginlib::ClassLoader<moveit::core::CompiledForwardKinematics>>(
+        "moveit_core", "moveit::core::CompiledForwardKinematics");
+  }
+  catch (pluginlib::PluginlibException& e)
+  {
+    RCLCPP_ERROR(LOGGER, "Unable to construct the compiled forward kinematics plugin loader: %s", e.what());
+    return;
+  }
+  // the model falls back to its joint models for kinematics that fail to load or do not match it
+  for (const std::string& plugin_name : plugin_names)
+  {
+    try
+    {
+      model_->setCompiledForwardKinematics(compiled_kinematics_loader_->createSharedInstance(plugin_name));
+    }
+    catch (pluginlib::PluginlibException& e)
+    {
+      RCLCPP_ERROR(LOGGER, "Unable to load compiled forward kinematics '%s': %s", plugin_name.c_str(), e.what());
+    }
+  }
+}
+
 void RobotModelLoader::loadKinematicsSolvers(const kinematics_plugin_loader::KinematicsPluginLoaderPtr& kloader)
 {
   if (rdf_loader_ && model_)
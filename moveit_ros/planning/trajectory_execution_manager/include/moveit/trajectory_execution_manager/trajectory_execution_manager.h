@@ -49,6 +49,7 @@
 #include <memory>
 #include <deque>
 #include <thread>
+#include <tuple>
 
 #include <moveit_trajectory_execution_manager_export.h>
 
@@ -153,6 +154,13 @@ public:
   /// If no controller is specified, a default is used.
   bool push(const moveit_msgs::msg::RobotTrajectory& trajectory, const std::vector<std::string>& controllers);
 
+  /// Replace the tail of the trajectory that is currently executed, starting at splice_time, without stopping the
+  /// robot in between. The trajectory has to actuate the same joints as the active one and its first point has to
+  /// match the state the active trajectory commands at splice_time, within the allowed start tolerance. Only the last
+  /// pushed trajectory can be spliced and all of its controllers need to support splicing. Multi-DOF trajectories
+  /// are not supported.
+  bool splice(const moveit_msgs::msg::RobotTrajectory& trajectory, const rclcpp::Time& splice_time);
+
   /// Get the trajectories to be executed
   const std::vector<TrajectoryExecutionContext*>& getTrajectories() const;
 
@@ -233,6 +241,21 @@ private:
     }
   };
 
+  /// The inputs selectControllers() depends on, used to memoize its result
+  struct ControllerSelectionKey
+  {
+    std::set<std::string> actuated_joints_;
+    std::vector<std::string> available_controllers_;
+    // active and default flags of the available controllers
+    std::vector<std::pair<bool, bool> > controller_states_;
+
+    bool operator<(const ControllerSelectionKey& other) const
+    {
+      return std::tie(actuated_joints_, available_controllers_, controller_states_) <
+             std::tie(other.actuated_joints_, other.available_controllers_, other.controller_states_);
+    }
+  };
+
   void initialize();
 
   void reloadControllerInformation();
@@ -259,9 +282,13 @@ private:
                                      std::vector<std::string>& selected_controllers,
                                      std::vector<std::vector<std::string> >& selected_options,
                                      const std::set<std::string>& actuated_joints);
+  /// Memoized wrapper of computeControllerSelection(), the result is reused until the controller states change
   bool selectControllers(const std::set<std::string>& actuated_joints,
                          const std::vector<std::string>& available_controllers,
                          std::vector<std::string>& selected_controllers);
+  bool computeControllerSelection(const std::set<std::string>& actuated_joints,
+                                  const std::vector<std::string>& available_controllers,
+                                  std::vector<std::string>& selected_controllers);
 
   void executeThread(const ExecutionCompleteCallback& callback, const PathSegmentCompleteCallback& part_callback,
                      bool auto_clear);
@@ -287,6 +314,10 @@ private:
   std::map<std::string, ControllerInformation> known_controllers_;
   bool manage_controllers_;
 
+  // selected controllers by the inputs of the selection, empty if there was no valid selection;
+  // cleared when the known controllers or their joints change
+  std::map<ControllerSelectionKey, std::vector<std::string> > controller_selection_cache_;
+
   // thread used to execute trajectories using the execute() command
   std::unique_ptr<std::thread> execution_thread_;
 
@@ -301,6 +332,8 @@ private:
   int current_context_;
   std::vector<rclcpp::Time> time_index_;  // used to find current expected trajectory location
   mutable std::mutex time_index_mutex_;
+  rclcpp::Time active_trajectory_start_{ 0, 0, RCL_ROS_TIME };  // when the current context was sent to controllers
+  rclcpp::Time spliced_trajectory_end_{ 0, 0, RCL_ROS_TIME };   // expected end of the spliced trajectories
   bool execution_complete_;
 
   std::vector<TrajectoryExecutionContext*> trajectories_;
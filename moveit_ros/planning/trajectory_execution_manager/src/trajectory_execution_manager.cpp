@@ -46,12 +46,37 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.trajectory_e
 const std::string TrajectoryExecutionManager::EXECUTION_EVENT_TOPIC = "trajectory_execution_event";
 
 static const auto DEFAULT_CONTROLLER_INFORMATION_VALIDITY_AGE = rclcpp::Duration::from_seconds(1);
+// the memoized controller selections are dropped when there are more, see selectControllers()
+static const std::size_t MAX_CONTROLLER_SELECTION_CACHE_SIZE = 64;
 static const double DEFAULT_CONTROLLER_GOAL_DURATION_MARGIN = 0.5;  // allow 0.5s more than the expected execution time
                                                                     // before triggering a trajectory cancel (applied
                                                                     // after scaling)
 static const double DEFAULT_CONTROLLER_GOAL_DURATION_SCALING =
     1.1;  // allow the execution of a trajectory to take more time than expected (scaled by a value > 1)
 
+// Linearly interpolate the joint positions a trajectory commands at the given time after its start
+static std::vector<double> interpolatePositions(const trajectory_msgs::msg::JointTrajectory& trajectory,
+                                                const rclcpp::Duration& time)
+{
+  const std::vector<trajectory_msgs::msg::JointTrajectoryPoint>& points = trajectory.points;
+  auto next = std::find_if(points.begin(), points.end(), [&time](const trajectory_msgs::msg::JointTrajectoryPoint& p) {
+    return rclcpp::Duration(p.time_from_start) > time;
+  });
+  if (next == points.begin())
+    return next->positions;
+  if (next == points.end())
+    return points.back().positions;
+
+  const trajectory_msgs::msg::JointTrajectoryPoint& prev = *(next - 1);
+  const double t0 = rclcpp::Duration(prev.time_from_start).seconds();
+  const double t1 = rclcpp::Duration(next->time_from_start).seconds();
+  const double alpha = (time.seconds() - t0) / (t1 - t0);
+  std::vector<double> positions(std::min(prev.positions.size(), next->positions.size()));
+  for (std::size_t i = 0; i < positions.size(); ++i)
+    positions[i] = prev.positions[i] + alpha * (next->positions[i] - prev.positions[i]);
+  return positions;
+}
+
 TrajectoryExecutionManager::TrajectoryExecutionManager(const rclcpp::Node::SharedPtr& node,
                                                        const moveit::core::RobotModelConstPtr& robot_model,
                                                        const planning_scene_monitor::CurrentStateMonitorPtr& csm)
@@ -375,7 +400,8 @@ bool TrajectoryExecutionManager::push(const moveit_msgs::msg::RobotTrajectory& t
 
 void TrajectoryExecutionManager::reloadControllerInformation()
 {
-  known_controllers_.clear();
+  std::map<std::string, ControllerInformation> previous_controllers;
+  previous_controllers.swap(known_controllers_);
   if (controller_manager_)
   {
     std::vector<std::string> names;
@@ -402,6 +428,22 @@ void TrajectoryExecutionManager::reloadControllerInformation()
       }
     }
 
+    // this is called for every trajectory, so the overlaps and the memoized controller selections are only
+    // computed again if a controller or its joints changed
+    const bool unchanged = std::equal(
+        known_controllers_.begin(), known_controllers_.end(), previous_controllers.begin(), previous_controllers.end(),
+        [](const auto& known, const auto& previous) {
+          return known.first == previous.first && known.second.joints_ == previous.second.joints_;
+        });
+    if (unchanged)
+    {
+      for (std::pair<const std::string, ControllerInformation>& known_controller : known_controllers_)
+        known_controller.second.overlapping_controllers_.swap(
+            previous_controllers[known_controller.first].overlapping_controllers_);
+      return;
+    }
+    controller_selection_cache_.clear();
+
     for (std::map<std::string, ControllerInformation>::iterator it = known_controllers_.begin();
          it != known_controllers_.end(); ++it)
     {
@@ -424,6 +466,7 @@ void TrajectoryExecutionManager::reloadControllerInformation()
   }
   else
   {
+    controller_selection_cache_.clear();
     RCLCPP_ERROR(LOGGER, "Failed to reload controllers: `controller_manager_` does not exist.");
   }
 }
@@ -660,6 +703,52 @@ bool TrajectoryExecutionManager::areControllersActive(const std::vector<std::str
 bool TrajectoryExecutionManager::selectControllers(const std::set<std::string>& actuated_joints,
                                                    const std::vector<std::string>& available_controllers,
                                                    std::vector<std::string>& selected_controllers)
+{
+  // the selection only depends on the joints, the available controllers and their states
+  ControllerSelectionKey key;
+  key.actuated_joints_ = actuated_joints;
+  key.available_controllers_ = available_controllers;
+  key.controller_states_.reserve(available_controllers.size());
+  for (const std::string& controller : available_controllers)
+  {
+    std::map<std::string, ControllerInformation>::iterator it = known_controllers_.find(controller);
+    if (it == known_controllers_.end())
+    {
+      key.controller_states_.emplace_back(false, false);
+      continue;
+    }
+    updateControllerState(it->second, DEFAULT_CONTROLLER_INFORMATION_VALIDITY_AGE);
+    key.controller_states_.emplace_back(it->second.state_.active_, it->second.state_.default_);
+  }
+
+  std::map<ControllerSelectionKey, std::vector<std::string> >::const_iterator cached =
+      controller_selection_cache_.find(key);
+  if (cached != controller_selection_cache_.end())
+  {
+    if (verbose_)
+      RCLCPP_INFO(LOGGER, "Reusing the controller selection for the same joints and controller states.");
+    if (cached->second.empty())
+      return false;
+    selected_controllers = cached->second;
+    return true;
+  }
+
+  std::vector<std::string> selection;
+  if (!computeControllerSelection(actuated_joints, available_controllers, selection))
+    selection.clear();
+  if (controller_selection_cache_.size() >= MAX_CONTROLLER_SELECTION_CACHE_SIZE)
+    controller_selection_cache_.clear();
+  controller_selection_cache_[key] = selection;
+
+  if (selection.empty())
+    return false;
+  selected_controllers.swap(selection);
+  return true;
+}
+
+bool TrajectoryExecutionManager::computeControllerSelection(const std::set<std::string>& actuated_joints,
+                                                            const std::vector<std::string>& available_controllers,
+                                                            std::vector<std::string>& selected_controllers)
 {
   for (std::size_t i = 1; i <= available_controllers.size(); ++i)
   {
@@ -839,13 +928,17 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
 
   RCLCPP_INFO(LOGGER, "Validating trajectory with allowed_start_tolerance %g", allowed_start_tolerance_);
 
-  moveit::core::RobotStatePtr current_state;
-  if (!csm_->waitForCurrentState(node_->now()) || !(current_state = csm_->getCurrentState()))
+  if (!csm_->waitForCurrentState(node_->now()))
   {
     RCLCPP_WARN(LOGGER, "Failed to validate trajectory: couldn't receive full current joint state within 1s");
     return false;
   }
 
+  // only the variables of the trajectory joints are read from the monitor, rather than copying the whole state
+  std::vector<const moveit::core::JointModel*> joints;
+  std::vector<int> variable_indices;
+  std::vector<double> current_positions;
+
   for (const auto& trajectory : context.trajectory_parts_)
   {
     if (!trajectory.joint_trajectory.points.empty())
@@ -859,16 +952,25 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
         return false;
       }
 
-      for (std::size_t i = 0, end = joint_names.size(); i < end; ++i)
+      joints.clear();
+      variable_indices.clear();
+      for (const std::string& joint_name : joint_names)
       {
-        const moveit::core::JointModel* jm = current_state->getJointModel(joint_names[i]);
+        const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_name);
         if (!jm)
         {
-          RCLCPP_ERROR_STREAM(LOGGER, "Unknown joint in trajectory: " << joint_names[i]);
+          RCLCPP_ERROR_STREAM(LOGGER, "Unknown joint in trajectory: " << joint_name);
           return false;
         }
+        joints.push_back(jm);
+        variable_indices.push_back(jm->getFirstVariableIndex());
+      }
+      csm_->getCurrentVariablePositions(variable_indices, current_positions);
 
-        double cur_position = current_state->getJointPositions(jm)[0];
+      for (std::size_t i = 0, end = joint_names.size(); i < end; ++i)
+      {
+        const moveit::core::JointModel* jm = joints[i];
+        double cur_position = current_positions[i];
         double traj_position = positions[i];
         // normalize positions and compare
         jm->enforcePositionBounds(&cur_position);
@@ -896,20 +998,34 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
         return false;
       }
 
-      for (std::size_t i = 0, end = joint_names.size(); i < end; ++i)
+      // all variables of the multi-dof joints are needed, stored contiguously per joint
+      joints.clear();
+      variable_indices.clear();
+      std::vector<std::size_t> first_positions;
+      for (const std::string& joint_name : joint_names)
       {
-        const moveit::core::JointModel* jm = current_state->getJointModel(joint_names[i]);
+        const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_name);
         if (!jm)
         {
-          RCLCPP_ERROR_STREAM(LOGGER, "Unknown joint in trajectory: " << joint_names[i]);
+          RCLCPP_ERROR_STREAM(LOGGER, "Unknown joint in trajectory: " << joint_name);
           return false;
         }
+        joints.push_back(jm);
+        first_positions.push_back(variable_indices.size());
+        for (std::size_t j = 0; j < jm->getVariableCount(); ++j)
+          variable_indices.push_back(jm->getFirstVariableIndex() + j);
+      }
+      csm_->getCurrentVariablePositions(variable_indices, current_positions);
+
+      for (std::size_t i = 0, end = joint_names.size(); i < end; ++i)
+      {
+        const moveit::core::JointModel* jm = joints[i];
 
         // compute difference (offset vector and rotation angle) between current transform
         // and start transform in trajectory
         Eigen::Isometry3d cur_transform, start_transform;
         // computeTransform() computes a valid isometry by contract
-        jm->computeTransform(current_state->getJointPositions(jm), cur_transform);
+        jm->computeTransform(&current_positions[first_positions[i]], cur_transform);
         start_transform = tf2::transformToEigen(transforms[i]);
         ASSERT_ISOMETRY(start_transform)  // unsanitized input, could contain a non-isometry
         Eigen::Vector3d offset = cur_transform.translation() - start_transform.translation();
@@ -1304,6 +1420,8 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
     // compute the expected duration of the trajectory and find the part of the trajectory that takes longest to execute
     rclcpp::Time current_time = node_->now();
     auto expected_trajectory_duration = rclcpp::Duration::from_seconds(0);
+    double duration_scaling = 0.0;  // used to extend the expected duration when trajectories are spliced
+    double duration_margin = 0.0;
     int longest_part = -1;
     for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
     {
@@ -1353,9 +1471,17 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
       // expected duration is the duration of the longest part
       expected_trajectory_duration =
           std::max(d * current_scaling + rclcpp::Duration::from_seconds(current_margin), expected_trajectory_duration);
+      duration_scaling = std::max(duration_scaling, current_scaling);
+      duration_margin = std::max(duration_margin, current_margin);
     }
 
     // construct a map from expected time to state index, for easy access to expected state location
+    {
+      // from now on the context is only modified by splice()
+      std::scoped_lock slock(time_index_mutex_);
+      active_trajectory_start_ = current_time;
+      spliced_trajectory_end_ = rclcpp::Time(0, 0, RCL_ROS_TIME);
+    }
     if (longest_part >= 0)
     {
       std::scoped_lock slock(time_index_mutex_);
@@ -1389,23 +1515,43 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
     {
       if (execution_duration_monitoring_)
       {
-        if (!handle->waitForExecution(expected_trajectory_duration))
+        bool timed_out = false;
+        auto timeout = expected_trajectory_duration - (node_->now() - current_time);
+        while (!handle->waitForExecution(std::max(timeout, rclcpp::Duration::from_seconds(0))))
         {
-          if (!execution_complete_ && node_->now() - current_time > expected_trajectory_duration)
+          // spliced trajectories extend the expected duration while we wait
           {
-            RCLCPP_ERROR(LOGGER,
-                         "Controller is taking too long to execute trajectory (the expected upper "
-                         "bound for the trajectory execution was %lf seconds). Stopping trajectory.",
-                         expected_trajectory_duration.seconds());
+            std::scoped_lock slock(time_index_mutex_);
+            if (spliced_trajectory_end_ > current_time)
             {
-              std::scoped_lock slock(execution_state_mutex_);
-              stopExecutionInternal();  // this is really tricky. we can't call stopExecution() here, so we call the
-                                        // internal function only
+              expected_trajectory_duration =
+                  std::max(expected_trajectory_duration, (spliced_trajectory_end_ - current_time) * duration_scaling +
+                                                             rclcpp::Duration::from_seconds(duration_margin));
             }
-            last_execution_status_ = moveit_controller_manager::ExecutionStatus::TIMED_OUT;
-            result = false;
+          }
+          timeout = expected_trajectory_duration - (node_->now() - current_time);
+          if (execution_complete_)
             break;
+          if (timeout >= rclcpp::Duration::from_seconds(0))
+            continue;
+
+          RCLCPP_ERROR(LOGGER,
+                       "Controller is taking too long to execute trajectory (the expected upper "
+                       "bound for the trajectory execution was %lf seconds). Stopping trajectory.",
+                       expected_trajectory_duration.seconds());
+          {
+            std::scoped_lock slock(execution_state_mutex_);
+            stopExecutionInternal();  // this is really tricky. we can't call stopExecution() here, so we call the
+                                      // internal function only
           }
+          last_execution_status_ = moveit_controller_manager::ExecutionStatus::TIMED_OUT;
+          timed_out = true;
+          break;
+        }
+        if (timed_out)
+        {
+          result = false;
+          break;
         }
       }
       else
@@ -1433,6 +1579,7 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
     // clear the time index
     time_index_mutex_.lock();
     time_index_.clear();
+    active_trajectory_start_ = rclcpp::Time(0, 0, RCL_ROS_TIME);
     current_context_ = -1;
     time_index_mutex_.unlock();
 
@@ -1459,49 +1606,60 @@ bool TrajectoryExecutionManager::waitForRobotToStop(const TrajectoryExecutionCon
   auto start = std::chrono::system_clock::now();
   double time_remaining = wait_time;
 
-  moveit::core::RobotStatePtr prev_state, cur_state;
-  prev_state = csm_->getCurrentState();
-  prev_state->enforceBounds();
+  // resolve the joints of the execution context once, so each state update only copies their positions
+  std::vector<const moveit::core::JointModel*> joints;
+  std::vector<int> variable_indices;
+  for (const auto& trajectory : context.trajectory_parts_)
+  {
+    for (const std::string& joint_name : trajectory.joint_trajectory.joint_names)
+    {
+      const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_name);
+      if (!jm || jm->getVariableCount() != 1)
+        continue;  // joint vanished from robot state (shouldn't happen), but we don't care
+      joints.push_back(jm);
+      variable_indices.push_back(jm->getFirstVariableIndex());
+    }
+  }
+  const auto enforce_bounds = [&joints](std::vector<double>& positions) {
+    for (std::size_t i = 0; i < joints.size(); ++i)
+      joints[i]->enforcePositionBounds(&positions[i]);
+  };
+
+  std::vector<double> prev_positions, cur_positions;
+  csm_->getCurrentVariablePositions(variable_indices, prev_positions);
+  enforce_bounds(prev_positions);
 
   // assume robot stopped when 3 consecutive checks yield the same robot state
   unsigned int no_motion_count = 0;  // count iterations with no motion
   while (time_remaining > 0. && no_motion_count < 3)
   {
-    if (!csm_->waitForCurrentState(node_->now(), time_remaining) || !(cur_state = csm_->getCurrentState()))
+    // the monitor notifies us as soon as a new joint state arrives
+    if (!csm_->waitForCurrentState(node_->now(), time_remaining))
     {
       RCLCPP_WARN(LOGGER, "Failed to receive current joint state");
       return false;
     }
-    cur_state->enforceBounds();
+    csm_->getCurrentVariablePositions(variable_indices, cur_positions);
+    enforce_bounds(cur_positions);
     std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
     time_remaining = wait_time - elapsed_seconds.count();  // remaining wait_time
 
     // check for motion in effected joints of execution context
     bool moved = false;
-    for (const auto& trajectory : context.trajectory_parts_)
+    for (std::size_t i = 0; i < joints.size(); ++i)
     {
-      const std::vector<std::string>& joint_names = trajectory.joint_trajectory.joint_names;
-      const std::size_t n = joint_names.size();
-
-      for (std::size_t i = 0; i < n && !moved; ++i)
+      if (fabs(cur_positions[i] - prev_positions[i]) > allowed_start_tolerance_)
       {
-        const moveit::core::JointModel* jm = cur_state->getJointModel(joint_names[i]);
-        if (!jm)
-          continue;  // joint vanished from robot state (shouldn't happen), but we don't care
-
-        if (fabs(cur_state->getJointPositions(jm)[0] - prev_state->getJointPositions(jm)[0]) > allowed_start_tolerance_)
-        {
-          moved = true;
-          no_motion_count = 0;
-          break;
-        }
+        moved = true;
+        no_motion_count = 0;
+        break;
       }
     }
 
     if (!moved)
       ++no_motion_count;
 
-    std::swap(prev_state, cur_state);
+    std::swap(prev_positions, cur_positions);
   }
 
   return time_remaining > 0;
@@ -1520,6 +1678,147 @@ std::pair<int, int> TrajectoryExecutionManager::getCurrentExpectedTrajectoryInde
   return std::make_pair(static_cast<int>(current_context_), pos);
 }
 
+bool TrajectoryExecutionManager::splice(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                                        const rclcpp::Time& splice_time)
+{
+  if (!trajectory.multi_dof_joint_trajectory.points.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "Splicing multi-DOF trajectories is not supported");
+    return false;
+  }
+  if (trajectory.joint_trajectory.points.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot splice an empty trajectory");
+    return false;
+  }
+  if (splice_time <= node_->now())
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot splice a trajectory at a time that already passed");
+    return false;
+  }
+
+  std::scoped_lock slock(execution_state_mutex_);
+  rclcpp::Time active_start(0, 0, RCL_ROS_TIME);
+  {
+    std::scoped_lock tlock(time_index_mutex_);
+    active_start = active_trajectory_start_;
+  }
+  // the start time is only known once the active trajectory was sent to its controllers
+  if (execution_complete_ || current_context_ < 0 || active_handles_.empty() || active_start.nanoseconds() == 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot splice a trajectory: no trajectory is being executed");
+    return false;
+  }
+  if (static_cast<std::size_t>(current_context_) + 1 != trajectories_.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Only the last pushed trajectory can be spliced");
+    return false;
+  }
+
+  TrajectoryExecutionContext& context = *trajectories_[current_context_];
+  std::vector<moveit_msgs::msg::RobotTrajectory> parts;
+  if (!distributeTrajectory(trajectory, context.controllers_, parts))
+    return false;
+
+  // check that every part continues from the state its controller commands at the splice time
+  std::vector<rclcpp::Duration> splice_offsets;
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    const trajectory_msgs::msg::JointTrajectory& active = context.trajectory_parts_[i].joint_trajectory;
+    trajectory_msgs::msg::JointTrajectory& part = parts[i].joint_trajectory;
+    if (part.joint_names != active.joint_names ||
+        !context.trajectory_parts_[i].multi_dof_joint_trajectory.points.empty())
+    {
+      RCLCPP_ERROR(LOGGER, "The spliced trajectory has to actuate the same joints of controller '%s' as the active one",
+                   context.controllers_[i].c_str());
+      return false;
+    }
+
+    const rclcpp::Time start = std::max(rclcpp::Time(active.header.stamp, RCL_ROS_TIME), active_start);
+    splice_offsets.push_back(splice_time - start);
+    if (active.points.empty())
+      continue;
+    if (part.points.front().positions.size() != part.joint_names.size())
+    {
+      RCLCPP_ERROR(LOGGER, "The first point of the spliced trajectory has no positions");
+      return false;
+    }
+
+    const std::vector<double> expected = interpolatePositions(active, splice_offsets.back());
+    for (std::size_t j = 0; j < expected.size() && allowed_start_tolerance_ > 0; ++j)
+    {
+      const double deviation = fabs(expected[j] - part.points.front().positions[j]);
+      if (deviation > allowed_start_tolerance_)
+      {
+        RCLCPP_ERROR(LOGGER,
+                     "The spliced trajectory does not continue from the commanded state: joint '%s' deviates by %g "
+                     "(tolerance %g)",
+                     part.joint_names[j].c_str(), deviation, allowed_start_tolerance_);
+        return false;
+      }
+    }
+    part.header.stamp = splice_time;
+  }
+
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    bool ok = false;
+    try
+    {
+      ok = active_handles_[i]->spliceTrajectory(parts[i]);
+    }
+    catch (std::exception& ex)
+    {
+      RCLCPP_ERROR(LOGGER, "Caught %s when splicing trajectory", ex.what());
+    }
+    if (!ok)
+    {
+      RCLCPP_ERROR(LOGGER, "Failed to splice trajectory part %zu of %zu into controller %s", i + 1, parts.size(),
+                   active_handles_[i]->getName().c_str());
+      // the parts already spliced cannot be taken back, so the controllers would no longer move in sync
+      if (i > 0)
+      {
+        RCLCPP_ERROR(LOGGER, "Stopping execution of the previously spliced trajectory parts");
+        stopExecutionInternal();
+      }
+      return false;
+    }
+  }
+
+  // keep the executed trajectory and the time index consistent with what the controllers execute now
+  std::scoped_lock tlock(time_index_mutex_);
+  std::size_t longest_part = 0;
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    std::vector<trajectory_msgs::msg::JointTrajectoryPoint>& points =
+        context.trajectory_parts_[i].joint_trajectory.points;
+    const rclcpp::Duration& offset = splice_offsets[i];
+    points.erase(std::find_if(points.begin(), points.end(),
+                              [&offset](const trajectory_msgs::msg::JointTrajectoryPoint& p) {
+                                return rclcpp::Duration(p.time_from_start) >= offset;
+                              }),
+                 points.end());
+    for (const trajectory_msgs::msg::JointTrajectoryPoint& point : parts[i].joint_trajectory.points)
+    {
+      points.push_back(point);
+      points.back().time_from_start = offset + rclcpp::Duration(point.time_from_start);
+    }
+
+    const rclcpp::Time end = splice_time + rclcpp::Duration(parts[i].joint_trajectory.points.back().time_from_start);
+    spliced_trajectory_end_ = std::max(spliced_trajectory_end_, end);
+    if (parts[i].joint_trajectory.points.size() > parts[longest_part].joint_trajectory.points.size())
+      longest_part = i;
+  }
+
+  time_index_.erase(std::lower_bound(time_index_.begin(), time_index_.end(), splice_time), time_index_.end());
+  for (const trajectory_msgs::msg::JointTrajectoryPoint& point : parts[longest_part].joint_trajectory.points)
+    time_index_.push_back(splice_time + rclcpp::Duration(point.time_from_start));
+
+  RCLCPP_INFO(LOGGER, "Spliced a trajectory into the active execution, taking over in %lf seconds",
+              (splice_time - node_->now()).seconds());
+  return true;
+}
+
 const std::vector<TrajectoryExecutionManager::TrajectoryExecutionContext*>&
 TrajectoryExecutionManager::getTrajectories() const
 {
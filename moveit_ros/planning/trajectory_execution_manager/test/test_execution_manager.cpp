@@ -108,6 +108,32 @@ TEST_F(MoveItCppTest, PushExecuteAndWaitTest)
   ASSERT_EQ(last_execution_status, moveit_controller_manager::ExecutionStatus::SUCCEEDED);
 }
 
+TEST_F(MoveItCppTest, ControllerSelectionFollowsControllerStatesAndJointsTest)
+{
+  const std::vector<std::string> arm_controller = { "fake_panda_arm_controller" };
+  const std::vector<std::string> hand_controller = { "fake_panda_hand_controller" };
+  ASSERT_TRUE(trajectory_execution_manager_ptr->push(traj1));
+  EXPECT_EQ(trajectory_execution_manager_ptr->getTrajectories().back()->controllers_, arm_controller);
+
+  // switching controllers changes their states, the selection is computed again and stays the same
+  ASSERT_TRUE(trajectory_execution_manager_ptr->ensureActiveController(hand_controller.front()));
+  ASSERT_TRUE(trajectory_execution_manager_ptr->push(traj1));
+  EXPECT_EQ(trajectory_execution_manager_ptr->getTrajectories().back()->controllers_, arm_controller);
+
+  // other joints with the same controller states must not reuse the selection for the arm
+  moveit_msgs::RobotTrajectory hand_trajectory;
+  hand_trajectory.joint_trajectory.joint_names.push_back("panda_finger_joint1");
+  hand_trajectory.joint_trajectory.points.resize(1);
+  hand_trajectory.joint_trajectory.points[0].positions.push_back(0.0);
+  ASSERT_TRUE(trajectory_execution_manager_ptr->push(hand_trajectory));
+  EXPECT_EQ(trajectory_execution_manager_ptr->getTrajectories().back()->controllers_, hand_controller);
+
+  // and the arm joints still get the arm controller
+  ASSERT_TRUE(trajectory_execution_manager_ptr->push(traj1));
+  EXPECT_EQ(trajectory_execution_manager_ptr->getTrajectories().back()->controllers_, arm_controller);
+  trajectory_execution_manager_ptr->clear();
+}
+
 }  // namespace moveit_cpp
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros.trajectory_execution_manager.test_app");
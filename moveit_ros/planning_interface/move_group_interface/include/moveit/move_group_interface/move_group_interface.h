@@ -57,6 +57,8 @@
 
 #include <rclcpp_action/rclcpp_action.hpp>
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <utility>
 #include <tf2_ros/buffer.h>
@@ -121,6 +123,41 @@ public:
     double planning_time;
   };
 
+  /// The outcome of a planning request sent with planAsync()
+  struct PlanResult
+  {
+    /// The error code reported by the move_group action
+    moveit::core::MoveItErrorCode error_code;
+
+    /// The computed plan, only filled if planning succeeded
+    Plan plan;
+  };
+
+  /// The outcome of a Cartesian path request sent with computeCartesianPathAsync()
+  struct CartesianPathResult
+  {
+    /// The error code reported by the Cartesian path service
+    moveit::core::MoveItErrorCode error_code;
+
+    /// The computed trajectory, only filled if the request succeeded
+    moveit_msgs::msg::RobotTrajectory trajectory;
+
+    /// The fraction of the path achieved as described by the waypoints, -1.0 in case of error
+    double fraction = -1.0;
+  };
+
+  /** \brief Handle of an asynchronous request sent to move_group.
+
+      The \e future becomes ready once move_group reported the outcome of the request, or once the request was
+      rejected or canceled. Calling \e cancel asks move_group to abort the request; the future then reports the
+      resulting error code (usually PREEMPTED). Canceling a request that already finished has no effect. */
+  template <typename ResultT>
+  struct AsyncResult
+  {
+    std::shared_future<ResultT> future;
+    std::function<void()> cancel;
+  };
+
   /**
       \brief Construct a MoveGroupInterface instance call using a specified set of options \e opt.
 
@@ -761,6 +798,42 @@ public:
                               const moveit_msgs::msg::Constraints& path_constraints, bool avoid_collisions = true,
                               moveit_msgs::msg::MoveItErrorCodes* error_code = nullptr);
 
+  /** \brief Compute a motion plan like plan(), but return immediately.
+
+      The goal is constructed from the current targets and settings when this function is called, so the
+      \e MoveGroupInterface can be reconfigured and further requests can be sent while this one is processed.
+      \e done_callback, if given, is called with the result just before the returned future becomes ready.
+      It is called from the internal callback thread and must not block on other requests of this instance. */
+  AsyncResult<PlanResult> planAsync(const std::function<void(const PlanResult&)>& done_callback = {});
+
+  /** \brief Plan and execute like move(), but return immediately. The returned future reports the outcome once the
+      execution finished. See planAsync() for the semantics of \e done_callback. */
+  AsyncResult<moveit::core::MoveItErrorCode>
+  moveAsync(const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback = {});
+
+  /** \brief Execute a \e plan like execute(), but return immediately. The returned future reports the outcome once
+      the execution finished. See planAsync() for the semantics of \e done_callback. */
+  AsyncResult<moveit::core::MoveItErrorCode>
+  executeAsync(const Plan& plan,
+               const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback = {});
+
+  /** \brief Execute a \e trajectory like execute(), but return immediately. The returned future reports the outcome
+      once the execution finished. See planAsync() for the semantics of \e done_callback. */
+  AsyncResult<moveit::core::MoveItErrorCode>
+  executeAsync(const moveit_msgs::msg::RobotTrajectory& trajectory,
+               const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback = {});
+
+  /** \brief Compute a Cartesian path like computeCartesianPath(), but return immediately.
+
+      The service call cannot be aborted on the server side: canceling the request makes the future report
+      PREEMPTED right away and the late response is ignored. See planAsync() for the semantics of \e done_callback. */
+  AsyncResult<CartesianPathResult>
+  computeCartesianPathAsync(const std::vector<geometry_msgs::msg::Pose>& waypoints, double eef_step,
+                            double jump_threshold,
+                            const moveit_msgs::msg::Constraints& path_constraints = moveit_msgs::msg::Constraints(),
+                            bool avoid_collisions = true,
+                            const std::function<void(const CartesianPathResult&)>& done_callback = {});
+
   /** \brief Stop any trajectory execution, if one is active */
   void stop();
 
@@ -39,6 +39,9 @@
 #include <stdexcept>
 #include <sstream>
 #include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #include <moveit/warehouse/constraints_storage.h>
 #include <moveit/kinematic_constraints/utils.h>
@@ -101,6 +104,70 @@ auto qos_default()
 }
 #endif
 
+// State shared between the AsyncResult of a request and the callbacks that complete it
+template <typename ResultT>
+struct AsyncRequestState
+{
+  explicit AsyncRequestState(std::function<void(const ResultT&)> callback) : done_callback(std::move(callback))
+  {
+  }
+
+  // Report the outcome of the request, only the first call has an effect
+  void finish(const ResultT& result)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (done)
+        return;
+      done = true;
+    }
+    if (done_callback)
+      done_callback(result);
+    promise.set_value(result);
+  }
+
+  std::mutex mutex;
+  bool done = false;
+  std::promise<ResultT> promise;
+  std::function<void(const ResultT&)> done_callback;
+};
+
+template <typename ActionT>
+using WrappedResult = typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult;
+
+template <typename ActionT, typename ResultT>
+struct AsyncGoalState : AsyncRequestState<ResultT>
+{
+  using AsyncRequestState<ResultT>::AsyncRequestState;
+
+  // Set once the goal was accepted, reset once it finished
+  typename rclcpp_action::ClientGoalHandle<ActionT>::SharedPtr goal_handle;
+  bool cancel_requested = false;
+};
+
+moveit::core::MoveItErrorCode& errorCodeOf(moveit::core::MoveItErrorCode& result)
+{
+  return result;
+}
+
+moveit::core::MoveItErrorCode& errorCodeOf(MoveGroupInterface::PlanResult& result)
+{
+  return result.error_code;
+}
+
+moveit::core::MoveItErrorCode& errorCodeOf(MoveGroupInterface::CartesianPathResult& result)
+{
+  return result.error_code;
+}
+
+template <typename ResultT>
+ResultT failedResult(int code)
+{
+  ResultT result{};
+  errorCodeOf(result) = code;
+  return result;
+}
+
 }  // namespace
 
 class MoveGroupInterface::MoveGroupInterfaceImpl
@@ -757,15 +824,95 @@ public:
   //    return pick(constructPickupGoal(object.id, std::move(response->grasps), plan_only));
   //  }
 
-  moveit::core::MoveItErrorCode plan(Plan& plan)
-  {
-    if (!move_action_client_ || !move_action_client_->action_server_is_ready())
+  // Send an action goal and report its outcome through the returned AsyncResult
+  template <typename ActionT, typename ResultT>
+  AsyncResult<ResultT> sendGoalAsync(const std::shared_ptr<rclcpp_action::Client<ActionT>>& client,
+                                     const typename ActionT::Goal& goal, const std::string& request_name,
+                                     const std::function<ResultT(const WrappedResult<ActionT>&)>& make_result,
+                                     const std::function<void(const ResultT&)>& done_callback)
+  {
+    using GoalHandle = rclcpp_action::ClientGoalHandle<ActionT>;
+
+    auto state = std::make_shared<AsyncGoalState<ActionT, ResultT>>(done_callback);
+    std::weak_ptr<rclcpp_action::Client<ActionT>> weak_client = client;
+    AsyncResult<ResultT> request;
+    request.future = state->promise.get_future().share();
+    request.cancel = [state, weak_client] {
+      typename GoalHandle::SharedPtr goal_handle;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->done)
+          return;
+        state->cancel_requested = true;
+        goal_handle = state->goal_handle;
+      }
+      // if the goal is not accepted yet, it is canceled from the goal response callback
+      auto locked_client = weak_client.lock();
+      if (goal_handle && locked_client)
+        locked_client->async_cancel_goal(goal_handle);
+    };
+
+    if (!client || !client->action_server_is_ready())
     {
-      RCLCPP_INFO_STREAM(LOGGER, "MoveGroup action client/server not ready");
-      return moveit::core::MoveItErrorCode::FAILURE;
+      RCLCPP_INFO_STREAM(LOGGER, "Action client/server for " << request_name << " requests not ready");
+      state->finish(failedResult<ResultT>(moveit::core::MoveItErrorCode::FAILURE));
+      return request;
     }
-    RCLCPP_INFO_STREAM(LOGGER, "MoveGroup action client/server ready");
 
+    typename rclcpp_action::Client<ActionT>::SendGoalOptions send_goal_opts;
+    send_goal_opts.goal_response_callback = [state, weak_client,
+                                             request_name](const typename GoalHandle::SharedPtr& goal_handle) {
+      if (!goal_handle)
+      {
+        RCLCPP_INFO_STREAM(LOGGER, request_name << " request rejected");
+        state->finish(failedResult<ResultT>(moveit::core::MoveItErrorCode::FAILURE));
+        return;
+      }
+      RCLCPP_INFO_STREAM(LOGGER, request_name << " request accepted");
+
+      bool cancel_requested;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->goal_handle = goal_handle;
+        cancel_requested = state->cancel_requested;
+      }
+      auto locked_client = weak_client.lock();
+      if (cancel_requested && locked_client)
+        locked_client->async_cancel_goal(goal_handle);
+    };
+    send_goal_opts.result_callback = [state, make_result, request_name](const WrappedResult<ActionT>& result) {
+      switch (result.code)
+      {
+        case rclcpp_action::ResultCode::SUCCEEDED:
+          RCLCPP_INFO_STREAM(LOGGER, request_name << " request complete!");
+          break;
+        case rclcpp_action::ResultCode::ABORTED:
+          RCLCPP_INFO_STREAM(LOGGER, request_name << " request aborted");
+          break;
+        case rclcpp_action::ResultCode::CANCELED:
+          RCLCPP_INFO_STREAM(LOGGER, request_name << " request canceled");
+          break;
+        default:
+          RCLCPP_INFO_STREAM(LOGGER, request_name << " request unknown result code");
+          break;
+      }
+
+      if (result.result)
+        state->finish(make_result(result));
+      else
+        state->finish(failedResult<ResultT>(moveit::core::MoveItErrorCode::FAILURE));
+
+      // the goal handle owns this callback, release it to break the reference cycle
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->goal_handle.reset();
+    };
+
+    client->async_send_goal(goal, send_goal_opts);
+    return request;
+  }
+
+  AsyncResult<PlanResult> planAsync(const std::function<void(const PlanResult&)>& done_callback)
+  {
     moveit_msgs::action::MoveGroup::Goal goal;
     constructGoal(goal);
     goal.planning_options.plan_only = true;
@@ -774,64 +921,69 @@ public:
     goal.planning_options.planning_scene_diff.is_diff = true;
     goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
 
-    bool done = false;
-    rclcpp_action::ResultCode code = rclcpp_action::ResultCode::UNKNOWN;
-    std::shared_ptr<moveit_msgs::action::MoveGroup::Result> res;
-    auto send_goal_opts = rclcpp_action::Client<moveit_msgs::action::MoveGroup>::SendGoalOptions();
-
-    send_goal_opts.goal_response_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::MoveGroup>::SharedPtr& goal_handle) {
-          if (!goal_handle)
-          {
-            done = true;
-            RCLCPP_INFO(LOGGER, "Planning request rejected");
-          }
-          else
-            RCLCPP_INFO(LOGGER, "Planning request accepted");
-        };
-    send_goal_opts.result_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::MoveGroup>::WrappedResult& result) {
-          res = result.result;
-          code = result.code;
-          done = true;
-
-          switch (result.code)
+    return sendGoalAsync<moveit_msgs::action::MoveGroup, PlanResult>(
+        move_action_client_, goal, "Planning",
+        [](const WrappedResult<moveit_msgs::action::MoveGroup>& result) {
+          PlanResult plan_result;
+          plan_result.error_code = result.result->error_code;
+          plan_result.plan.planning_time = result.result->planning_time;
+          if (result.code == rclcpp_action::ResultCode::SUCCEEDED)
           {
-            case rclcpp_action::ResultCode::SUCCEEDED:
-              RCLCPP_INFO(LOGGER, "Planning request complete!");
-              break;
-            case rclcpp_action::ResultCode::ABORTED:
-              RCLCPP_INFO(LOGGER, "Planning request aborted");
-              return;
-            case rclcpp_action::ResultCode::CANCELED:
-              RCLCPP_INFO(LOGGER, "Planning request canceled");
-              return;
-            default:
-              RCLCPP_INFO(LOGGER, "Planning request unknown result code");
-              return;
+            plan_result.plan.trajectory = result.result->planned_trajectory;
+            plan_result.plan.start_state = result.result->trajectory_start;
+            RCLCPP_INFO(LOGGER, "time taken to generate plan: %g seconds", plan_result.plan.planning_time);
           }
-        };
+          return plan_result;
+        },
+        done_callback);
+  }
+
+  AsyncResult<moveit::core::MoveItErrorCode>
+  moveAsync(const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback)
+  {
+    moveit_msgs::action::MoveGroup::Goal goal;
+    constructGoal(goal);
+    goal.planning_options.plan_only = false;
+    goal.planning_options.look_around = can_look_;
+    goal.planning_options.replan = can_replan_;
+    goal.planning_options.replan_delay = replan_delay_;
+    goal.planning_options.planning_scene_diff.is_diff = true;
+    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
 
-    auto goal_handle_future = move_action_client_->async_send_goal(goal, send_goal_opts);
+    return sendGoalAsync<moveit_msgs::action::MoveGroup, moveit::core::MoveItErrorCode>(
+        move_action_client_, goal, "Plan and Execute",
+        [](const WrappedResult<moveit_msgs::action::MoveGroup>& result) {
+          return moveit::core::MoveItErrorCode(result.result->error_code);
+        },
+        done_callback);
+  }
 
-    // wait until send_goal_opts.result_callback is called
-    while (!done)
-    {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
+  AsyncResult<moveit::core::MoveItErrorCode>
+  executeAsync(const moveit_msgs::msg::RobotTrajectory& trajectory,
+               const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback)
+  {
+    moveit_msgs::action::ExecuteTrajectory::Goal goal;
+    goal.trajectory = trajectory;
 
-    if (code != rclcpp_action::ResultCode::SUCCEEDED)
+    return sendGoalAsync<moveit_msgs::action::ExecuteTrajectory, moveit::core::MoveItErrorCode>(
+        execute_action_client_, goal, "Execute",
+        [](const WrappedResult<moveit_msgs::action::ExecuteTrajectory>& result) {
+          return moveit::core::MoveItErrorCode(result.result->error_code);
+        },
+        done_callback);
+  }
+
+  moveit::core::MoveItErrorCode plan(Plan& plan)
+  {
+    const PlanResult result = planAsync({}).future.get();
+    if (!result.error_code)
     {
       RCLCPP_ERROR_STREAM(LOGGER, "MoveGroupInterface::plan() failed or timeout reached");
-      return res->error_code;
+      return result.error_code;
     }
 
-    plan.trajectory = res->planned_trajectory;
-    plan.start_state = res->trajectory_start;
-    plan.planning_time = res->planning_time;
-    RCLCPP_INFO(LOGGER, "time taken to generate plan: %g seconds", plan.planning_time);
-
-    return res->error_code;
+    plan = result.plan;
+    return result.error_code;
   }
 
   moveit::core::MoveItErrorCode move(bool wait)
@@ -842,67 +994,16 @@ public:
       return moveit::core::MoveItErrorCode::FAILURE;
     }
 
-    moveit_msgs::action::MoveGroup::Goal goal;
-    constructGoal(goal);
-    goal.planning_options.plan_only = false;
-    goal.planning_options.look_around = can_look_;
-    goal.planning_options.replan = can_replan_;
-    goal.planning_options.replan_delay = replan_delay_;
-    goal.planning_options.planning_scene_diff.is_diff = true;
-    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
-
-    bool done = false;
-    rclcpp_action::ResultCode code = rclcpp_action::ResultCode::UNKNOWN;
-    std::shared_ptr<moveit_msgs::action::MoveGroup_Result> res;
-    auto send_goal_opts = rclcpp_action::Client<moveit_msgs::action::MoveGroup>::SendGoalOptions();
-
-    send_goal_opts.goal_response_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::MoveGroup>::SharedPtr& goal_handle) {
-          if (!goal_handle)
-          {
-            done = true;
-            RCLCPP_INFO(LOGGER, "Plan and Execute request rejected");
-          }
-          else
-            RCLCPP_INFO(LOGGER, "Plan and Execute request accepted");
-        };
-    send_goal_opts.result_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::MoveGroup>::WrappedResult& result) {
-          res = result.result;
-          code = result.code;
-          done = true;
-
-          switch (result.code)
-          {
-            case rclcpp_action::ResultCode::SUCCEEDED:
-              RCLCPP_INFO(LOGGER, "Plan and Execute request complete!");
-              break;
-            case rclcpp_action::ResultCode::ABORTED:
-              RCLCPP_INFO(LOGGER, "Plan and Execute request aborted");
-              return;
-            case rclcpp_action::ResultCode::CANCELED:
-              RCLCPP_INFO(LOGGER, "Plan and Execute request canceled");
-              return;
-            default:
-              RCLCPP_INFO(LOGGER, "Plan and Execute request unknown result code");
-              return;
-          }
-        };
-    auto goal_handle_future = move_action_client_->async_send_goal(goal, send_goal_opts);
+    const AsyncResult<moveit::core::MoveItErrorCode> request = moveAsync({});
     if (!wait)
       return moveit::core::MoveItErrorCode::SUCCESS;
 
-    // wait until send_goal_opts.result_callback is called
-    while (!done)
-    {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-
-    if (code != rclcpp_action::ResultCode::SUCCEEDED)
+    const moveit::core::MoveItErrorCode error_code = request.future.get();
+    if (!error_code)
     {
       RCLCPP_ERROR_STREAM(LOGGER, "MoveGroupInterface::move() failed or timeout reached");
     }
-    return res->error_code;
+    return error_code;
   }
 
   moveit::core::MoveItErrorCode execute(const moveit_msgs::msg::RobotTrajectory& trajectory, bool wait)
@@ -913,71 +1014,24 @@ public:
       return moveit::core::MoveItErrorCode::FAILURE;
     }
 
-    bool done = false;
-    rclcpp_action::ResultCode code = rclcpp_action::ResultCode::UNKNOWN;
-    std::shared_ptr<moveit_msgs::action::ExecuteTrajectory_Result> res;
-    auto send_goal_opts = rclcpp_action::Client<moveit_msgs::action::ExecuteTrajectory>::SendGoalOptions();
-
-    send_goal_opts.goal_response_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::ExecuteTrajectory>::SharedPtr& goal_handle) {
-          if (!goal_handle)
-          {
-            done = true;
-            RCLCPP_INFO(LOGGER, "Execute request rejected");
-          }
-          else
-            RCLCPP_INFO(LOGGER, "Execute request accepted");
-        };
-    send_goal_opts.result_callback =
-        [&](const rclcpp_action::ClientGoalHandle<moveit_msgs::action::ExecuteTrajectory>::WrappedResult& result) {
-          res = result.result;
-          code = result.code;
-          done = true;
-
-          switch (result.code)
-          {
-            case rclcpp_action::ResultCode::SUCCEEDED:
-              RCLCPP_INFO(LOGGER, "Execute request success!");
-              break;
-            case rclcpp_action::ResultCode::ABORTED:
-              RCLCPP_INFO(LOGGER, "Execute request aborted");
-              return;
-            case rclcpp_action::ResultCode::CANCELED:
-              RCLCPP_INFO(LOGGER, "Execute request canceled");
-              return;
-            default:
-              RCLCPP_INFO(LOGGER, "Execute request unknown result code");
-              return;
-          }
-        };
-
-    moveit_msgs::action::ExecuteTrajectory::Goal goal;
-    goal.trajectory = trajectory;
-
-    auto goal_handle_future = execute_action_client_->async_send_goal(goal, send_goal_opts);
+    const AsyncResult<moveit::core::MoveItErrorCode> request = executeAsync(trajectory, {});
     if (!wait)
       return moveit::core::MoveItErrorCode::SUCCESS;
 
-    // wait until send_goal_opts.result_callback is called
-    while (!done)
-    {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-
-    if (code != rclcpp_action::ResultCode::SUCCEEDED)
+    const moveit::core::MoveItErrorCode error_code = request.future.get();
+    if (!error_code)
     {
       RCLCPP_ERROR_STREAM(LOGGER, "MoveGroupInterface::execute() failed or timeout reached");
     }
-    return res->error_code;
+    return error_code;
   }
 
-  double computeCartesianPath(const std::vector<geometry_msgs::msg::Pose>& waypoints, double step,
-                              double jump_threshold, moveit_msgs::msg::RobotTrajectory& msg,
-                              const moveit_msgs::msg::Constraints& path_constraints, bool avoid_collisions,
-                              moveit_msgs::msg::MoveItErrorCodes& error_code)
+  AsyncResult<CartesianPathResult>
+  computeCartesianPathAsync(const std::vector<geometry_msgs::msg::Pose>& waypoints, double step, double jump_threshold,
+                            const moveit_msgs::msg::Constraints& path_constraints, bool avoid_collisions,
+                            const std::function<void(const CartesianPathResult&)>& done_callback)
   {
     auto req = std::make_shared<moveit_msgs::srv::GetCartesianPath::Request>();
-    moveit_msgs::srv::GetCartesianPath::Response::SharedPtr response;
 
     if (considered_start_state_)
     {
@@ -1000,24 +1054,40 @@ public:
     req->max_velocity_scaling_factor = max_velocity_scaling_factor_;
     req->max_acceleration_scaling_factor = max_acceleration_scaling_factor_;
 
-    auto future_response = cartesian_path_service_->async_send_request(req);
-    if (future_response.valid())
-    {
-      response = future_response.get();
-      error_code = response->error_code;
-      if (response->error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
-      {
-        msg = response->solution;
-        return response->fraction;
-      }
-      else
-        return -1.0;
-    }
-    else
-    {
-      error_code.val = error_code.FAILURE;
-      return -1.0;
-    }
+    auto state = std::make_shared<AsyncRequestState<CartesianPathResult>>(done_callback);
+    AsyncResult<CartesianPathResult> request;
+    request.future = state->promise.get_future().share();
+    // services cannot be canceled, a late response is ignored by finish()
+    request.cancel = [state] {
+      state->finish(failedResult<CartesianPathResult>(moveit::core::MoveItErrorCode::PREEMPTED));
+    };
+
+    cartesian_path_service_->async_send_request(
+        req, [state](rclcpp::Client<moveit_msgs::srv::GetCartesianPath>::SharedFuture future) {
+          const auto response = future.get();
+          CartesianPathResult result;
+          result.error_code = response->error_code;
+          if (result.error_code)
+          {
+            result.trajectory = response->solution;
+            result.fraction = response->fraction;
+          }
+          state->finish(result);
+        });
+    return request;
+  }
+
+  double computeCartesianPath(const std::vector<geometry_msgs::msg::Pose>& waypoints, double step,
+                              double jump_threshold, moveit_msgs::msg::RobotTrajectory& msg,
+                              const moveit_msgs::msg::Constraints& path_constraints, bool avoid_collisions,
+                              moveit_msgs::msg::MoveItErrorCodes& error_code)
+  {
+    const CartesianPathResult result =
+        computeCartesianPathAsync(waypoints, step, jump_threshold, path_constraints, avoid_collisions, {}).future.get();
+    error_code = result.error_code;
+    if (result.error_code)
+      msg = result.trajectory;
+    return result.fraction;
   }
 
   void stop()
@@ -1602,6 +1672,32 @@ moveit::core::MoveItErrorCode MoveGroupInterface::plan(Plan& plan)
   return impl_->plan(plan);
 }
 
+MoveGroupInterface::AsyncResult<MoveGroupInterface::PlanResult>
+MoveGroupInterface::planAsync(const std::function<void(const PlanResult&)>& done_callback)
+{
+  return impl_->planAsync(done_callback);
+}
+
+MoveGroupInterface::AsyncResult<moveit::core::MoveItErrorCode>
+MoveGroupInterface::moveAsync(const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback)
+{
+  return impl_->moveAsync(done_callback);
+}
+
+MoveGroupInterface::AsyncResult<moveit::core::MoveItErrorCode>
+MoveGroupInterface::executeAsync(const Plan& plan,
+                                 const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback)
+{
+  return impl_->executeAsync(plan.trajectory, done_callback);
+}
+
+MoveGroupInterface::AsyncResult<moveit::core::MoveItErrorCode>
+MoveGroupInterface::executeAsync(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                                 const std::function<void(const moveit::core::MoveItErrorCode&)>& done_callback)
+{
+  return impl_->executeAsync(trajectory, done_callback);
+}
+
 // moveit_msgs::action::Pickup::Goal MoveGroupInterface::constructPickupGoal(const std::string& object,
 //                                                                        std::vector<moveit_msgs::msg::Grasp> grasps,
 //                                                                        bool plan_only = false) const
@@ -1671,6 +1767,17 @@ double MoveGroupInterface::computeCartesianPath(const std::vector<geometry_msgs:
   }
 }
 
+MoveGroupInterface::AsyncResult<MoveGroupInterface::CartesianPathResult>
+MoveGroupInterface::computeCartesianPathAsync(const std::vector<geometry_msgs::msg::Pose>& waypoints, double eef_step,
+                                              double jump_threshold,
+                                              const moveit_msgs::msg::Constraints& path_constraints,
+                                              bool avoid_collisions,
+                                              const std::function<void(const CartesianPathResult&)>& done_callback)
+{
+  return impl_->computeCartesianPathAsync(waypoints, eef_step, jump_threshold, path_constraints, avoid_collisions,
+                                          done_callback);
+}
+
 void MoveGroupInterface::stop()
 {
   impl_->stop();
@@ -60,11 +60,15 @@ struct KinematicOptions
     LOCK_REDUNDANT_JOINTS = 0x00000004,        // options_.lock_redundant_joints
     RETURN_APPROXIMATE_SOLUTION = 0x00000008,  // options_.return_approximate_solution
     DISCRETIZATION_METHOD = 0x00000010,
+    MAX_JACOBIAN_STEP = 0x00000020,  // max_jacobian_step_
     ALL_QUERY_OPTIONS = LOCK_REDUNDANT_JOINTS | RETURN_APPROXIMATE_SOLUTION | DISCRETIZATION_METHOD,
     ALL = 0x7fffffff
   };
 
   /// Set \e state using inverse kinematics
+  /// If the tip moves less than max_jacobian_step_, a few damped least-squares
+  /// Jacobian steps are tried first and the IK solver is only called if they
+  /// do not converge.
   /// @param state the state to set
   /// @param group name of group whose joints can move
   /// @param tip link that will be posed
@@ -84,6 +88,10 @@ struct KinematicOptions
   /// This is called to determine if the state is valid
   moveit::core::GroupStateValidityCallbackFn state_validity_callback_;
 
+  /// max distance (m) the tip may move for the Jacobian step to be tried
+  /// before IK. 0 disables the Jacobian step. Defaults to 0.01.
+  double max_jacobian_step_;
+
   /// other options
   kinematics::KinematicsQueryOptions options_;
 };
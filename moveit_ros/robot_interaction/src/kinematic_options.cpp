@@ -36,10 +36,75 @@
 
 #include <moveit/robot_interaction/kinematic_options.h>
 #include <rclcpp/logging.hpp>
+#include <tf2_eigen/tf2_eigen.hpp>
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros_robot_interaction.kinematic_options");
 
-robot_interaction::KinematicOptions::KinematicOptions() : timeout_seconds_(0.0)  // 0.0 = use default timeout
+namespace
+{
+constexpr int JACOBIAN_STEP_ITERATIONS = 5;
+constexpr double JACOBIAN_STEP_DAMPING = 1e-3;
+constexpr double JACOBIAN_STEP_POSITION_TOLERANCE = 1e-4;
+constexpr double JACOBIAN_STEP_ORIENTATION_TOLERANCE = 1e-3;
+
+// Move the tip of a chain group to a nearby target with a few damped least-squares steps.
+// Returns false, leaving state untouched, if the target is too far away or the steps do not converge.
+bool setStateFromJacobian(moveit::core::RobotState& state, const moveit::core::JointModelGroup* jmg,
+                          const moveit::core::LinkModel* tip, const Eigen::Isometry3d& target, double max_step,
+                          const moveit::core::GroupStateValidityCallbackFn& validity_callback)
+{
+  state.updateLinkTransforms();
+  if ((target.translation() - state.getGlobalLinkTransform(tip).translation()).norm() > max_step)
+    return false;
+
+  // the Jacobian is expressed in the frame of the parent link of the group's root joint
+  const moveit::core::LinkModel* root_link = jmg->getJointModels()[0]->getParentLinkModel();
+
+  moveit::core::RobotState candidate(state);
+  Eigen::MatrixXd jacobian;
+  Eigen::VectorXd values;
+  for (int i = 0; i < JACOBIAN_STEP_ITERATIONS; ++i)
+  {
+    candidate.updateLinkTransforms();
+    const Eigen::Isometry3d& current = candidate.getGlobalLinkTransform(tip);
+    Eigen::Matrix<double, 6, 1> error;
+    error.head<3>() = target.translation() - current.translation();
+    const Eigen::AngleAxisd rotation_error(target.linear() * current.linear().transpose());
+    error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+
+    if (error.head<3>().norm() < JACOBIAN_STEP_POSITION_TOLERANCE &&
+        error.tail<3>().norm() < JACOBIAN_STEP_ORIENTATION_TOLERANCE)
+    {
+      candidate.copyJointGroupPositions(jmg, values);
+      if (validity_callback && !validity_callback(&candidate, jmg, values.data()))
+        return false;
+      state = candidate;
+      return true;
+    }
+
+    if (!candidate.getJacobian(jmg, tip, Eigen::Vector3d::Zero(), jacobian))
+      return false;
+    if (root_link)
+    {
+      const Eigen::Matrix3d root_rotation = candidate.getGlobalLinkTransform(root_link).linear().transpose();
+      error.head<3>() = root_rotation * error.head<3>();
+      error.tail<3>() = root_rotation * error.tail<3>();
+    }
+
+    const Eigen::MatrixXd damped = jacobian * jacobian.transpose() +
+                                   JACOBIAN_STEP_DAMPING * JACOBIAN_STEP_DAMPING * Eigen::MatrixXd::Identity(6, 6);
+    candidate.copyJointGroupPositions(jmg, values);
+    values += jacobian.transpose() * damped.ldlt().solve(error);
+    candidate.setJointGroupPositions(jmg, values);
+    candidate.enforceBounds(jmg);
+  }
+  return false;
+}
+}  // namespace
+
+robot_interaction::KinematicOptions::KinematicOptions()
+  : timeout_seconds_(0.0)  // 0.0 = use default timeout
+  , max_jacobian_step_(0.01)
 {
 }
 
@@ -55,6 +120,21 @@ bool robot_interaction::KinematicOptions::setStateFromIK(moveit::core::RobotStat
     RCLCPP_ERROR(LOGGER, "No getJointModelGroup('%s') found", group.c_str());
     return false;
   }
+
+  // Small marker moves are usually solved by a few Jacobian steps, which is much cheaper than a full IK query.
+  // Redundant joints cannot be locked that way, so leave those requests to the solver.
+  if (max_jacobian_step_ > 0.0 && jmg->isChain() && !options_.lock_redundant_joints && jmg->hasLinkModel(tip))
+  {
+    const moveit::core::LinkModel* tip_link = jmg->getLinkModel(tip);
+    Eigen::Isometry3d target;
+    tf2::fromMsg(pose, target);
+    if (setStateFromJacobian(state, jmg, tip_link, target, max_jacobian_step_, state_validity_callback_))
+    {
+      state.update();
+      return true;
+    }
+  }
+
   bool result = state.setFromIK(jmg, pose, tip,
                                 // limit timeout to 0.1s if set from JMG's default, i.e. when timeout_seconds_ == 0
                                 timeout_seconds_ > 0.0 ? timeout_seconds_ : std::min(0.1, jmg->getDefaultIKTimeout()),
@@ -74,7 +154,8 @@ void robot_interaction::KinematicOptions::setOptions(const KinematicOptions& sou
 // robot_interaction::KinematicOptions except options_
 #define O_FIELDS(F)                                                                                                    \
   F(double, timeout_seconds_, TIMEOUT)                                                                                 \
-  F(moveit::core::GroupStateValidityCallbackFn, state_validity_callback_, STATE_VALIDITY_CALLBACK)
+  F(moveit::core::GroupStateValidityCallbackFn, state_validity_callback_, STATE_VALIDITY_CALLBACK)                    \
+  F(double, max_jacobian_step_, MAX_JACOBIAN_STEP)
 
 // This needs to represent all the fields in
 // kinematics::KinematicsQueryOptions
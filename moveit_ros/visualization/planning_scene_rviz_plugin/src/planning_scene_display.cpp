@@ -64,7 +64,7 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_ros_visualizatio
 // Base class constructor
 // ******************************************************************************************
 PlanningSceneDisplay::PlanningSceneDisplay(bool listen_to_planning_scene, bool show_scene_robot)
-  : Display(), planning_scene_needs_render_(true), current_scene_time_(0.0f)
+  : Display(), planning_scene_needs_render_(true), robot_state_needs_render_(false), current_scene_time_(0.0f)
 {
   move_group_ns_property_ = new rviz_common::properties::StringProperty("Move Group Namespace", "",
                                                                         "The name of the ROS namespace in "
@@ -605,12 +605,16 @@ void PlanningSceneDisplay::sceneMonitorReceivedUpdate(
 }
 
 void PlanningSceneDisplay::onSceneMonitorReceivedUpdate(
-    planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType /*update_type*/)
+    planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type)
 {
   getPlanningSceneRW()->getCurrentStateNonConst().update();
   QMetaObject::invokeMethod(this, "setSceneName", Qt::QueuedConnection,
                             Q_ARG(QString, QString::fromStdString(getPlanningSceneRO()->getName())));
-  planning_scene_needs_render_ = true;
+  // joint state updates only move the robot's links, which does not require rendering the scene geometry again
+  if (update_type == planning_scene_monitor::PlanningSceneMonitor::UPDATE_STATE)
+    robot_state_needs_render_ = true;
+  else
+    planning_scene_needs_render_ = true;
 }
 
 void PlanningSceneDisplay::setSceneName(const QString& name)
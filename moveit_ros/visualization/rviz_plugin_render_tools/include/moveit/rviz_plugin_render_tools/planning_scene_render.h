@@ -41,6 +41,9 @@
 #include <moveit/rviz_plugin_render_tools/render_shapes.h>
 #include <rviz_common/properties/color_property.hpp>
 #include <OgreMaterial.h>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace moveit_rviz_plugin
 {
@@ -67,6 +70,11 @@ public:
 
   void updateRobotPosition(const planning_scene::PlanningSceneConstPtr& scene);
 
+  /** \brief Render the robot and the world objects of \e scene.
+   *
+   *  The rendering of world objects is kept between calls: objects that only moved are repositioned, and only
+   *  objects whose shapes, shape poses or colors changed are rendered again. Octrees are always rendered again,
+   *  because their content can change without notice. */
   void renderPlanningScene(const planning_scene::PlanningSceneConstPtr& scene,
                            const Ogre::ColourValue& default_scene_color,
                            const Ogre::ColourValue& default_attached_color, OctreeVoxelRenderMode voxel_render_mode,
@@ -74,9 +82,26 @@ public:
   void clear();
 
 private:
+  /** \brief The rendering of a world object, placed at the object's pose */
+  struct RenderedObject
+  {
+    Ogre::SceneNode* node;
+    RenderShapesPtr render_shapes;
+    std::vector<shapes::ShapeConstPtr> shapes;
+    EigenSTL::vector_Isometry3d shape_poses;
+    Ogre::ColourValue color;
+    float alpha;
+    bool has_octree;
+  };
+
+  void destroyRenderedObject(RenderedObject& rendered);
+
   Ogre::SceneNode* planning_scene_geometry_node_;
   rviz_common::DisplayContext* context_;
-  RenderShapesPtr render_shapes_;
   RobotStateVisualizationPtr scene_robot_;
+
+  std::map<std::string, RenderedObject> rendered_objects_;
+  OctreeVoxelRenderMode octree_voxel_rendering_;
+  OctreeVoxelColorMode octree_color_mode_;
 };
 }  // namespace moveit_rviz_plugin
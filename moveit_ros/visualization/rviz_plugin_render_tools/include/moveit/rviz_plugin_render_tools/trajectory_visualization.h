@@ -135,6 +135,14 @@ protected:
   float getStateDisplayTime();
   void clearTrajectoryTrail();
 
+  /**
+   * \brief Create or update the robots of the trail that are not shown yet.
+   *
+   * Only a bounded number of robots is prepared per call, so that long trails are built over several frames
+   * instead of blocking the render thread.
+   */
+  void prepareTrajectoryTrail();
+
   // Handles actually drawing the robot along motion plans
   RobotStateVisualizationPtr display_path_robot_;
   std_msgs::msg::ColorRGBA default_attached_object_color_;
@@ -145,7 +153,12 @@ protected:
 
   robot_trajectory::RobotTrajectoryPtr displaying_trajectory_message_;
   robot_trajectory::RobotTrajectoryPtr trajectory_message_to_display_;
+  // Pool of trail robots, which is reused between trajectories. The first trail_prepared_ robots show the
+  // waypoints trail_waypoints_ of trail_trajectory_, all others are hidden.
   std::vector<RobotStateVisualizationUniquePtr> trajectory_trail_;
+  robot_trajectory::RobotTrajectoryPtr trail_trajectory_;
+  std::vector<int> trail_waypoints_;
+  std::size_t trail_prepared_;
   rclcpp::Subscription<moveit_msgs::msg::DisplayTrajectory>::SharedPtr trajectory_topic_sub_;
   bool animating_path_;
   bool drop_displaying_trajectory_;
@@ -178,6 +191,7 @@ protected:
   rviz_common::properties::ColorProperty* robot_color_property_;
   rviz_common::properties::BoolProperty* enable_robot_color_property_;
   rviz_common::properties::IntProperty* trail_step_size_property_;
+  rviz_common::properties::FloatProperty* trail_resolution_property_;
 };
 
 }  // namespace moveit_rviz_plugin
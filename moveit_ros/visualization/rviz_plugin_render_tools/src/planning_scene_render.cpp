@@ -38,21 +38,28 @@
 #include <moveit/rviz_plugin_render_tools/robot_state_visualization.h>
 #include <moveit/rviz_plugin_render_tools/render_shapes.h>
 #include <rviz_common/display_context.hpp>
+#include <geometric_shapes/check_isometry.h>
 
 #include <OgreSceneNode.h>
 #include <OgreSceneManager.h>
 
+#include <algorithm>
+
 namespace moveit_rviz_plugin
 {
 PlanningSceneRender::PlanningSceneRender(Ogre::SceneNode* node, rviz_common::DisplayContext* context,
                                          const RobotStateVisualizationPtr& robot)
-  : planning_scene_geometry_node_(node->createChildSceneNode()), context_(context), scene_robot_(robot)
+  : planning_scene_geometry_node_(node->createChildSceneNode())
+  , context_(context)
+  , scene_robot_(robot)
+  , octree_voxel_rendering_(OCTOMAP_DISABLED)
+  , octree_color_mode_(OCTOMAP_Z_AXIS_COLOR)
 {
-  render_shapes_ = std::make_shared<RenderShapes>(context);
 }
 
 PlanningSceneRender::~PlanningSceneRender()
 {
+  clear();
   context_->getSceneManager()->destroySceneNode(planning_scene_geometry_node_);
 }
 
@@ -68,7 +75,17 @@ void PlanningSceneRender::updateRobotPosition(const planning_scene::PlanningScen
 
 void PlanningSceneRender::clear()
 {
-  render_shapes_->clear();
+  for (auto& [id, rendered] : rendered_objects_)
+    destroyRenderedObject(rendered);
+  rendered_objects_.clear();
+}
+
+void PlanningSceneRender::destroyRenderedObject(RenderedObject& rendered)
+{
+  // the shapes hold child nodes of the object's node, destroy them first
+  rendered.render_shapes.reset();
+  context_->getSceneManager()->destroySceneNode(rendered.node);
+  rendered.node = nullptr;
 }
 
 void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningSceneConstPtr& scene,
@@ -80,7 +97,12 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
   if (!scene)
     return;
 
-  clear();
+  if (octree_voxel_rendering != octree_voxel_rendering_ || octree_color_mode != octree_color_mode_)
+  {
+    clear();
+    octree_voxel_rendering_ = octree_voxel_rendering;
+    octree_color_mode_ = octree_color_mode;
+  }
 
   if (scene_robot_)
   {
@@ -97,10 +119,23 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
     scene_robot_->update(moveit::core::RobotStateConstPtr(rs), color, color_map);
   }
 
-  const std::vector<std::string>& ids = scene->getWorld()->getObjectIds();
-  for (const std::string& id : ids)
+  const collision_detection::WorldConstPtr& world = scene->getWorld();
+  // forget objects that were removed from the world
+  for (auto it = rendered_objects_.begin(); it != rendered_objects_.end();)
+  {
+    if (world->hasObject(it->first))
+    {
+      ++it;
+    }
+    else
+    {
+      destroyRenderedObject(it->second);
+      it = rendered_objects_.erase(it);
+    }
+  }
+
+  for (const auto& [id, object] : *world)
   {
-    collision_detection::CollisionEnv::ObjectConstPtr object = scene->getWorld()->getObject(id);
     Ogre::ColourValue color = default_env_color;
     float alpha = default_scene_alpha;
     if (scene->hasObjectColor(id))
@@ -111,12 +146,42 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
       color.b = c.b;
       alpha = c.a;
     }
-    for (std::size_t j = 0; j < object->shapes_.size(); ++j)
+
+    auto it = rendered_objects_.find(id);
+    if (it == rendered_objects_.end())
     {
-      render_shapes_->renderShape(planning_scene_geometry_node_, object->shapes_[j].get(),
-                                  object->global_shape_poses_[j], octree_voxel_rendering, octree_color_mode, color,
-                                  alpha);
+      RenderedObject rendered;
+      rendered.node = planning_scene_geometry_node_->createChildSceneNode();
+      it = rendered_objects_.emplace(id, std::move(rendered)).first;
     }
+    RenderedObject& rendered = it->second;
+
+    // only render the shapes again if they changed, otherwise it is sufficient to move the object's node
+    if (!rendered.render_shapes || rendered.has_octree || rendered.shapes != object->shapes_ ||
+        rendered.color != color || rendered.alpha != alpha ||
+        !std::equal(rendered.shape_poses.begin(), rendered.shape_poses.end(), object->shape_poses_.begin(),
+                    object->shape_poses_.end(),
+                    [](const Eigen::Isometry3d& a, const Eigen::Isometry3d& b) { return a.matrix() == b.matrix(); }))
+    {
+      rendered.render_shapes = std::make_shared<RenderShapes>(context_);
+      rendered.shapes = object->shapes_;
+      rendered.shape_poses = object->shape_poses_;
+      rendered.color = color;
+      rendered.alpha = alpha;
+      rendered.has_octree = false;
+      for (std::size_t j = 0; j < object->shapes_.size(); ++j)
+      {
+        rendered.render_shapes->renderShape(rendered.node, object->shapes_[j].get(), object->shape_poses_[j],
+                                            octree_voxel_rendering, octree_color_mode, color, alpha);
+        rendered.has_octree |= object->shapes_[j]->type == shapes::OCTREE;
+      }
+    }
+
+    const Eigen::Isometry3d& pose = object->pose_;
+    ASSERT_ISOMETRY(pose)  // unsanitized input, could contain a non-isometry
+    const Eigen::Quaterniond q(pose.linear());
+    rendered.node->setPosition(Ogre::Vector3(pose.translation().x(), pose.translation().y(), pose.translation().z()));
+    rendered.node->setOrientation(Ogre::Quaternion(q.w(), q.x(), q.y(), q.z()));
   }
 }
 }  // namespace moveit_rviz_plugin
@@ -64,10 +64,57 @@ namespace moveit_rviz_plugin
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_rviz_plugin_render_tools.trajectory_visualization");
 
+namespace
+{
+// Maximum number of trail robots that are created or updated per frame
+constexpr std::size_t TRAIL_ROBOTS_PER_UPDATE = 16;
+
+// Select every step-th waypoint and the last one. If resolution is positive, waypoints are skipped unless a link
+// moved by more than resolution since the previously selected waypoint.
+std::vector<int> selectTrailWayPoints(const robot_trajectory::RobotTrajectory& trajectory, int step, double resolution)
+{
+  std::vector<int> waypoints;
+  const int count = static_cast<int>(trajectory.getWayPointCount());
+  if (count == 0)
+    return waypoints;
+
+  const std::vector<const moveit::core::LinkModel*>& links =
+      trajectory.getRobotModel()->getLinkModelsWithCollisionGeometry();
+  moveit::core::RobotState state(trajectory.getRobotModel());
+  std::vector<Eigen::Vector3d> selected_positions;
+
+  auto select = [&](int waypoint) {
+    if (resolution > 0.0)
+    {
+      state.setVariablePositions(trajectory.getWayPoint(waypoint).getVariablePositions());
+      state.update();
+
+      bool moved = selected_positions.empty() || waypoint == count - 1;
+      for (std::size_t l = 0; l < links.size() && !moved; ++l)
+        moved = (state.getGlobalLinkTransform(links[l]).translation() - selected_positions[l]).norm() > resolution;
+      if (!moved)
+        return;
+
+      selected_positions.clear();
+      for (const moveit::core::LinkModel* link : links)
+        selected_positions.push_back(state.getGlobalLinkTransform(link).translation());
+    }
+    waypoints.push_back(waypoint);
+  };
+
+  for (int i = 0; i < count; i += step)
+    select(i);
+  if (waypoints.back() != count - 1)  // always include last trajectory point
+    select(count - 1);
+  return waypoints;
+}
+}  // namespace
+
 TrajectoryVisualization::TrajectoryVisualization(rviz_common::properties::Property* widget,
                                                  rviz_common::Display* display)
   : animating_path_(false)
   , drop_displaying_trajectory_(false)
+  , trail_prepared_(0)
   , current_state_(-1)
   , display_(display)
   , widget_(widget)
@@ -127,6 +174,13 @@ TrajectoryVisualization::TrajectoryVisualization(rviz_common::properties::Proper
                                                                        widget, SLOT(changedTrailStepSize()), this);
   trail_step_size_property_->setMin(1);
 
+  trail_resolution_property_ = new rviz_common::properties::FloatProperty(
+      "Trail Resolution", 0.0f,
+      "Minimum distance (m) a link has to move between two robots shown in the trajectory trail. "
+      "Use it to thin out long trails, 0 shows all samples.",
+      widget, SLOT(changedTrailStepSize()), this);
+  trail_resolution_property_->setMin(0.0);
+
   interrupt_display_property_ = new rviz_common::properties::BoolProperty(
       "Interrupt Display", false,
       "Immediately show newly planned trajectory, interrupting the currently displayed one.", widget);
@@ -141,6 +195,7 @@ TrajectoryVisualization::TrajectoryVisualization(rviz_common::properties::Proper
 TrajectoryVisualization::~TrajectoryVisualization()
 {
   clearTrajectoryTrail();
+  trajectory_trail_.clear();
   trajectory_message_to_display_.reset();
   displaying_trajectory_message_.reset();
 
@@ -211,6 +266,9 @@ void TrajectoryVisualization::onRobotModelLoaded(const moveit::core::RobotModelC
 
   // Load rviz robot
   display_path_robot_->load(*robot_model_->getURDF());
+  // trail robots of the previous model cannot be reused
+  clearTrajectoryTrail();
+  trajectory_trail_.clear();
   enabledRobotColor();  // force-refresh to account for saved display configuration
   // perform post-poned subscription to trajectory topic
   // Check if topic name is empty
@@ -232,7 +290,11 @@ void TrajectoryVisualization::reset()
 
 void TrajectoryVisualization::clearTrajectoryTrail()
 {
-  trajectory_trail_.clear();
+  for (std::size_t i = 0; i < trail_prepared_; ++i)
+    trajectory_trail_[i]->setVisible(false);
+  trail_prepared_ = 0;
+  trail_waypoints_.clear();
+  trail_trajectory_.reset();
 }
 
 void TrajectoryVisualization::changedLoopDisplay()
@@ -254,24 +316,36 @@ void TrajectoryVisualization::changedShowTrail()
   if (!t)
     return;
 
-  int stepsize = trail_step_size_property_->getInt();
-  // always include last trajectory point
-  trajectory_trail_.resize(
-      static_cast<int>(std::ceil((t->getWayPointCount() + stepsize - 1) / static_cast<float>(stepsize))));
-  for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
+  trail_trajectory_ = t;
+  trail_waypoints_ =
+      selectTrailWayPoints(*t, trail_step_size_property_->getInt(), trail_resolution_property_->getFloat());
+  prepareTrajectoryTrail();
+}
+
+void TrajectoryVisualization::prepareTrajectoryTrail()
+{
+  const std::size_t end = std::min(trail_waypoints_.size(), trail_prepared_ + TRAIL_ROBOTS_PER_UPDATE);
+  for (; trail_prepared_ < end; ++trail_prepared_)
   {
-    int waypoint_i = std::min(i * stepsize, t->getWayPointCount() - 1);  // limit to last trajectory point
-    auto r =
-        std::make_unique<RobotStateVisualization>(scene_node_, context_, "Trail Robot " + std::to_string(i), nullptr);
-    r->load(*robot_model_->getURDF());
-    r->setVisualVisible(display_path_visual_enabled_property_->getBool());
-    r->setCollisionVisible(display_path_collision_enabled_property_->getBool());
-    r->setAlpha(robot_path_alpha_property_->getFloat());
-    r->update(t->getWayPointPtr(waypoint_i), default_attached_object_color_);
+    if (trail_prepared_ == trajectory_trail_.size())
+    {
+      auto r = std::make_unique<RobotStateVisualization>(scene_node_, context_,
+                                                         "Trail Robot " + std::to_string(trail_prepared_), nullptr);
+      r->load(*robot_model_->getURDF());
+      r->setVisualVisible(display_path_visual_enabled_property_->getBool());
+      r->setCollisionVisible(display_path_collision_enabled_property_->getBool());
+      r->setAlpha(robot_path_alpha_property_->getFloat());
+      trajectory_trail_.push_back(std::move(r));
+    }
+
+    const RobotStateVisualizationUniquePtr& r = trajectory_trail_[trail_prepared_];
+    const int waypoint_i = trail_waypoints_[trail_prepared_];
+    r->update(trail_trajectory_->getWayPointPtr(waypoint_i), default_attached_object_color_);
     if (enable_robot_color_property_->getBool())
       setRobotColor(&(r->getRobot()), robot_color_property_->getColor());
+    else
+      unsetRobotColor(&(r->getRobot()));
     r->setVisible(display_->isEnabled() && (!animating_path_ || waypoint_i <= current_state_));
-    trajectory_trail_[i] = std::move(r);
   }
 }
 
@@ -334,11 +408,11 @@ void TrajectoryVisualization::onEnable()
   display_path_robot_->setVisualVisible(display_path_visual_enabled_property_->getBool());
   display_path_robot_->setCollisionVisible(display_path_collision_enabled_property_->getBool());
   display_path_robot_->setVisible(displaying_trajectory_message_ && animating_path_);
-  for (const RobotStateVisualizationUniquePtr& r : trajectory_trail_)
+  for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
   {
-    r->setVisualVisible(display_path_visual_enabled_property_->getBool());
-    r->setCollisionVisible(display_path_collision_enabled_property_->getBool());
-    r->setVisible(true);
+    trajectory_trail_[i]->setVisualVisible(display_path_visual_enabled_property_->getBool());
+    trajectory_trail_[i]->setCollisionVisible(display_path_collision_enabled_property_->getBool());
+    trajectory_trail_[i]->setVisible(i < trail_prepared_);
   }
 
   changedTrajectoryTopic();  // load topic at startup if default used
@@ -425,6 +499,9 @@ void TrajectoryVisualization::update(float wall_dt, float sim_dt)
     trajectory_slider_panel_->update(0);
     drop_displaying_trajectory_ = false;
   }
+  // continue building a trail that was too long for a single frame
+  prepareTrajectoryTrail();
+
   if (!animating_path_)
   {  // finished last animation?
     std::scoped_lock lock(update_trajectory_message_);
@@ -519,11 +596,8 @@ void TrajectoryVisualization::update(float wall_dt, float sim_dt)
       if (trajectory_slider_panel_)
         trajectory_slider_panel_->setSliderPosition(current_state_);
       display_path_robot_->update(displaying_trajectory_message_->getWayPointPtr(current_state_));
-      for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
-      {
-        trajectory_trail_[i]->setVisible(
-            std::min(waypoint_count - 1, static_cast<int>(i) * trail_step_size_property_->getInt()) <= current_state_);
-      }
+      for (std::size_t i = 0; i < trail_prepared_; ++i)
+        trajectory_trail_[i]->setVisible(trail_waypoints_[i] <= current_state_);
     }
     else
     {
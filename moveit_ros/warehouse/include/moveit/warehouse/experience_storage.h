@@ -0,0 +1,82 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/warehouse/moveit_message_storage.h>
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace moveit_warehouse
+{
+typedef warehouse_ros::MessageWithMetadata<moveit_msgs::msg::RobotTrajectory>::ConstPtr ExperienceWithMetadata;
+typedef warehouse_ros::MessageCollection<moveit_msgs::msg::RobotTrajectory>::Ptr ExperienceCollection;
+
+MOVEIT_CLASS_FORWARD(ExperienceStorage);  // Defines ExperienceStoragePtr, ConstPtr, WeakPtr... etc
+
+/** \brief Storage of previously planned paths that planners can recall for similar planning requests */
+class ExperienceStorage : public MoveItMessageStorage
+{
+public:
+  static const std::string DATABASE_NAME;
+
+  static const std::string EXPERIENCE_ID_NAME;
+  static const std::string EXPERIENCE_GROUP_NAME;
+  static const std::string ROBOT_NAME;
+
+  ExperienceStorage(warehouse_ros::DatabaseConnection::Ptr conn);
+
+  /** \brief Store the path \e msg that was planned for \e group of \e robot as \e name, replacing the stored path
+   * of that name */
+  void addExperience(const moveit_msgs::msg::RobotTrajectory& msg, const std::string& name,
+                     const std::string& robot = "", const std::string& group = "");
+
+  /** \brief Remove the stored path \e name of \e robot and \e group */
+  void removeExperience(const std::string& name, const std::string& robot = "", const std::string& group = "");
+
+  /** \brief Get all stored paths of \e robot and \e group; empty names match all robots and groups */
+  void getExperiences(std::vector<ExperienceWithMetadata>& experiences, const std::string& robot = "",
+                      const std::string& group = "") const;
+
+  /** \brief Remove all stored paths of \e robot and \e group; empty names match all robots and groups */
+  void removeExperiences(const std::string& robot = "", const std::string& group = "");
+
+  void reset();
+
+private:
+  void createCollections();
+
+  ExperienceCollection experience_collection_;
+};
+}  // namespace moveit_warehouse
@@ -67,8 +67,22 @@ public:
   PlanningSceneStorage(warehouse_ros::DatabaseConnection::Ptr conn);
 
   void addPlanningScene(const moveit_msgs::msg::PlanningScene& scene);
+
+  /** \brief Add several planning scenes, replacing the stored scenes of the same names.
+   *
+   * The names of the stored scenes are fetched once for all added scenes. */
+  void addPlanningScenes(const std::vector<moveit_msgs::msg::PlanningScene>& scenes);
+
   void addPlanningQuery(const moveit_msgs::msg::MotionPlanRequest& planning_query, const std::string& scene_name,
                         const std::string& query_name = "");
+
+  /** \brief Add several planning queries to the scene \e scene_name, like repeated calls to addPlanningQuery().
+   *
+   * \e query_names is either empty, or holds a (possibly empty) name for each query. The stored queries of the scene
+   * are fetched and serialized once for all added queries, instead of once per added query. */
+  void addPlanningQueries(const std::vector<moveit_msgs::msg::MotionPlanRequest>& planning_queries,
+                          const std::string& scene_name,
+                          const std::vector<std::string>& query_names = std::vector<std::string>());
   void addPlanningResult(const moveit_msgs::msg::MotionPlanRequest& planning_query,
                          const moveit_msgs::msg::RobotTrajectory& result, const std::string& scene_name);
 
@@ -91,6 +105,11 @@ public:
   void getPlanningQueries(std::vector<MotionPlanRequestWithMetadata>& planning_queries,
                           std::vector<std::string>& query_names, const std::string& scene_name) const;
 
+  /** \brief Get the queries of \e scene_name with names matching \e regex (all queries if it is empty), together with
+   * their names, from a single database query */
+  void getPlanningQueries(const std::string& regex, std::vector<MotionPlanRequestWithMetadata>& planning_queries,
+                          std::vector<std::string>& query_names, const std::string& scene_name) const;
+
   void getPlanningResults(std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
                           const moveit_msgs::msg::MotionPlanRequest& planning_query) const;
   void getPlanningResults(std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
@@ -115,6 +134,8 @@ private:
                                        const std::string& scene_name) const;
   std::string addNewPlanningRequest(const moveit_msgs::msg::MotionPlanRequest& planning_query,
                                     const std::string& scene_name, const std::string& query_name);
+  void insertPlanningRequest(const moveit_msgs::msg::MotionPlanRequest& planning_query, const std::string& scene_name,
+                             const std::string& query_name);
 
   PlanningSceneCollection planning_scene_collection_;
   MotionPlanRequestCollection motion_plan_request_collection_;
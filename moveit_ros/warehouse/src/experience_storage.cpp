@@ -0,0 +1,115 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/warehouse/experience_storage.h>
+
+#include <utility>
+
+const std::string moveit_warehouse::ExperienceStorage::DATABASE_NAME = "moveit_experiences";
+
+const std::string moveit_warehouse::ExperienceStorage::EXPERIENCE_ID_NAME = "experience_id";
+const std::string moveit_warehouse::ExperienceStorage::EXPERIENCE_GROUP_NAME = "group_id";
+const std::string moveit_warehouse::ExperienceStorage::ROBOT_NAME = "robot_id";
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.warehouse.experience_storage");
+
+using warehouse_ros::Metadata;
+using warehouse_ros::Query;
+
+moveit_warehouse::ExperienceStorage::ExperienceStorage(warehouse_ros::DatabaseConnection::Ptr conn)
+  : MoveItMessageStorage(std::move(conn))
+{
+  createCollections();
+}
+
+void moveit_warehouse::ExperienceStorage::createCollections()
+{
+  experience_collection_ = conn_->openCollectionPtr<moveit_msgs::msg::RobotTrajectory>(DATABASE_NAME, "experiences");
+}
+
+void moveit_warehouse::ExperienceStorage::reset()
+{
+  experience_collection_.reset();
+  conn_->dropDatabase(DATABASE_NAME);
+  createCollections();
+}
+
+void moveit_warehouse::ExperienceStorage::addExperience(const moveit_msgs::msg::RobotTrajectory& msg,
+                                                        const std::string& name, const std::string& robot,
+                                                        const std::string& group)
+{
+  removeExperience(name, robot, group);
+  Metadata::Ptr metadata = experience_collection_->createMetadata();
+  metadata->append(EXPERIENCE_ID_NAME, name);
+  metadata->append(ROBOT_NAME, robot);
+  metadata->append(EXPERIENCE_GROUP_NAME, group);
+  experience_collection_->insert(msg, metadata);
+  RCLCPP_DEBUG(LOGGER, "Added experience '%s' with %zu waypoints for group '%s'", name.c_str(),
+               msg.joint_trajectory.points.size(), group.c_str());
+}
+
+void moveit_warehouse::ExperienceStorage::removeExperience(const std::string& name, const std::string& robot,
+                                                           const std::string& group)
+{
+  Query::Ptr q = experience_collection_->createQuery();
+  q->append(EXPERIENCE_ID_NAME, name);
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  if (!group.empty())
+    q->append(EXPERIENCE_GROUP_NAME, group);
+  unsigned int rem = experience_collection_->removeMessages(q);
+  RCLCPP_DEBUG(LOGGER, "Removed %u experiences (named '%s')", rem, name.c_str());
+}
+
+void moveit_warehouse::ExperienceStorage::getExperiences(std::vector<ExperienceWithMetadata>& experiences,
+                                                         const std::string& robot, const std::string& group) const
+{
+  Query::Ptr q = experience_collection_->createQuery();
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  if (!group.empty())
+    q->append(EXPERIENCE_GROUP_NAME, group);
+  experiences = experience_collection_->queryList(q, false);
+}
+
+void moveit_warehouse::ExperienceStorage::removeExperiences(const std::string& robot, const std::string& group)
+{
+  Query::Ptr q = experience_collection_->createQuery();
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  if (!group.empty())
+    q->append(EXPERIENCE_GROUP_NAME, group);
+  unsigned int rem = experience_collection_->removeMessages(q);
+  RCLCPP_DEBUG(LOGGER, "Removed %u experiences", rem);
+}
@@ -35,6 +35,9 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/warehouse/planning_scene_storage.h>
+#include <map>
+#include <set>
+#include <unordered_map>
 #include <utility>
 #include <rclcpp/serialization.hpp>
 #include <regex>
@@ -88,6 +91,25 @@ void moveit_warehouse::PlanningSceneStorage::addPlanningScene(const moveit_msgs:
   RCLCPP_DEBUG(LOGGER, "%s scene '%s'", replace ? "Replaced" : "Added", scene.name.c_str());
 }
 
+void moveit_warehouse::PlanningSceneStorage::addPlanningScenes(
+    const std::vector<moveit_msgs::msg::PlanningScene>& scenes)
+{
+  std::vector<std::string> names;
+  getPlanningSceneNames(names);
+  std::set<std::string> stored(names.begin(), names.end());
+
+  for (const moveit_msgs::msg::PlanningScene& scene : scenes)
+  {
+    const bool replace = !stored.insert(scene.name).second;
+    if (replace)
+      removePlanningScene(scene.name);
+    Metadata::Ptr metadata = planning_scene_collection_->createMetadata();
+    metadata->append(PLANNING_SCENE_ID_NAME, scene.name);
+    planning_scene_collection_->insert(scene, metadata);
+    RCLCPP_DEBUG(LOGGER, "%s scene '%s'", replace ? "Replaced" : "Added", scene.name.c_str());
+  }
+}
+
 bool moveit_warehouse::PlanningSceneStorage::hasPlanningScene(const std::string& name) const
 {
   Query::Ptr q = planning_scene_collection_->createQuery();
@@ -148,6 +170,74 @@ void moveit_warehouse::PlanningSceneStorage::addPlanningQuery(const moveit_msgs:
     addNewPlanningRequest(planning_query, scene_name, query_name);
 }
 
+void moveit_warehouse::PlanningSceneStorage::addPlanningQueries(
+    const std::vector<moveit_msgs::msg::MotionPlanRequest>& planning_queries, const std::string& scene_name,
+    const std::vector<std::string>& query_names)
+{
+  if (!query_names.empty() && query_names.size() != planning_queries.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Got %zu names for %zu planning queries of scene '%s', not adding any", query_names.size(),
+                 planning_queries.size(), scene_name.c_str());
+    return;
+  }
+
+  // serializations and names of the stored requests, which addPlanningQuery() would fetch once per query
+  rclcpp::Serialization<moveit_msgs::msg::MotionPlanRequest> serializer;
+  auto serialize = [&serializer](const moveit_msgs::msg::MotionPlanRequest& request) {
+    rclcpp::SerializedMessage serialized_msg;
+    serializer.serialize_message(&request, &serialized_msg);
+    const void* data = serialized_msg.get_rcl_serialized_message().buffer;
+    return std::string(static_cast<const char*>(data), serialized_msg.size());
+  };
+  std::unordered_map<std::string, std::string> ids_by_content;
+  std::map<std::string, std::string> contents_by_id;
+  Query::Ptr q = motion_plan_request_collection_->createQuery();
+  q->append(PLANNING_SCENE_ID_NAME, scene_name);
+  std::size_t request_count = 0;
+  for (MotionPlanRequestWithMetadata& existing_request : motion_plan_request_collection_->queryList(q, false))
+  {
+    ++request_count;
+    if (!existing_request->lookupField(MOTION_PLAN_REQUEST_ID_NAME))
+      continue;
+    const std::string id = existing_request->lookupString(MOTION_PLAN_REQUEST_ID_NAME);
+    std::string content = serialize(static_cast<const moveit_msgs::msg::MotionPlanRequest&>(*existing_request));
+    ids_by_content.emplace(content, id);  // the first stored request wins, as in getMotionPlanRequestName()
+    contents_by_id[id] = std::move(content);
+  }
+
+  for (std::size_t i = 0; i < planning_queries.size(); ++i)
+  {
+    const std::string& query_name = query_names.empty() ? std::string() : query_names[i];
+    std::string content = serialize(planning_queries[i]);
+    const auto known = ids_by_content.find(content);
+    const std::string id = known == ids_by_content.end() ? std::string() : known->second;
+
+    // if we are trying to overwrite, we remove the old query first (if it exists).
+    if (!query_name.empty() && id.empty())
+    {
+      const auto old = contents_by_id.find(query_name);
+      if (old != contents_by_id.end())
+      {
+        removePlanningQuery(scene_name, query_name);
+        ids_by_content.erase(old->second);
+        contents_by_id.erase(old);
+        --request_count;
+      }
+    }
+
+    if (id == query_name && !id.empty())
+      continue;
+
+    std::string new_id = query_name;
+    for (std::size_t index = request_count; new_id.empty() || contents_by_id.count(new_id); ++index)
+      new_id = "Motion Plan Request " + std::to_string(index);
+    insertPlanningRequest(planning_queries[i], scene_name, new_id);
+    ++request_count;
+    ids_by_content.emplace(content, new_id);
+    contents_by_id[new_id] = std::move(content);
+  }
+}
+
 std::string
 moveit_warehouse::PlanningSceneStorage::addNewPlanningRequest(const moveit_msgs::msg::MotionPlanRequest& planning_query,
                                                               const std::string& scene_name,
@@ -169,12 +259,19 @@ moveit_warehouse::PlanningSceneStorage::addNewPlanningRequest(const moveit_msgs:
       index++;
     } while (used.find(id) != used.end());
   }
+  insertPlanningRequest(planning_query, scene_name, id);
+  return id;
+}
+
+void moveit_warehouse::PlanningSceneStorage::insertPlanningRequest(
+    const moveit_msgs::msg::MotionPlanRequest& planning_query, const std::string& scene_name,
+    const std::string& query_name)
+{
   Metadata::Ptr metadata = motion_plan_request_collection_->createMetadata();
   metadata->append(PLANNING_SCENE_ID_NAME, scene_name);
-  metadata->append(MOTION_PLAN_REQUEST_ID_NAME, id);
+  metadata->append(MOTION_PLAN_REQUEST_ID_NAME, query_name);
   motion_plan_request_collection_->insert(planning_query, metadata);
-  RCLCPP_DEBUG(LOGGER, "Saved planning query '%s' for scene '%s'", id.c_str(), scene_name.c_str());
-  return id;
+  RCLCPP_DEBUG(LOGGER, "Saved planning query '%s' for scene '%s'", query_name.c_str(), scene_name.c_str());
 }
 
 void moveit_warehouse::PlanningSceneStorage::addPlanningResult(const moveit_msgs::msg::MotionPlanRequest& planning_query,
@@ -326,6 +423,28 @@ void moveit_warehouse::PlanningSceneStorage::getPlanningQueries(
   }
 }
 
+void moveit_warehouse::PlanningSceneStorage::getPlanningQueries(
+    const std::string& regex, std::vector<MotionPlanRequestWithMetadata>& planning_queries,
+    std::vector<std::string>& query_names, const std::string& scene_name) const
+{
+  getPlanningQueries(planning_queries, query_names, scene_name);
+  if (regex.empty())
+    return;
+
+  std::regex r(regex);
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < planning_queries.size(); ++i)
+  {
+    if (!std::regex_match(query_names[i], r))
+      continue;
+    planning_queries[kept] = std::move(planning_queries[i]);
+    query_names[kept] = std::move(query_names[i]);
+    ++kept;
+  }
+  planning_queries.resize(kept);
+  query_names.resize(kept);
+}
+
 void moveit_warehouse::PlanningSceneStorage::getPlanningResults(
     std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
     const moveit_msgs::msg::MotionPlanRequest& planning_query) const
@@ -39,6 +39,8 @@
 #include <boost/math/special_functions/binomial.hpp>  // for statistics at end
 #include <boost/thread.hpp>
 #include <boost/assign.hpp>
+#include <algorithm>
+#include <atomic>
 #include <unordered_map>
 
 namespace moveit_setup
@@ -65,23 +67,25 @@ typedef std::set<std::pair<std::string, std::string> > StringPairSet;
 // Struct for passing parameters to threads, for cleaner code
 struct ThreadComputation
 {
-  ThreadComputation(planning_scene::PlanningScene& scene, const collision_detection::CollisionRequest& req,
-                    int thread_id, int num_trials, StringPairSet* links_seen_colliding, std::mutex* lock,
-                    unsigned int* progress)
+  ThreadComputation(const planning_scene::PlanningScenePtr& scene, const collision_detection::CollisionRequest& req,
+                    int thread_id, unsigned int num_trials, StringPairSet* links_seen_colliding,
+                    std::atomic<std::size_t>* num_links_seen_colliding, std::mutex* lock, unsigned int* progress)
     : scene_(scene)
     , req_(req)
     , thread_id_(thread_id)
     , num_trials_(num_trials)
     , links_seen_colliding_(links_seen_colliding)
+    , num_links_seen_colliding_(num_links_seen_colliding)
     , lock_(lock)
     , progress_(progress)
   {
   }
-  planning_scene::PlanningScene& scene_;
+  planning_scene::PlanningScenePtr scene_;  // owned by this thread, so that it can modify the collision matrix
   const collision_detection::CollisionRequest& req_;
   int thread_id_;
   unsigned int num_trials_;
-  StringPairSet* links_seen_colliding_;
+  StringPairSet* links_seen_colliding_;                  // shared by all threads, guarded by lock_
+  std::atomic<std::size_t>* num_links_seen_colliding_;  // size of links_seen_colliding_, readable without the lock
   std::mutex* lock_;
   unsigned int* progress_;  // only to be updated by thread 0
 };
@@ -559,14 +563,19 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
   unsigned int num_disabled = 0;
   std::vector<std::thread> bgroup;
   std::mutex lock;  // used for sharing the same data structures
+  std::atomic<std::size_t> num_links_seen_colliding{ links_seen_colliding.size() };
 
-  int num_threads = std::thread::hardware_concurrency();  // how many cores does this computer have?
+  // how many cores does this computer have?
+  const unsigned int num_threads = std::max(1u, std::thread::hardware_concurrency());
   // RCLCPP_INFO_STREAM_STREAM(LOGGER, "Performing " << num_trials << " trials for 'always in collision' checking on " <<
   //   num_threads << " threads...");
 
-  for (int i = 0; i < num_threads; ++i)
+  for (unsigned int i = 0; i < num_threads; ++i)
   {
-    ThreadComputation tc(scene, req, i, num_trials / num_threads, &links_seen_colliding, &lock, progress);
+    // Every thread checks its own clone of the scene, as it disables the pairs seen colliding in its collision matrix
+    const unsigned int thread_trials = num_trials / num_threads + (i < num_trials % num_threads ? 1 : 0);
+    ThreadComputation tc(scene.diff(), req, i, thread_trials, &links_seen_colliding, &num_links_seen_colliding, &lock,
+                         progress);
     bgroup.push_back(std::thread([tc] { return disableNeverInCollisionThread(tc); }));
   }
 
@@ -606,10 +615,15 @@ void disableNeverInCollisionThread(ThreadComputation tc)
   // RCLCPP_INFO_STREAM_STREAM(LOGGER, "Thread " << tc.thread_id_ << " running " << tc.num_trials_ << " trials");
 
   // User feedback vars
-  const unsigned int progress_interval = tc.num_trials_ / 20;  // show progress update every 5%
+  const unsigned int progress_interval = std::max(1u, tc.num_trials_ / 20);  // show progress update every 5%
 
   // Create a new kinematic state for this thread to work on
-  moveit::core::RobotState robot_state(tc.scene_.getRobotModel());
+  moveit::core::RobotState robot_state(tc.scene_->getRobotModel());
+  collision_detection::AllowedCollisionMatrix& acm = tc.scene_->getAllowedCollisionMatrixNonConst();
+
+  // Pairs that are disabled in the collision matrix of this thread. Once a pair has been seen colliding, by any thread,
+  // it is not checked anymore, so that the remaining trials only spend time on pairs that may never collide.
+  StringPairSet links_disabled;
 
   // Do a large number of tests
   for (unsigned int i = 0; i < tc.num_trials_; ++i)
@@ -622,24 +636,33 @@ void disableNeverInCollisionThread(ThreadComputation tc)
       (*tc.progress_) = i * 92 / tc.num_trials_ + 8;  // 8 is the amount of progress already completed in prev steps
     }
 
+    // Pick up the pairs other threads have seen colliding since the last trial
+    if (*tc.num_links_seen_colliding_ != links_disabled.size())
+    {
+      std::scoped_lock slock(*tc.lock_);
+      for (const std::pair<std::string, std::string>& link_pair : *tc.links_seen_colliding_)
+      {
+        if (links_disabled.insert(link_pair).second)
+          acm.setEntry(link_pair.first, link_pair.second, true);
+      }
+    }
+
     collision_detection::CollisionResult res;
     robot_state.setToRandomPositions();
-    tc.scene_.checkSelfCollision(tc.req_, res, robot_state);
+    tc.scene_->checkSelfCollision(tc.req_, res, robot_state);
 
     // Check all contacts
     for (collision_detection::CollisionResult::ContactMap::const_iterator it = res.contacts.begin();
          it != res.contacts.end(); ++it)
     {
-      // Check if this collision pair is unique before doing a thread lock
-      if (tc.links_seen_colliding_->find(it->first) == tc.links_seen_colliding_->end())
+      // Publish the pairs this thread has not disabled yet, other threads may have seen some of them already
+      if (links_disabled.insert(it->first).second)
       {
-        // Collision Matrix and links_seen_colliding is modified only if needed, based on above if statement
+        acm.setEntry(it->first.first, it->first.second, true);  // disable link checking in the collision matrix
 
         std::scoped_lock slock(*tc.lock_);
         tc.links_seen_colliding_->insert(it->first);
-
-        tc.scene_.getAllowedCollisionMatrixNonConst().setEntry(it->first.first, it->first.second,
-                                                               true);  // disable link checking in the collision matrix
+        *tc.num_links_seen_colliding_ = tc.links_seen_colliding_->size();
       }
     }
   }